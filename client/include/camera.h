@@ -41,4 +41,12 @@ public:
     glm::mat4 viewProj(float aspect) const {
         return proj(aspect) * view();
     }
+
+    // The far terrain's own depth range, drawn before depth is cleared for
+    // the chunks
+    glm::mat4 farViewProj(float aspect) const {
+        glm::mat4 p = glm::perspective(glm::radians(70.f), aspect, Config::FAR_NEAR, Config::FAR_FAR);
+        p[1][1] *= -1;
+        return p * view();
+    }
 };
@@ -0,0 +1,179 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunk.h"
+#include "terrain_vertex.h"
+
+// ── ChunkCollider ─────────────────────────────────────────────────────────────
+// A chunk's triangles for the PlayerController, built on the MeshBuilder
+// worker from the same packed vertices the GPU gets: positions are kept as
+// TerrainVertex::pos (4 bytes a vertex), triangles as 16-bit indices where
+// the mesh allows, under a bounding volume hierarchy with byte-quantized
+// bounds. Triangles are reordered along a Morton curve so every leaf is a
+// contiguous run and sits in exactly one leaf; a query walks the tree and
+// unpacks only the triangles whose boxes it touches. About a third of a
+// float triangle soup with a cell grid, and queries are const, so any
+// thread may run them.
+struct ChunkCollider {
+    static constexpr int   LEAF_TRIS = 4;
+    static constexpr float Q         = 255.f / (float)ChunkData::SIZE; // node bound units per block
+
+    // count 0: interior, children this + 1 and index. Otherwise a leaf of
+    // triangles [index, index + count). Bounds chunk-local, in 1/Q blocks,
+    // rounded outwards.
+    struct Node {
+        uint8_t  lo[3], hi[3];
+        uint16_t count;
+        uint32_t index;
+    };
+    static_assert(sizeof(Node) == 12);
+
+    ChunkCoord            coord{0, 0, 0};
+    glm::vec3             origin{0.f};
+    std::vector<uint32_t> pos;   // TerrainVertex::pos
+    std::vector<uint16_t> idx16; // three per triangle, when there are few enough vertices
+    std::vector<uint32_t> idx32; // else these
+    std::vector<Node>     nodes; // nodes[0] is the root
+
+    uint32_t triCount() const { return (uint32_t)((idx16.size() + idx32.size()) / 3); }
+    size_t   bytes() const {
+        return pos.size() * sizeof(uint32_t) + idx16.size() * sizeof(uint16_t) +
+               idx32.size() * sizeof(uint32_t) + nodes.size() * sizeof(Node);
+    }
+
+    void build(ChunkCoord c, const std::vector<TerrainVertex>& verts, const std::vector<uint32_t>& indices) {
+        coord  = c;
+        origin = glm::vec3(coord.x, coord.y, coord.z) * (float)ChunkData::SIZE;
+        pos.resize(verts.size());
+        for (size_t i = 0; i < verts.size(); i++) pos[i] = verts[i].pos;
+        idx16.clear();
+        idx32.clear();
+        nodes.clear();
+        const uint32_t tris = (uint32_t)(indices.size() / 3);
+        if (tris == 0) return;
+
+        // Worker scratch: Morton key of each centroid, then the triangles
+        // in key order with their bounds
+        static thread_local std::vector<std::pair<uint32_t, uint32_t>> order;
+        static thread_local std::vector<glm::vec3> triLo, triHi;
+        order.resize(tris);
+        for (uint32_t t = 0; t < tris; t++) {
+            glm::vec3 ctr = (local(indices[t * 3]) + local(indices[t * 3 + 1]) + local(indices[t * 3 + 2])) / 3.f;
+            order[t] = {morton(ctr), t};
+        }
+        std::sort(order.begin(), order.end());
+
+        const bool narrow = verts.size() <= 65536;
+        if (narrow) idx16.resize((size_t)tris * 3);
+        else        idx32.resize((size_t)tris * 3);
+        triLo.resize(tris);
+        triHi.resize(tris);
+        for (uint32_t i = 0; i < tris; i++) {
+            uint32_t t = order[i].second;
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = indices[t * 3 + k];
+                if (narrow) idx16[i * 3 + k] = (uint16_t)v;
+                else        idx32[i * 3 + k] = v;
+            }
+            glm::vec3 a = local(indices[t * 3]), b = local(indices[t * 3 + 1]), c3 = local(indices[t * 3 + 2]);
+            triLo[i] = glm::min(glm::min(a, b), c3);
+            triHi[i] = glm::max(glm::max(a, b), c3);
+        }
+        nodes.reserve(2 * (tris + LEAF_TRIS - 1) / LEAF_TRIS);
+        buildNode(0, tris, triLo, triHi);
+    }
+
+    // From an unpacked mesh: packs it first (tools and tests)
+    void build(const ChunkMesh& mesh) {
+        std::vector<TerrainVertex> verts(mesh.vertices.size());
+        for (size_t i = 0; i < verts.size(); i++) verts[i] = TerrainVertex::pack(mesh.vertices[i]);
+        build(mesh.coord, verts, mesh.indices);
+    }
+
+    // f(a, b, c), world space, once for each triangle whose bounds overlap
+    // [mn, mx]
+    template<class F>
+    void query(glm::vec3 mn, glm::vec3 mx, F&& f) const {
+        if (nodes.empty()) return;
+        const glm::vec3 lmn = mn - origin, lmx = mx - origin;
+        const glm::vec3 lo = lmn * Q, hi = lmx * Q;
+        uint32_t stack[64];
+        int      top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            uint32_t    ni = stack[--top];
+            const Node& n  = nodes[ni];
+            if (hi.x < n.lo[0] || lo.x > n.hi[0] || hi.y < n.lo[1] || lo.y > n.hi[1] ||
+                hi.z < n.lo[2] || lo.z > n.hi[2]) continue;
+            if (n.count == 0) {
+                stack[top++] = n.index;
+                stack[top++] = ni + 1;
+                continue;
+            }
+            // A leaf inside the box needs no per-triangle test
+            const bool inside = lo.x <= n.lo[0] && hi.x >= n.hi[0] && lo.y <= n.lo[1] &&
+                                hi.y >= n.hi[1] && lo.z <= n.lo[2] && hi.z >= n.hi[2];
+            for (uint32_t t = n.index; t < n.index + n.count; t++) {
+                glm::vec3 a = local(vertexOf(t, 0)), b = local(vertexOf(t, 1)), c = local(vertexOf(t, 2));
+                glm::vec3 tmn = glm::min(glm::min(a, b), c), tmx = glm::max(glm::max(a, b), c);
+                if (!inside && (tmx.x < lmn.x || tmn.x > lmx.x ||
+                    tmx.y < lmn.y || tmn.y > lmx.y ||
+                    tmx.z < lmn.z || tmn.z > lmx.z)) continue;
+                f(a + origin, b + origin, c + origin);
+            }
+        }
+    }
+
+private:
+    glm::vec3 local(uint32_t v) const { return TerrainVertex::unpackPos(pos[v]); }
+    uint32_t  vertexOf(uint32_t t, int k) const {
+        return idx16.empty() ? idx32[t * 3 + k] : idx16[t * 3 + k];
+    }
+
+    // 10 bits an axis, interleaved
+    static uint32_t morton(glm::vec3 p) {
+        auto spread = [](uint32_t v) {
+            v = (v | v << 16) & 0x030000FF;
+            v = (v | v << 8)  & 0x0300F00F;
+            v = (v | v << 4)  & 0x030C30C3;
+            v = (v | v << 2)  & 0x09249249;
+            return v;
+        };
+        auto q = [](float c) {
+            return (uint32_t)std::clamp(c * (1023.f / (float)ChunkData::SIZE), 0.f, 1023.f);
+        };
+        return spread(q(p.x)) | spread(q(p.y)) << 1 | spread(q(p.z)) << 2;
+    }
+
+    // Sorted triangles [begin, end), halved until a leaf's worth is left.
+    // Returns the node's index; the left child follows it.
+    uint32_t buildNode(uint32_t begin, uint32_t end, const std::vector<glm::vec3>& triLo,
+                       const std::vector<glm::vec3>& triHi) {
+        glm::vec3 mn = triLo[begin], mx = triHi[begin];
+        for (uint32_t i = begin + 1; i < end; i++) {
+            mn = glm::min(mn, triLo[i]);
+            mx = glm::max(mx, triHi[i]);
+        }
+        uint32_t ni = (uint32_t)nodes.size();
+        Node     n{};
+        for (int a = 0; a < 3; a++) {
+            n.lo[a] = (uint8_t)std::clamp(std::floor(mn[a] * Q), 0.f, 255.f);
+            n.hi[a] = (uint8_t)std::clamp(std::ceil(mx[a] * Q), 0.f, 255.f);
+        }
+        nodes.push_back(n);
+        if (end - begin <= (uint32_t)LEAF_TRIS) {
+            nodes[ni].count = (uint16_t)(end - begin);
+            nodes[ni].index = begin;
+            return ni;
+        }
+        uint32_t mid = begin + (end - begin) / 2;
+        buildNode(begin, mid, triLo, triHi);
+        uint32_t right  = buildNode(mid, end, triLo, triHi);
+        nodes[ni].index = right;
+        return ni;
+    }
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "chunk.h"
+#include "packets.h"
+
+// ── ChunkDiskCache ────────────────────────────────────────────────────────────
+// The full-resolution chunk packets a server sent, kept on disk between
+// sessions, so a reconnect or respawn needs only a ChunkCached for each
+// chunk that hasn't changed (see ChunkHavePacket). One file per server and
+// world.
+//
+// File layout (host byte order):
+//   Header   magic 'AECK', layout version, world id
+//   Records  {cx, cy, cz, length, hash} + the chunk packet, appended
+//
+// The index, the newest record per coord, is rebuilt by scanning at open.
+// Storing a chunk again appends, leaving the old record dead; open() rewrites
+// the file with only the live records once the dead ones are the larger part,
+// or a crash left a torn tail, dropping the oldest past MAX_BYTES. Until the
+// next open the file stops growing at twice that.
+//
+// Thread-safe: the mesh workers store and load, the main thread opens and
+// lists.
+class ChunkDiskCache {
+public:
+    static constexpr uint32_t MAGIC          = 0x4B434541; // "AECK"
+    static constexpr uint32_t LAYOUT_VERSION = 1;
+    static constexpr uint64_t MAX_BYTES      = 256ull << 20;
+    static constexpr uint32_t MAX_RECORD     = 4u << 20;   // a field is ~70 KB
+
+    ~ChunkDiskCache() { close(); }
+
+    // Closes whatever was open. A file for another world or layout is
+    // started over; false if path can't be written at all.
+    bool open(const std::filesystem::path& path, uint32_t world);
+    void close();
+    bool isOpen() const {
+        std::lock_guard lk(_mu);
+        return _file != nullptr;
+    }
+
+    // Bytes already stored for c are not written again
+    void store(const ChunkCoord& c, const uint8_t* data, size_t len);
+    // The packet stored for c, if it has this hash and reads back intact
+    bool load(const ChunkCoord& c, uint64_t hash, std::vector<uint8_t>& out);
+
+    // Appends every stored chunk keep(coord) accepts
+    template<class Keep>
+    void list(Keep&& keep, std::vector<ChunkHavePacket::Entry>& out) const {
+        std::lock_guard lk(_mu);
+        for (const auto& [c, e] : _index)
+            if (keep(c)) out.push_back({c, e.hash});
+    }
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t layoutVersion;
+        uint32_t world;
+        uint32_t pad;
+    };
+    struct Record {
+        int32_t  x, y, z;
+        uint32_t length;
+        uint64_t hash;
+    };
+    static_assert(sizeof(Record) == 24);
+
+    struct Entry {
+        uint64_t offset; // of the packet, past its Record
+        uint32_t length;
+        uint64_t hash;
+    };
+
+    // Under _mu
+    void closeLocked();
+    bool compactLocked();
+
+    mutable std::mutex    _mu;
+    std::filesystem::path _path;
+    uint32_t              _world = 0;
+    FILE*                 _file  = nullptr;
+    uint64_t              _end   = 0; // where the next record goes
+    uint64_t              _live  = 0; // bytes of live records, headers included
+    std::unordered_map<ChunkCoord, Entry, ChunkCoordHash> _index;
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunk.h"
+
+// ── ChunkVisibility ───────────────────────────────────────────────────────────
+// Which full-resolution chunks could be seen from the camera, going by each
+// chunk's face links (see faceLinkBit). A breadth-first walk leaves the
+// camera's chunk through every face; it goes on from a chunk it entered by
+// face a through face b only if a and b are linked, never back towards the
+// camera along an axis it has already moved out along, and never into a
+// chunk outside the frustum. Whatever the walk doesn't reach can't be in
+// view — a cave under solid ground from the surface, say.
+//
+// Chunks whose links aren't known (not received) count as open, as does
+// anything past the region the walk covers: the known chunks' bounds and the
+// camera's chunk. Complements the Hi-Z test, which needs last frame's
+// depth and so lets through what just came round a corner.
+class ChunkVisibility {
+public:
+    void set(const ChunkCoord& c, uint16_t faceLinks) { _links[c] = faceLinks; }
+    void erase(const ChunkCoord& c) { _links.erase(c); }
+    template<class Keep>
+    void retain(Keep&& keep) {
+        std::erase_if(_links, [&](const auto& kv) { return !keep(kv.first); });
+    }
+
+    // planes: inside where dot(p.xyz, x) + p.w >= 0
+    void update(glm::vec3 eye, const glm::vec4 (&planes)[6]) {
+        constexpr int S = ChunkData::SIZE;
+        ChunkCoord cam{(int)std::floor(eye.x / S), (int)std::floor(eye.y / S),
+                       (int)std::floor(eye.z / S)};
+        _lo = _hi = cam;
+        for (const auto& [c, l] : _links) {
+            _lo = {std::min(_lo.x, c.x), std::min(_lo.y, c.y), std::min(_lo.z, c.z)};
+            _hi = {std::max(_hi.x, c.x), std::max(_hi.y, c.y), std::max(_hi.z, c.z)};
+        }
+        _dim = {_hi.x - _lo.x + 1, _hi.y - _lo.y + 1, _hi.z - _lo.z + 1};
+        _reached.assign((size_t)_dim.x * _dim.y * _dim.z, 0);
+
+        static constexpr int STEP[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0},
+                                           {0, 1, 0},  {0, 0, -1}, {0, 0, 1}};
+        _queue.clear();
+        _queue.push_back({cam, -1, 0});
+        _reached[index(cam)] = 1;
+        for (size_t q = 0; q < _queue.size(); q++) {
+            Visit v = _queue[q];
+            auto it = _links.find(v.c);
+            uint16_t links = it == _links.end() ? FACE_LINKS_ALL : it->second;
+            for (int f = 0; f < 6; f++) {
+                if (v.dirs >> (f ^ 1) & 1) continue; // back towards the camera
+                if (v.entry >= 0 && !(links >> faceLinkBit(v.entry, f) & 1)) continue;
+                ChunkCoord n{v.c.x + STEP[f][0], v.c.y + STEP[f][1], v.c.z + STEP[f][2]};
+                if (!inside(n)) continue;
+                uint8_t& r = _reached[index(n)];
+                if (r) continue;
+                glm::vec3 mn = glm::vec3(n.x, n.y, n.z) * (float)S;
+                if (!inFrustum(planes, mn, mn + (float)S)) continue;
+                r = 1;
+                _queue.push_back({n, (int8_t)(f ^ 1), (uint8_t)(v.dirs | 1 << f)});
+            }
+        }
+    }
+
+    bool visible(const ChunkCoord& c) const {
+        return !inside(c) || _reached[index(c)];
+    }
+
+private:
+    struct Visit {
+        ChunkCoord c;
+        int8_t     entry; // face it was entered by, -1 for the camera's
+        uint8_t    dirs;  // axis directions moved out along so far
+    };
+
+    bool inside(const ChunkCoord& c) const {
+        return c.x >= _lo.x && c.y >= _lo.y && c.z >= _lo.z &&
+               c.x <= _hi.x && c.y <= _hi.y && c.z <= _hi.z;
+    }
+    size_t index(const ChunkCoord& c) const {
+        return ((size_t)(c.x - _lo.x) * _dim.z + (c.z - _lo.z)) * _dim.y + (c.y - _lo.y);
+    }
+    static bool inFrustum(const glm::vec4 (&planes)[6], glm::vec3 mn, glm::vec3 mx) {
+        for (const glm::vec4& p : planes) {
+            glm::vec3 pv{p.x > 0.f ? mx.x : mn.x, p.y > 0.f ? mx.y : mn.y, p.z > 0.f ? mx.z : mn.z};
+            if (glm::dot(glm::vec3(p), pv) + p.w < 0.f) return false;
+        }
+        return true;
+    }
+
+    std::unordered_map<ChunkCoord, uint16_t, ChunkCoordHash> _links;
+    ChunkCoord           _lo{}, _hi{}, _dim{};
+    std::vector<uint8_t> _reached; // over _lo.._hi, [x][z][y]
+    std::vector<Visit>   _queue;
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Batched box-vs-triangle (13-axis SAT) and ray-vs-triangle (Möller–Trumbore)
+// tests over structure-of-arrays triangles. Like Noise::fbmSpan, the batch
+// entry points pick the widest kernel the CPU supports at first use (AVX2 on
+// x86-64, scalar otherwise); per-triangle results match the scalar tests.
+namespace Collide {
+
+// Triangle corners as nine float arrays. Storage is kept a multiple of WIDTH
+// long so kernels can load whole batches; lanes past count are never hits.
+struct TriSoA {
+    static constexpr uint32_t WIDTH = 8;
+
+    std::vector<float> ax, ay, az, bx, by, bz, cx, cy, cz;
+    uint32_t count = 0;
+
+    void clear() { count = 0; }
+
+    void push(glm::vec3 a, glm::vec3 b, glm::vec3 c) {
+        if (count == ax.size())
+            for (auto* v : {&ax, &ay, &az, &bx, &by, &bz, &cx, &cy, &cz})
+                v->resize(count + WIDTH, 0.f);
+        ax[count] = a.x; ay[count] = a.y; az[count] = a.z;
+        bx[count] = b.x; by[count] = b.y; bz[count] = b.z;
+        cx[count] = c.x; cy[count] = c.y; cz[count] = c.z;
+        count++;
+    }
+
+    // Copy triangle i of another soup onto the end of this one
+    void push(const TriSoA& o, uint32_t i) { push(o.a(i), o.b(i), o.c(i)); }
+
+    glm::vec3 a(uint32_t i) const { return {ax[i], ay[i], az[i]}; }
+    glm::vec3 b(uint32_t i) const { return {bx[i], by[i], bz[i]}; }
+    glm::vec3 c(uint32_t i) const { return {cx[i], cy[i], cz[i]}; }
+};
+
+// Does the box [mn, mx] overlap triangle i? If so, outMTV is the shortest
+// push that separates them, pointing away from the triangle.
+bool boxTri(glm::vec3 mn, glm::vec3 mx, const TriSoA& t, uint32_t i, glm::vec3& outMTV);
+
+// boxTri for every triangle: hit[i] is 1 or 0, mtv[i] is set where hit.
+// hit and mtv hold at least t.count entries. Returns the number of hits.
+int boxTris(glm::vec3 mn, glm::vec3 mx, const TriSoA& t, uint8_t* hit, glm::vec3* mtv);
+
+// Nearest triangle the ray orig + dir*s, s in (0, maxDist], passes through,
+// skipping triangles whose unnormalised normal cross(b-a, c-a) has y below
+// minNy. Returns its index with outT set, or -1.
+int rayTris(glm::vec3 orig, glm::vec3 dir, float maxDist, float minNy,
+            const TriSoA& t, float& outT);
+
+// Name of the kernel the batch functions dispatch to ("avx2" / "scalar")
+const char* kernelName();
+
+} // namespace Collide
@@ -1,13 +1,19 @@
 #pragma once
 #include <entt/entt.hpp>
 #include <glm/vec3.hpp>
+#include <glm/common.hpp>
 #include <glm/geometric.hpp>
-#include <vector>
-#include <unordered_map>
+#include <algorithm>
 #include <cmath>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "combat.h"
 #include "config.h"
+#include "mp_packets.h"
+#include "particles.h"
 #include "player.h"
+#include "spatial_hash.h"
 
 // ── Helper ────────────────────────────────────────────────────────────────────
 static inline bool aabbOverlap(glm::vec3 mnA, glm::vec3 mxA,
@@ -19,7 +25,11 @@ static inline bool aabbOverlap(glm::vec3 mnA, glm::vec3 mxA,
 
 class CombatSystem {
 public:
-    explicit CombatSystem(entt::registry& reg) : _reg(reg) {}
+    // Creates the enemy group up front so its pools are packed from the
+    // first spawn rather than reshuffled on first use
+    explicit CombatSystem(entt::registry& reg)
+        : _reg(reg)
+        , _enemies(reg.group<CTransform, CAttack, CVelocity, CEnemy>(entt::get<CHealth, CFacing>)) {}
 
     // ── Player input interface ────────────────────────────────────────────────
 
@@ -41,6 +51,7 @@ public:
         if (par.state != CParry::State::Idle) return;
         par.state = CParry::State::Active;
         par.timer = CParry::WINDOW;
+        _defends.push_back({PlayerDefendPacket::Parry});
     }
 
     void playerDodge(entt::entity player, glm::vec3 wishDir) {
@@ -55,19 +66,26 @@ public:
         dod.timer = CDodge::DURATION;
         float len = glm::length(wishDir);
         dod.dir   = (len > 0.001f) ? wishDir / len : glm::vec3{0.f, 0.f, -1.f};
+        _defends.push_back({PlayerDefendPacket::Dodge});
+
+        // Kicked up from under the feet, behind the roll
+        const CTransform& tf = _reg.get<CTransform>(player);
+        glm::vec3 feet = tf.pos - glm::vec3(0.f, _reg.get<CAABB>(player).half.y, 0.f);
+        effect(ParticleFx::dust(feet, glm::vec3(-dod.dir.x, 0.5f, -dod.dir.z)));
     }
 
     // ── Per-frame update ──────────────────────────────────────────────────────
 
     void update(float dt, entt::entity playerEntity) {
-        tickAttacks(dt, playerEntity);
+        tickNetEnemies(dt);
+        rebuildBroadphase();
+        tickPlayerAttack(dt, playerEntity);
         tickParry(dt, playerEntity);
         tickDodge(dt, playerEntity);
         tickInvincibility(dt);
-        tickEnemyAI(dt, playerEntity);
+        tickEnemies(dt, playerEntity);
         resolveHits(playerEntity);
         clearHits();
-        tickEnemyKnockback(dt);
     }
 
     // Returns dodge velocity if rolling, else zero
@@ -93,16 +111,105 @@ public:
         _reg.emplace<CHealth>   (e, 60.f, 60.f);
         _reg.emplace<CAttack>   (e);
         _reg.emplace<CEnemy>    (e, CEnemy{.patrolOrigin = pos});
+        _reg.emplace<CFacing>   (e);
         return e;
     }
 
+    // ── Effects ───────────────────────────────────────────────────────────────
+
+    // Where hits, parries, kills and rolls put their bursts. Pushed from the
+    // tick, and from applyEnemySync, under sim.world() and so never beside
+    // one; the renderer drains it. None: no effects.
+    ParticleRing* effects = nullptr;
+
+    // ── Server enemies ────────────────────────────────────────────────────────
+
+    // Mirror the server's enemies near us. New ids get an entity; ones not
+    // heard from for REMOTE_STALE_S are dropped in update.
+    void applyEnemySync(const EnemySyncPacket& pkt) {
+        for (const EnemySyncEntry& s : pkt.enemies) {
+            auto [it, added] = _netEnemies.try_emplace(s.id, entt::null);
+            if (added) {
+                auto e = _reg.create();
+                _reg.emplace<CTransform>(e);
+                _reg.emplace<CAABB>     (e, glm::vec3{0.5f, 0.5f, 0.5f});
+                _reg.emplace<CHealth>   (e, 60.f, 60.f);
+                _reg.emplace<CEnemy>    (e);
+                _reg.emplace<CNetEnemy> (e, s.id);
+                it->second = e;
+            }
+            auto [tf, hp, en, net] = _reg.get<CTransform, CHealth, CEnemy, CNetEnemy>(it->second);
+            tf.pos         = {s.x, s.y, s.z};
+            en.ai          = (CEnemy::AIState)s.ai;
+            if (!added && !hp.dead && en.ai == CEnemy::AIState::Dead)
+                effect(ParticleFx::death(tf.pos));
+            hp.dead        = en.ai == CEnemy::AIState::Dead;
+            hp.current     = hp.max * (s.health / 255.f);
+            net.sinceHeard = 0.f;
+        }
+    }
+
+    // Hits on server enemies since the last call, to send as EnemyHit
+    std::vector<EnemyHitPacket> takeEnemyHits() {
+        std::vector<EnemyHitPacket> out;
+        out.swap(_enemyHits);
+        return out;
+    }
+
+    // Parries and dodges started since the last call, to send as
+    // PlayerDefend: the server times them against its enemies' attacks
+    std::vector<PlayerDefendPacket> takeDefends() {
+        std::vector<PlayerDefendPacket> out;
+        out.swap(_defends);
+        return out;
+    }
+
     // Access for renderer to draw enemy cubes
     void forEachEnemy(auto fn) const {
         _reg.view<CTransform, CEnemy, CHealth>().each(fn);
     }
 
 private:
+    static constexpr float ENEMY_WALK_SPEED = 3.5f;
+
+    // Every enemy, packed: the group owns the four pools it iterates, so the
+    // fused enemy tick walks them front to back in lockstep. The player has
+    // CTransform/CAttack/CVelocity too but no CEnemy, so it sits outside.
+    using EnemyGroup = decltype(std::declval<entt::registry&>()
+        .group<CTransform, CAttack, CVelocity, CEnemy>(entt::get<CHealth, CFacing>));
+
     entt::registry& _reg;
+    EnemyGroup      _enemies;
+
+    void effect(const ParticleEmitter& e) {
+        if (effects) effects->push(ParticleEmitter(e)); // full: dropped
+    }
+
+    // ── Broadphase ────────────────────────────────────────────────────────────
+    std::unordered_map<uint32_t, entt::entity> _netEnemies; // server id → mirror entity
+    std::vector<EnemyHitPacket>                _enemyHits;
+    std::vector<PlayerDefendPacket>            _defends;
+
+    // Every live CTransform+CHealth entity, at its position as of the start
+    // of update. Enemies move after this, so hit queries are widened by the
+    // furthest any enemy moved this frame and then tested against the live
+    // transforms.
+    SpatialHash _broadphase;
+    float       _maxAggroRange = 0.f;
+    float       _maxEnemyStep  = 0.f;
+
+    void rebuildBroadphase() {
+        _broadphase.clear();
+        _maxAggroRange = 0.f;
+        _reg.view<CTransform, CHealth>().each([&](entt::entity e, CTransform& tf, CHealth& hp) {
+            if (hp.dead) return;
+            const CAABB* box = _reg.try_get<CAABB>(e);
+            _broadphase.insert(e, tf.pos, box ? box->half : glm::vec3(0.f));
+            if (const CEnemy* en = _reg.try_get<CEnemy>(e))
+                _maxAggroRange = std::max(_maxAggroRange, en->aggroRange);
+        });
+        _broadphase.build();
+    }
 
     // ── Attack ticking ────────────────────────────────────────────────────────
     void startAttack(entt::entity e, const AttackData* data, glm::vec3 facingDir) {
@@ -111,44 +218,46 @@ private:
         atk.data  = data;
         atk.state = CAttack::State::Startup;
         atk.timer = data->startup;
-        // Store facing in a scratch component so we know where to place hitbox
-        _attackDir[e] = glm::normalize(glm::vec3{facingDir.x, 0.f, facingDir.z});
+        _reg.get_or_emplace<CFacing>(e).dir =
+            glm::normalize(glm::vec3{facingDir.x, 0.f, facingDir.z});
     }
 
-    void tickAttacks(float dt, entt::entity playerEntity) {
-        _reg.view<CAttack, CTransform>().each([&](entt::entity e, CAttack& atk, CTransform& tf) {
-            if (atk.isIdle()) return;
-            atk.timer -= dt;
-            if (atk.timer > 0.f) return;
-
-            switch (atk.state) {
-            case CAttack::State::Startup:
-                atk.state = CAttack::State::Active;
-                atk.timer = atk.data->active;
-                emitHitbox(e, tf, atk, e == playerEntity);
-                break;
-            case CAttack::State::Active:
-                atk.state = CAttack::State::Recovery;
-                atk.timer = atk.data->recovery;
-                break;
-            case CAttack::State::Recovery:
-                atk.state = CAttack::State::Idle;
-                atk.timer = 0.f;
-                atk.data  = nullptr;
-                break;
-            default: break;
-            }
-        });
+    void tickPlayerAttack(float dt, entt::entity player) {
+        if (!_reg.valid(player)) return;
+        const CFacing* fac = _reg.try_get<CFacing>(player);
+        tickAttack(dt, _reg.get<CAttack>(player), _reg.get<CTransform>(player),
+                   fac ? fac->dir : CFacing{}.dir, true);
     }
 
-    void emitHitbox(entt::entity attacker, CTransform tf,
-                    const CAttack& atk, bool fromPlayer) {
-        glm::vec3 facing{0.f, 0.f, -1.f};
-        auto it = _attackDir.find(attacker);
-        if (it != _attackDir.end()) facing = it->second;
+    void tickAttack(float dt, CAttack& atk, const CTransform& tf, glm::vec3 facing,
+                    bool fromPlayer) {
+        if (atk.isIdle()) return;
+        atk.timer -= dt;
+        if (atk.timer > 0.f) return;
+
+        switch (atk.state) {
+        case CAttack::State::Startup:
+            atk.state = CAttack::State::Active;
+            atk.timer = atk.data->active;
+            emitHitbox(tf, atk, facing, fromPlayer);
+            break;
+        case CAttack::State::Active:
+            atk.state = CAttack::State::Recovery;
+            atk.timer = atk.data->recovery;
+            break;
+        case CAttack::State::Recovery:
+            atk.state = CAttack::State::Idle;
+            atk.timer = 0.f;
+            atk.data  = nullptr;
+            break;
+        default: break;
+        }
+    }
 
-        // Rotate hitbox offset by facing (simplified: only yaw)
-        float yaw = std::atan2(facing.x, facing.z);
+    void emitHitbox(CTransform tf, const CAttack& atk, glm::vec3 facing, bool fromPlayer) {
+        // Rotate hitbox offset by facing (simplified: only yaw). Offsets are
+        // authored facing -Z.
+        float yaw = std::atan2(-facing.x, -facing.z);
         float cy = std::cos(yaw), sy = std::sin(yaw);
         glm::vec3 off = atk.data->hitboxOffset;
         glm::vec3 rotOff{
@@ -165,9 +274,9 @@ private:
             atk.data->damage,
             atk.data->knockback,
             facing,
-            fromPlayer
+            fromPlayer,
+            atk.data
         );
-        _pendingHits.push_back(hit);
     }
 
     // ── Parry ticking ─────────────────────────────────────────────────────────
@@ -210,25 +319,41 @@ private:
 
     // ── Hit resolution ────────────────────────────────────────────────────────
     void resolveHits(entt::entity playerEntity) {
-        for (auto hitEnt : _pendingHits) {
-            if (!_reg.valid(hitEnt)) continue;
-            auto& h = _reg.get<CHitThisFrame>(hitEnt);
-
+        for (auto [hitEnt, h] : _reg.view<CHitThisFrame>().each()) {
             if (h.fromPlayer) {
-                // Player hit → check enemies
-                _reg.view<CTransform, CAABB, CHealth, CEnemy>().each(
-                [&](entt::entity e, CTransform& tf, CAABB& box, CHealth& hp, CEnemy& en) {
+                // Player hit → check enemies near the hitbox
+                glm::vec3 slack(_maxEnemyStep);
+                _broadphase.query(h.worldMin - slack, h.worldMax + slack,
+                [&](const SpatialHash::Entry& cand) {
+                    if (!_reg.all_of<CTransform, CAABB, CHealth, CEnemy>(cand.e)) return;
+                    auto [tf, box, hp, en] = _reg.get<CTransform, CAABB, CHealth, CEnemy>(cand.e);
                     if (hp.dead) return;
                     glm::vec3 mn = tf.pos - box.half;
                     glm::vec3 mx = tf.pos + box.half;
                     if (!aabbOverlap(h.worldMin, h.worldMax, mn, mx)) return;
 
+                    // From the middle of where the hitbox and the body meet,
+                    // whoever owns the health
+                    glm::vec3 at = (glm::max(h.worldMin, mn) + glm::min(h.worldMax, mx)) * 0.5f;
+                    bool heavy   = h.move == &SwordMoves::HEAVY;
+                    effect(ParticleFx::hitSparks(at, h.knockDir, heavy));
+                    effect(ParticleFx::hitDebris(at, h.knockDir, heavy));
+
+                    // The server owns this one's health; just report the hit
+                    if (const CNetEnemy* net = _reg.try_get<CNetEnemy>(cand.e)) {
+                        _enemyHits.push_back({net->id,
+                            heavy ? EnemyHitPacket::Heavy : EnemyHitPacket::Light,
+                            h.knockDir.x, h.knockDir.z});
+                        return;
+                    }
+
                     hp.current -= h.damage;
                     en.knockbackVel = h.knockDir * h.knockback;
                     if (hp.current <= 0.f) {
                         hp.current = 0.f;
                         hp.dead    = true;
                         en.ai      = CEnemy::AIState::Dead;
+                        effect(ParticleFx::death(tf.pos));
                     }
                 });
             } else {
@@ -250,6 +375,7 @@ private:
 
                 if (pPar.isActive()) {
                     // Successful parry — grant brief invincibility + stagger attacker
+                    effect(ParticleFx::parry((glm::max(h.worldMin, mn) + glm::min(h.worldMax, mx)) * 0.5f));
                     pPar.state = CParry::State::Cooldown;
                     pPar.timer = CParry::COOLDOWN;
                     _reg.emplace_or_replace<CInvincible>(playerEntity, 0.5f);
@@ -268,69 +394,88 @@ private:
     }
 
     void clearHits() {
-        for (auto e : _pendingHits)
-            if (_reg.valid(e)) _reg.destroy(e);
-        _pendingHits.clear();
+        auto hits = _reg.view<CHitThisFrame>();
+        _reg.destroy(hits.begin(), hits.end());
     }
 
-    // ── Enemy AI ──────────────────────────────────────────────────────────────
-    void tickEnemyAI(float dt, entt::entity playerEntity) {
+    // ── Enemies ───────────────────────────────────────────────────────────────
+    // One pass over the enemy group: attack timers, AI, then movement
+    // (walk velocity plus decaying knockback). Knockback from this frame's
+    // hits is applied on the next pass.
+    void tickEnemies(float dt, entt::entity playerEntity) {
+        _maxEnemyStep = 0.f;
         if (!_reg.valid(playerEntity)) return;
         auto& pTF = _reg.get<CTransform>(playerEntity);
         auto& pHP = _reg.get<CHealth>(playerEntity);
 
-        _reg.view<CTransform, CEnemy, CAttack, CHealth>().each(
-        [&](entt::entity e, CTransform& tf, CEnemy& en, CAttack& atk, CHealth& hp) {
-            if (hp.dead) return;
-
-            float dist = glm::length(pTF.pos - tf.pos);
-
-            switch (en.ai) {
-            case CEnemy::AIState::Patrol:
-                if (!pHP.dead && dist < en.aggroRange)
-                    en.ai = CEnemy::AIState::Aggro;
-                break;
-
-            case CEnemy::AIState::Aggro: {
-                if (dist > en.aggroRange * 1.5f) { en.ai = CEnemy::AIState::Patrol; break; }
-                // Move toward player
-                glm::vec3 dir = pTF.pos - tf.pos;
-                float len = glm::length(dir);
-                if (len > 0.01f) {
-                    tf.pos += (dir / len) * 3.5f * dt; // enemy walk speed
-                }
-                if (dist < en.attackRange) en.ai = CEnemy::AIState::Attack;
-                break;
-            }
-
-            case CEnemy::AIState::Attack:
-                if (dist > en.attackRange * 1.5f) { en.ai = CEnemy::AIState::Aggro; break; }
-                en.attackTimer -= dt;
-                if (en.attackTimer <= 0.f && atk.isIdle()) {
-                    en.attackTimer = en.attackCooldown;
-                    glm::vec3 dir = glm::normalize(pTF.pos - tf.pos);
-                    _attackDir[e] = dir;
-                    atk.data  = &SwordMoves::LIGHT;
-                    atk.state = CAttack::State::Startup;
-                    atk.timer = SwordMoves::LIGHT.startup;
-                    // Emit hitbox when active fires in tickAttacks
-                }
-                break;
-
-            case CEnemy::AIState::Dead:
-                break;
+        // Patrol → Aggro: only enemies the broadphase has near the player
+        if (!pHP.dead)
+            _broadphase.queryRadius(pTF.pos, _maxAggroRange, [&](const SpatialHash::Entry& cand) {
+                if (!_enemies.contains(cand.e)) return; // server enemies think for themselves
+                CEnemy* en = &_enemies.get<CEnemy>(cand.e);
+                if (en->ai != CEnemy::AIState::Patrol) return;
+                if (glm::length(pTF.pos - _reg.get<CTransform>(cand.e).pos) >= en->aggroRange) return;
+                en->ai = CEnemy::AIState::Aggro;
+            });
+
+        float maxStep2 = 0.f;
+        _enemies.each([&](CTransform& tf, CAttack& atk, CVelocity& vel, CEnemy& en,
+                           CHealth& hp, CFacing& fac) {
+            tickAttack(dt, atk, tf, fac.dir, false);
+            vel.vel = glm::vec3(0.f);
+            if (!hp.dead) tickEnemyAI(dt, pTF.pos, tf, atk, vel, en, fac);
+
+            glm::vec3 step = vel.vel * dt;
+            if (glm::length(en.knockbackVel) >= 0.01f) {
+                step += en.knockbackVel * dt;
+                en.knockbackVel *= std::max(0.f, 1.f - 10.f * dt); // friction
             }
+            tf.pos  += step;
+            maxStep2 = std::max(maxStep2, glm::dot(step, step));
         });
+        _maxEnemyStep = std::sqrt(maxStep2);
     }
 
-    void tickEnemyKnockback(float dt) {
-        _reg.view<CTransform, CEnemy>().each([&](CTransform& tf, CEnemy& en) {
-            if (glm::length(en.knockbackVel) < 0.01f) return;
-            tf.pos += en.knockbackVel * dt;
-            en.knockbackVel *= std::max(0.f, 1.f - 10.f * dt); // friction
-        });
+    void tickNetEnemies(float dt) {
+        for (auto it = _netEnemies.begin(); it != _netEnemies.end(); ) {
+            auto& net = _reg.get<CNetEnemy>(it->second);
+            net.sinceHeard += dt;
+            if (net.sinceHeard < Config::REMOTE_STALE_S) { ++it; continue; }
+            _reg.destroy(it->second);
+            it = _netEnemies.erase(it);
+        }
     }
 
-    std::unordered_map<entt::entity, glm::vec3> _attackDir;
-    std::vector<entt::entity> _pendingHits;
+    void tickEnemyAI(float dt, glm::vec3 playerPos, const CTransform& tf, CAttack& atk,
+                     CVelocity& vel, CEnemy& en, CFacing& fac) {
+        float dist = glm::length(playerPos - tf.pos);
+
+        switch (en.ai) {
+        case CEnemy::AIState::Aggro: {
+            if (dist > en.aggroRange * 1.5f) { en.ai = CEnemy::AIState::Patrol; break; }
+            // Move toward player
+            glm::vec3 dir = playerPos - tf.pos;
+            float len = glm::length(dir);
+            if (len > 0.01f) vel.vel = (dir / len) * ENEMY_WALK_SPEED;
+            if (dist < en.attackRange) en.ai = CEnemy::AIState::Attack;
+            break;
+        }
+
+        case CEnemy::AIState::Attack:
+            if (dist > en.attackRange * 1.5f) { en.ai = CEnemy::AIState::Aggro; break; }
+            en.attackTimer -= dt;
+            if (en.attackTimer <= 0.f && atk.isIdle()) {
+                en.attackTimer = en.attackCooldown;
+                fac.dir   = glm::normalize(playerPos - tf.pos);
+                atk.data  = &SwordMoves::LIGHT;
+                atk.state = CAttack::State::Startup;
+                atk.timer = SwordMoves::LIGHT.startup;
+                // Hitbox is emitted when the attack goes active
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
 };
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+#include "config.h"
+
+// ── DynamicResolution ─────────────────────────────────────────────────────────
+// The share of the window, per axis, the 3D scene is drawn at. Fed the GPU
+// time of each measured frame; the scale moves to bring an average of it to
+// the target, assuming the cost goes with the pixel count. A change shows in
+// the timings only frames later (they come back FRAMES_IN_FLIGHT behind), so
+// after one the samples in flight are dropped and a fresh average is taken
+// before the next. Raising needs more headroom than lowering takes, so it
+// doesn't hunt around the target. No samples (no timestamps): holds.
+class DynamicResolution {
+public:
+    static constexpr int   SETTLE    = 8;      // samples averaged per decision
+    static constexpr int   LATENCY   = 3;      // samples still in flight after a change
+    static constexpr float STEP      = 1.f / 32.f;
+    static constexpr float MAX_RISE  = 0.05f;
+    static constexpr float MAX_DROP  = 0.15f;
+    static constexpr float RAISE_AT  = 0.85f;  // of the target
+    static constexpr float LOWER_AT  = 1.02f;
+
+    void update(float gpuMs, float targetMs) {
+        if (gpuMs <= 0.f) return;
+        if (_skip > 0) {
+            _skip--;
+            return;
+        }
+        _avg = _samples++ == 0 ? gpuMs : _avg + (gpuMs - _avg) * 0.2f;
+        if (_samples < SETTLE) return;
+
+        float load = _avg / targetMs;
+        if (load > RAISE_AT && load < LOWER_AT) return;
+        float want = std::clamp(_scale * std::sqrt(1.f / load), _scale - MAX_DROP, _scale + MAX_RISE);
+        want = std::clamp(std::round(want / STEP) * STEP, Config::DYNRES_MIN_SCALE, 1.f);
+        if (want == _scale) return;
+        _scale   = want;
+        _samples = 0;
+        _skip    = LATENCY;
+    }
+
+    void reset() {
+        _scale   = 1.f;
+        _samples = _skip = 0;
+    }
+
+    float scale() const { return _scale; }
+    // Of full, at least a pixel
+    VkExtent2D extent(VkExtent2D full) const {
+        return {std::max(1u, (uint32_t)std::lround((float)full.width * _scale)),
+                std::max(1u, (uint32_t)std::lround((float)full.height * _scale))};
+    }
+
+private:
+    float _scale   = 1.f;
+    float _avg     = 0.f;
+    int   _samples = 0;
+    int   _skip    = 0;
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <glm/glm.hpp>
+#include "config.h"
+#include "thread_pool.h"
+
+// ── FarTerrain ────────────────────────────────────────────────────────────────
+// A geometry clipmap over the 2D heightfield (surfaceHeights), so there's a
+// horizon past the streamed chunks: LEVELS square grids around the player,
+// each with twice the spacing and reach of the one inside it. Generated on
+// the client from the shared noise, nothing on the wire.
+//
+// A level's grid sits on a lattice of two spacings, so it only moves, and is
+// rebuilt on the worker, once the player has crossed one of those steps;
+// vk_draw copies each version to the GPU once and draws every level in one
+// pass behind the chunks. Each level leaves hole(l) to finer geometry — the
+// chunks for level 0, the level inside for the rest — and discards its
+// fragments there. The level inside stops a spacing short of its edge, so
+// neighbours overlap a little rather than crack.
+//
+// Main thread only, apart from the worker it owns.
+class FarTerrain {
+public:
+    static constexpr int LEVELS  = Config::FAR_LEVELS;
+    static constexpr int GRID    = Config::FAR_GRID;        // quads per side
+    static constexpr int VERTS   = (GRID + 1) * (GRID + 1); // z-major rows
+    static constexpr int INDICES = GRID * GRID * 6;
+    static_assert(VERTS <= 65536, "indices are 16-bit");
+
+    // World space — the far field reaches a few kilometres, well within
+    // float precision of a block
+    struct Vertex {
+        glm::vec3 pos;
+        uint32_t  normMat; // octahedral normal | BlockMat << 16, as TerrainVertex
+    };
+    static_assert(sizeof(Vertex) == 16);
+
+    struct Level {
+        std::vector<Vertex> verts;
+        glm::vec2 lo{0.f}, hi{0.f}; // xz the grid covers
+        uint32_t  version = 0;      // 0 until first built
+    };
+
+    FarTerrain() : _pool(1) {}
+
+    // Once per frame. chunkLo/chunkHi: the xz box the streamed chunks
+    // cover, where level 0 takes over. Picks up finished levels and queues
+    // those whose lattice step the eye has left.
+    void update(glm::vec3 eye, glm::vec2 chunkLo, glm::vec2 chunkHi);
+
+    const Level& level(int l) const { return _levels[l]; }
+    // xz box (lo in xy, hi in zw) level l leaves to finer geometry
+    glm::vec4 hole(int l) const { return _holes[l]; }
+    // Built, and not entirely inside its hole
+    bool      visible(int l) const;
+    // Where the outermost level ends, from its centre — for fog
+    static float reach() { return GRID / 2 * spacing(LEVELS - 1); }
+
+    static float spacing(int l) { return (float)(Config::FAR_SPACING << l); }
+    // Two triangles per quad, front faces up, for every level's grid
+    static std::vector<uint16_t> indices();
+
+private:
+    static void build(int l, glm::ivec2 step, Level& out);
+
+    std::mutex _mu;               // _built, _hasBuilt with the worker
+    Level      _built[LEVELS];
+    bool       _hasBuilt[LEVELS] = {};
+    bool       _busy[LEVELS]     = {};
+    bool       _queued[LEVELS]   = {};
+    glm::ivec2 _step[LEVELS]{};   // lattice step last queued
+
+    Level      _levels[LEVELS];
+    glm::vec4  _holes[LEVELS]{};
+
+    // Last, so it joins before the levels it writes are destroyed
+    ThreadPool _pool;
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "tick_arena.h"
+
+// ── FrameArena ────────────────────────────────────────────────────────────────
+// A TickArena per frame in flight. begin(frame) hands out frame's, reset,
+// once its fence says the GPU is done with that frame: what a frame builds
+// there (the render graph's passes, their lists of draws) stays put until
+// the same slot comes round again, so a frame that left something behind
+// for the one after it is still covered. Once the arenas have grown to a
+// frame's worth, building a frame touches the heap no more.
+//
+// Render thread only.
+template<uint32_t Frames>
+class FrameArena {
+public:
+    TickArena& begin(uint32_t frame) {
+        _current = frame % Frames;
+        _arenas[_current].reset();
+        return _arenas[_current];
+    }
+
+    // The one the last begin() handed out
+    TickArena& current() { return _arenas[_current]; }
+
+private:
+    std::array<TickArena, Frames> _arenas;
+    uint32_t                      _current = 0;
+};
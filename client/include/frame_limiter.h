@@ -0,0 +1,33 @@
+#pragma once
+#include <chrono>
+#include <thread>
+
+// ── FrameLimiter ──────────────────────────────────────────────────────────────
+// Holds the main loop to a frame rate: each wait() returns one period after
+// the last one did. Sleeps most of the way and spins the rest, since a
+// sleep can overshoot by a scheduler tick. A frame that ran long isn't made
+// up for by rushing the next ones.
+class FrameLimiter {
+    using Clock = std::chrono::steady_clock;
+
+public:
+    static constexpr auto SPIN = std::chrono::microseconds(1500);
+
+    // fps <= 0: no limit
+    void wait(float fps) {
+        auto now = Clock::now();
+        if (fps <= 0.f) {
+            _next = now;
+            return;
+        }
+        auto period = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / fps));
+        if (_next + period < now) _next = now;
+        if (_next - now > SPIN) std::this_thread::sleep_until(_next - SPIN);
+        while (Clock::now() < _next) std::this_thread::yield();
+        _next += period;
+    }
+
+private:
+    Clock::time_point _next{};
+};
@@ -0,0 +1,323 @@
+#pragma once
+#include "log.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <imgui.h>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// ── FrameProfiler ─────────────────────────────────────────────────────────────
+// Per-frame CPU scopes and GPU timestamp pairs, kept for the last HISTORY
+// frames. GPU results for a frame are read back FRAMES_IN_FLIGHT frames later,
+// after its fence, and filed under the frame that recorded them. The overlay
+// shows a rolling histogram with p50/p99 per zone; dumpCsv/dumpTrace write
+// the whole history for regression tracking (the trace loads in
+// chrome://tracing or Perfetto). Main thread only, apart from gpuBegin and
+// gpuEnd, which the render graph's recording threads call for different
+// zones at once.
+class FrameProfiler {
+    using Clock = std::chrono::steady_clock;
+
+public:
+    enum CpuZone : uint32_t {
+        CpuFrame,        // whole loop iteration
+        CpuNet,          // packet receive + dispatch
+        CpuMeshPoll,
+        CpuSim,          // ticks finished during the frame, on the sim thread
+        CpuFlushUploads,
+        CPU_ZONES
+    };
+    enum GpuZone : uint32_t {
+        GpuCull,
+        GpuTerrain,
+        GpuViewModel,
+        GpuRemotePlayers,
+        GpuImGui,
+        GpuHiz,
+        GpuMarch,        // --gpu-mesh compute passes
+        GpuDepthPrepass,
+        GpuFarTerrain,
+        GpuShadows,
+        GpuUpscale,      // dynamic resolution blit
+        GpuFoliage,      // foliage.comp's scatter
+        GpuParticles,    // particle.comp's passes
+        GpuLights,       // light_cull.comp's binning
+        GpuFrame,        // whole command buffer
+        GPU_ZONES
+    };
+
+    static constexpr int HISTORY    = 600; // frames kept for dumps
+    static constexpr int HIST_SHOWN = 240; // frames in the overlay histograms
+
+    bool visible = false;
+
+    // ── Lifecycle ─────────────────────────────────────────────────────────
+    void init(VkPhysicalDevice phys, VkDevice dev, uint32_t queueFamily,
+              uint32_t framesInFlight) {
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(phys, &props);
+        uint32_t n = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(phys, &n, nullptr);
+        std::vector<VkQueueFamilyProperties> fams(n);
+        vkGetPhysicalDeviceQueueFamilyProperties(phys, &n, fams.data());
+        uint32_t validBits = queueFamily < n ? fams[queueFamily].timestampValidBits : 0;
+        _periodNs = props.limits.timestampPeriod;
+        _mask     = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+        _slots.assign(framesInFlight, {});
+        if (validBits == 0 || _periodNs <= 0.f) {
+            Log::warn("GPU timestamps not supported — profiler is CPU only");
+            return;
+        }
+
+        VkQueryPoolCreateInfo ci{};
+        ci.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        ci.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+        ci.queryCount = framesInFlight * GPU_ZONES * 2;
+        if (vkCreateQueryPool(dev, &ci, nullptr, &_pool) != VK_SUCCESS) _pool = VK_NULL_HANDLE;
+    }
+
+    void destroy(VkDevice dev) {
+        if (_pool) vkDestroyQueryPool(dev, _pool, nullptr);
+        _pool = VK_NULL_HANDLE;
+    }
+
+    // ── CPU ───────────────────────────────────────────────────────────────
+    // Starts a new record; call at the top of the main loop
+    void beginFrame() {
+        auto now = Clock::now();
+        if (_frames > 0) cur().cpuMs[CpuFrame] = ms(_frameStart, now);
+        _frameStart = now;
+        _frames++;
+        Record& r = cur();
+        r = {};
+        r.startUs = std::chrono::duration<double, std::micro>(now - _epoch).count();
+    }
+
+    class Scope {
+    public:
+        Scope(FrameProfiler& p, CpuZone z) : _p(p), _z(z), _t0(Clock::now()) {}
+        ~Scope() { _p.addCpu(_z, _t0, Clock::now()); }
+        Scope(const Scope&)            = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        FrameProfiler&    _p;
+        CpuZone           _z;
+        Clock::time_point _t0;
+    };
+    Scope cpu(CpuZone z) { return Scope(*this, z); }
+    // Time another thread measured, counted against this frame
+    void addCpuMs(CpuZone z, float ms) {
+        if (_frames > 0) cur().cpuMs[z] += ms;
+    }
+
+    // ── GPU ───────────────────────────────────────────────────────────────
+    // After frame's fence wait, before anything else is recorded into cmd:
+    // collects what this slot measured last time and resets its queries
+    void beginGpuFrame(VkDevice dev, VkCommandBuffer cmd, uint32_t frame) {
+        _latestValid = 0;
+        if (!_pool || _frames == 0) return;
+        Slot& s = _slots[frame];
+        uint32_t first = frame * GPU_ZONES * 2;
+        if (s.used && _frames - s.frame < (uint64_t)HISTORY) {
+            // value, availability per query
+            std::array<uint64_t, GPU_ZONES * 4> res{};
+            vkGetQueryPoolResults(dev, _pool, first, GPU_ZONES * 2, sizeof(res), res.data(),
+                                  2 * sizeof(uint64_t),
+                                  VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+            Record& r = _ring[s.frame % HISTORY];
+            uint64_t base = UINT64_MAX;
+            for (uint32_t z = 0; z < GPU_ZONES; z++)
+                if (s.used & (1u << z) && res[z * 4 + 1] && res[z * 4 + 3])
+                    base = std::min(base, res[z * 4] & _mask);
+            for (uint32_t z = 0; z < GPU_ZONES; z++) {
+                if (!(s.used & (1u << z)) || !res[z * 4 + 1] || !res[z * 4 + 3]) continue;
+                uint64_t b = res[z * 4] & _mask, e = res[z * 4 + 2] & _mask;
+                r.gpuBeginMs[z] = (float)((b - base) * _periodNs * 1e-6);
+                r.gpuMs[z]      = (float)((e - b) * _periodNs * 1e-6);
+                r.gpuValid     |= 1u << z;
+            }
+            _latestValid = r.gpuValid;
+            std::copy(r.gpuMs, r.gpuMs + GPU_ZONES, _latest);
+        }
+        vkCmdResetQueryPool(cmd, _pool, first, GPU_ZONES * 2);
+        s.used  = 0;
+        s.frame = _frames - 1;
+        _curSlot = frame;
+    }
+
+    void gpuBegin(VkCommandBuffer cmd, GpuZone z) {
+        if (!_pool) return;
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _pool, query(z));
+    }
+    void gpuEnd(VkCommandBuffer cmd, GpuZone z) {
+        if (!_pool) return;
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _pool, query(z) + 1);
+        // Passes may be recorded on several threads at once
+        std::atomic_ref(_slots[_curSlot].used).fetch_or(1u << z, std::memory_order_relaxed);
+    }
+
+    // What the last beginGpuFrame collected, FRAMES_IN_FLIGHT frames old;
+    // false if that frame had no result for z (or nothing was collected)
+    bool latestGpu(GpuZone z, float& ms) const {
+        if (!(_latestValid & (1u << z))) return false;
+        ms = _latest[z];
+        return true;
+    }
+
+    // ── Output ────────────────────────────────────────────────────────────
+    void drawOverlay() {
+        if (!visible || _frames < 2) return;
+        ImGui::SetNextWindowPos({12.f, 12.f}, ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowBgAlpha(0.7f);
+        if (!ImGui::Begin("Profiler", &visible, ImGuiWindowFlags_AlwaysAutoResize)) {
+            ImGui::End();
+            return;
+        }
+        std::vector<float>& vals = _vals;
+        std::vector<float>& sorted = _sorted;
+        auto row = [&](const char* name, auto get) {
+            vals.clear();
+            int n = (int)std::min<uint64_t>(_frames - 1, HIST_SHOWN);
+            for (int i = n; i >= 1; i--) {
+                float v;
+                if (get(_ring[(_frames - 1 - i) % HISTORY], v)) vals.push_back(v);
+            }
+            if (vals.empty()) return;
+            sorted = vals;
+            float p50 = pct(sorted, 0.50f), p99 = pct(sorted, 0.99f);
+            ImGui::Text("%-14s p50 %6.2f  p99 %6.2f ms", name, p50, p99);
+            char id[48];
+            snprintf(id, sizeof(id), "##%s", name);
+            ImGui::PlotHistogram(id, vals.data(), (int)vals.size(),
+                                 0, nullptr, 0.f, std::max(p99 * 1.25f, 0.1f), {260.f, 28.f});
+        };
+        ImGui::TextDisabled("CPU");
+        for (uint32_t z = 0; z < CPU_ZONES; z++)
+            row(CPU_NAMES[z], [z](const Record& r, float& v) { v = r.cpuMs[z]; return true; });
+        if (_pool) {
+            ImGui::Separator();
+            ImGui::TextDisabled("GPU");
+            for (uint32_t z = 0; z < GPU_ZONES; z++)
+                row(GPU_NAMES[z], [z](const Record& r, float& v) {
+                    v = r.gpuMs[z];
+                    return (r.gpuValid & (1u << z)) != 0;
+                });
+        }
+        ImGui::TextDisabled("F3 hide  F4 dump");
+        ImGui::End();
+    }
+
+    // One row per frame, milliseconds; GPU columns empty where not measured
+    bool dumpCsv(const char* path) const {
+        FILE* f = fopen(path, "w");
+        if (!f) return false;
+        fprintf(f, "frame");
+        for (auto* n : CPU_NAMES) fprintf(f, ",cpu_%s", n);
+        for (auto* n : GPU_NAMES) fprintf(f, ",gpu_%s", n);
+        fprintf(f, "\n");
+        forEachDone([&](uint64_t i, const Record& r) {
+            fprintf(f, "%llu", (unsigned long long)i);
+            for (uint32_t z = 0; z < CPU_ZONES; z++) fprintf(f, ",%.4f", r.cpuMs[z]);
+            for (uint32_t z = 0; z < GPU_ZONES; z++)
+                if (r.gpuValid & (1u << z)) fprintf(f, ",%.4f", r.gpuMs[z]);
+                else                        fprintf(f, ",");
+            fprintf(f, "\n");
+        });
+        fclose(f);
+        return true;
+    }
+
+    // Chrome trace-event JSON. CPU zones on tid 1, GPU on tid 2; GPU zones
+    // are placed relative to the frame's CPU start, since the two clocks
+    // aren't calibrated against each other.
+    bool dumpTrace(const char* path) const {
+        FILE* f = fopen(path, "w");
+        if (!f) return false;
+        fprintf(f, "{\"traceEvents\":[\n");
+        bool first = true;
+        auto ev = [&](const char* name, int tid, double ts, double dur) {
+            fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.1f,\"dur\":%.1f}",
+                    first ? "" : ",\n", name, tid, ts, dur);
+            first = false;
+        };
+        forEachDone([&](uint64_t, const Record& r) {
+            for (uint32_t z = 0; z < CPU_ZONES; z++)
+                if (r.cpuMs[z] > 0.f)
+                    ev(CPU_NAMES[z], 1, r.startUs + r.cpuBeginMs[z] * 1e3, r.cpuMs[z] * 1e3);
+            for (uint32_t z = 0; z < GPU_ZONES; z++)
+                if (r.gpuValid & (1u << z))
+                    ev(GPU_NAMES[z], 2, r.startUs + r.gpuBeginMs[z] * 1e3, r.gpuMs[z] * 1e3);
+        });
+        fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+        fclose(f);
+        return true;
+    }
+
+private:
+    static constexpr const char* CPU_NAMES[CPU_ZONES] = {
+        "frame", "net", "mesh_poll", "sim", "flush_uploads"};
+    static constexpr const char* GPU_NAMES[GPU_ZONES] = {
+        "cull", "terrain", "viewmodel", "remote_players", "imgui", "hiz", "march", "depth_prepass",
+        "far_terrain", "shadows", "upscale", "foliage", "particles", "lights", "frame"};
+
+    struct Record {
+        double   startUs = 0;
+        float    cpuBeginMs[CPU_ZONES]{};
+        float    cpuMs[CPU_ZONES]{};
+        float    gpuBeginMs[GPU_ZONES]{};
+        float    gpuMs[GPU_ZONES]{};
+        uint32_t gpuValid = 0;
+    };
+    // Queries one frame-in-flight slot wrote, and which record they belong to
+    struct Slot {
+        uint32_t used  = 0;
+        uint64_t frame = 0;
+    };
+
+    static float ms(Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<float, std::milli>(b - a).count();
+    }
+    static float pct(std::vector<float>& v, float p) {
+        size_t k = (size_t)(p * (float)(v.size() - 1) + 0.5f);
+        std::nth_element(v.begin(), v.begin() + k, v.end());
+        return v[k];
+    }
+
+    Record& cur() { return _ring[(_frames - 1) % HISTORY]; }
+
+    void addCpu(CpuZone z, Clock::time_point t0, Clock::time_point t1) {
+        if (_frames == 0) return;
+        Record& r = cur();
+        if (r.cpuMs[z] == 0.f) r.cpuBeginMs[z] = ms(_frameStart, t0);
+        r.cpuMs[z] += ms(t0, t1); // a zone entered twice in a frame sums
+    }
+
+    uint32_t query(GpuZone z) const { return (_curSlot * GPU_ZONES + z) * 2; }
+
+    // Oldest to newest, skipping the frame still in progress
+    template<class F>
+    void forEachDone(F&& fn) const {
+        uint64_t n = std::min<uint64_t>(_frames > 0 ? _frames - 1 : 0, HISTORY - 1);
+        for (uint64_t i = _frames - 1 - n; i + 1 < _frames; i++) fn(i, _ring[i % HISTORY]);
+    }
+
+    std::array<Record, HISTORY> _ring{};
+    uint64_t          _frames = 0;
+    Clock::time_point _epoch = Clock::now();
+    Clock::time_point _frameStart;
+
+    VkQueryPool       _pool = VK_NULL_HANDLE;
+    float             _periodNs = 0.f;
+    uint64_t          _mask = ~0ull;
+    std::vector<Slot> _slots;
+    uint32_t          _curSlot = 0;
+    float             _latest[GPU_ZONES]{};
+    uint32_t          _latestValid = 0;
+
+    std::vector<float> _vals, _sorted; // drawOverlay's, reused
+};
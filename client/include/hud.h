@@ -1,5 +1,7 @@
 #pragma once
 #include <imgui.h>
+#include <algorithm>
+#include <cstdio>
 #include "player_stats.h"
 
 // Client-side mirror of server stats — updated by StatsSyncPacket / StatsDeltaPacket
@@ -19,9 +21,18 @@ struct ClientStats {
     }
 
     void applyDelta(const StatsDeltaPacket& p) {
-        health = p.health; stamina = p.stamina;
-        mana = p.mana; armour = p.armour;
-        dead = p.dead != 0;
+        if (p.has(StatsDeltaPacket::Health))  health  = p.value(0, healthMax);
+        if (p.has(StatsDeltaPacket::Stamina)) stamina = p.value(1, staminaMax);
+        if (p.has(StatsDeltaPacket::Mana))    mana    = p.value(2, manaMax);
+        if (p.has(StatsDeltaPacket::Armour))  armour  = p.value(3, armourMax);
+        dead = p.has(StatsDeltaPacket::Dead);
+    }
+
+    // The server doesn't send regen; run the same rates locally
+    void update(float dt) {
+        if (dead) return;
+        stamina = std::min(staminaMax, stamina + PlayerStats::STAMINA_REGEN * dt);
+        mana    = std::min(manaMax,    mana    + PlayerStats::MANA_REGEN * dt);
     }
 };
 
@@ -88,6 +99,21 @@ public:
         ImGui::End();
     }
 
+    // Verified but not let in yet: where we are in the server's queue
+    void drawQueue(int position, int waiting) {
+        ImGuiIO& io = ImGui::GetIO();
+        char txt[64];
+        snprintf(txt, sizeof(txt), "Server busy  -  %d of %d in the queue", position, waiting);
+        ImDrawList* dl = ImGui::GetForegroundDrawList();
+        ImVec2 center = {io.DisplaySize.x * 0.5f, io.DisplaySize.y * 0.4f};
+        ImVec2 sz = ImGui::CalcTextSize(txt);
+        dl->AddRectFilled({center.x - sz.x * 0.5f - 20, center.y - 20},
+                          {center.x + sz.x * 0.5f + 20, center.y + 30},
+                          IM_COL32(0, 0, 0, 180), 6.f);
+        dl->AddText({center.x - sz.x * 0.5f, center.y - 8},
+                    IM_COL32(220, 220, 220, 255), txt);
+    }
+
 private:
     void drawBar(ImDrawList* dl, float x, float y, float w, float h,
                  float val, float max, ImU32 fillCol, ImU32 bgCol, const char* label) {
@@ -2,26 +2,45 @@
 #include <GLFW/glfw3.h>
 #include <glm/vec2.hpp>
 
+// Which keys are held, and which went down, over a span: a frame for
+// Input, a tick for the simulation (SimThread)
+struct InputState {
+    bool keys[GLFW_KEY_LAST + 1]{};
+    bool down[GLFW_KEY_LAST + 1]{};
+
+    bool key(int glfwKey)        const { return keys[glfwKey]; }
+    bool keyDown(int glfwKey)    const { return down[glfwKey]; }
+    bool keyPressed(int glfwKey) const { return down[glfwKey]; }
+};
+
 class Input {
 public:
     explicit Input(GLFWwindow* window);
 
     void beginFrame();
 
-    bool key(int glfwKey)        const { return _keys[glfwKey]; }
-    bool keyDown(int glfwKey)    const { return _keys[glfwKey] && !_prevKeys[glfwKey]; }
-    bool keyPressed(int glfwKey) const { return _keys[glfwKey] && !_prevKeys[glfwKey]; }
+    bool key(int glfwKey)        const { return _state.key(glfwKey); }
+    bool keyDown(int glfwKey)    const { return _state.keyDown(glfwKey); }
+    bool keyPressed(int glfwKey) const { return _state.keyPressed(glfwKey); }
+    // The keys as of beginFrame
+    const InputState& state() const { return _state; }
 
     glm::vec2 mouseDelta() const { return _delta; }
+    // Polls again and returns the motion since beginFrame (or the last
+    // latch), which the next frame's mouseDelta then leaves out — for
+    // turning the camera just before the frame is recorded. Keys that
+    // change meanwhile show up from the next beginFrame.
+    glm::vec2 latchMouse();
 
     void captureCursor(bool capture);
     bool cursorCaptured() const { return _captured; }
 
 private:
     GLFWwindow* _win;
-    bool _keys    [GLFW_KEY_LAST + 1]{};
-    bool _prevKeys[GLFW_KEY_LAST + 1]{};
+    bool _live[GLFW_KEY_LAST + 1]{}; // as the callbacks leave it
+    InputState _state;               // at beginFrame
     glm::vec2 _lastPos{};
+    glm::vec2 _pending{}; // motion not yet handed out
     glm::vec2 _delta{};
     bool _captured   = false;
     bool _firstMouse = true;
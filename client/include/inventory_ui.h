@@ -1,9 +1,8 @@
 #pragma once
 #include <imgui.h>
-#include <enet/enet.h>
 #include "inventory.h"
 #include "inv_packets.h"
-#include "net_common.h"
+#include "net_thread.h"
 
 struct ClientChestMirror {
     uint32_t  uid  = 0;
@@ -25,8 +24,8 @@ public:
     // ── Per-frame draw ────────────────────────────────────────────────────────
     // Call inside ImGui frame every frame.
     // Returns true if any overlay window has focus (suppress game input).
-    bool draw(CInventory& cinv, ClientChestMirror* chest, ENetPeer* server) {
-        _server = server;
+    bool draw(CInventory& cinv, ClientChestMirror* chest, NetThread* net) {
+        _net    = net;
         _cinv   = &cinv;
         _chest  = chest;
 
@@ -42,17 +41,32 @@ public:
     }
 
     // ── Server ack application ────────────────────────────────────────────────
-    void applyAck(CInventory& cinv, const InventoryMoveAckPacket& ack,
+    // Acks carry only the changed slots and must arrive in sequence. Returns
+    // true when one was missed and an InventoryResync should go out; later
+    // acks are ignored until the InventoryState answering it arrives.
+    bool applyAck(CInventory& cinv, const InventoryMoveAckPacket& ack,
                   ClientChestMirror* chest) {
-        cinv.inv = ack.playerInv;
-        if (ack.hasSecondary && chest && chest->uid == ack.secondaryUID)
-            chest->inv = ack.secondaryInv;
+        if (_awaitingState) return false;
+        if (ack.seq != (uint16_t)(_invSeq + 1)) {
+            _awaitingState = true;
+            return true;
+        }
+        _invSeq = ack.seq;
+        for (const SlotChange& c : ack.changes) {
+            Inventory* inv = nullptr;
+            if (c.ref.owner == InvOwner::Player) inv = &cinv.inv;
+            else if (c.ref.owner == InvOwner::Chest && chest && chest->uid == c.ref.uid) inv = &chest->inv;
+            if (ItemStack* s = inv ? slot(*inv, c.ref.region, c.ref.index) : nullptr) *s = c.stack;
+        }
         // Re-sync weapon slot from active combat hotbar slot
         syncWeaponFromHotbar(cinv);
+        return false;
     }
 
     void applyState(CInventory& cinv, const InventoryStatePacket& pkt) {
-        cinv.inv = pkt.inv;
+        cinv.inv       = pkt.inv;
+        _invSeq        = pkt.seq;
+        _awaitingState = false;
         syncWeaponFromHotbar(cinv);
     }
 
@@ -93,9 +107,20 @@ public:
     }
 
 private:
-    ENetPeer*          _server = nullptr;
+    NetThread*         _net    = nullptr;
     CInventory*        _cinv   = nullptr;
     ClientChestMirror* _chest  = nullptr;
+    uint16_t           _invSeq = 0;         // last ack applied
+    bool               _awaitingState = false;
+
+    static ItemStack* slot(Inventory& inv, SlotRegion region, uint8_t index) {
+        switch (region) {
+        case SlotRegion::Grid:   return index < INV_SIZE    ? &inv.grid[index]       : nullptr;
+        case SlotRegion::Equip:  return index < EQUIP_SLOTS ? &inv.equipSlots[index] : nullptr;
+        case SlotRegion::Hotbar: return index < inv.hotbars.size() ? &inv.hotbars[index] : nullptr;
+        }
+        return nullptr;
+    }
 
     static constexpr const char* DRAG_TYPE = "INV_SLOT";
 
@@ -160,8 +185,8 @@ private:
             }
 
             uint8_t flatIdx = (uint8_t)cinv.inv.hotbarFlatIndex(cinv.hotbarMode, i);
-            drawSlot(s, InvOwner::Player, 0, SlotRegion::Hotbar, flatIdx,
-                     /*label=*/std::to_string(i + 1).c_str());
+            char label[8]; snprintf(label, sizeof(label), "%d", i + 1);
+            drawSlot(s, InvOwner::Player, 0, SlotRegion::Hotbar, flatIdx, label);
 
             if (active) ImGui::PopStyleColor();
 
@@ -274,7 +299,7 @@ private:
 
         if (!open) {
             ChestCloseReqPacket req{chest->uid};
-            Net::sendReliable(_server, req.serialize());
+            _net->sendReliable(req.serialize());
             chest->open  = false;
             _cinv->open  = false;
         }
@@ -368,11 +393,11 @@ private:
     }
 
     void sendMoveReq(const DragPayload& src, const DragPayload& dst) {
-        if (!_server) return;
+        if (!_net) return;
         InventoryMoveReqPacket req;
         req.src = {src.owner, src.uid, src.region, src.index};
         req.dst = {dst.owner, dst.uid, dst.region, dst.index};
-        Net::sendReliable(_server, req.serialize());
+        _net->sendReliable(req.serialize());
     }
 
     // ── Mode colour accent ────────────────────────────────────────────────────
@@ -0,0 +1,17 @@
+#pragma once
+#include <glm/vec3.hpp>
+
+// ── PointLight ────────────────────────────────────────────────────────────────
+// A light for one frame, as gameplay queues it (vk_add_light): colour times
+// intensity at pos, falling off smoothly to nothing at radius. Unshadowed.
+// light_cull.comp bins each frame's into view-space clusters, and terrain
+// and player shading loop over only their cluster's, so a frame can carry
+// hundreds while a pixel pays for a handful. std430, as the shaders read
+// them.
+struct PointLight {
+    glm::vec3 pos{0.f};
+    float     radius = 4.f;    // blocks
+    glm::vec3 color{1.f};
+    float     intensity = 1.f;
+};
+static_assert(sizeof(PointLight) == 32, "light_cull.comp's Light");
@@ -0,0 +1,56 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "loopback.h"
+#include "log.h"
+
+// ── LocalServer ───────────────────────────────────────────────────────────────
+// Singleplayer: the server, on a thread of this process, serving one world
+// over a Loopback rather than a port. NetThread::connect(loopback()) plays
+// on it like on any other server.
+//
+// Game thread only. Stop the NetThread before stop(), so the disconnect
+// (and with it the player's save) reaches the server first.
+class LocalServer {
+public:
+    LocalServer() = default;
+    ~LocalServer() { stop(); }
+
+    LocalServer(const LocalServer&)            = delete;
+    LocalServer& operator=(const LocalServer&) = delete;
+
+    // Starts serving worldDir; a no-op if it already is
+    void start(const std::string& worldDir) {
+        if (running() && worldDir == _world) return;
+        stop();
+        _world = worldDir;
+        _lb    = std::make_unique<Loopback>();
+        _thread = std::thread([lb = _lb.get(), world = _world] {
+            std::vector<std::string> args = {"server", "--world-dir", world};
+            std::vector<char*>       argv;
+            for (std::string& a : args) argv.push_back(a.data());
+            if (serverMain((int)argv.size(), argv.data(), lb) != 0)
+                Log::err("In-process server for " + world + " failed");
+        });
+    }
+
+    // Returns once the server has saved and gone
+    void stop() {
+        if (!_thread.joinable()) return;
+        _lb->close();
+        _thread.join();
+        _lb.reset();
+        _world.clear();
+    }
+
+    bool               running() const { return _thread.joinable(); }
+    const std::string& world() const { return _world; }
+    Loopback&          loopback() { return *_lb; }
+
+private:
+    std::unique_ptr<Loopback> _lb;
+    std::thread               _thread;
+    std::string               _world;
+};
@@ -20,6 +20,14 @@ enum class GameState {
 struct GameSettings {
     float renderDistance = 2.f;
     bool  vsync          = true;
+    bool  allowTearing   = false; // without vsync: immediate rather than mailbox
+    bool  lowLatency     = false; // one frame queued, not two
+    float fpsLimit       = 0.f;   // 0: none
+    bool  depthPrepass   = false; // cheaper terrain shading where overdraw is high
+    bool  dynamicResolution = false; // scene resolution follows GPU frame time
+    bool  foliage        = true;  // grass and rocks scattered near the camera
+    int   shaderQuality  = 1;     // ShaderTier: 0 low, 1 medium, 2 high
+    float shaderQualityF = 1.f;
     int   fov            = 70;
     float fovF           = 70.f;
     float mouseSens      = 0.10f;
@@ -58,15 +66,19 @@ class MainMenu {
 public:
     MainMenu();
 
-    // Returns current GameState. When Connecting, read pendingServerIP/Port.
+    // Returns current GameState. When Connecting, read pendingServerIP/Port,
+    // or pendingWorld if pendingServerIP is LOCAL_SERVER (singleplayer).
     GameState draw(float dt, int screenW, int screenH);
 
+    static constexpr const char* LOCAL_SERVER = "__LOCAL__";
+
     GameSettings& settings() { return _settings; }
     AccountState& account()  { return _account; }
 
     std::string pendingServerIP;
     int         pendingServerPort = 7777;
     char        pendingUsername[64] = {};
+    std::string pendingWorld; // world directory for the in-process server
 
 private:
     GameState    _state = GameState::MainMenu;
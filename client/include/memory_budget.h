@@ -0,0 +1,171 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <imgui.h>
+#include <vk_mem_alloc.h>
+#include "config.h"
+#include "log.h"
+#include "mem_tags.h"
+#include "net_alloc.h"
+#include "range_allocator.h"
+
+// What the renderer's fixed-size pools hold (vk_memory_stats)
+struct GpuMemoryStats {
+    RangeAllocator::Stats verts, inds, meshlets; // mega buffers, meshlet table
+    uint32_t     slotsUsed   = 0, slotsMax = 0;
+    VkDeviceSize stagingUsed = 0, stagingSize = 0;
+};
+
+// ── MemoryBudget ──────────────────────────────────────────────────────────────
+// Keeps the client inside its video memory by asking for less of the world.
+// sample() reads, once a frame, the device-local heaps against what the
+// driver says is ours to use (VK_EXT_memory_budget through VMA; without it
+// VMA counts only its own blocks against most of the heap) and how full the
+// fixed chunk pools are, which run out first on most cards. The load is the
+// worst of them. Above HIGH the view radius asked of the server drops a ring
+// every STEP_S; above CRITICAL, or once a chunk found no room, by a quarter
+// at once. It comes back a ring at a time after RECOVER_S under RELIEF. A
+// smaller radius also means fewer LOD levels, and what falls outside it is
+// evicted when the server's new ViewConfig arrives.
+//
+// It also keeps the client's memory accounting: every MEM_SNAPSHOT_S the
+// heap tags (MemTags, when built in), ENet's pools and VMA's blocks per
+// heap go through a MemTags::Watch, and anything growing steadily is
+// logged. The panel shows them live.
+class MemoryBudget {
+public:
+    static constexpr float  HIGH      = 0.90f;
+    static constexpr float  CRITICAL  = 0.97f;
+    static constexpr float  RELIEF    = 0.75f;
+    static constexpr double STEP_S    = 2.0;
+    static constexpr double RECOVER_S = 10.0;
+
+    bool visible = false;
+
+    // misses: chunks dropped for want of room since the last call
+    void sample(VmaAllocator alloc, const GpuMemoryStats& pools, size_t misses, double now) {
+        watch(now);
+        vmaSetCurrentFrameIndex(alloc, ++_frame);
+        const VkPhysicalDeviceMemoryProperties* mem = nullptr;
+        vmaGetMemoryProperties(alloc, &mem);
+        VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+        vmaGetHeapBudgets(alloc, budgets);
+
+        _pools    = pools;
+        _heapLoad = 0.f;
+        _heaps.clear();
+        for (uint32_t h = 0; h < mem->memoryHeapCount; h++) {
+            if (!(mem->memoryHeaps[h].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) continue;
+            _heaps.push_back({h, budgets[h]});
+            if (budgets[h].budget)
+                _heapLoad = std::max(_heapLoad, (float)budgets[h].usage / (float)budgets[h].budget);
+        }
+        _poolLoad = std::max({fill(pools.verts), fill(pools.inds), fill(pools.meshlets),
+                              pools.slotsMax ? (float)pools.slotsUsed / (float)pools.slotsMax : 0.f});
+        float load = std::max(_heapLoad, _poolLoad);
+        _misses += misses;
+
+        if (misses || load > CRITICAL) {
+            if (now - _lastCut >= STEP_S / 4) cut(std::max(1, (_radius - _cut) / 4), now);
+        } else if (load > HIGH) {
+            if (now - _lastCut >= STEP_S) cut(1, now);
+        } else if (load < RELIEF) {
+            if (_cut > 0 && now - std::max(_lastCut, _calmSince) >= RECOVER_S) {
+                _cut--;
+                _calmSince = now;
+            }
+            return;
+        }
+        _calmSince = now;
+    }
+
+    // Heap tags, ENet and VMA's device-local blocks, for the leak watch
+    std::vector<MemTags::Row> accounts() const {
+        std::vector<MemTags::Row> rows = MemTags::snapshot();
+        rows.push_back({"enet", NetAlloc::stats().liveBytes, 0});
+        for (const Heap& h : _heaps)
+            rows.push_back({"vulkan_heap" + std::to_string(h.index), (int64_t)h.b.statistics.blockBytes,
+                            (int64_t)h.b.statistics.blockCount});
+        return rows;
+    }
+
+    // The radius to ask the server for, given the one the player chose
+    int radius(int wanted) {
+        _radius = wanted;
+        _cut    = std::min(_cut, std::max(0, wanted - Config::MEMORY_MIN_RADIUS));
+        return wanted - _cut;
+    }
+    bool underPressure() const { return _cut > 0; }
+
+    void drawPanel() {
+        if (!visible) return;
+        ImGui::SetNextWindowPos({12.f, 420.f}, ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowBgAlpha(0.7f);
+        if (!ImGui::Begin("Memory", &visible, ImGuiWindowFlags_AlwaysAutoResize)) {
+            ImGui::End();
+            return;
+        }
+        constexpr float MB = 1.f / (1024.f * 1024.f);
+        ImGui::TextDisabled("Device-local heaps");
+        for (const Heap& h : _heaps)
+            ImGui::Text("heap %u   %7.1f / %7.1f MB  (VMA %7.1f MB)", h.index, (float)h.b.usage * MB,
+                        (float)h.b.budget * MB, (float)h.b.statistics.blockBytes * MB);
+        ImGui::Separator();
+        ImGui::TextDisabled("Chunk pools");
+        auto pool = [](const char* name, const RangeAllocator::Stats& s) {
+            ImGui::Text("%-9s %5.1f%% full, %4.1f%% fragmented, %u blocks", name,
+                        100.f * fill(s), 100.f * s.fragmentation(), s.liveBlocks);
+        };
+        pool("vertices", _pools.verts);
+        pool("indices", _pools.inds);
+        pool("meshlets", _pools.meshlets);
+        ImGui::Text("%-9s %u / %u", "slots", _pools.slotsUsed, _pools.slotsMax);
+        ImGui::Text("%-9s %5.1f / %5.1f MB", "staging", (float)_pools.stagingUsed * MB,
+                    (float)_pools.stagingSize * MB);
+        ImGui::Separator();
+        ImGui::TextDisabled(MemTags::enabled() ? "Heap" : "Heap (build with -Dmem_tags=true to see it by subsystem)");
+        for (int t = 0; t < MemTags::COUNT && MemTags::enabled(); t++) {
+            MemTags::Stats s = MemTags::stats((MemTags::Tag)t);
+            ImGui::Text("%-12s %7.1f MB  %8lld blocks", MemTags::name((MemTags::Tag)t), (float)s.liveBytes * MB,
+                        (long long)s.liveBlocks);
+        }
+        NetAlloc::Stats net = NetAlloc::stats();
+        ImGui::Text("%-12s %7.1f MB  (%.1f MB kept)", "enet", (float)net.liveBytes * MB, (float)net.heldBytes * MB);
+        ImGui::Separator();
+        ImGui::Text("load %.0f%%  radius %d (-%d)  %zu chunks dropped", 100.f * std::max(_heapLoad, _poolLoad),
+                    _radius - _cut, _cut, _misses);
+        ImGui::End();
+    }
+
+private:
+    struct Heap {
+        uint32_t  index;
+        VmaBudget b;
+    };
+
+    static float fill(const RangeAllocator::Stats& s) {
+        return s.capacity ? (float)s.used / (float)s.capacity : 0.f;
+    }
+    void watch(double now) {
+        if (now - _lastSnapshot < Config::MEM_SNAPSHOT_S) return;
+        _lastSnapshot = now;
+        _watch.sample(accounts());
+    }
+    void cut(int rings, double now) {
+        _cut     = std::min(_cut + rings, std::max(0, _radius - Config::MEMORY_MIN_RADIUS));
+        _lastCut = now;
+    }
+
+    uint32_t            _frame = 0;
+    std::vector<Heap>   _heaps;
+    GpuMemoryStats      _pools;
+    float               _heapLoad = 0.f, _poolLoad = 0.f;
+    size_t              _misses   = 0;
+    int                 _radius   = Config::VIEW_RADIUS_MAX; // as last asked for by radius()
+    int                 _cut      = 0;                       // rings taken off it
+    double              _lastCut  = -1e9, _calmSince = 0.0;
+    MemTags::Watch      _watch;
+    double              _lastSnapshot = 0.0;
+};
@@ -1,19 +1,52 @@
 #pragma once
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <queue>
 #include <mutex>
+#include <unordered_map>
 #include "chunk.h"
+#include "chunk_codec.h"
+#include "chunk_collider.h"
+#include "chunk_disk_cache.h"
 #include "packets.h"
 #include "thread_pool.h"
 
-// Receives raw ChunkDataPacket bytes from the network thread,
-// deserializes + runs toMesh() on a worker thread, then exposes
-// finished ChunkMesh objects for the main thread to poll.
+// Receives raw ChunkDataPacket / ChunkFieldPacket bytes from the network
+// thread, decodes them (marching field packets) into a ChunkMesh on a worker
+// thread and packs that into a ChunkUpload, then exposes finished uploads for
+// the main thread to poll.
 //
 // Thread model:
-//   Main/ENet thread  →  submit(bytes)      (fast, just a queue push)
-//   Worker thread     →  deserialize+toMesh (CPU heavy, off main)
-//   Main thread       →  poll(mesh)          (non-blocking drain)
+//   Network thread    →  submit(bytes)      (fast, just a queue push)
+//   Worker thread     →  deserialize/march  (CPU heavy, off main)
+//   Main thread       →  poll(upload)        (non-blocking drain)
+//
+// The worker also builds each chunk's ChunkCollider from the same packed
+// vertices, so the player controller collides with exactly what's drawn and
+// the main thread never passes over the triangles.
+//
+// ChunkUpdate packets (an edited chunk, versioned) are unwrapped here. A
+// decode that finishes after a newer version of its chunk was submitted is
+// dropped at poll(), so a slow worker can't put an old edit back on screen.
+//
+// Uploads are moved, never copied, from the worker to the upload queue. Once
+// their bytes are in staging, hand the shells back with recycle() and the
+// next decode reuses their vectors' capacity instead of allocating.
+//
+// With a disk cache set, every full-resolution chunk that decodes is stored
+// there, and submitCached() decodes one from it (a ChunkCached from the
+// server). One that isn't there after all comes out of pollMisses(), to be
+// asked for again with a ChunkUnload.
+//
+// With setGpuFields(true) (--gpu-mesh) field packets are only decoded: the
+// fields come out of pollFields() for the GPU to march, and the triangles it
+// reads back come in through submitCollider() to have their colliders built
+// here all the same.
+//
+// ChunkPacked payloads (compressed by the server, see chunk_codec.h) are
+// unpacked on the worker with the dictionary the session's ChunkDict
+// brought; the disk cache stores them unpacked.
 
 class MeshBuilder {
 public:
@@ -24,18 +57,95 @@ public:
     // enet_packet_destroy(). Non-blocking.
     void submit(const uint8_t* data, size_t len);
 
-    // Drain up to maxPerFrame finished meshes into out[].
-    // Returns number of meshes written. Non-blocking.
-    int poll(std::vector<ChunkMesh>& out, int maxPerFrame = 8);
+    // The dictionary ChunkPacked payloads submitted from now on were packed
+    // with; nullptr for none. Network thread, in order with submit().
+    void setDictionary(std::shared_ptr<const ChunkDict> dict) {
+        std::lock_guard lk(_dictMu);
+        _dict = std::move(dict);
+    }
+
+    // The disk cache to store into and load from; nullptr for none. The
+    // cache opens and closes by itself, so this is set once.
+    void setDiskCache(ChunkDiskCache* disk) { _disk.store(disk, std::memory_order_relaxed); }
+    // Decode the chunk at c from the disk cache, as the server said to
+    // (ChunkCachedPacket). Non-blocking.
+    void submitCached(const ChunkCoord& c, uint32_t version, uint64_t hash);
+    // Chunks submitCached couldn't find (appending)
+    void pollMisses(std::vector<ChunkCoord>& out);
+
+    // Drain up to maxPerFrame finished uploads into out[], and each one's
+    // collider at the same position in colliders[].
+    // Returns number of uploads written. Non-blocking.
+    int poll(std::vector<ChunkUpload>& out, std::vector<ChunkCollider>& colliders,
+             int maxPerFrame = 8);
+
+    // Return spent uploads (contents no longer needed) for reuse. Clears v.
+    void recycle(std::vector<ChunkUpload>& v);
+
+    // GPU meshing. Call setGpuFields before the first submit.
+    void setGpuFields(bool on) { _gpuFields.store(on, std::memory_order_relaxed); }
+    // Drain up to maxPerFrame decoded fields, stale ones dropped like poll's,
+    // and each one's face links (chunkFaceLinks) at the same position
+    int  pollFields(std::vector<std::unique_ptr<ChunkData>>& out,
+                    std::vector<uint16_t>& faceLinks, int maxPerFrame);
+    // Return fields once their voxels are on the GPU. Clears v.
+    void recycleFields(std::vector<std::unique_ptr<ChunkData>>& v);
+    // Builds the collider for a GPU-meshed chunk on a worker; pollColliders
+    // drains them (appending)
+    void submitCollider(ChunkUpload&& upload);
+    void pollColliders(std::vector<ChunkCollider>& out);
 
     // How many jobs are still in flight (for loading screen etc.)
     int pending() const;
 
+    // Drop everything submitted so far — queued decodes never run, running
+    // ones are discarded, finished ones are never polled. For disconnects;
+    // safe against a submit() on another thread.
+    void cancelPending();
+
 private:
+    static constexpr size_t SHELLS_MAX = 32;
+    static constexpr size_t FIELDS_MAX = 16; // ~70 KB each
+
+    struct Built {
+        ChunkUpload   upload;
+        ChunkCollider collider;
+        int64_t       readyUs = 0; // decoded, while tracing
+        uint32_t      version = 0; // ChunkUpdate version; 0 for a plain chunk packet
+        std::unique_ptr<ChunkData> field; // setGpuFields: decoded, not marched
+        bool          missed  = false; // submitCached: not on disk, only upload.coord is set
+        bool          dropped = false; // couldn't be unpacked: nothing to hand out
+    };
+
+    Built decode(const std::vector<uint8_t>& buf, uint32_t version, int64_t recvUs, bool store);
+    void  finish(TaskFuture<Built>& built, const CancelToken& cancel);
+    void  noteVersion(const ChunkCoord& c, uint32_t version);
+
+    ChunkUpload takeShell();
+    std::unique_ptr<ChunkData> takeField();
+    CancelToken token() const;
+    // Under _readyMu
+    bool stale(const ChunkCoord& c, uint32_t version) const;
+
     ThreadPool _pool;
 
+    std::mutex             _shellMu;
+    std::vector<ChunkUpload> _shells;
+    std::vector<std::unique_ptr<ChunkData>> _fieldShells;
+
     mutable std::mutex _readyMu;
-    std::queue<ChunkMesh> _ready;
+    std::queue<Built>  _ready;
+    std::queue<Built>  _fields;
+    std::vector<ChunkCollider> _colliders;
+    std::vector<ChunkCoord>    _misses;
+    std::unordered_map<ChunkCoord, uint32_t, ChunkCoordHash> _latest; // newest version submitted
+
+    std::atomic<int>  _inFlight{0};
+    std::atomic<bool> _gpuFields{false};
+    std::atomic<ChunkDiskCache*> _disk{nullptr};
+
+    std::mutex                       _dictMu;
+    std::shared_ptr<const ChunkDict> _dict;
 
-    std::atomic<int> _inFlight{0};
+    CancelToken _cancel = CancelToken::make(); // replaced by cancelPending(), under _readyMu
 };
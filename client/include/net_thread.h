@@ -0,0 +1,132 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <enet/enet.h>
+#include "loopback.h"
+#include "net_common.h"
+#include "packet_dispatch.h"
+#include "spsc_queue.h"
+
+// ── NetThread ─────────────────────────────────────────────────────────────────
+// Owns the client's ENet host and services it on a thread of its own, so
+// packets are taken off the socket as they arrive rather than once per
+// rendered frame, and a connect never stalls the menu. ENet isn't
+// thread-safe: nothing else touches the host or the peer.
+//
+// The game thread talks to it through two lock-free rings:
+//   commands  game → net   connect, and packets to send (built on the game
+//                          thread, so only the pointer crosses)
+//   events    net → game   connection changes, and every received message
+//                          with no handler registered here
+// Messages with a handler here (chunk packets, going straight to
+// MeshBuilder) never reach the game thread. Bundles are unpacked first, so
+// routing is per message. Either side holds on to what doesn't fit in a
+// full ring and retries, in order; nothing is dropped.
+//
+// Each connect() starts a new session; events carry it, so anything left
+// over from an abandoned attempt can be told apart. A session can be with
+// an in-process server over a Loopback instead of a host: the same
+// handlers and events, with packets passed by pointer.
+class NetThread {
+public:
+    struct Event {
+        enum class Kind : uint8_t { Message, Connected, ConnectFailed, Disconnected };
+        Kind                 kind    = Kind::Message;
+        uint32_t             session = 0;
+        std::vector<uint8_t> bytes; // Message: one message, out of its bundle
+    };
+
+    // Gives up on a connect the server hasn't answered in this long
+    static constexpr std::chrono::milliseconds CONNECT_TIMEOUT{5000};
+    // Longest enet_host_service wait: bounds how long a queued send sits
+    static constexpr uint32_t SERVICE_MS = 1;
+
+    NetThread() = default;
+    ~NetThread() { stop(); }
+
+    NetThread(const NetThread&)            = delete;
+    NetThread& operator=(const NetThread&) = delete;
+
+    // ── Setup — before start() ────────────────────────────────────────────
+    // Handled on the network thread; fn must be safe to call from there
+    template<class Id>
+    void on(Id id, PacketDispatcher::Handler fn) { _dispatch.on(id, std::move(fn)); }
+    // Runs on the network thread as each connect starts, before any packet
+    // of the new session is handled
+    void onSessionStart(std::function<void()> fn) { _sessionStart = std::move(fn); }
+
+    void start();
+    // Disconnects (flushing the notice to the server) and joins
+    void stop();
+
+    // ── Game thread ───────────────────────────────────────────────────────
+    // Drops any current connection; returns the new session's id
+    uint32_t connect(const std::string& host, uint16_t port);
+    // Connected as soon as the network thread takes it; lb must outlive
+    // the session (until the next connect, or stop())
+    uint32_t connect(Loopback& lb);
+    // Reliable, on the gameplay channel. The bytes are copied.
+    void sendReliable(const uint8_t* data, size_t len);
+    void sendReliable(const std::vector<uint8_t>& data) { sendReliable(data.data(), data.size()); }
+    // Unreliable-sequenced, on the movement channel
+    void sendMovement(const uint8_t* data, size_t len);
+    bool poll(Event& out);
+
+private:
+    struct Command {
+        enum class Kind : uint8_t { Send, Connect };
+        Kind        kind    = Kind::Send;
+        uint8_t     channel = 0;
+        uint32_t    session = 0;       // Connect
+        uint16_t    port    = 0;       // Connect
+        std::string host;              // Connect
+        Loopback*   loop    = nullptr; // Connect, in-process
+        ENetPacket* packet  = nullptr; // Send
+    };
+    enum class State : uint8_t { Idle, Connecting, Connected };
+
+    static constexpr size_t COMMANDS = 256;
+    static constexpr size_t EVENTS   = 1024;
+    // Message buffers go round the event ring and back (SpscQueue::claim,
+    // exchange) rather than being allocated per message; one that grew
+    // past this is let go instead
+    static constexpr size_t KEEP_BYTES = 16 << 10;
+
+    void command(Command&& c);
+    void run();
+    void execute(Command& c);
+    void handle(const ENetEvent& ev);
+    void emit(Event&& ev);
+    void emitMessage(const uint8_t* d, size_t len);
+    void flushEvents();
+    void loopSend(Loopback::Message&& m);
+    bool pumpLoopback(); // true if anything arrived
+    void dropLoopback();
+
+    // Network thread only
+    PacketDispatcher      _dispatch;
+    std::function<void()> _sessionStart;
+    ENetHost*             _host    = nullptr;
+    ENetPeer*             _peer    = nullptr;
+    State                 _state   = State::Idle;
+    uint32_t              _session = 0;
+    std::chrono::steady_clock::time_point _connectStart;
+    std::deque<Event>     _eventsWaiting;
+    Loopback*             _loop = nullptr; // instead of _peer, in-process
+    std::deque<Loopback::Message> _loopWaiting;
+
+    // Game thread only
+    uint32_t            _nextSession = 0;
+    std::deque<Command> _commandsWaiting;
+
+    SpscQueue<Command, COMMANDS> _commands;
+    SpscQueue<Event, EVENTS>     _events;
+    std::atomic<bool>            _running{false};
+    std::thread                  _thread;
+};
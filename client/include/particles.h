@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include "spsc_queue.h"
+
+// ── ParticleEmitter ───────────────────────────────────────────────────────────
+// One burst, as gameplay asks for it: count particles leave pos along dir,
+// spread out into a cone (0 a line, 1 every way), at about speed, living
+// about life seconds. particle.comp spawns them on the GPU the frame it's
+// queued (vk_emit_particles) and simulates them from then on, so loose
+// particles cost the CPU nothing; only emitters are handed over. std430, as
+// particle.comp reads them.
+struct ParticleEmitter {
+    glm::vec3 pos{0.f};
+    uint32_t  count = 0;
+    glm::vec3 dir{0.f, 1.f, 0.f};
+    float     speed = 1.f;     // blocks per second
+    glm::vec3 color{1.f};
+    float     spread = 1.f;
+    float     life = 0.5f;     // seconds
+    float     size = 0.1f;     // blocks across
+    float     gravity = 1.f;   // share of Config::GRAVITY
+    float     drag = 1.f;      // velocity lost per second, as a rate
+    uint32_t  additive = 0;    // glows: added over the scene, drawn as streaks
+    uint32_t  pad0 = 0, pad1 = 0, pad2 = 0;
+};
+static_assert(sizeof(ParticleEmitter) == 80, "particle.comp's Emitter");
+
+// From the sim thread to the renderer: combat pushes as it resolves, the
+// main thread drains it into vk_emit_particles each frame. Full, a burst is
+// dropped; they're only looks.
+using ParticleRing = SpscQueue<ParticleEmitter, 256>;
+
+// ── Effects ───────────────────────────────────────────────────────────────────
+namespace ParticleFx {
+
+// A blade striking: sparks off the edge and bits of what was struck, both
+// thrown along the blow
+inline ParticleEmitter hitSparks(glm::vec3 pos, glm::vec3 dir, bool heavy) {
+    ParticleEmitter e;
+    e.pos = pos; e.dir = dir;
+    e.count = heavy ? 48 : 24;   e.speed = heavy ? 9.f : 6.f;
+    e.color = {1.f, 0.75f, 0.35f}; e.spread = 0.6f;
+    e.life = 0.35f; e.size = 0.05f; e.gravity = 1.f; e.drag = 1.5f;
+    e.additive = 1;
+    return e;
+}
+inline ParticleEmitter hitDebris(glm::vec3 pos, glm::vec3 dir, bool heavy) {
+    ParticleEmitter e;
+    e.pos = pos; e.dir = dir;
+    e.count = heavy ? 20 : 10;   e.speed = 3.f;
+    e.color = {0.45f, 0.06f, 0.05f}; e.spread = 0.8f;
+    e.life = 0.6f; e.size = 0.08f; e.gravity = 1.f; e.drag = 1.f;
+    return e;
+}
+
+// Blade on blade: a bright ring of sparks every way
+inline ParticleEmitter parry(glm::vec3 pos) {
+    ParticleEmitter e;
+    e.pos = pos;
+    e.count = 40; e.speed = 8.f;
+    e.color = {0.8f, 0.9f, 1.f}; e.spread = 1.f;
+    e.life = 0.25f; e.size = 0.04f; e.gravity = 0.3f; e.drag = 3.f;
+    e.additive = 1;
+    return e;
+}
+
+// Something killed: a slow puff of dust that rises as it thins
+inline ParticleEmitter death(glm::vec3 pos) {
+    ParticleEmitter e;
+    e.pos = pos;
+    e.count = 64; e.speed = 2.f;
+    e.color = {0.55f, 0.52f, 0.48f}; e.spread = 1.f;
+    e.life = 1.2f; e.size = 0.25f; e.gravity = -0.05f; e.drag = 2.5f;
+    return e;
+}
+
+// Ground kicked up behind a roll, low and brown
+inline ParticleEmitter dust(glm::vec3 pos, glm::vec3 dir) {
+    ParticleEmitter e;
+    e.pos = pos; e.dir = dir;
+    e.count = 20; e.speed = 1.5f;
+    e.color = {0.5f, 0.43f, 0.33f}; e.spread = 0.9f;
+    e.life = 0.8f; e.size = 0.2f; e.gravity = 0.1f; e.drag = 3.f;
+    return e;
+}
+
+// A swing through the air in front of the eye, a faint streak along it
+inline ParticleEmitter swing(glm::vec3 pos, glm::vec3 dir, bool heavy) {
+    ParticleEmitter e;
+    e.pos = pos; e.dir = dir;
+    e.count = heavy ? 20 : 12; e.speed = heavy ? 5.f : 4.f;
+    e.color = {0.35f, 0.35f, 0.4f}; e.spread = 0.15f;
+    e.life = 0.15f; e.size = 0.03f; e.gravity = 0.f; e.drag = 4.f;
+    e.additive = 1;
+    return e;
+}
+
+} // namespace ParticleFx
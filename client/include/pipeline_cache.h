@@ -0,0 +1,154 @@
+#pragma once
+#include "log.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// ── PipelineCache ─────────────────────────────────────────────────────────────
+// VkPipelineCache persisted to <config>/aetheris/pipeline_cache.bin. The
+// file is our own header followed by the driver's blob; it's only handed
+// back to the driver if it was written by the same device and driver version
+// and the blob is intact, since drivers don't all survive a stale or torn
+// cache. A rejected file just means an empty cache and a slower first start.
+namespace PipelineCache {
+
+struct FileHeader {
+    uint32_t magic;         // 'AEPC'
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t  uuid[VK_UUID_SIZE];
+    uint64_t dataSize;
+    uint64_t dataHash;      // FNV-1a of the blob
+};
+
+inline constexpr uint32_t MAGIC   = 0x43504541; // "AEPC" little-endian
+inline constexpr uint32_t VERSION = 1;
+
+inline uint64_t hash(const uint8_t* p, size_t n) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < n; i++) { h ^= p[i]; h *= 1099511628211ull; }
+    return h;
+}
+
+// $XDG_CONFIG_HOME, ~/.config, or %APPDATA%; empty if none is set
+inline std::filesystem::path dir() {
+    namespace fs = std::filesystem;
+    if (const char* x = std::getenv("XDG_CONFIG_HOME"); x && *x) return fs::path(x) / "aetheris";
+    if (const char* a = std::getenv("APPDATA"); a && *a)         return fs::path(a) / "aetheris";
+    if (const char* h = std::getenv("HOME"); h && *h)            return fs::path(h) / ".config" / "aetheris";
+    return {};
+}
+
+inline std::filesystem::path file() {
+    auto d = dir();
+    return d.empty() ? d : d / "pipeline_cache.bin";
+}
+
+inline FileHeader headerFor(const VkPhysicalDeviceProperties& props) {
+    FileHeader h{};
+    h.magic         = MAGIC;
+    h.version       = VERSION;
+    h.vendorID      = props.vendorID;
+    h.deviceID      = props.deviceID;
+    h.driverVersion = props.driverVersion;
+    std::memcpy(h.uuid, props.pipelineCacheUUID, VK_UUID_SIZE);
+    return h;
+}
+
+// The saved blob for this device, or empty if there's none we trust
+inline std::vector<uint8_t> read(const VkPhysicalDeviceProperties& props) {
+    auto path = file();
+    if (path.empty()) return {};
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return {};
+
+    FileHeader want = headerFor(props), got{};
+    if (!f.read(reinterpret_cast<char*>(&got), sizeof(got))) return {};
+    if (got.magic != MAGIC || got.version != VERSION ||
+        got.vendorID != want.vendorID || got.deviceID != want.deviceID ||
+        got.driverVersion != want.driverVersion ||
+        std::memcmp(got.uuid, want.uuid, VK_UUID_SIZE) != 0) {
+        Log::info("Pipeline cache is from another device or driver, rebuilding");
+        return {};
+    }
+    if (got.dataSize < sizeof(VkPipelineCacheHeaderVersionOne) || got.dataSize > (256u << 20)) return {};
+
+    std::vector<uint8_t> data((size_t)got.dataSize);
+    if (!f.read(reinterpret_cast<char*>(data.data()), (std::streamsize)data.size()) ||
+        hash(data.data(), data.size()) != got.dataHash) {
+        Log::warn("Pipeline cache is truncated or corrupt, rebuilding");
+        return {};
+    }
+
+    // The driver's own header must agree with ours
+    VkPipelineCacheHeaderVersionOne vh;
+    std::memcpy(&vh, data.data(), sizeof(vh));
+    if (vh.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        vh.vendorID != props.vendorID || vh.deviceID != props.deviceID ||
+        std::memcmp(vh.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        return {};
+    return data;
+}
+
+inline VkPipelineCache create(VkPhysicalDevice phys, VkDevice dev) {
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(phys, &props);
+    std::vector<uint8_t> data = read(props);
+
+    VkPipelineCacheCreateInfo ci{};
+    ci.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    ci.initialDataSize = data.size();
+    ci.pInitialData    = data.empty() ? nullptr : data.data();
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    if (vkCreatePipelineCache(dev, &ci, nullptr, &cache) != VK_SUCCESS && !data.empty()) {
+        ci.initialDataSize = 0;
+        ci.pInitialData    = nullptr;
+        vkCreatePipelineCache(dev, &ci, nullptr, &cache);
+    }
+    Log::info(data.empty() ? "Pipeline cache: empty"
+                           : "Pipeline cache: loaded " + std::to_string(data.size() / 1024) + " KiB");
+    return cache;
+}
+
+// Written to a temp file and renamed over, so a crash mid-write leaves the
+// previous cache in place
+inline void save(VkPhysicalDevice phys, VkDevice dev, VkPipelineCache cache) {
+    namespace fs = std::filesystem;
+    auto path = file();
+    if (!cache || path.empty()) return;
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(dev, cache, &size, nullptr) != VK_SUCCESS || size == 0) return;
+    std::vector<uint8_t> data(size);
+    if (vkGetPipelineCacheData(dev, cache, &size, data.data()) != VK_SUCCESS) return;
+    data.resize(size);
+
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(phys, &props);
+    FileHeader h = headerFor(props);
+    h.dataSize = data.size();
+    h.dataHash = hash(data.data(), data.size());
+
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    fs::path tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f) { Log::warn("Pipeline cache: cannot write " + tmp.string()); return; }
+        f.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        f.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
+        if (!f) { Log::warn("Pipeline cache: write failed"); return; }
+    }
+    fs::rename(tmp, path, ec);
+    if (ec) Log::warn("Pipeline cache: " + ec.message());
+}
+
+} // namespace PipelineCache
@@ -1,14 +1,17 @@
 #pragma once
 #include <entt/entt.hpp>
 #include <glm/vec3.hpp>
-#include <unordered_map>
-#include <unordered_set>
+#include <array>
 #include "chunk.h"
+#include "chunk_collider.h"
+#include "collide_kernels.h"
 #include "camera.h"
 #include "input.h"
 #include "config.h"
+#include "flat_map.h"
 #include "combat.h"
 #include "inventory.h"
+#include "mp_packets.h"
 
 // ── ECS Components ────────────────────────────────────────────────────────────
 
@@ -25,9 +28,14 @@ struct CStamina {
     float depleteCooldown = 0.f;
 };
 
-struct ChunkTriSoup { std::vector<glm::vec3> tris; };
-
 // ── PlayerController ──────────────────────────────────────────────────────────
+// Movement is predicted: each update is one numbered input, simulated right
+// away and kept (with the state it produced) in a ring of PREDICT_HISTORY.
+// Moves sent to the server carry the newest input's number; a
+// MoveCorrection names the input the server refused and where the player
+// really is, and applyCorrection() rewinds to it, takes the server's state
+// and replays every later input through the same collision code. The
+// camera eases over the jump rather than snapping.
 
 class CombatSystem;
 
@@ -35,11 +43,20 @@ class PlayerController {
 public:
     PlayerController(entt::registry& reg, Camera& cam);
 
-    void addChunkMesh(const ChunkMesh& mesh);
+    // Collision grid from the MeshBuilder worker, one per meshed chunk
+    void addChunk(ChunkCollider&& collider);
     void removeChunk(ChunkCoord coord);
     void setSpawnPosition(glm::vec3 pos);
 
-    void update(float dt, const Input& input, CombatSystem* combat = nullptr);
+    // One simulation tick. Moves along the camera's yaw and pitch, which
+    // are the caller's to turn, and leaves its position at the eye
+    void update(float dt, const InputState& input, CombatSystem* combat = nullptr);
+
+    // Newest input, and the newest correction epoch applied, for PlayerMoveQ
+    uint16_t inputSeq()  const { return _seq; }
+    uint8_t  moveEpoch() const { return _epoch; }
+    void     applyCorrection(const MoveCorrectionPacket& c);
+    uint32_t corrections() const { return _corrections; } // applied, ever
 
     glm::vec3    position()  const;
     entt::entity entity()    const { return _player; }
@@ -55,36 +72,68 @@ public:
     const CInventory& inventory() const { return _reg.get<CInventory>(_player); }
 
 private:
+    // What one update fed the simulation, decided before it ran so a replay
+    // makes the same choices (stamina and combat aren't replayed)
+    struct MoveInput {
+        float     dt      = 0.f;
+        glm::vec3 target  {0.f}; // horizontal velocity wanted
+        bool      moving  = false;
+        bool      jump    = false; // wanted, and stamina allowed it
+        bool      rolling = false;
+        glm::vec3 dodgeVel{0.f};
+    };
+    struct MoveState {
+        glm::vec3 pos{0.f}, vel{0.f}, smoothVel{0.f};
+        bool      grounded = false;
+    };
+    struct Predicted {
+        uint16_t  seq = 0;
+        MoveInput in;
+        MoveState after;
+    };
+
     entt::registry& _reg;
     Camera&         _cam;
     entt::entity    _player;
 
-    std::unordered_map<ChunkCoord, ChunkTriSoup, ChunkCoordHash> _triSoups;
+    FlatMap<ChunkCoord, ChunkCollider, ChunkCoordHash> _colliders;
+
+    // Triangles near the player, gathered per query for the batch kernels
+    Collide::TriSoA        _near;
+    std::vector<uint8_t>   _hit;
+    std::vector<glm::vec3> _mtv;
 
     bool      _spawned         = false;
     bool      _hasPendingSpawn = false;
     glm::vec3 _pendingSpawn    {0.f, 120.f, 0.f};
 
-    std::unordered_set<ChunkCoord, ChunkCoordHash> _requiredChunks;
+    FlatSet<ChunkCoord, ChunkCoordHash> _requiredChunks;
 
     // Skyrim-style movement: smooth horizontal velocity target
     glm::vec3 _smoothVel{0.f}; // current horizontal velocity (blended)
 
+    std::array<Predicted, Config::PREDICT_HISTORY> _history;
+    uint16_t  _seq         = 0;
+    uint16_t  _spawnSeq    = 1;    // first input since the latest spawn
+    uint8_t   _epoch       = 0;
+    uint32_t  _corrections = 0;
+    glm::vec3 _renderError {0.f};  // camera's offset from the corrected path, easing out
+
     void buildRequiredChunks(glm::vec3 pos);
     bool spawnChunksReady()  const;
 
+    // Replaces _near with every loaded triangle overlapping [mn, mx]
+    void gatherTris(glm::vec3 mn, glm::vec3 mx);
+
     void resolveCollision(CTransform& tf, CVelocity& vel,
                           const CAABB& box, CGrounded& unused);
 
-    // Raycast ground detection
-    bool raycastGround(const CTransform& tf, const CAABB& box, float& outHitY) const;
-
-    bool aabbTriTest(glm::vec3 mn, glm::vec3 mx,
-                     glm::vec3 a, glm::vec3 b, glm::vec3 c,
-                     glm::vec3& outMTV) const;
+    // One input's worth of gravity, collision and steering; true if it
+    // jumped
+    bool      simulate(const MoveInput& in);
+    MoveState captureState() const;
+    void      restoreState(const MoveState& st);
 
-    // Ray-triangle intersection (Möller–Trumbore)
-    bool rayTriTest(glm::vec3 orig, glm::vec3 dir, float maxDist,
-                    glm::vec3 a, glm::vec3 b, glm::vec3 c,
-                    float& outT) const;
+    // Raycast ground detection
+    bool raycastGround(const CTransform& tf, const CAABB& box, float& outHitY);
 };
@@ -0,0 +1,236 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// ── RangeAllocator ────────────────────────────────────────────────────────────
+// Two-level segregated fit (TLSF) over [0, capacity), in whatever unit the
+// caller counts (vertices, indices). Free blocks are binned into 16 classes
+// per power of two; two bitmaps find the smallest class whose blocks all
+// fit, so alloc is O(1) and never walks a free list. release merges with
+// both physical neighbours, also O(1). Zero-length requests get offset 0
+// and take no space.
+class RangeAllocator {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Stats {
+        uint32_t capacity    = 0;
+        uint32_t used        = 0;
+        uint32_t free        = 0;
+        uint32_t largestFree = 0;
+        uint32_t freeBlocks  = 0;
+        uint32_t liveBlocks  = 0;
+
+        // 0 while all free space is one block, toward 1 as it splinters
+        float fragmentation() const {
+            return free ? 1.f - (float)largestFree / (float)free : 0.f;
+        }
+    };
+
+    explicit RangeAllocator(uint32_t capacity = 0) { reset(capacity); }
+
+    void reset(uint32_t capacity) {
+        _blocks.clear();
+        _spare.clear();
+        _live.clear();
+        _flBits = 0;
+        for (auto& s : _slBits) s = 0;
+        for (auto& fl : _heads) for (auto& h : fl) h = NONE;
+        _capacity = capacity;
+        _used = 0;
+        _freeBlocks = 0;
+        _lastPhys = NONE;
+        if (capacity == 0) return;
+        _lastPhys = newBlock({0, capacity, NONE, NONE, NONE, NONE, true});
+        insertFree(_lastPhys);
+    }
+
+    // Offset of `count` free units, or NONE if no block is big enough
+    uint32_t alloc(uint32_t count) {
+        if (count == 0) return 0;
+        uint32_t b = findFit(count);
+        if (b == NONE) return NONE;
+        removeFree(b);
+
+        if (_blocks[b].size > count) {
+            Block rest{_blocks[b].offset + count, _blocks[b].size - count,
+                       b, _blocks[b].nextPhys, NONE, NONE, true};
+            uint32_t r = newBlock(rest);
+            if (_blocks[r].nextPhys != NONE) _blocks[_blocks[r].nextPhys].prevPhys = r;
+            else                             _lastPhys = r;
+            _blocks[b].nextPhys = r;
+            _blocks[b].size = count;
+            insertFree(r);
+        }
+
+        _blocks[b].free = false;
+        _live[_blocks[b].offset] = b;
+        _used += count;
+        return _blocks[b].offset;
+    }
+
+    // count must match the alloc that returned offset
+    void release(uint32_t offset, uint32_t count) {
+        if (count == 0) return;
+        auto it = _live.find(offset);
+        if (it == _live.end()) return;
+        uint32_t b = it->second;
+        _live.erase(it);
+        _used -= _blocks[b].size;
+        _blocks[b].free = true;
+
+        uint32_t n = _blocks[b].nextPhys;
+        if (n != NONE && _blocks[n].free) {
+            removeFree(n);
+            _blocks[b].size += _blocks[n].size;
+            unlinkPhys(n);
+        }
+        uint32_t p = _blocks[b].prevPhys;
+        if (p != NONE && _blocks[p].free) {
+            removeFree(p);
+            _blocks[p].size += _blocks[b].size;
+            unlinkPhys(b);
+            b = p;
+        }
+        insertFree(b);
+    }
+
+    // Highest live allocation — what compaction moves first. False if
+    // nothing is allocated.
+    bool last(uint32_t& offset, uint32_t& size) const {
+        uint32_t b = _lastPhys;
+        if (b != NONE && _blocks[b].free) b = _blocks[b].prevPhys;
+        if (b == NONE || _blocks[b].free) return false;
+        offset = _blocks[b].offset;
+        size   = _blocks[b].size;
+        return true;
+    }
+
+    Stats stats() const {
+        Stats s;
+        s.capacity   = _capacity;
+        s.used       = _used;
+        s.free       = _capacity - _used;
+        s.freeBlocks = _freeBlocks;
+        s.liveBlocks = (uint32_t)_live.size();
+        if (_flBits) {
+            // Biggest blocks are in the top non-empty class; that one list
+            // is the only thing walked
+            int fl = 31 - std::countl_zero(_flBits);
+            int sl = 31 - std::countl_zero(_slBits[fl]);
+            for (uint32_t b = _heads[fl][sl]; b != NONE; b = _blocks[b].nextFree)
+                if (_blocks[b].size > s.largestFree) s.largestFree = _blocks[b].size;
+        }
+        return s;
+    }
+
+private:
+    static constexpr int SL_LOG   = 4;
+    static constexpr int SL_COUNT = 1 << SL_LOG;
+    static constexpr int FL_COUNT = 32 - SL_LOG + 1;
+
+    struct Block {
+        uint32_t offset, size;
+        uint32_t prevPhys, nextPhys;  // address order
+        uint32_t prevFree, nextFree;  // this block's size class
+        bool     free;
+    };
+
+    std::vector<Block>    _blocks;
+    std::vector<uint32_t> _spare;     // recycled _blocks slots
+    std::unordered_map<uint32_t, uint32_t> _live; // offset → block
+
+    uint32_t _flBits = 0;
+    uint32_t _slBits[FL_COUNT] = {};
+    uint32_t _heads[FL_COUNT][SL_COUNT];
+
+    uint32_t _capacity = 0, _used = 0, _freeBlocks = 0;
+    uint32_t _lastPhys = NONE;
+
+    // Sizes below SL_COUNT get one exact class each; above, each power of
+    // two [2^l, 2^(l+1)) splits into SL_COUNT equal classes
+    static void mapping(uint32_t size, int& fl, int& sl) {
+        if (size < (uint32_t)SL_COUNT) { fl = 0; sl = (int)size; return; }
+        int l = 31 - std::countl_zero(size);
+        fl = l - SL_LOG + 1;
+        sl = (int)(size >> (l - SL_LOG)) - SL_COUNT;
+    }
+
+    uint32_t findFit(uint32_t count) const {
+        // Round up to the next class boundary: every block from there on fits
+        uint64_t up = count;
+        if (count >= (uint32_t)SL_COUNT) {
+            int l = 31 - std::countl_zero(count);
+            up += (1ull << (l - SL_LOG)) - 1;
+        }
+        if (up <= UINT32_MAX) {
+            int fl, sl;
+            mapping((uint32_t)up, fl, sl);
+            uint32_t slMap = _slBits[fl] & (~0u << sl);
+            if (!slMap) {
+                uint32_t flMap = fl + 1 < 32 ? _flBits & (~0u << (fl + 1)) : 0;
+                if (flMap) {
+                    fl    = std::countr_zero(flMap);
+                    slMap = _slBits[fl];
+                }
+            }
+            if (slMap) return _heads[fl][std::countr_zero(slMap)];
+        }
+
+        // Nothing a class up — the request's own class may still hold a
+        // block big enough (matters only when space is nearly gone)
+        int fl, sl;
+        mapping(count, fl, sl);
+        for (uint32_t b = _heads[fl][sl]; b != NONE; b = _blocks[b].nextFree)
+            if (_blocks[b].size >= count) return b;
+        return NONE;
+    }
+
+    uint32_t newBlock(const Block& b) {
+        if (!_spare.empty()) {
+            uint32_t i = _spare.back();
+            _spare.pop_back();
+            _blocks[i] = b;
+            return i;
+        }
+        _blocks.push_back(b);
+        return (uint32_t)_blocks.size() - 1;
+    }
+
+    void unlinkPhys(uint32_t b) {
+        Block& k = _blocks[b];
+        if (k.prevPhys != NONE) _blocks[k.prevPhys].nextPhys = k.nextPhys;
+        if (k.nextPhys != NONE) _blocks[k.nextPhys].prevPhys = k.prevPhys;
+        else                    _lastPhys = k.prevPhys;
+        _spare.push_back(b);
+    }
+
+    void insertFree(uint32_t b) {
+        int fl, sl;
+        mapping(_blocks[b].size, fl, sl);
+        uint32_t& head = _heads[fl][sl];
+        _blocks[b].prevFree = NONE;
+        _blocks[b].nextFree = head;
+        if (head != NONE) _blocks[head].prevFree = b;
+        head = b;
+        _slBits[fl] |= 1u << sl;
+        _flBits     |= 1u << fl;
+        _freeBlocks++;
+    }
+
+    void removeFree(uint32_t b) {
+        int fl, sl;
+        mapping(_blocks[b].size, fl, sl);
+        Block& k = _blocks[b];
+        if (k.prevFree != NONE) _blocks[k.prevFree].nextFree = k.nextFree;
+        else                    _heads[fl][sl] = k.nextFree;
+        if (k.nextFree != NONE) _blocks[k.nextFree].prevFree = k.prevFree;
+        if (_heads[fl][sl] == NONE) {
+            _slBits[fl] &= ~(1u << sl);
+            if (!_slBits[fl]) _flBits &= ~(1u << fl);
+        }
+        _freeBlocks--;
+    }
+};
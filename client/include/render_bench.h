@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// ── Render benchmark ──────────────────────────────────────────────────────────
+// `client --bench <capture>`: replays a render capture (render_capture.h,
+// made with --record-render) through MeshBuilder, vk_upload_chunk and
+// vk_draw into offscreen images, with no server, window or display pacing,
+// and writes JSON: CPU and GPU frame time percentiles, upload throughput
+// and the video memory peak.
+//
+// Deterministic up to the GPU: each frame's packets are meshed to the last
+// one before it's drawn, so every run uploads the same chunks from the same
+// frame on. CPU time is the frame without that wait — feeding, polling,
+// uploading and recording — as in the game, where meshing overlaps it.
+struct RenderBenchOptions {
+    std::string capture;
+    std::string out;              // JSON file; empty for stdout
+    uint32_t    width   = 1280;
+    uint32_t    height  = 720;
+    bool        gpuMesh = false;  // --gpu-mesh
+    int         shaderTier = 1;   // ShaderTier, --bench-shaders
+    uint32_t    lights  = 0;      // point lights round the eye, --bench-lights
+};
+
+// The process exit code
+int runRenderBench(const RenderBenchOptions& opt);
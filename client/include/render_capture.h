@@ -0,0 +1,166 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "log.h"
+
+// ── Render capture ────────────────────────────────────────────────────────────
+// What a session fed the renderer — the chunk stream as it came off the
+// network and where the camera was each frame — for `client --bench` to
+// replay without a server (render_bench.h).
+//
+// File layout: "AETHRND" + u8 version, then records back to back:
+//
+//   u8 kind | (Packet) varint len | bytes
+//           | (Pose)   f32 eye xyz | f32 yaw, pitch | f32 player xyz | u8 spawned
+//
+// Packets are whole chunk packets, ChunkDicts and ViewConfigs, first byte
+// the PacketID, in the order their handlers ran. A pose ends a frame: the
+// packets before it arrived while that frame was being made. Chunks the
+// disk cache answered (ChunkCached) can't be replayed, so recording keeps
+// the cache closed. Varints are LEB128, 64-bit.
+namespace RenderCapture {
+
+inline constexpr char    MAGIC[7] = {'A', 'E', 'T', 'H', 'R', 'N', 'D'};
+inline constexpr uint8_t VERSION  = 1;
+
+enum class Kind : uint8_t { Packet = 0, Pose = 1 };
+
+struct Pose {
+    glm::vec3 eye{0.f};
+    float     yaw = 0.f, pitch = 0.f;
+    glm::vec3 player{0.f}; // where residency is centred
+    bool      spawned = false;
+};
+
+struct Packet {
+    const uint8_t* data; // points into the Reader's buffer
+    size_t         len;
+};
+
+struct Frame {
+    std::vector<Packet> packets;
+    Pose                pose;
+};
+
+// Packets come from the network thread and poses from the main thread,
+// so every write is under one lock
+class Writer {
+public:
+    ~Writer() { close(); }
+
+    bool open(const char* path) {
+        _f = fopen(path, "wb");
+        if (!_f) {
+            Log::err(std::string("Render capture: cannot open ") + path);
+            return false;
+        }
+        setvbuf(_f, nullptr, _IOFBF, 1 << 20);
+        fwrite(MAGIC, 1, sizeof MAGIC, _f);
+        fputc(VERSION, _f);
+        Log::info(std::string("Recording the chunk stream and camera to ") + path);
+        return true;
+    }
+    bool on() const { return _f != nullptr; }
+
+    void close() {
+        std::lock_guard lk(_mu);
+        if (!_f) return;
+        fclose(_f);
+        _f = nullptr;
+    }
+
+    void packet(const uint8_t* d, size_t len) {
+        std::lock_guard lk(_mu);
+        if (!_f) return;
+        fputc((int)Kind::Packet, _f);
+        uint8_t buf[10];
+        int n = 0;
+        uint64_t v = len;
+        for (; v >= 0x80; v >>= 7) buf[n++] = (uint8_t)(v & 0x7F) | 0x80;
+        buf[n++] = (uint8_t)v;
+        fwrite(buf, 1, (size_t)n, _f);
+        fwrite(d, 1, len, _f);
+    }
+
+    void pose(const Pose& p) {
+        std::lock_guard lk(_mu);
+        if (!_f) return;
+        float v[8] = {p.eye.x, p.eye.y, p.eye.z, p.yaw, p.pitch, p.player.x, p.player.y, p.player.z};
+        fputc((int)Kind::Pose, _f);
+        fwrite(v, sizeof(float), 8, _f);
+        fputc(p.spawned ? 1 : 0, _f);
+    }
+
+private:
+    std::mutex _mu;
+    FILE*      _f = nullptr;
+};
+
+// Loads the whole capture and splits it into frames up front, so the
+// replay isn't disk-bound. Packets after the last pose are dropped.
+class Reader {
+public:
+    bool open(const char* path) {
+        FILE* f = fopen(path, "rb");
+        if (!f) {
+            Log::err(std::string("Render capture: cannot open ") + path);
+            return false;
+        }
+        char buf[1 << 16];
+        for (size_t n; (n = fread(buf, 1, sizeof buf, f)) > 0;) _buf.insert(_buf.end(), buf, buf + n);
+        fclose(f);
+        if (_buf.size() < sizeof MAGIC + 1 || std::memcmp(_buf.data(), MAGIC, sizeof MAGIC) != 0 ||
+            _buf[sizeof MAGIC] != VERSION) {
+            Log::err(std::string("Render capture: ") + path + " is not a version " +
+                     std::to_string(VERSION) + " capture");
+            return false;
+        }
+        size_t o = sizeof MAGIC + 1;
+        Frame  cur;
+        while (o < _buf.size()) {
+            uint8_t k = _buf[o++];
+            if (k == (uint8_t)Kind::Packet) {
+                uint64_t len;
+                if (!varint(o, len) || len == 0 || len > _buf.size() - o) break;
+                cur.packets.push_back({_buf.data() + o, (size_t)len});
+                o += (size_t)len;
+            } else if (k == (uint8_t)Kind::Pose) {
+                if (_buf.size() - o < 8 * sizeof(float) + 1) break;
+                float v[8];
+                std::memcpy(v, _buf.data() + o, sizeof v);
+                o += sizeof v;
+                cur.pose = {{v[0], v[1], v[2]}, v[3], v[4], {v[5], v[6], v[7]}, _buf[o++] != 0};
+                _frames.push_back(std::move(cur));
+                cur = {};
+            } else {
+                break;
+            }
+        }
+        if (o < _buf.size()) Log::warn("Render capture: partial or corrupt record; stopping there");
+        return true;
+    }
+
+    const std::vector<Frame>& frames() const { return _frames; }
+    size_t bytes() const { return _buf.size(); }
+
+private:
+    bool varint(size_t& o, uint64_t& v) const {
+        v = 0;
+        for (int shift = 0; shift < 64 && o < _buf.size(); shift += 7) {
+            uint8_t c = _buf[o++];
+            v |= (uint64_t)(c & 0x7F) << shift;
+            if (!(c & 0x80)) return true;
+        }
+        return false;
+    }
+
+    std::vector<uint8_t> _buf;
+    std::vector<Frame>   _frames;
+};
+
+} // namespace RenderCapture
@@ -0,0 +1,140 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "thread_pool.h"
+#include "tick_arena.h"
+
+// ── RenderGraph ───────────────────────────────────────────────────────────────
+// A frame's GPU work as passes that say what they read and write, rebuilt
+// each frame. compile() keeps the roots (what's presented, read back, or
+// left for later frames) and every pass writing something a kept pass reads;
+// the rest aren't recorded at all. record() puts one barrier before each
+// kept pass for what it touches: writes made visible to a later read or
+// write, reads waited out before a write, and image layout transitions.
+// What happens inside a pass, including a render pass' own dependencies,
+// stays the pass' business.
+//
+// Parallel passes are recorded into secondary command buffers, one per
+// record, across the pool — every one before the primary is put together.
+// Inline passes are recorded into the primary, in order, after them all: so
+// only parallel passes run alongside each other, and a record may read CPU
+// state an inline pass changes without seeing the change.
+//
+// Resources are whatever the passes agree on: a memory resource (buffers,
+// or images a render pass transitions itself) is synchronised with global
+// barriers, an image resource also has its layout tracked.
+class RenderGraph {
+public:
+    using Resource = uint32_t;
+    using Record   = std::function<void(VkCommandBuffer)>;
+
+    // Where a resource was left before the graph: writes still to make
+    // visible in access, or (no access) reads at stage still to wait out.
+    // Zero: nothing pending, layout UNDEFINED.
+    struct State {
+        VkPipelineStageFlags stage;
+        VkAccessFlags        access;
+        VkImageLayout        layout;
+    };
+
+    struct Use {
+        Resource             res;
+        VkPipelineStageFlags stage;
+        VkAccessFlags        access;
+        // Images: the layout the pass needs (UNDEFINED: none, the contents
+        // are discarded or a render pass transitions it), and leaves it in
+        // (UNDEFINED: the one it needs)
+        VkImageLayout        layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout        after  = VK_IMAGE_LAYOUT_UNDEFINED;
+    };
+
+    // Its lists live in the frame's arena (reset)
+    struct Pass {
+        explicit Pass(TickArena* arena)
+            : reads(ArenaAllocator<Use>(arena)), writes(ArenaAllocator<Use>(arena)),
+              clears(ArenaAllocator<VkClearValue>(arena)), records(ArenaAllocator<Record>(arena)) {}
+
+        const char*      name = "";
+        // A resource the pass reads and writes goes in writes, with the
+        // read bits in its access (a render pass loading an attachment)
+        ArenaVector<Use> reads, writes;
+        bool             root     = false;
+        bool             parallel = false;
+        // With a render pass (begin.renderPass set) the records are its
+        // contents, in order; without, there's exactly one
+        VkRenderPassBeginInfo     begin{};
+        ArenaVector<VkClearValue> clears;
+        ArenaVector<Record>       records;
+
+        Pass& read(Use u)  { reads.push_back(u); return *this; }
+        Pass& write(Use u) { writes.push_back(u); return *this; }
+        Pass& record(Record r) { records.push_back(std::move(r)); return *this; }
+    };
+
+    // pool: where parallel passes are recorded, as well as the calling
+    // thread; none records everything inline
+    void init(VkDevice dev, uint32_t queueFamily, uint32_t frames, ThreadPool* pool);
+    void destroy();
+
+    // Starts the frame's graph; frame's command buffers must be done with.
+    // The passes are built in arena, which must last until the next reset.
+    void reset(uint32_t frame, TickArena& arena);
+    Resource memory(const char* name, State prior = {});
+    Resource image(const char* name, VkImage image, VkImageAspectFlags aspect, State prior = {});
+    // Stays valid until the next reset
+    Pass&    add(const char* name);
+    // The one reset was given, for whatever the frame builds to go in passes
+    TickArena& arena() { return *_arena; }
+
+    void compile();
+    void record(VkCommandBuffer primary);
+
+    // That record parallel passes, this one included: what's worth
+    // splitting work into records for
+    uint32_t threads() const { return _pool ? (uint32_t)_pool->maxThreads() + 1 : 1; }
+
+    // Of the last compile
+    uint32_t passesKept() const   { return _kept; }
+    uint32_t passesCulled() const { return (uint32_t)_passes.size() - _kept; }
+
+private:
+    struct Res {
+        const char*        name;
+        VkImage            image;
+        VkImageAspectFlags aspect;
+        // Since the last write: its stage and access, the stages that have
+        // read it, and the stages and access it has been made visible to
+        VkPipelineStageFlags writeStage, readStages, visibleStages;
+        VkAccessFlags        writeAccess, visibleAccess;
+        VkImageLayout        layout;
+    };
+    // A parallel pass' record
+    struct Job {
+        size_t pass, record;
+    };
+
+    VkCommandBuffer secondary(size_t job);
+    void            run(const Job& job, VkCommandBuffer cmd);
+    void            barriers(VkCommandBuffer cmd, const Pass& p);
+
+    VkDevice    _dev    = VK_NULL_HANDLE;
+    uint32_t    _family = 0;
+    ThreadPool* _pool   = nullptr;
+    uint32_t    _frame  = 0;
+    TickArena*  _arena  = nullptr;
+    // Per frame, a command pool per job so each records on its own
+    std::vector<std::vector<VkCommandPool>>   _cmdPools;
+    std::vector<std::vector<VkCommandBuffer>> _cmds;
+
+    std::vector<Res>  _res;
+    std::deque<Pass, ArenaAllocator<Pass>> _passes;
+    std::vector<bool> _alive;
+    std::vector<bool> _needed; // compile's, per resource
+    uint32_t          _kept = 0;
+    std::vector<Job>  _jobs;
+    std::vector<std::vector<VkCommandBuffer>> _recorded; // per pass, per record
+    std::vector<VkImageMemoryBarrier>         _imageBarriers;
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <glm/vec3.hpp>
+#include "input.h"
+#include "triple_buffer.h"
+
+// ── SimThread ─────────────────────────────────────────────────────────────────
+// Runs the client's simulation — the player's movement, combat, stats, the
+// day — in fixed ticks of 1 / CLIENT_SIM_HZ on a thread of its own, so it
+// costs the same at any frame rate and keeps time while the render thread
+// waits on the GPU. Ticks fall due on a fixed schedule; one that runs late
+// is caught up, and more than SIM_MAX_STEPS behind the schedule restarts.
+//
+// The render thread feed()s it each frame: the keys as they're held, every
+// key that went down since the last tick (so a tap between two ticks still
+// counts once), and the camera's angles, which turn at frame rate. Each
+// tick leaves a State for the renderer in a triple buffer, stamped with the
+// time it's due; view() draws one tick behind, between the last two.
+//
+// Whatever a tick touches that the render thread also does — packet
+// handlers, colliders, the UI — is guarded by world(), which each tick holds
+// throughout and the render thread takes around its own part.
+class SimThread {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // What a tick is fed
+    struct Controls {
+        InputState input;
+        float      yaw = 0.f, pitch = 0.f;
+        bool       uiOpen = false; // keys go to the UI, not into combat
+    };
+    // What a tick leaves for the renderer
+    struct State {
+        Clock::time_point t{};
+        glm::vec3         eye{0.f};
+    };
+    using Tick = std::function<void(float dt, const Controls& in, State& out)>;
+
+    SimThread() = default;
+    ~SimThread() { stop(); }
+
+    SimThread(const SimThread&)            = delete;
+    SimThread& operator=(const SimThread&) = delete;
+
+    void start(Tick tick);
+    void stop();
+
+    // ── Render thread ─────────────────────────────────────────────────────
+    void feed(const InputState& input, float yaw, float pitch, bool uiOpen);
+    std::unique_lock<std::mutex> world() { return std::unique_lock(_world); }
+    // The state one tick before now, between the two ticks around it; false
+    // until this run's first tick
+    bool view(Clock::time_point now, State& out);
+    // Spent in ticks since the last call
+    float takeTickMs();
+
+private:
+    // Two ticks in a row, so the pair view() blends is never torn apart
+    struct Published {
+        State prev, cur;
+    };
+
+    void run();
+
+    Tick              _tick;
+    std::thread       _thread;
+    std::atomic<bool> _running{false};
+    std::mutex        _world;
+    Clock::time_point _started{};
+
+    std::mutex _feedMu; // _controls, _tickMs
+    Controls   _controls;
+    float      _tickMs = 0.f;
+
+    TripleBuffer<Published> _published;
+};
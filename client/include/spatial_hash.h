@@ -0,0 +1,83 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <entt/entt.hpp>
+#include <glm/vec3.hpp>
+
+// ── SpatialHash ───────────────────────────────────────────────────────────────
+// Broadphase for combat: entity boxes bucketed by the CELL-metre cell their
+// centre falls in, stored as one array sorted by cell key. Rebuilt from
+// scratch each update (clear, insert, build), so there's nothing to keep in
+// sync when entities move or die. Each entity sits in exactly one cell, and
+// queries widen their cell range by the largest half-extent inserted, so
+// every overlapping box is reported exactly once.
+class SpatialHash {
+public:
+    static constexpr float CELL = 4.f;
+
+    struct Entry {
+        uint64_t     key;
+        entt::entity e;
+        glm::vec3    mn, mx;
+    };
+
+    void clear() {
+        _entries.clear();
+        _maxHalf = glm::vec3(0.f);
+    }
+
+    void insert(entt::entity e, glm::vec3 pos, glm::vec3 half) {
+        _entries.push_back({keyOf(cellOf(pos.x), cellOf(pos.y), cellOf(pos.z)), e,
+                            pos - half, pos + half});
+        _maxHalf = glm::max(_maxHalf, half);
+    }
+
+    // Call after the inserts, before any query
+    void build() {
+        std::sort(_entries.begin(), _entries.end(),
+                  [](const Entry& a, const Entry& b) { return a.key < b.key; });
+    }
+
+    // f(const Entry&) for every box overlapping [mn, mx]
+    template<class F>
+    void query(glm::vec3 mn, glm::vec3 mx, F&& f) const {
+        if (_entries.empty()) return;
+        glm::vec3 lo = mn - _maxHalf, hi = mx + _maxHalf;
+        int x0 = cellOf(lo.x), y0 = cellOf(lo.y), z0 = cellOf(lo.z);
+        int x1 = cellOf(hi.x), y1 = cellOf(hi.y), z1 = cellOf(hi.z);
+        for (int x = x0; x <= x1; x++)
+        for (int y = y0; y <= y1; y++)
+        for (int z = z0; z <= z1; z++) {
+            uint64_t k = keyOf(x, y, z);
+            auto it = std::lower_bound(_entries.begin(), _entries.end(), k,
+                                       [](const Entry& en, uint64_t key) { return en.key < key; });
+            for (; it != _entries.end() && it->key == k; ++it)
+                if (it->mn.x <= mx.x && it->mx.x >= mn.x &&
+                    it->mn.y <= mx.y && it->mx.y >= mn.y &&
+                    it->mn.z <= mx.z && it->mx.z >= mn.z)
+                    f(*it);
+        }
+    }
+
+    // Boxes overlapping the cube of half-size radius around p; the caller
+    // does its own distance test
+    template<class F>
+    void queryRadius(glm::vec3 p, float radius, F&& f) const {
+        query(p - glm::vec3(radius), p + glm::vec3(radius), f);
+    }
+
+    size_t size() const { return _entries.size(); }
+
+private:
+    static int cellOf(float v) { return (int)std::floor(v / CELL); }
+    // 21 bits per axis, two's complement wrapped — ±4M cells is plenty
+    static uint64_t keyOf(int x, int y, int z) {
+        constexpr uint64_t M = (1u << 21) - 1;
+        return ((uint64_t)x & M) | ((uint64_t)y & M) << 21 | ((uint64_t)z & M) << 42;
+    }
+
+    std::vector<Entry> _entries;
+    glm::vec3          _maxHalf{0.f};
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunk.h"
+#include "packets.h"
+
+// ── TerrainVertex ─────────────────────────────────────────────────────────────
+// What the mega vertex buffer holds — 8 bytes, decoded in terrain.vert.
+//   pos   chunk-local [0, SIZE], x:11 | y:11 | z:10 bits; both ends exact, so
+//         vertices on a shared chunk face land on the same point
+//   norm  octahedral, same encoding as the ChunkData wire format
+//   mat   BlockMat, 8 bits; UVs are rebuilt from pos/normal/mat in the shader
+//   ao    Vertex::occlusion, the top 8 bits; 0 (open) where nothing baked it
+// Vertex stays the wire and meshing format; the MeshBuilder worker packs,
+// and the collider keeps the packed positions, so what the player stands on
+// is what's drawn.
+struct TerrainVertex {
+    uint32_t pos;
+    uint32_t normMat; // nu << 8 | nv, mat << 16, ao << 24
+
+    static constexpr uint32_t X_MAX = (1u << 11) - 1;
+    static constexpr uint32_t Y_MAX = (1u << 11) - 1;
+    static constexpr uint32_t Z_MAX = (1u << 10) - 1;
+
+    // Largest position error, in blocks — slack for bounds taken before packing
+    static constexpr float POS_ERROR = 0.5f * (float)ChunkData::SIZE / (float)Z_MAX;
+
+    static TerrainVertex pack(const Vertex& v) {
+        auto q = [](float p, uint32_t max) {
+            float f = p / (float)ChunkData::SIZE * (float)max + 0.5f;
+            return (uint32_t)(f < 0.f ? 0.f : f > (float)max ? (float)max : f);
+        };
+        TerrainVertex t;
+        t.pos = q(v.pos.x, X_MAX) | q(v.pos.y, Y_MAX) << 11 | q(v.pos.z, Z_MAX) << 22;
+        t.normMat = ChunkDataPacket::octEncode(v.normal) | (v.material & 0xFFu) << 16 |
+                    (uint32_t)v.occlusion << 24;
+        return t;
+    }
+
+    // Chunk-local position, as terrain.vert decodes it
+    static glm::vec3 unpackPos(uint32_t pos) {
+        const float s = (float)ChunkData::SIZE;
+        return {(float)(pos & X_MAX) * (s / (float)X_MAX),
+                (float)(pos >> 11 & Y_MAX) * (s / (float)Y_MAX),
+                (float)(pos >> 22) * (s / (float)Z_MAX)};
+    }
+};
+static_assert(sizeof(TerrainVertex) == 8);
+
+// ── ChunkUpload ───────────────────────────────────────────────────────────────
+// A decoded chunk as flushUploads stages it, packed on the MeshBuilder worker
+// from the mesh it marched or decoded there: vertices already TerrainVertex,
+// bounds already taken. The ChunkMesh never leaves the worker.
+struct ChunkUpload {
+    ChunkCoord                 coord{0, 0, 0};
+    uint8_t                    lod       = 0;
+    uint16_t                   faceLinks = FACE_LINKS_ALL;
+    std::vector<TerrainVertex> vertices;
+    std::vector<uint32_t>      indices;
+    std::vector<Meshlet>       meshlets;
+    glm::vec3                  boundsMin{0.f}, boundsMax{0.f}; // chunk-local, POS_ERROR slack included
+
+    // Reuses this one's capacity
+    void pack(const ChunkMesh& mesh) {
+        coord     = mesh.coord;
+        lod       = mesh.lod;
+        faceLinks = mesh.faceLinks;
+        indices.assign(mesh.indices.begin(), mesh.indices.end());
+        meshlets.assign(mesh.meshlets.begin(), mesh.meshlets.end());
+        vertices.resize(mesh.vertices.size());
+        if (mesh.vertices.empty()) {
+            boundsMin = boundsMax = glm::vec3(0.f);
+            return;
+        }
+        // Tight bounds for the cull: a cave chunk is mostly empty space
+        boundsMin = boundsMax = mesh.vertices[0].pos;
+        for (size_t i = 0; i < mesh.vertices.size(); i++) {
+            const Vertex& v = mesh.vertices[i];
+            vertices[i] = TerrainVertex::pack(v);
+            boundsMin   = glm::min(boundsMin, v.pos);
+            boundsMax   = glm::max(boundsMax, v.pos);
+        }
+        boundsMin -= glm::vec3(TerrainVertex::POS_ERROR);
+        boundsMax += glm::vec3(TerrainVertex::POS_ERROR);
+    }
+
+    // Keeps the capacity, for the next decode
+    void clear() {
+        vertices.clear();
+        indices.clear();
+        meshlets.clear();
+        lod       = 0;
+        faceLinks = FACE_LINKS_ALL;
+    }
+};
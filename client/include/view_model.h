@@ -2,8 +2,10 @@
 #include <vulkan/vulkan.h>
 #include <vk_mem_alloc.h>
 #include <glm/glm.hpp>
+#include <string>
 #include <vector>
 #include "gltf_loader.h"
+#include "staged_uploads.h"
 #include "view_model_anim.h"
 
 // GPU buffers for one loaded GLB mesh
@@ -15,6 +17,14 @@ struct ViewModelMesh {
     uint32_t      indexCount = 0;
 };
 
+// A mesh as ViewModelRenderer::readMesh leaves it for addMesh: every
+// primitive merged, with the midpoint of its bounds
+struct ViewModelMeshData {
+    std::vector<GltfVertex> verts;
+    std::vector<uint32_t>   inds;
+    glm::vec3               center{0.f};
+};
+
 // Position/rotation/scale of the weapon in view space.
 // Tweak per weapon to sit correctly in the player's hand.
 struct ViewModelTransform {
@@ -30,7 +40,7 @@ struct ViewModelRenderer {
     VkPipeline            pipeline       = VK_NULL_HANDLE;
     VkPipelineLayout      pipelineLayout = VK_NULL_HANDLE;
 
-    // Loaded meshes — index returned by loadMesh()
+    // Loaded meshes — index returned by addMesh()
     std::vector<ViewModelMesh> meshes;
 
     // Which mesh is currently equipped (-1 = nothing / fists)
@@ -62,17 +72,22 @@ struct ViewModelRenderer {
     void triggerHeavyAttack() { anim.play(AnimSlot::HeavyAttack); }
 
     // ── Lifecycle ─────────────────────────────────────────────────────────
+    // Builds only the pipeline; safe on a worker alongside addMesh
     void init(VkDevice device, VmaAllocator allocator,
               VkRenderPass renderPass, VkExtent2D extent,
-              const char* vertSpv, const char* fragSpv);
+              const char* vertSpv, const char* fragSpv,
+              VkPipelineCache cache = VK_NULL_HANDLE);
 
     void destroy(VkDevice device, VmaAllocator allocator);
 
-    // Upload a GLB to GPU. Returns mesh index or -1 on failure.
-    int loadMesh(VkDevice device, VmaAllocator allocator,
-                 VkCommandPool pool, VkQueue queue,
-                 const GltfModel& model,
-                 ViewModelTransform transform = {});
+    // Any thread: read a GLB, or its asset_bake blob if fresh, and merge
+    // its meshes. False if there's nothing to draw.
+    static bool readMesh(const std::string& glbPath, ViewModelMeshData& out);
+
+    // Main thread. The buffers go into up, so the mesh mustn't be drawn
+    // until its submission has finished. Returns mesh index or -1 on failure.
+    int addMesh(StagedUploads& up, const ViewModelMeshData& data,
+                ViewModelTransform transform = {});
 
     // Record draw commands. Call after terrain draw, still inside render pass.
     // proj: same projection matrix used for the scene.
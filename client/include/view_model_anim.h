@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <cmath>
 #include <imgui.h>
+#include "anim_clip.h"
 
 // ── Easing functions ──────────────────────────────────────────────────────────
 
@@ -71,7 +72,8 @@ struct AnimClip {
         return d;
     }
 
-    // Sample the clip at time t, returning offset/rotation/scale deltas
+    // Sample the clip at time t, returning offset/rotation/scale deltas.
+    // A search per call: for compiling, playback goes through compileClip.
     void sample(float t, glm::vec3& outOffset, glm::vec3& outRot, glm::vec3& outScale) const {
         if (keyframes.empty()) {
             outOffset = {0,0,0}; outRot = {0,0,0}; outScale = {1,1,1};
@@ -109,6 +111,19 @@ struct AnimClip {
     }
 };
 
+// One track, Euler rotations: offset | rotation | scale, as sample() gives.
+// Keys needn't fall on a row, so a sharp one (EaseOutBack) is cut by up to
+// a row; at 240 Hz that's under a degree, and nine channels cost nothing.
+inline CompiledClip compileClip(const AnimClip& clip, float rate = 240.f) {
+    return CompiledClip::compile({1, 3}, clip.computeDuration(), clip.loop, [&](float t, float* row) {
+        glm::vec3 o, r, s;
+        clip.sample(t, o, r, s);
+        row[0] = o.x; row[1] = o.y; row[2] = o.z;
+        row[3] = r.x; row[4] = r.y; row[5] = r.z;
+        row[6] = s.x; row[7] = s.y; row[8] = s.z;
+    }, {rate});
+}
+
 // ── Built-in default animations ───────────────────────────────────────────────
 
 inline AnimClip makeDefaultLightAttack() {
@@ -202,7 +217,9 @@ enum class AnimSlot : uint8_t {
 static constexpr const char* ANIM_SLOT_NAMES[] = { "Idle", "LightAttack", "HeavyAttack" };
 
 struct AnimationPlayer {
-    std::array<AnimClip, (int)AnimSlot::COUNT> clips;
+    // As authored (and edited); what plays is compiled from them
+    std::array<AnimClip, (int)AnimSlot::COUNT>     clips;
+    std::array<CompiledClip, (int)AnimSlot::COUNT> compiled;
 
     // Playback state
     AnimSlot  activeSlot  = AnimSlot::Idle;
@@ -218,8 +235,12 @@ struct AnimationPlayer {
         clips[(int)AnimSlot::Idle]        = makeDefaultIdle();
         clips[(int)AnimSlot::LightAttack] = makeDefaultLightAttack();
         clips[(int)AnimSlot::HeavyAttack] = makeDefaultHeavyAttack();
+        for (int i = 0; i < (int)AnimSlot::COUNT; i++) compile(i);
     }
 
+    // After clips[slot] changes
+    void compile(int slot) { compiled[slot] = compileClip(clips[slot]); }
+
     void play(AnimSlot slot) {
         if (slot == activeSlot && playing) return;
         activeSlot = slot;
@@ -232,12 +253,12 @@ struct AnimationPlayer {
     void update(float dt) {
         if (!playing) return;
 
-        const AnimClip& clip = clips[(int)activeSlot];
-        float dur = clip.computeDuration();
+        const CompiledClip& clip = compiled[(int)activeSlot];
+        float dur = clip.duration();
 
         playTime += dt;
 
-        if (!clip.loop && playTime >= dur && activeSlot != AnimSlot::Idle) {
+        if (!clip.loop() && playTime >= dur && activeSlot != AnimSlot::Idle) {
             // Finished non-idle clip — blend back to idle
             activeSlot  = AnimSlot::Idle;
             playTime    = 0.f;
@@ -252,20 +273,19 @@ struct AnimationPlayer {
 
     // Returns combined transform deltas
     void getCurrentDelta(glm::vec3& outOffset, glm::vec3& outRot, glm::vec3& outScale) const {
-        glm::vec3 idleOff, idleRot, idleScl;
-        clips[(int)AnimSlot::Idle].sample(playTime, idleOff, idleRot, idleScl);
-
-        if (blendWeight < 0.001f || activeSlot == AnimSlot::Idle) {
-            outOffset = idleOff; outRot = idleRot; outScale = idleScl;
-            return;
-        }
-
-        glm::vec3 activeOff, activeRot, activeScl;
-        clips[(int)activeSlot].sample(playTime, activeOff, activeRot, activeScl);
-
-        outOffset = glm::mix(idleOff,  activeOff,  blendWeight);
-        outRot    = glm::mix(idleRot,  activeRot,  blendWeight);
-        outScale  = glm::mix(idleScl,  activeScl,  blendWeight);
+        // Idle and the active clip in one batch
+        ClipQuery q[2] = {{&compiled[(int)AnimSlot::Idle], playTime},
+                          {&compiled[(int)activeSlot], playTime}};
+        float pose[2][9] = {};
+        bool  blend = blendWeight >= 0.001f && activeSlot != AnimSlot::Idle;
+        sampleClips(q, blend ? 2 : 1, pose[0], 9);
+
+        const float w = blend ? blendWeight : 0.f;
+        float mixed[9];
+        for (int c = 0; c < 9; c++) mixed[c] = pose[0][c] + (pose[1][c] - pose[0][c]) * w;
+        outOffset = {mixed[0], mixed[1], mixed[2]};
+        outRot    = {mixed[3], mixed[4], mixed[5]};
+        outScale  = {mixed[6], mixed[7], mixed[8]};
     }
 };
 
@@ -327,13 +347,13 @@ struct ViewModelAnimEditor {
             if (previewTime > dur) previewTime = clip.loop ? 0.f : dur;
         }
 
-        // Preview sample display
-        glm::vec3 pOff, pRot, pScl;
-        clip.sample(previewTime, pOff, pRot, pScl);
+        // Preview sample display, as it plays
+        float p[9];
+        player.compiled[selectedSlot].sample(previewTime, p);
         ImGui::TextDisabled("  Sample → Offset(%.3f %.3f %.3f)  Rot(%.1f %.1f %.1f)  Scale(%.3f %.3f %.3f)",
-            pOff.x, pOff.y, pOff.z,
-            pRot.x, pRot.y, pRot.z,
-            pScl.x, pScl.y, pScl.z);
+            p[0], p[1], p[2],
+            p[3], p[4], p[5],
+            p[6], p[7], p[8]);
 
         ImGui::Separator();
 
@@ -452,5 +472,8 @@ struct ViewModelAnimEditor {
         ImGui::TextDisabled("Press ] to show/hide this editor and the transform panel.");
 
         ImGui::End();
+
+        // Whatever was edited above plays from the next frame
+        player.compile(selectedSlot);
     }
 };
@@ -4,10 +4,27 @@
 #include <vk_mem_alloc.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
+#include <chrono>
 #include <vector>
-#include <unordered_map>
 #include <deque>
+#include <functional>
+#include <memory>
+#include "bindless.h"
 #include "chunk.h"
+#include "chunk_visibility.h"
+#include "config.h"
+#include "dynamic_resolution.h"
+#include "far_terrain.h"
+#include "flat_map.h"
+#include "frame_arena.h"
+#include "frame_profiler.h"
+#include "lights.h"
+#include "memory_budget.h"
+#include "particles.h"
+#include "range_allocator.h"
+#include "render_graph.h"
+#include "staged_uploads.h"
+#include "terrain_vertex.h"
 
 struct ViewModelRenderer;
 class RemotePlayerRenderer;
@@ -17,15 +34,71 @@ struct GpuChunk {
     uint32_t indexOffset;
     uint32_t indexCount;
     uint32_t vertexCount;
+    glm::vec3 boundsMin{0.f}; // mesh AABB, chunk-local
+    glm::vec3 boundsMax{0.f};
+    uint32_t slot = UINT32_MAX; // chunk table entry, while resident
+    uint32_t meshletOffset = 0; // in meshletBuffer
+    uint32_t meshletCount  = 0;
 };
 
+// Holds the packed chunk itself (moved in, not copied); flushUploads
+// memcpys it into staging and parks the emptied upload in spentMeshes
 struct PendingUpload {
-    ChunkCoord            coord;
-    std::vector<Vertex>   vertices;
-    std::vector<uint32_t> indices;
+    ChunkUpload mesh;
+    int64_t     queuedUs = 0; // while tracing
 };
 
-static constexpr uint32_t MEGA_VERTEX_CAP = 1 << 21;
+// One chunk-upload submission. Its staging range stays reserved, and its
+// chunks stay out of the draw list, until the GPU has finished the copy.
+struct UploadBatch {
+    struct Chunk {
+        ChunkKey   key;
+        GpuChunk   gpu;
+        bool       dropped = false; // removed while in flight — free on retire
+        bool       moved   = false; // compaction: keeps the resident meshlets
+        int64_t    stagedUs = 0;    // while tracing
+    };
+
+    VkCommandBuffer    cmd   = VK_NULL_HANDLE;
+    VkFence            fence = VK_NULL_HANDLE; // completion, when there's no timeline semaphore
+    uint64_t           value = 0;              // timeline value signalled on completion
+    VkDeviceSize       stagingEnd  = 0;        // ring tail once this batch retires
+    VkDeviceSize       stagingUsed = 0;
+    std::vector<Chunk> chunks;
+};
+
+// One chunk marched on the GPU (--gpu-mesh), over two frame command
+// buffers: Counting records classify and scan and reads back the triangle
+// count and bounds; once that frame has finished, Emitting gets the mega
+// ranges, records emit — drawable from that frame on — and reads the
+// vertices back for the collider. The buffers are the job's own, so a job
+// is only reused once its last frame has signalled.
+struct GpuMeshJob {
+    enum class Stage : uint8_t { Free, Queued, Counting, Emitting };
+
+    Stage    stage   = Stage::Free;
+    ChunkKey key;
+    uint64_t frame   = 0;     // framesSubmitted of the frame the stage was recorded in
+    bool     dropped = false; // removed, or superseded by a newer field
+    GpuChunk gpu{};
+
+    VkBuffer      fieldBuffer    = VK_NULL_HANDLE; // ChunkData::voxels, host-written
+    VmaAllocation fieldAlloc     = nullptr;
+    void*         fieldMapped    = nullptr;
+    VkBuffer      cellBuffer     = VK_NULL_HANDLE; // per-cell counts, then offsets; header
+    VmaAllocation cellAlloc      = nullptr;
+    VkBuffer      headerBuffer   = VK_NULL_HANDLE; // header readback
+    VmaAllocation headerAlloc    = nullptr;
+    void*         headerMapped   = nullptr;
+    VkBuffer      readbackBuffer = VK_NULL_HANDLE; // emitted vertices, sized per chunk
+    VmaAllocation readbackAlloc  = nullptr;
+    void*         readbackMapped = nullptr;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+};
+
+// Vertices are 8-byte TerrainVertex, so twice the old count still takes
+// under half the memory
+static constexpr uint32_t MEGA_VERTEX_CAP = 1 << 22;
 static constexpr uint32_t MEGA_INDEX_CAP  = 1 << 21;
 
 struct MegaBuffer {
@@ -34,9 +107,9 @@ struct MegaBuffer {
     VmaAllocation vertexAlloc  = nullptr;
     VmaAllocation indexAlloc   = nullptr;
 
-    struct Range { uint32_t offset, size; };
-    std::vector<Range> vertRanges;
-    std::vector<Range> indRanges;
+    // In vertices / indices
+    RangeAllocator verts{MEGA_VERTEX_CAP};
+    RangeAllocator inds {MEGA_INDEX_CAP};
 
     uint32_t allocVerts  (uint32_t count);
     uint32_t allocInds   (uint32_t count);
@@ -52,11 +125,68 @@ struct DrawCmd {
     uint32_t firstInstance;
 };
 
-struct ChunkDrawData {
-    glm::mat4 model;
-    glm::vec4 params;
+// One resident chunk, as cull.comp and terrain.vert read it (std430).
+// Written once per upload through the frame command buffer, so frames
+// already submitted keep the old contents; indexCount 0 marks a free slot.
+// A draw's firstInstance is its slot, which is all the vertex shader needs.
+struct ChunkSlot {
+    glm::vec4  boundsMin;  // world space
+    glm::vec4  boundsMax;
+    glm::ivec4 origin;     // world-space chunk corner, w LOD level
+    uint32_t   indexCount;
+    uint32_t   firstIndex;
+    int32_t    vertexOffset;
+    uint32_t   meshletFirst;
+    uint32_t   meshletCount;
+    uint32_t   pad[3];
+};
+
+// One meshlet (see buildMeshlets) as cull.comp reads it (std430). In the
+// chunk's own frame and units, so it moves with the chunk's ranges.
+struct GpuMeshlet {
+    glm::vec4 boundsMin;  // w: cone cutoff, above 1 for no cone
+    glm::vec4 boundsMax;
+    glm::vec4 coneAxis;
+    uint32_t  firstIndex; // from the chunk's first index
+    uint32_t  indexCount;
+    uint32_t  pad[2];
+};
+
+// cull.comp uniforms (std140)
+struct CullParams {
+    glm::mat4  hizViewProj;   // the view the pyramid was rendered from
+    glm::vec4  planes[6];
+    glm::vec4  hiz;           // level-0 width, height, levels, 1 if usable
+    glm::uvec4 counts;        // slots to test, draw capacity
+    glm::vec4  eye;           // camera position, distance bands per sqrt(block)
+    glm::vec4  hizRect;       // xy: share of the pyramid the view covered
 };
 
+// One sun shadow cascade. viewProj is what its static map was last drawn
+// with; dynamic casters and the terrain's lookups use the same.
+struct ShadowCascade {
+    glm::mat4 viewProj{1.f};
+    glm::vec3 center{0.f};   // snapped to a quarter of the extent
+    glm::vec3 sun{0.f, 1.f, 0.f};
+    bool      dirty     = true;
+    uint64_t  lastFrame = 0; // framesSubmitted at the last redraw
+};
+
+// terrain.frag set 1, binding 0 (std140), one per frame in flight
+struct ShadowParams {
+    glm::mat4 viewProj[Config::SHADOW_CASCADES];
+    glm::vec4 sun;   // towards the sun
+    glm::vec4 texel; // world size of a static texel per cascade
+};
+static_assert(Config::SHADOW_CASCADES <= 4, "texel holds one per cascade");
+
+// terrain.frag's quality, as specialization constants (terrainSpec in
+// vk_init.cpp). Low is the branch-free variant for fill-rate-bound GPUs:
+// one projection, one layer, one shadow compare, no fog. Medium adds fog
+// and four-tap shadows; High blends three projections, cross-fades the
+// materials and takes nine taps.
+enum class ShaderTier : uint8_t { Low, Medium, High };
+
 struct VkContext {
     vkb::Instance  instance;
     vkb::Device    device;
@@ -73,20 +203,297 @@ struct VkContext {
     void*         stagingMapped = nullptr;
     VkDeviceSize  stagingSize   = 64 * 1024 * 1024;
 
+    // One-shot uploads at load time (atlas), and the model batch of
+    // vk_submit_assets: staged in the ring, or in assetStaging when the
+    // ring can't take it, and left in flight until vk_assets_uploaded
     VkCommandBuffer uploadCmd   = VK_NULL_HANDLE;
     VkFence         uploadFence = VK_NULL_HANDLE;
+    bool            assetsInFlight    = false;
+    VkDeviceSize    assetRingBytes    = 0;
+    VkBuffer        assetStaging      = VK_NULL_HANDLE;
+    VmaAllocation   assetStagingAlloc = nullptr;
+
+    // Chunk uploads: the staging buffer is a ring, filled by up to
+    // UPLOAD_BATCHES submissions in flight on transferQueue — a dedicated
+    // transfer family when the device has one and timeline semaphores are
+    // available, the graphics queue otherwise. Nothing on the render path
+    // waits for them; finished batches are picked up by polling.
+    static constexpr int UPLOAD_BATCHES = 4;
+    VkQueue       transferQueue       = VK_NULL_HANDLE;
+    uint32_t      transferQueueFamily = 0;
+    VkCommandPool transferPool        = VK_NULL_HANDLE;
+    UploadBatch   uploadBatches[UPLOAD_BATCHES];
+    std::deque<int> uploadsInFlight;    // batch indices, oldest first
+    VkDeviceSize  stagingHead = 0;      // next write
+    VkDeviceSize  stagingTail = 0;      // oldest byte still in flight
+    VkDeviceSize  stagingUsed = 0;
+
+    // Timeline semaphore, signalled by each batch. The frame submit waits on
+    // the newest retired value, which orders the copies before the draw
+    // across queues (already signalled, so it never stalls).
+    VkSemaphore   uploadTimeline     = VK_NULL_HANDLE;
+    uint64_t      uploadTimelineNext = 0;
+    uint64_t      uploadVisibleValue = 0;
+    PFN_vkGetSemaphoreCounterValue getSemaphoreCounterValue = nullptr;
+
+    // Per-frame upload scheduling: staged bytes per flush, and the point
+    // queued chunks are prioritized around (nearest first)
+    VkDeviceSize  uploadBudget = Config::UPLOAD_BUDGET_BYTES;
+    glm::vec3     uploadFocus{0.f};
+    uint64_t      bytesUploaded = 0; // staged by every flush so far
+
+    // Mega-buffer bytes compaction may move per flush; 0 pauses it
+    VkDeviceSize  compactBudget = 0;
 
     MegaBuffer mega;
 
-    static constexpr uint32_t MAX_DRAW_CHUNKS = 512;
+    // ── GPU culling ───────────────────────────────────────────────────────
+    // Every resident chunk has a slot in chunkSlotBuffer, and its meshlets
+    // a range of meshletBuffer. Each frame cull.comp tests all slots
+    // against the frustum and the Hi-Z pyramid of the previous frame, then
+    // the meshlets of the chunks that pass, and appends a draw for each
+    // surviving meshlet to that frame's indirect buffer, nearest distance
+    // band first; the draw takes its count from the GPU.
+    static constexpr uint32_t MAX_CHUNK_SLOTS = 8192;
+    static constexpr uint32_t MAX_MESHLETS    = 1 << 18;
+    static constexpr uint32_t MAX_DRAWS       = MAX_MESHLETS;
+    static constexpr uint32_t CULL_BANDS      = 64; // cull.comp BANDS
+    // drawCountBuffer: the count and the meshlet passes' dispatch size,
+    // then cull.comp's bands, the surviving chunks, and each meshlet's flag
+    static constexpr VkDeviceSize CULL_COUNT_HEADER = (4 + 2 * CULL_BANDS) * sizeof(uint32_t);
+    static constexpr VkDeviceSize CULL_DISPATCH_OFFSET = sizeof(uint32_t);
+    static constexpr VkDeviceSize CULL_COUNT_SIZE =
+        CULL_COUNT_HEADER + (MAX_CHUNK_SLOTS + MAX_MESHLETS) * sizeof(uint32_t);
+
+    VkBuffer      chunkSlotBuffer = VK_NULL_HANDLE;
+    VmaAllocation chunkSlotAlloc  = nullptr;
+    uint32_t      chunkSlotCount  = 0;      // high-water mark
+    std::vector<uint32_t> freeChunkSlots;
+    std::vector<std::pair<uint32_t, ChunkSlot>> chunkSlotWrites; // next frame
+
+    // Uploaded with the chunk's mesh; GPU-meshed chunks get one meshlet
+    // each, written through the frame command buffer like slots
+    VkBuffer       meshletBuffer = VK_NULL_HANDLE;
+    VmaAllocation  meshletAlloc  = nullptr;
+    RangeAllocator meshletRanges{MAX_MESHLETS};
+    std::vector<std::pair<uint32_t, GpuMeshlet>> meshletWrites; // next frame
+    // Chunks an upload dropped for want of room in the mega buffers, the
+    // meshlet table or the slots, until vk_take_space_misses
+    std::vector<ChunkKey> spaceMisses;
 
     VkBuffer      indirectBuffer[2] = {};
     VmaAllocation indirectAlloc[2]  = {};
-    void*         indirectMapped[2] = {};
 
-    VkBuffer      perChunkBuffer[2] = {};
-    VmaAllocation perChunkAlloc[2]  = {};
-    void*         perChunkMapped[2] = {};
+    VkBuffer      drawCountBuffer[2] = {};
+    VmaAllocation drawCountAlloc[2]  = {};
+
+    VkBuffer      cullParamBuffer[2] = {};
+    VmaAllocation cullParamAlloc[2]  = {};
+    void*         cullParamMapped[2] = {};
+
+    // One bit per slot, cleared for full-resolution chunks the visibility
+    // walk didn't reach; cull.comp drops those before anything else
+    ChunkVisibility visibility;
+    VkBuffer      visibleBuffer[2] = {};
+    VmaAllocation visibleAlloc[2]  = {};
+    void*         visibleMapped[2] = {};
+
+    VkDescriptorSetLayout cullLayout         = VK_NULL_HANDLE;
+    VkDescriptorPool      cullPool           = VK_NULL_HANDLE;
+    VkDescriptorSet       cullSets[2]        = {};
+    VkPipelineLayout      cullPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline            cullChunksPipeline   = VK_NULL_HANDLE;
+    VkPipeline            cullMeshletsPipeline = VK_NULL_HANDLE;
+    VkPipeline            cullEmitPipeline     = VK_NULL_HANDLE;
+
+    // vkCmdDrawIndexedIndirectCount (core 1.2). Without it the draw
+    // buffer is zeroed first and drawn at full capacity.
+    PFN_vkCmdDrawIndexedIndirectCount cmdDrawIndexedIndirectCount = nullptr;
+
+    // Hi-Z: max-depth pyramid reduced from the depth buffer after the
+    // render pass (hiz.comp), sampled by next frame's cull. Level 0 is half
+    // the depth resolution.
+    VkImage       hizImage  = VK_NULL_HANDLE;
+    VmaAllocation hizAlloc  = nullptr;
+    VkImageView   hizView   = VK_NULL_HANDLE;   // all levels, for cull.comp
+    std::vector<VkImageView>     hizLevelViews;
+    std::vector<VkDescriptorSet> hizSets;       // level i reads i-1 (depth for 0)
+    VkExtent2D    hizExtent = {};
+    uint32_t      hizLevels = 0;
+    VkSampler     hizSampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout hizLayout         = VK_NULL_HANDLE;
+    VkDescriptorPool      hizPool           = VK_NULL_HANDLE;
+    VkPipelineLayout      hizPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline            hizPipeline       = VK_NULL_HANDLE;
+    glm::mat4     hizViewProj{1.f};
+    glm::vec2     hizRect{1.f}; // top-left share of the depth buffer drawn
+    bool          hizValid = false;
+
+    // ── Foliage ───────────────────────────────────────────────────────────
+    // Grass and rocks grown on the client over the resident terrain, at no
+    // cost on the wire: after the cull, foliage.comp walks the triangles of
+    // the full-resolution chunks it kept within FOLIAGE_REACH, scatters
+    // plants from per-chunk seeds at a density falling off with distance,
+    // and appends the ones in view to this frame's instance region and its
+    // type's draw. Each type is then one instanced indirect draw, built in
+    // foliage.vert from gl_VertexIndex. At most FOLIAGE_MAX_INSTANCES per
+    // type, whatever the view, so the cost is bounded.
+    static constexpr uint32_t FOLIAGE_TYPES         = 2;     // grass, rock
+    static constexpr uint32_t FOLIAGE_MAX_INSTANCES = 32768; // per type, foliage.comp's
+    static constexpr uint32_t FOLIAGE_VERTS[FOLIAGE_TYPES] = {9, 24};
+    static constexpr VkDeviceSize FOLIAGE_INSTANCE_BYTES = 16;
+    bool          foliage = true;
+    // VkDrawIndirectCommand per type, per frame in flight
+    VkBuffer      foliageDrawBuffer[2] = {};
+    VmaAllocation foliageDrawAlloc[2]  = {};
+    // Frame i's types at i * FOLIAGE_TYPES * FOLIAGE_MAX_INSTANCES; in the
+    // bindless table at BINDLESS_FOLIAGE for foliage.vert
+    VkBuffer      foliageInstanceBuffer = VK_NULL_HANDLE;
+    VmaAllocation foliageInstanceAlloc  = nullptr;
+    VkDescriptorSetLayout foliageLayout           = VK_NULL_HANDLE;
+    VkDescriptorPool      foliagePool             = VK_NULL_HANDLE;
+    VkDescriptorSet       foliageSets[2]          = {};
+    VkPipelineLayout      foliageScatterLayout    = VK_NULL_HANDLE;
+    VkPipeline            foliageScatterPipeline  = VK_NULL_HANDLE;
+    VkPipelineLayout      foliagePipelineLayout   = VK_NULL_HANDLE; // set 0: the table
+    VkPipeline            foliagePipeline         = VK_NULL_HANDLE;
+
+    // ── Particles ─────────────────────────────────────────────────────────
+    // Hit sparks, dust and the like, wholly on the GPU: each frame
+    // particle.comp ages the live pool into the other one, packed, appends
+    // the bursts vk_emit_particles queued, and leaves the new pool's draw,
+    // one instanced indirect draw in the scene pass built in particle.vert.
+    // The CPU only writes emitters, at most PARTICLE_MAX_EMITTERS a frame,
+    // however many particles are alive.
+    static constexpr uint32_t     PARTICLE_MAX             = 65536; // per pool, particle.comp's
+    static constexpr uint32_t     PARTICLE_MAX_EMITTERS    = 256;   // a frame
+    static constexpr VkDeviceSize PARTICLE_BYTES           = 48;
+    // Per pool: its count, the dispatch over it, then its draw
+    static constexpr VkDeviceSize PARTICLE_STATE_BYTES     = 32;
+    static constexpr VkDeviceSize PARTICLE_DISPATCH_OFFSET = 4;
+    static constexpr VkDeviceSize PARTICLE_DRAW_OFFSET     = 16;
+    std::vector<ParticleEmitter> particleQueue; // for the next frame drawn
+    uint32_t      particleLive   = 0;     // the pool holding the live particles
+    bool          particlePrimed = false; // both pools' states zeroed
+    std::chrono::steady_clock::time_point particleStepped{}; // last simulated
+    // Both pools, pool p from p * PARTICLE_MAX; in the bindless table at
+    // BINDLESS_PARTICLES for particle.vert
+    VkBuffer      particleBuffer      = VK_NULL_HANDLE;
+    VmaAllocation particleAlloc       = nullptr;
+    VkBuffer      particleStateBuffer = VK_NULL_HANDLE;
+    VmaAllocation particleStateAlloc  = nullptr;
+    // Host-written, per frame in flight
+    VkBuffer      particleEmitterBuffer[2] = {};
+    VmaAllocation particleEmitterAlloc[2]  = {};
+    void*         particleEmitterMapped[2] = {};
+    VkDescriptorSetLayout particleLayout           = VK_NULL_HANDLE;
+    VkDescriptorPool      particleDescPool         = VK_NULL_HANDLE;
+    VkDescriptorSet       particleSets[2]          = {};
+    VkPipelineLayout      particleSimLayout        = VK_NULL_HANDLE;
+    VkPipeline            particleSimulatePipeline = VK_NULL_HANDLE;
+    VkPipeline            particleEmitPipeline     = VK_NULL_HANDLE;
+    VkPipeline            particleArgsPipeline     = VK_NULL_HANDLE;
+    VkPipelineLayout      particlePipelineLayout   = VK_NULL_HANDLE; // set 0: the table
+    VkPipeline            particlePipeline         = VK_NULL_HANDLE;
+
+    // ── Lights ────────────────────────────────────────────────────────────
+    // Clustered: the view cut into LIGHT_TILES_X x LIGHT_TILES_Y tiles and
+    // LIGHT_SLICES depth slices out to LIGHT_FAR, deeper the further out.
+    // Each frame the lights vk_add_light queued are copied into the grid,
+    // then light_cull.comp lists per cluster those reaching it, and
+    // terrain.frag and player.frag shade with their cluster's list alone.
+    // A cluster lists LIGHT_CLUSTER_CAP - 1 at most.
+    static constexpr uint32_t     LIGHT_MAX         = 1024; // a frame
+    static constexpr uint32_t     LIGHT_TILES_X     = 16;
+    static constexpr uint32_t     LIGHT_TILES_Y     = 9;
+    static constexpr uint32_t     LIGHT_SLICES      = 24;
+    static constexpr uint32_t     LIGHT_CLUSTERS    = LIGHT_TILES_X * LIGHT_TILES_Y * LIGHT_SLICES;
+    static constexpr uint32_t     LIGHT_CLUSTER_CAP = 32;   // uints: its count, then indices
+    static constexpr float        LIGHT_NEAR        = 1.f;  // slice 0 reaches in to the eye
+    static constexpr float        LIGHT_FAR         = 256.f;
+    // LightGrid (light_cull.comp), then the lights, then the clusters
+    static constexpr VkDeviceSize LIGHT_HEADER_BYTES = 144;
+    static constexpr VkDeviceSize LIGHT_INPUT_BYTES  = LIGHT_HEADER_BYTES + LIGHT_MAX * sizeof(PointLight);
+    static constexpr VkDeviceSize LIGHT_GRID_BYTES   =
+        LIGHT_INPUT_BYTES + LIGHT_CLUSTERS * LIGHT_CLUSTER_CAP * sizeof(uint32_t);
+    std::vector<PointLight> lightQueue; // for the next frame drawn
+    // Host-written, per frame in flight: the header and lights, copied in
+    VkBuffer      lightInputBuffer[2] = {};
+    VmaAllocation lightInputAlloc[2]  = {};
+    void*         lightInputMapped[2] = {};
+    // In the bindless table at BINDLESS_LIGHTS for the shading
+    VkBuffer      lightGridBuffer = VK_NULL_HANDLE;
+    VmaAllocation lightGridAlloc  = nullptr;
+    VkDescriptorSetLayout lightLayout       = VK_NULL_HANDLE;
+    VkDescriptorPool      lightDescPool     = VK_NULL_HANDLE;
+    VkDescriptorSet       lightSet          = VK_NULL_HANDLE;
+    VkPipelineLayout      lightCullLayout   = VK_NULL_HANDLE;
+    VkPipeline            lightCullPipeline = VK_NULL_HANDLE;
+
+    // ── Far terrain ───────────────────────────────────────────────────────
+    // FarTerrain's levels back to back, a host-visible copy per frame in
+    // flight, each level rewritten when its version moves on; one index
+    // list serves every level. Drawn first with its own depth range, then
+    // depth is cleared for the chunks.
+    static constexpr VkDeviceSize FAR_VERTEX_BYTES =
+        FarTerrain::LEVELS * FarTerrain::VERTS * sizeof(FarTerrain::Vertex);
+    VkBuffer         farVertexBuffer[2] = {};
+    VmaAllocation    farVertexAlloc[2]  = {};
+    void*            farVertexMapped[2] = {};
+    uint32_t         farVersions[2][FarTerrain::LEVELS] = {};
+    VkBuffer         farIndexBuffer     = VK_NULL_HANDLE;
+    VmaAllocation    farIndexAlloc      = nullptr;
+    VkPipelineLayout farPipelineLayout  = VK_NULL_HANDLE; // set 0: atlas
+    VkPipeline       farPipeline        = VK_NULL_HANDLE;
+
+    // ── Sun shadows ───────────────────────────────────────────────────────
+    // A layer per cascade in two depth arrays. The static one holds the
+    // terrain and is only redrawn for a dirty cascade — at most one a
+    // frame, oldest first, each cascade waiting longer than the one
+    // inside it; the dynamic one is cleared and holds the remote players,
+    // redrawn every frame they're about. terrain.frag takes the nearer of
+    // the two. Both pass through shadowRenderPass before the main pass, and
+    // start out cleared to the far plane.
+    static constexpr int SHADOW_CASCADES = Config::SHADOW_CASCADES;
+    ShadowCascade   shadowCascades[SHADOW_CASCADES];
+    glm::vec3       sunDir{0.f, 1.f, 0.f}; // vk_set_sun
+    bool            dynamicShadows = false; // casters in the dynamic map
+    VkImage         shadowStaticImage   = VK_NULL_HANDLE;
+    VmaAllocation   shadowStaticAlloc   = nullptr;
+    VkImageView     shadowStaticView    = VK_NULL_HANDLE; // all layers
+    VkImage         shadowDynamicImage  = VK_NULL_HANDLE;
+    VmaAllocation   shadowDynamicAlloc  = nullptr;
+    VkImageView     shadowDynamicView   = VK_NULL_HANDLE;
+    VkImageView     shadowLayerViews[2][SHADOW_CASCADES]   = {}; // static, dynamic
+    VkFramebuffer   shadowFramebuffers[2][SHADOW_CASCADES] = {};
+    VkRenderPass    shadowRenderPass    = VK_NULL_HANDLE; // depth only
+    VkSampler       shadowSampler       = VK_NULL_HANDLE; // comparison
+    VkBuffer        shadowParamBuffer[2] = {};
+    VmaAllocation   shadowParamAlloc[2]  = {};
+    void*           shadowParamMapped[2] = {};
+    // Set 1: ShadowParams, static and dynamic maps
+    VkDescriptorSetLayout shadowLayout   = VK_NULL_HANDLE;
+    VkDescriptorPool      shadowPool     = VK_NULL_HANDLE;
+    VkDescriptorSet       shadowSets[2]  = {};
+    VkPipeline            shadowPipeline = VK_NULL_HANDLE; // terrain.vert only
+
+    // ── GPU meshing ───────────────────────────────────────────────────────
+    // Only with vk_init(..., gpuMesh). march.comp's three passes share one
+    // layout; each job has its own descriptor set. Jobs advance in vk_draw,
+    // oldest first.
+    static constexpr int GPU_MESH_JOBS = 8;
+    bool                  gpuMesh = false;
+    GpuMeshJob            gpuMeshJobs[GPU_MESH_JOBS];
+    std::deque<int>       gpuMeshOrder; // busy jobs, oldest first
+    VkBuffer              marchTableBuffer    = VK_NULL_HANDLE;
+    VmaAllocation         marchTableAlloc     = nullptr;
+    VkDescriptorSetLayout marchLayout         = VK_NULL_HANDLE;
+    VkDescriptorPool      marchPool           = VK_NULL_HANDLE;
+    VkPipelineLayout      marchPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline            marchClassify       = VK_NULL_HANDLE;
+    VkPipeline            marchScan           = VK_NULL_HANDLE;
+    VkPipeline            marchEmit           = VK_NULL_HANDLE;
+    std::vector<ChunkUpload> gpuMeshed; // read back; vk_take_gpu_meshed
 
     VkSurfaceKHR surface             = VK_NULL_HANDLE;
     VkQueue      graphicsQueue       = VK_NULL_HANDLE;
@@ -98,18 +505,58 @@ struct VkContext {
     std::vector<VkImage>       swapImages;
     std::vector<VkImageView>   swapImageViews;
     std::vector<VkFramebuffer> framebuffers;
+    // --bench renders into images of its own instead of a swapchain: one
+    // per frame slot, never presented (vk_init's offscreen extent)
+    bool                       offscreen = false;
+    std::vector<VmaAllocation> offscreenAllocs; // of the swapImages, offscreen
+
+    // ── Frame pacing ──────────────────────────────────────────────────────
+    // vk_wait_frame, at the top of the main loop, blocks until the frame
+    // slot about to be recorded is free — so input is sampled after the
+    // wait, not before it. With lowLatency it also waits for the previous
+    // frame, keeping the GPU at most one frame behind, and with
+    // VK_KHR_present_wait for the frame before that to reach the display.
+    VkPresentModeKHR presentMode   = VK_PRESENT_MODE_FIFO_KHR; // the swapchain's
+    VkPresentModeKHR presentWanted = VK_PRESENT_MODE_FIFO_KHR; // last asked for
+    bool             lowLatency    = false;
+    PFN_vkWaitForPresentKHR waitForPresent = nullptr; // with present_wait
+    uint64_t         presentId     = 0;               // of the last present
+
+    // ── Render graph ──────────────────────────────────────────────────────
+    // vk_draw declares the frame as passes and lets the graph cull, order
+    // and synchronise them; recordPool records the parallel ones
+    RenderGraph                 graph;
+    std::unique_ptr<ThreadPool> recordPool;
 
     VkRenderPass          renderPass     = VK_NULL_HANDLE;
 
-    // Set 0: per-chunk storage buffer
-    VkDescriptorSetLayout dsLayout       = VK_NULL_HANDLE;
-    VkDescriptorPool      dsPool         = VK_NULL_HANDLE;
-    VkDescriptorSet       dsSets[2]      = {};
-
-    // Set 1: atlas sampler
-    VkDescriptorSetLayout atlasLayout    = VK_NULL_HANDLE;
-    VkDescriptorPool      atlasPool      = VK_NULL_HANDLE;
-    VkDescriptorSet       atlasSet       = VK_NULL_HANDLE;
+    // ── Dynamic resolution ────────────────────────────────────────────────
+    // While dynamicResolution is set the scene (far terrain, terrain,
+    // players) goes into the top-left resolution.extent() of sceneImage
+    // and the depth buffer through sceneRenderPass, the Hi-Z is built from
+    // that, and the rect is blitted over the whole swapchain image; the
+    // view model and ImGui follow at native resolution in overlayRenderPass
+    // on a fresh depth buffer. Needs the swapchain to take blits (canUpscale);
+    // without it, or while unset, everything goes straight to the swapchain.
+    bool              dynamicResolution = false;
+    bool              canUpscale        = false;
+    DynamicResolution resolution;
+    VkImage           sceneImage     = VK_NULL_HANDLE; // swapchain size and format
+    VmaAllocation     sceneAlloc     = nullptr;
+    VkImageView       sceneImageView = VK_NULL_HANDLE;
+    VkRenderPass      sceneRenderPass   = VK_NULL_HANDLE; // leaves colour for the blit
+    VkRenderPass      overlayRenderPass = VK_NULL_HANDLE; // loads the blit
+    VkFramebuffer     sceneFramebuffer  = VK_NULL_HANDLE;
+    std::vector<VkFramebuffer> overlayFramebuffers;       // per swapchain image
+
+    // Set 0, every renderer's: textures and storage buffers by index. The
+    // reserved entries below; players and the rest add theirs
+    static constexpr uint32_t BINDLESS_ATLAS       = 0; // texture
+    static constexpr uint32_t BINDLESS_CHUNK_SLOTS = 0; // buffer
+    static constexpr uint32_t BINDLESS_FOLIAGE     = 1; // buffer
+    static constexpr uint32_t BINDLESS_PARTICLES   = 2; // buffer
+    static constexpr uint32_t BINDLESS_LIGHTS      = 3; // buffer
+    std::unique_ptr<BindlessTable> bindless;
 
     // Atlas texture
     VkImage       atlasImage     = VK_NULL_HANDLE;
@@ -118,7 +565,26 @@ struct VkContext {
     VkSampler     atlasSampler   = VK_NULL_HANDLE;
 
     VkPipelineLayout      pipelineLayout = VK_NULL_HANDLE;
-    VkPipeline            pipeline       = VK_NULL_HANDLE;
+    VkPipeline            pipeline       = VK_NULL_HANDLE; // built for shaderTier
+    ShaderTier            shaderTier     = ShaderTier::Medium;
+    // Replaced by vk_set_shader_tier, destroyed once no frame that may have
+    // bound them is still in flight (as retiredRanges)
+    struct RetiredPipeline {
+        VkPipeline pipeline;
+        uint64_t   after;
+    };
+    std::deque<RetiredPipeline> retiredPipelines;
+    // Depth-only terrain, drawn first when depthPrepass is set, so
+    // terrain.frag then runs once per pixel rather than once per layer.
+    // Worth it where overdraw is high (hills, caves) and fill rate low.
+    VkPipeline            depthPrepassPipeline = VK_NULL_HANDLE;
+    bool                  depthPrepass         = false;
+
+    // Shared by every renderer's pipelines, persisted by PipelineCache.
+    // The pipelines themselves are built by vk_build_pipelines, usually on
+    // a worker; until pipelinesReady vk_draw only clears and draws ImGui.
+    VkPipelineCache       pipelineCache  = VK_NULL_HANDLE;
+    bool                  pipelinesReady = false;
 
     std::vector<VkSemaphore> imageAvailable;
     std::vector<VkSemaphore> renderFinished;
@@ -126,21 +592,101 @@ struct VkContext {
 
     VmaAllocator allocator = nullptr;
 
-    std::unordered_map<ChunkCoord, GpuChunk, ChunkCoordHash> chunks;
-    std::deque<PendingUpload> uploadQueue;
+    FlatMap<ChunkKey, GpuChunk, ChunkKeyHash> chunks; // LOD cells too
+    std::vector<PendingUpload> uploadQueue;
+    std::vector<ChunkUpload>  spentMeshes; // staged; hand back to MeshBuilder::recycle
 
     static constexpr int FRAMES_IN_FLIGHT = 2;
     uint32_t currentFrame = 0;
+    // The frame's graph and what's built for it; begun with the frame
+    FrameArena<FRAMES_IN_FLIGHT> frameArena;
+
+    // Mega-buffer ranges of removed or replaced chunks. Frames already
+    // submitted may still draw from them, so each waits until every frame
+    // submitted before it was retired (framesSubmitted at the time) has
+    // signalled its inFlight fence.
+    struct RetiredRange {
+        GpuChunk gpu;
+        uint64_t after;
+    };
+    std::deque<RetiredRange> retiredRanges;
+    uint64_t                 framesSubmitted = 0;
+
+    // vk_draw times its passes and flushUploads here; main adds CPU scopes
+    FrameProfiler profiler;
+
+    // Chunks made drawable since the last frame was submitted, while tracing
+    std::vector<ChunkKey> traceDrawable;
 };
 void vk_load_atlas(VkContext& ctx, const char* path);
-VkContext vk_init(GLFWwindow* window);
+// Submits a batch of load-time uploads on uploadCmd without waiting; call
+// before any chunk is uploaded (the ring is free then) and from the main
+// thread. vk_assets_uploaded polls, vk_wait_assets blocks; either gives the
+// staging back once the copies are done, and nothing in the batch may be
+// drawn until then.
+void vk_submit_assets(VkContext& ctx, StagedUploads& batch);
+bool vk_assets_uploaded(VkContext& ctx);
+void vk_wait_assets(VkContext& ctx);
+// gpuMesh sets up the compute marching cubes path (vk_gpu_mesh_chunk). A
+// non-zero offscreen extent draws into images of that size instead of the
+// window's swapchain; the window then only picks the device.
+VkContext vk_init(GLFWwindow* window, bool gpuMesh = false, VkExtent2D offscreen = {});
+// Terrain, cull and Hi-Z pipelines. Safe to run on another thread while the
+// main thread draws with pipelinesReady still false; set it once this returns.
+void      vk_build_pipelines(VkContext& ctx);
+// Writes ctx.pipelineCache to disk
+void      vk_save_pipeline_cache(VkContext& ctx);
+// Rebuilds the terrain colour pipeline for another tier, from the cache
+// when it has been built before. Main thread, once pipelinesReady; before
+// then set ctx.shaderTier instead, ahead of vk_build_pipelines.
+void      vk_set_shader_tier(VkContext& ctx, ShaderTier tier);
 void      vk_destroy(VkContext& ctx);
 
 void      vk_draw(VkContext& ctx, const glm::mat4& viewProj,
                   float sunIntensity, glm::vec3 skyColor,
                   const ViewModelRenderer* viewModel = nullptr,
                   const glm::mat4& proj = glm::mat4(1.f),
-                  const RemotePlayerRenderer* remotePlayers = nullptr);
-
-void      vk_upload_chunk(VkContext& ctx, const ChunkMesh& mesh);
-void      vk_remove_chunk(VkContext& ctx, ChunkCoord coord);
+                  RemotePlayerRenderer* remotePlayers = nullptr,
+                  const FarTerrain* far = nullptr,
+                  const glm::mat4& farViewProj = glm::mat4(1.f));
+
+void      vk_upload_chunk(VkContext& ctx, ChunkUpload&& mesh);
+void      vk_remove_chunk(VkContext& ctx, const ChunkKey& key);
+// Removes every chunk or LOD cell (resident, queued or uploading) keep
+// rejects, appending their keys to evicted
+void      vk_evict_chunks(VkContext& ctx, const std::function<bool(const ChunkKey&)>& keep,
+                          std::vector<ChunkKey>& evicted);
+// Top of the main loop, before input is read: see Frame pacing above
+void      vk_wait_frame(VkContext& ctx);
+// Rebuilds the swapchain when mode isn't what it has; one the surface
+// lacks falls back to mailbox or immediate, then FIFO. Between frames.
+void      vk_set_present_mode(VkContext& ctx, VkPresentModeKHR mode);
+// World position queued uploads are ordered around — call once per frame
+void      vk_set_upload_focus(VkContext& ctx, glm::vec3 pos);
+// Unit vector towards the sun, for lighting and shadows — once per frame
+void      vk_set_sun(VkContext& ctx, glm::vec3 dir);
+// Bytes of live chunk data compaction may move this frame — hand it spare
+// frame time, 0 otherwise
+void      vk_set_compact_budget(VkContext& ctx, size_t bytes);
+// Queues a burst for the next vk_draw; past PARTICLE_MAX_EMITTERS a frame,
+// or with no scene to draw, they're dropped
+void      vk_emit_particles(VkContext& ctx, const ParticleEmitter& e);
+// Queues a light for the next vk_draw alone — queue it again every frame
+// it's lit; past LIGHT_MAX a frame they're dropped
+void      vk_add_light(VkContext& ctx, const PointLight& light);
+size_t    vk_pending_uploads(const VkContext& ctx);
+// The chunk pools' occupancy and the staging ring's, for MemoryBudget
+GpuMemoryStats vk_memory_stats(const VkContext& ctx);
+// Moves the chunks dropped for want of room since the last call into out
+void      vk_take_space_misses(VkContext& ctx, std::vector<ChunkKey>& out);
+
+// GPU meshing: jobs free to take a field now — 0 without gpuMesh, and until
+// the pipelines are built
+int       vk_gpu_mesh_free(const VkContext& ctx);
+// Queues a full-resolution field to be marched on the GPU; it replaces
+// whatever the chunk shows a frame or two later. Needs a free job.
+// faceLinks is the field's chunkFaceLinks.
+void      vk_gpu_mesh_chunk(VkContext& ctx, const ChunkData& field, uint16_t faceLinks);
+// Chunks the GPU has finished meshing, as unindexed triangles (positions
+// only) for colliders; an empty mesh is a chunk with no surface
+void      vk_take_gpu_meshed(VkContext& ctx, std::vector<ChunkUpload>& out);
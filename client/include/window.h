@@ -5,7 +5,8 @@
 
 class Window {
 public:
-    Window(int width, int height, std::string_view title);
+    // visible=false: never shown (--bench, which only needs its surface)
+    Window(int width, int height, std::string_view title, bool visible = true);
     ~Window();
 
     bool        shouldClose() const { return glfwWindowShouldClose(_window); }
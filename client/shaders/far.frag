@@ -0,0 +1,45 @@
+#version 450
+
+// The bindless table's textures. Of the atlas, one layer per BlockMat, only
+// the last mip is read, the layer's average colour, since a far quad spans
+// many texture repeats
+const uint MAX_TEXTURES = 128u; // BindlessTable::MAX_TEXTURES
+const uint ATLAS        = 0u;   // VkContext::BINDLESS_ATLAS
+layout(set = 0, binding = 0) uniform sampler2DArray textures[MAX_TEXTURES];
+
+layout(push_constant) uniform PC {
+    mat4 viewProj;
+    vec4 hole; // xz box finer geometry covers: min in xy, max in zw
+    vec4 eye;  // w: sun intensity
+    vec4 fog;  // sky colour; w: distance everything has faded into it
+    vec4 sun;  // towards the sun, as terrain.frag's
+} pc;
+
+layout(location = 0) in vec3 fragNormal;
+layout(location = 1) in vec3 fragPos;
+layout(location = 2) flat in uint fragLayer;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    if (all(greaterThan(fragPos.xz, pc.hole.xy)) && all(lessThan(fragPos.xz, pc.hole.zw)))
+        discard;
+
+    // Lit as terrain.frag lights the chunks, so the seam doesn't show
+    vec3 an = abs(fragNormal);
+    vec3 n;
+    if (an.x > an.y && an.x > an.z)      n = vec3(sign(fragNormal.x), 0, 0);
+    else if (an.y > an.x && an.y > an.z) n = vec3(0, sign(fragNormal.y), 0);
+    else                                  n = vec3(0, 0, sign(fragNormal.z));
+
+    float sunIntensity = pc.eye.w;
+    vec3  sunDir  = pc.sun.xyz;
+    float diffuse = max(dot(n, sunDir), 0.0) * sunIntensity;
+    float ambient = mix(0.05, 0.2, sunIntensity);
+    float light   = clamp(ambient + diffuse, 0.0, 1.0);
+
+    float lastMip = float(textureQueryLevels(textures[ATLAS]) - 1);
+    vec3  baseCol = textureLod(textures[ATLAS], vec3(0.5, 0.5, float(fragLayer)), lastMip).rgb;
+    float fade    = smoothstep(pc.fog.w * 0.35, pc.fog.w, distance(fragPos, pc.eye.xyz));
+    outColor = vec4(mix(baseCol * light, pc.fog.rgb, fade), 1.0);
+}
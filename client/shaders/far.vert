@@ -0,0 +1,37 @@
+#version 450
+
+// FarTerrain::Vertex: world position; octahedral normal in the low 16 bits
+// of the second word, material above (as TerrainVertex)
+layout(location = 0) in vec3 inPos;
+layout(location = 1) in uint inNormMat;
+
+layout(push_constant) uniform PC {
+    mat4 viewProj; // the far depth range
+    vec4 hole;
+    vec4 eye;
+    vec4 fog;
+    vec4 sun;
+} pc;
+
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out vec3 fragPos;
+layout(location = 2) flat out uint fragLayer;
+
+const uint MAT_COUNT = 4u; // ATLAS_MAT_COUNT, atlas layers; past it, stone
+
+vec3 octDecode(uint n) {
+    vec2 f = vec2(float((n >> 8) & 0xFFu), float(n & 0xFFu)) / 255.0 * 2.0 - 1.0;
+    vec3 v = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    if (v.z < 0.0)
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0,
+                                        v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
+
+void main() {
+    uint mat    = (inNormMat >> 16) & 0xFFu;
+    gl_Position = pc.viewProj * vec4(inPos, 1.0);
+    fragNormal  = octDecode(inNormMat & 0xFFFFu);
+    fragPos     = inPos;
+    fragLayer   = mat < MAT_COUNT ? mat : 0u;
+}
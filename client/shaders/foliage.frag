@@ -0,0 +1,43 @@
+#version 450
+
+// The atlas layer's average colour, as far.frag takes it: grass the grass
+// it stands on, rocks stone. Lit and fogged as terrain.frag's Medium tier.
+const uint MAX_TEXTURES = 128u; // BindlessTable::MAX_TEXTURES
+const uint ATLAS        = 0u;   // VkContext::BINDLESS_ATLAS
+const uint MAT_STONE    = 0u;   // BlockMat
+const uint MAT_GRASS    = 2u;
+layout(set = 0, binding = 0) uniform sampler2DArray textures[MAX_TEXTURES];
+
+layout(push_constant) uniform PC {
+    mat4  viewProj;
+    vec4  eye;  // w: sun intensity
+    vec4  fog;  // sky colour; w: distance everything has faded into it
+    vec4  sun;  // towards the sun
+    uvec4 type; // x: 0 grass, 1 rock
+} pc;
+
+layout(location = 0) in vec3  fragNormal;
+layout(location = 1) in vec3  fragWorld;
+layout(location = 2) in float fragShade;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec3 n = normalize(fragNormal);
+    if (!gl_FrontFacing && pc.type.x == 0u)
+        n = -n;
+
+    float sunIntensity = pc.eye.w;
+    float diffuse = max(dot(n, pc.sun.xyz), 0.0) * sunIntensity;
+    float ambient = mix(0.05, 0.2, sunIntensity);
+    float light   = clamp(ambient + diffuse, 0.0, 1.0);
+
+    uint  layer   = pc.type.x == 0u ? MAT_GRASS : MAT_STONE;
+    float lastMip = float(textureQueryLevels(textures[ATLAS]) - 1);
+    vec3  baseCol = textureLod(textures[ATLAS], vec3(0.5, 0.5, float(layer)), lastMip).rgb;
+    // A little greener than the ground, so the blades read against it
+    if (pc.type.x == 0u)
+        baseCol *= vec3(0.9, 1.15, 0.8);
+    float fade = smoothstep(pc.fog.w * 0.35, pc.fog.w, distance(fragWorld, pc.eye.xyz));
+    outColor = vec4(mix(baseCol * light * fragShade, pc.fog.rgb, fade), 1.0);
+}
@@ -0,0 +1,85 @@
+#version 450
+
+// One plant per instance, built from gl_VertexIndex: no vertex buffer, the
+// shapes are below. The type comes with the draw (one per type), the
+// instance from foliage.comp's region of the bindless table's buffer.
+const uint MAX_BUFFERS = 32u; // BindlessTable::MAX_BUFFERS
+const uint FOLIAGE     = 1u;  // VkContext::BINDLESS_FOLIAGE
+
+struct Instance {
+    vec3 pos;
+    uint packed; // yaw 8 bits, scale 8, tint 8
+};
+layout(std430, set = 0, binding = 1) readonly buffer InstanceBuffer {
+    Instance instances[];
+} buffers[MAX_BUFFERS];
+
+layout(push_constant) uniform PC {
+    mat4  viewProj;
+    vec4  eye;  // w: sun intensity
+    vec4  fog;  // sky colour; w: distance everything has faded into it
+    vec4  sun;  // towards the sun
+    uvec4 type; // x: 0 grass, 1 rock
+} pc;
+
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out vec3 fragWorld;
+layout(location = 2) out float fragShade; // grass darkens towards the root
+
+// Grass: three blades a triangle each, a third of a turn apart, their tips
+// leaning out. Rock: an octahedron sunk halfway into the ground.
+// 9 and 24 vertices, the draws' vertexCount (VkContext::FOLIAGE_VERTS).
+const float TAU = 6.2831853;
+
+vec3 rockCorner(uint i) {
+    // Four around, one top, one bottom
+    if (i < 4u) {
+        float a = float(i) * (TAU / 4.0);
+        return vec3(cos(a), 0.0, sin(a));
+    }
+    return vec3(0.0, i == 4u ? 0.7 : -0.7, 0.0);
+}
+
+void main() {
+    Instance inst = buffers[FOLIAGE].instances[gl_InstanceIndex];
+    float yaw   = float(inst.packed & 0xFFu) * (TAU / 256.0);
+    float scale = 0.7 + float((inst.packed >> 8) & 0xFFu) * (0.6 / 255.0);
+    float tint  = float((inst.packed >> 16) & 0xFFu) / 255.0;
+
+    vec3 local, normal;
+    if (pc.type.x == 0u) {
+        uint  blade = uint(gl_VertexIndex) / 3u, corner = uint(gl_VertexIndex) % 3u;
+        float a     = yaw + float(blade) * (TAU / 3.0);
+        vec3  side  = vec3(cos(a), 0.0, sin(a));
+        vec3  lean  = vec3(-side.z, 0.0, side.x);
+        float h     = (0.45 + 0.25 * tint) * scale;
+        if (corner == 2u)
+            local = lean * 0.18 * h + vec3(0.0, h, 0.0);
+        else
+            local = side * (corner == 0u ? -0.05 : 0.05);
+        normal    = normalize(vec3(0.0, 1.0, 0.0) + lean * 0.5);
+        fragShade = corner == 2u ? 1.0 : 0.55;
+    } else {
+        // Faces: top four, then bottom four, each round the ring; drawn
+        // both sides, so the winding doesn't matter
+        uint  face = uint(gl_VertexIndex) / 3u, corner = uint(gl_VertexIndex) % 3u;
+        uint  ring = face & 3u;
+        vec3  c0 = rockCorner(ring), c1 = rockCorner((ring + 1u) & 3u);
+        vec3  c2 = rockCorner(face < 4u ? 4u : 5u);
+        float r  = 0.22 * scale;
+        mat2  rot = mat2(cos(yaw), sin(yaw), -sin(yaw), cos(yaw));
+        vec3  p  = corner == 0u ? c0 : corner == 1u ? c1 : c2;
+        p.xz     = rot * p.xz;
+        local    = p * r * vec3(1.0 + tint * 0.4, 1.0, 1.0);
+        vec3 n   = cross(c1 - c0, c2 - c0);
+        if (dot(n, c0 + c1 + c2) < 0.0)
+            n = -n; // outwards
+        n.xz     = rot * n.xz;
+        normal   = normalize(n);
+        fragShade = 0.8 + 0.2 * tint;
+    }
+
+    fragWorld   = inst.pos + local;
+    fragNormal  = normal;
+    gl_Position = pc.viewProj * vec4(fragWorld, 1.0);
+}
@@ -0,0 +1,31 @@
+#version 450
+
+// A soft disc, premultiplied: blended particles cover what's behind them,
+// glows (alpha 0) only add to it. Into the fog as the terrain goes.
+layout(push_constant) uniform PC {
+    mat4  viewProj;
+    vec4  eye;
+    vec4  fog;  // sky colour; w: distance everything has faded into it
+    uvec4 base;
+} pc;
+
+layout(location = 0) in vec2 fragCorner;
+layout(location = 1) in vec4 fragColor;
+layout(location = 2) in vec3 fragWorld;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    float r2 = dot(fragCorner, fragCorner);
+    if (r2 > 1.0)
+        discard;
+    float soft = 1.0 - r2;
+    float fade = 1.0 - smoothstep(pc.fog.w * 0.35, pc.fog.w, distance(fragWorld, pc.eye.xyz));
+    if (fragColor.a == 0.0) {
+        // A glow just fades
+        outColor = vec4(fragColor.rgb * (soft * fade), 0.0);
+        return;
+    }
+    float a  = fragColor.a * soft;
+    outColor = vec4(mix(fragColor.rgb * soft, pc.fog.rgb * a, 1.0 - fade), a);
+}
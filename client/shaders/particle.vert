@@ -0,0 +1,72 @@
+#version 450
+
+// A quad per live particle, from gl_VertexIndex: no vertex buffer, the
+// pool is the bindless table's buffer and the draw's instance count is
+// particle.comp's. Glows stretch along their velocity into streaks; the
+// rest face the eye.
+const uint MAX_BUFFERS = 32u; // BindlessTable::MAX_BUFFERS
+const uint PARTICLES   = 2u;  // VkContext::BINDLESS_PARTICLES
+
+// particle.comp's
+struct Particle {
+    vec3  pos;
+    float life;
+    vec3  vel;
+    float gravity;
+    uint  color;
+    float size;
+    float span;
+    float drag;
+};
+layout(std430, set = 0, binding = 1) readonly buffer ParticleBuffer {
+    Particle particles[];
+} buffers[MAX_BUFFERS];
+
+layout(push_constant) uniform PC {
+    mat4  viewProj;
+    vec4  eye;  // w: sun intensity
+    vec4  fog;  // sky colour; w: distance everything has faded into it
+    uvec4 base; // x: the drawn pool's first particle
+} pc;
+
+layout(location = 0) out vec2  fragCorner; // -1..1 across the quad
+layout(location = 1) out vec4  fragColor;  // premultiplied; alpha 0 adds
+layout(location = 2) out vec3  fragWorld;
+
+const vec2 CORNERS[6] = vec2[](vec2(-1, -1), vec2(1, -1), vec2(1, 1),
+                               vec2(-1, -1), vec2(1, 1), vec2(-1, 1));
+
+void main() {
+    Particle p = buffers[PARTICLES].particles[pc.base.x + uint(gl_InstanceIndex)];
+    vec2 c  = CORNERS[gl_VertexIndex];
+    vec4 col = unpackUnorm4x8(p.color);
+    bool glow = col.a == 0.0;
+
+    vec3 toEye = pc.eye.xyz - p.pos;
+    vec3 look  = dot(toEye, toEye) > 1e-6 ? normalize(toEye) : vec3(0.0, 0.0, 1.0);
+    vec3 right, up;
+    float len = 1.0;
+    vec3 along = cross(p.vel, look);
+    if (glow && dot(along, along) > 1e-6) {
+        // Across the streak, then along it, as long as a frame's travel
+        right = normalize(along);
+        up    = normalize(cross(look, right));
+        len   = 1.0 + length(p.vel) * 0.03 / max(p.size, 1e-3);
+    } else {
+        vec3 ref = abs(look.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+        right = normalize(cross(ref, look));
+        up    = cross(look, right);
+    }
+    float extent = p.size * 0.5;
+    fragWorld    = p.pos + right * (c.x * extent) + up * (c.y * extent * len);
+    fragCorner   = c;
+
+    // Out over the last third of its life
+    float fade = clamp(p.life / max(p.span * 0.33, 1e-3), 0.0, 1.0);
+    if (!glow) {
+        float light = mix(0.25, 1.0, pc.eye.w);
+        col.rgb *= light;
+    }
+    fragColor   = vec4(col.rgb * fade, col.a * fade);
+    gl_Position = pc.viewProj * vec4(fragWorld, 1.0);
+}
@@ -1,17 +1,71 @@
 #version 450
 
-layout(set = 0, binding = 0) uniform sampler2D atlas;
+const uint MAX_TEXTURES = 128u; // BindlessTable::MAX_TEXTURES
+layout(set = 0, binding = 0) uniform sampler2D textures[MAX_TEXTURES];
+
+// The light grid, as terrain.frag takes it
+const uint MAX_BUFFERS = 32u;   // BindlessTable::MAX_BUFFERS
+const uint LIGHTS      = 3u;    // VkContext::BINDLESS_LIGHTS
+const uint MAX_LIGHTS  = 1024u; // VkContext::LIGHT_MAX
+const uint CLUSTER_CAP = 32u;   // VkContext::LIGHT_CLUSTER_CAP
+struct Light {
+    vec3  pos;
+    float radius;
+    vec3  color;
+    float intensity;
+};
+layout(std430, set = 0, binding = 1) readonly buffer LightGrid {
+    uvec4 grid;
+    vec4  screen;
+    vec4  eye;
+    vec4  forward;
+    vec4  proj;
+    mat4  view;
+    Light lights[MAX_LIGHTS];
+    uint  clusters[];
+} buffers[MAX_BUFFERS];
+
+layout(push_constant) uniform PC {
+    mat4  viewProj;
+    uvec4 table; // as player.vert's; z the atlas
+} pc;
 
 layout(location = 0) in vec3 fragNormal;
 layout(location = 1) in vec2 fragUV;
+layout(location = 2) in vec3 fragWorld;
 
 layout(location = 0) out vec4 outColor;
 
+// terrain.frag's
+vec3 pointLights(vec3 world, vec3 n) {
+    if (buffers[LIGHTS].grid.w == 0u) return vec3(0.0);
+    uvec4 grid  = buffers[LIGHTS].grid;
+    vec4  scr   = buffers[LIGHTS].screen;
+    float depth = dot(world - buffers[LIGHTS].eye.xyz, buffers[LIGHTS].forward.xyz);
+    if (depth > buffers[LIGHTS].proj.w) return vec3(0.0);
+    uvec2 tile  = min(uvec2(gl_FragCoord.xy * scr.xy), grid.xy - 1u);
+    uint  slice = min(uint(max(log(max(depth, 1e-4)) * scr.z + scr.w, 0.0)), grid.z - 1u);
+    uint  base  = (tile.x + grid.x * (tile.y + grid.y * slice)) * CLUSTER_CAP;
+    uint  count = buffers[LIGHTS].clusters[base];
+    vec3  sum   = vec3(0.0);
+    for (uint i = 0u; i < count; i++) {
+        Light l  = buffers[LIGHTS].lights[buffers[LIGHTS].clusters[base + 1u + i]];
+        vec3  to = l.pos - world;
+        float d2 = dot(to, to), r2 = l.radius * l.radius;
+        if (d2 >= r2) continue;
+        float fall = 1.0 - d2 / r2;
+        sum += l.color * (l.intensity * fall * fall *
+                          max(dot(n, to * inversesqrt(max(d2, 1e-4))), 0.0));
+    }
+    return sum;
+}
+
 void main() {
+    vec3  normal  = normalize(fragNormal);
     vec3  sunDir  = normalize(vec3(0.6, 1.0, 0.4));
-    float diffuse = max(dot(normalize(fragNormal), sunDir), 0.0);
+    float diffuse = max(dot(normal, sunDir), 0.0);
     float light   = clamp(0.2 + diffuse * 0.8, 0.0, 1.0);
 
-    vec3 baseCol = texture(atlas, fragUV).rgb;
-    outColor = vec4(baseCol * light, 1.0);
+    vec3 baseCol = texture(textures[pc.table.z], fragUV).rgb;
+    outColor = vec4(baseCol * (light + pointLights(fragWorld, normal)), 1.0);
 }
@@ -1,18 +1,43 @@
 #version 450
 
-layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec2 inUV;
+layout(location = 0) in vec3  inPos;
+layout(location = 1) in vec3  inNormal;
+layout(location = 2) in vec2  inUV;
+layout(location = 3) in uvec4 inJoints;
+layout(location = 4) in vec4  inWeights;
+
+struct Instance {
+    mat4  model;
+    uvec4 info; // x first joint matrix, y joint count (0 = static)
+};
+// The bindless table's buffers, as each kind; the push constant says which
+const uint MAX_BUFFERS = 32u; // BindlessTable::MAX_BUFFERS
+layout(std430, set = 0, binding = 1) readonly buffer Instances { Instance inst[]; } instances[MAX_BUFFERS];
+layout(std430, set = 0, binding = 1) readonly buffer Joints    { mat4 joints[]; } jointSets[MAX_BUFFERS];
 
 layout(push_constant) uniform PC {
-    mat4 mvp;
+    mat4  viewProj;
+    uvec4 table; // entries: x instances, y joints, z atlas
 } pc;
 
 layout(location = 0) out vec3 fragNormal;
 layout(location = 1) out vec2 fragUV;
+layout(location = 2) out vec3 fragWorld;
 
 void main() {
-    gl_Position = pc.mvp * vec4(inPos, 1.0);
-    fragNormal  = inNormal;
+    Instance I = instances[pc.table.x].inst[gl_InstanceIndex];
+    mat4 m = I.model;
+    if (I.info.y != 0u) {
+        uint b = I.info.x;
+        uint j = pc.table.y;
+        m = m * (inWeights.x * jointSets[j].joints[b + inJoints.x] +
+                 inWeights.y * jointSets[j].joints[b + inJoints.y] +
+                 inWeights.z * jointSets[j].joints[b + inJoints.z] +
+                 inWeights.w * jointSets[j].joints[b + inJoints.w]);
+    }
+    vec4 world  = m * vec4(inPos, 1.0);
+    gl_Position = pc.viewProj * world;
+    fragWorld   = world.xyz;
+    fragNormal  = mat3(m) * inNormal;
     fragUV      = inUV;
 }
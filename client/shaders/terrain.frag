@@ -1,13 +1,184 @@
 #version 450
 
-layout(set = 1, binding = 0) uniform sampler2D atlas;
+// The bindless table's textures. The atlas, at a reserved entry: one layer
+// per BlockMat, full mip chain, repeat addressing
+const uint MAX_TEXTURES = 128u; // BindlessTable::MAX_TEXTURES
+const uint ATLAS        = 0u;   // VkContext::BINDLESS_ATLAS
+layout(set = 0, binding = 0) uniform sampler2DArray textures[MAX_TEXTURES];
+
+// Its buffers: the light grid, at a reserved entry. light_cull.comp's
+// LightGrid, filled for this frame.
+const uint MAX_BUFFERS = 32u;   // BindlessTable::MAX_BUFFERS
+const uint LIGHTS      = 3u;    // VkContext::BINDLESS_LIGHTS
+const uint MAX_LIGHTS  = 1024u; // VkContext::LIGHT_MAX
+const uint CLUSTER_CAP = 32u;   // VkContext::LIGHT_CLUSTER_CAP
+struct Light {
+    vec3  pos;
+    float radius;
+    vec3  color;
+    float intensity;
+};
+layout(std430, set = 0, binding = 1) readonly buffer LightGrid {
+    uvec4 grid;
+    vec4  screen;
+    vec4  eye;
+    vec4  forward;
+    vec4  proj;
+    mat4  view;
+    Light lights[MAX_LIGHTS];
+    uint  clusters[];
+} buffers[MAX_BUFFERS];
+
+// ShadowParams (vk_context.h). A layer per cascade, nearest first: the
+// cached terrain, and the players drawn this frame, at a lower resolution.
+layout(set = 1, binding = 0) uniform ShadowParams {
+    mat4 viewProj[3];
+    vec4 sun;   // towards the sun
+    vec4 texel; // world size of a static texel per cascade
+} shadow;
+layout(set = 1, binding = 1) uniform sampler2DArrayShadow shadowStatic;
+layout(set = 1, binding = 2) uniform sampler2DArrayShadow shadowDynamic;
+
+layout(push_constant) uniform PC {
+    mat4 viewProj;
+    vec4 params; // x: sun intensity
+    vec4 eye;
+    vec4 fog;    // sky colour; w: distance everything has faded into it
+} pc;
+
+// The quality tier (ShaderTier, vk_context.h), fixed when the pipeline is
+// built: every branch on these folds away, so the cheap variant pays for
+// none of what it leaves out. The defaults are Medium.
+layout(constant_id = 0) const bool TRIPLANAR      = false; // three projections blended, not the dominant axis's
+layout(constant_id = 1) const bool MATERIAL_BLEND = false; // layers cross-faded between vertices of different materials
+layout(constant_id = 2) const bool FOG            = true;  // fades into the sky as far.frag does
+layout(constant_id = 3) const int  SHADOW_TAPS    = 4;     // bilinear compares per map: 1, 4 or 9
 
 layout(location = 0) in vec3  fragNormal;
 layout(location = 1) in float sunIntensity;
 layout(location = 2) in vec2  fragUV;
+layout(location = 3) flat in uint fragLayer;
+layout(location = 4) in vec3  fragWorld;
+layout(location = 5) in vec4  fragMatW; // per layer, one-hot at each vertex
+layout(location = 6) in float fragOcclusion;
 
 layout(location = 0) out vec4 outColor;
 
+const int   CASCADES  = 3;    // Config::SHADOW_CASCADES
+const uint  MAT_COUNT = 4u;   // ATLAS_MAT_COUNT
+const float UV_SCALE  = 0.25; // terrainUV's, in terrain.vert
+
+float pcf(sampler2DArrayShadow map, vec3 uvz, float layer) {
+    if (SHADOW_TAPS <= 1) return texture(map, vec4(uvz.xy, layer, uvz.z));
+    vec2 texel = 1.0 / vec2(textureSize(map, 0).xy);
+    float sum = 0.0;
+    if (SHADOW_TAPS < 9) {
+        // Four a texel apart
+        vec2 d = 0.5 * texel;
+        for (int i = 0; i < 4; i++) {
+            vec2 o = vec2((i & 1) == 0 ? -d.x : d.x, (i & 2) == 0 ? -d.y : d.y);
+            sum += texture(map, vec4(uvz.xy + o, layer, uvz.z));
+        }
+        return sum * 0.25;
+    }
+    // A 3x3 grid a texel apart, softer edges for twice the fetches
+    for (int y = -1; y <= 1; y++)
+        for (int x = -1; x <= 1; x++)
+            sum += texture(map, vec4(uvz.xy + vec2(x, y) * texel, layer, uvz.z));
+    return sum * (1.0 / 9.0);
+}
+
+// 1 lit, 0 in shadow. The first cascade the point is well inside; pushed
+// out along the normal by a texel or so against acne.
+float sunShadow(vec3 n) {
+    for (int c = 0; c < CASCADES; c++) {
+        vec3 p    = fragWorld + n * (shadow.texel[c] * 1.5);
+        vec4 clip = shadow.viewProj[c] * vec4(p, 1.0);
+        if (any(greaterThan(abs(clip.xy), vec2(0.98))) || clip.z < 0.0 || clip.z > 1.0)
+            continue;
+        vec3 uvz = vec3(clip.xy * 0.5 + 0.5, clip.z);
+        return min(pcf(shadowStatic, uvz, float(c)), pcf(shadowDynamic, uvz, float(c)));
+    }
+    return 1.0;
+}
+
+// The point lights reaching this pixel's cluster, summed; unshadowed,
+// each fading out smoothly to its radius. As player.frag's.
+vec3 pointLights(vec3 world, vec3 n) {
+    if (buffers[LIGHTS].grid.w == 0u) return vec3(0.0);
+    uvec4 grid  = buffers[LIGHTS].grid;
+    vec4  scr   = buffers[LIGHTS].screen;
+    float depth = dot(world - buffers[LIGHTS].eye.xyz, buffers[LIGHTS].forward.xyz);
+    if (depth > buffers[LIGHTS].proj.w) return vec3(0.0);
+    uvec2 tile  = min(uvec2(gl_FragCoord.xy * scr.xy), grid.xy - 1u);
+    uint  slice = min(uint(max(log(max(depth, 1e-4)) * scr.z + scr.w, 0.0)), grid.z - 1u);
+    uint  base  = (tile.x + grid.x * (tile.y + grid.y * slice)) * CLUSTER_CAP;
+    uint  count = buffers[LIGHTS].clusters[base];
+    vec3  sum   = vec3(0.0);
+    for (uint i = 0u; i < count; i++) {
+        Light l  = buffers[LIGHTS].lights[buffers[LIGHTS].clusters[base + 1u + i]];
+        vec3  to = l.pos - world;
+        float d2 = dot(to, to), r2 = l.radius * l.radius;
+        if (d2 >= r2) continue;
+        float fall = 1.0 - d2 / r2;
+        sum += l.color * (l.intensity * fall * fall *
+                          max(dot(n, to * inversesqrt(max(d2, 1e-4))), 0.0));
+    }
+    return sum;
+}
+
+// Gradients are taken up front: the layer loop below is non-uniform across
+// a quad, and implicit ones wouldn't be defined in it
+struct Grads {
+    vec2 uv[3];
+    vec2 dx[3];
+    vec2 dy[3];
+};
+
+Grads projections() {
+    Grads g;
+    if (TRIPLANAR) {
+        vec3 p = fragWorld * UV_SCALE;
+        g.uv[0] = p.zy;
+        g.uv[1] = p.xz;
+        g.uv[2] = p.xy;
+    } else {
+        g.uv[0] = g.uv[1] = g.uv[2] = fragUV;
+    }
+    for (int i = 0; i < 3; i++) {
+        g.dx[i] = dFdx(g.uv[i]);
+        g.dy[i] = dFdy(g.uv[i]);
+    }
+    return g;
+}
+
+vec3 sampleLayer(Grads g, vec3 w, float layer) {
+    if (!TRIPLANAR)
+        return textureGrad(textures[ATLAS], vec3(g.uv[0], layer), g.dx[0], g.dy[0]).rgb;
+    vec3 c = vec3(0.0);
+    for (int i = 0; i < 3; i++)
+        c += textureGrad(textures[ATLAS], vec3(g.uv[i], layer), g.dx[i], g.dy[i]).rgb * w[i];
+    return c;
+}
+
+vec3 albedo(vec3 normal) {
+    Grads g = projections();
+    vec3  w = pow(abs(normal), vec3(4.0));
+    w /= w.x + w.y + w.z;
+    if (!MATERIAL_BLEND) return sampleLayer(g, w, float(fragLayer));
+    // A triangle of one material takes one layer's fetches; only the
+    // strips between materials take more
+    vec3  c     = vec3(0.0);
+    float total = 0.0;
+    for (uint m = 0u; m < MAT_COUNT; m++) {
+        float k = fragMatW[m];
+        if (k < 0.02) continue;
+        c     += sampleLayer(g, w, float(m)) * k;
+        total += k;
+    }
+    return total > 0.0 ? c / total : sampleLayer(g, w, float(fragLayer));
+}
+
 void main() {
     vec3 an = abs(fragNormal);
     vec3 n;
@@ -15,11 +186,21 @@ void main() {
     else if (an.y > an.x && an.y > an.z) n = vec3(0, sign(fragNormal.y), 0);
     else                                  n = vec3(0, 0, sign(fragNormal.z));
 
-    vec3  sunDir  = normalize(vec3(0.6, 1.0, 0.4));
+    vec3  sunDir  = shadow.sun.xyz;
     float diffuse = max(dot(n, sunDir), 0.0) * sunIntensity;
-    float ambient = mix(0.05, 0.2, sunIntensity);
-    float light   = clamp(ambient + diffuse, 0.0, 1.0);
+    if (diffuse > 0.0) diffuse *= sunShadow(normalize(fragNormal));
+    // Baked on the meshing worker: the ambient is all occluded, direct
+    // light half, so creases still read in full sun
+    float ao      = 1.0 - fragOcclusion;
+    float direct  = mix(1.0, ao, 0.5);
+    float ambient = mix(0.05, 0.2, sunIntensity) * ao;
+    float light   = clamp(ambient + diffuse * direct, 0.0, 1.0);
 
-    vec3 baseCol = texture(atlas, fragUV).rgb;
-    outColor = vec4(baseCol * light, 1.0);
+    vec3 normal = normalize(fragNormal);
+    vec3 color  = albedo(normal) * (light + pointLights(fragWorld, normal) * direct);
+    if (FOG) {
+        float fade = smoothstep(pc.fog.w * 0.35, pc.fog.w, distance(fragWorld, pc.eye.xyz));
+        color = mix(color, pc.fog.rgb, fade);
+    }
+    outColor = vec4(color, 1.0);
 }
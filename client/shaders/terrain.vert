@@ -1,17 +1,32 @@
 #version 450
 
-layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec2 inUV;
+// TerrainVertex (terrain_vertex.h): chunk-local position x:11 y:11 z:10,
+// octahedral normal in the low 16 bits of the second word, material above,
+// baked ambient occlusion in the top 8
+layout(location = 0) in uint inPos;
+layout(location = 1) in uint inNormMat;
 
-struct ChunkData {
-    mat4 model;
-    vec4 params;
-};
-layout(set = 0, binding = 0) readonly buffer ChunkBuffer {
-    ChunkData chunks[];
+// Persistent per-chunk data, written once at upload; the draw's
+// firstInstance is the chunk's slot
+struct ChunkSlot {
+    vec4  boundsMin;
+    vec4  boundsMax;
+    ivec4 origin;
+    uint  indexCount;
+    uint  firstIndex;
+    int   vertexOffset;
+    uint  meshletFirst;
+    uint  meshletCount;
+    uint  pad0, pad1, pad2;
 };
+// The bindless table's buffers; the slots are at a reserved entry
+const uint MAX_BUFFERS = 32u; // BindlessTable::MAX_BUFFERS
+const uint CHUNK_SLOTS = 0u;  // VkContext::BINDLESS_CHUNK_SLOTS
+layout(set = 0, binding = 1) readonly buffer SlotBuffer {
+    ChunkSlot slots[];
+} buffers[MAX_BUFFERS];
 
+// terrain.frag's, which goes on past params
 layout(push_constant) uniform PC {
     mat4 viewProj;
     vec4 params;
@@ -20,11 +35,64 @@ layout(push_constant) uniform PC {
 layout(location = 0) out vec3  fragNormal;
 layout(location = 1) out float sunIntensity;
 layout(location = 2) out vec2  fragUV;
+layout(location = 3) flat out uint fragLayer;
+layout(location = 4) out vec3  fragWorld; // for the shadow lookup, fog and triplanar
+layout(location = 5) out vec4  fragMatW;  // for material blending
+layout(location = 6) out float fragOcclusion; // 0 open, 1 shut
+
+// The depth pre-pass runs this without terrain.frag; both must land on the
+// same depth for the colour pass's less-or-equal test to pass
+invariant gl_Position;
+
+#ifndef AETHERIS_CHUNK_SIZE
+#define AETHERIS_CHUNK_SIZE 32 // ChunkData::SIZE; the build passes it
+#endif
+const float CHUNK_SIZE = float(AETHERIS_CHUNK_SIZE);
+const uint  MAT_COUNT  = 4u; // ATLAS_MAT_COUNT, atlas layers; past it, stone
+
+vec3 octDecode(uint n) {
+    vec2 f = vec2(float((n >> 8) & 0xFFu), float(n & 0xFFu)) / 255.0 * 2.0 - 1.0;
+    vec3 v = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    if (v.z < 0.0)
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0,
+                                        v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
+
+// Same mapping as terrainUV() in marching_cubes.h; unwrapped, the sampler
+// repeats
+vec2 terrainUV(vec3 p, vec3 n) {
+    const float SCALE = 0.25;
+    const float TIE = 0.05;
+
+    vec3 an = abs(n);
+    vec2 local;
+    if (an.x > an.y + TIE && an.x > an.z + TIE)
+        local = p.zy;
+    else if (an.y > an.z + TIE)
+        local = p.xz;
+    else
+        local = p.xy;
+    return abs(local) * SCALE;
+}
 
 void main() {
-    ChunkData cd = chunks[gl_InstanceIndex];
-    gl_Position  = pc.viewProj * cd.model * vec4(inPos, 1.0);
-    fragNormal   = normalize(mat3(cd.model) * inNormal);
-    sunIntensity = cd.params.x;
-    fragUV       = inUV;
+    // origin.w is the LOD level: a LOD cell's positions are in its own
+    // cells, 1 << w blocks each
+    vec3 local = vec3(float(inPos & 0x7FFu), float((inPos >> 11) & 0x7FFu),
+                      float(inPos >> 22)) *
+                 (CHUNK_SIZE / vec3(2047.0, 2047.0, 1023.0)) *
+                 float(1 << buffers[CHUNK_SLOTS].slots[gl_InstanceIndex].origin.w);
+    vec3 normal = octDecode(inNormMat & 0xFFFFu);
+    uint mat    = (inNormMat >> 16) & 0xFFu;
+
+    vec3 origin  = vec3(buffers[CHUNK_SLOTS].slots[gl_InstanceIndex].origin.xyz);
+    fragWorld    = origin + local;
+    gl_Position  = pc.viewProj * vec4(fragWorld, 1.0);
+    fragNormal   = normal;
+    sunIntensity = pc.params.x;
+    fragUV       = terrainUV(local, normal);
+    fragLayer    = mat < MAT_COUNT ? mat : 0u;
+    fragMatW     = vec4(equal(uvec4(fragLayer), uvec4(0u, 1u, 2u, 3u)));
+    fragOcclusion = float(inNormMat >> 24) / 255.0;
 }
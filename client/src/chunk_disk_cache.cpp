@@ -0,0 +1,176 @@
+#include "chunk_disk_cache.h"
+#include "log.h"
+#include "mem_tags.h"
+#include <algorithm>
+
+// ── open / close ──────────────────────────────────────────────────────────────
+
+bool ChunkDiskCache::open(const std::filesystem::path& path, uint32_t world) {
+    namespace fs = std::filesystem;
+    MemTags::Scope tag(MemTags::ChunkCache);
+    std::lock_guard lk(_mu);
+    closeLocked();
+    _path  = path;
+    _world = world;
+
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    _file = fopen(path.string().c_str(), "r+b");
+    Header h{};
+    if (_file && (fread(&h, sizeof(h), 1, _file) != 1 || h.magic != MAGIC ||
+                  h.layoutVersion != LAYOUT_VERSION || h.world != world)) {
+        Log::info("Chunk cache: " + path.string() + " is from another world, starting over");
+        fclose(_file);
+        _file = nullptr;
+    }
+    if (!_file) {
+        _file = fopen(path.string().c_str(), "w+b");
+        Header fresh{MAGIC, LAYOUT_VERSION, world, 0};
+        if (!_file || fwrite(&fresh, sizeof(fresh), 1, _file) != 1) {
+            Log::warn("Chunk cache: cannot write " + path.string());
+            closeLocked();
+            return false;
+        }
+    }
+
+    // The last record for a coord wins; one running past the end of the
+    // file was torn by a crash, and so is everything after it
+    fseek(_file, 0, SEEK_END);
+    uint64_t size = (uint64_t)ftell(_file);
+    uint64_t at   = sizeof(Header);
+    Record   r;
+    while (at + sizeof(Record) <= size) {
+        fseek(_file, (long)at, SEEK_SET);
+        if (fread(&r, sizeof(r), 1, _file) != 1 || r.length == 0 || r.length > MAX_RECORD ||
+            at + sizeof(Record) + r.length > size)
+            break;
+        Entry& e = _index[{r.x, r.y, r.z}];
+        if (e.length) _live -= sizeof(Record) + e.length;
+        e = {at + sizeof(Record), r.length, r.hash};
+        _live += sizeof(Record) + r.length;
+        at    += sizeof(Record) + r.length;
+    }
+    _end = at;
+
+    uint64_t records = _end - sizeof(Header);
+    if (_end != size || _live > MAX_BYTES || records - _live > _live)
+        compactLocked();
+    if (!_file) return false;
+    Log::info("Chunk cache: " + std::to_string(_index.size()) + " chunks, " +
+              std::to_string(_live >> 20) + " MiB");
+    return true;
+}
+
+void ChunkDiskCache::close() {
+    std::lock_guard lk(_mu);
+    closeLocked();
+}
+
+void ChunkDiskCache::closeLocked() {
+    if (_file) fclose(_file);
+    _file = nullptr;
+    _end = _live = 0;
+    _index.clear();
+}
+
+// Live records, in the order they were written, into a fresh file renamed
+// over the old one; the oldest are left out while the rest would come to
+// more than MAX_BYTES. Any failure leaves the old file in use.
+bool ChunkDiskCache::compactLocked() {
+    namespace fs = std::filesystem;
+    std::vector<std::pair<ChunkCoord, Entry>> live(_index.begin(), _index.end());
+    std::sort(live.begin(), live.end(),
+              [](const auto& a, const auto& b) { return a.second.offset < b.second.offset; });
+    size_t   first = 0;
+    uint64_t kept  = _live;
+    while (kept > MAX_BYTES && first < live.size())
+        kept -= sizeof(Record) + live[first++].second.length;
+
+    std::error_code ec;
+    fs::path tmp = _path;
+    tmp += ".tmp";
+    FILE* out = fopen(tmp.string().c_str(), "w+b");
+    if (!out) return false;
+
+    Header h{MAGIC, LAYOUT_VERSION, _world, 0};
+    bool ok = fwrite(&h, sizeof(h), 1, out) == 1;
+    std::unordered_map<ChunkCoord, Entry, ChunkCoordHash> index;
+    uint64_t at = sizeof(Header), liveBytes = 0;
+    std::vector<uint8_t> buf;
+    for (size_t i = first; i < live.size() && ok; i++) {
+        const auto& [c, e] = live[i];
+        buf.resize(e.length);
+        fseek(_file, (long)e.offset, SEEK_SET);
+        if (fread(buf.data(), 1, buf.size(), _file) != buf.size()) continue;
+        Record r{c.x, c.y, c.z, e.length, e.hash};
+        ok = fwrite(&r, sizeof(r), 1, out) == 1 && fwrite(buf.data(), 1, buf.size(), out) == buf.size();
+        index[c] = {at + sizeof(Record), e.length, e.hash};
+        at        += sizeof(Record) + e.length;
+        liveBytes += sizeof(Record) + e.length;
+    }
+    ok = fflush(out) == 0 && ok;
+    fclose(out);
+    if (ok) {
+        fclose(_file);
+        fs::rename(tmp, _path, ec);
+        _file = fopen(_path.string().c_str(), "r+b");
+        if (!_file) {
+            Log::warn("Chunk cache: cannot reopen " + _path.string());
+            closeLocked();
+            return false;
+        }
+        if (!ec) {
+            _index.swap(index);
+            _end  = at;
+            _live = liveBytes;
+            return true;
+        }
+    }
+    Log::warn("Chunk cache: compacting " + _path.string() + " failed");
+    fs::remove(tmp, ec);
+    return false;
+}
+
+// ── store / load ──────────────────────────────────────────────────────────────
+
+void ChunkDiskCache::store(const ChunkCoord& c, const uint8_t* data, size_t len) {
+    if (len == 0 || len > MAX_RECORD) return;
+    uint64_t hash = payloadHash(data, len);
+    MemTags::Scope tag(MemTags::ChunkCache);
+    std::lock_guard lk(_mu);
+    if (!_file) return;
+    auto it = _index.find(c);
+    if (it != _index.end() && it->second.hash == hash) return;
+    if (_end + sizeof(Record) + len > 2 * MAX_BYTES) return;
+
+    Record r{c.x, c.y, c.z, (uint32_t)len, hash};
+    if (fseek(_file, (long)_end, SEEK_SET) != 0 || fwrite(&r, sizeof(r), 1, _file) != 1 ||
+        fwrite(data, 1, len, _file) != len) {
+        Log::warn("Chunk cache: write failed, closing " + _path.string());
+        closeLocked();
+        return;
+    }
+    Entry& e = _index[c];
+    if (e.length) _live -= sizeof(Record) + e.length;
+    e = {_end + sizeof(Record), (uint32_t)len, hash};
+    _live += sizeof(Record) + len;
+    _end  += sizeof(Record) + len;
+}
+
+// A record that doesn't read back as stored is forgotten, so it isn't
+// listed again
+bool ChunkDiskCache::load(const ChunkCoord& c, uint64_t hash, std::vector<uint8_t>& out) {
+    std::lock_guard lk(_mu);
+    if (!_file) return false;
+    auto it = _index.find(c);
+    if (it == _index.end() || it->second.hash != hash) return false;
+    out.resize(it->second.length);
+    if (fseek(_file, (long)it->second.offset, SEEK_SET) != 0 ||
+        fread(out.data(), 1, out.size(), _file) != out.size() ||
+        payloadHash(out.data(), out.size()) != hash) {
+        _live -= sizeof(Record) + it->second.length;
+        _index.erase(it);
+        return false;
+    }
+    return true;
+}
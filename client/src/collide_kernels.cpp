@@ -0,0 +1,290 @@
+#include "collide_kernels.h"
+#include <algorithm>
+#include <cmath>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  #include <immintrin.h>
+  #define HAS_AVX2_KERNEL 1
+#endif
+
+namespace Collide {
+
+// ── Scalar reference ──────────────────────────────────────────────────────────
+// The AVX2 kernels test the same axes in the same order, so ties in the SAT
+// depth resolve to the same axis; change both together.
+
+static constexpr float AXIS_EPS2 = 1e-8f; // skip near-zero SAT axes
+static constexpr float RAY_EPS   = 1e-7f;
+
+static float projectAABB(glm::vec3 n, glm::vec3 half) {
+    return std::abs(n.x)*half.x + std::abs(n.y)*half.y + std::abs(n.z)*half.z;
+}
+
+static bool axisTest(glm::vec3 axis, glm::vec3 half,
+                     glm::vec3 a, glm::vec3 b, glm::vec3 c,
+                     float& depth, glm::vec3& mtvAxis) {
+    float len2 = glm::dot(axis, axis);
+    if (len2 < AXIS_EPS2) return true;
+    glm::vec3 n = axis / std::sqrt(len2);
+    float pa = glm::dot(n, a), pb = glm::dot(n, b), pc = glm::dot(n, c);
+    float lo = std::min({pa,pb,pc}), hi = std::max({pa,pb,pc});
+    float r  = projectAABB(n, half);
+    if (lo > r || hi < -r) return false;
+    float overlap = std::min(r - lo, hi + r);
+    if (overlap < depth) { depth = overlap; mtvAxis = n; }
+    return true;
+}
+
+bool boxTri(glm::vec3 mn, glm::vec3 mx, const TriSoA& t, uint32_t i, glm::vec3& outMTV) {
+    glm::vec3 half   = (mx - mn) * 0.5f;
+    glm::vec3 centre = (mn + mx) * 0.5f;
+    // Box-relative corners
+    glm::vec3 a = t.a(i) - centre, b = t.b(i) - centre, c = t.c(i) - centre;
+    glm::vec3 ab = b-a, bc = c-b, ca = a-c;
+    float     depth  = 1e9f;
+    glm::vec3 mtvAxis{0,1,0};
+    glm::vec3 axes[3] = {{1,0,0},{0,1,0},{0,0,1}};
+
+    for (auto& ax : axes)
+        if (!axisTest(ax, half, a, b, c, depth, mtvAxis)) return false;
+    if (!axisTest(glm::cross(ab, c-a), half, a, b, c, depth, mtvAxis)) return false;
+    for (auto& e : {ab, bc, ca})
+        for (auto& ax : axes)
+            if (!axisTest(glm::cross(e, ax), half, a, b, c, depth, mtvAxis)) return false;
+
+    if (glm::dot(mtvAxis, a) > 0) mtvAxis = -mtvAxis;
+    outMTV = mtvAxis * depth;
+    return true;
+}
+
+static int boxTrisScalar(glm::vec3 mn, glm::vec3 mx, const TriSoA& t,
+                         uint8_t* hit, glm::vec3* mtv) {
+    int n = 0;
+    for (uint32_t i = 0; i < t.count; i++) {
+        hit[i] = boxTri(mn, mx, t, i, mtv[i]) ? 1 : 0;
+        n += hit[i];
+    }
+    return n;
+}
+
+static bool rayTri(glm::vec3 orig, glm::vec3 dir, float maxDist, float minNy,
+                   const TriSoA& tri, uint32_t i, float& outT) {
+    glm::vec3 a = tri.a(i);
+    glm::vec3 ab = tri.b(i) - a, ac = tri.c(i) - a;
+    if (ab.z*ac.x - ab.x*ac.z < minNy) return false; // cross(ab, ac).y
+    glm::vec3 h  = glm::cross(dir, ac);
+    float det    = glm::dot(ab, h);
+    if (std::abs(det) < RAY_EPS) return false;
+    float invDet = 1.f / det;
+    glm::vec3 s  = orig - a;
+    float u      = glm::dot(s, h) * invDet;
+    if (u < 0.f || u > 1.f) return false;
+    glm::vec3 q  = glm::cross(s, ab);
+    float v      = glm::dot(dir, q) * invDet;
+    if (v < 0.f || u + v > 1.f) return false;
+    float t      = glm::dot(ac, q) * invDet;
+    if (t < RAY_EPS || t > maxDist) return false;
+    outT = t;
+    return true;
+}
+
+static int rayTrisScalar(glm::vec3 orig, glm::vec3 dir, float maxDist, float minNy,
+                         const TriSoA& t, float& outT) {
+    int best = -1;
+    for (uint32_t i = 0; i < t.count; i++) {
+        float s;
+        if (rayTri(orig, dir, maxDist, minNy, t, i, s) && (best < 0 || s < outT)) {
+            outT = s;
+            best = (int)i;
+        }
+    }
+    return best;
+}
+
+// ── AVX2, 8 triangles per iteration ───────────────────────────────────────────
+
+#if defined(HAS_AVX2_KERNEL)
+
+#define AVX2_FN __attribute__((target("avx2")))
+
+struct V3 { __m256 x, y, z; };
+
+AVX2_FN static inline __m256 add8(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+AVX2_FN static inline __m256 sub8(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+AVX2_FN static inline __m256 mul8(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+AVX2_FN static inline __m256 abs8(__m256 a) {
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a);
+}
+AVX2_FN static inline V3 sub3(V3 a, V3 b) { return {sub8(a.x, b.x), sub8(a.y, b.y), sub8(a.z, b.z)}; }
+AVX2_FN static inline __m256 dot3(V3 a, V3 b) {
+    return add8(add8(mul8(a.x, b.x), mul8(a.y, b.y)), mul8(a.z, b.z));
+}
+AVX2_FN static inline V3 cross3(V3 a, V3 b) {
+    return {sub8(mul8(a.y, b.z), mul8(a.z, b.y)),
+            sub8(mul8(a.z, b.x), mul8(a.x, b.z)),
+            sub8(mul8(a.x, b.y), mul8(a.y, b.x))};
+}
+AVX2_FN static inline V3 load3(const std::vector<float>& x, const std::vector<float>& y,
+                               const std::vector<float>& z, uint32_t i) {
+    return {_mm256_loadu_ps(&x[i]), _mm256_loadu_ps(&y[i]), _mm256_loadu_ps(&z[i])};
+}
+// All-ones in lanes i..i+7 that are < count
+AVX2_FN static inline __m256 laneMask(uint32_t i, uint32_t count) {
+    __m256i idx = _mm256_add_epi32(_mm256_set1_epi32((int)i), _mm256_setr_epi32(0,1,2,3,4,5,6,7));
+    return _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32((int)count), idx));
+}
+
+// The SAT state of 8 box/triangle pairs
+struct Sat8 {
+    V3     a, b, c, half;
+    __m256 alive;     // not yet separated
+    __m256 depth;
+    V3     axis;
+
+    AVX2_FN void test(V3 ax) {
+        __m256 len2 = dot3(ax, ax);
+        __m256 skip = _mm256_cmp_ps(len2, _mm256_set1_ps(AXIS_EPS2), _CMP_LT_OQ);
+        __m256 inv  = _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_sqrt_ps(len2));
+        V3 n{mul8(ax.x, inv), mul8(ax.y, inv), mul8(ax.z, inv)};
+        __m256 pa = dot3(n, a), pb = dot3(n, b), pc = dot3(n, c);
+        __m256 lo = _mm256_min_ps(_mm256_min_ps(pa, pb), pc);
+        __m256 hi = _mm256_max_ps(_mm256_max_ps(pa, pb), pc);
+        __m256 r  = add8(add8(mul8(abs8(n.x), half.x), mul8(abs8(n.y), half.y)),
+                         mul8(abs8(n.z), half.z));
+        __m256 sep = _mm256_or_ps(_mm256_cmp_ps(lo, r, _CMP_GT_OQ),
+                                  _mm256_cmp_ps(hi, sub8(_mm256_setzero_ps(), r), _CMP_LT_OQ));
+        alive = _mm256_andnot_ps(_mm256_andnot_ps(skip, sep), alive);
+        __m256 overlap = _mm256_min_ps(sub8(r, lo), add8(hi, r));
+        __m256 better  = _mm256_andnot_ps(skip, _mm256_cmp_ps(overlap, depth, _CMP_LT_OQ));
+        depth  = _mm256_blendv_ps(depth, overlap, better);
+        axis.x = _mm256_blendv_ps(axis.x, n.x, better);
+        axis.y = _mm256_blendv_ps(axis.y, n.y, better);
+        axis.z = _mm256_blendv_ps(axis.z, n.z, better);
+    }
+    AVX2_FN bool anyAlive() const { return _mm256_movemask_ps(alive) != 0; }
+};
+
+AVX2_FN static int boxTrisAVX2(glm::vec3 mn, glm::vec3 mx, const TriSoA& t,
+                               uint8_t* hit, glm::vec3* mtv) {
+    glm::vec3 h = (mx - mn) * 0.5f, cen = (mn + mx) * 0.5f;
+    V3 centre{_mm256_set1_ps(cen.x), _mm256_set1_ps(cen.y), _mm256_set1_ps(cen.z)};
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f);
+    int hits = 0;
+    uint32_t i = 0;
+    for (; i < t.count; i += TriSoA::WIDTH) {
+        Sat8 s;
+        s.a     = sub3(load3(t.ax, t.ay, t.az, i), centre);
+        s.b     = sub3(load3(t.bx, t.by, t.bz, i), centre);
+        s.c     = sub3(load3(t.cx, t.cy, t.cz, i), centre);
+        s.half  = {_mm256_set1_ps(h.x), _mm256_set1_ps(h.y), _mm256_set1_ps(h.z)};
+        s.alive = laneMask(i, t.count);
+        s.depth = _mm256_set1_ps(1e9f);
+        s.axis  = {zero, one, zero};
+        V3 ab = sub3(s.b, s.a), bc = sub3(s.c, s.b), ca = sub3(s.a, s.c);
+
+        s.test({one, zero, zero});
+        s.test({zero, one, zero});
+        s.test({zero, zero, one});
+        if (s.anyAlive()) s.test(cross3(ab, sub3(s.c, s.a)));
+        // cross(e, X) = (0, e.z, -e.y), cross(e, Y) = (-e.z, 0, e.x), cross(e, Z) = (e.y, -e.x, 0)
+        for (const V3& e : {ab, bc, ca}) {
+            if (!s.anyAlive()) break;
+            s.test({zero, e.z, sub8(zero, e.y)});
+            s.test({sub8(zero, e.z), zero, e.x});
+            s.test({e.y, sub8(zero, e.x), zero});
+        }
+
+        int mask = _mm256_movemask_ps(s.alive);
+        uint32_t lanes = std::min(TriSoA::WIDTH, t.count - i);
+        if (!mask) { std::fill(hit + i, hit + i + lanes, uint8_t(0)); continue; }
+
+        // Point the axis away from the triangle, then scale by depth
+        __m256 flip = _mm256_cmp_ps(dot3(s.axis, s.a), zero, _CMP_GT_OQ);
+        __m256 sign = _mm256_blendv_ps(one, _mm256_set1_ps(-1.f), flip);
+        __m256 d    = mul8(s.depth, sign);
+        alignas(32) float mx8[8], my8[8], mz8[8];
+        _mm256_store_ps(mx8, mul8(s.axis.x, d));
+        _mm256_store_ps(my8, mul8(s.axis.y, d));
+        _mm256_store_ps(mz8, mul8(s.axis.z, d));
+        for (uint32_t l = 0; l < lanes; l++) {
+            hit[i + l] = (mask >> l) & 1;
+            if (hit[i + l]) { mtv[i + l] = {mx8[l], my8[l], mz8[l]}; hits++; }
+        }
+    }
+    return hits;
+}
+
+AVX2_FN static int rayTrisAVX2(glm::vec3 o, glm::vec3 d, float maxDist, float minNy,
+                               const TriSoA& t, float& outT) {
+    V3 orig{_mm256_set1_ps(o.x), _mm256_set1_ps(o.y), _mm256_set1_ps(o.z)};
+    V3 dir {_mm256_set1_ps(d.x), _mm256_set1_ps(d.y), _mm256_set1_ps(d.z)};
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f);
+    const __m256 eps  = _mm256_set1_ps(RAY_EPS);
+    int best = -1;
+    for (uint32_t i = 0; i < t.count; i += TriSoA::WIDTH) {
+        V3 a  = load3(t.ax, t.ay, t.az, i);
+        V3 ab = sub3(load3(t.bx, t.by, t.bz, i), a);
+        V3 ac = sub3(load3(t.cx, t.cy, t.cz, i), a);
+        __m256 ok = laneMask(i, t.count);
+        __m256 ny = sub8(mul8(ab.z, ac.x), mul8(ab.x, ac.z));
+        ok = _mm256_and_ps(ok, _mm256_cmp_ps(ny, _mm256_set1_ps(minNy), _CMP_GE_OQ));
+
+        V3 h = cross3(dir, ac);
+        __m256 det = dot3(ab, h);
+        ok = _mm256_and_ps(ok, _mm256_cmp_ps(abs8(det), eps, _CMP_GE_OQ));
+        __m256 inv = _mm256_div_ps(one, det);
+        V3 s = sub3(orig, a);
+        __m256 u = mul8(dot3(s, h), inv);
+        ok = _mm256_and_ps(ok, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ),
+                                             _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+        V3 q = cross3(s, ab);
+        __m256 v = mul8(dot3(dir, q), inv);
+        ok = _mm256_and_ps(ok, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ),
+                                             _mm256_cmp_ps(add8(u, v), one, _CMP_LE_OQ)));
+        __m256 tt = mul8(dot3(ac, q), inv);
+        ok = _mm256_and_ps(ok, _mm256_and_ps(_mm256_cmp_ps(tt, eps, _CMP_GE_OQ),
+                                             _mm256_cmp_ps(tt, _mm256_set1_ps(maxDist), _CMP_LE_OQ)));
+
+        int mask = _mm256_movemask_ps(ok);
+        if (!mask) continue;
+        alignas(32) float t8[8];
+        _mm256_store_ps(t8, tt);
+        for (int l = 0; l < 8; l++)
+            if ((mask >> l) & 1 && (best < 0 || t8[l] < outT)) { outT = t8[l]; best = (int)i + l; }
+    }
+    return best;
+}
+
+#endif // HAS_AVX2_KERNEL
+
+// ── Dispatch ──────────────────────────────────────────────────────────────────
+
+using BoxFn = int(*)(glm::vec3, glm::vec3, const TriSoA&, uint8_t*, glm::vec3*);
+using RayFn = int(*)(glm::vec3, glm::vec3, float, float, const TriSoA&, float&);
+
+struct Kernel { BoxFn box; RayFn ray; const char* name; };
+
+static Kernel pickKernel() {
+#if defined(HAS_AVX2_KERNEL)
+    if (__builtin_cpu_supports("avx2")) return {boxTrisAVX2, rayTrisAVX2, "avx2"};
+#endif
+    return {boxTrisScalar, rayTrisScalar, "scalar"};
+}
+
+static const Kernel& kernel() {
+    static const Kernel k = pickKernel();
+    return k;
+}
+
+int boxTris(glm::vec3 mn, glm::vec3 mx, const TriSoA& t, uint8_t* hit, glm::vec3* mtv) {
+    return kernel().box(mn, mx, t, hit, mtv);
+}
+
+int rayTris(glm::vec3 orig, glm::vec3 dir, float maxDist, float minNy,
+            const TriSoA& t, float& outT) {
+    return kernel().ray(orig, dir, maxDist, minNy, t, outT);
+}
+
+const char* kernelName() { return kernel().name; }
+
+} // namespace Collide
@@ -0,0 +1,121 @@
+#include "far_terrain.h"
+#include "noise_gen.h"
+#include "packets.h"
+#include <cmath>
+
+namespace {
+
+// Boxes as hole() gives them: lo in xy, hi in zw
+bool contains(const glm::vec4& outer, const glm::vec4& inner) {
+    return outer.x <= inner.x && outer.y <= inner.y && outer.z >= inner.z && outer.w >= inner.w;
+}
+
+} // namespace
+
+// ── update ────────────────────────────────────────────────────────────────────
+
+void FarTerrain::update(glm::vec3 eye, glm::vec2 chunkLo, glm::vec2 chunkHi) {
+    for (int l = 0; l < LEVELS; l++) {
+        {
+            std::lock_guard lk(_mu);
+            if (_hasBuilt[l]) {
+                Level& lv = _levels[l];
+                lv.verts.swap(_built[l].verts);
+                lv.lo = _built[l].lo;
+                lv.hi = _built[l].hi;
+                lv.version++;
+                _hasBuilt[l] = false;
+                _busy[l]     = false;
+            }
+        }
+
+        float      snap = 2.f * spacing(l);
+        glm::ivec2 step((int)std::floor(eye.x / snap + 0.5f), (int)std::floor(eye.z / snap + 0.5f));
+        if (_busy[l] || (_queued[l] && step == _step[l])) continue;
+        _busy[l]   = true;
+        _queued[l] = true;
+        _step[l]   = step;
+        _pool.submit([this, l, step] {
+            Level built;
+            build(l, step, built);
+            std::lock_guard lk(_mu);
+            _built[l]    = std::move(built);
+            _hasBuilt[l] = true;
+        }, ThreadPool::Priority::Background);
+    }
+
+    // Where the level inside is drawn, or what it leaves to finer geometry
+    // in turn — whichever box holds the other, and their overlap when
+    // neither does, which only draws a little twice
+    _holes[0] = glm::vec4(chunkLo, chunkHi);
+    for (int l = 1; l < LEVELS; l++) {
+        glm::vec4    h  = _holes[l - 1];
+        const Level& in = _levels[l - 1];
+        if (in.version > 0) {
+            float     inset = spacing(l - 1);
+            glm::vec4 drawn(in.lo + inset, in.hi - inset);
+            if (contains(drawn, h))
+                h = drawn;
+            else if (!contains(h, drawn))
+                h = glm::vec4(glm::max(glm::vec2(h), glm::vec2(drawn)),
+                              glm::min(glm::vec2(h.z, h.w), glm::vec2(drawn.z, drawn.w)));
+        }
+        _holes[l] = h;
+    }
+}
+
+bool FarTerrain::visible(int l) const {
+    const Level& lv = _levels[l];
+    return lv.version > 0 && !contains(_holes[l], glm::vec4(lv.lo, lv.hi));
+}
+
+// ── Geometry ──────────────────────────────────────────────────────────────────
+
+// Heights on a ring one vertex past the grid, so edge normals take central
+// differences like the rest
+void FarTerrain::build(int l, glm::ivec2 step, Level& out) {
+    constexpr int B = GRID + 3;
+    const float   s = spacing(l);
+    glm::vec2 center = glm::vec2(step) * 2.f * s;
+    out.lo = center - (float)(GRID / 2) * s;
+    out.hi = center + (float)(GRID / 2) * s;
+
+    static thread_local std::vector<float> wx, wz, h;
+    wx.resize(B * B);
+    wz.resize(B * B);
+    h.resize(B * B);
+    for (int j = 0; j < B; j++)
+    for (int i = 0; i < B; i++) {
+        wx[j * B + i] = out.lo.x + (float)(i - 1) * s;
+        wz[j * B + i] = out.lo.y + (float)(j - 1) * s;
+    }
+    surfaceHeights(wx.data(), wz.data(), h.data(), B * B);
+
+    auto at = [&](int i, int j) { return h[(j + 1) * B + i + 1]; };
+    out.verts.resize(VERTS);
+    for (int j = 0; j <= GRID; j++)
+    for (int i = 0; i <= GRID; i++) {
+        float     y = at(i, j);
+        glm::vec3 n = glm::normalize(glm::vec3(at(i - 1, j) - at(i + 1, j), 2.f * s,
+                                               at(i, j - 1) - at(i, j + 1)));
+        auto mat = (uint32_t)surfaceMaterial(y, n.y);
+        out.verts[j * (GRID + 1) + i] = {{out.lo.x + (float)i * s, y, out.lo.y + (float)j * s},
+                                         ChunkDataPacket::octEncode(n) | mat << 16};
+    }
+}
+
+// Wound like the marched mesh: a triangle (a, b, c) faces along
+// (c - a) x (b - a), here +y
+std::vector<uint16_t> FarTerrain::indices() {
+    std::vector<uint16_t> out;
+    out.reserve(INDICES);
+    for (int j = 0; j < GRID; j++)
+    for (int i = 0; i < GRID; i++) {
+        auto v00 = (uint16_t)(j * (GRID + 1) + i);
+        auto v10 = (uint16_t)(v00 + 1);
+        auto v01 = (uint16_t)(v00 + GRID + 1);
+        auto v11 = (uint16_t)(v01 + 1);
+        out.insert(out.end(), {v00, v10, v01, v10, v11, v01});
+    }
+    return out;
+}
@@ -10,8 +10,7 @@ static GLFWcursorposfun s_prevCursorCallback = nullptr;
 
 Input::Input(GLFWwindow* window) : _win(window) {
     _instance = this;
-    std::memset(_keys,     0, sizeof(_keys));
-    std::memset(_prevKeys, 0, sizeof(_prevKeys));
+    std::memset(_live, 0, sizeof(_live));
 
     // Save ImGui's callbacks before overwriting (set by ImGui_ImplGlfw_Init)
     s_prevKeyCallback    = glfwSetKeyCallback(window, keyCallback);
@@ -21,9 +20,18 @@ Input::Input(GLFWwindow* window) : _win(window) {
 }
 
 void Input::beginFrame() {
-    std::memcpy(_prevKeys, _keys, sizeof(_keys));
-    _delta = {};
     glfwPollEvents();
+    for (int k = 0; k <= GLFW_KEY_LAST; k++) _state.down[k] = _live[k] && !_state.keys[k];
+    std::memcpy(_state.keys, _live, sizeof(_live));
+    _delta   = _pending;
+    _pending = {};
+}
+
+glm::vec2 Input::latchMouse() {
+    glfwPollEvents();
+    glm::vec2 d = _pending;
+    _pending = {};
+    return d;
 }
 
 void Input::captureCursor(bool capture) {
@@ -39,8 +47,8 @@ void Input::keyCallback(GLFWwindow* w, int key, int scancode, int action, int mo
         s_prevKeyCallback(w, key, scancode, action, mods);
 
     if (!_instance || key < 0 || key > GLFW_KEY_LAST) return;
-    if (action == GLFW_PRESS)   _instance->_keys[key] = true;
-    if (action == GLFW_RELEASE) _instance->_keys[key] = false;
+    if (action == GLFW_PRESS)   _instance->_live[key] = true;
+    if (action == GLFW_RELEASE) _instance->_live[key] = false;
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         _instance->captureCursor(!_instance->_captured);
 }
@@ -58,6 +66,6 @@ void Input::cursorCallback(GLFWwindow* w, double x, double y) {
         return;
     }
     if (_instance->_captured)
-        _instance->_delta += pos - _instance->_lastPos;
+        _instance->_pending += pos - _instance->_lastPos;
     _instance->_lastPos = pos;
 }
@@ -1,8 +1,12 @@
 #include "../include/combat_system.h"
 #include "asset_path.h"
 #include "camera.h"
+#include "chunk_codec.h"
+#include "chunk_disk_cache.h"
 #include "config.h"
 #include "day_night.h"
+#include "far_terrain.h"
+#include "frame_limiter.h"
 #include "gltf_loader.h"
 #include "hud.h"
 #include "input.h"
@@ -13,20 +17,37 @@
 #include "mesh_builder.h"
 #include "mp_packets.h"
 #include "net_common.h"
+#include "net_thread.h"
+#include "packet_dispatch.h"
 #include "packets.h"
+#include "pipeline_cache.h"
 #include "player.h"
 #include "player_stats.h"
 #include "remote_players.h"
+#include "render_bench.h"
+#include "render_capture.h"
+#include "replication.h"
+#include "sim_thread.h"
+#include "system_scheduler.h"
+#include "thread_pool.h"
+#include "trace.h"
 #include "view_model.h"
 #include "vk_context.h"
 #include "window.h"
+#include <algorithm>
+#include <cctype>
 #include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <enet/enet.h>
 #include <entt/entt.hpp>
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_vulkan.h>
 #include "main_menu.h"
+#include "local_server.h"
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -36,17 +57,60 @@ int main(int argc, char **argv) {
   Log::init("aetheris_client.log");
   Log::installCrashHandlers();
   Log::info("Client starting");
+  // --trace <file>: chunk pipeline spans, to line up with the server's
+  // --gpu-mesh: march full-resolution chunks in compute shaders
+  // --record-render <file>: the chunk stream and camera, for --bench
+  // --bench <file> [--bench-out <json>] [--bench-size WxH]
+  //   [--bench-shaders 0|1|2] [--bench-lights N]: replay one offscreen and
+  //   report frame times (render_bench.h), at the given ShaderTier, with N
+  //   point lights round the eye
+  bool gpuMesh = false;
+  RenderBenchOptions bench;
+  RenderCapture::Writer renderRec;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--trace" && i + 1 < argc)
+      Trace::start(argv[++i], 2, "client");
+    else if (arg == "--gpu-mesh")
+      gpuMesh = true;
+    else if (arg == "--record-render" && i + 1 < argc)
+      renderRec.open(argv[++i]);
+    else if (arg == "--bench" && i + 1 < argc)
+      bench.capture = argv[++i];
+    else if (arg == "--bench-out" && i + 1 < argc)
+      bench.out = argv[++i];
+    else if (arg == "--bench-size" && i + 1 < argc)
+      sscanf(argv[++i], "%ux%u", &bench.width, &bench.height);
+    else if (arg == "--bench-shaders" && i + 1 < argc)
+      bench.shaderTier = std::clamp(std::atoi(argv[++i]), 0, 2);
+    else if (arg == "--bench-lights" && i + 1 < argc)
+      bench.lights = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+  }
+  if (!bench.capture.empty()) {
+    bench.gpuMesh = gpuMesh;
+    int code = bench.width && bench.height ? runRenderBench(bench) : 1;
+    Trace::stop();
+    Log::shutdown();
+    return code;
+  }
 
   Window window(1280, 720, "Aetheris");
-  VkContext ctx = vk_init(window.handle());
+  VkContext ctx = vk_init(window.handle(), gpuMesh);
   vk_load_atlas(ctx, AssetPath::get("atlas.png").c_str());
   Input input(window.handle());
-  Camera camera;
+  Camera camera;    // drawn from, turned by the mouse every frame
+  Camera simCamera; // the player's, placed at its eye each sim tick
   entt::registry reg;
-  PlayerController player(reg, camera);
+  PlayerController player(reg, simCamera);
   CombatSystem combat(reg);
+  ParticleRing combatFx; // combat's bursts, drained into vk_emit_particles
+  combat.effects = &combatFx;
   DayNight dayNight;
+  ChunkDiskCache chunkCache; // outlives the mesh workers that use it
   MeshBuilder meshBuilder(1);
+  meshBuilder.setGpuFields(gpuMesh);
+  meshBuilder.setDiskCache(&chunkCache);
+  FarTerrain farTerrain;
   InventoryUI invUI;
   HUD hud;
   ClientStats clientStats;
@@ -55,16 +119,104 @@ int main(int argc, char **argv) {
   bool cursorWasCaptured = false;
   ClientChestMirror chestMirror;
   RemotePlayerRenderer remotePlayers;
+  PosDeltaDecoder posDecoder;
+  PacketWriter moveWriter;
+  PacketWriter unloadWriter;
 
-  // ── View model renderer ───────────────────────────────────────────────────
   ViewModelRenderer viewModel;
-  viewModel.init(ctx.device.device, ctx.allocator, ctx.renderPass,
-                 ctx.swapchain.extent,
-                 AssetPath::get("viewmodel_vert.spv").c_str(),
-                 AssetPath::get("viewmodel_frag.spv").c_str());
-
   viewModel.animEditor.open = false;
 
+  // ── Pipelines ─────────────────────────────────────────────────────────────
+  // Compiled on workers through the shared cache while the menu is up; the
+  // menu draws without them, and joining is deferred to the first game frame
+  remotePlayers.useTable(ctx.bindless.get());
+  ThreadPool startupPool(5); // a thread per job below
+  std::vector<TaskFuture<void>> pipelineJobs;
+  ctx.shaderTier = (ShaderTier)mainMenu.settings().shaderQuality;
+  pipelineJobs.push_back(startupPool.async([&] { vk_build_pipelines(ctx); }));
+  pipelineJobs.push_back(startupPool.async([&] {
+    viewModel.init(ctx.device.device, ctx.allocator, ctx.renderPass,
+                   ctx.swapchain.extent,
+                   AssetPath::get("viewmodel_vert.spv").c_str(),
+                   AssetPath::get("viewmodel_frag.spv").c_str(),
+                   ctx.pipelineCache);
+  }));
+  pipelineJobs.push_back(startupPool.async([&] {
+    remotePlayers.createPipeline(ctx.device.device, ctx.renderPass,
+                                 ctx.swapchain.extent,
+                                 AssetPath::get("player_vert.spv").c_str(),
+                                 AssetPath::get("player_frag.spv").c_str(),
+                                 ctx.pipelineCache);
+    // Depth only, into the dynamic shadow maps
+    remotePlayers.createPipeline(
+        ctx.device.device, ctx.shadowRenderPass,
+        {(uint32_t)Config::SHADOW_DYNAMIC_SIZE,
+         (uint32_t)Config::SHADOW_DYNAMIC_SIZE},
+        AssetPath::get("player_vert.spv").c_str(), nullptr, ctx.pipelineCache);
+  }));
+  TaskFuture<void> pipelinesBuilt = whenAll(std::move(pipelineJobs));
+  auto joinPipelines = [&] {
+    if (ctx.pipelinesReady)
+      return;
+    pipelinesBuilt.wait();
+    ctx.pipelinesReady = true;
+    vk_save_pipeline_cache(ctx);
+  };
+
+  // ── Models ────────────────────────────────────────────────────────────────
+  // Read and clustered on the same workers, then recorded into one upload
+  // submission from the menu loop once both are in; joined before the first
+  // game frame like the pipelines
+  TaskFuture<std::shared_ptr<ViewModelMeshData>> armRead =
+      startupPool.async([path = AssetPath::get("arm.glb")] {
+        auto d = std::make_shared<ViewModelMeshData>();
+        return ViewModelRenderer::readMesh(path, *d) ? d : nullptr;
+      });
+  TaskFuture<std::shared_ptr<PlayerModelData>> playerRead =
+      startupPool.async([path = AssetPath::get("player.glb")] {
+        auto d = std::make_shared<PlayerModelData>();
+        return RemotePlayerRenderer::readModel(path.c_str(), *d) ? d : nullptr;
+      });
+  bool modelsSubmitted = false;
+  auto uploadModels = [&] {
+    if (modelsSubmitted)
+      return;
+    armRead.wait();
+    playerRead.wait();
+    modelsSubmitted = true;
+    StagedUploads batch(ctx.allocator);
+
+    int idx = -1;
+    if (armRead.ready() && armRead.get()) {
+      ViewModelTransform t;
+      t.offset = {0.3900f, -0.2250f, -0.4050f};
+      t.rotation = {-28.5f, 359.0f, -154.0f};
+      t.scale = {0.21600f, 0.21300f, 0.21600f};
+      idx = viewModel.addMesh(batch, *armRead.get(), t);
+    }
+    if (idx >= 0)
+      viewModel.setActiveMesh(idx);
+    else
+      Log::warn("No arm.glb found — viewmodel disabled.");
+
+    if (playerRead.ready() && playerRead.get() &&
+        remotePlayers.addModel(ctx.device.device, ctx.allocator, batch,
+                               *playerRead.get(),
+                               VkContext::FRAMES_IN_FLIGHT))
+      Log::info("Player model loaded for multiplayer.");
+    else
+      Log::warn("No player.glb found — remote players will be invisible.");
+
+    vk_submit_assets(ctx, batch);
+    // Staged now, so the CPU copies can go
+    armRead = {};
+    playerRead = {};
+  };
+  auto joinModels = [&] {
+    uploadModels();
+    vk_wait_assets(ctx);
+  };
+
   VkDescriptorPool imguiPool;
   {
     VkDescriptorPoolSize poolSizes[] = {
@@ -100,59 +252,335 @@ int main(int argc, char **argv) {
     ImGui_ImplVulkan_Init(&imInfo);
   }
 
-  // ── Load hand GLB ─────────────────────────────────────────────────────────
-  {
-    std::string glbPath = AssetPath::get("arm.glb");
-    GltfModel model = loadGlb(glbPath.c_str());
-    if (model.valid) {
-      ViewModelTransform t;
-      t.offset = {0.3900f, -0.2250f, -0.4050f};
-      t.rotation = {-28.5f, 359.0f, -154.0f};
-      t.scale = {0.21600f, 0.21300f, 0.21600f};
-      int idx =
-          viewModel.loadMesh(ctx.device.device, ctx.allocator, ctx.commandPool,
-                             ctx.graphicsQueue, model, t);
-      viewModel.setActiveMesh(idx);
-    } else {
-      Log::warn("No arm.glb found — viewmodel disabled.");
+  bool authSent = false;
+
+  Net::init();
+  LocalServer localServer; // singleplayer; outlives net
+  NetThread net;
+  bool online = false;     // connected and in game
+  bool connecting = false; // waiting on the network thread
+  uint32_t session = 0;    // the connection events are taken from
+  std::string handoffToken; // moving to another shard: log in there with this
+
+  // ── Packet handlers ───────────────────────────────────────────────────────
+  // Chunks go to the mesh workers straight from the network thread, so
+  // meshing starts before the next frame does; everything else comes out
+  // of net.poll() into dispatch, on this thread.
+  auto onChunk = [&](ENetPeer *, const uint8_t *d, size_t len) {
+    renderRec.packet(d, len);
+    meshBuilder.submit(d, len);
+  };
+  net.on(PacketID::ChunkData, onChunk);
+  net.on(PacketID::ChunkField, onChunk);
+  net.on(PacketID::ChunkUniform, onChunk);
+  net.on(PacketID::ChunkUpdate, onChunk);
+  net.on(PacketID::ChunkPacked, onChunk);
+  // Ahead of every chunk packed with it, on the same channel
+  net.on(PacketID::ChunkDict, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    renderRec.packet(d, len);
+    ChunkDictPacket pkt;
+    if (!ChunkDictPacket::deserialize(d, len, pkt)) return;
+    auto dict = ChunkDict::load((ChunkCodec)pkt.codec,
+                                std::vector<uint8_t>(pkt.bytes, pkt.bytes + pkt.size));
+    if (!dict || dict->id() != pkt.dictId)
+      Log::warn("ChunkDict: can't use the server's dictionary; its chunks won't decode");
+    meshBuilder.setDictionary(std::move(dict));
+  });
+  net.on(PacketID::ChunkCached, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    ChunkCachedPacket pkt;
+    if (ChunkCachedPacket::deserialize(d, len, pkt))
+      meshBuilder.submitCached(pkt.coord, pkt.version, pkt.hash);
+  });
+  // Nothing of the last session may reach the new one's meshes
+  net.onSessionStart([&] {
+    meshBuilder.cancelPending();
+    meshBuilder.setDictionary(nullptr);
+  });
+  net.start();
+
+  PacketDispatcher dispatch;
+  ViewTiers viewTiers; // what the server agreed to send, from ViewConfig
+  MemoryBudget memBudget;
+  int askedRadius = 0; // the view radius last sent, at auth or in a ViewRadius
+
+  // One chunk cache file per server and world, opened once the server has
+  // said which world it is
+  dispatch.on(PacketID::ViewConfig, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    ViewConfigPacket vc;
+    if (!ViewConfigPacket::deserialize(d, len, vc))
+      return;
+    renderRec.packet(d, len);
+    viewTiers = vc.tiers;
+    // Recording keeps the cache shut: the chunks it answers can't replay
+    auto dir = PipelineCache::dir();
+    if (vc.world == 0 || dir.empty() || renderRec.on()) {
+      chunkCache.close();
+      return;
     }
-  }
+    std::string name = mainMenu.pendingServerIP + "_" +
+                       std::to_string(mainMenu.pendingServerPort);
+    for (char &ch : name)
+      if (!std::isalnum((unsigned char)ch) && ch != '.' && ch != '-')
+        ch = '_';
+    char world[16];
+    snprintf(world, sizeof(world), "_%08x.bin", vc.world);
+    chunkCache.open(dir / "chunks" / (name + world), vc.world);
+  });
 
-  // ── Load player model for remote players ──────────────────────────────────
-  {
-    std::string playerGlb = AssetPath::get("player.glb");
-    if (remotePlayers.loadModel(ctx.device.device, ctx.allocator,
-                                 ctx.commandPool, ctx.graphicsQueue,
-                                 ctx.renderPass, ctx.swapchain.extent,
-                                 playerGlb.c_str(),
-                                 AssetPath::get("player_vert.spv").c_str(),
-                                 AssetPath::get("player_frag.spv").c_str())) {
-      Log::info("Player model loaded for multiplayer.");
+  // Placed, by joining or respawning: list what's on disk around the spawn,
+  // so the server answers those chunks with a ChunkCached. Whatever it sent
+  // before this arrives just comes in as bytes.
+  ChunkHavePacket have;
+  PacketWriter haveWriter;
+  auto sendHave = [&](glm::vec3 at) {
+    ChunkCoord spawn{(int)std::floor(at.x / ChunkData::SIZE),
+                     (int)std::floor(at.y / ChunkData::SIZE),
+                     (int)std::floor(at.z / ChunkData::SIZE)};
+    have.entries.clear();
+    chunkCache.list([&](const ChunkCoord &c) { return viewTiers.wants({c, 0}, spawn); },
+                    have.entries);
+    for (size_t i = 0; i < have.entries.size(); i += ChunkHavePacket::MAX_ENTRIES) {
+      ChunkHavePacket batch;
+      size_t n = std::min(ChunkHavePacket::MAX_ENTRIES, have.entries.size() - i);
+      batch.entries.assign(have.entries.begin() + i, have.entries.begin() + i + n);
+      batch.write(haveWriter);
+      net.sendReliable(haveWriter.data(), haveWriter.size());
+    }
+  };
+  dispatch.on(PacketID::SpawnPosition, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    auto sp = SpawnPositionPacket::deserialize(d, len);
+    player.setSpawnPosition({sp.x, sp.y, sp.z});
+    chestMirror.open = false;
+    sendHave({sp.x, sp.y, sp.z});
+  });
+
+  dispatch.on(InvPacketID::InventoryState, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    auto pkt = InventoryStatePacket::deserialize(d, len);
+    invUI.applyState(reg.get<CInventory>(player.entity()), pkt);
+  });
+
+  dispatch.on(InvPacketID::ChestState, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    auto pkt = ChestStatePacket::deserialize(d, len);
+    invUI.applyChestState(chestMirror, pkt);
+    reg.get<CInventory>(player.entity()).open = true;
+    input.captureCursor(false);
+  });
+
+  dispatch.on(InvPacketID::InventoryMoveAck, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    auto ack = InventoryMoveAckPacket::deserialize(d, len);
+    if (invUI.applyAck(reg.get<CInventory>(player.entity()), ack,
+                       chestMirror.open ? &chestMirror : nullptr))
+      net.sendReliable(InventoryResyncPacket{}.serialize());
+  });
+
+  dispatch.on(InvPacketID::LootAvailable, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    auto pkt = LootAvailablePacket::deserialize(d, len);
+    Log::info("Loot available: corpse uid=" + std::to_string(pkt.corpseUID));
+  });
+
+  // ── Stats packets from server ──────────────────────────────────────────
+  dispatch.on(StatsPacketID::StatsSync, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    clientStats.applySync(StatsSyncPacket::deserialize(d, len));
+  });
+
+  dispatch.on(StatsPacketID::StatsDelta, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    StatsDeltaPacket p;
+    if (StatsDeltaPacket::deserialize(d, len, p))
+      clientStats.applyDelta(p);
+  });
+
+  // ── Multiplayer packets ────────────────────────────────────────────────
+  // Our place while the server holds the login back; cleared once it
+  // answers
+  AdmissionQueuePacket queued;
+  dispatch.on(MPPacketID::AdmissionQueue, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    if (AdmissionQueuePacket::deserialize(d, len, queued))
+      Log::info("Waiting to join: " + std::to_string(queued.position) + " of " +
+                std::to_string(queued.waiting));
+  });
+
+  dispatch.on(MPPacketID::AuthResponse, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    auto pkt = AuthResponsePacket::deserialize(d, len);
+    queued = {};
+    if (pkt.accepted) {
+      Log::info("Auth accepted: " + pkt.message + " (id=" + std::to_string(pkt.playerId) + ")");
+      remotePlayers.localPlayerId = pkt.playerId;
+      // Handed over: no SpawnPosition follows, the player stays put
+      if (!handoffToken.empty()) {
+        handoffToken.clear();
+        sendHave(player.position());
+      }
     } else {
-      Log::warn("No player.glb found — remote players will be invisible.");
+      Log::warn("Auth rejected: " + pkt.message);
+      // Could kick back to menu, for now just log
     }
-  }
+  });
 
-  bool enemiesSpawned = false;
-  bool authSent = false;
+  dispatch.on(MPPacketID::PlayerSpawn, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    auto pkt = PlayerSpawnPacket::deserialize(d, len);
+    remotePlayers.onSpawn(pkt);
+    Log::info("Remote player spawned: " + pkt.username +
+              " (id=" + std::to_string(pkt.playerId) + ")");
+  });
 
-  Net::init();
-  Net::Host host;
-  ENetPeer *server = nullptr;
+  // Walked into another shard's part of the world. The server has sent our
+  // state on ahead; reconnect there and log in with the ticket. It's the
+  // same world, so the chunks, colliders and simulation carry on as they are.
+  dispatch.on(ShardPacketID::ShardRedirect, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    ShardRedirectPacket rd;
+    if (!ShardRedirectPacket::deserialize(d, len, rd))
+      return;
+    Log::info("Handed over to " + rd.host + ":" + std::to_string(rd.port));
+    handoffToken = rd.token;
+    session = net.connect(rd.host, rd.port);
+  });
+
+  // First thing on every connection; a handoff logs in with its ticket and
+  // keeps the view it had until the new ViewConfig
+  auto sendAuth = [&] {
+    AuthRequestPacket authReq;
+    authReq.username = mainMenu.pendingUsername;
+    authReq.token = handoffToken.empty() ? mainMenu.account().sessionToken : handoffToken;
+    authReq.caps = CAP_CHUNK_FIELDS  // we mesh chunks ourselves
+                 | CAP_MOVE_DELTA    // compact movement on channel 1
+                 | CAP_LOD_CHUNKS    // and draw LOD rings past them
+                 | CAP_MOVE_PREDICT  // replay corrections from the server
+                 | CAP_REPLICATION   // mirror its replicated components
+                 | ChunkCodecs::caps(); // and unpack what it compresses
+    askedRadius = memBudget.radius(
+        std::clamp((int)mainMenu.settings().renderDistance, 1,
+                   Config::VIEW_RADIUS_MAX));
+    authReq.viewRadius = (uint8_t)askedRadius;
+    if (handoffToken.empty())
+      viewTiers = {};
+    net.sendReliable(authReq.serialize());
+  };
+
+  dispatch.on(MPPacketID::PlayerDespawn, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    auto pkt = PlayerDespawnPacket::deserialize(d, len);
+    Log::info("Remote player left (id=" + std::to_string(pkt.playerId) + ")");
+    remotePlayers.onDespawn(pkt.playerId);
+  });
+
+  // Both forms decode into the one packet, so its list keeps its capacity
+  PlayerPosSyncPacket posSync;
+  dispatch.on(MPPacketID::PlayerPosSync, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    if (PlayerPosSyncPacket::deserialize(d, len, posSync))
+      remotePlayers.onPosSync(posSync);
+  });
+
+  dispatch.on(MPPacketID::PlayerPosDelta, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    if (posDecoder.decode(d, len, posSync)) remotePlayers.onPosSync(posSync);
+  });
+
+  dispatch.on(MPPacketID::MoveCorrection, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    MoveCorrectionPacket c;
+    if (MoveCorrectionPacket::deserialize(d, len, c))
+      player.applyCorrection(c);
+  });
+
+  EnemySyncPacket enemySync;
+  dispatch.on(MPPacketID::EnemySync, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    if (EnemySyncPacket::deserialize(d, len, enemySync))
+      combat.applyEnemySync(enemySync);
+  });
+
+  // Server entities, into reg; components register here in the server's
+  // order (ReplicationServer::replicate)
+  ReplicationClient replClient(reg);
+  dispatch.on(MPPacketID::Replication, [&](ENetPeer *, const uint8_t *d, size_t len) {
+    if (!replClient.apply(d, len))
+      Log::warn("Replication: malformed packet");
+  });
+
+  // ── Simulation ────────────────────────────────────────────────────────
+  // Ticks on the sim thread from connect to disconnect, holding
+  // sim.world(); this thread takes it wherever it touches the same state.
+  // The tick's systems run as their declared reads and writes allow:
+  // combat follows the player, whose attacks it resolves; the stats and
+  // the day run beside both. The hand and the other players are drawn at
+  // frame rate on this thread instead, alongside the whole tick.
+  ThreadPool simPool(2);
+  SystemScheduler simSystems(simPool);
+  const SimThread::Controls *tickIn = nullptr;
+  simSystems
+      .add("player",
+           [&](float dt) {
+             player.update(dt, tickIn->input,
+                           tickIn->uiOpen ? nullptr : &combat);
+           })
+      .reads<CAABB, ChunkCollider>()
+      .writes<Camera, CombatSystem, CTransform, CVelocity, CGrounded,
+              CStamina, CHealth, CAttack, CDodge, CParry>();
+  simSystems.add("combat", [&](float dt) { combat.update(dt, player.entity()); })
+      .writes<CombatSystem, CTransform, CVelocity, CAABB, CStamina, CHealth,
+              CAttack, CDodge, CParry, CFacing, CEnemy, CNetEnemy,
+              CInvincible, CHitThisFrame>();
+  simSystems.add("stats", [&](float dt) { clientStats.update(dt); })
+      .writes<ClientStats>();
+  simSystems.add("day", [&](float dt) { dayNight.update(dt); })
+      .writes<DayNight>();
+  simSystems.build();
+
+  SimThread sim;
+  auto simTick = [&](float dt, const SimThread::Controls &in,
+                     SimThread::State &out) {
+    simCamera.yaw = in.yaw;
+    simCamera.pitch = in.pitch;
+    tickIn = &in;
+    simSystems.run(dt);
+    out.eye = simCamera.position;
+  };
+  // No tick touches the inventory; taken once, since the registry can't be
+  // looked into while one runs
+  auto &cinv = reg.get<CInventory>(player.entity());
 
   using Clock = std::chrono::steady_clock;
   auto prev = Clock::now();
+  FrameLimiter frameLimiter;
   float netAccum = 0.f;
-  std::vector<ChunkMesh> readyMeshes;
+  std::vector<ChunkUpload> readyMeshes;
+  std::vector<ChunkCollider> readyColliders;
+  std::vector<ChunkCollider> arrivedColliders; // for the player, under sim.world()
+  std::vector<std::unique_ptr<ChunkData>> readyFields;
+  std::vector<uint16_t> readyLinks; // face links, by readyFields index
+  std::vector<ChunkUpload> gpuMeshed;
+  int meshPollBudget = 4;
+  ChunkUnloadPacket unloaded;
+  std::vector<ChunkKey> evicted;
+  ChunkCoord residentCenter{INT_MIN, INT_MIN, INT_MIN};
+  ViewTiers residentTiers;
+  std::vector<ChunkKey> spaceMisses;
+  auto traceFlushed = prev;
 
   while (!window.shouldClose()) {
+    // Wait for the GPU (and the limiter) before reading input, not after
+    const GameSettings &gs = mainMenu.settings();
+    vk_set_present_mode(ctx, gs.vsync          ? VK_PRESENT_MODE_FIFO_KHR
+                             : gs.allowTearing ? VK_PRESENT_MODE_IMMEDIATE_KHR
+                                               : VK_PRESENT_MODE_MAILBOX_KHR);
+    ctx.lowLatency = gs.lowLatency;
+    vk_wait_frame(ctx);
+    frameLimiter.wait(gs.fpsLimit);
+
     auto now = Clock::now();
+    if (Trace::on() && now - traceFlushed > std::chrono::seconds(1)) {
+      Trace::flush();
+      traceFlushed = now;
+    }
     float dt = std::chrono::duration<float>(now - prev).count();
     prev = now;
+    float frameMs = dt * 1000.f;
     if (dt > 0.05f) dt = 0.05f;
     input.beginFrame();
+    ctx.profiler.beginFrame();
 
     if (gameState != GameState::InGame) {
+      if (pipelinesBuilt.done())
+        joinPipelines();
+      if (!modelsSubmitted && armRead.done() && playerRead.done())
+        uploadModels();
+      vk_assets_uploaded(ctx);
       if (input.cursorCaptured()) input.captureCursor(false);
       int w, h; window.getSize(w, h);
 
@@ -165,51 +593,69 @@ int main(int argc, char **argv) {
       if (next == GameState::Connecting) {
         if (mainMenu.pendingServerIP == "__QUIT__") break;
 
-        const char* ip = mainMenu.pendingServerIP.c_str();
-        int port = mainMenu.pendingServerPort;
-
-        ENetAddress addr2{};
-        if (enet_address_set_host(&addr2, ip) == 0) {
-          addr2.port = (uint16_t)port;
-          if (server) { enet_peer_disconnect_now(server, 0); server = nullptr; }
-          server = enet_host_connect(host.get(), &addr2, 2, 0);
-          if (server) {
-            ENetEvent ev2;
-            if (enet_host_service(host.get(), &ev2, 5000) > 0 &&
-                ev2.type == ENET_EVENT_TYPE_CONNECT) {
-              Log::info(std::string("Connected to ") + ip);
-
-              // Send auth request immediately
-              AuthRequestPacket authReq;
-              authReq.username = mainMenu.pendingUsername;
-              authReq.token = mainMenu.account().sessionToken;
-              Net::sendReliable(server, authReq.serialize());
-              enet_host_flush(host.get());
-              authSent = true;
-
-              gameState = GameState::InGame;
-              input.captureCursor(true);
-
-              // Clear remote players from previous session
-              remotePlayers.players.clear();
-              remotePlayers.localPlayerId = 0;
-
-            } else {
-              enet_peer_reset(server);
-              server = nullptr;
+        // The network thread connects while the menu keeps drawing; an
+        // attempt that fails is tried again for as long as it stays here
+        if (!connecting) {
+          if (mainMenu.pendingServerIP == MainMenu::LOCAL_SERVER) {
+            // Another world than the one running: its server takes our
+            // disconnect and saves before the new one starts
+            if (localServer.running() &&
+                localServer.world() != mainMenu.pendingWorld) {
+              net.stop();
+              localServer.stop();
+              net.start();
             }
+            localServer.start(mainMenu.pendingWorld);
+            session = net.connect(localServer.loopback());
+          } else {
+            session = net.connect(mainMenu.pendingServerIP,
+                                  (uint16_t)mainMenu.pendingServerPort);
           }
+          connecting = true;
         }
       } else {
         gameState = next;
+        connecting = false; // backed out
+      }
+
+      // Only the current attempt's answer counts; anything else is left
+      // over from one given up on
+      NetThread::Event ev;
+      while (gameState != GameState::InGame && net.poll(ev)) {
+        if (!connecting || ev.session != session)
+          continue;
+        if (ev.kind == NetThread::Event::Kind::ConnectFailed) {
+          connecting = false;
+        } else if (ev.kind == NetThread::Event::Kind::Connected) {
+          Log::info(mainMenu.pendingServerIP == MainMenu::LOCAL_SERVER
+                        ? "Playing " + mainMenu.pendingWorld
+                        : "Connected to " + mainMenu.pendingServerIP);
+          connecting = false;
+          online = true;
+
+          // Send auth request immediately
+          handoffToken.clear();
+          sendAuth();
+          authSent = true;
+
+          joinPipelines();
+          joinModels();
+          gameState = GameState::InGame;
+          input.captureCursor(true);
+
+          // Clear remote players from previous session
+          remotePlayers.players.clear();
+          remotePlayers.localPlayerId = 0;
+          posDecoder.reset();
+          sim.start(simTick);
+        }
       }
 
       ImGui::Render();
       vk_draw(ctx, glm::mat4(1.f), 0.f, {0.02f, 0.02f, 0.08f}, nullptr, glm::mat4(1.f));
       continue;
     }
-    if (!server) continue;
-    auto &cinv = reg.get<CInventory>(player.entity());
+    if (!online) continue;
 
     // ── ] key — toggle viewmodel UI panels ───────────────────────────────
     if (input.keyDown(GLFW_KEY_RIGHT_BRACKET)) {
@@ -221,100 +667,193 @@ int main(int argc, char **argv) {
         input.captureCursor(true);
     }
 
-    // ── Receive packets ───────────────────────────────────────────────────
-    ENetEvent ev;
-    while (enet_host_service(host.get(), &ev, 0) > 0) {
-      if (ev.type == ENET_EVENT_TYPE_RECEIVE) {
-        const uint8_t *d = ev.packet->data;
-        size_t len = ev.packet->dataLength;
-
-        if (len > 0) {
-          uint8_t pid = d[0];
-
-          if (pid == (uint8_t)PacketID::ChunkData) {
-            meshBuilder.submit(d, len);
-
-          } else if (pid == (uint8_t)PacketID::SpawnPosition) {
-            auto sp = SpawnPositionPacket::deserialize(d, len);
-            player.setSpawnPosition({sp.x, sp.y, sp.z});
-            enemiesSpawned = false;
-            chestMirror.open = false;
-
-          } else if (pid == (uint8_t)InvPacketID::InventoryState) {
-            auto pkt = InventoryStatePacket::deserialize(d, len);
-            invUI.applyState(cinv, pkt);
-
-          } else if (pid == (uint8_t)InvPacketID::ChestState) {
-            auto pkt = ChestStatePacket::deserialize(d, len);
-            invUI.applyChestState(chestMirror, pkt);
-            cinv.open = true;
-            input.captureCursor(false);
-
-          } else if (pid == (uint8_t)InvPacketID::InventoryMoveAck) {
-            auto ack = InventoryMoveAckPacket::deserialize(d, len);
-            invUI.applyAck(cinv, ack,
-                           chestMirror.open ? &chestMirror : nullptr);
-
-          } else if (pid == (uint8_t)InvPacketID::LootAvailable) {
-            auto pkt = LootAvailablePacket::deserialize(d, len);
-            Log::info("Loot available: corpse uid=" +
-                      std::to_string(pkt.corpseUID));
-
-          // ── Stats packets from server ────────────────────────────────
-          } else if (pid == (uint8_t)StatsPacketID::StatsSync) {
-            auto pkt = StatsSyncPacket::deserialize(d, len);
-            clientStats.applySync(pkt);
-
-          } else if (pid == (uint8_t)StatsPacketID::StatsDelta) {
-            auto pkt = StatsDeltaPacket::deserialize(d, len);
-            clientStats.applyDelta(pkt);
-
-          // ── Multiplayer packets ──────────────────────────────────────
-          } else if (pid == (uint8_t)MPPacketID::AuthResponse) {
-            auto pkt = AuthResponsePacket::deserialize(d, len);
-            if (pkt.accepted) {
-              Log::info("Auth accepted: " + pkt.message + " (id=" + std::to_string(pkt.playerId) + ")");
-              remotePlayers.localPlayerId = pkt.playerId;
-            } else {
-              Log::warn("Auth rejected: " + pkt.message);
-              // Could kick back to menu, for now just log
-            }
-
-          } else if (pid == (uint8_t)MPPacketID::PlayerSpawn) {
-            auto pkt = PlayerSpawnPacket::deserialize(d, len);
-            remotePlayers.onSpawn(pkt);
-            Log::info("Remote player spawned: " + pkt.username +
-                      " (id=" + std::to_string(pkt.playerId) + ")");
-
-          } else if (pid == (uint8_t)MPPacketID::PlayerDespawn) {
-            auto pkt = PlayerDespawnPacket::deserialize(d, len);
-            Log::info("Remote player left (id=" + std::to_string(pkt.playerId) + ")");
-            remotePlayers.onDespawn(pkt.playerId);
+    // ── F3 — profiler overlay, F4 — dump it, F5 — memory ──────────────────
+    if (input.keyDown(GLFW_KEY_F3))
+      ctx.profiler.visible = !ctx.profiler.visible;
+    if (input.keyDown(GLFW_KEY_F5))
+      memBudget.visible = !memBudget.visible;
+    if (input.keyDown(GLFW_KEY_F4)) {
+      bool ok = ctx.profiler.dumpCsv("aetheris_profile.csv") &&
+                ctx.profiler.dumpTrace("aetheris_trace.json");
+      Log::info(ok ? "Profile written to aetheris_profile.csv and "
+                     "aetheris_trace.json"
+                   : "Profile dump failed");
+    }
 
-          } else if (pid == (uint8_t)MPPacketID::PlayerPosSync) {
-            auto pkt = PlayerPosSyncPacket::deserialize(d, len);
-            remotePlayers.onPosSync(pkt);
+    // ── Receive packets ───────────────────────────────────────────────────
+    // The handlers reach into the simulation; what the rest of the frame
+    // needs of the player is read here too
+    bool spawned;
+    glm::vec3 ppos;
+    {
+      auto world = sim.world();
+      auto t = ctx.profiler.cpu(FrameProfiler::CpuNet);
+      NetThread::Event ev;
+      while (net.poll(ev)) {
+        if (ev.session != session)
+          continue;
+        if (ev.kind == NetThread::Event::Kind::Message) {
+          dispatch.dispatch(nullptr, ev.bytes.data(), ev.bytes.size());
+        } else if (ev.kind == NetThread::Event::Kind::Connected) {
+          // The shard we were handed to; its players come as it spawns them
+          remotePlayers.players.clear();
+          posDecoder.reset();
+          replClient.clear();
+          sendAuth();
+        } else if (ev.kind == NetThread::Event::Kind::Disconnected ||
+                   ev.kind == NetThread::Event::Kind::ConnectFailed) {
+          Log::info("Disconnected from server");
+          for (auto [name, s] : {std::pair{"vertex", ctx.mega.verts.stats()},
+                                 std::pair{"index", ctx.mega.inds.stats()}}) {
+            char buf[160];
+            snprintf(buf, sizeof(buf),
+                     "Mega %s buffer: %u/%u used, %u free blocks, %.0f%% "
+                     "fragmented",
+                     name, s.used, s.capacity, s.freeBlocks,
+                     s.fragmentation() * 100.f);
+            Log::info(buf);
           }
+          online = false;
+          handoffToken.clear();
+          replClient.clear();
+          queued = {};
+          world.unlock();
+          sim.stop();
+          meshBuilder.cancelPending();
+          chunkCache.close();
+          gameState = GameState::MainMenu;
+          break;
         }
-        enet_packet_destroy(ev.packet);
-      } else if (ev.type == ENET_EVENT_TYPE_DISCONNECT) {
-        Log::info("Disconnected from server");
-        server = nullptr;
-        gameState = GameState::MainMenu;
-        break;
       }
+      spawned = player.isSpawned();
+      ppos = player.position();
     }
 
-    if (!server) continue;
+    if (!online) continue;
 
     // ── Poll finished meshes ──────────────────────────────────────────────
+    // Take more per frame while frames come in under target and the GPU
+    // queue is keeping up; halve it as soon as a frame runs long
+    if (frameMs > Config::FRAME_TARGET_MS * 1.2f)
+      meshPollBudget = std::max(Config::MESH_POLL_MIN, meshPollBudget / 2);
+    else if (frameMs < Config::FRAME_TARGET_MS * 0.9f &&
+             vk_pending_uploads(ctx) < (size_t)meshPollBudget * 2)
+      meshPollBudget = std::min(Config::MESH_POLL_MAX, meshPollBudget + 1);
+
+    // ── Chunk residency ──────────────────────────────────────────────────
+    // Without LOD, keep the send radius plus one ring of hysteresis around
+    // the player, so walking along a chunk border doesn't drop and
+    // re-request the same row. With LOD, keep exactly what ViewTiers says
+    // the server sends — the levels tile space, so a ring of slack would
+    // overlap the next level. Evict the rest and tell the server about full
+    // chunks, so it sends them again if we come back; it forgets LOD cells
+    // on its own. Only once spawned — before that the position isn't where
+    // the chunks are arriving.
+    ChunkCoord center{(int)std::floor(ppos.x / ChunkData::SIZE),
+                      (int)std::floor(ppos.y / ChunkData::SIZE),
+                      (int)std::floor(ppos.z / ChunkData::SIZE)};
+    auto resident = [&](const ChunkKey &k) {
+      if (!spawned)
+        return true;
+      if (viewTiers.levels > 0)
+        return viewTiers.wants(k, center);
+      const ChunkCoord &c = k.coord;
+      return k.lod == 0 && std::abs(c.x - center.x) <= viewTiers.r + 1 &&
+             std::abs(c.y - center.y) <= viewTiers.ry + 1 &&
+             std::abs(c.z - center.z) <= viewTiers.r + 1;
+    };
+
     readyMeshes.clear();
-    meshBuilder.poll(readyMeshes, 4);
-    for (auto &mesh : readyMeshes) {
-      player.addChunkMesh(mesh);
-      vk_upload_chunk(ctx, mesh);
+    readyColliders.clear();
+    {
+      auto t = ctx.profiler.cpu(FrameProfiler::CpuMeshPoll);
+      meshBuilder.poll(readyMeshes, readyColliders, meshPollBudget);
+    }
+    for (size_t i = 0; i < readyMeshes.size(); i++) {
+      ChunkUpload &mesh = readyMeshes[i];
+      if (!resident({mesh.coord, mesh.lod})) {
+        // Meshed after we walked away from it
+        if (mesh.lod == 0)
+          unloaded.coords.push_back(mesh.coord);
+        ctx.spentMeshes.push_back(std::move(mesh));
+        continue;
+      }
+      if (mesh.lod == 0)
+        arrivedColliders.push_back(std::move(readyColliders[i]));
+      // An edit can dig a chunk out entirely; take down what it showed
+      if (mesh.lod == 0 && mesh.vertices.empty())
+        vk_remove_chunk(ctx, {mesh.coord, 0});
+      vk_upload_chunk(ctx, std::move(mesh));
     }
 
+    // GPU meshing: as many fields as there are free jobs this frame; the
+    // meshes come back a few frames later for their colliders
+    if (gpuMesh) {
+      readyFields.clear();
+      readyLinks.clear();
+      meshBuilder.pollFields(readyFields, readyLinks, vk_gpu_mesh_free(ctx));
+      for (size_t i = 0; i < readyFields.size(); i++) {
+        const ChunkData &field = *readyFields[i];
+        if (!resident({field.coord, 0}))
+          unloaded.coords.push_back(field.coord);
+        else
+          vk_gpu_mesh_chunk(ctx, field, readyLinks[i]);
+      }
+      meshBuilder.recycleFields(readyFields);
+
+      gpuMeshed.clear();
+      vk_take_gpu_meshed(ctx, gpuMeshed);
+      for (ChunkUpload &mesh : gpuMeshed)
+        meshBuilder.submitCollider(std::move(mesh));
+      readyColliders.clear();
+      meshBuilder.pollColliders(readyColliders);
+      for (ChunkCollider &collider : readyColliders)
+        if (resident({collider.coord, 0}))
+          arrivedColliders.push_back(std::move(collider));
+    }
+
+    if (spawned && (center != residentCenter || viewTiers != residentTiers)) {
+      residentCenter = center;
+      residentTiers = viewTiers;
+      evicted.clear();
+      vk_evict_chunks(ctx, resident, evicted);
+      for (const ChunkKey &k : evicted)
+        if (k.lod == 0)
+          unloaded.coords.push_back(k.coord);
+    }
+    meshBuilder.recycle(ctx.spentMeshes);
+
+    // ── Video memory ──────────────────────────────────────────────────────
+    // Chunks dropped for want of room go back to the server like evicted
+    // ones, so they come again once there's room; meanwhile MemoryBudget
+    // cuts the view radius asked for, and the new ViewConfig's tiers evict
+    // the rest. The player's own setting goes out the same way.
+    spaceMisses.clear();
+    vk_take_space_misses(ctx, spaceMisses);
+    for (const ChunkKey &k : spaceMisses)
+      if (k.lod == 0 && resident(k))
+        unloaded.coords.push_back(k.coord);
+    memBudget.sample(ctx.allocator, vk_memory_stats(ctx), spaceMisses.size(),
+                     std::chrono::duration<double>(now.time_since_epoch()).count());
+    int radius = memBudget.radius(
+        std::clamp((int)gs.renderDistance, 1, Config::VIEW_RADIUS_MAX));
+    if (spawned && radius != askedRadius) {
+      if (memBudget.underPressure())
+        Log::info("Video memory pressure: view radius " + std::to_string(radius));
+      ViewRadiusPacket{(uint8_t)radius}.write(unloadWriter);
+      net.sendReliable(unloadWriter.data(), unloadWriter.size());
+      askedRadius = radius;
+    }
+
+    // Listed but gone from disk: the server sends them after all
+    meshBuilder.pollMisses(unloaded.coords);
+
+    for (size_t sent = 0; sent < unloaded.coords.size();) {
+      sent = unloaded.write(unloadWriter, sent);
+      net.sendReliable(unloadWriter.data(), unloadWriter.size());
+    }
+    unloaded.coords.clear();
+
     // ── Hotbar mode (Tab) + slot select (1-8) ────────────────────────────
     {
       bool tabPressed = input.keyDown(GLFW_KEY_TAB);
@@ -336,7 +875,7 @@ int main(int argc, char **argv) {
       cinv.open = !cinv.open;
       if (!cinv.open && chestMirror.open) {
         ChestCloseReqPacket req{chestMirror.uid};
-        Net::sendReliable(server, req.serialize());
+        net.sendReliable(req.serialize());
         chestMirror.open = false;
       }
       input.captureCursor(!cinv.open);
@@ -344,90 +883,149 @@ int main(int argc, char **argv) {
 
     // ── Chest interaction (E) ─────────────────────────────────────────────
     if (input.keyDown(GLFW_KEY_E) && !chestMirror.open) {
-      ChestOpenReqPacket req{1};
-      Net::sendReliable(server, req.serialize());
-      enet_host_flush(host.get());
+      ChestOpenReqPacket req{0}; // nearest chest, picked by the server
+      net.sendReliable(req.serialize());
     }
 
     bool uiOpen = cinv.open || chestMirror.open || viewModel.uiVisible;
     if (!uiOpen && !input.cursorCaptured())
       input.captureCursor(true);
 
-    // ── Spawn test enemies ────────────────────────────────────────────────
-    if (player.isSpawned() && !enemiesSpawned) {
-      glm::vec3 base = player.position();
-      combat.spawnEnemy(base + glm::vec3{5.f, 0.f, 0.f});
-      combat.spawnEnemy(base + glm::vec3{-5.f, 0.f, 3.f});
-      combat.spawnEnemy(base + glm::vec3{0.f, 0.f, -6.f});
-      enemiesSpawned = true;
-    }
-
     // ── Update ────────────────────────────────────────────────────────────
-    bool suppressInput = uiOpen;
-    if (suppressInput) {
-      player.update(dt, input, nullptr);
-    } else {
-      bool lightAttack = input.keyDown(GLFW_KEY_F);
-      bool heavyAttack = input.keyDown(GLFW_KEY_G);
-
-      player.update(dt, input, &combat);
-
-      if (lightAttack)
-        viewModel.triggerLightAttack();
-      if (heavyAttack)
-        viewModel.triggerHeavyAttack();
+    // The player, combat, stats and the day tick on the sim thread; it
+    // gets this frame's keys and where the camera looks. The hand and the
+    // other players are only drawn, so they animate at frame rate.
+    camera.applyMouse(input.mouseDelta());
+    sim.feed(input.state(), camera.yaw, camera.pitch, uiOpen);
+    ctx.profiler.addCpuMs(FrameProfiler::CpuSim, sim.takeTickMs());
+    // A swing streaks across in front of the eye, left to right, whether
+    // or not it lands
+    auto swingFx = [&](bool heavy) {
+      glm::vec3 at = camera.position + camera.forward() * 0.9f -
+                     camera.right() * 0.3f;
+      vk_emit_particles(ctx, ParticleFx::swing(at, camera.right(), heavy));
+    };
+    if (!uiOpen && input.keyDown(GLFW_KEY_F)) {
+      viewModel.triggerLightAttack();
+      swingFx(false);
+    }
+    if (!uiOpen && input.keyDown(GLFW_KEY_G)) {
+      viewModel.triggerHeavyAttack();
+      swingFx(true);
     }
-
-    combat.update(dt, player.entity());
-    dayNight.update(dt);
     viewModel.update(dt);
     remotePlayers.update(dt);
 
     // ── Respawn ───────────────────────────────────────────────────────────
     if (input.keyPressed(GLFW_KEY_R)) {
-      Net::sendReliable(server, RespawnRequestPacket{}.serialize());
-      enet_host_flush(host.get());
+      net.sendReliable(RespawnRequestPacket{}.serialize());
     }
 
-    // ── Send position (20 Hz) ─────────────────────────────────────────────
-    netAccum += dt;
-    if (netAccum >= 0.05f) {
-      netAccum = 0.f;
-      glm::vec3 pos = player.position();
-      PlayerMovePacket mv{pos.x, pos.y, pos.z, camera.yaw, camera.pitch};
-      Net::sendReliable(server, mv.serialize());
-      enet_host_flush(host.get());
+    // ── Simulation state ──────────────────────────────────────────────────
+    ClientStats stats;
+    glm::vec3 sunDir, skyColor;
+    float sunIntensity;
+    {
+      auto world = sim.world();
+      for (ChunkCollider &collider : arrivedColliders)
+        player.addChunk(std::move(collider));
+      arrivedColliders.clear();
+      for (const EnemyHitPacket &hit : combat.takeEnemyHits())
+        net.sendReliable(hit.serialize());
+      for (const PlayerDefendPacket &def : combat.takeDefends())
+        net.sendReliable(def.serialize());
+
+      // Position, at 20 Hz. Not before spawning: until then the position
+      // is left over from wherever the player was, and the server would
+      // refuse it
+      netAccum += dt;
+      if (netAccum >= 0.05f && player.isSpawned()) {
+        netAccum = 0.f;
+        glm::vec3 pos = player.position();
+        PlayerMoveQPacket mv;
+        mv.x = pos.x; mv.y = pos.y; mv.z = pos.z;
+        mv.yaw = camera.yaw; mv.pitch = camera.pitch;
+        mv.ack = posDecoder.ack();
+        mv.predicted = true;
+        mv.seq = player.inputSeq();
+        mv.epoch = player.moveEpoch();
+        mv.write(moveWriter);
+        net.sendMovement(moveWriter.data(), moveWriter.size());
+      }
+
+      stats = clientStats;
+      sunDir = dayNight.sunDir();
+      skyColor = dayNight.skyColor();
+      sunIntensity = dayNight.sunIntensity();
     }
 
     // ── Render ────────────────────────────────────────────────────────────
+    // From one tick back, between the two ticks either side of it
+    SimThread::State simView;
+    if (sim.view(Clock::now(), simView))
+      camera.position = simView.eye;
     int w, h;
     window.getSize(w, h);
     float aspect = (w > 0 && h > 0) ? (float)w / (float)h : 1.f;
+    vk_set_upload_focus(ctx, ppos);
+    vk_set_sun(ctx, sunDir);
+    vk_set_compact_budget(ctx, frameMs < Config::FRAME_TARGET_MS * 0.9f
+                                   ? Config::MEGA_COMPACT_BYTES
+                                   : 0);
     glm::mat4 vp = camera.viewProj(aspect);
     glm::mat4 proj = camera.proj(aspect);
 
+    // The far field takes over where the outermost streamed level ends
+    if (spawned) {
+      ViewBox top = viewTiers.region(viewTiers.levels, center);
+      float cell = (float)(ChunkData::SIZE << viewTiers.levels);
+      farTerrain.update(camera.position,
+                        glm::vec2((float)top.lo.x, (float)top.lo.z) * cell,
+                        glm::vec2((float)top.hi.x + 1, (float)top.hi.z + 1) *
+                            cell);
+    }
+
     ImGui_ImplVulkan_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
     // Draw HUD (always visible)
-    hud.draw(clientStats);
+    hud.draw(stats);
+    if (queued.position > 0)
+      hud.drawQueue(queued.position, queued.waiting);
 
     // Draw nametags for remote players
     remotePlayers.drawNametags(vp, w, h);
 
     viewModel.drawDebugUI();
-    invUI.draw(cinv, chestMirror.open ? &chestMirror : nullptr, server);
+    ctx.profiler.drawOverlay();
+    memBudget.drawPanel();
+    invUI.draw(cinv, chestMirror.open ? &chestMirror : nullptr, &net);
 
     ImGui::Render();
-    vk_draw(ctx, vp, dayNight.sunIntensity(), dayNight.skyColor(), &viewModel,
-            proj, &remotePlayers);
+    // Late latch: whatever the mouse did during the frame still turns the
+    // camera it's drawn from
+    if (!uiOpen && input.cursorCaptured()) {
+      camera.applyMouse(input.latchMouse());
+      vp = camera.viewProj(aspect);
+    }
+    ctx.depthPrepass = mainMenu.settings().depthPrepass;
+    ctx.dynamicResolution = mainMenu.settings().dynamicResolution;
+    ctx.foliage = mainMenu.settings().foliage;
+    for (ParticleEmitter e; combatFx.pop(e);)
+      vk_emit_particles(ctx, e);
+    vk_set_shader_tier(ctx, (ShaderTier)mainMenu.settings().shaderQuality);
+    vk_draw(ctx, vp, sunIntensity, skyColor, &viewModel, proj, &remotePlayers,
+            spawned ? &farTerrain : nullptr, camera.farViewProj(aspect));
+    renderRec.pose({camera.position, camera.yaw, camera.pitch, ppos, spawned});
   }
 
-  if (server) {
-    enet_peer_disconnect(server, 0);
-    enet_host_flush(host.get());
-  }
+  sim.stop();
+  joinPipelines();
+  joinModels();
+  net.stop();
+  renderRec.close();
+  localServer.stop();
   ImGui_ImplVulkan_Shutdown();
   ImGui_ImplGlfw_Shutdown();
   ImGui::DestroyContext();
@@ -437,6 +1035,7 @@ int main(int argc, char **argv) {
   viewModel.destroy(ctx.device.device, ctx.allocator);
   vk_destroy(ctx);
   Net::deinit();
+  Trace::stop();
   Log::info("Client shutdown");
   Log::shutdown();
 }
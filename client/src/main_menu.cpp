@@ -6,6 +6,7 @@
 #include <cmath>
 #include <fstream>
 #include <algorithm>
+#include "config.h"
 
 // ── Colour palette — dark teal/blue with warm amber accents ───────────────────
 static constexpr ImU32 COL_BG_DARK    = IM_COL32(6,   10,  14,  255);
@@ -45,6 +46,13 @@ void GameSettings::save(const char* path) const {
     if (!f) return;
     f << "render_distance " << renderDistance << "\n"
       << "vsync "           << (int)vsync     << "\n"
+      << "allow_tearing "   << (int)allowTearing << "\n"
+      << "low_latency "     << (int)lowLatency << "\n"
+      << "fps_limit "       << fpsLimit       << "\n"
+      << "depth_prepass "   << (int)depthPrepass << "\n"
+      << "dynamic_resolution " << (int)dynamicResolution << "\n"
+      << "foliage "         << (int)foliage   << "\n"
+      << "shader_quality "  << shaderQuality  << "\n"
       << "fov "             << fov            << "\n"
       << "mouse_sens "      << mouseSens      << "\n"
       << "master_vol "      << masterVolume   << "\n"
@@ -61,6 +69,13 @@ void GameSettings::load(const char* path) {
     while (f >> key) {
         if      (key=="render_distance") f>>renderDistance;
         else if (key=="vsync")           { int v; f>>v; vsync=v; }
+        else if (key=="allow_tearing")   { int v; f>>v; allowTearing=v; }
+        else if (key=="low_latency")     { int v; f>>v; lowLatency=v; }
+        else if (key=="fps_limit")       f>>fpsLimit;
+        else if (key=="depth_prepass")   { int v; f>>v; depthPrepass=v; }
+        else if (key=="dynamic_resolution") { int v; f>>v; dynamicResolution=v; }
+        else if (key=="foliage")         { int v; f>>v; foliage=v; }
+        else if (key=="shader_quality")  f>>shaderQuality;
         else if (key=="fov")             f>>fov;
         else if (key=="mouse_sens")      f>>mouseSens;
         else if (key=="master_vol")      f>>masterVolume;
@@ -71,6 +86,8 @@ void GameSettings::load(const char* path) {
         else if (key=="auth_port")       f>>authPort;
     }
     fovF = (float)fov;
+    shaderQuality  = std::clamp(shaderQuality, 0, 2);
+    shaderQualityF = (float)shaderQuality;
 }
 
 // ── Constructor ───────────────────────────────────────────────────────────────
@@ -613,7 +630,7 @@ GameState MainMenu::drawMultiplayer(ImDrawList* dl, float cx, float cy,
 
 GameState MainMenu::drawSettings(ImDrawList* dl, float cx, float cy,
                                   int sw, int sh, float dt) {
-    float panW=540.f, panH=440.f;
+    float panW=540.f, panH=610.f;
     float panX=cx-panW*0.5f, panY=cy-panH*0.5f;
     drawPanel(dl,panX,panY,panW,panH,_panelSlide);
     ImFont* font=ImGui::GetFont();
@@ -631,10 +648,18 @@ GameState MainMenu::drawSettings(ImDrawList* dl, float cx, float cy,
     float cy2=panY+56.f+tabH+20.f, lx=panX+30.f, rowH=34.f;
     if (_settingsTab==0) {
         drawSectionHeader(dl,font,"RENDERING",lx,cy2,panW-60.f); cy2+=22.f;
-        drawSlider(dl,"Render Distance",lx,cy2,panW-60.f,_settings.renderDistance,1.f,8.f,"%.0f chunks"); cy2+=rowH;
+        drawSlider(dl,"Render Distance",lx,cy2,panW-60.f,_settings.renderDistance,1.f,(float)Config::VIEW_RADIUS_MAX,"%.0f chunks"); cy2+=rowH;
         drawSlider(dl,"Field of View",lx,cy2,panW-60.f,_settings.fovF,60.f,110.f,"%.0f"); cy2+=rowH;
         _settings.fov=(int)_settings.fovF;
-        drawToggle(dl,"VSync",lx,cy2,_settings.vsync); cy2+=rowH+10.f;
+        drawToggle(dl,"VSync",lx,cy2,_settings.vsync); cy2+=rowH;
+        drawToggle(dl,"Allow Tearing",lx,cy2,_settings.allowTearing); cy2+=rowH;
+        drawToggle(dl,"Low Latency",lx,cy2,_settings.lowLatency); cy2+=rowH;
+        drawSlider(dl,"FPS Cap (0 = off)",lx,cy2,panW-60.f,_settings.fpsLimit,0.f,300.f,"%.0f fps"); cy2+=rowH;
+        drawToggle(dl,"Depth Pre-pass",lx,cy2,_settings.depthPrepass); cy2+=rowH;
+        drawToggle(dl,"Dynamic Resolution",lx,cy2,_settings.dynamicResolution); cy2+=rowH;
+        drawToggle(dl,"Foliage",lx,cy2,_settings.foliage); cy2+=rowH;
+        drawSlider(dl,"Shader Quality",lx,cy2,panW-60.f,_settings.shaderQualityF,0.f,2.f,"%.0f of 2"); cy2+=rowH+10.f;
+        _settings.shaderQuality=(int)(_settings.shaderQualityF+0.5f);
         drawSectionHeader(dl,font,"INPUT",lx,cy2,panW-60.f); cy2+=22.f;
         drawSlider(dl,"Mouse Sensitivity",lx,cy2,panW-60.f,_settings.mouseSens,0.01f,0.5f,"%.3f");
     } else if (_settingsTab==1) {
@@ -684,8 +709,8 @@ GameState MainMenu::drawWorldSel(ImDrawList* dl, float cx, float cy,
         ImGui::SetCursorScreenPos({rx,wy});
         ImGui::PushID(i+50);
         if (ImGui::InvisibleButton("##world",{rw,rh})) {
-            pendingServerIP=_settings.lastServer;
-            pendingServerPort=_settings.serverPort;
+            pendingServerIP=LOCAL_SERVER;
+            pendingWorld="saves/world"+std::to_string(i+1);
             ImGui::PopID();
             return GameState::Connecting;
         }
@@ -712,7 +737,8 @@ GameState MainMenu::drawConnecting(ImDrawList* dl, float cx, float cy,
         int d=(int)(_connectTimer*2.f)%4;
         for (int i=0;i<d;i++) dots[i]='.'; dots[d]=0;
         char msg[128];
-        snprintf(msg,sizeof(msg),"Connecting to %s:%d%s",pendingServerIP.c_str(),pendingServerPort,dots);
+        if (pendingServerIP==LOCAL_SERVER) snprintf(msg,sizeof(msg),"Loading world%s",dots);
+        else snprintf(msg,sizeof(msg),"Connecting to %s:%d%s",pendingServerIP.c_str(),pendingServerPort,dots);
         ImVec2 msz=font->CalcTextSizeA(18.f,999.f,0.f,msg);
         dl->AddText(font,18.f,{cx-msz.x*0.5f,cy-10.f},COL_WHITE,msg);
         if (_connectTimer>8.f) _connectFailed=true;
@@ -725,7 +751,8 @@ GameState MainMenu::drawConnecting(ImDrawList* dl, float cx, float cy,
             _connectTimer=0.f; _connectFailed=false; return GameState::Connecting;
         }
         if (menuButton(dl,"BACK",cx+45.f,cy+10.f,80.f,32.f,false,hBack)) {
-            pendingServerIP=""; return GameState::Multiplayer;
+            bool local=pendingServerIP==LOCAL_SERVER;
+            pendingServerIP=""; return local?GameState::WorldSelect:GameState::Multiplayer;
         }
     }
     return GameState::Connecting;
@@ -1,36 +1,306 @@
 #include "mesh_builder.h"
+#include "log.h"
+#include "marching_cubes.h"
+#include "mem_tags.h"
+#include "mesh_optimize.h"
+#include "meshlets.h"
+#include "trace.h"
+#include "terrain_edit.h"
+#include <algorithm>
+#include <memory>
 
 MeshBuilder::MeshBuilder(int nThreads)
-    : _pool(nThreads) {}
+    : _pool(nThreads, MemTags::Meshing) {}
 
 void MeshBuilder::submit(const uint8_t* data, size_t len) {
+    uint32_t version = 0;
+    if (data[0] == (uint8_t)PacketID::ChunkUpdate) {
+        ChunkCoord c;
+        size_t     innerLen;
+        data = ChunkUpdatePacket::unwrap(data, len, c, version, innerLen);
+        if (!data) return;
+        len = innerLen;
+        noteVersion(c, version);
+    }
+    std::shared_ptr<const ChunkDict> dict;
+    if (data[0] == (uint8_t)PacketID::ChunkPacked) {
+        std::lock_guard lk(_dictMu);
+        dict = _dict;
+    }
+
     // Copy bytes so caller can free the packet immediately
     std::vector<uint8_t> buf(data, data + len);
     _inFlight.fetch_add(1, std::memory_order_relaxed);
 
-    _pool.submit([this, buf = std::move(buf)]() {
-        auto pkt  = ChunkDataPacket::deserialize(buf.data(), buf.size());
-        auto mesh = pkt.toMesh();
+    CancelToken cancel = token();
+    int64_t recvUs = Trace::on() ? Trace::nowUs() : 0;
+    _pool.async([this, buf = std::move(buf), dict = std::move(dict), recvUs, version]() {
+        if (buf[0] != (uint8_t)PacketID::ChunkPacked) return decode(buf, version, recvUs, true);
+        static thread_local std::vector<uint8_t> raw;
+        if (!dict || !dict->unpack(buf.data(), buf.size(), raw) ||
+            raw[0] == (uint8_t)PacketID::ChunkPacked) {
+            Log::warn("MeshBuilder: dropped a chunk packed with a dictionary this session doesn't have");
+            Built dropped;
+            dropped.dropped = true;
+            return dropped;
+        }
+        return decode(raw, version, recvUs, true);
+    }, ThreadPool::Priority::Normal, cancel)
+    .onDone([this, cancel](TaskFuture<Built>& built) { finish(built, cancel); });
+}
+
+// The disk read is on the worker too, so the network thread only queues
+void MeshBuilder::submitCached(const ChunkCoord& c, uint32_t version, uint64_t hash) {
+    if (version) noteVersion(c, version);
+    _inFlight.fetch_add(1, std::memory_order_relaxed);
 
-        {
-            std::lock_guard lk(_readyMu);
-            _ready.push(std::move(mesh));
+    CancelToken cancel = token();
+    int64_t recvUs = Trace::on() ? Trace::nowUs() : 0;
+    _pool.async([this, c, version, hash, recvUs]() {
+        static thread_local std::vector<uint8_t> buf;
+        ChunkDiskCache* disk = _disk.load(std::memory_order_relaxed);
+        if (!disk || !disk->load(c, hash, buf)) {
+            Built missed;
+            missed.upload.coord = c;
+            missed.missed     = true;
+            return missed;
         }
-        _inFlight.fetch_sub(1, std::memory_order_relaxed);
-    });
+        return decode(buf, version, recvUs, false);
+    }, ThreadPool::Priority::Normal, cancel)
+    .onDone([this, cancel](TaskFuture<Built>& built) { finish(built, cancel); });
+}
+
+void MeshBuilder::noteVersion(const ChunkCoord& c, uint32_t version) {
+    std::lock_guard lk(_readyMu);
+    uint32_t& latest = _latest[c];
+    latest = std::max(latest, version);
+}
+
+// On a worker. store: keep the packet in the disk cache once it has decoded
+// (full-resolution chunks only, the ones ChunkHave can name)
+MeshBuilder::Built MeshBuilder::decode(const std::vector<uint8_t>& buf, uint32_t version,
+                                       int64_t recvUs, bool store) {
+    Built built{takeShell(), {}, 0, version, nullptr};
+    // Marched or decoded here, packed into the upload, then reused: the
+    // float mesh never leaves the worker
+    static thread_local ChunkMesh mesh;
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    mesh.meshlets.clear();
+    mesh.lod       = 0;
+    mesh.faceLinks = FACE_LINKS_ALL;
+    Trace::Span span("client.decode");
+    int64_t     startUs = recvUs ? Trace::nowUs() : 0;
+    bool        ok = true;
+    if (buf[0] == (uint8_t)PacketID::ChunkField && _gpuFields.load(std::memory_order_relaxed)) {
+        // The GPU marches it; a field that doesn't decode goes the CPU
+        // way, as an empty mesh
+        built.field = takeField();
+        ok = ChunkFieldPacket::deserialize(buf.data(), buf.size(), *built.field);
+        mesh.coord = built.field->coord;
+        if (ok) mesh.faceLinks = chunkFaceLinks(*built.field);
+        if (!ok) {
+            std::vector<std::unique_ptr<ChunkData>> bad;
+            bad.push_back(std::move(built.field));
+            recycleFields(bad);
+        }
+    } else if (buf[0] == (uint8_t)PacketID::ChunkField) {
+        // Density field — march it here, off the main thread. The field
+        // is ~200 KB, so each worker keeps one.
+        static thread_local std::unique_ptr<ChunkData> data;
+        if (!data) data = std::make_unique<ChunkData>();
+        ok = ChunkFieldPacket::deserialize(buf.data(), buf.size(), *data);
+        if (ok) {
+            MarchOptions opts;
+            opts.occlusion = true;
+            marchChunk(*data, mesh, opts);
+            optimizeMesh(mesh);
+        } else
+            mesh.coord = data->coord;
+    } else if (buf[0] == (uint8_t)PacketID::ChunkUniform) {
+        auto u = ChunkUniformPacket::deserialize(buf.data(), buf.size());
+        mesh.coord     = u.coord;
+        mesh.faceLinks = u.fill == ChunkData::Fill::Solid ? 0 : FACE_LINKS_ALL;
+    } else {
+        ChunkDataPacket::deserialize(buf.data(), buf.size(), mesh);
+    }
+    if (store && ok && mesh.lod == 0)
+        if (ChunkDiskCache* disk = _disk.load(std::memory_order_relaxed))
+            disk->store(mesh.coord, buf.data(), buf.size());
+    if (!built.field) buildMeshlets(mesh);
+    built.upload.pack(mesh);
+    // LOD meshes are only ever drawn; nothing stands on them. A GPU
+    // field's collider comes later, from submitCollider.
+    if (mesh.lod == 0 && !built.field)
+        built.collider.build(mesh.coord, built.upload.vertices, built.upload.indices);
+    // Only now is it known which chunk this was
+    span.key = {mesh.coord, mesh.lod};
+    if (recvUs) {
+        Trace::span("client.decode_wait", span.key, recvUs, startUs);
+        built.readyUs = Trace::nowUs();
+    }
+    return built;
+}
+
+void MeshBuilder::finish(TaskFuture<Built>& built, const CancelToken& cancel) {
+    if (built.ready() && !cancel.cancelled()) {
+        std::lock_guard lk(_readyMu);
+        Built& b = built.get();
+        if (b.missed)
+            _misses.push_back(b.upload.coord);
+        else if (!b.dropped)
+            (b.field ? _fields : _ready).push(std::move(b));
+    }
+    _inFlight.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void MeshBuilder::pollMisses(std::vector<ChunkCoord>& out) {
+    std::lock_guard lk(_readyMu);
+    out.insert(out.end(), _misses.begin(), _misses.end());
+    _misses.clear();
 }
 
-int MeshBuilder::poll(std::vector<ChunkMesh>& out, int maxPerFrame) {
+int MeshBuilder::poll(std::vector<ChunkUpload>& out, std::vector<ChunkCollider>& colliders,
+                      int maxPerFrame) {
     std::lock_guard lk(_readyMu);
     int n = 0;
+    int64_t now = Trace::on() ? Trace::nowUs() : 0;
+    std::vector<ChunkUpload> spent;
     while (!_ready.empty() && n < maxPerFrame) {
-        out.push_back(std::move(_ready.front()));
+        Built& b = _ready.front();
+        if (b.upload.lod == 0 && stale(b.upload.coord, b.version)) {
+            // Overtaken by a newer edit of the same chunk
+            spent.push_back(std::move(b.upload));
+            _ready.pop();
+            continue;
+        }
+        if (_ready.front().readyUs)
+            Trace::span("client.poll_wait", {_ready.front().upload.coord, _ready.front().upload.lod},
+                        _ready.front().readyUs, now);
+        out.push_back(std::move(_ready.front().upload));
+        colliders.push_back(std::move(_ready.front().collider));
         _ready.pop();
         n++;
     }
+    if (!spent.empty()) recycle(spent);
     return n;
 }
 
+bool MeshBuilder::stale(const ChunkCoord& c, uint32_t version) const {
+    if (_latest.empty()) return false;
+    auto it = _latest.find(c);
+    return it != _latest.end() && version < it->second;
+}
+
+int MeshBuilder::pollFields(std::vector<std::unique_ptr<ChunkData>>& out,
+                            std::vector<uint16_t>& faceLinks, int maxPerFrame) {
+    std::lock_guard lk(_readyMu);
+    int n = 0;
+    int64_t now = Trace::on() ? Trace::nowUs() : 0;
+    std::vector<std::unique_ptr<ChunkData>> spent;
+    while (!_fields.empty() && n < maxPerFrame) {
+        Built& b = _fields.front();
+        if (stale(b.upload.coord, b.version)) {
+            spent.push_back(std::move(b.field));
+        } else {
+            if (b.readyUs) Trace::span("client.poll_wait", {b.upload.coord, 0}, b.readyUs, now);
+            out.push_back(std::move(b.field));
+            faceLinks.push_back(b.upload.faceLinks);
+            n++;
+        }
+        if (b.upload.vertices.capacity() || b.upload.indices.capacity()) {
+            std::vector<ChunkUpload> shell;
+            shell.push_back(std::move(b.upload));
+            recycle(shell);
+        }
+        _fields.pop();
+    }
+    if (!spent.empty()) recycleFields(spent);
+    return n;
+}
+
+std::unique_ptr<ChunkData> MeshBuilder::takeField() {
+    {
+        std::lock_guard lk(_shellMu);
+        if (!_fieldShells.empty()) {
+            std::unique_ptr<ChunkData> f = std::move(_fieldShells.back());
+            _fieldShells.pop_back();
+            return f;
+        }
+    }
+    return std::make_unique<ChunkData>();
+}
+
+void MeshBuilder::recycleFields(std::vector<std::unique_ptr<ChunkData>>& v) {
+    std::lock_guard lk(_shellMu);
+    for (auto& f : v) {
+        if (_fieldShells.size() >= FIELDS_MAX) break;
+        if (f) _fieldShells.push_back(std::move(f));
+    }
+    v.clear();
+}
+
+void MeshBuilder::submitCollider(ChunkUpload&& upload) {
+    _inFlight.fetch_add(1, std::memory_order_relaxed);
+    CancelToken cancel = token();
+    _pool.async([this, upload = std::move(upload)]() mutable {
+        ChunkCollider c;
+        c.build(upload.coord, upload.vertices, upload.indices);
+        std::vector<ChunkUpload> shell;
+        shell.push_back(std::move(upload));
+        recycle(shell);
+        return c;
+    }, ThreadPool::Priority::Normal, cancel)
+    .onDone([this, cancel](TaskFuture<ChunkCollider>& c) {
+        if (c.ready() && !cancel.cancelled()) {
+            std::lock_guard lk(_readyMu);
+            _colliders.push_back(std::move(c.get()));
+        }
+        _inFlight.fetch_sub(1, std::memory_order_relaxed);
+    });
+}
+
+void MeshBuilder::pollColliders(std::vector<ChunkCollider>& out) {
+    std::lock_guard lk(_readyMu);
+    for (auto& c : _colliders) out.push_back(std::move(c));
+    _colliders.clear();
+}
+
+ChunkUpload MeshBuilder::takeShell() {
+    std::lock_guard lk(_shellMu);
+    if (_shells.empty()) return {};
+    ChunkUpload m = std::move(_shells.back());
+    _shells.pop_back();
+    return m;
+}
+
+void MeshBuilder::recycle(std::vector<ChunkUpload>& v) {
+    std::lock_guard lk(_shellMu);
+    for (ChunkUpload& m : v) {
+        if (_shells.size() >= SHELLS_MAX) break;
+        if (m.vertices.capacity() == 0 && m.indices.capacity() == 0) continue;
+        m.clear();
+        _shells.push_back(std::move(m));
+    }
+    v.clear();
+}
+
+CancelToken MeshBuilder::token() const {
+    std::lock_guard lk(_readyMu);
+    return _cancel;
+}
+
+void MeshBuilder::cancelPending() {
+    std::lock_guard lk(_readyMu);
+    _cancel.cancel();
+    _cancel = CancelToken::make();
+    _ready = {};
+    _fields = {};
+    _colliders.clear();
+    _misses.clear();
+    _latest.clear();
+}
+
 int MeshBuilder::pending() const {
     return _inFlight.load(std::memory_order_relaxed);
 }
@@ -0,0 +1,230 @@
+#include "net_thread.h"
+#include "log.h"
+#include "mem_tags.h"
+#include <stdexcept>
+
+void NetThread::start() {
+    _host = enet_host_create(nullptr, 1, Net::CHANNEL_COUNT, 0, 0);
+    if (!_host) throw std::runtime_error("enet_host_create (client) failed");
+    _dispatch.setFallback([this](ENetPeer*, const uint8_t* d, size_t len) {
+        emitMessage(d, len);
+    });
+    _running.store(true, std::memory_order_release);
+    _thread = std::thread([this] { run(); });
+}
+
+void NetThread::stop() {
+    if (!_thread.joinable()) return;
+    _running.store(false, std::memory_order_release);
+    _thread.join();
+    for (Command& c : _commandsWaiting)
+        if (c.packet) enet_packet_destroy(c.packet);
+    _commandsWaiting.clear();
+    for (Loopback::Message& m : _loopWaiting)
+        if (m.packet) enet_packet_destroy(m.packet);
+    _loopWaiting.clear();
+    enet_host_destroy(_host);
+    _host = nullptr;
+}
+
+// ── Game thread ───────────────────────────────────────────────────────────────
+
+void NetThread::command(Command&& c) {
+    while (!_commandsWaiting.empty() && _commands.push(std::move(_commandsWaiting.front())))
+        _commandsWaiting.pop_front();
+    if (!_commandsWaiting.empty() || !_commands.push(std::move(c)))
+        _commandsWaiting.push_back(std::move(c));
+}
+
+uint32_t NetThread::connect(const std::string& host, uint16_t port) {
+    Command c;
+    c.kind    = Command::Kind::Connect;
+    c.session = ++_nextSession;
+    c.host    = host;
+    c.port    = port;
+    command(std::move(c));
+    return _nextSession;
+}
+
+uint32_t NetThread::connect(Loopback& lb) {
+    Command c;
+    c.kind    = Command::Kind::Connect;
+    c.session = ++_nextSession;
+    c.loop    = &lb;
+    command(std::move(c));
+    return _nextSession;
+}
+
+void NetThread::sendReliable(const uint8_t* data, size_t len) {
+    Command c;
+    c.channel = Net::CHANNEL_RELIABLE;
+    c.packet  = enet_packet_create(data, len, ENET_PACKET_FLAG_RELIABLE);
+    if (c.packet) command(std::move(c));
+}
+
+void NetThread::sendMovement(const uint8_t* data, size_t len) {
+    Command c;
+    c.channel = Net::CHANNEL_MOVEMENT;
+    c.packet  = enet_packet_create(data, len, 0);
+    if (c.packet) command(std::move(c));
+}
+
+bool NetThread::poll(Event& out) {
+    // Sends held back by a full ring go out as soon as there's room
+    while (!_commandsWaiting.empty() && _commands.push(std::move(_commandsWaiting.front())))
+        _commandsWaiting.pop_front();
+    if (out.bytes.capacity() > KEEP_BYTES) out.bytes = {};
+    return _events.exchange(out);
+}
+
+// ── Network thread ────────────────────────────────────────────────────────────
+
+void NetThread::emit(Event&& ev) {
+    if (!_eventsWaiting.empty() || !_events.push(std::move(ev)))
+        _eventsWaiting.push_back(std::move(ev));
+}
+
+// Straight into the ring's next slot when nothing is held back, into the
+// buffer that slot last carried
+void NetThread::emitMessage(const uint8_t* d, size_t len) {
+    Event* ev = _eventsWaiting.empty() ? _events.claim() : nullptr;
+    if (!ev) {
+        emit({Event::Kind::Message, _session, std::vector<uint8_t>(d, d + len)});
+        return;
+    }
+    ev->kind    = Event::Kind::Message;
+    ev->session = _session;
+    ev->bytes.assign(d, d + len);
+    _events.publish();
+}
+
+void NetThread::flushEvents() {
+    while (!_eventsWaiting.empty() && _events.push(std::move(_eventsWaiting.front())))
+        _eventsWaiting.pop_front();
+}
+
+void NetThread::loopSend(Loopback::Message&& m) {
+    if (!_loopWaiting.empty() || !_loop->toServer.push(std::move(m)))
+        _loopWaiting.push_back(m);
+    _loop->wakeServer();
+}
+
+bool NetThread::pumpLoopback() {
+    while (!_loopWaiting.empty() && _loop->toServer.push(std::move(_loopWaiting.front())))
+        _loopWaiting.pop_front();
+    bool got = false;
+    Loopback::Message m;
+    while (_loop->toClient.pop(m)) {
+        if (m.id == _session && _state == State::Connected)
+            _dispatch.dispatch(nullptr, m.packet->data, m.packet->dataLength);
+        enet_packet_destroy(m.packet);
+        got = true;
+    }
+    return got;
+}
+
+// Tells the server we've gone, after whatever it still had of ours
+void NetThread::dropLoopback() {
+    pumpLoopback();
+    loopSend({Loopback::Message::Kind::Disconnect, _session});
+    _loop = nullptr;
+    for (Loopback::Message& m : _loopWaiting)
+        if (m.packet) enet_packet_destroy(m.packet);
+    _loopWaiting.clear();
+}
+
+void NetThread::execute(Command& c) {
+    if (c.kind == Command::Kind::Send) {
+        // Sends for a connection that has gone (or isn't up yet) are dropped
+        if (_loop && _state == State::Connected)
+            loopSend({Loopback::Message::Kind::Receive, _session, c.channel, c.packet});
+        else if (_state != State::Connected || enet_peer_send(_peer, c.channel, c.packet) < 0)
+            enet_packet_destroy(c.packet);
+        c.packet = nullptr;
+        return;
+    }
+
+    if (_peer) enet_peer_disconnect_now(_peer, 0);
+    if (_loop) dropLoopback();
+    _peer    = nullptr;
+    _state   = State::Idle;
+    _session = c.session;
+    if (_sessionStart) _sessionStart();
+
+    if (c.loop) {
+        _loop  = c.loop;
+        _state = State::Connected;
+        loopSend({Loopback::Message::Kind::Connect, _session});
+        emit({Event::Kind::Connected, _session, {}});
+        return;
+    }
+
+    ENetAddress addr{};
+    if (enet_address_set_host(&addr, c.host.c_str()) == 0) {
+        addr.port = c.port;
+        _peer     = enet_host_connect(_host, &addr, Net::CHANNEL_COUNT, 0);
+    }
+    if (!_peer) {
+        emit({Event::Kind::ConnectFailed, _session, {}});
+        return;
+    }
+    _state        = State::Connecting;
+    _connectStart = std::chrono::steady_clock::now();
+}
+
+void NetThread::handle(const ENetEvent& ev) {
+    if (ev.type == ENET_EVENT_TYPE_RECEIVE) {
+        if (ev.peer == _peer && _state == State::Connected)
+            _dispatch.dispatch(ev.peer, ev.packet->data, ev.packet->dataLength);
+        enet_packet_destroy(ev.packet);
+        return;
+    }
+    if (ev.peer != _peer) return; // an earlier connection winding down
+
+    if (ev.type == ENET_EVENT_TYPE_CONNECT) {
+        _state = State::Connected;
+        emit({Event::Kind::Connected, _session, {}});
+    } else if (ev.type == ENET_EVENT_TYPE_DISCONNECT) {
+        bool wasUp = _state == State::Connected;
+        _peer  = nullptr;
+        _state = State::Idle;
+        if (wasUp)
+            for (const auto& p : _dispatch.takeStats())
+                Log::info("Recv " + PacketDispatcher::format(p));
+        emit({wasUp ? Event::Kind::Disconnected : Event::Kind::ConnectFailed, _session, {}});
+    }
+}
+
+void NetThread::run() {
+    MemTags::exchange(MemTags::Packets);
+    Command c;
+    ENetEvent ev;
+    while (_running.load(std::memory_order_acquire)) {
+        while (_commands.pop(c)) execute(c);
+        flushEvents();
+        bool got = _loop && pumpLoopback();
+
+        // Waits for the socket up to SERVICE_MS, sending what was queued;
+        // not at all while a loopback has more coming
+        for (int r = enet_host_service(_host, &ev, got ? 0 : SERVICE_MS); r > 0;
+             r = enet_host_service(_host, &ev, 0))
+            handle(ev);
+
+        if (_state == State::Connecting &&
+            std::chrono::steady_clock::now() - _connectStart > CONNECT_TIMEOUT) {
+            enet_peer_reset(_peer);
+            _peer  = nullptr;
+            _state = State::Idle;
+            emit({Event::Kind::ConnectFailed, _session, {}});
+        }
+    }
+
+    // Whatever the game sent last (a final position, say) still goes out
+    while (_commands.pop(c))
+        if (c.kind == Command::Kind::Send) execute(c);
+    if (_loop) dropLoopback();
+    if (_peer) {
+        enet_peer_disconnect(_peer, 0);
+        enet_host_flush(_host);
+    }
+}
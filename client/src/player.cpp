@@ -5,74 +5,26 @@
 #include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 
-// ── SAT helpers ───────────────────────────────────────────────────────────────
-
-static float projectAABB(glm::vec3 n, glm::vec3 half) {
-    return std::abs(n.x)*half.x + std::abs(n.y)*half.y + std::abs(n.z)*half.z;
-}
-
-static bool axisTest(glm::vec3 axis, glm::vec3 centre, glm::vec3 half,
-                     glm::vec3 a, glm::vec3 b, glm::vec3 c,
-                     float& depth, glm::vec3& mtvAxis) {
-    float len2 = glm::dot(axis, axis);
-    if (len2 < 1e-8f) return true;
-    glm::vec3 n = axis / std::sqrt(len2);
-    float pa = glm::dot(n, a - centre), pb = glm::dot(n, b - centre), pc = glm::dot(n, c - centre);
-    float lo = std::min({pa,pb,pc}), hi = std::max({pa,pb,pc});
-    float r  = projectAABB(n, half);
-    if (lo > r || hi < -r) return false;
-    float overlap = std::min(r - lo, hi + r);
-    if (overlap < depth) { depth = overlap; mtvAxis = n; }
-    return true;
-}
-
-bool PlayerController::aabbTriTest(glm::vec3 mn, glm::vec3 mx,
-                                    glm::vec3 a, glm::vec3 b, glm::vec3 c,
-                                    glm::vec3& outMTV) const {
-    glm::vec3 half   = (mx - mn) * 0.5f;
-    glm::vec3 centre = (mn + mx) * 0.5f;
-    glm::vec3 ab = b-a, bc = c-b, ca = a-c;
-    float     depth  = 1e9f;
-    glm::vec3 mtvAxis{0,1,0};
-    glm::vec3 axes[3] = {{1,0,0},{0,1,0},{0,0,1}};
-
-    for (auto& ax : axes)
-        if (!axisTest(ax, centre, half, a, b, c, depth, mtvAxis)) return false;
-    if (!axisTest(glm::cross(ab, c-a), centre, half, a, b, c, depth, mtvAxis)) return false;
-    for (auto& e : {ab, bc, ca})
-        for (auto& ax : axes)
-            if (!axisTest(glm::cross(e, ax), centre, half, a, b, c, depth, mtvAxis)) return false;
-
-    if (glm::dot(mtvAxis, a - centre) > 0) mtvAxis = -mtvAxis;
-    outMTV = mtvAxis * depth;
-    return true;
-}
-
-// ── Möller–Trumbore ray-triangle intersection ─────────────────────────────────
-bool PlayerController::rayTriTest(glm::vec3 orig, glm::vec3 dir, float maxDist,
-                                   glm::vec3 a, glm::vec3 b, glm::vec3 c,
-                                   float& outT) const {
-    constexpr float EPS = 1e-7f;
-    glm::vec3 ab = b - a, ac = c - a;
-    glm::vec3 h  = glm::cross(dir, ac);
-    float det    = glm::dot(ab, h);
-    if (std::abs(det) < EPS) return false;
-    float invDet = 1.f / det;
-    glm::vec3 s  = orig - a;
-    float u      = glm::dot(s, h) * invDet;
-    if (u < 0.f || u > 1.f) return false;
-    glm::vec3 q  = glm::cross(s, ab);
-    float v      = glm::dot(dir, q) * invDet;
-    if (v < 0.f || u + v > 1.f) return false;
-    float t      = glm::dot(ac, q) * invDet;
-    if (t < EPS || t > maxDist) return false;
-    outT = t;
-    return true;
+// ── Collision queries ─────────────────────────────────────────────────────────
+void PlayerController::gatherTris(glm::vec3 mn, glm::vec3 mx) {
+    _near.clear();
+    float sz = (float)ChunkData::SIZE;
+    int x0 = (int)std::floor(mn.x / sz), x1 = (int)std::floor(mx.x / sz);
+    int y0 = (int)std::floor(mn.y / sz), y1 = (int)std::floor(mx.y / sz);
+    int z0 = (int)std::floor(mn.z / sz), z1 = (int)std::floor(mx.z / sz);
+    for (int cx = x0; cx <= x1; cx++)
+    for (int cy = y0; cy <= y1; cy++)
+    for (int cz = z0; cz <= z1; cz++) {
+        auto it = _colliders.find({cx, cy, cz});
+        if (it == _colliders.end()) continue;
+        const ChunkCollider& col = it->second;
+        col.query(mn, mx, [&](glm::vec3 a, glm::vec3 b, glm::vec3 c) { _near.push(a, b, c); });
+    }
 }
 
 // ── Raycast ground detection ──────────────────────────────────────────────────
 bool PlayerController::raycastGround(const CTransform& tf, const CAABB& box,
-                                      float& outHitY) const {
+                                      float& outHitY) {
     // Tighter parameters to avoid "floating" feel
     constexpr float RAY_START  = 0.02f;  // just barely above feet
     constexpr float RAY_LEN    = 0.25f;  // short ray — only detect ground very close
@@ -93,36 +45,19 @@ bool PlayerController::raycastGround(const CTransform& tf, const CAABB& box,
     };
     glm::vec3 dir{0.f, -1.f, 0.f};
 
-    int sz = ChunkData::SIZE;
-    int cx = (int)std::floor(tf.pos.x / sz);
-    int cy = (int)std::floor(tf.pos.y / sz);
-    int cz = (int)std::floor(tf.pos.z / sz);
-
     float bestT = maxDist + 1.f;
     bool  hit   = false;
 
-    for (int dx = -1; dx <= 1; dx++)
-    for (int dy = -1; dy <= 1; dy++)
-    for (int dz = -1; dz <= 1; dz++) {
-        auto it = _triSoups.find({cx+dx, cy+dy, cz+dz});
-        if (it == _triSoups.end()) continue;
-        const auto& tris = it->second.tris;
-        for (size_t i = 0; i + 2 < tris.size(); i += 3) {
-            glm::vec3 edge1 = tris[i+1] - tris[i];
-            glm::vec3 edge2 = tris[i+2] - tris[i];
-            glm::vec3 n = glm::cross(edge1, edge2);
-            if (n.y < 0.1f) continue;
-
-            for (auto& orig : origins) {
-                float t;
-                if (rayTriTest(orig, dir, maxDist, tris[i], tris[i+1], tris[i+2], t)) {
-                    if (t < bestT) {
-                        bestT   = t;
-                        outHitY = orig.y - t;
-                        hit     = true;
-                    }
-                }
-            }
+    // Only triangles under the footprint, across the length of the rays
+    gatherTris({tf.pos.x - inset, origY - maxDist, tf.pos.z - inset},
+               {tf.pos.x + inset, origY,           tf.pos.z + inset});
+    constexpr float MIN_NY = 0.1f; // unnormalised — skips walls and ceilings
+    for (auto& orig : origins) {
+        float t;
+        if (Collide::rayTris(orig, dir, maxDist, MIN_NY, _near, t) >= 0 && t < bestT) {
+            bestT   = t;
+            outHitY = orig.y - t;
+            hit     = true;
         }
     }
     if (hit == true){
@@ -148,33 +83,26 @@ PlayerController::PlayerController(entt::registry& reg, Camera& cam)
     reg.emplace<CInventory>(_player);
 }
 
-void PlayerController::addChunkMesh(const ChunkMesh& mesh) {
-    if (mesh.vertices.empty()) return;
-    ChunkTriSoup soup;
-    int sz = ChunkData::SIZE;
-    glm::vec3 offset{
-        (float)(mesh.coord.x * sz),
-        (float)(mesh.coord.y * sz),
-        (float)(mesh.coord.z * sz)
-    };
-    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
-        soup.tris.push_back(mesh.vertices[mesh.indices[i  ]].pos + offset);
-        soup.tris.push_back(mesh.vertices[mesh.indices[i+1]].pos + offset);
-        soup.tris.push_back(mesh.vertices[mesh.indices[i+2]].pos + offset);
-    }
-    _triSoups[mesh.coord] = std::move(soup);
+void PlayerController::addChunk(ChunkCollider&& collider) {
+    // Empty (uniform) chunks still register, so the spawn gate sees them
+    ChunkCoord cc = collider.coord;
+    _colliders[cc] = std::move(collider);
 }
 
 void PlayerController::removeChunk(ChunkCoord coord) {
-    _triSoups.erase(coord);
+    _colliders.erase(coord);
 }
 
 void PlayerController::setSpawnPosition(glm::vec3 pos) {
     _pendingSpawn    = pos;
     _hasPendingSpawn = true;
     _spawned         = false;
-    _triSoups.clear();
+    _colliders.clear();
     _smoothVel = {0.f, 0.f, 0.f};
+    // Corrections for inputs before this are about a path the server
+    // has since replaced
+    _spawnSeq    = (uint16_t)(_seq + 1);
+    _renderError = {0.f, 0.f, 0.f};
     buildRequiredChunks(pos);
 }
 
@@ -197,14 +125,14 @@ bool PlayerController::spawnChunksReady() const {
                            (int)std::floor(_pendingSpawn.y / N),
                            (int)std::floor(_pendingSpawn.z / N) };
     ChunkCoord belowSpawn{ atSpawn.x, atSpawn.y - 1, atSpawn.z };
-    return _triSoups.count(atSpawn) && _triSoups.count(belowSpawn);
+    return _colliders.count(atSpawn) && _colliders.count(belowSpawn);
 }
 
 float PlayerController::spawnProgress() const {
     if (_spawned || _requiredChunks.empty()) return _spawned ? 1.f : 0.f;
     int have = 0;
     for (const auto& cc : _requiredChunks)
-        if (_triSoups.count(cc)) have++;
+        if (_colliders.count(cc)) have++;
     return (float)have / (float)_requiredChunks.size();
 }
 
@@ -216,61 +144,60 @@ glm::vec3 PlayerController::position() const {
 void PlayerController::resolveCollision(CTransform& tf, CVelocity& vel,
                                          const CAABB& box, CGrounded& gr) {
     glm::vec3 half = box.half;
-    int sz = ChunkData::SIZE;
-    int cx = (int)std::floor(tf.pos.x / sz);
-    int cy = (int)std::floor(tf.pos.y / sz);
-    int cz = (int)std::floor(tf.pos.z / sz);
+
+    // Candidates once per substep, from a box with a block of slack on each
+    // side for the pushes below. Each iteration tests them all in one batch,
+    // then applies the hits in order; once the box has moved, a hit is
+    // re-tested against the new box before its push is applied.
+    constexpr float SWEEP_MARGIN = 1.f;
+    glm::vec3 reach = half + glm::vec3(SWEEP_MARGIN);
+    gatherTris(tf.pos - reach, tf.pos + reach);
+    if (_near.count == 0) return;
+    _hit.resize(_near.count);
+    _mtv.resize(_near.count);
 
     for (int iter = 0; iter < 4; iter++) {
         glm::vec3 mn = tf.pos - half;
         glm::vec3 mx = tf.pos + half;
 
-        for (int dx = -1; dx <= 1; dx++)
-        for (int dy = -1; dy <= 1; dy++)
-        for (int dz = -1; dz <= 1; dz++) {
-            auto it = _triSoups.find({cx+dx, cy+dy, cz+dz});
-            if (it == _triSoups.end()) continue;
-            for (size_t i = 0; i + 2 < it->second.tris.size(); i += 3) {
-                glm::vec3 mtv;
-                if (!aabbTriTest(mn, mx,
-                        it->second.tris[i], it->second.tris[i+1], it->second.tris[i+2],
-                        mtv)) continue;
-
-                glm::vec3 mtvN = glm::normalize(mtv);
-
-                // If pushing upward, mark grounded
-                if (mtvN.y > 0.7f) {
-                    gr.grounded = true;
-                    mtv  = glm::vec3(0.f, mtv.y, 0.f);
-                    mtvN = glm::vec3(0.f, 1.f, 0.f);
-                } else if (std::abs(mtvN.y) > 0.7f) {
-                    mtv  = glm::vec3(0.f, mtv.y, 0.f);
-                    mtvN = glm::vec3(0.f, mtvN.y < 0.f ? -1.f : 1.f, 0.f);
-                }
-
-                tf.pos += mtv;
-                mn = tf.pos - half;
-                mx = tf.pos + half;
-
-                float vDot = glm::dot(vel.vel, mtvN);
-                if (vDot < 0.f) vel.vel -= mtvN * vDot;
+        if (Collide::boxTris(mn, mx, _near, _hit.data(), _mtv.data()) == 0) break;
+        bool moved = false;
+        for (uint32_t i = 0; i < _near.count; i++) {
+            if (!_hit[i]) continue;
+            glm::vec3 mtv = _mtv[i];
+            if (moved && !Collide::boxTri(mn, mx, _near, i, mtv)) continue;
+
+            glm::vec3 mtvN = glm::normalize(mtv);
+
+            // If pushing upward, mark grounded
+            if (mtvN.y > 0.7f) {
+                gr.grounded = true;
+                mtv  = glm::vec3(0.f, mtv.y, 0.f);
+                mtvN = glm::vec3(0.f, 1.f, 0.f);
+            } else if (std::abs(mtvN.y) > 0.7f) {
+                mtv  = glm::vec3(0.f, mtv.y, 0.f);
+                mtvN = glm::vec3(0.f, mtvN.y < 0.f ? -1.f : 1.f, 0.f);
             }
+
+            tf.pos += mtv;
+            mn = tf.pos - half;
+            mx = tf.pos + half;
+            moved = true;
+
+            float vDot = glm::dot(vel.vel, mtvN);
+            if (vDot < 0.f) vel.vel -= mtvN * vDot;
         }
     }
 }
 
-void PlayerController::update(float dt, const Input& input, CombatSystem* combat) {
+void PlayerController::update(float dt, const InputState& input, CombatSystem* combat) {
     // ── Spawn gate ────────────────────────────────────────────────────────────
     if (!_spawned) {
-        if (spawnChunksReady()) {
-            _reg.get<CTransform>(_player).pos = _pendingSpawn;
-            _reg.get<CVelocity> (_player).vel = {0.f, 0.f, 0.f};
-            _hasPendingSpawn = false;
-            _spawned         = true;
-        } else {
-            _cam.applyMouse(input.mouseDelta());
-            return;
-        }
+        if (!spawnChunksReady()) return;
+        _reg.get<CTransform>(_player).pos = _pendingSpawn;
+        _reg.get<CVelocity> (_player).vel = {0.f, 0.f, 0.f};
+        _hasPendingSpawn = false;
+        _spawned         = true;
     }
 
     auto& tf  = _reg.get<CTransform>(_player);
@@ -280,29 +207,24 @@ void PlayerController::update(float dt, const Input& input, CombatSystem* combat
     auto& sta = _reg.get<CStamina>  (_player);
     auto& hp  = _reg.get<CHealth>   (_player);
 
-    if (hp.dead) {
-        _cam.applyMouse(input.mouseDelta());
-        return;
-    }
+    if (hp.dead) return;
 
     // ── Chunk unload ──────────────────────────────────────────────────────────
     {
         int cx = (int)std::floor(tf.pos.x / ChunkData::SIZE);
         int cy = (int)std::floor(tf.pos.y / ChunkData::SIZE);
         int cz = (int)std::floor(tf.pos.z / ChunkData::SIZE);
-        for (auto it = _triSoups.begin(); it != _triSoups.end(); ) {
+        for (auto it = _colliders.begin(); it != _colliders.end(); ) {
             const auto& cc = it->first;
-            if (std::abs(cc.x - cx) > Config::CHUNK_RADIUS_XZ + 1 ||
-                std::abs(cc.y - cy) > Config::CHUNK_RADIUS_Y  + 1 ||
-                std::abs(cc.z - cz) > Config::CHUNK_RADIUS_XZ + 1)
-                it = _triSoups.erase(it);
+            if (std::abs(cc.x - cx) > Config::CHUNK_KEEP_XZ ||
+                std::abs(cc.y - cy) > Config::CHUNK_KEEP_Y  ||
+                std::abs(cc.z - cz) > Config::CHUNK_KEEP_XZ)
+                it = _colliders.erase(it);
             else
                 ++it;
         }
     }
 
-    _cam.applyMouse(input.mouseDelta());
-
     // ── Wish direction ────────────────────────────────────────────────────────
     glm::vec3 fwd = _cam.forward(); fwd.y = 0.f;
     float fwdLen = glm::length(fwd);
@@ -372,6 +294,52 @@ void PlayerController::update(float dt, const Input& input, CombatSystem* combat
              !movingFwd && !movingBack)    speedMult = 0.85f;
     float targetSpeed = baseSpeed * speedMult;
 
+    // ── Predict ───────────────────────────────────────────────────────────────
+    MoveInput in;
+    in.dt      = dt;
+    in.moving  = wishLen > 0.001f;
+    in.target  = wishDir * (in.moving ? targetSpeed : 0.f);
+    in.jump    = input.keyDown(GLFW_KEY_SPACE)
+                 && !sta.depleted
+                 && sta.current >= sta.jumpCost
+                 && atk.isIdle()
+                 && !dod.isRolling();
+    in.rolling = dod.isRolling() && combat;
+    if (in.rolling) in.dodgeVel = combat->getDodgeVelocity(_player);
+
+    if (simulate(in)) sta.current -= sta.jumpCost;
+
+    _seq++;
+    Predicted& p = _history[_seq % _history.size()];
+    p.seq   = _seq;
+    p.in    = in;
+    p.after = captureState();
+
+    // ── Head bob ──────────────────────────────────────────────────────────────
+    if (gr.grounded && wishLen > 0.001f) {
+        static float bobTime = 0.f;
+        float speed = glm::length(glm::vec3{vel.vel.x, 0.f, vel.vel.z});
+        bobTime += dt * speed * 0.4f;
+        float bobY = std::sin(bobTime * 2.f) * 0.04f;
+        float bobX = std::sin(bobTime) * 0.02f;
+        _cam.position.y += bobY;
+        _cam.position += _cam.right() * bobX;
+    }
+
+    // Eases out over ~0.1 s
+    _renderError *= std::exp(-dt / 0.1f);
+    _cam.position = tf.pos + _renderError + glm::vec3{0.f, box.half.y * 0.85f, 0.f};
+}
+
+// ── Prediction ────────────────────────────────────────────────────────────────
+bool PlayerController::simulate(const MoveInput& in) {
+    auto& tf  = _reg.get<CTransform>(_player);
+    auto& vel = _reg.get<CVelocity> (_player);
+    auto& box = _reg.get<CAABB>     (_player);
+    auto& gr  = _reg.get<CGrounded> (_player);
+    float dt  = in.dt;
+    bool  jumped = false;
+
     // ── Gravity ───────────────────────────────────────────────────────────────
     constexpr float MAX_FALL = 60.f;
     if (!gr.grounded) {
@@ -395,8 +363,6 @@ void PlayerController::update(float dt, const Input& input, CombatSystem* combat
     bool rayHit = raycastGround(tf, box, hitY);
 
     if (rayHit && vel.vel.y <= 0.01f) {
-        float footY = tf.pos.y - box.half.y;
-        float snapDist = hitY - footY + box.half.y;
         // Only snap if very close (within ray range)
         if (std::abs(tf.pos.y - (hitY + box.half.y)) < 0.20f) {
             tf.pos.y = hitY + box.half.y;
@@ -406,52 +372,72 @@ void PlayerController::update(float dt, const Input& input, CombatSystem* combat
     }
 
     // ── Horizontal movement ───────────────────────────────────────────────────
-    if (dod.isRolling() && combat) {
-        glm::vec3 dv = combat->getDodgeVelocity(_player);
-        _smoothVel.x = dv.x;
-        _smoothVel.z = dv.z;
+    if (in.rolling) {
+        _smoothVel.x = in.dodgeVel.x;
+        _smoothVel.z = in.dodgeVel.z;
     } else if (gr.grounded) {
-        glm::vec3 targetHoriz = wishDir * (wishLen > 0.001f ? targetSpeed : 0.f);
-
-        float accel  = (wishLen > 0.001f) ? Config::GROUND_ACCEL : Config::FRICTION;
+        float accel  = in.moving ? Config::GROUND_ACCEL : Config::FRICTION;
         float blend  = std::min(accel * dt, 1.f);
-        _smoothVel.x += (targetHoriz.x - _smoothVel.x) * blend;
-        _smoothVel.z += (targetHoriz.z - _smoothVel.z) * blend;
+        _smoothVel.x += (in.target.x - _smoothVel.x) * blend;
+        _smoothVel.z += (in.target.z - _smoothVel.z) * blend;
 
         vel.vel.x = _smoothVel.x;
         vel.vel.z = _smoothVel.z;
 
         // Jump
-        if (input.keyDown(GLFW_KEY_SPACE)
-            && !sta.depleted
-            && sta.current >= sta.jumpCost
-            && atk.isIdle()
-            && !dod.isRolling())
-        {
-            sta.current -= sta.jumpCost;
+        if (in.jump) {
             vel.vel.y   = Config::JUMP_VEL;
             gr.grounded = false;
+            jumped      = true;
         }
     } else {
         // Air control
-        glm::vec3 targetHoriz = wishDir * (wishLen > 0.001f ? targetSpeed : 0.f);
         float blend = std::min(Config::AIR_ACCEL * dt, 1.f);
-        _smoothVel.x += (targetHoriz.x - _smoothVel.x) * blend;
-        _smoothVel.z += (targetHoriz.z - _smoothVel.z) * blend;
+        _smoothVel.x += (in.target.x - _smoothVel.x) * blend;
+        _smoothVel.z += (in.target.z - _smoothVel.z) * blend;
         vel.vel.x = _smoothVel.x;
         vel.vel.z = _smoothVel.z;
     }
+    return jumped;
+}
 
-    // ── Head bob ──────────────────────────────────────────────────────────────
-    if (gr.grounded && wishLen > 0.001f) {
-        static float bobTime = 0.f;
-        float speed = glm::length(glm::vec3{vel.vel.x, 0.f, vel.vel.z});
-        bobTime += dt * speed * 0.4f;
-        float bobY = std::sin(bobTime * 2.f) * 0.04f;
-        float bobX = std::sin(bobTime) * 0.02f;
-        _cam.position.y += bobY;
-        _cam.position += _cam.right() * bobX;
-    }
+PlayerController::MoveState PlayerController::captureState() const {
+    return {_reg.get<CTransform>(_player).pos, _reg.get<CVelocity>(_player).vel,
+            _smoothVel, _reg.get<CGrounded>(_player).grounded};
+}
+
+void PlayerController::restoreState(const MoveState& st) {
+    _reg.get<CTransform>(_player).pos      = st.pos;
+    _reg.get<CVelocity> (_player).vel      = st.vel;
+    _reg.get<CGrounded> (_player).grounded = st.grounded;
+    _smoothVel = st.smoothVel;
+}
 
-    _cam.position = tf.pos + glm::vec3{0.f, box.half.y * 0.85f, 0.f};
+void PlayerController::applyCorrection(const MoveCorrectionPacket& c) {
+    // Lost, duplicated and reordered corrections: only a newer epoch counts
+    if ((int8_t)(c.epoch - _epoch) <= 0) return;
+    _epoch = c.epoch;
+    // Taken on board, but about a path from before the latest spawn
+    if (!_spawned || (int16_t)(c.seq - _spawnSeq) < 0) return;
+    int behind = (int16_t)(_seq - c.seq);
+    if (behind < 0) return;
+    _corrections++;
+
+    glm::vec3 was = position();
+    Predicted& at = _history[c.seq % _history.size()];
+    if (behind >= (int)_history.size() || at.seq != c.seq) {
+        // Too far back to replay: the server's word as it stands
+        restoreState({c.pos, c.vel, {c.vel.x, 0.f, c.vel.z}, false});
+    } else {
+        at.after.pos = c.pos;
+        at.after.vel = c.vel;
+        at.after.smoothVel = {c.vel.x, 0.f, c.vel.z};
+        restoreState(at.after);
+        for (uint16_t s = (uint16_t)(c.seq + 1); s != (uint16_t)(_seq + 1); s++) {
+            Predicted& p = _history[s % _history.size()];
+            simulate(p.in);
+            p.after = captureState();
+        }
+    }
+    _renderError += was - position();
 }
@@ -0,0 +1,261 @@
+#include "render_bench.h"
+#include "asset_path.h"
+#include "camera.h"
+#include "chunk_codec.h"
+#include "config.h"
+#include "far_terrain.h"
+#include "log.h"
+#include "mesh_builder.h"
+#include "packets.h"
+#include "render_capture.h"
+#include "vk_context.h"
+#include "window.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Noon, so the shadows and the lighting cost what they do by day
+const glm::vec3 SUN_DIR   = glm::normalize(glm::vec3(0.3f, 1.f, 0.2f));
+const glm::vec3 SKY_COLOR = {0.45f, 0.65f, 0.95f};
+
+// --bench-lights: n lights spread over a disc round the eye, a golden
+// angle apart, the same every frame — what the clustered lighting costs
+// as the count grows
+void scatterLights(VkContext& ctx, glm::vec3 eye, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        float      r = 64.f * std::sqrt((i + 0.5f) / (float)n);
+        float      a = (float)i * 2.39996323f;
+        PointLight l;
+        l.pos       = eye + glm::vec3(r * std::cos(a), -2.f, r * std::sin(a));
+        l.radius    = 6.f;
+        l.color     = {1.f, 0.5f + 0.5f * std::sin(a), 0.5f + 0.5f * std::cos(a)};
+        l.intensity = 1.5f;
+        vk_add_light(ctx, l);
+    }
+}
+
+float pct(std::vector<float> v, float p) {
+    if (v.empty()) return 0.f;
+    size_t i = std::min(v.size() - 1, (size_t)(p * (float)(v.size() - 1) + 0.5f));
+    std::nth_element(v.begin(), v.begin() + (ptrdiff_t)i, v.end());
+    return v[i];
+}
+
+void writeTimes(FILE* f, const char* name, const std::vector<float>& ms, bool last) {
+    float worst = ms.empty() ? 0.f : *std::max_element(ms.begin(), ms.end());
+    fprintf(f, "    \"%s\": {\"frames\": %zu, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, "
+               "\"max\": %.3f}%s\n",
+            name, ms.size(), pct(ms, 0.50f), pct(ms, 0.90f), pct(ms, 0.99f), worst, last ? "" : ",");
+}
+
+// This process's use of the device-local heaps
+VkDeviceSize deviceLocalUsage(VmaAllocator alloc) {
+    const VkPhysicalDeviceMemoryProperties* mem = nullptr;
+    vmaGetMemoryProperties(alloc, &mem);
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(alloc, budgets);
+    VkDeviceSize used = 0;
+    for (uint32_t h = 0; h < mem->memoryHeapCount; h++)
+        if (mem->memoryHeaps[h].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) used += budgets[h].usage;
+    return used;
+}
+
+} // namespace
+
+int runRenderBench(const RenderBenchOptions& opt) {
+    RenderCapture::Reader capture;
+    if (!capture.open(opt.capture.c_str())) return 1;
+    const auto& frames = capture.frames();
+    if (frames.empty()) {
+        Log::err("Render bench: " + opt.capture + " has no frames");
+        return 1;
+    }
+    Log::info("Render bench: " + std::to_string(frames.size()) + " frames, " +
+              std::to_string(capture.bytes() >> 10) + " KB");
+
+    Window    window((int)opt.width, (int)opt.height, "Aetheris bench", false);
+    VkContext ctx = vk_init(window.handle(), opt.gpuMesh, {opt.width, opt.height});
+    vk_load_atlas(ctx, AssetPath::get("atlas.png").c_str());
+    ctx.shaderTier = (ShaderTier)opt.shaderTier;
+    vk_build_pipelines(ctx);
+    ctx.pipelinesReady = true;
+
+    MeshBuilder meshBuilder(1); // as many workers as the game's
+    meshBuilder.setGpuFields(opt.gpuMesh);
+    FarTerrain farTerrain;
+    Camera     camera;
+    ViewTiers  viewTiers;
+    ChunkCoord residentCenter{INT_MIN, INT_MIN, INT_MIN};
+    ViewTiers  residentTiers;
+
+    std::vector<ChunkUpload>                readyMeshes;
+    std::vector<ChunkCollider>              readyColliders;
+    std::vector<std::unique_ptr<ChunkData>> readyFields;
+    std::vector<uint16_t>                   readyLinks;
+    std::vector<ChunkUpload>                gpuMeshed;
+    std::vector<ChunkKey>                   dropped;
+    size_t spaceMisses = 0;
+
+    std::vector<float> cpuMs, gpuMs;
+    cpuMs.reserve(frames.size());
+    gpuMs.reserve(frames.size());
+    VkDeviceSize vramPeak = 0;
+    const float  aspect   = (float)opt.width / (float)opt.height;
+    vk_set_sun(ctx, SUN_DIR);
+
+    auto started = Clock::now();
+    double busyS = 0.0;
+    // The last pose again for FRAMES_IN_FLIGHT frames, for the GPU times
+    // of the real ones
+    const size_t total = frames.size() + VkContext::FRAMES_IN_FLIGHT;
+    for (size_t i = 0; i < total; i++) {
+        const bool tail = i >= frames.size();
+        const RenderCapture::Frame& fr = frames[std::min(i, frames.size() - 1)];
+        vk_wait_frame(ctx);
+        ctx.profiler.beginFrame();
+
+        // ── Feed ──────────────────────────────────────────────────────────
+        if (!tail) {
+            for (const RenderCapture::Packet& p : fr.packets) {
+                switch ((PacketID)p.data[0]) {
+                    case PacketID::ChunkDict: {
+                        ChunkDictPacket pkt;
+                        if (!ChunkDictPacket::deserialize(p.data, p.len, pkt)) break;
+                        meshBuilder.setDictionary(ChunkDict::load(
+                            (ChunkCodec)pkt.codec, std::vector<uint8_t>(pkt.bytes, pkt.bytes + pkt.size)));
+                        break;
+                    }
+                    case PacketID::ViewConfig: {
+                        ViewConfigPacket vc;
+                        if (ViewConfigPacket::deserialize(p.data, p.len, vc)) viewTiers = vc.tiers;
+                        break;
+                    }
+                    default:
+                        meshBuilder.submit(p.data, p.len);
+                }
+            }
+            while (meshBuilder.pending() > 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        auto t0 = Clock::now();
+
+        // ── Residency, as the game's ──────────────────────────────────────
+        const glm::vec3  ppos = fr.pose.player;
+        const ChunkCoord center{(int)std::floor(ppos.x / ChunkData::SIZE),
+                                (int)std::floor(ppos.y / ChunkData::SIZE),
+                                (int)std::floor(ppos.z / ChunkData::SIZE)};
+        auto resident = [&](const ChunkKey& k) {
+            if (!fr.pose.spawned) return true;
+            if (viewTiers.levels > 0) return viewTiers.wants(k, center);
+            const ChunkCoord& c = k.coord;
+            return k.lod == 0 && std::abs(c.x - center.x) <= viewTiers.r + 1 &&
+                   std::abs(c.y - center.y) <= viewTiers.ry + 1 && std::abs(c.z - center.z) <= viewTiers.r + 1;
+        };
+
+        readyMeshes.clear();
+        readyColliders.clear();
+        meshBuilder.poll(readyMeshes, readyColliders, INT_MAX);
+        for (ChunkUpload& mesh : readyMeshes) {
+            if (!resident({mesh.coord, mesh.lod})) {
+                ctx.spentMeshes.push_back(std::move(mesh));
+                continue;
+            }
+            if (mesh.lod == 0 && mesh.vertices.empty()) vk_remove_chunk(ctx, {mesh.coord, 0});
+            vk_upload_chunk(ctx, std::move(mesh));
+        }
+        if (opt.gpuMesh) {
+            // Fields wait for free jobs as in the game; their colliders
+            // aren't wanted here
+            readyFields.clear();
+            readyLinks.clear();
+            meshBuilder.pollFields(readyFields, readyLinks, vk_gpu_mesh_free(ctx));
+            for (size_t f = 0; f < readyFields.size(); f++)
+                if (resident({readyFields[f]->coord, 0})) vk_gpu_mesh_chunk(ctx, *readyFields[f], readyLinks[f]);
+            meshBuilder.recycleFields(readyFields);
+            gpuMeshed.clear();
+            vk_take_gpu_meshed(ctx, gpuMeshed);
+            for (ChunkUpload& mesh : gpuMeshed) ctx.spentMeshes.push_back(std::move(mesh));
+        }
+        if (fr.pose.spawned && (center != residentCenter || viewTiers != residentTiers)) {
+            residentCenter = center;
+            residentTiers  = viewTiers;
+            dropped.clear();
+            vk_evict_chunks(ctx, resident, dropped);
+        }
+        meshBuilder.recycle(ctx.spentMeshes);
+        dropped.clear();
+        vk_take_space_misses(ctx, dropped);
+        spaceMisses += dropped.size();
+
+        // ── Draw ──────────────────────────────────────────────────────────
+        camera.position = fr.pose.eye;
+        camera.yaw      = fr.pose.yaw;
+        camera.pitch    = fr.pose.pitch;
+        vk_set_upload_focus(ctx, ppos);
+        if (fr.pose.spawned) {
+            ViewBox top  = viewTiers.region(viewTiers.levels, center);
+            float   cell = (float)(ChunkData::SIZE << viewTiers.levels);
+            farTerrain.update(camera.position, glm::vec2((float)top.lo.x, (float)top.lo.z) * cell,
+                              glm::vec2((float)top.hi.x + 1, (float)top.hi.z + 1) * cell);
+        }
+        if (fr.pose.spawned) scatterLights(ctx, camera.position, opt.lights);
+        vk_draw(ctx, camera.viewProj(aspect), 1.f, SKY_COLOR, nullptr, camera.proj(aspect), nullptr,
+                fr.pose.spawned ? &farTerrain : nullptr, camera.farViewProj(aspect));
+        auto t1 = Clock::now();
+
+        // What this draw collected is FRAMES_IN_FLIGHT frames old
+        float ms;
+        if (i >= (size_t)VkContext::FRAMES_IN_FLIGHT && ctx.profiler.latestGpu(FrameProfiler::GpuFrame, ms))
+            gpuMs.push_back(ms);
+        if (!tail) {
+            cpuMs.push_back(std::chrono::duration<float, std::milli>(t1 - t0).count());
+            busyS += std::chrono::duration<double>(t1 - t0).count();
+        }
+        vmaSetCurrentFrameIndex(ctx.allocator, (uint32_t)i);
+        vramPeak = std::max(vramPeak, deviceLocalUsage(ctx.allocator));
+    }
+    vkDeviceWaitIdle(ctx.device.device);
+    const double wallS = std::chrono::duration<double>(Clock::now() - started).count();
+    // Throughput over the frames' own time: the meshing waits are the
+    // replay's, not the game's
+    const double mb    = (double)ctx.bytesUploaded / (1024.0 * 1024.0);
+
+    FILE* f = opt.out.empty() ? stdout : fopen(opt.out.c_str(), "w");
+    if (!f) {
+        Log::err("Render bench: can't write " + opt.out);
+        vk_destroy(ctx);
+        return 1;
+    }
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    fprintf(f, "{\n  \"context\": {\n");
+    fprintf(f, "    \"date\": \"%s\",\n", date);
+    fprintf(f, "    \"capture\": \"%s\",\n", opt.capture.c_str());
+    fprintf(f, "    \"device\": \"%s\",\n", ctx.device.physical_device.properties.deviceName);
+    fprintf(f, "    \"width\": %u,\n    \"height\": %u,\n", opt.width, opt.height);
+    fprintf(f, "    \"gpu_mesh\": %s,\n", opt.gpuMesh ? "true" : "false");
+    fprintf(f, "    \"shader_tier\": %d,\n", opt.shaderTier);
+    fprintf(f, "    \"lights\": %u,\n", opt.lights);
+    fprintf(f, "    \"chunk_size\": %d\n  },\n  \"results\": {\n", Config::CHUNK_SIZE);
+    writeTimes(f, "cpu_frame_ms", cpuMs, false);
+    writeTimes(f, "gpu_frame_ms", gpuMs, false);
+    fprintf(f, "    \"wall_s\": %.3f,\n", wallS);
+    fprintf(f, "    \"uploaded_mb\": %.2f,\n", mb);
+    fprintf(f, "    \"upload_mb_per_s\": %.2f,\n", busyS > 0.0 ? mb / busyS : 0.0);
+    fprintf(f, "    \"chunks_dropped\": %zu,\n", spaceMisses);
+    fprintf(f, "    \"vram_peak_mb\": %.2f\n  }\n}\n", (double)vramPeak / (1024.0 * 1024.0));
+    if (f != stdout) fclose(f);
+    Log::info("Render bench: CPU p50 " + std::to_string(pct(cpuMs, 0.5f)) + " ms, GPU p50 " +
+              std::to_string(pct(gpuMs, 0.5f)) + " ms");
+
+    vk_destroy(ctx);
+    return 0;
+}
@@ -0,0 +1,252 @@
+#include "render_graph.h"
+#include "log.h"
+
+namespace {
+
+constexpr VkAccessFlags WRITES =
+    VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
+    VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+} // namespace
+
+// ── Lifetime ──────────────────────────────────────────────────────────────────
+
+void RenderGraph::init(VkDevice dev, uint32_t queueFamily, uint32_t frames, ThreadPool* pool) {
+    _dev    = dev;
+    _family = queueFamily;
+    _pool   = pool;
+    _cmdPools.assign(frames, {});
+    _cmds.assign(frames, {});
+}
+
+void RenderGraph::destroy() {
+    for (auto& pools : _cmdPools)
+        for (VkCommandPool p : pools) vkDestroyCommandPool(_dev, p, nullptr);
+    _cmdPools.clear();
+    _cmds.clear();
+}
+
+// ── Building ──────────────────────────────────────────────────────────────────
+
+void RenderGraph::reset(uint32_t frame, TickArena& arena) {
+    _frame = frame;
+    _arena = &arena;
+    for (VkCommandPool p : _cmdPools[frame]) vkResetCommandPool(_dev, p, 0);
+    _res.clear();
+    _passes = std::deque<Pass, ArenaAllocator<Pass>>(ArenaAllocator<Pass>(_arena));
+}
+
+RenderGraph::Resource RenderGraph::memory(const char* name, State prior) {
+    return image(name, VK_NULL_HANDLE, 0, prior);
+}
+
+RenderGraph::Resource RenderGraph::image(const char* name, VkImage image, VkImageAspectFlags aspect,
+                                         State prior) {
+    Res r{};
+    r.name   = name;
+    r.image  = image;
+    r.aspect = aspect;
+    if (prior.access & WRITES) {
+        r.writeStage  = prior.stage;
+        r.writeAccess = prior.access & WRITES;
+    } else {
+        r.readStages = prior.stage;
+    }
+    r.layout = prior.layout;
+    _res.push_back(r);
+    return (Resource)(_res.size() - 1);
+}
+
+RenderGraph::Pass& RenderGraph::add(const char* name) {
+    Pass& p = _passes.emplace_back(_arena);
+    p.name  = name;
+    return p;
+}
+
+// ── Compile ───────────────────────────────────────────────────────────────────
+// Back to front: a pass is kept if it's a root or writes something a kept
+// pass after it reads. Conservative — an earlier writer a later one
+// overwrites whole is kept too.
+
+void RenderGraph::compile() {
+    _needed.assign(_res.size(), false);
+    _alive.assign(_passes.size(), false);
+    _kept = 0;
+    for (size_t i = _passes.size(); i-- > 0;) {
+        const Pass& p = _passes[i];
+        bool keep = p.root;
+        for (const Use& w : p.writes) keep = keep || _needed[w.res];
+        if (!keep) continue;
+        _alive[i] = true;
+        _kept++;
+        for (const Use& r : p.reads) _needed[r.res] = true;
+        for (const Use& w : p.writes)
+            if (w.access & ~WRITES) _needed[w.res] = true;
+        if (p.begin.renderPass == VK_NULL_HANDLE && p.records.size() != 1)
+            Log::warn(std::string("Render graph: pass ") + p.name + " needs exactly one record");
+    }
+}
+
+// ── Barriers ──────────────────────────────────────────────────────────────────
+// Everything before the pass it depends on, in one vkCmdPipelineBarrier: a
+// global memory barrier for the buffers, image barriers where a layout
+// changes
+
+void RenderGraph::barriers(VkCommandBuffer cmd, const Pass& p) {
+    VkPipelineStageFlags src = 0, dst = 0;
+    VkMemoryBarrier mb{};
+    mb.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    _imageBarriers.clear();
+
+    auto use = [&](const Use& u, bool write) {
+        Res& r = _res[u.res];
+        VkPipelineStageFlags waits   = 0;
+        VkAccessFlags        flushes = 0;
+        // Read after write unless an earlier barrier already made it
+        // visible here; write after write always
+        if (r.writeAccess && (write || (u.stage & ~r.visibleStages) ||
+                              (u.access & ~r.visibleAccess))) {
+            waits   |= r.writeStage;
+            flushes |= r.writeAccess;
+        }
+        // Write after read: only the reads to wait out
+        if (write) waits |= r.readStages;
+
+        bool transition = r.image && u.layout != VK_IMAGE_LAYOUT_UNDEFINED && u.layout != r.layout;
+        if (transition) {
+            VkImageMemoryBarrier b{};
+            b.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            b.srcAccessMask       = r.writeAccess;
+            b.dstAccessMask       = u.access;
+            b.oldLayout           = r.layout;
+            b.newLayout           = u.layout;
+            b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b.image               = r.image;
+            b.subresourceRange    = {r.aspect, 0, VK_REMAINING_MIP_LEVELS, 0,
+                                     VK_REMAINING_ARRAY_LAYERS};
+            _imageBarriers.push_back(b);
+            src |= r.writeStage | r.readStages;
+            dst |= u.stage;
+        } else if (waits) {
+            src |= waits;
+            dst |= u.stage;
+            mb.srcAccessMask |= flushes;
+            if (flushes) mb.dstAccessMask |= u.access;
+        }
+
+        if (write) {
+            r.writeStage    = u.stage;
+            r.writeAccess   = u.access & WRITES;
+            r.readStages    = 0;
+            r.visibleStages = 0;
+            r.visibleAccess = 0;
+        } else {
+            if (flushes || transition) {
+                r.visibleStages |= u.stage;
+                r.visibleAccess |= u.access;
+            }
+            r.readStages |= u.stage;
+        }
+        if (r.image) {
+            if (u.after != VK_IMAGE_LAYOUT_UNDEFINED)
+                r.layout = u.after;
+            else if (u.layout != VK_IMAGE_LAYOUT_UNDEFINED)
+                r.layout = u.layout;
+        }
+    };
+    for (const Use& u : p.reads) use(u, false);
+    for (const Use& u : p.writes) use(u, true);
+
+    if (dst == 0) return;
+    // Nothing earlier in the frame to wait for: the layout change only
+    if (src == 0) src = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    bool global = mb.srcAccessMask != 0 || _imageBarriers.empty();
+    vkCmdPipelineBarrier(cmd, src, dst, 0, global ? 1 : 0, &mb, 0, nullptr,
+                         (uint32_t)_imageBarriers.size(), _imageBarriers.data());
+}
+
+// ── Record ────────────────────────────────────────────────────────────────────
+
+VkCommandBuffer RenderGraph::secondary(size_t job) {
+    auto& pools = _cmdPools[_frame];
+    auto& cmds  = _cmds[_frame];
+    while (pools.size() <= job) {
+        VkCommandPoolCreateInfo pCI{};
+        pCI.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        pCI.queueFamilyIndex = _family;
+        VkCommandPool pool   = VK_NULL_HANDLE;
+        vkCreateCommandPool(_dev, &pCI, nullptr, &pool);
+
+        VkCommandBufferAllocateInfo aI{};
+        aI.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        aI.commandPool        = pool;
+        aI.level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        aI.commandBufferCount = 1;
+        VkCommandBuffer cmd   = VK_NULL_HANDLE;
+        vkAllocateCommandBuffers(_dev, &aI, &cmd);
+        pools.push_back(pool);
+        cmds.push_back(cmd);
+    }
+    return cmds[job];
+}
+
+void RenderGraph::run(const Job& job, VkCommandBuffer cmd) {
+    const Pass& p = _passes[job.pass];
+    VkCommandBufferInheritanceInfo inh{};
+    inh.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inh.renderPass  = p.begin.renderPass;
+    inh.framebuffer = p.begin.framebuffer;
+    VkCommandBufferBeginInfo bI{};
+    bI.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    bI.flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (p.begin.renderPass) bI.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    bI.pInheritanceInfo = &inh;
+    vkBeginCommandBuffer(cmd, &bI);
+    p.records[job.record](cmd);
+    vkEndCommandBuffer(cmd);
+}
+
+void RenderGraph::record(VkCommandBuffer primary) {
+    _jobs.clear();
+    // Cleared rather than rebuilt, so the lists keep their capacity
+    _recorded.resize(_passes.size());
+    for (auto& r : _recorded) r.clear();
+    for (size_t i = 0; i < _passes.size(); i++) {
+        if (!_alive[i] || !_passes[i].parallel || !_pool) continue;
+        for (size_t k = 0; k < _passes[i].records.size(); k++) {
+            _recorded[i].push_back(secondary(_jobs.size()));
+            _jobs.push_back({i, k});
+        }
+    }
+
+    // The first job on this thread, the rest spread over the pool
+    ArenaVector<TaskFuture<void>> running{ArenaAllocator<TaskFuture<void>>(_arena)};
+    for (size_t j = 1; j < _jobs.size(); j++) {
+        VkCommandBuffer cmd = _recorded[_jobs[j].pass][_jobs[j].record];
+        running.push_back(_pool->async([this, j, cmd] { run(_jobs[j], cmd); },
+                                       ThreadPool::Priority::Urgent));
+    }
+    if (!_jobs.empty()) run(_jobs[0], _recorded[_jobs[0].pass][_jobs[0].record]);
+    for (auto& f : running) f.wait();
+
+    for (size_t i = 0; i < _passes.size(); i++) {
+        if (!_alive[i]) continue;
+        Pass& p = _passes[i];
+        barriers(primary, p);
+        bool secondaries = !_recorded[i].empty();
+        if (p.begin.renderPass) {
+            p.begin.clearValueCount = (uint32_t)p.clears.size();
+            p.begin.pClearValues    = p.clears.data();
+            vkCmdBeginRenderPass(primary, &p.begin,
+                                 secondaries ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                                             : VK_SUBPASS_CONTENTS_INLINE);
+        }
+        if (secondaries)
+            vkCmdExecuteCommands(primary, (uint32_t)_recorded[i].size(), _recorded[i].data());
+        else
+            for (const Record& r : p.records) r(primary);
+        if (p.begin.renderPass) vkCmdEndRenderPass(primary);
+    }
+}
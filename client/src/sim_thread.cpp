@@ -0,0 +1,107 @@
+#include "sim_thread.h"
+#include "config.h"
+#include <algorithm>
+#include <cstring>
+#include <glm/glm.hpp>
+
+namespace {
+
+const auto STEP = std::chrono::duration_cast<SimThread::Clock::duration>(
+    std::chrono::duration<double>(1.0 / Config::CLIENT_SIM_HZ));
+
+} // namespace
+
+void SimThread::start(Tick tick) {
+    stop();
+    _tick     = std::move(tick);
+    _controls = {};
+    _tickMs   = 0.f;
+    _started  = Clock::now();
+    _running.store(true, std::memory_order_release);
+    _thread = std::thread([this] { run(); });
+}
+
+void SimThread::stop() {
+    if (!_thread.joinable()) return;
+    _running.store(false, std::memory_order_release);
+    _thread.join();
+}
+
+// ── Render thread ─────────────────────────────────────────────────────────────
+
+void SimThread::feed(const InputState& input, float yaw, float pitch, bool uiOpen) {
+    std::lock_guard lk(_feedMu);
+    std::memcpy(_controls.input.keys, input.keys, sizeof(input.keys));
+    for (int k = 0; k <= GLFW_KEY_LAST; k++) _controls.input.down[k] |= input.down[k];
+    _controls.yaw    = yaw;
+    _controls.pitch  = pitch;
+    _controls.uiOpen = uiOpen;
+}
+
+bool SimThread::view(Clock::time_point now, State& out) {
+    _published.fetch();
+    const Published& p = _published.front();
+    if (p.cur.t < _started) return false; // left over from the last run, or none yet
+
+    float a = 1.f;
+    if (p.cur.t > p.prev.t)
+        a = std::chrono::duration<float>(now - STEP - p.prev.t) /
+            std::chrono::duration<float>(p.cur.t - p.prev.t);
+    a       = std::clamp(a, 0.f, 1.f);
+    out.t   = p.prev.t + std::chrono::duration_cast<Clock::duration>((p.cur.t - p.prev.t) * a);
+    out.eye = glm::mix(p.prev.eye, p.cur.eye, a);
+    return true;
+}
+
+float SimThread::takeTickMs() {
+    std::lock_guard lk(_feedMu);
+    float ms = _tickMs;
+    _tickMs  = 0.f;
+    return ms;
+}
+
+// ── Sim thread ────────────────────────────────────────────────────────────────
+
+void SimThread::run() {
+    const float dt  = (float)(1.0 / Config::CLIENT_SIM_HZ);
+    auto        due = Clock::now();
+    Published   ticks;
+    Controls    in;
+    bool        first = true;
+    while (_running.load(std::memory_order_acquire)) {
+        auto now = Clock::now();
+        if (now < due) {
+            std::this_thread::sleep_until(due);
+            continue;
+        }
+        // Stalled (a debugger, a long load): start the schedule over
+        // rather than run the whole backlog at once
+        if (now - due > STEP * Config::SIM_MAX_STEPS) due = now;
+
+        {
+            std::lock_guard lk(_feedMu);
+            in = _controls;
+            std::fill(std::begin(_controls.input.down), std::end(_controls.input.down), false);
+        }
+
+        ticks.prev = ticks.cur;
+        Clock::time_point t0, t1;
+        {
+            auto lk = world();
+            t0      = Clock::now();
+            _tick(dt, in, ticks.cur);
+            t1      = Clock::now();
+        }
+        ticks.cur.t = due;
+        if (first) ticks.prev = ticks.cur;
+        first = false;
+        _published.back() = ticks;
+        _published.publish();
+
+        {
+            std::lock_guard lk(_feedMu);
+            _tickMs += std::chrono::duration<float, std::milli>(t1 - t0).count();
+        }
+        due += STEP;
+    }
+}
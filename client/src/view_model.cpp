@@ -1,4 +1,5 @@
 #include "view_model.h"
+#include "asset_blob.h"
 #include "log.h"
 #include <cstring>
 #include <fstream>
@@ -36,65 +37,10 @@ static VkShaderModule vmMakeModule(VkDevice dev,
   return m;
 }
 
-static void uploadBuffer(VkDevice device, VmaAllocator allocator,
-                         VkCommandPool pool, VkQueue queue, const void *data,
-                         VkDeviceSize size, VkBufferUsageFlags usage,
-                         VkBuffer &outBuf, VmaAllocation &outAlloc) {
-  VkBuffer stageBuf;
-  VmaAllocation stageAlloc;
-  {
-    VkBufferCreateInfo bCI{};
-    bCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bCI.size = size;
-    bCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    VmaAllocationCreateInfo aCI{};
-    aCI.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-    aCI.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-    VmaAllocationInfo info{};
-    vmaCreateBuffer(allocator, &bCI, &aCI, &stageBuf, &stageAlloc, &info);
-    memcpy(info.pMappedData, data, size);
-  }
-
-  {
-    VkBufferCreateInfo bCI{};
-    bCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bCI.size = size;
-    bCI.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-    VmaAllocationCreateInfo aCI{};
-    aCI.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-    vmaCreateBuffer(allocator, &bCI, &aCI, &outBuf, &outAlloc, nullptr);
-  }
-
-  VkCommandBufferAllocateInfo cbAI{};
-  cbAI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-  cbAI.commandPool = pool;
-  cbAI.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  cbAI.commandBufferCount = 1;
-  VkCommandBuffer cmd;
-  vkAllocateCommandBuffers(device, &cbAI, &cmd);
-
-  VkCommandBufferBeginInfo bI{};
-  bI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-  bI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-  vkBeginCommandBuffer(cmd, &bI);
-  VkBufferCopy region{0, 0, size};
-  vkCmdCopyBuffer(cmd, stageBuf, outBuf, 1, &region);
-  vkEndCommandBuffer(cmd);
-
-  VkSubmitInfo si{};
-  si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-  si.commandBufferCount = 1;
-  si.pCommandBuffers = &cmd;
-  vkQueueSubmit(queue, 1, &si, VK_NULL_HANDLE);
-  vkQueueWaitIdle(queue);
-
-  vkFreeCommandBuffers(device, pool, 1, &cmd);
-  vmaDestroyBuffer(allocator, stageBuf, stageAlloc);
-}
-
 void ViewModelRenderer::init(VkDevice device, VmaAllocator /*allocator*/,
                              VkRenderPass renderPass, VkExtent2D extent,
-                             const char *vertSpv, const char *fragSpv) {
+                             const char *vertSpv, const char *fragSpv,
+                             VkPipelineCache cache) {
   VkPushConstantRange pushRange{};
   pushRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
   pushRange.size = sizeof(glm::mat4);
@@ -188,8 +134,7 @@ void ViewModelRenderer::init(VkDevice device, VmaAllocator /*allocator*/,
   pCI.pColorBlendState = &blend;
   pCI.layout = pipelineLayout;
   pCI.renderPass = renderPass;
-  vmCheck(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pCI, nullptr,
-                                    &pipeline),
+  vmCheck(vkCreateGraphicsPipelines(device, cache, 1, &pCI, nullptr, &pipeline),
           "viewmodel pipeline");
 
   vkDestroyShaderModule(device, vertMod, nullptr);
@@ -198,45 +143,56 @@ void ViewModelRenderer::init(VkDevice device, VmaAllocator /*allocator*/,
   Log::info("ViewModelRenderer initialised");
 }
 
-int ViewModelRenderer::loadMesh(VkDevice device, VmaAllocator allocator,
-                                VkCommandPool pool, VkQueue queue,
-                                const GltfModel &model,
-                                ViewModelTransform transform) {
-  if (!model.valid || model.meshes.empty())
-    return -1;
-
-  std::vector<GltfVertex> verts;
-  std::vector<uint32_t> inds;
-  for (auto &m : model.meshes) {
-    uint32_t base = (uint32_t)verts.size();
-    verts.insert(verts.end(), m.vertices.begin(), m.vertices.end());
-    for (auto i : m.indices)
-      inds.push_back(base + i);
-  }
-
-  if (!verts.empty()) {
-    glm::vec3 mn = verts[0].pos, mx = verts[0].pos;
-    for (auto &v : verts) {
-      mn = glm::min(mn, v.pos);
-      mx = glm::max(mx, v.pos);
+bool ViewModelRenderer::readMesh(const std::string &glbPath,
+                                 ViewModelMeshData &out) {
+  // Baked blob if fresh, else parse the GLB
+  AssetBlob::Mapped blob;
+  if (blob.open(AssetBlob::pathFor(glbPath).c_str(), glbPath.c_str(),
+                sizeof(GltfVertex))) {
+    auto &bh = blob.header();
+    const GltfVertex *v = blob.vertices<GltfVertex>();
+    out.verts.assign(v, v + bh.vertexCount);
+    out.inds.assign(blob.indices(), blob.indices() + bh.indexCount);
+    out.center = (blob.boundsMin() + blob.boundsMax()) * 0.5f;
+  } else {
+    GltfModel model = loadGlb(glbPath.c_str());
+    if (!model.valid || model.meshes.empty())
+      return false;
+    GltfMesh merged = mergeMeshes(model);
+    out.verts = std::move(merged.vertices);
+    out.inds = std::move(merged.indices);
+    if (!out.verts.empty()) {
+      glm::vec3 mn = out.verts[0].pos, mx = out.verts[0].pos;
+      for (auto &v : out.verts) {
+        mn = glm::min(mn, v.pos);
+        mx = glm::max(mx, v.pos);
+      }
+      out.center = (mn + mx) * 0.5f;
     }
-    transform.meshCenter = (mn + mx) * 0.5f;
   }
+  return !out.verts.empty() && !out.inds.empty();
+}
 
-  ViewModelMesh gpu{};
-  gpu.indexCount = (uint32_t)inds.size();
-
-  uploadBuffer(device, allocator, pool, queue, verts.data(),
-               verts.size() * sizeof(GltfVertex),
-               VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, gpu.vertBuf, gpu.vertAlloc);
-
-  uploadBuffer(device, allocator, pool, queue, inds.data(),
-               inds.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-               gpu.idxBuf, gpu.idxAlloc);
+int ViewModelRenderer::addMesh(StagedUploads &up,
+                               const ViewModelMeshData &data,
+                               ViewModelTransform transform) {
+  if (data.verts.empty() || data.inds.empty())
+    return -1;
+  transform.meshCenter = data.center;
 
+  ViewModelMesh gpu{};
+  gpu.indexCount = (uint32_t)data.inds.size();
+  bool ok = up.buffer(data.verts.data(), data.verts.size() * sizeof(GltfVertex),
+                      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, gpu.vertBuf,
+                      gpu.vertAlloc) &&
+            up.buffer(data.inds.data(), data.inds.size() * sizeof(uint32_t),
+                      VK_BUFFER_USAGE_INDEX_BUFFER_BIT, gpu.idxBuf,
+                      gpu.idxAlloc);
+
+  // Kept either way: up may already copy into it, and destroy() frees it
   meshes.push_back(gpu);
   transforms.push_back(transform);
-  return (int)meshes.size() - 1;
+  return ok ? (int)meshes.size() - 1 : -1;
 }
 
 void ViewModelRenderer::drawDebugUI() {
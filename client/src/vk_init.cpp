@@ -1,11 +1,19 @@
 #include "asset_path.h"
 #include "log.h"
+#include "marching_cubes.h"
+#include "pipeline_cache.h"
+#include "terrain_vertex.h"
+#include "trace.h"
 #include "view_model.h"
 #include "vk_context.h"
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <stdexcept>
+#include <tuple>
 #include <vector>
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -45,98 +53,1593 @@ static VkShaderModule makeModule(VkDevice dev,
   return m;
 }
 
-// ── MegaBuffer free-list
-// ──────────────────────────────────────────────────────
+// ── MegaBuffer ranges
+// ──────────────────────────────────────────────────────────
+
+uint32_t MegaBuffer::allocVerts(uint32_t count) {
+  uint32_t off = verts.alloc(count);
+  if (off == RangeAllocator::NONE)
+    Log::warn("MegaBuffer: vertex space exhausted, skipping chunk");
+  return off;
+}
+
+uint32_t MegaBuffer::allocInds(uint32_t count) {
+  uint32_t off = inds.alloc(count);
+  if (off == RangeAllocator::NONE)
+    Log::warn("MegaBuffer: index space exhausted, skipping chunk");
+  return off;
+}
+
+void MegaBuffer::releaseVerts(uint32_t offset, uint32_t count) {
+  verts.release(offset, count);
+}
+
+void MegaBuffer::releaseInds(uint32_t offset, uint32_t count) {
+  inds.release(offset, count);
+}
+
+// ── Render targets
+// ────────────────────────────────────────────────────────────
+// The depth buffer, and with canUpscale the colour image the scene goes
+// into under dynamic resolution — both swapchain-sized, drawn into a
+// smaller top-left rect as the scale drops, so nothing is reallocated.
+
+static void createRenderTargets(VkContext &ctx) {
+  VkImageCreateInfo imgCI{};
+  imgCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imgCI.imageType = VK_IMAGE_TYPE_2D;
+  imgCI.format = VK_FORMAT_D32_SFLOAT;
+  imgCI.extent = {ctx.swapchain.extent.width, ctx.swapchain.extent.height, 1};
+  imgCI.mipLevels = 1;
+  imgCI.arrayLayers = 1;
+  imgCI.samples = VK_SAMPLE_COUNT_1_BIT;
+  imgCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+  // Sampled by hiz.comp after the render pass
+  imgCI.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                VK_IMAGE_USAGE_SAMPLED_BIT;
+  VmaAllocationCreateInfo aCI{};
+  aCI.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+  vmaCreateImage(ctx.allocator, &imgCI, &aCI, &ctx.depthImage, &ctx.depthAlloc,
+                 nullptr);
+
+  VkImageViewCreateInfo vCI{};
+  vCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  vCI.image = ctx.depthImage;
+  vCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  vCI.format = VK_FORMAT_D32_SFLOAT;
+  vCI.subresourceRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1};
+  check(
+      vkCreateImageView(ctx.device.device, &vCI, nullptr, &ctx.depthImageView),
+      "depth view");
+
+  if (!ctx.canUpscale)
+    return;
+  imgCI.format = ctx.swapchain.image_format;
+  imgCI.usage =
+      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  check(vmaCreateImage(ctx.allocator, &imgCI, &aCI, &ctx.sceneImage,
+                       &ctx.sceneAlloc, nullptr),
+        "scene image");
+  vCI.image = ctx.sceneImage;
+  vCI.format = ctx.swapchain.image_format;
+  vCI.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+  check(
+      vkCreateImageView(ctx.device.device, &vCI, nullptr, &ctx.sceneImageView),
+      "scene view");
+}
+
+// ── Swapchain
+// ─────────────────────────────────────────────────────────────────
+// Dynamic resolution blits into the swapchain images, so they're made
+// transfer targets where the surface allows. Replaces ctx.swapchain (and
+// its images and views), retiring the old one, if there was one.
+
+static void buildSwapchain(VkContext &ctx, VkExtent2D extent,
+                           VkPresentModeKHR mode) {
+  VkSurfaceCapabilitiesKHR surfCaps{};
+  vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
+      ctx.device.physical_device.physical_device, ctx.surface, &surfCaps);
+  bool blitDst =
+      (surfCaps.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0;
+  vkb::SwapchainBuilder builder{ctx.device};
+  builder.set_old_swapchain(ctx.swapchain)
+      .set_desired_format(
+          {VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR})
+      .set_desired_present_mode(mode)
+      .set_desired_extent(extent.width, extent.height)
+      .add_image_usage_flags(blitDst ? VK_IMAGE_USAGE_TRANSFER_DST_BIT : 0);
+  // Unvsynced either way; FIFO, always there, after that
+  if (mode == VK_PRESENT_MODE_MAILBOX_KHR)
+    builder.add_fallback_present_mode(VK_PRESENT_MODE_IMMEDIATE_KHR);
+  else if (mode == VK_PRESENT_MODE_IMMEDIATE_KHR)
+    builder.add_fallback_present_mode(VK_PRESENT_MODE_MAILBOX_KHR);
+  auto sc = builder.build();
+  if (!sc)
+    throw std::runtime_error(sc.error().message());
+  if (ctx.swapchain.swapchain) {
+    ctx.swapchain.destroy_image_views(ctx.swapImageViews);
+    vkb::destroy_swapchain(ctx.swapchain);
+  }
+  ctx.swapchain = sc.value();
+  ctx.swapImages = ctx.swapchain.get_images().value();
+  ctx.swapImageViews = ctx.swapchain.get_image_views().value();
+  ctx.presentMode = ctx.swapchain.present_mode;
+}
+
+// ── Offscreen
+// ─────────────────────────────────────────────────────────────────
+// For --bench: FRAMES_IN_FLIGHT images shaped like the swapchain's, in
+// ctx.swapImages, one per frame slot, so the slot's fence is all that
+// guards its image. vk_init fills in ctx.swapchain's extent, format and
+// usage; nothing is ever presented from them.
+
+static void createOffscreenImages(VkContext &ctx) {
+  VkImageCreateInfo imgCI{};
+  imgCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imgCI.imageType = VK_IMAGE_TYPE_2D;
+  imgCI.format = ctx.swapchain.image_format;
+  imgCI.extent = {ctx.swapchain.extent.width, ctx.swapchain.extent.height, 1};
+  imgCI.mipLevels = 1;
+  imgCI.arrayLayers = 1;
+  imgCI.samples = VK_SAMPLE_COUNT_1_BIT;
+  imgCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imgCI.usage = ctx.swapchain.image_usage_flags;
+  VmaAllocationCreateInfo aCI{};
+  aCI.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+  VkImageViewCreateInfo vCI{};
+  vCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  vCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  vCI.format = ctx.swapchain.image_format;
+  vCI.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+  const uint32_t n = ctx.swapchain.image_count;
+  ctx.swapImages.resize(n);
+  ctx.swapImageViews.resize(n);
+  ctx.offscreenAllocs.resize(n);
+  for (uint32_t i = 0; i < n; i++) {
+    check(vmaCreateImage(ctx.allocator, &imgCI, &aCI, &ctx.swapImages[i],
+                         &ctx.offscreenAllocs[i], nullptr),
+          "offscreen image");
+    vCI.image = ctx.swapImages[i];
+    check(vkCreateImageView(ctx.device.device, &vCI, nullptr,
+                            &ctx.swapImageViews[i]),
+          "offscreen view");
+  }
+}
+
+// ── Framebuffers
+// ──────────────────────────────────────────────────────────────
+// Per swapchain image, and the dynamic resolution scene target
+
+static void createFramebuffers(VkContext &ctx) {
+  ctx.framebuffers.resize(ctx.swapImageViews.size());
+  for (size_t i = 0; i < ctx.swapImageViews.size(); i++) {
+    VkImageView fbAtts[] = {ctx.swapImageViews[i], ctx.depthImageView};
+    VkFramebufferCreateInfo fbCI{};
+    fbCI.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    fbCI.renderPass = ctx.renderPass;
+    fbCI.attachmentCount = 2;
+    fbCI.pAttachments = fbAtts;
+    fbCI.width = ctx.swapchain.extent.width;
+    fbCI.height = ctx.swapchain.extent.height;
+    fbCI.layers = 1;
+    check(vkCreateFramebuffer(ctx.device.device, &fbCI, nullptr,
+                              &ctx.framebuffers[i]),
+          "framebuf");
+  }
+  if (ctx.canUpscale) {
+    VkImageView fbAtts[] = {ctx.sceneImageView, ctx.depthImageView};
+    VkFramebufferCreateInfo fbCI{};
+    fbCI.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    fbCI.renderPass = ctx.sceneRenderPass;
+    fbCI.attachmentCount = 2;
+    fbCI.pAttachments = fbAtts;
+    fbCI.width = ctx.swapchain.extent.width;
+    fbCI.height = ctx.swapchain.extent.height;
+    fbCI.layers = 1;
+    check(vkCreateFramebuffer(ctx.device.device, &fbCI, nullptr,
+                              &ctx.sceneFramebuffer),
+          "scene framebuf");
+    fbCI.renderPass = ctx.overlayRenderPass;
+    ctx.overlayFramebuffers.resize(ctx.swapImageViews.size());
+    for (size_t i = 0; i < ctx.swapImageViews.size(); i++) {
+      fbAtts[0] = ctx.swapImageViews[i];
+      check(vkCreateFramebuffer(ctx.device.device, &fbCI, nullptr,
+                                &ctx.overlayFramebuffers[i]),
+            "overlay framebuf");
+    }
+  }
+}
+
+static void destroyFramebuffers(VkContext &ctx) {
+  for (auto &fb : ctx.framebuffers)
+    vkDestroyFramebuffer(ctx.device.device, fb, nullptr);
+  for (auto &fb : ctx.overlayFramebuffers)
+    vkDestroyFramebuffer(ctx.device.device, fb, nullptr);
+  vkDestroyFramebuffer(ctx.device.device, ctx.sceneFramebuffer, nullptr);
+  ctx.framebuffers.clear();
+  ctx.overlayFramebuffers.clear();
+  ctx.sceneFramebuffer = VK_NULL_HANDLE;
+}
+
+// ── Shadow maps
+// ──────────────────────────────────────────────────────────────
+// Both depth arrays, a view and framebuffer per layer, the depth-only pass
+// that fills them, and set 1 for terrain.frag. Needs uploadCmd.
+
+static void createShadowResources(VkContext &ctx) {
+  VkDevice dev = ctx.device.device;
+  const uint32_t C = VkContext::SHADOW_CASCADES;
+
+  VkAttachmentDescription depthAtt{};
+  depthAtt.format = VK_FORMAT_D32_SFLOAT;
+  depthAtt.samples = VK_SAMPLE_COUNT_1_BIT;
+  depthAtt.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  depthAtt.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+  depthAtt.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  depthAtt.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  depthAtt.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  depthAtt.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  VkAttachmentReference depthRef{
+      0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+  VkSubpassDescription subpass{};
+  subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpass.pDepthStencilAttachment = &depthRef;
+
+  // In: earlier frames' terrain.frag may still be sampling the layer.
+  // Out: this frame's does.
+  VkSubpassDependency deps[2]{};
+  deps[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+  deps[0].dstSubpass = 0;
+  deps[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  deps[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                         VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  deps[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  deps[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                          VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  deps[1].srcSubpass = 0;
+  deps[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+  deps[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  deps[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  deps[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  deps[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+  VkRenderPassCreateInfo rpCI{};
+  rpCI.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+  rpCI.attachmentCount = 1;
+  rpCI.pAttachments = &depthAtt;
+  rpCI.subpassCount = 1;
+  rpCI.pSubpasses = &subpass;
+  rpCI.dependencyCount = 2;
+  rpCI.pDependencies = deps;
+  check(vkCreateRenderPass(dev, &rpCI, nullptr, &ctx.shadowRenderPass),
+        "shadow render pass");
+
+  // Static maps first, then dynamic
+  const uint32_t sizes[2] = {(uint32_t)Config::SHADOW_MAP_SIZE,
+                             (uint32_t)Config::SHADOW_DYNAMIC_SIZE};
+  VkImage *images[2] = {&ctx.shadowStaticImage, &ctx.shadowDynamicImage};
+  VmaAllocation *allocs[2] = {&ctx.shadowStaticAlloc, &ctx.shadowDynamicAlloc};
+  VkImageView *views[2] = {&ctx.shadowStaticView, &ctx.shadowDynamicView};
+  for (int m = 0; m < 2; m++) {
+    VkImageCreateInfo imgCI{};
+    imgCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imgCI.imageType = VK_IMAGE_TYPE_2D;
+    imgCI.format = VK_FORMAT_D32_SFLOAT;
+    imgCI.extent = {sizes[m], sizes[m], 1};
+    imgCI.mipLevels = 1;
+    imgCI.arrayLayers = C;
+    imgCI.samples = VK_SAMPLE_COUNT_1_BIT;
+    imgCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imgCI.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                  VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    VmaAllocationCreateInfo aCI{};
+    aCI.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    check(vmaCreateImage(ctx.allocator, &imgCI, &aCI, images[m], allocs[m],
+                         nullptr),
+          "shadow map");
+
+    VkImageViewCreateInfo vCI{};
+    vCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    vCI.image = *images[m];
+    vCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    vCI.format = VK_FORMAT_D32_SFLOAT;
+    vCI.subresourceRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, C};
+    check(vkCreateImageView(dev, &vCI, nullptr, views[m]), "shadow view");
+    vCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    for (uint32_t c = 0; c < C; c++) {
+      vCI.subresourceRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, c, 1};
+      check(vkCreateImageView(dev, &vCI, nullptr, &ctx.shadowLayerViews[m][c]),
+            "shadow layer view");
+
+      VkFramebufferCreateInfo fbCI{};
+      fbCI.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+      fbCI.renderPass = ctx.shadowRenderPass;
+      fbCI.attachmentCount = 1;
+      fbCI.pAttachments = &ctx.shadowLayerViews[m][c];
+      fbCI.width = sizes[m];
+      fbCI.height = sizes[m];
+      fbCI.layers = 1;
+      check(vkCreateFramebuffer(dev, &fbCI, nullptr,
+                                &ctx.shadowFramebuffers[m][c]),
+            "shadow framebuf");
+    }
+  }
+
+  // Outside every cascade reads as lit
+  VkSamplerCreateInfo sCI{};
+  sCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  sCI.magFilter = VK_FILTER_LINEAR;
+  sCI.minFilter = VK_FILTER_LINEAR;
+  sCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  sCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+  sCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+  sCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+  sCI.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+  sCI.compareEnable = VK_TRUE;
+  sCI.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+  check(vkCreateSampler(dev, &sCI, nullptr, &ctx.shadowSampler),
+        "shadow sampler");
+
+  VkDescriptorSetLayoutBinding bindings[3]{};
+  for (uint32_t i = 0; i < 3; i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorType = i == 0
+                                     ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+                                     : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[i].descriptorCount = 1;
+    bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+  }
+  VkDescriptorSetLayoutCreateInfo dsCI{};
+  dsCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  dsCI.bindingCount = 3;
+  dsCI.pBindings = bindings;
+  check(vkCreateDescriptorSetLayout(dev, &dsCI, nullptr, &ctx.shadowLayout),
+        "shadow ds layout");
+
+  VkDescriptorPoolSize poolSizes[2] = {
+      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2},
+      {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4}};
+  VkDescriptorPoolCreateInfo dpCI{};
+  dpCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  dpCI.maxSets = 2;
+  dpCI.poolSizeCount = 2;
+  dpCI.pPoolSizes = poolSizes;
+  check(vkCreateDescriptorPool(dev, &dpCI, nullptr, &ctx.shadowPool),
+        "shadow ds pool");
+
+  VkDescriptorSetLayout layouts[2] = {ctx.shadowLayout, ctx.shadowLayout};
+  VkDescriptorSetAllocateInfo dsAI{};
+  dsAI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  dsAI.descriptorPool = ctx.shadowPool;
+  dsAI.descriptorSetCount = 2;
+  dsAI.pSetLayouts = layouts;
+  check(vkAllocateDescriptorSets(dev, &dsAI, ctx.shadowSets),
+        "shadow ds alloc");
+
+  for (int i = 0; i < 2; i++) {
+    VkBufferCreateInfo bCI{};
+    bCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bCI.size = sizeof(ShadowParams);
+    bCI.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    VmaAllocationCreateInfo aCI{};
+    aCI.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    aCI.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    VmaAllocationInfo info{};
+    check(vmaCreateBuffer(ctx.allocator, &bCI, &aCI, &ctx.shadowParamBuffer[i],
+                          &ctx.shadowParamAlloc[i], &info),
+          "shadow param buf");
+    ctx.shadowParamMapped[i] = info.pMappedData;
+
+    VkDescriptorBufferInfo bufInfo{ctx.shadowParamBuffer[i], 0,
+                                   sizeof(ShadowParams)};
+    VkDescriptorImageInfo imgInfo[2]{};
+    for (int m = 0; m < 2; m++)
+      imgInfo[m] = {ctx.shadowSampler, *views[m],
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkWriteDescriptorSet writes[3]{};
+    for (uint32_t b = 0; b < 3; b++) {
+      writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[b].dstSet = ctx.shadowSets[i];
+      writes[b].dstBinding = b;
+      writes[b].descriptorCount = 1;
+      writes[b].descriptorType = bindings[b].descriptorType;
+    }
+    writes[0].pBufferInfo = &bufInfo;
+    writes[1].pImageInfo = &imgInfo[0];
+    writes[2].pImageInfo = &imgInfo[1];
+    vkUpdateDescriptorSets(dev, 3, writes, 0, nullptr);
+  }
+
+  // Cleared to the far plane and left readable, so a layer drawn for the
+  // first time some frames in reads as lit until then
+  vkWaitForFences(dev, 1, &ctx.uploadFence, VK_TRUE, UINT64_MAX);
+  vkResetFences(dev, 1, &ctx.uploadFence);
+  vkResetCommandBuffer(ctx.uploadCmd, 0);
+  VkCommandBufferBeginInfo bI{};
+  bI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  bI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkBeginCommandBuffer(ctx.uploadCmd, &bI);
+  VkImageSubresourceRange range{VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, C};
+  VkImageMemoryBarrier b[2]{};
+  for (int m = 0; m < 2; m++) {
+    b[m].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    b[m].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    b[m].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    b[m].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    b[m].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b[m].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b[m].image = *images[m];
+    b[m].subresourceRange = range;
+  }
+  vkCmdPipelineBarrier(ctx.uploadCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 2, b);
+  VkClearDepthStencilValue cleared{1.f, 0};
+  for (int m = 0; m < 2; m++)
+    vkCmdClearDepthStencilImage(ctx.uploadCmd, *images[m],
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &cleared, 1,
+                                &range);
+  for (auto &bm : b) {
+    bm.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    bm.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    bm.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bm.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  }
+  vkCmdPipelineBarrier(ctx.uploadCmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 2, b);
+  vkEndCommandBuffer(ctx.uploadCmd);
+  VkSubmitInfo si{};
+  si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  si.commandBufferCount = 1;
+  si.pCommandBuffers = &ctx.uploadCmd;
+  vkQueueSubmit(ctx.graphicsQueue, 1, &si, ctx.uploadFence);
+  vkWaitForFences(dev, 1, &ctx.uploadFence, VK_TRUE, UINT64_MAX);
+}
+
+// ── Compute passes
+// ────────────────────────────────────────────────────────────
+
+static VkPipeline makeComputePipeline(VkDevice dev, VkPipelineCache cache,
+                                      const char *spv,
+                                      VkPipelineLayout layout) {
+  VkShaderModule mod = makeModule(dev, loadSpv(AssetPath::get(spv).c_str()));
+  VkComputePipelineCreateInfo ci{};
+  ci.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  ci.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  ci.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  ci.stage.module = mod;
+  ci.stage.pName = "main";
+  ci.layout = layout;
+  VkPipeline p;
+  check(vkCreateComputePipelines(dev, cache, 1, &ci, nullptr, &p),
+        spv);
+  vkDestroyShaderModule(dev, mod, nullptr);
+  return p;
+}
+
+// Pyramid image, one view and descriptor set per level, and the reduce
+// pipeline's layout. Needs the depth view and uploadCmd.
+static void createHizResources(VkContext &ctx) {
+  VkDevice dev = ctx.device.device;
+  ctx.hizExtent = {std::max(1u, ctx.swapchain.extent.width / 2),
+                   std::max(1u, ctx.swapchain.extent.height / 2)};
+  ctx.hizLevels = 1;
+  for (uint32_t m = std::max(ctx.hizExtent.width, ctx.hizExtent.height); m > 1;
+       m >>= 1)
+    ctx.hizLevels++;
+
+  VkImageCreateInfo imgCI{};
+  imgCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imgCI.imageType = VK_IMAGE_TYPE_2D;
+  imgCI.format = VK_FORMAT_R32_SFLOAT;
+  imgCI.extent = {ctx.hizExtent.width, ctx.hizExtent.height, 1};
+  imgCI.mipLevels = ctx.hizLevels;
+  imgCI.arrayLayers = 1;
+  imgCI.samples = VK_SAMPLE_COUNT_1_BIT;
+  imgCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imgCI.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  VmaAllocationCreateInfo aCI{};
+  aCI.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+  check(vmaCreateImage(ctx.allocator, &imgCI, &aCI, &ctx.hizImage,
+                       &ctx.hizAlloc, nullptr),
+        "hiz image");
+
+  VkImageViewCreateInfo vCI{};
+  vCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  vCI.image = ctx.hizImage;
+  vCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  vCI.format = VK_FORMAT_R32_SFLOAT;
+  vCI.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, ctx.hizLevels, 0, 1};
+  check(vkCreateImageView(dev, &vCI, nullptr, &ctx.hizView), "hiz view");
+  ctx.hizLevelViews.resize(ctx.hizLevels);
+  for (uint32_t l = 0; l < ctx.hizLevels; l++) {
+    vCI.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, l, 1, 0, 1};
+    check(vkCreateImageView(dev, &vCI, nullptr, &ctx.hizLevelViews[l]),
+          "hiz level view");
+  }
+
+  // Only texelFetch'd, so filtering never matters
+  VkSamplerCreateInfo sCI{};
+  sCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  sCI.magFilter = VK_FILTER_NEAREST;
+  sCI.minFilter = VK_FILTER_NEAREST;
+  sCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  sCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sCI.maxLod = VK_LOD_CLAMP_NONE;
+  check(vkCreateSampler(dev, &sCI, nullptr, &ctx.hizSampler), "hiz sampler");
+
+  VkDescriptorSetLayoutBinding bindings[2]{};
+  bindings[0].binding = 0;
+  bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  bindings[0].descriptorCount = 1;
+  bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  bindings[1].binding = 1;
+  bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  bindings[1].descriptorCount = 1;
+  bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  VkDescriptorSetLayoutCreateInfo dsCI{};
+  dsCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  dsCI.bindingCount = 2;
+  dsCI.pBindings = bindings;
+  check(vkCreateDescriptorSetLayout(dev, &dsCI, nullptr, &ctx.hizLayout),
+        "hiz ds layout");
+
+  VkDescriptorPoolSize poolSizes[2] = {
+      {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, ctx.hizLevels},
+      {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, ctx.hizLevels}};
+  VkDescriptorPoolCreateInfo dpCI{};
+  dpCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  dpCI.maxSets = ctx.hizLevels;
+  dpCI.poolSizeCount = 2;
+  dpCI.pPoolSizes = poolSizes;
+  check(vkCreateDescriptorPool(dev, &dpCI, nullptr, &ctx.hizPool),
+        "hiz ds pool");
+
+  std::vector<VkDescriptorSetLayout> layouts(ctx.hizLevels, ctx.hizLayout);
+  VkDescriptorSetAllocateInfo dsAI{};
+  dsAI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  dsAI.descriptorPool = ctx.hizPool;
+  dsAI.descriptorSetCount = ctx.hizLevels;
+  dsAI.pSetLayouts = layouts.data();
+  ctx.hizSets.resize(ctx.hizLevels);
+  check(vkAllocateDescriptorSets(dev, &dsAI, ctx.hizSets.data()),
+        "hiz ds alloc");
+
+  for (uint32_t l = 0; l < ctx.hizLevels; l++) {
+    VkDescriptorImageInfo srcInfo{};
+    srcInfo.sampler = ctx.hizSampler;
+    srcInfo.imageView = l == 0 ? ctx.depthImageView : ctx.hizLevelViews[l - 1];
+    srcInfo.imageLayout = l == 0
+                              ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                              : VK_IMAGE_LAYOUT_GENERAL;
+    VkDescriptorImageInfo dstInfo{};
+    dstInfo.imageView = ctx.hizLevelViews[l];
+    dstInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkWriteDescriptorSet writes[2]{};
+    writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[0].dstSet = ctx.hizSets[l];
+    writes[0].dstBinding = 0;
+    writes[0].descriptorCount = 1;
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[0].pImageInfo = &srcInfo;
+    writes[1] = writes[0];
+    writes[1].dstBinding = 1;
+    writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[1].pImageInfo = &dstInfo;
+    vkUpdateDescriptorSets(dev, 2, writes, 0, nullptr);
+  }
+
+  VkPipelineLayoutCreateInfo plCI{};
+  plCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  plCI.setLayoutCount = 1;
+  plCI.pSetLayouts = &ctx.hizLayout;
+  check(vkCreatePipelineLayout(dev, &plCI, nullptr, &ctx.hizPipelineLayout),
+        "hiz pipeline layout");
+
+  // The pyramid lives in GENERAL: written as storage, sampled in place
+  vkWaitForFences(dev, 1, &ctx.uploadFence, VK_TRUE, UINT64_MAX);
+  vkResetFences(dev, 1, &ctx.uploadFence);
+  vkResetCommandBuffer(ctx.uploadCmd, 0);
+  VkCommandBufferBeginInfo bI{};
+  bI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  bI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkBeginCommandBuffer(ctx.uploadCmd, &bI);
+  VkImageMemoryBarrier b{};
+  b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  b.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  b.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+  b.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  b.image = ctx.hizImage;
+  b.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, ctx.hizLevels, 0, 1};
+  vkCmdPipelineBarrier(ctx.uploadCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &b);
+  vkEndCommandBuffer(ctx.uploadCmd);
+  VkSubmitInfo si{};
+  si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  si.commandBufferCount = 1;
+  si.pCommandBuffers = &ctx.uploadCmd;
+  vkQueueSubmit(ctx.graphicsQueue, 1, &si, ctx.uploadFence);
+  vkWaitForFences(dev, 1, &ctx.uploadFence, VK_TRUE, UINT64_MAX);
+}
+
+// cull.comp's per-frame sets: slot table in, draw list out, Hi-Z sampled,
+// visibility bits in
+static void createCullResources(VkContext &ctx) {
+  VkDevice dev = ctx.device.device;
+
+  VkDescriptorSetLayoutBinding bindings[7]{};
+  for (uint32_t i = 0; i < 7; i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[i].descriptorCount = 1;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+  bindings[3].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  bindings[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  VkDescriptorSetLayoutCreateInfo dsCI{};
+  dsCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  dsCI.bindingCount = 7;
+  dsCI.pBindings = bindings;
+  check(vkCreateDescriptorSetLayout(dev, &dsCI, nullptr, &ctx.cullLayout),
+        "cull ds layout");
+
+  VkDescriptorPoolSize poolSizes[3] = {
+      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 10},
+      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2},
+      {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2}};
+  VkDescriptorPoolCreateInfo dpCI{};
+  dpCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  dpCI.maxSets = 2;
+  dpCI.poolSizeCount = 3;
+  dpCI.pPoolSizes = poolSizes;
+  check(vkCreateDescriptorPool(dev, &dpCI, nullptr, &ctx.cullPool),
+        "cull ds pool");
+
+  VkDescriptorSetLayout layouts[2] = {ctx.cullLayout, ctx.cullLayout};
+  VkDescriptorSetAllocateInfo dsAI{};
+  dsAI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  dsAI.descriptorPool = ctx.cullPool;
+  dsAI.descriptorSetCount = 2;
+  dsAI.pSetLayouts = layouts;
+  check(vkAllocateDescriptorSets(dev, &dsAI, ctx.cullSets), "cull ds alloc");
+
+  for (int i = 0; i < 2; i++) {
+    VkDescriptorBufferInfo bufs[7] = {
+        {ctx.chunkSlotBuffer, 0, VK_WHOLE_SIZE},
+        {ctx.indirectBuffer[i], 0, VK_WHOLE_SIZE},
+        {ctx.drawCountBuffer[i], 0, VK_WHOLE_SIZE},
+        {ctx.cullParamBuffer[i], 0, sizeof(CullParams)},
+        {},
+        {ctx.visibleBuffer[i], 0, VK_WHOLE_SIZE},
+        {ctx.meshletBuffer, 0, VK_WHOLE_SIZE}};
+    VkDescriptorImageInfo hizInfo{ctx.hizSampler, ctx.hizView,
+                                  VK_IMAGE_LAYOUT_GENERAL};
+    VkWriteDescriptorSet writes[7]{};
+    for (uint32_t b = 0; b < 7; b++) {
+      writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[b].dstSet = ctx.cullSets[i];
+      writes[b].dstBinding = b;
+      writes[b].descriptorCount = 1;
+      writes[b].descriptorType = bindings[b].descriptorType;
+      if (b == 4)
+        writes[b].pImageInfo = &hizInfo;
+      else
+        writes[b].pBufferInfo = &bufs[b];
+    }
+    vkUpdateDescriptorSets(dev, 7, writes, 0, nullptr);
+  }
+
+  VkPipelineLayoutCreateInfo plCI{};
+  plCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  plCI.setLayoutCount = 1;
+  plCI.pSetLayouts = &ctx.cullLayout;
+  check(vkCreatePipelineLayout(dev, &plCI, nullptr, &ctx.cullPipelineLayout),
+        "cull pipeline layout");
+}
+
+// foliage.comp's per-frame sets — slot table, cull.comp's chunk list, the
+// mega buffers in, the frame's draws and the instances out — and the
+// layouts of the scatter and of the draws, which take the bindless table
+static void createFoliageResources(VkContext &ctx) {
+  VkDevice dev = ctx.device.device;
+
+  VkDescriptorSetLayoutBinding bindings[6]{};
+  for (uint32_t i = 0; i < 6; i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[i].descriptorCount = 1;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+  VkDescriptorSetLayoutCreateInfo dsCI{};
+  dsCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  dsCI.bindingCount = 6;
+  dsCI.pBindings = bindings;
+  check(vkCreateDescriptorSetLayout(dev, &dsCI, nullptr, &ctx.foliageLayout),
+        "foliage ds layout");
+
+  VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 12};
+  VkDescriptorPoolCreateInfo dpCI{};
+  dpCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  dpCI.maxSets = 2;
+  dpCI.poolSizeCount = 1;
+  dpCI.pPoolSizes = &poolSize;
+  check(vkCreateDescriptorPool(dev, &dpCI, nullptr, &ctx.foliagePool),
+        "foliage ds pool");
+
+  VkDescriptorSetLayout layouts[2] = {ctx.foliageLayout, ctx.foliageLayout};
+  VkDescriptorSetAllocateInfo dsAI{};
+  dsAI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  dsAI.descriptorPool = ctx.foliagePool;
+  dsAI.descriptorSetCount = 2;
+  dsAI.pSetLayouts = layouts;
+  check(vkAllocateDescriptorSets(dev, &dsAI, ctx.foliageSets),
+        "foliage ds alloc");
+
+  for (int i = 0; i < 2; i++) {
+    VkDescriptorBufferInfo bufs[6] = {
+        {ctx.chunkSlotBuffer, 0, VK_WHOLE_SIZE},
+        {ctx.drawCountBuffer[i], 0, VK_WHOLE_SIZE},
+        {ctx.mega.vertexBuffer, 0, VK_WHOLE_SIZE},
+        {ctx.mega.indexBuffer, 0, VK_WHOLE_SIZE},
+        {ctx.foliageDrawBuffer[i], 0, VK_WHOLE_SIZE},
+        {ctx.foliageInstanceBuffer, 0, VK_WHOLE_SIZE}};
+    VkWriteDescriptorSet writes[6]{};
+    for (uint32_t b = 0; b < 6; b++) {
+      writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[b].dstSet = ctx.foliageSets[i];
+      writes[b].dstBinding = b;
+      writes[b].descriptorCount = 1;
+      writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      writes[b].pBufferInfo = &bufs[b];
+    }
+    vkUpdateDescriptorSets(dev, 6, writes, 0, nullptr);
+  }
+
+  // FoliagePC, then FoliageDrawPC (vk_draw)
+  VkPushConstantRange range{};
+  range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  range.size = 7 * sizeof(glm::vec4);
+  VkPipelineLayoutCreateInfo plCI{};
+  plCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  plCI.setLayoutCount = 1;
+  plCI.pSetLayouts = &ctx.foliageLayout;
+  plCI.pushConstantRangeCount = 1;
+  plCI.pPushConstantRanges = &range;
+  check(vkCreatePipelineLayout(dev, &plCI, nullptr, &ctx.foliageScatterLayout),
+        "foliage scatter layout");
+
+  VkDescriptorSetLayout table = ctx.bindless->layout();
+  range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+  range.size = sizeof(glm::mat4) + 4 * sizeof(glm::vec4);
+  plCI.pSetLayouts = &table;
+  check(vkCreatePipelineLayout(dev, &plCI, nullptr, &ctx.foliagePipelineLayout),
+        "foliage pipeline layout");
+}
+
+// particle.comp's per-frame sets — both pools, their states, the frame's
+// emitters — and the layouts of its passes and of the draw, which takes
+// the bindless table
+static void createParticleResources(VkContext &ctx) {
+  VkDevice dev = ctx.device.device;
+
+  VkDescriptorSetLayoutBinding bindings[3]{};
+  for (uint32_t i = 0; i < 3; i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[i].descriptorCount = 1;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+  VkDescriptorSetLayoutCreateInfo dsCI{};
+  dsCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  dsCI.bindingCount = 3;
+  dsCI.pBindings = bindings;
+  check(vkCreateDescriptorSetLayout(dev, &dsCI, nullptr, &ctx.particleLayout),
+        "particle ds layout");
+
+  VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6};
+  VkDescriptorPoolCreateInfo dpCI{};
+  dpCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  dpCI.maxSets = 2;
+  dpCI.poolSizeCount = 1;
+  dpCI.pPoolSizes = &poolSize;
+  check(vkCreateDescriptorPool(dev, &dpCI, nullptr, &ctx.particleDescPool),
+        "particle ds pool");
+
+  VkDescriptorSetLayout layouts[2] = {ctx.particleLayout, ctx.particleLayout};
+  VkDescriptorSetAllocateInfo dsAI{};
+  dsAI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  dsAI.descriptorPool = ctx.particleDescPool;
+  dsAI.descriptorSetCount = 2;
+  dsAI.pSetLayouts = layouts;
+  check(vkAllocateDescriptorSets(dev, &dsAI, ctx.particleSets),
+        "particle ds alloc");
+
+  for (int i = 0; i < 2; i++) {
+    VkDescriptorBufferInfo bufs[3] = {
+        {ctx.particleBuffer, 0, VK_WHOLE_SIZE},
+        {ctx.particleStateBuffer, 0, VK_WHOLE_SIZE},
+        {ctx.particleEmitterBuffer[i], 0, VK_WHOLE_SIZE}};
+    VkWriteDescriptorSet writes[3]{};
+    for (uint32_t b = 0; b < 3; b++) {
+      writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[b].dstSet = ctx.particleSets[i];
+      writes[b].dstBinding = b;
+      writes[b].descriptorCount = 1;
+      writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      writes[b].pBufferInfo = &bufs[b];
+    }
+    vkUpdateDescriptorSets(dev, 3, writes, 0, nullptr);
+  }
+
+  // ParticlePC, then ParticleDrawPC (vk_draw)
+  VkPushConstantRange range{};
+  range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  range.size = sizeof(glm::uvec4) + sizeof(glm::vec4);
+  VkPipelineLayoutCreateInfo plCI{};
+  plCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  plCI.setLayoutCount = 1;
+  plCI.pSetLayouts = &ctx.particleLayout;
+  plCI.pushConstantRangeCount = 1;
+  plCI.pPushConstantRanges = &range;
+  check(vkCreatePipelineLayout(dev, &plCI, nullptr, &ctx.particleSimLayout),
+        "particle sim layout");
+
+  VkDescriptorSetLayout table = ctx.bindless->layout();
+  range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+  range.size = sizeof(glm::mat4) + 3 * sizeof(glm::vec4);
+  plCI.pSetLayouts = &table;
+  check(vkCreatePipelineLayout(dev, &plCI, nullptr, &ctx.particlePipelineLayout),
+        "particle pipeline layout");
+}
+
+// light_cull.comp's set, the light grid alone; it takes no push constants
+static void createLightResources(VkContext &ctx) {
+  VkDevice dev = ctx.device.device;
+
+  VkDescriptorSetLayoutBinding binding{};
+  binding.binding = 0;
+  binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  binding.descriptorCount = 1;
+  binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  VkDescriptorSetLayoutCreateInfo dsCI{};
+  dsCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  dsCI.bindingCount = 1;
+  dsCI.pBindings = &binding;
+  check(vkCreateDescriptorSetLayout(dev, &dsCI, nullptr, &ctx.lightLayout),
+        "light ds layout");
+
+  VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1};
+  VkDescriptorPoolCreateInfo dpCI{};
+  dpCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  dpCI.maxSets = 1;
+  dpCI.poolSizeCount = 1;
+  dpCI.pPoolSizes = &poolSize;
+  check(vkCreateDescriptorPool(dev, &dpCI, nullptr, &ctx.lightDescPool),
+        "light ds pool");
+
+  VkDescriptorSetAllocateInfo dsAI{};
+  dsAI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  dsAI.descriptorPool = ctx.lightDescPool;
+  dsAI.descriptorSetCount = 1;
+  dsAI.pSetLayouts = &ctx.lightLayout;
+  check(vkAllocateDescriptorSets(dev, &dsAI, &ctx.lightSet), "light ds alloc");
+
+  VkDescriptorBufferInfo buf{ctx.lightGridBuffer, 0, VK_WHOLE_SIZE};
+  VkWriteDescriptorSet write{};
+  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write.dstSet = ctx.lightSet;
+  write.dstBinding = 0;
+  write.descriptorCount = 1;
+  write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  write.pBufferInfo = &buf;
+  vkUpdateDescriptorSets(dev, 1, &write, 0, nullptr);
+
+  VkPipelineLayoutCreateInfo plCI{};
+  plCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  plCI.setLayoutCount = 1;
+  plCI.pSetLayouts = &ctx.lightLayout;
+  check(vkCreatePipelineLayout(dev, &plCI, nullptr, &ctx.lightCullLayout),
+        "light cull layout");
+}
+
+// march.comp's resources: the tri table, and per job its field, cell and
+// header-readback buffers and a descriptor set over them and the mega
+// buffers. All allocated up front; only the vertex readback is per chunk.
+static_assert(sizeof(ChunkData::Voxel) == 2,
+              "march.comp reads 16-bit samples (CHUNK_DENSITY_BITS 8)");
+static constexpr uint32_t MARCH_CELLS =
+    ChunkData::SIZE * ChunkData::SIZE * ChunkData::SIZE;
+static constexpr uint32_t MARCH_HEADER_BYTES = 7 * sizeof(uint32_t);
+static constexpr VkDeviceSize MARCH_FIELD_BYTES =
+    (sizeof(ChunkData::voxels) + 3) & ~VkDeviceSize(3);
+
+struct MarchPC {
+  uint32_t vertexBase;
+  uint32_t indexBase;
+  uint32_t smoothNormals;
+};
+
+static void makeMarchBuffer(VkContext &ctx, VkDeviceSize size,
+                            VkBufferUsageFlags usage, VmaMemoryUsage mem,
+                            VkBuffer &buf, VmaAllocation &alloc,
+                            void **mapped) {
+  VkBufferCreateInfo bCI{};
+  bCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  bCI.size = size;
+  bCI.usage = usage;
+  VmaAllocationCreateInfo aCI{};
+  aCI.usage = mem;
+  if (mapped)
+    aCI.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+  VmaAllocationInfo info{};
+  check(vmaCreateBuffer(ctx.allocator, &bCI, &aCI, &buf, &alloc, &info),
+        "march buf");
+  if (mapped)
+    *mapped = info.pMappedData;
+}
+
+static void createMarchResources(VkContext &ctx) {
+  VkDevice dev = ctx.device.device;
+
+  void *table = nullptr;
+  makeMarchBuffer(ctx, sizeof(MarchTriTable),
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                  VMA_MEMORY_USAGE_CPU_TO_GPU, ctx.marchTableBuffer,
+                  ctx.marchTableAlloc, &table);
+  memcpy(table, marchTriTable(), sizeof(MarchTriTable));
+  vmaFlushAllocation(ctx.allocator, ctx.marchTableAlloc, 0, VK_WHOLE_SIZE);
+
+  VkDescriptorSetLayoutBinding bindings[5]{};
+  for (uint32_t i = 0; i < 5; i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[i].descriptorCount = 1;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+  VkDescriptorSetLayoutCreateInfo dsCI{};
+  dsCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  dsCI.bindingCount = 5;
+  dsCI.pBindings = bindings;
+  check(vkCreateDescriptorSetLayout(dev, &dsCI, nullptr, &ctx.marchLayout),
+        "march ds layout");
+
+  VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                5 * VkContext::GPU_MESH_JOBS};
+  VkDescriptorPoolCreateInfo dpCI{};
+  dpCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  dpCI.maxSets = VkContext::GPU_MESH_JOBS;
+  dpCI.poolSizeCount = 1;
+  dpCI.pPoolSizes = &poolSize;
+  check(vkCreateDescriptorPool(dev, &dpCI, nullptr, &ctx.marchPool),
+        "march ds pool");
+
+  for (GpuMeshJob &j : ctx.gpuMeshJobs) {
+    makeMarchBuffer(ctx, MARCH_FIELD_BYTES, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                    VMA_MEMORY_USAGE_CPU_TO_GPU, j.fieldBuffer, j.fieldAlloc,
+                    &j.fieldMapped);
+    makeMarchBuffer(ctx, MARCH_CELLS * sizeof(uint32_t) + MARCH_HEADER_BYTES,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                        VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VMA_MEMORY_USAGE_GPU_ONLY, j.cellBuffer, j.cellAlloc,
+                    nullptr);
+    makeMarchBuffer(ctx, MARCH_HEADER_BYTES, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    VMA_MEMORY_USAGE_GPU_TO_CPU, j.headerBuffer, j.headerAlloc,
+                    &j.headerMapped);
+
+    VkDescriptorSetAllocateInfo dsAI{};
+    dsAI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    dsAI.descriptorPool = ctx.marchPool;
+    dsAI.descriptorSetCount = 1;
+    dsAI.pSetLayouts = &ctx.marchLayout;
+    check(vkAllocateDescriptorSets(dev, &dsAI, &j.set), "march ds alloc");
+
+    VkDescriptorBufferInfo bufs[5] = {
+        {j.fieldBuffer, 0, VK_WHOLE_SIZE},
+        {ctx.marchTableBuffer, 0, VK_WHOLE_SIZE},
+        {j.cellBuffer, 0, VK_WHOLE_SIZE},
+        {ctx.mega.vertexBuffer, 0, VK_WHOLE_SIZE},
+        {ctx.mega.indexBuffer, 0, VK_WHOLE_SIZE}};
+    VkWriteDescriptorSet writes[5]{};
+    for (uint32_t b = 0; b < 5; b++) {
+      writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[b].dstSet = j.set;
+      writes[b].dstBinding = b;
+      writes[b].descriptorCount = 1;
+      writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      writes[b].pBufferInfo = &bufs[b];
+    }
+    vkUpdateDescriptorSets(dev, 5, writes, 0, nullptr);
+  }
+
+  VkPushConstantRange pcr{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(MarchPC)};
+  VkPipelineLayoutCreateInfo plCI{};
+  plCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  plCI.setLayoutCount = 1;
+  plCI.pSetLayouts = &ctx.marchLayout;
+  plCI.pushConstantRangeCount = 1;
+  plCI.pPushConstantRanges = &pcr;
+  check(vkCreatePipelineLayout(dev, &plCI, nullptr, &ctx.marchPipelineLayout),
+        "march pipeline layout");
+}
+
+// ── Pipelines
+// ─────────────────────────────────────────────────────────────────
+
+// terrain.frag's constant_ids, in order
+struct TerrainSpec {
+  VkBool32 triplanar;
+  VkBool32 materialBlend;
+  VkBool32 fog;
+  int32_t shadowTaps;
+};
+
+static TerrainSpec terrainSpec(ShaderTier tier) {
+  switch (tier) {
+  case ShaderTier::Low:
+    return {VK_FALSE, VK_FALSE, VK_FALSE, 1};
+  case ShaderTier::Medium:
+    return {VK_FALSE, VK_FALSE, VK_TRUE, 4};
+  default:
+    return {VK_TRUE, VK_TRUE, VK_TRUE, 9};
+  }
+}
+
+// The colour pipeline for ctx.shaderTier, and unless colourOnly the depth
+// pre-pass and shadow caster, which run terrain.vert alone and so are the
+// same for every tier
+static VkPipeline createTerrainPipeline(VkContext &ctx,
+                                        bool colourOnly = false) {
+  auto vertCode = loadSpv(AssetPath::get("terrain_vert.spv").c_str());
+  auto fragCode = loadSpv(AssetPath::get("terrain_frag.spv").c_str());
+  Log::info("Shaders loaded");
+
+  const TerrainSpec spec = terrainSpec(ctx.shaderTier);
+  const VkSpecializationMapEntry specEntries[] = {
+      {0, offsetof(TerrainSpec, triplanar), sizeof(VkBool32)},
+      {1, offsetof(TerrainSpec, materialBlend), sizeof(VkBool32)},
+      {2, offsetof(TerrainSpec, fog), sizeof(VkBool32)},
+      {3, offsetof(TerrainSpec, shadowTaps), sizeof(int32_t)},
+  };
+  VkSpecializationInfo specInfo{};
+  specInfo.mapEntryCount = 4;
+  specInfo.pMapEntries = specEntries;
+  specInfo.dataSize = sizeof(spec);
+  specInfo.pData = &spec;
+
+  VkShaderModule vertMod = makeModule(ctx.device.device, vertCode);
+  VkShaderModule fragMod = makeModule(ctx.device.device, fragCode);
+
+  VkPipelineShaderStageCreateInfo stages[2]{};
+  stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+  stages[0].module = vertMod;
+  stages[0].pName = "main";
+  stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+  stages[1].module = fragMod;
+  stages[1].pName = "main";
+  stages[1].pSpecializationInfo = &specInfo;
+
+  VkVertexInputBindingDescription vBinding{};
+  vBinding.binding = 0;
+  vBinding.stride = sizeof(TerrainVertex);
+  vBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+  // Packed words, unpacked in terrain.vert
+  VkVertexInputAttributeDescription attrs[2]{};
+  attrs[0].binding = 0;
+  attrs[0].location = 0;
+  attrs[0].format = VK_FORMAT_R32_UINT;
+  attrs[0].offset = offsetof(TerrainVertex, pos);
+  attrs[1].binding = 0;
+  attrs[1].location = 1;
+  attrs[1].format = VK_FORMAT_R32_UINT;
+  attrs[1].offset = offsetof(TerrainVertex, normMat);
+
+  VkPipelineVertexInputStateCreateInfo vertexInput{};
+  vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+  vertexInput.vertexBindingDescriptionCount = 1;
+  vertexInput.pVertexBindingDescriptions = &vBinding;
+  vertexInput.vertexAttributeDescriptionCount = 2;
+  vertexInput.pVertexAttributeDescriptions = attrs;
+
+  VkPipelineInputAssemblyStateCreateInfo ia{};
+  ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+  ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+  VkViewport vp{};
+  vp.width = (float)ctx.swapchain.extent.width;
+  vp.height = (float)ctx.swapchain.extent.height;
+  vp.maxDepth = 1.f;
+  VkRect2D sc2{};
+  sc2.extent = ctx.swapchain.extent;
+
+  VkPipelineViewportStateCreateInfo vs{};
+  vs.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+  vs.viewportCount = 1;
+  vs.pViewports = &vp;
+  vs.scissorCount = 1;
+  vs.pScissors = &sc2;
+
+  VkPipelineRasterizationStateCreateInfo raster{};
+  raster.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+  raster.polygonMode = VK_POLYGON_MODE_FILL;
+  raster.cullMode = VK_CULL_MODE_BACK_BIT;
+  raster.frontFace = VK_FRONT_FACE_CLOCKWISE;
+  raster.lineWidth = 1.f;
+
+  VkPipelineMultisampleStateCreateInfo ms{};
+  ms.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+  ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  VkPipelineDepthStencilStateCreateInfo ds{};
+  ds.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+  ds.depthTestEnable = VK_TRUE;
+  ds.depthWriteEnable = VK_TRUE;
+  // Equal passes too, for what the depth pre-pass already laid down
+  ds.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+  VkPipelineColorBlendAttachmentState blendAtt{};
+  blendAtt.colorWriteMask = 0xF;
+
+  VkPipelineColorBlendStateCreateInfo blend{};
+  blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+  blend.attachmentCount = 1;
+  blend.pAttachments = &blendAtt;
+
+  // vk_draw sets the rect per frame, smaller under dynamic resolution
+  VkDynamicState dynStates[] = {VK_DYNAMIC_STATE_VIEWPORT,
+                                VK_DYNAMIC_STATE_SCISSOR};
+  VkPipelineDynamicStateCreateInfo dyn{};
+  dyn.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  dyn.dynamicStateCount = 2;
+  dyn.pDynamicStates = dynStates;
+
+  VkGraphicsPipelineCreateInfo pCI{};
+  pCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pCI.stageCount = 2;
+  pCI.pStages = stages;
+  pCI.pVertexInputState = &vertexInput;
+  pCI.pInputAssemblyState = &ia;
+  pCI.pViewportState = &vs;
+  pCI.pRasterizationState = &raster;
+  pCI.pMultisampleState = &ms;
+  pCI.pDepthStencilState = &ds;
+  pCI.pColorBlendState = &blend;
+  pCI.pDynamicState = &dyn;
+  pCI.layout = ctx.pipelineLayout;
+  pCI.renderPass = ctx.renderPass;
+  VkPipeline colour;
+  check(vkCreateGraphicsPipelines(ctx.device.device, ctx.pipelineCache, 1,
+                                  &pCI, nullptr, &colour),
+        "pipeline");
+  if (colourOnly) {
+    vkDestroyShaderModule(ctx.device.device, vertMod, nullptr);
+    vkDestroyShaderModule(ctx.device.device, fragMod, nullptr);
+    return colour;
+  }
+
+  // Depth pre-pass: the same vertex stage, no fragment shader, no colour
+  VkPipelineColorBlendAttachmentState noColor{};
+  blend.pAttachments = &noColor;
+  ds.depthCompareOp = VK_COMPARE_OP_LESS;
+  pCI.stageCount = 1;
+  check(vkCreateGraphicsPipelines(ctx.device.device, ctx.pipelineCache, 1,
+                                  &pCI, nullptr, &ctx.depthPrepassPipeline),
+        "depth pre-pass pipeline");
+
+  // Shadow caster: the same again into a static map layer, both sides,
+  // pushed back off the surfaces it shades
+  vp.width = vp.height = (float)Config::SHADOW_MAP_SIZE;
+  sc2.extent = {(uint32_t)Config::SHADOW_MAP_SIZE,
+                (uint32_t)Config::SHADOW_MAP_SIZE};
+  raster.cullMode = VK_CULL_MODE_NONE;
+  raster.depthBiasEnable = VK_TRUE;
+  raster.depthBiasConstantFactor = 1.25f;
+  raster.depthBiasSlopeFactor = 1.75f;
+  blend.attachmentCount = 0;
+  pCI.pDynamicState = nullptr;
+  pCI.renderPass = ctx.shadowRenderPass;
+  check(vkCreateGraphicsPipelines(ctx.device.device, ctx.pipelineCache, 1,
+                                  &pCI, nullptr, &ctx.shadowPipeline),
+        "shadow pipeline");
+
+  vkDestroyShaderModule(ctx.device.device, vertMod, nullptr);
+  vkDestroyShaderModule(ctx.device.device, fragMod, nullptr);
+  return colour;
+}
+
+// FarTerrain::Vertex in world space. Depth tested against itself only:
+// vk_draw clears depth before the chunks.
+static void createFarPipeline(VkContext &ctx) {
+  auto vertCode = loadSpv(AssetPath::get("far_vert.spv").c_str());
+  auto fragCode = loadSpv(AssetPath::get("far_frag.spv").c_str());
+  VkShaderModule vertMod = makeModule(ctx.device.device, vertCode);
+  VkShaderModule fragMod = makeModule(ctx.device.device, fragCode);
+
+  VkPipelineShaderStageCreateInfo stages[2]{};
+  stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+  stages[0].module = vertMod;
+  stages[0].pName = "main";
+  stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+  stages[1].module = fragMod;
+  stages[1].pName = "main";
+
+  VkVertexInputBindingDescription vBinding{};
+  vBinding.binding = 0;
+  vBinding.stride = sizeof(FarTerrain::Vertex);
+  vBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+  VkVertexInputAttributeDescription attrs[2]{};
+  attrs[0].binding = 0;
+  attrs[0].location = 0;
+  attrs[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+  attrs[0].offset = offsetof(FarTerrain::Vertex, pos);
+  attrs[1].binding = 0;
+  attrs[1].location = 1;
+  attrs[1].format = VK_FORMAT_R32_UINT;
+  attrs[1].offset = offsetof(FarTerrain::Vertex, normMat);
+
+  VkPipelineVertexInputStateCreateInfo vertexInput{};
+  vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+  vertexInput.vertexBindingDescriptionCount = 1;
+  vertexInput.pVertexBindingDescriptions = &vBinding;
+  vertexInput.vertexAttributeDescriptionCount = 2;
+  vertexInput.pVertexAttributeDescriptions = attrs;
 
-static void doFreeRange(std::vector<MegaBuffer::Range> &list, uint32_t offset,
-                        uint32_t size) {
-  list.push_back({offset, size});
-  std::sort(list.begin(), list.end(),
-            [](const MegaBuffer::Range &a, const MegaBuffer::Range &b) {
-              return a.offset < b.offset;
-            });
-  for (size_t i = 0; i + 1 < list.size();) {
-    if (list[i].offset + list[i].size == list[i + 1].offset) {
-      list[i].size += list[i + 1].size;
-      list.erase(list.begin() + (ptrdiff_t)(i + 1));
-    } else
-      ++i;
-  }
-}
+  VkPipelineInputAssemblyStateCreateInfo ia{};
+  ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+  ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
-uint32_t MegaBuffer::allocVerts(uint32_t count) {
-  for (auto it = vertRanges.begin(); it != vertRanges.end(); ++it) {
-    if (it->size >= count) {
-      uint32_t off = it->offset;
-      it->offset += count;
-      it->size -= count;
-      if (it->size == 0)
-        vertRanges.erase(it);
-      return off;
-    }
-  }
-  Log::warn("MegaBuffer: vertex space exhausted, skipping chunk");
-  return UINT32_MAX;
-}
+  VkViewport vp{};
+  vp.width = (float)ctx.swapchain.extent.width;
+  vp.height = (float)ctx.swapchain.extent.height;
+  vp.maxDepth = 1.f;
+  VkRect2D sc2{};
+  sc2.extent = ctx.swapchain.extent;
 
-uint32_t MegaBuffer::allocInds(uint32_t count) {
-  for (auto it = indRanges.begin(); it != indRanges.end(); ++it) {
-    if (it->size >= count) {
-      uint32_t off = it->offset;
-      it->offset += count;
-      it->size -= count;
-      if (it->size == 0)
-        indRanges.erase(it);
-      return off;
-    }
-  }
-  Log::warn("MegaBuffer: index space exhausted, skipping chunk");
-  return UINT32_MAX;
+  VkPipelineViewportStateCreateInfo vs{};
+  vs.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+  vs.viewportCount = 1;
+  vs.pViewports = &vp;
+  vs.scissorCount = 1;
+  vs.pScissors = &sc2;
+
+  VkPipelineRasterizationStateCreateInfo raster{};
+  raster.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+  raster.polygonMode = VK_POLYGON_MODE_FILL;
+  raster.cullMode = VK_CULL_MODE_BACK_BIT;
+  raster.frontFace = VK_FRONT_FACE_CLOCKWISE;
+  raster.lineWidth = 1.f;
+
+  VkPipelineMultisampleStateCreateInfo ms{};
+  ms.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+  ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  VkPipelineDepthStencilStateCreateInfo ds{};
+  ds.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+  ds.depthTestEnable = VK_TRUE;
+  ds.depthWriteEnable = VK_TRUE;
+  ds.depthCompareOp = VK_COMPARE_OP_LESS;
+
+  VkPipelineColorBlendAttachmentState blendAtt{};
+  blendAtt.colorWriteMask = 0xF;
+
+  VkPipelineColorBlendStateCreateInfo blend{};
+  blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+  blend.attachmentCount = 1;
+  blend.pAttachments = &blendAtt;
+
+  // vk_draw sets the rect per frame, smaller under dynamic resolution
+  VkDynamicState dynStates[] = {VK_DYNAMIC_STATE_VIEWPORT,
+                                VK_DYNAMIC_STATE_SCISSOR};
+  VkPipelineDynamicStateCreateInfo dyn{};
+  dyn.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  dyn.dynamicStateCount = 2;
+  dyn.pDynamicStates = dynStates;
+
+  VkGraphicsPipelineCreateInfo pCI{};
+  pCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pCI.stageCount = 2;
+  pCI.pStages = stages;
+  pCI.pVertexInputState = &vertexInput;
+  pCI.pInputAssemblyState = &ia;
+  pCI.pViewportState = &vs;
+  pCI.pRasterizationState = &raster;
+  pCI.pMultisampleState = &ms;
+  pCI.pDepthStencilState = &ds;
+  pCI.pColorBlendState = &blend;
+  pCI.pDynamicState = &dyn;
+  pCI.layout = ctx.farPipelineLayout;
+  pCI.renderPass = ctx.renderPass;
+  check(vkCreateGraphicsPipelines(ctx.device.device, ctx.pipelineCache, 1,
+                                  &pCI, nullptr, &ctx.farPipeline),
+        "far terrain pipeline");
+
+  vkDestroyShaderModule(ctx.device.device, vertMod, nullptr);
+  vkDestroyShaderModule(ctx.device.device, fragMod, nullptr);
 }
 
-void MegaBuffer::releaseVerts(uint32_t offset, uint32_t count) {
-  doFreeRange(vertRanges, offset, count);
+// foliage.vert builds the plants itself, so no vertex input; both sides of
+// every blade
+static void createFoliagePipeline(VkContext &ctx) {
+  auto vertCode = loadSpv(AssetPath::get("foliage_vert.spv").c_str());
+  auto fragCode = loadSpv(AssetPath::get("foliage_frag.spv").c_str());
+  VkShaderModule vertMod = makeModule(ctx.device.device, vertCode);
+  VkShaderModule fragMod = makeModule(ctx.device.device, fragCode);
+
+  VkPipelineShaderStageCreateInfo stages[2]{};
+  stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+  stages[0].module = vertMod;
+  stages[0].pName = "main";
+  stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+  stages[1].module = fragMod;
+  stages[1].pName = "main";
+
+  VkPipelineVertexInputStateCreateInfo vertexInput{};
+  vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+  VkPipelineInputAssemblyStateCreateInfo ia{};
+  ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+  ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+  VkViewport vp{};
+  vp.width = (float)ctx.swapchain.extent.width;
+  vp.height = (float)ctx.swapchain.extent.height;
+  vp.maxDepth = 1.f;
+  VkRect2D sc2{};
+  sc2.extent = ctx.swapchain.extent;
+
+  VkPipelineViewportStateCreateInfo vs{};
+  vs.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+  vs.viewportCount = 1;
+  vs.pViewports = &vp;
+  vs.scissorCount = 1;
+  vs.pScissors = &sc2;
+
+  VkPipelineRasterizationStateCreateInfo raster{};
+  raster.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+  raster.polygonMode = VK_POLYGON_MODE_FILL;
+  raster.cullMode = VK_CULL_MODE_NONE;
+  raster.frontFace = VK_FRONT_FACE_CLOCKWISE;
+  raster.lineWidth = 1.f;
+
+  VkPipelineMultisampleStateCreateInfo ms{};
+  ms.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+  ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  VkPipelineDepthStencilStateCreateInfo ds{};
+  ds.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+  ds.depthTestEnable = VK_TRUE;
+  ds.depthWriteEnable = VK_TRUE;
+  ds.depthCompareOp = VK_COMPARE_OP_LESS;
+
+  VkPipelineColorBlendAttachmentState blendAtt{};
+  blendAtt.colorWriteMask = 0xF;
+
+  VkPipelineColorBlendStateCreateInfo blend{};
+  blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+  blend.attachmentCount = 1;
+  blend.pAttachments = &blendAtt;
+
+  // vk_draw sets the rect per frame, smaller under dynamic resolution
+  VkDynamicState dynStates[] = {VK_DYNAMIC_STATE_VIEWPORT,
+                                VK_DYNAMIC_STATE_SCISSOR};
+  VkPipelineDynamicStateCreateInfo dyn{};
+  dyn.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  dyn.dynamicStateCount = 2;
+  dyn.pDynamicStates = dynStates;
+
+  VkGraphicsPipelineCreateInfo pCI{};
+  pCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pCI.stageCount = 2;
+  pCI.pStages = stages;
+  pCI.pVertexInputState = &vertexInput;
+  pCI.pInputAssemblyState = &ia;
+  pCI.pViewportState = &vs;
+  pCI.pRasterizationState = &raster;
+  pCI.pMultisampleState = &ms;
+  pCI.pDepthStencilState = &ds;
+  pCI.pColorBlendState = &blend;
+  pCI.pDynamicState = &dyn;
+  pCI.layout = ctx.foliagePipelineLayout;
+  pCI.renderPass = ctx.renderPass;
+  check(vkCreateGraphicsPipelines(ctx.device.device, ctx.pipelineCache, 1,
+                                  &pCI, nullptr, &ctx.foliagePipeline),
+        "foliage pipeline");
+
+  vkDestroyShaderModule(ctx.device.device, vertMod, nullptr);
+  vkDestroyShaderModule(ctx.device.device, fragMod, nullptr);
 }
 
-void MegaBuffer::releaseInds(uint32_t offset, uint32_t count) {
-  doFreeRange(indRanges, offset, count);
+// particle.vert builds the quads itself, so no vertex input. Premultiplied
+// blending, so one draw holds both kinds: alpha 0 adds, the rest cover.
+// Tested against depth but not written, since they overlap each other
+// unsorted.
+static void createParticlePipeline(VkContext &ctx) {
+  auto vertCode = loadSpv(AssetPath::get("particle_vert.spv").c_str());
+  auto fragCode = loadSpv(AssetPath::get("particle_frag.spv").c_str());
+  VkShaderModule vertMod = makeModule(ctx.device.device, vertCode);
+  VkShaderModule fragMod = makeModule(ctx.device.device, fragCode);
+
+  VkPipelineShaderStageCreateInfo stages[2]{};
+  stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+  stages[0].module = vertMod;
+  stages[0].pName = "main";
+  stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+  stages[1].module = fragMod;
+  stages[1].pName = "main";
+
+  VkPipelineVertexInputStateCreateInfo vertexInput{};
+  vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+  VkPipelineInputAssemblyStateCreateInfo ia{};
+  ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+  ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+  VkViewport vp{};
+  vp.width = (float)ctx.swapchain.extent.width;
+  vp.height = (float)ctx.swapchain.extent.height;
+  vp.maxDepth = 1.f;
+  VkRect2D sc2{};
+  sc2.extent = ctx.swapchain.extent;
+
+  VkPipelineViewportStateCreateInfo vs{};
+  vs.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+  vs.viewportCount = 1;
+  vs.pViewports = &vp;
+  vs.scissorCount = 1;
+  vs.pScissors = &sc2;
+
+  VkPipelineRasterizationStateCreateInfo raster{};
+  raster.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+  raster.polygonMode = VK_POLYGON_MODE_FILL;
+  raster.cullMode = VK_CULL_MODE_NONE;
+  raster.frontFace = VK_FRONT_FACE_CLOCKWISE;
+  raster.lineWidth = 1.f;
+
+  VkPipelineMultisampleStateCreateInfo ms{};
+  ms.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+  ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  VkPipelineDepthStencilStateCreateInfo ds{};
+  ds.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+  ds.depthTestEnable = VK_TRUE;
+  ds.depthWriteEnable = VK_FALSE;
+  ds.depthCompareOp = VK_COMPARE_OP_LESS;
+
+  VkPipelineColorBlendAttachmentState blendAtt{};
+  blendAtt.blendEnable = VK_TRUE;
+  blendAtt.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+  blendAtt.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  blendAtt.colorBlendOp = VK_BLEND_OP_ADD;
+  blendAtt.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+  blendAtt.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  blendAtt.alphaBlendOp = VK_BLEND_OP_ADD;
+  blendAtt.colorWriteMask = 0xF;
+
+  VkPipelineColorBlendStateCreateInfo blend{};
+  blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+  blend.attachmentCount = 1;
+  blend.pAttachments = &blendAtt;
+
+  // vk_draw sets the rect per frame, smaller under dynamic resolution
+  VkDynamicState dynStates[] = {VK_DYNAMIC_STATE_VIEWPORT,
+                                VK_DYNAMIC_STATE_SCISSOR};
+  VkPipelineDynamicStateCreateInfo dyn{};
+  dyn.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  dyn.dynamicStateCount = 2;
+  dyn.pDynamicStates = dynStates;
+
+  VkGraphicsPipelineCreateInfo pCI{};
+  pCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pCI.stageCount = 2;
+  pCI.pStages = stages;
+  pCI.pVertexInputState = &vertexInput;
+  pCI.pInputAssemblyState = &ia;
+  pCI.pViewportState = &vs;
+  pCI.pRasterizationState = &raster;
+  pCI.pMultisampleState = &ms;
+  pCI.pDepthStencilState = &ds;
+  pCI.pColorBlendState = &blend;
+  pCI.pDynamicState = &dyn;
+  pCI.layout = ctx.particlePipelineLayout;
+  pCI.renderPass = ctx.renderPass;
+  check(vkCreateGraphicsPipelines(ctx.device.device, ctx.pipelineCache, 1,
+                                  &pCI, nullptr, &ctx.particlePipeline),
+        "particle pipeline");
+
+  vkDestroyShaderModule(ctx.device.device, vertMod, nullptr);
+  vkDestroyShaderModule(ctx.device.device, fragMod, nullptr);
 }
 
-// ── Depth image
-// ───────────────────────────────────────────────────────────────
+// Only creates pipelines, through the internally synchronized cache, and
+// writes handles nothing else reads until pipelinesReady
+void vk_build_pipelines(VkContext &ctx) {
+  VkDevice dev = ctx.device.device;
+  ctx.pipeline = createTerrainPipeline(ctx);
+  createFarPipeline(ctx);
+  ctx.cullChunksPipeline = makeComputePipeline(dev, ctx.pipelineCache,
+                                               "cull_chunks_comp.spv",
+                                               ctx.cullPipelineLayout);
+  ctx.cullMeshletsPipeline = makeComputePipeline(dev, ctx.pipelineCache,
+                                                 "cull_meshlets_comp.spv",
+                                                 ctx.cullPipelineLayout);
+  ctx.cullEmitPipeline = makeComputePipeline(dev, ctx.pipelineCache,
+                                             "cull_emit_comp.spv",
+                                             ctx.cullPipelineLayout);
+  ctx.hizPipeline = makeComputePipeline(dev, ctx.pipelineCache, "hiz_comp.spv",
+                                        ctx.hizPipelineLayout);
+  ctx.foliageScatterPipeline = makeComputePipeline(
+      dev, ctx.pipelineCache, "foliage_comp.spv", ctx.foliageScatterLayout);
+  createFoliagePipeline(ctx);
+  ctx.particleSimulatePipeline =
+      makeComputePipeline(dev, ctx.pipelineCache, "particle_simulate_comp.spv",
+                          ctx.particleSimLayout);
+  ctx.particleEmitPipeline =
+      makeComputePipeline(dev, ctx.pipelineCache, "particle_emit_comp.spv",
+                          ctx.particleSimLayout);
+  ctx.particleArgsPipeline =
+      makeComputePipeline(dev, ctx.pipelineCache, "particle_args_comp.spv",
+                          ctx.particleSimLayout);
+  createParticlePipeline(ctx);
+  ctx.lightCullPipeline =
+      makeComputePipeline(dev, ctx.pipelineCache, "light_cull_comp.spv",
+                          ctx.lightCullLayout);
+  if (ctx.gpuMesh) {
+    ctx.marchClassify =
+        makeComputePipeline(dev, ctx.pipelineCache, "march_classify_comp.spv",
+                            ctx.marchPipelineLayout);
+    ctx.marchScan = makeComputePipeline(dev, ctx.pipelineCache,
+                                        "march_scan_comp.spv",
+                                        ctx.marchPipelineLayout);
+    ctx.marchEmit = makeComputePipeline(dev, ctx.pipelineCache,
+                                        "march_emit_comp.spv",
+                                        ctx.marchPipelineLayout);
+  }
+}
 
-static void createDepthResources(VkContext &ctx) {
-  VkImageCreateInfo imgCI{};
-  imgCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-  imgCI.imageType = VK_IMAGE_TYPE_2D;
-  imgCI.format = VK_FORMAT_D32_SFLOAT;
-  imgCI.extent = {ctx.swapchain.extent.width, ctx.swapchain.extent.height, 1};
-  imgCI.mipLevels = 1;
-  imgCI.arrayLayers = 1;
-  imgCI.samples = VK_SAMPLE_COUNT_1_BIT;
-  imgCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-  imgCI.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-  VmaAllocationCreateInfo aCI{};
-  aCI.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-  vmaCreateImage(ctx.allocator, &imgCI, &aCI, &ctx.depthImage, &ctx.depthAlloc,
-                 nullptr);
+void vk_save_pipeline_cache(VkContext &ctx) {
+  PipelineCache::save(ctx.device.physical_device.physical_device,
+                      ctx.device.device, ctx.pipelineCache);
+}
 
-  VkImageViewCreateInfo vCI{};
-  vCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-  vCI.image = ctx.depthImage;
-  vCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
-  vCI.format = VK_FORMAT_D32_SFLOAT;
-  vCI.subresourceRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1};
-  check(
-      vkCreateImageView(ctx.device.device, &vCI, nullptr, &ctx.depthImageView),
-      "depth view");
+void vk_set_shader_tier(VkContext &ctx, ShaderTier tier) {
+  if (tier == ctx.shaderTier || !ctx.pipelinesReady)
+    return;
+  auto t0 = std::chrono::steady_clock::now();
+  ctx.shaderTier = tier;
+  VkPipeline built = createTerrainPipeline(ctx, /*colourOnly=*/true);
+  ctx.retiredPipelines.push_back({ctx.pipeline, ctx.framesSubmitted});
+  ctx.pipeline = built;
+  Log::info("Terrain shaders now tier " + std::to_string((int)tier) + ", " +
+            std::to_string(std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - t0)
+                               .count()) +
+            " ms");
+  vk_save_pipeline_cache(ctx);
 }
 
 // ── vk_init
 // ───────────────────────────────────────────────────────────────────
 
-VkContext vk_init(GLFWwindow *window) {
+VkContext vk_init(GLFWwindow *window, bool gpuMesh, VkExtent2D offscreen) {
   VkContext ctx;
+  ctx.gpuMesh = gpuMesh;
 
   // ── Auto-detect Vulkan version ────────────────────────────────────────────
   uint32_t instanceVersion = VK_API_VERSION_1_0;
@@ -170,38 +1673,159 @@ VkContext vk_init(GLFWwindow *window) {
   if (!phys)
     throw std::runtime_error(phys.error().message());
 
-  auto dev = vkb::DeviceBuilder{phys.value()}.build();
+  // Timeline semaphores (core in 1.2) let chunk uploads run on their own
+  // queue with nothing on the render path waiting for them;
+  // drawIndirectCount lets the terrain draw take its count from cull.comp
+  VkPhysicalDeviceVulkan12Features feat12{};
+  feat12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  bool timeline = false, indirectCount = false;
+  if (minor >= 2 && phys.value().properties.apiVersion >= VK_API_VERSION_1_2) {
+    VkPhysicalDeviceFeatures2 f2{};
+    f2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    f2.pNext = &feat12;
+    vkGetPhysicalDeviceFeatures2(phys.value().physical_device, &f2);
+    timeline = feat12.timelineSemaphore == VK_TRUE;
+    indirectCount = feat12.drawIndirectCount == VK_TRUE;
+  }
+  VkPhysicalDeviceVulkan12Features want12{};
+  want12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  want12.timelineSemaphore = timeline;
+  want12.drawIndirectCount = indirectCount;
+
+  // One indirect call draws every visible chunk, each carrying its slot
+  // in firstInstance
+  vkb::PhysicalDevice physDev = phys.value();
+  VkPhysicalDeviceFeatures multiDraw{};
+  multiDraw.multiDrawIndirect = VK_TRUE;
+  if (!physDev.enable_features_if_present(multiDraw))
+    Log::warn("multiDrawIndirect not supported");
+  VkPhysicalDeviceFeatures firstInstance{};
+  firstInstance.drawIndirectFirstInstance = VK_TRUE;
+  if (!physDev.enable_features_if_present(firstInstance))
+    Log::warn("drawIndirectFirstInstance not supported");
+  // The bindless table is indexed by push constants
+  VkPhysicalDeviceFeatures arrayIndexing{};
+  arrayIndexing.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+  arrayIndexing.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
+  if (!physDev.enable_features_if_present(arrayIndexing))
+    Log::warn("descriptor array dynamic indexing not supported");
+
+  // Present wait (on top of present id): low latency mode waits for the
+  // display, not just the GPU
+  VkPhysicalDevicePresentWaitFeaturesKHR wantWait{};
+  wantWait.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+  VkPhysicalDevicePresentIdFeaturesKHR wantId{};
+  wantId.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+  bool presentWait = false;
+  if (physDev.is_extension_present(VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+      physDev.is_extension_present(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+    wantId.pNext = &wantWait;
+    VkPhysicalDeviceFeatures2 f2{};
+    f2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    f2.pNext = &wantId;
+    vkGetPhysicalDeviceFeatures2(physDev.physical_device, &f2);
+    wantId.pNext = nullptr;
+    presentWait = wantId.presentId && wantWait.presentWait;
+    if (presentWait)
+      physDev.enable_extensions_if_present(
+          {VK_KHR_PRESENT_ID_EXTENSION_NAME,
+           VK_KHR_PRESENT_WAIT_EXTENSION_NAME});
+  }
+
+  // Memory budget: what the driver lets us have, for MemoryBudget. Its
+  // properties query is core in 1.1.
+  bool memoryBudget =
+      physDev.enable_extension_if_present(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  Log::info(memoryBudget ? "Memory budget: yes" : "Memory budget: no");
+
+  vkb::DeviceBuilder devBuilder{physDev};
+  if (timeline || indirectCount)
+    devBuilder.add_pNext(&want12);
+  if (presentWait) {
+    devBuilder.add_pNext(&wantId);
+    devBuilder.add_pNext(&wantWait);
+  }
+  auto dev = devBuilder.build();
   if (!dev)
     throw std::runtime_error(dev.error().message());
   ctx.device = dev.value();
+  if (presentWait)
+    ctx.waitForPresent = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(
+        ctx.device.device, "vkWaitForPresentKHR");
+  Log::info(ctx.waitForPresent ? "Present wait: yes" : "Present wait: no");
+  ctx.pipelineCache = PipelineCache::create(
+      ctx.device.physical_device.physical_device, ctx.device.device);
+  if (indirectCount)
+    ctx.cmdDrawIndexedIndirectCount =
+        (PFN_vkCmdDrawIndexedIndirectCount)vkGetDeviceProcAddr(
+            ctx.device.device, "vkCmdDrawIndexedIndirectCount");
 
   auto gq = ctx.device.get_queue(vkb::QueueType::graphics);
   if (!gq)
     throw std::runtime_error("No graphics queue");
   ctx.graphicsQueue = gq.value();
   ctx.graphicsQueueFamily =
-      ctx.device.get_queue_index(vkb::QueueType::graphics).value();
-
-  int w, h;
-  glfwGetFramebufferSize(window, &w, &h);
-  auto sc = vkb::SwapchainBuilder{ctx.device}
-                .set_desired_format({VK_FORMAT_B8G8R8A8_SRGB,
-                                     VK_COLOR_SPACE_SRGB_NONLINEAR_KHR})
-                .set_desired_present_mode(VK_PRESENT_MODE_FIFO_KHR)
-                .set_desired_extent(w, h)
-                .build();
-  if (!sc)
-    throw std::runtime_error(sc.error().message());
-  ctx.swapchain = sc.value();
-  ctx.swapImages = ctx.swapchain.get_images().value();
-  ctx.swapImageViews = ctx.swapchain.get_image_views().value();
+      ctx.device.get_queue_index(vkb::QueueType::graphics).value();
+  ctx.profiler.init(ctx.device.physical_device.physical_device,
+                    ctx.device.device, ctx.graphicsQueueFamily,
+                    VkContext::FRAMES_IN_FLIGHT);
+
+  // Chunk uploads go to a dedicated transfer family if there is one. That
+  // needs the timeline semaphore to order them against the draws.
+  ctx.transferQueue = ctx.graphicsQueue;
+  ctx.transferQueueFamily = ctx.graphicsQueueFamily;
+  if (timeline) {
+    auto tq = ctx.device.get_dedicated_queue(vkb::QueueType::transfer);
+    auto ti = ctx.device.get_dedicated_queue_index(vkb::QueueType::transfer);
+    if (tq && ti) {
+      ctx.transferQueue = tq.value();
+      ctx.transferQueueFamily = ti.value();
+    }
+  }
+  Log::info(std::string("Chunk uploads: ") +
+            (ctx.transferQueueFamily != ctx.graphicsQueueFamily
+                 ? "dedicated transfer queue"
+                 : "graphics queue") +
+            (timeline ? ", timeline semaphore" : ", fences"));
+
+  if (offscreen.width && offscreen.height) {
+    // The window is only there for the surface the device was picked by
+    ctx.offscreen = true;
+    ctx.swapchain.extent = offscreen;
+    ctx.swapchain.image_format = VK_FORMAT_B8G8R8A8_SRGB;
+    ctx.swapchain.image_usage_flags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                                      VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    ctx.swapchain.image_count = VkContext::FRAMES_IN_FLIGHT;
+  } else {
+    int w, h;
+    glfwGetFramebufferSize(window, &w, &h);
+    buildSwapchain(ctx, {(uint32_t)w, (uint32_t)h}, VK_PRESENT_MODE_FIFO_KHR);
+  }
+  {
+    VkFormatProperties fp;
+    vkGetPhysicalDeviceFormatProperties(
+        ctx.device.physical_device.physical_device, ctx.swapchain.image_format,
+        &fp);
+    VkFormatFeatureFlags need = VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+                                VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    ctx.canUpscale =
+        (ctx.swapchain.image_usage_flags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) &&
+        (fp.optimalTilingFeatures & need) == need;
+    if (!ctx.canUpscale)
+      Log::warn("Swapchain can't be blitted to — dynamic resolution off");
+  }
 
   VmaAllocatorCreateInfo vmaCI{};
   vmaCI.instance = ctx.instance.instance;
   vmaCI.physicalDevice = ctx.device.physical_device.physical_device;
   vmaCI.device = ctx.device.device;
   vmaCI.vulkanApiVersion = VK_MAKE_VERSION(major, minor, 0);
+  if (memoryBudget)
+    vmaCI.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
   check(vmaCreateAllocator(&vmaCI, &ctx.allocator), "VMA allocator");
+  if (ctx.offscreen)
+    createOffscreenImages(ctx);
 
   // ── Command pool ──────────────────────────────────────────────────────────
   VkCommandPoolCreateInfo poolCI{};
@@ -211,6 +1835,10 @@ VkContext vk_init(GLFWwindow *window) {
   check(vkCreateCommandPool(ctx.device.device, &poolCI, nullptr,
                             &ctx.commandPool),
         "cmd pool");
+  ctx.recordPool = std::make_unique<ThreadPool>(
+      ThreadPoolOptions{1, Config::RENDER_RECORD_THREADS, {}});
+  ctx.graph.init(ctx.device.device, ctx.graphicsQueueFamily,
+                 VkContext::FRAMES_IN_FLIGHT, ctx.recordPool.get());
 
   // ── Staging buffer ────────────────────────────────────────────────────────
   {
@@ -244,6 +1872,49 @@ VkContext vk_init(GLFWwindow *window) {
           "upload fence");
   }
 
+  // ── Chunk upload batches ──────────────────────────────────────────────────
+  {
+    VkCommandPoolCreateInfo tpCI{};
+    tpCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    tpCI.queueFamilyIndex = ctx.transferQueueFamily;
+    tpCI.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    check(vkCreateCommandPool(ctx.device.device, &tpCI, nullptr,
+                              &ctx.transferPool),
+          "transfer pool");
+
+    for (auto &b : ctx.uploadBatches) {
+      VkCommandBufferAllocateInfo aI{};
+      aI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+      aI.commandPool = ctx.transferPool;
+      aI.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+      aI.commandBufferCount = 1;
+      check(vkAllocateCommandBuffers(ctx.device.device, &aI, &b.cmd),
+            "upload batch cmd");
+      if (!timeline) {
+        VkFenceCreateInfo fCI{};
+        fCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        check(vkCreateFence(ctx.device.device, &fCI, nullptr, &b.fence),
+              "upload batch fence");
+      }
+    }
+
+    if (timeline) {
+      VkSemaphoreTypeCreateInfo tCI{};
+      tCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+      tCI.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+      tCI.initialValue = 0;
+      VkSemaphoreCreateInfo sCI{};
+      sCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+      sCI.pNext = &tCI;
+      check(vkCreateSemaphore(ctx.device.device, &sCI, nullptr,
+                              &ctx.uploadTimeline),
+            "upload timeline");
+      ctx.getSemaphoreCounterValue =
+          (PFN_vkGetSemaphoreCounterValue)vkGetDeviceProcAddr(
+              ctx.device.device, "vkGetSemaphoreCounterValue");
+    }
+  }
+
   // ── Mega vertex + index buffers ───────────────────────────────────────────
   {
     auto makeGpuBuf = [&](VkDeviceSize size, VkBufferUsageFlags usage,
@@ -251,47 +1922,151 @@ VkContext vk_init(GLFWwindow *window) {
       VkBufferCreateInfo bCI{};
       bCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
       bCI.size = size;
-      bCI.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+      // Compaction copies within the buffer, so it's a transfer source too;
+      // march.comp writes it directly, foliage.comp reads it
+      bCI.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+      // Written by the transfer queue, read by graphics — concurrent
+      // sharing saves an ownership transfer per upload
+      uint32_t families[] = {ctx.graphicsQueueFamily, ctx.transferQueueFamily};
+      if (families[0] != families[1]) {
+        bCI.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bCI.queueFamilyIndexCount = 2;
+        bCI.pQueueFamilyIndices = families;
+      }
       VmaAllocationCreateInfo aCI{};
       aCI.usage = VMA_MEMORY_USAGE_GPU_ONLY;
       check(vmaCreateBuffer(ctx.allocator, &bCI, &aCI, &buf, &alloc, nullptr),
             "mega buf");
     };
-    makeGpuBuf(MEGA_VERTEX_CAP * sizeof(Vertex),
+    makeGpuBuf(MEGA_VERTEX_CAP * sizeof(TerrainVertex),
                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, ctx.mega.vertexBuffer,
                ctx.mega.vertexAlloc);
     makeGpuBuf(MEGA_INDEX_CAP * sizeof(uint32_t),
                VK_BUFFER_USAGE_INDEX_BUFFER_BIT, ctx.mega.indexBuffer,
                ctx.mega.indexAlloc);
-    ctx.mega.vertRanges.push_back({0, MEGA_VERTEX_CAP});
-    ctx.mega.indRanges.push_back({0, MEGA_INDEX_CAP});
+    // Uploaded alongside the meshes, so shared the same way
+    makeGpuBuf(VkContext::MAX_MESHLETS * sizeof(GpuMeshlet),
+               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, ctx.meshletBuffer,
+               ctx.meshletAlloc);
   }
 
-  // ── Per-frame indirect + per-chunk buffers (CPU_TO_GPU, mapped) ───────────
-  for (int i = 0; i < 2; i++) {
-    auto makeHostBuf = [&](VkDeviceSize size, VkBufferUsageFlags usage,
-                           VkBuffer &buf, VmaAllocation &alloc, void *&mapped) {
+  // ── Chunk slot table + per-frame cull output ──────────────────────────────
+  {
+    auto makeBuf = [&](VkDeviceSize size, VkBufferUsageFlags usage,
+                       VmaMemoryUsage mem, VkBuffer &buf, VmaAllocation &alloc,
+                       void **mapped) {
       VkBufferCreateInfo bCI{};
       bCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
       bCI.size = size;
       bCI.usage = usage;
       VmaAllocationCreateInfo aCI{};
-      aCI.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-      aCI.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+      aCI.usage = mem;
+      if (mapped)
+        aCI.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
       VmaAllocationInfo info{};
       check(vmaCreateBuffer(ctx.allocator, &bCI, &aCI, &buf, &alloc, &info),
-            "host buf");
-      mapped = info.pMappedData;
+            "cull buf");
+      if (mapped)
+        *mapped = info.pMappedData;
     };
-    makeHostBuf(VkContext::MAX_DRAW_CHUNKS * sizeof(DrawCmd),
-                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, ctx.indirectBuffer[i],
-                ctx.indirectAlloc[i], ctx.indirectMapped[i]);
-    makeHostBuf(VkContext::MAX_DRAW_CHUNKS * sizeof(ChunkDrawData),
-                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, ctx.perChunkBuffer[i],
-                ctx.perChunkAlloc[i], ctx.perChunkMapped[i]);
+    makeBuf(VkContext::MAX_CHUNK_SLOTS * sizeof(ChunkSlot),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY, ctx.chunkSlotBuffer, ctx.chunkSlotAlloc,
+            nullptr);
+    for (int i = 0; i < 2; i++) {
+      makeBuf(VkContext::MAX_DRAWS * sizeof(DrawCmd),
+              VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                  VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+              VMA_MEMORY_USAGE_GPU_ONLY, ctx.indirectBuffer[i],
+              ctx.indirectAlloc[i], nullptr);
+      makeBuf(VkContext::CULL_COUNT_SIZE,
+              VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                  VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+              VMA_MEMORY_USAGE_GPU_ONLY, ctx.drawCountBuffer[i],
+              ctx.drawCountAlloc[i], nullptr);
+      makeBuf(sizeof(CullParams), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+              VMA_MEMORY_USAGE_CPU_TO_GPU, ctx.cullParamBuffer[i],
+              ctx.cullParamAlloc[i], &ctx.cullParamMapped[i]);
+      makeBuf(VkContext::MAX_CHUNK_SLOTS / 32 * sizeof(uint32_t),
+              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+              ctx.visibleBuffer[i], ctx.visibleAlloc[i],
+              &ctx.visibleMapped[i]);
+      makeBuf(VkContext::FOLIAGE_TYPES * sizeof(VkDrawIndirectCommand),
+              VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                  VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+              VMA_MEMORY_USAGE_GPU_ONLY, ctx.foliageDrawBuffer[i],
+              ctx.foliageDrawAlloc[i], nullptr);
+    }
+    makeBuf(VkContext::FRAMES_IN_FLIGHT * VkContext::FOLIAGE_TYPES *
+                VkContext::FOLIAGE_MAX_INSTANCES *
+                VkContext::FOLIAGE_INSTANCE_BYTES,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+            ctx.foliageInstanceBuffer, ctx.foliageInstanceAlloc, nullptr);
+    // Particles: the pools and their states carry over from frame to
+    // frame, on the GPU alone; only the emitters are written here
+    makeBuf(2 * VkContext::PARTICLE_MAX * VkContext::PARTICLE_BYTES,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+            ctx.particleBuffer, ctx.particleAlloc, nullptr);
+    makeBuf(2 * VkContext::PARTICLE_STATE_BYTES,
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY, ctx.particleStateBuffer,
+            ctx.particleStateAlloc, nullptr);
+    for (int i = 0; i < 2; i++)
+      makeBuf(VkContext::PARTICLE_MAX_EMITTERS * sizeof(ParticleEmitter),
+              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+              ctx.particleEmitterBuffer[i], ctx.particleEmitterAlloc[i],
+              &ctx.particleEmitterMapped[i]);
+    // Lights: written here per frame, copied into the grid the shading
+    // reads
+    for (int i = 0; i < 2; i++)
+      makeBuf(VkContext::LIGHT_INPUT_BYTES, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+              VMA_MEMORY_USAGE_CPU_TO_GPU, ctx.lightInputBuffer[i],
+              ctx.lightInputAlloc[i], &ctx.lightInputMapped[i]);
+    makeBuf(VkContext::LIGHT_GRID_BYTES,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY, ctx.lightGridBuffer, ctx.lightGridAlloc,
+            nullptr);
   }
 
-  createDepthResources(ctx);
+  // ── Far terrain ───────────────────────────────────────────────────────────
+  // Host-written: levels change every few seconds at most, a few tens of KB
+  // each
+  {
+    VkBufferCreateInfo bCI{};
+    bCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bCI.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    bCI.size = VkContext::FAR_VERTEX_BYTES;
+    VmaAllocationCreateInfo aCI{};
+    aCI.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    aCI.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    VmaAllocationInfo info{};
+    for (int i = 0; i < 2; i++) {
+      check(vmaCreateBuffer(ctx.allocator, &bCI, &aCI, &ctx.farVertexBuffer[i],
+                            &ctx.farVertexAlloc[i], &info),
+            "far vertex buf");
+      ctx.farVertexMapped[i] = info.pMappedData;
+    }
+
+    std::vector<uint16_t> indices = FarTerrain::indices();
+    bCI.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    bCI.size = indices.size() * sizeof(uint16_t);
+    check(vmaCreateBuffer(ctx.allocator, &bCI, &aCI, &ctx.farIndexBuffer,
+                          &ctx.farIndexAlloc, &info),
+          "far index buf");
+    memcpy(info.pMappedData, indices.data(), bCI.size);
+    vmaFlushAllocation(ctx.allocator, ctx.farIndexAlloc, 0, VK_WHOLE_SIZE);
+  }
+
+  createRenderTargets(ctx);
 
   // ── Render pass ───────────────────────────────────────────────────────────
   VkAttachmentDescription colorAtt{};
@@ -308,11 +2083,11 @@ VkContext vk_init(GLFWwindow *window) {
   depthAtt.format = VK_FORMAT_D32_SFLOAT;
   depthAtt.samples = VK_SAMPLE_COUNT_1_BIT;
   depthAtt.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-  depthAtt.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  depthAtt.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // the Hi-Z pyramid's source
   depthAtt.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
   depthAtt.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
   depthAtt.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  depthAtt.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  depthAtt.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
   VkAttachmentReference colorRef{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
   VkAttachmentReference depthRef{
@@ -324,14 +2099,24 @@ VkContext vk_init(GLFWwindow *window) {
   subpass.pColorAttachments = &colorRef;
   subpass.pDepthStencilAttachment = &depthRef;
 
-  VkSubpassDependency dep{};
-  dep.srcSubpass = VK_SUBPASS_EXTERNAL;
-  dep.dstSubpass = 0;
-  dep.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
-                     VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-  dep.dstStageMask = dep.srcStageMask;
-  dep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
-                      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  // In: the previous frame's Hi-Z build may still be reading depth.
+  // Out: this frame's build reads it.
+  VkSubpassDependency deps[2]{};
+  deps[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+  deps[0].dstSubpass = 0;
+  deps[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                         VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  deps[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                         VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+  deps[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                          VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  deps[1].srcSubpass = 0;
+  deps[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+  deps[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  deps[1].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  deps[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  deps[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
   VkAttachmentDescription atts[] = {colorAtt, depthAtt};
   VkRenderPassCreateInfo rpCI{};
@@ -340,10 +2125,52 @@ VkContext vk_init(GLFWwindow *window) {
   rpCI.pAttachments = atts;
   rpCI.subpassCount = 1;
   rpCI.pSubpasses = &subpass;
-  rpCI.dependencyCount = 1;
-  rpCI.pDependencies = &dep;
+  rpCI.dependencyCount = 2;
+  rpCI.pDependencies = deps;
   check(vkCreateRenderPass(ctx.device.device, &rpCI, nullptr, &ctx.renderPass),
         "render pass");
+
+  // Dynamic resolution: the same attachments, so every pipeline built for
+  // renderPass works in both. The scene pass leaves colour for the blit,
+  // and waits for the last one to have read it; the overlay pass loads the
+  // blit and starts depth over once the Hi-Z build has read the scene's.
+  if (ctx.canUpscale) {
+    colorAtt.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    atts[0] = colorAtt;
+    deps[0].srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT |
+                            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    deps[0].srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    deps[1].srcStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    deps[1].dstStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    deps[1].srcAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    deps[1].dstAccessMask |= VK_ACCESS_TRANSFER_READ_BIT;
+    check(vkCreateRenderPass(ctx.device.device, &rpCI, nullptr,
+                             &ctx.sceneRenderPass),
+          "scene render pass");
+
+    colorAtt.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    colorAtt.initialLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    colorAtt.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    depthAtt.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    atts[0] = colorAtt;
+    atts[1] = depthAtt;
+    VkSubpassDependency in{};
+    in.srcSubpass = VK_SUBPASS_EXTERNAL;
+    in.dstSubpass = 0;
+    in.srcStageMask =
+        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    in.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    in.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    in.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                       VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                       VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    rpCI.dependencyCount = 1;
+    rpCI.pDependencies = &in;
+    check(vkCreateRenderPass(ctx.device.device, &rpCI, nullptr,
+                             &ctx.overlayRenderPass),
+          "overlay render pass");
+  }
   // ── ImGui descriptor pool ─────────────────────────────────────────────────
   {
     VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
@@ -358,205 +2185,38 @@ VkContext vk_init(GLFWwindow *window) {
                                  &ctx.imguiPool),
           "imgui ds pool");
   }
-  // ── Framebuffers ──────────────────────────────────────────────────────────
-  ctx.framebuffers.resize(ctx.swapImageViews.size());
-  for (size_t i = 0; i < ctx.swapImageViews.size(); i++) {
-    VkImageView fbAtts[] = {ctx.swapImageViews[i], ctx.depthImageView};
-    VkFramebufferCreateInfo fbCI{};
-    fbCI.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-    fbCI.renderPass = ctx.renderPass;
-    fbCI.attachmentCount = 2;
-    fbCI.pAttachments = fbAtts;
-    fbCI.width = ctx.swapchain.extent.width;
-    fbCI.height = ctx.swapchain.extent.height;
-    fbCI.layers = 1;
-    check(vkCreateFramebuffer(ctx.device.device, &fbCI, nullptr,
-                              &ctx.framebuffers[i]),
-          "framebuf");
-  }
-
-  // ── Descriptor set layout ─────────────────────────────────────────────────
-  {
-    VkDescriptorSetLayoutBinding binding{};
-    binding.binding = 0;
-    binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    binding.descriptorCount = 1;
-    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-    VkDescriptorSetLayoutCreateInfo dsCI{};
-    dsCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    dsCI.bindingCount = 1;
-    dsCI.pBindings = &binding;
-    check(vkCreateDescriptorSetLayout(ctx.device.device, &dsCI, nullptr,
-                                      &ctx.dsLayout),
-          "ds layout");
-
-    VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2};
-    VkDescriptorPoolCreateInfo dpCI{};
-    dpCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    dpCI.maxSets = 2;
-    dpCI.poolSizeCount = 1;
-    dpCI.pPoolSizes = &poolSize;
-    check(
-        vkCreateDescriptorPool(ctx.device.device, &dpCI, nullptr, &ctx.dsPool),
-        "ds pool");
-
-    VkDescriptorSetLayout layouts[2] = {ctx.dsLayout, ctx.dsLayout};
-    VkDescriptorSetAllocateInfo dsAI{};
-    dsAI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    dsAI.descriptorPool = ctx.dsPool;
-    dsAI.descriptorSetCount = 2;
-    dsAI.pSetLayouts = layouts;
-    check(vkAllocateDescriptorSets(ctx.device.device, &dsAI, ctx.dsSets),
-          "ds alloc");
-
-    for (int i = 0; i < 2; i++) {
-      VkDescriptorBufferInfo bufInfo{};
-      bufInfo.buffer = ctx.perChunkBuffer[i];
-      bufInfo.offset = 0;
-      bufInfo.range = VkContext::MAX_DRAW_CHUNKS * sizeof(ChunkDrawData);
-      VkWriteDescriptorSet write{};
-      write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-      write.dstSet = ctx.dsSets[i];
-      write.dstBinding = 0;
-      write.descriptorCount = 1;
-      write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-      write.pBufferInfo = &bufInfo;
-      vkUpdateDescriptorSets(ctx.device.device, 1, &write, 0, nullptr);
-    }
-  }
-  // ── Atlas descriptor set layout (set 1) ──────────────────────────────────
-  {
-    VkDescriptorSetLayoutBinding binding{};
-    binding.binding = 0;
-    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    binding.descriptorCount = 1;
-    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-    VkDescriptorSetLayoutCreateInfo ci{};
-    ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    ci.bindingCount = 1;
-    ci.pBindings = &binding;
-    check(vkCreateDescriptorSetLayout(ctx.device.device, &ci, nullptr,
-                                      &ctx.atlasLayout),
-          "atlas ds layout");
-
-    VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1};
-    VkDescriptorPoolCreateInfo dpCI{};
-    dpCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    dpCI.maxSets = 1;
-    dpCI.poolSizeCount = 1;
-    dpCI.pPoolSizes = &poolSize;
-    check(vkCreateDescriptorPool(ctx.device.device, &dpCI, nullptr,
-                                 &ctx.atlasPool),
-          "atlas ds pool");
-
-    VkDescriptorSetAllocateInfo ai{};
-    ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    ai.descriptorPool = ctx.atlasPool;
-    ai.descriptorSetCount = 1;
-    ai.pSetLayouts = &ctx.atlasLayout;
-    check(vkAllocateDescriptorSets(ctx.device.device, &ai, &ctx.atlasSet),
-          "atlas ds alloc");
-  }
-  // ── Pipeline ──────────────────────────────────────────────────────────────
-  auto vertCode = loadSpv(AssetPath::get("terrain_vert.spv").c_str());
-  auto fragCode = loadSpv(AssetPath::get("terrain_frag.spv").c_str());
-  Log::info("Shaders loaded");
-
-  VkShaderModule vertMod = makeModule(ctx.device.device, vertCode);
-  VkShaderModule fragMod = makeModule(ctx.device.device, fragCode);
-
-  VkPipelineShaderStageCreateInfo stages[2]{};
-  stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-  stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-  stages[0].module = vertMod;
-  stages[0].pName = "main";
-  stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-  stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-  stages[1].module = fragMod;
-  stages[1].pName = "main";
-
-  VkVertexInputBindingDescription vBinding{};
-  vBinding.binding = 0;
-  vBinding.stride = sizeof(Vertex);
-  vBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-  VkVertexInputAttributeDescription attrs[3]{};
-  attrs[0].binding = 0;
-  attrs[0].location = 0;
-  attrs[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-  attrs[0].offset = offsetof(Vertex, pos);
-  attrs[1].binding = 0;
-  attrs[1].location = 1;
-  attrs[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-  attrs[1].offset = offsetof(Vertex, normal);
-
-  VkPipelineVertexInputStateCreateInfo vertexInput{};
-  vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-  vertexInput.vertexBindingDescriptionCount = 1;
-  vertexInput.pVertexBindingDescriptions = &vBinding;
-  vertexInput.vertexAttributeDescriptionCount = 3;
-  attrs[2].binding = 0;
-  attrs[2].location = 2;
-  attrs[2].format = VK_FORMAT_R32G32_SFLOAT;
-  attrs[2].offset = offsetof(Vertex, uv);
-  vertexInput.pVertexAttributeDescriptions = attrs;
-
-  VkPipelineInputAssemblyStateCreateInfo ia{};
-  ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-  ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-
-  VkViewport vp{};
-  vp.width = (float)ctx.swapchain.extent.width;
-  vp.height = (float)ctx.swapchain.extent.height;
-  vp.maxDepth = 1.f;
-  VkRect2D sc2{};
-  sc2.extent = ctx.swapchain.extent;
-
-  VkPipelineViewportStateCreateInfo vs{};
-  vs.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-  vs.viewportCount = 1;
-  vs.pViewports = &vp;
-  vs.scissorCount = 1;
-  vs.pScissors = &sc2;
-
-  VkPipelineRasterizationStateCreateInfo raster{};
-  raster.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-  raster.polygonMode = VK_POLYGON_MODE_FILL;
-  raster.cullMode = VK_CULL_MODE_BACK_BIT;
-  raster.frontFace = VK_FRONT_FACE_CLOCKWISE;
-  raster.lineWidth = 1.f;
-
-  VkPipelineMultisampleStateCreateInfo ms{};
-  ms.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-  ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-  VkPipelineDepthStencilStateCreateInfo ds{};
-  ds.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-  ds.depthTestEnable = VK_TRUE;
-  ds.depthWriteEnable = VK_TRUE;
-  ds.depthCompareOp = VK_COMPARE_OP_LESS;
-
-  VkPipelineColorBlendAttachmentState blendAtt{};
-  blendAtt.colorWriteMask = 0xF;
-
-  VkPipelineColorBlendStateCreateInfo blend{};
-  blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-  blend.attachmentCount = 1;
-  blend.pAttachments = &blendAtt;
-
+  createFramebuffers(ctx);
+
+  // ── Bindless table (set 0) ────────────────────────────────────────────────
+  // One texture and four buffers reserved: the atlas, once loaded, the
+  // chunk slots, the foliage instances, the particle pools and the light
+  // grid
+  ctx.bindless = std::make_unique<BindlessTable>();
+  if (!ctx.bindless->init(ctx.device.device,
+                          ctx.device.physical_device.properties.limits,
+                          VkContext::FRAMES_IN_FLIGHT, 1, 4))
+    throw std::runtime_error("bindless descriptor table");
+  ctx.bindless->setBuffer(VkContext::BINDLESS_CHUNK_SLOTS,
+                          ctx.chunkSlotBuffer, 0,
+                          VkContext::MAX_CHUNK_SLOTS * sizeof(ChunkSlot));
+  ctx.bindless->setBuffer(VkContext::BINDLESS_FOLIAGE,
+                          ctx.foliageInstanceBuffer);
+  ctx.bindless->setBuffer(VkContext::BINDLESS_PARTICLES, ctx.particleBuffer);
+  ctx.bindless->setBuffer(VkContext::BINDLESS_LIGHTS, ctx.lightGridBuffer);
+  // ── Shadow maps (set 1) ───────────────────────────────────────────────────
+  createShadowResources(ctx);
+  // ── Pipeline layout ───────────────────────────────────────────────────────
   VkPushConstantRange pushRange{};
   pushRange.stageFlags =
       VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-  pushRange.size = sizeof(glm::mat4) + sizeof(glm::vec4);
-  VkDescriptorSetLayout setLayouts[] = {ctx.dsLayout, ctx.atlasLayout};
+  // GlobalPC: terrain.frag reads the eye and fog past what the vertex
+  // stage and the shadow casters push
+  pushRange.size = sizeof(glm::mat4) + 3 * sizeof(glm::vec4);
+  VkDescriptorSetLayout setLayouts[] = {ctx.bindless->layout(),
+                                        ctx.shadowLayout};
 
   VkPipelineLayoutCreateInfo layoutCI{};
   layoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-
-  layoutCI.pSetLayouts = &ctx.dsLayout;
-
   layoutCI.setLayoutCount = 2;
   layoutCI.pSetLayouts = setLayouts;
   layoutCI.pPushConstantRanges = &pushRange;
@@ -565,25 +2225,26 @@ VkContext vk_init(GLFWwindow *window) {
                                &ctx.pipelineLayout),
         "pipeline layout");
 
-  VkGraphicsPipelineCreateInfo pCI{};
-  pCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-  pCI.stageCount = 2;
-  pCI.pStages = stages;
-  pCI.pVertexInputState = &vertexInput;
-  pCI.pInputAssemblyState = &ia;
-  pCI.pViewportState = &vs;
-  pCI.pRasterizationState = &raster;
-  pCI.pMultisampleState = &ms;
-  pCI.pDepthStencilState = &ds;
-  pCI.pColorBlendState = &blend;
-  pCI.layout = ctx.pipelineLayout;
-  pCI.renderPass = ctx.renderPass;
-  check(vkCreateGraphicsPipelines(ctx.device.device, VK_NULL_HANDLE, 1, &pCI,
-                                  nullptr, &ctx.pipeline),
-        "pipeline");
-
-  vkDestroyShaderModule(ctx.device.device, vertMod, nullptr);
-  vkDestroyShaderModule(ctx.device.device, fragMod, nullptr);
+  // Far terrain: the table alone, and FarPC
+  pushRange.size = sizeof(glm::mat4) + 4 * sizeof(glm::vec4);
+  layoutCI.setLayoutCount = 1;
+  check(vkCreatePipelineLayout(ctx.device.device, &layoutCI, nullptr,
+                               &ctx.farPipelineLayout),
+        "far terrain pipeline layout");
+
+  // ── GPU culling ───────────────────────────────────────────────────────────
+  createHizResources(ctx);
+  createCullResources(ctx);
+  createFoliageResources(ctx);
+  createParticleResources(ctx);
+  createLightResources(ctx);
+  Log::info(std::string("Chunk culling: GPU frustum + Hi-Z, ") +
+            (ctx.cmdDrawIndexedIndirectCount ? "indirect count"
+                                             : "fixed-size indirect draw"));
+  if (ctx.gpuMesh) {
+    createMarchResources(ctx);
+    Log::info("Chunk meshing: GPU compute (full-resolution fields)");
+  }
 
   // ── Command buffers ───────────────────────────────────────────────────────
   ctx.commandBuffers.resize(VkContext::FRAMES_IN_FLIGHT);
@@ -630,6 +2291,24 @@ void vk_load_atlas(VkContext &ctx, const char *path) {
   }
   VkDeviceSize size = w * h * 4;
 
+  // The atlas is a 4x4 grid of tiles with one material per column of the
+  // top row; each becomes a layer, copied straight out of the PNG rows
+  const uint32_t layers = ATLAS_MAT_COUNT;
+  const uint32_t tileW = (uint32_t)w / 4, tileH = (uint32_t)h / 4;
+  uint32_t mips = 1;
+  VkFormatProperties fp;
+  vkGetPhysicalDeviceFormatProperties(
+      ctx.device.physical_device.physical_device, VK_FORMAT_R8G8B8A8_SRGB, &fp);
+  bool canBlit = (fp.optimalTilingFeatures &
+                  VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) &&
+                 (fp.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT) &&
+                 (fp.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT);
+  if (canBlit)
+    while ((std::max(tileW, tileH) >> mips) > 0)
+      mips++;
+  else
+    Log::warn("Atlas format can't be blitted, no mipmaps");
+
   // Stage + upload
   VkBuffer stageBuf;
   VmaAllocation stageAlloc;
@@ -651,19 +2330,20 @@ void vk_load_atlas(VkContext &ctx, const char *path) {
   imgCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   imgCI.imageType = VK_IMAGE_TYPE_2D;
   imgCI.format = VK_FORMAT_R8G8B8A8_SRGB;
-  imgCI.extent = {(uint32_t)w, (uint32_t)h, 1};
-  imgCI.mipLevels = 1;
-  imgCI.arrayLayers = 1;
+  imgCI.extent = {tileW, tileH, 1};
+  imgCI.mipLevels = mips;
+  imgCI.arrayLayers = layers;
   imgCI.samples = VK_SAMPLE_COUNT_1_BIT;
   imgCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-  imgCI.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  imgCI.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
   imgCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
   VmaAllocationCreateInfo aCI{};
   aCI.usage = VMA_MEMORY_USAGE_GPU_ONLY;
   vmaCreateImage(ctx.allocator, &imgCI, &aCI, &ctx.atlasImage, &ctx.atlasAlloc,
                  nullptr);
 
-  // Transition + copy + transition via upload cmd
+  // Transition + copy + mip blits via upload cmd
   vkWaitForFences(ctx.device.device, 1, &ctx.uploadFence, VK_TRUE, UINT64_MAX);
   vkResetFences(ctx.device.device, 1, &ctx.uploadFence);
   vkResetCommandBuffer(ctx.uploadCmd, 0);
@@ -672,7 +2352,8 @@ void vk_load_atlas(VkContext &ctx, const char *path) {
   bI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
   vkBeginCommandBuffer(ctx.uploadCmd, &bI);
 
-  auto barrier = [&](VkImageLayout oldL, VkImageLayout newL, VkAccessFlags srcA,
+  auto barrier = [&](uint32_t mip, uint32_t mipCount, VkImageLayout oldL,
+                     VkImageLayout newL, VkAccessFlags srcA,
                      VkAccessFlags dstA, VkPipelineStageFlags srcS,
                      VkPipelineStageFlags dstS) {
     VkImageMemoryBarrier b{};
@@ -682,320 +2363,2142 @@ void vk_load_atlas(VkContext &ctx, const char *path) {
     b.srcAccessMask = srcA;
     b.dstAccessMask = dstA;
     b.image = ctx.atlasImage;
-    b.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    b.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, mip, mipCount, 0, layers};
     vkCmdPipelineBarrier(ctx.uploadCmd, srcS, dstS, 0, 0, nullptr, 0, nullptr,
                          1, &b);
   };
 
-  barrier(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0,
-          VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-          VK_PIPELINE_STAGE_TRANSFER_BIT);
+  barrier(0, mips, VK_IMAGE_LAYOUT_UNDEFINED,
+          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+          VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+  std::vector<VkBufferImageCopy> regions(layers);
+  for (uint32_t l = 0; l < layers; l++) {
+    regions[l].bufferOffset = (VkDeviceSize)l * tileW * 4;
+    regions[l].bufferRowLength = (uint32_t)w;
+    regions[l].bufferImageHeight = (uint32_t)h;
+    regions[l].imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, l, 1};
+    regions[l].imageExtent = {tileW, tileH, 1};
+  }
+  vkCmdCopyBufferToImage(ctx.uploadCmd, stageBuf, ctx.atlasImage,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layers,
+                         regions.data());
+
+  // Each level from the one above, all layers per blit; a level is done
+  // (shader-readable) once the next one has been made from it
+  int32_t mw = (int32_t)tileW, mh = (int32_t)tileH;
+  for (uint32_t m = 1; m < mips; m++) {
+    barrier(m - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT);
+    int32_t nw = std::max(mw / 2, 1), nh = std::max(mh / 2, 1);
+    VkImageBlit blit{};
+    blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, m - 1, 0, layers};
+    blit.srcOffsets[1] = {mw, mh, 1};
+    blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, m, 0, layers};
+    blit.dstOffsets[1] = {nw, nh, 1};
+    vkCmdBlitImage(ctx.uploadCmd, ctx.atlasImage,
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, ctx.atlasImage,
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
+                   VK_FILTER_LINEAR);
+    barrier(m - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    mw = nw;
+    mh = nh;
+  }
+  barrier(mips - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+          VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+          VK_PIPELINE_STAGE_TRANSFER_BIT,
+          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+  vkEndCommandBuffer(ctx.uploadCmd);
+  VkSubmitInfo si{};
+  si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  si.commandBufferCount = 1;
+  si.pCommandBuffers = &ctx.uploadCmd;
+  vkQueueSubmit(ctx.graphicsQueue, 1, &si, ctx.uploadFence);
+  vkWaitForFences(ctx.device.device, 1, &ctx.uploadFence, VK_TRUE, UINT64_MAX);
+  vmaDestroyBuffer(ctx.allocator, stageBuf, stageAlloc);
+
+  // Image view
+  VkImageViewCreateInfo vCI{};
+  vCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  vCI.image = ctx.atlasImage;
+  vCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+  vCI.format = VK_FORMAT_R8G8B8A8_SRGB;
+  vCI.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mips, 0, layers};
+  vkCreateImageView(ctx.device.device, &vCI, nullptr, &ctx.atlasImageView);
+
+  // Trilinear; tiles wrap within their own layer, so nothing bleeds in from
+  // the neighbouring material
+  VkSamplerCreateInfo sCI{};
+  sCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  sCI.magFilter = VK_FILTER_LINEAR;
+  sCI.minFilter = VK_FILTER_LINEAR;
+  sCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  sCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  sCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  sCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sCI.maxLod = VK_LOD_CLAMP_NONE;
+  vkCreateSampler(ctx.device.device, &sCI, nullptr, &ctx.atlasSampler);
+
+  ctx.bindless->setTexture(VkContext::BINDLESS_ATLAS, ctx.atlasImageView,
+                           ctx.atlasSampler);
+
+  Log::info(std::string("Atlas loaded: ") + path + " (" +
+            std::to_string(layers) + " layers of " + std::to_string(tileW) +
+            "x" + std::to_string(tileH) + ", " + std::to_string(mips) +
+            " mips)");
+}
+// ── Upload
+// ────────────────────────────────────────────────────────────────────
+
+// Newer data for key arrived: GPU jobs for it must not show or report it
+static void dropGpuMeshJobs(VkContext &ctx, const ChunkKey &key) {
+  for (int i : ctx.gpuMeshOrder)
+    if (ctx.gpuMeshJobs[i].key == key)
+      ctx.gpuMeshJobs[i].dropped = true;
+}
+
+void vk_upload_chunk(VkContext &ctx, ChunkUpload &&mesh) {
+  dropGpuMeshJobs(ctx, {mesh.coord, mesh.lod});
+  // Empty ones too: an all-solid chunk is what the walk stops at
+  if (mesh.lod == 0)
+    ctx.visibility.set(mesh.coord, mesh.faceLinks);
+  if (mesh.vertices.empty()) {
+    ctx.spentMeshes.push_back(std::move(mesh));
+    return;
+  }
+  ctx.uploadQueue.push_back({std::move(mesh), Trace::on() ? Trace::nowUs() : 0});
+}
+
+// Reserve n bytes of the staging ring. Each allocation is contiguous, so a
+// request that doesn't fit before the end wraps to the start. False when the
+// space is still held by batches in flight.
+static bool stagingAlloc(VkContext &ctx, VkDeviceSize n, VkDeviceSize &off) {
+  n = (n + 15) & ~VkDeviceSize(15);
+  if (ctx.stagingUsed == 0)
+    ctx.stagingHead = ctx.stagingTail = 0;
+  VkDeviceSize head = ctx.stagingHead, tail = ctx.stagingTail;
+  if (ctx.stagingUsed == 0 || head > tail) {
+    if (ctx.stagingSize - head >= n) {
+      off = head;
+    } else if (tail > n || ctx.stagingUsed == 0) {
+      if (n > ctx.stagingSize)
+        return false;
+      // The skipped tail end counts as used until the ring comes round
+      ctx.stagingUsed += ctx.stagingSize - head;
+      off = 0;
+    } else {
+      return false;
+    }
+  } else if (tail - head > n) {
+    off = head;
+  } else {
+    return false;
+  }
+  ctx.stagingHead = off + n;
+  ctx.stagingUsed += n;
+  return true;
+}
+
+// ── Asset uploads ─────────────────────────────────────────────────────────────
+
+void vk_submit_assets(VkContext &ctx, StagedUploads &batch) {
+  if (batch.empty())
+    return;
+  vk_wait_assets(ctx);
+  VkDevice dev = ctx.device.device;
+  const VkDeviceSize n = batch.bytes();
+  VkBuffer staging = ctx.stagingBuffer;
+  uint8_t *mapped = static_cast<uint8_t *>(ctx.stagingMapped);
+  VkDeviceSize off = 0;
+  if (ctx.uploadsInFlight.empty() && stagingAlloc(ctx, n, off)) {
+    ctx.assetRingBytes = (n + 15) & ~VkDeviceSize(15);
+  } else {
+    // Bigger than the ring: a buffer of its own for this batch
+    VkBufferCreateInfo bCI{};
+    bCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bCI.size = n;
+    bCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    VmaAllocationCreateInfo aCI{};
+    aCI.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+    aCI.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    VmaAllocationInfo info{};
+    check(vmaCreateBuffer(ctx.allocator, &bCI, &aCI, &ctx.assetStaging,
+                          &ctx.assetStagingAlloc, &info),
+          "asset staging buf");
+    staging = ctx.assetStaging;
+    mapped = static_cast<uint8_t *>(info.pMappedData);
+  }
+
+  vkResetFences(dev, 1, &ctx.uploadFence);
+  vkResetCommandBuffer(ctx.uploadCmd, 0);
+  VkCommandBufferBeginInfo bI{};
+  bI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  bI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkBeginCommandBuffer(ctx.uploadCmd, &bI);
+  batch.record(ctx.uploadCmd, staging, mapped, off);
+  vkEndCommandBuffer(ctx.uploadCmd);
+
+  VkSubmitInfo si{};
+  si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  si.commandBufferCount = 1;
+  si.pCommandBuffers = &ctx.uploadCmd;
+  check(vkQueueSubmit(ctx.graphicsQueue, 1, &si, ctx.uploadFence),
+        "asset upload submit");
+  ctx.assetsInFlight = true;
+  Log::info("Asset uploads: " + std::to_string(n >> 10) +
+            " KB in one submission");
+}
+
+bool vk_assets_uploaded(VkContext &ctx) {
+  if (!ctx.assetsInFlight)
+    return true;
+  if (vkGetFenceStatus(ctx.device.device, ctx.uploadFence) != VK_SUCCESS)
+    return false;
+  ctx.assetsInFlight = false;
+  ctx.stagingUsed -= ctx.assetRingBytes;
+  ctx.assetRingBytes = 0;
+  if (ctx.assetStaging) {
+    vmaDestroyBuffer(ctx.allocator, ctx.assetStaging, ctx.assetStagingAlloc);
+    ctx.assetStaging = VK_NULL_HANDLE;
+    ctx.assetStagingAlloc = nullptr;
+  }
+  return true;
+}
+
+void vk_wait_assets(VkContext &ctx) {
+  if (!ctx.assetsInFlight)
+    return;
+  vkWaitForFences(ctx.device.device, 1, &ctx.uploadFence, VK_TRUE, UINT64_MAX);
+  vk_assets_uploaded(ctx);
+}
+
+static bool batchDone(VkContext &ctx, const UploadBatch &b) {
+  if (ctx.uploadTimeline) {
+    uint64_t v = 0;
+    ctx.getSemaphoreCounterValue(ctx.device.device, ctx.uploadTimeline, &v);
+    return v >= b.value;
+  }
+  return vkGetFenceStatus(ctx.device.device, b.fence) == VK_SUCCESS;
+}
+
+static void releaseGpuChunk(VkContext &ctx, const GpuChunk &g) {
+  ctx.mega.releaseVerts(g.vertexOffset, g.vertexCount);
+  ctx.mega.releaseInds(g.indexOffset, g.indexCount);
+  ctx.meshletRanges.release(g.meshletOffset, g.meshletCount);
+}
+
+// For ranges that earlier frames may have drawn from
+static void retireGpuChunk(VkContext &ctx, const GpuChunk &g) {
+  ctx.retiredRanges.push_back({g, ctx.framesSubmitted});
+}
+
+// Right after waiting on inFlight[currentFrame], every frame but the
+// FRAMES_IN_FLIGHT-1 latest has finished
+static uint64_t completedFrames(const VkContext &ctx) {
+  const uint64_t lag = VkContext::FRAMES_IN_FLIGHT - 1;
+  return ctx.framesSubmitted > lag ? ctx.framesSubmitted - lag : 0;
+}
+
+// Call right after waiting on inFlight[currentFrame]
+static void releaseRetired(VkContext &ctx) {
+  uint64_t completed = completedFrames(ctx);
+  while (!ctx.retiredRanges.empty() &&
+         ctx.retiredRanges.front().after <= completed) {
+    releaseGpuChunk(ctx, ctx.retiredRanges.front().gpu);
+    ctx.retiredRanges.pop_front();
+  }
+  while (!ctx.retiredPipelines.empty() &&
+         ctx.retiredPipelines.front().after <= completed) {
+    vkDestroyPipeline(ctx.device.device, ctx.retiredPipelines.front().pipeline,
+                      nullptr);
+    ctx.retiredPipelines.pop_front();
+  }
+}
+
+// ── Chunk slots
+// ─────────────────────────────────────────────────────────────────
+// Slot contents change through vkCmdUpdateBuffer in the next frame's
+// command buffer, ahead of its cull. Frames already submitted keep seeing
+// the old contents, so a freed slot can be handed out again at once.
+
+static uint32_t allocChunkSlot(VkContext &ctx, const ChunkKey &key) {
+  if (!ctx.freeChunkSlots.empty()) {
+    uint32_t slot = ctx.freeChunkSlots.back();
+    ctx.freeChunkSlots.pop_back();
+    return slot;
+  }
+  if (ctx.chunkSlotCount >= VkContext::MAX_CHUNK_SLOTS) {
+    Log::warn("Chunk slot table full, chunk not drawn");
+    ctx.spaceMisses.push_back(key);
+    return UINT32_MAX;
+  }
+  return ctx.chunkSlotCount++;
+}
+
+// World-space corner of a chunk or LOD cell, and its size in blocks
+static glm::ivec4 chunkOrigin(const ChunkKey &key) {
+  const int s = ChunkData::SIZE << key.lod;
+  const ChunkCoord &c = key.coord;
+  return glm::ivec4(c.x * s, c.y * s, c.z * s, s);
+}
 
-  VkBufferImageCopy region{};
-  region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
-  region.imageExtent = {(uint32_t)w, (uint32_t)h, 1};
-  vkCmdCopyBufferToImage(ctx.uploadCmd, stageBuf, ctx.atlasImage,
-                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+// A LOD cell's vertices are in its own cells, 1 << lod blocks each; w
+// carries the level so terrain.vert can scale them
+static void writeChunkSlot(VkContext &ctx, const ChunkKey &key,
+                           const GpuChunk &g) {
+  if (g.slot == UINT32_MAX)
+    return;
+  ChunkSlot cs{};
+  cs.origin = chunkOrigin(key);
+  cs.origin.w = key.lod;
+  glm::vec3 origin((float)cs.origin.x, (float)cs.origin.y, (float)cs.origin.z);
+  float scale = (float)(1 << key.lod);
+  cs.boundsMin = glm::vec4(origin + g.boundsMin * scale, 0.f);
+  cs.boundsMax = glm::vec4(origin + g.boundsMax * scale, 0.f);
+  cs.indexCount = g.indexCount;
+  cs.firstIndex = g.indexOffset;
+  cs.vertexOffset = (int32_t)g.vertexOffset;
+  cs.meshletFirst = g.meshletOffset;
+  cs.meshletCount = g.meshletCount;
+  ctx.chunkSlotWrites.push_back({g.slot, cs});
+}
 
-  barrier(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-          VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-          VK_PIPELINE_STAGE_TRANSFER_BIT,
-          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+static void freeChunkSlot(VkContext &ctx, uint32_t slot) {
+  if (slot == UINT32_MAX)
+    return;
+  ctx.chunkSlotWrites.push_back({slot, ChunkSlot{}});
+  ctx.freeChunkSlots.push_back(slot);
+}
 
-  vkEndCommandBuffer(ctx.uploadCmd);
-  VkSubmitInfo si{};
-  si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-  si.commandBufferCount = 1;
-  si.pCommandBuffers = &ctx.uploadCmd;
-  vkQueueSubmit(ctx.graphicsQueue, 1, &si, ctx.uploadFence);
-  vkWaitForFences(ctx.device.device, 1, &ctx.uploadFence, VK_TRUE, UINT64_MAX);
-  vmaDestroyBuffer(ctx.allocator, stageBuf, stageAlloc);
+// Only the last write to each slot is recorded
+static void recordChunkSlotWrites(VkContext &ctx, VkCommandBuffer cmd) {
+  auto &w = ctx.chunkSlotWrites;
+  std::stable_sort(w.begin(), w.end(), [](const auto &a, const auto &b) {
+    return a.first < b.first;
+  });
+  for (size_t i = 0; i < w.size(); i++) {
+    if (i + 1 < w.size() && w[i + 1].first == w[i].first)
+      continue;
+    vkCmdUpdateBuffer(cmd, ctx.chunkSlotBuffer, w[i].first * sizeof(ChunkSlot),
+                      sizeof(ChunkSlot), &w[i].second);
+  }
+  w.clear();
+
+  // A range is only handed out again once no frame can read it, so these
+  // never overlap and all go
+  for (const auto &[index, m] : ctx.meshletWrites)
+    vkCmdUpdateBuffer(cmd, ctx.meshletBuffer, index * sizeof(GpuMeshlet),
+                      sizeof(GpuMeshlet), &m);
+  ctx.meshletWrites.clear();
+}
 
-  // Image view
-  VkImageViewCreateInfo vCI{};
-  vCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-  vCI.image = ctx.atlasImage;
-  vCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
-  vCI.format = VK_FORMAT_R8G8B8A8_SRGB;
-  vCI.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
-  vkCreateImageView(ctx.device.device, &vCI, nullptr, &ctx.atlasImageView);
+// ── Sun shadows
+// ─────────────────────────────────────────────────────────────────
+
+// Whether a world box falls inside the cascade's square, seen from the sun
+// — depth is left to the pad
+static bool inCascade(const ShadowCascade &sc, glm::vec3 lo, glm::vec3 hi) {
+  glm::vec2 cmin(1e30f), cmax(-1e30f);
+  for (int i = 0; i < 8; i++) {
+    glm::vec3 p(i & 1 ? hi.x : lo.x, i & 2 ? hi.y : lo.y, i & 4 ? hi.z : lo.z);
+    glm::vec2 c(sc.viewProj * glm::vec4(p, 1.f));
+    cmin = glm::min(cmin, c);
+    cmax = glm::max(cmax, c);
+  }
+  return cmin.x <= 1.f && cmax.x >= -1.f && cmin.y <= 1.f && cmax.y >= -1.f;
+}
 
-  // Sampler — nearest for pixel-art crispness, or linear for smooth
-  VkSamplerCreateInfo sCI{};
-  sCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-  sCI.magFilter = VK_FILTER_LINEAR;
-  sCI.minFilter = VK_FILTER_LINEAR;
-  sCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-  sCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  sCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  sCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  vkCreateSampler(ctx.device.device, &sCI, nullptr, &ctx.atlasSampler);
+// A chunk's geometry appeared, changed or went: its whole cell, so the
+// old mesh's bounds don't matter
+static void touchShadows(VkContext &ctx, const ChunkKey &key) {
+  glm::ivec4 o = chunkOrigin(key);
+  glm::vec3 lo((float)o.x, (float)o.y, (float)o.z);
+  for (auto &sc : ctx.shadowCascades)
+    if (!sc.dirty && inCascade(sc, lo, lo + (float)o.w))
+      sc.dirty = true;
+}
 
-  // Write descriptor
-  VkDescriptorImageInfo imgInfo{};
-  imgInfo.sampler = ctx.atlasSampler;
-  imgInfo.imageView = ctx.atlasImageView;
-  imgInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-  VkWriteDescriptorSet write{};
-  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-  write.dstSet = ctx.atlasSet;
-  write.dstBinding = 0;
-  write.descriptorCount = 1;
-  write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-  write.pImageInfo = &imgInfo;
-  vkUpdateDescriptorSets(ctx.device.device, 1, &write, 0, nullptr);
+// ── Mega-buffer compaction
+// ──────────────────────────────────────────────────────
+// Moves whole chunks (both ranges) from the top of whichever buffer is more
+// fragmented into holes lower down, so free space gathers into one block at
+// the end. A move is just a buffer-to-buffer copy recorded ahead of the
+// batch's uploads; like an upload, it only takes effect when the batch
+// retires, and the old ranges go through the retire list. Meshlets are
+// relative to the chunk's ranges, so they stay where they are. Chunks the
+// in-flight batches touch are left alone — their retire would race ours.
+static VkDeviceSize compactMega(VkContext &ctx, UploadBatch &batch) {
+  RangeAllocator::Stats vs = ctx.mega.verts.stats();
+  RangeAllocator::Stats is = ctx.mega.inds.stats();
+  float frag = std::max(vs.fragmentation(), is.fragmentation());
+  if (ctx.compactBudget == 0 || frag < Config::MEGA_COMPACT_FRAGMENTATION)
+    return 0;
+  bool byVerts = vs.fragmentation() >= is.fragmentation();
+
+  std::vector<std::pair<uint32_t, ChunkKey>> order;
+  order.reserve(ctx.chunks.size());
+  for (const auto &[key, g] : ctx.chunks)
+    if (g.vertexCount && g.indexCount)
+      order.push_back({byVerts ? g.vertexOffset : g.indexOffset, key});
+  std::sort(order.begin(), order.end(),
+            [](const auto &a, const auto &b) { return a.first > b.first; });
+
+  // GPU jobs too: an emitting job's ranges are being written on the
+  // graphics queue
+  auto busy = [&](const ChunkKey &k) {
+    for (int i : ctx.uploadsInFlight)
+      for (const auto &bc : ctx.uploadBatches[i].chunks)
+        if (bc.key == k)
+          return true;
+    for (int i : ctx.gpuMeshOrder)
+      if (ctx.gpuMeshJobs[i].key == k)
+        return true;
+    return false;
+  };
+
+  constexpr int MISSES_MAX = 8;
+  int misses = 0;
+  VkDeviceSize moved = 0;
+  for (const auto &[offset, key] : order) {
+    if (moved >= ctx.compactBudget)
+      break;
+    if (busy(key))
+      continue;
+    const GpuChunk &old = ctx.chunks[key];
+
+    GpuChunk g = old;
+    g.meshletCount = 0; // taken over from the resident copy on retire
+    g.vertexOffset = ctx.mega.verts.alloc(g.vertexCount);
+    g.indexOffset = ctx.mega.inds.alloc(g.indexCount);
+    uint32_t primary = byVerts ? g.vertexOffset : g.indexOffset;
+    if (g.vertexOffset == RangeAllocator::NONE ||
+        g.indexOffset == RangeAllocator::NONE || primary >= offset) {
+      // No hole below that fits this one; a smaller chunk further down may
+      // still fit, but don't walk the whole list every frame
+      ctx.mega.verts.release(g.vertexOffset, g.vertexCount);
+      ctx.mega.inds.release(g.indexOffset, g.indexCount);
+      if (++misses >= MISSES_MAX)
+        break;
+      continue;
+    }
 
-  Log::info(std::string("Atlas loaded: ") + path + " (" + std::to_string(w) +
-            "x" + std::to_string(h) + ")");
+    VkBufferCopy vc{old.vertexOffset * sizeof(TerrainVertex),
+                    g.vertexOffset * sizeof(TerrainVertex),
+                    g.vertexCount * sizeof(TerrainVertex)};
+    VkBufferCopy ic{old.indexOffset * sizeof(uint32_t),
+                    g.indexOffset * sizeof(uint32_t),
+                    g.indexCount * sizeof(uint32_t)};
+    vkCmdCopyBuffer(batch.cmd, ctx.mega.vertexBuffer, ctx.mega.vertexBuffer, 1,
+                    &vc);
+    vkCmdCopyBuffer(batch.cmd, ctx.mega.indexBuffer, ctx.mega.indexBuffer, 1,
+                    &ic);
+    batch.chunks.push_back({key, g, false, true});
+    moved += vc.size + ic.size;
+  }
+  return moved;
 }
-// ── Upload
-// ────────────────────────────────────────────────────────────────────
 
-void vk_upload_chunk(VkContext &ctx, const ChunkMesh &mesh) {
-  if (mesh.vertices.empty())
-    return;
-  PendingUpload u;
-  u.coord = mesh.coord;
-  u.vertices = mesh.vertices;
-  u.indices = mesh.indices;
-  ctx.uploadQueue.push_back(std::move(u));
+// Make finished batches' chunks drawable and give back their staging.
+// Batches complete in submission order, so only the oldest is checked.
+static void retireUploads(VkContext &ctx) {
+  while (!ctx.uploadsInFlight.empty()) {
+    UploadBatch &b = ctx.uploadBatches[ctx.uploadsInFlight.front()];
+    if (!batchDone(ctx, b))
+      break;
+
+    int64_t now = Trace::on() ? Trace::nowUs() : 0;
+    for (auto &c : b.chunks) {
+      if (c.dropped) {
+        releaseGpuChunk(ctx, c.gpu);
+        continue;
+      }
+      if (c.stagedUs) {
+        // Submitted to seen done, so it includes the wait for this check
+        Trace::span("client.gpu_copy", c.key, c.stagedUs, now);
+        ctx.traceDrawable.push_back(c.key);
+      }
+      if (!c.moved)
+        touchShadows(ctx, c.key);
+      auto it = ctx.chunks.find(c.key);
+      if (it != ctx.chunks.end()) {
+        GpuChunk old = it->second;
+        if (c.moved) {
+          c.gpu.meshletOffset = old.meshletOffset;
+          c.gpu.meshletCount = old.meshletCount;
+          old.meshletCount = 0;
+        }
+        retireGpuChunk(ctx, old);
+        c.gpu.slot = old.slot;
+        it->second = c.gpu;
+      } else {
+        c.gpu.slot = allocChunkSlot(ctx, c.key);
+        it = ctx.chunks.emplace(c.key, c.gpu).first;
+      }
+      writeChunkSlot(ctx, c.key, it->second);
+    }
+    b.chunks.clear();
+
+    ctx.stagingTail = b.stagingEnd;
+    ctx.stagingUsed -= b.stagingUsed;
+    ctx.uploadVisibleValue = std::max(ctx.uploadVisibleValue, b.value);
+    ctx.uploadsInFlight.pop_front();
+  }
 }
 
 static void flushUploads(VkContext &ctx) {
-  if (ctx.uploadQueue.empty())
+  retireUploads(ctx);
+  if ((ctx.uploadQueue.empty() && ctx.compactBudget == 0) ||
+      ctx.uploadsInFlight.size() >= (size_t)VkContext::UPLOAD_BATCHES)
     return;
 
-  vkWaitForFences(ctx.device.device, 1, &ctx.uploadFence, VK_TRUE, UINT64_MAX);
-  vkResetFences(ctx.device.device, 1, &ctx.uploadFence);
-  vkResetCommandBuffer(ctx.uploadCmd, 0);
+  int slot = 0;
+  while (std::find(ctx.uploadsInFlight.begin(), ctx.uploadsInFlight.end(),
+                   slot) != ctx.uploadsInFlight.end())
+    slot++;
+  UploadBatch &batch = ctx.uploadBatches[slot];
 
+  vkResetCommandBuffer(batch.cmd, 0);
   VkCommandBufferBeginInfo bI{};
   bI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
   bI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-  vkBeginCommandBuffer(ctx.uploadCmd, &bI);
+  vkBeginCommandBuffer(batch.cmd, &bI);
+
+  // Moves first: a fresh upload of the same chunk later in this batch must
+  // retire after the move, or the move would win
+  compactMega(ctx, batch);
+
+  // Nearest first, so the chunks around the player appear before the
+  // horizon when a burst arrives. Stable: two uploads of a chunk stay in
+  // arrival order, or the stale one could retire last and win
+  if (ctx.uploadQueue.size() > 1) {
+    glm::vec3 f = ctx.uploadFocus;
+    auto dist2 = [&](const PendingUpload &u) {
+      float s = (float)(ChunkData::SIZE << u.mesh.lod);
+      glm::vec3 c = (glm::vec3((float)u.mesh.coord.x, (float)u.mesh.coord.y,
+                               (float)u.mesh.coord.z) + 0.5f) * s;
+      glm::vec3 d = c - f;
+      return glm::dot(d, d);
+    };
+    std::stable_sort(ctx.uploadQueue.begin(), ctx.uploadQueue.end(),
+                     [&](const PendingUpload &a, const PendingUpload &b) {
+                       return dist2(a) < dist2(b);
+                     });
+  }
 
   uint8_t *staging = static_cast<uint8_t *>(ctx.stagingMapped);
-  VkDeviceSize cursor = 0;
-
-  for (auto &u : ctx.uploadQueue) {
-    auto existing = ctx.chunks.find(u.coord);
-    if (existing != ctx.chunks.end()) {
-      ctx.mega.releaseVerts(existing->second.vertexOffset,
-                            existing->second.vertexCount);
-      ctx.mega.releaseInds(existing->second.indexOffset,
-                           existing->second.indexCount);
-      ctx.chunks.erase(existing);
-    }
+  VkDeviceSize usedBefore = ctx.stagingUsed;
+  VkDeviceSize staged = 0;
+
+  // Taken off the front in one go after the loop, so the queue keeps its
+  // capacity
+  size_t taken = 0;
+  while (taken < ctx.uploadQueue.size() && staged < ctx.uploadBudget) {
+    PendingUpload &u = ctx.uploadQueue[taken];
+    uint32_t vc = (uint32_t)u.mesh.vertices.size();
+    uint32_t ic = (uint32_t)u.mesh.indices.size();
+    // A mesh that wasn't split up on the way here is one meshlet
+    uint32_t mc =
+        ic ? std::max<uint32_t>((uint32_t)u.mesh.meshlets.size(), 1) : 0;
+    VkDeviceSize vSize = vc * sizeof(TerrainVertex);
+    VkDeviceSize iSize = ic * sizeof(uint32_t);
+    VkDeviceSize mOff = (vSize + iSize + 15) & ~VkDeviceSize(15);
+    VkDeviceSize mSize = mc * sizeof(GpuMeshlet);
 
-    uint32_t vc = (uint32_t)u.vertices.size();
-    uint32_t ic = (uint32_t)u.indices.size();
+    if (mOff + mSize > ctx.stagingSize) {
+      Log::warn("Chunk mesh larger than the staging buffer, skipped");
+      ctx.spentMeshes.push_back(std::move(u.mesh));
+      taken++;
+      continue;
+    }
 
     GpuChunk gpu{};
     gpu.vertexCount = vc;
     gpu.indexCount = ic;
-
+    gpu.meshletCount = mc;
     gpu.vertexOffset = ctx.mega.allocVerts(vc);
     gpu.indexOffset = ctx.mega.allocInds(ic);
-    if (gpu.vertexOffset == UINT32_MAX || gpu.indexOffset == UINT32_MAX) {
+    gpu.meshletOffset = ctx.meshletRanges.alloc(mc);
+    if (gpu.vertexOffset == UINT32_MAX || gpu.indexOffset == UINT32_MAX ||
+        gpu.meshletOffset == RangeAllocator::NONE) {
       if (gpu.vertexOffset != UINT32_MAX)
         ctx.mega.releaseVerts(gpu.vertexOffset, vc);
       if (gpu.indexOffset != UINT32_MAX)
         ctx.mega.releaseInds(gpu.indexOffset, ic);
+      if (gpu.meshletOffset != RangeAllocator::NONE)
+        ctx.meshletRanges.release(gpu.meshletOffset, mc);
+      else
+        Log::warn("Meshlet buffer full, chunk not drawn");
+      ctx.spaceMisses.push_back({u.mesh.coord, u.mesh.lod});
+      ctx.spentMeshes.push_back(std::move(u.mesh));
+      taken++;
       continue;
     }
-    VkDeviceSize vSize = vc * sizeof(Vertex);
-    VkDeviceSize iSize = ic * sizeof(uint32_t);
 
-    memcpy(staging + cursor, u.vertices.data(), vSize);
-    memcpy(staging + cursor + vSize, u.indices.data(), iSize);
+    VkDeviceSize off;
+    if (!stagingAlloc(ctx, mOff + mSize, off)) {
+      // Ring full — the rest waits for a batch to retire
+      releaseGpuChunk(ctx, gpu);
+      break;
+    }
+
+    // Packed and bounded on the decode worker already
+    gpu.boundsMin = u.mesh.boundsMin;
+    gpu.boundsMax = u.mesh.boundsMax;
+    memcpy(staging + off, u.mesh.vertices.data(), vSize);
+    memcpy(staging + off + vSize, u.mesh.indices.data(), iSize);
+
+    // Meshlets go with the chunk's frame and units; their bounds get the
+    // same packing slack as the chunk's
+    auto *ml = reinterpret_cast<GpuMeshlet *>(staging + off + mOff);
+    if (mc && u.mesh.meshlets.empty())
+      ml[0] = GpuMeshlet{glm::vec4(gpu.boundsMin, 2.f),
+                         glm::vec4(gpu.boundsMax, 0.f), glm::vec4(0.f), 0, ic,
+                         {}};
+    for (size_t i = 0; i < u.mesh.meshlets.size(); i++) {
+      const Meshlet &m = u.mesh.meshlets[i];
+      glm::vec3 mn = m.boundsMin - TerrainVertex::POS_ERROR;
+      glm::vec3 mx = m.boundsMax + TerrainVertex::POS_ERROR;
+      ml[i] = GpuMeshlet{glm::vec4(mn, m.coneCutoff), glm::vec4(mx, 0.f),
+                         glm::vec4(m.coneAxis, 0.f), m.firstIndex,
+                         m.indexCount, {}};
+    }
 
-    VkBufferCopy vc2{cursor, gpu.vertexOffset * sizeof(Vertex), vSize};
-    VkBufferCopy ic2{cursor + vSize, gpu.indexOffset * sizeof(uint32_t), iSize};
-    vkCmdCopyBuffer(ctx.uploadCmd, ctx.stagingBuffer, ctx.mega.vertexBuffer, 1,
+    VkBufferCopy vc2{off, gpu.vertexOffset * sizeof(TerrainVertex), vSize};
+    VkBufferCopy ic2{off + vSize, gpu.indexOffset * sizeof(uint32_t), iSize};
+    VkBufferCopy mc2{off + mOff, gpu.meshletOffset * sizeof(GpuMeshlet),
+                     mSize};
+    vkCmdCopyBuffer(batch.cmd, ctx.stagingBuffer, ctx.mega.vertexBuffer, 1,
                     &vc2);
-    vkCmdCopyBuffer(ctx.uploadCmd, ctx.stagingBuffer, ctx.mega.indexBuffer, 1,
+    vkCmdCopyBuffer(batch.cmd, ctx.stagingBuffer, ctx.mega.indexBuffer, 1,
                     &ic2);
+    if (mSize)
+      vkCmdCopyBuffer(batch.cmd, ctx.stagingBuffer, ctx.meshletBuffer, 1,
+                      &mc2);
+
+    staged += mOff + mSize;
+    ChunkKey key{u.mesh.coord, u.mesh.lod};
+    int64_t stagedUs = 0;
+    if (u.queuedUs) {
+      // Time behind the per-frame upload budget and the staging ring
+      stagedUs = Trace::nowUs();
+      Trace::span("client.upload_wait", key, u.queuedUs, stagedUs);
+    }
+    batch.chunks.push_back({key, gpu, false, false, stagedUs});
+    ctx.spentMeshes.push_back(std::move(u.mesh));
+    taken++;
+  }
+  ctx.uploadQueue.erase(ctx.uploadQueue.begin(), ctx.uploadQueue.begin() + taken);
 
-    cursor += vSize + iSize;
-    ctx.chunks[u.coord] = gpu;
-
-    if (cursor + 4 * 1024 * 1024 > ctx.stagingSize)
-      break;
+  if (batch.chunks.empty()) {
+    vkEndCommandBuffer(batch.cmd);
+    return;
+  }
+  ctx.bytesUploaded += staged;
+
+  if (!ctx.uploadTimeline) {
+    // Same queue as the draws: a barrier is enough to order them
+    VkMemoryBarrier mb{};
+    mb.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    mb.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                       VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(batch.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 1, &mb, 0, nullptr, 0, nullptr);
   }
-  ctx.uploadQueue.clear();
+  vkEndCommandBuffer(batch.cmd);
 
-  vkEndCommandBuffer(ctx.uploadCmd);
+  batch.stagingEnd = ctx.stagingHead;
+  batch.stagingUsed = ctx.stagingUsed - usedBefore;
 
   VkSubmitInfo sI{};
   sI.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
   sI.commandBufferCount = 1;
-  sI.pCommandBuffers = &ctx.uploadCmd;
-  vkQueueSubmit(ctx.graphicsQueue, 1, &sI, ctx.uploadFence);
-  // Fence is checked at start of next flushUploads — no stall here
+  sI.pCommandBuffers = &batch.cmd;
+
+  VkTimelineSemaphoreSubmitInfo tI{};
+  if (ctx.uploadTimeline) {
+    batch.value = ++ctx.uploadTimelineNext;
+    tI.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    tI.signalSemaphoreValueCount = 1;
+    tI.pSignalSemaphoreValues = &batch.value;
+    sI.pNext = &tI;
+    sI.signalSemaphoreCount = 1;
+    sI.pSignalSemaphores = &ctx.uploadTimeline;
+    vkQueueSubmit(ctx.transferQueue, 1, &sI, VK_NULL_HANDLE);
+  } else {
+    vkResetFences(ctx.device.device, 1, &batch.fence);
+    vkQueueSubmit(ctx.transferQueue, 1, &sI, batch.fence);
+  }
+  ctx.uploadsInFlight.push_back(slot);
+}
+
+void vk_set_upload_focus(VkContext &ctx, glm::vec3 pos) {
+  ctx.uploadFocus = pos;
+}
+
+void vk_set_sun(VkContext &ctx, glm::vec3 dir) {
+  ctx.sunDir = dir;
+}
+
+void vk_set_compact_budget(VkContext &ctx, size_t bytes) {
+  ctx.compactBudget = bytes;
+}
+
+void vk_emit_particles(VkContext &ctx, const ParticleEmitter &e) {
+  if (ctx.particleQueue.size() < VkContext::PARTICLE_MAX_EMITTERS &&
+      e.count > 0)
+    ctx.particleQueue.push_back(e);
 }
 
-void vk_remove_chunk(VkContext &ctx, ChunkCoord coord) {
-  auto it = ctx.chunks.find(coord);
+void vk_add_light(VkContext &ctx, const PointLight &light) {
+  if (ctx.lightQueue.size() < VkContext::LIGHT_MAX && light.radius > 0.f &&
+      light.intensity > 0.f)
+    ctx.lightQueue.push_back(light);
+}
+
+size_t vk_pending_uploads(const VkContext &ctx) {
+  return ctx.uploadQueue.size();
+}
+
+GpuMemoryStats vk_memory_stats(const VkContext &ctx) {
+  GpuMemoryStats s;
+  s.verts = ctx.mega.verts.stats();
+  s.inds = ctx.mega.inds.stats();
+  s.meshlets = ctx.meshletRanges.stats();
+  s.slotsUsed = ctx.chunkSlotCount - (uint32_t)ctx.freeChunkSlots.size();
+  s.slotsMax = VkContext::MAX_CHUNK_SLOTS;
+  s.stagingUsed = ctx.stagingUsed;
+  s.stagingSize = ctx.stagingSize;
+  return s;
+}
+
+void vk_take_space_misses(VkContext &ctx, std::vector<ChunkKey> &out) {
+  out.insert(out.end(), ctx.spaceMisses.begin(), ctx.spaceMisses.end());
+  ctx.spaceMisses.clear();
+}
+
+// Not uploaded yet, or still copying: make sure it never appears
+static void dropPendingUploads(VkContext &ctx, const ChunkKey &key) {
+  for (auto it = ctx.uploadQueue.begin(); it != ctx.uploadQueue.end();) {
+    if (ChunkKey{it->mesh.coord, it->mesh.lod} == key) {
+      ctx.spentMeshes.push_back(std::move(it->mesh));
+      it = ctx.uploadQueue.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (int i : ctx.uploadsInFlight)
+    for (auto &c : ctx.uploadBatches[i].chunks)
+      if (c.key == key)
+        c.dropped = true;
+}
+
+void vk_remove_chunk(VkContext &ctx, const ChunkKey &key) {
+  dropPendingUploads(ctx, key);
+  dropGpuMeshJobs(ctx, key);
+
+  auto it = ctx.chunks.find(key);
   if (it == ctx.chunks.end())
     return;
-  vkDeviceWaitIdle(ctx.device.device);
-  ctx.mega.releaseVerts(it->second.vertexOffset, it->second.vertexCount);
-  ctx.mega.releaseInds(it->second.indexOffset, it->second.indexCount);
+  touchShadows(ctx, key);
+  retireGpuChunk(ctx, it->second);
+  freeChunkSlot(ctx, it->second.slot);
   ctx.chunks.erase(it);
 }
 
-// ── Draw
-// ──────────────────────────────────────────────────────────────────────
+void vk_evict_chunks(VkContext &ctx,
+                     const std::function<bool(const ChunkKey &)> &keep,
+                     std::vector<ChunkKey> &evicted) {
+  size_t first = evicted.size();
+  for (auto it = ctx.uploadQueue.begin(); it != ctx.uploadQueue.end();) {
+    ChunkKey key{it->mesh.coord, it->mesh.lod};
+    if (!keep(key)) {
+      evicted.push_back(key);
+      ctx.spentMeshes.push_back(std::move(it->mesh));
+      it = ctx.uploadQueue.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (int i : ctx.uploadsInFlight)
+    for (auto &c : ctx.uploadBatches[i].chunks)
+      if (!c.dropped && !keep(c.key)) {
+        c.dropped = true;
+        evicted.push_back(c.key);
+      }
+  for (int i : ctx.gpuMeshOrder) {
+    GpuMeshJob &j = ctx.gpuMeshJobs[i];
+    if (!j.dropped && !keep(j.key)) {
+      j.dropped = true;
+      evicted.push_back(j.key);
+    }
+  }
+  for (auto it = ctx.chunks.begin(); it != ctx.chunks.end();) {
+    if (!keep(it->first)) {
+      evicted.push_back(it->first);
+      touchShadows(ctx, it->first);
+      retireGpuChunk(ctx, it->second);
+      freeChunkSlot(ctx, it->second.slot);
+      it = ctx.chunks.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  ctx.visibility.retain(
+      [&](const ChunkCoord &c) { return keep(ChunkKey{c, 0}); });
+
+  // A re-sent chunk can be resident and queued at once
+  std::sort(evicted.begin() + first, evicted.end(),
+            [](const ChunkKey &a, const ChunkKey &b) {
+              return std::tie(a.lod, a.coord.x, a.coord.y, a.coord.z) <
+                     std::tie(b.lod, b.coord.x, b.coord.y, b.coord.z);
+            });
+  evicted.erase(std::unique(evicted.begin() + first, evicted.end()),
+                evicted.end());
+}
 
-// ── Draw
-// ──────────────────────────────────────────────────────────────────────
+// ── GPU meshing
+// ─────────────────────────────────────────────────────────────────
+// A field waits as Queued until the next frame records classify and scan
+// for it, plus a copy of the header (triangle count, cell bounds) back to
+// the host. When that frame has finished, the count sizes the chunk's mega
+// ranges, and the frame being recorded emits into them and draws the chunk;
+// the emitted vertices are copied back for the collider. Each stage waits
+// on completed frames, not a fence, so nothing here ever blocks.
+
+int vk_gpu_mesh_free(const VkContext &ctx) {
+  if (!ctx.gpuMesh || !ctx.pipelinesReady)
+    return 0;
+  return VkContext::GPU_MESH_JOBS - (int)ctx.gpuMeshOrder.size();
+}
 
-void vk_draw(VkContext &ctx, const glm::mat4 &viewProj, float sunIntensity,
-             glm::vec3 skyColor, const ViewModelRenderer *viewModel,
-             const glm::mat4 &proj, const RemotePlayerRenderer *remotePlayers) {
-  // just before the drawCount loop:
+void vk_gpu_mesh_chunk(VkContext &ctx, const ChunkData &field,
+                       uint16_t faceLinks) {
+  int slot = 0;
+  while (slot < VkContext::GPU_MESH_JOBS &&
+         ctx.gpuMeshJobs[slot].stage != GpuMeshJob::Stage::Free)
+    slot++;
+  if (slot == VkContext::GPU_MESH_JOBS)
+    return;
 
-  flushUploads(ctx);
+  ChunkKey key{field.coord, 0};
+  dropPendingUploads(ctx, key);
+  dropGpuMeshJobs(ctx, key);
+  ctx.visibility.set(field.coord, faceLinks);
+
+  GpuMeshJob &j = ctx.gpuMeshJobs[slot];
+  memcpy(j.fieldMapped, field.voxels, sizeof(field.voxels));
+  vmaFlushAllocation(ctx.allocator, j.fieldAlloc, 0, VK_WHOLE_SIZE);
+  j.stage = GpuMeshJob::Stage::Queued;
+  j.key = key;
+  j.dropped = false;
+  j.gpu = GpuChunk{};
+  ctx.gpuMeshOrder.push_back(slot);
+}
 
-  uint32_t frame = ctx.currentFrame;
-  vkWaitForFences(ctx.device.device, 1, &ctx.inFlight[frame], VK_TRUE,
-                  UINT64_MAX);
-  vkResetFences(ctx.device.device, 1, &ctx.inFlight[frame]);
+void vk_take_gpu_meshed(VkContext &ctx, std::vector<ChunkUpload> &out) {
+  for (auto &m : ctx.gpuMeshed)
+    out.push_back(std::move(m));
+  ctx.gpuMeshed.clear();
+}
 
-  uint32_t imageIndex;
-  vkAcquireNextImageKHR(ctx.device.device, ctx.swapchain.swapchain, UINT64_MAX,
-                        ctx.imageAvailable[frame], VK_NULL_HANDLE, &imageIndex);
+// Emitted vertices as they were drawn, one index each, for the collider
+static void takeGpuMesh(VkContext &ctx, GpuMeshJob &j) {
+  if (!j.dropped) {
+    vmaInvalidateAllocation(ctx.allocator, j.readbackAlloc, 0, VK_WHOLE_SIZE);
+    const auto *tv = static_cast<const TerrainVertex *>(j.readbackMapped);
+    ChunkUpload mesh;
+    mesh.coord = j.key.coord;
+    mesh.vertices.assign(tv, tv + j.gpu.vertexCount);
+    mesh.indices.resize(j.gpu.vertexCount);
+    for (uint32_t i = 0; i < j.gpu.vertexCount; i++)
+      mesh.indices[i] = i;
+    ctx.gpuMeshed.push_back(std::move(mesh));
+  }
+  vmaDestroyBuffer(ctx.allocator, j.readbackBuffer, j.readbackAlloc);
+  j.readbackBuffer = VK_NULL_HANDLE;
+  j.readbackAlloc = nullptr;
+  j.readbackMapped = nullptr;
+}
 
-  // ── Frustum planes ────────────────────────────────────────────────────────
-  struct Plane {
-    glm::vec3 n;
-    float d;
-  };
-  Plane planes[6];
-  const glm::mat4 &m = viewProj;
-  planes[0] = {{m[0][3] + m[0][0], m[1][3] + m[1][0], m[2][3] + m[2][0]},
-               m[3][3] + m[3][0]};
-  planes[1] = {{m[0][3] - m[0][0], m[1][3] - m[1][0], m[2][3] - m[2][0]},
-               m[3][3] - m[3][0]};
-  planes[2] = {{m[0][3] + m[0][1], m[1][3] + m[1][1], m[2][3] + m[2][1]},
-               m[3][3] + m[3][1]};
-  planes[3] = {{m[0][3] - m[0][1], m[1][3] - m[1][1], m[2][3] - m[2][1]},
-               m[3][3] - m[3][1]};
-  planes[4] = {{m[0][3] + m[0][2], m[1][3] + m[1][2], m[2][3] + m[2][2]},
-               m[3][3] + m[3][2]};
-  planes[5] = {{m[0][3] - m[0][2], m[1][3] - m[1][2], m[2][3] - m[2][2]},
-               m[3][3] - m[3][2]};
-
-  auto chunkVisible = [&](ChunkCoord coord) -> bool {
-    float s = (float)ChunkData::SIZE;
-    glm::vec3 mn((float)coord.x * s, (float)coord.y * s, (float)coord.z * s);
-    glm::vec3 mx = mn + s;
-    for (auto &p : planes) {
-      glm::vec3 pv{p.n.x > 0 ? mx.x : mn.x, p.n.y > 0 ? mx.y : mn.y,
-                   p.n.z > 0 ? mx.z : mn.z};
-      if (glm::dot(p.n, pv) + p.d < 0.f)
-        return false;
+// Reads a counted job's header and gives it mega ranges and a chunk entry.
+// False when the job has nothing left to do.
+static bool startEmit(VkContext &ctx, GpuMeshJob &j) {
+  if (j.dropped)
+    return false;
+  vmaInvalidateAllocation(ctx.allocator, j.headerAlloc, 0, VK_WHOLE_SIZE);
+  const auto *h = static_cast<const uint32_t *>(j.headerMapped);
+  uint32_t count = h[0] * 3;
+  if (count == 0) {
+    // No surface left: take down what was there, and tell the collider
+    auto it = ctx.chunks.find(j.key);
+    if (it != ctx.chunks.end()) {
+      touchShadows(ctx, j.key);
+      retireGpuChunk(ctx, it->second);
+      freeChunkSlot(ctx, it->second.slot);
+      ctx.chunks.erase(it);
     }
-    return true;
+    ChunkUpload empty;
+    empty.coord = j.key.coord;
+    ctx.gpuMeshed.push_back(std::move(empty));
+    return false;
+  }
+
+  GpuChunk g{};
+  g.vertexCount = g.indexCount = count;
+  g.meshletCount = 1;
+  g.vertexOffset = ctx.mega.allocVerts(count);
+  g.indexOffset = ctx.mega.allocInds(count);
+  g.meshletOffset = ctx.meshletRanges.alloc(1);
+  if (g.vertexOffset == UINT32_MAX || g.indexOffset == UINT32_MAX ||
+      g.meshletOffset == RangeAllocator::NONE) {
+    if (g.vertexOffset != UINT32_MAX)
+      ctx.mega.releaseVerts(g.vertexOffset, count);
+    if (g.indexOffset != UINT32_MAX)
+      ctx.mega.releaseInds(g.indexOffset, count);
+    if (g.meshletOffset != RangeAllocator::NONE)
+      ctx.meshletRanges.release(g.meshletOffset, 1);
+    ctx.spaceMisses.push_back(j.key);
+    return false;
+  }
+  // Cell bounds: vertices sit on the corners of the cells that made them
+  g.boundsMin = glm::vec3((float)h[1], (float)h[2], (float)h[3]) -
+                TerrainVertex::POS_ERROR;
+  g.boundsMax = glm::vec3((float)h[4], (float)h[5], (float)h[6]) + 1.f +
+                TerrainVertex::POS_ERROR;
+  // march.comp's triangles come in cell order, not bricks: one meshlet,
+  // the whole chunk, no cone
+  ctx.meshletWrites.push_back(
+      {g.meshletOffset,
+       GpuMeshlet{glm::vec4(g.boundsMin, 2.f), glm::vec4(g.boundsMax, 0.f),
+                  glm::vec4(0.f), 0, count, {}}});
+
+  makeMarchBuffer(ctx, count * sizeof(TerrainVertex),
+                  VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU,
+                  j.readbackBuffer, j.readbackAlloc, &j.readbackMapped);
+
+  touchShadows(ctx, j.key);
+  auto it = ctx.chunks.find(j.key);
+  if (it != ctx.chunks.end()) {
+    retireGpuChunk(ctx, it->second);
+    g.slot = it->second.slot;
+    it->second = g;
+  } else {
+    g.slot = allocChunkSlot(ctx, j.key);
+    it = ctx.chunks.emplace(j.key, g).first;
+  }
+  writeChunkSlot(ctx, j.key, it->second);
+  if (Trace::on())
+    ctx.traceDrawable.push_back(j.key);
+  j.gpu = g;
+  return true;
+}
+
+// Ahead of the cull, so chunks emitted here are drawn this frame
+static void recordGpuMeshing(VkContext &ctx, VkCommandBuffer cmd) {
+  const uint64_t done = completedFrames(ctx);
+  const uint64_t thisFrame = ctx.framesSubmitted + 1;
+  std::vector<GpuMeshJob *> counting, emitting;
+  for (auto it = ctx.gpuMeshOrder.begin(); it != ctx.gpuMeshOrder.end();) {
+    GpuMeshJob &j = ctx.gpuMeshJobs[*it];
+    bool finished = false;
+    if (j.stage == GpuMeshJob::Stage::Emitting && j.frame <= done) {
+      takeGpuMesh(ctx, j);
+      finished = true;
+    } else if (j.stage == GpuMeshJob::Stage::Counting && j.frame <= done) {
+      finished = !startEmit(ctx, j);
+      if (!finished)
+        emitting.push_back(&j);
+    } else if (j.stage == GpuMeshJob::Stage::Queued) {
+      counting.push_back(&j);
+    }
+    if (finished) {
+      j.stage = GpuMeshJob::Stage::Free;
+      it = ctx.gpuMeshOrder.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (counting.empty() && emitting.empty())
+    return;
+
+  auto barrier = [&](VkPipelineStageFlags srcStage, VkAccessFlags src,
+                     VkPipelineStageFlags dstStage, VkAccessFlags dst) {
+    VkMemoryBarrier mb{};
+    mb.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    mb.srcAccessMask = src;
+    mb.dstAccessMask = dst;
+    vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 1, &mb, 0, nullptr, 0,
+                         nullptr);
   };
+  auto bind = [&](VkPipeline p, const GpuMeshJob &j) {
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, p);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            ctx.marchPipelineLayout, 0, 1, &j.set, 0, nullptr);
+  };
+  const uint32_t groups = MARCH_CELLS / 64;
+
+  ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuMarch);
+  // Header: no triangles, empty bounds
+  const uint32_t header[7] = {0, ~0u, ~0u, ~0u, 0, 0, 0};
+  for (GpuMeshJob *j : counting)
+    vkCmdUpdateBuffer(cmd, j->cellBuffer, MARCH_CELLS * sizeof(uint32_t),
+                      MARCH_HEADER_BYTES, header);
+  // Also orders the previous frame's scan before this frame's emit
+  barrier(VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+          VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+  for (GpuMeshJob *j : counting) {
+    bind(ctx.marchClassify, *j);
+    vkCmdDispatch(cmd, groups, 1, 1);
+  }
+  for (GpuMeshJob *j : emitting) {
+    MarchPC pc{j->gpu.vertexOffset, j->gpu.indexOffset,
+               Config::SMOOTH_TERRAIN_NORMALS ? 1u : 0u};
+    bind(ctx.marchEmit, *j);
+    vkCmdPushConstants(cmd, ctx.marchPipelineLayout,
+                       VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+    vkCmdDispatch(cmd, groups, 1, 1);
+  }
+  if (!counting.empty()) {
+    barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    for (GpuMeshJob *j : counting) {
+      bind(ctx.marchScan, *j);
+      vkCmdDispatch(cmd, 1, 1, 1);
+    }
+  }
+  barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+          VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+          VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+              VK_ACCESS_TRANSFER_READ_BIT);
+
+  for (GpuMeshJob *j : counting) {
+    VkBufferCopy c{MARCH_CELLS * sizeof(uint32_t), 0, MARCH_HEADER_BYTES};
+    vkCmdCopyBuffer(cmd, j->cellBuffer, j->headerBuffer, 1, &c);
+    j->stage = GpuMeshJob::Stage::Counting;
+    j->frame = thisFrame;
+  }
+  for (GpuMeshJob *j : emitting) {
+    VkBufferCopy c{j->gpu.vertexOffset * sizeof(TerrainVertex), 0,
+                   j->gpu.vertexCount * sizeof(TerrainVertex)};
+    vkCmdCopyBuffer(cmd, ctx.mega.vertexBuffer, j->readbackBuffer, 1, &c);
+    j->stage = GpuMeshJob::Stage::Emitting;
+    j->frame = thisFrame;
+  }
+  barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+          VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+  ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuMarch);
+}
 
-  // ── Build indirect draw list ──────────────────────────────────────────────
-  auto *drawCmds = static_cast<DrawCmd *>(ctx.indirectMapped[frame]);
-  auto *chunkDatas = static_cast<ChunkDrawData *>(ctx.perChunkMapped[frame]);
+// ── Draw
+// ──────────────────────────────────────────────────────────────────────
 
-  uint32_t drawCount = 0;
-  for (auto &[coord, gpu] : ctx.chunks) {
-    if (!chunkVisible(coord))
-      continue;
-    if (drawCount >= VkContext::MAX_DRAW_CHUNKS)
-      break;
+// ── Draw
+// ──────────────────────────────────────────────────────────────────────
 
-    float s = (float)ChunkData::SIZE;
-    glm::vec3 offset((float)coord.x * s, (float)coord.y * s,
-                     (float)coord.z * s);
-    chunkDatas[drawCount].model = glm::translate(glm::mat4(1.f), offset);
-    chunkDatas[drawCount].params = glm::vec4(sunIntensity, 0.f, 0.f, 0.f);
+// Reduce this frame's depth into the pyramid, one dispatch per level
+static void buildHiz(VkContext &ctx, VkCommandBuffer cmd) {
+  auto levelBarrier = [&](uint32_t base, uint32_t count, VkAccessFlags src,
+                          VkAccessFlags dst) {
+    VkImageMemoryBarrier b{};
+    b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    b.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    b.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    b.srcAccessMask = src;
+    b.dstAccessMask = dst;
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.image = ctx.hizImage;
+    b.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, base, count, 0, 1};
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &b);
+  };
 
-    drawCmds[drawCount].indexCount = gpu.indexCount;
-    drawCmds[drawCount].instanceCount = 1;
-    drawCmds[drawCount].firstIndex = gpu.indexOffset;
-    drawCmds[drawCount].vertexOffset = (int32_t)gpu.vertexOffset;
-    drawCmds[drawCount].firstInstance = drawCount;
-    drawCount++;
+  // Between levels only: the graph orders the pass after this frame's
+  // cull, which read the old pyramid
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, ctx.hizPipeline);
+  uint32_t w = ctx.hizExtent.width, h = ctx.hizExtent.height;
+  for (uint32_t l = 0; l < ctx.hizLevels; l++) {
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            ctx.hizPipelineLayout, 0, 1, &ctx.hizSets[l], 0,
+                            nullptr);
+    vkCmdDispatch(cmd, (w + 7) / 8, (h + 7) / 8, 1);
+    levelBarrier(l, 1, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+    w = std::max(1u, w / 2);
+    h = std::max(1u, h / 2);
   }
+}
 
-  vmaFlushAllocation(ctx.allocator, ctx.perChunkAlloc[frame], 0, VK_WHOLE_SIZE);
-  vmaFlushAllocation(ctx.allocator, ctx.indirectAlloc[frame], 0, VK_WHOLE_SIZE);
-
-  // ── Record ────────────────────────────────────────────────────────────────
-  VkCommandBuffer cmd = ctx.commandBuffers[frame];
-  vkResetCommandBuffer(cmd, 0);
-  VkCommandBufferBeginInfo bI{};
-  bI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-  vkBeginCommandBuffer(cmd, &bI);
+// What the shadow passes draw this frame
+struct ShadowPlan {
+  int redraw = -1;      // cascade whose static layer is redrawn
+  uint32_t casters = 0; // remote players, for the dynamic layers
+  bool dynamic = false; // clear (and draw) every dynamic layer
+};
+
+// Moves each cascade's target with the eye and the sun, then picks the
+// static layer of at most one dirty cascade to redraw — the one that has
+// waited longest, once it has waited its minimum — and clears and redraws
+// every dynamic layer while there are casters. Writes this frame's
+// ShadowParams.
+static ShadowPlan planShadows(VkContext &ctx, uint32_t frame, glm::vec3 eyePos,
+                              RemotePlayerRenderer *remotePlayers) {
+  const float cosSun =
+      std::cos(glm::radians((float)Config::SHADOW_SUN_DEGREES));
+  // At night the sun is under the ground: keep the last day's shadows
+  const bool sunUp = ctx.sunDir.y > 0.f;
+  ShadowPlan plan;
+  for (int c = 0; c < VkContext::SHADOW_CASCADES; c++) {
+    ShadowCascade &sc = ctx.shadowCascades[c];
+    float extent = Config::SHADOW_NEAR_EXTENT * (float)(1 << (2 * c));
+    float snap = extent / 4.f;
+    glm::vec3 center = glm::floor(eyePos / snap + 0.5f) * snap;
+    if (center != sc.center ||
+        (sunUp && glm::dot(ctx.sunDir, sc.sun) < cosSun))
+      sc.dirty = true;
+    // Finer cascades show a stale map sooner, and cost less to redraw
+    uint64_t wait = 4ull << (2 * c);
+    if (sc.dirty && ctx.framesSubmitted >= sc.lastFrame + wait &&
+        (plan.redraw < 0 ||
+         sc.lastFrame < ctx.shadowCascades[plan.redraw].lastFrame))
+      plan.redraw = c;
+  }
 
-  VkClearValue clears[2]{};
-  clears[0].color = {{skyColor.r, skyColor.g, skyColor.b, 1.f}};
-  clears[1].depthStencil = {1.f, 0};
+  if (plan.redraw >= 0) {
+    ShadowCascade &sc = ctx.shadowCascades[plan.redraw];
+    float extent = Config::SHADOW_NEAR_EXTENT * (float)(1 << (2 * plan.redraw));
+    float snap = extent / 4.f;
+    sc.center = glm::floor(eyePos / snap + 0.5f) * snap;
+    if (sunUp)
+      sc.sun = ctx.sunDir;
+    float depth = extent + Config::SHADOW_DEPTH_PAD;
+    glm::vec3 up = std::fabs(sc.sun.y) > 0.99f ? glm::vec3(0.f, 0.f, 1.f)
+                                               : glm::vec3(0.f, 1.f, 0.f);
+    sc.viewProj =
+        glm::ortho(-extent, extent, -extent, extent, 0.f, 2.f * depth) *
+        glm::lookAt(sc.center + sc.sun * depth, sc.center, up);
+    sc.dirty = false;
+    sc.lastFrame = ctx.framesSubmitted;
+  }
 
-  VkRenderPassBeginInfo rpBI{};
-  rpBI.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-  rpBI.renderPass = ctx.renderPass;
-  rpBI.framebuffer = ctx.framebuffers[imageIndex];
-  rpBI.renderArea.extent = ctx.swapchain.extent;
-  rpBI.clearValueCount = 2;
-  rpBI.pClearValues = clears;
+  plan.casters = remotePlayers ? remotePlayers->writeShadowInstances(frame) : 0;
+  plan.dynamic = plan.casters > 0 || ctx.dynamicShadows;
+  if (plan.dynamic)
+    ctx.dynamicShadows = plan.casters > 0;
 
-  vkCmdBeginRenderPass(cmd, &rpBI, VK_SUBPASS_CONTENTS_INLINE);
+  auto &sp = *static_cast<ShadowParams *>(ctx.shadowParamMapped[frame]);
+  for (int c = 0; c < VkContext::SHADOW_CASCADES; c++) {
+    sp.viewProj[c] = ctx.shadowCascades[c].viewProj;
+    sp.texel[c] = 2.f * Config::SHADOW_NEAR_EXTENT * (float)(1 << (2 * c)) /
+                  (float)Config::SHADOW_MAP_SIZE;
+  }
+  sp.sun = glm::vec4(ctx.sunDir, 0.f);
+  vmaFlushAllocation(ctx.allocator, ctx.shadowParamAlloc[frame], 0,
+                     VK_WHOLE_SIZE);
+  return plan;
+}
 
-  // ── Terrain ───────────────────────────────────────────────────────────────
-  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, ctx.pipeline);
+// Terrain into cascade c's static layer, inside its pass: the chunks in
+// slots [first, last) of the resident table, so it can be split across
+// records. Whole chunks: the cull's draws are for the camera.
+static void recordStaticShadow(const VkContext &ctx, VkCommandBuffer cmd, int c,
+                               size_t first, size_t last) {
+  const ShadowCascade &sc = ctx.shadowCascades[c];
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, ctx.shadowPipeline);
   VkDeviceSize zero = 0;
   vkCmdBindVertexBuffers(cmd, 0, 1, &ctx.mega.vertexBuffer, &zero);
   vkCmdBindIndexBuffer(cmd, ctx.mega.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+  VkDescriptorSet table = ctx.bindless->set(ctx.currentFrame);
   vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          ctx.pipelineLayout, 0, 1, &ctx.dsSets[frame], 0,
-                          nullptr);
-  vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          ctx.pipelineLayout, 1, 1, &ctx.atlasSet, 0, nullptr);
-
+                          ctx.pipelineLayout, 0, 1, &table, 0, nullptr);
   struct GlobalPC {
     glm::mat4 viewProj;
     glm::vec4 params;
   };
-  GlobalPC gpc{viewProj, {sunIntensity, 0.f, 0.f, 0.f}};
+  GlobalPC gpc{sc.viewProj, glm::vec4(0.f)};
   vkCmdPushConstants(cmd, ctx.pipelineLayout,
                      VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
                      0, sizeof(GlobalPC), &gpc);
+  for (auto it = ctx.chunks.fromSlot(first), end = ctx.chunks.fromSlot(last);
+       it != end; ++it) {
+    const auto &[key, g] = *it;
+    if (g.slot == UINT32_MAX || g.indexCount == 0)
+      continue;
+    glm::ivec4 o = chunkOrigin(key);
+    glm::vec3 origin((float)o.x, (float)o.y, (float)o.z);
+    float scale = (float)(1 << key.lod);
+    if (inCascade(sc, origin + g.boundsMin * scale,
+                  origin + g.boundsMax * scale))
+      vkCmdDrawIndexed(cmd, g.indexCount, 1, g.indexOffset,
+                       (int32_t)g.vertexOffset, g.slot);
+  }
+}
 
-  if (drawCount > 0)
-    vkCmdDrawIndexedIndirect(cmd, ctx.indirectBuffer[frame], 0, drawCount,
-                             sizeof(DrawCmd));
+// ── Frame pacing
+// ──────────────────────────────────────────────────────────────
 
-  // ── View model (drawn after terrain, depth test disabled so always on top) ─
-  if (viewModel)
-    viewModel->draw(cmd, proj);
+void vk_wait_frame(VkContext &ctx) {
+  uint32_t frame = ctx.currentFrame;
+  vkWaitForFences(ctx.device.device, 1, &ctx.inFlight[frame], VK_TRUE,
+                  UINT64_MAX);
+  if (!ctx.lowLatency)
+    return;
+  uint32_t prev = (frame + VkContext::FRAMES_IN_FLIGHT - 1) %
+                  VkContext::FRAMES_IN_FLIGHT;
+  vkWaitForFences(ctx.device.device, 1, &ctx.inFlight[prev], VK_TRUE,
+                  UINT64_MAX);
+  // One frame may still wait for its vblank; a present the compositor
+  // sits on gives up after a few frames' time rather than stall input
+  if (ctx.waitForPresent && ctx.presentId > 1)
+    ctx.waitForPresent(ctx.device.device, ctx.swapchain.swapchain,
+                       ctx.presentId - 1, 50'000'000);
+}
+
+void vk_set_present_mode(VkContext &ctx, VkPresentModeKHR mode) {
+  if (mode == ctx.presentWanted || ctx.offscreen)
+    return;
+  ctx.presentWanted = mode;
+  vkDeviceWaitIdle(ctx.device.device);
+  destroyFramebuffers(ctx);
+  VkExtent2D extent = ctx.swapchain.extent;
+  buildSwapchain(ctx, extent, mode);
+  // Everything else is sized for the old extent; the surface only offers
+  // another while the window is being resized, which isn't handled
+  if (ctx.swapchain.extent.width != extent.width ||
+      ctx.swapchain.extent.height != extent.height)
+    Log::warn("Swapchain extent changed on rebuild");
+  createFramebuffers(ctx);
+  // Present ids are per swapchain
+  ctx.presentId = 0;
+  const char *name = ctx.presentMode == VK_PRESENT_MODE_MAILBOX_KHR ? "mailbox"
+                     : ctx.presentMode == VK_PRESENT_MODE_IMMEDIATE_KHR
+                         ? "immediate"
+                         : "FIFO";
+  Log::info(std::string("Present mode: ") + name);
+}
+
+void vk_draw(VkContext &ctx, const glm::mat4 &viewProj, float sunIntensity,
+             glm::vec3 skyColor, const ViewModelRenderer *viewModel,
+             const glm::mat4 &proj, RemotePlayerRenderer *remotePlayers,
+             const FarTerrain *far, const glm::mat4 &farViewProj) {
+  {
+    auto t = ctx.profiler.cpu(FrameProfiler::CpuFlushUploads);
+    flushUploads(ctx);
+  }
+
+  uint32_t frame = ctx.currentFrame;
+  vkWaitForFences(ctx.device.device, 1, &ctx.inFlight[frame], VK_TRUE,
+                  UINT64_MAX);
+  vkResetFences(ctx.device.device, 1, &ctx.inFlight[frame]);
+  releaseRetired(ctx);
+  ctx.bindless->update(frame);
+  TickArena &arena = ctx.frameArena.begin(frame);
+
+  uint32_t imageIndex = frame; // offscreen: the slot's own image
+  if (!ctx.offscreen)
+    vkAcquireNextImageKHR(ctx.device.device, ctx.swapchain.swapchain,
+                          UINT64_MAX, ctx.imageAvailable[frame],
+                          VK_NULL_HANDLE, &imageIndex);
+
+  // ── Frame setup ───────────────────────────────────────────────────────────
+  // Dynamic resolution is steered by the whole frame's GPU time,
+  // FRAMES_IN_FLIGHT frames old
+  const bool upscale =
+      ctx.dynamicResolution && ctx.canUpscale && ctx.pipelinesReady;
+  float gpuMs;
+  if (!upscale)
+    ctx.resolution.reset();
+  else if (ctx.profiler.latestGpu(FrameProfiler::GpuFrame, gpuMs))
+    ctx.resolution.update(gpuMs,
+                          Config::FRAME_TARGET_MS * Config::DYNRES_BUDGET);
+  const VkExtent2D full = ctx.swapchain.extent;
+  const VkExtent2D ext = upscale ? ctx.resolution.extent(full) : full;
+
+  // The eye is where clip (0, 0, 1, 0) comes from (w is 0 for a view with
+  // no perspective — the menu's, which has no scene to draw); the farthest
+  // band ends at the view radius
+  glm::vec4 eye = glm::inverse(viewProj) * glm::vec4(0.f, 0.f, 1.f, 0.f);
+  const bool haveEye = std::fabs(eye.w) > 1e-6f;
+  const glm::vec3 eyePos = haveEye ? glm::vec3(eye) / eye.w : glm::vec3(0.f);
+  const bool scene = ctx.pipelinesReady && haveEye;
+
+  // A draw per meshlet, so nothing past the meshlet high-water mark can
+  // survive the cull
+  uint32_t maxDraws = 0;
+  {
+    uint32_t offset, size;
+    if (ctx.meshletRanges.last(offset, size))
+      maxDraws = std::min(offset + size, VkContext::MAX_DRAWS);
+  }
+
+  ShadowPlan shadows;
+  if (scene)
+    shadows = planShadows(ctx, frame, eyePos,
+                          viewModel ? remotePlayers : nullptr);
+
+  // Dynamic state isn't inherited: every secondary sets its own
+  auto setViewport = [](VkCommandBuffer cmd, VkExtent2D e) {
+    VkViewport viewport{0.f, 0.f, (float)e.width, (float)e.height, 0.f, 1.f};
+    VkRect2D scissor{{0, 0}, e};
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+  };
+
+  // ── Graph ─────────────────────────────────────────────────────────────────
+  // What each pass touches; the graph drops what nothing presented reads
+  // (on the menu: the cull, the Hi-Z and the chunk table writes, which
+  // wait) and puts the barriers between the rest
+  using RG = RenderGraph;
+  RenderGraph &rg = ctx.graph;
+  rg.reset(frame, arena);
+  // The blit writes the swapchain image too
+  const VkPipelineStageFlags swapWait =
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+      (upscale ? VK_PIPELINE_STAGE_TRANSFER_BIT : 0);
+  const RG::Resource mega = rg.memory("mega buffers");
+  const RG::Resource draws = rg.memory("draws");
+  // As the previous frame left them: the pyramid built; the chunk table
+  // (the frames in flight share it), the maps, depth and scene colour
+  // still being read
+  const RG::Resource hiz = rg.image(
+      "hi-z", ctx.hizImage, VK_IMAGE_ASPECT_COLOR_BIT,
+      {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+       VK_IMAGE_LAYOUT_GENERAL});
+  const RG::Resource slots = rg.memory(
+      "chunk tables", {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                           VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                       0, VK_IMAGE_LAYOUT_UNDEFINED});
+  const RG::Resource shadowMaps =
+      rg.memory("shadow maps", {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                                 VK_IMAGE_LAYOUT_UNDEFINED});
+  const RG::Resource depth =
+      rg.memory("depth", {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                          VK_IMAGE_LAYOUT_UNDEFINED});
+  const RG::Resource sceneColor =
+      rg.memory("scene colour", {VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                                 VK_IMAGE_LAYOUT_UNDEFINED});
+  const RG::Resource swap =
+      rg.image("swapchain", ctx.swapImages[imageIndex],
+               VK_IMAGE_ASPECT_COLOR_BIT,
+               {swapWait, 0, VK_IMAGE_LAYOUT_UNDEFINED});
+
+  const RG::Use meshRead{mega, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                         VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                             VK_ACCESS_INDEX_READ_BIT};
+  const RG::Use depthWrite{depth,
+                           VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                               VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                           VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT};
+
+  // ── GPU meshing ───────────────────────────────────────────────────────────
+  // A root: what it reads back is for later frames
+  if (ctx.gpuMesh && ctx.pipelinesReady) {
+    RG::Pass &p = rg.add("gpu mesh");
+    p.root = true;
+    p.write({mega,
+             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                 VK_PIPELINE_STAGE_TRANSFER_BIT,
+             VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT});
+    p.record([&](VkCommandBuffer cmd) { recordGpuMeshing(ctx, cmd); });
+  }
+
+  rg.add("chunk tables")
+      .write({slots, VK_PIPELINE_STAGE_TRANSFER_BIT,
+              VK_ACCESS_TRANSFER_WRITE_BIT})
+      .record([&](VkCommandBuffer cmd) { recordChunkSlotWrites(ctx, cmd); });
+
+  // ── Cull ──────────────────────────────────────────────────────────────────
+  // Frustum planes from this frame's view; occlusion against the pyramid
+  // the previous frame left, in that frame's view. List the chunks that
+  // pass, count their meshlets that pass per distance band, then write
+  // those out band by band. The meshlet passes run a workgroup per listed
+  // chunk, sized on the GPU.
+  {
+    RG::Pass &p = rg.add("cull");
+    p.parallel = true;
+    p.read({slots, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT});
+    p.read({hiz, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL});
+    p.write({draws,
+             VK_PIPELINE_STAGE_TRANSFER_BIT |
+                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+             VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT});
+    p.record([&](VkCommandBuffer cmd) {
+      auto &cp = *static_cast<CullParams *>(ctx.cullParamMapped[frame]);
+      const glm::mat4 &m = viewProj;
+      auto row = [&](int i) {
+        return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+      };
+      // Kept here too: the visibility walk reads them, and the mapped copy
+      // is write-combined
+      glm::vec4 planes[6] = {row(3) + row(0), row(3) - row(0),
+                             row(3) + row(1), row(3) - row(1),
+                             row(3) + row(2), row(3) - row(2)};
+      std::copy(std::begin(planes), std::end(planes), cp.planes);
+      cp.hizViewProj = ctx.hizViewProj;
+      cp.hiz =
+          glm::vec4((float)ctx.hizExtent.width, (float)ctx.hizExtent.height,
+                    (float)ctx.hizLevels, ctx.hizValid ? 1.f : 0.f);
+      cp.counts = glm::uvec4(ctx.chunkSlotCount, VkContext::MAX_DRAWS, 0, 0);
+      float maxDist = (float)(Config::VIEW_RADIUS_MAX + 1) * ChunkData::SIZE;
+      cp.eye = glm::vec4(eyePos,
+                         (float)VkContext::CULL_BANDS / std::sqrt(maxDist));
+      cp.hizRect = glm::vec4(ctx.hizRect, 0.f, 0.f);
+      vmaFlushAllocation(ctx.allocator, ctx.cullParamAlloc[frame], 0,
+                         VK_WHOLE_SIZE);
+
+      // Chunks the face-link walk can't reach from the camera's chunk
+      auto *bits = static_cast<uint32_t *>(ctx.visibleMapped[frame]);
+      memset(bits, 0xFF, (ctx.chunkSlotCount + 31) / 32 * sizeof(uint32_t));
+      if (haveEye) {
+        ctx.visibility.update(eyePos, planes);
+        for (const auto &[key, g] : ctx.chunks)
+          if (key.lod == 0 && g.slot != UINT32_MAX &&
+              !ctx.visibility.visible(key.coord))
+            bits[g.slot / 32] &= ~(1u << (g.slot % 32));
+      }
+      vmaFlushAllocation(ctx.allocator, ctx.visibleAlloc[frame], 0,
+                         VK_WHOLE_SIZE);
+
+      // Zero counts and an empty dispatch: (0, 1, 1) workgroups
+      vkCmdFillBuffer(cmd, ctx.drawCountBuffer[frame], 0,
+                      VkContext::CULL_COUNT_HEADER, 0);
+      vkCmdFillBuffer(cmd, ctx.drawCountBuffer[frame],
+                      VkContext::CULL_DISPATCH_OFFSET + sizeof(uint32_t),
+                      2 * sizeof(uint32_t), 1);
+      if (!ctx.cmdDrawIndexedIndirectCount && maxDraws > 0)
+        vkCmdFillBuffer(cmd, ctx.indirectBuffer[frame], 0,
+                        maxDraws * sizeof(DrawCmd), 0);
+      if (!ctx.pipelinesReady || ctx.chunkSlotCount == 0)
+        return;
+
+      ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuCull);
+      auto barrier = [&](VkPipelineStageFlags src, VkAccessFlags srcAccess) {
+        VkMemoryBarrier mb{};
+        mb.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        mb.srcAccessMask = srcAccess;
+        mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+                           VK_ACCESS_SHADER_WRITE_BIT |
+                           VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        vkCmdPipelineBarrier(cmd, src,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                                 VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                             0, 1, &mb, 0, nullptr, 0, nullptr);
+      };
+      barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+      vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                              ctx.cullPipelineLayout, 0, 1,
+                              &ctx.cullSets[frame], 0, nullptr);
+      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                        ctx.cullChunksPipeline);
+      vkCmdDispatch(cmd, (ctx.chunkSlotCount + 63) / 64, 1, 1);
+      barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                        ctx.cullMeshletsPipeline);
+      vkCmdDispatchIndirect(cmd, ctx.drawCountBuffer[frame],
+                            VkContext::CULL_DISPATCH_OFFSET);
+      barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                        ctx.cullEmitPipeline);
+      vkCmdDispatchIndirect(cmd, ctx.drawCountBuffer[frame],
+                            VkContext::CULL_DISPATCH_OFFSET);
+      ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuCull);
+    });
+  }
+
+  // ── Foliage ───────────────────────────────────────────────────────────────
+  // Over the chunks the cull just listed, so a workgroup each through the
+  // same indirect dispatch; each type's draw starts at its own run of this
+  // frame's instances, with no instances yet
+  const RG::Resource foliage = rg.memory("foliage");
+  const bool plants = scene && ctx.foliage;
+  if (plants) {
+    RG::Pass &p = rg.add("foliage");
+    p.parallel = true;
+    p.read({slots, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT});
+    p.read({draws,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT});
+    p.read({mega, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT});
+    p.write({foliage,
+             VK_PIPELINE_STAGE_TRANSFER_BIT |
+                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+             VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT});
+    p.record([&](VkCommandBuffer cmd) {
+      ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuFoliage);
+      const uint32_t base = frame * VkContext::FOLIAGE_TYPES *
+                            VkContext::FOLIAGE_MAX_INSTANCES;
+      VkDrawIndirectCommand cmds[VkContext::FOLIAGE_TYPES];
+      for (uint32_t t = 0; t < VkContext::FOLIAGE_TYPES; t++)
+        cmds[t] = {VkContext::FOLIAGE_VERTS[t], 0, 0,
+                   base + t * VkContext::FOLIAGE_MAX_INSTANCES};
+      vkCmdUpdateBuffer(cmd, ctx.foliageDrawBuffer[frame], 0, sizeof(cmds),
+                        cmds);
+      VkMemoryBarrier mb{};
+      mb.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+      vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &mb, 0,
+                           nullptr, 0, nullptr);
+
+      // The view's sides, as the cull takes them
+      const glm::mat4 &m = viewProj;
+      auto row = [&](int i) {
+        return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+      };
+      struct FoliagePC {
+        glm::vec4 planes[4];
+        glm::vec4 eye;     // w: reach
+        glm::vec4 density; // per type
+        glm::uvec4 base;
+      };
+      FoliagePC pc{{row(3) + row(0), row(3) - row(0), row(3) + row(1),
+                    row(3) - row(1)},
+                   glm::vec4(eyePos, Config::FOLIAGE_REACH),
+                   glm::vec4(Config::FOLIAGE_GRASS_DENSITY,
+                             Config::FOLIAGE_ROCK_DENSITY, 0.f, 0.f),
+                   glm::uvec4(base, 0, 0, 0)};
+      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                        ctx.foliageScatterPipeline);
+      vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                              ctx.foliageScatterLayout, 0, 1,
+                              &ctx.foliageSets[frame], 0, nullptr);
+      vkCmdPushConstants(cmd, ctx.foliageScatterLayout,
+                         VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+      vkCmdDispatchIndirect(cmd, ctx.drawCountBuffer[frame],
+                            VkContext::CULL_DISPATCH_OFFSET);
+      ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuFoliage);
+    });
+  }
+
+  // ── Particles ─────────────────────────────────────────────────────────────
+  // The live pool aged into the other, this frame's bursts appended, then
+  // the new pool's dispatch and draw; the old pool's dispatch was left by
+  // the previous run. Going in: that run's compute writes, and the draw of
+  // the run before still reading the pool this one refills.
+  const RG::Resource particles = rg.memory(
+      "particles",
+      {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+           VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+           VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+       VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED});
+  const uint32_t oldPool = ctx.particleLive, newPool = oldPool ^ 1;
+  if (scene) {
+    auto now = std::chrono::steady_clock::now();
+    float dt = ctx.particleStepped == decltype(now){}
+                   ? 0.f
+                   : std::chrono::duration<float>(now - ctx.particleStepped)
+                         .count();
+    ctx.particleStepped = now;
+    dt = std::min(dt, 0.1f); // a hitch doesn't fling them through walls
+    const uint32_t emitters = (uint32_t)ctx.particleQueue.size();
+    if (emitters > 0) {
+      memcpy(ctx.particleEmitterMapped[frame], ctx.particleQueue.data(),
+             emitters * sizeof(ParticleEmitter));
+      vmaFlushAllocation(ctx.allocator, ctx.particleEmitterAlloc[frame], 0,
+                         VK_WHOLE_SIZE);
+    }
+    const bool prime = !ctx.particlePrimed;
+    ctx.particlePrimed = true;
+    ctx.particleLive = newPool;
+
+    RG::Pass &p = rg.add("particles");
+    p.write({particles,
+             VK_PIPELINE_STAGE_TRANSFER_BIT |
+                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                 VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+             VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT |
+                 VK_ACCESS_SHADER_WRITE_BIT |
+                 VK_ACCESS_INDIRECT_COMMAND_READ_BIT});
+    p.record([&ctx, frame, prime, dt, emitters, oldPool,
+              newPool](VkCommandBuffer cmd) {
+      ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuParticles);
+      // Nothing alive yet: both counts and dispatches zero
+      if (prime)
+        vkCmdFillBuffer(cmd, ctx.particleStateBuffer, 0, VK_WHOLE_SIZE, 0);
+      vkCmdFillBuffer(cmd, ctx.particleStateBuffer,
+                      newPool * VkContext::PARTICLE_STATE_BYTES,
+                      sizeof(uint32_t), 0);
+      auto barrier = [&](VkPipelineStageFlags src, VkAccessFlags srcAccess) {
+        VkMemoryBarrier mb{};
+        mb.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        mb.srcAccessMask = srcAccess;
+        mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+                           VK_ACCESS_SHADER_WRITE_BIT |
+                           VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        vkCmdPipelineBarrier(cmd, src,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                                 VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                             0, 1, &mb, 0, nullptr, 0, nullptr);
+      };
+      barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+      struct ParticlePC {
+        glm::uvec4 pools; // old, new, emitters, seed
+        glm::vec4 step;   // dt, gravity
+      };
+      ParticlePC pc{{oldPool, newPool, emitters,
+                     (uint32_t)ctx.framesSubmitted * 0x9E3779B9u},
+                    {dt, Config::GRAVITY, 0.f, 0.f}};
+      vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                              ctx.particleSimLayout, 0, 1,
+                              &ctx.particleSets[frame], 0, nullptr);
+      vkCmdPushConstants(cmd, ctx.particleSimLayout,
+                         VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+      // Survivors and bursts append side by side
+      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                        ctx.particleSimulatePipeline);
+      vkCmdDispatchIndirect(cmd, ctx.particleStateBuffer,
+                            oldPool * VkContext::PARTICLE_STATE_BYTES +
+                                VkContext::PARTICLE_DISPATCH_OFFSET);
+      if (emitters > 0) {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          ctx.particleEmitPipeline);
+        vkCmdDispatch(cmd, emitters, 1, 1);
+      }
+      barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                        ctx.particleArgsPipeline);
+      vkCmdDispatch(cmd, 1, 1, 1);
+      ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuParticles);
+    });
+  }
+  ctx.particleQueue.clear();
+
+  // ── Lights ────────────────────────────────────────────────────────────────
+  // The frame's lights and the view they're binned in are copied into the
+  // grid, then light_cull.comp lists each cluster's. Every frame, so the
+  // header the shading reads is always this frame's, lightless without a
+  // scene. Going in: the frame before's shading still reading it.
+  const RG::Resource lights = rg.memory(
+      "lights", {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                 VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED});
+  {
+    struct LightGrid {
+      glm::uvec4 grid;   // tiles across, down, slices, lights
+      glm::vec4 screen;  // tiles per pixel; slice from log depth
+      glm::vec4 eye;
+      glm::vec4 forward;
+      glm::vec4 proj;    // [0][0], [1][1], near, far
+      glm::mat4 view;
+    };
+    static_assert(sizeof(LightGrid) == VkContext::LIGHT_HEADER_BYTES,
+                  "light_cull.comp's LightGrid");
+    const uint32_t count = scene ? (uint32_t)ctx.lightQueue.size() : 0;
+    const glm::mat4 view = glm::inverse(proj) * viewProj;
+    const float span = std::log(VkContext::LIGHT_FAR / VkContext::LIGHT_NEAR);
+    const float slices = (float)VkContext::LIGHT_SLICES;
+    LightGrid header{
+        {VkContext::LIGHT_TILES_X, VkContext::LIGHT_TILES_Y,
+         VkContext::LIGHT_SLICES, count},
+        {VkContext::LIGHT_TILES_X / (float)ext.width,
+         VkContext::LIGHT_TILES_Y / (float)ext.height, slices / span,
+         -slices * std::log(VkContext::LIGHT_NEAR) / span},
+        glm::vec4(eyePos, 1.f),
+        glm::vec4(-view[0][2], -view[1][2], -view[2][2], 0.f),
+        {proj[0][0], proj[1][1], VkContext::LIGHT_NEAR, VkContext::LIGHT_FAR},
+        view};
+    auto *mapped = static_cast<uint8_t *>(ctx.lightInputMapped[frame]);
+    memcpy(mapped, &header, sizeof(header));
+    if (count > 0)
+      memcpy(mapped + sizeof(header), ctx.lightQueue.data(),
+             count * sizeof(PointLight));
+    const VkDeviceSize bytes = sizeof(header) + count * sizeof(PointLight);
+    vmaFlushAllocation(ctx.allocator, ctx.lightInputAlloc[frame], 0, bytes);
+
+    RG::Pass &p = rg.add("lights");
+    p.write({lights,
+             VK_PIPELINE_STAGE_TRANSFER_BIT |
+                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+             VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT |
+                 VK_ACCESS_SHADER_WRITE_BIT});
+    p.record([&ctx, frame, count, bytes](VkCommandBuffer cmd) {
+      ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuLights);
+      VkBufferCopy copy{0, 0, bytes};
+      vkCmdCopyBuffer(cmd, ctx.lightInputBuffer[frame], ctx.lightGridBuffer, 1,
+                      &copy);
+      if (count > 0) {
+        VkMemoryBarrier mb{};
+        mb.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &mb, 0,
+                             nullptr, 0, nullptr);
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          ctx.lightCullPipeline);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                ctx.lightCullLayout, 0, 1, &ctx.lightSet, 0,
+                                nullptr);
+        vkCmdDispatch(cmd, VkContext::LIGHT_TILES_X, VkContext::LIGHT_TILES_Y,
+                      VkContext::LIGHT_SLICES);
+      }
+      ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuLights);
+    });
+  }
+  ctx.lightQueue.clear();
+
+  // ── Shadows ───────────────────────────────────────────────────────────────
+  // A render pass per layer drawn, under one profiler zone. The static
+  // layer walks every resident chunk, so it's split across the recording
+  // threads once there are enough chunks to go round.
+  {
+    constexpr size_t CHUNKS_PER_RECORD = 512;
+    using Records = ArenaVector<RG::Record>;
+    ArenaVector<std::pair<VkFramebuffer, Records>> layers{
+        ArenaAllocator<std::pair<VkFramebuffer, Records>>(&arena)};
+    if (shadows.redraw >= 0) {
+      size_t slots = ctx.chunks.slotCount();
+      size_t split = std::clamp<size_t>(ctx.chunks.size() / CHUNKS_PER_RECORD,
+                                        1, rg.threads());
+      Records draws{ArenaAllocator<RG::Record>(&arena)};
+      for (size_t i = 0; i < split; i++)
+        draws.push_back([&ctx, c = shadows.redraw, first = slots * i / split,
+                         last = slots * (i + 1) / split](VkCommandBuffer cmd) {
+          recordStaticShadow(ctx, cmd, c, first, last);
+        });
+      layers.push_back({ctx.shadowFramebuffers[0][shadows.redraw],
+                        std::move(draws)});
+    }
+    if (shadows.dynamic)
+      for (int c = 0; c < VkContext::SHADOW_CASCADES; c++)
+        layers.push_back(
+            {ctx.shadowFramebuffers[1][c],
+             Records({[&ctx, &shadows, remotePlayers, frame, c](VkCommandBuffer cmd) {
+                       if (shadows.casters > 0)
+                         remotePlayers->drawShadow(cmd, ctx.shadowCascades[c].viewProj,
+                                                   frame, shadows.casters);
+                     }},
+                     ArenaAllocator<RG::Record>(&arena))});
+
+    for (size_t l = 0; l < layers.size(); l++) {
+      RG::Pass &p = rg.add("shadows");
+      p.parallel = true;
+      p.read({slots, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+              VK_ACCESS_SHADER_READ_BIT});
+      p.read(meshRead);
+      p.write({shadowMaps, depthWrite.stage, depthWrite.access});
+      p.begin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+      p.begin.renderPass = ctx.shadowRenderPass;
+      p.begin.framebuffer = layers[l].first;
+      uint32_t size = (uint32_t)(shadows.redraw >= 0 && l == 0
+                                     ? Config::SHADOW_MAP_SIZE
+                                     : Config::SHADOW_DYNAMIC_SIZE);
+      p.begin.renderArea.extent = {size, size};
+      VkClearValue clear{};
+      clear.depthStencil = {1.f, 0};
+      p.clears = {clear};
+      auto &draws = layers[l].second;
+      for (size_t r = 0; r < draws.size(); r++) {
+        bool first = l == 0 && r == 0;
+        bool last = l + 1 == layers.size() && r + 1 == draws.size();
+        p.record([&ctx, first, last,
+                  draw = std::move(draws[r])](VkCommandBuffer cmd) {
+          if (first)
+            ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuShadows);
+          draw(cmd);
+          if (last)
+            ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuShadows);
+        });
+      }
+    }
+  }
+
+  // ── Scene ─────────────────────────────────────────────────────────────────
+  // At the render resolution; without upscaling straight into the
+  // swapchain image, with the overlay on top in the same pass
+  RG::Pass &scenePass = rg.add("scene");
+  scenePass.parallel = true;
+  scenePass.root = !upscale;
+  scenePass.begin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+  scenePass.begin.renderPass = upscale ? ctx.sceneRenderPass : ctx.renderPass;
+  scenePass.begin.framebuffer =
+      upscale ? ctx.sceneFramebuffer : ctx.framebuffers[imageIndex];
+  scenePass.begin.renderArea.extent = ext;
+  scenePass.clears.resize(2);
+  scenePass.clears[0].color = {{skyColor.r, skyColor.g, skyColor.b, 1.f}};
+  scenePass.clears[1].depthStencil = {1.f, 0};
+  scenePass.write(depthWrite);
+  scenePass.read({lights, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                  VK_ACCESS_SHADER_READ_BIT});
+  if (upscale)
+    scenePass.write({sceneColor, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT});
+  else
+    scenePass.write({swap, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR});
+
+  // ── Far terrain ───────────────────────────────────────────────────────────
+  // In its own depth range, then depth goes back to clear for the chunks.
+  // Each level discards what finer geometry covers, and every chunk is
+  // nearer the eye than the far field behind it, so the chunks can simply
+  // draw over it.
+  if (scene && far && ctx.atlasImageView)
+    scenePass.record([&](VkCommandBuffer cmd) {
+      ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuFarTerrain);
+      setViewport(cmd, ext);
+      auto *mapped =
+          static_cast<FarTerrain::Vertex *>(ctx.farVertexMapped[frame]);
+      for (int l = 0; l < FarTerrain::LEVELS; l++) {
+        const FarTerrain::Level &lv = far->level(l);
+        if (lv.version == ctx.farVersions[frame][l])
+          continue;
+        VkDeviceSize offset =
+            l * FarTerrain::VERTS * sizeof(FarTerrain::Vertex);
+        memcpy(mapped + l * FarTerrain::VERTS, lv.verts.data(),
+               FarTerrain::VERTS * sizeof(FarTerrain::Vertex));
+        vmaFlushAllocation(ctx.allocator, ctx.farVertexAlloc[frame], offset,
+                           FarTerrain::VERTS * sizeof(FarTerrain::Vertex));
+        ctx.farVersions[frame][l] = lv.version;
+      }
+
+      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, ctx.farPipeline);
+      VkDeviceSize zero = 0;
+      vkCmdBindVertexBuffers(cmd, 0, 1, &ctx.farVertexBuffer[frame], &zero);
+      vkCmdBindIndexBuffer(cmd, ctx.farIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
+      VkDescriptorSet table = ctx.bindless->set(frame);
+      vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              ctx.farPipelineLayout, 0, 1, &table, 0, nullptr);
+      struct FarPC {
+        glm::mat4 viewProj;
+        glm::vec4 hole; // xz box to discard
+        glm::vec4 eye;  // w: sun intensity
+        glm::vec4 fog;  // sky colour, w: where it's all fog
+        glm::vec4 sun;  // towards the sun
+      };
+      FarPC fpc{farViewProj, {}, glm::vec4(eyePos, sunIntensity),
+                glm::vec4(skyColor, FarTerrain::reach()),
+                glm::vec4(ctx.sunDir, 0.f)};
+      bool drawn = false;
+      for (int l = 0; l < FarTerrain::LEVELS; l++) {
+        if (!far->visible(l) || ctx.farVersions[frame][l] == 0)
+          continue;
+        fpc.hole = far->hole(l);
+        vkCmdPushConstants(cmd, ctx.farPipelineLayout,
+                           VK_SHADER_STAGE_VERTEX_BIT |
+                               VK_SHADER_STAGE_FRAGMENT_BIT,
+                           0, sizeof(FarPC), &fpc);
+        vkCmdDrawIndexed(cmd, FarTerrain::INDICES, 1, 0,
+                         l * FarTerrain::VERTS, 0);
+        drawn = true;
+      }
+      if (drawn) {
+        VkClearAttachment ca{};
+        ca.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        ca.clearValue.depthStencil = {1.f, 0};
+        VkClearRect cr{};
+        cr.rect.extent = ext;
+        cr.layerCount = 1;
+        vkCmdClearAttachments(cmd, 1, &ca, 1, &cr);
+      }
+      ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuFarTerrain);
+    });
+
+  // ── Terrain ───────────────────────────────────────────────────────────────
+  // Nothing to draw it with until the pipelines are built
+  if (scene) {
+    scenePass.read({draws,
+               VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                   VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+               VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+                   VK_ACCESS_SHADER_READ_BIT});
+    scenePass.read(
+        {slots, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT});
+    scenePass.read(meshRead);
+    scenePass.read({shadowMaps, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+               VK_ACCESS_SHADER_READ_BIT});
+    scenePass.record([&](VkCommandBuffer cmd) {
+      ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuTerrain);
+      setViewport(cmd, ext);
+      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, ctx.pipeline);
+      VkDeviceSize zero = 0;
+      vkCmdBindVertexBuffers(cmd, 0, 1, &ctx.mega.vertexBuffer, &zero);
+      vkCmdBindIndexBuffer(cmd, ctx.mega.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+      VkDescriptorSet sets[] = {ctx.bindless->set(frame),
+                                ctx.shadowSets[frame]};
+      vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              ctx.pipelineLayout, 0, 2, sets, 0, nullptr);
+
+      struct GlobalPC {
+        glm::mat4 viewProj;
+        glm::vec4 params; // x: sun intensity
+        glm::vec4 eye;
+        glm::vec4 fog; // sky colour, w: where it's all fog, as far terrain's
+      };
+      GlobalPC gpc{viewProj, {sunIntensity, 0.f, 0.f, 0.f},
+                   glm::vec4(eyePos, 0.f),
+                   glm::vec4(skyColor, FarTerrain::reach())};
+      vkCmdPushConstants(cmd, ctx.pipelineLayout,
+                         VK_SHADER_STAGE_VERTEX_BIT |
+                             VK_SHADER_STAGE_FRAGMENT_BIT,
+                         0, sizeof(GlobalPC), &gpc);
+
+      auto drawTerrain = [&] {
+        if (maxDraws == 0)
+          return;
+        if (ctx.cmdDrawIndexedIndirectCount)
+          ctx.cmdDrawIndexedIndirectCount(
+              cmd, ctx.indirectBuffer[frame], 0, ctx.drawCountBuffer[frame], 0,
+              maxDraws, sizeof(DrawCmd));
+        else
+          vkCmdDrawIndexedIndirect(cmd, ctx.indirectBuffer[frame], 0,
+                                   maxDraws, sizeof(DrawCmd));
+      };
+      if (ctx.depthPrepass) {
+        ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuDepthPrepass);
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          ctx.depthPrepassPipeline);
+        drawTerrain();
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, ctx.pipeline);
+        ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuDepthPrepass);
+      }
+      drawTerrain();
+      ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuTerrain);
+    });
+  }
+
+  // After the terrain, which hides most of what's behind a hill; one draw
+  // per type
+  if (plants) {
+    scenePass.read({foliage,
+                    VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                    VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+                        VK_ACCESS_SHADER_READ_BIT});
+    scenePass.record([&](VkCommandBuffer cmd) {
+      setViewport(cmd, ext);
+      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                        ctx.foliagePipeline);
+      VkDescriptorSet table = ctx.bindless->set(frame);
+      vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              ctx.foliagePipelineLayout, 0, 1, &table, 0,
+                              nullptr);
+      struct FoliageDrawPC {
+        glm::mat4 viewProj;
+        glm::vec4 eye; // w: sun intensity
+        glm::vec4 fog; // sky colour, w: where it's all fog
+        glm::vec4 sun;
+        glm::uvec4 type;
+      };
+      FoliageDrawPC pc{viewProj, glm::vec4(eyePos, sunIntensity),
+                       glm::vec4(skyColor, FarTerrain::reach()),
+                       glm::vec4(ctx.sunDir, 0.f), glm::uvec4(0)};
+      for (uint32_t t = 0; t < VkContext::FOLIAGE_TYPES; t++) {
+        pc.type.x = t;
+        vkCmdPushConstants(cmd, ctx.foliagePipelineLayout,
+                           VK_SHADER_STAGE_VERTEX_BIT |
+                               VK_SHADER_STAGE_FRAGMENT_BIT,
+                           0, sizeof(pc), &pc);
+        vkCmdDrawIndirect(cmd, ctx.foliageDrawBuffer[frame],
+                          t * sizeof(VkDrawIndirectCommand), 1,
+                          sizeof(VkDrawIndirectCommand));
+      }
+    });
+  }
+
+  // Before the view model, whose pipeline has a fixed viewport
   if (remotePlayers && viewModel)
-  remotePlayers->draw(cmd, viewProj);
-  // ── ImGui ─────────────────────────────────────────────────────────────────
-  ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmd);
-  vkCmdEndRenderPass(cmd);
+    scenePass.record([&](VkCommandBuffer cmd) {
+      ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuRemotePlayers);
+      setViewport(cmd, ext);
+      remotePlayers->draw(cmd, viewProj, frame);
+      ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuRemotePlayers);
+    });
+
+  // Last of the scene, over everything solid; depth-tested, not written
+  if (scene) {
+    scenePass.read({particles,
+                    VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                    VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+                        VK_ACCESS_SHADER_READ_BIT});
+    scenePass.record([&](VkCommandBuffer cmd) {
+      setViewport(cmd, ext);
+      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                        ctx.particlePipeline);
+      VkDescriptorSet table = ctx.bindless->set(frame);
+      vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              ctx.particlePipelineLayout, 0, 1, &table, 0,
+                              nullptr);
+      struct ParticleDrawPC {
+        glm::mat4 viewProj;
+        glm::vec4 eye; // w: sun intensity
+        glm::vec4 fog; // sky colour, w: where it's all fog
+        glm::uvec4 base;
+      };
+      ParticleDrawPC pc{viewProj, glm::vec4(eyePos, sunIntensity),
+                        glm::vec4(skyColor, FarTerrain::reach()),
+                        glm::uvec4(newPool * VkContext::PARTICLE_MAX, 0, 0,
+                                   0)};
+      vkCmdPushConstants(cmd, ctx.particlePipelineLayout,
+                         VK_SHADER_STAGE_VERTEX_BIT |
+                             VK_SHADER_STAGE_FRAGMENT_BIT,
+                         0, sizeof(pc), &pc);
+      vkCmdDrawIndirect(cmd, ctx.particleStateBuffer,
+                        newPool * VkContext::PARTICLE_STATE_BYTES +
+                            VkContext::PARTICLE_DRAW_OFFSET,
+                        1, sizeof(VkDrawIndirectCommand));
+    });
+  }
+
+  // ── View model and ImGui ──────────────────────────────────────────────────
+  // The view model is drawn after terrain, depth test disabled so always on
+  // top. Each its own record, in whichever pass ends up holding them.
+  ArenaVector<RG::Record> overlay{ArenaAllocator<RG::Record>(&arena)};
+  if (viewModel)
+    overlay.push_back([&](VkCommandBuffer cmd) {
+      ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuViewModel);
+      viewModel->draw(cmd, proj);
+      ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuViewModel);
+    });
+  if (ImGui::GetCurrentContext()) // not under --bench
+    overlay.push_back([&](VkCommandBuffer cmd) {
+      ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuImGui);
+      ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmd);
+      ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuImGui);
+    });
+  if (!upscale)
+    for (const RG::Record &r : overlay)
+      scenePass.record(r);
+
+  // ── Hi-Z for the next frame's cull ────────────────────────────────────────
+  // A root while there's a scene; without one it's dropped, and the pyramid
+  // it would have replaced isn't trusted again
+  if (ctx.pipelinesReady) {
+    RG::Pass &p = rg.add("hi-z");
+    p.root = scene;
+    p.read({depth, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT});
+    p.write({hiz, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+             VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL});
+    p.record([&](VkCommandBuffer cmd) {
+      ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuHiz);
+      buildHiz(ctx, cmd);
+      ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuHiz);
+      ctx.hizViewProj = viewProj;
+      ctx.hizRect = glm::vec2((float)ext.width / (float)full.width,
+                              (float)ext.height / (float)full.height);
+      ctx.hizValid = true;
+    });
+  }
+  if (!scene)
+    ctx.hizValid = false;
+
+  // ── Upscale ───────────────────────────────────────────────────────────────
+  // The scene's depth is only good for the Hi-Z: the overlay starts over
+  if (upscale) {
+    rg.add("upscale")
+        .read({sceneColor, VK_PIPELINE_STAGE_TRANSFER_BIT,
+               VK_ACCESS_TRANSFER_READ_BIT})
+        .write({swap, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL})
+        .record([&](VkCommandBuffer cmd) {
+          ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuUpscale);
+          VkImageBlit blit{};
+          blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+          blit.srcOffsets[1] = {(int32_t)ext.width, (int32_t)ext.height, 1};
+          blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+          blit.dstOffsets[1] = {(int32_t)full.width, (int32_t)full.height, 1};
+          vkCmdBlitImage(cmd, ctx.sceneImage,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         ctx.swapImages[imageIndex],
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
+                         VK_FILTER_LINEAR);
+          ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuUpscale);
+        });
+
+    RG::Pass &p = rg.add("overlay");
+    p.root = true;
+    p.parallel = true;
+    p.begin = scenePass.begin;
+    p.begin.renderPass = ctx.overlayRenderPass;
+    p.begin.framebuffer = ctx.overlayFramebuffers[imageIndex];
+    p.begin.renderArea.extent = full;
+    p.clears = scenePass.clears;
+    p.write(depthWrite);
+    p.write({swap, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+             VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+             VK_IMAGE_LAYOUT_PRESENT_SRC_KHR});
+    for (const RG::Record &r : overlay)
+      p.record(r);
+  }
+  rg.compile();
+
+  // ── Record ────────────────────────────────────────────────────────────────
+  VkCommandBuffer cmd = ctx.commandBuffers[frame];
+  vkResetCommandBuffer(cmd, 0);
+  VkCommandBufferBeginInfo bI{};
+  bI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  vkBeginCommandBuffer(cmd, &bI);
+  ctx.profiler.beginGpuFrame(ctx.device.device, cmd, frame);
+  ctx.profiler.gpuBegin(cmd, FrameProfiler::GpuFrame);
+  rg.record(cmd);
+  ctx.profiler.gpuEnd(cmd, FrameProfiler::GpuFrame);
   vkEndCommandBuffer(cmd);
 
   // ── Submit ────────────────────────────────────────────────────────────────
-  VkPipelineStageFlags waitStage =
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  // Also wait for the newest retired chunk upload. It has already
+  // completed, so this costs nothing, but it orders the copy before the draws
+  // that read it when the copy ran on another queue. Offscreen there's no
+  // image to wait for, and nothing to present.
+  const uint32_t first = ctx.offscreen ? 1 : 0;
+  VkSemaphore waitSems[2] = {ctx.imageAvailable[frame], ctx.uploadTimeline};
+  VkPipelineStageFlags waitStages[2] = {
+      swapWait,
+      VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT}; // the cull reads meshlets
+  uint64_t waitValues[2] = {0, ctx.uploadVisibleValue};
+  VkTimelineSemaphoreSubmitInfo tI2{};
+  tI2.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  tI2.waitSemaphoreValueCount = 2 - first;
+  tI2.pWaitSemaphoreValues = waitValues + first;
+
   VkSubmitInfo sI2{};
   sI2.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-  sI2.waitSemaphoreCount = 1;
-  sI2.pWaitSemaphores = &ctx.imageAvailable[frame];
-  sI2.pWaitDstStageMask = &waitStage;
+  bool waitUploads = ctx.uploadTimeline && ctx.uploadVisibleValue > 0;
+  if (waitUploads)
+    sI2.pNext = &tI2;
+  sI2.waitSemaphoreCount = (waitUploads ? 2 : 1) - first;
+  sI2.pWaitSemaphores = waitSems + first;
+  sI2.pWaitDstStageMask = waitStages + first;
   sI2.commandBufferCount = 1;
   sI2.pCommandBuffers = &cmd;
-  sI2.signalSemaphoreCount = 1;
+  sI2.signalSemaphoreCount = ctx.offscreen ? 0 : 1;
   sI2.pSignalSemaphores = &ctx.renderFinished[frame];
   vkQueueSubmit(ctx.graphicsQueue, 1, &sI2, ctx.inFlight[frame]);
+  ctx.framesSubmitted++;
+  // The first frame each newly drawable chunk can appear in
+  for (const ChunkKey &k : ctx.traceDrawable)
+    Trace::mark("client.first_frame", k);
+  ctx.traceDrawable.clear();
+  if (ctx.offscreen) {
+    ctx.currentFrame = (frame + 1) % VkContext::FRAMES_IN_FLIGHT;
+    return;
+  }
 
   VkPresentInfoKHR pI{};
   pI.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -1004,13 +4507,22 @@ void vk_draw(VkContext &ctx, const glm::mat4 &viewProj, float sunIntensity,
   pI.swapchainCount = 1;
   pI.pSwapchains = &ctx.swapchain.swapchain;
   pI.pImageIndices = &imageIndex;
-  vkQueuePresentKHR(ctx.graphicsQueue, &pI);
+  VkPresentIdKHR idI{};
+  idI.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+  idI.swapchainCount = 1;
+  uint64_t presentId = ctx.presentId + 1;
+  idI.pPresentIds = &presentId;
+  if (ctx.waitForPresent)
+    pI.pNext = &idI;
+  if (vkQueuePresentKHR(ctx.graphicsQueue, &pI) >= VK_SUCCESS)
+    ctx.presentId = presentId;
 
   ctx.currentFrame = (frame + 1) % VkContext::FRAMES_IN_FLIGHT;
 }
 
 void vk_destroy(VkContext &ctx) {
   vkDeviceWaitIdle(ctx.device.device);
+  vk_assets_uploaded(ctx);
 
   for (int i = 0; i < VkContext::FRAMES_IN_FLIGHT; i++) {
     vkDestroySemaphore(ctx.device.device, ctx.imageAvailable[i], nullptr);
@@ -1019,31 +4531,142 @@ void vk_destroy(VkContext &ctx) {
   }
 
   vkDestroyFence(ctx.device.device, ctx.uploadFence, nullptr);
+  for (auto &b : ctx.uploadBatches)
+    if (b.fence)
+      vkDestroyFence(ctx.device.device, b.fence, nullptr);
+  if (ctx.uploadTimeline)
+    vkDestroySemaphore(ctx.device.device, ctx.uploadTimeline, nullptr);
+  vkDestroyCommandPool(ctx.device.device, ctx.transferPool, nullptr);
+
+  vkDestroyPipeline(ctx.device.device, ctx.cullChunksPipeline, nullptr);
+  vkDestroyPipeline(ctx.device.device, ctx.cullMeshletsPipeline, nullptr);
+  vkDestroyPipeline(ctx.device.device, ctx.cullEmitPipeline, nullptr);
+  vkDestroyPipelineLayout(ctx.device.device, ctx.cullPipelineLayout, nullptr);
+  vkDestroyDescriptorPool(ctx.device.device, ctx.cullPool, nullptr);
+  vkDestroyDescriptorSetLayout(ctx.device.device, ctx.cullLayout, nullptr);
+  vkDestroyPipeline(ctx.device.device, ctx.foliageScatterPipeline, nullptr);
+  vkDestroyPipeline(ctx.device.device, ctx.foliagePipeline, nullptr);
+  vkDestroyPipelineLayout(ctx.device.device, ctx.foliageScatterLayout, nullptr);
+  vkDestroyPipelineLayout(ctx.device.device, ctx.foliagePipelineLayout,
+                          nullptr);
+  vkDestroyDescriptorPool(ctx.device.device, ctx.foliagePool, nullptr);
+  vkDestroyDescriptorSetLayout(ctx.device.device, ctx.foliageLayout, nullptr);
+  vkDestroyPipeline(ctx.device.device, ctx.particleSimulatePipeline, nullptr);
+  vkDestroyPipeline(ctx.device.device, ctx.particleEmitPipeline, nullptr);
+  vkDestroyPipeline(ctx.device.device, ctx.particleArgsPipeline, nullptr);
+  vkDestroyPipeline(ctx.device.device, ctx.particlePipeline, nullptr);
+  vkDestroyPipelineLayout(ctx.device.device, ctx.particleSimLayout, nullptr);
+  vkDestroyPipelineLayout(ctx.device.device, ctx.particlePipelineLayout,
+                          nullptr);
+  vkDestroyDescriptorPool(ctx.device.device, ctx.particleDescPool, nullptr);
+  vkDestroyDescriptorSetLayout(ctx.device.device, ctx.particleLayout, nullptr);
+  vkDestroyPipeline(ctx.device.device, ctx.lightCullPipeline, nullptr);
+  vkDestroyPipelineLayout(ctx.device.device, ctx.lightCullLayout, nullptr);
+  vkDestroyDescriptorPool(ctx.device.device, ctx.lightDescPool, nullptr);
+  vkDestroyDescriptorSetLayout(ctx.device.device, ctx.lightLayout, nullptr);
+  vkDestroyPipeline(ctx.device.device, ctx.hizPipeline, nullptr);
+  vkDestroyPipelineLayout(ctx.device.device, ctx.hizPipelineLayout, nullptr);
+  vkDestroyDescriptorPool(ctx.device.device, ctx.hizPool, nullptr);
+  vkDestroyDescriptorSetLayout(ctx.device.device, ctx.hizLayout, nullptr);
+  vkDestroySampler(ctx.device.device, ctx.hizSampler, nullptr);
+  if (ctx.gpuMesh) {
+    for (GpuMeshJob &j : ctx.gpuMeshJobs) {
+      vmaDestroyBuffer(ctx.allocator, j.fieldBuffer, j.fieldAlloc);
+      vmaDestroyBuffer(ctx.allocator, j.cellBuffer, j.cellAlloc);
+      vmaDestroyBuffer(ctx.allocator, j.headerBuffer, j.headerAlloc);
+      if (j.readbackBuffer)
+        vmaDestroyBuffer(ctx.allocator, j.readbackBuffer, j.readbackAlloc);
+    }
+    vmaDestroyBuffer(ctx.allocator, ctx.marchTableBuffer, ctx.marchTableAlloc);
+    vkDestroyPipeline(ctx.device.device, ctx.marchClassify, nullptr);
+    vkDestroyPipeline(ctx.device.device, ctx.marchScan, nullptr);
+    vkDestroyPipeline(ctx.device.device, ctx.marchEmit, nullptr);
+    vkDestroyPipelineLayout(ctx.device.device, ctx.marchPipelineLayout,
+                            nullptr);
+    vkDestroyDescriptorPool(ctx.device.device, ctx.marchPool, nullptr);
+    vkDestroyDescriptorSetLayout(ctx.device.device, ctx.marchLayout, nullptr);
+  }
+  for (auto &v : ctx.hizLevelViews)
+    vkDestroyImageView(ctx.device.device, v, nullptr);
+  vkDestroyImageView(ctx.device.device, ctx.hizView, nullptr);
+  vmaDestroyImage(ctx.allocator, ctx.hizImage, ctx.hizAlloc);
 
+  vkDestroyPipeline(ctx.device.device, ctx.depthPrepassPipeline, nullptr);
   vkDestroyPipeline(ctx.device.device, ctx.pipeline, nullptr);
+  for (const VkContext::RetiredPipeline &r : ctx.retiredPipelines)
+    vkDestroyPipeline(ctx.device.device, r.pipeline, nullptr);
   vkDestroyPipelineLayout(ctx.device.device, ctx.pipelineLayout, nullptr);
-  vkDestroyDescriptorPool(ctx.device.device, ctx.dsPool, nullptr);
-  vkDestroyDescriptorSetLayout(ctx.device.device, ctx.dsLayout, nullptr);
+  vkDestroyPipeline(ctx.device.device, ctx.farPipeline, nullptr);
+  vkDestroyPipelineLayout(ctx.device.device, ctx.farPipelineLayout, nullptr);
+  vkDestroyPipelineCache(ctx.device.device, ctx.pipelineCache, nullptr);
+  ctx.profiler.destroy(ctx.device.device);
+  ctx.bindless->destroy();
 
-  for (auto &fb : ctx.framebuffers)
-    vkDestroyFramebuffer(ctx.device.device, fb, nullptr);
+  destroyFramebuffers(ctx);
 
   vkDestroyRenderPass(ctx.device.device, ctx.renderPass, nullptr);
+  vkDestroyRenderPass(ctx.device.device, ctx.sceneRenderPass, nullptr);
+  vkDestroyRenderPass(ctx.device.device, ctx.overlayRenderPass, nullptr);
 
   vkDestroyImageView(ctx.device.device, ctx.depthImageView, nullptr);
   vmaDestroyImage(ctx.allocator, ctx.depthImage, ctx.depthAlloc);
+  vkDestroyImageView(ctx.device.device, ctx.sceneImageView, nullptr);
+  if (ctx.sceneImage)
+    vmaDestroyImage(ctx.allocator, ctx.sceneImage, ctx.sceneAlloc);
+
+  vkDestroyPipeline(ctx.device.device, ctx.shadowPipeline, nullptr);
+  for (int m = 0; m < 2; m++)
+    for (int c = 0; c < VkContext::SHADOW_CASCADES; c++) {
+      vkDestroyFramebuffer(ctx.device.device, ctx.shadowFramebuffers[m][c],
+                           nullptr);
+      vkDestroyImageView(ctx.device.device, ctx.shadowLayerViews[m][c],
+                         nullptr);
+    }
+  vkDestroyImageView(ctx.device.device, ctx.shadowStaticView, nullptr);
+  vkDestroyImageView(ctx.device.device, ctx.shadowDynamicView, nullptr);
+  vmaDestroyImage(ctx.allocator, ctx.shadowStaticImage, ctx.shadowStaticAlloc);
+  vmaDestroyImage(ctx.allocator, ctx.shadowDynamicImage,
+                  ctx.shadowDynamicAlloc);
+  vkDestroyRenderPass(ctx.device.device, ctx.shadowRenderPass, nullptr);
+  vkDestroySampler(ctx.device.device, ctx.shadowSampler, nullptr);
+  vkDestroyDescriptorPool(ctx.device.device, ctx.shadowPool, nullptr);
+  vkDestroyDescriptorSetLayout(ctx.device.device, ctx.shadowLayout, nullptr);
 
   for (int i = 0; i < 2; i++) {
     vmaDestroyBuffer(ctx.allocator, ctx.indirectBuffer[i],
                      ctx.indirectAlloc[i]);
-    vmaDestroyBuffer(ctx.allocator, ctx.perChunkBuffer[i],
-                     ctx.perChunkAlloc[i]);
+    vmaDestroyBuffer(ctx.allocator, ctx.drawCountBuffer[i],
+                     ctx.drawCountAlloc[i]);
+    vmaDestroyBuffer(ctx.allocator, ctx.cullParamBuffer[i],
+                     ctx.cullParamAlloc[i]);
+    vmaDestroyBuffer(ctx.allocator, ctx.visibleBuffer[i], ctx.visibleAlloc[i]);
+    vmaDestroyBuffer(ctx.allocator, ctx.farVertexBuffer[i],
+                     ctx.farVertexAlloc[i]);
+    vmaDestroyBuffer(ctx.allocator, ctx.shadowParamBuffer[i],
+                     ctx.shadowParamAlloc[i]);
+    vmaDestroyBuffer(ctx.allocator, ctx.foliageDrawBuffer[i],
+                     ctx.foliageDrawAlloc[i]);
+    vmaDestroyBuffer(ctx.allocator, ctx.particleEmitterBuffer[i],
+                     ctx.particleEmitterAlloc[i]);
+    vmaDestroyBuffer(ctx.allocator, ctx.lightInputBuffer[i],
+                     ctx.lightInputAlloc[i]);
   }
+  vmaDestroyBuffer(ctx.allocator, ctx.foliageInstanceBuffer,
+                   ctx.foliageInstanceAlloc);
+  vmaDestroyBuffer(ctx.allocator, ctx.particleBuffer, ctx.particleAlloc);
+  vmaDestroyBuffer(ctx.allocator, ctx.particleStateBuffer,
+                   ctx.particleStateAlloc);
+  vmaDestroyBuffer(ctx.allocator, ctx.lightGridBuffer, ctx.lightGridAlloc);
+  vmaDestroyBuffer(ctx.allocator, ctx.farIndexBuffer, ctx.farIndexAlloc);
+  vmaDestroyBuffer(ctx.allocator, ctx.chunkSlotBuffer, ctx.chunkSlotAlloc);
+  vmaDestroyBuffer(ctx.allocator, ctx.meshletBuffer, ctx.meshletAlloc);
 
   vmaDestroyBuffer(ctx.allocator, ctx.mega.vertexBuffer, ctx.mega.vertexAlloc);
   vmaDestroyBuffer(ctx.allocator, ctx.mega.indexBuffer, ctx.mega.indexAlloc);
   vmaDestroyBuffer(ctx.allocator, ctx.stagingBuffer, ctx.stagingAlloc);
 
+  ctx.graph.destroy();
+  ctx.recordPool.reset();
   vkDestroyCommandPool(ctx.device.device, ctx.commandPool, nullptr);
   if (ctx.atlasSampler)
     vkDestroySampler(ctx.device.device, ctx.atlasSampler, nullptr);
@@ -1051,12 +4674,10 @@ void vk_destroy(VkContext &ctx) {
     vkDestroyImageView(ctx.device.device, ctx.atlasImageView, nullptr);
   if (ctx.atlasImage)
     vmaDestroyImage(ctx.allocator, ctx.atlasImage, ctx.atlasAlloc);
-  if (ctx.atlasPool)
-    vkDestroyDescriptorPool(ctx.device.device, ctx.atlasPool, nullptr);
-  if (ctx.atlasLayout)
-    vkDestroyDescriptorSetLayout(ctx.device.device, ctx.atlasLayout, nullptr);
   for (auto &iv : ctx.swapImageViews)
     vkDestroyImageView(ctx.device.device, iv, nullptr);
+  for (size_t i = 0; i < ctx.offscreenAllocs.size(); i++)
+    vmaDestroyImage(ctx.allocator, ctx.swapImages[i], ctx.offscreenAllocs[i]);
 
   vmaDestroyAllocator(ctx.allocator);
 
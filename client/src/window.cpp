@@ -1,13 +1,14 @@
 #include "window.h"
 #include <stdexcept>
 
-Window::Window(int width, int height, std::string_view title) {
+Window::Window(int width, int height, std::string_view title, bool visible) {
 
 	if (!glfwInit())
         throw std::runtime_error("glfwInit failed");
 
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API); // no OpenGL
     glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 
     _window = glfwCreateWindow(width, height, title.data(), nullptr, nullptr);
     if (!_window) {
@@ -0,0 +1,143 @@
+#pragma once
+#include <enet/enet.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <unordered_set>
+#include "config.h"
+#include "mp_packets.h"
+#include "outbox.h"
+
+// Verified logins wait here before entering the world (chunk view,
+// inventory, stats, the first chunk flush), so a join storm after a
+// restart is let in a few at a time instead of in one tick. A login goes
+// in when there's a token for it — ADMIT_PER_S, bursting to ADMIT_BURST —
+// and the server has room: the main loop's recent load under
+// ADMIT_MAX_LOAD and the generation backlog under ADMIT_GEN_BACKLOG. A
+// server that never has room still lets one in every ADMIT_STALL_MS.
+// First come, first in; waiting clients are told their place
+// (AdmissionQueuePacket) when it changes.
+//
+// Main thread only. A rate of 0 turns it off: nothing waits.
+class AdmissionQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        size_t   waiting    = 0;
+        uint64_t admitted   = 0;
+        float    worstWaitS = 0.f; // since the last takeStats
+        float    load       = 0.f;
+    };
+
+    explicit AdmissionQueue(Outbox& out, double perSecond = Config::ADMIT_PER_S)
+        : _out(out), _rate(std::max(perSecond, 0.0)), _tokens(Config::ADMIT_BURST) {}
+
+    bool enabled() const { return _rate > 0.0; }
+
+    // A verified login; false when admission is off (let it straight in)
+    bool push(ENetPeer* peer) {
+        if (!enabled()) return false;
+        if (_queued.insert(peer).second) _queue.push_back({peer, Clock::now(), 0});
+        return true;
+    }
+
+    void remove(ENetPeer* peer) {
+        if (!_queued.erase(peer)) return;
+        std::erase_if(_queue, [peer](const Entry& e) { return e.peer == peer; });
+    }
+
+    bool waiting(ENetPeer* peer) const { return _queued.count(peer) != 0; }
+
+    // Seconds of work the main loop just did, once per iteration
+    void observe(double busySeconds) { _busy += busySeconds; }
+
+    // Once per iteration. enter(peer) for each login let in; backlog()
+    // is the generation pool's queue, asked again after each one since
+    // every login adds its view to it.
+    template<class Enter, class Backlog>
+    void admit(Enter&& enter, Backlog&& backlog) {
+        if (!enabled()) return;
+        auto now = Clock::now();
+        double dt = std::chrono::duration<double>(now - _last).count();
+        _last     = now;
+        _tokens   = std::min((double)Config::ADMIT_BURST, _tokens + dt * _rate);
+        measureLoad(now);
+
+        while (!_queue.empty() && _tokens >= 1.0) {
+            bool room    = _load < Config::ADMIT_MAX_LOAD && backlog() < Config::ADMIT_GEN_BACKLOG;
+            bool stalled = now - _lastAdmit >= std::chrono::milliseconds(Config::ADMIT_STALL_MS);
+            if (!room && !stalled) break;
+            Entry e = _queue.front();
+            _queue.pop_front();
+            _queued.erase(e.peer);
+            _tokens   -= 1.0;
+            _lastAdmit = now;
+            _admitted++;
+            _worstWait = std::max(_worstWait, std::chrono::duration<float>(now - e.since).count());
+            enter(e.peer);
+        }
+        notify(now);
+    }
+
+    size_t queued() const { return _queue.size(); }
+
+    Stats takeStats() {
+        Stats s{_queue.size(), _admitted, _worstWait, (float)_load};
+        _worstWait = 0.f;
+        return s;
+    }
+
+private:
+    struct Entry {
+        ENetPeer*         peer;
+        Clock::time_point since;
+        uint16_t          told; // place last sent; 0 before the first
+    };
+
+    static constexpr auto LOAD_WINDOW = std::chrono::milliseconds(250);
+
+    // Busy fraction over the last window, smoothed
+    void measureLoad(Clock::time_point now) {
+        double span = std::chrono::duration<double>(now - _windowStart).count();
+        if (now - _windowStart < LOAD_WINDOW) return;
+        double load  = std::min(_busy / span, 1.0);
+        _load        = _load * 0.5 + load * 0.5;
+        _busy        = 0.0;
+        _windowStart = now;
+    }
+
+    void notify(Clock::time_point now) {
+        if (_queue.empty() || now - _notified < std::chrono::milliseconds(Config::ADMIT_NOTIFY_MS)) return;
+        _notified = now;
+        AdmissionQueuePacket pkt;
+        pkt.waiting = (uint16_t)std::min<size_t>(_queue.size(), 0xFFFF);
+        uint16_t place = 0;
+        for (Entry& e : _queue) {
+            pkt.position = place = (uint16_t)std::min<int>(place + 1, 0xFFFF);
+            if (e.told == place) continue;
+            e.told = place;
+            pkt.write(_w);
+            _out.reliable(e.peer, _w.data(), _w.size());
+        }
+    }
+
+    Outbox&      _out;
+    double       _rate;
+    double       _tokens;
+    PacketWriter _w;
+
+    std::deque<Entry>             _queue;
+    std::unordered_set<ENetPeer*> _queued;
+
+    Clock::time_point _last        = Clock::now();
+    Clock::time_point _lastAdmit   = Clock::now();
+    Clock::time_point _windowStart = Clock::now();
+    Clock::time_point _notified{};
+    double            _busy = 0.0;
+    double            _load = 0.0;
+
+    uint64_t _admitted  = 0;
+    float    _worstWait = 0.f;
+};
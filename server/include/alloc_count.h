@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+
+// ── AllocCount ────────────────────────────────────────────────────────────────
+// Debug builds of the server binary (AETHERIS_COUNT_ALLOCS, set by
+// server/meson.build for debug buildtypes) replace the global operator new
+// with one that counts per thread. The status line reports the main loop's
+// heap allocations per iteration: with the tick arena and the reused
+// buffers, a warmed-up server with steady players should hold near none.
+// Workers and the network threads allocate as they please.
+#ifdef AETHERIS_COUNT_ALLOCS
+namespace AllocCount {
+    // operator new calls on the calling thread, since it started
+    uint64_t thisThread();
+}
+#endif
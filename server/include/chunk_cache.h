@@ -0,0 +1,173 @@
+#pragma once
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "chunk.h"
+#include "flat_map.h"
+
+// A serialized chunk packet. Immutable once built, so the cache, the region
+// writer and every in-flight ENet packet share one copy.
+using ChunkPayload = std::shared_ptr<const std::vector<uint8_t>>;
+
+// Both encodings of one chunk. The field is the canonical form (it's what the
+// region store persists); the mesh is built from it only once some client
+// that can't mesh locally asks for the chunk. Either may be null. Uniform
+// chunks use one ChunkUniform marker for both.
+//
+// With compression on (ChunkManager::useCompression) each encoding may have
+// a packed twin, a ChunkPacked of the same bytes, made once on the way in;
+// null where packing didn't shrink it.
+struct ChunkPayloads {
+    ChunkPayload field;
+    ChunkPayload mesh;
+    ChunkPayload fieldPacked{};
+    ChunkPayload meshPacked{};
+
+    size_t bytes() const {
+        size_t n = field ? field->size() : 0;
+        if (mesh && mesh != field) n += mesh->size();
+        if (fieldPacked) n += fieldPacked->size();
+        if (meshPacked && meshPacked != fieldPacked) n += meshPacked->size();
+        return n;
+    }
+};
+
+// Serialized chunks keyed by coord and level of detail, bounded by a byte
+// budget.
+// Least-recently-used entries are evicted first. Pinned coords (chunks inside
+// some connected player's view) are never evicted — they sit outside the LRU
+// list until their last pin is released. If everything is pinned the cache is
+// allowed to run over budget rather than drop chunks a player is standing in.
+// Thread-safe: workers insert, the ENet thread looks up and pins.
+class ChunkCache {
+public:
+    struct Stats {
+        uint64_t hits      = 0;
+        uint64_t misses    = 0;
+        uint64_t evictions = 0;
+        size_t   entries   = 0;
+        size_t   bytes     = 0;
+        size_t   budget    = 0;
+    };
+
+    explicit ChunkCache(size_t budgetBytes) : _budget(budgetBytes) {}
+
+    // Both null on miss. Only counts a hit if the wanted encoding is present.
+    ChunkPayloads get(const ChunkKey& key, bool wantMesh) {
+        std::lock_guard lk(_mu);
+        auto it = _entries.find(key);
+        if (it == _entries.end()) { _misses++; return {}; }
+        const ChunkPayloads& p = it->second.payloads;
+        (wantMesh ? p.mesh : p.field) ? _hits++ : _misses++;
+        touch(it->second);
+        return p;
+    }
+
+    // get() without counting or touching anything — for readers other than
+    // the streaming path, whose lookups the stats describe
+    ChunkPayloads peek(const ChunkKey& key) {
+        std::lock_guard lk(_mu);
+        auto it = _entries.find(key);
+        return it == _entries.end() ? ChunkPayloads{} : it->second.payloads;
+    }
+
+    // Merges with what's cached — a null encoding doesn't clear an existing one.
+    void put(const ChunkKey& key, ChunkPayloads bytes) { store(key, std::move(bytes), true); }
+
+    // Drops whatever isn't given: for an edited chunk, every old encoding
+    // is stale
+    void replace(const ChunkKey& key, ChunkPayloads bytes) { store(key, std::move(bytes), false); }
+
+    // Pins are refcounted — one per player whose view cube covers the coord.
+    // Pinning a coord that isn't cached yet is fine; it takes effect on put().
+    void pin(const ChunkKey& key) {
+        std::lock_guard lk(_mu);
+        if (_pins[key]++ > 0) return;
+        auto it = _entries.find(key);
+        if (it != _entries.end() && it->second.inLru) {
+            _lru.erase(it->second.lruIt);
+            it->second.inLru = false;
+        }
+    }
+
+    void unpin(const ChunkKey& key) {
+        std::lock_guard lk(_mu);
+        auto p = _pins.find(key);
+        if (p == _pins.end() || --p->second > 0) return;
+        _pins.erase(p);
+        auto it = _entries.find(key);
+        if (it != _entries.end()) {
+            // Just left a player's view — most recently used
+            _lru.push_front(key);
+            it->second.lruIt = _lru.begin();
+            it->second.inLru = true;
+            evict();
+        }
+    }
+
+    Stats stats() {
+        std::lock_guard lk(_mu);
+        return {_hits, _misses, _evictions, _entries.size(), _bytes, _budget};
+    }
+
+private:
+    void store(const ChunkKey& key, ChunkPayloads bytes, bool merge) {
+        std::lock_guard lk(_mu);
+        auto [it, isNew] = _entries.try_emplace(key);
+        Entry& e = it->second;
+        if (!isNew) {
+            _bytes -= e.payloads.bytes();
+            if (e.inLru) { _lru.erase(e.lruIt); e.inLru = false; }
+            if (merge && !bytes.field) {
+                bytes.field       = std::move(e.payloads.field);
+                bytes.fieldPacked = std::move(e.payloads.fieldPacked);
+            }
+            if (merge && !bytes.mesh) {
+                bytes.mesh       = std::move(e.payloads.mesh);
+                bytes.meshPacked = std::move(e.payloads.meshPacked);
+            }
+        }
+        e.payloads = std::move(bytes);
+        _bytes += e.payloads.bytes();
+        if (!_pins.count(key)) {
+            _lru.push_front(key);
+            e.lruIt = _lru.begin();
+            e.inLru = true;
+        }
+        evict();
+    }
+
+    struct Entry {
+        ChunkPayloads                   payloads;
+        std::list<ChunkKey>::iterator lruIt;
+        bool                            inLru = false;
+    };
+
+    void touch(Entry& e) {
+        if (e.inLru) _lru.splice(_lru.begin(), _lru, e.lruIt);
+    }
+
+    void evict() {
+        while (_bytes > _budget && !_lru.empty()) {
+            ChunkKey victim = _lru.back();
+            _lru.pop_back();
+            auto it = _entries.find(victim);
+            _bytes -= it->second.payloads.bytes();
+            _entries.erase(it);
+            _evictions++;
+        }
+    }
+
+    std::mutex _mu;
+    size_t     _budget;
+    size_t     _bytes = 0;
+
+    FlatMap<ChunkKey, Entry, ChunkKeyHash> _entries;
+    FlatMap<ChunkKey, int,   ChunkKeyHash> _pins;
+    std::list<ChunkKey> _lru; // front = most recent, unpinned entries only
+
+    uint64_t _hits = 0, _misses = 0, _evictions = 0;
+};
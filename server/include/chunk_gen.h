@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "chunk.h"
+#include "chunk_cache.h"
+#include "metrics.h"
+#include "trace.h"
+
+// ── Chunk generation stages ───────────────────────────────────────────────────
+// The pure CPU work behind a chunk, shared by ChunkManager's own pool and the
+// standalone chunkgen service: no cache, no region store, no peers. Every
+// function here runs on whatever worker calls it.
+
+// Seconds per generation stage, observed on the workers: noise is
+// sampling (a split job's wall time across its slabs), march includes
+// decoding the field it marches from, serialize is encoding a field or
+// mesh payload; edit is a whole edit job, remeshing included
+struct GenTimings {
+    Metrics::Histogram noise, march, optimize, serialize, edit;
+};
+
+// One stage of a chunk's generation: timed into its histogram, and into the
+// chunk's trace while tracing
+struct Stage {
+    Stage(Metrics::Histogram& h, const char* name, const ChunkKey& key) : timer(h), span(name, key) {}
+    Metrics::ScopedTimer timer;
+    Trace::Span          span;
+};
+
+// Per-worker scratch, kept between jobs: a ChunkData is ~180 KB — too big
+// for a worker's stack, and too big to fault in fresh for every chunk — and
+// a mesh's vectors keep their capacity. Only for stages that start and
+// finish on one worker.
+ChunkData& workerData();
+ChunkMesh& workerMesh();
+
+// A sampled chunk's canonical payload: the uniform marker, or the field
+ChunkPayload encodeField(ChunkCoord coord, const ChunkData& data, GenTimings& timings);
+
+// The mesh payload marched from a field payload; nullptr if it's corrupt
+ChunkPayload marchField(const ChunkKey& key, const ChunkPayload& field, GenTimings& timings);
+
+// A LOD cell sampled, marched with skirts and encoded — a uniform marker if
+// there's nothing to draw. uniform says whether the samples were.
+ChunkPayload buildLodCell(const ChunkKey& key, GenTimings& timings, bool& uniform);
+
+// Names what this build generates — seed, terrain graph, feature placement
+// and payload formats — so caches and services from another world are never
+// consulted. Never 0.
+uint32_t generatorWorldId();
+
+// Generate from the graph in the file at path (see noise_graph.h) rather
+// than the built-in one; before anything is generated. False, logged, if
+// it can't be read or doesn't parse.
+bool loadTerrainGraph(const std::string& path);
@@ -0,0 +1,57 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+#include <glm/vec3.hpp>
+#include "chunk.h"
+
+// Keys bucketed by the chunk their position falls in, for things that are
+// looked up by proximity far more often than they move (chests, corpses,
+// players between chunk crossings). A radius query visits only the chunks
+// the radius touches; callers do their own exact distance test.
+template<class Key>
+class ChunkIndex {
+public:
+    void insert(Key k, const glm::vec3& pos) { _cells[cellOf(pos)].push_back(k); }
+
+    void erase(Key k, const glm::vec3& pos) {
+        auto it = _cells.find(cellOf(pos));
+        if (it == _cells.end()) return;
+        auto& v = it->second;
+        auto at = std::find(v.begin(), v.end(), k);
+        if (at == v.end()) return;
+        *at = v.back();
+        v.pop_back();
+        if (v.empty()) _cells.erase(it);
+    }
+
+    // Re-bucket after a move; a no-op while k stays in the same chunk
+    void move(Key k, const glm::vec3& from, const glm::vec3& to) {
+        if (cellOf(from) == cellOf(to)) return;
+        erase(k, from);
+        insert(k, to);
+    }
+
+    // f(Key) for every key in a chunk overlapping the cube of half-size
+    // radius around pos
+    template<class F>
+    void forEachNear(const glm::vec3& pos, float radius, F&& f) const {
+        ChunkCoord lo = cellOf(pos - glm::vec3(radius)), hi = cellOf(pos + glm::vec3(radius));
+        for (int x = lo.x; x <= hi.x; x++)
+        for (int y = lo.y; y <= hi.y; y++)
+        for (int z = lo.z; z <= hi.z; z++) {
+            auto it = _cells.find({x, y, z});
+            if (it == _cells.end()) continue;
+            for (const Key& k : it->second) f(k);
+        }
+    }
+
+    static ChunkCoord cellOf(const glm::vec3& p) {
+        return {(int)std::floor(p.x / ChunkData::SIZE), (int)std::floor(p.y / ChunkData::SIZE),
+                (int)std::floor(p.z / ChunkData::SIZE)};
+    }
+
+private:
+    std::unordered_map<ChunkCoord, std::vector<Key>, ChunkCoordHash> _cells;
+};
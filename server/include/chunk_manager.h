@@ -1,56 +1,531 @@
 #pragma once
 #include <enet/enet.h>
+#include <array>
+#include <cstdint>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <queue>
 #include <mutex>
 #include <climits>
+#include <atomic>
+#include <functional>
+#include <chrono>
 #include "chunk.h"
 #include "packets.h"
 #include "config.h"
 #include "thread_pool.h"
+#include "chunk_cache.h"
+#include "chunk_codec.h"
+#include "chunk_gen.h"
+#include "chunkgen_link.h"
+#include "density_cache.h"
+#include "shared_chunk_cache.h"
+#include "flat_map.h"
+#include "outbox.h"
+#include "player_registry.h"
+#include "region_store.h"
+#include "resident_chunk.h"
+#include "view_tiers.h"
+#include "scratch_pool.h"
+#include "tick_arena.h"
+#include "metrics.h"
+#include "trace.h"
+#include "terrain_edit.h"
+#include "terrain_query.h"
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+
+// One bit per cell of a fixed-size view box, addressed by coord modulo the
+// box size. The box can move without shifting anything: the cells a move
+// vacates are exactly the ones the newly entered coords land on, so
+// clearing those as they're visited forgets everything that left range.
+// Coords outside the box always read as clear and can't be set.
+class ViewBits {
+public:
+    void resize(int w, int h) {
+        _w = w;
+        _h = h;
+        _bits.assign(((size_t)w * w * h + 63) / 64, 0);
+    }
+
+    bool test(ChunkCoord c, const ViewBox& box) const {
+        if (!box.contains(c)) return false;
+        size_t i = index(c);
+        return _bits[i >> 6] >> (i & 63) & 1;
+    }
+    void set(ChunkCoord c, const ViewBox& box) {
+        if (!box.contains(c)) return;
+        size_t i = index(c);
+        _bits[i >> 6] |= uint64_t(1) << (i & 63);
+    }
+    // Takes any coord; one outside the box clears the cell it aliases, which
+    // is what a move does to the cells it hands over
+    void reset(ChunkCoord c) {
+        size_t i = index(c);
+        _bits[i >> 6] &= ~(uint64_t(1) << (i & 63));
+    }
+    void clear() { std::fill(_bits.begin(), _bits.end(), 0); }
+
+private:
+    static int wrap(int v, int n) { int m = v % n; return m < 0 ? m + n : m; }
+    size_t index(ChunkCoord c) const {
+        return ((size_t)wrap(c.x, _w) * _h + (size_t)wrap(c.y, _h)) * _w + (size_t)wrap(c.z, _w);
+    }
+
+    int                   _w = 1, _h = 1;
+    std::vector<uint64_t> _bits = std::vector<uint64_t>(1);
+};
 
 struct ClientState {
     ENetPeer*  peer      = nullptr;
     ChunkCoord lastChunk = {INT_MIN, INT_MIN, INT_MIN};
-    std::unordered_set<ChunkCoord, ChunkCoordHash> sentChunks;
-    std::unordered_set<ChunkCoord, ChunkCoordHash> pendingChunks;
+    ChunkCoord heading   = {0, 0, 0}; // x and z of the last boundary crossing, each -1..1
+
+    // Horizontal velocity in m/s, smoothed over the moves (updateClient),
+    // and the prefetch shell it last asked for: the full-resolution view
+    // shifted by shift, minus the view itself
+    float                                  pos[2] = {0.f, 0.f}, vel[2] = {0.f, 0.f};
+    std::chrono::steady_clock::time_point  movedAt{};
+    float                                  prefetchDir[2] = {0.f, 0.f}; // unit, or zero for none
+    ChunkCoord                             prefetchShift  = {0, 0, 0};
+    ChunkCoord                             prefetchAround = {INT_MIN, INT_MIN, INT_MIN}; // lastChunk then
+    std::vector<ChunkKey>                  prefetch;
+    ViewTiers  tiers;          // negotiated at login, or since by setViewRadius
+    bool       fields = false; // negotiated CAP_CHUNK_FIELDS — meshes locally
+    bool       lod    = false; // negotiated CAP_LOD_CHUNKS
+    bool       packed = false; // named the codec of the world's dictionary — gets ChunkPacked
+
+    // Per level of detail, around lastChunk: the cells sent (region minus
+    // hole — see ViewTiers) and which of them were handed over, or are on
+    // their way. Empty boxes until the client is placed.
+    struct Level {
+        ViewBox  region, hole;
+        ViewBits sent;
+    };
+    std::array<Level, Config::LOD_LEVELS_MAX + 1> levels;
+    FlatSet<ChunkKey, ChunkKeyHash> pendingChunks;
+
+    bool wants(const ChunkKey& k) const {
+        if (k.lod > tiers.levels) return false;
+        const Level& l = levels[k.lod];
+        return l.region.contains(k.coord) && !l.hole.contains(k.coord);
+    }
+
+    // Finished chunks not yet handed to the Outbox, each holding a packet
+    // reference. Drained nearest-first as the peer's budget allows.
+    struct Outbound {
+        ChunkKey    key;
+        ENetPacket* pkt;
+        int64_t     readyUs = 0; // Trace::nowUs() when it got here, while tracing
+    };
+    std::vector<Outbound> outbound;
+
+    // Full-resolution chunks the client has on disk (ChunkHave), by payload
+    // hash. Each is offered once, when the chunk is next on its way out;
+    // kept across resetClient, since respawning doesn't touch the disk.
+    static constexpr size_t HELD_MAX = 1 << 16;
+    std::unordered_map<ChunkCoord, uint64_t, ChunkCoordHash> held;
 };
 
+// A finished chunk waiting to be sent on the ENet thread. peers lists every
+// client that asked for it — one entry for a cache hit, all subscribers of the
+// in-flight job for a freshly generated chunk. bytes is shared with the cache;
+// each peer gets whichever encoding it negotiated (LOD cells only ever go
+// out as meshes). A partial result carries only the field while the mesh
+// stage is still running — it serves the field subscribers and leaves the
+// rest waiting for the final one.
 struct ReadyChunk {
-    ENetPeer*            peer;
-    ChunkCoord           coord;
-    std::vector<uint8_t> bytes;
+    std::vector<ENetPeer*> peers;
+    ChunkKey               key;
+    ChunkPayloads          bytes;
+    bool                   partial = false;
+};
+
+// One generation job per key, server-wide. Every peer that requests the
+// key while the job is running is attached here instead of submitting its
+// own job. Only touched on the ENet thread. meshCancel drops the mesh stage
+// once nobody is left to receive it.
+struct InFlightChunk {
+    std::vector<ENetPeer*> subscribers;
+    std::vector<ENetPeer*> prefetchers; // queued it ahead of their travel; sent nothing
+    CancelToken            meshCancel = CancelToken::make();
+};
+
+// Entry in the generation priority queue. Lower priority runs first.
+// stamp ties the entry to _queued — re-prioritizing pushes a fresh entry with a
+// new stamp, so the old one is skipped when it surfaces (lazy deletion).
+struct GenJob {
+    float      priority;
+    uint32_t   stamp;
+    ChunkKey   key;
+
+    bool operator>(const GenJob& o) const { return priority > o.priority; }
 };
 
 class ChunkManager {
 public:
-    explicit ChunkManager(int genThreads = 0);
+    explicit ChunkManager(PlayerRegistry& players,
+                          const ThreadPoolOptions& genPool = {Config::GEN_THREADS_MIN,
+                                                              Config::GEN_THREADS_MAX, {},
+                                                              MemTags::GenScratch},
+                          size_t cacheBudgetBytes = Config::CHUNK_CACHE_BUDGET_MB << 20,
+                          std::string worldDir = Config::WORLD_DIR);
 
-    void addClient   (ENetPeer* peer);
+    // A client's view is its ClientState component in players, so the peer
+    // must be there first. viewRadius is what the client asked for
+    // (AuthRequest); the returned tiers are what it gets, for the ViewConfig
+    // reply.
+    ViewTiers addClient(ENetPeer* peer, uint32_t caps = 0,
+                        int viewRadius = Config::CHUNK_RADIUS_XZ);
     void removeClient(ENetPeer* peer);
     void resetClient (ENetPeer* peer);
+    // A new view radius mid-session (ViewRadius), renegotiated as at login.
+    // What was sent and is still in view isn't sent again; the rest of the
+    // new view is scheduled. Returns the tiers for the ViewConfig reply.
+    ViewTiers setViewRadius(ENetPeer* peer, int viewRadius);
 
     void updateClient(ENetPeer* peer, float wx, float wy, float wz);
 
-    // Call every server tick from the ENet thread — sends finished chunks
-    void flushReady(ENetHost* host);
+    // Move timing (the velocity prefetch is judged by) runs on steady_clock
+    // unless this says otherwise (replay)
+    void setClock(std::function<std::chrono::steady_clock::time_point()> now) { _now = std::move(now); }
+
+    // The client evicted these full-resolution chunks (ChunkUnload); they
+    // get sent again if needed
+    void forgetChunks(ENetPeer* peer, const std::vector<ChunkCoord>& coords);
+
+    // The client's disk cache has these chunks (ChunkHave). Any of them
+    // already waiting in its outbound list with the same bytes, and any sent
+    // later, go out as a ChunkCached instead.
+    void holdChunks(ENetPeer* peer, const std::vector<ChunkHavePacket::Entry>& entries);
+
+    // Names what this server generates — seed and payload formats — for
+    // ViewConfig, so a client's cache from another world is never consulted
+    uint32_t worldId() const;
+
+    // Sharded: the regions this process persists. Chunks elsewhere are
+    // still generated, edited and sent, for the players near a border, but
+    // only their owner saves them. Before the first client.
+    void setOwnedRegions(RegionStore::Owned owned) { _regions.setOwned(std::move(owned)); }
+
+    // Hands the chunks this process would generate on its own pool to the
+    // chunkgen service at host:port instead — all but the ones a player is
+    // standing in or next to, which are split across the pool here as
+    // before. What the service sends back is saved and sent like anything
+    // generated here; whatever it can't take is. Before the first client;
+    // throws as ChunkGenLink does.
+    void useChunkGen(const std::string& host, uint16_t port);
+
+    // Consults, and feeds, the host-wide SharedChunkCache of this world
+    // before generating anything, creating it at about bytes if no other
+    // instance has. False (and none used) if it can't be mapped. Before the
+    // first client.
+    bool useSharedCache(size_t bytes);
+
+    // ── Compression ───────────────────────────────────────────────────────────
+    // Packs every payload with codec, once, as it enters the chunk cache,
+    // and sends the packed form to clients whose caps name the codec. The
+    // dictionary is the world's chunks.dict, or trained on the nearest
+    // CHUNK_DICT_SAMPLES columns to (wx, wz) and saved there. False (and
+    // nothing packed) if the codec isn't in this build or training fails.
+    // Before the first client, and before pregenerate.
+    bool useCompression(ChunkCodec codec, float wx, float wz);
+
+    // The ChunkDict a client with these caps needs ahead of its first
+    // chunk; null if it gets everything raw
+    ChunkPayload dictFor(uint32_t caps) const;
+
+    struct PackStats {
+        ChunkCodec codec = ChunkCodec::None;
+        uint64_t   payloads = 0, rawBytes = 0, packedBytes = 0; // of the ones packing shrank
+        uint64_t   skipped  = 0;                                  // not worth packing
+    };
+    PackStats packStats() const {
+        return {_dict ? _dict->codec() : ChunkCodec::None, _packed.load(std::memory_order_relaxed),
+                _packRaw.load(std::memory_order_relaxed), _packOut.load(std::memory_order_relaxed),
+                _packSkipped.load(std::memory_order_relaxed)};
+    }
+
+    // ── Pregeneration ─────────────────────────────────────────────────────────
+    // Generates and saves every column within radius chunks of (wx, wz),
+    // PREGEN_DEPTH chunks either side of the surface, across the whole
+    // pool, logging progress; returns when it's done. What's saved already
+    // is skipped, and so are other shards' regions. The results are cached
+    // too, for the first players. Before the first client.
+    void pregenerate(float wx, float wz, int radius);
+
+    // From now on, whenever no chunk or edit job is waiting or running,
+    // flushReady hands the pool a few columns at background priority: the
+    // ones just past each moving player's view along their heading, then
+    // the ones around (wx, wz), ring by ring, out to radius. They go to the
+    // region store only. Columns inside a player's view are left alone —
+    // an edit there must never race a pregenerated save.
+    void setIdlePregen(float wx, float wz, int radius);
+
+    // Chunks pregenerated, at startup or idle
+    uint64_t pregenCount() const { return _pregenerated.load(std::memory_order_relaxed); }
+
+    // Call every server tick from the ENet thread. Finished chunks join
+    // each client's outbound list; as much of it as the peer's Outbox
+    // budget has room for is handed over, nearest the player first.
+    void flushReady(Outbox& out);
+
+    // flushReady's lists of the moment — the batch taken off the workers,
+    // the edits, the picks for idle pregeneration — come out of arena from
+    // then on, rather than the heap; the caller resets it after the flush.
+    // The ENet thread's, like flushReady.
+    void useTickArena(TickArena& arena) { _tick = &arena; }
 
     float findSpawnY(float wx, float wz);
 
+    // Some job is queued or running — results will show up in flushReady.
+    // Chunks waiting on a budget don't count: the tick slots wake the loop
+    // often enough to keep a bucket drained.
+    bool busy() const { return !_inFlight.empty(); }
+    size_t inFlight() const { return _inFlight.size(); }
+
+    ChunkCache::Stats cacheStats() { return _cache.stats(); }
+
+    // Chunks run through generateChunk, and how many of those the uniform
+    // air/solid fast path answered without cave noise or marching; LOD
+    // cells are counted in both and on their own
+    uint64_t generatedCount() const { return _generated.load(std::memory_order_relaxed); }
+    uint64_t uniformCount()   const { return _uniform.load(std::memory_order_relaxed); }
+    uint64_t lodCount()       const { return _lodCells.load(std::memory_order_relaxed); }
+    // Chunks and LOD cells the chunkgen service generated for this process
+    uint64_t remoteCount()    const { return _remoteGen.load(std::memory_order_relaxed); }
+    // Chunks and LOD cells taken from the SharedChunkCache
+    uint64_t sharedCount()    const { return _sharedHits.load(std::memory_order_relaxed); }
+    std::optional<SharedChunkCache::Stats> sharedStats() const {
+        return _shared ? std::optional(_shared->stats()) : std::nullopt;
+    }
+    // Chunks answered with a ChunkCached rather than their bytes
+    uint64_t cachedCount()    const { return _sentCached.load(std::memory_order_relaxed); }
+    // Jobs queued ahead of a moving player's view, and those called off
+    // again by a turn before any worker had them
+    uint64_t prefetchCount()       const { return _prefetched.load(std::memory_order_relaxed); }
+    uint64_t prefetchCancelCount() const { return _prefetchCancelled.load(std::memory_order_relaxed); }
+
+    // Generation workers running now / allowed, and each one's busy fraction
+    // since the previous call
+    int                genThreads()    const { return _pool.threadCount(); }
+    int                genThreadsMax() const { return _pool.maxThreads(); }
+    std::vector<float> genUtilization()      { return _pool.sampleUtilization(); }
+    int                genPending()    const { return _pool.pending(); }
+
+    // ── Terrain queries ───────────────────────────────────────────────────────
+    // Collision against the density field, for checking moves and for
+    // anything the server simulates. A chunk's densities are decoded on
+    // first touch from the cache or region store, and kept (DENSITY_CACHE_MB)
+    // until evicted or an edit to the chunk lands. One that isn't generated
+    // yet reads as air, and is looked for again next tick. ENet thread.
+    const TerrainQuery& terrain() const { return _terrain; }
+    DensityCache::Stats densityStats() const { return _densities.stats(); }
+
+    // ── Terrain edits ─────────────────────────────────────────────────────────
+    // Applies an edit to every full-resolution chunk it reaches, the
+    // neighbours sharing a border layer included. Each chunk's edits run in
+    // order on the pool, one job at a time, after any generation job that's
+    // already in flight for it: load the field, apply, persist, and re-march
+    // only the slabs the edit reached. The result bumps the chunk's version
+    // and goes out, as a ChunkUpdate, to every client that has the chunk or
+    // is waiting for it. ENet thread.
+    void editTerrain(const TerrainEdit& edit);
+
+    uint64_t editCount() const { return _editsApplied.load(std::memory_order_relaxed); }
+
+    // Chunks edited lately are kept decoded between edits as ResidentChunks,
+    // within RESIDENT_CHUNK_MB, so digging at one spot doesn't decode (or,
+    // for uniform rock, re-decorate) its chunks on every stroke
+    struct ResidentStats {
+        size_t entries = 0, bytes = 0;
+    };
+    ResidentStats residentStats() {
+        std::lock_guard lk(_residentMu);
+        return {_resident.size(), _residentBytes};
+    }
+
+    // Seconds per generation stage on this process's workers (see chunk_gen.h)
+    using GenTimings = ::GenTimings;
+    const GenTimings& genTimings() const { return _timings; }
+
+    // The region files, for WorldBackup to freeze
+    RegionStore& regions() { return _regions; }
+
 private:
-    ThreadPool _pool;
+    ChunkCache  _cache;
+    RegionStore _regions;
+
+    // Terrain queries, on the ENet thread. Coords found nowhere are noted
+    // until the next flushReady, so a query loop doesn't look for them per
+    // sample.
+    DensityCache                       _densities{Config::DENSITY_CACHE_MB << 20};
+    FlatSet<ChunkCoord, ChunkCoordHash> _densityMissing;
+    TerrainQuery                       _terrain{[this](ChunkCoord c) { return densityOf(c); }};
+
+    std::mutex              _readyMu;
+    std::vector<ReadyChunk> _ready;
 
-    std::mutex _cacheMu;
-    std::unordered_map<ChunkCoord, std::vector<uint8_t>, ChunkCoordHash> _cache;
+    TickArena* _tick = nullptr; // useTickArena
 
-    std::mutex _readyMu;
-    std::queue<ReadyChunk> _ready;
+    PlayerRegistry& _players; // each client's ClientState
 
-    std::vector<ClientState> _clients;
+    std::unordered_map<ChunkKey, InFlightChunk, ChunkKeyHash> _inFlight;
+
+    // Jobs waiting for a worker. A key is in _queued until a worker picks it
+    // up; removing it cancels the job.
+    std::mutex _jobMu;
+    std::priority_queue<GenJob, std::vector<GenJob>, std::greater<GenJob>> _jobHeap;
+    struct QueuedJob {
+        uint32_t    stamp;    // live heap entry
+        bool        needMesh; // some subscriber can't mesh locally
+        CancelToken meshCancel;
+        int64_t     queuedUs = 0; // while tracing
+    };
+    std::unordered_map<ChunkKey, QueuedJob, ChunkKeyHash> _queued;
+    uint32_t _nextStamp = 0;
+
+    // Edited chunks, on the ENet thread. version counts the edit jobs
+    // started; sent is the version whose payload is in the cache, stamped
+    // on every send. Entries stay for the session so versions never repeat.
+    struct EditedChunk {
+        std::vector<TerrainEdit> queued;   // waiting for the running job or a generation job
+        std::vector<ENetPeer*>   waiters;  // asked for the chunk while a job was running
+        uint32_t                 version = 0;
+        uint32_t                 sent    = 0;
+        bool                     running = false;
+        bool                     deferred = false; // in _editsDeferred
+    };
+    std::unordered_map<ChunkCoord, EditedChunk, ChunkCoordHash> _edits;
+    std::vector<ChunkCoord> _editsDeferred; // have queued edits behind a generation job
+
+    // Finished edit jobs, under _readyMu
+    struct EditResult {
+        ChunkCoord    coord;
+        uint32_t      version;
+        ChunkPayloads bytes;
+        bool          changed; // false: the edits missed every sample
+    };
+    std::vector<EditResult> _editsDone;
+
+    // Slab meshes of recently edited chunks, so the next edit re-marches
+    // only the slabs it reaches. A chunk's edit jobs never overlap, so an
+    // entry is only ever in one worker's hands.
+    using EditSlabs = std::shared_ptr<std::vector<ChunkMesh>>;
+    std::mutex                                                _editSlabMu;
+    std::unordered_map<ChunkCoord, EditSlabs, ChunkCoordHash> _editSlabs;
+    std::deque<ChunkCoord>                                    _editSlabOrder; // oldest first
+
+    // Edited chunks as the last edit left them, the same way; by bytes
+    using Resident = std::unique_ptr<ResidentChunk>;
+    std::mutex                                                _residentMu;
+    std::unordered_map<ChunkCoord, Resident, ChunkCoordHash>  _resident;
+    std::deque<ChunkCoord>                                    _residentOrder; // oldest first
+    size_t                                                    _residentBytes = 0;
+
+    std::atomic<uint64_t> _editsApplied{0};
+    std::atomic<uint64_t> _generated{0};
+    std::atomic<uint64_t> _uniform{0};
+    std::atomic<uint64_t> _lodCells{0};
+    std::atomic<uint64_t> _sentCached{0};
+    std::atomic<uint64_t> _prefetched{0}, _prefetchCancelled{0};
+
+    std::function<std::chrono::steady_clock::time_point()> _now = std::chrono::steady_clock::now;
+    GenTimings            _timings;
+
+    // Scratch for split jobs, whose buffers pass between workers
+    ScratchPool<ChunkData>              _splitData;
+    ScratchPool<std::vector<ChunkMesh>> _splitSlabs;
+
+    // Jobs handed to the chunkgen service, by key, until their result is
+    // in or the link hands them back. Set from workers, taken in flushReady.
+    struct RemoteJob {
+        bool        needMesh;
+        CancelToken meshCancel;
+    };
+    std::unique_ptr<ChunkGenLink>                         _remote;
+    std::mutex                                            _remoteMu;
+    std::unordered_map<ChunkKey, RemoteJob, ChunkKeyHash> _remoteJobs;
+    std::vector<ChunkGenLink::Result>                     _remoteDone; // flushReady scratch
+    std::vector<ChunkKey>                                 _remoteLost;
+    std::atomic<uint64_t>                                 _remoteGen{0};
+
+    std::unique_ptr<SharedChunkCache> _shared;
+    std::atomic<uint64_t>             _sharedHits{0};
+
+    // Compression (useCompression); set before any worker packs
+    std::string                      _worldDir;
+    std::shared_ptr<const ChunkDict> _dict;
+    ChunkPayload                     _dictPacket;
+    std::atomic<uint64_t>            _packed{0}, _packRaw{0}, _packOut{0}, _packSkipped{0};
+
+    // Background pregeneration state, on the ENet thread (setIdlePregen).
+    // ring and index walk the square rings around centre; seen holds the
+    // columns (y = 0) handed out, so a player path never repeats them.
+    struct IdlePregen {
+        ChunkCoord                          center;
+        int                                 radius = 0, ring = 0, index = 0;
+        FlatSet<ChunkCoord, ChunkCoordHash> seen;
+    };
+    std::unique_ptr<IdlePregen> _idlePregen;
+    std::atomic<int>            _pregenRunning{0};
+    std::atomic<uint64_t>       _pregenerated{0};
+
+    // Declared last: workers touch everything above, so the pool must drain
+    // and join before any of it is destroyed
+    ThreadPool _pool;
 
     ClientState* findClient(ENetPeer* peer);
-    void         scheduleChunk(ClientState& cs, ChunkCoord coord);
-    void         generateAndEnqueue(ENetPeer* peer, ChunkCoord coord);
+    void         scheduleChunk(ClientState& cs, const ChunkKey& key);
+    void         unsubscribe  (ENetPeer* peer, const ChunkKey& key);
+    void         refreshPrefetch(ClientState& cs);
+    void         prefetchChunk(ClientState& cs, const ChunkKey& key);
+    void         dropPrefetch (ENetPeer* peer, const ChunkKey& key);
+    float        jobPriority  (const ChunkKey& key, const InFlightChunk& job);
+    void         queueJob     (const ChunkKey& key, float priority, bool needMesh,
+                               CancelToken meshCancel);
+    bool         requeueJob   (const ChunkKey& key, float priority, bool needMesh = false);
+    bool         cancelJob    (const ChunkKey& key);
+    void         runNextJob();
+    void         moveView(ClientState& cs, ChunkCoord center);
+    void         unpinView(const ClientState& cs);
+    void         streamOutbound(ClientState& cs, Outbox& out);
+    void         dropOutbound(ClientState& cs);
+    void         generateAndEnqueue(const ChunkKey& key, bool needMesh, CancelToken meshCancel,
+                                    bool split);
+    void         generateSplit(const ChunkKey& key, ChunkPayloads out, bool needMesh,
+                               CancelToken meshCancel);
+    ChunkPayload generateField(const ChunkKey& key);
+    ChunkPayload storeField(ChunkCoord coord, const ChunkData& data);
+    ChunkPayload fromShared(const ChunkKey& key);
+    int          pregenColumn(int cx, int cz, bool cache);
+    void         pregenIdle();
+    const DensityField* densityOf(ChunkCoord coord);
+    bool         offload(const ChunkKey& key, bool needMesh, CancelToken& meshCancel);
+    void         serviceRemote();
+    void         remoteReady(const ChunkKey& key, ChunkPayloads bytes, bool needMesh,
+                             CancelToken meshCancel);
+    void         fieldReady(const ChunkKey& key, ChunkPayloads out, bool needMesh,
+                            CancelToken meshCancel, bool split);
+    void         marchSplit(const ChunkKey& key, ChunkPayload field, CancelToken meshCancel);
+    void         generateLod(const ChunkKey& key);
+    void         enqueueReady(const ChunkKey& key, ChunkPayloads bytes, bool partial);
+    void         pack(const ChunkKey& key, ChunkPayloads& bytes);
+    void         startEdit(ChunkCoord coord);
+    void         runEdit(ChunkCoord coord, std::vector<TerrainEdit> edits, uint32_t version,
+                         bool needMesh);
+    ChunkPayload remeshEdit(const ChunkData& data, const EditBox& box);
+    void         deliverEdit(EditResult& r);
+    ChunkPayload versioned(const ChunkKey& key, const ChunkPayload& bytes);
+    void         dropQueued(ClientState& cs, const ChunkKey& key);
+    bool         offerCached(ClientState& cs, const ChunkKey& key, const ChunkPayload& bytes,
+                             std::optional<uint64_t>& hash);
+    ENetPacket*  cachedPacket(ChunkCoord coord, uint32_t version, uint64_t hash);
+    EditSlabs    takeEditSlabs(ChunkCoord coord);
+    void         keepEditSlabs(ChunkCoord coord, EditSlabs slabs);
+    Resident     takeResident(ChunkCoord coord);
+    void         keepResident(Resident chunk);
 };
@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <enet/enet.h>
+#include "chunk.h"
+#include "chunk_cache.h"
+#include "chunkgen_packets.h"
+
+// ── ChunkGenLink ──────────────────────────────────────────────────────────────
+// A game server's connection to the chunkgen service: an ENet client host of
+// its own, opened with a ChunkGenHello and retried every
+// CHUNKGEN_RECONNECT_MS while it's down. A service that answers with another
+// world id is never asked anything, and never retried.
+//
+// Workers hand it keys from any thread; service(), from ChunkManager's
+// flushReady, sends what was handed over since as one batch and hands back
+// whatever results arrived. A key is outstanding from request() until its
+// result comes back, or the link drops — then it's handed back as lost, to
+// be generated locally after all.
+class ChunkGenLink {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Result {
+        ChunkKey      key;
+        ChunkPayloads bytes; // either may be null, if the service had nothing
+    };
+
+    // Throws if the client host can't be created
+    ChunkGenLink(std::string host, uint16_t port, uint32_t world);
+    ~ChunkGenLink();
+
+    ChunkGenLink(const ChunkGenLink&)            = delete;
+    ChunkGenLink& operator=(const ChunkGenLink&) = delete;
+
+    // Any thread. False while the link is down, or CHUNKGEN_OUTSTANDING_MAX
+    // keys are out already: generate it here.
+    bool request(const ChunkKey& key, bool mesh);
+
+    // Connects what's down, sends the batch, collects results. Appends to
+    // done and lost; one thread only.
+    void service(std::vector<Result>& done, std::vector<ChunkKey>& lost);
+
+    bool up() const { return _up.load(std::memory_order_relaxed); }
+
+private:
+    void receive(const uint8_t* d, size_t len, std::vector<Result>& done);
+    void dropped(std::vector<ChunkKey>& lost);
+
+    std::string       _hostName;
+    uint16_t          _port;
+    uint32_t          _world;
+    ENetHost*         _host = nullptr;
+    ENetPeer*         _peer = nullptr;
+    bool              _refused = false; // another world: given up on
+    Clock::time_point _retryAt{};
+    std::atomic<bool> _up{false};       // connected, and the hello matched
+    PacketWriter      _out;
+
+    std::mutex                                     _mu;
+    std::vector<ChunkGenRequestPacket::Entry>      _batch;       // not sent yet
+    std::unordered_set<ChunkKey, ChunkKeyHash>     _outstanding; // batched or sent
+};
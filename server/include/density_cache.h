@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include "chunk.h"
+#include "flat_map.h"
+#include "terrain_query.h"
+
+// Decoded densities of the chunks terrain queries last touched, bounded by a
+// byte budget and evicted least recently used first. What's cached is
+// pristine or edited — whatever the chunk cache or region store had when it
+// was decoded; ChunkManager drops an entry whenever an edit lands.
+// One thread only: ChunkManager's, the ENet thread.
+class DensityCache {
+public:
+    struct Stats {
+        uint64_t hits = 0, misses = 0, evictions = 0;
+        size_t   entries = 0, bytes = 0, budget = 0;
+    };
+
+    explicit DensityCache(size_t budgetBytes) : _budget(budgetBytes) {}
+
+    // nullptr on miss. Valid until evicted: whatever a query has just
+    // touched is the most recent, so it outlasts the query.
+    const DensityField* find(ChunkCoord c) {
+        auto it = _entries.find(c);
+        if (it == _entries.end()) {
+            _misses++;
+            return nullptr;
+        }
+        _hits++;
+        _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+        return it->second.field.get();
+    }
+
+    const DensityField* put(std::unique_ptr<DensityField> field) {
+        ChunkCoord c = field->coord;
+        erase(c);
+        _bytes += field->bytes();
+        _lru.push_front(c);
+        const DensityField* p = field.get();
+        _entries.try_emplace(c, Entry{std::move(field), _lru.begin()});
+        // The newest entry stays, even over budget
+        while (_bytes > _budget && _lru.size() > 1) {
+            ChunkCoord victim = _lru.back();
+            _lru.pop_back();
+            auto it = _entries.find(victim);
+            _bytes -= it->second.field->bytes();
+            _entries.erase(it);
+            _evictions++;
+        }
+        return p;
+    }
+
+    void erase(ChunkCoord c) {
+        auto it = _entries.find(c);
+        if (it == _entries.end()) return;
+        _bytes -= it->second.field->bytes();
+        _lru.erase(it->second.lruIt);
+        _entries.erase(it);
+    }
+
+    Stats stats() const { return {_hits, _misses, _evictions, _entries.size(), _bytes, _budget}; }
+
+private:
+    struct Entry {
+        std::unique_ptr<DensityField> field;
+        std::list<ChunkCoord>::iterator lruIt;
+    };
+
+    size_t _budget;
+    size_t _bytes = 0;
+    FlatMap<ChunkCoord, Entry, ChunkCoordHash> _entries;
+    std::list<ChunkCoord> _lru; // front = most recent
+
+    uint64_t _hits = 0, _misses = 0, _evictions = 0;
+};
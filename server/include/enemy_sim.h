@@ -0,0 +1,449 @@
+#pragma once
+#include <enet/enet.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/geometric.hpp>
+#include "combat.h"
+#include "config.h"
+#include "interest_grid.h"
+#include "mp_packets.h"
+#include "outbox.h"
+#include "sim_regions.h"
+
+// Server-authoritative enemies, built from the same combat.h components the
+// client's CombatSystem uses. Stepped from a fixed-rate tick slot with AI
+// LOD by distance to the nearest player and a time budget for the coarse
+// levels (see Config::ENEMY_*); replicated with the same InterestGrid
+// rule as player positions. Enemies only ever touch players, so a tick
+// splits into SimRegions by their nearest player's island and steps in
+// parallel, the hits they land applied afterwards on the ticking thread.
+// Parries and dodges are timed here too, from what the clients report, and
+// a hit has to get past them, as in CombatSystem, before it does damage.
+struct SimEnemy {
+    uint32_t  id = 0;
+    glm::vec3 pos{0.f};
+    glm::vec3 half{0.5f};
+    CHealth   hp{60.f, 60.f};
+    CAttack   atk;
+    CEnemy    ai;
+    CFacing   facing;
+    uint16_t  every = 1; // LOD: ticks per step
+    uint16_t  owed  = 0; // ticks since last step
+    float     respawnTimer = 0.f;
+};
+
+class EnemySim {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // A player enemies can chase, hit and be seen by
+    struct Target {
+        ENetPeer* peer;
+        glm::vec3 pos;
+    };
+
+    struct Stats {
+        uint64_t ticks    = 0;
+        uint64_t steps    = 0;
+        uint64_t deferred = 0; // coarse steps pushed to a later tick by the budget
+        uint32_t regions  = 0; // most in one tick
+        float    worstMs  = 0.f;
+    };
+
+    // Longest single step a deferred or far enemy takes, so a long wait
+    // doesn't turn into one huge move
+    static constexpr float MAX_STEP_S = 0.5f;
+    // Invincibility after a parry, and after a hit that lands; the client's
+    static constexpr float PARRY_IFRAMES_S = 0.5f;
+    static constexpr float HIT_IFRAMES_S   = 0.3f;
+    // How much sooner than its cooldown a client's next move may arrive,
+    // for jitter in its packets and the tick the clock moves in
+    static constexpr float SLACK_S = 0.1f;
+
+    explicit EnemySim(Outbox& out) : _out(out) {}
+
+    uint32_t spawn(glm::vec3 pos) {
+        SimEnemy& e = _enemies.emplace_back();
+        e.id = (uint32_t)_enemies.size(); // ids are index + 1, enemies are never erased
+        e.pos = pos;
+        e.ai.patrolOrigin = pos;
+        // Spread the coarse levels' steps over ticks
+        e.owed = (uint16_t)(e.id % Config::ENEMY_LOD_FAR_EVERY);
+        return e.id;
+    }
+
+    bool   empty() const { return _enemies.empty(); }
+    size_t size()  const { return _enemies.size(); }
+
+    // One fixed step. Full-rate enemies always run; coarse ones resume from
+    // where the last tick's budget ran out, each region against the same
+    // deadline. onHit(peer, damage) for every enemy attack that lands on a
+    // target, once every region is done, in region order.
+    template<class OnHit>
+    void tick(float dt, const std::vector<Target>& targets, SimRegions& regions, OnHit&& onHit) {
+        auto start = Clock::now();
+        auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<float, std::milli>(Config::ENEMY_TICK_BUDGET_MS));
+        _stats.ticks++;
+        _time += dt;
+        size_t n = _enemies.size();
+        if (n == 0) return;
+
+        regions.partition(targets.size(), [&](size_t i) { return targets[i].pos; });
+        uint32_t islands = regions.islands();
+        _islandTargets.resize(islands + 1); // the last for enemies with nobody to chase
+        for (auto& t : _islandTargets) t.clear();
+        for (size_t i = 0; i < targets.size(); i++) _islandTargets[regions.island(i)].push_back(targets[i]);
+
+        // Each enemy's island, by its nearest target; that can only change
+        // through its own step, so it holds for the tick
+        _home.resize(n);
+        size_t batch = (size_t)Config::SIM_REGION_ENEMIES;
+        regions.run((n + batch - 1) / batch, [&](size_t b) {
+            for (size_t i = b * batch; i < std::min(n, (b + 1) * batch); i++) {
+                _enemies[i].owed++;
+                const Target* t = nearest(_enemies[i], targets);
+                _home[i] = t ? regions.island((size_t)(t - targets.data())) : islands;
+            }
+        });
+
+        // Bucketed by island, each in order from the cursor, then cut into
+        // regions
+        _count.assign(islands + 2, 0u);
+        for (uint32_t h : _home) _count[h + 1]++;
+        for (uint32_t k = 1; k <= islands + 1; k++) _count[k] += _count[k - 1];
+        _order.resize(n);
+        for (size_t k = 0; k < n; k++) {
+            size_t i = (_cursor + k) % n;
+            _order[_count[_home[i]]++] = {(uint32_t)i, (uint32_t)k};
+        }
+        size_t used = 0;
+        for (uint32_t isl = 0, begin = 0; isl <= islands; isl++) {
+            uint32_t end = _count[isl];
+            for (uint32_t b = begin; b < end; b += (uint32_t)batch) {
+                if (used == _regions.size()) _regions.emplace_back();
+                Region& g = _regions[used++];
+                g.island = isl;
+                g.begin  = b;
+                g.end    = std::min(end, b + (uint32_t)batch);
+            }
+            begin = end;
+        }
+
+        regions.run(used, [&](size_t r) { stepRegion(_regions[r], dt, deadline); });
+
+        // The exchange: what crossed over, in region order
+        size_t firstDeferred = n;
+        for (size_t r = 0; r < used; r++) {
+            Region& g = _regions[r];
+            for (const Hit& h : g.hits)
+                if (lands(h.peer)) onHit(h.peer, h.damage);
+            _stats.steps    += g.steps;
+            _stats.deferred += g.deferred;
+            firstDeferred = std::min(firstDeferred, g.firstDeferred);
+        }
+        if (firstDeferred < n) _cursor = (_cursor + firstDeferred) % n;
+        _stats.regions = std::max(_stats.regions, (uint32_t)used);
+
+        _stats.worstMs = std::max(_stats.worstMs,
+            std::chrono::duration<float, std::milli>(Clock::now() - start).count());
+    }
+
+    // A client's claim that its swing hit enemyId. Damage comes from the
+    // move; the claim is dropped if the attacker isn't within reach, or
+    // comes sooner than the move allows: one swing hits each enemy once,
+    // and the next can't start until startup, active and recovery are over.
+    void applyHit(ENetPeer* attacker, const EnemyHitPacket& hit, glm::vec3 attackerPos) {
+        if (hit.enemyId == 0 || hit.enemyId > _enemies.size()) return;
+        SimEnemy& e = _enemies[hit.enemyId - 1];
+        if (e.hp.dead) return;
+
+        const AttackData& move = hit.move == EnemyHitPacket::Heavy ? SwordMoves::HEAVY : SwordMoves::LIGHT;
+        float reach = glm::length(move.hitboxOffset) + glm::length(move.hitboxHalf) +
+                      glm::length(e.half) + Config::PLAYER_WIDTH + 1.f; // 1 m for latency
+        if (glm::length(e.pos - attackerPos) > reach) return;
+
+        Guard& gd = _guards[attacker];
+        if (_time <= gd.swingLive + SLACK_S) {
+            // Still the swing that's live: another enemy, or nothing
+            if (std::find(gd.swingHits.begin(), gd.swingHits.end(), hit.enemyId) != gd.swingHits.end()) return;
+        } else if (_time + SLACK_S < gd.swingDone) {
+            return;
+        } else {
+            gd.swingLive = _time + move.active;
+            gd.swingDone = _time + move.startup + move.active + move.recovery;
+            gd.swingHits.clear();
+        }
+        gd.swingHits.push_back(hit.enemyId);
+
+        glm::vec3 dir{hit.dirX, 0.f, hit.dirZ};
+        float len = glm::length(dir);
+        if (len > 0.001f) e.ai.knockbackVel = dir / len * move.knockback;
+
+        e.hp.current -= move.damage;
+        if (e.ai.ai == CEnemy::AIState::Patrol) e.ai.ai = CEnemy::AIState::Aggro;
+        if (e.hp.current <= 0.f) {
+            e.hp.current   = 0.f;
+            e.hp.dead      = true;
+            e.ai.ai        = CEnemy::AIState::Dead;
+            e.atk          = {};
+            e.respawnTimer = Config::ENEMY_RESPAWN_S;
+        }
+        // Hit enemies step at full rate until their next LOD check
+        e.every = 1;
+    }
+
+    // A client's parry or dodge, timed from now; dropped while the last
+    // one is still cooling down
+    void applyDefend(ENetPeer* peer, const PlayerDefendPacket& def) {
+        Guard& gd = _guards[peer];
+        if (def.kind == PlayerDefendPacket::Parry) {
+            if (_time + SLACK_S < gd.parryReady) return;
+            gd.parryUntil = _time + CParry::WINDOW;
+            gd.parryReady = gd.parryUntil + CParry::COOLDOWN;
+        } else {
+            if (_time + SLACK_S < gd.dodgeReady) return;
+            gd.dodgeUntil = _time + CDodge::IFRAMES;
+            gd.dodgeReady = _time + CDodge::DURATION + CDodge::COOLDOWN;
+        }
+    }
+
+    void forget(ENetPeer* peer) { _guards.erase(peer); }
+
+    // Call at ENEMY_BROADCAST_HZ. Each target hears about the enemies in its
+    // interest range.
+    void broadcast(const std::vector<Target>& targets) {
+        if (targets.empty() || _enemies.empty()) return;
+        _broadcastTick++;
+
+        _grid.clear();
+        for (const SimEnemy& e : _enemies) _grid.add(e.pos, e.id, &e);
+
+        for (const Target& t : targets) {
+            _batch.enemies.clear();
+            _grid.forEach(t.pos, _broadcastTick, [&](const SimEnemy* e) {
+                _batch.enemies.push_back({e->id, e->pos.x, e->pos.y, e->pos.z, (uint8_t)e->ai.ai,
+                    (uint8_t)std::lround(std::clamp(e->hp.current / e->hp.max, 0.f, 1.f) * 255.f)});
+            });
+            if (_batch.enemies.empty()) continue;
+            _batch.write(_writer);
+            _out.movement(t.peer, _writer.data(), _writer.size());
+        }
+    }
+
+    // Snapshot and reset the worst tick time
+    Stats takeStats() {
+        Stats s = _stats;
+        _stats.worstMs = 0.f;
+        _stats.regions = 0;
+        return s;
+    }
+
+private:
+    static constexpr float WALK_SPEED = 3.5f; // matches the client's CombatSystem
+
+    struct Hit {
+        ENetPeer* peer;
+        float     damage;
+    };
+
+    // A player's moves, in sim time. The swing is their own latest; the
+    // rest is what stands between them and an enemy's hit.
+    struct Guard {
+        double swingLive = -1e9, swingDone = -1e9; // its active window ends, and recovery
+        std::vector<uint32_t> swingHits;           // enemies it has hit
+        double parryUntil = -1e9, parryReady = -1e9;
+        double dodgeUntil = -1e9, dodgeReady = -1e9; // the I-frames end, and the cooldown
+        double immuneUntil = -1e9;
+    };
+
+    // Whether an enemy's hit on peer does damage, on the ticking thread:
+    // not through I-frames, and a parry takes it instead, as on the client
+    bool lands(ENetPeer* peer) {
+        Guard& gd = _guards[peer];
+        if (_time < gd.immuneUntil || _time < gd.dodgeUntil) return false;
+        if (_time < gd.parryUntil) {
+            gd.parryUntil  = _time;
+            gd.parryReady  = _time + CParry::COOLDOWN;
+            gd.immuneUntil = _time + PARRY_IFRAMES_S;
+            return false;
+        }
+        gd.immuneUntil = _time + HIT_IFRAMES_S;
+        return true;
+    }
+
+    // Some of one island's enemies: _order[begin, end), and what stepping
+    // them did. Kept between ticks for the hits' capacity.
+    struct Region {
+        uint32_t         island = 0, begin = 0, end = 0;
+        uint64_t         steps = 0, deferred = 0;
+        size_t           firstDeferred = 0; // from the cursor; past the last if none
+        std::vector<Hit> hits;
+    };
+
+    struct Slot {
+        uint32_t enemy; // index
+        uint32_t k;     // from the cursor
+    };
+
+    static const Target* nearest(const SimEnemy& e, const std::vector<Target>& targets) {
+        const Target* best = nullptr;
+        float bestD2 = 1e30f;
+        for (const Target& t : targets) {
+            glm::vec3 d = t.pos - e.pos;
+            float d2 = glm::dot(d, d);
+            if (d2 < bestD2) { bestD2 = d2; best = &t; }
+        }
+        return best;
+    }
+
+    // On whichever thread run() hands it; touches only its own enemies
+    void stepRegion(Region& g, float dt, Clock::time_point deadline) {
+        const std::vector<Target>& targets = _islandTargets[g.island];
+        g.steps = g.deferred = 0;
+        g.firstDeferred = _enemies.size();
+        g.hits.clear();
+
+        for (uint32_t s = g.begin; s < g.end; s++) {
+            SimEnemy& e = _enemies[_order[s].enemy];
+            if (e.every == 1) step(e, dt, targets, g);
+        }
+        for (uint32_t s = g.begin; s < g.end; s++) {
+            SimEnemy& e = _enemies[_order[s].enemy];
+            if (e.every == 1 || e.owed < e.every) continue;
+            if (((s - g.begin) & 31) == 0 && Clock::now() >= deadline) {
+                for (uint32_t j = s; j < g.end; j++) {
+                    const SimEnemy& d = _enemies[_order[j].enemy];
+                    if (d.every != 1 && d.owed >= d.every) g.deferred++;
+                }
+                g.firstDeferred = _order[s].k;
+                break;
+            }
+            step(e, std::min(e.owed * dt, MAX_STEP_S), targets, g);
+        }
+    }
+
+    void step(SimEnemy& e, float dt, const std::vector<Target>& targets, Region& g) {
+        e.owed = 0;
+        g.steps++;
+
+        const Target* nearest = EnemySim::nearest(e, targets);
+        float dist = nearest ? glm::length(nearest->pos - e.pos) : 1e15f;
+        e.every = dist < Config::ENEMY_LOD_NEAR ? 1
+                : dist < Config::ENEMY_LOD_FAR  ? Config::ENEMY_LOD_MID_EVERY
+                :                                 Config::ENEMY_LOD_FAR_EVERY;
+
+        if (e.hp.dead) {
+            e.respawnTimer -= dt;
+            if (e.respawnTimer <= 0.f) {
+                e.pos = e.ai.patrolOrigin;
+                e.hp  = {e.hp.max, e.hp.max};
+                e.ai  = CEnemy{.patrolOrigin = e.ai.patrolOrigin};
+            }
+            return;
+        }
+
+        tickAttack(e, dt, targets, g);
+
+        glm::vec3 vel{0.f};
+        if (nearest) {
+            switch (e.ai.ai) {
+            case CEnemy::AIState::Patrol:
+                if (dist < e.ai.aggroRange) e.ai.ai = CEnemy::AIState::Aggro;
+                break;
+
+            case CEnemy::AIState::Aggro:
+                if (dist > e.ai.aggroRange * 1.5f) { e.ai.ai = CEnemy::AIState::Patrol; break; }
+                if (dist > 0.01f) vel = (nearest->pos - e.pos) / dist * WALK_SPEED;
+                if (dist < e.ai.attackRange) e.ai.ai = CEnemy::AIState::Attack;
+                break;
+
+            case CEnemy::AIState::Attack:
+                if (dist > e.ai.attackRange * 1.5f) { e.ai.ai = CEnemy::AIState::Aggro; break; }
+                e.ai.attackTimer -= dt;
+                if (e.ai.attackTimer <= 0.f && e.atk.isIdle() && dist > 0.01f) {
+                    e.ai.attackTimer = e.ai.attackCooldown;
+                    e.facing.dir = (nearest->pos - e.pos) / dist;
+                    e.atk.data   = &SwordMoves::LIGHT;
+                    e.atk.state  = CAttack::State::Startup;
+                    e.atk.timer  = SwordMoves::LIGHT.startup;
+                }
+                break;
+
+            default:
+                break;
+            }
+        } else if (e.ai.ai != CEnemy::AIState::Patrol) {
+            e.ai.ai = CEnemy::AIState::Patrol; // nobody left to chase
+        }
+
+        e.pos += vel * dt;
+        if (glm::length(e.ai.knockbackVel) >= 0.01f) {
+            e.pos += e.ai.knockbackVel * dt;
+            e.ai.knockbackVel *= std::max(0.f, 1.f - 10.f * dt); // friction
+        }
+    }
+
+    void tickAttack(SimEnemy& e, float dt, const std::vector<Target>& targets, Region& g) {
+        CAttack& atk = e.atk;
+        if (atk.isIdle()) return;
+        atk.timer -= dt;
+        if (atk.timer > 0.f) return;
+
+        switch (atk.state) {
+        case CAttack::State::Startup: {
+            atk.state = CAttack::State::Active;
+            atk.timer = atk.data->active;
+
+            // Same yaw-only hitbox placement as CombatSystem::emitHitbox
+            glm::vec3 f = e.facing.dir;
+            float yaw = std::atan2(-f.x, -f.z);
+            float cy = std::cos(yaw), sy = std::sin(yaw);
+            glm::vec3 off = atk.data->hitboxOffset;
+            glm::vec3 centre = e.pos + glm::vec3{off.x * cy + off.z * sy, off.y, -off.x * sy + off.z * cy};
+            glm::vec3 mn = centre - atk.data->hitboxHalf, mx = centre + atk.data->hitboxHalf;
+
+            glm::vec3 ph{Config::PLAYER_WIDTH * 0.5f, Config::PLAYER_HEIGHT * 0.5f, Config::PLAYER_WIDTH * 0.5f};
+            // Parries and I-frames are for lands(), once the regions are done
+            for (const Target& t : targets) {
+                glm::vec3 pmn = t.pos - ph, pmx = t.pos + ph;
+                if (mn.x <= pmx.x && mx.x >= pmn.x &&
+                    mn.y <= pmx.y && mx.y >= pmn.y &&
+                    mn.z <= pmx.z && mx.z >= pmn.z)
+                    g.hits.push_back({t.peer, atk.data->damage});
+            }
+            break;
+        }
+        case CAttack::State::Active:
+            atk.state = CAttack::State::Recovery;
+            atk.timer = atk.data->recovery;
+            break;
+        case CAttack::State::Recovery:
+            atk = {};
+            break;
+        default: break;
+        }
+    }
+
+    Outbox&                        _out;
+    std::vector<SimEnemy>          _enemies;
+    size_t                         _cursor = 0;        // where the coarse pass resumes
+    double                         _time = 0.0;        // sim seconds, by tick
+    std::unordered_map<ENetPeer*, Guard> _guards;      // per player, once they move
+    // Per tick, kept for their capacity
+    std::vector<std::vector<Target>> _islandTargets;
+    std::vector<uint32_t>          _home;              // per enemy, its island
+    std::vector<uint32_t>          _count;             // per island, where its slots end
+    std::vector<Slot>              _order;             // by island, then from the cursor
+    std::vector<Region>            _regions;
+    uint32_t                       _broadcastTick = 0;
+    InterestGrid<const SimEnemy*>  _grid;              // rebuilt per broadcast
+    EnemySyncPacket                _batch;             // per-listener scratch
+    PacketWriter                   _writer;
+    Stats                          _stats;
+};
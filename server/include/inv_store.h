@@ -0,0 +1,115 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <glm/vec3.hpp>
+#include "inventory.h"
+
+// Persistent store for player inventories and chests: one append-only log
+// ("inventories.log") plus a compacted snapshot ("inventories.snap") under
+// the world directory.
+//
+// Record layout (host byte order):
+//   u32 body length | u32 FNV-1a of body | body
+//   body = u8 type | u64 id | payload
+// Both files start with magic 'AINV' and a version. On open the snapshot is
+// read, then the log replayed over it, latest record per key winning; a torn
+// record at the log's tail is cut off.
+//
+// put*() only replaces the in-memory copy and wakes the I/O thread, so the
+// simulation thread never touches the disk. The thread lets writes gather
+// for FLUSH_MS, so an inventory moved ten times in a burst is written once,
+// then appends the whole batch with one write and one fsync. Once the log
+// passes COMPACT_BYTES the full state goes to a fresh snapshot (written
+// aside, fsynced, renamed over the old one) and the log starts over.
+//
+// Payloads are immutable once put: a put replaces a key's pointer, never
+// the bytes behind it. So freeze() — everything put so far, for a backup —
+// copies the map and shares every payload with the live state; whatever is
+// put after it leaves the frozen copy as it was.
+class InvStore {
+public:
+    static constexpr const char* LOG_FILE      = "inventories.log";
+    static constexpr const char* SNAP_FILE     = "inventories.snap";
+    static constexpr uint32_t    MAGIC         = 0x564E4941; // "AINV"
+    static constexpr uint32_t    VERSION       = 1;
+    static constexpr int         FLUSH_MS      = 250;
+    static constexpr size_t      COMPACT_BYTES = 8u << 20;
+
+    struct StoredChest {
+        uint32_t  uid;
+        glm::vec3 pos;
+        Inventory inv;
+    };
+
+    explicit InvStore(std::string dir);
+    ~InvStore(); // writes anything pending, compacts, joins the I/O thread
+
+    InvStore(const InvStore&)            = delete;
+    InvStore& operator=(const InvStore&) = delete;
+
+    // Thread-safe; sees writes that haven't reached the disk yet
+    bool loadPlayer(uint64_t uid, Inventory& out);
+    std::vector<StoredChest> chests();
+    uint32_t nextUID(); // 0 if never stored
+
+    // Thread-safe, non-blocking
+    void putPlayer(uint64_t uid, const Inventory& inv);
+    void putChest(uint32_t uid, glm::vec3 pos, const Inventory& inv);
+    void putNextUID(uint32_t next);
+
+private:
+    enum class Rec : uint8_t { Player = 1, Chest = 2, Meta = 3 };
+    using Key   = std::pair<uint8_t, uint64_t>;  // {Rec, id}
+    using Bytes = std::vector<uint8_t>;          // record payload
+    using State = std::map<Key, std::shared_ptr<const Bytes>>;
+
+public:
+    using Frozen = State;
+    // Thread-safe. A copy of the state as of now — what the stores would
+    // hold once everything put so far has been written.
+    Frozen freeze();
+    // Writes state as a snapshot (SNAP_FILE's format; a store opened on a
+    // directory holding just that comes up with it): aside, fsynced and
+    // renamed over path. Any thread.
+    static bool writeSnapshot(const std::string& path, const Frozen& state);
+
+private:
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+    };
+
+    void put(Rec type, uint64_t id, Bytes payload);
+    void run();
+
+    // I/O thread (and the constructor, before it starts)
+    bool replay(const std::string& path, State& into, bool truncateTail);
+    bool appendBatch(const State& batch);
+    void compact();
+    bool openLog(bool truncate);
+
+    static void appendRecord(Bytes& out, const Key& k, const Bytes& payload);
+    static bool syncFile(FILE* f);
+
+    std::string _dir;
+    std::string _logPath, _snapPath;
+    FILE*       _log      = nullptr;
+    size_t      _logBytes = 0;
+
+    std::mutex              _mu;
+    std::condition_variable _cv;
+    State                   _state;   // latest copy of every key, durable or not
+    State                   _pending; // changed since the last batch was taken
+    bool                    _stop = false;
+
+    std::thread _io; // started last, joined in the destructor
+};
@@ -1,15 +1,19 @@
 #pragma once
 #include <enet/enet.h>
+#include <algorithm>
 #include <unordered_map>
+#include <vector>
 #include <glm/vec3.hpp>
 #include <glm/geometric.hpp>
 #include <cstdint>
 #include <string>
 #include <fstream>
-#include <filesystem>
+#include "chunk_index.h"
 #include "inventory.h"
 #include "inv_packets.h"
-#include "net_common.h"
+#include "inv_store.h"
+#include "outbox.h"
+#include "player_registry.h"
 #include "log.h"
 
 struct ServerChest {
@@ -30,69 +34,113 @@ class InventoryManager {
 public:
     static constexpr float       CHEST_INTERACT_RANGE = 3.5f;
     static constexpr float       CORPSE_LOOT_RANGE    = 3.5f;
-    static constexpr const char* CHEST_FILE           = "chests.dat";
-    static constexpr const char* PLAYER_INV_DIR       = "player_invs/";
-
-    InventoryManager() {
-        std::filesystem::create_directories(PLAYER_INV_DIR);
+    static constexpr float       LOOT_NOTIFY_RANGE    = 30.f;
+    // Pre-InvStore files, read once if the store doesn't have the data yet
+    static constexpr const char* LEGACY_CHEST_FILE    = "chests.dat";
+    static constexpr const char* LEGACY_PLAYER_INV_DIR = "player_invs/";
+
+    // Everything persists through an InvStore under worldDir; saves never
+    // block the caller. Each player's side is a component in players.
+    InventoryManager(const std::string& worldDir, Outbox& out, PlayerRegistry& players)
+        : _out(out), _players(players), _store(worldDir) {
         loadChests();
     }
-    ~InventoryManager() { saveChests(); }
+    InvStore& store() { return _store; } // for WorldBackup
 
     // ── Player lifecycle ──────────────────────────────────────────────────────
 
-    void onPlayerConnect(ENetPeer* peer, uint64_t uid) {
-        _playerUIDs[peer] = uid;
-        _playerInvs[peer] = loadPlayerInv(uid);
+    // What uid saved last time, or empty. Touches only the store and the
+    // legacy files, so it's safe off the main thread (SessionLoader).
+    Inventory loadPlayerInv(uint64_t uid) {
+        Inventory inv;
+        if (_store.loadPlayer(uid, inv)) return inv;
+        std::ifstream f(std::string(LEGACY_PLAYER_INV_DIR) + std::to_string(uid) + ".inv", std::ios::binary);
+        if (f) {
+            readLegacyInv(f, inv);
+            _store.putPlayer(uid, inv);
+        }
+        return inv;
     }
 
-    void onPlayerDisconnect(ENetPeer* peer) {
-        auto it = _playerUIDs.find(peer);
-        if (it != _playerUIDs.end()) {
-            savePlayerInv(it->second, _playerInvs[peer]);
-            _playerUIDs.erase(it);
+    // inv as loadPlayerInv(uid) read it
+    void onPlayerConnect(ENetPeer* peer, uint64_t uid, Inventory inv) {
+        if (PlayerInv* old = _players.get<PlayerInv>(peer)) release(peer, *old);
+        if (PlayerInv* me = _players.emplace<PlayerInv>(peer)) {
+            me->uid = uid;
+            me->inv = std::move(inv);
         }
-        _playerInvs.erase(peer);
-        _playerPos.erase(peer);
-        for (auto& [uid, chest] : _chests)
-            if (chest.lockedBy == peer) chest.lockedBy = nullptr;
+    }
+
+    void onPlayerDisconnect(ENetPeer* peer) {
+        PlayerInv* me = _players.get<PlayerInv>(peer);
+        if (!me) return;
+        _store.putPlayer(me->uid, me->inv);
+        release(peer, *me);
+        _players.erase<PlayerInv>(peer);
     }
 
     void onPlayerMove(ENetPeer* peer, glm::vec3 pos) {
-        _playerPos[peer] = pos;
-        for (auto& [uid, chest] : _chests) {
-            if (chest.lockedBy == peer &&
-                glm::length(pos - chest.pos) > CHEST_INTERACT_RANGE * 1.5f) {
+        PlayerInv* me = _players.get<PlayerInv>(peer);
+        if (!me) return;
+        if (!me->placed) _playerIndex.insert(peer, pos);
+        else             _playerIndex.move(peer, me->pos, pos);
+        me->placed = true;
+        me->pos    = pos;
+
+        auto& held = me->locks;
+        for (size_t i = 0; i < held.size();) {
+            ServerChest& chest = _chests[held[i]];
+            if (glm::length(pos - chest.pos) > CHEST_INTERACT_RANGE * 1.5f) {
                 chest.lockedBy = nullptr;
+                held[i] = held.back();
+                held.pop_back();
+            } else {
+                i++;
             }
         }
     }
 
+    // The player's own inventory. A handoff to another shard carries it
+    // there, and onPlayerConnect takes the one that arrives.
+    Inventory* playerInventory(ENetPeer* peer) { return getPlayerInv(peer); }
+
+    // Full state: on connect, respawn, and when the client reports a gap in
+    // the ack sequence. A chest the peer has open is resent too.
     void sendInventoryState(ENetPeer* peer) {
-        auto it = _playerInvs.find(peer);
-        if (it == _playerInvs.end()) return;
-        InventoryStatePacket p; p.inv = it->second;
-        Net::sendReliable(peer, p.serialize());
+        PlayerInv* me = _players.get<PlayerInv>(peer);
+        if (!me) return;
+        InventoryStatePacket p;
+        p.seq = me->seq;
+        p.inv = me->inv;
+        _out.reliable(peer, p.serialize());
+        for (uint32_t uid : me->locks) {
+            const ServerChest& c = _chests[uid];
+            _out.reliable(peer, ChestStatePacket{c.uid, c.pos, c.inv}.serialize());
+        }
     }
 
     // ── Death / corpse ────────────────────────────────────────────────────────
 
     uint32_t onPlayerDeath(ENetPeer* dead, glm::vec3 pos, ENetPeer* killer) {
-        auto it = _playerInvs.find(dead);
-        if (it == _playerInvs.end()) return 0;
+        PlayerInv* me = _players.get<PlayerInv>(dead);
+        if (!me) return 0;
 
         uint32_t uid = _nextUID++;
-        CorpseLoot loot{uid, pos, it->second, killer};
+        CorpseLoot loot{uid, pos, me->inv, killer};
         _corpses[uid] = loot;
-        it->second    = Inventory{};
+        _corpseIndex.insert(uid, pos);
+        me->inv       = Inventory{};
 
         LootAvailablePacket lp{uid, pos};
         if (killer) {
-            Net::sendReliable(killer, lp.serialize());
+            _out.reliable(killer, lp.serialize());
         } else {
-            for (auto& [p, ppos] : _playerPos)
-                if (glm::length(ppos - pos) < 30.f)
-                    Net::sendReliable(p, lp.serialize());
+            auto bytes = lp.serialize();
+            _playerIndex.forEachNear(pos, LOOT_NOTIFY_RANGE, [&](ENetPeer* p) {
+                const PlayerInv* o = _players.get<PlayerInv>(p);
+                if (o && glm::length(o->pos - pos) < LOOT_NOTIFY_RANGE)
+                    _out.reliable(p, bytes);
+            });
         }
         return uid;
     }
@@ -102,35 +150,58 @@ public:
     uint32_t addChest(glm::vec3 pos, Inventory prefill = {}) {
         uint32_t uid = _nextUID++;
         _chests[uid] = {uid, pos, prefill, nullptr};
-        saveChests();
+        _chestIndex.insert(uid, pos);
+        _store.putChest(uid, pos, prefill);
+        _store.putNextUID(_nextUID);
         return uid;
     }
 
+    // ── Proximity ─────────────────────────────────────────────────────────────
+
+    // Closest chest / corpse within range of pos, 0 if none. Only the chunks
+    // the range touches are visited.
+    uint32_t nearestChest(glm::vec3 pos, float range = CHEST_INTERACT_RANGE) const {
+        return nearest(_chestIndex, _chests, pos, range);
+    }
+
+    uint32_t nearestCorpse(glm::vec3 pos, float range = CORPSE_LOOT_RANGE) const {
+        return nearest(_corpseIndex, _corpses, pos, range);
+    }
+
     // ── Packet handlers ───────────────────────────────────────────────────────
 
+    // chestUID 0 means "whichever chest is nearest", which is what the
+    // client's interact key sends
     void onChestOpenReq(ENetPeer* peer, const ChestOpenReqPacket& req) {
-        auto pit = _playerPos.find(peer);
-        auto cit = _chests.find(req.chestUID);
-        if (pit == _playerPos.end() || cit == _chests.end()) return;
+        PlayerInv* me = _players.get<PlayerInv>(peer);
+        if (!me || !me->placed) return;
+        uint32_t uid = req.chestUID ? req.chestUID : nearestChest(me->pos);
+        auto cit = _chests.find(uid);
+        if (cit == _chests.end()) return;
 
         ServerChest& c = cit->second;
-        if (glm::length(pit->second - c.pos) > CHEST_INTERACT_RANGE) return;
+        if (glm::length(me->pos - c.pos) > CHEST_INTERACT_RANGE) return;
         if (c.lockedBy && c.lockedBy != peer) return;
 
+        if (!c.lockedBy) me->locks.push_back(uid);
         c.lockedBy = peer;
         ChestStatePacket p{c.uid, c.pos, c.inv};
-        Net::sendReliable(peer, p.serialize());
+        _out.reliable(peer, p.serialize());
     }
 
     void onChestCloseReq(ENetPeer* peer, const ChestCloseReqPacket& req) {
         auto it = _chests.find(req.chestUID);
-        if (it != _chests.end() && it->second.lockedBy == peer)
-            it->second.lockedBy = nullptr;
+        if (it == _chests.end() || it->second.lockedBy != peer) return;
+        it->second.lockedBy = nullptr;
+        if (PlayerInv* me = _players.get<PlayerInv>(peer)) {
+            auto& held = me->locks;
+            if (auto h = std::find(held.begin(), held.end(), req.chestUID); h != held.end()) held.erase(h);
+        }
     }
 
     void onInventoryMoveReq(ENetPeer* peer, const InventoryMoveReqPacket& req) {
-        Inventory* playerInv = getPlayerInv(peer);
-        if (!playerInv) return;
+        PlayerInv* me = _players.get<PlayerInv>(peer);
+        if (!me) return;
 
         Inventory* srcInv = resolveInv(peer, req.src);
         Inventory* dstInv = resolveInv(peer, req.dst);
@@ -149,6 +220,9 @@ public:
             Log::warn("MoveReq: type guard failed"); return;
         }
 
+        // Nothing would change — don't spend an ack
+        if (srcSlot == dstSlot || (srcSlot->empty() && dstSlot->empty())) return;
+
         // Stack merge for same item in grid/hotbar
         if (req.src.region != SlotRegion::Equip &&
             req.dst.region != SlotRegion::Equip &&
@@ -156,6 +230,7 @@ public:
             srcSlot->id == dstSlot->id) {
             const ItemDef& def = getItemDef(srcSlot->id);
             int take = std::min(srcSlot->count, def.maxStack - dstSlot->count);
+            if (take <= 0) return; // destination stack already full
             dstSlot->count += take;
             srcSlot->count -= take;
             if (srcSlot->count <= 0) srcSlot->clear();
@@ -163,48 +238,58 @@ public:
             std::swap(*srcSlot, *dstSlot);
         }
 
-        savePlayerInv(_playerUIDs[peer], *playerInv);
-
-        // Build ack
-        InventoryMoveAckPacket ack;
-        ack.playerInv = *playerInv;
-
-        uint32_t secUID = 0;
-        Inventory* secInv = nullptr;
-        if (req.src.owner == InvOwner::Chest || req.dst.owner == InvOwner::Chest) {
-            secUID = (req.src.owner == InvOwner::Chest) ? req.src.uid : req.dst.uid;
-            auto it = _chests.find(secUID);
-            if (it != _chests.end()) { secInv = &it->second.inv; saveChests(); }
-        } else if (req.src.owner == InvOwner::Corpse || req.dst.owner == InvOwner::Corpse) {
-            secUID = (req.src.owner == InvOwner::Corpse) ? req.src.uid : req.dst.uid;
-            auto it = _corpses.find(secUID);
-            if (it != _corpses.end()) secInv = &it->second.inv;
-        }
-
-        if (secInv) {
-            ack.hasSecondary = true;
-            ack.secondaryUID = secUID;
-            ack.secondaryInv = *secInv;
+        // Persist only what was touched
+        if (req.src.owner == InvOwner::Player || req.dst.owner == InvOwner::Player)
+            _store.putPlayer(me->uid, me->inv);
+        for (const SlotRef* ref : {&req.src, &req.dst}) {
+            if (ref->owner != InvOwner::Chest) continue;
+            auto it = _chests.find(ref->uid); // same chest twice coalesces in the store
+            if (it != _chests.end()) _store.putChest(it->first, it->second.pos, it->second.inv);
         }
 
-        Net::sendReliable(peer, ack.serialize());
+        InventoryMoveAckPacket ack;
+        ack.seq = ++me->seq;
+        ack.changes.push_back({req.src, *srcSlot});
+        ack.changes.push_back({req.dst, *dstSlot});
+        _out.reliable(peer, ack.serialize());
 
         // Clean up empty corpse
-        if (req.src.owner == InvOwner::Corpse || req.dst.owner == InvOwner::Corpse)
-            tryCleanCorpse(secUID);
+        if (req.src.owner == InvOwner::Corpse) tryCleanCorpse(req.src.uid);
+        if (req.dst.owner == InvOwner::Corpse) tryCleanCorpse(req.dst.uid);
     }
 
 private:
-    std::unordered_map<ENetPeer*, Inventory>  _playerInvs;
-    std::unordered_map<ENetPeer*, uint64_t>   _playerUIDs;
-    std::unordered_map<ENetPeer*, glm::vec3>  _playerPos;
+    // A connected player's side, in the PlayerRegistry
+    struct PlayerInv {
+        uint64_t              uid = 0;
+        Inventory             inv;
+        uint16_t              seq    = 0;     // last ack sent
+        bool                  placed = false; // moved since connecting: pos is in _playerIndex
+        glm::vec3             pos{0.f};
+        std::vector<uint32_t> locks;          // chests it holds
+    };
+
     std::unordered_map<uint32_t, ServerChest> _chests;
     std::unordered_map<uint32_t, CorpseLoot>  _corpses;
-    uint32_t _nextUID = 1;
+    ChunkIndex<uint32_t>  _chestIndex;
+    ChunkIndex<uint32_t>  _corpseIndex;
+    ChunkIndex<ENetPeer*> _playerIndex;
+    uint32_t        _nextUID = 1;
+    Outbox&         _out;
+    PlayerRegistry& _players;
+    InvStore        _store;
 
     Inventory* getPlayerInv(ENetPeer* peer) {
-        auto it = _playerInvs.find(peer);
-        return it != _playerInvs.end() ? &it->second : nullptr;
+        PlayerInv* me = _players.get<PlayerInv>(peer);
+        return me ? &me->inv : nullptr;
+    }
+
+    // Out of the index, its chests unlocked
+    void release(ENetPeer* peer, PlayerInv& me) {
+        if (me.placed) _playerIndex.erase(peer, me.pos);
+        me.placed = false;
+        for (uint32_t uid : me.locks) _chests[uid].lockedBy = nullptr;
+        me.locks.clear();
     }
 
     Inventory* resolveInv(ENetPeer* peer, const SlotRef& ref) {
@@ -225,6 +310,17 @@ private:
         return nullptr;
     }
 
+    template<class Map>
+    static uint32_t nearest(const ChunkIndex<uint32_t>& index, const Map& items, glm::vec3 pos, float range) {
+        uint32_t best = 0;
+        float bestD = range;
+        index.forEachNear(pos, range, [&](uint32_t uid) {
+            float d = glm::length(items.at(uid).pos - pos);
+            if (d <= bestD) { bestD = d; best = uid; }
+        });
+        return best;
+    }
+
     ItemStack* resolveSlot(Inventory* inv, const SlotRef& ref) {
         if (!inv) return nullptr;
         switch (ref.region) {
@@ -256,74 +352,47 @@ private:
 
     // ── Persistence ───────────────────────────────────────────────────────────
 
-    void writeInv(std::ofstream& f, const Inventory& inv) {
-        auto writeSlot = [&](const ItemStack& s) {
-            uint16_t id = (uint16_t)s.id;
-            int32_t  ct = s.count;
-            f.write((char*)&id, 2);
-            f.write((char*)&ct, 4);
-        };
-        for (const auto& s : inv.grid)       writeSlot(s);
-        for (const auto& s : inv.equipSlots) writeSlot(s);
-        for (const auto& s : inv.hotbars)    writeSlot(s);
-    }
-
-    void readInv(std::ifstream& f, Inventory& inv) {
-        auto readSlot = [&](ItemStack& s) {
-            uint16_t id; int32_t ct;
-            f.read((char*)&id, 2); f.read((char*)&ct, 4);
-            s.id = (ItemID)id; s.count = ct;
-        };
-        for (auto& s : inv.grid)       readSlot(s);
-        for (auto& s : inv.equipSlots) readSlot(s);
-        for (auto& s : inv.hotbars)    readSlot(s);
-    }
-
-    void saveChests() {
-        std::ofstream f(CHEST_FILE, std::ios::binary | std::ios::trunc);
-        if (!f) return;
-        uint32_t cnt = (uint32_t)_chests.size();
-        f.write((char*)&cnt,      4);
-        f.write((char*)&_nextUID, 4);
-        for (auto& [uid, c] : _chests) {
-            f.write((char*)&c.uid,   4);
-            f.write((char*)&c.pos.x, 4);
-            f.write((char*)&c.pos.y, 4);
-            f.write((char*)&c.pos.z, 4);
-            writeInv(f, c.inv);
+    void loadChests() {
+        for (const auto& c : _store.chests())
+            _chests[c.uid] = {c.uid, c.pos, c.inv, nullptr};
+        _nextUID = std::max(_nextUID, _store.nextUID());
+        if (_chests.empty()) loadLegacyChests();
+        for (const auto& [uid, c] : _chests) {
+            _nextUID = std::max(_nextUID, uid + 1);
+            _chestIndex.insert(uid, c.pos);
         }
+        Log::info("Loaded " + std::to_string(_chests.size()) + " chests");
     }
 
-    void loadChests() {
-        std::ifstream f(CHEST_FILE, std::ios::binary);
+    void loadLegacyChests() {
+        std::ifstream f(LEGACY_CHEST_FILE, std::ios::binary);
         if (!f) return;
         uint32_t cnt = 0;
         f.read((char*)&cnt,      4);
         f.read((char*)&_nextUID, 4);
-        for (uint32_t i = 0; i < cnt; i++) {
+        for (uint32_t i = 0; i < cnt && f; i++) {
             ServerChest c;
             f.read((char*)&c.uid,   4);
             f.read((char*)&c.pos.x, 4);
             f.read((char*)&c.pos.y, 4);
             f.read((char*)&c.pos.z, 4);
-            readInv(f, c.inv);
+            readLegacyInv(f, c.inv);
             _chests[c.uid] = c;
+            _store.putChest(c.uid, c.pos, c.inv);
         }
-        Log::info("Loaded " + std::to_string(cnt) + " chests");
-    }
-
-    void savePlayerInv(uint64_t uid, const Inventory& inv) {
-        std::string path = std::string(PLAYER_INV_DIR) + std::to_string(uid) + ".inv";
-        std::ofstream f(path, std::ios::binary | std::ios::trunc);
-        if (f) writeInv(f, inv);
+        _store.putNextUID(_nextUID);
+        Log::info("Imported " + std::to_string(_chests.size()) + " chests from " + LEGACY_CHEST_FILE);
     }
 
-    Inventory loadPlayerInv(uint64_t uid) {
-        std::string path = std::string(PLAYER_INV_DIR) + std::to_string(uid) + ".inv";
-        std::ifstream f(path, std::ios::binary);
-        Inventory inv;
-        if (f) readInv(f, inv);
-        return inv;
+    static void readLegacyInv(std::ifstream& f, Inventory& inv) {
+        auto readSlot = [&](ItemStack& s) {
+            uint16_t id; int32_t ct;
+            f.read((char*)&id, 2); f.read((char*)&ct, 4);
+            s.id = (ItemID)id; s.count = ct;
+        };
+        for (auto& s : inv.grid)       readSlot(s);
+        for (auto& s : inv.equipSlots) readSlot(s);
+        for (auto& s : inv.hotbars)    readSlot(s);
     }
 
     void tryCleanCorpse(uint32_t uid) {
@@ -331,6 +400,7 @@ private:
         if (it == _corpses.end()) return;
         for (const auto& s : it->second.inv.grid)
             if (!s.empty()) return;
+        _corpseIndex.erase(uid, it->second.pos);
         _corpses.erase(it);
     }
 };
@@ -0,0 +1,130 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+#include "http_client.h"
+#include "metrics.h"
+#include "log.h"
+
+// Serves registry.render() as GET /metrics on its own thread, so a scrape
+// never touches the ENet loop. Minimal HTTP/1.1: one request per
+// connection, answered and closed. Connections are handled one at a time —
+// a scraper every few seconds is the only expected client.
+class MetricsServer {
+public:
+    static constexpr int POLL_MS    = 200;  // how often the thread checks for stop()
+    static constexpr int REQUEST_MS = 2000; // a client gets this long to send its request line
+
+    explicit MetricsServer(const MetricsRegistry& registry) : _registry(registry) {}
+    ~MetricsServer() { stop(); }
+
+    MetricsServer(const MetricsServer&)            = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    bool start(const std::string& bind, int port) {
+        sock_init();
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port   = htons((uint16_t)port);
+        if (inet_pton(AF_INET, bind.c_str(), &addr.sin_addr) != 1) {
+            Log::err("Metrics: bad bind address " + bind);
+            return false;
+        }
+        _listen = socket(AF_INET, SOCK_STREAM, 0);
+        if (_listen == SOCK_INVALID) return false;
+        int on = 1;
+        setsockopt(_listen, SOL_SOCKET, SO_REUSEADDR, (const char*)&on, sizeof on);
+        if (::bind(_listen, (sockaddr*)&addr, sizeof addr) != 0 || listen(_listen, 8) != 0 ||
+            !sock_nonblocking(_listen)) {
+            Log::err("Metrics: can't listen on " + bind + ":" + std::to_string(port));
+            sock_close(_listen);
+            _listen = SOCK_INVALID;
+            return false;
+        }
+        _stop = false;
+        _thread = std::thread([this] { run(); });
+        Log::info("Metrics on http://" + bind + ":" + std::to_string(port) + "/metrics");
+        return true;
+    }
+
+    void stop() {
+        if (!_thread.joinable()) return;
+        _stop = true;
+        _thread.join();
+        sock_close(_listen);
+        _listen = SOCK_INVALID;
+    }
+
+private:
+    void run() {
+        while (!_stop) {
+            sock_pollfd p{};
+            p.fd     = _listen;
+            p.events = POLLIN;
+            if (sock_poll(&p, 1, POLL_MS) <= 0) continue;
+            sock_t c = accept(_listen, nullptr, nullptr);
+            if (c == SOCK_INVALID) continue;
+            if (sock_nonblocking(c)) serve(c);
+            sock_close(c);
+        }
+    }
+
+    void serve(sock_t c) {
+        // Only the request line matters; headers and any body are ignored
+        std::string req;
+        auto deadline = Metrics::Clock::now() + std::chrono::milliseconds(REQUEST_MS);
+        while (req.find("\r\n") == std::string::npos && req.size() < 4096) {
+            int left = (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+                           deadline - Metrics::Clock::now()).count();
+            sock_pollfd p{};
+            p.fd     = c;
+            p.events = POLLIN;
+            if (left <= 0 || sock_poll(&p, 1, left) <= 0) return;
+            char buf[1024];
+            int n = (int)recv(c, buf, sizeof buf, 0);
+            if (n <= 0) {
+                if (n < 0 && sock_would_block()) continue;
+                return;
+            }
+            req.append(buf, (size_t)n);
+        }
+
+        std::string line = req.substr(0, req.find("\r\n"));
+        std::string path = line.size() > 4 && line.compare(0, 4, "GET ") == 0
+                               ? line.substr(4, line.find(' ', 4) - 4) : std::string{};
+        if (path.find('?') != std::string::npos) path.resize(path.find('?'));
+
+        std::string body, status = "200 OK", type = "text/plain; version=0.0.4; charset=utf-8";
+        if (path == "/metrics" || path == "/") {
+            body = _registry.render();
+        } else {
+            status = line.compare(0, 4, "GET ") == 0 ? "404 Not Found" : "405 Method Not Allowed";
+            type   = "text/plain";
+            body   = status + "\n";
+        }
+        std::string out = "HTTP/1.1 " + status + "\r\nContent-Type: " + type +
+                          "\r\nContent-Length: " + std::to_string(body.size()) +
+                          "\r\nConnection: close\r\n\r\n" + body;
+        sendAll(c, out);
+    }
+
+    static void sendAll(sock_t c, const std::string& s) {
+        size_t off = 0;
+        while (off < s.size()) {
+            int n = (int)send(c, s.data() + off, (int)(s.size() - off), SOCK_NOSIGNAL);
+            if (n > 0) { off += (size_t)n; continue; }
+            if (n < 0 && sock_would_block()) {
+                sock_pollfd p{};
+                p.fd     = c;
+                p.events = POLLOUT;
+                if (sock_poll(&p, 1, REQUEST_MS) > 0) continue;
+            }
+            return;
+        }
+    }
+
+    const MetricsRegistry& _registry;
+    sock_t                 _listen = SOCK_INVALID;
+    std::atomic<bool>      _stop{false};
+    std::thread            _thread;
+};
@@ -0,0 +1,168 @@
+#pragma once
+#include <enet/enet.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "log.h"
+
+// ── Packet capture ────────────────────────────────────────────────────────────
+// Every ENet event the server loop handles — connects, received packets,
+// disconnects — in the order it handled them, for `server --replay` to feed
+// back through the same handlers without a socket.
+//
+// File layout: "AETHCAP" + u8 version, then records back to back:
+//
+//   u8 kind | varint µs since the previous record | varint peer | (Receive) varint len | bytes
+//
+// Times are the loop wakeup the event was handled in, so one loop
+// iteration's batch shares a timestamp (delta 0) and replays as one. Peers are numbered from 1 in connect order for the capture;
+// the pointers mean nothing outside the process. Varints are LEB128, 64-bit.
+namespace Capture {
+
+inline constexpr char    MAGIC[7] = {'A', 'E', 'T', 'H', 'C', 'A', 'P'};
+inline constexpr uint8_t VERSION  = 1;
+
+enum class Kind : uint8_t { Connect = 0, Receive = 1, Disconnect = 2 };
+
+struct Record {
+    Kind           kind;
+    int64_t        us;     // since the capture started
+    uint32_t       peer;
+    const uint8_t* data;   // Receive only; points into the Reader's buffer
+    size_t         len;
+};
+
+// Writes on the simulation thread through a large stdio buffer; flush() now and
+// then (the server does it once a second) bounds what a crash loses.
+class Writer {
+public:
+    ~Writer() { close(); }
+
+    bool open(const char* path) {
+        _f = fopen(path, "wb");
+        if (!_f) {
+            Log::err(std::string("Capture: cannot open ") + path);
+            return false;
+        }
+        setvbuf(_f, nullptr, _IOFBF, 1 << 20);
+        fwrite(MAGIC, 1, sizeof MAGIC, _f);
+        fputc(VERSION, _f);
+        Log::info(std::string("Capturing inbound packets to ") + path);
+        return true;
+    }
+    bool on() const { return _f != nullptr; }
+
+    void close() {
+        if (!_f) return;
+        fclose(_f);
+        _f = nullptr;
+    }
+    void flush() { if (_f) fflush(_f); }
+
+    // at: when the loop woke for this batch
+    void connect(int64_t at, ENetPeer* peer) {
+        if (!_f) return;
+        uint32_t id = _ids[peer] = _nextId++;
+        header(Kind::Connect, at, id);
+    }
+    void receive(int64_t at, ENetPeer* peer, const uint8_t* d, size_t len) {
+        if (!_f) return;
+        auto it = _ids.find(peer);
+        if (it == _ids.end()) return; // connected before the capture started
+        header(Kind::Receive, at, it->second);
+        varint(len);
+        fwrite(d, 1, len, _f);
+    }
+    void disconnect(int64_t at, ENetPeer* peer) {
+        if (!_f) return;
+        auto it = _ids.find(peer);
+        if (it == _ids.end()) return;
+        header(Kind::Disconnect, at, it->second);
+        _ids.erase(it);
+    }
+
+private:
+    void header(Kind k, int64_t at, uint32_t peer) {
+        fputc((int)k, _f);
+        varint((uint64_t)std::max<int64_t>(0, at - _last));
+        varint(peer);
+        _last = std::max(_last, at);
+    }
+    void varint(uint64_t v) {
+        uint8_t buf[10];
+        int n = 0;
+        for (; v >= 0x80; v >>= 7) buf[n++] = (uint8_t)(v & 0x7F) | 0x80;
+        buf[n++] = (uint8_t)v;
+        fwrite(buf, 1, (size_t)n, _f);
+    }
+
+    FILE*                                   _f      = nullptr;
+    int64_t                                 _last   = 0;
+    uint32_t                                _nextId = 1;
+    std::unordered_map<ENetPeer*, uint32_t> _ids;
+};
+
+// Loads a whole capture up front, so replay timing isn't disk-bound
+class Reader {
+public:
+    bool open(const char* path) {
+        FILE* f = fopen(path, "rb");
+        if (!f) {
+            Log::err(std::string("Replay: cannot open ") + path);
+            return false;
+        }
+        char buf[1 << 16];
+        for (size_t n; (n = fread(buf, 1, sizeof buf, f)) > 0;) _buf.insert(_buf.end(), buf, buf + n);
+        fclose(f);
+        if (_buf.size() < sizeof MAGIC + 1 || std::memcmp(_buf.data(), MAGIC, sizeof MAGIC) != 0 ||
+            _buf[sizeof MAGIC] != VERSION) {
+            Log::err(std::string("Replay: ") + path + " is not a version " +
+                     std::to_string(VERSION) + " capture");
+            return false;
+        }
+        _o = sizeof MAGIC + 1;
+        return true;
+    }
+
+    size_t bytes() const { return _buf.size(); }
+
+    // False at the end, or at a truncated record (a capture cut short by a
+    // crash ends mid-write)
+    bool next(Record& r) {
+        if (_o >= _buf.size()) return false;
+        uint8_t  k = _buf[_o++];
+        uint64_t dt, peer, len = 0;
+        if (k > (uint8_t)Kind::Disconnect || !varint(dt) || !varint(peer)) return truncated();
+        if (k == (uint8_t)Kind::Receive && (!varint(len) || len > _buf.size() - _o)) return truncated();
+        _us += (int64_t)dt;
+        r = {(Kind)k, _us, (uint32_t)peer, _buf.data() + _o, (size_t)len};
+        _o += (size_t)len;
+        return true;
+    }
+
+private:
+    bool varint(uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64 && _o < _buf.size(); shift += 7) {
+            uint8_t c = _buf[_o++];
+            v |= (uint64_t)(c & 0x7F) << shift;
+            if (!(c & 0x80)) return true;
+        }
+        return false;
+    }
+    bool truncated() {
+        Log::warn("Replay: partial or corrupt record; stopping there");
+        _o = _buf.size();
+        return false;
+    }
+
+    std::vector<uint8_t> _buf;
+    size_t               _o  = 0;
+    int64_t              _us = 0;
+};
+
+} // namespace Capture
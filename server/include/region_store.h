@@ -0,0 +1,146 @@
+#pragma once
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include "chunk.h"
+#include "thread_pool.h"
+
+// Persistent store for serialized chunks, grouped into region files of
+// REGION³ chunks each ("r.X.Y.Z.bin" under the world directory).
+//
+// File layout (host byte order):
+//   Header  magic 'AREG', layout version, world seed, payload version
+//   Table   REGION³ slots {sector, length, codec}, indexed by local coord
+//   Data    payloads, each starting on a SECTOR boundary, appended in order
+//
+// Reads go through a read-only mmap of the file (POSIX), so a cache miss on a
+// stored chunk is a page fault plus a memcpy. The mapping is marked random
+// access and a payload's own pages are asked for ahead of the copy, so a
+// load reads what it needs and no more. Writes are queued to a single I/O
+// thread and appended; re-saving a chunk appends a new copy and repoints
+// its slot — the old sectors are left as garbage.
+//
+// A file whose seed or payload version doesn't match is moved to stale/ and
+// rebuilt, so changing WORLD_SEED or the chunk wire format regenerates the
+// world while the edits saved under the old one are kept for recovery.
+//
+// Sectors are only ever appended, so a copy of a region's slot table stays
+// good for as long as the file does: freeze() takes one of every region
+// this process writes, and writeFrozen() copies what such a table points
+// at into a fresh file, while saves go on appending around it.
+//
+// When the world is split between shards (ShardMap), each writes only the
+// regions it owns. The rest it opens read-only, never creating or resetting
+// them, and reads each slot afresh from the file on every load, so what the
+// owner has saved since is seen; saves to them are dropped.
+class RegionStore {
+public:
+    static constexpr int      REGION          = 16;
+    static constexpr int      SLOTS           = REGION * REGION * REGION;
+    static constexpr size_t   SECTOR          = 4096;
+    static constexpr uint32_t MAGIC           = 0x47455241; // "AREG"
+    static constexpr uint32_t LAYOUT_VERSION  = 1;
+
+    // Slot codecs. Only uncompressed payloads are written today; the field is
+    // there so a codec can be introduced without a layout bump.
+    enum class Codec : uint8_t { None = 0 };
+
+    // Whether this process writes a region, by region coord
+    using Owned = std::function<bool(ChunkCoord region)>;
+
+    RegionStore(std::string dir, uint32_t seed, uint32_t payloadVersion);
+
+    // Before the first load or save; unset, every region is ours
+    void setOwned(Owned owned) { _owned = std::move(owned); }
+
+    // Whether saves of this chunk are kept
+    bool ownsChunk(ChunkCoord coord) const { return owns(regionOf(coord)); }
+
+    // Thread-safe. Returns nullopt if the chunk was never saved.
+    std::optional<std::vector<uint8_t>> load(ChunkCoord coord);
+
+    // Thread-safe, non-blocking — the write happens on the I/O thread.
+    void save(ChunkCoord coord, std::shared_ptr<const std::vector<uint8_t>> bytes);
+
+    struct Slot {
+        uint32_t sector = 0;  // 0 = empty (sector 0 is always header/table)
+        uint32_t length = 0;  // payload bytes
+        uint8_t  codec  = 0;
+        uint8_t  pad[3] = {};
+    };
+    static_assert(sizeof(Slot) == 12);
+
+    struct FrozenRegion {
+        ChunkCoord               coord; // region coord
+        std::array<Slot, SLOTS>  table;
+    };
+    using Frozen = std::vector<FrozenRegion>;
+
+    // Thread-safe, non-blocking. The slot tables of every region on disk
+    // this process writes, as they stand once the saves queued before the
+    // call are written — taken on the I/O thread, in line with them.
+    TaskFuture<Frozen> freeze();
+    // Any thread. A compacted copy of a frozen region at path: the same
+    // header, its payloads packed, written aside and renamed over it.
+    bool writeFrozen(const std::string& path, const FrozenRegion& region) const;
+
+    // Writes (and freezes) queued on the I/O thread, not yet started
+    int ioPending() const { return _io.pending(); }
+
+private:
+
+    struct Header {
+        uint32_t magic;
+        uint32_t layoutVersion;
+        uint32_t seed;
+        uint32_t payloadVersion;
+    };
+
+    static constexpr size_t   TABLE_OFFSET = sizeof(Header);
+    static constexpr uint32_t DATA_SECTOR  =
+        (uint32_t)((TABLE_OFFSET + SLOTS * sizeof(Slot) + SECTOR - 1) / SECTOR);
+
+    struct Region {
+        std::mutex               mu;
+        FILE*                    file = nullptr;
+        std::array<Slot, SLOTS>  table{};
+        uint32_t                 endSector = DATA_SECTOR;
+        const uint8_t*           map     = nullptr;
+        size_t                   mapSize = 0;
+        bool                     readOnly = false; // another shard's
+
+        ~Region(); // unmaps and closes
+    };
+
+    Region* region(ChunkCoord regionCoord);
+    bool    openRegion(Region& r, ChunkCoord regionCoord);
+    bool    openReadOnly(Region& r, ChunkCoord regionCoord);
+    bool    owns(ChunkCoord regionCoord) const { return !_owned || _owned(regionCoord); }
+    std::string pathOf(ChunkCoord regionCoord) const;
+    std::string stalePathOf(ChunkCoord regionCoord) const;
+    void    write(ChunkCoord coord, const std::vector<uint8_t>& bytes);
+    bool    ensureMapped(Region& r, size_t end);
+    static void unmap(Region& r);
+
+    static ChunkCoord regionOf(ChunkCoord c);
+    static int        slotOf  (ChunkCoord c);
+
+    std::string _dir;
+    uint32_t    _seed;
+    uint32_t    _payloadVersion;
+    Owned       _owned;
+
+    std::mutex _regionsMu;
+    std::unordered_map<ChunkCoord, std::unique_ptr<Region>, ChunkCoordHash> _regions;
+
+    // Declared last: destroyed first, draining queued writes before the
+    // regions above are closed
+    ThreadPool _io{1};
+};
@@ -0,0 +1,243 @@
+#pragma once
+#include <enet/enet.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include <entt/entt.hpp>
+#include "config.h"
+#include "interest_grid.h"
+#include "log.h"
+#include "outbox.h"
+#include "replication.h"
+
+// Sends the registry's replicated components (replication.h) to the clients
+// that asked for them. flush() snapshots every CReplicated entity's fields,
+// quantized, then for each client walks the entities within
+// INTEREST_FAR_CHUNKS of its viewer position and writes a record for each
+// one whose fields differ from that client's baseline — the whole entity
+// the first time, only the changed fields after. Entities that left range
+// or the registry get a gone record and drop out of the baseline.
+//
+// A client gets at most REPL_BYTES_PER_FLUSH a flush. Candidates go
+// nearest first, their distance discounted by how many flushes they've
+// been passed over for, so a far entity that keeps changing still gets
+// through. One record that doesn't fit on its own goes anyway.
+//
+// Main (simulation) thread, like the registry.
+class ReplicationServer {
+public:
+    struct Stats {
+        uint64_t records  = 0; // written, gone ones included
+        uint64_t bytes    = 0;
+        uint64_t deferred = 0; // changed but over budget, sent later
+        size_t   entities = 0; // in the last snapshot
+    };
+
+    ReplicationServer(entt::registry& reg, Outbox& out) : _reg(reg), _out(out) {}
+
+    // In the same order as every client's ReplicationClient::replicate
+    template<class T>
+    void replicate() {
+        static_assert(!std::is_empty_v<T>, "replicate a component with at least one field");
+        if (_types.size() >= 32) {
+            Log::err("Replication: more than 32 component types");
+            return;
+        }
+        Type t;
+        t.fields = ReplTraits<T>::fields();
+        t.first  = _fieldCount;
+        t.get    = [](const entt::registry& reg, entt::entity e) -> const void* { return reg.try_get<T>(e); };
+        _fieldCount += t.fields.size();
+        _types.push_back(std::move(t));
+    }
+
+    // Makes e replicated under a fresh netId
+    CReplicated& track(entt::entity e, const glm::vec3& pos) {
+        return _reg.emplace_or_replace<CReplicated>(e, CReplicated{_nextNetId++, pos});
+    }
+
+    void addClient(ENetPeer* peer) { _clients[peer]; }
+    void removeClient(ENetPeer* peer) { _clients.erase(peer); }
+
+    // Where the client's player is; nothing goes to it until this is set
+    void setViewer(ENetPeer* peer, const glm::vec3& pos) {
+        auto it = _clients.find(peer);
+        if (it == _clients.end()) return;
+        it->second.pos    = pos;
+        it->second.hasPos = true;
+    }
+
+    void flush() {
+        _flushes++;
+        snapshot();
+        for (auto& [peer, c] : _clients)
+            if (c.hasPos) flushClient(peer, c);
+    }
+
+    Stats stats() const { return _stats; }
+
+private:
+    struct Type {
+        std::vector<ReplField> fields;
+        size_t first = 0; // into the snapshot's values
+        const void* (*get)(const entt::registry&, entt::entity) = nullptr; // nullptr if absent
+    };
+
+    struct Snap {
+        uint32_t  netId   = 0;
+        glm::vec3 pos{0.f};
+        uint32_t  present = 0;   // bit per type
+        size_t    values  = 0;   // offset, _fieldCount of them
+    };
+
+    // What the client holds of one entity
+    struct Base {
+        bool                  sent    = false; // false: in range, not yet written
+        uint32_t              present = 0;
+        std::vector<uint32_t> values;
+        uint32_t              waiting = 0;     // flushes it was changed but left out
+        uint64_t              seen    = 0;     // last flush it was in range
+    };
+
+    struct Client {
+        glm::vec3 pos{0.f};
+        bool      hasPos = false;
+        std::unordered_map<uint32_t, Base> known; // by netId
+    };
+
+    struct Candidate {
+        float  score;
+        size_t snap;
+        Base*  base;
+    };
+
+    void snapshot() {
+        _snaps.clear();
+        _values.clear();
+        _grid.clear();
+        auto view = _reg.view<const CReplicated>();
+        for (auto [e, r] : view.each()) {
+            Snap s{r.netId, r.pos, 0, _values.size()};
+            _values.resize(_values.size() + _fieldCount);
+            for (size_t i = 0; i < _types.size(); i++) {
+                const Type& t = _types[i];
+                const void* c = t.get(_reg, e);
+                if (!c) continue;
+                s.present |= 1u << i;
+                for (size_t k = 0; k < t.fields.size(); k++)
+                    _values[s.values + t.first + k] = t.fields[k].get(c, t.fields[k]);
+            }
+            _grid.add(s.pos, s.netId, _snaps.size());
+            _snaps.push_back(s);
+        }
+        _stats.entities = _snaps.size();
+    }
+
+    bool unchanged(const Snap& s, const Base& b) const {
+        return b.sent && b.present == s.present &&
+               std::memcmp(b.values.data(), &_values[s.values], _fieldCount * sizeof(uint32_t)) == 0;
+    }
+
+    void flushClient(ENetPeer* peer, Client& c) {
+        _cands.clear();
+        _grid.forEachInRange(c.pos, Config::INTEREST_FAR_CHUNKS, [&](size_t si) {
+            const Snap& s = _snaps[si];
+            Base&       b = c.known[s.netId];
+            b.seen        = _flushes;
+            if (unchanged(s, b)) return;
+            glm::vec3 d   = s.pos - c.pos;
+            float     w   = 1.f + (float)b.waiting;
+            _cands.push_back({glm::dot(d, d) / (w * w), si, &b});
+        });
+
+        _w.begin((uint8_t)MPPacketID::Replication, Config::REPL_BYTES_PER_FLUSH);
+        for (auto it = c.known.begin(); it != c.known.end();) {
+            if (it->second.seen == _flushes) {
+                ++it;
+                continue;
+            }
+            if (it->second.sent) {
+                _w.varint(it->first);
+                BitWriter(_w).put(1, 1);
+                _stats.records++;
+            }
+            it = c.known.erase(it);
+        }
+
+        std::sort(_cands.begin(), _cands.end(),
+                  [](const Candidate& a, const Candidate& b) { return a.score < b.score; });
+        for (const Candidate& cand : _cands) {
+            const Snap& s = _snaps[cand.snap];
+            encode(s, *cand.base);
+            if (_w.size() > 1 && _w.size() + _rec.size() > Config::REPL_BYTES_PER_FLUSH) {
+                cand.base->waiting++;
+                _stats.deferred++;
+                continue;
+            }
+            _w.bytes(_rec.data(), _rec.size());
+            Base& b   = *cand.base;
+            b.sent    = true;
+            b.present = s.present;
+            b.values.assign(_values.begin() + (ptrdiff_t)s.values,
+                            _values.begin() + (ptrdiff_t)(s.values + _fieldCount));
+            b.waiting = 0;
+            _stats.records++;
+        }
+
+        if (_w.size() <= 1) return;
+        _out.reliable(peer, _w.data(), _w.size());
+        _stats.bytes += _w.size();
+    }
+
+    // s against what b holds, into _rec
+    void encode(const Snap& s, const Base& b) {
+        _rec.clear();
+        _rec.varint(s.netId);
+        BitWriter bits(_rec);
+        bits.put(0, 1);
+        for (size_t i = 0; i < _types.size(); i++) {
+            const Type& t   = _types[i];
+            const bool  has = s.present >> i & 1;
+            const bool  had = b.sent && (b.present >> i & 1);
+            if (!has) {
+                bits.put(had ? Repl::OP_REMOVED : Repl::OP_SAME, 2);
+                continue;
+            }
+            const uint32_t* now  = &_values[s.values + t.first];
+            uint32_t        mask = 0;
+            for (size_t k = 0; k < t.fields.size(); k++)
+                if (!had || b.values[t.first + k] != now[k]) mask |= 1u << k;
+            // A component new to the client goes whole
+            if (mask == 0) {
+                bits.put(Repl::OP_SAME, 2);
+                continue;
+            }
+            bits.put(Repl::OP_CHANGED, 2);
+            bits.put(mask, (int)t.fields.size());
+            for (size_t k = 0; k < t.fields.size(); k++)
+                if (mask >> k & 1) bits.put(now[k], t.fields[k].bits);
+        }
+    }
+
+    entt::registry& _reg;
+    Outbox&         _out;
+
+    std::vector<Type> _types;
+    size_t            _fieldCount = 0;
+    uint32_t          _nextNetId  = 1;
+    uint64_t          _flushes    = 0;
+
+    std::unordered_map<ENetPeer*, Client> _clients;
+
+    // Per flush, reused
+    std::vector<Snap>      _snaps;
+    std::vector<uint32_t>  _values;
+    InterestGrid<size_t>   _grid;
+    std::vector<Candidate> _cands;
+    PacketWriter           _w, _rec;
+
+    Stats _stats;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Free list of large scratch objects, handed out as shared_ptrs that return
+// here when the last holder lets go — memory and all, so a buffer's pages
+// and a vector's capacity are reused instead of allocated and faulted in
+// again. For work that crosses threads; a stage that stays on one worker
+// uses thread_local scratch instead. At most keep objects wait here; the
+// rest are freed. Must outlive every handle it gave out.
+template<class T>
+class ScratchPool {
+public:
+    explicit ScratchPool(size_t keep = 8) : _keep(keep) {}
+
+    // Holds whatever its last user left in it
+    std::shared_ptr<T> acquire() {
+        std::unique_ptr<T> p;
+        {
+            std::lock_guard lk(_mu);
+            if (!_free.empty()) {
+                p = std::move(_free.back());
+                _free.pop_back();
+            }
+        }
+        if (!p) p = std::make_unique<T>();
+        return std::shared_ptr<T>(p.release(), [this](T* q) { release(q); });
+    }
+
+private:
+    void release(T* p) {
+        std::unique_ptr<T> owned(p);
+        std::lock_guard lk(_mu);
+        if (_free.size() < _keep) _free.push_back(std::move(owned));
+    }
+
+    size_t                          _keep;
+    std::mutex                      _mu;
+    std::vector<std::unique_ptr<T>> _free;
+};
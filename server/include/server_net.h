@@ -0,0 +1,151 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <enet/enet.h>
+#include "loopback.h"
+#include "net_common.h"
+#include "spsc_queue.h"
+
+// ── ServerNet ─────────────────────────────────────────────────────────────────
+// Owns the server's ENet host and services it on a thread of its own, so
+// ACKs, resends and keep-alives go out on time however long a simulation
+// iteration runs, and packets come off the socket as they arrive. ENet
+// isn't thread-safe: on the simulation side nothing touches the host, and
+// nothing reads a peer's ENet state — peers are only keys.
+//
+// The two threads talk through two lock-free rings:
+//   inbound   net → sim   connects, received packets, disconnects, and each
+//                         peer's RTT and loss every LINK_MS
+//   outbound  sim → net   finished packets (the Outbox's bundles and shared
+//                         chunk packets, re-wrapped so each is the net
+//                         thread's alone) to send as they are
+// Either side holds on to what doesn't fit in a full ring and retries, in
+// order; nothing is dropped.
+//
+// ENet reuses peer slots, so a peer's connectID travels with everything:
+// a send queued for a connection that has since gone is discarded rather
+// than delivered to whoever got the slot next.
+//
+// One host's service loop is a ceiling on packets a second. start() can
+// instead open several lanes: each its own host on its own thread with
+// its own pair of rings, all bound to the one port with SO_REUSEPORT. The
+// kernel picks a lane per client address, so a player keeps theirs for
+// the whole connection; poll() drains every lane's inbound ring, and a
+// send (a broadcast is one per peer) goes to the sending peer's lane.
+// Where SO_REUSEPORT isn't available there's one lane.
+//
+// An in-process client (singleplayer) comes in through attach() instead,
+// with or without lanes: its Loopback's rings stand in for a lane's, and
+// its packets never touch ENet.
+class ServerNet {
+public:
+    struct Event {
+        enum class Kind : uint8_t { Connect, Receive, Disconnect, Link };
+        Kind        kind   = Kind::Receive;
+        ENetPeer*   peer   = nullptr;
+        uint32_t    id     = 0;       // the peer's connectID
+        ENetPacket* packet = nullptr; // Receive: the handler's to destroy
+        uint32_t    rtt    = 0;       // Link: ms
+        uint32_t    loss   = 0;       // Link: of ENET_PEER_PACKET_LOSS_SCALE
+    };
+
+    // Longest enet_host_service wait: bounds how long a queued send sits
+    static constexpr uint32_t SERVICE_MS = 1;
+    // How often peers' link figures are published
+    static constexpr std::chrono::milliseconds LINK_MS{250};
+
+    ServerNet() = default;
+    ~ServerNet() { stop(); }
+
+    ServerNet(const ServerNet&)            = delete;
+    ServerNet& operator=(const ServerNet&) = delete;
+
+    // lanes network threads, each taking up to maxPeers (the kernel can
+    // spread clients unevenly). Throws if the port can't be bound.
+    void start(uint16_t port, size_t maxPeers, int lanes = 1);
+    // Flushes what's queued and joins; peers are left to time out
+    void stop();
+    // Lanes running; 0 before start
+    int lanes() const { return (int)_lanes.size(); }
+    // Keep lane i's thread on core cpu + i; false if unsupported or not running
+    bool pin(int cpu);
+    // Serves lb's client as lb.peer; lb outlives this
+    void attach(Loopback& lb);
+    bool loopbackConnected() const { return _loopUp; }
+
+    // ── Simulation thread ─────────────────────────────────────────────────
+    // Blocks until an event is waiting or ms pass
+    void wait(int ms);
+    bool poll(Event& out);
+    // Takes ownership of pkt; dropped if the peer has disconnected
+    void send(ENetPeer* peer, uint8_t channel, ENetPacket* pkt);
+
+    // UDP payload bytes sent, ENet headers and resends included; any thread
+    uint64_t bytesSent() const;
+    // Peers connected through each lane; any thread
+    std::vector<int> lanePeers() const;
+
+private:
+    struct Send {
+        ENetPeer*   peer    = nullptr;
+        uint32_t    id      = 0;
+        uint8_t     channel = 0;
+        ENetPacket* packet  = nullptr;
+    };
+
+    static constexpr size_t INBOUND  = 4096;
+    static constexpr size_t OUTBOUND = 4096;
+
+    struct Lane {
+        // Its network thread only
+        ENetHost*         host = nullptr;
+        std::deque<Event> eventsWaiting;
+        std::chrono::steady_clock::time_point linkSent;
+
+        // Simulation thread only
+        std::deque<Send> sendsWaiting;
+
+        SpscQueue<Event, INBOUND> inbound;
+        SpscQueue<Send, OUTBOUND> outbound;
+        std::atomic<uint64_t>     bytesSent{0};
+        std::atomic<int>          peers{0};
+        std::thread               thread;
+    };
+    struct Live {
+        uint32_t id;   // connectID
+        uint32_t lane;
+    };
+
+    static ENetHost* openHost(uint16_t port, size_t maxPeers, bool shared);
+    void run(Lane& l);
+    void emit(Lane& l, Event&& ev);
+    bool flushEvents(Lane& l); // true if any went
+    void execute(Send& s);
+    void signal(); // wakes wait(); any thread
+    bool pollLoopback(Event& out);
+
+    std::vector<std::unique_ptr<Lane>> _lanes;
+
+    // Simulation thread only
+    std::unordered_map<ENetPeer*, Live> _live; // connected
+    size_t                              _nextLane = 0; // where poll() starts, so no lane starves
+    Loopback*                           _loop     = nullptr;
+    uint32_t                            _loopId   = 0;     // its live connection, if _loopUp
+    bool                                _loopUp   = false;
+    std::deque<Loopback::Message>       _loopWaiting;      // sends a full ring held back
+
+    std::atomic<bool> _running{false};
+
+    // Only for waking the simulation thread; the rings don't lock
+    std::mutex              _wakeMu;
+    std::condition_variable _wake;
+    std::atomic<bool>       _signalled{false};
+};
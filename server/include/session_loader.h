@@ -0,0 +1,91 @@
+#pragma once
+#include <enet/enet.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include "async.h"
+#include "config.h"
+#include "inventory.h"
+#include "player_stats.h"
+#include "thread_pool.h"
+
+// What a player brings into the world, read before they enter it
+struct PlayerSession {
+    Inventory   inv;
+    PlayerStats stats; // not persisted yet; starts fresh
+};
+
+// Reads a verified login's saved data on a pool of SESSION_LOAD_WORKERS I/O
+// workers, so a slow read holds up that player rather than the main loop or
+// every login behind it (past the pool's width, they queue). Between auth and
+// MultiplayerManager::enter: start() once a login may come in (straight
+// away, or when the admission queue lets it go), and ready() is called on
+// the main thread, from the AsyncLoop, when its save is in.
+//
+// Main thread only, apart from the load function, which runs on the
+// workers, several at once, and must be thread-safe. A peer that leaves
+// while its load is in flight is cancel()ed; the result is dropped when it
+// lands, even if ENet has handed the same peer to someone new by then.
+class SessionLoader {
+public:
+    using Clock  = std::chrono::steady_clock;
+    using LoadFn = std::function<PlayerSession(uint64_t uid)>;
+
+    struct Stats {
+        size_t   loading = 0;
+        uint64_t loaded  = 0;
+        float    worstMs = 0.f; // since the last takeStats
+    };
+
+    using ReadyFn = std::function<void(ENetPeer*, PlayerSession&)>;
+
+    // For each load that finished for a peer still waiting on it
+    ReadyFn ready;
+
+    SessionLoader(AsyncLoop& loop, LoadFn load) : _loop(loop), _load(std::move(load)) {}
+
+    void start(ENetPeer* peer, uint64_t uid) {
+        uint64_t ticket = ++_nextTicket;
+        _loading[peer]  = ticket;
+        _loop.spawn(load(peer, ticket, uid));
+    }
+
+    void cancel(ENetPeer* peer) { _loading.erase(peer); }
+
+    bool loading(ENetPeer* peer) const { return _loading.count(peer) != 0; }
+    bool busy() const { return !_loading.empty(); }
+    size_t loadingCount() const { return _loading.size(); }
+
+    Stats takeStats() {
+        Stats s{_loading.size(), _loaded, _worstMs};
+        _worstMs = 0.f;
+        return s;
+    }
+
+private:
+    Async<> load(ENetPeer* peer, uint64_t ticket, uint64_t uid) {
+        auto since = Clock::now();
+        PlayerSession session = co_await _loop.run(_pool, [this, uid] { return _load(uid); });
+        auto it = _loading.find(peer);
+        if (it == _loading.end() || it->second != ticket) co_return;
+        _loading.erase(it);
+        _loaded++;
+        _worstMs = std::max(_worstMs, std::chrono::duration<float, std::milli>(Clock::now() - since).count());
+        if (ready) ready(peer, session);
+    }
+
+    AsyncLoop& _loop;
+    LoadFn     _load;
+
+    std::unordered_map<ENetPeer*, uint64_t> _loading; // peer → ticket of its live load
+    uint64_t                                _nextTicket = 0;
+
+    uint64_t _loaded  = 0;
+    float    _worstMs = 0.f;
+
+    // Last, so the workers are joined before the frames they finish into go
+    ThreadPool _pool{Config::SESSION_LOAD_WORKERS};
+};
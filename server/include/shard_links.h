@@ -0,0 +1,88 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <enet/enet.h>
+#include "shard_map.h"
+#include "shard_packets.h"
+
+// ── ShardLinks ────────────────────────────────────────────────────────────────
+// This shard's end of the links between shards.
+//
+// Outbound: an ENet connection to every other shard in the map, from a
+// client host of its own, opened with a ShardHello and retried every
+// SHARD_RECONNECT_MS while it's down. It's serviced from the simulation
+// loop (service(), after the Outbox flush) rather than a thread: nothing
+// but acks comes back on it, and the loop wakes for every slot.
+//
+// Inbound: the other shards' links arrive on the game port like any peer.
+// A ShardHello with the right secret makes one a link, and only links are
+// heard on the shard packets.
+//
+// Handoff tickets another shard sent ahead of a player wait here until the
+// player logs in with one, or SHARD_TICKET_TTL_S passes.
+class ShardLinks {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Throws if the client host can't be created
+    ShardLinks(const ShardMap& map, uint16_t self, std::string secret);
+    ~ShardLinks();
+
+    ShardLinks(const ShardLinks&)            = delete;
+    ShardLinks& operator=(const ShardLinks&) = delete;
+
+    uint16_t self() const { return _self; }
+
+    // ── Outbound ──────────────────────────────────────────────────────────
+    // Connects what's down, sends what's queued; once per loop iteration
+    void service();
+    bool up(uint16_t shard) const;
+    // Reliable on the gameplay channel, or unreliable-sequenced on the
+    // movement channel; false if the link isn't up
+    bool send(uint16_t shard, const uint8_t* d, size_t len, bool movement = false);
+
+    // ── Inbound ───────────────────────────────────────────────────────────
+    // False if the secret or the shard is wrong; the peer stays a stranger
+    bool onHello(ENetPeer* peer, const ShardHelloPacket& hello);
+    // The shard a peer is the link from, or -1
+    int shardOf(ENetPeer* peer) const;
+    // As shardOf, and forgets the peer
+    int onDisconnect(ENetPeer* peer);
+
+    // ── Handoff tickets ───────────────────────────────────────────────────
+    uint64_t newTicket() { return _rng() | 1; } // never 0
+    void     expect(ShardHandoffPacket handoff);
+    // The handoff a login token names, once
+    std::optional<ShardHandoffPacket> claim(const std::string& token);
+
+private:
+    struct Link {
+        uint16_t          shard = 0;
+        ENetPeer*         peer  = nullptr;
+        bool              up    = false;
+        Clock::time_point retryAt{};
+    };
+    struct Ticket {
+        ShardHandoffPacket handoff;
+        Clock::time_point  expires;
+    };
+
+    Link* linkOf(ENetPeer* peer);
+    void  expire();
+
+    const ShardMap&   _map;
+    uint16_t          _self;
+    std::string       _secret;
+    ENetHost*         _host = nullptr;
+    std::vector<Link> _links; // ENetPeer::data = index + 1
+    PacketWriter      _hello;
+
+    std::unordered_map<ENetPeer*, uint16_t>  _inbound;
+    std::unordered_map<std::string, Ticket>  _tickets; // by login token
+    std::mt19937_64                          _rng{std::random_device{}()};
+};
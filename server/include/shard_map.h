@@ -0,0 +1,105 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <glm/vec3.hpp>
+#include "chunk.h"
+#include "config.h"
+#include "log.h"
+#include "region_store.h"
+
+// ── ShardMap ──────────────────────────────────────────────────────────────────
+// How the world is split between server processes. The unit is a region
+// column: RegionStore's REGION-chunk cubes stacked top to bottom, so every
+// region file has one owner and no two processes ever write the same one.
+// Read from the --shards file, one shard per line ("#" starts a comment):
+//   shard <id> <host> <port> <rx0> <rz0> <rx1> <rz1>
+// owning the region columns rx0..rx1 by rz0..rz1, inclusive; host:port is
+// where players and the other shards reach it. Columns no line names are
+// shard 0's, so the world has no holes. With no file there's one shard, 0,
+// owning everything, and nothing here is consulted.
+class ShardMap {
+public:
+    struct Shard {
+        uint16_t    id   = 0;
+        std::string host;
+        uint16_t    port = 0;
+        int         rx0 = 0, rz0 = 0, rx1 = -1, rz1 = -1;
+    };
+
+    static constexpr float COLUMN = (float)(RegionStore::REGION * ChunkData::SIZE); // blocks
+
+    bool load(const std::string& path) {
+        std::ifstream f(path);
+        if (!f) {
+            Log::err("ShardMap: cannot read " + path);
+            return false;
+        }
+        _shards.clear();
+        std::string line;
+        for (int n = 1; std::getline(f, line); n++) {
+            line = line.substr(0, line.find('#'));
+            std::istringstream in(line);
+            std::string word;
+            if (!(in >> word)) continue;
+            Shard s;
+            int id = -1, port = 0;
+            if (word != "shard" || !(in >> id >> s.host >> port >> s.rx0 >> s.rz0 >> s.rx1 >> s.rz1) ||
+                id < 0 || id > 0xFFFF || port <= 0 || port > 0xFFFF || find((uint16_t)id)) {
+                Log::err("ShardMap: " + path + ":" + std::to_string(n) + ": bad line");
+                return false;
+            }
+            s.id   = (uint16_t)id;
+            s.port = (uint16_t)port;
+            _shards.push_back(std::move(s));
+        }
+        if (!find(0)) {
+            Log::err("ShardMap: " + path + " has no shard 0");
+            return false;
+        }
+        return true;
+    }
+
+    bool sharded() const { return !_shards.empty(); }
+    const std::vector<Shard>& shards() const { return _shards; }
+
+    const Shard* find(uint16_t id) const {
+        for (const Shard& s : _shards)
+            if (s.id == id) return &s;
+        return nullptr;
+    }
+
+    uint16_t ownerOfColumn(int rx, int rz) const {
+        for (const Shard& s : _shards)
+            if (rx >= s.rx0 && rx <= s.rx1 && rz >= s.rz0 && rz <= s.rz1) return s.id;
+        return 0;
+    }
+    uint16_t ownerOfRegion(ChunkCoord region) const { return ownerOfColumn(region.x, region.z); }
+    uint16_t ownerAt(glm::vec3 p) const {
+        return ownerOfColumn((int)std::floor(p.x / COLUMN), (int)std::floor(p.z / COLUMN));
+    }
+
+    // Horizontal blocks from p to the nearest column of shard id's, looking
+    // no further than reach; past that, infinity. 0 inside it.
+    float distanceTo(uint16_t id, glm::vec3 p, float reach) const {
+        float best = std::numeric_limits<float>::infinity();
+        int   x0 = (int)std::floor((p.x - reach) / COLUMN), x1 = (int)std::floor((p.x + reach) / COLUMN);
+        int   z0 = (int)std::floor((p.z - reach) / COLUMN), z1 = (int)std::floor((p.z + reach) / COLUMN);
+        for (int rx = x0; rx <= x1; rx++)
+        for (int rz = z0; rz <= z1; rz++) {
+            if (ownerOfColumn(rx, rz) != id) continue;
+            float dx = std::max({rx * COLUMN - p.x, 0.f, p.x - (rx + 1) * COLUMN});
+            float dz = std::max({rz * COLUMN - p.z, 0.f, p.z - (rz + 1) * COLUMN});
+            best = std::min(best, std::sqrt(dx * dx + dz * dz));
+        }
+        return best <= reach ? best : std::numeric_limits<float>::infinity();
+    }
+
+private:
+    std::vector<Shard> _shards;
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "chunk.h"
+#include "chunk_cache.h"
+
+// ── SharedChunkCache ──────────────────────────────────────────────────────────
+// Generated chunks shared by every server process on one host that runs the
+// same world: a shared memory segment, named after the world id, holding an
+// open-addressing table and a ring arena for payloads. Whoever generates a
+// chunk first publishes it; the others copy it out instead of generating it,
+// so generation CPU and memory scale with world area, not instance count.
+// The segment outlives the processes, so a restart starts warm.
+//
+// Only pristine payloads go in — generated fields and LOD cell meshes, never
+// anything edited or loaded from a region file, which is per instance.
+//
+// Nothing takes a lock. A slot is a seqlock: a writer claims it by making its
+// sequence odd, fills it in, and makes it even again; a reader that sees the
+// sequence change, or odd, skips the slot. The arena is written strictly in
+// order, at a position that only grows: a payload at position p is gone
+// once the position passes p + arena size, and a reader checks that after
+// copying the bytes out, so it never returns ones overwritten under it.
+// Worst cases are a miss and a duplicate; both just cost a generation.
+//
+// Linux and other POSIX systems only; elsewhere open() reports it and
+// returns nullptr.
+class SharedChunkCache {
+public:
+    struct Stats {
+        uint64_t hits = 0, misses = 0, puts = 0;
+        size_t   slots = 0, arenaBytes = 0;
+    };
+
+    // Maps the world's segment, creating it at about sizeBytes if it's new;
+    // an existing one keeps the size it was made with. nullptr on failure.
+    static std::unique_ptr<SharedChunkCache> open(uint32_t world, size_t sizeBytes);
+    ~SharedChunkCache();
+
+    SharedChunkCache(const SharedChunkCache&)            = delete;
+    SharedChunkCache& operator=(const SharedChunkCache&) = delete;
+
+    // A copy of the payload, or nullptr. mesh picks the encoding.
+    ChunkPayload get(const ChunkKey& key, bool mesh);
+    void         put(const ChunkKey& key, bool mesh, const std::vector<uint8_t>& bytes);
+
+    Stats stats() const;
+    const std::string& name() const { return _name; }
+
+private:
+    struct Header;
+    struct Slot;
+
+    SharedChunkCache() = default;
+
+    Header*     _hdr   = nullptr;
+    Slot*       _slots = nullptr;
+    uint8_t*    _arena = nullptr;
+    void*       _map   = nullptr;
+    size_t      _mapBytes = 0;
+    std::string _name;
+
+    std::atomic<uint64_t> _hits{0}, _misses{0}, _puts{0};
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/geometric.hpp>
+#include "config.h"
+#include "thread_pool.h"
+
+// ── SimRegions ────────────────────────────────────────────────────────────────
+// Runs a simulation tick as independent regions across a pool of its own.
+// partition() first groups the players into islands: any two within
+// SIM_ISLAND_LINK of each other share one, transitively apart, so what a
+// system steps next to one player can't reach a player of another island.
+// A system then cuts its work into regions (an island's share, in batches)
+// and run() steps them in parallel, the calling thread taking its turn.
+//
+// A region writes only what's its own. Anything that crosses over (damage
+// to a player, say) it queues, and the caller applies the queues once run()
+// returns, region by region: regions are numbered from the islands and the
+// caller's own order, never from which thread got where first, so a tick
+// comes out the same on any number of threads.
+class SimRegions {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // threads: helpers besides the calling thread; 0 runs everything on it
+    explicit SimRegions(int threads) : _threads(std::max(0, threads)) {
+        if (_threads > 0) _pool = std::make_unique<ThreadPool>(_threads);
+    }
+
+    int threads() const { return _threads; }
+
+    // Islands of the n positions posOf(i), numbered in order of each one's
+    // first position
+    template<class Pos>
+    void partition(size_t n, Pos&& posOf) {
+        constexpr float L = Config::SIM_ISLAND_LINK;
+        _parent.resize(n);
+        std::iota(_parent.begin(), _parent.end(), 0u);
+        for (auto& [key, cell] : _cells) cell.clear();
+        for (size_t i = 0; i < n; i++) {
+            glm::vec3 p = posOf(i);
+            int cx = (int)std::floor(p.x / L), cz = (int)std::floor(p.z / L);
+            for (int dx = -1; dx <= 1; dx++)
+                for (int dz = -1; dz <= 1; dz++) {
+                    auto cell = _cells.find(key(cx + dx, cz + dz));
+                    if (cell == _cells.end()) continue;
+                    for (uint32_t j : cell->second) {
+                        glm::vec3 d = posOf(j) - p;
+                        if (glm::dot(d, d) <= L * L) unite((uint32_t)i, j);
+                    }
+                }
+            _cells[key(cx, cz)].push_back((uint32_t)i);
+        }
+        _island.assign(n, NONE);
+        _rootIsland.assign(n, NONE);
+        _islands = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint32_t& id = _rootIsland[find((uint32_t)i)];
+            if (id == NONE) id = _islands++;
+            _island[i] = id;
+        }
+    }
+
+    uint32_t islands() const { return _islands; }
+    uint32_t island(size_t i) const { return _island[i]; }
+
+    // fn(r) for every r below n, spread over the pool and the calling
+    // thread; returns once every one has
+    template<class F>
+    void run(size_t n, F&& fn) {
+        size_t helpers = std::min(n > 0 ? n - 1 : 0, (size_t)_threads);
+        if (helpers == 0) {
+            for (size_t r = 0; r < n; r++) fn(r);
+            return;
+        }
+        using Fn = std::remove_reference_t<F>;
+        _fn   = const_cast<void*>(static_cast<const void*>(&fn));
+        _call = [](void* f, size_t r) { (*static_cast<Fn*>(f))(r); };
+        _n    = n;
+        _next.store(0, std::memory_order_relaxed);
+        {
+            std::lock_guard lk(_mu);
+            _busy = helpers;
+        }
+        for (size_t h = 0; h < helpers; h++)
+            _pool->submit([this] {
+                drain();
+                std::lock_guard lk(_mu);
+                if (--_busy == 0) _cv.notify_one();
+            }, TaskPriority::Urgent);
+        drain();
+        std::unique_lock lk(_mu);
+        _cv.wait(lk, [&] { return _busy == 0; });
+    }
+
+private:
+    static uint64_t key(int x, int z) { return (uint64_t)(uint32_t)x << 32 | (uint32_t)z; }
+
+    uint32_t find(uint32_t i) {
+        while (_parent[i] != i) i = _parent[i] = _parent[_parent[i]];
+        return i;
+    }
+    void unite(uint32_t a, uint32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a != b) _parent[std::max(a, b)] = std::min(a, b);
+    }
+
+    void drain() {
+        for (size_t r; (r = _next.fetch_add(1, std::memory_order_relaxed)) < _n;) _call(_fn, r);
+    }
+
+    int                         _threads;
+    std::unique_ptr<ThreadPool> _pool;
+    // By link-sized column, kept between ticks
+    std::unordered_map<uint64_t, std::vector<uint32_t>> _cells;
+    std::vector<uint32_t>       _parent, _island, _rootIsland;
+    uint32_t                    _islands = 0;
+
+    // The run in progress
+    void*                   _fn = nullptr;
+    void                  (*_call)(void*, size_t) = nullptr;
+    size_t                  _n = 0;
+    std::atomic<size_t>     _next{0};
+    std::mutex              _mu;
+    std::condition_variable _cv;
+    size_t                  _busy = 0; // helpers still draining
+};
@@ -1,108 +1,162 @@
 #pragma once
 #include <enet/enet.h>
-#include <unordered_map>
+#include <cstdint>
 #include "player_stats.h"
-#include "net_common.h"
+#include "player_registry.h"
+#include "outbox.h"
 
+// Server-authoritative stats. Regen isn't stepped per tick: stamina and mana
+// are kept as of a timestamp and brought up to date when read or changed,
+// and the client runs the same PlayerStats::regen, so a player regenerating
+// costs nothing on either end. Damage, spends and the like mark the fields
+// they touch; flushDirty walks only the players on the dirty list and sends
+// just those fields through the Outbox, bundled with that peer's other
+// small messages. Each player's entry is a component in the PlayerRegistry.
 class StatsManager {
 public:
-    void onPlayerConnect(ENetPeer* peer) {
-        _stats[peer] = PlayerStats{};
-        _dirty[peer] = true;
+    StatsManager(Outbox& out, PlayerRegistry& players) : _out(out), _players(players) {}
+
+    void onPlayerConnect(ENetPeer* peer, const PlayerStats& stats = {}) {
+        if (Entry* old = _players.get<Entry>(peer); old && old->dirty) unlink(old);
+        Entry* e = _players.emplace<Entry>(peer);
+        if (!e) return;
+        e->stats = stats;
+        e->peer  = peer;
+        e->at    = _now;
     }
 
     void onPlayerDisconnect(ENetPeer* peer) {
-        _stats.erase(peer);
-        _dirty.erase(peer);
+        Entry* e = _players.get<Entry>(peer);
+        if (!e) return;
+        if (e->dirty) unlink(e);
+        _players.erase<Entry>(peer);
     }
 
+    // Up to date as of the current tick
     PlayerStats* get(ENetPeer* peer) {
-        auto it = _stats.find(peer);
-        return it != _stats.end() ? &it->second : nullptr;
+        Entry* e = _players.get<Entry>(peer);
+        if (!e) return nullptr;
+        settle(*e);
+        return &e->stats;
     }
 
-    void markDirty(ENetPeer* peer) { _dirty[peer] = true; }
+    // After changing fields through get() directly
+    void markDirty(ENetPeer* peer, uint8_t fields = StatsDeltaPacket::FIELDS) {
+        if (Entry* e = _players.get<Entry>(peer)) mark(*e, fields);
+    }
 
     // Call when player takes damage (after armour reduction)
     void applyDamage(ENetPeer* peer, float raw) {
-        auto* s = get(peer);
-        if (!s || s->dead) return;
-        float reduced = raw * (1.f - s->armour / (s->armour + 100.f)); // diminishing returns
-        s->health -= reduced;
-        s->clamp();
-        _dirty[peer] = true;
+        Entry* e = live(peer);
+        if (!e) return;
+        PlayerStats& s = e->stats;
+        float reduced = raw * (1.f - s.armour / (s.armour + 100.f)); // diminishing returns
+        s.health -= reduced;
+        s.clamp();
+        mark(*e, StatsDeltaPacket::Health);
     }
 
     void applyHeal(ENetPeer* peer, float amount) {
-        auto* s = get(peer);
-        if (!s || s->dead) return;
-        s->health += amount;
-        s->clamp();
-        _dirty[peer] = true;
+        Entry* e = live(peer);
+        if (!e) return;
+        e->stats.health += amount;
+        e->stats.clamp();
+        mark(*e, StatsDeltaPacket::Health);
     }
 
     void spendMana(ENetPeer* peer, float amount) {
-        auto* s = get(peer);
-        if (!s) return;
-        s->mana -= amount;
-        s->clamp();
-        _dirty[peer] = true;
+        Entry* e = _players.get<Entry>(peer);
+        if (!e) return;
+        settle(*e);
+        e->stats.mana -= amount;
+        e->stats.clamp();
+        mark(*e, StatsDeltaPacket::Mana);
     }
 
     void respawn(ENetPeer* peer) {
-        auto* s = get(peer);
-        if (!s) return;
-        s->reset();
-        _dirty[peer] = true;
+        Entry* e = _players.get<Entry>(peer);
+        if (!e) return;
+        e->stats.reset();
+        e->at = _now;
         // Send full sync on respawn
         sendFullSync(peer);
     }
 
-    // Called every server tick with dt
-    void update(float dt) {
-        for (auto& [peer, stats] : _stats) {
-            if (stats.dead) continue;
-            bool changed = false;
-
-            // Stamina regen
-            if (stats.stamina < stats.staminaMax) {
-                stats.stamina += 15.f * dt;
-                if (stats.stamina > stats.staminaMax) stats.stamina = stats.staminaMax;
-                changed = true;
-            }
-
-            // Mana regen
-            if (stats.mana < stats.manaMax) {
-                stats.mana += 5.f * dt;
-                if (stats.mana > stats.manaMax) stats.mana = stats.manaMax;
-                changed = true;
-            }
-
-            if (changed) _dirty[peer] = true;
-        }
-    }
+    // Called every server tick with dt; only advances the clock regen is
+    // measured against
+    void update(float dt) { _now += dt; }
 
-    // Send delta packets for dirty stats (call at ~10Hz from server tick)
+    // Send deltas for dirty players (call at ~10Hz from server tick)
     void flushDirty() {
-        for (auto& [peer, dirty] : _dirty) {
-            if (!dirty) continue;
-            auto* s = get(peer);
-            if (!s) continue;
-            auto pkt = StatsDeltaPacket::from(*s);
-            Net::sendReliable(peer, pkt.serialize());
-            dirty = false;
+        for (Entry* e = _dirtyHead; e;) {
+            Entry* next = e->nextDirty;
+            settle(*e);
+            StatsDeltaPacket::from(e->stats, e->dirty).write(_writer);
+            _out.reliable(e->peer, _writer.data(), _writer.size());
+            e->dirty     = 0;
+            e->nextDirty = nullptr;
+            e = next;
         }
+        _dirtyHead = nullptr;
     }
 
     void sendFullSync(ENetPeer* peer) {
-        auto* s = get(peer);
-        if (!s) return;
-        auto pkt = StatsSyncPacket::from(*s);
-        Net::sendReliable(peer, pkt.serialize());
-        _dirty[peer] = false;
+        Entry* e = _players.get<Entry>(peer);
+        if (!e) return;
+        settle(*e);
+        _out.reliable(peer, StatsSyncPacket::from(e->stats).serialize());
+        if (e->dirty) unlink(e); // the sync already carries it
     }
 
 private:
-    std::unordered_map<ENetPeer*, PlayerStats> _stats;
-    std::unordered_map<ENetPeer*, bool>        _dirty;
+    // Left in place when another player's goes, so the dirty list's
+    // pointers stay good
+    struct Entry {
+        static constexpr bool in_place_delete = true;
+
+        ENetPeer*   peer = nullptr;
+        PlayerStats stats;              // stamina/mana as of `at`
+        double      at   = 0.0;
+        uint8_t     dirty = 0;          // StatsDeltaPacket fields not yet sent
+        Entry*      nextDirty = nullptr;
+    };
+
+    void settle(Entry& e) {
+        e.stats.regen((float)(_now - e.at));
+        e.at = _now;
+    }
+
+    // Settled, or nullptr if unknown or dead
+    Entry* live(ENetPeer* peer) {
+        Entry* e = _players.get<Entry>(peer);
+        if (!e || e->stats.dead) return nullptr;
+        settle(*e);
+        return e;
+    }
+
+    void mark(Entry& e, uint8_t fields) {
+        if (!(fields & StatsDeltaPacket::FIELDS)) return;
+        if (!e.dirty) {
+            e.nextDirty = _dirtyHead;
+            _dirtyHead  = &e;
+        }
+        e.dirty |= fields & StatsDeltaPacket::FIELDS;
+    }
+
+    // Rare (disconnect, full sync), so a walk of the list is fine
+    void unlink(Entry* e) {
+        for (Entry** p = &_dirtyHead; *p; p = &(*p)->nextDirty) {
+            if (*p != e) continue;
+            *p = e->nextDirty;
+            break;
+        }
+        e->dirty     = 0;
+        e->nextDirty = nullptr;
+    }
+
+    Outbox&         _out;
+    PlayerRegistry& _players;
+    Entry*          _dirtyHead = nullptr;
+    double          _now = 0.0;
+    PacketWriter    _writer;   // reused by flushDirty
 };
@@ -0,0 +1,125 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// Fixed-rate slots for the server main loop. Each slot runs on its own
+// deadline grid (start + n·period), so rates don't drift with loop jitter and
+// the loop can block (on the network thread's events) until the next
+// deadline instead of polling.
+//
+// A slot that falls behind catches up by at most maxCatchUp back-to-back
+// runs; anything beyond that is skipped and the grid restarts from now.
+// Either way the slot counts an overrun, and the worst lateness and run time
+// are kept for the status log.
+//
+// Deadlines follow steady_clock unless setClock() swaps in another source —
+// replay runs the slots on the capture's timeline. Run times are always
+// measured on the real clock, and handed to the run hook if one is set.
+class TickScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Now   = std::function<Clock::time_point()>;
+    // name lives as long as the slot
+    using RunHook = std::function<void(const char* name, Clock::time_point t0, Clock::time_point t1)>;
+
+    struct SlotStats {
+        std::string name;
+        uint64_t    runs       = 0;
+        uint64_t    overruns   = 0; // started a period late, or ran longer than one
+        uint64_t    skipped    = 0; // steps dropped past maxCatchUp
+        float       worstLateMs = 0.f;
+        float       worstRunMs  = 0.f;
+        double      totalRunMs  = 0.0; // like runs, never reset
+    };
+
+    // Before the first add()
+    void setClock(Now now) { _now = std::move(now); }
+    void setRunHook(RunHook hook) { _hook = std::move(hook); }
+
+    // fn(dt) gets the slot period in seconds, so simulation code sees a
+    // fixed step no matter how late the loop woke up.
+    void add(std::string name, double hz, std::function<void(float)> fn, int maxCatchUp = 1) {
+        Slot s;
+        s.stats.name = std::move(name);
+        s.period     = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / hz));
+        s.next       = _now() + s.period;
+        s.fn         = std::move(fn);
+        s.maxCatchUp = std::max(1, maxCatchUp);
+        _slots.push_back(std::move(s));
+    }
+
+    // Run every slot whose deadline has passed.
+    void runDue() {
+        for (Slot& s : _slots) {
+            auto now = _now();
+            if (now < s.next) continue;
+
+            float late = ms(now - s.next);
+            s.stats.worstLateMs = std::max(s.stats.worstLateMs, late);
+            if (now - s.next >= s.period) s.stats.overruns++;
+
+            float dt = std::chrono::duration<float>(s.period).count();
+            for (int step = 0; step < s.maxCatchUp && now >= s.next; step++) {
+                auto t0 = Clock::now();
+                s.fn(dt);
+                s.next += s.period;
+                s.stats.runs++;
+                auto t1  = Clock::now();
+                auto run = t1 - t0;
+                if (_hook) _hook(s.stats.name.c_str(), t0, t1);
+                if (run > s.period) s.stats.overruns++;
+                s.stats.worstRunMs = std::max(s.stats.worstRunMs, ms(run));
+                s.stats.totalRunMs += ms(run);
+                now = _now();
+            }
+            if (now >= s.next) {
+                // Still behind — drop the backlog rather than spiral
+                s.stats.skipped += (uint64_t)((now - s.next) / s.period) + 1;
+                s.next = now + s.period;
+            }
+        }
+    }
+
+    // Milliseconds until the earliest deadline, rounded up (ENet timeouts are
+    // whole ms), capped at maxMs.
+    int msUntilNext(int maxMs = 1000) const {
+        auto now  = _now();
+        auto next = now + std::chrono::milliseconds(maxMs);
+        for (const Slot& s : _slots) next = std::min(next, s.next);
+        if (next <= now) return 0;
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(next - now).count();
+        return (int)((us + 999) / 1000);
+    }
+
+    // Snapshot and reset the worst-case figures
+    std::vector<SlotStats> takeStats() {
+        std::vector<SlotStats> out;
+        out.reserve(_slots.size());
+        for (Slot& s : _slots) {
+            out.push_back(s.stats);
+            s.stats.worstLateMs = s.stats.worstRunMs = 0.f;
+        }
+        return out;
+    }
+
+private:
+    struct Slot {
+        SlotStats                  stats;
+        Clock::duration            period{};
+        Clock::time_point          next{};
+        std::function<void(float)> fn;
+        int                        maxCatchUp = 1;
+    };
+
+    static float ms(Clock::duration d) {
+        return std::chrono::duration<float, std::milli>(d).count();
+    }
+
+    std::vector<Slot> _slots;
+    Now               _now = Clock::now;
+    RunHook           _hook;
+};
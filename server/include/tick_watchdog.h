@@ -0,0 +1,165 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include "log.h"
+
+// ── TickWatchdog ──────────────────────────────────────────────────────────────
+// Always-on timings of every main-loop iteration, for the rare stall the
+// averages hide. Scopes — each packet handler, each tick slot, each step of
+// the iteration's tail — land in a fixed array reused every tick: two clock
+// reads and a store, nothing allocated or locked. endTick() keeps the
+// tick's length in a ring of the last HISTORY.
+//
+// A tick longer than the threshold is written out whole to
+//   <dir>/slow-tick-<YYYYmmdd-HHMMSS>-<tick>.json
+// as Chrome trace events (ui.perfetto.dev, chrome://tracing), with the
+// figures the caller hands endTick() — pool queue depths and the like — and
+// the ticks before it under "otherData". At most one file every
+// MIN_DUMP_GAP, so a server slow throughout doesn't also fill the disk; the
+// ones skipped are still counted. Simulation thread only.
+class TickWatchdog {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t SPANS_MAX = 4096; // per tick; past this they're counted, not kept
+    static constexpr size_t HISTORY   = 64;
+    static constexpr auto   MIN_DUMP_GAP = std::chrono::seconds(1);
+
+    // Named figures for a slow tick's dump
+    using Figures = std::vector<std::pair<const char*, double>>;
+
+    // 0 ms: off — scopes still cost their clock reads, nothing is written
+    TickWatchdog(std::string dir, double thresholdMs)
+        : _dir(std::move(dir)), _threshold(std::chrono::duration_cast<Clock::duration>(
+                                    std::chrono::duration<double, std::milli>(thresholdMs))) {}
+
+    bool on() const { return _threshold.count() > 0 && !_dir.empty(); }
+
+    void beginTick() {
+        _spanCount = 0;
+        _overflow  = 0;
+        _start     = Clock::now();
+    }
+
+    // name: a string literal, or a string outliving the tick; detail: the
+    // packet ID and such, -1 for none
+    void record(const char* name, int detail, Clock::time_point t0, Clock::time_point t1) {
+        if (_spanCount == SPANS_MAX) { _overflow++; return; }
+        _spans[_spanCount++] = {name, detail, t0, t1};
+    }
+
+    class Scope {
+    public:
+        Scope(TickWatchdog& w, const char* name, int detail)
+            : _w(w), _name(name), _detail(detail), _t0(Clock::now()) {}
+        ~Scope() { _w.record(_name, _detail, _t0, Clock::now()); }
+        Scope(const Scope&)            = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        TickWatchdog&     _w;
+        const char*       _name;
+        int               _detail;
+        Clock::time_point _t0;
+    };
+    Scope scope(const char* name, int detail = -1) { return Scope(*this, name, detail); }
+
+    // figures() is called only for a tick over the threshold
+    void endTick(const std::function<void(Figures&)>& figures) {
+        auto end = Clock::now();
+        auto len = end - _start;
+        _history[_tick % HISTORY] = std::chrono::duration<float, std::milli>(len).count();
+        _tick++;
+        if (!on() || len < _threshold) return;
+        _slow++;
+        if (_lastDump != Clock::time_point{} && end - _lastDump < MIN_DUMP_GAP) {
+            _skipped++;
+            return;
+        }
+        _lastDump = end;
+        Figures f;
+        if (figures) figures(f);
+        dump(end, f);
+    }
+
+    uint64_t slowTicks()   const { return _slow; }
+    uint64_t skippedDumps() const { return _skipped; }
+
+private:
+    struct Span {
+        const char*       name;
+        int               detail;
+        Clock::time_point t0, t1;
+    };
+
+    void dump(Clock::time_point end, const Figures& figures) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        fs::create_directories(_dir, ec);
+        char stamp[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(stamp, sizeof stamp, "%Y%m%d-%H%M%S", std::localtime(&now));
+        const uint64_t tick = _tick - 1;
+        std::string path = (fs::path(_dir) / ("slow-tick-" + std::string(stamp) + "-" +
+                                              std::to_string(tick) + ".json")).string();
+        FILE* f = fopen(path.c_str(), "w");
+        if (!f) {
+            Log::warn("TickWatchdog: cannot write " + path);
+            return;
+        }
+        auto us = [&](Clock::time_point t) {
+            return (long long)std::chrono::duration_cast<std::chrono::microseconds>(t - _start).count();
+        };
+        const double ms = std::chrono::duration<double, std::milli>(end - _start).count();
+
+        fprintf(f, "{\"traceEvents\":[\n");
+        fprintf(f, "{\"name\":\"tick\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":0,\"dur\":%lld,"
+                   "\"args\":{\"tick\":%llu}}",
+                us(end), (unsigned long long)tick);
+        for (size_t i = 0; i < _spanCount; i++) {
+            const Span& s = _spans[i];
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%lld,\"dur\":%lld",
+                    s.name ? s.name : "?", us(s.t0), us(s.t1) - us(s.t0));
+            if (s.detail >= 0) fprintf(f, ",\"args\":{\"detail\":%d}", s.detail);
+            fputc('}', f);
+        }
+        fprintf(f, "\n],\"otherData\":{\"tick\":%llu,\"ms\":%.3f,\"threshold_ms\":%.3f,"
+                   "\"spans_dropped\":%zu,\"slow_ticks\":%llu,\"dumps_skipped\":%llu",
+                (unsigned long long)tick, ms,
+                std::chrono::duration<double, std::milli>(_threshold).count(), _overflow,
+                (unsigned long long)_slow, (unsigned long long)_skipped);
+        for (const auto& [name, v] : figures) fprintf(f, ",\"%s\":%.6g", name, v);
+        // Oldest first, this tick last
+        fprintf(f, ",\"previous_ms\":[");
+        size_t n = (size_t)std::min<uint64_t>(_tick, HISTORY);
+        for (size_t i = 0; i < n; i++)
+            fprintf(f, "%s%.3f", i ? "," : "", _history[(_tick - n + i) % HISTORY]);
+        fprintf(f, "]}}\n");
+        fclose(f);
+        Log::warn("Slow tick " + std::to_string(tick) + ": " + std::to_string((int)ms) + " ms, breakdown in " +
+                  path);
+    }
+
+    std::string     _dir;
+    Clock::duration _threshold;
+
+    std::array<Span, SPANS_MAX> _spans{};
+    size_t                      _spanCount = 0;
+    size_t                      _overflow  = 0;
+    Clock::time_point           _start{};
+
+    std::array<float, HISTORY> _history{};
+    uint64_t                   _tick    = 0;
+    uint64_t                   _slow    = 0;
+    uint64_t                   _skipped = 0;
+    Clock::time_point          _lastDump{};
+};
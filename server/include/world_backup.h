@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "inv_store.h"
+#include "region_store.h"
+#include "thread_pool.h"
+
+// Backups of a running world, with no tick waiting on the disk.
+//
+// begin() freezes an epoch on the simulation thread: InvStore::freeze()
+// (a map copy sharing every payload) and RegionStore::freeze() (taken on
+// its I/O thread after the saves already queued). Both stores go on taking
+// writes at once — a put replaces a payload rather than changing it, and a
+// save appends sectors rather than rewriting them — so what was frozen
+// stays as it was while this class's own thread streams it out:
+//
+//   <target>/<YYYYmmdd-HHMMSS>/inventories.snap   every chest and inventory
+//   <target>/<YYYYmmdd-HHMMSS>/r.X.Y.Z.bin        every region, compacted
+//
+// written under a ".partial" name and renamed once complete, so a backup
+// that's there is whole. Either file type drops into a world directory as
+// it is (an empty log replays over the snapshot to nothing). The newest
+// `keep` backups are kept.
+class WorldBackup {
+public:
+    WorldBackup(std::string target, int keep);
+    ~WorldBackup(); // finishes the backup under way
+
+    WorldBackup(const WorldBackup&)            = delete;
+    WorldBackup& operator=(const WorldBackup&) = delete;
+
+    // Simulation thread. False, freezing nothing, while the last backup is
+    // still being written.
+    bool begin(InvStore& inv, RegionStore& regions);
+
+    bool busy() const { return _busy.load(std::memory_order_acquire); }
+
+private:
+    struct Epoch {
+        std::string                     name;
+        InvStore::Frozen                inv;
+        RegionStore*                    store = nullptr;
+        TaskFuture<RegionStore::Frozen> regions;
+    };
+
+    void run();
+    bool write(Epoch& e);
+    void prune();
+
+    std::string _target;
+    int         _keep;
+
+    std::mutex              _mu;
+    std::condition_variable _cv;
+    Epoch                   _next;
+    bool                    _queued = false;
+    bool                    _stop   = false;
+    std::atomic<bool>       _busy{false};
+
+    std::thread _thread; // started last
+};
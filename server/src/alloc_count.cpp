@@ -0,0 +1,28 @@
+#include "alloc_count.h"
+
+#if defined(AETHERIS_COUNT_ALLOCS) && defined(AETHERIS_MEM_TAGS)
+#include "mem_tags.h"
+
+// MemTags has operator new already, and counts per thread as it goes
+uint64_t AllocCount::thisThread() { return MemTags::threadAllocs(); }
+#elif defined(AETHERIS_COUNT_ALLOCS)
+#include <cstdlib>
+#include <new>
+
+namespace {
+    thread_local uint64_t t_allocs = 0;
+}
+
+uint64_t AllocCount::thisThread() { return t_allocs; }
+
+// The array and nothrow forms forward here; aligned ones are left alone
+// and not counted
+void* operator new(std::size_t n) {
+    t_allocs++;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
@@ -0,0 +1,119 @@
+#include "chunk_gen.h"
+#include "noise_gen.h"
+#include "world_features.h"
+#include "marching_cubes.h"
+#include "mesh_optimize.h"
+#include "packets.h"
+#include "config.h"
+#include "log.h"
+#include "mem_tags.h"
+#include "big_pages.h"
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <sstream>
+
+// Mapped on the worker that uses it, so under BigPages' numaLocal it lands
+// on that worker's node
+ChunkData& workerData() {
+    static thread_local BigPages::Ptr<ChunkData> data;
+    if (!data) data = BigPages::make<ChunkData>();
+    return *data;
+}
+
+ChunkMesh& workerMesh() {
+    static thread_local ChunkMesh mesh;
+    return mesh;
+}
+
+// Payloads are charged to the chunk cache, whose they become; the rest of
+// a job is the generation pool's scratch
+ChunkPayload encodeField(ChunkCoord coord, const ChunkData& data, GenTimings& timings) {
+    MemTags::Scope tag(MemTags::ChunkCache);
+    if (data.fill != ChunkData::Fill::Mixed)
+        return std::make_shared<const std::vector<uint8_t>>(ChunkUniformPacket{coord, data.fill}.serialize());
+    Stage t(timings.serialize, "gen.serialize", {coord, 0});
+    return std::make_shared<const std::vector<uint8_t>>(ChunkFieldPacket::serialize(data));
+}
+
+ChunkPayload marchField(const ChunkKey& key, const ChunkPayload& field, GenTimings& timings) {
+    ChunkData& data = workerData();
+    ChunkMesh& mesh = workerMesh();
+    {
+        Stage t(timings.march, "gen.march", key);
+        if (!ChunkFieldPacket::deserialize(field->data(), field->size(), data)) {
+            Log::err("ChunkManager: corrupt field payload");
+            return nullptr;
+        }
+        marchChunk(data, mesh);
+    }
+    {
+        Stage t(timings.optimize, "gen.optimize", key);
+        optimizeMesh(mesh);
+    }
+    MemTags::Scope tag(MemTags::ChunkCache);
+    Stage t(timings.serialize, "gen.serialize", key);
+    return std::make_shared<const std::vector<uint8_t>>(ChunkDataPacket::serialize(mesh));
+}
+
+ChunkPayload buildLodCell(const ChunkKey& key, GenTimings& timings, bool& uniform) {
+    ChunkData& data = workerData();
+    {
+        Stage t(timings.noise, "gen.noise", key);
+        generateChunk(data, key.coord, key.lod);
+    }
+    uniform = data.fill != ChunkData::Fill::Mixed;
+
+    // Clears the scratch mesh even when there's nothing to march
+    MarchOptions opts;
+    opts.skirt = Config::LOD_SKIRT_CELLS;
+    ChunkMesh& mesh = workerMesh();
+    {
+        Stage t(timings.march, "gen.march", key);
+        marchChunk(data, mesh, opts);
+    }
+    {
+        Stage t(timings.optimize, "gen.optimize", key);
+        optimizeMesh(mesh);
+    }
+    mesh.lod = (uint8_t)key.lod;
+    // A mixed cell can still march to nothing at this resolution
+    ChunkData::Fill fill = data.fill == ChunkData::Fill::Mixed ? ChunkData::Fill::Air : data.fill;
+    MemTags::Scope tag(MemTags::ChunkCache);
+    Stage t(timings.serialize, "gen.serialize", key);
+    return std::make_shared<const std::vector<uint8_t>>(
+        mesh.indices.empty() ? ChunkUniformPacket{key.coord, fill}.serialize()
+                             : ChunkDataPacket::serialize(mesh));
+}
+
+uint32_t generatorWorldId() {
+    // The built-in graph and marching cubes add nothing, so the default
+    // world keeps its id
+    uint8_t  id[28];
+    uint64_t graph = terrainGraphId();
+    uint8_t* end   = putU32(putU32(putU32(putU32(id, (uint32_t)Config::WORLD_SEED), ChunkFieldPacket::WIRE_VERSION),
+                                   ChunkDataPacket::WIRE_VERSION), Features::VERSION);
+    if (graph) end = putU32(putU32(end, (uint32_t)graph), (uint32_t)(graph >> 32));
+    if (defaultMesher() != Mesher::Cubes) end = putU32(end, (uint32_t)defaultMesher());
+    uint64_t h = payloadHash(id, (size_t)(end - id));
+    return (uint32_t)(h ^ h >> 32) | 1; // never 0, which means no cache
+}
+
+bool loadTerrainGraph(const std::string& path) {
+    std::ifstream f(path);
+    if (!f) {
+        Log::err("Terrain graph " + path + " can't be read");
+        return false;
+    }
+    std::stringstream text;
+    text << f.rdbuf();
+    std::string err;
+    std::optional<Noise::Graph> graph = Noise::Graph::parse(text.str(), err);
+    if (!graph) {
+        Log::err("Terrain graph " + path + ": " + err);
+        return false;
+    }
+    useTerrainGraph(std::move(*graph));
+    Log::info("Terrain graph " + path + " (" + std::to_string(terrainGraphId()) + ")");
+    return true;
+}
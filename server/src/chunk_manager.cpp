@@ -1,135 +1,1590 @@
 #include "chunk_manager.h"
+#include "chunk_gen.h"
 #include "noise_gen.h"
+#include "world_features.h"
 #include "marching_cubes.h"
+#include "mesh_optimize.h"
 #include "net_common.h"
+#include "mp_packets.h"
+#include "log.h"
+#include "mem_tags.h"
 #include <cmath>
+#include <cstdio>
 #include <algorithm>
+#include <filesystem>
+#include <thread>
 
 static ChunkCoord worldToChunk(float wx, float wy, float wz) {
     int sz = ChunkData::SIZE;
     return { (int)std::floor(wx/sz), (int)std::floor(wy/sz), (int)std::floor(wz/sz) };
 }
 
-ChunkManager::ChunkManager(int genThreads)
-    : _pool(genThreads) {}
+ChunkManager::ChunkManager(PlayerRegistry& players, const ThreadPoolOptions& genPool,
+                           size_t cacheBudgetBytes, std::string worldDir)
+    : _cache(cacheBudgetBytes),
+      // A world of another graph is another world; the built-in one folds in 0
+      _regions(worldDir, (uint32_t)Config::WORLD_SEED ^ (uint32_t)terrainGraphId(), ChunkFieldPacket::WIRE_VERSION),
+      _players(players),
+      _worldDir(std::move(worldDir)),
+      _pool(genPool) {}
 
-ClientState* ChunkManager::findClient(ENetPeer* peer) {
-    for (auto& c : _clients)
-        if (c.peer == peer) return &c;
-    return nullptr;
+// Generation order: the player's own chunk, then the one below their feet
+// (PlayerController won't spawn until both arrive), then by squared distance
+// — to the centre of a LOD cell, in chunks, so each ring mostly queues
+// behind the finer one inside it.
+static float chunkPriority(const ChunkKey& key, ChunkCoord center) {
+    if (key.lod > 0) {
+        float s = (float)(1 << key.lod), half = (s - 1.f) * 0.5f;
+        float dx = key.coord.x * s + half - center.x;
+        float dy = key.coord.y * s + half - center.y;
+        float dz = key.coord.z * s + half - center.z;
+        return dx*dx + dy*dy + dz*dz;
+    }
+    int dx = key.coord.x - center.x, dy = key.coord.y - center.y, dz = key.coord.z - center.z;
+    if (dx == 0 && dz == 0 && dy ==  0) return -2.f;
+    if (dx == 0 && dz == 0 && dy == -1) return -1.f;
+    return (float)(dx*dx + dy*dy + dz*dz);
 }
 
-void ChunkManager::addClient(ENetPeer* peer) {
-    _clients.push_back({peer});
+// Prefetched chunks queue behind every chunk and LOD cell in anyone's view,
+// nearest the prefetching player first
+static constexpr float PREFETCH_PRIORITY = 1e6f;
+
+// f(coord) for every coord in box to but not in box from: up to three slabs,
+// one per axis, so an ordinary boundary crossing visits one face of the box
+// instead of all of it. An empty from is the whole of to.
+template<class F>
+static void forEachEntered(const ViewBox& from, const ViewBox& to, F&& f) {
+    auto inside = [](int v, int lo, int hi) { return v >= lo && v <= hi; };
+    for (int x = to.lo.x; x <= to.hi.x; x++) {
+        bool inX = inside(x, from.lo.x, from.hi.x);
+        for (int y = to.lo.y; y <= to.hi.y; y++) {
+            bool inY = inX && inside(y, from.lo.y, from.hi.y);
+            if (inY) {
+                // Only the z slab is left in this row
+                for (int z = to.lo.z; z <= to.hi.z; z++)
+                    if (!inside(z, from.lo.z, from.hi.z)) f(ChunkCoord{x, y, z});
+            } else {
+                for (int z = to.lo.z; z <= to.hi.z; z++) f(ChunkCoord{x, y, z});
+            }
+        }
+    }
+}
+
+// ── Client table ──────────────────────────────────────────────────────────────
+// Each client's ClientState is a component of its player (PlayerRegistry):
+// found through ENetPeer::data, and packed with the others for the passes
+// over every client.
+
+ClientState* ChunkManager::findClient(ENetPeer* peer) { return _players.get<ClientState>(peer); }
+
+ViewTiers ChunkManager::addClient(ENetPeer* peer, uint32_t caps, int viewRadius) {
+    if (findClient(peer)) removeClient(peer);
+    ClientState cs;
+    cs.peer = peer;
+    // A client marches fields with cubes; a nets server's meshes would
+    // differ from the ones it makes itself
+    cs.fields = (caps & CAP_CHUNK_FIELDS) != 0 && defaultMesher() == Mesher::Cubes;
+    cs.lod    = (caps & CAP_LOD_CHUNKS) != 0;
+    cs.packed = _dict && (caps & ChunkCodecs::cap(_dict->codec())) != 0;
+    cs.tiers  = ViewTiers::negotiate(viewRadius, cs.lod);
+    for (int lv = 0; lv <= cs.tiers.levels; lv++)
+        cs.levels[lv].sent.resize(cs.tiers.width(lv), cs.tiers.height(lv));
+    ViewTiers tiers = cs.tiers;
+    _players.emplace<ClientState>(peer, std::move(cs));
+    return tiers;
 }
 
 void ChunkManager::removeClient(ENetPeer* peer) {
-    _clients.erase(
-        std::remove_if(_clients.begin(), _clients.end(),
-            [peer](const ClientState& c){ return c.peer == peer; }),
-        _clients.end());
+    ClientState* cs = findClient(peer);
+    if (!cs) return;
+    for (const auto& key : cs->pendingChunks)
+        unsubscribe(peer, key);
+    for (const auto& key : cs->prefetch)
+        dropPrefetch(peer, key);
+    unpinView(*cs);
+    dropOutbound(*cs);
+    _players.erase<ClientState>(peer);
 }
 
 void ChunkManager::resetClient(ENetPeer* peer) {
     ClientState* cs = findClient(peer);
     if (!cs) return;
-    cs->sentChunks.clear();
+    for (const auto& key : cs->pendingChunks)
+        unsubscribe(peer, key);
+    for (const auto& key : cs->prefetch)
+        dropPrefetch(peer, key);
+    cs->prefetch.clear();
+    cs->prefetchDir[0] = cs->prefetchDir[1] = 0.f;
+    cs->prefetchAround = {INT_MIN, INT_MIN, INT_MIN};
+    cs->vel[0] = cs->vel[1] = 0.f;
+    cs->movedAt = {};
+    unpinView(*cs);
+    dropOutbound(*cs);
+    for (auto& l : cs->levels) {
+        l.sent.clear();
+        l.region = l.hole = {};
+    }
     cs->pendingChunks.clear();
     cs->lastChunk = {INT_MIN, INT_MIN, INT_MIN};
 }
 
+// The boxes are rebuilt around the same centre at the new size; sent bits
+// carry over where a cell stays in view, since the client keeps those
+ViewTiers ChunkManager::setViewRadius(ENetPeer* peer, int viewRadius) {
+    ClientState* cs = findClient(peer);
+    if (!cs) return {};
+    ViewTiers tiers = ViewTiers::negotiate(viewRadius, cs->lod);
+    if (tiers == cs->tiers) return tiers;
+
+    auto      old      = cs->levels;
+    ViewTiers oldTiers = cs->tiers;
+    bool      placed   = cs->lastChunk.x != INT_MIN;
+    unpinView(*cs);
+    cs->tiers = tiers;
+    for (int lv = 0; lv <= tiers.levels; lv++) {
+        ClientState::Level& l = cs->levels[lv];
+        l.sent.resize(tiers.width(lv), tiers.height(lv));
+        l.region = l.hole = {};
+        if (!placed) continue;
+        l.region = tiers.region(lv, cs->lastChunk);
+        l.hole   = tiers.hole(lv, cs->lastChunk);
+        forEachEntered(ViewBox{}, l.region, [&](ChunkCoord c) {
+            _cache.pin({c, lv});
+            if (lv <= oldTiers.levels && !l.hole.contains(c) && old[lv].sent.test(c, old[lv].region) &&
+                !old[lv].hole.contains(c))
+                l.sent.set(c, l.region);
+        });
+    }
+    if (!placed) return tiers;
+
+    for (auto it = cs->pendingChunks.begin(); it != cs->pendingChunks.end(); ) {
+        ChunkKey key = *it;
+        if (cs->wants(key)) { ++it; continue; }
+        it = cs->pendingChunks.erase(it);
+        unsubscribe(peer, key);
+    }
+    for (int lv = 0; lv <= tiers.levels; lv++) {
+        const ClientState::Level& l = cs->levels[lv];
+        forEachEntered(ViewBox{}, l.region, [&](ChunkCoord c) {
+            if (!l.hole.contains(c)) scheduleChunk(*cs, {c, lv});
+        });
+    }
+    return tiers;
+}
+
 // ── scheduleChunk ─────────────────────────────────────────────────────────────
-// Called on ENet thread. Checks cache; if hit sends immediately, else submits
-// a generation task to the thread pool.
+// Called on ENet thread. Checks cache; if hit sends immediately. Otherwise
+// subscribes the client to the key's in-flight job, queueing a generation
+// job only if no job for that key exists yet.
 
-void ChunkManager::scheduleChunk(ClientState& cs, ChunkCoord coord) {
-    if (cs.sentChunks.count(coord) || cs.pendingChunks.count(coord)) return;
+void ChunkManager::scheduleChunk(ClientState& cs, const ChunkKey& key) {
+    ClientState::Level& l = cs.levels[key.lod];
+    if (l.sent.test(key.coord, l.region) || cs.pendingChunks.count(key)) return;
 
-    // Check cache under lock
-    {
-        std::lock_guard lk(_cacheMu);
-        auto it = _cache.find(coord);
-        if (it != _cache.end()) {
-            // Already generated — push straight to ready queue
-            std::lock_guard rlk(_readyMu);
-            _ready.push({cs.peer, coord, it->second});
-            cs.sentChunks.insert(coord);
+    bool wantMesh = !cs.fields || key.lod > 0;
+    ChunkPayloads cached = _cache.get(key, wantMesh);
+    if (wantMesh ? cached.mesh : cached.field) {
+        // Already generated — push straight to ready queue
+        Trace::mark("server.cache_hit", key);
+        std::lock_guard lk(_readyMu);
+        _ready.push_back({{cs.peer}, key, std::move(cached)});
+        l.sent.set(key.coord, l.region);
+        return;
+    }
+
+    cs.pendingChunks.insert(key);
+    Trace::mark("server.schedule", key);
+
+    // An edit job owns the chunk until its result is out; that result
+    // serves this client too
+    if (key.lod == 0) {
+        auto e = _edits.find(key.coord);
+        if (e != _edits.end() && e->second.running) {
+            e->second.waiters.push_back(cs.peer);
             return;
         }
     }
 
-    cs.pendingChunks.insert(coord);
-    ENetPeer* peer = cs.peer;
+    auto [it, isNew] = _inFlight.try_emplace(key);
+    auto& subs = it->second.subscribers;
+    if (std::find(subs.begin(), subs.end(), cs.peer) == subs.end())
+        subs.push_back(cs.peer);
 
-    _pool.submit([this, peer, coord]() {
-        generateAndEnqueue(peer, coord);
-    });
+    if (isNew) queueJob(key, chunkPriority(key, cs.lastChunk), wantMesh,
+                        it->second.meshCancel);
+    else       requeueJob(key, jobPriority(key, it->second), wantMesh);
+}
+
+// Detach one peer from a key's job. The last subscriber leaving cancels the
+// job if no worker has picked it up yet and nobody is prefetching it; a job
+// already running keeps its field stage so the result still lands in the
+// cache, but skips meshing.
+void ChunkManager::unsubscribe(ENetPeer* peer, const ChunkKey& key) {
+    if (key.lod == 0) {
+        auto e = _edits.find(key.coord);
+        if (e != _edits.end()) {
+            auto& w = e->second.waiters;
+            w.erase(std::remove(w.begin(), w.end(), peer), w.end());
+        }
+    }
+    auto it = _inFlight.find(key);
+    if (it == _inFlight.end()) return;
+    auto& subs = it->second.subscribers;
+    subs.erase(std::remove(subs.begin(), subs.end(), peer), subs.end());
+
+    if (subs.empty() && it->second.prefetchers.empty()) {
+        if (cancelJob(key)) _inFlight.erase(it);
+        else                it->second.meshCancel.cancel();
+    } else {
+        requeueJob(key, jobPriority(key, it->second));
+    }
+}
+
+// A shared job runs as early as its most urgent subscriber needs it.
+float ChunkManager::jobPriority(const ChunkKey& key, const InFlightChunk& job) {
+    float best = 1e30f;
+    for (ENetPeer* peer : job.subscribers) {
+        ClientState* cs = findClient(peer);
+        if (cs) best = std::min(best, chunkPriority(key, cs->lastChunk));
+    }
+    for (ENetPeer* peer : job.prefetchers) {
+        ClientState* cs = findClient(peer);
+        if (cs) best = std::min(best, PREFETCH_PRIORITY + chunkPriority(key, cs->lastChunk));
+    }
+    return best;
+}
+
+// ── Velocity prefetch ─────────────────────────────────────────────────────────
+// A job for a chunk just past the view, ahead of a moving player. It joins
+// _inFlight with the player as a prefetcher rather than a subscriber, so
+// its result only goes to the cache — unless the player arrives first, when
+// scheduleChunk finds the job and subscribes to it like any other.
+
+void ChunkManager::prefetchChunk(ClientState& cs, const ChunkKey& key) {
+    if (cs.wants(key) || cs.pendingChunks.count(key)) return; // scheduleChunk's
+    bool wantMesh = !cs.fields;
+    ChunkPayloads cached = _cache.peek(key);
+    if (wantMesh ? cached.mesh : cached.field) return;
+    auto e = _edits.find(key.coord);
+    if (e != _edits.end() && e->second.running) return;
+
+    auto [it, isNew] = _inFlight.try_emplace(key);
+    auto& pf = it->second.prefetchers;
+    if (std::find(pf.begin(), pf.end(), cs.peer) != pf.end()) return;
+    pf.push_back(cs.peer);
+    cs.prefetch.push_back(key);
+    if (isNew) {
+        queueJob(key, PREFETCH_PRIORITY + chunkPriority(key, cs.lastChunk), wantMesh,
+                 it->second.meshCancel);
+        _prefetched.fetch_add(1, std::memory_order_relaxed);
+    } else if (wantMesh) {
+        requeueJob(key, jobPriority(key, it->second), true);
+    }
+}
+
+// As unsubscribe, for a prefetcher
+void ChunkManager::dropPrefetch(ENetPeer* peer, const ChunkKey& key) {
+    auto it = _inFlight.find(key);
+    if (it == _inFlight.end()) return; // done
+    auto& pf = it->second.prefetchers;
+    auto  p  = std::find(pf.begin(), pf.end(), peer);
+    if (p == pf.end()) return;
+    pf.erase(p);
+
+    if (it->second.subscribers.empty() && pf.empty()) {
+        if (cancelJob(key)) {
+            _inFlight.erase(it);
+            _prefetchCancelled.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            it->second.meshCancel.cancel();
+        }
+    } else {
+        requeueJob(key, jobPriority(key, it->second));
+    }
 }
 
-void ChunkManager::generateAndEnqueue(ENetPeer* peer, ChunkCoord coord) {
-    // Pure CPU work — no ENet calls here
-    ChunkData data = generateChunk(coord);
-    ChunkMesh mesh = marchChunk(data);
-    auto bytes = ChunkDataPacket::from(mesh).serialize();
+// The shell ahead of a moving player: the full-resolution view shifted along
+// their velocity, depth scaled by speed, minus the view itself. Rebuilt when
+// they cross a boundary, turn or change pace; left as it is while they stand
+// still, so a pause doesn't throw away what was queued.
+void ChunkManager::refreshPrefetch(ClientState& cs) {
+    const ViewBox& view = cs.levels[0].region;
+    if (view.empty()) return;
+    float speed = std::sqrt(cs.vel[0] * cs.vel[0] + cs.vel[1] * cs.vel[1]);
+    if (speed < Config::PREFETCH_MIN_SPEED) return;
 
+    float dir[2] = {cs.vel[0] / speed, cs.vel[1] / speed};
+    if (dir[0] * cs.prefetchDir[0] + dir[1] * cs.prefetchDir[1] < Config::PREFETCH_TURN_COS) {
+        cs.prefetchDir[0] = dir[0];
+        cs.prefetchDir[1] = dir[1];
+    }
+    int depth = std::clamp((int)std::ceil(speed * Config::PREFETCH_AHEAD_S / (float)ChunkData::SIZE), 1,
+                           Config::PREFETCH_DEPTH_MAX);
+    ChunkCoord shift{(int)std::lround(cs.prefetchDir[0] * depth), 0,
+                     (int)std::lround(cs.prefetchDir[1] * depth)};
+    if (shift == cs.prefetchShift && cs.prefetchAround == cs.lastChunk) return;
+    cs.prefetchShift  = shift;
+    cs.prefetchAround = cs.lastChunk;
+
+    ViewBox ahead{{view.lo.x + shift.x, view.lo.y, view.lo.z + shift.z},
+                  {view.hi.x + shift.x, view.hi.y, view.hi.z + shift.z}};
+    FlatSet<ChunkKey, ChunkKeyHash> shell;
+    forEachEntered(view, ahead, [&](ChunkCoord c) { shell.insert({c, 0}); });
+
+    // What fell out of the shell is called off; whatever's new in it is
+    // asked for
+    auto old = std::move(cs.prefetch);
+    cs.prefetch.clear();
+    for (const ChunkKey& key : old) {
+        if (shell.contains(key)) cs.prefetch.push_back(key);
+        else                     dropPrefetch(cs.peer, key);
+    }
+    forEachEntered(view, ahead, [&](ChunkCoord c) { prefetchChunk(cs, {c, 0}); });
+}
+
+// ── Job queue ─────────────────────────────────────────────────────────────────
+// The ThreadPool only knows coarse priority lanes, so it never sees chunk
+// keys directly. Each queued job submits one anonymous runNextJob task, and
+// whichever worker runs it pops the most urgent job at that moment.
+// Re-prioritizing just pushes a fresher heap entry and cancelling just
+// forgets the coord; stale entries are skipped on pop.
+
+void ChunkManager::queueJob(const ChunkKey& key, float priority, bool needMesh,
+                            CancelToken meshCancel) {
     {
-        std::lock_guard lk(_cacheMu);
-        _cache.emplace(coord, bytes);
+        std::lock_guard lk(_jobMu);
+        uint32_t stamp = _nextStamp++;
+        _queued[key] = {stamp, needMesh, std::move(meshCancel), Trace::on() ? Trace::nowUs() : 0};
+        _jobHeap.push({priority, stamp, key});
+    }
+    _pool.submit([this]() { runNextJob(); });
+}
+
+// Returns false if the job is no longer queued (already picked up).
+// needMesh only ever widens what the job produces.
+bool ChunkManager::requeueJob(const ChunkKey& key, float priority, bool needMesh) {
+    std::lock_guard lk(_jobMu);
+    auto it = _queued.find(key);
+    if (it == _queued.end()) return false;
+    it->second.stamp     = _nextStamp++;
+    it->second.needMesh |= needMesh;
+    _jobHeap.push({priority, it->second.stamp, key});
+    return true;
+}
+
+// Returns false if a worker already picked the job up.
+bool ChunkManager::cancelJob(const ChunkKey& key) {
+    std::lock_guard lk(_jobMu);
+    if (!_queued.erase(key)) return false;
+
+    // Re-prioritizing and cancelling leave stale entries behind; rebuild
+    // the heap if they start to dominate.
+    if (_jobHeap.size() > 64 && _jobHeap.size() > _queued.size() * 4) {
+        std::vector<GenJob> live;
+        live.reserve(_queued.size());
+        while (!_jobHeap.empty()) {
+            const GenJob& j = _jobHeap.top();
+            auto q = _queued.find(j.key);
+            if (q != _queued.end() && q->second.stamp == j.stamp) live.push_back(j);
+            _jobHeap.pop();
+        }
+        for (auto& j : live) _jobHeap.push(j);
     }
+    return true;
+}
+
+// The 3x3x3 around a player, by chunkPriority
+static constexpr float URGENT_PRIORITY = 3.f;
+
+void ChunkManager::runNextJob() {
+    ChunkKey    key;
+    bool        needMesh;
+    bool        urgent;
+    CancelToken meshCancel;
     {
-        std::lock_guard lk(_readyMu);
-        _ready.push({peer, coord, std::move(bytes)});
+        std::lock_guard lk(_jobMu);
+        while (true) {
+            if (_jobHeap.empty()) return; // job was cancelled
+            GenJob job = _jobHeap.top();
+            _jobHeap.pop();
+            auto it = _queued.find(job.key);
+            if (it == _queued.end() || it->second.stamp != job.stamp) continue; // stale
+            needMesh   = it->second.needMesh;
+            meshCancel = std::move(it->second.meshCancel);
+            if (it->second.queuedUs) Trace::span("server.queue", job.key, it->second.queuedUs, Trace::nowUs());
+            _queued.erase(it);
+            key    = job.key;
+            urgent = job.priority <= URGENT_PRIORITY;
+            break;
+        }
+    }
+    bool split = urgent && key.lod == 0 && Config::GEN_URGENT_SLABS > 1 &&
+                 _pool.threadCount() > 1;
+    generateAndEnqueue(key, needMesh, std::move(meshCancel), split);
+}
+
+// slab(i) for every i < n: all but the first on other workers at Urgent
+// priority, the first right here. then() runs once, on whichever thread
+// finishes the last slab. Nothing waits, so it's safe on a busy pool.
+template<class Slab, class Then>
+static void splitAcross(ThreadPool& pool, int n, Slab slab, Then then) {
+    struct Split {
+        Slab             slab;
+        Then             then;
+        std::atomic<int> left;
+    };
+    std::shared_ptr<Split> sp(new Split{std::move(slab), std::move(then), {n}});
+    auto run = [sp](int i) {
+        sp->slab(i);
+        if (sp->left.fetch_sub(1, std::memory_order_acq_rel) == 1) sp->then();
+    };
+    for (int i = 1; i < n; i++)
+        pool.submit([run, i]() { run(i); }, ThreadPool::Priority::Urgent);
+    run(0);
+}
+
+// The field is canonical: it's what gets persisted, and meshes are always
+// marched from the decoded field so server- and client-built meshes match.
+// A job only meshes if some subscriber needs it; otherwise meshing is left to
+// the clients entirely. Meshing is a second stage on the pool: the field goes
+// out to field subscribers as soon as it exists instead of waiting behind it.
+// A split job spreads both stages over several workers instead of one, for
+// the chunks a player is waiting on.
+void ChunkManager::generateAndEnqueue(const ChunkKey& key, bool needMesh,
+                                      CancelToken meshCancel, bool split) {
+    if (key.lod > 0) {
+        generateLod(key);
+        return;
+    }
+
+    // Pure CPU work — no ENet calls here. Start from whatever is already
+    // cached, then the region store, then what another instance on this host
+    // generated; only chunks nobody has are generated.
+    ChunkCoord    coord = key.coord;
+    ChunkPayloads out   = _cache.get(key, needMesh);
+    if (!out.field) {
+        std::optional<std::vector<uint8_t>> stored;
+        {
+            Trace::Span    t("gen.load", key);
+            MemTags::Scope tag(MemTags::ChunkCache);
+            stored = _regions.load(coord);
+        }
+        if (stored) {
+            out.field = std::make_shared<const std::vector<uint8_t>>(std::move(*stored));
+        } else if (ChunkPayload shared = fromShared(key)) {
+            out.field = std::move(shared);
+        } else if (split) {
+            generateSplit(key, std::move(out), needMesh, std::move(meshCancel));
+            return;
+        } else if (offload(key, needMesh, meshCancel)) {
+            return;
+        } else {
+            out.field = generateField(key);
+        }
+    }
+    fieldReady(key, std::move(out), needMesh, std::move(meshCancel), split);
+}
+
+void ChunkManager::generateSplit(const ChunkKey& key, ChunkPayloads out, bool needMesh,
+                                 CancelToken meshCancel) {
+    auto data = _splitData.acquire();
+    auto t0   = Metrics::Clock::now();
+    beginChunk(*data, key.coord);
+    // Wall time across the slabs, as the waiting player sees it
+    auto done = [this, key, out = std::move(out), needMesh,
+                 meshCancel = std::move(meshCancel), data, t0]() mutable {
+        _timings.noise.observe(Metrics::secondsSince(t0));
+        publishFaces(*data);
+        out.field = storeField(key.coord, *data);
+        fieldReady(key, std::move(out), needMesh, std::move(meshCancel), true);
+    };
+    if (data->fill != ChunkData::Fill::Mixed) {
+        done();  // the marker carries no samples
+        return;
+    }
+    const int n = Config::GEN_URGENT_SLABS;
+    splitAcross(_pool, n, [data, n, key](int i) {
+        constexpr int P = ChunkData::PADDED;
+        Trace::Span t("gen.noise_slab", key);
+        generateSlab(*data, 0, P * i / n, P * (i + 1) / n);
+    }, std::move(done));
+}
+
+ChunkPayload ChunkManager::generateField(const ChunkKey& key) {
+    ChunkData& data = workerData();
+    {
+        Stage t(_timings.noise, "gen.noise", key);
+        generateChunk(data, key.coord);
+    }
+    return storeField(key.coord, data);
+}
+
+// Freshly generated: counted, encoded and saved
+ChunkPayload ChunkManager::storeField(ChunkCoord coord, const ChunkData& data) {
+    _generated.fetch_add(1, std::memory_order_relaxed);
+    if (data.fill != ChunkData::Fill::Mixed) _uniform.fetch_add(1, std::memory_order_relaxed);
+    ChunkPayload field = encodeField(coord, data, _timings);
+    if (_shared) _shared->put({coord, 0}, false, *field);
+    Trace::Span t("gen.store", {coord, 0});
+    _regions.save(coord, field);
+    return field;
+}
+
+// ── Shared chunk cache ────────────────────────────────────────────────────────
+// Other instances' pristine chunks: a full-resolution field is saved here too,
+// as if generated here; a LOD cell's mesh just joins the cache.
+
+bool ChunkManager::useSharedCache(size_t bytes) {
+    _shared = SharedChunkCache::open(worldId(), bytes);
+    return _shared != nullptr;
+}
+
+ChunkPayload ChunkManager::fromShared(const ChunkKey& key) {
+    if (!_shared) return nullptr;
+    ChunkPayload bytes;
+    {
+        Trace::Span t("gen.shared", key);
+        bytes = _shared->get(key, key.lod > 0);
+    }
+    if (!bytes) return nullptr;
+    _sharedHits.fetch_add(1, std::memory_order_relaxed);
+    if (key.lod == 0) {
+        Trace::Span t("gen.store", key);
+        _regions.save(key.coord, bytes);
+    }
+    return bytes;
+}
+
+// ── Compression ───────────────────────────────────────────────────────────────
+// chunks.dict: u32 magic | u32 worldId | u8 codec | dictionary. One trained
+// for another seed or format, or another codec, is trained again.
+
+static constexpr uint32_t DICT_MAGIC = 0x41444354; // "ADCT"
+
+static ChunkCoord ringCell(int r, int i); // see Pregeneration
+
+bool ChunkManager::useCompression(ChunkCodec codec, float wx, float wz) {
+    if (!ChunkCodecs::available(codec)) {
+        Log::warn(std::string("ChunkManager: ") + ChunkCodecs::name(codec) +
+                  " isn't in this build; chunks go out uncompressed");
+        return false;
+    }
+    const std::string path = _worldDir + "/chunks.dict";
+    const uint32_t    world = worldId();
+
+    if (FILE* f = fopen(path.c_str(), "rb")) {
+        std::vector<uint8_t> file;
+        uint8_t buf[4096];
+        for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0;) file.insert(file.end(), buf, buf + n);
+        fclose(f);
+        size_t o = 0;
+        if (file.size() > 9 && readU32(file.data(), o) == DICT_MAGIC && readU32(file.data(), o) == world &&
+            file[8] == (uint8_t)codec)
+            _dict = ChunkDict::load(codec, std::vector<uint8_t>(file.begin() + 9, file.end()));
+        if (!_dict) Log::info("ChunkManager: " + path + " is for another world or codec; training a new one");
+    }
+
+    if (!_dict) {
+        // Fields and meshes of the surface chunk of each column and the
+        // ones above and below — what players mostly get sent. Uniform
+        // chunks are a handful of bytes and teach nothing.
+        auto t0 = Metrics::Clock::now();
+        ChunkCoord c = worldToChunk(wx, 0.f, wz);
+        std::mutex                        mu;
+        std::vector<std::vector<uint8_t>> samples;
+        std::atomic<int>                  left{Config::CHUNK_DICT_SAMPLES};
+        for (int r = 0, i = 0, n = 0; n < Config::CHUNK_DICT_SAMPLES; n++) {
+            ChunkCoord cell = ringCell(r, i);
+            if (++i >= std::max(8 * r, 1)) { r++; i = 0; }
+            int cx = c.x + cell.x, cz = c.z + cell.z;
+            _pool.submit([this, cx, cz, &mu, &samples, &left]() {
+                const float size = (float)ChunkData::SIZE;
+                float wx = (cx + 0.5f) * size, wz = (cz + 0.5f) * size;
+                int   sy = worldToChunk(wx, sampleSurfaceY(wx, wz), wz).y;
+                for (int y = sy - 1; y <= sy + 1; y++) {
+                    ChunkKey   key{{cx, y, cz}, 0};
+                    ChunkData& data = workerData();
+                    generateChunk(data, key.coord);
+                    if (data.fill != ChunkData::Fill::Mixed) continue;
+                    ChunkPayload field = encodeField(key.coord, data, _timings);
+                    ChunkPayload mesh  = marchField(key, field, _timings);
+                    std::lock_guard lk(mu);
+                    samples.push_back(*field);
+                    if (mesh) samples.push_back(*mesh);
+                }
+                left.fetch_sub(1, std::memory_order_acq_rel);
+            });
+        }
+        while (left.load(std::memory_order_acquire) > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        // In a fixed order, so every shard of the world trains the same one
+        std::sort(samples.begin(), samples.end());
+        _dict = ChunkDict::train(codec, samples, Config::CHUNK_DICT_BYTES);
+        if (!_dict) {
+            Log::warn("ChunkManager: training a chunk dictionary failed; chunks go out uncompressed");
+            return false;
+        }
+        Log::info("ChunkManager: trained a " + std::to_string(_dict->bytes().size() >> 10) + " KB " +
+                  ChunkCodecs::name(codec) + " dictionary on " + std::to_string(samples.size()) +
+                  " payloads in " + std::to_string((int)(Metrics::secondsSince(t0) * 1000.0)) + " ms");
+
+        PacketWriter w(9 + _dict->bytes().size());
+        w.u32(DICT_MAGIC).u32(world).u8((uint8_t)codec).bytes(_dict->bytes().data(), _dict->bytes().size());
+        std::error_code ec;
+        std::filesystem::create_directories(_worldDir, ec);
+        std::string tmp = path + ".tmp";
+        FILE* f  = fopen(tmp.c_str(), "wb");
+        bool  ok = f && fwrite(w.data(), 1, w.size(), f) == w.size();
+        if (f) fclose(f);
+        if (ok) std::filesystem::rename(tmp, path, ec);
+        if (!ok || ec) Log::warn("ChunkManager: couldn't save " + path + "; it'll be trained again next start");
+    }
+
+    PacketWriter w(6 + _dict->bytes().size());
+    ChunkDictPacket{(uint8_t)codec, _dict->id(), _dict->bytes().data(), _dict->bytes().size()}.write(w);
+    _dictPacket = std::make_shared<const std::vector<uint8_t>>(w.toVector());
+    return true;
+}
+
+ChunkPayload ChunkManager::dictFor(uint32_t caps) const {
+    return _dict && (caps & ChunkCodecs::cap(_dict->codec())) ? _dictPacket : nullptr;
+}
+
+// Worker. Each encoding's packed twin, taken from the cache when it holds
+// the very same bytes (a final result after its partial one, a cached
+// chunk going round again) and packed here otherwise.
+void ChunkManager::pack(const ChunkKey& key, ChunkPayloads& bytes) {
+    if (!_dict) return;
+    ChunkPayloads have = _cache.peek(key);
+    auto one = [&](const ChunkPayload& raw, ChunkPayload& packed, const ChunkPayload& haveRaw,
+                   const ChunkPayload& havePacked) {
+        if (!raw || packed || (*raw)[0] == (uint8_t)PacketID::ChunkUniform) return;
+        if (raw == haveRaw) {
+            packed = havePacked;
+            return;
+        }
+        std::vector<uint8_t> out;
+        {
+            Trace::Span    t("gen.pack", key);
+            MemTags::Scope tag(MemTags::ChunkCache);
+            out = _dict->pack(raw->data(), raw->size());
+        }
+        if (out.empty()) {
+            _packSkipped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        _packed.fetch_add(1, std::memory_order_relaxed);
+        _packRaw.fetch_add(raw->size(), std::memory_order_relaxed);
+        _packOut.fetch_add(out.size(), std::memory_order_relaxed);
+        packed = std::make_shared<const std::vector<uint8_t>>(std::move(out));
+    };
+    one(bytes.field, bytes.fieldPacked, have.field, have.fieldPacked);
+    if (bytes.mesh == bytes.field) bytes.meshPacked = bytes.fieldPacked;
+    else one(bytes.mesh, bytes.meshPacked, have.mesh, have.meshPacked);
+}
+
+void ChunkManager::fieldReady(const ChunkKey& key, ChunkPayloads out, bool needMesh,
+                              CancelToken meshCancel, bool split) {
+    // A uniform marker doubles as the mesh — nothing to march
+    if ((*out.field)[0] == (uint8_t)PacketID::ChunkUniform) out.mesh = out.field;
+
+    if (!needMesh || out.mesh) {
+        enqueueReady(key, std::move(out), false);
+        return;
+    }
+
+    enqueueReady(key, out, true);
+    ChunkPayload field = out.field;
+    if (split) {
+        marchSplit(key, std::move(field), std::move(meshCancel));
+        return;
+    }
+    _pool.async([this, key, field]() { return marchField(key, field, _timings); },
+                ThreadPool::Priority::Normal, std::move(meshCancel))
+         .onDone([this, key, field](TaskFuture<ChunkPayload>& mesh) {
+             // Cancelled or not, the final result retires the in-flight entry
+             enqueueReady(key, {field, mesh.ready() ? mesh.get() : nullptr}, false);
+         });
+}
+
+// marchField over z slabs, stitched by whichever worker finishes last
+void ChunkManager::marchSplit(const ChunkKey& key, ChunkPayload field, CancelToken meshCancel) {
+    auto data = _splitData.acquire();
+    auto t0   = Metrics::Clock::now();
+    if (!ChunkFieldPacket::deserialize(field->data(), field->size(), *data)) {
+        Log::err("ChunkManager: corrupt field payload");
+        enqueueReady(key, {field, nullptr}, false);
+        return;
+    }
+    const int n = Config::GEN_URGENT_SLABS;
+    auto slabs = _splitSlabs.acquire();
+    slabs->resize(n);
+    splitAcross(_pool, n, [data, slabs, n, meshCancel, key](int i) {
+        Trace::Span t("gen.march_slab", key);
+        if (!meshCancel.cancelled()) marchSlab(*data, (*slabs)[i], i, n);
+    }, [this, key, field, data, slabs, meshCancel, t0]() {
+        ChunkPayload mesh;
+        if (!meshCancel.cancelled()) {
+            ChunkMesh& joined = workerMesh();
+            stitchSlabs(*slabs, joined);
+            joined.faceLinks = chunkFaceLinks(*data);
+            _timings.march.observe(Metrics::secondsSince(t0));
+            {
+                Stage t(_timings.optimize, "gen.optimize", key);
+                optimizeMesh(joined);
+            }
+            Stage t(_timings.serialize, "gen.serialize", key);
+            mesh = std::make_shared<const std::vector<uint8_t>>(ChunkDataPacket::serialize(joined));
+        }
+        enqueueReady(key, {field, std::move(mesh)}, false);
+    });
+}
+
+// LOD cells are cheap to regenerate and only ever sent as meshes, so they
+// skip the region store and the field stage: one job samples, marches with
+// skirts and caches the mesh. A cell with nothing to draw is cached as a
+// uniform marker, which flushReady marks sent without sending.
+void ChunkManager::generateLod(const ChunkKey& key) {
+    ChunkPayloads out = _cache.get(key, true);
+    if (!out.mesh) out.mesh = fromShared(key);
+    if (!out.mesh) {
+        CancelToken none;
+        if (offload(key, true, none)) return;
+        bool uniform = false;
+        out.mesh = buildLodCell(key, _timings, uniform);
+        _generated.fetch_add(1, std::memory_order_relaxed);
+        _lodCells.fetch_add(1, std::memory_order_relaxed);
+        if (uniform) _uniform.fetch_add(1, std::memory_order_relaxed);
+        if (_shared) _shared->put(key, true, *out.mesh);
+    }
+    enqueueReady(key, std::move(out), false);
+}
+
+// ── Pregeneration ─────────────────────────────────────────────────────────────
+// A column is the chunks PREGEN_DEPTH either side of the one the surface is
+// in at its centre. Each chunk goes through the same stages a job's would —
+// another instance's copy, or generated — minus any mesh.
+
+// Worker. How many of the column's chunks it generated.
+int ChunkManager::pregenColumn(int cx, int cz, bool cache) {
+    const float size = (float)ChunkData::SIZE;
+    float wx = (cx + 0.5f) * size, wz = (cz + 0.5f) * size;
+    int   sy = worldToChunk(wx, sampleSurfaceY(wx, wz), wz).y;
+    int   made = 0;
+    for (int y = sy - Config::PREGEN_DEPTH; y <= sy + Config::PREGEN_DEPTH; y++) {
+        ChunkKey key{{cx, y, cz}, 0};
+        if (!_regions.ownsChunk(key.coord) || _regions.load(key.coord)) continue;
+        ChunkPayload field = fromShared(key);
+        if (!field) field = generateField(key);
+        made++;
+        if (!cache) continue;
+        ChunkPayload  mesh = (*field)[0] == (uint8_t)PacketID::ChunkUniform ? field : nullptr;
+        ChunkPayloads bytes{std::move(field), std::move(mesh)};
+        pack(key, bytes);
+        _cache.put(key, std::move(bytes));
+    }
+    _pregenerated.fetch_add(made, std::memory_order_relaxed);
+    return made;
+}
+
+void ChunkManager::pregenerate(float wx, float wz, int radius) {
+    ChunkCoord c = worldToChunk(wx, 0.f, wz);
+    const int  columns = (2 * radius + 1) * (2 * radius + 1);
+    std::atomic<int>      left{columns};
+    std::atomic<uint64_t> made{0};
+    auto t0 = Metrics::Clock::now();
+    Log::info("Pregenerating " + std::to_string(columns) + " columns around spawn");
+    for (int x = c.x - radius; x <= c.x + radius; x++)
+        for (int z = c.z - radius; z <= c.z + radius; z++)
+            _pool.submit([this, x, z, &left, &made]() {
+                made.fetch_add(pregenColumn(x, z, true), std::memory_order_relaxed);
+                left.fetch_sub(1, std::memory_order_acq_rel);
+            });
+
+    auto nextLog = t0 + std::chrono::seconds(2);
+    while (left.load(std::memory_order_acquire) > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (Metrics::Clock::now() < nextLog) continue;
+        nextLog += std::chrono::seconds(2);
+        Log::info("Pregenerating: " + std::to_string(columns - left.load()) + "/" + std::to_string(columns) +
+                  " columns, " + std::to_string(made.load()) + " chunks generated, " +
+                  std::to_string(_pool.threadCount()) + " workers");
+    }
+    Log::info("Pregenerated " + std::to_string(made.load()) + " chunks in " +
+              std::to_string((int)(Metrics::secondsSince(t0) * 1000.0)) + " ms");
+}
+
+void ChunkManager::setIdlePregen(float wx, float wz, int radius) {
+    _idlePregen = std::make_unique<IdlePregen>();
+    ChunkCoord c = worldToChunk(wx, 0.f, wz);
+    _idlePregen->center = {c.x, 0, c.z};
+    _idlePregen->radius = radius;
+}
+
+// Cell i of the 8r cells of square ring r, walking its four sides
+static ChunkCoord ringCell(int r, int i) {
+    if (r == 0) return {0, 0, 0};
+    int side = i / (2 * r), t = i % (2 * r);
+    switch (side) {
+    case 0:  return {-r + t, 0, -r};
+    case 1:  return { r,     0, -r + t};
+    case 2:  return { r - t, 0,  r};
+    default: return {-r,     0,  r - t};
+    }
+}
+
+// ENet thread, from flushReady. One batch at a time, and only while the
+// pool has nothing else: a player's job never queues behind more than a
+// column per worker.
+void ChunkManager::pregenIdle() {
+    if (!_inFlight.empty() || _pool.pending() > 0 || _pregenRunning.load(std::memory_order_acquire) > 0)
+        return;
+    IdlePregen& p = *_idlePregen;
+    if (p.seen.size() > (1u << 20)) p.seen.clear();
+
+    auto inView = [this](int x, int z) {
+        for (const ClientState& cs : _players.all<ClientState>()) {
+            const ViewBox& b = cs.levels[0].region;
+            if (x >= b.lo.x && x <= b.hi.x && z >= b.lo.z && z <= b.hi.z) return true;
+        }
+        return false;
+    };
+    ArenaVector<ChunkCoord> picks{ArenaAllocator<ChunkCoord>(_tick)};
+    picks.reserve(Config::PREGEN_IDLE_BATCH);
+    auto take = [&](int x, int z) {
+        if ((int)picks.size() >= Config::PREGEN_IDLE_BATCH || inView(x, z)) return;
+        if (p.seen.insert({x, 0, z}).second) picks.push_back({x, 0, z});
+    };
+
+    // Where players are going: a band three columns wide past the view edge
+    for (const ClientState& cs : _players.all<ClientState>()) {
+        if (cs.heading.x == 0 && cs.heading.z == 0) continue;
+        int r = cs.tiers.width(0) / 2;
+        for (int d = r + 1; d <= r + Config::PREGEN_AHEAD; d++)
+            for (int side = -1; side <= 1; side++)
+                take(cs.lastChunk.x + cs.heading.x * d - cs.heading.z * side,
+                     cs.lastChunk.z + cs.heading.z * d + cs.heading.x * side);
+    }
+    // Then outward from spawn
+    while ((int)picks.size() < Config::PREGEN_IDLE_BATCH && p.ring <= p.radius) {
+        if (p.index >= std::max(1, 8 * p.ring)) {
+            p.ring++;
+            p.index = 0;
+            continue;
+        }
+        ChunkCoord c = ringCell(p.ring, p.index++);
+        take(p.center.x + c.x, p.center.z + c.z);
+    }
+
+    for (ChunkCoord col : picks) {
+        _pregenRunning.fetch_add(1, std::memory_order_acq_rel);
+        _pool.submit([this, col]() {
+            pregenColumn(col.x, col.z, false);
+            _pregenRunning.fetch_sub(1, std::memory_order_acq_rel);
+        }, ThreadPool::Priority::Background);
+    }
+}
+
+// ── Terrain queries ───────────────────────────────────────────────────────────
+
+const DensityField* ChunkManager::densityOf(ChunkCoord coord) {
+    if (const DensityField* f = _densities.find(coord)) return f;
+    if (_densityMissing.contains(coord)) return nullptr;
+    ChunkPayload field = _cache.peek({coord, 0}).field;
+    if (!field) {
+        if (auto stored = _regions.load(coord))
+            field = std::make_shared<const std::vector<uint8_t>>(std::move(*stored));
+    }
+    std::unique_ptr<DensityField> f = field ? DensityField::fromPayload(field->data(), field->size()) : nullptr;
+    if (!f) {
+        _densityMissing.insert(coord);
+        return nullptr;
+    }
+    return _densities.put(std::move(f));
+}
+
+// ── Chunkgen service ──────────────────────────────────────────────────────────
+// A job the service takes leaves the worker at once; its in-flight entry
+// stays until the result, picked up in flushReady, has been through the
+// same stages a local one would — saved, meshed if the service didn't,
+// enqueued — on the pool. A job the link hands back runs here from the top.
+
+void ChunkManager::useChunkGen(const std::string& host, uint16_t port) {
+    _remote = std::make_unique<ChunkGenLink>(host, port, worldId());
+    Log::info("Chunk generation: offloading to chunkgen at " + host + ":" + std::to_string(port));
+}
+
+// Worker. True if the service took the job, and meshCancel with it.
+bool ChunkManager::offload(const ChunkKey& key, bool needMesh, CancelToken& meshCancel) {
+    if (!_remote || !_remote->up()) return false;
+    std::lock_guard lk(_remoteMu);
+    if (!_remote->request(key, needMesh)) return false;
+    _remoteJobs[key] = {needMesh, std::move(meshCancel)};
+    return true;
+}
+
+// ENet thread
+void ChunkManager::serviceRemote() {
+    _remoteDone.clear();
+    _remoteLost.clear();
+    _remote->service(_remoteDone, _remoteLost);
+    if (_remoteDone.empty() && _remoteLost.empty()) return;
+
+    std::lock_guard lk(_remoteMu);
+    for (ChunkGenLink::Result& r : _remoteDone) {
+        auto it = _remoteJobs.find(r.key);
+        if (it == _remoteJobs.end()) continue;
+        _pool.submit([this, key = r.key, bytes = std::move(r.bytes), job = std::move(it->second)]() mutable {
+            remoteReady(key, std::move(bytes), job.needMesh, std::move(job.meshCancel));
+        });
+        _remoteJobs.erase(it);
+    }
+    for (const ChunkKey& key : _remoteLost) {
+        auto it = _remoteJobs.find(key);
+        if (it == _remoteJobs.end()) continue;
+        _pool.submit([this, key, job = std::move(it->second)]() mutable {
+            generateAndEnqueue(key, job.needMesh, std::move(job.meshCancel), false);
+        });
+        _remoteJobs.erase(it);
+    }
+}
+
+// Worker. A result missing what it should carry is made here instead.
+void ChunkManager::remoteReady(const ChunkKey& key, ChunkPayloads bytes, bool needMesh,
+                               CancelToken meshCancel) {
+    if (key.lod > 0) {
+        if (!bytes.mesh) {
+            Log::warn("ChunkManager: chunkgen sent a LOD cell without its mesh");
+            bool uniform = false;
+            bytes.mesh = buildLodCell(key, _timings, uniform);
+        } else {
+            _remoteGen.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (_shared) _shared->put(key, true, *bytes.mesh);
+        enqueueReady(key, {nullptr, std::move(bytes.mesh)}, false);
+        return;
+    }
+    if (!bytes.field) {
+        Log::warn("ChunkManager: chunkgen sent a chunk without its field");
+        bytes = {generateField(key), nullptr};
+    } else {
+        _remoteGen.fetch_add(1, std::memory_order_relaxed);
+        if (_shared) _shared->put(key, false, *bytes.field);
+        Trace::Span t("gen.store", key);
+        _regions.save(key.coord, bytes.field);
     }
+    fieldReady(key, std::move(bytes), needMesh, std::move(meshCancel), false);
+}
+
+void ChunkManager::enqueueReady(const ChunkKey& key, ChunkPayloads bytes, bool partial) {
+    pack(key, bytes);
+    _cache.put(key, bytes);
+    // Subscribers are resolved in flushReady on the ENet thread
+    std::lock_guard lk(_readyMu);
+    _ready.push_back({{}, key, std::move(bytes), partial});
 }
 
 // ── updateClient ──────────────────────────────────────────────────────────────
-// Called when a PlayerMove packet arrives. Only schedules new chunks.
+// Called when a PlayerMove packet arrives. On crossing a chunk boundary, drops
+// pending chunks that fell out of range, re-prioritizes the rest around the
+// new centre, then schedules what newly came into range at each level — the
+// only place anything unknown can be. Every move also feeds the velocity the
+// prefetch shell follows.
+
+// Between two moves: a teleport or respawn, not travel
+static constexpr float TELEPORT_SPEED = 60.f;
 
 void ChunkManager::updateClient(ENetPeer* peer, float wx, float wy, float wz) {
     ClientState* cs = findClient(peer);
     if (!cs) return;
 
+    auto  now = _now();
+    float dt  = std::chrono::duration<float>(now - cs->movedAt).count();
+    if (cs->movedAt == std::chrono::steady_clock::time_point{} || dt > 1.f) {
+        cs->vel[0] = cs->vel[1] = 0.f;
+    } else if (dt > 0.f) {
+        float vx = (wx - cs->pos[0]) / dt, vz = (wz - cs->pos[1]) / dt;
+        if (vx * vx + vz * vz > TELEPORT_SPEED * TELEPORT_SPEED) {
+            cs->vel[0] = cs->vel[1] = 0.f;
+        } else {
+            float a = 1.f - std::exp(-dt / Config::PREFETCH_SMOOTH_S);
+            cs->vel[0] += (vx - cs->vel[0]) * a;
+            cs->vel[1] += (vz - cs->vel[1]) * a;
+        }
+    }
+    if (dt > 0.f || cs->movedAt == std::chrono::steady_clock::time_point{}) {
+        // Two moves in one instant (a replay) leave the first as the base
+        cs->pos[0]  = wx;
+        cs->pos[1]  = wz;
+        cs->movedAt = now;
+    }
+
     ChunkCoord center = worldToChunk(wx, wy, wz);
-    if (center == cs->lastChunk) return; // didn't cross a chunk boundary
-    cs->lastChunk = center;
+    if (center != cs->lastChunk) {
+        if (cs->lastChunk.x != INT_MIN) {
+            auto sign = [](int v) { return (v > 0) - (v < 0); };
+            cs->heading = {sign(center.x - cs->lastChunk.x), 0, sign(center.z - cs->lastChunk.z)};
+        }
+        moveView(*cs, center);
+    }
+    refreshPrefetch(*cs);
+}
+
+void ChunkManager::moveView(ClientState& cs, ChunkCoord center) {
+    struct Boxes { ViewBox region, hole; };
+    std::array<Boxes, Config::LOD_LEVELS_MAX + 1> old;
+    for (int lv = 0; lv <= cs.tiers.levels; lv++) {
+        ClientState::Level& l = cs.levels[lv];
+        old[lv] = {l.region, l.hole};
+        ViewBox region = cs.tiers.region(lv, center);
+        // Pin what came into view, unpin what left; the overlap keeps its pins
+        forEachEntered(l.region, region, [&](ChunkCoord c) { _cache.pin({c, lv}); });
+        forEachEntered(region, l.region, [&](ChunkCoord c) { _cache.unpin({c, lv}); });
+        l.region = region;
+        l.hole   = cs.tiers.hole(lv, center);
+    }
+    cs.lastChunk = center;
+
+    for (auto it = cs.pendingChunks.begin(); it != cs.pendingChunks.end(); ) {
+        ChunkKey key = *it;
+        if (!cs.wants(key)) {
+            it = cs.pendingChunks.erase(it);
+            unsubscribe(cs.peer, key);
+            continue;
+        }
+        auto job = _inFlight.find(key);
+        if (job != _inFlight.end())
+            requeueJob(key, jobPriority(key, job->second));
+        ++it;
+    }
+
+    for (int lv = 0; lv <= cs.tiers.levels; lv++) {
+        ClientState::Level& l = cs.levels[lv];
+        // Each entered coord takes over the bit of one that left. Cells the
+        // finer level took over are forgotten too — the client drops them.
+        forEachEntered(old[lv].region, l.region, [&](ChunkCoord c) { l.sent.reset(c); });
+        forEachEntered(old[lv].hole, l.hole, [&](ChunkCoord c) { l.sent.reset(c); });
+
+        forEachEntered(old[lv].region, l.region, [&](ChunkCoord c) {
+            if (!l.hole.contains(c)) scheduleChunk(cs, {c, lv});
+        });
+        // ...and cells the finer level handed back
+        forEachEntered(l.hole, old[lv].hole, [&](ChunkCoord c) {
+            if (l.region.contains(c)) scheduleChunk(cs, {c, lv});
+        });
+    }
+}
+
+// Coords still in view (the unload raced a move back) are rescheduled right
+// away; the rest wait for updateClient to bring them back into range.
+void ChunkManager::forgetChunks(ENetPeer* peer, const std::vector<ChunkCoord>& coords) {
+    ClientState* cs = findClient(peer);
+    if (!cs) return;
+    ClientState::Level& l = cs->levels[0];
+    for (const auto& coord : coords) {
+        if (!l.sent.test(coord, l.region)) continue; // out of range: already forgotten
+        l.sent.reset(coord);
+        scheduleChunk(*cs, {coord, 0});
+    }
+}
+
+// Outbound entries are the versioned bytes, so an edited chunk is unwrapped
+// to hash what the client hashed
+void ChunkManager::holdChunks(ENetPeer* peer, const std::vector<ChunkHavePacket::Entry>& entries) {
+    ClientState* cs = findClient(peer);
+    if (!cs) return;
+    for (const auto& e : entries) {
+        if (cs->held.size() >= ClientState::HELD_MAX) break;
+        cs->held[e.coord] = e.hash;
+    }
+
+    std::vector<uint8_t> raw;
+    for (ClientState::Outbound& o : cs->outbound) {
+        if (o.key.lod != 0) continue;
+        auto it = cs->held.find(o.key.coord);
+        if (it == cs->held.end()) continue;
+        const uint8_t* d = o.pkt->data;
+        size_t         n = o.pkt->dataLength;
+        uint32_t version = 0;
+        if (d[0] == (uint8_t)PacketID::ChunkUpdate) {
+            ChunkCoord c;
+            d = ChunkUpdatePacket::unwrap(d, n, c, version, n);
+            if (!d) continue;
+        }
+        if (d[0] == (uint8_t)PacketID::ChunkPacked) {
+            // The client hashed what it decoded
+            if (!_dict || !_dict->unpack(d, n, raw)) continue;
+            d = raw.data();
+            n = raw.size();
+        }
+        if (payloadHash(d, n) != it->second) continue;
+        ENetPacket* cached = cachedPacket(o.key.coord, version, it->second);
+        if (!cached) continue;
+        cs->held.erase(it);
+        Net::release(o.pkt);
+        o.pkt = cached;
+    }
+}
+
+uint32_t ChunkManager::worldId() const {
+    return generatorWorldId();
+}
 
-    for (int dx = -Config::CHUNK_RADIUS_XZ; dx <= Config::CHUNK_RADIUS_XZ; dx++)
-    for (int dy = -Config::CHUNK_RADIUS_Y;  dy <= Config::CHUNK_RADIUS_Y;  dy++)
-    for (int dz = -Config::CHUNK_RADIUS_XZ; dz <= Config::CHUNK_RADIUS_XZ; dz++)
-        scheduleChunk(*cs, {center.x+dx, center.y+dy, center.z+dz});
+// Every cached cell a player can see is pinned, so it's never evicted; this
+// releases one client's pins.
+void ChunkManager::unpinView(const ClientState& cs) {
+    for (int lv = 0; lv <= cs.tiers.levels; lv++)
+        forEachEntered(ViewBox{}, cs.levels[lv].region,
+                       [&](ChunkCoord c) { _cache.unpin({c, lv}); });
 }
 
 // ── flushReady ────────────────────────────────────────────────────────────────
 // Called every server tick from the ENet thread.
-// Drains the ready queue and sends packets. ENet is not thread-safe so all
-// enet_peer_send calls must happen here, not in the worker threads.
+// Drains the ready queue into each recipient's outbound list, then streams
+// from those lists. ENet is not thread-safe so this must run here, not in
+// the worker threads.
+// A generation result carries no peers of its own; it is fanned out to every
+// subscriber of the key's in-flight job, which is then retired. A partial
+// result only takes the field subscribers. Edit results go out after the
+// batch, so a send of the chunk queued before the edit finished is
+// overtaken, never the other way round. A chunkgen link is serviced first,
+// and idle pregeneration topped up last.
 
-void ChunkManager::flushReady(ENetHost* host) {
-    std::queue<ReadyChunk> batch;
+void ChunkManager::flushReady(Outbox& out) {
+    if (_remote) serviceRemote();
+    _densityMissing.clear();
+    // Moved rather than swapped out, so the lists the workers fill keep
+    // their capacity and this one is the arena's
+    ArenaVector<ReadyChunk> batch{ArenaAllocator<ReadyChunk>(_tick)};
+    ArenaVector<EditResult> edits{ArenaAllocator<EditResult>(_tick)};
     {
         std::lock_guard lk(_readyMu);
-        std::swap(batch, _ready);
+        batch.assign(std::make_move_iterator(_ready.begin()), std::make_move_iterator(_ready.end()));
+        edits.assign(std::make_move_iterator(_editsDone.begin()), std::make_move_iterator(_editsDone.end()));
+        _ready.clear();
+        _editsDone.clear();
+    }
+
+    for (ReadyChunk& rc : batch) {
+
+        if (rc.peers.empty()) {
+            auto it = _inFlight.find(rc.key);
+            if (it != _inFlight.end() && rc.partial) {
+                auto& subs = it->second.subscribers;
+                auto waiting = std::partition(subs.begin(), subs.end(), [this](ENetPeer* p) {
+                    ClientState* cs = findClient(p);
+                    return cs && !cs->fields;
+                });
+                rc.peers.assign(waiting, subs.end());
+                subs.erase(waiting, subs.end());
+                if (subs.empty() && it->second.prefetchers.empty()) it->second.meshCancel.cancel();
+            } else if (it != _inFlight.end()) {
+                rc.peers = std::move(it->second.subscribers);
+                _inFlight.erase(it);
+            }
+        }
+
+        // One packet per encoding, raw or packed, for every recipient,
+        // pointing straight at the cached bytes — ENet refcounts it per
+        // peer, so fan-out never copies.
+        ENetPacket* pkts[2][2] = {};
+        std::optional<uint64_t> fieldHash, meshHash;
+        for (ENetPeer* peer : rc.peers) {
+            // Mark pendingChunks as sent (peer might be gone — check)
+            ClientState* cs = findClient(peer);
+            if (!cs) continue;
+            cs->pendingChunks.erase(rc.key);
+
+            bool useField = cs->fields && rc.key.lod == 0;
+            const ChunkPayload& bytes = useField ? rc.bytes.field : rc.bytes.mesh;
+            if (!bytes) {
+                // Subscribed after a field-only job had started — go again,
+                // this time the job will mesh from the cached field
+                scheduleChunk(*cs, rc.key);
+                continue;
+            }
+            ClientState::Level& l = cs->levels[rc.key.lod];
+            l.sent.set(rc.key.coord, l.region);
+            // Nothing to draw, and a uniform marker has no level to file it
+            // under on the client
+            if (rc.key.lod > 0 && (*bytes)[0] == (uint8_t)PacketID::ChunkUniform) continue;
+            if (offerCached(*cs, rc.key, bytes, useField ? fieldHash : meshHash)) continue;
+
+            const ChunkPayload& packed = useField ? rc.bytes.fieldPacked : rc.bytes.meshPacked;
+            const bool          tight  = cs->packed && packed;
+            ENetPacket*& pkt = pkts[useField][tight];
+            if (!pkt) pkt = Net::makeSharedPacket(versioned(rc.key, tight ? packed : bytes));
+            if (!pkt) continue;
+            Net::retain(pkt);
+            cs->outbound.push_back({rc.key, pkt, Trace::on() ? Trace::nowUs() : 0});
+        }
+        for (auto& row : pkts)
+            for (ENetPacket* pkt : row)
+                if (pkt && pkt->referenceCount == 0) enet_packet_destroy(pkt);
     }
 
-    bool sent = false;
-    while (!batch.empty()) {
-        ReadyChunk& rc = batch.front();
+    for (EditResult& r : edits) deliverEdit(r);
+    if (!_editsDeferred.empty()) {
+        ArenaVector<ChunkCoord> deferred(_editsDeferred.begin(), _editsDeferred.end(),
+                                         ArenaAllocator<ChunkCoord>(_tick));
+        _editsDeferred.clear();
+        for (ChunkCoord c : deferred) {
+            _edits[c].deferred = false;
+            startEdit(c);
+        }
+    }
+
+    for (ClientState& cs : _players.all<ClientState>())
+        if (!cs.outbound.empty()) streamOutbound(cs, out);
+    if (_idlePregen) pregenIdle();
+}
+
+// Nearest first, by the client's position now rather than when the chunk
+// finished. Chunks the client has since moved away from, or that a finer
+// level has taken over, are dropped (and forgotten, so they're scheduled
+// again if it comes back).
+void ChunkManager::streamOutbound(ClientState& cs, Outbox& out) {
+    auto& ob = cs.outbound;
+    ob.erase(std::remove_if(ob.begin(), ob.end(), [&](const ClientState::Outbound& o) {
+        if (cs.wants(o.key)) return false;
+        Net::release(o.pkt);
+        return true;
+    }), ob.end());
+
+    double room = out.streamRoom(cs.peer);
+    if (room > 0 && !ob.empty()) {
+        // Farthest at the front, so the nearest pop off the back
+        std::sort(ob.begin(), ob.end(), [&](const ClientState::Outbound& a, const ClientState::Outbound& b) {
+            return chunkPriority(a.key, cs.lastChunk) > chunkPriority(b.key, cs.lastChunk);
+        });
+        while (room > 0 && !ob.empty()) {
+            ENetPacket* pkt = ob.back().pkt;
+            // Ready to the outbox: time spent behind the peer's send budget
+            if (ob.back().readyUs) Trace::span("server.budget_wait", ob.back().key, ob.back().readyUs, Trace::nowUs());
+            ob.pop_back();
+            room -= (double)pkt->dataLength;
+            out.stream(cs.peer, pkt);
+            Net::release(pkt);
+        }
+    }
+}
+
+void ChunkManager::dropOutbound(ClientState& cs) {
+    for (const auto& o : cs.outbound) Net::release(o.pkt);
+    cs.outbound.clear();
+}
+
+// ── Terrain edits ─────────────────────────────────────────────────────────────
+// The field stays canonical: an edit job decodes the stored field, applies
+// its edits in wire units and stores the result, so a field client meshing
+// it gets exactly what the server would send as a mesh. A chunk goes out
+// wrapped in a ChunkUpdate from its first edit on (see versioned).
+
+void ChunkManager::editTerrain(const TerrainEdit& edit) {
+    TerrainEdits::forEachEditedChunk(edit, [&](ChunkCoord c) {
+        _edits[c].queued.push_back(edit);
+        startEdit(c);
+    });
+}
+
+void ChunkManager::startEdit(ChunkCoord coord) {
+    EditedChunk& e = _edits[coord];
+    if (e.running || e.queued.empty()) return;
+    if (_inFlight.count({coord, 0})) {
+        // The generation result is what the edit applies to; go once it's out
+        if (!e.deferred) {
+            e.deferred = true;
+            _editsDeferred.push_back(coord);
+        }
+        return;
+    }
+
+    // Mesh it only for clients that can't mesh it themselves
+    bool needMesh = false;
+    for (const ClientState& cs : _players.all<ClientState>()) {
+        if (cs.fields) continue;
+        const ClientState::Level& l = cs.levels[0];
+        if (l.sent.test(coord, l.region)) { needMesh = true; break; }
+    }
+    for (ENetPeer* p : e.waiters) {
+        ClientState* cs = findClient(p);
+        if (cs && !cs->fields) needMesh = true;
+    }
+
+    e.running = true;
+    uint32_t version = ++e.version;
+    std::vector<TerrainEdit> edits;
+    std::swap(edits, e.queued);
+    _pool.submit([this, coord, edits = std::move(edits), version, needMesh]() mutable {
+        runEdit(coord, std::move(edits), version, needMesh);
+    }, ThreadPool::Priority::Urgent);
+}
+
+// A uniform chunk as generation would have filled it: solid rock keeps the
+// ore it never carried on the wire
+static void expandGenerated(ChunkData& data, ChunkCoord coord, ChunkData::Fill fill) {
+    TerrainEdits::expandUniform(data, coord, fill);
+    if (fill == ChunkData::Fill::Solid) Features::decorateSlab(data, 0, 0, ChunkData::PADDED);
+}
+
+void ChunkManager::runEdit(ChunkCoord coord, std::vector<TerrainEdit> edits, uint32_t version,
+                           bool needMesh) {
+    const ChunkKey key{coord, 0};
+    Metrics::ScopedTimer timer(_timings.edit);
+    Trace::Span span("edit.apply", key);
+
+    ChunkData&    data = workerData();
+    ChunkPayloads cur  = _cache.get(key, needMesh);
+    if (!cur.field) {
+        if (auto stored = _regions.load(coord))
+            cur.field = std::make_shared<const std::vector<uint8_t>>(std::move(*stored));
+    }
+    bool decoded = false;
+    Resident resident = cur.field ? takeResident(coord) : nullptr;
+    if (resident) {
+        resident->decode(data);
+        decoded = true;
+    } else if (cur.field && (*cur.field)[0] == (uint8_t)PacketID::ChunkUniform) {
+        auto u = ChunkUniformPacket::deserialize(cur.field->data(), cur.field->size());
+        expandGenerated(data, coord, u.fill);
+        decoded = true;
+    } else if (cur.field) {
+        decoded = ChunkFieldPacket::deserialize(cur.field->data(), cur.field->size(), data);
+        if (!decoded) Log::err("ChunkManager: corrupt field payload; regenerating it for an edit");
+    }
+    if (!decoded) {
+        // Never generated (or unreadable): generate it as it stands first
+        generateChunk(data, coord);
+        cur = {storeField(coord, data), nullptr};
+        if (data.fill != ChunkData::Fill::Mixed) expandGenerated(data, coord, data.fill);
+    }
+
+    EditBox box;
+    for (const TerrainEdit& e : edits) TerrainEdits::apply(data, e, box);
+    _editsApplied.fetch_add(edits.size(), std::memory_order_relaxed);
+
+    EditResult r{coord, version, {}, !box.empty()};
+    if (!r.changed) {
+        // Only grazed it: whoever's waiting gets the chunk as it was
+        if ((*cur.field)[0] == (uint8_t)PacketID::ChunkUniform) cur.mesh = cur.field;
+        if (needMesh && !cur.mesh) cur.mesh = remeshEdit(data, box);
+        r.bytes = std::move(cur);
+        pack(key, r.bytes);
+    } else {
+        data.fill = TerrainEdits::classify(data);
+        {
+            Stage t(_timings.serialize, "gen.serialize", key);
+            r.bytes.field = std::make_shared<const std::vector<uint8_t>>(
+                data.fill == ChunkData::Fill::Air ? ChunkUniformPacket{coord, data.fill}.serialize()
+                                                  : ChunkFieldPacket::serialize(data));
+        }
+        {
+            Trace::Span t("gen.store", key);
+            _regions.save(coord, r.bytes.field);
+        }
+        if (data.fill == ChunkData::Fill::Air) {
+            r.bytes.mesh = r.bytes.field;
+            takeEditSlabs(coord);
+        } else if (needMesh) {
+            r.bytes.mesh = remeshEdit(data, box);
+        } else {
+            takeEditSlabs(coord); // would be stale by the next edit
+        }
+        pack(key, r.bytes);
+        _cache.replace(key, r.bytes);
+    }
+    {
+        MemTags::Scope tag(MemTags::ChunkCache);
+        keepResident(resident && !r.changed ? std::move(resident) : ResidentChunk::fromData(data));
+    }
+
+    std::lock_guard lk(_readyMu);
+    _editsDone.push_back(std::move(r));
+}
+
+// Re-marches only the z slabs whose cells touch a changed sample — a cell
+// reads its corners and, for normals, one sample past them — when the
+// chunk's slabs are kept from its last edit; all of them otherwise, and
+// always under surface nets, which has no slabs to keep
+ChunkPayload ChunkManager::remeshEdit(const ChunkData& data, const EditBox& box) {
+    const ChunkKey key{data.coord, 0};
+    EditSlabs slabs = takeEditSlabs(data.coord);
+    const bool all  = !slabs || defaultMesher() == Mesher::Nets;
+    const int  n    = Config::EDIT_REMESH_SLABS;
+    if (!slabs) slabs = std::make_shared<std::vector<ChunkMesh>>(n);
+
+    ChunkMesh& mesh = workerMesh();
+    {
+        Stage t(_timings.march, "edit.march", key);
+        constexpr int S = ChunkData::SIZE;
+        const int lo = box.lo[2] - 2, hi = box.hi[2] + 1;
+        for (int i = 0; i < n; i++) {
+            // Slab i marches cells [S*i/n, S*(i+1)/n)
+            if (all || (S * (i + 1) / n > lo && S * i / n <= hi)) marchSlab(data, (*slabs)[i], i, n);
+        }
+        stitchSlabs(*slabs, mesh);
+        mesh.faceLinks = chunkFaceLinks(data);
+    }
+    keepEditSlabs(data.coord, std::move(slabs));
+    {
+        Stage t(_timings.optimize, "edit.optimize", key);
+        optimizeMesh(mesh);
+    }
+    Stage t(_timings.serialize, "gen.serialize", key);
+    return std::make_shared<const std::vector<uint8_t>>(ChunkDataPacket::serialize(mesh));
+}
+
+ChunkManager::EditSlabs ChunkManager::takeEditSlabs(ChunkCoord coord) {
+    std::lock_guard lk(_editSlabMu);
+    auto it = _editSlabs.find(coord);
+    if (it == _editSlabs.end()) return nullptr;
+    EditSlabs s = std::move(it->second);
+    _editSlabs.erase(it);
+    _editSlabOrder.erase(std::find(_editSlabOrder.begin(), _editSlabOrder.end(), coord));
+    return s;
+}
+
+void ChunkManager::keepEditSlabs(ChunkCoord coord, EditSlabs slabs) {
+    std::lock_guard lk(_editSlabMu);
+    _editSlabs[coord] = std::move(slabs);
+    _editSlabOrder.push_back(coord);
+    while (_editSlabOrder.size() > Config::EDIT_SLAB_CACHE_CHUNKS) {
+        _editSlabs.erase(_editSlabOrder.front());
+        _editSlabOrder.pop_front();
+    }
+}
+
+ChunkManager::Resident ChunkManager::takeResident(ChunkCoord coord) {
+    std::lock_guard lk(_residentMu);
+    auto it = _resident.find(coord);
+    if (it == _resident.end()) return nullptr;
+    Resident r = std::move(it->second);
+    _resident.erase(it);
+    _residentBytes -= r->bytes();
+    _residentOrder.erase(std::find(_residentOrder.begin(), _residentOrder.end(), coord));
+    return r;
+}
 
-        // Mark pendingChunks as sent (peer might be gone — check)
-        ClientState* cs = findClient(rc.peer);
-        if (cs) {
-            cs->pendingChunks.erase(rc.coord);
-            cs->sentChunks.insert(rc.coord);
-            ENetPacket* pkt = enet_packet_create(
-                rc.bytes.data(), rc.bytes.size(), ENET_PACKET_FLAG_RELIABLE);
-            enet_peer_send(rc.peer, 0, pkt);
-            sent = true;
+// The newest stays, even over budget
+void ChunkManager::keepResident(Resident chunk) {
+    std::lock_guard lk(_residentMu);
+    ChunkCoord coord = chunk->coord;
+    _residentBytes += chunk->bytes();
+    _resident[coord] = std::move(chunk);
+    _residentOrder.push_back(coord);
+    while (_residentBytes > (Config::RESIDENT_CHUNK_MB << 20) && _residentOrder.size() > 1) {
+        auto it = _resident.find(_residentOrder.front());
+        _residentBytes -= it->second->bytes();
+        _resident.erase(it);
+        _residentOrder.pop_front();
+    }
+}
+
+// To everyone holding the chunk, replacing anything of it still queued for
+// them, then to everyone who asked while the job ran; one packet per
+// encoding, stamped with the new version
+void ChunkManager::deliverEdit(EditResult& r) {
+    const ChunkKey key{r.coord, 0};
+    EditedChunk&   e = _edits[r.coord];
+    e.running = false;
+    if (r.changed) {
+        e.sent = r.version;
+        _densities.erase(r.coord);
+    }
+    std::vector<ENetPeer*> waiters;
+    std::swap(waiters, e.waiters);
+
+    ENetPacket* pkts[2][2] = {};
+    auto send = [&](ClientState& cs) {
+        const ChunkPayload& bytes = cs.fields ? r.bytes.field : r.bytes.mesh;
+        ClientState::Level& l = cs.levels[0];
+        if (!bytes) {
+            // Started meshing before this client came along
+            l.sent.reset(r.coord);
+            scheduleChunk(cs, key);
+            return;
         }
+        l.sent.set(r.coord, l.region);
+        const ChunkPayload& packed = cs.fields ? r.bytes.fieldPacked : r.bytes.meshPacked;
+        const bool          tight  = cs.packed && packed;
+        ENetPacket*& pkt = pkts[cs.fields][tight];
+        if (!pkt) pkt = Net::makeSharedPacket(versioned(key, tight ? packed : bytes));
+        if (!pkt) return;
+        Net::retain(pkt);
+        cs.outbound.push_back({key, pkt, Trace::on() ? Trace::nowUs() : 0});
+    };
 
-        batch.pop();
+    if (r.changed) {
+        for (ClientState& cs : _players.all<ClientState>()) {
+            ClientState::Level& l = cs.levels[0];
+            if (!l.sent.test(r.coord, l.region)) continue;
+            dropQueued(cs, key);
+            send(cs);
+        }
+    }
+    for (ENetPeer* p : waiters) {
+        ClientState* cs = findClient(p);
+        if (!cs || !cs->pendingChunks.erase(key)) continue; // left, or moved away
+        send(*cs);
     }
+    for (auto& row : pkts)
+        for (ENetPacket* pkt : row)
+            if (pkt && pkt->referenceCount == 0) enet_packet_destroy(pkt);
+
+    if (!e.queued.empty()) startEdit(r.coord);
+}
+
+// An edited chunk's payload in a ChunkUpdate carrying its version, so a
+// client can tell a stale decode from a fresh one; anything else as is
+ChunkPayload ChunkManager::versioned(const ChunkKey& key, const ChunkPayload& bytes) {
+    if (key.lod != 0) return bytes;
+    auto it = _edits.find(key.coord);
+    if (it == _edits.end() || it->second.sent == 0) return bytes;
+    return std::make_shared<const std::vector<uint8_t>>(
+        ChunkUpdatePacket::wrap(key.coord, it->second.sent, *bytes));
+}
+
+// A chunk the client listed with these very bytes goes out as a ChunkCached.
+// The listing is used up either way: a miss on the client comes back as a
+// ChunkUnload, and the resend has to be the bytes. hash is the payload's,
+// worked out once for all recipients.
+bool ChunkManager::offerCached(ClientState& cs, const ChunkKey& key, const ChunkPayload& bytes,
+                               std::optional<uint64_t>& hash) {
+    if (key.lod != 0 || cs.held.empty()) return false;
+    auto it = cs.held.find(key.coord);
+    if (it == cs.held.end()) return false;
+    if (!hash) hash = payloadHash(bytes->data(), bytes->size());
+    bool match = it->second == *hash;
+    cs.held.erase(it);
+    if (!match) return false;
+
+    auto e = _edits.find(key.coord);
+    ENetPacket* pkt = cachedPacket(key.coord, e != _edits.end() ? e->second.sent : 0, *hash);
+    if (!pkt) return false;
+    cs.outbound.push_back({key, pkt, Trace::on() ? Trace::nowUs() : 0});
+    return true;
+}
+
+// One reference held, as outbound entries are
+ENetPacket* ChunkManager::cachedPacket(ChunkCoord coord, uint32_t version, uint64_t hash) {
+    PacketWriter w(ChunkCachedPacket::BYTES);
+    ChunkCachedPacket{coord, version, hash}.write(w);
+    ENetPacket* pkt = Net::makeSharedPacket(std::make_shared<const std::vector<uint8_t>>(w.toVector()));
+    if (!pkt) return nullptr;
+    Net::retain(pkt);
+    _sentCached.fetch_add(1, std::memory_order_relaxed);
+    return pkt;
+}
 
-    if (sent) enet_host_flush(host);
+void ChunkManager::dropQueued(ClientState& cs, const ChunkKey& key) {
+    auto& ob = cs.outbound;
+    ob.erase(std::remove_if(ob.begin(), ob.end(), [&](const ClientState::Outbound& o) {
+        if (o.key != key) return false;
+        Net::release(o.pkt);
+        return true;
+    }), ob.end());
 }
 
 // ── findSpawnY ────────────────────────────────────────────────────────────────
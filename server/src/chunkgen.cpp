@@ -0,0 +1,268 @@
+// server/src/chunkgen.cpp
+// Standalone chunk generation service. Game servers started with
+// --chunkgen host:port send it the chunks they're missing, in batches, and
+// get each one back as it's done: the field (or uniform marker) of a
+// full-resolution chunk, its mesh too if asked, or a LOD cell's mesh. One
+// pool and one cache serve every server, so the chunks players on different
+// shards or instances share are generated once.
+//
+// The service is stateless apart from its cache: it never touches the region
+// store. A server still loads what it has saved itself, and saves what comes
+// back; only never-saved chunks reach the service.
+//
+// Usage:
+//   ./chunkgen [--port 7790] [--threads N] [--threads-min N] [--cache-mb MB]
+//              [--terrain-graph FILE] [--mesher cubes|nets]
+// The graph and mesher have to be the servers' own: both are part of the
+// world id they check, so a service on others is never asked.
+
+#include "chunk_gen.h"
+#include "chunk_cache.h"
+#include "chunkgen_packets.h"
+#include "config.h"
+#include "log.h"
+#include "marching_cubes.h"
+#include "net_common.h"
+#include "noise_gen.h"
+#include "thread_pool.h"
+#include <enet/enet.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// One generation job per key, across every server. Subscribers that asked
+// for the mesh of a chunk whose running job only makes the field wait for a
+// second, mesh-only job started from it.
+struct Job {
+    std::vector<std::pair<ENetPeer*, bool>> subs; // peer, wants the mesh
+    bool                                    meshing = false;
+};
+
+struct Done {
+    ChunkKey      key;
+    ChunkPayloads bytes;
+};
+
+class ChunkGenService {
+public:
+    ChunkGenService(uint16_t port, const ThreadPoolOptions& pool, size_t cacheBytes)
+        : _host(port, Config::CHUNKGEN_MAX_PEERS), _cache(cacheBytes), _pool(pool) {}
+
+    void run() {
+        auto nextStatus = std::chrono::steady_clock::now();
+        while (true) {
+            // Workers don't wake the host; poll quickly while anything runs
+            ENetEvent ev;
+            int       ms = _jobs.empty() ? 100 : Config::CHUNK_FLUSH_MS;
+            while (enet_host_service(_host.get(), &ev, ms) > 0) {
+                ms = 0;
+                switch (ev.type) {
+                case ENET_EVENT_TYPE_CONNECT:
+                    Log::info("Chunkgen: server connected");
+                    break;
+                case ENET_EVENT_TYPE_DISCONNECT:
+                    dropPeer(ev.peer);
+                    Log::info("Chunkgen: server disconnected");
+                    break;
+                case ENET_EVENT_TYPE_RECEIVE:
+                    receive(ev.peer, ev.packet->data, ev.packet->dataLength);
+                    enet_packet_destroy(ev.packet);
+                    break;
+                default:
+                    break;
+                }
+            }
+            drainDone();
+            enet_host_flush(_host.get());
+
+            auto now = std::chrono::steady_clock::now();
+            if (now >= nextStatus) {
+                nextStatus = now + std::chrono::minutes(1);
+                logStatus();
+            }
+        }
+    }
+
+private:
+    void receive(ENetPeer* peer, const uint8_t* d, size_t len) {
+        if (len == 0) return;
+        switch ((ChunkGenPacketID)d[0]) {
+        case ChunkGenPacketID::ChunkGenHello: {
+            ChunkGenHelloPacket hello;
+            if (!ChunkGenHelloPacket::deserialize(d, len, hello)) return;
+            // Answered either way; a server from another world hangs up
+            if (hello.world == _world) _servers.insert(peer);
+            else Log::warn("Chunkgen: hello from a server of another world");
+            ChunkGenHelloPacket{_world}.write(_out);
+            Net::sendReliable(peer, _out.data(), _out.size());
+            break;
+        }
+        case ChunkGenPacketID::ChunkGenRequest: {
+            ChunkGenRequestPacket req;
+            if (!_servers.count(peer) || !ChunkGenRequestPacket::deserialize(d, len, req)) return;
+            for (const ChunkGenRequestPacket::Entry& e : req.entries) request(peer, e.key, e.mesh);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    void request(ENetPeer* peer, const ChunkKey& key, bool mesh) {
+        if (key.lod < 0 || key.lod > Config::LOD_LEVELS_MAX) return;
+        mesh |= key.lod > 0;
+        ChunkPayloads cached = _cache.get(key, mesh);
+        if (mesh ? cached.mesh : cached.field) {
+            send(peer, key, cached);
+            return;
+        }
+        auto [it, isNew] = _jobs.try_emplace(key);
+        Job& job = it->second;
+        job.subs.push_back({peer, mesh});
+        if (isNew) {
+            job.meshing = mesh;
+            start(key, cached.field, mesh);
+        }
+        // A field-only job already running: the mesh follows it (drainDone)
+    }
+
+    // Generates (or, given the field, just marches) on the pool
+    void start(const ChunkKey& key, ChunkPayload field, bool mesh) {
+        _pool.submit([this, key, field, mesh]() {
+            ChunkPayloads out{field, nullptr};
+            if (key.lod > 0) {
+                bool uniform = false;
+                out.mesh = buildLodCell(key, _timings, uniform);
+            } else {
+                if (!out.field) {
+                    ChunkData& data = workerData();
+                    {
+                        Stage t(_timings.noise, "gen.noise", key);
+                        generateChunk(data, key.coord);
+                    }
+                    out.field = encodeField(key.coord, data, _timings);
+                    _generated.fetch_add(1, std::memory_order_relaxed);
+                }
+                // A uniform marker doubles as the mesh
+                if ((*out.field)[0] == (uint8_t)PacketID::ChunkUniform) out.mesh = out.field;
+                else if (mesh) out.mesh = marchField(key, out.field, _timings);
+            }
+            _cache.put(key, out);
+            std::lock_guard lk(_doneMu);
+            _done.push_back({key, std::move(out)});
+        });
+    }
+
+    void drainDone() {
+        std::vector<Done> done;
+        {
+            std::lock_guard lk(_doneMu);
+            done.swap(_done);
+        }
+        for (Done& d : done) {
+            auto it = _jobs.find(d.key);
+            if (it == _jobs.end()) continue;
+            Job& job = it->second;
+            // A corrupt field marches to nothing; those subscribers get the
+            // field alone and mesh it themselves, as a fallback
+            bool meshFailed = job.meshing && !d.bytes.mesh;
+            std::vector<std::pair<ENetPeer*, bool>> waiting;
+            for (auto& [peer, mesh] : job.subs) {
+                if (!mesh || d.bytes.mesh || meshFailed) send(peer, d.key, d.bytes);
+                else waiting.push_back({peer, mesh});
+            }
+            if (waiting.empty() || !d.bytes.field) {
+                _jobs.erase(it);
+                continue;
+            }
+            job.subs    = std::move(waiting);
+            job.meshing = true;
+            start(d.key, d.bytes.field, true);
+        }
+    }
+
+    void send(ENetPeer* peer, const ChunkKey& key, const ChunkPayloads& bytes) {
+        // A uniform marker goes once, as the field; a LOD cell has only a mesh
+        ChunkPayload field = key.lod > 0 ? nullptr : bytes.field;
+        ChunkPayload mesh  = bytes.mesh == bytes.field && key.lod == 0 ? nullptr : bytes.mesh;
+        ChunkGenResultPacket::write(_out, key, field ? field->data() : nullptr, field ? field->size() : 0,
+                                    mesh ? mesh->data() : nullptr, mesh ? mesh->size() : 0);
+        ENetPacket* pkt = enet_packet_create(_out.data(), _out.size(), ENET_PACKET_FLAG_RELIABLE);
+        enet_peer_send(peer, Net::CHANNEL_STREAM, pkt);
+    }
+
+    // Its jobs keep running; the results still land in the cache
+    void dropPeer(ENetPeer* peer) {
+        _servers.erase(peer);
+        for (auto& [key, job] : _jobs)
+            std::erase_if(job.subs, [peer](const auto& s) { return s.first == peer; });
+    }
+
+    void logStatus() {
+        ChunkCache::Stats cs = _cache.stats();
+        Log::info("Chunkgen: " + std::to_string(_servers.size()) + " servers, " +
+                  std::to_string(_jobs.size()) + " jobs, generated " +
+                  std::to_string(_generated.load(std::memory_order_relaxed)) + "; cache " +
+                  std::to_string(cs.entries) + " chunks, " + std::to_string(cs.bytes >> 20) + "/" +
+                  std::to_string(cs.budget >> 20) + " MB, hits " + std::to_string(cs.hits) +
+                  ", misses " + std::to_string(cs.misses) + "; pool " +
+                  std::to_string(_pool.threadCount()) + "/" + std::to_string(_pool.maxThreads()));
+    }
+
+    Net::Host    _host;
+    uint32_t     _world = generatorWorldId();
+    PacketWriter _out;
+
+    std::unordered_set<ENetPeer*>                    _servers; // said hello from this world
+    std::unordered_map<ChunkKey, Job, ChunkKeyHash>  _jobs;
+
+    ChunkCache            _cache;
+    GenTimings            _timings;
+    std::atomic<uint64_t> _generated{0};
+    std::mutex            _doneMu;
+    std::vector<Done>     _done;
+
+    // Declared last: workers touch everything above
+    ThreadPool _pool;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Log::init("aetheris_chunkgen.log");
+    Log::installCrashHandlers();
+
+    int    port    = Config::CHUNKGEN_PORT;
+    size_t cacheMB = Config::CHUNKGEN_CACHE_MB;
+    ThreadPoolOptions pool{Config::GEN_THREADS_MIN, Config::GEN_THREADS_MAX, {}, MemTags::GenScratch};
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--port") port = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--threads") pool.maxThreads = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--threads-min") pool.minThreads = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--cache-mb") cacheMB = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::string(argv[i]) == "--terrain-graph" && !loadTerrainGraph(argv[++i])) {
+            Log::shutdown();
+            return 1;
+        }
+        else if (std::string(argv[i]) == "--mesher") useMesher(Meshers::parse(argv[++i]));
+    }
+
+    Net::init();
+    {
+        ChunkGenService service((uint16_t)port, pool, cacheMB << 20);
+        Log::info("Chunkgen listening on " + std::to_string(port) + ", cache " + std::to_string(cacheMB) + " MB");
+        service.run();
+    }
+    Net::deinit();
+    Log::shutdown();
+    return 0;
+}
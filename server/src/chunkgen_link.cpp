@@ -0,0 +1,125 @@
+#include "chunkgen_link.h"
+#include "config.h"
+#include "log.h"
+#include "net_common.h"
+#include <algorithm>
+#include <stdexcept>
+
+static ChunkPayload payloadOf(std::vector<uint8_t>& bytes) {
+    if (bytes.empty()) return nullptr;
+    return std::make_shared<const std::vector<uint8_t>>(std::move(bytes));
+}
+
+ChunkGenLink::ChunkGenLink(std::string host, uint16_t port, uint32_t world)
+    : _hostName(std::move(host)), _port(port), _world(world)
+{
+    _host = enet_host_create(nullptr, 1, Net::CHANNEL_COUNT, 0, 0);
+    if (!_host) throw std::runtime_error("enet_host_create (chunkgen link) failed");
+}
+
+ChunkGenLink::~ChunkGenLink() {
+    if (_peer) enet_peer_disconnect_now(_peer, 0);
+    if (_host) enet_host_destroy(_host);
+}
+
+bool ChunkGenLink::request(const ChunkKey& key, bool mesh) {
+    std::lock_guard lk(_mu);
+    if (!up() || _outstanding.size() >= Config::CHUNKGEN_OUTSTANDING_MAX) return false;
+    if (_outstanding.insert(key).second) _batch.push_back({key, mesh || key.lod > 0});
+    return true;
+}
+
+void ChunkGenLink::service(std::vector<Result>& done, std::vector<ChunkKey>& lost) {
+    auto now = Clock::now();
+    if (!_peer && !_refused && now >= _retryAt) {
+        _retryAt = now + std::chrono::milliseconds(Config::CHUNKGEN_RECONNECT_MS);
+        ENetAddress addr{};
+        if (enet_address_set_host(&addr, _hostName.c_str()) == 0) {
+            addr.port = _port;
+            _peer     = enet_host_connect(_host, &addr, Net::CHANNEL_COUNT, 0);
+        }
+    }
+
+    ENetEvent ev;
+    while (enet_host_service(_host, &ev, 0) > 0) {
+        switch (ev.type) {
+        case ENET_EVENT_TYPE_CONNECT:
+            ChunkGenHelloPacket{_world}.write(_out);
+            Net::sendReliable(ev.peer, _out.data(), _out.size());
+            break;
+        case ENET_EVENT_TYPE_DISCONNECT:
+            if (up()) Log::warn("Chunkgen link to " + _hostName + " lost; generating locally");
+            _peer    = nullptr;
+            _retryAt = now + std::chrono::milliseconds(Config::CHUNKGEN_RECONNECT_MS);
+            dropped(lost);
+            break;
+        case ENET_EVENT_TYPE_RECEIVE:
+            receive(ev.packet->data, ev.packet->dataLength, done);
+            enet_packet_destroy(ev.packet);
+            break;
+        default:
+            break;
+        }
+    }
+    if (!_peer) return;
+
+    // Everything the workers handed over since the last call, in the order
+    // they popped it — most urgent first
+    std::vector<ChunkGenRequestPacket::Entry> batch;
+    {
+        std::lock_guard lk(_mu);
+        batch.swap(_batch);
+    }
+    ChunkGenRequestPacket req;
+    for (size_t i = 0; i < batch.size(); i += ChunkGenRequestPacket::MAX_ENTRIES) {
+        size_t n = std::min(batch.size() - i, ChunkGenRequestPacket::MAX_ENTRIES);
+        req.entries.assign(batch.begin() + i, batch.begin() + i + n);
+        req.write(_out);
+        Net::sendReliable(_peer, _out.data(), _out.size());
+    }
+    enet_host_flush(_host);
+}
+
+void ChunkGenLink::receive(const uint8_t* d, size_t len, std::vector<Result>& done) {
+    if (len == 0) return;
+    switch ((ChunkGenPacketID)d[0]) {
+    case ChunkGenPacketID::ChunkGenHello: {
+        ChunkGenHelloPacket hello;
+        if (!ChunkGenHelloPacket::deserialize(d, len, hello)) return;
+        if (hello.world != _world) {
+            Log::err("Chunkgen service at " + _hostName + " generates another world; not using it");
+            _refused = true;
+            enet_peer_disconnect(_peer, 0);
+            return;
+        }
+        {
+            std::lock_guard lk(_mu);
+            _up.store(true, std::memory_order_relaxed);
+        }
+        Log::info("Chunkgen link to " + _hostName + ":" + std::to_string(_port) + " up");
+        break;
+    }
+    case ChunkGenPacketID::ChunkGenResult: {
+        ChunkGenResultPacket r;
+        if (!ChunkGenResultPacket::deserialize(d, len, r)) return;
+        {
+            std::lock_guard lk(_mu);
+            if (!_outstanding.erase(r.key)) return;
+        }
+        done.push_back({r.key, {payloadOf(r.field), payloadOf(r.mesh)}});
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// Down: nothing handed over comes back now, batched or sent. Under _mu, so
+// a request() racing the drop either lands in lost or sees the link down.
+void ChunkGenLink::dropped(std::vector<ChunkKey>& lost) {
+    std::lock_guard lk(_mu);
+    _up.store(false, std::memory_order_relaxed);
+    lost.insert(lost.end(), _outstanding.begin(), _outstanding.end());
+    _outstanding.clear();
+    _batch.clear();
+}
@@ -0,0 +1,298 @@
+#include "inv_store.h"
+#include "log.h"
+#include "mem_tags.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+  #include <io.h>
+#else
+  #include <unistd.h>
+#endif
+
+// ── Encoding ──────────────────────────────────────────────────────────────────
+
+namespace {
+
+static constexpr size_t SLOT_BYTES = 2 + 4;
+static constexpr size_t INV_BYTES  = (INV_SIZE + EQUIP_SLOTS + HOTBAR_SIZE * HOTBAR_MODE_COUNT) * SLOT_BYTES;
+static constexpr size_t KEY_BYTES  = 1 + 8;
+
+uint32_t fnv1a(const uint8_t* p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+template<class T> void put(std::vector<uint8_t>& b, T v) {
+    size_t at = b.size();
+    b.resize(at + sizeof(T));
+    std::memcpy(b.data() + at, &v, sizeof(T));
+}
+template<class T> T get(const uint8_t*& p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return v;
+}
+
+void writeInv(std::vector<uint8_t>& b, const Inventory& inv) {
+    auto slot = [&](const ItemStack& s) { put<uint16_t>(b, (uint16_t)s.id); put<int32_t>(b, s.count); };
+    for (const auto& s : inv.grid)       slot(s);
+    for (const auto& s : inv.equipSlots) slot(s);
+    for (const auto& s : inv.hotbars)    slot(s);
+}
+
+void readInv(const uint8_t*& p, Inventory& inv) {
+    auto slot = [&](ItemStack& s) { s.id = (ItemID)get<uint16_t>(p); s.count = get<int32_t>(p); };
+    for (auto& s : inv.grid)       slot(s);
+    for (auto& s : inv.equipSlots) slot(s);
+    for (auto& s : inv.hotbars)    slot(s);
+}
+
+} // namespace
+
+void InvStore::appendRecord(Bytes& out, const Key& k, const Bytes& payload) {
+    uint32_t len = (uint32_t)(KEY_BYTES + payload.size());
+    size_t at = out.size();
+    ::put<uint32_t>(out, len);
+    ::put<uint32_t>(out, 0); // checksum, patched below
+    out.push_back(k.first);
+    ::put<uint64_t>(out, k.second);
+    out.insert(out.end(), payload.begin(), payload.end());
+    uint32_t sum = fnv1a(out.data() + at + 8, len);
+    std::memcpy(out.data() + at + 4, &sum, 4);
+}
+
+bool InvStore::syncFile(FILE* f) {
+    if (fflush(f) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+// ── Open ──────────────────────────────────────────────────────────────────────
+
+InvStore::InvStore(std::string dir)
+    : _dir(std::move(dir))
+    , _logPath(_dir + "/" + LOG_FILE)
+    , _snapPath(_dir + "/" + SNAP_FILE)
+{
+    MemTags::Scope tag(MemTags::Inventory);
+    std::error_code ec;
+    std::filesystem::create_directories(_dir, ec);
+    if (ec) Log::err("InvStore: cannot create " + _dir + ": " + ec.message());
+
+    replay(_snapPath, _state, false);
+    bool logOk = replay(_logPath, _state, true);
+    if (!openLog(!logOk)) Log::err("InvStore: cannot open " + _logPath + ", inventories won't be saved");
+    Log::info("InvStore: " + std::to_string(_state.size()) + " records, log " +
+              std::to_string(_logBytes >> 10) + " KB");
+
+    _io = std::thread([this] { run(); });
+}
+
+InvStore::~InvStore() {
+    {
+        std::lock_guard lk(_mu);
+        _stop = true;
+    }
+    _cv.notify_one();
+    if (_io.joinable()) _io.join();
+    if (_log) fclose(_log);
+}
+
+// Reads a snapshot or log into `into`. Returns false if the file exists but
+// isn't ours; a bad record ends the replay (and with truncateTail, the file).
+bool InvStore::replay(const std::string& path, State& into, bool truncateTail) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return true; // nothing stored yet
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    Bytes data(size > 0 ? (size_t)size : 0);
+    bool read = data.empty() || fread(data.data(), 1, data.size(), f) == data.size();
+    fclose(f);
+
+    FileHeader h{};
+    if (!read || data.size() < sizeof(h)) return false;
+    std::memcpy(&h, data.data(), sizeof(h));
+    if (h.magic != MAGIC || h.version != VERSION) {
+        Log::warn("InvStore: ignoring " + path + " (not a v" + std::to_string(VERSION) + " store)");
+        return false;
+    }
+
+    size_t o = sizeof(h);
+    while (o + 8 <= data.size()) {
+        const uint8_t* p = data.data() + o;
+        uint32_t len = get<uint32_t>(p), sum = get<uint32_t>(p);
+        if (len < KEY_BYTES || o + 8 + len > data.size() || fnv1a(p, len) != sum) break;
+        Key k;
+        k.first  = get<uint8_t>(p);
+        k.second = get<uint64_t>(p);
+        into[k] = std::make_shared<const Bytes>(p, p + (len - KEY_BYTES));
+        o += 8 + len;
+    }
+
+    if (o != data.size()) {
+        Log::warn("InvStore: " + path + " has a torn record at byte " + std::to_string(o) + ", dropping the rest");
+        if (truncateTail) {
+            std::error_code ec;
+            std::filesystem::resize_file(path, o, ec);
+        }
+    }
+    if (truncateTail) _logBytes = o;
+    return true;
+}
+
+bool InvStore::openLog(bool truncate) {
+    if (_log) fclose(_log);
+    _log = fopen(_logPath.c_str(), truncate ? "wb" : "ab");
+    if (!_log) return false;
+    if (truncate || _logBytes == 0) {
+        FileHeader h{MAGIC, VERSION};
+        fwrite(&h, sizeof(h), 1, _log);
+        _logBytes = sizeof(h);
+        syncFile(_log);
+    }
+    return true;
+}
+
+// ── Reads / puts ──────────────────────────────────────────────────────────────
+
+bool InvStore::loadPlayer(uint64_t uid, Inventory& out) {
+    std::lock_guard lk(_mu);
+    auto it = _state.find({(uint8_t)Rec::Player, uid});
+    if (it == _state.end() || it->second->size() != INV_BYTES) return false;
+    const uint8_t* p = it->second->data();
+    readInv(p, out);
+    return true;
+}
+
+std::vector<InvStore::StoredChest> InvStore::chests() {
+    std::lock_guard lk(_mu);
+    std::vector<StoredChest> out;
+    for (auto it = _state.lower_bound({(uint8_t)Rec::Chest, 0});
+         it != _state.end() && it->first.first == (uint8_t)Rec::Chest; ++it) {
+        if (it->second->size() != 12 + INV_BYTES) continue;
+        StoredChest c;
+        c.uid = (uint32_t)it->first.second;
+        const uint8_t* p = it->second->data();
+        c.pos.x = get<float>(p); c.pos.y = get<float>(p); c.pos.z = get<float>(p);
+        readInv(p, c.inv);
+        out.push_back(c);
+    }
+    return out;
+}
+
+uint32_t InvStore::nextUID() {
+    std::lock_guard lk(_mu);
+    auto it = _state.find({(uint8_t)Rec::Meta, 0});
+    if (it == _state.end() || it->second->size() != 4) return 0;
+    const uint8_t* p = it->second->data();
+    return get<uint32_t>(p);
+}
+
+void InvStore::putPlayer(uint64_t uid, const Inventory& inv) {
+    MemTags::Scope tag(MemTags::Inventory);
+    Bytes b;
+    b.reserve(INV_BYTES);
+    writeInv(b, inv);
+    put(Rec::Player, uid, std::move(b));
+}
+
+void InvStore::putChest(uint32_t uid, glm::vec3 pos, const Inventory& inv) {
+    MemTags::Scope tag(MemTags::Inventory);
+    Bytes b;
+    b.reserve(12 + INV_BYTES);
+    ::put<float>(b, pos.x); ::put<float>(b, pos.y); ::put<float>(b, pos.z);
+    writeInv(b, inv);
+    put(Rec::Chest, uid, std::move(b));
+}
+
+void InvStore::putNextUID(uint32_t next) {
+    MemTags::Scope tag(MemTags::Inventory);
+    Bytes b;
+    ::put<uint32_t>(b, next);
+    put(Rec::Meta, 0, std::move(b));
+}
+
+void InvStore::put(Rec type, uint64_t id, Bytes payload) {
+    auto shared = std::make_shared<const Bytes>(std::move(payload));
+    {
+        std::lock_guard lk(_mu);
+        Key k{(uint8_t)type, id};
+        _state[k]   = shared;
+        _pending[k] = std::move(shared);
+    }
+    _cv.notify_one();
+}
+
+InvStore::Frozen InvStore::freeze() {
+    std::lock_guard lk(_mu);
+    return _state;
+}
+
+// ── I/O thread ────────────────────────────────────────────────────────────────
+
+void InvStore::run() {
+    MemTags::exchange(MemTags::Inventory);
+    std::unique_lock lk(_mu);
+    for (;;) {
+        _cv.wait(lk, [&] { return _stop || !_pending.empty(); });
+        // Let the burst finish so repeated puts of one key cost one record
+        if (!_stop) _cv.wait_for(lk, std::chrono::milliseconds(FLUSH_MS), [&] { return _stop; });
+
+        State batch;
+        batch.swap(_pending);
+        bool stop = _stop;
+        lk.unlock();
+
+        if (!batch.empty() && !appendBatch(batch))
+            Log::err("InvStore: write to " + _logPath + " failed");
+        if (_logBytes > COMPACT_BYTES || stop) compact();
+
+        lk.lock();
+        if (stop) return;
+    }
+}
+
+bool InvStore::appendBatch(const State& batch) {
+    if (!_log) return false;
+    Bytes buf;
+    buf.reserve(batch.size() * (8 + KEY_BYTES + 12 + INV_BYTES));
+    for (const auto& [k, payload] : batch) appendRecord(buf, k, *payload);
+    if (fwrite(buf.data(), 1, buf.size(), _log) != buf.size() || !syncFile(_log)) return false;
+    _logBytes += buf.size();
+    return true;
+}
+
+bool InvStore::writeSnapshot(const std::string& path, const Frozen& state) {
+    Bytes buf;
+    FileHeader h{MAGIC, VERSION};
+    buf.resize(sizeof(h));
+    std::memcpy(buf.data(), &h, sizeof(h));
+    for (const auto& [k, payload] : state) appendRecord(buf, k, *payload);
+
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    bool ok = f && fwrite(buf.data(), 1, buf.size(), f) == buf.size() && syncFile(f);
+    if (f) fclose(f);
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tmp, path, ec);
+    return ok && !ec;
+}
+
+// Full state to the snapshot, then an empty log. A crash before the rename
+// keeps the old snapshot and the full log; after it, replaying the old log
+// over the new snapshot lands on the same state.
+void InvStore::compact() {
+    if (!writeSnapshot(_snapPath, freeze())) {
+        Log::err("InvStore: snapshot to " + _snapPath + " failed");
+        return;
+    }
+    if (!openLog(true)) Log::err("InvStore: cannot reopen " + _logPath);
+}
@@ -1,188 +1,1287 @@
 #include "chunk_manager.h"
+#include "chunk_gen.h"
+#include "chunk_codec.h"
+#include "tick_scheduler.h"
+#include "tick_watchdog.h"
 #include "inventory_manager.h"
 #include "stats_manager.h"
+#include "outbox.h"
+#include "player_registry.h"
+#include "admission_queue.h"
+#include "async.h"
+#include "session_loader.h"
+#include "enemy_sim.h"
+#include "replication_server.h"
 #include "multiplayer_manager.h"
 #include "config.h"
 #include "log.h"
+#include "marching_cubes.h"
 #include "net_common.h"
 #include "packets.h"
 #include "inv_packets.h"
 #include "mp_packets.h"
 #include "player_stats.h"
+#include "packet_dispatch.h"
+#include "metrics.h"
+#include "metrics_server.h"
+#include "trace.h"
+#include "packet_capture.h"
+#include "server_net.h"
+#include "loopback.h"
+#include "shard_links.h"
+#include "shard_map.h"
+#include "tick_arena.h"
+#include "alloc_count.h"
+#include "mem_tags.h"
+#include "big_pages.h"
+#include "world_backup.h"
 #include <enet/enet.h>
 #include <unordered_map>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 static uint64_t peerToUID(ENetPeer* peer) {
     return (uint64_t)(uintptr_t)peer;
 }
 
-int main(int argc, char **argv) {
-    Log::init("aetheris_server.log");
-    Log::installCrashHandlers();
-    Log::info("Server starting");
+// Server keys in settings.cfg (same "key value" format the client uses;
+// unknown keys are skipped). Command-line flags override these.
+struct ServerSettings {
+    int  genThreadsMin = Config::GEN_THREADS_MIN;
+    int  genThreadsMax = Config::GEN_THREADS_MAX;
+    bool genPin        = false; // keep workers off the first cores, where the network threads run
+    int  netThreads    = Config::NET_THREADS;
+    int  simThreads    = Config::SIM_THREADS; // simulation helpers besides the main thread
+    std::string hugePages = Config::HUGE_PAGES; // off, thp or hugetlb
+    bool        numa      = Config::NUMA_LOCAL; // gen workers a core each, scratch on its node
+    int  peerSendKB    = (int)(Config::PEER_SEND_BYTES_PER_S >> 10); // per-peer send budget, KB/s
+    int  metricsPort   = Config::METRICS_PORT; // 0: no endpoint
+    std::string metricsBind = Config::METRICS_BIND;
+    std::string shards;      // shard map file; empty: one process owns the world
+    int         shard = 0;   // which of its shards this is
+    std::string shardSecret; // what the shards' links must say to be heard
+    std::string chunkgen;    // host[:port] of a chunkgen service; empty: generate here
+    size_t      sharedCacheMB = Config::SHARED_CHUNK_CACHE_MB; // host-wide chunk cache; 0: none
+    int         pregenRadius     = Config::PREGEN_RADIUS;      // columns around spawn at startup
+    int         pregenIdleRadius = Config::PREGEN_IDLE_RADIUS; // and when idle; 0: none
+    std::string chunkCodec       = Config::CHUNK_CODEC;        // zstd, lz4 or none
+    double      admitPerS        = Config::ADMIT_PER_S;        // logins let in a second; 0: no queue
+    std::string terrainGraph;    // noise graph file the terrain comes from; empty: the built-in one
+    std::string mesher           = Config::TERRAIN_MESHER;     // cubes or nets
+    std::string backupDir;       // where world backups go; empty: none
+    int         backupIntervalMin = Config::BACKUP_INTERVAL_MIN;
+    int         backupKeep        = Config::BACKUP_KEEP;
+    double      slowTickMs        = Config::SLOW_TICK_MS;  // 0: no watchdog dumps
+    std::string slowTickDir       = Config::SLOW_TICK_DIR;
 
-    Net::init();
-    Net::Host host(Config::SERVER_PORT, 32);
+    void load(const char* path = "settings.cfg") {
+        std::ifstream f(path);
+        if (!f) return;
+        std::string key;
+        while (f >> key) {
+            if      (key=="gen_threads")     f>>genThreadsMax;
+            else if (key=="gen_threads_min") f>>genThreadsMin;
+            else if (key=="gen_pin")         { int v; f>>v; genPin=v; }
+            else if (key=="net_threads")     f>>netThreads;
+            else if (key=="sim_threads")     f>>simThreads;
+            else if (key=="huge_pages")      f>>hugePages;
+            else if (key=="numa")            { int v; f>>v; numa=v; }
+            else if (key=="peer_send_kb")    f>>peerSendKB;
+            else if (key=="metrics_port")    f>>metricsPort;
+            else if (key=="metrics_bind")    f>>metricsBind;
+            else if (key=="shards")          f>>shards;
+            else if (key=="shard")           f>>shard;
+            else if (key=="shard_secret")    f>>shardSecret;
+            else if (key=="chunkgen")        f>>chunkgen;
+            else if (key=="shared_cache_mb") f>>sharedCacheMB;
+            else if (key=="pregen_radius")   f>>pregenRadius;
+            else if (key=="pregen_idle_radius") f>>pregenIdleRadius;
+            else if (key=="chunk_codec")     f>>chunkCodec;
+            else if (key=="admit_per_s")     f>>admitPerS;
+            else if (key=="terrain_graph")   f>>terrainGraph;
+            else if (key=="mesher")          f>>mesher;
+            else if (key=="backup_dir")      f>>backupDir;
+            else if (key=="backup_interval_min") f>>backupIntervalMin;
+            else if (key=="backup_keep")     f>>backupKeep;
+            else if (key=="slow_tick_ms")    f>>slowTickMs;
+            else if (key=="slow_tick_dir")   f>>slowTickDir;
+        }
+    }
+};
+
+// lb: running inside the client (singleplayer), which owns the log, the
+// ENet library and the crash handlers
+int serverMain(int argc, char** argv, Loopback* lb) {
+    const bool embedded = lb != nullptr;
+    if (!embedded) {
+        Log::init("aetheris_server.log");
+        Log::installCrashHandlers();
+    }
+    Log::info(embedded ? "Server starting in-process" : "Server starting");
+
+    ServerSettings settings;
+    settings.load();
+
+    size_t chunkCacheMB = Config::CHUNK_CACHE_BUDGET_MB;
+    std::string worldDir;
+    std::string capturePath, replayPath;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--chunk-cache-mb") chunkCacheMB = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::string(argv[i]) == "--world-dir") worldDir = argv[++i];
+        else if (std::string(argv[i]) == "--gen-threads") settings.genThreadsMax = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--gen-threads-min") settings.genThreadsMin = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--gen-pin") settings.genPin = std::atoi(argv[++i]) != 0;
+        else if (std::string(argv[i]) == "--net-threads") settings.netThreads = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--sim-threads") settings.simThreads = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--huge-pages") settings.hugePages = argv[++i];
+        else if (std::string(argv[i]) == "--numa") settings.numa = std::atoi(argv[++i]) != 0;
+        else if (std::string(argv[i]) == "--peer-send-kb") settings.peerSendKB = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--metrics-port") settings.metricsPort = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--metrics-bind") settings.metricsBind = argv[++i];
+        else if (std::string(argv[i]) == "--trace") Trace::start(argv[++i], 1, "server");
+        else if (std::string(argv[i]) == "--capture") capturePath = argv[++i];
+        else if (std::string(argv[i]) == "--replay") replayPath = argv[++i];
+        else if (std::string(argv[i]) == "--shards") settings.shards = argv[++i];
+        else if (std::string(argv[i]) == "--shard") settings.shard = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--shard-secret") settings.shardSecret = argv[++i];
+        else if (std::string(argv[i]) == "--chunkgen") settings.chunkgen = argv[++i];
+        else if (std::string(argv[i]) == "--shared-cache-mb") settings.sharedCacheMB = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::string(argv[i]) == "--pregen-radius") settings.pregenRadius = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--pregen-idle-radius") settings.pregenIdleRadius = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--chunk-codec") settings.chunkCodec = argv[++i];
+        else if (std::string(argv[i]) == "--admit-per-s") settings.admitPerS = std::atof(argv[++i]);
+        else if (std::string(argv[i]) == "--terrain-graph") settings.terrainGraph = argv[++i];
+        else if (std::string(argv[i]) == "--mesher") settings.mesher = argv[++i];
+        else if (std::string(argv[i]) == "--backup-dir") settings.backupDir = argv[++i];
+        else if (std::string(argv[i]) == "--backup-interval-min") settings.backupIntervalMin = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--backup-keep") settings.backupKeep = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--slow-tick-ms") settings.slowTickMs = std::atof(argv[++i]);
+        else if (std::string(argv[i]) == "--slow-tick-dir") settings.slowTickDir = argv[++i];
+    }
+    // One player on a loopback: no shards, services, endpoint or queue, and
+    // no wire to meter or compress chunks for
+    if (embedded) {
+        settings.shards.clear();
+        settings.chunkgen.clear();
+        settings.sharedCacheMB = 0;
+        settings.metricsPort   = 0;
+        settings.admitPerS     = 0.0;
+        settings.peerSendKB    = 1 << 20;
+        settings.chunkCodec    = "none";
+        settings.backupDir.clear();
+        settings.slowTickMs    = 0.0;
+        settings.simThreads    = 0;
+        settings.hugePages     = "off";
+        settings.numa          = false;
+    }
 
-    ChunkManager     chunks(1);
-    InventoryManager invMgr;
-    StatsManager     statsMgr;
-    MultiplayerManager mpMgr;
+    // A replay has no socket, and starts from an empty world of its own
+    // unless --world-dir names one (a copy of the live world, say)
+    bool replaying = !replayPath.empty();
+    bool ownWorld  = replaying && worldDir.empty();
+    if (ownWorld)
+        worldDir = (std::filesystem::temp_directory_path() /
+                    ("aetheris_replay_" + std::to_string(Trace::nowUs()))).string();
+    else if (worldDir.empty())
+        worldDir = Config::WORLD_DIR;
+
+    // ── Sharding ──────────────────────────────────────────────────────────────
+    // Every shard runs this binary against the same world directory and the
+    // same map; each listens on its own port from the map, saves only its
+    // own regions, and keeps its chests and inventories to itself. A replay
+    // runs unsharded.
+    ShardMap shardMap;
+    if (!settings.shards.empty() && !replaying && !shardMap.load(settings.shards)) {
+        Log::shutdown();
+        return 1;
+    }
+    const uint16_t self = shardMap.sharded() ? (uint16_t)settings.shard : 0;
+    const ShardMap::Shard* selfShard = shardMap.find(self);
+    if (shardMap.sharded() && !selfShard) {
+        Log::err("--shard " + std::to_string(settings.shard) + " isn't in " + settings.shards);
+        Log::shutdown();
+        return 1;
+    }
+    const uint16_t port = selfShard ? selfShard->port : (uint16_t)Config::SERVER_PORT;
+
+    if (!embedded) Net::init();
+    ServerNet net;
+    if (embedded) net.attach(*lb);
+
+    std::unique_ptr<ShardLinks> links;
+    if (shardMap.sharded()) {
+        links = std::make_unique<ShardLinks>(shardMap, self, settings.shardSecret);
+        Log::info("Shard " + std::to_string(self) + " of " + std::to_string(shardMap.shards().size()) +
+                  ", regions " + std::to_string(selfShard->rx0) + "," + std::to_string(selfShard->rz0) +
+                  " to " + std::to_string(selfShard->rx1) + "," + std::to_string(selfShard->rz1) +
+                  (self == 0 ? " and the rest" : ""));
+    }
+
+    // Ahead of every pool and cache it places
+    BigPages::configure({BigPages::parse(settings.hugePages), settings.numa});
+    if (BigPages::policy().mode == BigPages::Mode::Off && settings.hugePages != "off")
+        Log::warn("Unknown huge_pages " + settings.hugePages + "; using normal pages");
+    if (BigPages::policy().mode != BigPages::Mode::Off) {
+        // The chunk cache and density store are many small payloads on the
+        // heap, which only malloc can put on huge pages
+        const char* tunables = std::getenv("GLIBC_TUNABLES");
+        Log::info(std::string("Huge pages: ") + BigPages::name(BigPages::policy().mode) +
+                  " for the shared chunk cache and worker scratch" +
+                  (tunables && std::strstr(tunables, "glibc.malloc.hugetlb")
+                       ? ", malloc's arenas by GLIBC_TUNABLES"
+                       : "; set GLIBC_TUNABLES=glibc.malloc.hugetlb=1 for the heap caches"));
+    }
+
+    const int netThreads = replaying ? 1 : std::max(1, settings.netThreads);
+    ThreadPoolOptions genPool{settings.genThreadsMin, settings.genThreadsMax, {}, MemTags::GenScratch};
+    genPool.pinEach = settings.numa;
+    if (settings.genPin && std::thread::hardware_concurrency() > (unsigned)netThreads) {
+        // Each network thread gets a core to itself, from core 0 (replay:
+        // the replay loop); they're pinned once they start
+        if (!replaying || ThreadPool::pinCurrentThread(0))
+            for (int c = 0; c < netThreads; c++) genPool.avoidCpus.push_back(c);
+        else Log::warn("--gen-pin: thread affinity not supported here");
+    }
+
+    // Before the chunk manager: the region store's seed folds in the graph
+    if (!settings.terrainGraph.empty() && !loadTerrainGraph(settings.terrainGraph)) {
+        Log::shutdown();
+        return 1;
+    }
+    useMesher(Meshers::parse(settings.mesher));
+    if (defaultMesher() != Mesher::Cubes) Log::info(std::string("Meshing with ") + Meshers::name(defaultMesher()));
+
+    // What an iteration builds and drops by its end; reset after the flush
+    TickArena        tickArena;
+    // Every connected peer's state, each manager's as a component of it
+    PlayerRegistry   playerReg;
+    ChunkManager     chunks(playerReg, genPool, chunkCacheMB << 20, worldDir);
+    chunks.useTickArena(tickArena);
+    if (links)
+        chunks.setOwnedRegions([&shardMap, self](ChunkCoord r) { return shardMap.ownerOfRegion(r) == self; });
+    if (settings.sharedCacheMB > 0 && !replaying && !chunks.useSharedCache(settings.sharedCacheMB << 20))
+        Log::warn("Shared chunk cache unavailable; generating alone");
+    if (!settings.chunkgen.empty() && !replaying) {
+        std::string host = settings.chunkgen;
+        int genPort = Config::CHUNKGEN_PORT;
+        if (size_t colon = host.rfind(':'); colon != std::string::npos) {
+            genPort = std::atoi(host.c_str() + colon + 1);
+            host.resize(colon);
+        }
+        chunks.useChunkGen(host, (uint16_t)genPort);
+    }
+    Log::info("Chunk generation: " + std::to_string(chunks.genThreads()) + "-" +
+              std::to_string(chunks.genThreadsMax()) + " workers" +
+              (genPool.avoidCpus.empty() ? "" : ", pinned off the network threads' cores") +
+              (genPool.pinEach ? ", a core each with node-local scratch" : ""));
+    // Ahead of pregeneration, whose chunks are packed as they're cached
+    if (ChunkCodec codec = ChunkCodecs::parse(settings.chunkCodec); codec != ChunkCodec::None)
+        chunks.useCompression(codec, 0.f, 0.f);
+    else if (settings.chunkCodec != "none")
+        Log::warn("Unknown chunk_codec " + settings.chunkCodec + "; chunks go out uncompressed");
+
+    // Spawn's surroundings before the first connection; the rest as the
+    // pool goes idle. A replay generates only what its capture asks for.
+    if (!replaying) {
+        if (settings.pregenRadius > 0) chunks.pregenerate(0.f, 0.f, settings.pregenRadius);
+        if (settings.pregenIdleRadius > 0) chunks.setIdlePregen(0.f, 0.f, settings.pregenIdleRadius);
+        if (!embedded) net.start(port, Config::MAX_PEERS, netThreads);
+        if (net.lanes() > 1) Log::info("Network: " + std::to_string(net.lanes()) + " threads on port " + std::to_string(port));
+        if (!genPool.avoidCpus.empty() && !net.pin(0))
+            Log::warn("--gen-pin: thread affinity not supported here");
+    }
+    // Every send goes through here; flushed once per loop iteration, to the
+    // network thread
+    Outbox           outbox((size_t)std::max(1, settings.peerSendKB) << 10);
+    if (!replaying)
+        outbox.setSink([&net](ENetPeer* peer, uint8_t channel, ENetPacket* pkt) { net.send(peer, channel, pkt); });
+    // Auth checks and save loads, as coroutines resumed once an iteration
+    // (endIteration); declared ahead of everything whose frames it holds
+    AsyncLoop        tasks;
+    InventoryManager invMgr(links ? worldDir + "/shard-" + std::to_string(self) : worldDir, outbox, playerReg);
+    StatsManager     statsMgr(outbox, playerReg);
+    MultiplayerManager mpMgr(outbox, playerReg, tasks);
+    mpMgr.setIdBase((uint32_t)self << 24);
+    // Verified logins wait their turn to enter; a replay lets them straight
+    // in, as the capture's own timeline already did
+    AdmissionQueue   admission(outbox, replaying ? 0.0 : settings.admitPerS);
+    // Then their saved data is read off the main thread; they enter once
+    // it's in. Every login is held for that, admission or not.
+    SessionLoader    sessions(tasks, [&invMgr](uint64_t uid) { return PlayerSession{invMgr.loadPlayerInv(uid), {}}; });
+    mpMgr.hold = [&](ENetPeer* peer) {
+        if (!admission.push(peer)) sessions.start(peer, peerToUID(peer));
+        return true;
+    };
+    EnemySim         enemies(outbox);
+    std::vector<EnemySim::Target> enemyTargets;
+    SimRegions       simRegions(settings.simThreads);
+    if (simRegions.threads() > 0)
+        Log::info("Simulation: regions over " + std::to_string(simRegions.threads()) + " threads and the main one");
+    // Server-side entities whose components replicate to CAP_REPLICATION
+    // clients; features move onto it one at a time, registering their
+    // components here and in the client's ReplicationClient in one order
+    entt::registry     world;
+    ReplicationServer  repl(world, outbox);
+
+    // Replay time: the capture's timeline, stepped by the replay loop
+    TickScheduler::Clock::time_point replayNow = TickScheduler::Clock::now();
+    auto replayClock = [&replayNow] { return replayNow; };
+    if (replaying) {
+        outbox.setClock(replayClock);
+        mpMgr.setClock(replayClock);
+        chunks.setClock(replayClock);
+        mpMgr.offline = true; // tokens from the capture are long expired
+    }
+    if (embedded) mpMgr.offline = true; // alone, under whatever name
 
     // Parse auth server config from args: --auth-host X --auth-port Y
+    // --auth-keys FILE (session token signing keys, see session_token.h)
     for (int i = 1; i + 1 < argc; i++) {
         if (std::string(argv[i]) == "--auth-host") mpMgr.authHost = argv[++i];
         else if (std::string(argv[i]) == "--auth-port") mpMgr.authPort = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--auth-concurrency") mpMgr.authConcurrency = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--auth-keys") mpMgr.authKeysPath = argv[++i];
+    }
+    if (!mpMgr.authKeysPath.empty()) {
+        std::ifstream in(mpMgr.authKeysPath);
+        std::string   text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (!mpMgr.setAuthKeys(text)) Log::warn("--auth-keys: no keys in " + mpMgr.authKeysPath);
+    }
+    if (replaying) {
+        Log::info("Replaying " + replayPath + " into " + worldDir);
+    } else {
+        Log::info("Auth server: " + mpMgr.authHost + ":" + std::to_string(mpMgr.authPort) + ", " +
+                  std::to_string(mpMgr.authKeyCount()) + " session token keys");
+        if (!embedded) Log::info(std::string("Listening on port ") + std::to_string(port));
     }
-    Log::info("Auth server: " + mpMgr.authHost + ":" + std::to_string(mpMgr.authPort));
 
-    Log::info(std::string("Listening on port ") +
-              std::to_string(Config::SERVER_PORT));
+    // Where a placed player last was, by their reports and the server's
+    // own spawns
+    struct PlayerPos {
+        glm::vec3 pos;
+    };
 
-    std::unordered_map<ENetPeer*, glm::vec3> positions;
+    // Normal connect setup, once a verified login has its session loaded.
+    // A player another shard handed over (arrival) brings their session
+    // along, starts where they were, and isn't sent a SpawnPosition: the
+    // client is already standing there with the world around it loaded.
+    auto onAuthenticated = [&](ENetPeer* peer, const AuthRequestPacket& req, PlayerSession& session,
+                               const ShardHandoffPacket* arrival = nullptr) {
+        // Ahead of SpawnPosition on the same channel, so the client knows
+        // what it's keeping before it starts evicting
+        ViewConfigPacket view{chunks.addClient(peer, req.caps, req.viewRadius), chunks.worldId()};
+        PacketWriter w;
+        view.write(w);
+        outbox.reliable(peer, w.data(), w.size());
+        // On the stream lane, ahead of every chunk packed with it
+        if (ChunkPayload dict = chunks.dictFor(req.caps))
+            if (ENetPacket* pkt = Net::makeSharedPacket(dict)) outbox.stream(peer, pkt);
+        invMgr.onPlayerConnect(peer, peerToUID(peer), std::move(session.inv));
+        statsMgr.onPlayerConnect(peer, session.stats);
+        if (req.caps & CAP_REPLICATION) repl.addClient(peer);
 
-    using Clock = std::chrono::steady_clock;
-    auto lastTick = Clock::now();
-    float statsFlushAccum = 0.f;
-    float possBroadcastAccum = 0.f;
+        glm::vec3 at;
+        if (arrival) {
+            at = {arrival->x, arrival->y, arrival->z};
+        } else {
+            at = {0.f, chunks.findSpawnY(0.f, 0.f) + Config::PLAYER_HEIGHT + 2.f, 0.f};
+        }
+        playerReg.emplace<PlayerPos>(peer, at);
+        mpMgr.teleport(peer, at);
 
-    while (true) {
-        auto now = Clock::now();
-        float dt = std::chrono::duration<float>(now - lastTick).count();
-        lastTick = now;
-        if (dt > 0.1f) dt = 0.1f;
+        chunks.updateClient(peer, at.x, at.y, at.z);
+        chunks.flushReady(outbox);
 
-        ENetEvent ev;
-        while (enet_host_service(host.get(), &ev, 0) > 0) {
-            switch (ev.type) {
+        // Test camp by the spawn point, seeded when the first player arrives
+        // on the shard that has it
+        if (enemies.empty() && shardMap.ownerAt({}) == self)
+            for (glm::vec3 off : {glm::vec3{5.f, 0.f, 0.f}, glm::vec3{-5.f, 0.f, 3.f}, glm::vec3{0.f, 0.f, -6.f}})
+                enemies.spawn({off.x, chunks.findSpawnY(off.x, off.z) + 0.5f, off.z});
 
-            case ENET_EVENT_TYPE_CONNECT: {
-                Log::info("Peer connected (awaiting auth)");
-                mpMgr.onPeerConnect(ev.peer);
-                // Don't do chunk/inv/stats setup until authenticated
-                break;
+        if (!arrival) {
+            SpawnPositionPacket sp{at.x, at.y, at.z};
+            outbox.reliable(peer, sp.serialize());
+        }
+
+        invMgr.sendInventoryState(peer);
+        statsMgr.sendFullSync(peer);
+    };
+    sessions.ready = [&](ENetPeer* peer, PlayerSession& session) {
+        AuthRequestPacket req;
+        if (mpMgr.enter(peer, req)) onAuthenticated(peer, req, session);
+    };
+
+    // ── Shard handoff ─────────────────────────────────────────────────────────
+    // A player SHARD_HANDOFF_M into another shard's area is sent there:
+    // their state goes ahead over the link, then the client is told to
+    // reconnect with the ticket. They stay here until they do, their moves
+    // still applied, so a link or client that fails just leaves them on this
+    // shard. Edits reaching another shard's players' view are passed on.
+    std::unordered_map<ENetPeer*, uint16_t> handingOff;
+    PacketWriter shardWriter;
+    const float  shardReach = (float)(Config::SHARD_BORDER_CHUNKS * ChunkData::SIZE);
+    const float  editReach  = (float)((Config::VIEW_RADIUS_MAX + 1) * ChunkData::SIZE);
+
+    auto offerHandoff = [&](ENetPeer* peer, glm::vec3 pos) {
+        if (!links || handingOff.count(peer)) return;
+        uint16_t to = shardMap.ownerAt(pos);
+        if (to == self || shardMap.distanceTo(self, pos, Config::SHARD_HANDOFF_M) <= Config::SHARD_HANDOFF_M ||
+            !links->up(to))
+            return;
+        const ConnectedPlayer* p    = mpMgr.getPlayer(peer);
+        const ShardMap::Shard* dest = shardMap.find(to);
+        const Inventory*       inv  = invMgr.playerInventory(peer);
+        const PlayerStats*     st   = statsMgr.get(peer);
+        if (!p || !dest || !inv || !st || st->dead) return;
+
+        ShardHandoffPacket h;
+        h.ticket    = links->newTicket();
+        h.player    = p->id;
+        h.name      = p->username;
+        h.uid       = p->uid;
+        h.x = pos.x; h.y = pos.y; h.z = pos.z;
+        h.yaw       = p->yaw;
+        h.pitch     = p->pitch;
+        h.moveEpoch = p->moveEpoch;
+        h.stats     = *st;
+        h.inv       = *inv;
+        h.write(shardWriter);
+        if (!links->send(to, shardWriter.data(), shardWriter.size())) return;
+
+        ShardRedirectPacket{dest->host, dest->port, ShardHandoffPacket::token(h.ticket)}.write(shardWriter);
+        outbox.reliable(peer, shardWriter.data(), shardWriter.size());
+        handingOff[peer] = to;
+        Log::info("Handing %s over to shard %u", p->username, (unsigned)to);
+    };
+
+    auto shareEdit = [&](const TerrainEdit& edit) {
+        if (!links) return;
+        glm::vec3 centre{(float)edit.x, (float)edit.y, (float)edit.z};
+        ShardEditPacket{edit}.write(shardWriter);
+        for (const ShardMap::Shard& s : shardMap.shards())
+            if (s.id != self && shardMap.distanceTo(s.id, centre, editReach) <= editReach)
+                links->send(s.id, shardWriter.data(), shardWriter.size());
+    };
+
+    // Logins with a handoff ticket. It comes over the link from the shard
+    // the player left, usually well ahead of them; a login that beats it
+    // waits up to SHARD_ARRIVAL_WAIT_MS.
+    struct Arrival {
+        ENetPeer*                             peer;
+        AuthRequestPacket                     req;
+        std::chrono::steady_clock::time_point giveUp;
+    };
+    std::vector<Arrival> arrivals;
+    auto admitArrivals = [&] {
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < arrivals.size();) {
+            Arrival& a = arrivals[i];
+            if (auto h = links->claim(a.req.token)) {
+                PlayerSession carried{h->inv, h->stats};
+                if (mpMgr.acceptArrival(a.peer, a.req, *h)) onAuthenticated(a.peer, a.req, carried, &*h);
+            } else if (now < a.giveUp) {
+                i++;
+                continue;
+            } else {
+                AuthResponsePacket arp{0, 0, "Handoff expired."};
+                outbox.reliable(a.peer, arp.serialize());
             }
+            arrivals[i] = std::move(arrivals.back());
+            arrivals.pop_back();
+        }
+    };
 
-            case ENET_EVENT_TYPE_RECEIVE: {
-                const uint8_t* d   = ev.packet->data;
-                size_t         len = ev.packet->dataLength;
-                if (len == 0) { enet_packet_destroy(ev.packet); break; }
+    // ── Packet handlers ───────────────────────────────────────────────────────
+    // ── Slow ticks ────────────────────────────────────────────────────────────
+    // Every handler and slot run is timed into the watchdog; the live loop
+    // below brackets each iteration and names the rest of it
+    TickWatchdog watchdog(settings.slowTickDir, settings.slowTickMs);
 
-                uint8_t pid = d[0];
+    PacketDispatcher dispatch;
+    dispatch.setTimer([&](uint8_t id, TickWatchdog::Clock::time_point t0, TickWatchdog::Clock::time_point t1) {
+        const char* name = packetName(id);
+        watchdog.record(name ? name : "packet", id, t0, t1);
+    });
+    // All packets but AuthRequest require authentication
+    dispatch.setGate([&](ENetPeer* peer) { return mpMgr.isAuthenticated(peer); });
 
-                // ── Auth request (must come first) ────────────────────────
-                if (pid == (uint8_t)MPPacketID::AuthRequest) {
-                    auto req = AuthRequestPacket::deserialize(d, len);
-                    mpMgr.onAuthRequest(ev.peer, req, host.get());
+    dispatch.on(MPPacketID::AuthRequest, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        auto req = AuthRequestPacket::deserialize(d, len);
+        // Every chunk it would get is laid out for another size
+        if (req.chunkSize != ChunkData::SIZE) {
+            AuthResponsePacket arp{0, 0, "Chunk size " + std::to_string(req.chunkSize) + ", server's is " +
+                                             std::to_string(ChunkData::SIZE) + "."};
+            outbox.reliable(peer, arp.serialize());
+            return;
+        }
+        if (links && req.token.rfind("shard:", 0) == 0) {
+            arrivals.push_back({peer, req, std::chrono::steady_clock::now() +
+                                               std::chrono::milliseconds(Config::SHARD_ARRIVAL_WAIT_MS)});
+            admitArrivals();
+            return;
+        }
+        mpMgr.onAuthRequest(peer, req); // held: into the admission queue or straight to a load
+    }, /*open=*/true);
 
-                    // If authenticated, do normal connect setup
-                    if (mpMgr.isAuthenticated(ev.peer)) {
-                        chunks.addClient(ev.peer);
-                        invMgr.onPlayerConnect(ev.peer, peerToUID(ev.peer));
-                        statsMgr.onPlayerConnect(ev.peer);
+    // ── Shard links ───────────────────────────────────────────────────────────
+    // Open, so a link is heard without logging in; past the hello, only
+    // peers that are links get anywhere
+    dispatch.on(ShardPacketID::ShardHello, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        ShardHelloPacket hello;
+        if (links && ShardHelloPacket::deserialize(d, len, hello)) links->onHello(peer, hello);
+    }, /*open=*/true);
 
-                        float surfaceY = chunks.findSpawnY(0.f, 0.f);
-                        float spawnY = surfaceY + Config::PLAYER_HEIGHT + 2.f;
-                        positions[ev.peer] = {0.f, spawnY, 0.f};
+    dispatch.on(ShardPacketID::ShardGhosts, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        ShardGhostsPacket pkt;
+        int from = links ? links->shardOf(peer) : -1;
+        if (from < 0 || !ShardGhostsPacket::deserialize(d, len, pkt)) return;
+        mpMgr.setGhosts((uint16_t)from, pkt.ghosts);
+    }, /*open=*/true);
 
-                        chunks.updateClient(ev.peer, 0.f, spawnY, 0.f);
-                        chunks.flushReady(host.get());
+    dispatch.on(ShardPacketID::ShardHandoff, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        ShardHandoffPacket pkt;
+        if (!links || links->shardOf(peer) < 0 || !ShardHandoffPacket::deserialize(d, len, pkt)) return;
+        links->expect(std::move(pkt));
+        admitArrivals();
+    }, /*open=*/true);
 
-                        SpawnPositionPacket sp{0.f, spawnY, 0.f};
-                        Net::sendReliable(ev.peer, sp.serialize());
+    dispatch.on(ShardPacketID::ShardEdit, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        ShardEditPacket pkt;
+        if (!links || links->shardOf(peer) < 0 || !ShardEditPacket::deserialize(d, len, pkt)) return;
+        chunks.editTerrain(pkt.edit);
+    }, /*open=*/true);
 
-                        invMgr.sendInventoryState(ev.peer);
-                        statsMgr.sendFullSync(ev.peer);
-                        enet_host_flush(host.get());
-                    }
+    dispatch.on(PacketID::PlayerMove, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        auto mv = PlayerMovePacket::deserialize(d, len);
+        glm::vec3 pos{mv.x, mv.y, mv.z};
+        if (PlayerPos* p = playerReg.get<PlayerPos>(peer)) p->pos = pos;
+        chunks.updateClient(peer, mv.x, mv.y, mv.z);
+        invMgr.onPlayerMove(peer, pos);
+        mpMgr.onPlayerMove(peer, mv.x, mv.y, mv.z, mv.yaw, mv.pitch);
+        offerHandoff(peer, pos);
+    });
 
-                    enet_packet_destroy(ev.packet);
-                    break;
-                }
+    dispatch.on(MPPacketID::PlayerMoveQ, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        PlayerMoveQPacket mv;
+        if (!PlayerMoveQPacket::deserialize(d, len, mv)) return;
+        if (!mpMgr.onPlayerMoveQ(peer, mv)) return; // refused and corrected
+        glm::vec3 pos{mv.x, mv.y, mv.z};
+        if (PlayerPos* p = playerReg.get<PlayerPos>(peer)) p->pos = pos;
+        chunks.updateClient(peer, mv.x, mv.y, mv.z);
+        invMgr.onPlayerMove(peer, pos);
+        offerHandoff(peer, pos);
+    });
 
-                // All other packets require authentication
-                if (!mpMgr.isAuthenticated(ev.peer)) {
-                    enet_packet_destroy(ev.packet);
-                    break;
-                }
+    dispatch.on(MPPacketID::EnemyHit, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        EnemyHitPacket hit;
+        const PlayerPos* p = playerReg.get<PlayerPos>(peer);
+        if (!p || !EnemyHitPacket::deserialize(d, len, hit)) return;
+        enemies.applyHit(peer, hit, p->pos);
+    });
+
+    dispatch.on(MPPacketID::PlayerDefend, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        PlayerDefendPacket def;
+        if (!playerReg.get<PlayerPos>(peer) || !PlayerDefendPacket::deserialize(d, len, def)) return;
+        enemies.applyDefend(peer, def);
+    });
+
+    // The two list packets a moving client keeps sending are read into the
+    // same one each time (per message, reused), so their lists keep the
+    // capacity
+    ChunkUnloadPacket unloadPkt;
+    dispatch.on(PacketID::ChunkUnload, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        if (ChunkUnloadPacket::deserialize(d, len, unloadPkt))
+            chunks.forgetChunks(peer, unloadPkt.coords);
+    });
+
+    dispatch.on(PacketID::ViewRadius, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        ViewRadiusPacket pkt;
+        if (!ViewRadiusPacket::deserialize(d, len, pkt)) return;
+        ViewConfigPacket view{chunks.setViewRadius(peer, pkt.radius), chunks.worldId()};
+        PacketWriter w;
+        view.write(w);
+        outbox.reliable(peer, w.data(), w.size());
+    });
+
+    ChunkHavePacket havePkt;
+    dispatch.on(PacketID::ChunkHave, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        if (ChunkHavePacket::deserialize(d, len, havePkt))
+            chunks.holdChunks(peer, havePkt.entries);
+    });
+
+    // Out of reach, or from a player the server hasn't placed, is dropped
+    dispatch.on(PacketID::TerrainEdit, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        TerrainEditPacket pkt;
+        const PlayerPos* p = playerReg.get<PlayerPos>(peer);
+        if (!p || !TerrainEditPacket::deserialize(d, len, pkt)) return;
+        glm::vec3 centre{(float)pkt.edit.x, (float)pkt.edit.y, (float)pkt.edit.z};
+        if (glm::distance(centre, p->pos) > Config::EDIT_REACH) return;
+        chunks.editTerrain(pkt.edit);
+        shareEdit(pkt.edit);
+    });
 
-                if (pid == (uint8_t)PacketID::PlayerMove) {
-                    auto mv = PlayerMovePacket::deserialize(d, len);
-                    glm::vec3 pos{mv.x, mv.y, mv.z};
-                    positions[ev.peer] = pos;
-                    chunks.updateClient(ev.peer, mv.x, mv.y, mv.z);
-                    invMgr.onPlayerMove(ev.peer, pos);
-                    mpMgr.onPlayerMove(ev.peer, mv.x, mv.y, mv.z, mv.yaw, mv.pitch);
-
-                } else if (pid == (uint8_t)PacketID::RespawnRequest) {
-                    float surfaceY = chunks.findSpawnY(0.f, 0.f);
-                    float spawnY = surfaceY + Config::PLAYER_HEIGHT + 2.f;
-                    positions[ev.peer] = {0.f, spawnY, 0.f};
-
-                    chunks.resetClient(ev.peer);
-                    chunks.updateClient(ev.peer, 0.f, spawnY, 0.f);
-
-                    SpawnPositionPacket sp{0.f, spawnY, 0.f};
-                    Net::sendReliable(ev.peer, sp.serialize());
-                    invMgr.sendInventoryState(ev.peer);
-                    statsMgr.respawn(ev.peer);
-                    enet_host_flush(host.get());
-
-                } else if (pid == (uint8_t)InvPacketID::ChestOpenReq) {
-                    auto req = ChestOpenReqPacket::deserialize(d, len);
-                    invMgr.onChestOpenReq(ev.peer, req);
-                    enet_host_flush(host.get());
-
-                } else if (pid == (uint8_t)InvPacketID::ChestCloseReq) {
-                    auto req = ChestCloseReqPacket::deserialize(d, len);
-                    invMgr.onChestCloseReq(ev.peer, req);
-
-                } else if (pid == (uint8_t)InvPacketID::InventoryMoveReq) {
-                    auto req = InventoryMoveReqPacket::deserialize(d, len);
-                    invMgr.onInventoryMoveReq(ev.peer, req);
-                    enet_host_flush(host.get());
+    dispatch.on(PacketID::RespawnRequest, [&](ENetPeer* peer, const uint8_t*, size_t) {
+        float surfaceY = chunks.findSpawnY(0.f, 0.f);
+        float spawnY = surfaceY + Config::PLAYER_HEIGHT + 2.f;
+        glm::vec3 at{0.f, spawnY, 0.f};
+        playerReg.emplace<PlayerPos>(peer, at);
+        mpMgr.teleport(peer, at);
+
+        chunks.resetClient(peer);
+        chunks.updateClient(peer, 0.f, spawnY, 0.f);
+
+        SpawnPositionPacket sp{0.f, spawnY, 0.f};
+        outbox.reliable(peer, sp.serialize());
+        invMgr.sendInventoryState(peer);
+        statsMgr.respawn(peer);
+    });
+
+    dispatch.on(InvPacketID::ChestOpenReq, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        auto req = ChestOpenReqPacket::deserialize(d, len);
+        invMgr.onChestOpenReq(peer, req);
+    });
+
+    dispatch.on(InvPacketID::ChestCloseReq, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        auto req = ChestCloseReqPacket::deserialize(d, len);
+        invMgr.onChestCloseReq(peer, req);
+    });
+
+    dispatch.on(InvPacketID::InventoryMoveReq, [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        auto req = InventoryMoveReqPacket::deserialize(d, len);
+        invMgr.onInventoryMoveReq(peer, req);
+    });
+
+    dispatch.on(InvPacketID::InventoryResync, [&](ENetPeer* peer, const uint8_t*, size_t) {
+        invMgr.sendInventoryState(peer);
+    });
+
+    // Receive counters since the last call; replay also wants them summed
+    std::array<PacketDispatcher::Stats, 256> recvTotals{};
+    auto takeRecvStats = [&] {
+        auto stats = dispatch.takeStats();
+        for (const auto& p : stats) {
+            PacketDispatcher::Stats& t = recvTotals[p.id];
+            t.id   = p.id;
+            t.name = p.name;
+            t.packets   += p.packets;
+            t.bytes     += p.bytes;
+            t.handlerNs += p.handlerNs;
+            t.dropped   += p.dropped;
+        }
+        return stats;
+    };
+
+    // ── Tick slots ────────────────────────────────────────────────────────────
+    TickScheduler sched;
+    if (replaying) sched.setClock(replayClock);
+    sched.setRunHook([&](const char* name, TickScheduler::Clock::time_point t0, TickScheduler::Clock::time_point t1) {
+        watchdog.record(name, -1, t0, t1);
+    });
+    sched.add("sim", Config::SERVER_TICK_HZ, [&](float dt) {
+        statsMgr.update(dt);
+    }, 4);
+    sched.add("enemies", Config::ENEMY_TICK_HZ, [&](float dt) {
+        enemyTargets.clear();
+        mpMgr.forEachPlayer([&](const ConnectedPlayer& p) {
+            if (const PlayerStats* st = statsMgr.get(p.peer); st && !st->dead)
+                enemyTargets.push_back({p.peer, p.pos});
+        });
+        enemies.tick(dt, enemyTargets, simRegions, [&](ENetPeer* peer, float damage) {
+            statsMgr.applyDamage(peer, damage);
+        });
+    }, 2);
+    sched.add("enemy_sync", Config::ENEMY_BROADCAST_HZ, [&](float) {
+        // Everyone sees enemies, dead or not
+        enemyTargets.clear();
+        mpMgr.forEachPlayer([&](const ConnectedPlayer& p) { enemyTargets.push_back({p.peer, p.pos}); });
+        enemies.broadcast(enemyTargets);
+    });
+    sched.add("stats", Config::STATS_FLUSH_HZ, [&](float) {
+        statsMgr.flushDirty();
+    });
+    sched.add("positions", Config::POS_BROADCAST_HZ, [&](float) {
+        mpMgr.broadcastPositions();
+    });
+    // Keys (reread from --auth-keys) and revocations for signed session
+    // tokens, now and then every AUTH_KEYS_REFRESH_S
+    if (!replaying) {
+        mpMgr.refreshAuthKeys();
+        sched.add("auth_keys", 1.0 / Config::AUTH_KEYS_REFRESH_S, [&](float) { mpMgr.refreshAuthKeys(); });
+    }
+    sched.add("replication", Config::REPL_HZ, [&](float) {
+        mpMgr.forEachPlayer([&](const ConnectedPlayer& p) { repl.setViewer(p.peer, p.pos); });
+        repl.flush();
+    });
+    // Each other shard hears, at the same rate, which of our players are
+    // near enough its area to be shown there; an empty list clears them
+    ShardGhostsPacket ghosts;
+    if (links) sched.add("shard_ghosts", Config::POS_BROADCAST_HZ, [&](float) {
+        for (const ShardMap::Shard& s : shardMap.shards()) {
+            if (s.id == self || !links->up(s.id)) continue;
+            ghosts.shard = self;
+            ghosts.ghosts.clear();
+            mpMgr.forEachPlayer([&](const ConnectedPlayer& p) {
+                if (shardMap.distanceTo(s.id, p.pos, shardReach) <= shardReach)
+                    ghosts.ghosts.push_back({p.id, p.username, p.pos.x, p.pos.y, p.pos.z, p.yaw, p.pitch});
+            });
+            ghosts.write(shardWriter);
+            links->send(s.id, shardWriter.data(), shardWriter.size(), /*movement=*/true);
+        }
+    });
+    uint64_t lastNetAllocs = 0, lastNetPooled = 0; // the status line's last look, for rates
+    uint64_t iterations = 0, lastIterations = 0;       // of the main loop (endIteration)
+#ifdef AETHERIS_COUNT_ALLOCS
+    uint64_t lastHeapAllocs = AllocCount::thisThread();
+#endif
+    sched.add("status", 1.0 / 60.0, [&](float) {
+        auto cs = chunks.cacheStats();
+        Log::info("Chunk cache: " + std::to_string(cs.entries) + " chunks, " +
+                  std::to_string(cs.bytes >> 20) + "/" + std::to_string(cs.budget >> 20) +
+                  " MB, hits " + std::to_string(cs.hits) + ", misses " +
+                  std::to_string(cs.misses) + ", evictions " + std::to_string(cs.evictions) +
+                  "; generated " + std::to_string(chunks.generatedCount()) +
+                  " (" + std::to_string(chunks.uniformCount()) + " uniform, " +
+                  std::to_string(chunks.lodCount()) + " LOD, " +
+                  std::to_string(chunks.remoteCount()) + " by chunkgen, " +
+                  std::to_string(chunks.sharedCount()) + " shared, " +
+                  std::to_string(chunks.pregenCount()) + " pregenerated)");
+
+        auto ps = chunks.packStats();
+        if (ps.payloads > 0) {
+            char buf[160];
+            snprintf(buf, sizeof(buf), "Chunk compression: %s, %llu payloads packed %.2fx, %llu not worth it",
+                     ChunkCodecs::name(ps.codec), (unsigned long long)ps.payloads,
+                     (double)ps.rawBytes / (double)std::max<uint64_t>(ps.packedBytes, 1),
+                     (unsigned long long)ps.skipped);
+            Log::info(buf);
+        }
+
+        std::string util;
+        for (float u : chunks.genUtilization()) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), " %d%%", (int)(u * 100.f + 0.5f));
+            util += buf;
+        }
+        Log::info("Gen pool: " + std::to_string(chunks.genThreads()) + "/" +
+                  std::to_string(chunks.genThreadsMax()) + " workers, busy" + util);
+
+        if (net.lanes() > 1) {
+            std::string peers;
+            for (int n : net.lanePeers()) peers += " " + std::to_string(n);
+            Log::info("Network threads: peers" + peers);
+        }
+
+        auto ds = chunks.densityStats();
+        if (ds.hits + ds.misses > 0)
+            Log::info("Terrain queries: " + std::to_string(ds.entries) + " chunks decoded, " +
+                      std::to_string(ds.bytes >> 20) + "/" + std::to_string(ds.budget >> 20) +
+                      " MB, hits " + std::to_string(ds.hits) + ", misses " + std::to_string(ds.misses) +
+                      ", evictions " + std::to_string(ds.evictions));
+
+        auto rc = chunks.residentStats();
+        if (rc.entries > 0)
+            Log::info("Edited chunks resident: " + std::to_string(rc.entries) + " in " +
+                      std::to_string(rc.bytes >> 10) + " KB, " + std::to_string(rc.bytes / rc.entries >> 10) +
+                      " KB each against " + std::to_string(sizeof(ChunkData) >> 10) + " KB decoded");
+
+        if (!enemies.empty()) {
+            auto es = enemies.takeStats();
+            char buf[192];
+            snprintf(buf, sizeof(buf),
+                     "Enemies: %zu, %llu steps over %llu ticks in up to %u regions, %llu deferred, worst tick %.2f ms",
+                     enemies.size(), (unsigned long long)es.steps, (unsigned long long)es.ticks, es.regions,
+                     (unsigned long long)es.deferred, es.worstMs);
+            Log::info(buf);
+        }
+
+        auto as = admission.takeStats();
+        if (as.waiting > 0 || as.worstWaitS >= 1.f) {
+            char buf[160];
+            snprintf(buf, sizeof(buf), "Admission: %zu waiting, %llu let in, longest wait %.1f s, load %.0f%%",
+                     as.waiting, (unsigned long long)as.admitted, as.worstWaitS, as.load * 100.f);
+            Log::info(buf);
+        }
+
+        auto ss = sessions.takeStats();
+        if (ss.worstMs >= 100.f) {
+            char buf[160];
+            snprintf(buf, sizeof(buf), "Sessions: %zu loading, %llu loaded, slowest %.0f ms",
+                     ss.loading, (unsigned long long)ss.loaded, ss.worstMs);
+            Log::info(buf);
+        }
+
+        auto rs = repl.stats();
+        if (rs.entities > 0)
+            Log::info("Replication: " + std::to_string(rs.entities) + " entities, " +
+                      std::to_string(rs.records) + " records in " + std::to_string(rs.bytes >> 10) +
+                      " KB, " + std::to_string(rs.deferred) + " deferred");
+
+        for (const auto& t : sched.takeStats()) {
+            if (t.overruns == 0 && t.skipped == 0) continue;
+            char buf[160];
+            snprintf(buf, sizeof(buf),
+                     "Tick %s: %llu overruns, %llu skipped of %llu runs; worst %.1f ms late, %.1f ms run",
+                     t.name.c_str(), (unsigned long long)t.overruns,
+                     (unsigned long long)t.skipped, (unsigned long long)t.runs,
+                     t.worstLateMs, t.worstRunMs);
+            Log::warn(buf);
+        }
+
+        auto na = NetAlloc::stats();
+        if (uint64_t n = na.allocs - lastNetAllocs; n > 0) {
+            char buf[160];
+            snprintf(buf, sizeof(buf), "ENet memory: %.0f allocs/s, %.0f%% pooled, %lld KB live, %lld KB kept",
+                     n / 60.0, 100.0 * (double)(na.fromPool - lastNetPooled) / (double)n,
+                     (long long)(na.liveBytes >> 10), (long long)(na.heldBytes >> 10));
+            Log::info(buf);
+        }
+        lastNetAllocs = na.allocs;
+        lastNetPooled = na.fromPool;
+
+        if (auto bp = BigPages::stats(); bp.liveBytes > 0 && BigPages::policy().mode != BigPages::Mode::Off)
+            Log::info("Big pages: " + std::to_string(bp.liveBytes >> 10) + " KB mapped, " +
+                      std::to_string(bp.hugetlb) + " from the hugetlb pool, " +
+                      std::to_string(bp.fallbacks) + " fell back to transparent");
+
+#ifdef AETHERIS_COUNT_ALLOCS
+        if (uint64_t it = iterations - lastIterations; it > 0) {
+            uint64_t heap = AllocCount::thisThread() - lastHeapAllocs;
+            char buf[160];
+            snprintf(buf, sizeof(buf), "Main loop heap: %.2f allocs per iteration over %llu, tick arena %zu KB",
+                     (double)heap / (double)it, (unsigned long long)it, tickArena.capacity() >> 10);
+            Log::info(buf);
+        }
+        lastHeapAllocs = AllocCount::thisThread();
+#endif
+        lastIterations = iterations;
+
+        if (auto os = outbox.takeStats(); os.packets)
+            Log::info("Outbox: " + std::to_string(os.messages) + " messages + " +
+                      std::to_string(os.streamed) + " chunks in " + std::to_string(os.packets) +
+                      " packets, " + std::to_string(os.bytes >> 10) + " KB; " +
+                      std::to_string(os.backlog) + " chunks waiting on budgets");
+
+        for (const auto& p : takeRecvStats())
+            Log::info("Recv " + PacketDispatcher::format(p));
+    });
+
+    // ── Metrics ───────────────────────────────────────────────────────────────
+    // Histograms and counters update in place from whichever thread does the
+    // work; callbacks only read thread-safe state. Per-peer series live on
+    // the simulation thread, so the "metrics" slot publishes them as a block.
+    MetricsRegistry    metrics;
+    Metrics::Histogram tickSeconds;
+    Metrics::Histogram tickEvents(Metrics::exponential(1, 2, 12));
+    Metrics::Counter   bytesIn;
+    Metrics::Gauge     players;
+    std::unordered_map<ENetPeer*, uint64_t> peerBytesIn;
+
+    metrics.add("aetheris_tick_seconds", "Simulation loop work per iteration, events through flush", tickSeconds);
+    metrics.add("aetheris_enet_events_per_tick", "ENet events handled per simulation loop iteration", tickEvents);
+    metrics.add("aetheris_net_bytes_in_total", "Packet bytes received from peers", bytesIn);
+    metrics.addCounterFn("aetheris_net_bytes_out_total", "UDP payload bytes sent, ENet headers and resends included",
+                         [&net] { return (double)net.bytesSent(); });
+    metrics.addCounterFn("aetheris_enet_allocs_total", "ENet allocations",
+                         [] { return (double)NetAlloc::stats().allocs; });
+    metrics.addCounterFn("aetheris_enet_allocs_pooled_total", "ENet allocations served from NetAlloc's free lists",
+                         [] { return (double)NetAlloc::stats().fromPool; });
+    metrics.addGaugeFn("aetheris_enet_live_bytes", "ENet memory handed out and not yet freed",
+                       [] { return (double)NetAlloc::stats().liveBytes; });
+    metrics.add("aetheris_players", "Authenticated players", players);
+    metrics.add("aetheris_auth_seconds", "AuthRequest to acceptance", mpMgr.authSeconds);
+    metrics.add("aetheris_pos_batches_total", "Position batches queued", mpMgr.posSent);
+    metrics.add("aetheris_pos_suppressed_total", "Position batches skipped with nothing new in range", mpMgr.posSuppressed);
+    metrics.add("aetheris_gen_noise_seconds", "Chunk density sampling", chunks.genTimings().noise);
+    metrics.add("aetheris_gen_march_seconds", "Chunk meshing, field decode included", chunks.genTimings().march);
+    metrics.add("aetheris_gen_optimize_seconds", "Chunk mesh reordering for the GPU", chunks.genTimings().optimize);
+    metrics.add("aetheris_gen_serialize_seconds", "Chunk payload encoding", chunks.genTimings().serialize);
+    metrics.add("aetheris_gen_edit_seconds", "Terrain edit jobs, remeshing included", chunks.genTimings().edit);
+    metrics.addCounterFn("aetheris_terrain_edits_total", "Terrain edits applied, per chunk reached",
+                         [&chunks] { return (double)chunks.editCount(); });
+    metrics.addGaugeFn("aetheris_gen_queue_depth", "Generation tasks waiting for a worker",
+                       [&chunks] { return (double)chunks.genPending(); });
+    metrics.addGaugeFn("aetheris_gen_workers", "Generation workers running",
+                       [&chunks] { return (double)chunks.genThreads(); });
+    metrics.addCounterFn("aetheris_chunks_generated_total", "Chunks generated, LOD cells included",
+                         [&chunks] { return (double)chunks.generatedCount(); });
+    metrics.addCounterFn("aetheris_chunks_remote_total", "Chunks the chunkgen service generated for this server",
+                         [&chunks] { return (double)chunks.remoteCount(); });
+    metrics.addGaugeFn("aetheris_async_live", "Server coroutines started and not yet finished",
+                       [&tasks] { return (double)tasks.live(); });
+    metrics.addCounterFn("aetheris_async_resumed_total", "Server coroutine resumptions",
+                         [&tasks] { return (double)tasks.resumed(); });
+    metrics.addCounterFn("aetheris_chunks_shared_total", "Chunks taken from the host-wide shared cache",
+                         [&chunks] { return (double)chunks.sharedCount(); });
+    metrics.addCounterFn("aetheris_chunks_pregenerated_total", "Chunks generated ahead of any player, at startup or idle",
+                         [&chunks] { return (double)chunks.pregenCount(); });
+    metrics.addCounterFn("aetheris_chunks_cached_total", "Chunks the client loaded from its own disk cache",
+                         [&chunks] { return (double)chunks.cachedCount(); });
+    metrics.addCounterFn("aetheris_chunks_prefetched_total", "Chunk jobs queued ahead of a moving player's view",
+                         [&chunks] { return (double)chunks.prefetchCount(); });
+    metrics.addCounterFn("aetheris_chunk_prefetch_cancelled_total", "Prefetched chunk jobs called off by a turn",
+                         [&chunks] { return (double)chunks.prefetchCancelCount(); });
+    metrics.addCounterFn("aetheris_chunk_pack_raw_bytes_total", "Payload bytes compressed, before",
+                         [&chunks] { return (double)chunks.packStats().rawBytes; });
+    metrics.addCounterFn("aetheris_chunk_pack_bytes_total", "Payload bytes compressed, after",
+                         [&chunks] { return (double)chunks.packStats().packedBytes; });
+    metrics.addCounterFn("aetheris_chunk_cache_hits_total", "Chunk cache hits",
+                         [&chunks] { return (double)chunks.cacheStats().hits; });
+    metrics.addCounterFn("aetheris_chunk_cache_misses_total", "Chunk cache misses",
+                         [&chunks] { return (double)chunks.cacheStats().misses; });
+    metrics.addGaugeFn("aetheris_chunk_cache_hit_ratio", "Chunk cache hits over lookups since start",
+                       [&chunks] {
+                           auto cs = chunks.cacheStats();
+                           return cs.hits + cs.misses ? (double)cs.hits / (double)(cs.hits + cs.misses) : 0.0;
+                       });
+    metrics.addGaugeFn("aetheris_chunk_cache_bytes", "Chunk cache payload bytes",
+                       [&chunks] { return (double)chunks.cacheStats().bytes; });
+
+    sched.add("metrics", 1.0, [&](float) {
+        std::string block;
+        auto header = [&](const char* name, const char* type, const char* help) {
+            block += std::string("# HELP ") + name + " " + help + "\n# TYPE " + name + " " + type + "\n";
+        };
+        struct Row { std::string label; ENetPeer* peer; };
+        std::vector<Row> rows;
+        mpMgr.forEachPlayer([&](const ConnectedPlayer& p) {
+            rows.push_back({"player=\"" + std::to_string(p.id) + "\"", p.peer});
+        });
+        players.set((double)rows.size());
+
+        header("aetheris_peer_bytes_in_total", "counter", "Packet bytes received from the player");
+        for (const Row& r : rows) MetricsRegistry::line(block, "aetheris_peer_bytes_in_total", r.label, (double)peerBytesIn[r.peer]);
+        header("aetheris_peer_bytes_out_total", "counter", "Bytes the outbox sent the player");
+        for (const Row& r : rows) MetricsRegistry::line(block, "aetheris_peer_bytes_out_total", r.label, (double)outbox.sentBytes(r.peer));
+        header("aetheris_peer_send_rate_bytes", "gauge", "The player's adapted send budget, bytes/s");
+        for (const Row& r : rows) MetricsRegistry::line(block, "aetheris_peer_send_rate_bytes", r.label, outbox.peerRate(r.peer));
+        header("aetheris_peer_rtt_seconds", "gauge", "ENet's smoothed round trip time");
+        for (const Row& r : rows) MetricsRegistry::line(block, "aetheris_peer_rtt_seconds", r.label, outbox.rttMs(r.peer) / 1000.0);
+        header("aetheris_peer_stream_backlog", "gauge", "Chunk packets queued behind the player's budget");
+        for (const Row& r : rows) MetricsRegistry::line(block, "aetheris_peer_stream_backlog", r.label, (double)outbox.streamBacklog(r.peer));
+        metrics.setBlock("peers", std::move(block));
+
+        if (!MemTags::enabled()) return;
+        block.clear();
+        header("aetheris_mem_live_bytes", "gauge", "Heap bytes live, by the subsystem that allocated them");
+        for (int t = 0; t < MemTags::COUNT; t++)
+            MetricsRegistry::line(block, "aetheris_mem_live_bytes", std::string("tag=\"") + MemTags::name((MemTags::Tag)t) + "\"",
+                                  (double)MemTags::stats((MemTags::Tag)t).liveBytes);
+        header("aetheris_mem_live_blocks", "gauge", "Heap blocks live, by the subsystem that allocated them");
+        for (int t = 0; t < MemTags::COUNT; t++)
+            MetricsRegistry::line(block, "aetheris_mem_live_blocks", std::string("tag=\"") + MemTags::name((MemTags::Tag)t) + "\"",
+                                  (double)MemTags::stats((MemTags::Tag)t).liveBlocks);
+        header("aetheris_mem_allocs_total", "counter", "Heap allocations, by subsystem");
+        for (int t = 0; t < MemTags::COUNT; t++)
+            MetricsRegistry::line(block, "aetheris_mem_allocs_total", std::string("tag=\"") + MemTags::name((MemTags::Tag)t) + "\"",
+                                  (double)MemTags::stats((MemTags::Tag)t).allocs);
+        metrics.setBlock("memory", std::move(block));
+    });
+
+    // ── Memory accounting ─────────────────────────────────────────────────────
+    // Heap tags (when built with -Dmem_tags=true), ENet's pools and the chunk
+    // cache, snapshotted for MemTags::Watch; steady growth is logged
+    MemTags::Watch memWatch;
+    sched.add("memory", 1.0 / Config::MEM_SNAPSHOT_S, [&](float) {
+        std::vector<MemTags::Row> rows = MemTags::snapshot();
+        rows.push_back({"enet", NetAlloc::stats().liveBytes, 0});
+        auto cs = chunks.cacheStats();
+        rows.push_back({"chunk_cache_entries", (int64_t)cs.bytes, (int64_t)cs.entries});
+        if (MemTags::enabled()) {
+            std::string line = "Heap:";
+            for (size_t i = 0; i < MemTags::COUNT; i++)
+                line += " " + rows[i].name + " " + std::to_string(rows[i].bytes >> 20) + " MB";
+            Log::info(line);
+        }
+        memWatch.sample(rows);
+    });
+
+    // Chunk pipeline spans (--trace <file>), appended as they accumulate
+    // ── Backups ──────────────────────────────────────────────────────────────
+    // Frozen between ticks, written on WorldBackup's thread. Declared after
+    // the stores it freezes, so it's finished with them before they go.
+    std::unique_ptr<WorldBackup> backup;
+    if (!settings.backupDir.empty() && !replaying && settings.backupIntervalMin > 0) {
+        std::string dir = links ? settings.backupDir + "/shard-" + std::to_string(self) : settings.backupDir;
+        backup = std::make_unique<WorldBackup>(dir, settings.backupKeep);
+        sched.add("backup", 1.0 / (settings.backupIntervalMin * 60.0),
+                  [&](float) { backup->begin(invMgr.store(), chunks.regions()); });
+        Log::info("Backing up to " + dir + " every " + std::to_string(settings.backupIntervalMin) + " min");
+    }
+    if (Trace::on()) sched.add("trace", 1.0, [](float) { Trace::flush(); });
+
+    // ── Events ────────────────────────────────────────────────────────────────
+    // Shared by the live loop and replay, so a capture runs the same code
+    Capture::Writer capture;
+    auto captureStart = Metrics::Clock::now();
+    if (!capturePath.empty() && !replaying && capture.open(capturePath.c_str()))
+        sched.add("capture", 1.0, [&](float) { capture.flush(); });
+
+    auto onConnect = [&](ENetPeer* peer) {
+        Log::info("Peer connected (awaiting auth)");
+        playerReg.add(peer);
+        mpMgr.onPeerConnect(peer);
+        // Don't do chunk/inv/stats setup until authenticated
+    };
+    auto onReceive = [&](ENetPeer* peer, const uint8_t* d, size_t len) {
+        bytesIn.add(len);
+        peerBytesIn[peer] += len;
+        dispatch.dispatch(peer, d, len);
+    };
+    auto onDisconnect = [&](ENetPeer* peer) {
+        Log::info("Peer disconnected");
+        mpMgr.onPeerDisconnect(peer);
+        admission.remove(peer);
+        sessions.cancel(peer);
+        chunks.removeClient(peer);
+        invMgr.onPlayerDisconnect(peer);
+        statsMgr.onPlayerDisconnect(peer);
+        enemies.forget(peer);
+        repl.removeClient(peer);
+        outbox.drop(peer);
+        peerBytesIn.erase(peer);
+        if (links) {
+            if (int shard = links->onDisconnect(peer); shard >= 0) mpMgr.setGhosts((uint16_t)shard, {});
+            handingOff.erase(peer);
+            std::erase_if(arrivals, [peer](const Arrival& a) { return a.peer == peer; });
+        }
+        playerReg.remove(peer); // last: the managers above look their components up
+    };
+    // Everything after an iteration's events, up to the wire. The one
+    // flush: this iteration's handlers and slots, bundled per peer and
+    // metered against each peer's budget.
+    auto endIteration = [&] {
+        {
+            auto s = watchdog.scope("logins");
+            if (links) admitArrivals();
+            admission.admit([&](ENetPeer* peer) { sessions.start(peer, peerToUID(peer)); },
+                            [&] { return chunks.genPending(); });
+        }
+        {
+            // Verdicts and saves that came in: logins held, players entering
+            auto s = watchdog.scope("async");
+            tasks.resume(Config::ASYNC_RESUME_BUDGET);
+        }
+        sched.runDue();
+        {
+            auto s = watchdog.scope("flushReady");
+            chunks.flushReady(outbox);
+        }
+        {
+            auto s = watchdog.scope("outbox.flush");
+            outbox.flush();
+        }
+        if (links) {
+            auto s = watchdog.scope("links.service");
+            links->service();
+        }
+        tickArena.reset();
+        iterations++;
+    };
+    // The live loop's wait: until the next slot or a network event, or
+    // sooner while chunks are generating or coroutines waiting — workers
+    // don't wake it. None at all while some are resumable and over budget.
+    auto waitMs = [&] {
+        int ms = sched.msUntilNext();
+        if (chunks.busy() || tasks.busy()) ms = std::min(ms, Config::CHUNK_FLUSH_MS);
+        if (tasks.queued() > 0) ms = 0;
+        return ms;
+    };
+
+    // ── Replay ────────────────────────────────────────────────────────────────
+    // A capture fed through the handlers above as fast as they'll go, on the
+    // capture's own timeline: the slots run as often as they did live, and
+    // each batch of events lands between the same slot runs it did live.
+    // Peers are zeroed stand-ins, so nothing reaches a wire — sends fail
+    // past the Outbox, which has already done its bundling and metering.
+    // Chunk generation still runs on the worker pool at its real speed.
+    if (replaying) {
+        Capture::Reader in;
+        if (!in.open(replayPath.c_str())) {
+            Log::shutdown();
+            return 1;
+        }
+        std::unordered_map<uint32_t, std::unique_ptr<ENetPeer>> peers; // outlive every manager's use
+        auto peerOf = [&](uint32_t id) {
+            auto& p = peers[id];
+            if (!p) p = std::make_unique<ENetPeer>();
+            return p.get();
+        };
+
+        auto     start = replayNow;
+        auto     wall0 = Metrics::Clock::now();
+        uint64_t records = 0, batches = 0, iterations = 0, received = 0;
+        double   worstMs = 0.0;
+        int64_t  lastUs  = 0;
+        Capture::Record r;
+        bool more = in.next(r);
+        while (more) {
+            // The iterations the live loop woke up for before this batch
+            auto at = start + std::chrono::microseconds(r.us);
+            for (auto wake = replayNow + std::chrono::milliseconds(waitMs()); wake < at;
+                 wake = replayNow + std::chrono::milliseconds(waitMs())) {
+                replayNow = wake;
+                endIteration();
+                iterations++;
+            }
+
+            replayNow = at;
+            lastUs    = r.us;
+            auto workStart = Metrics::Clock::now();
+            int  events    = 0;
+            for (int64_t batch = r.us; more && r.us == batch; more = in.next(r)) {
+                events++;
+                ENetPeer* peer = peerOf(r.peer);
+                switch (r.kind) {
+                case Capture::Kind::Connect:    onConnect(peer); break;
+                case Capture::Kind::Receive:    onReceive(peer, r.data, r.len); received++; break;
+                case Capture::Kind::Disconnect: onDisconnect(peer); break;
                 }
+            }
+            endIteration();
+            iterations++;
+            batches++;
+            records += (uint64_t)events;
+            double work = Metrics::secondsSince(workStart);
+            worstMs = std::max(worstMs, work * 1e3);
+            tickEvents.observe(events);
+            tickSeconds.observe(work);
+        }
+        double wall = Metrics::secondsSince(wall0);
 
-                enet_packet_destroy(ev.packet);
+        // Whatever the capture left generating, so its cost is counted
+        while (chunks.busy()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(Config::CHUNK_FLUSH_MS));
+            chunks.flushReady(outbox);
+            outbox.flush();
+            tickArena.reset();
+        }
+        double drained = Metrics::secondsSince(wall0);
+
+        char buf[256];
+        snprintf(buf, sizeof(buf),
+                 "Replay: %llu events (%llu packets, %llu KB) in %llu iterations; %.1f s of capture "
+                 "in %.2f s (%.1fx), %.2f s with generation drained; event batches %.3f ms mean, "
+                 "%.2f ms worst",
+                 (unsigned long long)records, (unsigned long long)received,
+                 (unsigned long long)(bytesIn.value() >> 10), (unsigned long long)iterations,
+                 lastUs / 1e6, wall, wall > 0 ? lastUs / 1e6 / wall : 0.0, drained,
+                 tickSeconds.sum() * 1e3 / (double)std::max<uint64_t>(1, batches),
+                 worstMs);
+        Log::info(buf);
+        for (const auto& t : sched.takeStats()) {
+            snprintf(buf, sizeof(buf), "Replay tick %s: %llu runs, %.3f ms mean, %.2f ms worst of the last minute",
+                     t.name.c_str(), (unsigned long long)t.runs,
+                     t.runs ? t.totalRunMs / (double)t.runs : 0.0, t.worstRunMs);
+            Log::info(buf);
+        }
+        takeRecvStats();
+        std::vector<PacketDispatcher::Stats> recv;
+        for (const auto& t : recvTotals)
+            if (t.packets) recv.push_back(t);
+        std::sort(recv.begin(), recv.end(), [](const auto& a, const auto& b) { return a.handlerNs > b.handlerNs; });
+        for (const auto& p : recv) Log::info("Replay recv " + PacketDispatcher::format(p));
+        auto cs = chunks.cacheStats();
+        Log::info("Replay chunks: " + std::to_string(chunks.generatedCount()) + " generated, cache hits " +
+                  std::to_string(cs.hits) + ", misses " + std::to_string(cs.misses));
+
+        Trace::stop();
+        if (ownWorld) {
+            std::error_code ec;
+            std::filesystem::remove_all(worldDir, ec);
+        }
+        Net::deinit();
+        Log::shutdown();
+        return 0;
+    }
+
+    MetricsServer metricsServer(metrics);
+    if (settings.metricsPort > 0) metricsServer.start(settings.metricsBind, settings.metricsPort);
+
+    // The simulation: events the network thread has taken off the socket,
+    // then the slots, then this iteration's sends handed back to it. ENet
+    // keeps acking and resending meanwhile, however long this takes.
+    // In-process, until the client has gone.
+    while (!embedded || !lb->finished()) {
+        // Block until the next slot is due, or something arrives
+        net.wait(waitMs());
+        auto workStart = Metrics::Clock::now(); // the wait isn't work
+        watchdog.beginTick();
+        auto at        = std::chrono::duration_cast<std::chrono::microseconds>(workStart - captureStart).count();
+        int  events    = 0;
+        ServerNet::Event ev;
+        while (net.poll(ev)) {
+            switch (ev.kind) {
+
+            case ServerNet::Event::Kind::Connect: {
+                auto s = watchdog.scope("connect");
+                capture.connect(at, ev.peer);
+                onConnect(ev.peer);
                 break;
             }
 
-            case ENET_EVENT_TYPE_DISCONNECT:
-                Log::info("Peer disconnected");
-                mpMgr.onPeerDisconnect(ev.peer, host.get());
-                chunks.removeClient(ev.peer);
-                invMgr.onPlayerDisconnect(ev.peer);
-                statsMgr.onPlayerDisconnect(ev.peer);
-                positions.erase(ev.peer);
+            case ServerNet::Event::Kind::Receive: {
+                // The handler's own span nests in this one
+                auto s = watchdog.scope("receive", ev.packet->dataLength ? ev.packet->data[0] : -1);
+                capture.receive(at, ev.peer, ev.packet->data, ev.packet->dataLength);
+                onReceive(ev.peer, ev.packet->data, ev.packet->dataLength);
+                enet_packet_destroy(ev.packet);
                 break;
+            }
 
-            default:
+            case ServerNet::Event::Kind::Disconnect: {
+                auto s = watchdog.scope("disconnect");
+                capture.disconnect(at, ev.peer);
+                onDisconnect(ev.peer);
                 break;
             }
-        }
 
-        statsMgr.update(dt);
-
-        statsFlushAccum += dt;
-        if (statsFlushAccum >= 0.1f) {
-            statsFlushAccum = 0.f;
-            statsMgr.flushDirty();
-            enet_host_flush(host.get());
-        }
-
-        // Broadcast player positions at ~20Hz
-        possBroadcastAccum += dt;
-        if (possBroadcastAccum >= 0.05f) {
-            possBroadcastAccum = 0.f;
-            mpMgr.broadcastPositions(host.get());
-            enet_host_flush(host.get());
+            case ServerNet::Event::Kind::Link:
+                outbox.setLink(ev.peer, ev.rtt, ev.loss);
+                continue; // not an ENet event
+            }
+            events++;
         }
 
-        chunks.flushReady(host.get());
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        endIteration();
+        watchdog.endTick([&](TickWatchdog::Figures& f) {
+            f.push_back({"events", (double)events});
+            f.push_back({"gen_pending", (double)chunks.genPending()});
+            f.push_back({"gen_threads", (double)chunks.genThreads()});
+            f.push_back({"chunks_in_flight", (double)chunks.inFlight()});
+            f.push_back({"region_io_pending", (double)chunks.regions().ioPending()});
+            f.push_back({"sessions_loading", (double)sessions.loadingCount()});
+            f.push_back({"async_live", (double)tasks.live()});
+            f.push_back({"admission_queued", (double)admission.queued()});
+            f.push_back({"players", (double)playerReg.count<PlayerPos>()});
+        });
+        tickEvents.observe(events);
+        double busy = Metrics::secondsSince(workStart);
+        tickSeconds.observe(busy);
+        admission.observe(busy);
     }
 
+    // A client that closed without the disconnect reaching us still saves
+    if (embedded && net.loopbackConnected()) onDisconnect(&lb->peer);
+    net.stop();
+    metricsServer.stop();
+    if (embedded) {
+        Log::info("In-process server stopped");
+        return 0;
+    }
+    Trace::stop();
     Net::deinit();
     Log::shutdown();
+    return 0;
+}
+
+#ifndef AETHERIS_EMBEDDED_SERVER
+int main(int argc, char** argv) {
+    return serverMain(argc, argv, nullptr);
 }
+#endif
@@ -0,0 +1,335 @@
+#include "region_store.h"
+#include "log.h"
+#include <filesystem>
+#include <cstring>
+
+#ifdef _WIN32
+  #include <io.h>
+#else
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+  #define HAS_MMAP 1
+#endif
+
+static int floorDiv(int v, int d) {
+    return (v >= 0) ? v / d : -((-v + d - 1) / d);
+}
+
+static bool syncFile(FILE* f) {
+    if (fflush(f) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+ChunkCoord RegionStore::regionOf(ChunkCoord c) {
+    return {floorDiv(c.x, REGION), floorDiv(c.y, REGION), floorDiv(c.z, REGION)};
+}
+
+int RegionStore::slotOf(ChunkCoord c) {
+    int lx = c.x - floorDiv(c.x, REGION) * REGION;
+    int ly = c.y - floorDiv(c.y, REGION) * REGION;
+    int lz = c.z - floorDiv(c.z, REGION) * REGION;
+    return (lx * REGION + ly) * REGION + lz;
+}
+
+RegionStore::RegionStore(std::string dir, uint32_t seed, uint32_t payloadVersion)
+    : _dir(std::move(dir)), _seed(seed), _payloadVersion(payloadVersion)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(_dir, ec);
+    if (ec) Log::err("RegionStore: cannot create " + _dir + ": " + ec.message());
+}
+
+RegionStore::Region::~Region() {
+    unmap(*this);
+    if (file) fclose(file);
+}
+
+// ── Region files ──────────────────────────────────────────────────────────────
+
+std::string RegionStore::pathOf(ChunkCoord rc) const {
+    return _dir + "/r." + std::to_string(rc.x) + "." + std::to_string(rc.y) + "." +
+           std::to_string(rc.z) + ".bin";
+}
+
+RegionStore::Region* RegionStore::region(ChunkCoord rc) {
+    std::lock_guard lk(_regionsMu);
+    auto [it, isNew] = _regions.try_emplace(rc);
+    if (isNew) {
+        it->second = std::make_unique<Region>();
+        Region& r  = *it->second;
+        std::lock_guard rlk(r.mu);
+        r.readOnly = !owns(rc);
+        if (r.readOnly) openReadOnly(r, rc);
+        else            openRegion(r, rc);
+    }
+    return it->second.get();
+}
+
+// Another shard's region: opened if its owner has written it and it's in
+// this world's format, never touched otherwise. Slots are read per load.
+bool RegionStore::openReadOnly(Region& r, ChunkCoord rc) {
+    std::string path = pathOf(rc);
+    r.file = fopen(path.c_str(), "rb");
+    if (!r.file) return false;
+    Header h{};
+    if (fread(&h, sizeof(h), 1, r.file) == 1 && h.magic == MAGIC && h.layoutVersion == LAYOUT_VERSION &&
+        h.seed == _seed && h.payloadVersion == _payloadVersion)
+        return true;
+    fclose(r.file);
+    r.file = nullptr;
+    return false;
+}
+
+// Where a region file that isn't this world's is moved, rather than lost:
+// stale/ under the world directory, numbered when there's one already
+std::string RegionStore::stalePathOf(ChunkCoord rc) const {
+    std::string dir  = _dir + "/stale";
+    std::string name = "r." + std::to_string(rc.x) + "." + std::to_string(rc.y) + "." + std::to_string(rc.z);
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    std::string path = dir + "/" + name + ".bin";
+    for (int n = 1; std::filesystem::exists(path, ec); n++)
+        path = dir + "/" + name + "." + std::to_string(n) + ".bin";
+    return path;
+}
+
+// Opens (or creates) the region file and loads its slot table. A slot that
+// points past EOF (a torn write) is emptied on its own; a file that is cut
+// short of its table or belongs to a different seed/payload version is
+// moved to stale/ and a new one started. On failure r.file stays null and
+// the region behaves as permanently empty, its file untouched.
+bool RegionStore::openRegion(Region& r, ChunkCoord rc) {
+    std::string path = pathOf(rc);
+
+    r.file = fopen(path.c_str(), "r+b");
+    if (r.file) {
+        Header h{};
+        bool ok = fread(&h, sizeof(h), 1, r.file) == 1 &&
+                  fread(r.table.data(), sizeof(Slot), SLOTS, r.file) == SLOTS &&
+                  h.magic == MAGIC && h.layoutVersion == LAYOUT_VERSION &&
+                  h.seed == _seed && h.payloadVersion == _payloadVersion;
+        if (ok) {
+            fseek(r.file, 0, SEEK_END);
+            long size = ftell(r.file);
+            r.endSector = std::max<uint32_t>(DATA_SECTOR,
+                                             (uint32_t)((size + SECTOR - 1) / SECTOR));
+            int torn = 0;
+            for (int i = 0; i < SLOTS; i++) {
+                Slot& s = r.table[i];
+                if (!s.sector || (uint64_t)s.sector * SECTOR + s.length <= (uint64_t)size) continue;
+                s = {};
+                fseek(r.file, (long)(TABLE_OFFSET + i * sizeof(Slot)), SEEK_SET);
+                fwrite(&s, sizeof(Slot), 1, r.file);
+                torn++;
+            }
+            if (torn) {
+                fflush(r.file);
+                Log::warn("RegionStore: " + path + ": emptied " + std::to_string(torn) +
+                          " slot(s) past EOF from a torn write");
+            }
+            return true;
+        }
+
+        fclose(r.file);
+        r.file = nullptr;
+        std::string aside = stalePathOf(rc);
+        std::error_code ec;
+        std::filesystem::rename(path, aside, ec);
+        if (ec) {
+            Log::err("RegionStore: " + path + " isn't this world's and can't be moved aside (" + ec.message() +
+                     "); leaving it be");
+            return false;
+        }
+        Log::warn("RegionStore: " + path + " isn't this world's; moved to " + aside);
+    }
+
+    r.file = fopen(path.c_str(), "w+b");
+    if (!r.file) {
+        Log::err("RegionStore: cannot open " + path);
+        return false;
+    }
+    r.table.fill({});
+    r.endSector = DATA_SECTOR;
+
+    Header h{MAGIC, LAYOUT_VERSION, _seed, _payloadVersion};
+    fwrite(&h, sizeof(h), 1, r.file);
+    fwrite(r.table.data(), sizeof(Slot), SLOTS, r.file);
+    fflush(r.file);
+    return true;
+}
+
+// ── Mapping ───────────────────────────────────────────────────────────────────
+// The file only grows, so the mapping is replaced whenever a read lands past
+// its end. Caller holds r.mu.
+
+bool RegionStore::ensureMapped(Region& r, size_t end) {
+#if defined(HAS_MMAP)
+    if (r.map && end <= r.mapSize) return true;
+    unmap(r);
+
+    struct stat st{};
+    int fd = fileno(r.file);
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < end) return false;
+
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) return false;
+    // A load reads one payload, wherever its sectors are: no readahead
+    // around a fault, only ahead of the payload itself (load)
+    madvise(p, (size_t)st.st_size, MADV_RANDOM);
+    r.map     = (const uint8_t*)p;
+    r.mapSize = (size_t)st.st_size;
+    return true;
+#else
+    (void)r; (void)end;
+    return false;
+#endif
+}
+
+void RegionStore::unmap(Region& r) {
+#if defined(HAS_MMAP)
+    if (r.map) munmap((void*)r.map, r.mapSize);
+#endif
+    r.map     = nullptr;
+    r.mapSize = 0;
+}
+
+// ── load / save ───────────────────────────────────────────────────────────────
+
+std::optional<std::vector<uint8_t>> RegionStore::load(ChunkCoord coord) {
+    ChunkCoord rc = regionOf(coord);
+    Region*    r  = region(rc);
+    std::lock_guard lk(r->mu);
+    if (r->readOnly) {
+        // The owner may have created it, or saved this chunk, since
+        if (!r->file && !openReadOnly(*r, rc)) return std::nullopt;
+        Slot& fresh = r->table[slotOf(coord)];
+        if (fseek(r->file, (long)(TABLE_OFFSET + slotOf(coord) * sizeof(Slot)), SEEK_SET) != 0 ||
+            fread(&fresh, sizeof(Slot), 1, r->file) != 1)
+            return std::nullopt;
+    }
+    if (!r->file) return std::nullopt;
+
+    const Slot& s = r->table[slotOf(coord)];
+    if (s.sector == 0 || s.codec != (uint8_t)Codec::None) return std::nullopt;
+
+    size_t offset = (size_t)s.sector * SECTOR;
+    std::vector<uint8_t> bytes(s.length);
+    if (ensureMapped(*r, offset + s.length)) {
+#if defined(HAS_MMAP)
+        // Its pages in one go rather than a fault apiece; offset is sector-aligned
+        if (s.length > SECTOR) madvise((void*)(r->map + offset), s.length, MADV_WILLNEED);
+#endif
+        memcpy(bytes.data(), r->map + offset, s.length);
+    } else {
+        // No mmap on this platform (or it failed) — plain read
+        if (fseek(r->file, (long)offset, SEEK_SET) != 0 ||
+            fread(bytes.data(), 1, s.length, r->file) != s.length)
+            return std::nullopt;
+    }
+    return bytes;
+}
+
+void RegionStore::save(ChunkCoord coord, std::shared_ptr<const std::vector<uint8_t>> bytes) {
+    if (!owns(regionOf(coord))) return;
+    _io.submit([this, coord, bytes = std::move(bytes)]() { write(coord, *bytes); });
+}
+
+// I/O thread only. Payload first, synced to disk, then the slot, so a crash
+// between the two leaves the old slot (or an empty one) rather than one
+// pointing at sectors that never made it.
+void RegionStore::write(ChunkCoord coord, const std::vector<uint8_t>& bytes) {
+    Region* r = region(regionOf(coord));
+    std::lock_guard lk(r->mu);
+    if (!r->file) return;
+
+    uint32_t sectors = (uint32_t)((bytes.size() + SECTOR - 1) / SECTOR);
+    Slot slot{r->endSector, (uint32_t)bytes.size(), (uint8_t)Codec::None};
+
+    static const uint8_t zeros[SECTOR] = {};
+    fseek(r->file, (long)((size_t)slot.sector * SECTOR), SEEK_SET);
+    size_t padding = (size_t)sectors * SECTOR - bytes.size();
+    if (fwrite(bytes.data(), 1, bytes.size(), r->file) != bytes.size() ||
+        fwrite(zeros, 1, padding, r->file) != padding || !syncFile(r->file)) {
+        Log::err("RegionStore: write failed");
+        return;
+    }
+
+    int idx = slotOf(coord);
+    fseek(r->file, (long)(TABLE_OFFSET + idx * sizeof(Slot)), SEEK_SET);
+    if (fwrite(&slot, sizeof(Slot), 1, r->file) != 1 || fflush(r->file) != 0) {
+        Log::err("RegionStore: write failed");
+        return;
+    }
+
+    r->table[idx] = slot;
+    r->endSector += sectors;
+}
+
+// ── Snapshots ─────────────────────────────────────────────────────────────────
+
+TaskFuture<RegionStore::Frozen> RegionStore::freeze() {
+    return _io.async([this] {
+        // Regions nothing has touched this run are opened too: one could
+        // be written before the backup has read it
+        std::error_code ec;
+        for (const auto& e : std::filesystem::directory_iterator(_dir, ec)) {
+            ChunkCoord rc;
+            if (sscanf(e.path().filename().string().c_str(), "r.%d.%d.%d.bin", &rc.x, &rc.y, &rc.z) == 3 &&
+                owns(rc))
+                region(rc);
+        }
+        Frozen out;
+        std::lock_guard lk(_regionsMu);
+        for (const auto& [rc, r] : _regions) {
+            std::lock_guard rlk(r->mu);
+            if (r->readOnly || !r->file || r->endSector == DATA_SECTOR) continue;
+            out.push_back({rc, r->table});
+        }
+        return out;
+    });
+}
+
+bool RegionStore::writeFrozen(const std::string& path, const FrozenRegion& fr) const {
+    FILE* in = fopen(pathOf(fr.coord).c_str(), "rb");
+    if (!in) return false;
+    std::string tmp = path + ".tmp";
+    FILE* out = fopen(tmp.c_str(), "wb");
+    if (!out) {
+        fclose(in);
+        return false;
+    }
+
+    std::array<Slot, SLOTS> table{};
+    Header h{MAGIC, LAYOUT_VERSION, _seed, _payloadVersion};
+    bool ok = fwrite(&h, sizeof(h), 1, out) == 1 && fwrite(table.data(), sizeof(Slot), SLOTS, out) == SLOTS;
+
+    static const uint8_t zeros[SECTOR] = {};
+    std::vector<uint8_t> bytes;
+    uint32_t end = DATA_SECTOR;
+    for (int i = 0; i < SLOTS && ok; i++) {
+        const Slot& s = fr.table[i];
+        if (s.sector == 0) continue;
+        bytes.resize(s.length);
+        uint32_t sectors = (uint32_t)((s.length + SECTOR - 1) / SECTOR);
+        ok = fseek(in, (long)((size_t)s.sector * SECTOR), SEEK_SET) == 0 &&
+             fread(bytes.data(), 1, s.length, in) == s.length &&
+             fseek(out, (long)((size_t)end * SECTOR), SEEK_SET) == 0 &&
+             fwrite(bytes.data(), 1, s.length, out) == s.length &&
+             fwrite(zeros, 1, (size_t)sectors * SECTOR - s.length, out) == (size_t)sectors * SECTOR - s.length;
+        table[i] = {end, s.length, s.codec};
+        end += sectors;
+    }
+    ok = ok && fseek(out, (long)TABLE_OFFSET, SEEK_SET) == 0 &&
+         fwrite(table.data(), sizeof(Slot), SLOTS, out) == SLOTS && fflush(out) == 0;
+    fclose(in);
+    fclose(out);
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tmp, path, ec);
+    else    std::filesystem::remove(tmp, ec);
+    return ok && !ec;
+}
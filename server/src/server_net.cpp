@@ -0,0 +1,279 @@
+#include "server_net.h"
+#include "log.h"
+#include "mem_tags.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <stdexcept>
+#ifndef _WIN32
+#include <sys/socket.h>
+#endif
+
+// shared: bound with SO_REUSEPORT, for a lane alongside others. ENet binds
+// its socket as it creates it, so a shared one is created unbound and
+// bound here once the option is set.
+ENetHost* ServerNet::openHost(uint16_t port, size_t maxPeers, bool shared) {
+    ENetAddress addr{};
+    addr.host = ENET_HOST_ANY;
+    addr.port = port;
+    if (!shared) return enet_host_create(&addr, maxPeers, Net::CHANNEL_COUNT, 0, 0);
+#if defined(SO_REUSEPORT)
+    ENetHost* host = enet_host_create(nullptr, maxPeers, Net::CHANNEL_COUNT, 0, 0);
+    if (!host) return nullptr;
+    int one = 1;
+    if (setsockopt(host->socket, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0 ||
+        enet_socket_bind(host->socket, &addr) < 0) {
+        enet_host_destroy(host);
+        return nullptr;
+    }
+    host->address = addr;
+    return host;
+#else
+    return nullptr;
+#endif
+}
+
+void ServerNet::start(uint16_t port, size_t maxPeers, int lanes) {
+#if !defined(SO_REUSEPORT)
+    if (lanes > 1) Log::warn("ServerNet: no SO_REUSEPORT here; one network thread");
+    lanes = 1;
+#endif
+    lanes = std::max(lanes, 1);
+    for (int i = 0; i < lanes; i++) {
+        auto l  = std::make_unique<Lane>();
+        l->host = openHost(port, maxPeers, lanes > 1);
+        if (!l->host) {
+            for (auto& open : _lanes) enet_host_destroy(open->host);
+            _lanes.clear();
+            throw std::runtime_error("enet_host_create (server) failed");
+        }
+        _lanes.push_back(std::move(l));
+    }
+    _running.store(true, std::memory_order_release);
+    for (auto& l : _lanes) l->thread = std::thread([this, lane = l.get()] { run(*lane); });
+}
+
+void ServerNet::stop() {
+    for (Loopback::Message& m : _loopWaiting) enet_packet_destroy(m.packet);
+    _loopWaiting.clear();
+    _loopUp = false;
+    if (_lanes.empty() || !_lanes.front()->thread.joinable()) return;
+    _running.store(false, std::memory_order_release);
+    for (auto& l : _lanes) l->thread.join();
+
+    for (auto& l : _lanes) {
+        Event ev;
+        while (l->inbound.pop(ev))
+            if (ev.packet) enet_packet_destroy(ev.packet);
+        for (Event& e : l->eventsWaiting)
+            if (e.packet) enet_packet_destroy(e.packet);
+        for (Send& s : l->sendsWaiting) enet_packet_destroy(s.packet);
+        l->sendsWaiting.clear();
+        l->eventsWaiting.clear();
+        enet_host_destroy(l->host);
+        l->host = nullptr;
+    }
+    _live.clear(); // the lanes stay, for bytesSent()
+}
+
+bool ServerNet::pin(int cpu) {
+    bool ok = !_lanes.empty();
+    for (size_t i = 0; i < _lanes.size(); i++) ok &= ThreadPool::pinThread(_lanes[i]->thread, cpu + (int)i);
+    return ok;
+}
+
+void ServerNet::attach(Loopback& lb) {
+    _loop         = &lb;
+    lb.wakeServer = [this] { signal(); };
+}
+
+uint64_t ServerNet::bytesSent() const {
+    uint64_t n = 0;
+    for (const auto& l : _lanes) n += l->bytesSent.load(std::memory_order_relaxed);
+    return n;
+}
+
+std::vector<int> ServerNet::lanePeers() const {
+    std::vector<int> n;
+    for (const auto& l : _lanes) n.push_back(l->peers.load(std::memory_order_relaxed));
+    return n;
+}
+
+// ── Simulation thread ─────────────────────────────────────────────────────────
+
+void ServerNet::wait(int ms) {
+    std::unique_lock lk(_wakeMu);
+    _wake.wait_for(lk, std::chrono::milliseconds(ms),
+                   [this] { return _signalled.load(std::memory_order_acquire); });
+    _signalled.store(false, std::memory_order_relaxed);
+}
+
+bool ServerNet::poll(Event& out) {
+    // Sends held back by a full ring go out as soon as there's room
+    for (auto& l : _lanes)
+        while (!l->sendsWaiting.empty() && l->outbound.push(std::move(l->sendsWaiting.front())))
+            l->sendsWaiting.pop_front();
+    if (_loop)
+        while (!_loopWaiting.empty() && _loop->toClient.push(std::move(_loopWaiting.front())))
+            _loopWaiting.pop_front();
+
+    // A lane at a time, from where the last call found something, so a
+    // busy one can't hold the others back
+    for (size_t n = 0; n < _lanes.size(); n++) {
+        uint32_t lane = (uint32_t)((_nextLane + n) % _lanes.size());
+        while (_lanes[lane]->inbound.pop(out)) {
+            switch (out.kind) {
+            case Event::Kind::Connect:
+                _live[out.peer] = {out.id, lane};
+                _nextLane = lane + 1;
+                return true;
+            case Event::Kind::Disconnect:
+                _live.erase(out.peer);
+                _nextLane = lane + 1;
+                return true;
+            default: {
+                // Anything still arriving from a peer after its disconnect was
+                // handled here belongs to no one
+                auto it = _live.find(out.peer);
+                if (it != _live.end() && it->second.id == out.id) {
+                    _nextLane = lane + 1;
+                    return true;
+                }
+                if (out.packet) enet_packet_destroy(out.packet);
+                break;
+            }
+            }
+        }
+    }
+    return _loop && pollLoopback(out);
+}
+
+bool ServerNet::pollLoopback(Event& out) {
+    Loopback::Message m;
+    while (_loop->toServer.pop(m)) {
+        switch (m.kind) {
+        case Loopback::Message::Kind::Connect:
+            _loopId = m.id;
+            _loopUp = true;
+            out     = {Event::Kind::Connect, &_loop->peer, m.id};
+            return true;
+        case Loopback::Message::Kind::Disconnect:
+            if (!_loopUp || m.id != _loopId) break;
+            _loopUp = false;
+            out     = {Event::Kind::Disconnect, &_loop->peer};
+            return true;
+        case Loopback::Message::Kind::Receive:
+            if (_loopUp && m.id == _loopId) {
+                out = {Event::Kind::Receive, &_loop->peer, m.id, m.packet};
+                return true;
+            }
+            enet_packet_destroy(m.packet);
+            break;
+        }
+    }
+    return false;
+}
+
+void ServerNet::send(ENetPeer* peer, uint8_t channel, ENetPacket* pkt) {
+    if (_loop && peer == &_loop->peer) {
+        if (!_loopUp) {
+            enet_packet_destroy(pkt);
+            return;
+        }
+        Loopback::Message m{Loopback::Message::Kind::Receive, _loopId, channel, pkt};
+        if (!_loopWaiting.empty() || !_loop->toClient.push(std::move(m)))
+            _loopWaiting.push_back(m);
+        return;
+    }
+    auto it = _live.find(peer);
+    if (it == _live.end()) {
+        enet_packet_destroy(pkt);
+        return;
+    }
+    Lane& l = *_lanes[it->second.lane];
+    Send  s{peer, it->second.id, channel, pkt};
+    if (!l.sendsWaiting.empty() || !l.outbound.push(std::move(s)))
+        l.sendsWaiting.push_back(s);
+}
+
+// ── Network threads ───────────────────────────────────────────────────────────
+
+void ServerNet::signal() {
+    if (_signalled.exchange(true, std::memory_order_acq_rel)) return;
+    std::lock_guard lk(_wakeMu);
+    _wake.notify_one();
+}
+
+void ServerNet::emit(Lane& l, Event&& ev) {
+    if (!l.eventsWaiting.empty() || !l.inbound.push(std::move(ev)))
+        l.eventsWaiting.push_back(ev);
+}
+
+bool ServerNet::flushEvents(Lane& l) {
+    bool any = false;
+    while (!l.eventsWaiting.empty() && l.inbound.push(std::move(l.eventsWaiting.front()))) {
+        l.eventsWaiting.pop_front();
+        any = true;
+    }
+    return any;
+}
+
+void ServerNet::execute(Send& s) {
+    ENetPeer* peer = s.peer;
+    uint8_t   channel = s.channel;
+    if (channel == Net::CHANNEL_STREAM && peer->channelCount <= Net::CHANNEL_STREAM)
+        channel = Net::CHANNEL_RELIABLE;
+    if (peer->state != ENET_PEER_STATE_CONNECTED || peer->connectID != s.id ||
+        enet_peer_send(peer, channel, s.packet) < 0)
+        enet_packet_destroy(s.packet);
+}
+
+void ServerNet::run(Lane& l) {
+    MemTags::exchange(MemTags::Packets);
+    Send      s;
+    ENetEvent ev;
+    l.linkSent = std::chrono::steady_clock::now();
+    while (_running.load(std::memory_order_acquire)) {
+        while (l.outbound.pop(s)) execute(s);
+        bool got = flushEvents(l);
+
+        // Waits for the socket up to SERVICE_MS, sending what was queued
+        for (int r = enet_host_service(l.host, &ev, SERVICE_MS); r > 0;
+             r = enet_host_service(l.host, &ev, 0)) {
+            switch (ev.type) {
+            case ENET_EVENT_TYPE_CONNECT:
+                l.peers.fetch_add(1, std::memory_order_relaxed);
+                emit(l, {Event::Kind::Connect, ev.peer, ev.peer->connectID});
+                break;
+            case ENET_EVENT_TYPE_RECEIVE:
+                emit(l, {Event::Kind::Receive, ev.peer, ev.peer->connectID, ev.packet});
+                break;
+            case ENET_EVENT_TYPE_DISCONNECT:
+                // ENet has already reset the peer; its connectID is gone
+                l.peers.fetch_sub(1, std::memory_order_relaxed);
+                emit(l, {Event::Kind::Disconnect, ev.peer});
+                break;
+            default:
+                continue;
+            }
+            got = true;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - l.linkSent >= LINK_MS) {
+            l.linkSent = now;
+            for (ENetPeer* p = l.host->peers; p < l.host->peers + l.host->peerCount; p++)
+                if (p->state == ENET_PEER_STATE_CONNECTED)
+                    emit(l, {Event::Kind::Link, p, p->connectID, nullptr, p->roundTripTime, p->packetLoss});
+        }
+
+        // ENet's own tally is 32-bit; drained here so it never wraps
+        l.bytesSent.fetch_add(l.host->totalSentData, std::memory_order_relaxed);
+        l.host->totalSentData = 0;
+
+        if (got) signal();
+    }
+
+    // Whatever the simulation sent last still goes out
+    while (l.outbound.pop(s)) execute(s);
+    enet_host_flush(l.host);
+}
@@ -0,0 +1,134 @@
+#include "shard_links.h"
+#include "log.h"
+#include "net_common.h"
+#include <algorithm>
+#include <stdexcept>
+
+ShardLinks::ShardLinks(const ShardMap& map, uint16_t self, std::string secret)
+    : _map(map), _self(self), _secret(std::move(secret))
+{
+    for (const ShardMap::Shard& s : _map.shards())
+        if (s.id != _self) _links.push_back({s.id});
+    _host = enet_host_create(nullptr, std::max<size_t>(1, _links.size()), Net::CHANNEL_COUNT, 0, 0);
+    if (!_host) throw std::runtime_error("enet_host_create (shard links) failed");
+    ShardHelloPacket{_self, _secret}.write(_hello);
+}
+
+ShardLinks::~ShardLinks() {
+    for (Link& l : _links)
+        if (l.peer) enet_peer_disconnect_now(l.peer, 0);
+    if (_host) enet_host_destroy(_host);
+}
+
+// ── Outbound ──────────────────────────────────────────────────────────────────
+
+void ShardLinks::service() {
+    auto now = Clock::now();
+    for (size_t i = 0; i < _links.size(); i++) {
+        Link& l = _links[i];
+        if (l.peer || now < l.retryAt) continue;
+        l.retryAt = now + std::chrono::milliseconds(Config::SHARD_RECONNECT_MS);
+        const ShardMap::Shard* s = _map.find(l.shard);
+        ENetAddress addr{};
+        if (!s || enet_address_set_host(&addr, s->host.c_str()) != 0) continue;
+        addr.port = s->port;
+        l.peer    = enet_host_connect(_host, &addr, Net::CHANNEL_COUNT, 0);
+        if (l.peer) l.peer->data = (void*)(uintptr_t)(i + 1);
+    }
+
+    ENetEvent ev;
+    while (enet_host_service(_host, &ev, 0) > 0) {
+        Link* l = linkOf(ev.peer);
+        switch (ev.type) {
+        case ENET_EVENT_TYPE_CONNECT:
+            if (!l) break;
+            l->up = true;
+            Net::sendReliable(ev.peer, _hello.data(), _hello.size());
+            Log::info("Shard link to " + std::to_string(l->shard) + " up");
+            break;
+        case ENET_EVENT_TYPE_DISCONNECT:
+            if (!l) break;
+            if (l->up) Log::warn("Shard link to " + std::to_string(l->shard) + " lost");
+            l->peer    = nullptr;
+            l->up      = false;
+            l->retryAt = now + std::chrono::milliseconds(Config::SHARD_RECONNECT_MS);
+            break;
+        case ENET_EVENT_TYPE_RECEIVE:
+            enet_packet_destroy(ev.packet); // nothing is sent this way
+            break;
+        default:
+            break;
+        }
+    }
+    enet_host_flush(_host);
+    expire();
+}
+
+bool ShardLinks::up(uint16_t shard) const {
+    for (const Link& l : _links)
+        if (l.shard == shard) return l.up;
+    return false;
+}
+
+bool ShardLinks::send(uint16_t shard, const uint8_t* d, size_t len, bool movement) {
+    for (Link& l : _links) {
+        if (l.shard != shard) continue;
+        if (!l.up) return false;
+        if (movement) Net::sendMovement(l.peer, d, len);
+        else          Net::sendReliable(l.peer, d, len);
+        return true;
+    }
+    return false;
+}
+
+ShardLinks::Link* ShardLinks::linkOf(ENetPeer* peer) {
+    size_t i = (size_t)(uintptr_t)peer->data;
+    return i >= 1 && i <= _links.size() && _links[i - 1].peer == peer ? &_links[i - 1] : nullptr;
+}
+
+// ── Inbound ───────────────────────────────────────────────────────────────────
+
+bool ShardLinks::onHello(ENetPeer* peer, const ShardHelloPacket& hello) {
+    if (hello.secret != _secret || hello.shard == _self || !_map.find(hello.shard)) {
+        Log::warn("Shard hello refused (shard " + std::to_string(hello.shard) + ")");
+        return false;
+    }
+    _inbound[peer] = hello.shard;
+    Log::info("Shard link from " + std::to_string(hello.shard) + " accepted");
+    return true;
+}
+
+int ShardLinks::shardOf(ENetPeer* peer) const {
+    auto it = _inbound.find(peer);
+    return it != _inbound.end() ? it->second : -1;
+}
+
+int ShardLinks::onDisconnect(ENetPeer* peer) {
+    auto it = _inbound.find(peer);
+    if (it == _inbound.end()) return -1;
+    int shard = it->second;
+    _inbound.erase(it);
+    Log::warn("Shard link from " + std::to_string(shard) + " closed");
+    return shard;
+}
+
+// ── Handoff tickets ───────────────────────────────────────────────────────────
+
+void ShardLinks::expect(ShardHandoffPacket handoff) {
+    std::string token = ShardHandoffPacket::token(handoff.ticket);
+    _tickets[token] = {std::move(handoff), Clock::now() + std::chrono::seconds(Config::SHARD_TICKET_TTL_S)};
+}
+
+std::optional<ShardHandoffPacket> ShardLinks::claim(const std::string& token) {
+    auto it = _tickets.find(token);
+    if (it == _tickets.end()) return std::nullopt;
+    ShardHandoffPacket h = std::move(it->second.handoff);
+    _tickets.erase(it);
+    return h;
+}
+
+void ShardLinks::expire() {
+    auto now = Clock::now();
+    for (auto it = _tickets.begin(); it != _tickets.end();)
+        it = it->second.expires <= now ? _tickets.erase(it) : std::next(it);
+}
@@ -0,0 +1,232 @@
+#include "shared_chunk_cache.h"
+#include "log.h"
+#include "big_pages.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr uint32_t MAGIC          = 0x43484341; // "ACHC"
+static constexpr uint32_t LAYOUT_VERSION = 1;
+static constexpr size_t   PROBE          = 16;    // slots past its home a key may sit
+static constexpr size_t   AVG_PAYLOAD    = 4096;  // sizes the table against the arena
+static constexpr size_t   HEADER_BYTES   = 64;
+static constexpr int      READY_WAIT_MS  = 2000;  // for another process laying a new segment out
+
+struct SharedChunkCache::Header {
+    std::atomic<uint32_t> state;      // 0 new, 2 laid out
+    uint32_t              magic, version, world;
+    uint64_t              slots;      // a power of two; PROBE more follow
+    uint64_t              arenaBytes;
+    std::atomic<uint64_t> cursor;     // arena bytes ever written
+};
+
+// info: bit 31 used, 30 mesh, 27-29 lod, 0-26 payload length
+struct SharedChunkCache::Slot {
+    std::atomic<uint32_t> seq;   // odd while a writer has it
+    std::atomic<uint32_t> info;
+    std::atomic<uint64_t> coord; // packCoord
+    std::atomic<uint64_t> start; // arena position
+};
+// Other processes see the same memory through their own mapping
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free);
+
+static constexpr uint32_t USED = 1u << 31, MESH = 1u << 30, LEN_MASK = (1u << 27) - 1;
+
+static uint32_t tagOf(const ChunkKey& key, bool mesh) {
+    return USED | (mesh ? MESH : 0) | (uint32_t)key.lod << 27;
+}
+static size_t homeOf(const ChunkKey& key, bool mesh, size_t slots) {
+    return (size_t)mixHash(packCoord(key.coord) * 16 + (uint64_t)key.lod * 2 + (mesh ? 1 : 0)) & (slots - 1);
+}
+
+// The arena is a ring over its positions
+static void ringWrite(uint8_t* arena, uint64_t size, uint64_t at, const uint8_t* p, size_t n) {
+    size_t o = (size_t)(at % size), first = std::min<size_t>(n, (size_t)size - o);
+    std::memcpy(arena + o, p, first);
+    std::memcpy(arena, p + first, n - first);
+}
+static void ringRead(const uint8_t* arena, uint64_t size, uint64_t at, uint8_t* p, size_t n) {
+    size_t o = (size_t)(at % size), first = std::min<size_t>(n, (size_t)size - o);
+    std::memcpy(p, arena + o, first);
+    std::memcpy(p + first, arena, n - first);
+}
+
+std::unique_ptr<SharedChunkCache> SharedChunkCache::open(uint32_t world, size_t sizeBytes) {
+#ifdef _WIN32
+    (void)world; (void)sizeBytes;
+    Log::warn("SharedChunkCache: shared memory segments aren't supported here");
+    return nullptr;
+#else
+    char name[40];
+    snprintf(name, sizeof(name), "/aetheris-chunks-%08x", world);
+
+    // Whoever creates the segment lays it out; everyone else waits for that
+    bool creator = true;
+    int  fd      = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        creator = false;
+        fd      = shm_open(name, O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        Log::err(std::string("SharedChunkCache: cannot open ") + name + ": " + std::strerror(errno));
+        return nullptr;
+    }
+
+    static_assert(sizeof(Header) <= HEADER_BYTES);
+    size_t slots = 0, arena = 0, bytes = 0;
+    if (creator) {
+        slots = std::bit_floor(std::max<size_t>(1024, sizeBytes / AVG_PAYLOAD));
+        arena = std::max<size_t>(1 << 20, sizeBytes - std::min(sizeBytes, (slots + PROBE) * sizeof(Slot)));
+        bytes = HEADER_BYTES + (slots + PROBE) * sizeof(Slot) + arena;
+        if (ftruncate(fd, (off_t)bytes) != 0) {
+            Log::err(std::string("SharedChunkCache: cannot size ") + name + ": " + std::strerror(errno));
+            close(fd);
+            shm_unlink(name);
+            return nullptr;
+        }
+    } else {
+        struct stat st{};
+        for (int waited = 0; waited < READY_WAIT_MS; waited += 10) {
+            if (fstat(fd, &st) == 0 && (size_t)st.st_size >= HEADER_BYTES) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        bytes = (size_t)st.st_size;
+    }
+
+    void* map = bytes >= HEADER_BYTES ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                                      : MAP_FAILED;
+    close(fd);
+    if (map == MAP_FAILED) {
+        Log::err(std::string("SharedChunkCache: cannot map ") + name);
+        return nullptr;
+    }
+
+    // Probed and copied out of at random across the whole segment
+    BigPages::adviseHuge(map, bytes);
+
+    std::unique_ptr<SharedChunkCache> c(new SharedChunkCache);
+    c->_map      = map;
+    c->_mapBytes = bytes;
+    c->_name     = name;
+    c->_hdr      = static_cast<Header*>(map);
+    Header& h    = *c->_hdr;
+
+    // A fresh segment is all zeroes: every slot unused, the cursor at 0
+    if (creator) {
+        h.magic      = MAGIC;
+        h.version    = LAYOUT_VERSION;
+        h.world      = world;
+        h.slots      = slots;
+        h.arenaBytes = arena;
+        h.state.store(2, std::memory_order_release);
+    } else {
+        for (int waited = 0; h.state.load(std::memory_order_acquire) != 2 && waited < READY_WAIT_MS; waited += 10)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (h.state.load(std::memory_order_acquire) != 2 || h.magic != MAGIC ||
+            h.version != LAYOUT_VERSION || h.world != world ||
+            HEADER_BYTES + (h.slots + PROBE) * sizeof(Slot) + h.arenaBytes > bytes) {
+            Log::err(std::string("SharedChunkCache: ") + name + " is stale or from another build;"
+                     " remove it from /dev/shm once no server uses it");
+            return nullptr;
+        }
+    }
+    c->_slots = reinterpret_cast<Slot*>(static_cast<uint8_t*>(map) + HEADER_BYTES);
+    c->_arena = reinterpret_cast<uint8_t*>(c->_slots + h.slots + PROBE);
+    Log::info(std::string("SharedChunkCache: ") + (creator ? "created " : "joined ") + name + ", " +
+              std::to_string(h.arenaBytes >> 20) + " MB arena, " + std::to_string(h.slots) + " slots");
+    return c;
+#endif
+}
+
+SharedChunkCache::~SharedChunkCache() {
+#ifndef _WIN32
+    if (_map) munmap(_map, _mapBytes);
+#endif
+}
+
+ChunkPayload SharedChunkCache::get(const ChunkKey& key, bool mesh) {
+    const uint32_t tag   = tagOf(key, mesh);
+    const uint64_t coord = packCoord(key.coord);
+    const uint64_t arena = _hdr->arenaBytes;
+    size_t home = homeOf(key, mesh, _hdr->slots);
+    for (size_t i = home; i < home + PROBE; i++) {
+        Slot&    s   = _slots[i];
+        uint32_t seq = s.seq.load(std::memory_order_acquire);
+        if (seq & 1) continue;
+        uint32_t info  = s.info.load(std::memory_order_relaxed);
+        uint64_t c     = s.coord.load(std::memory_order_relaxed);
+        uint64_t start = s.start.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.seq.load(std::memory_order_relaxed) != seq) continue;
+        if ((info & ~LEN_MASK) != tag || c != coord) continue;
+
+        // Gone once the cursor passes start + arena; checked again after
+        // the copy, which a writer lapping the ring may have raced
+        if (_hdr->cursor.load() > start + arena) continue;
+        std::vector<uint8_t> out(info & LEN_MASK);
+        ringRead(_arena, arena, start, out.data(), out.size());
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_hdr->cursor.load() > start + arena) continue;
+        _hits.fetch_add(1, std::memory_order_relaxed);
+        return std::make_shared<const std::vector<uint8_t>>(std::move(out));
+    }
+    _misses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+void SharedChunkCache::put(const ChunkKey& key, bool mesh, const std::vector<uint8_t>& bytes) {
+    const uint64_t arena = _hdr->arenaBytes;
+    if (bytes.empty() || bytes.size() > LEN_MASK || bytes.size() > arena / 8) return;
+
+    // The bytes first, then the slot that points at them
+    uint64_t start = _hdr->cursor.fetch_add(bytes.size());
+    ringWrite(_arena, arena, start, bytes.data(), bytes.size());
+
+    // This key's slot if it has one, else a free or overwritten one, else
+    // whichever's payload is oldest
+    const uint32_t tag   = tagOf(key, mesh);
+    const uint64_t coord = packCoord(key.coord);
+    size_t home = homeOf(key, mesh, _hdr->slots);
+    Slot*    pick     = nullptr;
+    uint64_t pickRank = UINT64_MAX;
+    for (size_t i = home; i < home + PROBE; i++) {
+        Slot&    s    = _slots[i];
+        uint32_t info = s.info.load(std::memory_order_relaxed);
+        if ((info & ~LEN_MASK) == tag && s.coord.load(std::memory_order_relaxed) == coord) {
+            pick = &s;
+            break;
+        }
+        uint64_t st   = s.start.load(std::memory_order_relaxed);
+        uint64_t rank = !(info & USED) || st + arena < start ? 0 : st + 1;
+        if (rank < pickRank) {
+            pick     = &s;
+            pickRank = rank;
+        }
+    }
+
+    // Another writer has the slot: this one's a cache, the chunk can go
+    uint32_t seq = pick->seq.load(std::memory_order_relaxed);
+    if ((seq & 1) || !pick->seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) return;
+    std::atomic_thread_fence(std::memory_order_release);
+    pick->info.store(tag | (uint32_t)bytes.size(), std::memory_order_relaxed);
+    pick->coord.store(coord, std::memory_order_relaxed);
+    pick->start.store(start, std::memory_order_relaxed);
+    pick->seq.store(seq + 2, std::memory_order_release);
+    _puts.fetch_add(1, std::memory_order_relaxed);
+}
+
+SharedChunkCache::Stats SharedChunkCache::stats() const {
+    return {_hits.load(std::memory_order_relaxed), _misses.load(std::memory_order_relaxed),
+            _puts.load(std::memory_order_relaxed), (size_t)_hdr->slots, (size_t)_hdr->arenaBytes};
+}
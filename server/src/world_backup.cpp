@@ -0,0 +1,122 @@
+#include "world_backup.h"
+#include "config.h"
+#include "log.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <vector>
+
+WorldBackup::WorldBackup(std::string target, int keep)
+    : _target(std::move(target)), _keep(std::max(1, keep))
+{
+    std::error_code ec;
+    std::filesystem::create_directories(_target, ec);
+    if (ec) Log::err("WorldBackup: cannot create " + _target + ": " + ec.message());
+    _thread = std::thread([this] { run(); });
+}
+
+WorldBackup::~WorldBackup() {
+    {
+        std::lock_guard lk(_mu);
+        _stop = true;
+    }
+    _cv.notify_one();
+    if (_thread.joinable()) _thread.join();
+}
+
+bool WorldBackup::begin(InvStore& inv, RegionStore& regions) {
+    if (_busy.exchange(true, std::memory_order_acq_rel)) {
+        Log::warn("WorldBackup: the last backup is still being written; skipping this one");
+        return false;
+    }
+    char name[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(name, sizeof name, "%Y%m%d-%H%M%S", std::localtime(&now));
+    {
+        std::lock_guard lk(_mu);
+        _next   = {name, inv.freeze(), &regions, regions.freeze()};
+        _queued = true;
+    }
+    _cv.notify_one();
+    return true;
+}
+
+// ── Backup thread ─────────────────────────────────────────────────────────────
+
+void WorldBackup::run() {
+    std::unique_lock lk(_mu);
+    for (;;) {
+        _cv.wait(lk, [&] { return _stop || _queued; });
+        if (!_queued) return;
+        Epoch e = std::move(_next);
+        _next   = {};
+        _queued = false;
+        lk.unlock();
+
+        auto t0 = std::chrono::steady_clock::now();
+        if (write(e)) {
+            prune();
+            Log::info("WorldBackup: " + e.name + " written in " +
+                      std::to_string(std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count()) +
+                      " s");
+        }
+        _busy.store(false, std::memory_order_release);
+        lk.lock();
+    }
+}
+
+bool WorldBackup::write(Epoch& e) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    // Two in one second (a restart, say) get a suffix
+    for (int n = 1; fs::exists(fs::path(_target) / e.name, ec); n++)
+        e.name = e.name.substr(0, 15) + "-" + std::to_string(n);
+    const fs::path partial = fs::path(_target) / (e.name + ".partial");
+    const fs::path done    = fs::path(_target) / e.name;
+    fs::remove_all(partial, ec);
+    fs::create_directories(partial, ec);
+    auto fail = [&](const std::string& what) {
+        Log::err("WorldBackup: " + e.name + ": " + what);
+        fs::remove_all(partial, ec);
+        return false;
+    };
+
+    if (!InvStore::writeSnapshot((partial / InvStore::SNAP_FILE).string(), e.inv))
+        return fail("inventory snapshot failed");
+    e.inv.clear(); // the payloads it alone still holds go now
+
+    e.regions.wait();
+    if (!e.regions.ready()) return fail("region tables weren't frozen");
+    // Paced, so the live region writes aren't queued behind the copy
+    const double bytesPerS = Config::BACKUP_MB_PER_S * 1024.0 * 1024.0;
+    auto start  = std::chrono::steady_clock::now();
+    double sent = 0.0;
+    for (const RegionStore::FrozenRegion& r : e.regions.get()) {
+        std::string file = "r." + std::to_string(r.coord.x) + "." + std::to_string(r.coord.y) + "." +
+                           std::to_string(r.coord.z) + ".bin";
+        if (!e.store->writeFrozen((partial / file).string(), r)) return fail("copying " + file + " failed");
+        for (const RegionStore::Slot& s : r.table) sent += (double)s.length;
+        auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(sent / bytesPerS));
+        std::unique_lock lk(_mu);
+        _cv.wait_until(lk, due, [&] { return _stop; }); // flat out once stopping
+    }
+
+    fs::rename(partial, done, ec);
+    if (ec) return fail("rename failed: " + ec.message());
+    return true;
+}
+
+// Oldest first by name, which is the time it was taken. Partial ones are
+// left from a run that stopped mid-backup; none is being written now.
+void WorldBackup::prune() {
+    namespace fs = std::filesystem;
+    std::vector<fs::path> backups, partial;
+    std::error_code ec;
+    for (const auto& d : fs::directory_iterator(_target, ec))
+        if (d.is_directory()) (d.path().extension() == ".partial" ? partial : backups).push_back(d.path());
+    for (const fs::path& p : partial) fs::remove_all(p, ec);
+    std::sort(backups.begin(), backups.end());
+    for (size_t i = 0; i + (size_t)_keep < backups.size(); i++) fs::remove_all(backups[i], ec);
+}
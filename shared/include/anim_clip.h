@@ -0,0 +1,180 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ── Compiled animation clips ──────────────────────────────────────────────────
+// Authored clips — keyframes with per-key easing, or a GLB's channels — baked
+// once into fixed-rate tracks, so playing one is an index and a lerp: no
+// keyframe search, no easing and no per-channel branching at sample time.
+//
+// A clip animates layout.tracks transforms (one for the view model, a skin's
+// joints for the player model). Each frame is one row of channels grouped by
+// kind, every track's translation, then every rotation, then every scale:
+//
+//   t0.xyz t1.xyz … | r0 r1 … | s0.xyz s1.xyz …
+//
+// with rotations rotWidth wide: 3 for Euler degrees, 4 for a quaternion
+// (xyzw, renormalized after the lerp). Rows are back to back at the compile
+// rate, the last exactly at the clip's end — a looping clip's last row is its
+// first, so the wrap is seamless. Sampling lerps two adjacent rows across all
+// channels in one loop the compiler vectorizes, and sampleClips does that for
+// a whole batch of (clip, time) pairs. Quantized clips store each channel as
+// a u16 over that channel's own range, half the bytes for a little precision.
+struct ClipLayout {
+    uint16_t tracks   = 1;
+    uint8_t  rotWidth = 3;
+
+    uint32_t channels()   const { return tracks * (6u + rotWidth); }
+    uint32_t rotBegin()   const { return tracks * 3u; }
+    uint32_t scaleBegin() const { return tracks * (3u + rotWidth); }
+};
+
+struct ClipCompileOptions {
+    float rate     = 60.f; // rows per second
+    bool  quantize = false;
+};
+
+struct ClipQuery;
+inline void sampleClips(const ClipQuery* q, size_t n, float* out, size_t stride);
+
+class CompiledClip {
+public:
+    // fn(t, row) writes layout.channels() floats for the pose at t seconds,
+    // 0 <= t <= duration
+    template<class F>
+    static CompiledClip compile(ClipLayout layout, float duration, bool loop, F&& fn,
+                                ClipCompileOptions opt = {}) {
+        CompiledClip c;
+        c._layout   = layout;
+        c._duration = std::max(duration, 0.f);
+        c._loop     = loop;
+        c._frames   = c._duration > 0.f
+                          ? std::max(2u, (uint32_t)std::ceil(c._duration * std::max(opt.rate, 1.f)) + 1u)
+                          : 1u;
+        c._perRow   = c._frames > 1 ? (float)(c._frames - 1) / c._duration : 0.f;
+
+        const uint32_t C = layout.channels();
+        std::vector<float> rows((size_t)c._frames * C);
+        for (uint32_t i = 0; i < c._frames; i++) {
+            float t = c._frames > 1 ? c._duration * (float)i / (float)(c._frames - 1) : 0.f;
+            fn(t, rows.data() + (size_t)i * C);
+        }
+        if (!opt.quantize) {
+            c._rows = std::move(rows);
+            return c;
+        }
+
+        c._min.assign(C, 0.f);
+        c._step.assign(C, 0.f);
+        for (uint32_t ch = 0; ch < C; ch++) {
+            float lo = rows[ch], hi = rows[ch];
+            for (uint32_t i = 1; i < c._frames; i++) {
+                lo = std::min(lo, rows[(size_t)i * C + ch]);
+                hi = std::max(hi, rows[(size_t)i * C + ch]);
+            }
+            c._min[ch]  = lo;
+            c._step[ch] = (hi - lo) / 65535.f;
+        }
+        c._q.resize(rows.size());
+        for (size_t k = 0; k < rows.size(); k++) {
+            uint32_t ch = (uint32_t)(k % C);
+            c._q[k] = c._step[ch] > 0.f
+                          ? (uint16_t)std::lround((rows[k] - c._min[ch]) / c._step[ch])
+                          : (uint16_t)0;
+        }
+        return c;
+    }
+
+    const ClipLayout& layout()    const { return _layout; }
+    float             duration()  const { return _duration; }
+    bool              loop()      const { return _loop; }
+    uint32_t          frames()    const { return _frames; }
+    bool              quantized() const { return !_q.empty(); }
+    bool              empty()     const { return _frames == 0; }
+    size_t bytes() const {
+        return _rows.size() * sizeof(float) + _q.size() * sizeof(uint16_t) +
+               (_min.size() + _step.size()) * sizeof(float);
+    }
+
+    // layout().channels() floats
+    void sample(float t, float* out) const;
+
+private:
+    friend void sampleClips(const ClipQuery* q, size_t n, float* out, size_t stride);
+
+    // The row t falls in and how far it is towards the next
+    void locate(float t, uint32_t& i, float& f) const {
+        if (_frames < 2) { i = 0; f = 0.f; return; }
+        if (_loop) {
+            t = std::fmod(t, _duration);
+            if (t < 0.f) t += _duration;
+        }
+        float x = std::clamp(t, 0.f, _duration) * _perRow;
+        i = std::min((uint32_t)x, _frames - 2);
+        f = std::min(x - (float)i, 1.f);
+    }
+
+    void lerpRows(uint32_t i, float f, float* out) const {
+        const uint32_t C = _layout.channels();
+        const uint32_t j = _frames > 1 ? i + 1 : i;
+        if (_q.empty()) {
+            const float* a = _rows.data() + (size_t)i * C;
+            const float* b = _rows.data() + (size_t)j * C;
+            for (uint32_t c = 0; c < C; c++) out[c] = a[c] + (b[c] - a[c]) * f;
+        } else {
+            const uint16_t* a = _q.data() + (size_t)i * C;
+            const uint16_t* b = _q.data() + (size_t)j * C;
+            const float* lo = _min.data();
+            const float* st = _step.data();
+            for (uint32_t c = 0; c < C; c++) {
+                float qa = (float)a[c], qb = (float)b[c];
+                out[c] = lo[c] + st[c] * (qa + (qb - qa) * f);
+            }
+        }
+        if (_layout.rotWidth == 4) {
+            float* r = out + _layout.rotBegin();
+            for (uint32_t k = 0; k < _layout.tracks; k++, r += 4) {
+                float len = std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+                float inv = len > 0.f ? 1.f / len : 0.f;
+                r[0] *= inv; r[1] *= inv; r[2] *= inv; r[3] *= inv;
+            }
+        }
+    }
+
+    ClipLayout            _layout;
+    float                 _duration = 0.f;
+    float                 _perRow   = 0.f; // rows per second, as laid out
+    bool                  _loop     = false;
+    uint32_t              _frames   = 0;
+    std::vector<float>    _rows;             // unquantized
+    std::vector<uint16_t> _q;                // quantized, with:
+    std::vector<float>    _min, _step;       //   per channel
+};
+
+// ── Batched sampling ──────────────────────────────────────────────────────────
+// One call for everything animated this frame. Finding a query's rows is a
+// multiply, not a search, so the loop over channels is all that runs per
+// pose. Queries needn't share a clip or a layout.
+struct ClipQuery {
+    const CompiledClip* clip;
+    float               time;
+};
+
+// Query k's pose goes to out + k * stride; stride must cover the widest
+// clip's channels
+inline void sampleClips(const ClipQuery* q, size_t n, float* out, size_t stride) {
+    for (size_t k = 0; k < n; k++) {
+        uint32_t i;
+        float    f;
+        q[k].clip->locate(q[k].time, i, f);
+        q[k].clip->lerpRows(i, f, out + k * stride);
+    }
+}
+
+inline void CompiledClip::sample(float t, float* out) const {
+    ClipQuery q{this, t};
+    sampleClips(&q, 1, out, _layout.channels());
+}
@@ -0,0 +1,217 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <glm/glm.hpp>
+#include "log.h"
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+// ── AssetBlob ─────────────────────────────────────────────────────────────────
+// A model as tools/asset_bake leaves it: vertex and index buffers exactly as
+// they're uploaded, an optional RGBA8 texture, and bounds, behind a fixed
+// header. Native byte order — it's a local cache next to the .glb it came
+// from, not an interchange format. The header records the source's size and
+// mtime; a blob that doesn't match its source or this VERSION is stale, and
+// the loader falls back to parsing the GLB.
+//
+//   Header | vertices | indices (u32) | texture       each 16-byte aligned
+namespace AssetBlob {
+
+inline constexpr uint32_t MAGIC   = 0x42414541; // "AEAB"
+inline constexpr uint32_t VERSION = 2;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexStride;  // sizeof the vertex type the baker wrote
+    uint32_t jointCount;    // skinned models; 0 if static
+    uint64_t sourceSize;
+    int64_t  sourceTime;    // last_write_time ticks
+    uint64_t vertexOffset, vertexCount;
+    uint64_t indexOffset,  indexCount;
+    uint64_t textureOffset; // 0 if none
+    uint32_t textureW, textureH;
+    float    boundsMin[3];
+    float    boundsMax[3];
+};
+static_assert(sizeof(Header) % 8 == 0);
+
+// Blob path for a source asset: arm.glb -> arm.aeb
+inline std::string pathFor(const std::string& source) {
+    return std::filesystem::path(source).replace_extension(".aeb").string();
+}
+
+inline bool sourceStamp(const char* source, uint64_t& size, int64_t& time) {
+    std::error_code ec;
+    auto sz = std::filesystem::file_size(source, ec);
+    if (ec) return false;
+    auto t = std::filesystem::last_write_time(source, ec);
+    if (ec) return false;
+    size = sz;
+    time = (int64_t)t.time_since_epoch().count();
+    return true;
+}
+
+// What the baker hands to write()
+struct Contents {
+    const void*     vertices     = nullptr;
+    uint32_t        vertexStride = 0;
+    size_t          vertexCount  = 0;
+    const uint32_t* indices      = nullptr;
+    size_t          indexCount   = 0;
+    const uint8_t*  texture      = nullptr; // RGBA8, optional
+    uint32_t        textureW     = 0, textureH = 0;
+    glm::vec3       boundsMin{0.f}, boundsMax{0.f};
+    uint32_t        jointCount   = 0;
+};
+
+inline bool write(const char* path, const char* source, const Contents& c) {
+    Header h{};
+    h.magic        = MAGIC;
+    h.version      = VERSION;
+    h.vertexStride = c.vertexStride;
+    h.jointCount   = c.jointCount;
+    if (!sourceStamp(source, h.sourceSize, h.sourceTime)) return false;
+
+    auto align = [](uint64_t o) { return (o + 15) & ~uint64_t(15); };
+    uint64_t vBytes = (uint64_t)c.vertexCount * c.vertexStride;
+    uint64_t iBytes = (uint64_t)c.indexCount * sizeof(uint32_t);
+    h.vertexOffset = align(sizeof(Header));
+    h.vertexCount  = c.vertexCount;
+    h.indexOffset  = align(h.vertexOffset + vBytes);
+    h.indexCount   = c.indexCount;
+    uint64_t end   = h.indexOffset + iBytes;
+    if (c.texture) {
+        h.textureOffset = align(end);
+        h.textureW      = c.textureW;
+        h.textureH      = c.textureH;
+        end = h.textureOffset + (uint64_t)c.textureW * c.textureH * 4;
+    }
+    for (int i = 0; i < 3; i++) { h.boundsMin[i] = c.boundsMin[i]; h.boundsMax[i] = c.boundsMax[i]; }
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = true;
+    auto put = [&](uint64_t at, const void* d, uint64_t n) {
+        static const uint8_t zeros[16] = {};
+        long pos = ftell(f);
+        if (pos < 0) { ok = false; return; }
+        ok = ok && fwrite(zeros, 1, (size_t)(at - (uint64_t)pos), f) == at - (uint64_t)pos;
+        ok = ok && fwrite(d, 1, (size_t)n, f) == n;
+    };
+    put(0, &h, sizeof(h));
+    put(h.vertexOffset, c.vertices, vBytes);
+    put(h.indexOffset, c.indices, iBytes);
+    if (c.texture) put(h.textureOffset, c.texture, end - h.textureOffset);
+    ok = fclose(f) == 0 && ok;
+    return ok;
+}
+
+// ── Mapped ────────────────────────────────────────────────────────────────────
+// Read-only mapping of a blob. Pointers stay valid until close(); pages are
+// only read in as the upload copies them out.
+class Mapped {
+public:
+    Mapped() = default;
+    Mapped(const Mapped&)            = delete;
+    Mapped& operator=(const Mapped&) = delete;
+    ~Mapped() { close(); }
+
+    // False if missing, stale against source, the wrong vertex type or
+    // truncated — not an error, the caller parses the source instead
+    bool open(const char* path, const char* source, uint32_t vertexStride) {
+        close();
+        if (!map(path)) return false;
+        if (_size < sizeof(Header)) { close(); return false; }
+        const Header& h = header();
+        uint64_t srcSize = 0; int64_t srcTime = 0;
+        bool fresh = h.magic == MAGIC && h.version == VERSION &&
+                     h.vertexStride == vertexStride &&
+                     sourceStamp(source, srcSize, srcTime) &&
+                     h.sourceSize == srcSize && h.sourceTime == srcTime;
+        uint64_t end = h.indexOffset + h.indexCount * sizeof(uint32_t);
+        if (h.textureOffset) end = h.textureOffset + (uint64_t)h.textureW * h.textureH * 4;
+        if (!fresh || end > _size ||
+            h.vertexOffset + h.vertexCount * vertexStride > h.indexOffset) {
+            if (!fresh) Log::info(std::string("Stale asset blob, using source: ") + path);
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (!_data) return;
+#ifdef _WIN32
+        UnmapViewOfFile(_data);
+        CloseHandle(_mapping);
+        CloseHandle(_file);
+#else
+        munmap(const_cast<uint8_t*>(_data), _size);
+#endif
+        _data = nullptr;
+        _size = 0;
+    }
+
+    bool valid() const { return _data != nullptr; }
+    const Header& header() const { return *reinterpret_cast<const Header*>(_data); }
+
+    template<class V>
+    const V* vertices() const { return reinterpret_cast<const V*>(_data + header().vertexOffset); }
+    const uint32_t* indices() const {
+        return reinterpret_cast<const uint32_t*>(_data + header().indexOffset);
+    }
+    const uint8_t* texture() const {
+        return header().textureOffset ? _data + header().textureOffset : nullptr;
+    }
+    glm::vec3 boundsMin() const { auto& b = header().boundsMin; return {b[0], b[1], b[2]}; }
+    glm::vec3 boundsMax() const { auto& b = header().boundsMax; return {b[0], b[1], b[2]}; }
+
+private:
+    bool map(const char* path) {
+#ifdef _WIN32
+        _file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(_file, &sz) || sz.QuadPart == 0) { CloseHandle(_file); return false; }
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!_mapping) { CloseHandle(_file); return false; }
+        void* p = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!p) { CloseHandle(_mapping); CloseHandle(_file); return false; }
+        _data = static_cast<const uint8_t*>(p);
+        _size = (size_t)sz.QuadPart;
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        _data = static_cast<const uint8_t*>(p);
+        _size = (size_t)st.st_size;
+#endif
+        return true;
+    }
+
+    const uint8_t* _data = nullptr;
+    size_t         _size = 0;
+#ifdef _WIN32
+    HANDLE _file    = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#endif
+};
+
+} // namespace AssetBlob
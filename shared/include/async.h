@@ -0,0 +1,234 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "thread_pool.h"
+
+// ── Async ─────────────────────────────────────────────────────────────────────
+// Coroutines for the flows that wait on something off the main thread — an
+// auth server's answer, a save read off disk — and carry on on it:
+//
+//   Async<> verify(ENetPeer* peer, AuthRequestPacket req) {
+//       Verdict v = co_await loop.run(pool, [=] { return ask(req); });
+//       ...                                  // main thread again
+//   }
+//   loop.spawn(verify(peer, req));
+//
+// An Async<T> starts when it's first awaited, or spawned; co_await on one
+// runs it and gives back its co_return. loop.run() puts a function on a
+// ThreadPool and loop.wait() waits out a TaskFuture; either way the
+// coroutine is queued on its AsyncLoop when the work is done, and resumed
+// by the loop's resume() — once per main-loop iteration, at most a budget
+// of them, so a burst of completions spreads over ticks instead of
+// stretching one. Nothing here blocks the thread running the loop.
+//
+// Parameters are copied into the frame; take them by value, not by
+// reference, since the caller is long gone by the time the coroutine
+// resumes. An exception escaping a coroutine ends the program, as one
+// escaping a pool task would.
+class AsyncLoop;
+template<class T = void> class Async;
+
+namespace AsyncDetail {
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation; // whoever awaits it
+    AsyncLoop*              owner = nullptr; // spawn()ed: the loop frees the frame
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { std::terminate(); }
+
+    // On to the awaiting coroutine, or, spawned, gone
+    struct Final {
+        bool await_ready() const noexcept { return false; }
+        template<class P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept;
+        void await_resume() const noexcept {}
+    };
+    Final final_suspend() noexcept { return {}; }
+};
+
+template<class T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Async<T> get_return_object();
+    template<class U> void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+    T take() { return std::move(*value); }
+};
+
+template<>
+struct Promise<void> : PromiseBase {
+    Async<void> get_return_object();
+    void return_void() {}
+    void take() {}
+};
+
+} // namespace AsyncDetail
+
+template<class T>
+class [[nodiscard]] Async {
+public:
+    using promise_type = AsyncDetail::Promise<T>;
+    using Handle       = std::coroutine_handle<promise_type>;
+
+    Async() = default;
+    explicit Async(Handle h) : _h(h) {}
+    Async(Async&& o) noexcept : _h(std::exchange(o._h, {})) {}
+    Async& operator=(Async&& o) noexcept {
+        if (this != &o) {
+            if (_h) _h.destroy();
+            _h = std::exchange(o._h, {});
+        }
+        return *this;
+    }
+    Async(const Async&)            = delete;
+    Async& operator=(const Async&) = delete;
+    ~Async() { if (_h) _h.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+        _h.promise().continuation = caller;
+        return _h;
+    }
+    T await_resume() { return _h.promise().take(); }
+
+private:
+    friend class AsyncLoop;
+    Handle _h;
+};
+
+template<class T>
+Async<T> AsyncDetail::Promise<T>::get_return_object() {
+    return Async<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+inline Async<void> AsyncDetail::Promise<void>::get_return_object() {
+    return Async<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// ── AsyncLoop ─────────────────────────────────────────────────────────────────
+// Where spawned coroutines live and resume. Everything but post() is for
+// the thread that calls resume(). The pools run() submits to must be joined
+// before the loop goes; coroutines still suspended then are freed unfinished.
+class AsyncLoop {
+public:
+    AsyncLoop() = default;
+    AsyncLoop(const AsyncLoop&)            = delete;
+    AsyncLoop& operator=(const AsyncLoop&) = delete;
+    ~AsyncLoop() {
+        for (std::coroutine_handle<> h : _roots) h.destroy();
+    }
+
+    // Runs t now, up to its first wait; the loop owns it from there
+    void spawn(Async<void> t) {
+        auto h = std::exchange(t._h, {});
+        h.promise().owner = this;
+        _roots.insert(h);
+        h.resume();
+    }
+
+    // Any thread: h is resumed by a later resume()
+    void post(std::coroutine_handle<> h) {
+        std::lock_guard lk(_mu);
+        _posted.push_back(h);
+    }
+
+    // Once an iteration: resumes up to budget of the coroutines whose waits
+    // are over, oldest first; the rest keep their place for the next call
+    size_t resume(size_t budget) {
+        {
+            std::lock_guard lk(_mu);
+            for (std::coroutine_handle<> h : _posted) _ready.push_back(h);
+            _posted.clear();
+        }
+        size_t n = 0;
+        for (; n < budget && !_ready.empty(); n++) {
+            std::coroutine_handle<> h = _ready.front();
+            _ready.pop_front();
+            h.resume();
+        }
+        _resumed += n;
+        return n;
+    }
+
+    size_t   live()    const { return _roots.size(); }  // spawned and not finished
+    size_t   queued()  const { std::lock_guard lk(_mu); return _ready.size() + _posted.size(); }
+    bool     busy()    const { return !_roots.empty(); }
+    uint64_t resumed() const { return _resumed; }
+
+    // ── Awaitables ──
+
+    // co_await gives back f, done: ready, or cancelled
+    template<class T>
+    struct FutureWait {
+        AsyncLoop&    loop;
+        TaskFuture<T> f;
+
+        bool await_ready() const { return f.done(); }
+        void await_suspend(std::coroutine_handle<> h) {
+            f.onDone([&l = loop, h](TaskFuture<T>&) { l.post(h); });
+        }
+        TaskFuture<T> await_resume() { return f; }
+    };
+    template<class T> FutureWait<T> wait(TaskFuture<T> f) { return {*this, std::move(f)}; }
+
+    // fn() on pool; co_await gives back what it returned
+    template<class T>
+    struct RunWait : FutureWait<T> {
+        T await_resume() {
+            if constexpr (!std::is_void_v<T>) return std::move(this->f.get());
+        }
+    };
+    template<class F, class R = std::invoke_result_t<std::decay_t<F>&>>
+    RunWait<R> run(ThreadPool& pool, F&& fn, TaskPriority prio = TaskPriority::Normal) {
+        return {{*this, pool.async(std::forward<F>(fn), prio)}};
+    }
+
+    // Back of the queue: after the coroutines already waiting, a later
+    // iteration if the budget's spent
+    struct Yield {
+        AsyncLoop& loop;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { loop._ready.push_back(h); }
+        void await_resume() const noexcept {}
+    };
+    Yield yield() { return {*this}; }
+
+private:
+    friend struct AsyncDetail::PromiseBase;
+
+    // A spawned coroutine at its end
+    void retire(std::coroutine_handle<> h) {
+        _roots.erase(h);
+        h.destroy();
+    }
+
+    struct HandleHash {
+        size_t operator()(std::coroutine_handle<> h) const noexcept {
+            return std::hash<void*>{}(h.address());
+        }
+    };
+
+    std::unordered_set<std::coroutine_handle<>, HandleHash> _roots;
+    std::deque<std::coroutine_handle<>>                     _ready;
+    uint64_t                                                _resumed = 0;
+
+    mutable std::mutex                   _mu;
+    std::vector<std::coroutine_handle<>> _posted; // under _mu
+};
+
+template<class P>
+std::coroutine_handle<> AsyncDetail::PromiseBase::Final::await_suspend(std::coroutine_handle<P> h) noexcept {
+    PromiseBase& p = h.promise();
+    if (p.continuation) return p.continuation;
+    if (p.owner) p.owner->retire(h);
+    return std::noop_coroutine();
+}
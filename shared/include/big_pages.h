@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+
+// ── BigPages ──────────────────────────────────────────────────────────────────
+// Where the server's large, long-lived, randomly read buffers get their
+// pages. Under Advise, a mapping of HUGE_BYTES or more is marked for
+// transparent huge pages (madvise MADV_HUGEPAGE); under Explicit it's
+// mapped from the hugetlb pool (MAP_HUGETLB), falling back to Advise when
+// the pool can't cover it. numaLocal binds what map() hands out to the
+// node of whichever thread first touches it (MPOL_LOCAL), so a pinned
+// worker's thread_local scratch stays beside that worker.
+//
+// configure() once at startup, before the pools it covers exist; the
+// default is Off and not local, which is plain anonymous memory, as on the
+// client. Linux only: elsewhere map() is aligned operator new and hints do
+// nothing.
+namespace BigPages {
+    enum class Mode : uint8_t { Off, Advise, Explicit };
+
+    // "off", "thp" or "hugetlb"; anything else is Off
+    Mode        parse(const std::string& s);
+    const char* name(Mode m);
+
+    struct Policy {
+        Mode mode      = Mode::Off;
+        bool numaLocal = false;
+    };
+
+    void   configure(const Policy& p);
+    Policy policy();
+
+    constexpr size_t HUGE_BYTES = 2u << 20;
+
+    struct Stats {
+        int64_t  liveBytes = 0; // handed out by map(), rounded up
+        uint64_t hugetlb   = 0; // maps from the hugetlb pool, since start
+        uint64_t fallbacks = 0; // and Explicit ones that made do with Advise
+    };
+    Stats stats();
+
+    // bytes of zeroed memory under the policy; throws bad_alloc like new
+    void* map(size_t bytes);
+    void  unmap(void* p, size_t bytes);
+
+    // The policy's hint for a mapping made elsewhere (a shared segment):
+    // huge pages under Advise or Explicit, where it's large enough
+    void adviseHuge(void* p, size_t bytes);
+
+    template<class T>
+    struct Deleter {
+        void operator()(T* p) const {
+            p->~T();
+            unmap(p, sizeof(T));
+        }
+    };
+    template<class T>
+    using Ptr = std::unique_ptr<T, Deleter<T>>;
+
+    template<class T, class... Args>
+    Ptr<T> make(Args&&... args) {
+        void* p = map(sizeof(T));
+        return Ptr<T>(new (p) T(std::forward<Args>(args)...));
+    }
+}
@@ -0,0 +1,207 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "log.h"
+
+// ── BindlessTable ─────────────────────────────────────────────────────────────
+// One descriptor set layout every renderer's pipelines share at set 0:
+// binding 0 an array of MAX_TEXTURES combined image samplers, binding 1 an
+// array of MAX_BUFFERS storage buffers. Shaders pick entries by index — a
+// constant, or a push constant — so a pass binds the one set once however
+// many textures and buffers its draws reach, and adding one is an index,
+// not a layout.
+//
+// Entries below the reserved counts are the caller's to place with
+// setTexture/setBuffer; addTexture/addBuffer hand out the rest. Changes
+// reach a frame's set in update(frame), called once that frame's fence has
+// been waited on, so a set the GPU may still read is never written and no
+// UPDATE_AFTER_BIND is needed. An entry nothing is in repeats the first
+// filled one, so every descriptor is valid without PARTIALLY_BOUND. Indices
+// must be the same across a draw (dynamically uniform), which core Vulkan
+// covers with the array dynamic indexing features.
+class BindlessTable {
+public:
+    static constexpr uint32_t MAX_TEXTURES = 128; // the shaders declare the same
+    static constexpr uint32_t MAX_BUFFERS  = 32;
+    static constexpr uint32_t NONE         = ~0u;
+
+    bool init(VkDevice dev, const VkPhysicalDeviceLimits& limits, uint32_t frames,
+              uint32_t reservedTextures, uint32_t reservedBuffers) {
+        if (limits.maxPerStageDescriptorSamplers < MAX_TEXTURES + 2 ||
+            limits.maxPerStageDescriptorStorageBuffers < MAX_BUFFERS) {
+            Log::err("Bindless: device allows " +
+                     std::to_string(limits.maxPerStageDescriptorSamplers) + " samplers, " +
+                     std::to_string(limits.maxPerStageDescriptorStorageBuffers) +
+                     " storage buffers per stage");
+            return false;
+        }
+        _dev = dev;
+        _textures.assign(MAX_TEXTURES, {});
+        _buffers.assign(MAX_BUFFERS, {});
+        _freeTextures.clear();
+        _freeBuffers.clear();
+        for (uint32_t i = MAX_TEXTURES; i-- > reservedTextures;) _freeTextures.push_back(i);
+        for (uint32_t i = MAX_BUFFERS; i-- > reservedBuffers;) _freeBuffers.push_back(i);
+
+        VkDescriptorSetLayoutBinding b[2]{};
+        b[0].binding         = 0;
+        b[0].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        b[0].descriptorCount = MAX_TEXTURES;
+        b[0].stageFlags      = VK_SHADER_STAGE_FRAGMENT_BIT;
+        b[1].binding         = 1;
+        b[1].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        b[1].descriptorCount = MAX_BUFFERS;
+        b[1].stageFlags      = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        VkDescriptorSetLayoutCreateInfo lCI{};
+        lCI.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        lCI.bindingCount = 2;
+        lCI.pBindings    = b;
+        if (vkCreateDescriptorSetLayout(dev, &lCI, nullptr, &_layout) != VK_SUCCESS) return false;
+
+        VkDescriptorPoolSize sizes[2] = {
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURES * frames},
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, MAX_BUFFERS * frames}};
+        VkDescriptorPoolCreateInfo pCI{};
+        pCI.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pCI.maxSets       = frames;
+        pCI.poolSizeCount = 2;
+        pCI.pPoolSizes    = sizes;
+        if (vkCreateDescriptorPool(dev, &pCI, nullptr, &_pool) != VK_SUCCESS) return false;
+
+        std::vector<VkDescriptorSetLayout> layouts(frames, _layout);
+        _sets.assign(frames, VK_NULL_HANDLE);
+        _applied.assign(frames, 0);
+        VkDescriptorSetAllocateInfo aI{};
+        aI.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        aI.descriptorPool     = _pool;
+        aI.descriptorSetCount = frames;
+        aI.pSetLayouts        = layouts.data();
+        return vkAllocateDescriptorSets(dev, &aI, _sets.data()) == VK_SUCCESS;
+    }
+
+    void destroy() {
+        if (_pool) vkDestroyDescriptorPool(_dev, _pool, nullptr);
+        if (_layout) vkDestroyDescriptorSetLayout(_dev, _layout, nullptr);
+        _pool   = VK_NULL_HANDLE;
+        _layout = VK_NULL_HANDLE;
+        _sets.clear();
+    }
+
+    // ── Entries ───────────────────────────────────────────────────────────
+    // Any thread. The view and buffer must outlive the entry on every frame
+    // in flight: release, then destroy once those frames are done
+
+    void setTexture(uint32_t index, VkImageView view, VkSampler sampler,
+                    VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+        std::lock_guard lk(_mu);
+        _textures[index] = {sampler, view, layout};
+        _version++;
+    }
+    void setBuffer(uint32_t index, VkBuffer buffer, VkDeviceSize offset = 0,
+                   VkDeviceSize range = VK_WHOLE_SIZE) {
+        std::lock_guard lk(_mu);
+        _buffers[index] = {buffer, offset, range};
+        _version++;
+    }
+    // NONE when the table is full
+    uint32_t addTexture(VkImageView view, VkSampler sampler,
+                        VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+        uint32_t i = take(_freeTextures);
+        if (i == NONE) Log::err("Bindless: out of texture entries");
+        else setTexture(i, view, sampler, layout);
+        return i;
+    }
+    uint32_t addBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE) {
+        uint32_t i = take(_freeBuffers);
+        if (i == NONE) Log::err("Bindless: out of buffer entries");
+        else setBuffer(i, buffer, offset, range);
+        return i;
+    }
+    // Empties the entry and returns it to addTexture/addBuffer
+    void releaseTexture(uint32_t index) {
+        if (index == NONE) return;
+        std::lock_guard lk(_mu);
+        _textures[index] = {};
+        _freeTextures.push_back(index);
+        _version++;
+    }
+    void releaseBuffer(uint32_t index) {
+        if (index == NONE) return;
+        std::lock_guard lk(_mu);
+        _buffers[index] = {};
+        _freeBuffers.push_back(index);
+        _version++;
+    }
+
+    // ── Per frame ─────────────────────────────────────────────────────────
+
+    // Writes the changes since frame's set was last brought up to date;
+    // frame's command buffers must be done with
+    void update(uint32_t frame) {
+        std::lock_guard lk(_mu);
+        if (_applied[frame] == _version) return;
+        _applied[frame] = _version;
+
+        auto fill = [](auto& out, const auto& in, auto filled) {
+            auto first = std::find_if(in.begin(), in.end(), filled);
+            if (first == in.end()) return false;
+            out = in;
+            for (auto& e : out)
+                if (!filled(e)) e = *first;
+            return true;
+        };
+        auto hasView   = [](const VkDescriptorImageInfo& e) { return e.imageView != VK_NULL_HANDLE; };
+        auto hasBuffer = [](const VkDescriptorBufferInfo& e) { return e.buffer != VK_NULL_HANDLE; };
+        VkWriteDescriptorSet w[2]{};
+        uint32_t             n = 0;
+        if (fill(_imageWrites, _textures, hasView)) {
+            w[n].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            w[n].dstSet          = _sets[frame];
+            w[n].dstBinding      = 0;
+            w[n].descriptorCount = MAX_TEXTURES;
+            w[n].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            w[n].pImageInfo      = _imageWrites.data();
+            n++;
+        }
+        if (fill(_bufferWrites, _buffers, hasBuffer)) {
+            w[n].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            w[n].dstSet          = _sets[frame];
+            w[n].dstBinding      = 1;
+            w[n].descriptorCount = MAX_BUFFERS;
+            w[n].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            w[n].pBufferInfo     = _bufferWrites.data();
+            n++;
+        }
+        if (n) vkUpdateDescriptorSets(_dev, n, w, 0, nullptr);
+    }
+
+    VkDescriptorSetLayout layout() const { return _layout; }
+    VkDescriptorSet       set(uint32_t frame) const { return _sets[frame]; }
+
+private:
+    uint32_t take(std::vector<uint32_t>& free) {
+        std::lock_guard lk(_mu);
+        if (free.empty()) return NONE;
+        uint32_t i = free.back();
+        free.pop_back();
+        return i;
+    }
+
+    VkDevice              _dev    = VK_NULL_HANDLE;
+    VkDescriptorSetLayout _layout = VK_NULL_HANDLE;
+    VkDescriptorPool      _pool   = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> _sets;    // per frame
+    std::vector<uint64_t>        _applied; // _version each set was last written at
+
+    std::mutex                          _mu;
+    uint64_t                            _version = 0;
+    std::vector<VkDescriptorImageInfo>  _textures;
+    std::vector<VkDescriptorBufferInfo> _buffers;
+    std::vector<uint32_t>               _freeTextures, _freeBuffers;
+    std::vector<VkDescriptorImageInfo>  _imageWrites; // update()'s scratch
+    std::vector<VkDescriptorBufferInfo> _bufferWrites;
+};
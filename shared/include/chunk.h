@@ -1,21 +1,35 @@
 #pragma once
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
 #include <vector>
 #include <glm/vec3.hpp>
 #include <glm/vec2.hpp>
+#include "config.h"
 
-// Material IDs — match atlas column order (each = 0.25 of atlas width)
+// Material IDs — match atlas column order (each = 0.25 of atlas width);
+// the client cuts the columns into one texture-array layer per material
 enum class BlockMat : uint8_t {
     Stone = 0,
     Dirt  = 1,
     Grass = 2,
     Sand  = 3,
+    Coal  = 4, // ores, placed by Features::decorateSlab
+    Iron  = 5,
 };
+inline constexpr uint32_t BLOCK_MAT_COUNT = 6;
+// The materials with a tile in the atlas's top row; the ones past them
+// (the ores, so far) are textured as stone until they get one
+inline constexpr uint32_t ATLAS_MAT_COUNT = 4;
 
 struct Vertex {
     glm::vec3 pos;
     glm::vec3 normal;
     glm::vec2 uv;
-    uint32_t  material; // 0=stone, 1=dirt, 2=grass, 3=sand
+    uint32_t  material; // BlockMat
+    uint8_t   occlusion = 0; // ambient, 0 open to 255 shut; see MarchOptions::occlusion
 };
 
 struct ChunkCoord {
@@ -23,27 +37,107 @@ struct ChunkCoord {
     bool operator==(const ChunkCoord&) const = default;
 };
 
+// Which of a chunk's six faces (0..5: -x +x -y +y -z +z; f ^ 1 is the
+// opposite face) can see each other through open space inside it: bit
+// faceLinkBit(a, b) for each of the 15 pairs. Clients walk these outwards
+// from the camera's chunk to skip chunks that can't be in view (caves from
+// the surface, the surface from a cave).
+inline constexpr uint16_t FACE_LINKS_ALL = 0x7FFF;
+inline constexpr int faceLinkBit(int a, int b) {
+    int lo = a < b ? a : b, hi = a < b ? b : a;
+    return lo * (11 - lo) / 2 + hi - lo - 1;
+}
+
+// A run of a mesh's triangles culled as one — see buildMeshlets
+struct Meshlet {
+    glm::vec3 boundsMin{0.f}, boundsMax{0.f}; // mesh units
+    glm::vec3 coneAxis{0.f};   // average facing
+    float     coneCutoff = 2.f; // sin of the cone's half-angle; above 1 for no cone
+    uint32_t  firstIndex = 0;   // into the mesh's indices
+    uint32_t  indexCount = 0;
+};
+
 struct ChunkMesh {
     ChunkCoord coord;
     std::vector<Vertex>   vertices;
     std::vector<uint32_t> indices;
+    std::vector<Meshlet>  meshlets; // client-side only, never sent
+    uint8_t    lod = 0; // level of detail — see ChunkKey
+    uint16_t   faceLinks = FACE_LINKS_ALL; // unknown counts as open
 };
 
-#include <functional>
+// Chunk hashes: the coord packed 21 bits an axis, then run through
+// splitmix64's finaliser, so every output bit depends on every axis and
+// neighbouring chunks land in unrelated slots — FlatMap takes the low bits
+// as they are. (std::hash<int> is the identity, and xor-combining it left
+// rows of chunks in runs of adjacent buckets.)
+inline uint64_t mixHash(uint64_t x) {
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27; x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+inline uint64_t packCoord(const ChunkCoord& c) {
+    auto axis = [](int v) { return (uint64_t)(uint32_t)v & 0x1FFFFF; };
+    return axis(c.x) << 42 | axis(c.y) << 21 | axis(c.z);
+}
+
 struct ChunkCoordHash {
-    size_t operator()(const ChunkCoord& c) const {
-        size_t h = 0;
-        h ^= std::hash<int>{}(c.x) + 0x9e3779b9 + (h<<6) + (h>>2);
-        h ^= std::hash<int>{}(c.y) + 0x9e3779b9 + (h<<6) + (h>>2);
-        h ^= std::hash<int>{}(c.z) + 0x9e3779b9 + (h<<6) + (h>>2);
-        return h;
+    size_t operator()(const ChunkCoord& c) const { return (size_t)mixHash(packCoord(c)); }
+};
+
+// A chunk at a level of detail. Level 0 is the full-resolution chunk at
+// coord; level L covers 2^L x 2^L x 2^L chunks starting at coord << L, with
+// the same PADDED^3 samples spaced 2^L blocks apart, so its mesh is in cells
+// of 2^L blocks.
+struct ChunkKey {
+    ChunkCoord coord;
+    int        lod = 0;
+    bool operator==(const ChunkKey&) const = default;
+};
+
+struct ChunkKeyHash {
+    size_t operator()(const ChunkKey& k) const {
+        return (size_t)mixHash(packCoord(k.coord) + (uint64_t)k.lod * 0x9e3779b97f4a7c15ull);
     }
 };
 
 struct ChunkData {
+    // Uniform chunks have no surface anywhere in them — marchChunk skips them
+    // and the network sends a ChunkUniform marker instead of a field/mesh.
+    enum class Fill : uint8_t { Mixed = 0, Air = 1, Solid = 2 };
+
+    // Density in fixed point, DENSITY_SCALE steps per unit, saturating at
+    // the generator's ±DENSITY_MAX clamp. The sign is kept exact (anything
+    // negative stays <= -1), so classifying corners against 0 is the same as
+    // on the float. Comparisons and ratios work on the raw values; only
+    // absolute densities need dequantize.
+    using Density = std::conditional_t<Config::CHUNK_DENSITY_BITS == 16, int16_t, int8_t>;
+    static constexpr float DENSITY_MAX   = 2.f;
+    static constexpr float DENSITY_SCALE = (float)std::numeric_limits<Density>::max() / DENSITY_MAX;
+
+    struct Voxel {
+        Density density;  // < 0 is inside the surface
+        uint8_t material; // BlockMat
+    };
+
     ChunkCoord coord;
-    static constexpr int SIZE   = 32;
+    Fill       fill = Fill::Mixed;
+    static constexpr int SIZE   = Config::CHUNK_SIZE;
     static constexpr int PADDED = SIZE + 1;
-    float   values   [PADDED][PADDED][PADDED];
-    uint8_t materials[PADDED][PADDED][PADDED]; // BlockMat per voxel
+    // [x][z][y]: y innermost, so a column is contiguous — generation fills
+    // columns, and the mesher walks y and gathers corners in y pairs
+    Voxel voxels[PADDED][PADDED][PADDED];
+
+    Voxel&       at(int x, int y, int z)       { return voxels[x][z][y]; }
+    const Voxel& at(int x, int y, int z) const { return voxels[x][z][y]; }
+
+    static Density quantize(float v) {
+        constexpr float M = (float)std::numeric_limits<Density>::max();
+        float q = std::round(v * DENSITY_SCALE);
+        if (q >  M) q =  M;
+        if (q < -M) q = -M;
+        if (v < 0.f && q > -1.f) q = -1.f;
+        return (Density)q;
+    }
+    static float dequantize(Density q) { return (float)q / DENSITY_SCALE; }
 };
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ── Chunk payload compression ─────────────────────────────────────────────────
+// Chunk payloads are already quantized (ChunkData v2, ChunkField's int8 RLE),
+// but neighbouring chunks still share most of their bytes: headers, the runs
+// of air and stone, material bytes, the same vertex patterns over and over.
+// A dictionary trained on this generator's chunks hands all of that to the
+// compressor up front, which a payload of a few KB is too short to learn.
+//
+//   Zstd  the default when compression is on; level CHUNK_ZSTD_LEVEL
+//   Lz4   for a server short of CPU — faster both ways, compresses less;
+//         uses the dictionary's last 64 KB as raw history
+//
+// Each codec is in the build only if meson found its library (available()).
+// The server trains one dictionary per world (ChunkManager::useCompression),
+// sends it in a ChunkDict to clients whose AuthRequest caps name the codec,
+// and packs every payload once, as it enters the chunk cache; MeshBuilder
+// workers unpack. Everything persisted — region files, the shared cache,
+// the client's disk cache — holds the raw payload.
+enum class ChunkCodec : uint8_t { None = 0, Zstd = 1, Lz4 = 2 };
+
+namespace ChunkCodecs {
+    bool        available(ChunkCodec c);
+    // The CAP_CHUNK_* bit naming c; 0 for None
+    uint32_t    cap(ChunkCodec c);
+    // The CAP_CHUNK_* bits of the codecs in this build
+    uint32_t    caps();
+    // "zstd", "lz4"; None for anything else
+    ChunkCodec  parse(const std::string& name);
+    const char* name(ChunkCodec c);
+}
+
+class ChunkDict {
+public:
+    // Trained on samples (whole payloads), at most maxBytes. Without zstd
+    // in the build, an LZ4 dictionary is the samples' tails strung
+    // together. nullptr if the codec isn't available or training fails.
+    static std::shared_ptr<const ChunkDict> train(ChunkCodec codec,
+                                                  const std::vector<std::vector<uint8_t>>& samples,
+                                                  size_t maxBytes);
+    // From bytes train() made, saved or sent in a ChunkDict; nullptr if the
+    // codec isn't available
+    static std::shared_ptr<const ChunkDict> load(ChunkCodec codec, std::vector<uint8_t> bytes);
+
+    ~ChunkDict();
+
+    ChunkCodec                  codec() const { return _codec; }
+    uint32_t                    id()    const { return _id; }
+    const std::vector<uint8_t>& bytes() const { return _bytes; }
+
+    // The payload as a ChunkPacked packet; empty if that wouldn't be
+    // smaller. Any thread.
+    std::vector<uint8_t> pack(const uint8_t* d, size_t len) const;
+
+    // A ChunkPacked packet's payload, into out; false if it's malformed or
+    // was packed with another dictionary. Any thread.
+    bool unpack(const uint8_t* d, size_t len, std::vector<uint8_t>& out) const;
+
+private:
+    ChunkDict() = default;
+
+    ChunkCodec           _codec = ChunkCodec::None;
+    uint32_t             _id    = 0;
+    std::vector<uint8_t> _bytes;
+    void*                _cdict = nullptr; // zstd's digested forms, shared by every thread
+    void*                _ddict = nullptr;
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "packets.h"
+
+// ── Chunk generation service packets ──────────────────────────────────────────
+// What a game server and the standalone chunkgen service say to each other.
+// The server sends the chunks it's missing in batches; the service answers
+// each one on its own, as it's done, from whichever of its workers or its
+// cache gets there first. Nothing here ever reaches a client.
+
+enum class ChunkGenPacketID : uint8_t {
+    ChunkGenHello   = 0x60, // both ways: the world id each side generates for
+    ChunkGenRequest = 0x61, // server -> service: chunks to generate
+    ChunkGenResult  = 0x62, // service -> server: one chunk's payloads
+};
+
+// First from the server, echoed back with the service's own id. A service
+// generating another world (seed or payload format) is never asked.
+//   u8 id | u32 world
+struct ChunkGenHelloPacket {
+    uint32_t world = 0;
+
+    void write(PacketWriter& w) const { w.begin((uint8_t)ChunkGenPacketID::ChunkGenHello, 5).u32(world); }
+
+    static bool deserialize(const uint8_t* d, size_t len, ChunkGenHelloPacket& out) {
+        PacketReader r(d, len);
+        out.world = r.u32();
+        return r.ok();
+    }
+};
+
+// mesh: the server has a subscriber that can't march the field itself.
+// LOD cells are only ever meshes, so it's implied for them.
+//   u8 id | u16 n | n × { i32 x,y,z | u8 lod | u8 mesh }
+struct ChunkGenRequestPacket {
+    struct Entry {
+        ChunkKey key;
+        bool     mesh = false;
+    };
+    std::vector<Entry> entries;
+
+    static constexpr size_t MAX_ENTRIES = 512;
+
+    void write(PacketWriter& w) const {
+        w.begin((uint8_t)ChunkGenPacketID::ChunkGenRequest, 3 + entries.size() * 14);
+        w.u16((uint16_t)entries.size());
+        for (const Entry& e : entries)
+            w.i32(e.key.coord.x).i32(e.key.coord.y).i32(e.key.coord.z)
+             .u8((uint8_t)e.key.lod).u8(e.mesh ? 1 : 0);
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, ChunkGenRequestPacket& out) {
+        PacketReader r(d, len);
+        uint16_t n = r.u16();
+        if (n > MAX_ENTRIES) return false;
+        out.entries.clear();
+        for (uint16_t i = 0; i < n && r.ok(); i++) {
+            Entry e;
+            e.key.coord.x = r.i32(); e.key.coord.y = r.i32(); e.key.coord.z = r.i32();
+            e.key.lod = r.u8();
+            e.mesh    = r.u8() & 1;
+            out.entries.push_back(e);
+        }
+        return r.ok() && out.entries.size() == n;
+    }
+};
+
+// The payloads as they'd go to a client, either one empty: a full-resolution
+// chunk always has its field (a uniform marker stands for both), a LOD cell
+// only its mesh.
+//   u8 id | i32 x,y,z | u8 lod | u32 n | n field bytes | u32 m | m mesh bytes
+struct ChunkGenResultPacket {
+    ChunkKey             key;
+    std::vector<uint8_t> field, mesh;
+
+    static void write(PacketWriter& w, const ChunkKey& key, const uint8_t* field, size_t fieldLen,
+                      const uint8_t* mesh, size_t meshLen) {
+        w.begin((uint8_t)ChunkGenPacketID::ChunkGenResult, 22 + fieldLen + meshLen)
+         .i32(key.coord.x).i32(key.coord.y).i32(key.coord.z).u8((uint8_t)key.lod);
+        w.u32((uint32_t)fieldLen).bytes(field, fieldLen);
+        w.u32((uint32_t)meshLen).bytes(mesh, meshLen);
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, ChunkGenResultPacket& out) {
+        PacketReader r(d, len);
+        out.key.coord.x = r.i32(); out.key.coord.y = r.i32(); out.key.coord.z = r.i32();
+        out.key.lod = r.u8();
+        uint32_t n = r.u32();
+        const uint8_t* f = r.view(n);
+        if (f) out.field.assign(f, f + n);
+        uint32_t m = r.u32();
+        const uint8_t* p = r.view(m);
+        if (p) out.mesh.assign(p, p + m);
+        return r.ok();
+    }
+};
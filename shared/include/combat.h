@@ -58,6 +58,12 @@ struct CAttack {
     bool canAct()     const { return state == State::Idle; }
 };
 
+// Direction the entity last attacked in; places the hitbox when the attack
+// goes active
+struct CFacing {
+    glm::vec3 dir{0.f, 0.f, -1.f};
+};
+
 // Parry window
 struct CParry {
     enum class State { Idle, Active, Cooldown };
@@ -101,6 +107,7 @@ struct CHitThisFrame {
     float     knockback;
     glm::vec3 knockDir;
     bool      fromPlayer; // so enemies don't hit each other (for now)
+    const AttackData* move = nullptr;
 };
 
 // Simple cube enemy (placeholder)
@@ -113,4 +120,11 @@ struct CEnemy {
     float     attackTimer = 0.f;
     float     attackCooldown = 1.5f;
     glm::vec3 knockbackVel{0.f};
-};
\ No newline at end of file
+};
+
+// Client side: an enemy the server simulates. Its state comes from
+// EnemySync, and hits on it are reported rather than applied locally.
+struct CNetEnemy {
+    uint32_t id         = 0;
+    float    sinceHeard = 0.f;
+};
@@ -1,10 +1,388 @@
 #pragma once
+#include <cstddef>
+
+// Set by the build (meson -Dchunk_size=N), for the shaders as well
+#ifndef AETHERIS_CHUNK_SIZE
+  #define AETHERIS_CHUNK_SIZE 32
+#endif
 
 namespace Config {
+    // Cells along a chunk's edge, fixed at build time. Smaller chunks cull
+    // and re-mesh at a finer grain; larger ones mean fewer draws, packets
+    // and map entries. Radii stay in chunks, so they reach further with
+    // larger ones. Code takes it as ChunkData::SIZE.
+    inline constexpr int CHUNK_SIZE = AETHERIS_CHUNK_SIZE;
+    static_assert(CHUNK_SIZE == 16 || CHUNK_SIZE == 32 || CHUNK_SIZE == 64, "chunk_size: 16, 32 or 64");
+
     inline constexpr int CHUNK_RADIUS_XZ = 2;
     inline constexpr int CHUNK_RADIUS_Y  = 1;
 
+    // The client keeps chunks (GPU mesh and collision) one ring past the
+    // send radius and evicts beyond it, so walking along a chunk border
+    // doesn't drop and re-request the same row. With LOD the full-resolution
+    // region is aligned to the level above and reaches 2*((r+1)/2)+1, which
+    // is never less than r+1, so that's the bound.
+    inline constexpr int CHUNK_KEEP_XZ = (CHUNK_RADIUS_XZ + 1) / 2 * 2 + 1;
+    inline constexpr int CHUNK_KEEP_Y  = (CHUNK_RADIUS_Y  + 1) / 2 * 2 + 1;
+
+    // View distance a client can ask for past CHUNK_RADIUS_XZ, in chunks.
+    // Beyond the full-resolution chunks it's served as rings of LOD cells,
+    // each level twice as coarse as the one inside it (see ViewTiers), up to
+    // LOD_LEVELS_MAX levels. LOD meshes hang skirts LOD_SKIRT_CELLS deep to
+    // cover the seams between levels.
+    inline constexpr int   VIEW_RADIUS_MAX = 32;
+    inline constexpr int   LOD_LEVELS_MAX  = 4;
+    inline constexpr float LOD_SKIRT_CELLS = 1.f;
+
+    // Serialized chunk meshes kept in server memory (chunks in view are pinned
+    // and don't count against eviction). Override with --chunk-cache-mb.
+    inline constexpr size_t CHUNK_CACHE_BUDGET_MB = 256;
+
+    // Densities the server keeps decoded for terrain queries (TerrainQuery):
+    // about 35 KB a mixed chunk, so the default holds some 1800 of them.
+    // Rays step by the density over TERRAIN_RAY_LIPSCHITZ, a bound on how
+    // fast it changes per block; terrain steeper than that can be stepped
+    // into by a sliver before the crossing is found. Steps never go below
+    // TERRAIN_RAY_MIN_STEP blocks.
+    inline constexpr size_t DENSITY_CACHE_MB      = 64;
+    inline constexpr float  TERRAIN_RAY_LIPSCHITZ = 2.f;
+    inline constexpr float  TERRAIN_RAY_MIN_STEP  = 0.05f;
+
+    // Generated chunks shared by every server instance of the same world on
+    // one host (see SharedChunkCache); 0 leaves it off. Override with
+    // --shared-cache-mb or shared_cache_mb in settings.cfg.
+    inline constexpr size_t SHARED_CHUNK_CACHE_MB = 0;
+
+    // Bits per stored density sample in ChunkData: 8 (what the wire carries)
+    // or 16
+    inline constexpr int CHUNK_DENSITY_BITS = 8;
+
+    // Surface column grids (2D terrain noise, ~4 KB each) kept for the chunks
+    // stacked above and below, and for spawn height queries
+    inline constexpr size_t SURFACE_COLUMN_CACHE = 2048;
+    // Chunk faces (~4 KB each) generated and waiting for the neighbour on
+    // the other side to copy them rather than sample them again
+    inline constexpr size_t FACE_CACHE = 2048;
+
+    // Region files for generated chunks. Override with --world-dir.
+    inline constexpr const char* WORLD_DIR = "world";
+
+    // Backups of the world directory's stores (WorldBackup), every
+    // BACKUP_INTERVAL_MIN minutes while backup_dir / --backup-dir names
+    // where, the newest BACKUP_KEEP kept. Streamed at up to BACKUP_MB_PER_S
+    // so the live region writes keep the disk.
+    inline constexpr int    BACKUP_INTERVAL_MIN = 60;
+    inline constexpr int    BACKUP_KEEP         = 24;
+    inline constexpr double BACKUP_MB_PER_S     = 64.0;
+
+    // Chunk generation workers: start with MIN, grow toward MAX while the
+    // backlog outruns them (0 → hardware_concurrency-1). Override with
+    // --gen-threads-min / --gen-threads or gen_threads_min / gen_threads in
+    // settings.cfg.
+    inline constexpr int GEN_THREADS_MIN = 1;
+    inline constexpr int GEN_THREADS_MAX = 0;
+
+    // Pages for the server's big buffers (BigPages): "off", "thp" or
+    // "hugetlb" (huge_pages / --huge-pages). NUMA_LOCAL (numa / --numa)
+    // pins each generation worker to a core and keeps its scratch on that
+    // core's node.
+    inline constexpr const char* HUGE_PAGES = "off";
+    inline constexpr bool        NUMA_LOCAL = false;
+
+    // Chunks a player is in or next to (the 3x3x3 the client waits for before
+    // spawning) are generated in x slabs and meshed in z slabs this many ways
+    // across the pool, when it has more than one worker. 1 keeps every chunk
+    // on one task.
+    inline constexpr int GEN_URGENT_SLABS = 4;
+
+    // Pregeneration. Before taking connections the server generates every
+    // column within PREGEN_RADIUS chunks of spawn, PREGEN_DEPTH chunks
+    // either side of the surface. Afterwards, whenever nothing else is
+    // generating, PREGEN_IDLE_BATCH columns at a time go to the pool at
+    // background priority: first the ones up to PREGEN_AHEAD chunks past
+    // the view of each moving player, along their heading, then outward
+    // from spawn up to PREGEN_IDLE_RADIUS. Override with --pregen-radius /
+    // --pregen-idle-radius or pregen_radius / pregen_idle_radius in
+    // settings.cfg; 0 turns either off.
+    inline constexpr int PREGEN_RADIUS      = 8;
+    inline constexpr int PREGEN_DEPTH       = 2;
+    inline constexpr int PREGEN_IDLE_RADIUS = 64;
+    inline constexpr int PREGEN_IDLE_BATCH  = 2;
+    inline constexpr int PREGEN_AHEAD       = 4;
+
+    // Velocity prefetch. Each player's horizontal velocity is smoothed over
+    // PREFETCH_SMOOTH_S of moves; past PREFETCH_MIN_SPEED (m/s) the
+    // full-resolution chunks PREFETCH_AHEAD_S of travel past the view edge,
+    // at least one chunk and at most PREFETCH_DEPTH_MAX deep, are queued
+    // behind everything a player can already see. Turning further than
+    // PREFETCH_TURN_COS (cosine of the angle) calls off the ones no worker
+    // has started. At the default chunk size a walk asks for one chunk
+    // ahead and a sprint (WALK_SPEED * SPRINT_MULT) for two.
+    inline constexpr float PREFETCH_SMOOTH_S  = 0.25f;
+    inline constexpr float PREFETCH_MIN_SPEED = 3.f;
+    inline constexpr float PREFETCH_AHEAD_S   = 4.f;
+    inline constexpr int   PREFETCH_DEPTH_MAX = 4;
+    inline constexpr float PREFETCH_TURN_COS  = 0.9f;
+
+    // Chunk payload compression (see chunk_codec.h), off unless --chunk-codec
+    // zstd|lz4 or chunk_codec in settings.cfg says otherwise. The server
+    // trains its dictionary on CHUNK_DICT_SAMPLES columns' worth of chunks
+    // around spawn the first time, up to CHUNK_DICT_BYTES (LZ4 can only use
+    // the last 64 KB of one), and keeps it in the world directory. Past zstd
+    // level 6 the dictionary leaves little more to find, at several times
+    // the CPU.
+    inline constexpr const char* CHUNK_CODEC        = "none";
+    inline constexpr size_t      CHUNK_DICT_BYTES   = 64 << 10;
+    inline constexpr int         CHUNK_DICT_SAMPLES = 64;
+    inline constexpr int         CHUNK_ZSTD_LEVEL   = 6;
+
+    // How the server meshes terrain (--mesher): "cubes" or "nets"; see
+    // Mesher. A nets server sends fields to no one.
+    inline constexpr const char* TERRAIN_MESHER = "cubes";
+
+    // Terrain edits: the largest brush a player may ask for and how far from
+    // them its centre may be, in blocks. An edited chunk is re-marched only
+    // in the z slabs (of EDIT_REMESH_SLABS) the edit reached; the slab
+    // meshes are kept for the last EDIT_SLAB_CACHE_CHUNKS chunks edited.
+    inline constexpr int    EDIT_RADIUS_MAX        = 8;
+    inline constexpr float  EDIT_REACH             = 8.f;
+    inline constexpr int    EDIT_REMESH_SLABS      = 8;
+    inline constexpr size_t EDIT_SLAB_CACHE_CHUNKS = 64;
+    // Edited chunks kept decoded (ResidentChunk, a few KB each) for the next
+    // edit to start from
+    inline constexpr size_t RESIDENT_CHUNK_MB      = 32;
+
+    // Auth server token checks in flight at once (--auth-concurrency), and
+    // how long a verified token is trusted without asking again. Signed
+    // tokens need neither; their keys are reread from --auth-keys, and
+    // revocations fetched again, every AUTH_KEYS_REFRESH_S.
+    inline constexpr int AUTH_CONCURRENCY    = 4;
+    inline constexpr int AUTH_CACHE_TTL_S    = 60;
+    inline constexpr int AUTH_KEYS_REFRESH_S = 60;
+
+    // Login admission (AdmissionQueue). Verified logins enter the world at
+    // up to ADMIT_PER_S a second, bursting to ADMIT_BURST, and only while
+    // the main loop is busy less than ADMIT_MAX_LOAD of the time and fewer
+    // than ADMIT_GEN_BACKLOG chunk jobs wait on the generation pool; even
+    // then one gets in every ADMIT_STALL_MS. Waiting clients hear their
+    // place at most every ADMIT_NOTIFY_MS. --admit-per-s or admit_per_s in
+    // settings.cfg; 0 lets every login straight in.
+    inline constexpr double ADMIT_PER_S       = 5.0;
+    inline constexpr int    ADMIT_BURST       = 4;
+    inline constexpr double ADMIT_MAX_LOAD    = 0.5;
+    inline constexpr int    ADMIT_GEN_BACKLOG = 512;
+    inline constexpr int    ADMIT_STALL_MS    = 5000;
+    inline constexpr int    ADMIT_NOTIFY_MS   = 1000;
+    // Saves read at once for logins on their way in (SessionLoader), so
+    // one slow read doesn't hold up the rest
+    inline constexpr int    SESSION_LOAD_WORKERS = 4;
+
+    // Server tick slots. The simulation loop sleeps until the next one is
+    // due or a network event arrives; CHUNK_FLUSH_MS bounds that wait while
+    // chunks are being generated or logins verified, so results don't sit
+    // until the next slot.
+    inline constexpr double SERVER_TICK_HZ   = 30.0;
+    inline constexpr double POS_BROADCAST_HZ = 20.0;
+    inline constexpr double STATS_FLUSH_HZ   = 10.0;
+    inline constexpr int    CHUNK_FLUSH_MS   = 2;
+
+    // Position broadcasts only carry what moved: a player counts as moved
+    // past POS_SEND_EPS metres or POS_SEND_ROT_DEG of yaw or pitch from what
+    // the receiver was last sent. A receiver with nothing new hears nothing,
+    // but at least every POS_HEARTBEAT_S (a third of REMOTE_STALE_S, so an
+    // idle player stays shown through a lost heartbeat, late by up to an
+    // interval) and a full exact state every POS_KEYFRAME_S.
+    // Its rate drops from POS_BROADCAST_HZ by another base interval per
+    // POS_RATE_RTT_MS of RTT and per POS_RATE_LOSS of packet loss, to no
+    // slower than POS_INTERVAL_MAX_S.
+    inline constexpr float  POS_SEND_EPS       = 0.01f;
+    inline constexpr float  POS_SEND_ROT_DEG   = 0.5f;
+    inline constexpr double POS_HEARTBEAT_S    = 0.5;
+    inline constexpr double POS_KEYFRAME_S     = 5.0;
+    inline constexpr double POS_RATE_RTT_MS    = 250.0;
+    inline constexpr double POS_RATE_LOSS      = 0.05;
+    inline constexpr double POS_INTERVAL_MAX_S = 0.2;
+
+    // Server coroutines (AsyncLoop) resumed per main-loop iteration at most;
+    // a burst of auth verdicts or loaded saves past this waits a tick.
+    inline constexpr size_t ASYNC_RESUME_BUDGET = 64;
+
+    // Iterations of the server loop longer than SLOW_TICK_MS have their
+    // breakdown written under SLOW_TICK_DIR (TickWatchdog). Override with
+    // slow_tick_ms / slow_tick_dir or --slow-tick-ms / --slow-tick-dir;
+    // 0 ms turns it off.
+    inline constexpr double      SLOW_TICK_MS  = 100.0;
+    inline constexpr const char* SLOW_TICK_DIR = "slow_ticks";
+
+    // Default per-peer send budget for the server's Outbox (--peer-kbps).
+    // Movement never waits on it; gameplay and chunk streaming do, in that
+    // order.
+    inline constexpr size_t PEER_SEND_BYTES_PER_S = 1u << 20;
+
+    // Client chunk streaming. At most UPLOAD_BUDGET_BYTES of meshes are
+    // staged for the GPU per frame, nearest the player first; the rest wait.
+    // Meshes taken from the builder per frame adapt to frame time between
+    // MESH_POLL_MIN and MESH_POLL_MAX, aiming at FRAME_TARGET_MS.
+    inline constexpr size_t UPLOAD_BUDGET_BYTES = 8u << 20;
+    inline constexpr float  FRAME_TARGET_MS     = 16.7f;
+    inline constexpr int    MESH_POLL_MIN       = 1;
+    inline constexpr int    MESH_POLL_MAX       = 32;
+
+    // Client mega-buffer compaction: runs on frames with time to spare once
+    // either buffer's free space is more than MEGA_COMPACT_FRAGMENTATION
+    // outside its largest block, moving up to MEGA_COMPACT_BYTES per frame
+    inline constexpr float  MEGA_COMPACT_FRAGMENTATION = 0.25f;
+    inline constexpr size_t MEGA_COMPACT_BYTES         = 2u << 20;
+
+    // Far terrain past the streamed chunks: FAR_LEVELS nested square grids
+    // of FAR_GRID quads over the 2D heightfield, level l spaced
+    // FAR_SPACING << l blocks apart, drawn from FAR_NEAR to FAR_FAR
+    inline constexpr int   FAR_LEVELS  = 5;
+    inline constexpr int   FAR_GRID    = 64;
+    inline constexpr int   FAR_SPACING = 16;
+    inline constexpr float FAR_NEAR    = 8.f;
+    inline constexpr float FAR_FAR     = 12000.f;
+
+    // Sun shadows: SHADOW_CASCADES square cascades around the player, the
+    // first SHADOW_NEAR_EXTENT blocks from centre to edge, each next one
+    // four times that. Terrain is drawn into SHADOW_MAP_SIZE maps and kept
+    // until the sun turns SHADOW_SUN_DEGREES, the player crosses a quarter
+    // of the cascade, or a chunk in it changes; players go into
+    // SHADOW_DYNAMIC_SIZE maps every frame. SHADOW_DEPTH_PAD blocks of
+    // sunward space are kept in front of each cascade for casters above it.
+    inline constexpr int   SHADOW_CASCADES     = 3;
+    inline constexpr int   SHADOW_MAP_SIZE     = 2048;
+    inline constexpr int   SHADOW_DYNAMIC_SIZE = 1024;
+    inline constexpr float SHADOW_NEAR_EXTENT  = 64.f;
+    inline constexpr float SHADOW_SUN_DEGREES  = 0.5f;
+    inline constexpr float SHADOW_DEPTH_PAD    = 512.f;
+
+    // Dynamic resolution (optional): the 3D scene is drawn at between
+    // DYNRES_MIN_SCALE and 1 of the window per axis, steered so the GPU's
+    // frame takes DYNRES_BUDGET of FRAME_TARGET_MS, and stretched to fit
+    inline constexpr float DYNRES_MIN_SCALE = 0.5f;
+    inline constexpr float DYNRES_BUDGET    = 0.85f;
+
+    // Foliage, scattered on the client over the terrain it already has
+    // (foliage.comp): within FOLIAGE_REACH blocks of the eye, thinning out
+    // from a quarter of that; densities are plants per square block of
+    // level ground at the eye.
+    inline constexpr float FOLIAGE_REACH         = 64.f;
+    inline constexpr float FOLIAGE_GRASS_DENSITY = 2.5f;
+    inline constexpr float FOLIAGE_ROCK_DENSITY  = 0.04f;
+
+    // Most threads, besides the main one, recording a frame's parallel
+    // passes into secondary command buffers; the pool grows toward it while
+    // the records outnumber its workers (0 → hardware_concurrency-1)
+    inline constexpr int RENDER_RECORD_THREADS = 0;
+
+    // Video memory pressure (MemoryBudget): the view radius the client asks
+    // for is cut back toward MEMORY_MIN_RADIUS chunks while the device-local
+    // heaps or the chunk pools are nearly full
+    inline constexpr int MEMORY_MIN_RADIUS = 2;
+
+    // Memory accounting (MemTags::Watch): live bytes per subsystem are
+    // snapshotted every MEM_SNAPSHOT_S; one that grew at each of the last
+    // MEM_LEAK_SAMPLES, by MEM_LEAK_MIN_BYTES in all, is reported as a
+    // likely leak
+    inline constexpr double  MEM_SNAPSHOT_S     = 60.0;
+    inline constexpr int     MEM_LEAK_SAMPLES   = 10;
+    inline constexpr size_t  MEM_LEAK_MIN_BYTES = 16u << 20;
+
+    // Client simulation (SimThread): movement, combat, stats and the day
+    // tick at CLIENT_SIM_HZ on a thread of their own. Ticks more than
+    // SIM_MAX_STEPS behind are dropped rather than run back to back.
+    inline constexpr double CLIENT_SIM_HZ = 60.0;
+    inline constexpr int    SIM_MAX_STEPS = 5;
+
+    // Terrain shading: false keeps the faceted look (per-face normals)
+    inline constexpr bool SMOOTH_TERRAIN_NORMALS = false;
+
     inline constexpr int   SERVER_PORT    = 7777;
+    inline constexpr int   MAX_PEERS      = 256;
+
+    // Network threads on the server, each with its own ENet host on
+    // SERVER_PORT (SO_REUSEPORT; see ServerNet). One host tops out at what
+    // one thread can service; raise with net_threads / --net-threads.
+    inline constexpr int   NET_THREADS    = 1;
+
+    // Prometheus scrape endpoint (GET /metrics, plain HTTP) on the server;
+    // loopback only unless told otherwise, port 0 turns it off
+    inline constexpr int         METRICS_PORT = 9100;
+    inline constexpr const char* METRICS_BIND = "127.0.0.1";
+
+    // Position broadcast interest, in chunk columns around the listener:
+    // full rate inside NEAR, every FAR_EVERY-th broadcast out to FAR
+    inline constexpr int   INTEREST_NEAR_CHUNKS = CHUNK_RADIUS_XZ;
+    inline constexpr int   INTEREST_FAR_CHUNKS  = CHUNK_RADIUS_XZ * 2;
+    inline constexpr int   INTEREST_FAR_EVERY   = 4;
+
+    // Component replication (ReplicationServer): REPL_HZ flushes a second,
+    // each sending a client at most REPL_BYTES_PER_FLUSH of records, out to
+    // INTEREST_FAR_CHUNKS. What doesn't fit goes next time, ahead of
+    // entities that have waited less.
+    inline constexpr double REPL_HZ              = 20.0;
+    inline constexpr size_t REPL_BYTES_PER_FLUSH = 1024;
+
+    // World sharding (--shards, see ShardMap). A player within
+    // SHARD_BORDER_CHUNKS of another shard's area is shown there too; one
+    // SHARD_HANDOFF_M into it is handed over. A handoff ticket lapses if
+    // no one logs in with it in SHARD_TICKET_TTL_S; a login that beats its
+    // ticket there waits SHARD_ARRIVAL_WAIT_MS for it. A link to another
+    // shard that's down is retried every SHARD_RECONNECT_MS.
+    inline constexpr int   SHARD_BORDER_CHUNKS   = INTEREST_FAR_CHUNKS;
+    inline constexpr float SHARD_HANDOFF_M       = 4.f;
+    inline constexpr int   SHARD_TICKET_TTL_S    = 30;
+    inline constexpr int   SHARD_ARRIVAL_WAIT_MS = 2000;
+    inline constexpr int   SHARD_RECONNECT_MS    = 2000;
+
+    // Standalone chunk generation service (chunkgen; a game server uses it
+    // with --chunkgen host:port). It keeps CHUNKGEN_CACHE_MB of finished
+    // chunks for every server it serves. A server hands it at most
+    // CHUNKGEN_OUTSTANDING_MAX chunks at a time and generates the rest
+    // itself, as it does everything while the link is down; a link that's
+    // down is retried every CHUNKGEN_RECONNECT_MS.
+    inline constexpr int    CHUNKGEN_PORT            = 7790;
+    inline constexpr size_t CHUNKGEN_CACHE_MB        = 1024;
+    inline constexpr size_t CHUNKGEN_OUTSTANDING_MAX = 1024;
+    inline constexpr int    CHUNKGEN_RECONNECT_MS    = 2000;
+    inline constexpr int    CHUNKGEN_MAX_PEERS       = 64;
+
+    // Server enemy simulation. Enemies within ENEMY_LOD_NEAR of a player
+    // step every tick; out to ENEMY_LOD_FAR every ENEMY_LOD_MID_EVERY ticks,
+    // beyond that every ENEMY_LOD_FAR_EVERY. Full-rate enemies always run;
+    // coarse ones stop for the tick once ENEMY_TICK_BUDGET_MS is spent and
+    // go first next time.
+    inline constexpr double ENEMY_TICK_HZ        = 20.0;
+    inline constexpr double ENEMY_BROADCAST_HZ   = 10.0;
+    inline constexpr float  ENEMY_LOD_NEAR       = 32.f;
+    inline constexpr float  ENEMY_LOD_FAR        = 96.f;
+    inline constexpr int    ENEMY_LOD_MID_EVERY  = 4;
+    inline constexpr int    ENEMY_LOD_FAR_EVERY  = 16;
+    inline constexpr float  ENEMY_TICK_BUDGET_MS = 2.f;
+    inline constexpr float  ENEMY_RESPAWN_S      = 30.f;
+
+    // Parallel simulation (SimRegions). Players within SIM_ISLAND_LINK of
+    // one another, transitively, form an island, and an enemy steps against
+    // its nearest player's island alone; SIM_REGION_ENEMIES of an island's
+    // enemies make a region, and regions run across SIM_THREADS helpers
+    // besides the main thread (sim_threads / --sim-threads; 0: inline).
+    // The link has to outreach two enemy swings, so nothing one steps can
+    // touch a player off its island.
+    inline constexpr float  SIM_ISLAND_LINK      = 8.f;
+    inline constexpr int    SIM_REGION_ENEMIES   = 128;
+    inline constexpr int    SIM_THREADS          = 2;
+
+    // Client hides a remote player it hasn't heard about for this long
+    inline constexpr float REMOTE_STALE_S = 1.5f;
+    static_assert(2 * POS_HEARTBEAT_S + POS_INTERVAL_MAX_S < REMOTE_STALE_S,
+                  "one lost heartbeat mustn't hide an idle player");
+    // Remote players are drawn this far behind the newest snapshot: the
+    // broadcast interval plus arrival jitter, adapted, within these bounds.
+    // Past the newest one they're extrapolated for at most REMOTE_EXTRAP_S.
+    inline constexpr float REMOTE_DELAY_MIN_S = 0.05f;
+    inline constexpr float REMOTE_DELAY_MAX_S = 0.4f;
+    inline constexpr float REMOTE_EXTRAP_S    = 0.25f;
     inline constexpr int   WORLD_SEED    = 1273;
     inline constexpr float PLAYER_WIDTH   = 0.6f;
     inline constexpr float PLAYER_HEIGHT  = 1.8f;
@@ -25,6 +403,18 @@ namespace Config {
     // Air steering: very low, Skyrim has almost no air control
     inline constexpr float AIR_ACCEL     = 1.8f;
 
+    // Server-side move check for predicting clients (CAP_MOVE_PREDICT): a
+    // player earns MOVE_CHECK_SPEED metres of travel a second, horizontal or
+    // up (falling is free), banked up to MOVE_CHECK_BURST_S worth so jitter
+    // and bunched packets pass. A move past the bank is refused with a
+    // MoveCorrection, resent every MOVE_CORRECT_RESEND_MS while moves from
+    // before it keep arriving. Clients keep PREDICT_HISTORY inputs to replay
+    // — about a second at 240 fps, several round trips at 150 ms.
+    inline constexpr float  MOVE_CHECK_SPEED       = 15.f; // a dodge roll is 12
+    inline constexpr float  MOVE_CHECK_BURST_S     = 1.f;
+    inline constexpr int    MOVE_CORRECT_RESEND_MS = 300;
+    inline constexpr size_t PREDICT_HISTORY        = 256;
+
     inline float MOUSE_SENS     = 0.1f;
     inline constexpr float DAY_LENGTH_SECONDS = 1200.f;
 }
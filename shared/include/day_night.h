@@ -17,9 +17,10 @@ struct DayNight {
         return s < 0.f ? 0.f : s;
     }
 
-    // Sun direction for lighting (world space)
+    // Towards the sun (world space): on the horizon at dawn and dusk,
+    // highest at noon, in phase with sunIntensity
     glm::vec3 sunDir() const {
-        float angle = time * 6.2831853f;
+        float angle = time * 6.2831853f - 1.5707963f;
         return glm::normalize(glm::vec3{std::cos(angle), std::sin(angle), 0.3f});
     }
 
@@ -0,0 +1,280 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// ── FlatMap / FlatSet ─────────────────────────────────────────────────────────
+// Open-addressing hash tables for keys whose hash is good in the low bits
+// (ChunkCoordHash and ChunkKeyHash mix theirs). Entries sit in one array in
+// Robin Hood order — an entry further from its home slot takes the place of
+// one nearer its own — so every probe stays short and a lookup reads a few
+// adjacent slots instead of chasing a node per entry. Erase shifts the run
+// after it back a slot rather than leave a tombstone. Nothing wraps around:
+// the array has probeMax spare slots past the last home, and an insert
+// that would probe past them grows the table instead.
+//
+// Unlike std::unordered_map, any insert or erase moves entries: references
+// and iterators don't survive one, apart from what erase(it) returns, which
+// carries a walk on with each entry still visited once. The key in an entry
+// is not const, and must not be changed.
+template<class Traits, class Hash, class Eq>
+class FlatTable {
+    using K = typename Traits::Key;
+    using E = typename Traits::Entry;
+
+public:
+    using key_type   = K;
+    using value_type = E;
+
+    template<bool Const>
+    class Iter {
+    public:
+        using Ref = std::conditional_t<Const, const E&, E&>;
+        using Ptr = std::conditional_t<Const, const E*, E*>;
+
+        Iter() = default;
+        template<bool C = Const>
+            requires C
+        Iter(const Iter<false>& o) : _e(o._e), _d(o._d) {}
+
+        Ref   operator*() const { return *_e; }
+        Ptr   operator->() const { return _e; }
+        Iter& operator++() {
+            do { ++_e; ++_d; } while (*_d < 0);
+            return *this;
+        }
+        bool operator==(const Iter& o) const { return _e == o._e; }
+
+    private:
+        friend class FlatTable;
+        friend class Iter<!Const>;
+        Iter(E* e, const int8_t* d) : _e(e), _d(d) {}
+        E*            _e = nullptr;
+        const int8_t* _d = nullptr;
+    };
+    using iterator       = Iter<false>;
+    using const_iterator = Iter<true>;
+
+    FlatTable() = default;
+    FlatTable(const FlatTable& o) {
+        reserve(o._size);
+        for (const E& e : o) place(E(e));
+    }
+    FlatTable(FlatTable&& o) noexcept { swap(o); }
+    FlatTable& operator=(FlatTable o) noexcept {
+        swap(o);
+        return *this;
+    }
+    ~FlatTable() { release(); }
+
+    void swap(FlatTable& o) noexcept {
+        std::swap(_slots, o._slots);
+        std::swap(_dist, o._dist);
+        std::swap(_homes, o._homes);
+        std::swap(_probeMax, o._probeMax);
+        std::swap(_size, o._size);
+    }
+
+    // ── Lookup ────────────────────────────────────────────────────────────
+    iterator find(const K& key) {
+        size_t i = slotOf(key);
+        return i == NONE ? end() : iterator{_slots + i, _dist + i};
+    }
+    const_iterator find(const K& key) const { return const_cast<FlatTable*>(this)->find(key); }
+    bool   contains(const K& key) const { return slotOf(key) != NONE; }
+    size_t count(const K& key) const { return contains(key) ? 1 : 0; }
+
+    size_t size() const { return _size; }
+    bool   empty() const { return _size == 0; }
+
+    // ── Iteration ─────────────────────────────────────────────────────────
+    iterator       begin() { return fromSlot(0); }
+    iterator       end() { return _dist ? iterator{_slots + slotCount(), _dist + slotCount()} : iterator{}; }
+    const_iterator begin() const { return const_cast<FlatTable*>(this)->begin(); }
+    const_iterator end() const { return const_cast<FlatTable*>(this)->end(); }
+
+    // Slots [a, b) for splitting a walk: the entries from fromSlot(a) up to
+    // fromSlot(b), over every a < b up to slotCount(), are each seen once
+    size_t   slotCount() const { return _dist ? _homes + _probeMax : 0; }
+    iterator fromSlot(size_t i) {
+        if (!_dist) return {};
+        i = std::min(i, slotCount());
+        while (_dist[i] < 0) i++;
+        return {_slots + i, _dist + i};
+    }
+    const_iterator fromSlot(size_t i) const { return const_cast<FlatTable*>(this)->fromSlot(i); }
+
+    // ── Changes ───────────────────────────────────────────────────────────
+    // The entry made from key and args, unless key is already in
+    template<class... A>
+    std::pair<iterator, bool> try_emplace(const K& key, A&&... args) {
+        if (iterator it = find(key); it != end()) return {it, false};
+        if (!_dist || (_size + 1) * LOAD_DEN > _homes * LOAD_NUM) rehash(_homes ? _homes * 2 : HOMES_MIN);
+        size_t i = place(Traits::make(key, std::forward<A>(args)...));
+        return {i == NONE ? find(key) : iterator{_slots + i, _dist + i}, true};
+    }
+
+    iterator erase(const_iterator it) {
+        size_t at = (size_t)(it._e - _slots);
+        size_t i  = at;
+        for (; _dist[i + 1] > 0; i++) {
+            _slots[i] = std::move(_slots[i + 1]);
+            _dist[i]  = (int8_t)(_dist[i + 1] - 1);
+        }
+        _slots[i].~E();
+        _dist[i] = -1;
+        _size--;
+        return fromSlot(at);
+    }
+    iterator erase(iterator it) { return erase(const_iterator(it)); }
+    size_t   erase(const K& key) {
+        size_t i = slotOf(key);
+        if (i == NONE) return 0;
+        erase(const_iterator{_slots + i, _dist + i});
+        return 1;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < slotCount(); i++)
+            if (_dist[i] >= 0) {
+                _slots[i].~E();
+                _dist[i] = -1;
+            }
+        _size = 0;
+    }
+
+    void reserve(size_t n) {
+        size_t homes = std::bit_ceil(std::max(HOMES_MIN, n * LOAD_DEN / LOAD_NUM + 1));
+        if (homes > _homes) rehash(homes);
+    }
+
+private:
+    static constexpr size_t NONE      = ~size_t(0);
+    static constexpr size_t HOMES_MIN = 16;
+    static constexpr size_t LOAD_NUM  = 4, LOAD_DEN = 5; // grows past 80% full
+
+    size_t slotOf(const K& key) const {
+        if (!_dist) return NONE;
+        size_t i = Hash{}(key) & (_homes - 1);
+        // Past an entry nearer its home than we'd be, the key can't be in
+        for (int8_t d = 0; _dist[i] >= d; i++, d++)
+            if (Eq{}(Traits::key(_slots[i]), key)) return i;
+        return NONE;
+    }
+
+    // Puts e (not already in) where it goes, shifting poorer entries on;
+    // where it went, or NONE if the table had to grow on the way
+    size_t place(E&& e) {
+        size_t i     = Hash{}(Traits::key(e)) & (_homes - 1);
+        int8_t d     = 0;
+        size_t first = NONE;
+        for (;; i++, d++) {
+            if (d > _probeMax) {
+                rehash(_homes * 2);
+                place(std::move(e));
+                return NONE;
+            }
+            if (_dist[i] < 0) {
+                new (&_slots[i]) E(std::move(e));
+                _dist[i] = d;
+                _size++;
+                return first == NONE ? i : first;
+            }
+            if (_dist[i] < d) {
+                std::swap(e, _slots[i]);
+                std::swap(d, _dist[i]);
+                if (first == NONE) first = i;
+            }
+        }
+    }
+
+    void rehash(size_t homes) {
+        size_t  oldCount = slotCount();
+        E*      slots    = _slots;
+        int8_t* dist     = _dist;
+
+        _homes    = homes;
+        _probeMax = (int8_t)std::max(4, (int)std::bit_width(homes) - 1);
+        _size     = 0;
+        size_t n  = _homes + _probeMax;
+        _slots    = std::allocator<E>{}.allocate(n);
+        _dist     = new int8_t[n + 1];
+        std::fill(_dist, _dist + n, (int8_t)-1);
+        _dist[n] = 0; // stops iteration
+
+        for (size_t i = 0; i < oldCount; i++)
+            if (dist[i] >= 0) {
+                place(std::move(slots[i]));
+                slots[i].~E();
+            }
+        if (slots) std::allocator<E>{}.deallocate(slots, oldCount);
+        delete[] dist;
+    }
+
+    void release() {
+        if (!_dist) return;
+        clear();
+        std::allocator<E>{}.deallocate(_slots, slotCount());
+        delete[] _dist;
+        _slots = nullptr;
+        _dist  = nullptr;
+        _homes = 0;
+    }
+
+    E*      _slots    = nullptr;
+    int8_t* _dist     = nullptr; // per slot: how far from home, -1 empty; then a 0
+    size_t  _homes    = 0;
+    int8_t  _probeMax = 0;
+    size_t  _size     = 0;
+};
+
+namespace flat_detail {
+
+template<class K, class V>
+struct MapTraits {
+    using Key   = K;
+    using Entry = std::pair<K, V>;
+    static const K& key(const Entry& e) { return e.first; }
+    template<class... A>
+    static Entry make(const K& k, A&&... args) {
+        return Entry(std::piecewise_construct, std::forward_as_tuple(k),
+                     std::forward_as_tuple(std::forward<A>(args)...));
+    }
+};
+
+template<class K>
+struct SetTraits {
+    using Key   = K;
+    using Entry = K;
+    static const K& key(const K& e) { return e; }
+    static K        make(const K& k) { return k; }
+};
+
+} // namespace flat_detail
+
+template<class K, class V, class Hash, class Eq = std::equal_to<K>>
+class FlatMap : public FlatTable<flat_detail::MapTraits<K, V>, Hash, Eq> {
+    using Base = FlatTable<flat_detail::MapTraits<K, V>, Hash, Eq>;
+
+public:
+    using mapped_type = V;
+
+    V& operator[](const K& key) { return this->try_emplace(key).first->second; }
+    std::pair<typename Base::iterator, bool> emplace(const K& key, V v) {
+        return this->try_emplace(key, std::move(v));
+    }
+};
+
+template<class K, class Hash, class Eq = std::equal_to<K>>
+class FlatSet : public FlatTable<flat_detail::SetTraits<K>, Hash, Eq> {
+    using Base = FlatTable<flat_detail::SetTraits<K>, Hash, Eq>;
+
+public:
+    std::pair<typename Base::iterator, bool> insert(const K& key) { return this->try_emplace(key); }
+};
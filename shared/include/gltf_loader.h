@@ -23,3 +23,6 @@ struct GltfModel {
 
 // Loads a .glb file. Returns invalid model on failure.
 GltfModel loadGlb(const char* path);
+
+// Every mesh's vertices and indices in one list, indices rebased
+GltfMesh mergeMeshes(const GltfModel& model);
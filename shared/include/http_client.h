@@ -2,6 +2,14 @@
 #include <string>
 #include <cstring>
 #include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cctype>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
 
 #ifdef _WIN32
   #include <winsock2.h>
@@ -9,19 +17,36 @@
   #pragma comment(lib, "ws2_32")
   typedef SOCKET sock_t;
   #define SOCK_INVALID INVALID_SOCKET
-  static void sock_init()  { WSADATA w; WSAStartup(MAKEWORD(2,2),&w); }
+  static void sock_init()  { static bool done = false; if (!done) { WSADATA w; WSAStartup(MAKEWORD(2,2),&w); done = true; } }
   static void sock_close(sock_t s) { closesocket(s); }
+  static bool sock_nonblocking(sock_t s) { u_long on = 1; return ioctlsocket(s, FIONBIO, &on) == 0; }
+  static bool sock_would_block() { int e = WSAGetLastError(); return e == WSAEWOULDBLOCK || e == WSAEINPROGRESS; }
+  static int  sock_poll(WSAPOLLFD* fds, unsigned long n, int ms) { return WSAPoll(fds, n, ms); }
+  typedef WSAPOLLFD sock_pollfd;
+  #define SOCK_NOSIGNAL 0
 #else
   #include <sys/socket.h>
   #include <netinet/in.h>
+  #include <netinet/tcp.h>
   #include <arpa/inet.h>
   #include <netdb.h>
   #include <unistd.h>
   #include <fcntl.h>
+  #include <poll.h>
+  #include <cerrno>
   typedef int sock_t;
   #define SOCK_INVALID (-1)
   static void sock_init()  {}
   static void sock_close(sock_t s) { close(s); }
+  static bool sock_nonblocking(sock_t s) { int f = fcntl(s, F_GETFL, 0); return f >= 0 && fcntl(s, F_SETFL, f | O_NONBLOCK) == 0; }
+  static bool sock_would_block() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS; }
+  static int  sock_poll(pollfd* fds, nfds_t n, int ms) { return poll(fds, n, ms); }
+  typedef pollfd sock_pollfd;
+  #ifdef MSG_NOSIGNAL
+    #define SOCK_NOSIGNAL MSG_NOSIGNAL
+  #else
+    #define SOCK_NOSIGNAL 0
+  #endif
 #endif
 
 struct HttpResponse {
@@ -30,85 +55,363 @@ struct HttpResponse {
     bool ok() const { return status >= 200 && status < 300; }
 };
 
-// Minimal blocking HTTP POST/GET. Good enough for auth calls.
+// Minimal HTTP/1.1 client for the website backend (auth, stats).
 // host: e.g. "127.0.0.1", port: e.g. 8080
+//
+// Connections are kept alive and pooled per host:port, and name lookups are
+// cached, so repeat calls skip both the TCP handshake and DNS. Sockets are
+// non-blocking: HttpClient::Request is a state machine an event loop can
+// drive with poll() on fd()/events(); get()/post()/request() are the blocking
+// wrappers built on it.
 namespace HttpClient {
 
+inline constexpr int TIMEOUT_MS        = 3000;
+inline constexpr int DNS_TTL_S         = 300;
+inline constexpr int MAX_IDLE_PER_HOST = 4;
+
+// ── DNS cache ─────────────────────────────────────────────────────────────────
+
+inline bool resolve(const char* host, int port, sockaddr_in& out) {
+    out = {};
+    out.sin_family = AF_INET;
+    out.sin_port   = htons((uint16_t)port);
+    // Numeric first — no lookup, no cache entry
+    if (inet_pton(AF_INET, host, &out.sin_addr) == 1) return true;
+
+    using Clock = std::chrono::steady_clock;
+    struct Entry { in_addr addr; Clock::time_point expires; };
+    static std::mutex mu;
+    static std::unordered_map<std::string, Entry> cache;
+    {
+        std::lock_guard lk(mu);
+        auto it = cache.find(host);
+        if (it != cache.end() && Clock::now() < it->second.expires) {
+            out.sin_addr = it->second.addr;
+            return true;
+        }
+    }
+
+    addrinfo hints{};
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &res) != 0 || !res) return false;
+    out.sin_addr = ((sockaddr_in*)res->ai_addr)->sin_addr;
+    freeaddrinfo(res);
+
+    std::lock_guard lk(mu);
+    cache[host] = {out.sin_addr, Clock::now() + std::chrono::seconds(DNS_TTL_S)};
+    return true;
+}
+
+// ── Connection pool ───────────────────────────────────────────────────────────
+// Idle keep-alive sockets by "host:port". Thread-safe.
+
+class ConnectionPool {
+public:
+    static ConnectionPool& instance() {
+        static ConnectionPool pool;
+        return pool;
+    }
+
+    // An idle socket the server hasn't closed yet, or SOCK_INVALID
+    sock_t acquire(const std::string& key) {
+        std::lock_guard lk(_mu);
+        auto& idle = _idle[key];
+        while (!idle.empty()) {
+            sock_t fd = idle.back();
+            idle.pop_back();
+            // Closed (0) or holding stray bytes (>0) — either way not reusable
+            char c;
+            int n = recv(fd, &c, 1, MSG_PEEK);
+            if (n < 0 && sock_would_block()) return fd;
+            sock_close(fd);
+        }
+        return SOCK_INVALID;
+    }
+
+    void release(const std::string& key, sock_t fd) {
+        std::lock_guard lk(_mu);
+        auto& idle = _idle[key];
+        if ((int)idle.size() >= MAX_IDLE_PER_HOST) { sock_close(fd); return; }
+        idle.push_back(fd);
+    }
+
+    ~ConnectionPool() {
+        for (auto& [key, idle] : _idle)
+            for (sock_t fd : idle) sock_close(fd);
+    }
+
+private:
+    std::mutex _mu;
+    std::unordered_map<std::string, std::vector<sock_t>> _idle;
+};
+
+// ── Request ───────────────────────────────────────────────────────────────────
+// One request/response exchange on a pooled or fresh non-blocking socket.
+// Drive it by waiting on fd() for events() and calling step() until done().
+// On success the socket goes back to the pool unless the server asked to
+// close it. fresh skips the pool and always connects anew.
+
+class Request {
+public:
+    enum class State { Connecting, Sending, Receiving, Done, Failed };
+
+    Request(const char* method, const char* host, int port,
+            const char* path, const std::string& jsonBody = "", bool fresh = false)
+        : _key(std::string(host) + ":" + std::to_string(port)),
+          _idempotent(strcmp(method, "GET") == 0 || strcmp(method, "HEAD") == 0)
+    {
+        sock_init();
+        buildRequest(method, host, port, path, jsonBody);
+
+        if (!fresh) _fd = ConnectionPool::instance().acquire(_key);
+        if (_fd != SOCK_INVALID) { _reused = true; _state = State::Sending; return; }
+
+        sockaddr_in addr;
+        if (!resolve(host, port, addr)) { _state = State::Failed; return; }
+
+        _fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (_fd == SOCK_INVALID || !sock_nonblocking(_fd)) { fail(); return; }
+        int one = 1;
+        setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+
+        if (connect(_fd, (sockaddr*)&addr, sizeof(addr)) == 0) _state = State::Sending;
+        else if (sock_would_block())                           _state = State::Connecting;
+        else                                                   fail();
+    }
+
+    ~Request() {
+        if (_fd == SOCK_INVALID) return;
+        if (_state == State::Done && _keepAlive) ConnectionPool::instance().release(_key, _fd);
+        else                                     sock_close(_fd);
+    }
+
+    Request(const Request&)            = delete;
+    Request& operator=(const Request&) = delete;
+
+    sock_t fd()     const { return _fd; }
+    State  state()  const { return _state; }
+    bool   done()   const { return _state == State::Done || _state == State::Failed; }
+    // Came from the pool — a failure may just mean the server timed it out
+    bool   reused() const { return _reused; }
+    // Failed such that sending it again on a fresh socket is safe: the pooled
+    // socket was dead before any answer, and either the method is
+    // idempotent or not a byte of the request went out
+    bool   retryable() const {
+        return _state == State::Failed && _reused && _raw.empty() && (_idempotent || _sent == 0);
+    }
+
+    // Poll events to wait for before the next step()
+    short events() const {
+        return (_state == State::Connecting || _state == State::Sending) ? POLLOUT : POLLIN;
+    }
+
+    // Advance as far as possible without blocking
+    State step() {
+        if (_state == State::Connecting) {
+            sock_pollfd pfd{};
+            pfd.fd     = _fd;
+            pfd.events = POLLOUT;
+            if (sock_poll(&pfd, 1, 0) == 0) return _state; // still handshaking
+            int err = 0;
+            socklen_t len = sizeof(err);
+            if (getsockopt(_fd, SOL_SOCKET, SO_ERROR, (char*)&err, &len) != 0 || err != 0) {
+                fail();
+                return _state;
+            }
+            _state = State::Sending;
+        }
+        while (_state == State::Sending) {
+            int n = send(_fd, _out.data() + _sent, (int)(_out.size() - _sent), SOCK_NOSIGNAL);
+            if (n < 0) { if (!sock_would_block()) fail(); return _state; }
+            _sent += (size_t)n;
+            if (_sent == _out.size()) _state = State::Receiving;
+        }
+        while (_state == State::Receiving) {
+            char buf[4096];
+            int n = recv(_fd, buf, sizeof(buf), 0);
+            if (n < 0) { if (!sock_would_block()) fail(); return _state; }
+            if (n == 0) {
+                // EOF ends an unframed body; anything else is truncated
+                _keepAlive = false;
+                if (_headerEnd && !_contentLength && !_chunked) finish(_raw.substr(_headerEnd));
+                else fail();
+                return _state;
+            }
+            _raw.append(buf, (size_t)n);
+            parse();
+        }
+        return _state;
+    }
+
+    // Valid once state() == Done
+    HttpResponse& response() { return _resp; }
+
+private:
+    void buildRequest(const char* method, const char* host, int port,
+                      const char* path, const std::string& jsonBody) {
+        char head[1024];
+        int n;
+        if (jsonBody.empty()) {
+            n = snprintf(head, sizeof(head),
+                "%s %s HTTP/1.1\r\n"
+                "Host: %s:%d\r\n"
+                "Connection: keep-alive\r\n"
+                "\r\n",
+                method, path, host, port);
+        } else {
+            n = snprintf(head, sizeof(head),
+                "%s %s HTTP/1.1\r\n"
+                "Host: %s:%d\r\n"
+                "Content-Type: application/json\r\n"
+                "Content-Length: %d\r\n"
+                "Connection: keep-alive\r\n"
+                "\r\n",
+                method, path, host, port, (int)jsonBody.size());
+        }
+        _out.assign(head, (size_t)std::min(n, (int)sizeof(head) - 1));
+        _out += jsonBody;
+    }
+
+    void fail() {
+        _state     = State::Failed;
+        _keepAlive = false;
+    }
+
+    void finish(std::string body) {
+        _resp.body = std::move(body);
+        _state     = State::Done;
+    }
+
+    // Case-insensitive header lookup in _raw[0, _headerEnd)
+    bool header(const char* name, std::string& value) const {
+        size_t nlen = strlen(name);
+        size_t pos  = _raw.find("\r\n");
+        while (pos != std::string::npos && pos + 2 < _headerEnd) {
+            size_t line = pos + 2;
+            size_t eol  = _raw.find("\r\n", line);
+            if (eol == std::string::npos || eol > _headerEnd) break;
+            if (eol - line > nlen && _raw[line + nlen] == ':') {
+                bool match = true;
+                for (size_t i = 0; i < nlen && match; i++)
+                    match = tolower((unsigned char)_raw[line + i]) == tolower((unsigned char)name[i]);
+                if (match) {
+                    size_t v = line + nlen + 1;
+                    while (v < eol && _raw[v] == ' ') v++;
+                    value = _raw.substr(v, eol - v);
+                    return true;
+                }
+            }
+            pos = eol;
+        }
+        return false;
+    }
+
+    static bool equalsNoCase(const std::string& a, const char* b) {
+        if (a.size() != strlen(b)) return false;
+        for (size_t i = 0; i < a.size(); i++)
+            if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return false;
+        return true;
+    }
+
+    void parse() {
+        if (!_headerEnd) {
+            size_t end = _raw.find("\r\n\r\n");
+            if (end == std::string::npos) return;
+            _headerEnd = end + 4;
+
+            // Parse status
+            if (_raw.size() > 12 && _raw.compare(0, 4, "HTTP") == 0)
+                _resp.status = atoi(_raw.c_str() + 9);
+
+            std::string v;
+            if (header("Connection", v) && equalsNoCase(v, "close")) _keepAlive = false;
+            if (header("Transfer-Encoding", v) && v.find("chunked") != std::string::npos) _chunked = true;
+            else if (header("Content-Length", v)) _contentLength = strtoull(v.c_str(), nullptr, 10) + 1;
+            // Unframed: the body runs to EOF, so the socket can't be reused
+            if (!_chunked && !_contentLength) _keepAlive = false;
+        }
+
+        if (_chunked) {
+            std::string body;
+            if (dechunk(body)) finish(std::move(body));
+        } else if (_contentLength) {
+            size_t want = (size_t)(_contentLength - 1);
+            if (_raw.size() - _headerEnd >= want) finish(_raw.substr(_headerEnd, want));
+        }
+    }
+
+    // Decodes a complete chunked body; false if more bytes are needed
+    bool dechunk(std::string& body) const {
+        size_t p = _headerEnd;
+        while (true) {
+            size_t eol = _raw.find("\r\n", p);
+            if (eol == std::string::npos) return false;
+            size_t size = strtoull(_raw.c_str() + p, nullptr, 16);
+            p = eol + 2;
+            if (size == 0) {
+                // Skip trailers up to the blank line
+                while (true) {
+                    size_t t = _raw.find("\r\n", p);
+                    if (t == std::string::npos) return false;
+                    if (t == p) return true;
+                    p = t + 2;
+                }
+            }
+            if (_raw.size() < p + size + 2) return false;
+            body.append(_raw, p, size);
+            p += size + 2;
+        }
+    }
+
+    std::string  _key;
+    sock_t       _fd        = SOCK_INVALID;
+    State        _state     = State::Failed;
+    bool         _idempotent;
+    bool         _reused    = false;
+    bool         _keepAlive = true;
+
+    std::string  _out;
+    size_t       _sent = 0;
+
+    std::string  _raw;
+    size_t       _headerEnd     = 0;
+    bool         _chunked       = false;
+    uint64_t     _contentLength = 0; // length + 1, 0 = not given
+
+    HttpResponse _resp;
+};
+
+// ── Blocking wrappers ─────────────────────────────────────────────────────────
+
+// Waits on r until it finishes or the deadline passes
+inline bool wait(Request& r, std::chrono::steady_clock::time_point deadline) {
+    while (!r.done()) {
+        if (r.step() == Request::State::Done || r.done()) break;
+        int ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (ms <= 0) return false;
+        sock_pollfd pfd{};
+        pfd.fd     = r.fd();
+        pfd.events = r.events();
+        if (sock_poll(&pfd, 1, ms) < 0) return false;
+    }
+    return r.state() == Request::State::Done;
+}
+
 inline HttpResponse request(const char* method, const char* host, int port,
                             const char* path, const std::string& jsonBody = "") {
-    HttpResponse resp;
-    sock_init();
-
-    sock_t fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (fd == SOCK_INVALID) return resp;
-
-    // Set 3s timeout
-    struct timeval tv;
-    tv.tv_sec = 3; tv.tv_usec = 0;
-    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
-    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, (const char*)&tv, sizeof(tv));
-
-    struct sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons((uint16_t)port);
-
-    // Try numeric first, then DNS
-    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
-        struct hostent* he = gethostbyname(host);
-        if (!he) { sock_close(fd); return resp; }
-        memcpy(&addr.sin_addr, he->h_addr_list[0], he->h_length);
-    }
-
-    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
-        sock_close(fd); return resp;
-    }
-
-    // Build HTTP request
-    char reqBuf[4096];
-    int reqLen;
-    if (jsonBody.empty()) {
-        reqLen = snprintf(reqBuf, sizeof(reqBuf),
-            "%s %s HTTP/1.1\r\n"
-            "Host: %s:%d\r\n"
-            "Connection: close\r\n"
-            "\r\n",
-            method, path, host, port);
-    } else {
-        reqLen = snprintf(reqBuf, sizeof(reqBuf),
-            "%s %s HTTP/1.1\r\n"
-            "Host: %s:%d\r\n"
-            "Content-Type: application/json\r\n"
-            "Content-Length: %d\r\n"
-            "Connection: close\r\n"
-            "\r\n"
-            "%s",
-            method, path, host, port, (int)jsonBody.size(), jsonBody.c_str());
-    }
-
-    send(fd, reqBuf, reqLen, 0);
-
-    // Read response
-    std::string raw;
-    char buf[4096];
-    while (true) {
-        int n = recv(fd, buf, sizeof(buf), 0);
-        if (n <= 0) break;
-        raw.append(buf, n);
-    }
-    sock_close(fd);
-
-    // Parse status
-    if (raw.size() > 12 && raw.substr(0, 4) == "HTTP") {
-        resp.status = atoi(raw.c_str() + 9);
-    }
-
-    // Find body after \r\n\r\n
-    auto bodyStart = raw.find("\r\n\r\n");
-    if (bodyStart != std::string::npos) {
-        resp.body = raw.substr(bodyStart + 4);
-    }
-
-    return resp;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TIMEOUT_MS);
+    // A pooled socket the server already timed out fails fast — retry on a
+    // new connection, not another idle one that may be just as dead, unless
+    // the server may have acted on the request
+    for (int attempt = 0; attempt < 2; attempt++) {
+        Request r(method, host, port, path, jsonBody, attempt > 0);
+        if (wait(r, deadline)) return std::move(r.response());
+        if (!r.retryable()) break;
+    }
+    return {};
 }
 
 inline HttpResponse post(const char* host, int port, const char* path,
@@ -0,0 +1,70 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+#include <glm/vec3.hpp>
+#include "chunk.h"
+#include "config.h"
+
+// Server-side interest management for anything broadcast to players. Items
+// are bucketed by chunk column; a listener hears about everything within
+// INTEREST_NEAR_CHUNKS on every broadcast, and out to INTEREST_FAR_CHUNKS
+// on every INTEREST_FAR_EVERY-th, staggered by id so a crowd doesn't all
+// land on one tick. Nothing beyond that is sent.
+template<class T>
+class InterestGrid {
+public:
+    void clear() {
+        for (auto& [c, cell] : _cells) cell.clear();
+    }
+
+    void add(const glm::vec3& pos, uint32_t id, T item) {
+        _cells[columnOf(pos)].push_back({id, item});
+    }
+
+    // f(const T&) for every item the listener at pos should hear about on
+    // broadcast number tick
+    template<class F>
+    void forEach(const glm::vec3& pos, uint32_t tick, F&& f) const {
+        const int R = Config::INTEREST_FAR_CHUNKS;
+        ChunkCoord c = columnOf(pos);
+        for (int dx = -R; dx <= R; dx++)
+        for (int dz = -R; dz <= R; dz++) {
+            auto cell = _cells.find({c.x + dx, 0, c.z + dz});
+            if (cell == _cells.end()) continue;
+            bool near = std::max(std::abs(dx), std::abs(dz)) <= Config::INTEREST_NEAR_CHUNKS;
+            for (const Entry& e : cell->second) {
+                if (!near && (tick + e.id) % Config::INTEREST_FAR_EVERY != 0) continue;
+                f(e.item);
+            }
+        }
+    }
+
+    // f(const T&) for every item within R columns of pos, whatever the tick
+    template<class F>
+    void forEachInRange(const glm::vec3& pos, int R, F&& f) const {
+        ChunkCoord c = columnOf(pos);
+        for (int dx = -R; dx <= R; dx++)
+        for (int dz = -R; dz <= R; dz++) {
+            auto cell = _cells.find({c.x + dx, 0, c.z + dz});
+            if (cell == _cells.end()) continue;
+            for (const Entry& e : cell->second) f(e.item);
+        }
+    }
+
+    static ChunkCoord columnOf(const glm::vec3& p) {
+        return {(int)std::floor(p.x / ChunkData::SIZE), 0, (int)std::floor(p.z / ChunkData::SIZE)};
+    }
+
+private:
+    struct Entry {
+        uint32_t id;
+        T        item;
+    };
+
+    // Cells are emptied rather than erased so their storage is reused
+    std::unordered_map<ChunkCoord, std::vector<Entry>, ChunkCoordHash> _cells;
+};
@@ -11,6 +11,7 @@ enum class InvPacketID : uint8_t {
     InventoryMoveAck = 0x15,
     LootAvailable    = 0x16,
     HotbarModeSync   = 0x17, // client -> server: active mode + slot changed
+    InventoryResync  = 0x18, // client -> server: missed an ack, send InventoryState
 };
 
 enum class InvOwner : uint8_t {
@@ -65,21 +66,27 @@ inline void readInventory(const uint8_t* d, size_t& o, Inventory& inv) {
 
 // ── Packets ────────────────────────────────────────────────────────────────────
 
+// Full player inventory. seq is the ack sequence it's current as of; the
+// next InventoryMoveAck carries seq + 1.
 struct InventoryStatePacket {
+    uint16_t  seq = 0;
     Inventory inv;
     std::vector<uint8_t> serialize() const {
         std::vector<uint8_t> b;
         writeU8(b, (uint8_t)InvPacketID::InventoryState);
+        writeU16(b, seq);
         writeInventory(b, inv);
         return b;
     }
     static InventoryStatePacket deserialize(const uint8_t* d, size_t) {
         InventoryStatePacket p; size_t o = 1;
+        p.seq = readU16(d, o);
         readInventory(d, o, p.inv);
         return p;
     }
 };
 
+// chestUID 0 asks for the nearest chest in interact range
 struct ChestOpenReqPacket {
     uint32_t chestUID;
     std::vector<uint8_t> serialize() const {
@@ -149,34 +156,50 @@ struct InventoryMoveReqPacket {
     }
 };
 
+// The slots a move changed, with their new contents. Acks are numbered per
+// player; a client that sees a gap asks for InventoryResync instead of
+// applying it.
+struct SlotChange {
+    SlotRef   ref;
+    ItemStack stack;
+};
+
 struct InventoryMoveAckPacket {
-    Inventory playerInv;
-    bool      hasSecondary = false;
-    uint32_t  secondaryUID = 0;
-    Inventory secondaryInv;
+    uint16_t                seq = 0;
+    std::vector<SlotChange> changes;
     std::vector<uint8_t> serialize() const {
         std::vector<uint8_t> b;
+        b.reserve(1 + 2 + 1 + changes.size() * (7 + 8));
         writeU8(b, (uint8_t)InvPacketID::InventoryMoveAck);
-        writeInventory(b, playerInv);
-        writeU8(b, hasSecondary ? 1 : 0);
-        if (hasSecondary) {
-            writeU32(b, secondaryUID);
-            writeInventory(b, secondaryInv);
+        writeU16(b, seq);
+        writeU8(b, (uint8_t)changes.size());
+        for (const auto& c : changes) {
+            writeSlotRef(b, c.ref);
+            writeStack(b, c.stack);
         }
         return b;
     }
-    static InventoryMoveAckPacket deserialize(const uint8_t* d, size_t) {
+    static InventoryMoveAckPacket deserialize(const uint8_t* d, size_t len) {
         InventoryMoveAckPacket p; size_t o = 1;
-        readInventory(d, o, p.playerInv);
-        p.hasSecondary = readU8(d, o) != 0;
-        if (p.hasSecondary) {
-            p.secondaryUID = readU32(d, o);
-            readInventory(d, o, p.secondaryInv);
+        if (len < 4) return p;
+        p.seq = readU16(d, o);
+        uint8_t n = readU8(d, o);
+        if (len - o < (size_t)n * (7 + 8)) return p;
+        p.changes.resize(n);
+        for (auto& c : p.changes) {
+            c.ref   = readSlotRef(d, o);
+            c.stack = readStack(d, o);
         }
         return p;
     }
 };
 
+struct InventoryResyncPacket {
+    std::vector<uint8_t> serialize() const {
+        return {(uint8_t)InvPacketID::InventoryResync};
+    }
+};
+
 struct LootAvailablePacket {
     uint32_t  corpseUID;
     glm::vec3 pos;
@@ -1,8 +1,21 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 // Cross-platform signal handling
 #include <csignal>
@@ -16,38 +29,405 @@
   #endif
 #endif
 
+// Records below this level compile away, arguments and all, at the call
+// site: 0 keeps everything, 1 drops info, 2 keeps only errors
+#ifndef AETHERIS_LOG_LEVEL
+  #define AETHERIS_LOG_LEVEL 0
+#endif
+
+// Logging never blocks the caller on I/O. Each thread that logs gets its own
+// ring; a record is copied in — the raw arguments, not the formatted text,
+// when logged as info("fmt %d", x) — and a background thread formats them,
+// orders them by time and writes them out. A full ring drops the record and
+// counts it instead of waiting, so a stalled disk costs log lines, never a
+// tick. Before init(), after shutdown() and once a crash handler is running,
+// records are written synchronously on the caller's thread as they always
+// were.
 namespace Log {
 
 enum class Level { INFO, WARN, ERR };
 
+inline constexpr Level MIN_LEVEL = (Level)AETHERIS_LOG_LEVEL;
+inline constexpr bool  enabled(Level l) { return (int)l >= (int)MIN_LEVEL; }
+
+inline constexpr size_t RING_BYTES  = 256 << 10; // per logging thread
+inline constexpr size_t TEXT_MAX    = 4096;     // longer records are truncated
+inline constexpr int    DRAIN_MS    = 10;       // the writer's poll interval when nobody wakes it
+
+// A format string that is known at compile time, so a record can keep just
+// the pointer
+struct Fmt {
+    template<size_t N>
+    consteval Fmt(const char (&s)[N]) : str(s) {}
+    const char* str;
+};
+
+// ── Records ───────────────────────────────────────────────────────────────────
+// Header, then payload: the message bytes for plain records, the packed
+// arguments for formatted ones. Sizes are rounded to 8 so headers stay aligned.
+
+// Formats packed arguments into out; one instantiation per argument list
+using FormatFn = int (*)(char* out, size_t cap, const char* fmt, const uint8_t* args);
+
+struct Record {
+    uint32_t    size;   // header + payload, rounded; 0 marks padding to the ring's end
+    uint32_t    len;    // payload bytes
+    Level       level;
+    int64_t     timeNs; // system clock
+    FormatFn    format; // null: payload is the message
+    const char* fmt;
+};
+
+inline constexpr size_t roundUp8(size_t n) { return (n + 7) & ~size_t(7); }
+
+// ── Deferred arguments ────────────────────────────────────────────────────────
+// Arithmetic values, enums and pointers are copied as they are; strings are
+// copied with a NUL and handed back to the formatter as const char*.
+
+template<class T>
+inline constexpr bool isText = std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> ||
+                               std::is_same_v<T, const char*> || std::is_same_v<T, char*>;
+
+// As passed: string literals arrive as const char*
+template<class T>
+using Arg = std::decay_t<const T>;
+
+template<class T, bool = std::is_enum_v<T>> struct PackedOf              { using type = T; };
+template<class T>                        struct PackedOf<T, true>        { using type = std::underlying_type_t<T>; };
+
+template<class T>
+using Packed = std::conditional_t<isText<T>, const char*, typename PackedOf<T>::type>;
+
+inline std::string_view textOf(std::string_view s) { return s; }
+inline std::string_view textOf(const char* s)      { return s ? std::string_view(s) : std::string_view("(null)"); }
+
+// Strings share TEXT_MAX between them; textLeft counts down as they're packed
+inline size_t textBytes(std::string_view s, size_t textLeft) {
+    return std::min({s.size(), textLeft ? textLeft - 1 : 0, (size_t)UINT16_MAX - 1});
+}
+
+// What pack() will write for v
+template<class T>
+inline size_t packedSize(size_t& textLeft, const T& v) {
+    if constexpr (isText<T>) {
+        size_t n = textBytes(textOf(v), textLeft);
+        textLeft -= n + 1;
+        return 3 + n;
+    } else {
+        return sizeof(Packed<T>);
+    }
+}
+
+template<class T>
+inline void pack(uint8_t*& p, size_t& textLeft, const T& v) {
+    if constexpr (isText<T>) {
+        std::string_view s = textOf(v);
+        uint16_t n = (uint16_t)textBytes(s, textLeft);
+        memcpy(p, &n, 2);
+        memcpy(p + 2, s.data(), n);
+        p[2 + n] = 0;
+        p += 3 + n;
+        textLeft -= n + 1;
+    } else {
+        static_assert(std::is_trivially_copyable_v<T>, "Log: argument can't be deferred");
+        Packed<T> x = (Packed<T>)v;
+        memcpy(p, &x, sizeof x);
+        p += sizeof x;
+    }
+}
+
+template<class T>
+inline Packed<T> unpack(const uint8_t*& p) {
+    if constexpr (isText<T>) {
+        uint16_t n;
+        memcpy(&n, p, 2);
+        const char* s = (const char*)p + 2;
+        p += 3 + n;
+        return s;
+    } else {
+        Packed<T> x;
+        memcpy(&x, p, sizeof x);
+        p += sizeof x;
+        return x;
+    }
+}
+
+template<class... Args>
+inline int formatPacked(char* out, size_t cap, const char* fmt, const uint8_t* args) {
+    // Braced initialization unpacks left to right
+    std::tuple<Packed<Args>...> values{unpack<Args>(args)...};
+    return std::apply([&](auto... v) {
+#if defined(__GNUC__)
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wformat-nonliteral"
+  #pragma GCC diagnostic ignored "-Wformat-security"
+#endif
+        return snprintf(out, cap, fmt, v...);
+#if defined(__GNUC__)
+  #pragma GCC diagnostic pop
+#endif
+    }, values);
+}
+
+// ── Per-thread rings ──────────────────────────────────────────────────────────
+// Single producer (the owning thread), single consumer (the writer, or the
+// crash handler once it has taken over). head and tail only ever grow.
+
+struct Ring {
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool>     retired{false}; // thread gone; freed once drained
+    alignas(8) uint8_t    buf[RING_BYTES];
+
+    // Producer: room for size contiguous bytes, or null
+    uint8_t* reserve(size_t size) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        uint64_t t = tail.load(std::memory_order_acquire);
+        size_t   at = (size_t)(h % RING_BYTES), toEnd = RING_BYTES - at;
+        size_t   pad = size > toEnd ? toEnd : 0;
+        if (RING_BYTES - (h - t) < size + pad) return nullptr;
+        if (pad) {
+            // Too little left for a header reads as padding anyway
+            if (toEnd >= sizeof(Record)) memset(buf + at, 0, sizeof(uint32_t));
+            head.store(h + pad, std::memory_order_release);
+            at = 0;
+        }
+        return buf + at;
+    }
+    void commit(size_t size) {
+        head.store(head.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+    size_t used() const {
+        return (size_t)(head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed));
+    }
+};
+
 inline FILE*      g_file  = nullptr;
-inline std::mutex g_mutex;
+inline std::mutex g_mutex;                       // synchronous writes
+
+inline std::mutex                         g_ringsMu;
+inline std::vector<std::shared_ptr<Ring>> g_rings;
+inline std::atomic<bool>                  g_async{false};
+inline std::atomic<bool>                  g_crashing{false};
+inline std::atomic<bool>                  g_draining{false}; // a consumer is inside drain()
+inline std::atomic<bool>                  g_stop{false};
+inline std::condition_variable            g_wake;
+inline std::mutex                         g_wakeMu;
+inline std::thread                        g_writer;
+
+// Retires the thread's ring when the thread exits
+struct RingOwner {
+    std::shared_ptr<Ring> ring;
+    ~RingOwner() { if (ring) ring->retired.store(true, std::memory_order_release); }
+};
+inline thread_local RingOwner t_ring;
+
+inline Ring* threadRing() {
+    if (!t_ring.ring) {
+        t_ring.ring = std::make_shared<Ring>();
+        std::lock_guard lk(g_ringsMu);
+        g_rings.push_back(t_ring.ring);
+    }
+    return t_ring.ring.get();
+}
+
+// ── Output ────────────────────────────────────────────────────────────────────
+
+inline const char* tagOf(Level level) {
+    return level == Level::INFO ? "INFO" : level == Level::WARN ? "WARN" : "ERR ";
+}
+
+inline void emit(int64_t timeNs, Level level, std::string_view msg) {
+    std::time_t t = (std::time_t)(timeNs / 1000000000);
+    char timebuf[32];
+    std::strftime(timebuf, sizeof(timebuf), "%H:%M:%S", std::localtime(&t));
+    fprintf(stdout, "[%s][%s] %.*s\n", timebuf, tagOf(level), (int)msg.size(), msg.data());
+    if (g_file)
+        fprintf(g_file, "[%s][%s] %.*s\n", timebuf, tagOf(level), (int)msg.size(), msg.data());
+}
+
+inline int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+inline void writeNow(Level level, std::string_view msg) {
+    // A crashing thread may hold the lock already
+    std::unique_lock lock(g_mutex, std::defer_lock);
+    if (!g_crashing.load(std::memory_order_relaxed)) lock.lock();
+    emit(nowNs(), level, msg);
+    if (g_crashing.load(std::memory_order_relaxed)) {
+        fflush(stdout);
+        if (g_file) fflush(g_file);
+    }
+}
+
+// Consumer side: everything committed so far, across rings, in time order.
+// Only one drain runs at a time (g_draining).
+inline void drain() {
+    struct Line {
+        int64_t     timeNs;
+        Level       level;
+        std::string text;
+    };
+    std::vector<Line>                  lines;
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        // A crashing thread may be mid-registration; then read the list as is
+        std::unique_lock lk(g_ringsMu, std::defer_lock);
+        if (g_crashing.load(std::memory_order_relaxed)) (void)lk.try_lock();
+        else lk.lock();
+        rings = g_rings;
+        // Threads that left and whose records are all out
+        if (lk.owns_lock())
+            g_rings.erase(std::remove_if(g_rings.begin(), g_rings.end(), [](const auto& r) {
+                return r->retired.load(std::memory_order_acquire) && r->used() == 0;
+            }), g_rings.end());
+    }
+
+    uint64_t dropped = 0;
+    char text[TEXT_MAX];
+    for (const auto& r : rings) {
+        dropped += r->dropped.exchange(0, std::memory_order_relaxed);
+        uint64_t t = r->tail.load(std::memory_order_relaxed);
+        uint64_t h = r->head.load(std::memory_order_acquire);
+        while (t < h) {
+            size_t at = (size_t)(t % RING_BYTES);
+            Record rec{};
+            if (RING_BYTES - at >= sizeof rec) memcpy(&rec, r->buf + at, sizeof rec);
+            if (rec.size == 0) { t += RING_BYTES - at; continue; }
+            const uint8_t* payload = r->buf + at + sizeof(Record);
+            std::string_view msg;
+            if (rec.format) {
+                int n = rec.format(text, sizeof text, rec.fmt, payload);
+                msg = {text, n < 0 ? 0 : std::min((size_t)n, sizeof text - 1)};
+            } else {
+                msg = {(const char*)payload, rec.len};
+            }
+            lines.push_back({rec.timeNs, rec.level, std::string(msg)});
+            t += rec.size;
+        }
+        r->tail.store(t, std::memory_order_release);
+    }
+
+    std::stable_sort(lines.begin(), lines.end(),
+                     [](const Line& a, const Line& b) { return a.timeNs < b.timeNs; });
+    for (const Line& l : lines) emit(l.timeNs, l.level, l.text);
+    if (dropped)
+        emit(nowNs(), Level::WARN, std::to_string(dropped) + " log records dropped, rings full");
+    if (!lines.empty() || dropped) {
+        fflush(stdout);
+        if (g_file) fflush(g_file);
+    }
+}
+
+inline void writerLoop() {
+    while (true) {
+        {
+            std::unique_lock lk(g_wakeMu);
+            g_wake.wait_for(lk, std::chrono::milliseconds(DRAIN_MS));
+        }
+        bool stop = g_stop.load(std::memory_order_acquire);
+        if (!g_draining.exchange(true, std::memory_order_acquire)) {
+            drain();
+            g_draining.store(false, std::memory_order_release);
+        }
+        if (stop) return;
+    }
+}
+
+// Producer side. Errors, and rings past half full, wake the writer early;
+// the notify takes no lock, so a missed one just waits out DRAIN_MS.
+inline void push(Level level, FormatFn format, const char* fmt, size_t len,
+                 const auto& fill) {
+    Ring*  r    = threadRing();
+    size_t size = roundUp8(sizeof(Record) + len);
+    uint8_t* at = r->reserve(size);
+    if (!at) {
+        r->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Record rec{(uint32_t)size, (uint32_t)len, level, nowNs(), format, fmt};
+    memcpy(at, &rec, sizeof rec);
+    fill(at + sizeof(Record));
+    r->commit(size);
+    if (level == Level::ERR || r->used() > RING_BYTES / 2) g_wake.notify_one();
+}
+
+// ── Interface ─────────────────────────────────────────────────────────────────
+
+inline void shutdown();
 
 inline void init(const char* logPath = "aetheris.log") {
     g_file = fopen(logPath, "w");
+    if (g_async.exchange(true)) return;
+    g_stop = false;
+    g_writer = std::thread(writerLoop);
+    // A return from main without shutdown() still gets its records out
+    static bool registered = false;
+    if (!registered) { registered = true; std::atexit([] { shutdown(); }); }
 }
 
 inline void shutdown() {
+    if (g_async.exchange(false)) {
+        g_stop = true;
+        g_wake.notify_one();
+        if (g_writer.joinable()) g_writer.join();
+        // Anything logged between the writer's last pass and g_async going false
+        while (g_draining.exchange(true)) std::this_thread::yield();
+        drain();
+        g_draining = false;
+    }
     if (g_file) { fflush(g_file); fclose(g_file); g_file = nullptr; }
 }
 
 inline void write(Level level, std::string_view msg) {
-    const char* tag = level == Level::INFO ? "INFO"
-                    : level == Level::WARN ? "WARN"
-                                           : "ERR ";
-    std::time_t t = std::time(nullptr);
-    char timebuf[32];
-    std::strftime(timebuf, sizeof(timebuf), "%H:%M:%S", std::localtime(&t));
+    if (!g_async.load(std::memory_order_acquire) || g_crashing.load(std::memory_order_relaxed)) {
+        writeNow(level, msg);
+        return;
+    }
+    size_t len = std::min(msg.size(), TEXT_MAX - 1);
+    push(level, nullptr, nullptr, len, [&](uint8_t* p) { memcpy(p, msg.data(), len); });
+}
 
-    std::lock_guard lock(g_mutex);
-    fprintf(stdout, "[%s][%s] %.*s\n", timebuf, tag, (int)msg.size(), msg.data());
-    if (g_file)
-        fprintf(g_file, "[%s][%s] %.*s\n", timebuf, tag, (int)msg.size(), msg.data());
+// printf-style, formatted on the writer thread. Arguments are copied into
+// the record; strings up to what's left of TEXT_MAX.
+template<class... Args>
+inline void writef(Level level, Fmt fmt, const Args&... args) {
+    size_t left = TEXT_MAX;
+    size_t len  = (packedSize<Arg<Args>>(left, args) + ... + 0);
+    auto   fill = [&](uint8_t* p) {
+        size_t textLeft = TEXT_MAX;
+        (pack<Arg<Args>>(p, textLeft, args), ...);
+    };
+    FormatFn format = &formatPacked<Arg<Args>...>;
+
+    if (!g_async.load(std::memory_order_acquire) || g_crashing.load(std::memory_order_relaxed)) {
+        std::vector<uint8_t> packed(len);
+        fill(packed.data());
+        char text[TEXT_MAX];
+        int  n = format(text, sizeof text, fmt.str, packed.data());
+        writeNow(level, {text, n < 0 ? 0 : std::min((size_t)n, sizeof text - 1)});
+        return;
+    }
+    push(level, format, fmt.str, len, fill);
 }
 
-inline void info(std::string_view msg) { write(Level::INFO, msg); }
-inline void warn(std::string_view msg) { write(Level::WARN, msg); }
-inline void err (std::string_view msg) { write(Level::ERR,  msg); }
+inline void info(std::string_view msg) { if constexpr (enabled(Level::INFO)) write(Level::INFO, msg); }
+inline void warn(std::string_view msg) { if constexpr (enabled(Level::WARN)) write(Level::WARN, msg); }
+inline void err (std::string_view msg) { write(Level::ERR, msg); }
+
+template<class A, class... Args>
+inline void info(Fmt fmt, const A& a, const Args&... args) {
+    if constexpr (enabled(Level::INFO)) writef(Level::INFO, fmt, a, args...);
+}
+template<class A, class... Args>
+inline void warn(Fmt fmt, const A& a, const Args&... args) {
+    if constexpr (enabled(Level::WARN)) writef(Level::WARN, fmt, a, args...);
+}
+template<class A, class... Args>
+inline void err(Fmt fmt, const A& a, const Args&... args) { writef(Level::ERR, fmt, a, args...); }
 
 inline void printBacktrace() {
 #if defined(HAS_BACKTRACE)
@@ -67,9 +447,17 @@ inline void crashHandler(int sig) {
                      : sig == SIGABRT ? "SIGABRT"
                      : sig == SIGFPE  ? "SIGFPE"
                                       : "SIGNAL";
+    // Take the rings over from the writer: wait briefly for a pass in
+    // progress, then drain whatever is pending from every thread. From here
+    // on every record is written synchronously.
+    g_crashing = true;
+    for (int i = 0; i < 200 && g_draining.exchange(true); i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    drain();
     err(std::string("Caught ") + name + " — flushing log");
     printBacktrace();
-    shutdown();
+    fflush(stdout);
+    if (g_file) { fflush(g_file); fclose(g_file); g_file = nullptr; }
     // Re-raise so the OS generates a core dump / Windows error report
     signal(sig, SIG_DFL);
     raise(sig);
@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <enet/enet.h>
+#include "spsc_queue.h"
+
+// ── Loopback ──────────────────────────────────────────────────────────────────
+// In place of a socket between a client and a server in the same process
+// (singleplayer). The two network ends — NetThread::connect(Loopback&) on
+// the client, ServerNet::attach on the server — hand each other finished
+// ENetPackets through two lock-free rings: nothing is copied, nothing is
+// acked or resent, and a chunk the server packed once reaches MeshBuilder
+// in the very buffer the generation pool filled (Net::makeSharedPacket).
+//
+// The client stands as one peer on the server, `peer`, a zeroed stand-in
+// as in a replay; nothing reads its ENet state. Each connect is a new
+// connection id, so a send for an earlier one is dropped.
+//
+// When the client is done it disconnects, then close(); the server's loop
+// returns once it has taken the disconnect (finished()).
+class Loopback {
+public:
+    struct Message {
+        enum class Kind : uint8_t { Connect, Receive, Disconnect };
+        Kind        kind    = Kind::Receive;
+        uint32_t    id      = 0;       // connection
+        uint8_t     channel = 0;
+        ENetPacket* packet  = nullptr; // Receive: the receiver's to destroy
+    };
+
+    static constexpr size_t RING = 4096;
+
+    Loopback() = default;
+    ~Loopback() {
+        Message m;
+        while (toServer.pop(m)) if (m.packet) enet_packet_destroy(m.packet);
+        while (toClient.pop(m)) if (m.packet) enet_packet_destroy(m.packet);
+    }
+
+    Loopback(const Loopback&)            = delete;
+    Loopback& operator=(const Loopback&) = delete;
+
+    ENetPeer peer{};
+
+    // Client's network thread → the server's simulation thread, and back
+    SpscQueue<Message, RING> toServer;
+    SpscQueue<Message, RING> toClient;
+
+    // Set by ServerNet::attach; the client calls it after each push so a
+    // waiting server wakes
+    std::function<void()> wakeServer;
+
+    void close() {
+        _closed.store(true, std::memory_order_release);
+        if (wakeServer) wakeServer();
+    }
+    bool finished() const { return _closed.load(std::memory_order_acquire) && toServer.empty(); }
+
+private:
+    std::atomic<bool> _closed{false};
+};
+
+// The server, run in-process over lb rather than on a port, until
+// lb.finished(); argv as the server binary takes it. Built into the
+// client from the server's sources (server_embed in server/meson.build).
+int serverMain(int argc, char** argv, Loopback* lb);
@@ -1,6 +1,105 @@
 #pragma once
+#include <cmath>
+#include <cstdint>
+#include <string>
 #include "chunk.h"
+#include "config.h"
 
-// Takes a filled ChunkData scalar field and returns a mesh.
-// Values < 0 are considered inside the surface.
-ChunkMesh marchChunk(const ChunkData& chunk);
+// Triplanar UV for a terrain vertex — tile at 1/SCALE units along the
+// face's dominant plane. Not wrapped: the sampler repeats, so a triangle
+// crossing a tile edge interpolates straight through it. The material picks
+// the texture-array layer, not a region of these coordinates.
+// Pure function of position/normal, so the client can rebuild UVs from the
+// wire format instead of receiving them.
+inline glm::vec2 terrainUV(glm::vec3 p, glm::vec3 normal) {
+    constexpr float SCALE = 0.25f; // lower = more tiles = "zoomed out"
+    // Ties between axes are common (45° faces); the margin keeps the choice
+    // stable when the normal has been through a lossy encoding
+    constexpr float TIE   = 0.05f;
+
+    glm::vec3 an{std::fabs(normal.x), std::fabs(normal.y), std::fabs(normal.z)};
+    glm::vec2 localUV;
+    if (an.x > an.y + TIE && an.x > an.z + TIE)
+        localUV = {p.z, p.y};
+    else if (an.y > an.z + TIE)
+        localUV = {p.x, p.z};
+    else
+        localUV = {p.x, p.y};
+
+    return { std::fabs(localUV.x) * SCALE, std::fabs(localUV.y) * SCALE };
+}
+
+// How a field becomes triangles:
+//   Cubes  marching cubes: up to 5 triangles a cell, vertices snapped to
+//          grid corners; what client-side meshing (fields, march.comp) does
+//   Nets   surface nets: a vertex per cell the surface crosses, a quad per
+//          crossing edge, then flat blocks of cells merged into one vertex
+//          — under half cubes' triangles, every vertex shared;
+//          smooth-shaded (there's one normal per cell to give)
+// A server picks one for every mesh it makes (--mesher); clients that mesh
+// fields themselves only get them from a Cubes server.
+enum class Mesher : uint8_t { Cubes = 0, Nets = 1 };
+
+namespace Meshers {
+    // "cubes", "nets"; Cubes for anything else
+    Mesher      parse(const std::string& name);
+    const char* name(Mesher m);
+}
+
+// What MarchOptions default to: Cubes unless useMesher says otherwise,
+// which has to happen before anything is meshed
+Mesher defaultMesher();
+void   useMesher(Mesher m);
+
+struct MarchOptions {
+    Mesher mesher = defaultMesher();
+
+    // Per-vertex normals from the field gradient instead of per-face normals.
+    // Faceted (false) welds only vertices shared by coplanar triangles;
+    // smooth welds every vertex at a grid corner.
+    bool smoothNormals = Config::SMOOTH_TERRAIN_NORMALS;
+
+    // LOD meshes: hang a curtain this many cells deep below every surface
+    // edge on the chunk's x/z faces and face it outwards. A coarser
+    // neighbour samples the shared face at fewer points than a finer one, so
+    // the two surfaces meet it along different lines; the curtain covers the
+    // sliver between them. 0 for full-resolution chunks, which always meet
+    // their neighbours exactly.
+    float skirt = 0.f;
+
+    // Bake per-vertex ambient occlusion into Vertex::occlusion from taps
+    // along the normal into the field. Only the client draws it, so the
+    // server's meshes leave it 0 (open).
+    bool occlusion = false;
+};
+
+// Takes a filled ChunkData scalar field and returns an indexed mesh with
+// shared vertices. Values < 0 are considered inside the surface.
+ChunkMesh marchChunk(const ChunkData& chunk, const MarchOptions& opts = {});
+
+// Same, into an existing mesh whose vectors keep their capacity — for
+// callers that recycle meshes.
+void marchChunk(const ChunkData& chunk, ChunkMesh& out, const MarchOptions& opts = {});
+
+// The chunk's FACE_LINKS mask (see faceLinkBit), which marchChunk also sets
+// on the mesh. Flood-fills the cells that have an air corner, joining two
+// neighbours when their shared face has one: never finds a face pair closed
+// that the surface leaves open, only sometimes open when it's closed.
+uint16_t chunkFaceLinks(const ChunkData& chunk);
+
+// The case table marchChunk runs on: per cube index (bit c set when corner
+// c is inside), the triangles' edges in threes, -1 after the last. For
+// client/shaders/march.comp, which numbers corners and edges the same way.
+using MarchTriTable = int8_t[256][16];
+const MarchTriTable& marchTriTable();
+
+// marchChunk in pieces, to spread one chunk over several threads (Cubes
+// only; a Nets chunk is meshed whole, into slab 0): marchSlab
+// meshes slab i of n (cells z in [marchSlabStart(i, n), marchSlabStart(i+1,
+// n))) into its own mesh, then stitchSlabs joins all n, in order, welding
+// the vertices neighbouring slabs share on their boundary layer. The result
+// is identical to marchChunk's, faceLinks aside: stitching can't see the
+// field, so callers set that themselves with chunkFaceLinks.
+inline int marchSlabStart(int i, int n) { return ChunkData::SIZE * i / n; }
+void marchSlab(const ChunkData& chunk, ChunkMesh& out, int i, int n, const MarchOptions& opts = {});
+void stitchSlabs(std::vector<ChunkMesh>& slabs, ChunkMesh& out, const MarchOptions& opts = {});
@@ -0,0 +1,128 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "config.h"
+#include "log.h"
+
+// ── MemTags ───────────────────────────────────────────────────────────────────
+// Heap accounting by subsystem, opt-in (meson -Dmem_tags=true, which sets
+// AETHERIS_MEM_TAGS). The global operator new then puts a 16-byte header
+// ahead of every block with its size and the allocating thread's tag, set
+// by a Scope, and counts live bytes and blocks per tag; delete takes them
+// off the tag they were charged to on whichever thread frees them. A block
+// stays with the tag it was allocated under, so a payload encoded on a
+// generation worker and kept by the cache counts where the Scope around
+// its encoding put it. Aligned new is left alone and not counted, as is
+// anything that calls malloc itself (ENet through NetAlloc, VMA, codecs).
+//
+// Without the option the tags, scopes and stats are all still there, and
+// all no-ops: stats() reads zero and enabled() is false.
+namespace MemTags {
+    enum Tag : uint8_t {
+        Untagged,
+        ChunkCache, // encoded chunk payloads, as the caches and stores keep them
+        GenScratch, // generation and edit jobs' working memory
+        Meshing,    // client chunk decode, meshing and colliders
+        Packets,    // network threads and outgoing message queues
+        Inventory,  // the inventory store
+        COUNT
+    };
+
+    const char* name(Tag t);
+
+    struct Stats {
+        int64_t  liveBytes  = 0; // requested sizes, headers not included
+        int64_t  liveBlocks = 0;
+        uint64_t allocs     = 0; // since start
+    };
+
+#ifdef AETHERIS_MEM_TAGS
+    constexpr bool enabled() { return true; }
+    Stats stats(Tag t);
+    Tag   exchange(Tag t); // the calling thread's tag, returning the old one
+    // operator new calls on the calling thread, since it started
+    uint64_t threadAllocs();
+#else
+    constexpr bool enabled() { return false; }
+    inline Stats stats(Tag) { return {}; }
+    inline Tag   exchange(Tag) { return Untagged; }
+#endif
+
+    // Charges the thread's allocations to t until it ends, then puts back
+    // whatever tag was in force
+    class Scope {
+    public:
+        explicit Scope(Tag t) : _prev(exchange(t)) {}
+        ~Scope() { exchange(_prev); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        Tag _prev;
+    };
+
+    // One line of a snapshot: a tag, or whatever else the caller counts
+    // (ENet's pools, GPU heaps)
+    struct Row {
+        std::string name;
+        int64_t     bytes  = 0;
+        int64_t     blocks = 0;
+    };
+
+    // The heap tags, when enabled; empty otherwise
+    inline std::vector<Row> snapshot() {
+        std::vector<Row> rows;
+        if (!enabled()) return rows;
+        for (int t = 0; t < COUNT; t++) {
+            Stats s = stats((Tag)t);
+            rows.push_back({name((Tag)t), s.liveBytes, s.liveBlocks});
+        }
+        return rows;
+    }
+
+    // Keeps the last Config::MEM_LEAK_SAMPLES snapshots. A row that grew at
+    // every one of them, by MEM_LEAK_MIN_BYTES in all, is a suspect: sample()
+    // logs and returns it once, and again only after it has stopped growing
+    // and started over.
+    class Watch {
+    public:
+        struct Suspect {
+            std::string name;
+            int64_t     from = 0, to = 0; // bytes across the window
+        };
+
+        std::vector<Suspect> sample(const std::vector<Row>& rows) {
+            std::vector<Suspect> out;
+            for (const Row& r : rows) {
+                Series& s = _series[r.name];
+                if (!s.bytes.empty() && r.bytes <= s.bytes.back()) {
+                    s.bytes.clear();
+                    s.flagged = false;
+                }
+                s.bytes.push_back(r.bytes);
+                if ((int)s.bytes.size() > Config::MEM_LEAK_SAMPLES) s.bytes.erase(s.bytes.begin());
+                int64_t grown = s.bytes.back() - s.bytes.front();
+                if (!s.flagged && (int)s.bytes.size() == Config::MEM_LEAK_SAMPLES &&
+                    grown >= (int64_t)Config::MEM_LEAK_MIN_BYTES) {
+                    s.flagged = true;
+                    out.push_back({r.name, s.bytes.front(), s.bytes.back()});
+                    Log::warn("Memory: " + r.name + " grew from " + std::to_string(s.bytes.front() >> 20) +
+                              " to " + std::to_string(s.bytes.back() >> 20) + " MB over the last " +
+                              std::to_string(Config::MEM_LEAK_SAMPLES) + " snapshots");
+                }
+            }
+            return out;
+        }
+
+    private:
+        // The current run of growth, oldest first
+        struct Series {
+            std::vector<int64_t> bytes;
+            bool                 flagged = false;
+        };
+        std::unordered_map<std::string, Series> _series;
+    };
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "chunk.h"
+
+// ── Mesh ordering ─────────────────────────────────────────────────────────────
+// Reorders a marched mesh for the GPU without changing what it draws:
+// triangles by Tipsify (Sander, Nehab & Barczak, "Fast Triangle Reordering
+// for Vertex Locality and Reduced Overdraw", 2007), which fans around one
+// vertex at a time and picks the next fan to keep recently used vertices in
+// a post-transform cache of MESH_CACHE_SIZE; then vertices in the order the
+// new indices first use them, so fetches walk the buffer forwards.
+// Vertices no triangle uses are dropped. Linear in the mesh size.
+//
+// The order is deterministic, so a client marching a field itself gets the
+// very mesh the server would have sent.
+inline constexpr int MESH_CACHE_SIZE = 16;
+
+void optimizeMesh(ChunkMesh& mesh);
@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunk.h"
+
+// ── Meshlets ──────────────────────────────────────────────────────────────────
+// Cuts a chunk mesh into runs of at most MESHLET_TRIS triangles, each with
+// its own bounds and normal cone, so the client can cull parts of a chunk:
+// a cliff face seen edge-on, the far side of a hill, the bit of a cave
+// poking out of the frustum. The triangles are first regrouped by the
+// MESHLET_BRICK^3-cell brick their centroid falls in — the mesher emits
+// them column by column, which would make long thin runs with loose
+// bounds and a wide cone. Only the order of the triangles changes.
+inline constexpr int MESHLET_TRIS  = 128;
+inline constexpr int MESHLET_BRICK = 8; // cells
+
+// A cone narrower than this (cosine of the half-angle) is kept; wider ones
+// cull next to nothing and only cost the test
+inline constexpr float MESHLET_CONE_MIN_COS = 0.1f;
+// Taken off the cone's cosine: the client packs positions to a grid, which
+// tips slivers' normals a little
+inline constexpr float MESHLET_CONE_SLACK = 0.05f;
+
+inline void buildMeshlets(ChunkMesh& mesh) {
+    mesh.meshlets.clear();
+    const uint32_t tris = (uint32_t)(mesh.indices.size() / 3);
+    if (tris == 0) return;
+
+    constexpr int B = ChunkData::SIZE / MESHLET_BRICK; // bricks per axis
+    auto cell = [](float v) {
+        return std::clamp((int)std::floor(v / MESHLET_BRICK), 0, B - 1);
+    };
+
+    // Counting sort by brick, stable so each brick keeps the mesher's order
+    static thread_local std::vector<uint16_t> brick;
+    static thread_local std::vector<uint32_t> sorted;
+    uint32_t begin[B * B * B + 1] = {};
+    brick.resize(tris);
+    for (uint32_t t = 0; t < tris; t++) {
+        const uint32_t* i = &mesh.indices[t * 3];
+        glm::vec3 c = (mesh.vertices[i[0]].pos + mesh.vertices[i[1]].pos +
+                       mesh.vertices[i[2]].pos) / 3.f;
+        brick[t] = (uint16_t)((cell(c.x) * B + cell(c.z)) * B + cell(c.y));
+        begin[brick[t] + 1]++;
+    }
+    for (int b = 0; b < B * B * B; b++) begin[b + 1] += begin[b];
+    uint32_t fill[B * B * B];
+    std::copy(begin, begin + B * B * B, fill);
+    sorted.resize(mesh.indices.size());
+    for (uint32_t t = 0; t < tris; t++) {
+        uint32_t d = fill[brick[t]]++;
+        std::copy_n(&mesh.indices[t * 3], 3, &sorted[d * 3]);
+    }
+    mesh.indices.swap(sorted);
+
+    for (int b = 0; b < B * B * B; b++) {
+        for (uint32_t t0 = begin[b]; t0 < begin[b + 1]; t0 += MESHLET_TRIS) {
+            uint32_t t1 = std::min(t0 + (uint32_t)MESHLET_TRIS, begin[b + 1]);
+            Meshlet m;
+            m.firstIndex = t0 * 3;
+            m.indexCount = (t1 - t0) * 3;
+            m.boundsMin  = glm::vec3(1e30f);
+            m.boundsMax  = glm::vec3(-1e30f);
+
+            // Facing as the rasterizer sees it: front faces are the air
+            // side, which is against the winding's cross product (see
+            // cornerGradient) and against the vertex normals
+            auto facing = [&](uint32_t t) {
+                const uint32_t* i = &mesh.indices[t * 3];
+                const glm::vec3& a = mesh.vertices[i[0]].pos;
+                glm::vec3 n = glm::cross(mesh.vertices[i[2]].pos - a, mesh.vertices[i[1]].pos - a);
+                float len = glm::length(n);
+                return len > 1e-12f ? n / len : glm::vec3(0.f);
+            };
+            glm::vec3 sum{0.f};
+            for (uint32_t t = t0; t < t1; t++) {
+                for (int c = 0; c < 3; c++) {
+                    const glm::vec3& p = mesh.vertices[mesh.indices[t * 3 + c]].pos;
+                    m.boundsMin = glm::min(m.boundsMin, p);
+                    m.boundsMax = glm::max(m.boundsMax, p);
+                }
+                sum += facing(t);
+            }
+            float sumLen = glm::length(sum);
+            if (sumLen > 1e-6f) {
+                glm::vec3 axis = sum / sumLen;
+                float minCos = 1.f;
+                for (uint32_t t = t0; t < t1 && minCos >= MESHLET_CONE_MIN_COS; t++) {
+                    glm::vec3 n = facing(t);
+                    if (n != glm::vec3(0.f)) minCos = std::min(minCos, glm::dot(axis, n));
+                }
+                minCos -= MESHLET_CONE_SLACK;
+                if (minCos >= MESHLET_CONE_MIN_COS) {
+                    m.coneAxis   = axis;
+                    m.coneCutoff = std::sqrt(1.f - minCos * minCos);
+                }
+            }
+            mesh.meshlets.push_back(m);
+        }
+    }
+}
@@ -0,0 +1,176 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <variant>
+#include <vector>
+
+// Counters, gauges and histograms cheap enough for hot paths: an update is a
+// relaxed atomic op or two, from any thread, with no lock. They live with
+// whatever they measure; a MetricsRegistry only points at them, names them
+// and renders the Prometheus text format on whichever thread scrapes.
+namespace Metrics {
+
+struct Counter {
+    void     add(uint64_t n = 1) { _v.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const       { return _v.load(std::memory_order_relaxed); }
+private:
+    std::atomic<uint64_t> _v{0};
+};
+
+struct Gauge {
+    void   set(double v) { _v.store(v, std::memory_order_relaxed); }
+    double value() const { return _v.load(std::memory_order_relaxed); }
+private:
+    std::atomic<double> _v{0.0};
+};
+
+// Upper bounds start, start·factor, ... (n of them), plus +Inf
+inline std::vector<double> exponential(double start, double factor, int n) {
+    std::vector<double> b;
+    for (int i = 0; i < n; i++, start *= factor) b.push_back(start);
+    return b;
+}
+
+// 50 µs to ~1.6 s, doubling: ticks, generation stages, auth round trips
+inline std::vector<double> latencyBuckets() { return exponential(50e-6, 2.0, 16); }
+
+class Histogram {
+public:
+    explicit Histogram(std::vector<double> bounds = latencyBuckets())
+        : _bounds(std::move(bounds)), _counts(new std::atomic<uint64_t>[_bounds.size() + 1]) {
+        for (size_t i = 0; i <= _bounds.size(); i++) _counts[i].store(0, std::memory_order_relaxed);
+    }
+
+    void observe(double v) {
+        size_t i = 0;
+        while (i < _bounds.size() && v > _bounds[i]) i++;
+        _counts[i].fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(v, std::memory_order_relaxed);
+    }
+
+    const std::vector<double>& bounds() const { return _bounds; }
+    // Per bucket, not cumulative; the last is past every bound
+    uint64_t count(size_t bucket) const { return _counts[bucket].load(std::memory_order_relaxed); }
+    double   sum() const { return _sum.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<double>                      _bounds;
+    std::unique_ptr<std::atomic<uint64_t>[]> _counts;
+    std::atomic<double>                      _sum{0.0};
+};
+
+using Clock = std::chrono::steady_clock;
+
+inline double secondsSince(Clock::time_point t) {
+    return std::chrono::duration<double>(Clock::now() - t).count();
+}
+
+// Observes its own lifetime, in seconds
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& h) : _h(h), _t0(Clock::now()) {}
+    ~ScopedTimer() { _h.observe(secondsSince(_t0)); }
+    ScopedTimer(const ScopedTimer&)            = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+private:
+    Histogram&        _h;
+    Clock::time_point _t0;
+};
+
+} // namespace Metrics
+
+// Names for metrics owned elsewhere, rendered on demand. Registration and
+// render() take a lock; the metrics themselves never do. Callback metrics
+// run on the rendering thread, so they must only read thread-safe state.
+// Series only one thread can read (per-peer figures kept on the ENet
+// thread, say) are published by that thread as a pre-rendered block.
+class MetricsRegistry {
+public:
+    using Fn = std::function<double()>;
+
+    void add(std::string name, std::string help, const Metrics::Counter& c)   { push(std::move(name), std::move(help), "counter", &c); }
+    void add(std::string name, std::string help, const Metrics::Gauge& g)     { push(std::move(name), std::move(help), "gauge", &g); }
+    void add(std::string name, std::string help, const Metrics::Histogram& h) { push(std::move(name), std::move(help), "histogram", &h); }
+    void addCounterFn(std::string name, std::string help, Fn fn) { push(std::move(name), std::move(help), "counter", std::move(fn)); }
+    void addGaugeFn  (std::string name, std::string help, Fn fn) { push(std::move(name), std::move(help), "gauge", std::move(fn)); }
+
+    // Replaces the block under key; text is complete exposition lines,
+    // HELP/TYPE included
+    void setBlock(const std::string& key, std::string text) {
+        std::lock_guard lk(_mu);
+        _blocks[key] = std::move(text);
+    }
+
+    std::string render() const {
+        std::lock_guard lk(_mu);
+        std::string out;
+        out.reserve(4096);
+        for (const Entry& e : _entries) {
+            out += "# HELP " + e.name + " " + e.help + "\n";
+            out += "# TYPE " + e.name + " " + e.type + "\n";
+            if (auto* c = std::get_if<const Metrics::Counter*>(&e.src)) {
+                line(out, e.name, "", (double)(*c)->value());
+            } else if (auto* g = std::get_if<const Metrics::Gauge*>(&e.src)) {
+                line(out, e.name, "", (*g)->value());
+            } else if (auto* fn = std::get_if<Fn>(&e.src)) {
+                line(out, e.name, "", (*fn)());
+            } else {
+                const Metrics::Histogram& h = *std::get<const Metrics::Histogram*>(e.src);
+                // Cumulative, and count is the buckets' total, so a scrape
+                // racing an observe still reads as a consistent histogram
+                uint64_t cum = 0;
+                for (size_t i = 0; i < h.bounds().size(); i++) {
+                    cum += h.count(i);
+                    char le[32];
+                    snprintf(le, sizeof le, "%g", h.bounds()[i]);
+                    line(out, e.name + "_bucket", std::string("le=\"") + le + "\"", (double)cum);
+                }
+                cum += h.count(h.bounds().size());
+                line(out, e.name + "_bucket", "le=\"+Inf\"", (double)cum);
+                line(out, e.name + "_sum", "", h.sum());
+                line(out, e.name + "_count", "", (double)cum);
+            }
+        }
+        for (const auto& [key, text] : _blocks) out += text;
+        return out;
+    }
+
+    // One sample line; labels without braces, e.g. peer="3"
+    static void line(std::string& out, const std::string& name, const std::string& labels, double v) {
+        char num[32];
+        if (std::isnan(v)) snprintf(num, sizeof num, "NaN");
+        else if (v == std::floor(v) && std::abs(v) < 1e15) snprintf(num, sizeof num, "%.0f", v);
+        else snprintf(num, sizeof num, "%.9g", v);
+        out += name;
+        if (!labels.empty()) out += "{" + labels + "}";
+        out += " ";
+        out += num;
+        out += "\n";
+    }
+
+private:
+    using Source = std::variant<const Metrics::Counter*, const Metrics::Gauge*,
+                                const Metrics::Histogram*, Fn>;
+    struct Entry {
+        std::string name, help;
+        const char* type;
+        Source      src;
+    };
+
+    void push(std::string name, std::string help, const char* type, Source src) {
+        std::lock_guard lk(_mu);
+        _entries.push_back({std::move(name), std::move(help), type, std::move(src)});
+    }
+
+    mutable std::mutex                 _mu;
+    std::vector<Entry>                 _entries;
+    std::map<std::string, std::string> _blocks;
+};
@@ -3,6 +3,8 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cmath>
+#include <algorithm>
 
 // ── Multiplayer Packet IDs ────────────────────────────────────────────────────
 
@@ -12,13 +14,36 @@ enum class MPPacketID : uint8_t {
     PlayerSpawn     = 0x32, // server -> client: a new player appeared
     PlayerDespawn   = 0x33, // server -> client: a player left
     PlayerPosSync   = 0x34, // server -> client: batch position update
+    PlayerPosDelta  = 0x35, // server -> client: delta-encoded batch (CAP_MOVE_DELTA)
+    PlayerMoveQ     = 0x36, // client -> server: quantized move + snapshot ack
+    EnemySync       = 0x37, // server -> client: enemies near the player (movement channel)
+    EnemyHit        = 0x38, // client -> server: a swing landed on an enemy
+    MoveCorrection  = 0x39, // server -> client: a rejected move, and where the player is (movement channel)
+    Replication     = 0x3A, // server -> client: component deltas (replication.h)
+    AdmissionQueue  = 0x3B, // server -> client: verified, waiting to be let in
+    PlayerDefend    = 0x3C, // client -> server: a parry or dodge started
 };
 
 // ── Auth ──────────────────────────────────────────────────────────────────────
 
+// Optional features a client can ask for in AuthRequest. Older clients don't
+// send the field at all, which reads as 0.
+enum ClientCaps : uint32_t {
+    CAP_CHUNK_FIELDS = 1u << 0, // send ChunkField instead of ChunkData meshes
+    CAP_MOVE_DELTA   = 1u << 1, // PlayerMoveQ / PlayerPosDelta on the movement channel
+    CAP_LOD_CHUNKS   = 1u << 2, // LOD meshes past the full-resolution radius (ViewTiers)
+    CAP_MOVE_PREDICT = 1u << 3, // PlayerMoveQ carries input seq + epoch; moves are checked, MoveCorrection answers
+    CAP_CHUNK_ZSTD   = 1u << 4, // can take ChunkPacked payloads compressed with zstd (chunk_codec.h)
+    CAP_CHUNK_LZ4    = 1u << 5, // ...and with LZ4
+    CAP_REPLICATION  = 1u << 6, // takes Replication packets (ReplicationClient)
+};
+
 struct AuthRequestPacket {
     std::string username;
     std::string token;
+    uint32_t    caps = 0;
+    uint8_t     viewRadius = Config::CHUNK_RADIUS_XZ; // chunks; answered with ViewConfig
+    uint8_t     chunkSize  = Config::CHUNK_SIZE;      // what it was built with; the server's has to match
 
     std::vector<uint8_t> serialize() const {
         std::vector<uint8_t> b;
@@ -27,15 +52,23 @@ struct AuthRequestPacket {
         b.insert(b.end(), username.begin(), username.end());
         writeU32(b, (uint32_t)token.size());
         b.insert(b.end(), token.begin(), token.end());
+        writeU32(b, caps);
+        writeU8(b, viewRadius);
+        writeU8(b, chunkSize);
         return b;
     }
 
+    // Comes from unauthenticated peers — a truncated packet yields empty
+    // fields rather than reading past the end
     static AuthRequestPacket deserialize(const uint8_t* d, size_t len) {
-        AuthRequestPacket p; size_t o = 1;
-        uint32_t uLen = readU32(d, o);
-        p.username.assign((const char*)d + o, uLen); o += uLen;
-        uint32_t tLen = readU32(d, o);
-        p.token.assign((const char*)d + o, tLen); o += tLen;
+        AuthRequestPacket p;
+        PacketReader r(d, len);
+        p.username = r.str();
+        p.token    = r.str();
+        if (r.has(4)) p.caps = r.u32();
+        if (r.has(1)) p.viewRadius = r.u8();
+        p.chunkSize = r.has(1) ? r.u8() : 32; // clients from before it had 32
+        if (!r.ok()) p = {};
         return p;
     }
 };
@@ -56,11 +89,11 @@ struct AuthResponsePacket {
     }
 
     static AuthResponsePacket deserialize(const uint8_t* d, size_t len) {
-        AuthResponsePacket p; size_t o = 1;
-        p.accepted = readU8(d, o);
-        p.playerId = readU32(d, o);
-        uint32_t mLen = readU32(d, o);
-        p.message.assign((const char*)d + o, mLen);
+        AuthResponsePacket p;
+        PacketReader r(d, len);
+        p.accepted = r.u8();
+        p.playerId = r.u32();
+        p.message  = r.str();
         return p;
     }
 };
@@ -85,12 +118,12 @@ struct PlayerSpawnPacket {
     }
 
     static PlayerSpawnPacket deserialize(const uint8_t* d, size_t len) {
-        PlayerSpawnPacket p; size_t o = 1;
-        p.playerId = readU32(d, o);
-        uint32_t nLen = readU32(d, o);
-        p.username.assign((const char*)d + o, nLen); o += nLen;
-        p.x = readF32(d, o); p.y = readF32(d, o); p.z = readF32(d, o);
-        p.yaw = readF32(d, o);
+        PlayerSpawnPacket p;
+        PacketReader r(d, len);
+        p.playerId = r.u32();
+        p.username = r.str();
+        p.x = r.f32(); p.y = r.f32(); p.z = r.f32();
+        p.yaw = r.f32();
         return p;
     }
 };
@@ -114,6 +147,9 @@ struct PlayerDespawnPacket {
 
 // ── Position batch sync (server -> all clients, 20 Hz) ───────────────────────
 // Contains all connected players' positions in one packet for efficiency.
+// timeMs is the server clock (ms since it started, wrapping) when the batch
+// was taken, so clients can place snapshots on the server's timeline rather
+// than their arrival's. It trails the entries; older servers leave it off.
 
 struct PlayerPosEntry {
     uint32_t playerId;
@@ -123,29 +159,480 @@ struct PlayerPosEntry {
 
 struct PlayerPosSyncPacket {
     std::vector<PlayerPosEntry> players;
+    uint32_t timeMs = 0;
+    bool     timed  = false; // timeMs was on the wire
 
-    std::vector<uint8_t> serialize() const {
-        std::vector<uint8_t> b;
-        writeU8(b, (uint8_t)MPPacketID::PlayerPosSync);
-        writeU32(b, (uint32_t)players.size());
+    static constexpr size_t ENTRY_BYTES = 4 + 5 * 4;
+
+    size_t bytes() const { return 1 + 4 + players.size() * ENTRY_BYTES + 4; }
+
+    void write(PacketWriter& w) const {
+        w.begin((uint8_t)MPPacketID::PlayerPosSync, bytes());
+        w.u32((uint32_t)players.size());
         for (const auto& p : players) {
-            writeU32(b, p.playerId);
-            writeF32(b, p.x); writeF32(b, p.y); writeF32(b, p.z);
-            writeF32(b, p.yaw); writeF32(b, p.pitch);
+            w.u32(p.playerId);
+            w.f32(p.x).f32(p.y).f32(p.z);
+            w.f32(p.yaw).f32(p.pitch);
         }
-        return b;
+        w.u32(timeMs);
+    }
+
+    std::vector<uint8_t> serialize() const {
+        PacketWriter w(bytes());
+        write(w);
+        return w.toVector();
     }
 
     static PlayerPosSyncPacket deserialize(const uint8_t* d, size_t len) {
-        PlayerPosSyncPacket pkt; size_t o = 1;
-        uint32_t count = readU32(d, o);
-        pkt.players.resize(count);
-        for (uint32_t i = 0; i < count; i++) {
-            auto& p = pkt.players[i];
-            p.playerId = readU32(d, o);
-            p.x = readF32(d, o); p.y = readF32(d, o); p.z = readF32(d, o);
-            p.yaw = readF32(d, o); p.pitch = readF32(d, o);
-        }
+        PlayerPosSyncPacket pkt;
+        deserialize(d, len, pkt);
         return pkt;
     }
+
+    // Into out, reusing its list; false (out emptied) if the count doesn't fit
+    static bool deserialize(const uint8_t* d, size_t len, PlayerPosSyncPacket& out) {
+        PacketReader r(d, len);
+        uint32_t count = r.u32();
+        out.players.clear();
+        out.timed = false;
+        if (count > r.remaining() / ENTRY_BYTES) return false;
+        out.players.resize(count);
+        for (auto& p : out.players) {
+            p.playerId = r.u32();
+            p.x = r.f32(); p.y = r.f32(); p.z = r.f32();
+            p.yaw = r.f32(); p.pitch = r.f32();
+        }
+        out.timed = r.has(4);
+        if (out.timed) out.timeMs = r.u32();
+        return true;
+    }
+};
+
+// ── Compact movement (CAP_MOVE_DELTA) ─────────────────────────────────────────
+// Both directions travel unreliable-sequenced on Net::CHANNEL_MOVEMENT, so a
+// lost update is simply superseded by the next one instead of retransmitted.
+//
+// Positions are fixed point at 1/POS_UNITS block. On the wire an absolute
+// position is its chunk (i16 ×3) plus the offset inside it (u16 ×3); yaw is
+// u16 over 360°, pitch i8 over ±90°.
+
+namespace MoveQuant {
+    inline constexpr int32_t POS_UNITS  = 1024;
+    // A grid of its own, not ChunkData::SIZE's: at 64 the offset would
+    // outgrow its u16
+    inline constexpr int32_t CHUNK_UNITS = POS_UNITS * 32;
+
+    inline int32_t pos(float v) { return (int32_t)std::lround(v * POS_UNITS); }
+    inline float   pos(int32_t q) { return (float)q / POS_UNITS; }
+
+    inline uint16_t yaw(float deg) {
+        float w = std::fmod(deg, 360.f);
+        if (w < 0.f) w += 360.f;
+        return (uint16_t)std::lround(w / 360.f * 65536.f);
+    }
+    inline float yaw(uint16_t q) { return q * (360.f / 65536.f); }
+
+    inline int8_t pitch(float deg) {
+        return (int8_t)std::lround(std::clamp(deg, -90.f, 90.f) / 90.f * 127.f);
+    }
+    inline float pitch(int8_t q) { return q * (90.f / 127.f); }
+
+    inline int32_t floorDiv(int32_t v, int32_t d) { return v >= 0 ? v / d : -((-v + d - 1) / d); }
+
+    inline void writeAbs(PacketWriter& w, const int32_t q[3]) {
+        for (int i = 0; i < 3; i++) w.i16((int16_t)floorDiv(q[i], CHUNK_UNITS));
+        for (int i = 0; i < 3; i++) w.u16((uint16_t)(q[i] - floorDiv(q[i], CHUNK_UNITS) * CHUNK_UNITS));
+    }
+    inline void readAbs(PacketReader& r, int32_t q[3]) {
+        int32_t c[3];
+        for (int i = 0; i < 3; i++) c[i] = r.i16();
+        for (int i = 0; i < 3; i++) q[i] = c[i] * CHUNK_UNITS + r.u16();
+    }
+}
+
+// Client -> server, replaces PlayerMove for CAP_MOVE_DELTA clients. ack is
+// the newest PlayerPosDelta snapshot received (NO_ACK before the first), so
+// the server can delta against something the client is known to have.
+// CAP_MOVE_PREDICT clients add the input the position is the result of and
+// the newest correction epoch they've applied (see MoveCorrectionPacket).
+//   u8 id | u16 ack | abs pos (12) | u16 yaw | i8 pitch | [u16 seq | u8 epoch]
+struct PlayerMoveQPacket {
+    static constexpr uint16_t NO_ACK = 0xFFFF;
+    static constexpr size_t   BYTES  = 1 + 2 + 12 + 2 + 1;
+    static constexpr size_t   PREDICT_BYTES = 3;
+
+    float    x = 0, y = 0, z = 0;
+    float    yaw = 0, pitch = 0;
+    uint16_t ack = NO_ACK;
+    bool     predicted = false;
+    uint16_t seq   = 0;
+    uint8_t  epoch = 0;
+
+    void write(PacketWriter& w) const {
+        int32_t q[3] = {MoveQuant::pos(x), MoveQuant::pos(y), MoveQuant::pos(z)};
+        w.begin((uint8_t)MPPacketID::PlayerMoveQ, BYTES + (predicted ? PREDICT_BYTES : 0));
+        w.u16(ack);
+        MoveQuant::writeAbs(w, q);
+        w.u16(MoveQuant::yaw(yaw)).u8((uint8_t)MoveQuant::pitch(pitch));
+        if (predicted) w.u16(seq).u8(epoch);
+    }
+
+    std::vector<uint8_t> serialize() const {
+        PacketWriter w(BYTES);
+        write(w);
+        return w.toVector();
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, PlayerMoveQPacket& out) {
+        if (len < BYTES) return false;
+        PacketReader r(d, len);
+        out.ack = r.u16();
+        int32_t q[3];
+        MoveQuant::readAbs(r, q);
+        out.x = MoveQuant::pos(q[0]); out.y = MoveQuant::pos(q[1]); out.z = MoveQuant::pos(q[2]);
+        out.yaw   = MoveQuant::yaw(r.u16());
+        out.pitch = MoveQuant::pitch((int8_t)r.u8());
+        out.predicted = r.has(PREDICT_BYTES);
+        if (out.predicted) {
+            out.seq   = r.u16();
+            out.epoch = r.u8();
+        }
+        return true;
+    }
+};
+
+// Server -> client, movement channel: the move for input seq was refused,
+// and the player is at pos with vel instead. The client rewinds to seq,
+// takes this state and replays its later inputs on top. Each correction
+// starts a new epoch; moves from an older one were made before the client
+// heard, so the server doesn't judge them again (and resends the
+// correction if they keep coming, in case it was lost).
+//   u8 id | u16 seq | u8 epoch | abs pos (12) | i16 vel x,y,z at 1/VEL_UNITS m/s
+struct MoveCorrectionPacket {
+    static constexpr size_t BYTES     = 1 + 2 + 1 + 12 + 6;
+    static constexpr float  VEL_UNITS = 128.f;
+
+    uint16_t  seq   = 0;
+    uint8_t   epoch = 0;
+    glm::vec3 pos{0.f};
+    glm::vec3 vel{0.f};
+
+    void write(PacketWriter& w) const {
+        int32_t q[3] = {MoveQuant::pos(pos.x), MoveQuant::pos(pos.y), MoveQuant::pos(pos.z)};
+        w.begin((uint8_t)MPPacketID::MoveCorrection, BYTES);
+        w.u16(seq).u8(epoch);
+        MoveQuant::writeAbs(w, q);
+        for (int i = 0; i < 3; i++)
+            w.i16((int16_t)std::lround(std::clamp(vel[i] * VEL_UNITS, -32767.f, 32767.f)));
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, MoveCorrectionPacket& out) {
+        if (len < BYTES) return false;
+        PacketReader r(d, len);
+        out.seq   = r.u16();
+        out.epoch = r.u8();
+        int32_t q[3];
+        MoveQuant::readAbs(r, q);
+        out.pos = {MoveQuant::pos(q[0]), MoveQuant::pos(q[1]), MoveQuant::pos(q[2])};
+        for (int i = 0; i < 3; i++) out.vel[i] = r.i16() / VEL_UNITS;
+        return true;
+    }
+};
+
+// Server -> client position snapshot, delta-encoded against the snapshot the
+// client last acked (baseline NO_BASE = everything absolute).
+//   u8 id | u16 seq | u16 baseline | u16 count | entries
+// Entry: LEB128 playerId | u8 flags | [i16 dx,dy,dz | abs pos] | [u16 yaw, i8 pitch]
+// then u32 timeMs, as in PlayerPosSyncPacket.
+// An entry with no flags means "unchanged since baseline" — still listed so
+// the client knows the player is in range.
+namespace PosDelta {
+    inline constexpr uint16_t NO_BASE    = 0xFFFF;
+    inline constexpr uint8_t  F_POS_DELTA = 1 << 0;
+    inline constexpr uint8_t  F_POS_ABS   = 1 << 1;
+    inline constexpr uint8_t  F_ROT       = 1 << 2;
+
+    struct Entry {
+        uint32_t id;
+        int32_t  q[3];
+        uint16_t yaw;
+        int8_t   pitch;
+    };
+    // Sorted by id
+    using Snapshot = std::vector<Entry>;
+
+    inline const Entry* find(const Snapshot& s, uint32_t id) {
+        auto it = std::lower_bound(s.begin(), s.end(), id,
+                                   [](const Entry& e, uint32_t v) { return e.id < v; });
+        return (it != s.end() && it->id == id) ? &*it : nullptr;
+    }
+
+    // Snapshots kept for baselines. The decoder keeps twice the encoder's
+    // window so any baseline the encoder may still pick is on hand.
+    inline constexpr int ENCODE_WINDOW = 32;
+    inline constexpr int DECODE_WINDOW = ENCODE_WINDOW * 2;
+}
+
+// One per receiving client, server side
+class PosDeltaEncoder {
+public:
+    void ack(uint16_t seq) {
+        if (seq == PlayerMoveQPacket::NO_ACK) return;
+        // Only move forward (16-bit wrap), and only to something we sent
+        if (_acked != PosDelta::NO_BASE && (int16_t)(seq - _acked) <= 0) return;
+        if ((int16_t)(_seq - seq) <= 0) return;
+        _acked = seq;
+    }
+
+    // Writes the PlayerPosDelta packet into w; a keyframe takes no baseline
+    void encode(const std::vector<PlayerPosEntry>& players, uint32_t timeMs, PacketWriter& w,
+                bool keyframe = false) {
+        using namespace PosDelta;
+        Snapshot snap;
+        snap.reserve(players.size());
+        for (const auto& p : players)
+            snap.push_back({p.playerId, {MoveQuant::pos(p.x), MoveQuant::pos(p.y), MoveQuant::pos(p.z)},
+                            MoveQuant::yaw(p.yaw), MoveQuant::pitch(p.pitch)});
+        std::sort(snap.begin(), snap.end(), [](const Entry& a, const Entry& b) { return a.id < b.id; });
+
+        const Snapshot* base = nullptr;
+        if (!keyframe && _acked != NO_BASE && (uint16_t)(_seq - _acked) < ENCODE_WINDOW) {
+            const Slot& s = _ring[_acked % ENCODE_WINDOW];
+            if (s.seq == _acked) base = &s.snap;
+        }
+
+        w.begin((uint8_t)MPPacketID::PlayerPosDelta, 11 + snap.size() * 21); // worst case: 5-byte id, abs pos, rot
+        w.u16(_seq);
+        w.u16(base ? _acked : NO_BASE);
+        w.u16((uint16_t)snap.size());
+        for (const Entry& e : snap) {
+            w.varint(e.id);
+            const Entry* be = base ? find(*base, e.id) : nullptr;
+            uint8_t flags = 0;
+            int32_t dq[3] = {0, 0, 0};
+            if (be) {
+                bool fits = true, moved = false;
+                for (int i = 0; i < 3; i++) {
+                    dq[i] = e.q[i] - be->q[i];
+                    fits  &= dq[i] >= INT16_MIN && dq[i] <= INT16_MAX;
+                    moved |= dq[i] != 0;
+                }
+                if (moved) flags |= fits ? F_POS_DELTA : F_POS_ABS;
+                if (e.yaw != be->yaw || e.pitch != be->pitch) flags |= F_ROT;
+            } else {
+                flags = F_POS_ABS | F_ROT;
+            }
+            w.u8(flags);
+            if (flags & F_POS_DELTA)
+                for (int i = 0; i < 3; i++) w.i16((int16_t)dq[i]);
+            if (flags & F_POS_ABS) MoveQuant::writeAbs(w, e.q);
+            if (flags & F_ROT) w.u16(e.yaw).u8((uint8_t)e.pitch);
+        }
+        w.u32(timeMs);
+
+        _ring[_seq % ENCODE_WINDOW] = {_seq, std::move(snap)};
+        _seq = (uint16_t)(_seq + 1);
+        if (_seq == NO_BASE) _seq = 0;
+    }
+
+private:
+    struct Slot {
+        uint16_t           seq = PosDelta::NO_BASE;
+        PosDelta::Snapshot snap;
+    };
+    Slot     _ring[PosDelta::ENCODE_WINDOW];
+    uint16_t _seq   = 0;
+    uint16_t _acked = PosDelta::NO_BASE;
+};
+
+// Client side: turns PlayerPosDelta back into absolute positions and tracks
+// what to ack
+class PosDeltaDecoder {
+public:
+    // False (and out untouched) if the packet is malformed or its baseline
+    // has already been dropped
+    bool decode(const uint8_t* d, size_t len, PlayerPosSyncPacket& out) {
+        using namespace PosDelta;
+        if (len < 7) return false;
+        PacketReader r(d, len);
+        uint16_t seq      = r.u16();
+        uint16_t baseline = r.u16();
+        uint16_t count    = r.u16();
+
+        const Snapshot* base = nullptr;
+        if (baseline != NO_BASE) {
+            const Slot& s = _ring[baseline % DECODE_WINDOW];
+            if (s.seq != baseline) return false;
+            base = &s.snap;
+        }
+
+        Snapshot& snap = _scratch;
+        snap.clear();
+        snap.reserve(count);
+        for (uint16_t i = 0; i < count && r.ok(); i++) {
+            Entry e{};
+            e.id = r.varint();
+            uint8_t flags = r.u8();
+            const Entry* be = base ? find(*base, e.id) : nullptr;
+            if (!be && (!(flags & F_POS_ABS) || !(flags & F_ROT))) return false;
+
+            if (be) e = {e.id, {be->q[0], be->q[1], be->q[2]}, be->yaw, be->pitch};
+            if (flags & F_POS_DELTA)
+                for (int k = 0; k < 3; k++) e.q[k] += r.i16();
+            if (flags & F_POS_ABS) MoveQuant::readAbs(r, e.q);
+            if (flags & F_ROT) { e.yaw = r.u16(); e.pitch = (int8_t)r.u8(); }
+            snap.push_back(e);
+        }
+        if (!r.ok()) return false;
+
+        out.timed = r.has(4);
+        if (out.timed) out.timeMs = r.u32();
+        out.players.clear();
+        for (const Entry& e : snap)
+            out.players.push_back({e.id, MoveQuant::pos(e.q[0]), MoveQuant::pos(e.q[1]),
+                                   MoveQuant::pos(e.q[2]), MoveQuant::yaw(e.yaw),
+                                   MoveQuant::pitch(e.pitch)});
+        // The slot's old snapshot is the next one's buffer
+        Slot& slot = _ring[seq % DECODE_WINDOW];
+        slot.seq   = seq;
+        std::swap(slot.snap, _scratch);
+        _latest = seq;
+        return true;
+    }
+
+    // Goes into the next PlayerMoveQ
+    uint16_t ack() const { return _latest; }
+
+    void reset() { *this = {}; }
+
+private:
+    struct Slot {
+        uint16_t           seq = PosDelta::NO_BASE;
+        PosDelta::Snapshot snap;
+    };
+    Slot               _ring[PosDelta::DECODE_WINDOW];
+    PosDelta::Snapshot _scratch; // decode's
+    uint16_t           _latest = PlayerMoveQPacket::NO_ACK;
+};
+
+// ── Enemies ───────────────────────────────────────────────────────────────────
+// The server owns enemy AI and health; clients get every enemy in their
+// interest range each enemy broadcast, unreliable on the movement channel.
+// An enemy missing from updates for REMOTE_STALE_S is dropped client side.
+//   u8 id | u16 count | entries
+// Entry: LEB128 enemyId | abs pos (12) | u8 ai state | u8 health (of 255)
+
+struct EnemySyncEntry {
+    uint32_t id;
+    float    x, y, z;
+    uint8_t  ai;
+    uint8_t  health;
+};
+
+struct EnemySyncPacket {
+    std::vector<EnemySyncEntry> enemies;
+
+    static constexpr size_t MAX_ENTRY_BYTES = 5 + 12 + 2;
+
+    void write(PacketWriter& w) const {
+        w.begin((uint8_t)MPPacketID::EnemySync, 3 + enemies.size() * MAX_ENTRY_BYTES);
+        w.u16((uint16_t)enemies.size());
+        for (const auto& e : enemies) {
+            int32_t q[3] = {MoveQuant::pos(e.x), MoveQuant::pos(e.y), MoveQuant::pos(e.z)};
+            w.varint(e.id);
+            MoveQuant::writeAbs(w, q);
+            w.u8(e.ai).u8(e.health);
+        }
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, EnemySyncPacket& out) {
+        PacketReader r(d, len);
+        uint16_t count = r.u16();
+        if (count > r.remaining() / (1 + 12 + 2)) return false;
+        out.enemies.resize(count);
+        for (auto& e : out.enemies) {
+            e.id = r.varint();
+            int32_t q[3];
+            MoveQuant::readAbs(r, q);
+            e.x = MoveQuant::pos(q[0]); e.y = MoveQuant::pos(q[1]); e.z = MoveQuant::pos(q[2]);
+            e.ai     = r.u8();
+            e.health = r.u8();
+        }
+        return r.ok();
+    }
+};
+
+// Client -> server when the local hitbox overlaps a replicated enemy. The
+// server looks the damage up from the move itself and checks the attacker
+// is in reach, so a client can only claim hits, not their size.
+//   u8 id | LEB128 enemyId | u8 move | f32 dirX | f32 dirZ
+struct EnemyHitPacket {
+    enum Move : uint8_t { Light = 0, Heavy = 1 };
+
+    uint32_t enemyId = 0;
+    uint8_t  move    = Light;
+    float    dirX = 0.f, dirZ = 0.f; // knockback direction
+
+    std::vector<uint8_t> serialize() const {
+        PacketWriter w(1 + 5 + 1 + 8);
+        w.begin((uint8_t)MPPacketID::EnemyHit);
+        w.varint(enemyId).u8(move).f32(dirX).f32(dirZ);
+        return w.toVector();
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, EnemyHitPacket& out) {
+        PacketReader r(d, len);
+        out.enemyId = r.varint();
+        out.move    = r.u8();
+        out.dirX    = r.f32();
+        out.dirZ    = r.f32();
+        return r.ok();
+    }
+};
+
+// Client -> server the moment a parry or dodge starts, so the server can
+// honour its window against enemy attacks. The server times the window
+// itself, from when this arrives, and refuses one still cooling down.
+//   u8 id | u8 kind
+struct PlayerDefendPacket {
+    enum Kind : uint8_t { Parry = 0, Dodge = 1 };
+
+    uint8_t kind = Parry;
+
+    std::vector<uint8_t> serialize() const {
+        PacketWriter w(2);
+        w.begin((uint8_t)MPPacketID::PlayerDefend);
+        w.u8(kind);
+        return w.toVector();
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, PlayerDefendPacket& out) {
+        PacketReader r(d, len);
+        out.kind = r.u8();
+        return r.ok() && out.kind <= Dodge;
+    }
+};
+
+// Server -> client while a verified login waits in the admission queue, each
+// time its place changes (at most every ADMIT_NOTIFY_MS). Position 1 is
+// next in; the AuthResponse follows once it's let in.
+//   u8 id | u16 position | u16 waiting
+struct AdmissionQueuePacket {
+    static constexpr size_t BYTES = 1 + 2 + 2;
+
+    uint16_t position = 0;
+    uint16_t waiting  = 0;
+
+    void write(PacketWriter& w) const {
+        w.begin((uint8_t)MPPacketID::AdmissionQueue, BYTES);
+        w.u16(position).u16(waiting);
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, AdmissionQueuePacket& out) {
+        if (len < BYTES) return false;
+        PacketReader r(d, len);
+        out.position = r.u16();
+        out.waiting  = r.u16();
+        return r.ok();
+    }
 };
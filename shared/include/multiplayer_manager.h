@@ -1,12 +1,30 @@
 #pragma once
 #include <enet/enet.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
 #include <glm/vec3.hpp>
 #include "mp_packets.h"
+#include "shard_packets.h"
+#include "chunk.h"
 #include "http_client.h"
-#include "net_common.h"
+#include "session_token.h"
+#include "interest_grid.h"
+#include "async.h"
+#include "outbox.h"
+#include "player_registry.h"
+#include "thread_pool.h"
+#include "config.h"
 #include "log.h"
+#include "metrics.h"
 
 struct ConnectedPlayer {
     uint32_t    id = 0;
@@ -17,188 +35,615 @@ struct ConnectedPlayer {
     glm::vec3   pos{0.f};
     float       yaw   = 0.f;
     float       pitch = 0.f;
+
+    // CAP_MOVE_DELTA clients get PlayerPosDelta on the movement channel;
+    // older clients keep the reliable PlayerPosSync batch
+    bool            deltaSync = false;
+    PosDeltaEncoder posEnc;
+
+    // As a receiver: what it was last sent about each player in range, and
+    // when its next broadcast may go (see Config::POS_SEND_EPS)
+    struct SentPos {
+        glm::vec3 pos{0.f};
+        float     yaw    = 0.f;
+        float     pitch  = 0.f;
+        uint32_t  tick   = 0;     // broadcast that last found it in range
+        bool      moving = false; // moved in the last batch: the next one settles it
+    };
+    std::unordered_map<uint32_t, SentPos> posSent;
+    std::chrono::steady_clock::time_point posDue, posLastSent, posKeyframe;
+
+    // CAP_MOVE_PREDICT clients have their moves checked; see
+    // Config::MOVE_CHECK_SPEED
+    bool      predicted    = false;
+    bool      moveFresh    = true;  // no move since the last spawn: full bank
+    uint8_t   moveEpoch    = 0;     // corrections sent
+    uint16_t  correctedSeq = 0;     // input the latest correction refused
+    float     moveBank     = 0.f;   // metres the next moves may cover
+    glm::vec3 moveVel{0.f};         // between the last two accepted moves
+    std::chrono::steady_clock::time_point lastMove, correctedAt;
 };
 
+// Signed session tokens (session_token.h) are checked on the spot against
+// the keys loaded with setAuthKeys or reread by refreshAuthKeys. Older
+// opaque tokens, and signed ones under a key not seen yet, are verified
+// by the auth server on a small worker pool so a slow or dead auth server
+// never stalls the ENet thread: each is a coroutine on the AsyncLoop, which
+// finishes it on the ENet thread once the answer is in. Guests and recently
+// verified tokens are answered immediately.
+//
+// An unreachable auth server lets the player in as a guest only while no
+// signing keys are held: once they are, the website issues signed tokens
+// and an unverifiable one is refused.
+//
+// A login in progress and a player once in are components of the peer's
+// entity in the PlayerRegistry (PendingAuth, ConnectedPlayer).
 class MultiplayerManager {
 public:
     std::string authHost = "127.0.0.1";
     int         authPort = 8080;
+    int         authConcurrency = Config::AUTH_CONCURRENCY; // set before first login
+    std::string authKeysPath;    // --auth-keys; empty: none, only the auth server verifies
+    bool        offline  = false; // tokens aren't verified; everyone joins as their own name (replay)
+
+    // Called on the ENet thread when the auth server's answer lets a peer
+    // straight in (not held)
+    using AcceptFn = std::function<void(ENetPeer*, const AuthRequestPacket&)>;
+    AcceptFn onAccept;
+
+    // Seconds from AuthRequest to acceptance: ~0 for guests, signed and
+    // cached tokens, the auth server's round trip for the rest
+    Metrics::Histogram authSeconds;
+
+    // Signing keys as "<kid> <hex>" lines (--auth-keys); false if there
+    // were none
+    bool setAuthKeys(const std::string& text) { return _tokens.setKeys(text); }
+    size_t authKeyCount() const { return _tokens.keyCount(); }
+
+    // Rereads the keys from authKeysPath and fetches the revocation list
+    // from the auth server, off the ENet thread, and puts them in place
+    // once they're in. Every AUTH_KEYS_REFRESH_S. The keys only ever come
+    // from the file: whoever holds them can sign sessions.
+    void refreshAuthKeys() {
+        if (offline || _keysFetching) return;
+        if (!_authPool) _authPool = std::make_unique<ThreadPool>(std::max(1, authConcurrency));
+        _keysFetching = true;
+        _loop.spawn(fetchKeys());
+    }
+
+    MultiplayerManager(Outbox& out, PlayerRegistry& players, AsyncLoop& loop)
+        : _out(out), _players(players), _loop(loop) {}
+
+    // Move checks run on steady_clock unless this says otherwise (replay)
+    void setClock(std::function<std::chrono::steady_clock::time_point()> now) {
+        _now   = std::move(now);
+        _start = _now();
+    }
 
     void onPeerConnect(ENetPeer* peer) {
         // Don't assign player ID yet - wait for auth
-        _pending[peer] = {};
+        _players.emplace<PendingAuth>(peer, PendingAuth{.ticket = _nextTicket++});
     }
 
-    void onPeerDisconnect(ENetPeer* peer, ENetHost* host) {
-        _pending.erase(peer);
-        auto it = _peerToId.find(peer);
-        if (it == _peerToId.end()) return;
-        uint32_t pid = it->second;
+    void onPeerDisconnect(ENetPeer* peer) {
+        _players.erase<PendingAuth>(peer); // an in-flight verification is dropped on return
+        ConnectedPlayer* me = getPlayer(peer);
+        if (!me) return;
+        uint32_t pid = me->id;
 
         // Broadcast despawn to all other players
         PlayerDespawnPacket dp{pid};
         auto bytes = dp.serialize();
-        for (auto& [otherId, other] : _players) {
-            if (otherId == pid || !other.authenticated) continue;
-            Net::sendReliable(other.peer, bytes);
+        for (const ConnectedPlayer& other : _players.all<ConnectedPlayer>()) {
+            if (other.id == pid || !other.authenticated) continue;
+            _out.reliable(other.peer, bytes);
         }
 
-        Log::info("Player left: " + _players[pid].username + " (id=" + std::to_string(pid) + ")");
-        _players.erase(pid);
-        _peerToId.erase(it);
+        Log::info("Player left: %s (id=%u)", me->username, pid);
+        _ids.erase(pid);
+        _players.erase<ConnectedPlayer>(peer);
     }
 
-    // Returns true if auth was handled (whether accepted or rejected)
-    bool onAuthRequest(ENetPeer* peer, const AuthRequestPacket& req, ENetHost* host) {
-        // Verify token with auth server
-        std::string path = "/api/verify?token=" + req.token;
-        auto resp = HttpClient::get(authHost.c_str(), authPort, path.c_str());
-
-        bool valid = false;
-        std::string serverUid;
-        std::string serverUsername;
-
-        if (resp.ok()) {
-            // Minimal JSON parse - look for "valid":true
-            valid = resp.body.find("\"valid\":true") != std::string::npos ||
-                    resp.body.find("\"valid\": true") != std::string::npos;
-            if (valid) {
-                // Extract username from response
-                auto upos = resp.body.find("\"username\":\"");
-                if (upos == std::string::npos) upos = resp.body.find("\"username\": \"");
-                if (upos != std::string::npos) {
-                    auto start = resp.body.find('"', upos + 10);
-                    if (start != std::string::npos) {
-                        start++;
-                        auto end = resp.body.find('"', start);
-                        if (end != std::string::npos)
-                            serverUsername = resp.body.substr(start, end - start);
-                    }
-                }
-                auto uidpos = resp.body.find("\"uid\":\"");
-                if (uidpos == std::string::npos) uidpos = resp.body.find("\"uid\": \"");
-                if (uidpos != std::string::npos) {
-                    auto start = resp.body.find('"', uidpos + 5);
-                    if (start != std::string::npos) {
-                        start++;
-                        auto end = resp.body.find('"', start);
-                        if (end != std::string::npos)
-                            serverUid = resp.body.substr(start, end - start);
-                    }
+    // Asked before a verified login enters the world; true holds it back
+    // until enter(). Logins handed over by another shard don't wait.
+    using HoldFn = std::function<bool(ENetPeer*)>;
+    HoldFn hold;
+
+    // Returns true if the peer was accepted right away. False if it was
+    // rejected, already authenticated, held, or verification is in flight —
+    // in which case verify() finishes it.
+    bool onAuthRequest(ENetPeer* peer, const AuthRequestPacket& req) {
+        PendingAuth* pend = _players.get<PendingAuth>(peer);
+        if (!pend || pend->verifying || pend->held) return false; // duplicate
+        pend->requested = Clock::now();
+
+        // Guest connections (no token) never hit the auth server
+        if (req.token.empty() || offline) {
+            return login(peer, req, req.username.empty() ? "Guest" : req.username,
+                         "guest_" + std::to_string((uintptr_t)peer));
+        }
+
+        if (SessionTokens::isSigned(req.token)) {
+            SessionTokens::Claims c;
+            auto res = _tokens.verify(req.token, unixNow(), c);
+            if (res == SessionTokens::Result::Valid) return login(peer, req, c.username, c.uid);
+            // A key newer than ours goes to the auth server, which has it
+            if (res != SessionTokens::Result::UnknownKey) {
+                Log::warn("Session token refused (%s): %s", SessionTokens::name(res), req.username);
+                refuse(peer);
+                return false;
+            }
+        }
+
+        auto cached = _verified.find(req.token);
+        if (cached != _verified.end()) {
+            if (Clock::now() < cached->second.expires)
+                return login(peer, req, cached->second.username, cached->second.uid);
+            _verified.erase(cached);
+        }
+
+        // Verify token with auth server, off the ENet thread
+        if (!_authPool) _authPool = std::make_unique<ThreadPool>(std::max(1, authConcurrency));
+        pend->verifying = true;
+        _loop.spawn(verify(peer, pend->ticket, req));
+        return false;
+    }
+
+    // Some verification is still waiting on the auth server
+    bool authBusy() const {
+        for (const PendingAuth& p : _players.all<PendingAuth>())
+            if (p.verifying) return true;
+        return false;
+    }
+
+    // A held login, into the world; false if it isn't held (it left).
+    // req is what it asked with, for the caller's own connect setup.
+    bool enter(ENetPeer* peer, AuthRequestPacket& req) {
+        PendingAuth* pend = _players.get<PendingAuth>(peer);
+        if (!pend || !pend->held) return false;
+        PendingAuth p = std::move(*pend);
+        req = std::move(p.req);
+        accept(peer, req, p.username, p.uid);
+        return true;
+    }
+
+    // A player another shard handed over (ShardHandoff), logging in with
+    // its ticket: accepted as who they were there, with the same id, where
+    // they stood. False for a duplicate AuthRequest.
+    bool acceptArrival(ENetPeer* peer, const AuthRequestPacket& req, const ShardHandoffPacket& h) {
+        PendingAuth* pend = _players.get<PendingAuth>(peer);
+        if (!pend || pend->verifying || pend->held || _ids.count(h.player)) return false;
+        pend->requested = Clock::now();
+        _ghosts.erase(h.player); // everyone here has them already
+        accept(peer, req, h.name, h.uid, h.player, {h.x, h.y, h.z}, h.yaw);
+        ConnectedPlayer* p = getPlayer(peer);
+        if (!p) return false;
+        p->pitch     = h.pitch;
+        p->moveEpoch = h.moveEpoch;
+        return true;
+    }
+
+    // ── Ghosts ────────────────────────────────────────────────────────────
+    // Sharded, ids are made unique across shards: base is the shard's id
+    // in the top byte. Before the first login.
+    void setIdBase(uint32_t base) { _nextId = base + 1; }
+
+    // Another shard's players near our border (ShardGhosts), shown to ours
+    // as if they were here: spawned on first sight, in every position
+    // broadcast, despawned once a list from that shard leaves them out
+    void setGhosts(uint16_t shard, const std::vector<ShardGhostsPacket::Ghost>& list) {
+        for (auto& [id, g] : _ghosts)
+            if (g.shard == shard) g.seen = false;
+        for (const ShardGhostsPacket::Ghost& in : list) {
+            if (_ids.count(in.id)) continue; // came over, and the list hasn't caught up
+            auto [it, fresh] = _ghosts.try_emplace(in.id);
+            Ghost& g     = it->second;
+            g.shard      = shard;
+            g.seen       = true;
+            g.p.id       = in.id;
+            g.p.username = in.name;
+            g.p.pos      = {in.x, in.y, in.z};
+            g.p.yaw      = in.yaw;
+            g.p.pitch    = in.pitch;
+            if (!fresh) continue;
+            auto bytes = PlayerSpawnPacket{g.p.id, g.p.username, in.x, in.y, in.z, in.yaw}.serialize();
+            for (const ConnectedPlayer& other : _players.all<ConnectedPlayer>())
+                if (other.authenticated) _out.reliable(other.peer, bytes);
+        }
+        for (auto it = _ghosts.begin(); it != _ghosts.end();) {
+            if (it->second.shard != shard || it->second.seen) {
+                ++it;
+                continue;
+            }
+            auto bytes = PlayerDespawnPacket{it->first}.serialize();
+            for (const ConnectedPlayer& other : _players.all<ConnectedPlayer>())
+                if (other.authenticated) _out.reliable(other.peer, bytes);
+            it = _ghosts.erase(it);
+        }
+    }
+
+    void onPlayerMove(ENetPeer* peer, float x, float y, float z, float yaw, float pitch) {
+        ConnectedPlayer* p = getPlayer(peer);
+        if (!p) return;
+        p->pos   = {x, y, z};
+        p->yaw   = yaw;
+        p->pitch = pitch;
+    }
+
+    // PlayerMoveQ also carries the newest snapshot the client holds. False
+    // if a predicting client's move was refused (or made before it heard of
+    // the last refusal): the player stays where the server last put it.
+    bool onPlayerMoveQ(ENetPeer* peer, const PlayerMoveQPacket& mv) {
+        ConnectedPlayer* p = getPlayer(peer);
+        if (!p) return false;
+        p->posEnc.ack(mv.ack);
+        if (p->predicted && !checkMove(*p, mv)) return false;
+        onPlayerMove(peer, mv.x, mv.y, mv.z, mv.yaw, mv.pitch);
+        return true;
+    }
+
+    // The server put the player somewhere (spawn, respawn); moves are
+    // checked from there
+    void teleport(ENetPeer* peer, glm::vec3 pos) {
+        ConnectedPlayer* p = getPlayer(peer);
+        if (!p) return;
+        p->pos       = pos;
+        p->moveFresh = true;
+        p->moveVel   = glm::vec3(0.f);
+    }
+
+    // Call at POS_BROADCAST_HZ. Each player only hears about players near
+    // it, by the InterestGrid rule, and only once one of them has moved
+    // (Config::POS_SEND_EPS), come into range or left it, plus a heartbeat
+    // and a periodic keyframe of everyone's exact state. Players that
+    // haven't moved are listed as last sent, so a delta batch marks them
+    // unchanged. Each receiver's rate follows its RTT and loss. Every batch
+    // is stamped with this tick's time.
+    void broadcastPositions() {
+        auto& players = _players.all<ConnectedPlayer>();
+        if (players.size() + _ghosts.size() < 2) return;
+        _posTick++;
+        auto now = _now();
+        uint32_t timeMs = (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(now - _start).count();
+
+        _grid.clear();
+        for (const ConnectedPlayer& p : players)
+            if (p.authenticated) _grid.add(p.pos, p.id, &p);
+        for (auto& [id, g] : _ghosts) _grid.add(g.p.pos, id, &g.p);
+
+        using Secs = std::chrono::duration<double>;
+        constexpr float eps2 = Config::POS_SEND_EPS * Config::POS_SEND_EPS;
+        PlayerPosSyncPacket& pkt = _posBatch;
+        for (ConnectedPlayer& me : players) {
+            if (!me.authenticated || now < me.posDue) continue;
+            bool keyframe = now - me.posKeyframe >= Secs(Config::POS_KEYFRAME_S);
+            bool send     = keyframe || now - me.posLastSent >= Secs(Config::POS_HEARTBEAT_S);
+            pkt.players.clear();
+            _grid.forEach(me.pos, _posTick, [&](const ConnectedPlayer* o) {
+                if (o == &me) return;
+                auto [it, fresh] = me.posSent.try_emplace(o->id);
+                ConnectedPlayer::SentPos& s = it->second;
+                glm::vec3 d = o->pos - s.pos;
+                bool moved = fresh || keyframe || d.x * d.x + d.y * d.y + d.z * d.z > eps2 ||
+                             std::fabs(std::remainder(o->yaw - s.yaw, 360.f)) > Config::POS_SEND_ROT_DEG ||
+                             std::fabs(o->pitch - s.pitch) > Config::POS_SEND_ROT_DEG;
+                if (moved) {
+                    s.pos   = o->pos;
+                    s.yaw   = o->yaw;
+                    s.pitch = o->pitch;
                 }
+                // One batch past the last move, so the client stops it
+                // there instead of extrapolating on
+                send    |= moved || s.moving;
+                s.moving = moved;
+                s.tick   = _posTick;
+                pkt.players.push_back({o->id, s.pos.x, s.pos.y, s.pos.z, s.yaw, s.pitch});
+            });
+            send |= std::erase_if(me.posSent, [&](const auto& kv) { return kv.second.tick != _posTick; }) > 0;
+            if (pkt.players.empty() || !send) {
+                if (!pkt.players.empty()) posSuppressed.add();
+                continue;
+            }
+
+            pkt.timeMs = timeMs;
+            if (me.deltaSync) {
+                me.posEnc.encode(pkt.players, timeMs, _posWriter, keyframe);
+                _out.movement(me.peer, _posWriter.data(), _posWriter.size());
+            } else {
+                pkt.write(_posWriter);
+                _out.reliable(me.peer, _posWriter.data(), _posWriter.size());
             }
+            posSent.add();
+            me.posLastSent = now;
+            if (keyframe) me.posKeyframe = now;
+            // Half a tick early, so a base-rate receiver isn't pushed to
+            // every other one by scheduling jitter
+            me.posDue = now + std::chrono::duration_cast<Clock::duration>(
+                                  Secs(posInterval(me.peer) - 0.5 / Config::POS_BROADCAST_HZ));
         }
+    }
+
+    // Position batches queued, and ones a receiver in range of someone was
+    // spared for want of anything new
+    Metrics::Counter posSent, posSuppressed;
 
-        // Allow guest connections (no auth server or token empty)
-        if (!valid && req.token.empty()) {
-            valid = true;
-            serverUsername = req.username.empty() ? "Guest" : req.username;
-            serverUid = "guest_" + std::to_string((uintptr_t)peer);
+    bool isAuthenticated(ENetPeer* peer) const {
+        const ConnectedPlayer* p = _players.get<ConnectedPlayer>(peer);
+        return p && p->authenticated;
+    }
+
+    uint32_t getPlayerId(ENetPeer* peer) const {
+        const ConnectedPlayer* p = _players.get<ConnectedPlayer>(peer);
+        return p ? p->id : 0;
+    }
+
+    // f(const ConnectedPlayer&) for every authenticated player
+    template<class F>
+    void forEachPlayer(F&& f) const {
+        for (const ConnectedPlayer& p : _players.all<ConnectedPlayer>())
+            if (p.authenticated) f(p);
+    }
+
+    ConnectedPlayer* getPlayer(ENetPeer* peer) { return _players.get<ConnectedPlayer>(peer); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Verdict {
+        bool        valid       = false;
+        bool        unreachable = false;
+        std::string username;
+        std::string uid;
+    };
+
+    struct PendingAuth {
+        uint32_t ticket    = 0;     // tells a reconnect on the same ENetPeer apart
+        bool     verifying = false;
+        Clock::time_point requested{}; // latest AuthRequest
+
+        // Verified, waiting on hold: who it turned out to be
+        bool              held = false;
+        AuthRequestPacket req{};
+        std::string       username{}, uid{};
+    };
+
+    struct Ghost {
+        uint16_t        shard = 0;
+        bool            seen  = false; // in the shard's latest list
+        ConnectedPlayer p;             // id, name and where; never authenticated
+    };
+
+    struct VerifiedToken {
+        std::string       username;
+        std::string       uid;
+        Clock::time_point expires;
+    };
+
+    // Worker side — no member state touched
+    static Verdict parseVerify(const HttpResponse& resp) {
+        Verdict v;
+        v.unreachable = resp.status == 0;
+        if (!resp.ok()) return v;
+
+        // Minimal JSON parse - look for "valid":true
+        v.valid = resp.body.find("\"valid\":true") != std::string::npos ||
+                  resp.body.find("\"valid\": true") != std::string::npos;
+        if (!v.valid) return v;
+
+        auto field = [&](const char* key) -> std::string {
+            std::string k = std::string("\"") + key + "\":";
+            auto pos = resp.body.find(k);
+            if (pos == std::string::npos) return {};
+            auto start = resp.body.find('"', pos + k.size());
+            if (start == std::string::npos) return {};
+            start++;
+            auto end = resp.body.find('"', start);
+            return end == std::string::npos ? std::string{} : resp.body.substr(start, end - start);
+        };
+        v.username = field("username");
+        v.uid      = field("uid");
+        return v;
+    }
+
+    static int64_t unixNow() {
+        return std::chrono::duration_cast<std::chrono::seconds>(
+                   std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    void refuse(ENetPeer* peer) {
+        AuthResponsePacket arp{0, 0, "Authentication failed."};
+        _out.reliable(peer, arp.serialize());
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream in(path);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    // Keys the file no longer has, or a list the auth server doesn't serve,
+    // stay as they were
+    Async<> fetchKeys() {
+        auto [keys, revoked] = co_await _loop.run(*_authPool, [path = authKeysPath, host = authHost, port = authPort] {
+            return std::pair{path.empty() ? std::string{} : readFile(path),
+                             HttpClient::get(host.c_str(), port, "/api/session-revoked")};
+        });
+        _keysFetching = false;
+        if (!keys.empty() && _tokens.setKeys(keys)) _verified.clear(); // revocations apply to cached ones too
+        if (revoked.ok()) _tokens.setRevoked(revoked.body);
+    }
+
+    // A token only the auth server can vouch for, asked off the ENet thread.
+    // The ticket tells whether the peer that asked is still the one waiting.
+    Async<> verify(ENetPeer* peer, uint32_t ticket, AuthRequestPacket req) {
+        std::string path = "/api/verify?token=" + req.token;
+        Verdict v = co_await _loop.run(*_authPool, [path, host = authHost, port = authPort] {
+            return parseVerify(HttpClient::get(host.c_str(), port, path.c_str()));
+        });
+
+        // Peer left (and its ENetPeer slot may already be someone else)
+        PendingAuth* pend = _players.get<PendingAuth>(peer);
+        if (!pend || pend->ticket != ticket) co_return;
+
+        if (v.valid) {
+            _verified[req.token] = {v.username, v.uid,
+                Clock::now() + std::chrono::seconds(Config::AUTH_CACHE_TTL_S)};
+            if (_verified.size() > 4096) pruneVerified();
+        } else if (v.unreachable && _tokens.empty()) {
+            // Also allow if auth server is down (fallback to guest)
+            Log::warn("Auth server unreachable, allowing as guest: %s", req.username);
+            v.valid    = true;
+            v.username = req.username.empty() ? "Guest" : req.username;
+            v.uid      = "guest_" + std::to_string((uintptr_t)peer);
         }
 
-        // Also allow if auth server is down (fallback to guest)
-        if (!valid && resp.status == 0) {
-            Log::warn("Auth server unreachable, allowing as guest: " + req.username);
-            valid = true;
-            serverUsername = req.username.empty() ? "Guest" : req.username;
-            serverUid = "guest_" + std::to_string((uintptr_t)peer);
+        if (!v.valid) {
+            if (v.unreachable) Log::warn("Auth server unreachable, refusing: %s", req.username);
+            pend->verifying = false;
+            refuse(peer);
+            co_return;
         }
+        if (login(peer, req, v.username, v.uid) && onAccept) onAccept(peer, req);
+    }
 
-        if (!valid) {
-            AuthResponsePacket arp{0, 0, "Authentication failed."};
-            Net::sendReliable(peer, arp.serialize());
-            enet_host_flush(host);
-            return true;
+    void pruneVerified() {
+        auto now = Clock::now();
+        for (auto it = _verified.begin(); it != _verified.end(); )
+            it = (it->second.expires <= now) ? _verified.erase(it) : std::next(it);
+    }
+
+    // Verified: in now, or held
+    bool login(ENetPeer* peer, const AuthRequestPacket& req, const std::string& username, const std::string& uid) {
+        if (hold && hold(peer)) {
+            PendingAuth* p = _players.get<PendingAuth>(peer);
+            if (!p) return false;
+            p->verifying = false;
+            p->held      = true;
+            p->req       = req;
+            p->username  = username;
+            p->uid       = uid;
+            return false;
         }
+        accept(peer, req, username, uid);
+        return true;
+    }
 
-        // Assign player ID
-        uint32_t pid = _nextId++;
-        ConnectedPlayer cp;
+    // pid 0 assigns the next id
+    void accept(ENetPeer* peer, const AuthRequestPacket& req, const std::string& serverUsername,
+                const std::string& serverUid, uint32_t pid = 0, glm::vec3 pos = {}, float yaw = 0.f) {
+        ConnectedPlayer* slot = _players.emplace<ConnectedPlayer>(peer);
+        if (!slot) return;
+        if (!pid) pid = _nextId++;
+        ConnectedPlayer& cp = *slot;
         cp.id = pid;
+        cp.pos = pos;
+        cp.yaw = yaw;
         cp.peer = peer;
         cp.username = serverUsername.empty() ? req.username : serverUsername;
         cp.uid = serverUid;
         cp.authenticated = true;
+        cp.deltaSync = (req.caps & CAP_MOVE_DELTA) != 0;
+        cp.predicted = (req.caps & CAP_MOVE_PREDICT) != 0;
 
-        _players[pid] = cp;
-        _peerToId[peer] = pid;
-        _pending.erase(peer);
+        _ids.insert(pid);
+        if (PendingAuth* pend = _players.get<PendingAuth>(peer)) {
+            authSeconds.observe(std::chrono::duration<double>(Clock::now() - pend->requested).count());
+            _players.erase<PendingAuth>(peer);
+        }
 
         // Send auth accepted
         AuthResponsePacket arp{1, pid, "Welcome, " + cp.username + "!"};
-        Net::sendReliable(peer, arp.serialize());
+        _out.reliable(peer, arp.serialize());
 
-        Log::info("Player authenticated: " + cp.username + " (id=" + std::to_string(pid) + ")");
+        Log::info("Player authenticated: %s (id=%u)", cp.username, pid);
 
         // Tell new player about all existing players
-        for (auto& [otherId, other] : _players) {
-            if (otherId == pid || !other.authenticated) continue;
+        for (const ConnectedPlayer& other : _players.all<ConnectedPlayer>()) {
+            if (other.id == pid || !other.authenticated) continue;
             PlayerSpawnPacket sp{other.id, other.username,
                                 other.pos.x, other.pos.y, other.pos.z, other.yaw};
-            Net::sendReliable(peer, sp.serialize());
+            _out.reliable(peer, sp.serialize());
+        }
+        for (auto& [otherId, g] : _ghosts) {
+            PlayerSpawnPacket sp{otherId, g.p.username, g.p.pos.x, g.p.pos.y, g.p.pos.z, g.p.yaw};
+            _out.reliable(peer, sp.serialize());
         }
 
         // Tell all existing players about new player
-        PlayerSpawnPacket sp{pid, cp.username, 0, 0, 0, 0};
+        PlayerSpawnPacket sp{pid, cp.username, pos.x, pos.y, pos.z, yaw};
         auto spBytes = sp.serialize();
-        for (auto& [otherId, other] : _players) {
-            if (otherId == pid || !other.authenticated) continue;
-            Net::sendReliable(other.peer, spBytes);
+        for (const ConnectedPlayer& other : _players.all<ConnectedPlayer>()) {
+            if (other.id == pid || !other.authenticated) continue;
+            _out.reliable(other.peer, spBytes);
         }
-
-        enet_host_flush(host);
-        return true;
     }
 
-    void onPlayerMove(ENetPeer* peer, float x, float y, float z, float yaw, float pitch) {
-        auto it = _peerToId.find(peer);
-        if (it == _peerToId.end()) return;
-        auto pit = _players.find(it->second);
-        if (pit == _players.end()) return;
-        pit->second.pos = {x, y, z};
-        pit->second.yaw = yaw;
-        pit->second.pitch = pitch;
+    // Seconds between a receiver's position batches: the base interval,
+    // plus one more per Config::POS_RATE_RTT_MS of RTT and per
+    // POS_RATE_LOSS of loss, so a struggling link isn't fed faster than
+    // it can use
+    double posInterval(ENetPeer* peer) const {
+        double base = 1.0 / Config::POS_BROADCAST_HZ;
+        double loss = (double)_out.packetLoss(peer) / ENET_PEER_PACKET_LOSS_SCALE;
+        double steps = _out.rttMs(peer) / Config::POS_RATE_RTT_MS + loss / Config::POS_RATE_LOSS;
+        return std::min(base * (1.0 + steps), Config::POS_INTERVAL_MAX_S);
     }
 
-    // Call at ~20Hz to broadcast all positions
-    void broadcastPositions(ENetHost* host) {
-        if (_players.size() < 2) return;
-
-        PlayerPosSyncPacket pkt;
-        for (auto& [id, p] : _players) {
-            if (!p.authenticated) continue;
-            pkt.players.push_back({p.id, p.pos.x, p.pos.y, p.pos.z, p.yaw, p.pitch});
+    // Spends the player's bank on the move, or refuses it. Distance is the
+    // larger of horizontal travel and climb.
+    bool checkMove(ConnectedPlayer& p, const PlayerMoveQPacket& mv) {
+        auto now = _now();
+        if (mv.epoch != p.moveEpoch) {
+            if (now - p.correctedAt >= std::chrono::milliseconds(Config::MOVE_CORRECT_RESEND_MS))
+                sendCorrection(p, now); // the first may have been lost
+            return false;
         }
 
-        auto bytes = pkt.serialize();
-        for (auto& [id, p] : _players) {
-            if (!p.authenticated) continue;
-            Net::sendReliable(p.peer, bytes);
+        constexpr float cap = Config::MOVE_CHECK_SPEED * Config::MOVE_CHECK_BURST_S;
+        float dt = p.moveFresh ? 0.f : std::chrono::duration<float>(now - p.lastMove).count();
+        p.moveBank  = p.moveFresh ? cap : std::min(cap, p.moveBank + dt * Config::MOVE_CHECK_SPEED);
+        p.moveFresh = false;
+        p.lastMove  = now;
+
+        glm::vec3 d{mv.x - p.pos.x, mv.y - p.pos.y, mv.z - p.pos.z};
+        float dist = std::max(std::sqrt(d.x * d.x + d.z * d.z), d.y);
+        if (dist > p.moveBank) {
+            p.moveEpoch++;
+            p.correctedSeq = mv.seq;
+            sendCorrection(p, now);
+            return false;
         }
+        p.moveBank -= std::max(dist, 0.f);
+        if (dt > 0.01f) p.moveVel = d / dt;
+        return true;
     }
 
-    bool isAuthenticated(ENetPeer* peer) const {
-        auto it = _peerToId.find(peer);
-        if (it == _peerToId.end()) return false;
-        auto pit = _players.find(it->second);
-        return pit != _players.end() && pit->second.authenticated;
+    void sendCorrection(ConnectedPlayer& p, std::chrono::steady_clock::time_point now) {
+        p.correctedAt = now;
+        MoveCorrectionPacket c{p.correctedSeq, p.moveEpoch, p.pos, p.moveVel};
+        c.write(_posWriter);
+        _out.movement(p.peer, _posWriter.data(), _posWriter.size());
     }
 
-    uint32_t getPlayerId(ENetPeer* peer) const {
-        auto it = _peerToId.find(peer);
-        return it != _peerToId.end() ? it->second : 0;
-    }
+    Outbox&  _out;
+    std::function<std::chrono::steady_clock::time_point()> _now = Clock::now;
+    Clock::time_point _start = Clock::now(); // PlayerPosSync timestamps count from here
+    uint32_t _nextId = 1;
+    uint32_t _nextTicket = 1;
+    uint32_t _posTick = 0;
+    InterestGrid<const ConnectedPlayer*> _grid; // rebuilt per broadcast
+    PlayerPosSyncPacket _posBatch;  // per-listener scratch, reused across broadcasts
+    PacketWriter        _posWriter;
+    PlayerRegistry&              _players;
+    std::unordered_set<uint32_t> _ids; // of the players here, for what comes by id
+    std::unordered_map<std::string, VerifiedToken> _verified; // token → recent verdict, ENet thread only
+    std::unordered_map<uint32_t, Ghost>            _ghosts;   // other shards' players, by id
 
-    ConnectedPlayer* getPlayer(ENetPeer* peer) {
-        auto it = _peerToId.find(peer);
-        if (it == _peerToId.end()) return nullptr;
-        auto pit = _players.find(it->second);
-        return pit != _players.end() ? &pit->second : nullptr;
-    }
+    SessionTokens _tokens;               // ENet thread only
+    bool          _keysFetching = false;
 
-private:
-    uint32_t _nextId = 1;
-    std::unordered_map<uint32_t, ConnectedPlayer> _players;
-    std::unordered_map<ENetPeer*, uint32_t>       _peerToId;
-    std::unordered_map<ENetPeer*, int>             _pending; // awaiting auth
+    AsyncLoop& _loop;
+
+    // Declared last: workers finish into verify()/fetchKeys() frames, so
+    // they must join first
+    std::unique_ptr<ThreadPool> _authPool;
 };
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <enet/enet.h>
+
+// ── NetAlloc ──────────────────────────────────────────────────────────────────
+// ENet's allocator (Net::init installs it with enet_initialize_with_callbacks).
+// Every enet_packet_create is two allocations, the packet and its data,
+// freed on whichever thread sends or receives it last; at the server's
+// broadcast rates that's thousands of small malloc/free pairs a second.
+//
+// Sizes up to 4 KB are rounded up to one of eight power-of-two classes and
+// kept on free lists: one per class per thread, in front of a shared depot
+// per class taken in batches under its own lock. A block freed on another
+// thread than the one that allocated it just joins the freeing thread's
+// list. Anything bigger (peer arrays, chunk payloads) goes straight to
+// malloc. Each list and depot keeps a bounded number of blocks and hands
+// the rest back.
+//
+// Counted per thread and folded into the totals every 64 operations, so
+// stats() lags by at most that much per thread.
+namespace NetAlloc {
+    struct Stats {
+        uint64_t allocs    = 0; // since start
+        uint64_t fromPool  = 0; // of those, served from a free list
+        uint64_t large     = 0; // of those, past the classes
+        int64_t  liveBytes = 0; // handed out, not yet freed (class sizes)
+        int64_t  heldBytes = 0; // on the depots' free lists
+    };
+
+    void* alloc(size_t size);
+    void  free(void* p);
+    Stats stats();
+
+    ENetCallbacks callbacks();
+}
@@ -2,12 +2,16 @@
 #include <enet/enet.h>
 #include <stdexcept>
 #include <vector>
+#include <memory>
 #include <cstdint>
+#include "net_alloc.h"
 
 namespace Net {
 
+// With ENet's allocations going through NetAlloc's pools
 inline void init() {
-    if (enet_initialize() != 0)
+    ENetCallbacks cb = NetAlloc::callbacks();
+    if (enet_initialize_with_callbacks(ENET_VERSION, &cb) != 0)
         throw std::runtime_error("enet_initialize failed");
 }
 
@@ -15,6 +19,16 @@ inline void deinit() {
     enet_deinitialize();
 }
 
+// Both hosts open three channels: gameplay messages on channel 0, movement
+// on channel 1 so a stale position never waits behind anything reliable,
+// and chunk streaming on channel 2 so a resent chunk never holds up the
+// next inventory ack. Peers that connected with fewer channels (older
+// clients) get their chunks on channel 0.
+inline constexpr uint8_t CHANNEL_RELIABLE = 0;
+inline constexpr uint8_t CHANNEL_MOVEMENT = 1;
+inline constexpr uint8_t CHANNEL_STREAM   = 2;
+inline constexpr size_t  CHANNEL_COUNT    = 3;
+
 // Wraps an ENetHost with RAII
 struct Host {
     ENetHost* h = nullptr;
@@ -24,13 +38,13 @@ struct Host {
         ENetAddress addr{};
         addr.host = ENET_HOST_ANY;
         addr.port = port;
-        h = enet_host_create(&addr, maxClients, 2, 0, 0);
+        h = enet_host_create(&addr, maxClients, CHANNEL_COUNT, 0, 0);
         if (!h) throw std::runtime_error("enet_host_create (server) failed");
     }
 
     // Client ctor
     explicit Host() {
-        h = enet_host_create(nullptr, 1, 2, 0, 0);
+        h = enet_host_create(nullptr, 1, CHANNEL_COUNT, 0, 0);
         if (!h) throw std::runtime_error("enet_host_create (client) failed");
     }
 
@@ -43,11 +57,61 @@ struct Host {
     ENetHost* get()        { return h; }
 };
 
-// Send a raw byte vector on channel 0, reliable
+// Send raw bytes on channel 0, reliable. ENet copies them, so a reused
+// PacketWriter buffer can go straight in.
+inline void sendReliable(ENetPeer* peer, const uint8_t* data, size_t len) {
+    ENetPacket* pkt = enet_packet_create(data, len, ENET_PACKET_FLAG_RELIABLE);
+    enet_peer_send(peer, CHANNEL_RELIABLE, pkt);
+}
 inline void sendReliable(ENetPeer* peer, const std::vector<uint8_t>& data) {
-    ENetPacket* pkt = enet_packet_create(data.data(), data.size(),
-                                         ENET_PACKET_FLAG_RELIABLE);
-    enet_peer_send(peer, 0, pkt);
+    sendReliable(peer, data.data(), data.size());
+}
+
+// Unreliable-sequenced on the movement channel: ENet drops anything that
+// arrives after a newer packet, so receivers only ever see fresher state
+inline void sendMovement(ENetPeer* peer, const uint8_t* data, size_t len) {
+    ENetPacket* pkt = enet_packet_create(data, len, 0);
+    enet_peer_send(peer, CHANNEL_MOVEMENT, pkt);
+}
+inline void sendMovement(ENetPeer* peer, const std::vector<uint8_t>& data) {
+    sendMovement(peer, data.data(), data.size());
+}
+
+// Reliable packet over immutable shared bytes, without copying them. The
+// packet holds a reference until ENet frees it, so one packet can be sent to
+// any number of peers (and fragmented) while the bytes stay owned elsewhere
+// too. If no peer ends up taking it, enet_packet_destroy it yourself.
+inline void freeSharedBytes(ENetPacket* p) {
+    delete static_cast<std::shared_ptr<const std::vector<uint8_t>>*>(p->userData);
+}
+inline ENetPacket* makeSharedPacket(std::shared_ptr<const std::vector<uint8_t>> bytes) {
+    ENetPacket* pkt = enet_packet_create(
+        const_cast<uint8_t*>(bytes->data()), bytes->size(),
+        ENET_PACKET_FLAG_RELIABLE | ENET_PACKET_FLAG_NO_ALLOCATE);
+    if (!pkt) return nullptr;
+    pkt->userData     = new std::shared_ptr<const std::vector<uint8_t>>(std::move(bytes));
+    pkt->freeCallback = freeSharedBytes;
+    return pkt;
+}
+
+// A fresh packet over the same bytes, nobody else's: shared bytes stay
+// shared (their shared_ptr count is atomic), anything else is copied. For
+// handing a packet to another thread while the original's reference count —
+// which ENet doesn't guard — stays with this one.
+inline ENetPacket* ownCopy(const ENetPacket* pkt) {
+    if (pkt->freeCallback == freeSharedBytes)
+        return makeSharedPacket(*static_cast<const std::shared_ptr<const std::vector<uint8_t>>*>(pkt->userData));
+    constexpr enet_uint32 kept = ENET_PACKET_FLAG_RELIABLE | ENET_PACKET_FLAG_UNSEQUENCED |
+                                 ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT;
+    return enet_packet_create(pkt->data, pkt->dataLength, pkt->flags & kept);
+}
+
+// Reference counting for packets held outside ENet (queued, or shared across
+// peers): retain while holding, release when done. The last release of a
+// packet no peer took destroys it.
+inline void retain(ENetPacket* pkt) { pkt->referenceCount++; }
+inline void release(ENetPacket* pkt) {
+    if (--pkt->referenceCount == 0) enet_packet_destroy(pkt);
 }
 
 } // namespace Net
@@ -1,4 +1,52 @@
 #pragma once
+#include <cstdint>
+#include <memory>
 #include "chunk.h"
-float     sampleSurfaceY(float wx, float wz);  // add this
-ChunkData generateChunk(ChunkCoord coord);
+#include "noise_graph.h"
+
+// The graph terrain is generated from: the built-in one unless
+// useTerrainGraph replaced it, which has to happen before anything is
+// generated (columns are cached) and not while anything is
+const Noise::Graph& terrainGraph();
+void                useTerrainGraph(Noise::Graph graph);
+// 0 for the built-in graph, else its hash — what a world's identity folds in
+uint64_t            terrainGraphId();
+
+// 2D terrain over one chunk column, on the padded grid: every chunk stacked
+// at the same (x, z) and lod shares it, so the heightmap noise is sampled
+// once per column rather than once per chunk. minY/maxY bound the surface
+// for the uniform-chunk test.
+struct SurfaceColumn {
+    float surface[ChunkData::PADDED][ChunkData::PADDED];
+    float minY, maxY;
+};
+
+// Cached (up to Config::SURFACE_COLUMN_CACHE columns); safe from any thread
+std::shared_ptr<const SurfaceColumn> surfaceColumn(int cx, int cz, int lod = 0);
+
+// Ground height at a world position, with a couple of blocks' clearance
+float     sampleSurfaceY(float wx, float wz);
+// The heightmap itself at n arbitrary points, no clearance, uncached — what
+// the column grids are filled from, for callers sampling far coarser than
+// a block (the client's far terrain)
+void      surfaceHeights(const float* wx, const float* wz, float* out, int n);
+// What the marched surface shows at that height, facing normalY up: sand
+// near sea level, else grass, or dirt where it's steep
+BlockMat  surfaceMaterial(float surfaceY, float normalY);
+// Fills out, which the caller owns — a ChunkData is ~180 KB, so it's
+// best reused rather than returned. lod > 0: the LOD cell at coord (see
+// ChunkKey), sampled every 2^lod blocks.
+void      generateChunk(ChunkData& out, ChunkCoord coord, int lod = 0);
+
+// generateChunk in pieces, to spread one chunk over several threads:
+// beginChunk sets the coord and the uniform classification, then
+// generateSlab fills padded rows x in [x0, x1), terrain then features
+// (world_features.h). Slabs write disjoint rows,
+// so they can all run at once; together they match generateChunk exactly.
+// Once every slab is done, publishFaces leaves the chunk's faces for the
+// neighbours that haven't been generated yet (generateChunk does this
+// itself). Their slabs copy them rather than sample them; the result is the
+// same either way.
+void      beginChunk(ChunkData& data, ChunkCoord coord, int lod = 0);
+void      generateSlab(ChunkData& data, int lod, int x0, int x1);
+void      publishFaces(const ChunkData& data, int lod = 0);
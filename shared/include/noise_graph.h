@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ── Noise graph ───────────────────────────────────────────────────────────────
+// The terrain recipe as data: a list of named nodes over the world position
+// (x, y, z), each an operation on earlier nodes or numbers, and a few
+// parameters. Two of the nodes are what generation asks for:
+//   surface  block height of the ground at (x, z); may not use y
+//   carve    added to the density where a voxel is more than carve_depth
+//            below the surface (caves: negative carves, positive fills)
+// One node per line, # to the end of a line is a comment:
+//   name = fbm    X Y Z [octaves=N] [seed=S]  value-noise fbm, in [-1, 1]
+//   name = ridged X Y Z [octaves=N] [seed=S]  1 - |fbm|, in [0, 1]
+//   name = warp   P N K          P + N * K (a coordinate pushed by a noise)
+//   name = blend  A B T          A + (B - A) * T
+//   name = clamp  A LO HI
+//   name = select A B C T        C < T ? A : B
+//   name = add A B | sub A B | mul A B | abs A
+//   param name value             sand_top, grass_depth, dirt_depth, carve_depth
+// Operands are node names, x, y, z or numbers; seed is added to the world's.
+//
+// Parsing compiles each output into a tape over the nodes it needs, with
+// numbers folded into constant registers. A tape runs over spans of up to
+// BATCH points at once, each step one flat loop (fbm the batched kernel of
+// Noise::fbmSpan), so a whole row of a chunk costs one pass per node rather
+// than a call per node per voxel. Every step does the float operations the
+// line names, in that order: the built-in graph reproduces the hand-written
+// recipe it replaced to the bit.
+namespace Noise {
+
+class Graph {
+public:
+    static constexpr int BATCH = 256;
+
+    struct Params {
+        float sandTop    = 70.f; // a surface at or below this is sand
+        float grassDepth = 1.f;  // then grass this far down
+        float dirtDepth  = 4.f;  // then dirt; stone past it
+        float carveDepth = 4.f;  // carve applies below this depth (>= 0)
+    };
+
+    // The program text describes; nullopt, with err naming the line, if it
+    // doesn't parse or misses an output
+    static std::optional<Graph> parse(std::string_view text, std::string& err);
+    // What the terrain was before graphs: the default
+    static const Graph& builtin();
+
+    // out[i] at each point, for any n; out may not alias the inputs
+    void surface(const float* x, const float* z, float* out, int n) const;
+    void carve(const float* x, const float* y, const float* z, float* out, int n) const;
+
+    // Bounds on what carve can be anywhere, from the tape: what the uniform
+    // chunk test has to allow for
+    float carveMin() const { return _carve.lo; }
+    float carveMax() const { return _carve.hi; }
+
+    const Params& params() const { return _params; }
+
+    // Fingerprint of the compiled tapes and parameters — equal graphs
+    // generate equal worlds
+    uint64_t hash() const { return _hash; }
+
+private:
+    enum class Op : uint8_t { Fbm, Ridged, Add, Sub, Mul, Abs, Warp, Blend, Clamp, Select };
+
+    struct Step {
+        Op       op;
+        uint16_t dst;
+        uint16_t src[4];
+        int      octaves;
+        int64_t  seed;
+    };
+
+    // Registers: x, y, z, then the constants, then one per step
+    struct Tape {
+        std::vector<Step>  steps;
+        std::vector<float> consts;
+        uint16_t           out = 0;
+        uint16_t           regs = 0;
+        float              lo = 0.f, hi = 0.f; // of out
+    };
+
+    void run(const Tape& t, const float* x, const float* y, const float* z, float* out, int n) const;
+
+    Tape     _surface, _carve;
+    Params   _params;
+    uint64_t _hash = 0;
+};
+
+} // namespace Noise
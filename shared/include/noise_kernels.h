@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+
+// Value-noise fbm used by terrain generation, in scalar and batched form.
+// fbmSpan picks the widest kernel the CPU supports at first use (AVX2 on
+// x86-64, scalar otherwise). Every kernel does the same float operations in
+// the same order, so results are bit-identical to fbm() for a given seed —
+// worlds don't change with the machine that generated them.
+namespace Noise {
+
+float fbm(int64_t seed, float x, float y, float z, int octaves);
+
+// out[i] = fbm(seed, xs[i], ys[i], zs[i], octaves) for i in [0, n).
+// out may not alias the inputs.
+void fbmSpan(int64_t seed, const float* xs, const float* ys, const float* zs,
+             float* out, int n, int octaves);
+
+// Name of the kernel fbmSpan dispatches to ("avx2" / "scalar"), for logs
+const char* kernelName();
+
+} // namespace Noise
@@ -0,0 +1,299 @@
+#pragma once
+#include <enet/enet.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "config.h"
+#include "mem_tags.h"
+#include "net_common.h"
+#include "packets.h"
+
+// Everything the server sends goes through here; flush() once per tick puts
+// it on the wire. Each peer has three lanes, drained in priority order:
+//
+//   Movement  unreliable, movement channel — positions, enemy sync
+//   Gameplay  reliable — stats, inventory, spawns, auth
+//   Stream    reliable shared packets on the stream channel — chunk data
+//
+// Small messages in a lane are coalesced into Bundle packets of up to
+// BUNDLE_BYTES (PacketDispatcher unpacks them on the other end), so a tick's
+// worth of gameplay chatter costs one datagram and one ack instead of one
+// per message.
+//
+// Each peer also has a token bucket, bursting to a tenth of a second's
+// worth. Movement always goes. Gameplay and then stream packets go while
+// the peer has tokens left — the last one may overdraw — and whatever
+// doesn't fit waits, in order, for a later flush. A chunk flood therefore
+// queues here behind the budget instead of in ENet ahead of the next hit or
+// inventory ack. Stream senders can ask streamRoom() first and keep their
+// backlog themselves, so they still get to pick what goes next.
+//
+// The bucket's rate adapts to the link, AIMD-style, every ADAPT_MS: it
+// backs off when ENet reports packet loss or the RTT climbs well above the
+// lowest seen, and creeps back up towards bytesPerSec (PEER_SEND_BYTES_PER_S
+// by default) while the peer has more queued than it was allowed.
+//
+// Budgets run on steady_clock unless setClock() says otherwise (replay).
+//
+// Packets go to enet_peer_send unless setSink() hands them elsewhere — the
+// server's network thread. With a sink, nothing here reads the live peer:
+// the RTT and loss figures adaptation needs come in through setLink(), and
+// every packet the sink gets is its own (stream packets are re-wrapped, see
+// Net::ownCopy), so reference counts never cross threads.
+class Outbox {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Now   = std::function<Clock::time_point()>;
+    // Takes ownership of pkt. Stream packets come with CHANNEL_STREAM; the
+    // sink falls back for peers that didn't open it.
+    using Sink  = std::function<void(ENetPeer*, uint8_t channel, ENetPacket*)>;
+
+    // Bundle payload that fits one datagram on a typical 1400-byte MTU path
+    static constexpr size_t BUNDLE_BYTES = 1200;
+
+    static constexpr int    ADAPT_MS      = 250;
+    static constexpr double MIN_RATE      = 32 << 10;  // never throttle a peer below this
+    static constexpr double LOSS_BACKOFF  = 0.02;      // packet loss fraction that counts as congestion
+    static constexpr double RTT_BACKOFF   = 2.0;       // ...as does RTT past this multiple of the best seen
+    static constexpr int    RTT_SLACK_MS  = 40;        // plus this, so LAN jitter doesn't count
+
+    explicit Outbox(size_t bytesPerSec = Config::PEER_SEND_BYTES_PER_S)
+        : _rate(std::max((double)bytesPerSec, MIN_RATE)) {}
+
+    double bytesPerSec() const { return _rate; }
+
+    void setClock(Now now) { _now = std::move(now); }
+    void setSink(Sink sink) { _sink = std::move(sink); }
+
+    // The peer's smoothed RTT (ms) and ENet packet loss (of
+    // ENET_PEER_PACKET_LOSS_SCALE), for a sink's peers
+    void setLink(ENetPeer* peer, uint32_t rtt, uint32_t loss) {
+        PeerQueue& q = _peers[peer];
+        q.rtt  = rtt;
+        q.loss = loss;
+    }
+
+    struct Stats {
+        uint64_t messages = 0; // movement + gameplay messages queued
+        uint64_t packets  = 0; // ENet packets they and the stream went out in
+        uint64_t bytes    = 0;
+        uint64_t streamed = 0; // stream packets sent
+        size_t   backlog  = 0; // stream packets waiting after the last flush
+        uint64_t backoffs = 0; // rate cuts for loss or RTT
+        double   minRate  = 0; // slowest peer's current rate, bytes/s
+    };
+
+    void movement(ENetPeer* peer, const uint8_t* d, size_t len) { push(_peers[peer].movement, d, len); }
+    void movement(ENetPeer* peer, const std::vector<uint8_t>& d) { movement(peer, d.data(), d.size()); }
+
+    void reliable(ENetPeer* peer, const uint8_t* d, size_t len) { push(_peers[peer].gameplay, d, len); }
+    void reliable(ENetPeer* peer, const std::vector<uint8_t>& d) { reliable(peer, d.data(), d.size()); }
+
+    // A reliable packet that may be shared between peers (see
+    // Net::makeSharedPacket). The outbox holds a reference until it's sent.
+    void stream(ENetPeer* peer, ENetPacket* pkt) {
+        Net::retain(pkt);
+        PeerQueue& q = _peers[peer];
+        q.stream.push_back(pkt);
+        q.streamBytes += pkt->dataLength;
+    }
+
+    // Stream bytes the peer could take on the next flush, after what's
+    // already queued for it. Asking and finding no room counts as being
+    // budget-bound for rate adaptation.
+    double streamRoom(ENetPeer* peer) {
+        PeerQueue& q = _peers[peer];
+        refill(q, _now());
+        double room = q.tokens - (double)(q.movement.bytes.size() + q.gameplay.bytes.size() + q.streamBytes);
+        if (room <= 0) q.limited = true;
+        return room;
+    }
+
+    // Once per tick, after everything for the tick is queued
+    void flush() {
+        auto now = _now();
+        _stats.backlog = 0;
+        _stats.minRate = _rate;
+        for (auto& [peer, q] : _peers) {
+            refill(q, now);
+            adapt(peer, q, now);
+
+            sendLane(peer, q, q.movement, Net::CHANNEL_MOVEMENT, 0, true);
+            sendLane(peer, q, q.gameplay, Net::CHANNEL_RELIABLE, ENET_PACKET_FLAG_RELIABLE, false);
+            uint8_t channel = _sink || peer->channelCount > Net::CHANNEL_STREAM ? Net::CHANNEL_STREAM
+                                                                                : Net::CHANNEL_RELIABLE;
+            while (!q.stream.empty() && q.tokens > 0 && q.gameplay.ends.empty()) {
+                ENetPacket* pkt = q.stream.front();
+                q.stream.pop_front();
+                q.streamBytes -= pkt->dataLength;
+                q.tokens -= (double)pkt->dataLength;
+                q.sent   += pkt->dataLength;
+                _stats.bytes += pkt->dataLength;
+                _stats.packets++;
+                _stats.streamed++;
+                if (!_sink)
+                    enet_peer_send(peer, channel, pkt); // takes its own reference
+                else if (ENetPacket* own = Net::ownCopy(pkt))
+                    _sink(peer, channel, own);
+                Net::release(pkt);
+            }
+            if (!q.stream.empty() || !q.gameplay.ends.empty()) q.limited = true;
+            _stats.backlog += q.stream.size();
+            _stats.minRate = std::min(_stats.minRate, q.rate);
+        }
+    }
+
+    // Peer gone: anything still queued for it is discarded
+    void drop(ENetPeer* peer) {
+        auto it = _peers.find(peer);
+        if (it == _peers.end()) return;
+        for (ENetPacket* pkt : it->second.stream) Net::release(pkt);
+        _peers.erase(it);
+    }
+
+    size_t streamBacklog(ENetPeer* peer) const {
+        auto it = _peers.find(peer);
+        return it != _peers.end() ? it->second.stream.size() : 0;
+    }
+
+    // Bytes handed to ENet for the peer so far, and its current adapted rate
+    uint64_t sentBytes(ENetPeer* peer) const {
+        auto it = _peers.find(peer);
+        return it != _peers.end() ? it->second.sent : 0;
+    }
+    double peerRate(ENetPeer* peer) const {
+        auto it = _peers.find(peer);
+        return it != _peers.end() && !it->second.fresh ? it->second.rate : _rate;
+    }
+    // As last seen by flush(), or set by setLink()
+    uint32_t rttMs(ENetPeer* peer) const {
+        auto it = _peers.find(peer);
+        return it != _peers.end() ? it->second.rtt : 0;
+    }
+    uint32_t packetLoss(ENetPeer* peer) const { // of ENET_PEER_PACKET_LOSS_SCALE
+        auto it = _peers.find(peer);
+        return it != _peers.end() ? it->second.loss : 0;
+    }
+
+    Stats takeStats() { Stats s = _stats; _stats = {}; return s; }
+
+private:
+    // Messages back to back; ends[i] is where message i stops
+    struct Lane {
+        std::vector<uint8_t>  bytes;
+        std::vector<uint32_t> ends;
+    };
+
+    struct PeerQueue {
+        Lane                    movement, gameplay;
+        std::deque<ENetPacket*> stream;
+        size_t                  streamBytes = 0;
+        uint64_t                sent     = 0;     // bytes sent, ever
+        double                  rate     = 0.0;   // bytes/s, adapted
+        double                  tokens   = 0.0;
+        bool                    fresh    = true;  // starts at the full rate with a full bucket
+        bool                    limited  = false; // left something queued since the last adapt
+        uint32_t                bestRtt  = UINT32_MAX;
+        uint32_t                rtt      = 0;
+        uint32_t                loss     = 0;
+        Clock::time_point       refilled = Clock::now();
+        Clock::time_point       adapted  = Clock::now();
+    };
+
+    static double burstOf(double rate) { return std::max(rate / 10.0, (double)BUNDLE_BYTES * 4); }
+
+    void refill(PeerQueue& q, Clock::time_point now) {
+        if (q.fresh) {
+            q.rate    = _rate;
+            q.tokens  = burstOf(q.rate);
+            q.fresh   = false;
+            q.refilled = q.adapted = now;
+            return;
+        }
+        double dt = std::chrono::duration<double>(now - q.refilled).count();
+        q.refilled = now;
+        q.tokens = std::min(burstOf(q.rate), q.tokens + dt * q.rate);
+    }
+
+    // Multiplicative decrease on loss or a swollen RTT, additive increase
+    // (a sixteenth of the cap per step) while the peer is budget-bound
+    void adapt(ENetPeer* peer, PeerQueue& q, Clock::time_point now) {
+        if (now - q.adapted < std::chrono::milliseconds(ADAPT_MS)) return;
+        q.adapted = now;
+        if (!_sink) {
+            q.rtt  = peer->roundTripTime;
+            q.loss = peer->packetLoss;
+        }
+        uint32_t rtt = q.rtt;
+        if (rtt) q.bestRtt = std::min(q.bestRtt, rtt);
+        double loss = (double)q.loss / ENET_PEER_PACKET_LOSS_SCALE;
+        bool congested = loss > LOSS_BACKOFF ||
+                         (q.bestRtt != UINT32_MAX && rtt > q.bestRtt * RTT_BACKOFF + RTT_SLACK_MS);
+        if (congested) {
+            q.rate = std::max(MIN_RATE, q.rate * 0.75);
+            _stats.backoffs++;
+        } else if (q.limited) {
+            q.rate = std::min(_rate, q.rate + _rate / 16.0);
+        }
+        q.limited = false;
+    }
+
+    void push(Lane& lane, const uint8_t* d, size_t len) {
+        if (len == 0) return;
+        MemTags::Scope tag(MemTags::Packets);
+        lane.bytes.insert(lane.bytes.end(), d, d + len);
+        lane.ends.push_back((uint32_t)lane.bytes.size());
+        _stats.messages++;
+    }
+
+    // Bundles from the front of the lane until it's empty or, unless
+    // always, the peer is out of tokens. A lone message goes out as itself.
+    void sendLane(ENetPeer* peer, PeerQueue& q, Lane& lane, uint8_t channel, uint32_t flags, bool always) {
+        const auto& ends = lane.ends;
+        auto start = [&](size_t m) -> size_t { return m ? ends[m - 1] : 0; };
+        size_t i = 0, n = ends.size();
+        while (i < n && (always || q.tokens > 0)) {
+            size_t end = i + 1, size = 1 + 5 + (ends[i] - start(i));
+            while (end < n && size + 5 + (ends[end] - ends[end - 1]) <= BUNDLE_BYTES) {
+                size += 5 + (ends[end] - ends[end - 1]);
+                end++;
+            }
+
+            ENetPacket* pkt;
+            if (end == i + 1) {
+                pkt = enet_packet_create(lane.bytes.data() + start(i), ends[i] - start(i), flags);
+            } else {
+                _bundle.begin((uint8_t)PacketID::Bundle, size);
+                for (size_t m = i; m < end; m++)
+                    _bundle.varint((uint32_t)(ends[m] - start(m))).bytes(lane.bytes.data() + start(m), ends[m] - start(m));
+                pkt = enet_packet_create(_bundle.data(), _bundle.size(), flags);
+            }
+            if (pkt) {
+                q.tokens -= (double)pkt->dataLength;
+                q.sent   += pkt->dataLength;
+                _stats.bytes += pkt->dataLength;
+                _stats.packets++;
+                if (_sink) _sink(peer, channel, pkt);
+                else if (enet_peer_send(peer, channel, pkt) != 0) enet_packet_destroy(pkt);
+            }
+            i = end;
+        }
+
+        // Keep what's left for the next flush
+        size_t sent = start(i);
+        lane.bytes.erase(lane.bytes.begin(), lane.bytes.begin() + sent);
+        lane.ends.erase(lane.ends.begin(), lane.ends.begin() + i);
+        for (uint32_t& e : lane.ends) e -= (uint32_t)sent;
+    }
+
+    double                                   _rate;  // per-peer cap
+    std::unordered_map<ENetPeer*, PeerQueue> _peers;
+    PacketWriter                             _bundle{BUNDLE_BYTES};
+    Stats                                    _stats;
+    Now                                      _now = Clock::now;
+    Sink                                     _sink;
+};
@@ -0,0 +1,205 @@
+#pragma once
+#include "packets.h"
+#include "inv_packets.h"
+#include "mp_packets.h"
+#include "player_stats.h"
+#include "shard_packets.h"
+#include "chunkgen_packets.h"
+#include <enet/enet.h>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+// ── Packet names ──────────────────────────────────────────────────────────────
+// Every id from the six packet enums, resolved at compile time. Ids nobody
+// defines come back as nullptr.
+
+namespace PacketNames {
+    constexpr std::array<const char*, 256> build() {
+        std::array<const char*, 256> n{};
+        n[(uint8_t)PacketID::ChunkData]         = "ChunkData";
+        n[(uint8_t)PacketID::PlayerMove]        = "PlayerMove";
+        n[(uint8_t)PacketID::PlayerJoin]        = "PlayerJoin";
+        n[(uint8_t)PacketID::PlayerLeave]       = "PlayerLeave";
+        n[(uint8_t)PacketID::SpawnPosition]     = "SpawnPosition";
+        n[(uint8_t)PacketID::RespawnRequest]    = "RespawnRequest";
+        n[(uint8_t)PacketID::ChunkField]        = "ChunkField";
+        n[(uint8_t)PacketID::ChunkUniform]      = "ChunkUniform";
+        n[(uint8_t)PacketID::ChunkUnload]       = "ChunkUnload";
+        n[(uint8_t)PacketID::Bundle]            = "Bundle";
+        n[(uint8_t)PacketID::ViewConfig]        = "ViewConfig";
+        n[(uint8_t)PacketID::ChunkUpdate]       = "ChunkUpdate";
+        n[(uint8_t)PacketID::TerrainEdit]       = "TerrainEdit";
+        n[(uint8_t)PacketID::ChunkHave]         = "ChunkHave";
+        n[(uint8_t)PacketID::ChunkCached]       = "ChunkCached";
+        n[(uint8_t)PacketID::ViewRadius]        = "ViewRadius";
+        n[(uint8_t)PacketID::ChunkDict]         = "ChunkDict";
+        n[(uint8_t)PacketID::ChunkPacked]       = "ChunkPacked";
+        n[(uint8_t)InvPacketID::InventoryState]   = "InventoryState";
+        n[(uint8_t)InvPacketID::ChestOpenReq]     = "ChestOpenReq";
+        n[(uint8_t)InvPacketID::ChestState]       = "ChestState";
+        n[(uint8_t)InvPacketID::ChestCloseReq]    = "ChestCloseReq";
+        n[(uint8_t)InvPacketID::InventoryMoveReq] = "InventoryMoveReq";
+        n[(uint8_t)InvPacketID::InventoryMoveAck] = "InventoryMoveAck";
+        n[(uint8_t)InvPacketID::LootAvailable]    = "LootAvailable";
+        n[(uint8_t)InvPacketID::HotbarModeSync]   = "HotbarModeSync";
+        n[(uint8_t)InvPacketID::InventoryResync]  = "InventoryResync";
+        n[(uint8_t)StatsPacketID::StatsSync]  = "StatsSync";
+        n[(uint8_t)StatsPacketID::StatsDelta] = "StatsDelta";
+        n[(uint8_t)MPPacketID::AuthRequest]    = "AuthRequest";
+        n[(uint8_t)MPPacketID::AuthResponse]   = "AuthResponse";
+        n[(uint8_t)MPPacketID::PlayerSpawn]    = "PlayerSpawn";
+        n[(uint8_t)MPPacketID::PlayerDespawn]  = "PlayerDespawn";
+        n[(uint8_t)MPPacketID::PlayerPosSync]  = "PlayerPosSync";
+        n[(uint8_t)MPPacketID::PlayerPosDelta] = "PlayerPosDelta";
+        n[(uint8_t)MPPacketID::PlayerMoveQ]    = "PlayerMoveQ";
+        n[(uint8_t)MPPacketID::EnemySync]      = "EnemySync";
+        n[(uint8_t)MPPacketID::EnemyHit]       = "EnemyHit";
+        n[(uint8_t)MPPacketID::MoveCorrection] = "MoveCorrection";
+        n[(uint8_t)MPPacketID::Replication]    = "Replication";
+        n[(uint8_t)MPPacketID::AdmissionQueue] = "AdmissionQueue";
+        n[(uint8_t)ShardPacketID::ShardHello]    = "ShardHello";
+        n[(uint8_t)ShardPacketID::ShardGhosts]   = "ShardGhosts";
+        n[(uint8_t)ShardPacketID::ShardHandoff]  = "ShardHandoff";
+        n[(uint8_t)ShardPacketID::ShardEdit]     = "ShardEdit";
+        n[(uint8_t)ShardPacketID::ShardRedirect] = "ShardRedirect";
+        n[(uint8_t)ChunkGenPacketID::ChunkGenHello]   = "ChunkGenHello";
+        n[(uint8_t)ChunkGenPacketID::ChunkGenRequest] = "ChunkGenRequest";
+        n[(uint8_t)ChunkGenPacketID::ChunkGenResult]  = "ChunkGenResult";
+        return n;
+    }
+    inline constexpr std::array<const char*, 256> table = build();
+
+    // The enums share one id space; two of them claiming the same byte
+    // would make dispatch ambiguous
+    constexpr size_t defined() {
+        size_t c = 0;
+        for (const char* s : table) c += s != nullptr;
+        return c;
+    }
+    static_assert(defined() == 49, "packet id collision (or a new id missing from PacketNames)");
+}
+
+inline const char* packetName(uint8_t id) { return PacketNames::table[id]; }
+
+// ── PacketDispatcher ──────────────────────────────────────────────────────────
+// One slot per id byte: dispatch() is a single indexed lookup instead of an
+// if/else chain across the enums. Each slot counts packets, bytes and time
+// spent in its handler; ids with no handler are counted and dropped.
+//
+// A gate, if set, is asked before every handler not registered as open —
+// the server uses it to hold everything but AuthRequest until a peer is
+// authenticated.
+//
+// Bundles are unpacked here: the Bundle slot counts the wrapper, and each
+// message inside is dispatched (and counted, and gated) as if it had
+// arrived alone.
+//
+// A fallback, if set, takes every id with no handler of its own instead of
+// it being dropped — the client's network thread uses it to hand whatever
+// it doesn't handle itself to the game thread.
+//
+// A timer, if set, is told each handler's start and end as well — the
+// server's TickWatchdog keeps them per tick.
+class PacketDispatcher {
+public:
+    using Handler = std::function<void(ENetPeer*, const uint8_t*, size_t)>;
+    using Gate    = std::function<bool(ENetPeer*)>;
+    using Clock   = std::chrono::steady_clock;
+    using Timer   = std::function<void(uint8_t id, Clock::time_point t0, Clock::time_point t1)>;
+
+    struct Stats {
+        uint8_t     id = 0;
+        const char* name = nullptr;  // nullptr for ids no enum defines
+        uint64_t    packets = 0;
+        uint64_t    bytes   = 0;
+        uint64_t    handlerNs = 0;
+        uint64_t    dropped = 0;     // no handler, or refused by the gate
+    };
+
+    template<class Id>
+    void on(Id id, Handler fn, bool open = false) {
+        Slot& s = _slots[(uint8_t)id];
+        s.fn   = std::move(fn);
+        s.open = open;
+    }
+
+    void setGate(Gate g) { _gate = std::move(g); }
+    void setFallback(Handler fn) { _fallback = std::move(fn); }
+    void setTimer(Timer fn) { _timer = std::move(fn); }
+
+    // False if the packet was dropped (empty, unhandled or gated). For a
+    // bundle, false if it was malformed; its messages count on their own.
+    bool dispatch(ENetPeer* peer, const uint8_t* d, size_t len) {
+        if (len == 0) return false;
+        Slot& s = _slots[d[0]];
+        s.packets++;
+        s.bytes += len;
+        if (d[0] == (uint8_t)PacketID::Bundle) return unbundle(peer, d, len);
+        const Handler& fn = s.fn ? s.fn : _fallback;
+        if (!fn || (!s.open && _gate && !_gate(peer))) { s.dropped++; return false; }
+
+        auto t0 = Clock::now();
+        fn(peer, d, len);
+        auto t1 = Clock::now();
+        s.handlerNs += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        if (_timer) _timer(d[0], t0, t1);
+        return true;
+    }
+
+    // Counters since the last call, busiest (by bytes) first; idle ids are
+    // left out
+    std::vector<Stats> takeStats() {
+        std::vector<Stats> out;
+        for (int i = 0; i < 256; i++) {
+            Slot& s = _slots[i];
+            if (s.packets == 0) continue;
+            out.push_back({(uint8_t)i, packetName((uint8_t)i), s.packets, s.bytes, s.handlerNs, s.dropped});
+            s.packets = s.bytes = s.handlerNs = s.dropped = 0;
+        }
+        std::sort(out.begin(), out.end(), [](const Stats& a, const Stats& b) { return a.bytes > b.bytes; });
+        return out;
+    }
+
+    // "Name: N pkts, K KB, T ms" per id, for the logs
+    static std::string format(const Stats& s) {
+        char id[8];
+        snprintf(id, sizeof(id), "0x%02X", s.id);
+        char buf[160];
+        snprintf(buf, sizeof(buf), "%s: %llu pkts, %llu KB, %.1f ms%s",
+                 s.name ? s.name : id, (unsigned long long)s.packets,
+                 (unsigned long long)(s.bytes >> 10), s.handlerNs / 1e6,
+                 s.dropped ? (", " + std::to_string(s.dropped) + " dropped").c_str() : "");
+        return buf;
+    }
+
+private:
+    bool unbundle(ENetPeer* peer, const uint8_t* d, size_t len) {
+        PacketReader r(d, len);
+        while (r.ok() && r.remaining() > 0) {
+            uint32_t n = r.varint();
+            const uint8_t* m = r.view(n);
+            if (!m || n == 0 || m[0] == (uint8_t)PacketID::Bundle) break; // no nesting
+            dispatch(peer, m, n);
+        }
+        if (r.ok() && r.remaining() == 0) return true;
+        _slots[(uint8_t)PacketID::Bundle].dropped++;
+        return false;
+    }
+
+    struct Slot {
+        Handler  fn;
+        bool     open = false;
+        uint64_t packets = 0, bytes = 0, handlerNs = 0, dropped = 0;
+    };
+
+    std::array<Slot, 256> _slots{};
+    Gate                  _gate;
+    Handler               _fallback;
+    Timer                 _timer;
+};
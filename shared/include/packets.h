@@ -2,7 +2,14 @@
 #include <vector>
 #include <cstdint>
 #include <cstring>
+#include <cmath>
+#include <bit>
+#include <memory>
+#include <algorithm>
+#include <string_view>
 #include "chunk.h"
+#include "marching_cubes.h"
+#include "view_tiers.h"
 #include <string>
 // Packet IDs
 enum class PacketID : uint8_t {
@@ -12,14 +19,34 @@ enum class PacketID : uint8_t {
     PlayerLeave  = 0x04,
     SpawnPosition = 0x05,
 RespawnRequest = 0x06,
+    ChunkField   = 0x07, // density/material field, meshed on the client
+    ChunkUniform = 0x08, // all-air / all-solid chunk — nothing to mesh
+    ChunkUnload  = 0x09, // client dropped these chunks — resend if needed again
+    Bundle       = 0x0A, // several small messages in one packet, see below
+    ViewConfig   = 0x0B, // server -> client: the view distance it will be sent
+    ChunkUpdate  = 0x0C, // server -> client: an edited chunk's payload, versioned
+    TerrainEdit  = 0x0D, // client -> server: dig or fill with a brush
+    ChunkHave    = 0x0E, // client -> server: chunks it has on disk, by content hash
+    ChunkCached  = 0x0F, // server -> client: load this chunk from your disk cache
+    // 0x10-0x3F are the inventory, stats and multiplayer packets
+    ViewRadius   = 0x40, // client -> server: a new view distance, answered with ViewConfig
+    ChunkDict    = 0x41, // server -> client: the dictionary ChunkPacked payloads use
+    ChunkPacked  = 0x42, // server -> client: a compressed chunk payload (chunk_codec.h)
+    // 0x50-0x5F are the shard links' (shard_packets.h), 0x60-0x6F the chunkgen
+    // service's (chunkgen_packets.h)
 };
 
 // ── Serialization helpers ─────────────────────────────────────────────────────
 
 inline void writeU8 (std::vector<uint8_t>& b, uint8_t  v) { b.push_back(v); }
+inline void writeU16(std::vector<uint8_t>& b, uint16_t v) {
+    b.push_back((uint8_t)(v>>8)); b.push_back((uint8_t)v);
+}
 inline void writeU32(std::vector<uint8_t>& b, uint32_t v) {
-    b.push_back((v>>24)&0xFF); b.push_back((v>>16)&0xFF);
-    b.push_back((v>> 8)&0xFF); b.push_back( v     &0xFF);
+    size_t o = b.size();
+    b.resize(o + 4);
+    b[o] = (uint8_t)(v>>24); b[o+1] = (uint8_t)(v>>16);
+    b[o+2] = (uint8_t)(v>> 8); b[o+3] = (uint8_t)v;
 }
 inline void writeF32(std::vector<uint8_t>& b, float v) {
     uint32_t tmp; memcpy(&tmp, &v, 4); writeU32(b, tmp);
@@ -36,82 +63,448 @@ inline float   readF32(const uint8_t* d, size_t& o) {
     uint32_t tmp = readU32(d,o); float v; memcpy(&v,&tmp,4); return v;
 }
 inline int32_t readI32(const uint8_t* d, size_t& o) { return (int32_t)readU32(d,o); }
+inline uint16_t readU16(const uint8_t* d, size_t& o) {
+    uint16_t v = (uint16_t)(((uint16_t)d[o]<<8)|d[o+1]);
+    o+=2; return v;
+}
 
-// ── Packets ───────────────────────────────────────────────────────────────────
+// Raw-pointer writers for pre-sized buffers (same big-endian layout)
+inline uint8_t* putU8 (uint8_t* p, uint8_t  v) { *p = v; return p + 1; }
+inline uint8_t* putU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)(v>>8); p[1] = (uint8_t)v; return p + 2;
+}
+inline uint8_t* putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v>>24); p[1] = (uint8_t)(v>>16);
+    p[2] = (uint8_t)(v>> 8); p[3] = (uint8_t)v; return p + 4;
+}
 
-struct ChunkDataPacket {
-    ChunkCoord            coord;
-    std::vector<float>    vertices;  // 8 floats per vertex: pos(3) normal(3) uv(2)
-    std::vector<uint32_t> materials; // 1 per vertex
-    std::vector<uint32_t> indices;
-
-    static ChunkDataPacket from(const ChunkMesh& mesh) {
-        ChunkDataPacket p;
-        p.coord = mesh.coord;
-        p.vertices.reserve(mesh.vertices.size() * 8);
-        p.materials.reserve(mesh.vertices.size());
-        for (auto& v : mesh.vertices) {
-            p.vertices.push_back(v.pos.x);
-            p.vertices.push_back(v.pos.y);
-            p.vertices.push_back(v.pos.z);
-            p.vertices.push_back(v.normal.x);
-            p.vertices.push_back(v.normal.y);
-            p.vertices.push_back(v.normal.z);
-            p.vertices.push_back(v.uv.x);
-            p.vertices.push_back(v.uv.y);
-            p.materials.push_back((uint32_t)v.material);
+// ── PacketWriter / PacketReader ───────────────────────────────────────────────
+// Same big-endian wire layout as the helpers above. A writer owns a growable
+// buffer that survives clear(), so a long-lived writer (one per sender) stops
+// allocating after its first few packets; values go in with one memcpy each.
+// Send straight from data()/size() — ENet copies the bytes anyway.
+//
+// The reader is bounds-checked: running off the end returns zeros and latches
+// ok() false, so deserializers read straight through and check once. Strings
+// and byte runs come back as views into the packet.
+
+namespace Wire {
+    inline uint16_t be16(uint16_t v) {
+        if constexpr (std::endian::native == std::endian::big) return v;
+        return (uint16_t)(v << 8 | v >> 8);
+    }
+    inline uint32_t be32(uint32_t v) {
+        if constexpr (std::endian::native == std::endian::big) return v;
+        return (v << 24) | ((v << 8) & 0x00FF0000u) | ((v >> 8) & 0x0000FF00u) | (v >> 24);
+    }
+}
+
+class PacketWriter {
+public:
+    explicit PacketWriter(size_t capacity = 256) { grow(capacity); }
+
+    // Start a packet; bytes is the expected total, so the writes that follow
+    // don't have to grow the buffer
+    PacketWriter& begin(uint8_t id, size_t bytes = 0) {
+        _size = 0;
+        reserve(bytes);
+        return u8(id);
+    }
+    void clear() { _size = 0; }
+    void reserve(size_t n) { if (_size + n > _cap) grow(_size + n); }
+
+    PacketWriter& u8 (uint8_t v)  { *take(1) = v; return *this; }
+    PacketWriter& u16(uint16_t v) { v = Wire::be16(v); std::memcpy(take(2), &v, 2); return *this; }
+    PacketWriter& u32(uint32_t v) { v = Wire::be32(v); std::memcpy(take(4), &v, 4); return *this; }
+    PacketWriter& i16(int16_t v)  { return u16((uint16_t)v); }
+    PacketWriter& i32(int32_t v)  { return u32((uint32_t)v); }
+    PacketWriter& f32(float v)    { uint32_t t; std::memcpy(&t, &v, 4); return u32(t); }
+
+    PacketWriter& bytes(const void* p, size_t n) {
+        if (n) std::memcpy(take(n), p, n);
+        return *this;
+    }
+    // u32 length + bytes, as every string field on the wire is laid out
+    PacketWriter& str(const std::string& s) { return u32((uint32_t)s.size()).bytes(s.data(), s.size()); }
+
+    PacketWriter& varint(uint32_t v) {                // LEB128
+        for (; v >= 0x80; v >>= 7) u8((uint8_t)(v & 0x7F) | 0x80);
+        return u8((uint8_t)v);
+    }
+
+    // Reserve n bytes to patch later (length prefixes); returns their offset
+    size_t skip(size_t n) { take(n); return _size - n; }
+    void   patchU32(size_t at, uint32_t v) { v = Wire::be32(v); std::memcpy(_buf.get() + at, &v, 4); }
+
+    const uint8_t* data() const { return _buf.get(); }
+    size_t         size() const { return _size; }
+
+    // For APIs that keep the bytes (caches, the old serialize() signatures)
+    std::vector<uint8_t> toVector() const { return {_buf.get(), _buf.get() + _size}; }
+
+private:
+    uint8_t* take(size_t n) {
+        if (_size + n > _cap) grow(_size + n);
+        uint8_t* p = _buf.get() + _size;
+        _size += n;
+        return p;
+    }
+    void grow(size_t need) {
+        size_t cap = std::max<size_t>(need, _cap * 2);
+        if (cap == 0) return;
+        auto nb = std::make_unique_for_overwrite<uint8_t[]>(cap);
+        if (_size) std::memcpy(nb.get(), _buf.get(), _size);
+        _buf = std::move(nb);
+        _cap = cap;
+    }
+
+    std::unique_ptr<uint8_t[]> _buf;
+    size_t                     _size = 0;
+    size_t                     _cap  = 0;
+};
+
+class PacketReader {
+public:
+    // Starts past the packet id by default
+    PacketReader(const uint8_t* d, size_t len, size_t offset = 1)
+        : _d(d), _len(len), _o(offset <= len ? offset : len), _ok(offset <= len) {}
+
+    bool   ok()        const { return _ok; }
+    size_t offset()    const { return _o; }
+    size_t remaining() const { return _len - _o; }
+    bool   has(size_t n) const { return _len - _o >= n; }
+
+    uint8_t  u8()  { const uint8_t* p = view(1); return p ? *p : 0; }
+    uint16_t u16() { uint16_t v = 0; if (auto* p = view(2)) std::memcpy(&v, p, 2); return Wire::be16(v); }
+    uint32_t u32() { uint32_t v = 0; if (auto* p = view(4)) std::memcpy(&v, p, 4); return Wire::be32(v); }
+    int16_t  i16() { return (int16_t)u16(); }
+    int32_t  i32() { return (int32_t)u32(); }
+    float    f32() { uint32_t t = u32(); float v; std::memcpy(&v, &t, 4); return v; }
+
+    uint32_t varint() {
+        uint32_t v = 0;
+        for (int shift = 0; shift <= 28; shift += 7) {
+            uint8_t c = u8();
+            v |= (uint32_t)(c & 0x7F) << shift;
+            if (!(c & 0x80)) return v;
         }
-        p.indices = mesh.indices;
+        return fail(), 0;
+    }
+
+    // n bytes in place, or nullptr (and !ok()) if the packet is short
+    const uint8_t* view(size_t n) {
+        if (!_ok || !has(n)) return fail(), nullptr;
+        const uint8_t* p = _d + _o;
+        _o += n;
         return p;
     }
 
-    ChunkMesh toMesh() const {
-        ChunkMesh m;
-        m.coord = coord;
-        size_t vertCount = vertices.size() / 8;
-        m.vertices.reserve(vertCount);
-        for (size_t i = 0; i < vertCount; i++) {
-            size_t b = i * 8;
-            Vertex v;
-            v.pos      = {vertices[b],   vertices[b+1], vertices[b+2]};
-            v.normal   = {vertices[b+3], vertices[b+4], vertices[b+5]};
-            v.uv       = {vertices[b+6], vertices[b+7]};
-            v.material = (i < materials.size()) ? materials[i] : 0u;
-            m.vertices.push_back(v);
+    // u32-prefixed string, in place
+    std::string_view str() {
+        uint32_t n = u32();
+        const uint8_t* p = view(n);
+        return p ? std::string_view((const char*)p, n) : std::string_view{};
+    }
+
+private:
+    void fail() { _ok = false; _o = _len; }
+
+    const uint8_t* _d;
+    size_t         _len;
+    size_t         _o;
+    bool           _ok;
+};
+
+// ── Packets ───────────────────────────────────────────────────────────────────
+
+// Bundle: small messages coalesced into one ENet packet, each prefixed with
+// its length. Receivers unpack it in PacketDispatcher, so handlers never see
+// the wrapper.
+//   u8 id | { varint len | message }*
+
+// ChunkData wire format v2 (byte 1 after the packet id). Sized once and written
+// through raw pointers. Per vertex:
+//   u16 x,y,z   chunk-local position, fixed point at 1/POS_SCALE block
+//   u8  nu,nv   octahedral-encoded normal
+//   u8  mat     BlockMat
+// UVs aren't sent — the client rebuilds them with terrainUV(). Indices are u16
+// whenever the vertex count allows it (flag bit 0), u32 otherwise. Flag bits
+// 4-6 are the mesh's level of detail (ChunkKey::lod; coord is then the LOD
+// cell and positions are in its cells). The trailing face links (see
+// faceLinkBit) may be missing; the chunk is then taken as open everywhere.
+//   u8 id | u8 format | i32 cx,cy,cz | u8 flags | u32 nVerts | verts | u32 nIdx | idx
+//   [| u16 faceLinks]
+struct ChunkDataPacket {
+    static constexpr uint8_t  FORMAT       = 2;
+    // Bump whenever the layout changes — persisted regions key on it. A
+    // chunk size other than 32 is part of it: positions scale with it.
+    static constexpr uint32_t WIRE_VERSION = FORMAT | (ChunkData::SIZE == 32 ? 0u : (uint32_t)ChunkData::SIZE << 16);
+
+    static constexpr float    POS_SCALE    = 32768.f / ChunkData::SIZE; // 0..SIZE → 0..32768
+    static constexpr uint8_t  FLAG_IDX16   = 1 << 0;
+    static constexpr int      LOD_SHIFT    = 4;
+    static constexpr uint8_t  LOD_MASK     = 7;
+    static constexpr size_t   HEADER_BYTES = 1 + 1 + 12 + 1 + 4;
+    static constexpr size_t   VERTEX_BYTES = 6 + 2 + 1;
+
+    static std::vector<uint8_t> serialize(const ChunkMesh& mesh) {
+        bool idx16 = mesh.vertices.size() <= 0x10000;
+        std::vector<uint8_t> b(HEADER_BYTES + mesh.vertices.size() * VERTEX_BYTES +
+                               4 + mesh.indices.size() * (idx16 ? 2 : 4) + 2);
+        uint8_t* p = b.data();
+        p = putU8 (p, (uint8_t)PacketID::ChunkData);
+        p = putU8 (p, FORMAT);
+        p = putU32(p, (uint32_t)mesh.coord.x);
+        p = putU32(p, (uint32_t)mesh.coord.y);
+        p = putU32(p, (uint32_t)mesh.coord.z);
+        p = putU8 (p, (uint8_t)((idx16 ? FLAG_IDX16 : 0) | (mesh.lod & LOD_MASK) << LOD_SHIFT));
+        p = putU32(p, (uint32_t)mesh.vertices.size());
+        for (const Vertex& v : mesh.vertices) {
+            p = putU16(p, quantizePos(v.pos.x));
+            p = putU16(p, quantizePos(v.pos.y));
+            p = putU16(p, quantizePos(v.pos.z));
+            uint16_t n = octEncode(v.normal);
+            p = putU8 (p, (uint8_t)(n >> 8));
+            p = putU8 (p, (uint8_t)n);
+            p = putU8 (p, (uint8_t)v.material);
         }
-        m.indices = indices;
+        p = putU32(p, (uint32_t)mesh.indices.size());
+        if (idx16) for (uint32_t i : mesh.indices) p = putU16(p, (uint16_t)i);
+        else       for (uint32_t i : mesh.indices) p = putU32(p, i);
+        putU16(p, mesh.faceLinks);
+        return b;
+    }
+
+    // Malformed or foreign-format input yields an empty mesh (coord is still
+    // filled in when the header is readable).
+    static ChunkMesh deserialize(const uint8_t* d, size_t len) {
+        ChunkMesh m{};
+        deserialize(d, len, m);
         return m;
     }
 
+    // Decodes into m, reusing its vectors' capacity
+    static void deserialize(const uint8_t* d, size_t len, ChunkMesh& m) {
+        m.coord = {};
+        m.lod   = 0;
+        m.faceLinks = FACE_LINKS_ALL;
+        m.vertices.clear();
+        m.indices.clear();
+        if (len < HEADER_BYTES || d[1] != FORMAT) return;
+
+        size_t o = 2;
+        m.coord.x = readI32(d,o); m.coord.y = readI32(d,o); m.coord.z = readI32(d,o);
+        uint8_t  flags = readU8(d,o);
+        bool     idx16 = flags & FLAG_IDX16;
+        m.lod          = (uint8_t)(flags >> LOD_SHIFT & LOD_MASK);
+        uint32_t vc    = readU32(d,o);
+        if ((len - o) / VERTEX_BYTES < vc)
+            return;
+        if (len - o - (size_t)vc * VERTEX_BYTES < 4) return;
+
+        m.vertices.resize(vc);
+        for (Vertex& v : m.vertices) {
+            v.pos.x = dequantizePos(readU16(d,o));
+            v.pos.y = dequantizePos(readU16(d,o));
+            v.pos.z = dequantizePos(readU16(d,o));
+            uint8_t nu = readU8(d,o), nv = readU8(d,o);
+            v.normal   = octDecode(nu, nv);
+            v.material = readU8(d,o);
+            v.uv       = terrainUV(v.pos, v.normal);
+            v.occlusion = 0; // not on the wire
+        }
+
+        uint32_t ic = readU32(d,o);
+        if ((len - o) / (idx16 ? 2 : 4) < ic) { m.vertices.clear(); return; }
+        m.indices.resize(ic);
+        if (idx16) for (auto& i : m.indices) i = readU16(d,o);
+        else       for (auto& i : m.indices) i = readU32(d,o);
+        for (uint32_t i : m.indices)
+            if (i >= vc) { m.vertices.clear(); m.indices.clear(); return; }
+        if (len - o >= 2) m.faceLinks = readU16(d,o);
+    }
+
+    static uint16_t quantizePos(float v) {
+        float q = v * POS_SCALE + 0.5f;
+        return (uint16_t)(q < 0.f ? 0.f : q > 65535.f ? 65535.f : q);
+    }
+    static float dequantizePos(uint16_t q) { return (float)q / POS_SCALE; }
+
+    // Octahedral normal: project onto |x|+|y|+|z|=1, fold the lower half over,
+    // store the xy plane as two unorm8s.
+    static uint16_t octEncode(glm::vec3 n) {
+        float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+        if (l1 < 1e-20f) return 0x8080;
+        float x = n.x / l1, y = n.y / l1;
+        if (n.z < 0.f) {
+            float fx = (1.f - std::fabs(y)) * (x >= 0.f ? 1.f : -1.f);
+            float fy = (1.f - std::fabs(x)) * (y >= 0.f ? 1.f : -1.f);
+            x = fx; y = fy;
+        }
+        auto toU8 = [](float f) { return (uint16_t)std::lround((f * 0.5f + 0.5f) * 255.f); };
+        return (uint16_t)(toU8(x) << 8 | toU8(y));
+    }
+    static glm::vec3 octDecode(uint8_t u, uint8_t v) {
+        float x = u / 255.f * 2.f - 1.f;
+        float y = v / 255.f * 2.f - 1.f;
+        float z = 1.f - std::fabs(x) - std::fabs(y);
+        if (z < 0.f) {
+            float fx = (1.f - std::fabs(y)) * (x >= 0.f ? 1.f : -1.f);
+            float fy = (1.f - std::fabs(x)) * (y >= 0.f ? 1.f : -1.f);
+            x = fx; y = fy;
+        }
+        float len = std::sqrt(x*x + y*y + z*z);
+        return {x / len, y / len, z / len};
+    }
+};
+
+// ChunkField: the chunk's scalar field instead of its mesh, for clients that
+// negotiated CAP_CHUNK_FIELDS. Densities are quantized to int8 (sign kept
+// exact, so the surface topology matches the server's), then the density and
+// material grids are each run-length encoded in ChunkData's [x][z][y] order,
+// so runs follow columns. All-air and all-solid chunks collapse to a few
+// bytes.
+//   u8 id | u8 format | i32 cx,cy,cz | u32 densityBytes | RLE densities | RLE materials
+// RLE is a sequence of {varint run, u8 value}.
+struct ChunkFieldPacket {
+    static constexpr uint8_t  FORMAT        = 2; // 2: [x][z][y] order
+    // Persisted regions key on this; the high byte keeps it from ever
+    // colliding with ChunkDataPacket::WIRE_VERSION. A chunk size other than
+    // 32 is part of it, as VOXELS is.
+    static constexpr uint32_t WIRE_VERSION  = 0x100 | FORMAT |
+                                              (ChunkData::SIZE == 32 ? 0u : (uint32_t)ChunkData::SIZE << 16);
+    static constexpr float    DENSITY_SCALE = 127.f / 2.f; // generator clamps to ±2
+    static constexpr size_t   HEADER_BYTES  = 1 + 1 + 12 + 4;
+    static constexpr size_t   VOXELS        = (size_t)ChunkData::PADDED *
+                                              ChunkData::PADDED * ChunkData::PADDED;
+
+    static std::vector<uint8_t> serialize(const ChunkData& data) {
+        std::vector<uint8_t> b;
+        b.reserve(256);
+        writeU8 (b, (uint8_t)PacketID::ChunkField);
+        writeU8 (b, FORMAT);
+        writeI32(b, data.coord.x); writeI32(b, data.coord.y); writeI32(b, data.coord.z);
+        size_t lenAt = b.size();
+        writeU32(b, 0);
+
+        const ChunkData::Voxel* vox = &data.voxels[0][0][0];
+        rleEncode(b, VOXELS, [&](size_t i) { return (uint8_t)toWire(vox[i].density); });
+        uint32_t densityBytes = (uint32_t)(b.size() - lenAt - 4);
+        putU32(b.data() + lenAt, densityBytes);
+
+        rleEncode(b, VOXELS, [&](size_t i) { return vox[i].material; });
+        return b;
+    }
+
+    // Returns false (out untouched past coord) on malformed input.
+    static bool deserialize(const uint8_t* d, size_t len, ChunkData& out) {
+        if (len < HEADER_BYTES || d[1] != FORMAT) return false;
+        size_t o = 2;
+        out.coord.x = readI32(d,o); out.coord.y = readI32(d,o); out.coord.z = readI32(d,o);
+        uint32_t densityBytes = readU32(d,o);
+        if (densityBytes > len - o) return false;
+
+        ChunkData::Voxel* vox = &out.voxels[0][0][0];
+        if (!rleDecode(d + o, densityBytes, VOXELS,
+                       [&](size_t i, uint8_t v) { vox[i].density = fromWire((int8_t)v); }))
+            return false;
+        o += densityBytes;
+
+        return rleDecode(d + o, len - o, VOXELS,
+                         [&](size_t i, uint8_t v) { vox[i].material = v; });
+    }
+
+    // Just the densities, in wire units, into VOXELS bytes at out — for
+    // readers with no use for materials. False on malformed input.
+    static bool deserializeDensities(const uint8_t* d, size_t len, int8_t* out) {
+        if (len < HEADER_BYTES || d[1] != FORMAT) return false;
+        size_t o = HEADER_BYTES - 4;
+        uint32_t densityBytes = readU32(d,o);
+        if (densityBytes > len - o) return false;
+        return rleDecode(d + o, densityBytes, VOXELS, [&](size_t i, uint8_t v) { out[i] = (int8_t)v; });
+    }
+
+    // Zero and positive stay >= 0, anything negative stays <= -1, so
+    // "v < iso" classifies every corner the same after the round trip.
+    static int8_t quantizeDensity(float v) {
+        float q = std::round(v * DENSITY_SCALE);
+        if (q >  127.f) q =  127.f;
+        if (q < -127.f) q = -127.f;
+        if (v < 0.f && q > -1.f) q = -1.f;
+        return (int8_t)q;
+    }
+    static float dequantizeDensity(int8_t q) { return (float)q / DENSITY_SCALE; }
+
+    // ChunkData's fixed point to the wire's and back; the identity at 8 bits
+    static int8_t toWire(ChunkData::Density q) {
+        if constexpr (sizeof(ChunkData::Density) == 1) return q;
+        else return quantizeDensity(ChunkData::dequantize(q));
+    }
+    static ChunkData::Density fromWire(int8_t q) {
+        if constexpr (sizeof(ChunkData::Density) == 1) return q;
+        else return ChunkData::quantize(dequantizeDensity(q));
+    }
+
+private:
+    template<class Get>
+    static void rleEncode(std::vector<uint8_t>& b, size_t n, Get get) {
+        size_t i = 0;
+        while (i < n) {
+            uint8_t v   = get(i);
+            size_t  run = 1;
+            while (i + run < n && get(i + run) == v) run++;
+            for (size_t r = run; ; r >>= 7) {          // LEB128 run length
+                if (r < 0x80) { b.push_back((uint8_t)r); break; }
+                b.push_back((uint8_t)(r & 0x7F) | 0x80);
+            }
+            b.push_back(v);
+            i += run;
+        }
+    }
+
+    template<class Put>
+    static bool rleDecode(const uint8_t* d, size_t len, size_t n, Put put) {
+        size_t o = 0, i = 0;
+        while (i < n) {
+            size_t run = 0;
+            for (int shift = 0; ; shift += 7) {
+                if (o >= len || shift > 28) return false;
+                uint8_t c = d[o++];
+                run |= (size_t)(c & 0x7F) << shift;
+                if (!(c & 0x80)) break;
+            }
+            if (o >= len || run == 0 || run > n - i) return false;
+            uint8_t v = d[o++];
+            for (size_t r = 0; r < run; r++) put(i++, v);
+        }
+        return true;
+    }
+};
+
+// Stand-in for both ChunkData and ChunkField when a chunk has no surface.
+// Clients treat it as an empty mesh.
+struct ChunkUniformPacket {
+    ChunkCoord      coord;
+    ChunkData::Fill fill;
+
     std::vector<uint8_t> serialize() const {
         std::vector<uint8_t> b;
-        writeU8(b, (uint8_t)PacketID::ChunkData);
+        writeU8 (b, (uint8_t)PacketID::ChunkUniform);
         writeI32(b, coord.x); writeI32(b, coord.y); writeI32(b, coord.z);
-        writeU32(b, (uint32_t)vertices.size());
-        for (float f : vertices)    writeF32(b, f);
-        writeU32(b, (uint32_t)materials.size());
-        for (uint32_t mat : materials) writeU32(b, mat);
-        writeU32(b, (uint32_t)indices.size());
-        for (uint32_t i : indices)  writeU32(b, i);
+        writeU8 (b, (uint8_t)fill);
         return b;
     }
 
-    static ChunkDataPacket deserialize(const uint8_t* d, size_t len) {
-        ChunkDataPacket p;
-        size_t o = 1; // skip packet id
+    static ChunkUniformPacket deserialize(const uint8_t* d, size_t len) {
+        ChunkUniformPacket p{};
+        if (len < 14) return p;
+        size_t o = 1;
         p.coord.x = readI32(d,o); p.coord.y = readI32(d,o); p.coord.z = readI32(d,o);
-        uint32_t vc = readU32(d,o);
-        p.vertices.resize(vc);
-        for (auto& f : p.vertices)  f = readF32(d,o);
-        uint32_t mc = readU32(d,o);
-        p.materials.resize(mc);
-        for (auto& mat : p.materials) mat = readU32(d,o);
-        uint32_t ic = readU32(d,o);
-        p.indices.resize(ic);
-        for (auto& i : p.indices)   i = readU32(d,o);
+        p.fill = (ChunkData::Fill)readU8(d,o);
         return p;
     }
 };
+
 struct PlayerMovePacket {
     float x, y, z;
     float yaw, pitch;
@@ -175,3 +568,183 @@ struct RespawnRequestPacket {
         return b;
     }
 };
+
+// The ViewTiers the server settled on from AuthRequest's view radius, sent
+// after auth and in answer to each ViewRadius, so the client evicts by the
+// same rules. world names what
+// the server generates (seed and payload formats), so a client keeps one
+// disk cache per world; older servers leave it off and read as 0, no cache.
+//   u8 id | u8 r | u8 ry | u8 levels | u32 world
+struct ViewConfigPacket {
+    ViewTiers tiers;
+    uint32_t  world = 0;
+
+    void write(PacketWriter& w) const {
+        w.begin((uint8_t)PacketID::ViewConfig, 8)
+         .u8((uint8_t)tiers.r).u8((uint8_t)tiers.ry).u8((uint8_t)tiers.levels).u32(world);
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, ViewConfigPacket& out) {
+        PacketReader r(d, len);
+        ViewTiers t;
+        t.r      = r.u8();
+        t.ry     = r.u8();
+        t.levels = r.u8();
+        if (!r.ok() || t.r < 1 || t.ry < 0 || t.levels > Config::LOD_LEVELS_MAX) return false;
+        out.tiers = t;
+        out.world = r.has(4) ? r.u32() : 0;
+        return true;
+    }
+};
+
+// A view distance asked for after login, as AuthRequest's; the server
+// answers with a fresh ViewConfig. Sent when the client drops or restores
+// detail to fit its memory.
+//   u8 id | u8 radius
+struct ViewRadiusPacket {
+    uint8_t radius = Config::CHUNK_RADIUS_XZ;
+
+    void write(PacketWriter& w) const { w.begin((uint8_t)PacketID::ViewRadius, 2).u8(radius); }
+
+    static bool deserialize(const uint8_t* d, size_t len, ViewRadiusPacket& out) {
+        PacketReader r(d, len);
+        out.radius = r.u8();
+        return r.ok() && out.radius >= 1;
+    }
+};
+
+// Chunks the client evicted. The server forgets it sent them, so walking
+// back into range sends them again.
+struct ChunkUnloadPacket {
+    static constexpr size_t MAX_COORDS = 4096;
+
+    std::vector<ChunkCoord> coords;
+
+    // Up to MAX_COORDS of them from coords[from]; returns where the next
+    // packet picks up, coords.size() once they're all written
+    size_t write(PacketWriter& w, size_t from = 0) const {
+        size_t n = std::min(coords.size() - std::min(from, coords.size()), MAX_COORDS);
+        w.begin((uint8_t)PacketID::ChunkUnload, 3 + n * 12).u16((uint16_t)n);
+        for (size_t i = from; i < from + n; i++)
+            w.i32(coords[i].x).i32(coords[i].y).i32(coords[i].z);
+        return from + n;
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, ChunkUnloadPacket& out) {
+        PacketReader r(d, len);
+        uint16_t n = r.u16();
+        if (!r.has((size_t)n * 12)) return false;
+        out.coords.resize(n);
+        for (auto& c : out.coords) { c.x = r.i32(); c.y = r.i32(); c.z = r.i32(); }
+        return r.ok();
+    }
+};
+
+// ── Client chunk cache ────────────────────────────────────────────────────────
+// A client keeps the full-resolution chunk packets it was sent on disk and,
+// once placed, lists the ones around it by a hash of their bytes. A chunk
+// the server is about to send goes out as a ChunkCached instead when the
+// hashes agree. The hash stands in for a version: edit versions start over
+// with every server run, the bytes don't lie. It covers the chunk packet
+// itself — ChunkField, ChunkData or ChunkUniform, never the ChunkUpdate
+// wrapping an edited one.
+
+// 64-bit FNV-1a
+inline uint64_t payloadHash(const uint8_t* p, size_t n) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < n; i++) { h ^= p[i]; h *= 1099511628211ull; }
+    return h;
+}
+
+//   u8 id | u16 n | n * (i32 cx,cy,cz | u32 hash hi | u32 hash lo)
+struct ChunkHavePacket {
+    static constexpr size_t MAX_ENTRIES = 4096;
+
+    struct Entry {
+        ChunkCoord coord;
+        uint64_t   hash;
+    };
+    std::vector<Entry> entries;
+
+    void write(PacketWriter& w) const {
+        size_t n = std::min(entries.size(), MAX_ENTRIES);
+        w.begin((uint8_t)PacketID::ChunkHave, 3 + n * 20).u16((uint16_t)n);
+        for (size_t i = 0; i < n; i++) {
+            const Entry& e = entries[i];
+            w.i32(e.coord.x).i32(e.coord.y).i32(e.coord.z)
+             .u32((uint32_t)(e.hash >> 32)).u32((uint32_t)e.hash);
+        }
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, ChunkHavePacket& out) {
+        PacketReader r(d, len);
+        uint16_t n = r.u16();
+        if (!r.has((size_t)n * 20)) return false;
+        out.entries.resize(n);
+        for (auto& e : out.entries) {
+            e.coord.x = r.i32(); e.coord.y = r.i32(); e.coord.z = r.i32();
+            uint64_t hi = r.u32();
+            e.hash = hi << 32 | r.u32();
+        }
+        return r.ok();
+    }
+};
+
+// The chunk at coord is the one the client listed with this hash. version
+// is the edit version it would have been wrapped with, 0 if never edited.
+//   u8 id | i32 cx,cy,cz | u32 version | u32 hash hi | u32 hash lo
+struct ChunkCachedPacket {
+    static constexpr size_t BYTES = 1 + 12 + 4 + 8;
+
+    ChunkCoord coord;
+    uint32_t   version = 0;
+    uint64_t   hash    = 0;
+
+    void write(PacketWriter& w) const {
+        w.begin((uint8_t)PacketID::ChunkCached, BYTES)
+         .i32(coord.x).i32(coord.y).i32(coord.z).u32(version)
+         .u32((uint32_t)(hash >> 32)).u32((uint32_t)hash);
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, ChunkCachedPacket& out) {
+        PacketReader r(d, len);
+        out.coord.x = r.i32(); out.coord.y = r.i32(); out.coord.z = r.i32();
+        out.version = r.u32();
+        uint64_t hi = r.u32();
+        out.hash = hi << 32 | r.u32();
+        return r.ok();
+    }
+};
+
+// The dictionary this client's ChunkPacked payloads are compressed with
+// (ChunkDict, chunk_codec.h), sent once on the stream channel ahead of the
+// first of them. bytes is a view into the packet.
+//   u8 id | u8 codec | u32 dictId | dictionary
+struct ChunkDictPacket {
+    uint8_t        codec  = 0;
+    uint32_t       dictId = 0;
+    const uint8_t* bytes  = nullptr;
+    size_t         size   = 0;
+
+    void write(PacketWriter& w) const {
+        w.begin((uint8_t)PacketID::ChunkDict, 6 + size).u8(codec).u32(dictId).bytes(bytes, size);
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, ChunkDictPacket& out) {
+        PacketReader r(d, len);
+        out.codec  = r.u8();
+        out.dictId = r.u32();
+        out.size   = r.remaining();
+        out.bytes  = r.view(out.size);
+        return r.ok() && out.size > 0;
+    }
+};
+
+// A ChunkField, ChunkData or ChunkUniform payload compressed with the
+// dictionary dictId, on its own or inside a ChunkUpdate; rawLen is its size
+// decompressed. Built and taken apart by ChunkDict::pack / unpack.
+//   u8 id | u8 codec | u32 dictId | u32 rawLen | compressed
+struct ChunkPackedPacket {
+    static constexpr size_t HEADER_BYTES = 1 + 1 + 4 + 4;
+    static constexpr size_t RAW_MAX      = 16 << 20; // more than any chunk payload
+};
@@ -0,0 +1,216 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include <tiny_gltf.h>
+#include "log.h"
+
+struct PlayerVertex {
+    glm::vec3 pos;
+    glm::vec3 normal;
+    glm::vec2 uv;
+    uint8_t   joints[4];  // JOINTS_0; unused while jointCount is 0
+    uint8_t   weights[4]; // WEIGHTS_0, unorm
+};
+
+// ── PlayerMesh ────────────────────────────────────────────────────────────────
+// The player model as RemotePlayerRenderer uploads it: one vertex/index list
+// over all triangle primitives, each material's base colour tiled into a row
+// of a single RGBA atlas with UVs remapped into its tile. Built from the GLB
+// by buildPlayerMesh, or read pre-built from the asset_bake blob.
+struct PlayerMesh {
+    std::vector<PlayerVertex> verts;
+    std::vector<uint32_t>     inds;
+    std::vector<uint8_t>      atlas; // RGBA8
+    int                       atlasW = 0, atlasH = 0;
+    glm::vec3                 boundsMin{0.f}, boundsMax{0.f};
+    uint32_t                  jointCount = 0; // first skin's joints; 0 = static
+};
+
+inline bool buildPlayerMesh(const char* glbPath, PlayerMesh& out) {
+    tinygltf::Model gltf;
+    tinygltf::TinyGLTF loader;
+    std::string err, warn;
+    if (!loader.LoadBinaryFromFile(&gltf, &err, &warn, glbPath)) {
+        Log::err("Player GLB failed: " + err); return false;
+    }
+
+    // ── Per-material diffuse textures ─────────────────────────────────────
+    struct MatTex { std::vector<uint8_t> rgba; int w=0, h=0; glm::vec4 col{1}; };
+    std::vector<MatTex> mats(gltf.materials.size());
+    for (int mi = 0; mi < (int)gltf.materials.size(); mi++) {
+        auto& mat = gltf.materials[mi]; auto& mt = mats[mi];
+        if (mat.pbrMetallicRoughness.baseColorFactor.size()==4) {
+            auto& f = mat.pbrMetallicRoughness.baseColorFactor;
+            mt.col = {(float)f[0],(float)f[1],(float)f[2],(float)f[3]};
+        }
+        if (mat.pbrMetallicRoughness.baseColorTexture.index >= 0) {
+            int src = gltf.textures[mat.pbrMetallicRoughness.baseColorTexture.index].source;
+            if (src >= 0 && src < (int)gltf.images.size()) {
+                auto& img = gltf.images[src];
+                if (!img.image.empty()) {
+                    mt.w = img.width; mt.h = img.height;
+                    if (img.component == 4) { mt.rgba = img.image; }
+                    else if (img.component == 3) {
+                        mt.rgba.resize(img.width*img.height*4);
+                        for (int p=0;p<img.width*img.height;p++) {
+                            mt.rgba[p*4]=img.image[p*3]; mt.rgba[p*4+1]=img.image[p*3+1];
+                            mt.rgba[p*4+2]=img.image[p*3+2]; mt.rgba[p*4+3]=255;
+                        }
+                    }
+                }
+            }
+        }
+        if (mt.rgba.empty()) {
+            mt.w=1; mt.h=1; mt.rgba.resize(4);
+            mt.rgba[0]=(uint8_t)(mt.col.r*255); mt.rgba[1]=(uint8_t)(mt.col.g*255);
+            mt.rgba[2]=(uint8_t)(mt.col.b*255); mt.rgba[3]=(uint8_t)(mt.col.a*255);
+        }
+    }
+
+    // ── Bake atlas: tiles in a row ────────────────────────────────────────
+    int numMats = (int)mats.size();
+    int tile = 512, atlasW = tile*numMats, atlasH = tile;
+    std::vector<uint8_t>& atlas = out.atlas;
+    atlas.assign((size_t)atlasW*atlasH*4, 0);
+    out.atlasW = atlasW; out.atlasH = atlasH;
+    for (int mi=0; mi<numMats; mi++) {
+        auto& mt = mats[mi]; int ox = mi*tile;
+        for (int y=0; y<tile; y++) for (int x=0; x<tile; x++) {
+            int sx = mt.w>1 ? x%mt.w : 0, sy = mt.h>1 ? y%mt.h : 0;
+            int si = (sy*mt.w+sx)*4, di = (y*atlasW+ox+x)*4;
+            memcpy(&atlas[di], &mt.rgba[si], 4);
+        }
+    }
+
+    if (!gltf.skins.empty()) {
+        size_t n = gltf.skins[0].joints.size();
+        if (n <= 256) out.jointCount = (uint32_t)n;
+        else Log::warn("Player skin has "+std::to_string(n)+" joints, drawing it static");
+    }
+
+    // ── Extract verts, remap UVs ──────────────────────────────────────────
+    std::vector<PlayerVertex>& verts = out.verts; std::vector<uint32_t>& inds = out.inds;
+    glm::vec3 mn{1e9f}, mx{-1e9f};
+    for (auto& mesh : gltf.meshes) for (auto& prim : mesh.primitives) {
+        if (prim.mode != TINYGLTF_MODE_TRIANGLES) continue;
+        int mi = prim.material >= 0 ? prim.material : 0;
+        float uOff = (float)mi/(float)numMats, uScl = 1.f/(float)numMats;
+
+        auto posIt = prim.attributes.find("POSITION");
+        if (posIt == prim.attributes.end()) continue;
+        auto& pa = gltf.accessors[posIt->second];
+        auto& pv = gltf.bufferViews[pa.bufferView];
+        const uint8_t* pr = gltf.buffers[pv.buffer].data.data()+pv.byteOffset+pa.byteOffset;
+        size_t ps = pv.byteStride ? pv.byteStride : 12;
+
+        const uint8_t* nr=nullptr; size_t ns=12;
+        auto ni = prim.attributes.find("NORMAL");
+        if (ni!=prim.attributes.end()) {
+            auto& a=gltf.accessors[ni->second]; auto& v=gltf.bufferViews[a.bufferView];
+            nr=gltf.buffers[v.buffer].data.data()+v.byteOffset+a.byteOffset;
+            ns=v.byteStride?v.byteStride:12;
+        }
+        const uint8_t* ur=nullptr; size_t us=8;
+        auto ui = prim.attributes.find("TEXCOORD_0");
+        if (ui!=prim.attributes.end()) {
+            auto& a=gltf.accessors[ui->second]; auto& v=gltf.bufferViews[a.bufferView];
+            ur=gltf.buffers[v.buffer].data.data()+v.byteOffset+a.byteOffset;
+            us=v.byteStride?v.byteStride:8;
+        }
+
+        // Skin streams, only if the model has a skin we can index in 8 bits
+        const tinygltf::Accessor *ja=nullptr, *wa=nullptr;
+        const uint8_t *jr=nullptr, *wr=nullptr; size_t js=0, ws=0;
+        auto stream=[&](const char* name, const tinygltf::Accessor*& acc,
+                        const uint8_t*& raw, size_t& stride) {
+            auto it = prim.attributes.find(name);
+            if (it == prim.attributes.end()) return;
+            acc=&gltf.accessors[it->second]; auto& v=gltf.bufferViews[acc->bufferView];
+            raw=gltf.buffers[v.buffer].data.data()+v.byteOffset+acc->byteOffset;
+            stride=v.byteStride?v.byteStride:
+                   4*tinygltf::GetComponentSizeInBytes(acc->componentType);
+        };
+        if (out.jointCount) { stream("JOINTS_0",ja,jr,js); stream("WEIGHTS_0",wa,wr,ws); }
+
+        uint32_t base = (uint32_t)verts.size();
+        for (size_t i=0; i<pa.count; i++) {
+            PlayerVertex v{};
+            if (jr && wr) for (int k=0; k<4; k++) {
+                const uint8_t* j=jr+i*js; const uint8_t* w=wr+i*ws;
+                v.joints[k] = ja->componentType==TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE
+                            ? j[k] : (uint8_t)((const uint16_t*)j)[k];
+                float wf = wa->componentType==TINYGLTF_COMPONENT_TYPE_FLOAT ? ((const float*)w)[k]
+                         : wa->componentType==TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE ? w[k]/255.f
+                         : ((const uint16_t*)w)[k]/65535.f;
+                v.weights[k] = (uint8_t)(std::clamp(wf,0.f,1.f)*255.f+0.5f);
+            }
+            auto* pp=(const float*)(pr+i*ps);
+            v.pos={pp[0],pp[1],pp[2]};
+            mn=glm::min(mn,v.pos); mx=glm::max(mx,v.pos);
+            if (nr) { auto* nn=(const float*)(nr+i*ns); v.normal={nn[0],nn[1],nn[2]}; }
+            if (ur) {
+                auto* uu=(const float*)(ur+i*us);
+                float u=uu[0]-std::floor(uu[0]), vv=uu[1]-std::floor(uu[1]);
+                v.uv={uOff+u*uScl, vv};
+            } else { v.uv={uOff+0.5f*uScl, 0.5f}; }
+            verts.push_back(v);
+        }
+        if (prim.indices>=0) {
+            auto& a=gltf.accessors[prim.indices]; auto& bvw=gltf.bufferViews[a.bufferView];
+            const uint8_t* r=gltf.buffers[bvw.buffer].data.data()+bvw.byteOffset+a.byteOffset;
+            for (size_t i=0;i<a.count;i++) {
+                uint32_t idx;
+                switch(a.componentType){
+                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: idx=r[i]; break;
+                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: idx=((const uint16_t*)r)[i]; break;
+                    default: idx=((const uint32_t*)r)[i]; break;
+                }
+                inds.push_back(base+idx);
+            }
+        } else { for(size_t i=0;i<pa.count;i++) inds.push_back(base+(uint32_t)i); }
+    }
+    out.boundsMin = mn; out.boundsMax = mx;
+    return true;
+}
+
+// ── clusterPlayerLod ──────────────────────────────────────────────────────────
+// Vertex-clustering simplification for the distance LODs: vertices that snap
+// to the same `cell`-sized grid cell merge into one (positions averaged, the
+// first vertex's other attributes kept) and triangles that collapse are
+// dropped. Vertices in different atlas tiles never merge, so the materials
+// don't bleed into each other.
+inline void clusterPlayerLod(const PlayerVertex* verts, size_t nVerts,
+                             const uint32_t* inds, size_t nInds, float cell, int uTiles,
+                             std::vector<PlayerVertex>& outV, std::vector<uint32_t>& outI) {
+    outV.clear(); outI.clear();
+    std::unordered_map<uint64_t, uint32_t> cluster;
+    std::vector<uint32_t> remap(nVerts);
+    std::vector<float>    weight;
+    for (size_t i = 0; i < nVerts; i++) {
+        const PlayerVertex& v = verts[i];
+        glm::ivec3 c = glm::ivec3(glm::floor(v.pos / cell)) + 0x8000;
+        uint64_t tile = (uint64_t)std::clamp((int)(v.uv.x * uTiles), 0, 0xFFFF);
+        uint64_t key = (uint64_t)(c.x & 0xFFFF) | (uint64_t)(c.y & 0xFFFF) << 16 |
+                       (uint64_t)(c.z & 0xFFFF) << 32 | tile << 48;
+        auto [it, fresh] = cluster.try_emplace(key, (uint32_t)outV.size());
+        if (fresh) { outV.push_back(v); weight.push_back(1.f); }
+        else {
+            PlayerVertex& m = outV[it->second];
+            float& n = weight[it->second];
+            m.pos = (m.pos * n + v.pos) / (n + 1.f);
+            n += 1.f;
+        }
+        remap[i] = it->second;
+    }
+    for (size_t t = 0; t + 2 < nInds; t += 3) {
+        uint32_t a = remap[inds[t]], b = remap[inds[t+1]], c = remap[inds[t+2]];
+        if (a == b || b == c || a == c) continue;
+        outI.push_back(a); outI.push_back(b); outI.push_back(c);
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <enet/enet.h>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <entt/entt.hpp>
+
+// ── PlayerRegistry ────────────────────────────────────────────────────────────
+// The server's per-player state in one place. A connected peer is an entity
+// from connect to disconnect, and each manager keeps what it knows of them
+// — login, chunk view, inventory, stats — as a component in entt's packed
+// storage. The entity goes in ENetPeer::data, so every handler a packet
+// reaches finds its component with one load and an index rather than a hash
+// lookup per manager, and a pass over all players walks one component's
+// array.
+//
+// The entity's version and the peer stored with it make a stale or foreign
+// data value read as "no player". Adding a component never moves the others
+// of its type; removing one moves the last into its place, unless the type
+// sets in_place_delete (a hole is left, so those are for lookups, not
+// all()). Main thread only.
+struct PlayerPeer {
+    ENetPeer* peer = nullptr;
+};
+
+class PlayerRegistry {
+public:
+    // On connect; a peer already here starts over
+    entt::entity add(ENetPeer* peer) {
+        remove(peer);
+        entt::entity e = _reg.create();
+        _reg.emplace<PlayerPeer>(e, peer);
+        peer->data = (void*)((uintptr_t)entt::to_integral(e) + 1);
+        return e;
+    }
+
+    // Once every manager has seen the disconnect; what they left goes too
+    void remove(ENetPeer* peer) {
+        entt::entity e = find(peer);
+        if (e == entt::null) return;
+        _reg.destroy(e);
+        peer->data = nullptr;
+    }
+
+    entt::entity find(ENetPeer* peer) const {
+        uintptr_t v = (uintptr_t)peer->data;
+        if (v == 0) return entt::null;
+        auto e = (entt::entity)(uint32_t)(v - 1);
+        if (!_reg.valid(e)) return entt::null;
+        const PlayerPeer* p = _reg.try_get<PlayerPeer>(e);
+        return p && p->peer == peer ? e : entt::null;
+    }
+
+    // nullptr if the peer isn't here or has no T
+    template<class T>
+    T* get(ENetPeer* peer) {
+        entt::entity e = find(peer);
+        return e == entt::null ? nullptr : _reg.try_get<T>(e);
+    }
+
+    // Replaces a T it has; nullptr if the peer isn't here
+    template<class T, class... Args>
+    T* emplace(ENetPeer* peer, Args&&... args) {
+        entt::entity e = find(peer);
+        return e == entt::null ? nullptr : &_reg.emplace_or_replace<T>(e, std::forward<Args>(args)...);
+    }
+
+    template<class T>
+    void erase(ENetPeer* peer) {
+        if (entt::entity e = find(peer); e != entt::null) _reg.remove<T>(e);
+    }
+
+    // Every T, packed; no T is added or removed while it's walked
+    template<class T> auto&  all()   { return _reg.storage<T>(); }
+    template<class T> size_t count() { return _reg.storage<T>().size(); }
+    size_t size() { return count<PlayerPeer>(); }
+
+private:
+    entt::registry _reg;
+};
@@ -1,11 +1,17 @@
 #pragma once
 #include <vector>
 #include <cstdint>
+#include <cmath>
 #include "packets.h"
 
 // ── Server-authoritative player stats ─────────────────────────────────────────
 
 struct PlayerStats {
+    // Per second while alive. Both ends apply these, so regen never has to
+    // go over the wire.
+    static constexpr float STAMINA_REGEN = 15.f;
+    static constexpr float MANA_REGEN    = 5.f;
+
     float health    = 100.f;
     float healthMax = 100.f;
     float stamina    = 100.f;
@@ -28,6 +34,15 @@ struct PlayerStats {
         if (health <= 0.f) { health = 0.f; dead = true; }
     }
 
+    // Advance stamina/mana regen by dt seconds
+    void regen(float dt) {
+        if (dead) return;
+        stamina += STAMINA_REGEN * dt;
+        mana    += MANA_REGEN * dt;
+        if (stamina > staminaMax) stamina = staminaMax;
+        if (mana    > manaMax)    mana    = manaMax;
+    }
+
     void reset() {
         health  = healthMax;
         stamina = staminaMax;
@@ -79,33 +94,63 @@ struct StatsSyncPacket {
     }
 };
 
-// Compact delta — just the 4 current values + dead flag (sent at 10Hz)
+// Only the fields that changed since the last delta, each as a 16-bit
+// fraction of its max (the maxes come from StatsSync). The dead flag rides
+// in the flags byte and is always current.
+//   u8 id | u8 flags | u16 per set field bit, in bit order
 struct StatsDeltaPacket {
-    float health, stamina, mana, armour;
-    uint8_t dead;
+    enum Field : uint8_t {
+        Health  = 1 << 0,
+        Stamina = 1 << 1,
+        Mana    = 1 << 2,
+        Armour  = 1 << 3,
+        FIELDS  = 0x0F,
+        Dead    = 1 << 7,
+    };
+
+    uint8_t  flags = 0;
+    uint16_t q[4]{}; // indexed by field bit; only set fields are meaningful
+
+    static constexpr size_t MAX_BYTES = 1 + 1 + 4 * 2;
+
+    static uint16_t quantize(float v, float max) {
+        if (max <= 0.f) return 0;
+        float f = v / max;
+        return (uint16_t)std::lround((f < 0.f ? 0.f : f > 1.f ? 1.f : f) * 65535.f);
+    }
+    static float dequantize(uint16_t q, float max) { return q / 65535.f * max; }
+
+    bool  has(Field f) const { return flags & f; }
+    float value(int i, float max) const { return dequantize(q[i], max); }
+
+    void write(PacketWriter& w) const {
+        w.begin((uint8_t)StatsPacketID::StatsDelta, MAX_BYTES);
+        w.u8(flags);
+        for (int i = 0; i < 4; i++)
+            if (flags & (1 << i)) w.u16(q[i]);
+    }
 
     std::vector<uint8_t> serialize() const {
-        std::vector<uint8_t> b;
-        writeU8(b, (uint8_t)StatsPacketID::StatsDelta);
-        writeF32(b, health);
-        writeF32(b, stamina);
-        writeF32(b, mana);
-        writeF32(b, armour);
-        writeU8(b, dead);
-        return b;
+        PacketWriter w(MAX_BYTES);
+        write(w);
+        return w.toVector();
     }
 
-    static StatsDeltaPacket deserialize(const uint8_t* d, size_t) {
-        StatsDeltaPacket p; size_t o = 1;
-        p.health  = readF32(d, o);
-        p.stamina = readF32(d, o);
-        p.mana    = readF32(d, o);
-        p.armour  = readF32(d, o);
-        p.dead    = readU8(d, o);
-        return p;
+    static bool deserialize(const uint8_t* d, size_t len, StatsDeltaPacket& out) {
+        PacketReader r(d, len);
+        out.flags = r.u8();
+        for (int i = 0; i < 4; i++)
+            if (out.flags & (1 << i)) out.q[i] = r.u16();
+        return r.ok();
     }
 
-    static StatsDeltaPacket from(const PlayerStats& s) {
-        return {s.health, s.stamina, s.mana, s.armour, (uint8_t)(s.dead ? 1 : 0)};
+    static StatsDeltaPacket from(const PlayerStats& s, uint8_t fields) {
+        StatsDeltaPacket p;
+        p.flags = (uint8_t)((fields & FIELDS) | (s.dead ? Dead : 0));
+        p.q[0] = quantize(s.health,  s.healthMax);
+        p.q[1] = quantize(s.stamina, s.staminaMax);
+        p.q[2] = quantize(s.mana,    s.manaMax);
+        p.q[3] = quantize(s.armour,  s.armourMax);
+        return p;
     }
 };
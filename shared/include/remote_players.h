@@ -3,6 +3,8 @@
 #include <vk_mem_alloc.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
 #include <unordered_map>
 #include <string>
 #include <vector>
@@ -10,7 +12,12 @@
 #include <cstdio>
 #include <imgui.h>
 #include "mp_packets.h"
+#include "config.h"
 #include "log.h"
+#include "asset_blob.h"
+#include "bindless.h"
+#include "player_model.h"
+#include "staged_uploads.h"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/euler_angles.hpp>
@@ -18,47 +25,123 @@
 #include <tiny_gltf.h>
 
 struct RemotePlayerState {
+    // Position as of a server time (seconds, on the renderer's unwrapped
+    // server timeline)
+    struct Snapshot {
+        double    t = 0.0;
+        glm::vec3 pos{0.f};
+        float     yaw = 0.f, pitch = 0.f;
+    };
+    static constexpr int SNAPSHOTS = 16; // 0.8 s at 20 Hz, past the longest delay
+
     uint32_t    id = 0;
     std::string username;
-    glm::vec3   pos{0.f};
-    glm::vec3   prevPos{0.f};
+    glm::vec3   pos{0.f};       // newest from the server
     glm::vec3   renderPos{0.f};
-    float       yaw   = 0.f;
+    float       yaw   = 0.f;    // as drawn
     float       pitch = 0.f;
-    float       interpT = 0.f;
+    float       sinceSync = 0.f; // server stops syncing players out of range
     bool        active = false;
+    std::vector<glm::mat4> joints; // skinning matrices for the pose; empty = bind pose
+
+    Snapshot snaps[SNAPSHOTS]; // ring, oldest first from snapHead - snapCount
+    int      snapHead  = 0;
+    int      snapCount = 0;
+
+    const Snapshot& snap(int i) const { // 0 = oldest kept
+        return snaps[(snapHead - snapCount + i + SNAPSHOTS) % SNAPSHOTS];
+    }
+    void push(const Snapshot& s) {
+        // A reordered or repeated batch: the timeline only goes forward
+        if (snapCount && s.t <= snap(snapCount - 1).t) return;
+        snaps[snapHead] = s;
+        snapHead = (snapHead + 1) % SNAPSHOTS;
+        snapCount = std::min(snapCount + 1, SNAPSHOTS);
+    }
 };
 
-struct PlayerVertex {
-    glm::vec3 pos;
-    glm::vec3 normal;
-    glm::vec2 uv;
+// One per drawn player, read by player.vert through gl_InstanceIndex
+struct PlayerInstance {
+    glm::mat4  model;
+    glm::uvec4 info; // x first joint matrix, y joint count (0 = static)
 };
+static_assert(sizeof(PlayerInstance) == 80);
 
 struct PlayerModelGPU {
     VkBuffer      vertBuf   = VK_NULL_HANDLE;
     VmaAllocation vertAlloc = nullptr;
     VkBuffer      idxBuf    = VK_NULL_HANDLE;
     VmaAllocation idxAlloc  = nullptr;
-    uint32_t      indexCount = 0;
+
+    // Distance LODs, packed back to back in vertBuf/idxBuf
+    static constexpr int LOD_COUNT = 3;
+    struct Lod { uint32_t firstIndex = 0, indexCount = 0; int32_t vertexOffset = 0; };
+    Lod lods[LOD_COUNT];
+    int lodCount = 0;
+
+    // Instance and joint-matrix slices in host-visible buffers: one per
+    // frame in flight for the camera pass, then one each for shadows
+    VkBuffer      instBuf    = VK_NULL_HANDLE;
+    VmaAllocation instAlloc  = nullptr;
+    PlayerInstance* instMapped = nullptr;
+    VkBuffer      jointBuf   = VK_NULL_HANDLE;
+    VmaAllocation jointAlloc = nullptr;
+    glm::mat4*    jointMapped = nullptr;
+    uint32_t      jointCount  = 0;
+    uint32_t      frames      = 0;
+
+    // Model-space bounding sphere for the frustum test
+    glm::vec3 sphereCenter{0.f};
+    float     sphereRadius = 0.f;
 
     VkImage       atlasImage     = VK_NULL_HANDLE;
     VkImageView   atlasImageView = VK_NULL_HANDLE;
     VmaAllocation atlasAlloc     = nullptr;
     VkSampler     atlasSampler   = VK_NULL_HANDLE;
 
-    VkDescriptorSetLayout dsLayout = VK_NULL_HANDLE;
-    VkDescriptorPool      dsPool   = VK_NULL_HANDLE;
-    VkDescriptorSet       dsSet    = VK_NULL_HANDLE;
+    // Where the atlas and the two buffers are in the bindless table
+    uint32_t atlasEntry = BindlessTable::NONE;
+    uint32_t instEntry  = BindlessTable::NONE;
+    uint32_t jointEntry = BindlessTable::NONE;
 
     VkPipeline       pipeline       = VK_NULL_HANDLE;
+    VkPipeline       shadowPipeline = VK_NULL_HANDLE; // depth only, same layout
     VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
 
     bool loaded = false;
 };
 
+// The player model as RemotePlayerRenderer::readModel leaves it for
+// addModel: every LOD packed back to back, and the atlas
+struct PlayerModelData {
+    std::vector<PlayerVertex> verts;
+    std::vector<uint32_t>     inds;
+    PlayerModelGPU::Lod       lods[PlayerModelGPU::LOD_COUNT];
+    int                       lodCount = 0;
+    std::vector<uint8_t>      atlas; // RGBA8
+    int                       atlasW = 0, atlasH = 0;
+    glm::vec3                 boundsMin{0.f}, boundsMax{0.f};
+    uint32_t                  jointCount = 0;
+};
+
+// ── RemotePlayerRenderer ──────────────────────────────────────────────────────
+// All visible remote players go out as one instanced draw per LOD: draw()
+// frustum-culls the active players, buckets them by view depth, and writes
+// their transforms into this frame's slice of the instance buffer.
+//
+// Positions are interpolated between timestamped snapshots, drawn `delay`
+// behind the server clock as best estimated here: the lowest transit time
+// seen (creeping up slowly so it can follow a route change) gives the
+// offset, and the delay is the broadcast interval plus twice the mean
+// jitter above that lowest transit. A late packet then costs nothing, and a
+// lost one is bridged; past the newest snapshot, motion is extrapolated for
+// at most Config::REMOTE_EXTRAP_S and then held.
 class RemotePlayerRenderer {
 public:
+    static constexpr uint32_t MAX_INSTANCES = 256; // per frame and pass; the rest aren't drawn
+    // View depth at which LOD 1 and LOD 2 take over
+    static constexpr float LOD_DEPTH[PlayerModelGPU::LOD_COUNT - 1] = {24.f, 64.f};
+
     std::unordered_map<uint32_t, RemotePlayerState> players;
     PlayerModelGPU model;
     uint32_t localPlayerId = 0;
@@ -71,188 +154,321 @@ public:
         p.id        = pkt.playerId;
         p.username  = pkt.username;
         p.pos       = {pkt.x, pkt.y, pkt.z};
-        p.prevPos   = p.pos;
         p.renderPos = p.pos;
         p.yaw       = pkt.yaw;
+        p.snapCount = 0;
         p.active    = true;
     }
 
     void onDespawn(uint32_t playerId) { players.erase(playerId); }
 
     void onPosSync(const PlayerPosSyncPacket& pkt) {
+        double t = serverTime(pkt);
         for (const auto& entry : pkt.players) {
             if (entry.playerId == localPlayerId) continue;
             auto it = players.find(entry.playerId);
             if (it == players.end()) continue;
             auto& p    = it->second;
-            p.prevPos  = p.renderPos;
+            if (!p.active) p.snapCount = 0; // back in range: no path from where it left
             p.pos      = {entry.x, entry.y, entry.z};
-            p.yaw      = entry.yaw;
-            p.pitch    = entry.pitch;
-            p.interpT  = 0.f;
+            p.push({t, p.pos, entry.yaw, entry.pitch});
+            p.sinceSync = 0.f;
+            p.active   = true;
         }
     }
 
     void update(float dt) {
+        _clock += dt;
+        // Eased, so a change in conditions doesn't jerk everyone at once
+        float target = std::clamp(_interval + 2.f * _jitter, Config::REMOTE_DELAY_MIN_S, Config::REMOTE_DELAY_MAX_S);
+        _delay += (target - _delay) * std::min(dt * 2.f, 1.f);
+        _offset += dt * 0.001; // the lowest transit may have gone up since
+
+        double at = _clock - _offset - _delay; // on the server timeline
         for (auto& [id, p] : players) {
-            p.interpT = std::min(p.interpT + dt * 10.f, 1.f);
-            p.renderPos = glm::mix(p.prevPos, p.pos, p.interpT);
+            p.sinceSync += dt;
+            if (p.sinceSync > Config::REMOTE_STALE_S) p.active = false; // out of range — snap back in later
+            sample(p, at);
         }
     }
 
-    bool loadModel(VkDevice device, VmaAllocator allocator,
-                   VkCommandPool pool, VkQueue queue,
-                   VkRenderPass renderPass, VkExtent2D extent,
-                   const char* glbPath,
-                   const char* vertSpvPath, const char* fragSpvPath) {
-
-        tinygltf::Model gltf;
-        tinygltf::TinyGLTF loader;
-        std::string err, warn;
-        if (!loader.LoadBinaryFromFile(&gltf, &err, &warn, glbPath)) {
-            Log::err("Player GLB failed: " + err); return false;
-        }
+    float interpDelay() const { return _delay; } // seconds behind the server
 
-        // ── Per-material diffuse textures ─────────────────────────────────
-        struct MatTex { std::vector<uint8_t> rgba; int w=0, h=0; glm::vec4 col{1}; };
-        std::vector<MatTex> mats(gltf.materials.size());
-        for (int mi = 0; mi < (int)gltf.materials.size(); mi++) {
-            auto& mat = gltf.materials[mi]; auto& mt = mats[mi];
-            if (mat.pbrMetallicRoughness.baseColorFactor.size()==4) {
-                auto& f = mat.pbrMetallicRoughness.baseColorFactor;
-                mt.col = {(float)f[0],(float)f[1],(float)f[2],(float)f[3]};
-            }
-            if (mat.pbrMetallicRoughness.baseColorTexture.index >= 0) {
-                int src = gltf.textures[mat.pbrMetallicRoughness.baseColorTexture.index].source;
-                if (src >= 0 && src < (int)gltf.images.size()) {
-                    auto& img = gltf.images[src];
-                    if (!img.image.empty()) {
-                        mt.w = img.width; mt.h = img.height;
-                        if (img.component == 4) { mt.rgba = img.image; }
-                        else if (img.component == 3) {
-                            mt.rgba.resize(img.width*img.height*4);
-                            for (int p=0;p<img.width*img.height;p++) {
-                                mt.rgba[p*4]=img.image[p*3]; mt.rgba[p*4+1]=img.image[p*3+1];
-                                mt.rgba[p*4+2]=img.image[p*3+2]; mt.rgba[p*4+3]=255;
-                            }
-                        }
-                    }
-                }
-            }
-            if (mt.rgba.empty()) {
-                mt.w=1; mt.h=1; mt.rgba.resize(4);
-                mt.rgba[0]=(uint8_t)(mt.col.r*255); mt.rgba[1]=(uint8_t)(mt.col.g*255);
-                mt.rgba[2]=(uint8_t)(mt.col.b*255); mt.rgba[3]=(uint8_t)(mt.col.a*255);
-            }
+    // The bindless table both pipelines take as set 0 and addModel adds
+    // to; set it first so the two can run on different threads
+    void useTable(BindlessTable* table) { _table = table; }
+
+    // Touches only the pipeline handles, so it may run on a worker while
+    // addModel runs on the main thread. fs nullptr builds the depth-only
+    // shadow caster instead, for a depth-only pass like rp; that needs the
+    // layout the camera pipeline's call made. The camera pipeline takes its
+    // viewport and scissor from the pass (dynamic), ext is for the shadow's.
+    void createPipeline(VkDevice dev, VkRenderPass rp, VkExtent2D ext,
+                        const char* vs, const char* fs,
+                        VkPipelineCache cache = VK_NULL_HANDLE) {
+        auto loadSpv=[](const char* p)->std::vector<uint32_t>{
+            FILE* f=fopen(p,"rb"); if(!f) return {};
+            fseek(f,0,SEEK_END); size_t sz=ftell(f); fseek(f,0,SEEK_SET);
+            std::vector<uint32_t> b(sz/4); fread(b.data(),1,sz,f); fclose(f); return b; };
+        auto makeMod=[&](const std::vector<uint32_t>& c)->VkShaderModule{
+            VkShaderModuleCreateInfo ci{}; ci.sType=VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+            ci.codeSize=c.size()*4; ci.pCode=c.data(); VkShaderModule m;
+            vkCreateShaderModule(dev,&ci,nullptr,&m); return m; };
+
+        const bool shadow = fs == nullptr;
+        auto vc=loadSpv(vs), fc=shadow ? std::vector<uint32_t>{} : loadSpv(fs);
+        VkShaderModule vm=makeMod(vc), fm=shadow ? VK_NULL_HANDLE : makeMod(fc);
+
+        if (!model.pipelineLayout) {
+            VkPushConstantRange pcr{}; pcr.stageFlags=VK_SHADER_STAGE_VERTEX_BIT|VK_SHADER_STAGE_FRAGMENT_BIT;
+            pcr.size=sizeof(PushConstants);
+            VkDescriptorSetLayout set=_table->layout();
+            VkPipelineLayoutCreateInfo li{}; li.sType=VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            li.setLayoutCount=1; li.pSetLayouts=&set;
+            li.pushConstantRangeCount=1; li.pPushConstantRanges=&pcr;
+            vkCreatePipelineLayout(dev,&li,nullptr,&model.pipelineLayout);
         }
 
-        // ── Bake atlas: tiles in a row ────────────────────────────────────
-        int numMats = (int)mats.size();
-        int tile = 512, atlasW = tile*numMats, atlasH = tile;
-        std::vector<uint8_t> atlas(atlasW*atlasH*4, 0);
-        for (int mi=0; mi<numMats; mi++) {
-            auto& mt = mats[mi]; int ox = mi*tile;
-            for (int y=0; y<tile; y++) for (int x=0; x<tile; x++) {
-                int sx = mt.w>1 ? x%mt.w : 0, sy = mt.h>1 ? y%mt.h : 0;
-                int si = (sy*mt.w+sx)*4, di = (y*atlasW+ox+x)*4;
-                memcpy(&atlas[di], &mt.rgba[si], 4);
-            }
+        VkPipelineShaderStageCreateInfo st[2]{};
+        st[0].sType=VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        st[0].stage=VK_SHADER_STAGE_VERTEX_BIT; st[0].module=vm; st[0].pName="main";
+        st[1].sType=VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        st[1].stage=VK_SHADER_STAGE_FRAGMENT_BIT; st[1].module=fm; st[1].pName="main";
+
+        VkVertexInputBindingDescription bd{}; bd.stride=sizeof(PlayerVertex);
+        VkVertexInputAttributeDescription at[5]{};
+        at[0]={0,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(PlayerVertex,pos)};
+        at[1]={1,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(PlayerVertex,normal)};
+        at[2]={2,0,VK_FORMAT_R32G32_SFLOAT,   offsetof(PlayerVertex,uv)};
+        at[3]={3,0,VK_FORMAT_R8G8B8A8_UINT,   offsetof(PlayerVertex,joints)};
+        at[4]={4,0,VK_FORMAT_R8G8B8A8_UNORM,  offsetof(PlayerVertex,weights)};
+        VkPipelineVertexInputStateCreateInfo vi{}; vi.sType=VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vi.vertexBindingDescriptionCount=1; vi.pVertexBindingDescriptions=&bd;
+        vi.vertexAttributeDescriptionCount=5; vi.pVertexAttributeDescriptions=at;
+
+        VkPipelineInputAssemblyStateCreateInfo ia{}; ia.sType=VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        ia.topology=VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        VkViewport vp{0,0,(float)ext.width,(float)ext.height,0,1};
+        VkRect2D sc{{0,0},ext};
+        VkPipelineViewportStateCreateInfo vps{}; vps.sType=VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        vps.viewportCount=1; vps.pViewports=&vp; vps.scissorCount=1; vps.pScissors=&sc;
+        VkPipelineRasterizationStateCreateInfo rs{}; rs.sType=VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rs.polygonMode=VK_POLYGON_MODE_FILL; rs.cullMode=VK_CULL_MODE_BACK_BIT;
+        rs.frontFace=VK_FRONT_FACE_COUNTER_CLOCKWISE; rs.lineWidth=1.f;
+        if (shadow) { // both sides, pushed back off the surfaces they shade
+            rs.cullMode=VK_CULL_MODE_NONE; rs.depthBiasEnable=VK_TRUE;
+            rs.depthBiasConstantFactor=1.25f; rs.depthBiasSlopeFactor=1.75f;
         }
+        VkPipelineMultisampleStateCreateInfo ms{}; ms.sType=VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        ms.rasterizationSamples=VK_SAMPLE_COUNT_1_BIT;
+        VkPipelineDepthStencilStateCreateInfo ds{}; ds.sType=VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        ds.depthTestEnable=VK_TRUE; ds.depthWriteEnable=VK_TRUE; ds.depthCompareOp=VK_COMPARE_OP_LESS;
+        VkPipelineColorBlendAttachmentState ba{}; ba.colorWriteMask=0xF;
+        VkPipelineColorBlendStateCreateInfo bl{}; bl.sType=VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        bl.attachmentCount=shadow ? 0 : 1; bl.pAttachments=&ba;
 
-        // ── Extract verts, remap UVs ──────────────────────────────────────
-        std::vector<PlayerVertex> verts; std::vector<uint32_t> inds;
-        float yMin=1e9f, yMax=-1e9f;
-        for (auto& mesh : gltf.meshes) for (auto& prim : mesh.primitives) {
-            if (prim.mode != TINYGLTF_MODE_TRIANGLES) continue;
-            int mi = prim.material >= 0 ? prim.material : 0;
-            float uOff = (float)mi/(float)numMats, uScl = 1.f/(float)numMats;
-
-            auto posIt = prim.attributes.find("POSITION");
-            if (posIt == prim.attributes.end()) continue;
-            auto& pa = gltf.accessors[posIt->second];
-            auto& pv = gltf.bufferViews[pa.bufferView];
-            const uint8_t* pr = gltf.buffers[pv.buffer].data.data()+pv.byteOffset+pa.byteOffset;
-            size_t ps = pv.byteStride ? pv.byteStride : 12;
-
-            const uint8_t* nr=nullptr; size_t ns=12;
-            auto ni = prim.attributes.find("NORMAL");
-            if (ni!=prim.attributes.end()) {
-                auto& a=gltf.accessors[ni->second]; auto& v=gltf.bufferViews[a.bufferView];
-                nr=gltf.buffers[v.buffer].data.data()+v.byteOffset+a.byteOffset;
-                ns=v.byteStride?v.byteStride:12;
-            }
-            const uint8_t* ur=nullptr; size_t us=8;
-            auto ui = prim.attributes.find("TEXCOORD_0");
-            if (ui!=prim.attributes.end()) {
-                auto& a=gltf.accessors[ui->second]; auto& v=gltf.bufferViews[a.bufferView];
-                ur=gltf.buffers[v.buffer].data.data()+v.byteOffset+a.byteOffset;
-                us=v.byteStride?v.byteStride:8;
-            }
+        VkGraphicsPipelineCreateInfo pi{}; pi.sType=VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pi.stageCount=shadow ? 1 : 2; pi.pStages=st; pi.pVertexInputState=&vi; pi.pInputAssemblyState=&ia;
+        pi.pViewportState=&vps; pi.pRasterizationState=&rs; pi.pMultisampleState=&ms;
+        pi.pDepthStencilState=&ds; pi.pColorBlendState=&bl;
+        VkDynamicState dyn[]={VK_DYNAMIC_STATE_VIEWPORT,VK_DYNAMIC_STATE_SCISSOR};
+        VkPipelineDynamicStateCreateInfo dsi{}; dsi.sType=VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dsi.dynamicStateCount=2; dsi.pDynamicStates=dyn;
+        if (!shadow) pi.pDynamicState=&dsi;
+        pi.layout=model.pipelineLayout; pi.renderPass=rp;
+        vkCreateGraphicsPipelines(dev,cache,1,&pi,nullptr,shadow ? &model.shadowPipeline : &model.pipeline);
+        vkDestroyShaderModule(dev,vm,nullptr); if (fm) vkDestroyShaderModule(dev,fm,nullptr);
+    }
 
-            uint32_t base = (uint32_t)verts.size();
-            for (size_t i=0; i<pa.count; i++) {
-                PlayerVertex v{};
-                auto* pp=(const float*)(pr+i*ps);
-                v.pos={pp[0],pp[1],pp[2]};
-                if (v.pos.y<yMin) yMin=v.pos.y; if (v.pos.y>yMax) yMax=v.pos.y;
-                if (nr) { auto* nn=(const float*)(nr+i*ns); v.normal={nn[0],nn[1],nn[2]}; }
-                if (ur) {
-                    auto* uu=(const float*)(ur+i*us);
-                    float u=uu[0]-std::floor(uu[0]), vv=uu[1]-std::floor(uu[1]);
-                    v.uv={uOff+u*uScl, vv};
-                } else { v.uv={uOff+0.5f*uScl, 0.5f}; }
-                verts.push_back(v);
-            }
-            if (prim.indices>=0) {
-                auto& a=gltf.accessors[prim.indices]; auto& bvw=gltf.bufferViews[a.bufferView];
-                const uint8_t* r=gltf.buffers[bvw.buffer].data.data()+bvw.byteOffset+a.byteOffset;
-                for (size_t i=0;i<a.count;i++) {
-                    uint32_t idx;
-                    switch(a.componentType){
-                        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: idx=r[i]; break;
-                        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: idx=((const uint16_t*)r)[i]; break;
-                        default: idx=((const uint32_t*)r)[i]; break;
-                    }
-                    inds.push_back(base+idx);
-                }
-            } else { for(size_t i=0;i<pa.count;i++) inds.push_back(base+(uint32_t)i); }
+    // Any thread: the CPU half of loading — read, cluster into LODs and pack.
+    // Prefers the asset_bake blob next to the GLB.
+    static bool readModel(const char* glbPath, PlayerModelData& out) {
+        const PlayerVertex* verts; size_t nVerts;
+        const uint32_t* inds; size_t nInds;
+        PlayerMesh mesh;
+        AssetBlob::Mapped blob;
+        if (blob.open(AssetBlob::pathFor(glbPath).c_str(), glbPath, sizeof(PlayerVertex)) &&
+            blob.header().textureOffset) {
+            auto& h = blob.header();
+            verts = blob.vertices<PlayerVertex>(); nVerts = h.vertexCount;
+            inds  = blob.indices(); nInds = h.indexCount;
+            out.atlas.assign(blob.texture(), blob.texture() + (size_t)h.textureW * h.textureH * 4);
+            out.atlasW = (int)h.textureW; out.atlasH = (int)h.textureH;
+            out.boundsMin = blob.boundsMin(); out.boundsMax = blob.boundsMax();
+            out.jointCount = h.jointCount;
+        } else {
+            if (!buildPlayerMesh(glbPath, mesh)) return false;
+            verts = mesh.verts.data(); nVerts = mesh.verts.size();
+            inds  = mesh.inds.data(); nInds = mesh.inds.size();
+            out.atlas = std::move(mesh.atlas);
+            out.atlasW = mesh.atlasW; out.atlasH = mesh.atlasH;
+            out.boundsMin = mesh.boundsMin; out.boundsMax = mesh.boundsMax;
+            out.jointCount = mesh.jointCount;
         }
-        modelHeight = yMax - yMin;
-        Log::info("Player model: "+std::to_string(verts.size())+" verts, h="+std::to_string(modelHeight));
-
-        model.indexCount = (uint32_t)inds.size();
-        uploadBuf(device,allocator,pool,queue,verts.data(),verts.size()*sizeof(PlayerVertex),
-                  VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,model.vertBuf,model.vertAlloc);
-        uploadBuf(device,allocator,pool,queue,inds.data(),inds.size()*sizeof(uint32_t),
-                  VK_BUFFER_USAGE_INDEX_BUFFER_BIT,model.idxBuf,model.idxAlloc);
-        uploadTex(device,allocator,pool,queue,atlas.data(),atlasW,atlasH);
-        createDS(device);
-        createPipeline(device,renderPass,extent,vertSpvPath,fragSpvPath);
-        model.loaded = true;
+        const float height = out.boundsMax.y - out.boundsMin.y;
+        Log::info("Player model: "+std::to_string(nVerts)+" verts, h="+std::to_string(height));
+
+        // LOD 0 is the mesh itself; coarser ones are clustered on grids of
+        // 1/48 and 1/16 of the model's height
+        out.verts.assign(verts, verts + nVerts);
+        out.inds.assign(inds, inds + nInds);
+        out.lods[0] = {0, (uint32_t)nInds, 0};
+        out.lodCount = 1;
+        const float cells[] = {height / 48.f, height / 16.f};
+        int uTiles = out.atlasH > 0 ? std::max(1, out.atlasW / out.atlasH) : 1;
+        std::vector<PlayerVertex> lv; std::vector<uint32_t> li;
+        for (float cell : cells) {
+            if (!(cell > 0.f)) break;
+            clusterPlayerLod(verts, nVerts, inds, nInds, cell, uTiles, lv, li);
+            if (li.empty()) break;
+            out.lods[out.lodCount++] = {(uint32_t)out.inds.size(), (uint32_t)li.size(),
+                                        (int32_t)out.verts.size()};
+            out.verts.insert(out.verts.end(), lv.begin(), lv.end());
+            out.inds.insert(out.inds.end(), li.begin(), li.end());
+        }
+        for (int l=1; l<out.lodCount; l++)
+            Log::info("Player LOD "+std::to_string(l)+": "+std::to_string(out.lods[l].indexCount/3)+" tris");
         return true;
     }
 
-    void draw(VkCommandBuffer cmd, const glm::mat4& viewProj) const {
-        if (!model.loaded || players.empty()) return;
-        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, model.pipeline);
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                model.pipelineLayout, 0, 1, &model.dsSet, 0, nullptr);
-        VkDeviceSize zero=0;
-        vkCmdBindVertexBuffers(cmd, 0, 1, &model.vertBuf, &zero);
-        vkCmdBindIndexBuffer(cmd, model.idxBuf, 0, VK_INDEX_TYPE_UINT32);
+    // Main thread, after useTable. The buffers and the atlas go into up, so
+    // nothing may be drawn until its submission has finished; the pipeline
+    // comes from createPipeline.
+    bool addModel(VkDevice device, VmaAllocator allocator, StagedUploads& up,
+                  const PlayerModelData& d, uint32_t framesInFlight) {
+        if (d.inds.empty() || d.atlas.empty()) return false;
+        modelHeight = d.boundsMax.y - d.boundsMin.y;
+        model.sphereCenter = (d.boundsMin + d.boundsMax) * 0.5f;
+        model.sphereRadius = glm::length(d.boundsMax - d.boundsMin) * 0.5f;
+        std::copy(d.lods, d.lods + PlayerModelGPU::LOD_COUNT, model.lods);
+        model.lodCount = d.lodCount;
+
+        if (!up.buffer(d.verts.data(), d.verts.size() * sizeof(PlayerVertex),
+                       VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, model.vertBuf, model.vertAlloc) ||
+            !up.buffer(d.inds.data(), d.inds.size() * sizeof(uint32_t),
+                       VK_BUFFER_USAGE_INDEX_BUFFER_BIT, model.idxBuf, model.idxAlloc) ||
+            !up.image(d.atlas.data(), d.atlas.size(), (uint32_t)d.atlasW, (uint32_t)d.atlasH,
+                      VK_FORMAT_R8G8B8A8_SRGB, model.atlasImage, model.atlasAlloc))
+            return false;
+
+        VkImageViewCreateInfo vc{}; vc.sType=VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        vc.image=model.atlasImage; vc.viewType=VK_IMAGE_VIEW_TYPE_2D;
+        vc.format=VK_FORMAT_R8G8B8A8_SRGB; vc.subresourceRange={VK_IMAGE_ASPECT_COLOR_BIT,0,1,0,1};
+        vkCreateImageView(device,&vc,nullptr,&model.atlasImageView);
+
+        VkSamplerCreateInfo sc{}; sc.sType=VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        sc.magFilter=VK_FILTER_LINEAR; sc.minFilter=VK_FILTER_LINEAR;
+        sc.addressModeU=VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sc.addressModeV=VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        vkCreateSampler(device,&sc,nullptr,&model.atlasSampler);
+
+        // A static model still binds a one-matrix joint buffer
+        const uint32_t jointCount = d.jointCount;
+        model.frames     = framesInFlight;
+        model.jointCount = jointCount;
+        size_t jointSlots = (size_t)2 * framesInFlight * MAX_INSTANCES * std::max(jointCount, 1u);
+        model.instMapped  = static_cast<PlayerInstance*>(hostBuf(allocator,
+            (VkDeviceSize)2 * framesInFlight * MAX_INSTANCES * sizeof(PlayerInstance),
+            model.instBuf, model.instAlloc));
+        model.jointMapped = static_cast<glm::mat4*>(hostBuf(allocator,
+            jointCount ? jointSlots * sizeof(glm::mat4) : sizeof(glm::mat4),
+            model.jointBuf, model.jointAlloc));
+        model.atlasEntry = _table->addTexture(model.atlasImageView, model.atlasSampler);
+        model.instEntry  = _table->addBuffer(model.instBuf);
+        model.jointEntry = _table->addBuffer(model.jointBuf);
+        model.loaded = model.atlasEntry != BindlessTable::NONE && model.instEntry != BindlessTable::NONE &&
+                       model.jointEntry != BindlessTable::NONE;
+        return model.loaded;
+    }
+
+    // Culls, picks LODs and fills frame's instance slice, so call it once
+    // per frame after that frame's fence has been waited on, inside a pass
+    // that has set the viewport
+    void draw(VkCommandBuffer cmd, const glm::mat4& viewProj, uint32_t frame) {
+        if (!model.loaded || players.empty() || frame >= model.frames) return;
+
+        // Normalised frustum planes, as in the chunk cull
+        glm::vec4 planes[6];
+        auto row = [&](int i) { return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]); };
+        for (int i = 0; i < 3; i++) {
+            planes[i*2]   = row(3) + row(i);
+            planes[i*2+1] = row(3) - row(i);
+        }
+        for (auto& pl : planes) pl /= glm::length(glm::vec3(pl));
+
+        for (auto& b : _bucket) b.clear();
+        float radius = model.sphereRadius * modelScale;
         for (const auto& [id,p] : players) {
             if (!p.active) continue;
             glm::mat4 m(1.f);
             m = glm::translate(m, p.renderPos);
             m = glm::rotate(m, glm::radians(-p.yaw+90.f), {0,1,0});
             m = glm::scale(m, glm::vec3(modelScale));
-            glm::mat4 mvp = viewProj * m;
-            vkCmdPushConstants(cmd, model.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT,
-                               0, sizeof(glm::mat4), &mvp);
-            vkCmdDrawIndexed(cmd, model.indexCount, 1, 0, 0, 0);
+            glm::vec3 c = glm::vec3(m * glm::vec4(model.sphereCenter, 1.f));
+            bool inside = true;
+            for (auto& pl : planes)
+                if (glm::dot(glm::vec3(pl), c) + pl.w < -radius) { inside = false; break; }
+            if (!inside) continue;
+
+            float depth = (viewProj * glm::vec4(c, 1.f)).w;
+            int lod = 0;
+            while (lod < model.lodCount - 1 && depth > LOD_DEPTH[lod]) lod++;
+            _bucket[lod].push_back({m, &p});
+        }
+
+        // Write the instances LOD by LOD so each bucket is one contiguous range
+        uint32_t base = frame * MAX_INSTANCES, n = 0;
+        uint32_t first[PlayerModelGPU::LOD_COUNT] = {}, count[PlayerModelGPU::LOD_COUNT] = {};
+        for (int l = 0; l < model.lodCount; l++) {
+            first[l] = n;
+            for (const auto& v : _bucket[l]) {
+                if (n == MAX_INSTANCES) break;
+                writeInstance(base + n++, v);
+            }
+            count[l] = n - first[l];
+        }
+        if (n == 0) return;
+        flushInstances(base, n);
+
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, model.pipeline);
+        bind(cmd, viewProj, frame);
+        for (int l = 0; l < model.lodCount; l++) {
+            if (!count[l]) continue;
+            const auto& lod = model.lods[l];
+            vkCmdDrawIndexed(cmd, lod.indexCount, count[l], lod.firstIndex,
+                             lod.vertexOffset, base + first[l]);
         }
     }
 
+    // Shadow casters: every active player at the coarsest LOD, into this
+    // frame's shadow slice, unculled — each cascade looks from elsewhere.
+    // Once per frame, after its fence; returns the count for drawShadow.
+    uint32_t writeShadowInstances(uint32_t frame) {
+        if (!model.loaded || !model.shadowPipeline || frame >= model.frames) return 0;
+        uint32_t base = (model.frames + frame) * MAX_INSTANCES, n = 0;
+        for (const auto& [id,p] : players) {
+            if (!p.active || n == MAX_INSTANCES) continue;
+            glm::mat4 m(1.f);
+            m = glm::translate(m, p.renderPos);
+            m = glm::rotate(m, glm::radians(-p.yaw+90.f), {0,1,0});
+            m = glm::scale(m, glm::vec3(modelScale));
+            writeInstance(base + n++, {m, &p});
+        }
+        if (n) flushInstances(base, n);
+        return n;
+    }
+
+    // Inside a depth-only pass compatible with the shadow pipeline's
+    void drawShadow(VkCommandBuffer cmd, const glm::mat4& lightViewProj, uint32_t frame,
+                    uint32_t count) const {
+        if (count == 0) return;
+        const auto& lod = model.lods[model.lodCount - 1];
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, model.shadowPipeline);
+        bind(cmd, lightViewProj, frame);
+        vkCmdDrawIndexed(cmd, lod.indexCount, count, lod.firstIndex, lod.vertexOffset,
+                         (model.frames + frame) * MAX_INSTANCES);
+    }
+
     void drawNametags(const glm::mat4& viewProj, int sw, int sh) const {
         ImDrawList* dl = ImGui::GetForegroundDrawList();
         float tagY = modelHeight * modelScale + 0.3f;
@@ -273,177 +489,144 @@ public:
 
     void destroy(VkDevice device, VmaAllocator allocator) {
         if (model.pipeline)       vkDestroyPipeline(device, model.pipeline, nullptr);
+        if (model.shadowPipeline) vkDestroyPipeline(device, model.shadowPipeline, nullptr);
         if (model.pipelineLayout) vkDestroyPipelineLayout(device, model.pipelineLayout, nullptr);
-        if (model.dsPool)         vkDestroyDescriptorPool(device, model.dsPool, nullptr);
-        if (model.dsLayout)       vkDestroyDescriptorSetLayout(device, model.dsLayout, nullptr);
+        if (_table) {
+            _table->releaseTexture(model.atlasEntry);
+            _table->releaseBuffer(model.instEntry);
+            _table->releaseBuffer(model.jointEntry);
+        }
         if (model.atlasSampler)   vkDestroySampler(device, model.atlasSampler, nullptr);
         if (model.atlasImageView) vkDestroyImageView(device, model.atlasImageView, nullptr);
         if (model.atlasImage)     vmaDestroyImage(allocator, model.atlasImage, model.atlasAlloc);
         if (model.vertBuf)        vmaDestroyBuffer(allocator, model.vertBuf, model.vertAlloc);
         if (model.idxBuf)         vmaDestroyBuffer(allocator, model.idxBuf, model.idxAlloc);
+        if (model.instBuf)        vmaDestroyBuffer(allocator, model.instBuf, model.instAlloc);
+        if (model.jointBuf)       vmaDestroyBuffer(allocator, model.jointBuf, model.jointAlloc);
         model = {};
     }
 
 private:
-    static void uploadBuf(VkDevice dev, VmaAllocator alloc, VkCommandPool pool, VkQueue q,
-                          const void* data, VkDeviceSize size, VkBufferUsageFlags usage,
-                          VkBuffer& buf, VmaAllocation& al) {
-        VkBuffer stg; VmaAllocation sa;
-        { VkBufferCreateInfo b{}; b.sType=VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-          b.size=size; b.usage=VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-          VmaAllocationCreateInfo a{}; a.usage=VMA_MEMORY_USAGE_CPU_ONLY;
-          a.flags=VMA_ALLOCATION_CREATE_MAPPED_BIT; VmaAllocationInfo i{};
-          vmaCreateBuffer(alloc,&b,&a,&stg,&sa,&i); memcpy(i.pMappedData,data,size); }
-        { VkBufferCreateInfo b{}; b.sType=VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-          b.size=size; b.usage=usage|VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-          VmaAllocationCreateInfo a{}; a.usage=VMA_MEMORY_USAGE_GPU_ONLY;
-          vmaCreateBuffer(alloc,&b,&a,&buf,&al,nullptr); }
-        auto cmd=beginOT(dev,pool); VkBufferCopy r{0,0,size};
-        vkCmdCopyBuffer(cmd,stg,buf,1,&r); endOT(dev,pool,q,cmd);
-        vmaDestroyBuffer(alloc,stg,sa);
-    }
-
-    void uploadTex(VkDevice dev, VmaAllocator alloc, VkCommandPool pool, VkQueue q,
-                   const uint8_t* px, int w, int h) {
-        VkDeviceSize sz=w*h*4; VkBuffer stg; VmaAllocation sa;
-        { VkBufferCreateInfo b{}; b.sType=VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-          b.size=sz; b.usage=VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-          VmaAllocationCreateInfo a{}; a.usage=VMA_MEMORY_USAGE_CPU_ONLY;
-          a.flags=VMA_ALLOCATION_CREATE_MAPPED_BIT; VmaAllocationInfo i{};
-          vmaCreateBuffer(alloc,&b,&a,&stg,&sa,&i); memcpy(i.pMappedData,px,sz); }
-
-        VkImageCreateInfo ic{}; ic.sType=VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-        ic.imageType=VK_IMAGE_TYPE_2D; ic.format=VK_FORMAT_R8G8B8A8_SRGB;
-        ic.extent={(uint32_t)w,(uint32_t)h,1}; ic.mipLevels=1; ic.arrayLayers=1;
-        ic.samples=VK_SAMPLE_COUNT_1_BIT; ic.tiling=VK_IMAGE_TILING_OPTIMAL;
-        ic.usage=VK_IMAGE_USAGE_TRANSFER_DST_BIT|VK_IMAGE_USAGE_SAMPLED_BIT;
-        VmaAllocationCreateInfo ac{}; ac.usage=VMA_MEMORY_USAGE_GPU_ONLY;
-        vmaCreateImage(alloc,&ic,&ac,&model.atlasImage,&model.atlasAlloc,nullptr);
-
-        auto cmd=beginOT(dev,pool);
-        VkImageMemoryBarrier br{}; br.sType=VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        br.image=model.atlasImage; br.subresourceRange={VK_IMAGE_ASPECT_COLOR_BIT,0,1,0,1};
-        br.oldLayout=VK_IMAGE_LAYOUT_UNDEFINED; br.newLayout=VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        br.dstAccessMask=VK_ACCESS_TRANSFER_WRITE_BIT;
-        vkCmdPipelineBarrier(cmd,VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,VK_PIPELINE_STAGE_TRANSFER_BIT,
-                             0,0,nullptr,0,nullptr,1,&br);
-        VkBufferImageCopy rg{}; rg.imageSubresource={VK_IMAGE_ASPECT_COLOR_BIT,0,0,1};
-        rg.imageExtent={(uint32_t)w,(uint32_t)h,1};
-        vkCmdCopyBufferToImage(cmd,stg,model.atlasImage,VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,1,&rg);
-        br.oldLayout=VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        br.newLayout=VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        br.srcAccessMask=VK_ACCESS_TRANSFER_WRITE_BIT; br.dstAccessMask=VK_ACCESS_SHADER_READ_BIT;
-        vkCmdPipelineBarrier(cmd,VK_PIPELINE_STAGE_TRANSFER_BIT,VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                             0,0,nullptr,0,nullptr,1,&br);
-        endOT(dev,pool,q,cmd); vmaDestroyBuffer(alloc,stg,sa);
+    struct Visible { glm::mat4 model; const RemotePlayerState* player; };
+    // player.vert's and player.frag's
+    struct PushConstants { glm::mat4 viewProj; glm::uvec4 table; };
 
-        VkImageViewCreateInfo vc{}; vc.sType=VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        vc.image=model.atlasImage; vc.viewType=VK_IMAGE_VIEW_TYPE_2D;
-        vc.format=VK_FORMAT_R8G8B8A8_SRGB; vc.subresourceRange={VK_IMAGE_ASPECT_COLOR_BIT,0,1,0,1};
-        vkCreateImageView(dev,&vc,nullptr,&model.atlasImageView);
-
-        VkSamplerCreateInfo sc{}; sc.sType=VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-        sc.magFilter=VK_FILTER_LINEAR; sc.minFilter=VK_FILTER_LINEAR;
-        sc.addressModeU=VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-        sc.addressModeV=VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-        vkCreateSampler(dev,&sc,nullptr,&model.atlasSampler);
+    // The table, the model's buffers and its entries in the table
+    void bind(VkCommandBuffer cmd, const glm::mat4& viewProj, uint32_t frame) const {
+        VkDescriptorSet set = _table->set(frame);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                model.pipelineLayout, 0, 1, &set, 0, nullptr);
+        VkDeviceSize zero=0;
+        vkCmdBindVertexBuffers(cmd, 0, 1, &model.vertBuf, &zero);
+        vkCmdBindIndexBuffer(cmd, model.idxBuf, 0, VK_INDEX_TYPE_UINT32);
+        PushConstants pc{viewProj, {model.instEntry, model.jointEntry, model.atlasEntry, 0u}};
+        vkCmdPushConstants(cmd, model.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT|VK_SHADER_STAGE_FRAGMENT_BIT,
+                           0, sizeof pc, &pc);
     }
 
-    void createDS(VkDevice dev) {
-        VkDescriptorSetLayoutBinding b{}; b.binding=0;
-        b.descriptorType=VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        b.descriptorCount=1; b.stageFlags=VK_SHADER_STAGE_FRAGMENT_BIT;
-        VkDescriptorSetLayoutCreateInfo ci{}; ci.sType=VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        ci.bindingCount=1; ci.pBindings=&b;
-        vkCreateDescriptorSetLayout(dev,&ci,nullptr,&model.dsLayout);
-
-        VkDescriptorPoolSize ps{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,1};
-        VkDescriptorPoolCreateInfo dp{}; dp.sType=VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        dp.maxSets=1; dp.poolSizeCount=1; dp.pPoolSizes=&ps;
-        vkCreateDescriptorPool(dev,&dp,nullptr,&model.dsPool);
-
-        VkDescriptorSetAllocateInfo ai{}; ai.sType=VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        ai.descriptorPool=model.dsPool; ai.descriptorSetCount=1; ai.pSetLayouts=&model.dsLayout;
-        vkAllocateDescriptorSets(dev,&ai,&model.dsSet);
-
-        VkDescriptorImageInfo ii{}; ii.sampler=model.atlasSampler;
-        ii.imageView=model.atlasImageView; ii.imageLayout=VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        VkWriteDescriptorSet w{}; w.sType=VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        w.dstSet=model.dsSet; w.dstBinding=0; w.descriptorCount=1;
-        w.descriptorType=VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; w.pImageInfo=&ii;
-        vkUpdateDescriptorSets(dev,1,&w,0,nullptr);
+    // Local seconds, from update(); server seconds, unwrapped from timeMs
+    double   _clock      = 0.0;
+    double   _serverT    = 0.0;
+    uint32_t _lastMs     = 0;
+    bool     _haveServer = false;
+    double   _offset     = 0.0;   // lowest (arrival - server time) seen
+    float    _jitter     = 0.f;   // mean arrival lateness above _offset
+    float    _interval   = 0.05f; // mean gap between batches, server time
+    float    _delay      = 0.1f;
+
+    // Places a batch on the server timeline and folds its arrival into the
+    // offset and jitter estimates. Without a timestamp (older server) the
+    // arrival time stands in, jitter and all.
+    double serverTime(const PlayerPosSyncPacket& pkt) {
+        if (!pkt.timed) return _clock;
+        if (!_haveServer) {
+            _serverT = pkt.timeMs / 1000.0;
+            _offset  = _clock - _serverT;
+            _haveServer = true;
+        } else {
+            int32_t step = (int32_t)(pkt.timeMs - _lastMs);
+            if (step <= 0) return _serverT; // reordered or repeated
+            _serverT += step / 1000.0;
+            // The server goes quiet while nobody in range moves; a gap
+            // like that isn't the batch rate slowing
+            if (step / 1000.0 < _interval * 3.0)
+                _interval += ((float)(step / 1000.0) - _interval) * 0.1f;
+        }
+        _lastMs = pkt.timeMs;
+        double transit = _clock - _serverT;
+        _offset = std::min(_offset, transit);
+        _jitter += ((float)(transit - _offset) - _jitter) * 0.1f;
+        return _serverT;
     }
 
-    void createPipeline(VkDevice dev, VkRenderPass rp, VkExtent2D ext,
-                        const char* vs, const char* fs) {
-        auto loadSpv=[](const char* p)->std::vector<uint32_t>{
-            FILE* f=fopen(p,"rb"); if(!f) return {};
-            fseek(f,0,SEEK_END); size_t sz=ftell(f); fseek(f,0,SEEK_SET);
-            std::vector<uint32_t> b(sz/4); fread(b.data(),1,sz,f); fclose(f); return b; };
-        auto makeMod=[&](const std::vector<uint32_t>& c)->VkShaderModule{
-            VkShaderModuleCreateInfo ci{}; ci.sType=VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-            ci.codeSize=c.size()*4; ci.pCode=c.data(); VkShaderModule m;
-            vkCreateShaderModule(dev,&ci,nullptr,&m); return m; };
-
-        auto vc=loadSpv(vs), fc=loadSpv(fs);
-        VkShaderModule vm=makeMod(vc), fm=makeMod(fc);
-
-        VkPushConstantRange pcr{}; pcr.stageFlags=VK_SHADER_STAGE_VERTEX_BIT; pcr.size=sizeof(glm::mat4);
-        VkPipelineLayoutCreateInfo li{}; li.sType=VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        li.setLayoutCount=1; li.pSetLayouts=&model.dsLayout;
-        li.pushConstantRangeCount=1; li.pPushConstantRanges=&pcr;
-        vkCreatePipelineLayout(dev,&li,nullptr,&model.pipelineLayout);
-
-        VkPipelineShaderStageCreateInfo st[2]{};
-        st[0].sType=VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        st[0].stage=VK_SHADER_STAGE_VERTEX_BIT; st[0].module=vm; st[0].pName="main";
-        st[1].sType=VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        st[1].stage=VK_SHADER_STAGE_FRAGMENT_BIT; st[1].module=fm; st[1].pName="main";
-
-        VkVertexInputBindingDescription bd{}; bd.stride=sizeof(PlayerVertex);
-        VkVertexInputAttributeDescription at[3]{};
-        at[0]={0,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(PlayerVertex,pos)};
-        at[1]={1,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(PlayerVertex,normal)};
-        at[2]={2,0,VK_FORMAT_R32G32_SFLOAT,   offsetof(PlayerVertex,uv)};
-        VkPipelineVertexInputStateCreateInfo vi{}; vi.sType=VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vi.vertexBindingDescriptionCount=1; vi.pVertexBindingDescriptions=&bd;
-        vi.vertexAttributeDescriptionCount=3; vi.pVertexAttributeDescriptions=at;
+    static float lerpAngle(float a, float b, float f) {
+        float d = std::fmod(b - a + 540.f, 360.f) - 180.f; // shortest way round
+        return a + d * f;
+    }
 
-        VkPipelineInputAssemblyStateCreateInfo ia{}; ia.sType=VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        ia.topology=VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        VkViewport vp{0,0,(float)ext.width,(float)ext.height,0,1};
-        VkRect2D sc{{0,0},ext};
-        VkPipelineViewportStateCreateInfo vps{}; vps.sType=VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-        vps.viewportCount=1; vps.pViewports=&vp; vps.scissorCount=1; vps.pScissors=&sc;
-        VkPipelineRasterizationStateCreateInfo rs{}; rs.sType=VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-        rs.polygonMode=VK_POLYGON_MODE_FILL; rs.cullMode=VK_CULL_MODE_BACK_BIT;
-        rs.frontFace=VK_FRONT_FACE_COUNTER_CLOCKWISE; rs.lineWidth=1.f;
-        VkPipelineMultisampleStateCreateInfo ms{}; ms.sType=VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-        ms.rasterizationSamples=VK_SAMPLE_COUNT_1_BIT;
-        VkPipelineDepthStencilStateCreateInfo ds{}; ds.sType=VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-        ds.depthTestEnable=VK_TRUE; ds.depthWriteEnable=VK_TRUE; ds.depthCompareOp=VK_COMPARE_OP_LESS;
-        VkPipelineColorBlendAttachmentState ba{}; ba.colorWriteMask=0xF;
-        VkPipelineColorBlendStateCreateInfo bl{}; bl.sType=VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-        bl.attachmentCount=1; bl.pAttachments=&ba;
+    static void sample(RemotePlayerState& p, double at) {
+        if (p.snapCount == 0) { p.renderPos = p.pos; return; }
+        const auto& newest = p.snap(p.snapCount - 1);
+        if (p.snapCount == 1 || at <= p.snap(0).t) {
+            const auto& s = p.snapCount == 1 ? newest : p.snap(0);
+            p.renderPos = s.pos; p.yaw = s.yaw; p.pitch = s.pitch;
+            return;
+        }
+        if (at >= newest.t) {
+            // Ran out: carry on along the last step for a while, then hold
+            const auto& prev = p.snap(p.snapCount - 2);
+            double span = newest.t - prev.t;
+            float  over = (float)std::min(at - newest.t, (double)Config::REMOTE_EXTRAP_S);
+            glm::vec3 v = span > 0 ? (newest.pos - prev.pos) / (float)span : glm::vec3(0.f);
+            p.renderPos = newest.pos + v * over;
+            p.yaw = newest.yaw; p.pitch = newest.pitch;
+            return;
+        }
+        int i = p.snapCount - 1;
+        while (i > 0 && p.snap(i - 1).t > at) i--;
+        const auto& a = p.snap(i - 1);
+        const auto& b = p.snap(i);
+        float f = (float)((at - a.t) / (b.t - a.t));
+        p.renderPos = glm::mix(a.pos, b.pos, f);
+        p.yaw   = lerpAngle(a.yaw, b.yaw, f);
+        p.pitch = a.pitch + (b.pitch - a.pitch) * f;
+    }
+    std::vector<Visible> _bucket[PlayerModelGPU::LOD_COUNT];
+    VmaAllocator         _allocator = nullptr;
+    BindlessTable*       _table     = nullptr;
+
+    void writeInstance(uint32_t slot, const Visible& v) {
+        PlayerInstance& inst = model.instMapped[slot];
+        inst.model = v.model;
+        inst.info  = glm::uvec4(0u);
+        if (model.jointCount) {
+            uint32_t j0 = slot * model.jointCount;
+            inst.info = glm::uvec4(j0, model.jointCount, 0u, 0u);
+            glm::mat4* dst = model.jointMapped + j0;
+            if (v.player->joints.size() == model.jointCount)
+                memcpy(dst, v.player->joints.data(), model.jointCount * sizeof(glm::mat4));
+            else
+                for (uint32_t j = 0; j < model.jointCount; j++) dst[j] = glm::mat4(1.f);
+        }
+    }
 
-        VkGraphicsPipelineCreateInfo pi{}; pi.sType=VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pi.stageCount=2; pi.pStages=st; pi.pVertexInputState=&vi; pi.pInputAssemblyState=&ia;
-        pi.pViewportState=&vps; pi.pRasterizationState=&rs; pi.pMultisampleState=&ms;
-        pi.pDepthStencilState=&ds; pi.pColorBlendState=&bl;
-        pi.layout=model.pipelineLayout; pi.renderPass=rp;
-        vkCreateGraphicsPipelines(dev,VK_NULL_HANDLE,1,&pi,nullptr,&model.pipeline);
-        vkDestroyShaderModule(dev,vm,nullptr); vkDestroyShaderModule(dev,fm,nullptr);
+    void flushInstances(uint32_t base, uint32_t n) {
+        vmaFlushAllocation(_allocator, model.instAlloc, (VkDeviceSize)base * sizeof(PlayerInstance),
+                           (VkDeviceSize)n * sizeof(PlayerInstance));
+        if (model.jointCount)
+            vmaFlushAllocation(_allocator, model.jointAlloc,
+                               (VkDeviceSize)base * model.jointCount * sizeof(glm::mat4),
+                               (VkDeviceSize)n * model.jointCount * sizeof(glm::mat4));
     }
 
-    static VkCommandBuffer beginOT(VkDevice d, VkCommandPool p) {
-        VkCommandBufferAllocateInfo a{}; a.sType=VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        a.commandPool=p; a.level=VK_COMMAND_BUFFER_LEVEL_PRIMARY; a.commandBufferCount=1;
-        VkCommandBuffer c; vkAllocateCommandBuffers(d,&a,&c);
-        VkCommandBufferBeginInfo b{}; b.sType=VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        b.flags=VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; vkBeginCommandBuffer(c,&b); return c; }
-    static void endOT(VkDevice d, VkCommandPool p, VkQueue q, VkCommandBuffer c) {
-        vkEndCommandBuffer(c); VkSubmitInfo s{}; s.sType=VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        s.commandBufferCount=1; s.pCommandBuffers=&c;
-        vkQueueSubmit(q,1,&s,VK_NULL_HANDLE); vkQueueWaitIdle(q);
-        vkFreeCommandBuffers(d,p,1,&c); }
+    // Persistently mapped storage buffer
+    void* hostBuf(VmaAllocator alloc, VkDeviceSize size, VkBuffer& buf, VmaAllocation& al) {
+        _allocator = alloc;
+        VkBufferCreateInfo b{}; b.sType=VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        b.size=size; b.usage=VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        VmaAllocationCreateInfo a{}; a.usage=VMA_MEMORY_USAGE_CPU_TO_GPU;
+        a.flags=VMA_ALLOCATION_CREATE_MAPPED_BIT; VmaAllocationInfo i{};
+        if (vmaCreateBuffer(alloc,&b,&a,&buf,&al,&i) != VK_SUCCESS) return nullptr;
+        return i.pMappedData;
+    }
 };
@@ -0,0 +1,258 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <entt/entt.hpp>
+#include "packets.h"
+#include "mp_packets.h"
+
+// ── Replication ───────────────────────────────────────────────────────────────
+// Server → client sync of entt components, so a new networked feature gets
+// per-field deltas without a packet of its own. A component is marked
+// replicated by specializing ReplTraits<T> with its schema — which fields
+// go over and how each is quantized — and registering it on both ends in
+// the same order (ReplicationServer::replicate, ReplicationClient::replicate).
+// Components are structs of plain fields; a tag needs a field to carry.
+//
+//   struct CBurning { float left; uint8_t stacks; };
+//   template<> struct ReplTraits<CBurning> {
+//       static std::vector<ReplField> fields() {
+//           return {Repl::real<&CBurning::left>(0.f, 30.f, 8), Repl::integer<&CBurning::stacks>(3)};
+//       }
+//   };
+//
+// The server replicates entities that carry a CReplicated: netId names the
+// entity on the wire, pos decides who hears about it. Each client has a
+// baseline per entity it knows: the quantized fields last sent. Sends are
+// reliable, so that's what the client holds, and a flush sends only the
+// fields that differ from it (see ReplicationServer for the budget).
+//
+//   u8 id | records until the end, each byte-aligned:
+//     varint netId | bits: 1 gone | unless gone, per registered type, in
+//     order: 2 bits op (0 same, 1 changed, 2 removed) | if changed: a mask
+//     of the type's fields, then each set field at its width
+
+// ── Schema ────────────────────────────────────────────────────────────────────
+
+struct ReplField {
+    uint8_t bits = 0;                           // width on the wire, 1..32
+    float   lo = 0.f, hi = 0.f;                 // real(): the quantized range
+    uint32_t (*get)(const void* c, const ReplField& f) = nullptr; // the field, quantized
+    void     (*set)(void* c, const ReplField& f, uint32_t q)      = nullptr;
+
+    uint32_t mask() const { return bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1; }
+};
+
+// Specialize with static std::vector<ReplField> fields(), at most 32
+template<class T>
+struct ReplTraits;
+
+namespace Repl {
+    template<class M> struct MemberOf;
+    template<class C, class T> struct MemberOf<T C::*> {
+        using Class = C;
+        using Type  = T;
+    };
+
+    // A float member in [lo, hi], bits wide; clamped into range
+    template<auto M>
+    ReplField real(float lo, float hi, int bits) {
+        using C = typename MemberOf<decltype(M)>::Class;
+        static_assert(std::is_same_v<typename MemberOf<decltype(M)>::Type, float>, "real() takes a float member");
+        ReplField f;
+        f.bits = (uint8_t)std::clamp(bits, 1, 32);
+        f.lo   = lo;
+        f.hi   = hi;
+        f.get  = [](const void* c, const ReplField& f) {
+            float v = static_cast<const C*>(c)->*M;
+            float t = f.hi > f.lo ? (v - f.lo) / (f.hi - f.lo) : 0.f;
+            return (uint32_t)std::lround((double)std::clamp(t, 0.f, 1.f) * f.mask());
+        };
+        f.set = [](void* c, const ReplField& f, uint32_t q) {
+            static_cast<C*>(c)->*M = f.lo + (f.hi - f.lo) * (float)((double)q / f.mask());
+        };
+        return f;
+    }
+
+    // An integer, enum or bool member, its low bits as is; signed ones
+    // sign-extend back
+    template<auto M>
+    ReplField integer(int bits) {
+        using C = typename MemberOf<decltype(M)>::Class;
+        using T = typename MemberOf<decltype(M)>::Type;
+        using I = typename std::conditional_t<std::is_enum_v<T>, std::underlying_type<T>,
+                                              std::type_identity<T>>::type;
+        static_assert(std::is_integral_v<I>, "integer() takes an integer, enum or bool member");
+        ReplField f;
+        f.bits = (uint8_t)std::clamp(bits, 1, 32);
+        f.get  = [](const void* c, const ReplField& f) {
+            return (uint32_t)(int64_t)(I)(static_cast<const C*>(c)->*M) & f.mask();
+        };
+        f.set = [](void* c, const ReplField& f, uint32_t q) {
+            int64_t v = q;
+            if constexpr (std::is_signed_v<I>)
+                if (f.bits < 32 && (q >> (f.bits - 1)) & 1) v -= (int64_t)1 << f.bits;
+            if constexpr (std::is_same_v<I, bool>) static_cast<C*>(c)->*M = q != 0;
+            else                                   static_cast<C*>(c)->*M = (T)(I)v;
+        };
+        return f;
+    }
+}
+
+// On every replicated entity, both ends. The server sets both; on the
+// client pos stays as constructed — anything that should move on screen
+// replicates a component of its own.
+struct CReplicated {
+    uint32_t  netId = 0;
+    glm::vec3 pos{0.f};
+};
+
+// ── Bits ──────────────────────────────────────────────────────────────────────
+// LSB first within each byte
+
+class BitWriter {
+public:
+    explicit BitWriter(PacketWriter& w) : _w(w) {}
+    ~BitWriter() { finish(); }
+
+    void put(uint32_t v, int bits) {
+        if (bits <= 0) return;
+        _acc |= (uint64_t)(bits >= 32 ? v : v & ((1u << bits) - 1)) << _n;
+        _n += bits;
+        for (; _n >= 8; _n -= 8, _acc >>= 8) _w.u8((uint8_t)_acc);
+    }
+    // Pads to the next byte
+    void finish() {
+        if (_n > 0) _w.u8((uint8_t)_acc);
+        _acc = 0;
+        _n   = 0;
+    }
+
+private:
+    PacketWriter& _w;
+    uint64_t      _acc = 0;
+    int           _n   = 0;
+};
+
+class BitReader {
+public:
+    explicit BitReader(PacketReader& r) : _r(r) {}
+
+    uint32_t get(int bits) {
+        if (bits <= 0) return 0;
+        while (_n < bits) {
+            if (!_r.has(1)) {
+                _bad = true;
+                return 0;
+            }
+            _acc |= (uint64_t)_r.u8() << _n;
+            _n += 8;
+        }
+        uint32_t v = (uint32_t)(bits >= 32 ? _acc : _acc & ((1ull << bits) - 1));
+        _acc >>= bits;
+        _n -= bits;
+        return v;
+    }
+    // Drops what's left of the current byte
+    void finish() {
+        _acc = 0;
+        _n   = 0;
+    }
+    bool ok() const { return !_bad; }
+
+private:
+    PacketReader& _r;
+    uint64_t      _acc = 0;
+    int           _n   = 0;
+    bool          _bad = false;
+};
+
+namespace Repl {
+    inline constexpr uint32_t OP_SAME = 0, OP_CHANGED = 1, OP_REMOVED = 2;
+}
+
+// ── Client ────────────────────────────────────────────────────────────────────
+// Mirrors the server's replicated entities into a registry: one entity per
+// netId, created at its first record and destroyed when it goes. Main
+// thread, like the rest of the game's registry.
+class ReplicationClient {
+public:
+    explicit ReplicationClient(entt::registry& reg) : _reg(reg) {}
+
+    template<class T>
+    void replicate() {
+        static_assert(!std::is_empty_v<T>, "replicate a component with at least one field");
+        Type t;
+        t.fields = ReplTraits<T>::fields();
+        t.edit   = [](entt::registry& reg, entt::entity e) -> void* { return &reg.get_or_emplace<T>(e); };
+        t.remove = [](entt::registry& reg, entt::entity e) { reg.remove<T>(e); };
+        _types.push_back(std::move(t));
+    }
+
+    // False if the packet is malformed; records before the bad one stay
+    // applied, and the server's next change of a field puts it right
+    bool apply(const uint8_t* d, size_t len) {
+        PacketReader r(d, len);
+        while (r.ok() && r.remaining() > 0) {
+            uint32_t  id = r.varint();
+            BitReader b(r);
+            if (b.get(1)) {
+                auto it = _entities.find(id);
+                if (it != _entities.end()) {
+                    if (_reg.valid(it->second)) _reg.destroy(it->second);
+                    _entities.erase(it);
+                }
+                continue;
+            }
+            entt::entity e = entityFor(id);
+            for (Type& t : _types) {
+                uint32_t op = b.get(2);
+                if (op == Repl::OP_REMOVED) t.remove(_reg, e);
+                if (op != Repl::OP_CHANGED) continue;
+                uint32_t mask = b.get((int)t.fields.size());
+                void*    c    = t.edit(_reg, e);
+                for (size_t i = 0; i < t.fields.size(); i++)
+                    if (mask >> i & 1) t.fields[i].set(c, t.fields[i], b.get(t.fields[i].bits));
+            }
+            if (!b.ok()) return false;
+        }
+        return r.ok();
+    }
+
+    // entt::null if the server hasn't sent it, or it's gone
+    entt::entity find(uint32_t netId) const {
+        auto it = _entities.find(netId);
+        return it != _entities.end() ? it->second : entt::entity{entt::null};
+    }
+
+    // A new session starts from nothing
+    void clear() {
+        for (auto& [id, e] : _entities)
+            if (_reg.valid(e)) _reg.destroy(e);
+        _entities.clear();
+    }
+
+private:
+    struct Type {
+        std::vector<ReplField> fields;
+        void* (*edit)(entt::registry&, entt::entity)   = nullptr; // emplaced if missing
+        void  (*remove)(entt::registry&, entt::entity) = nullptr;
+    };
+
+    entt::entity entityFor(uint32_t id) {
+        auto [it, fresh] = _entities.try_emplace(id, entt::null);
+        if (fresh || !_reg.valid(it->second)) {
+            it->second = _reg.create();
+            _reg.emplace<CReplicated>(it->second, CReplicated{id});
+        }
+        return it->second;
+    }
+
+    entt::registry&                            _reg;
+    std::vector<Type>                          _types;
+    std::unordered_map<uint32_t, entt::entity> _entities; // by netId
+};
@@ -0,0 +1,172 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "chunk.h"
+
+// ── SparseColumns ─────────────────────────────────────────────────────────────
+// A chunk's densities, for keeping in memory: each [x][z] column keeps only
+// the run between its saturated ends. Below the run every sample is the
+// column's first (+sat or -sat), above it its last, so deep rock and open
+// sky cost a column header and nothing more; a column that crosses the
+// surface keeps the few samples around the crossing, and one that never
+// saturates keeps them all. Lossless for any field. Rebuilt, not edited;
+// at() only once built.
+template<class T>
+class SparseColumns {
+public:
+    static constexpr int P = ChunkData::PADDED;
+
+    // get(x, y, z) for every sample; sat is the saturated magnitude
+    template<class Get>
+    void build(Get&& get, T sat) {
+        _sat = sat;
+        _slabBase.assign(P, 0u);
+        _cols.assign((size_t)P * P, Column{});
+        _samples.clear();
+        for (int x = 0; x < P; x++) {
+            _slabBase[x] = (uint32_t)_samples.size();
+            for (int z = 0; z < P; z++) {
+                Column& c = _cols[x * P + z];
+                T first = get(x, 0, z), last = get(x, P - 1, z);
+                int lo = 0, hi = P;
+                if (first == sat || first == -sat)
+                    while (lo < P && get(x, lo, z) == first) lo++;
+                if (last == sat || last == -sat)
+                    while (hi > lo && get(x, hi - 1, z) == last) hi--;
+                c.offset = (uint16_t)(_samples.size() - _slabBase[x]);
+                c.lo     = (uint8_t)(lo | (first < 0 ? NEG : 0));
+                c.n      = (uint8_t)((hi - lo) | (last < 0 ? NEG : 0));
+                for (int y = lo; y < hi; y++) _samples.push_back(get(x, y, z));
+            }
+        }
+        _samples.shrink_to_fit();
+    }
+
+    T at(int x, int y, int z) const {
+        const Column& c = _cols[x * P + z];
+        int lo = c.lo & ~NEG, n = c.n & ~NEG;
+        if (y < lo) return c.lo & NEG ? -_sat : _sat;
+        if (y >= lo + n) return c.n & NEG ? -_sat : _sat;
+        return _samples[_slabBase[x] + c.offset + (y - lo)];
+    }
+
+    // put(x, y, z, v) for every sample
+    template<class Put>
+    void expand(Put&& put) const {
+        for (int x = 0; x < P; x++)
+            for (int z = 0; z < P; z++)
+                for (int y = 0; y < P; y++) put(x, y, z, at(x, y, z));
+    }
+
+    size_t stored() const { return _samples.size(); }
+    size_t heapBytes() const {
+        return _slabBase.capacity() * sizeof(uint32_t) + _cols.capacity() * sizeof(Column) +
+               _samples.capacity() * sizeof(T);
+    }
+
+private:
+    static constexpr uint8_t NEG = 0x80; // in lo: below the run is -sat; in n: above it is
+    static_assert(P < NEG, "column extents share a byte with the sign");
+    static_assert(P * P <= 0xFFFF, "a slab's samples fit a u16 offset");
+
+    struct Column {
+        uint16_t offset = 0; // into _samples, from the column's x slab
+        uint8_t  lo     = 0; // first kept sample
+        uint8_t  n      = 0; // kept samples
+    };
+    T                     _sat = 0;
+    std::vector<uint32_t> _slabBase; // per x, empty until built
+    std::vector<Column>   _cols;     // [x][z]
+    std::vector<T>        _samples;
+};
+
+// ── MaterialPalette ───────────────────────────────────────────────────────────
+// A chunk's materials in 8^3 bricks, each an index into the few materials
+// it holds: 0 bits for a brick of one (all the air and deep rock), then 1,
+// 2 or 4 bits, and 8 past sixteen, packed into words so no index straddles
+// two. Only the bricks the surface passes through cost anything much.
+class MaterialPalette {
+public:
+    static constexpr int P      = ChunkData::PADDED;
+    static constexpr int B      = 8;                 // brick edge
+    static constexpr int BRICKS = (P + B - 1) / B;   // along each axis; the last ones partial
+    static constexpr int SLOTS  = B * B * B;
+
+    // get(x, y, z) for every sample
+    template<class Get>
+    void build(Get&& get) {
+        _bricks.assign((size_t)BRICKS * BRICKS * BRICKS, Brick{});
+        _palettes.clear();
+        _packed.clear();
+        uint8_t slot[SLOTS];
+        for (int bx = 0; bx < BRICKS; bx++)
+            for (int bz = 0; bz < BRICKS; bz++)
+                for (int by = 0; by < BRICKS; by++) {
+                    Brick& b = _bricks[((size_t)bx * BRICKS + bz) * BRICKS + by];
+                    b.palette = (uint32_t)_palettes.size();
+                    int16_t index[256];
+                    std::fill(index, index + 256, (int16_t)-1);
+                    int n = 0;
+                    for (int i = 0; i < SLOTS; i++) {
+                        int x = bx * B + i / (B * B), z = bz * B + i / B % B, y = by * B + i % B;
+                        if (x >= P || y >= P || z >= P) { slot[i] = 0; continue; }
+                        uint8_t m = get(x, y, z);
+                        if (index[m] < 0) {
+                            index[m] = (int16_t)n++;
+                            _palettes.push_back(m);
+                        }
+                        slot[i] = (uint8_t)index[m];
+                    }
+                    b.bits = (uint8_t)(n <= 1 ? 0 : n <= 2 ? 1 : n <= 4 ? 2 : n <= 16 ? 4 : 8);
+                    b.word = (uint32_t)_packed.size();
+                    if (!b.bits) continue;
+                    _packed.resize(_packed.size() + SLOTS * b.bits / 32, 0u);
+                    for (int i = 0; i < SLOTS; i++) {
+                        size_t bit = (size_t)i * b.bits;
+                        _packed[b.word + bit / 32] |= (uint32_t)slot[i] << (bit % 32);
+                    }
+                }
+        _palettes.shrink_to_fit();
+        _packed.shrink_to_fit();
+    }
+
+    uint8_t at(int x, int y, int z) const {
+        const Brick& b = _bricks[((size_t)(x / B) * BRICKS + z / B) * BRICKS + y / B];
+        if (b.bits == 0) return _palettes[b.palette];
+        size_t bit = (size_t)(((x % B) * B + z % B) * B + y % B) * b.bits;
+        return _palettes[b.palette + ((_packed[b.word + bit / 32] >> (bit % 32)) & ((1u << b.bits) - 1))];
+    }
+
+    size_t heapBytes() const {
+        return _bricks.capacity() * sizeof(Brick) + _palettes.capacity() + _packed.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    struct Brick {
+        uint32_t word    = 0; // its indices, into _packed
+        uint32_t palette = 0; // its materials, into _palettes
+        uint8_t  bits    = 0;
+    };
+    std::vector<Brick>    _bricks;   // [x][z][y]
+    std::vector<uint8_t>  _palettes; // every brick's, back to back
+    std::vector<uint32_t> _packed;
+};
+
+// ── ResidentChunk ─────────────────────────────────────────────────────────────
+// A ChunkData as the server keeps it between uses: sparse densities and
+// brick-palette materials, a quarter to half the dense grid, decoded
+// back into a ChunkData (exactly) when it's meshed or edited.
+struct ResidentChunk {
+    ChunkCoord                         coord{0, 0, 0};
+    ChunkData::Fill                    fill = ChunkData::Fill::Air;
+    SparseColumns<ChunkData::Density>  density;
+    MaterialPalette                    materials;
+
+    static std::unique_ptr<ResidentChunk> fromData(const ChunkData& data);
+    void decode(ChunkData& out) const;
+
+    size_t bytes() const { return sizeof(*this) + density.heapBytes() + materials.heapBytes(); }
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// ── Signed session tokens ─────────────────────────────────────────────────────
+// The website signs the session tokens it issues, so a game server can check
+// one itself instead of asking /api/verify:
+//
+//   v1.<kid>.<claims>.<sig>
+//     kid     which signing key, so keys can rotate with tokens still live
+//     claims  base64url of "uid\nusername\nexpires\nsession": expires in
+//             unix seconds, session the id the website revokes it by
+//     sig     base64url of HMAC-SHA256(key, "v1.<kid>.<claims>")
+//
+// Keys and the revocation list are plain text, one entry a line:
+// "<kid> <hex secret>" and "<session>". A server reads keys from
+// --auth-keys (the website's data/session-keys.txt), and in the background
+// rereads that file and fetches the revocations from the auth server
+// (MultiplayerManager::refreshAuthKeys). The keys never go over the wire:
+// a server not on the website's host needs a copy of the file. Tokens
+// without the v1 prefix are the website's older JWTs, still
+// verified over HTTP.
+namespace Sha256 {
+    using Digest = std::array<uint8_t, 32>;
+    Digest hash(const void* d, size_t len);
+    Digest hmac(const uint8_t* key, size_t keyLen, const void* d, size_t len);
+}
+
+class SessionTokens {
+public:
+    enum class Result { Valid, Unsigned, Malformed, UnknownKey, BadSignature, Expired, Revoked };
+
+    struct Claims {
+        std::string uid;
+        std::string username;
+        int64_t     expires = 0; // unix seconds
+        std::string session;
+    };
+
+    // Has the v1 prefix; anything else goes to the auth server
+    static bool        isSigned(const std::string& token) { return token.rfind("v1.", 0) == 0; }
+    static const char* name(Result r);
+
+    // Microseconds; one thread at a time with the setters
+    Result verify(const std::string& token, int64_t now, Claims& out) const;
+
+    // From "<kid> <hex>" lines; bad lines are skipped. False if none parsed,
+    // and the keys held are left alone.
+    bool        setKeys(const std::string& text);
+    void        setRevoked(const std::string& text);
+    bool        empty() const { return _keys.empty(); }
+    size_t      keyCount() const { return _keys.size(); }
+    size_t      revokedCount() const { return _revoked.size(); }
+
+    // v1 token for claims under key kid (tools and tests; the website
+    // does the same)
+    static std::string sign(const std::string& kid, const std::vector<uint8_t>& key, const Claims& c);
+
+private:
+    std::unordered_map<std::string, std::vector<uint8_t>> _keys; // by kid
+    std::unordered_set<std::string>                       _revoked;
+};
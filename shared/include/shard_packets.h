@@ -0,0 +1,182 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "packets.h"
+#include "inv_packets.h"
+#include "player_stats.h"
+#include "terrain_edit.h"
+
+// ── Shard packets ─────────────────────────────────────────────────────────────
+// What server processes that split the world between them (see ShardMap)
+// say to each other over their links, and the one thing a client hears
+// about it: where to go next.
+
+enum class ShardPacketID : uint8_t {
+    ShardHello    = 0x50, // shard -> shard: which shard this link is from, and the shared secret
+    ShardGhosts   = 0x51, // shard -> shard: its players near the receiver's area (movement channel)
+    ShardHandoff  = 0x52, // shard -> shard: a player on their way over, with their state
+    ShardEdit     = 0x53, // shard -> shard: a terrain edit that reaches the receiver's view
+    ShardRedirect = 0x54, // server -> client: reconnect to this shard, with this ticket
+};
+
+// First on every link; nothing else is taken from a link until it's heard
+//   u8 id | u16 shard | str secret
+struct ShardHelloPacket {
+    uint16_t    shard = 0;
+    std::string secret;
+
+    void write(PacketWriter& w) const {
+        w.begin((uint8_t)ShardPacketID::ShardHello, 7 + secret.size()).u16(shard).str(secret);
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, ShardHelloPacket& out) {
+        PacketReader r(d, len);
+        out.shard  = r.u16();
+        out.secret = std::string(r.str());
+        return r.ok();
+    }
+};
+
+// Every player of the sender's within SHARD_BORDER_CHUNKS of the receiver's
+// area, as of now. Whoever was in the last list and isn't in this one has
+// gone — left, or walked away from the border.
+//   u8 id | u16 shard | u16 n | n × { u32 player | str name | f32 x,y,z,yaw,pitch }
+struct ShardGhostsPacket {
+    struct Ghost {
+        uint32_t    id = 0;
+        std::string name;
+        float       x = 0.f, y = 0.f, z = 0.f, yaw = 0.f, pitch = 0.f;
+    };
+    uint16_t           shard = 0;
+    std::vector<Ghost> ghosts;
+
+    void write(PacketWriter& w) const {
+        w.begin((uint8_t)ShardPacketID::ShardGhosts, 5 + ghosts.size() * 32).u16(shard);
+        w.u16((uint16_t)ghosts.size());
+        for (const Ghost& g : ghosts)
+            w.u32(g.id).str(g.name).f32(g.x).f32(g.y).f32(g.z).f32(g.yaw).f32(g.pitch);
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, ShardGhostsPacket& out) {
+        PacketReader r(d, len);
+        out.shard = r.u16();
+        uint16_t n = r.u16();
+        out.ghosts.clear();
+        for (uint16_t i = 0; i < n && r.ok(); i++) {
+            Ghost g;
+            g.id   = r.u32();
+            g.name = std::string(r.str());
+            g.x = r.f32(); g.y = r.f32(); g.z = r.f32();
+            g.yaw = r.f32(); g.pitch = r.f32();
+            out.ghosts.push_back(std::move(g));
+        }
+        return r.ok();
+    }
+};
+
+// A player crossing into the receiver's area: who they are, where, and what
+// they carry. The ticket is what the client will log in with there (as its
+// AuthRequest token, "shard:" and 16 hex digits); the player keeps their id,
+// so the receiver's players, who saw them as a ghost, see the same player.
+//   u8 id | u32 ticket hi, lo | u32 player | str name | str uid
+//   | f32 x,y,z,yaw,pitch | u8 move epoch | stats | inventory
+struct ShardHandoffPacket {
+    uint64_t    ticket = 0;
+    uint32_t    player = 0;
+    std::string name, uid;
+    float       x = 0.f, y = 0.f, z = 0.f, yaw = 0.f, pitch = 0.f;
+    uint8_t     moveEpoch = 0;
+    PlayerStats stats;
+    Inventory   inv;
+
+    static std::string token(uint64_t ticket) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), "shard:%016llx", (unsigned long long)ticket);
+        return buf;
+    }
+
+    void write(PacketWriter& w) const {
+        std::vector<uint8_t> items;
+        writeInventory(items, inv);
+        w.begin((uint8_t)ShardPacketID::ShardHandoff, 64 + name.size() + uid.size() + items.size())
+         .u32((uint32_t)(ticket >> 32)).u32((uint32_t)ticket).u32(player).str(name).str(uid)
+         .f32(x).f32(y).f32(z).f32(yaw).f32(pitch).u8(moveEpoch)
+         .f32(stats.health).f32(stats.healthMax).f32(stats.stamina).f32(stats.staminaMax)
+         .f32(stats.mana).f32(stats.manaMax).f32(stats.armour).f32(stats.armourMax)
+         .u8(stats.dead ? 1 : 0);
+        w.u32((uint32_t)items.size()).bytes(items.data(), items.size());
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, ShardHandoffPacket& out) {
+        PacketReader r(d, len);
+        out.ticket = (uint64_t)r.u32() << 32;
+        out.ticket |= r.u32();
+        out.player = r.u32();
+        out.name   = std::string(r.str());
+        out.uid    = std::string(r.str());
+        out.x = r.f32(); out.y = r.f32(); out.z = r.f32();
+        out.yaw = r.f32(); out.pitch = r.f32();
+        out.moveEpoch = r.u8();
+        PlayerStats& s = out.stats;
+        s.health = r.f32(); s.healthMax  = r.f32();
+        s.stamina = r.f32(); s.staminaMax = r.f32();
+        s.mana = r.f32(); s.manaMax = r.f32();
+        s.armour = r.f32(); s.armourMax = r.f32();
+        s.dead = r.u8() & 1;
+
+        std::vector<uint8_t> empty;
+        writeInventory(empty, Inventory{});
+        uint32_t n = r.u32();
+        const uint8_t* items = r.view(n);
+        if (!r.ok() || n != empty.size()) return false;
+        size_t o = 0;
+        readInventory(items, o, out.inv);
+        return true;
+    }
+};
+
+// A terrain edit applied by the sender that reaches chunks the receiver
+// streams; laid out as TerrainEdit
+//   u8 id | i32 x,y,z | u8 radius, strength, fill, material
+struct ShardEditPacket {
+    TerrainEdit edit;
+
+    void write(PacketWriter& w) const {
+        w.begin((uint8_t)ShardPacketID::ShardEdit, 17)
+         .i32(edit.x).i32(edit.y).i32(edit.z)
+         .u8((uint8_t)edit.radius).u8((uint8_t)edit.strength)
+         .u8(edit.fill ? 1 : 0).u8(edit.material);
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, ShardEditPacket& out) {
+        TerrainEditPacket p;
+        if (!TerrainEditPacket::deserialize(d, len, p)) return false;
+        out.edit = p.edit;
+        return true;
+    }
+};
+
+// The player has crossed into another shard's area: disconnect, connect to
+// host:port and log in with token. The world there is the same one, so the
+// client keeps its chunks and its disk cache.
+//   u8 id | str host | u16 port | str token
+struct ShardRedirectPacket {
+    std::string host;
+    uint16_t    port = 0;
+    std::string token;
+
+    void write(PacketWriter& w) const {
+        w.begin((uint8_t)ShardPacketID::ShardRedirect, 11 + host.size() + token.size())
+         .str(host).u16(port).str(token);
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, ShardRedirectPacket& out) {
+        PacketReader r(d, len);
+        out.host  = std::string(r.str());
+        out.port  = r.u16();
+        out.token = std::string(r.str());
+        return r.ok() && !out.host.empty() && out.port != 0;
+    }
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// ── SpscQueue ─────────────────────────────────────────────────────────────────
+// Fixed-capacity ring between exactly one producer thread and one consumer
+// thread; neither side ever takes a lock. Elements are moved in and out, so
+// a slot keeps whatever a moved-from T leaves behind (an empty vector, say)
+// until it's reused. push() fails when the ring is full — the producer
+// decides whether to hold on to the element or drop it.
+template<class T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+    // Producer side
+    bool push(T&& v) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) == N) return false;
+        _slots[head & (N - 1)] = std::move(v);
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side, in place: the next slot to fill, or null when the ring
+    // is full; publish() pushes it. The slot holds what exchange() left
+    // there, so a buffer filled by assign() comes round again without
+    // allocating.
+    T* claim() {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) == N) return nullptr;
+        return &_slots[head & (N - 1)];
+    }
+    void publish() { _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // Consumer side
+    bool pop(T& out) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return false;
+        out = std::move(_slots[tail & (N - 1)]);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // As pop, but out's old contents go into the slot for claim() to reuse
+    bool exchange(T& out) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return false;
+        std::swap(out, _slots[tail & (N - 1)]);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Either side; only a snapshot
+    bool empty() const {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+private:
+    // Apart, so the two threads don't bounce one cache line between them
+    alignas(64) std::atomic<size_t> _head{0}; // next push
+    alignas(64) std::atomic<size_t> _tail{0}; // next pop
+    T _slots[N];
+};
@@ -0,0 +1,132 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// ── StagedUploads ─────────────────────────────────────────────────────────────
+// Load-time copies into device-local buffers and textures, gathered from
+// every loader and recorded into one command buffer through one staging
+// range, so startup pays for a single submission and fence instead of a
+// submit-and-wait per resource.
+//
+// buffer() and image() create the destination at once and remember the
+// source, which must stay alive until record(). record() packs the sources
+// into the staging memory and the copies into cmd, with barriers for the
+// vertex, index and fragment stages that read them after. The destinations
+// can be bound, but not drawn from, until that submission has finished —
+// on the client vk_submit_assets supplies both and vk_assets_uploaded says.
+class StagedUploads {
+public:
+    explicit StagedUploads(VmaAllocator alloc) : _alloc(alloc) {}
+
+    bool buffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage,
+                VkBuffer& buf, VmaAllocation& al) {
+        VkBufferCreateInfo b{};
+        b.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        b.size  = size;
+        b.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        VmaAllocationCreateInfo a{};
+        a.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+        if (vmaCreateBuffer(_alloc, &b, &a, &buf, &al, nullptr) != VK_SUCCESS) return false;
+        _copies.push_back({data, size, buf, VK_NULL_HANDLE, 0, 0});
+        return true;
+    }
+
+    // Tightly packed texels, one mip level; left SHADER_READ_ONLY_OPTIMAL
+    bool image(const void* texels, VkDeviceSize size, uint32_t w, uint32_t h, VkFormat fmt,
+               VkImage& img, VmaAllocation& al) {
+        VkImageCreateInfo ic{};
+        ic.sType       = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        ic.imageType   = VK_IMAGE_TYPE_2D;
+        ic.format      = fmt;
+        ic.extent      = {w, h, 1};
+        ic.mipLevels   = 1;
+        ic.arrayLayers = 1;
+        ic.samples     = VK_SAMPLE_COUNT_1_BIT;
+        ic.tiling      = VK_IMAGE_TILING_OPTIMAL;
+        ic.usage       = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        VmaAllocationCreateInfo a{};
+        a.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+        if (vmaCreateImage(_alloc, &ic, &a, &img, &al, nullptr) != VK_SUCCESS) return false;
+        _copies.push_back({texels, size, VK_NULL_HANDLE, img, w, h});
+        return true;
+    }
+
+    bool empty() const { return _copies.empty(); }
+
+    // Staging the batch takes, each source 16-byte aligned
+    VkDeviceSize bytes() const {
+        VkDeviceSize n = 0;
+        for (const Copy& c : _copies) n += align(c.size);
+        return n;
+    }
+
+    // mapped is the staging buffer's mapping; bytes() of it from offset on
+    // are written. The sources can go once this returns.
+    void record(VkCommandBuffer cmd, VkBuffer staging, uint8_t* mapped, VkDeviceSize offset) {
+        std::vector<VkImageMemoryBarrier> barriers;
+        for (const Copy& c : _copies) {
+            if (!c.img) continue;
+            VkImageMemoryBarrier br{};
+            br.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            br.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            br.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            br.image               = c.img;
+            br.subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+            br.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+            br.newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            br.dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barriers.push_back(br);
+        }
+        if (!barriers.empty())
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                                 0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+
+        VkDeviceSize off = offset;
+        for (const Copy& c : _copies) {
+            std::memcpy(mapped + off, c.src, (size_t)c.size);
+            if (c.buf) {
+                VkBufferCopy r{off, 0, c.size};
+                vkCmdCopyBuffer(cmd, staging, c.buf, 1, &r);
+            } else {
+                VkBufferImageCopy r{};
+                r.bufferOffset     = off;
+                r.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+                r.imageExtent      = {c.w, c.h, 1};
+                vkCmdCopyBufferToImage(cmd, staging, c.img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &r);
+            }
+            off += align(c.size);
+        }
+
+        for (VkImageMemoryBarrier& br : barriers) {
+            br.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            br.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            br.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            br.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        }
+        VkMemoryBarrier mb{};
+        mb.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        mb.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                             1, &mb, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+        _copies.clear();
+    }
+
+private:
+    struct Copy {
+        const void*  src;
+        VkDeviceSize size;
+        VkBuffer     buf;  // one of buf and img
+        VkImage      img;
+        uint32_t     w, h;
+    };
+
+    static VkDeviceSize align(VkDeviceSize n) { return (n + 15) & ~VkDeviceSize(15); }
+
+    VmaAllocator      _alloc;
+    std::vector<Copy> _copies;
+};
@@ -0,0 +1,156 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "log.h"
+#include "thread_pool.h"
+
+// ── SystemScheduler ───────────────────────────────────────────────────────────
+// One simulation tick's systems, each declaring what it reads and writes:
+// registry components, or anything else shared between systems (the
+// camera, the colliders, the day). build() turns the declarations into a
+// dependency graph once — a system waits for every earlier-added one it
+// conflicts with, two writers or a writer and a reader of the same type —
+// and run() walks it, independent systems side by side on the pool.
+//
+//   sched.add("player", [&](float dt) { ... })
+//        .reads<CAABB>().writes<CTransform, CVelocity>();
+//
+// Added order is the order conflicting systems keep, so a tick means what
+// it did run in sequence. The thread calling run() takes part: it runs the
+// first ready system and each system's first newly ready dependent itself,
+// hands the rest to the pool, and returns once every system has. Entity
+// creation and destruction change a component's storage, so a system that
+// emplaces or removes a type writes it; anything undeclared is the
+// system's own.
+class SystemScheduler {
+public:
+    using Fn = std::function<void(float dt)>;
+
+    explicit SystemScheduler(ThreadPool& pool) : _pool(pool) {}
+
+    SystemScheduler(const SystemScheduler&)            = delete;
+    SystemScheduler& operator=(const SystemScheduler&) = delete;
+
+    class System {
+    public:
+        template<class... T> System& reads()  { (_reads.push_back(key<T>()), ...); return *this; }
+        template<class... T> System& writes() { (_writes.push_back(key<T>()), ...); return *this; }
+
+    private:
+        friend class SystemScheduler;
+        using Key = const void*;
+
+        // One address per type, no RTTI
+        template<class T> static Key key() {
+            static const char k = 0;
+            return &k;
+        }
+
+        bool conflicts(const System& o) const {
+            auto has = [](const std::vector<Key>& v, Key k) { return std::find(v.begin(), v.end(), k) != v.end(); };
+            for (Key k : _writes)
+                if (has(o._writes, k) || has(o._reads, k)) return true;
+            for (Key k : _reads)
+                if (has(o._writes, k)) return true;
+            return false;
+        }
+
+        std::string      _name;
+        Fn               _fn;
+        std::vector<Key> _reads, _writes;
+        std::vector<int> _next;  // systems waiting on this one
+        int              _deps = 0;
+    };
+
+    // The reference is good until the next add()
+    System& add(std::string name, Fn fn) {
+        _built = false;
+        _systems.emplace_back();
+        System& s = _systems.back();
+        s._name   = std::move(name);
+        s._fn     = std::move(fn);
+        return s;
+    }
+
+    // Also done by the first run() after an add()
+    void build() {
+        const int n = (int)_systems.size();
+        for (System& s : _systems) {
+            s._next.clear();
+            s._deps = 0;
+        }
+        int edges = 0, roots = 0;
+        for (int j = 0; j < n; j++)
+            for (int i = 0; i < j; i++)
+                if (_systems[i].conflicts(_systems[j])) {
+                    _systems[i]._next.push_back(j);
+                    _systems[j]._deps++;
+                    edges++;
+                }
+        for (const System& s : _systems) roots += s._deps == 0;
+        _waiting = std::make_unique<std::atomic<int>[]>(n);
+        _built   = true;
+        Log::info("SystemScheduler: " + std::to_string(n) + " systems, " + std::to_string(edges) +
+                  " dependencies, " + std::to_string(roots) + " free to start");
+    }
+
+    // Every system once, in dependency order; not reentrant
+    void run(float dt) {
+        if (!_built) build();
+        const int n = (int)_systems.size();
+        if (n == 0) return;
+        _dt = dt;
+        for (int i = 0; i < n; i++) _waiting[i].store(_systems[i]._deps, std::memory_order_relaxed);
+        _left.store(n, std::memory_order_relaxed);
+
+        int first = -1;
+        for (int i = 0; i < n; i++) {
+            if (_systems[i]._deps != 0) continue;
+            if (first < 0) first = i;
+            else           _pool.submit([this, i] { runFrom(i); }, ThreadPool::Priority::Urgent);
+        }
+        runFrom(first);
+
+        std::unique_lock lk(_doneMu);
+        _doneCv.wait(lk, [&] { return _left.load(std::memory_order_acquire) == 0; });
+    }
+
+    size_t size() const { return _systems.size(); }
+
+private:
+    // Runs i, then the first of its dependents it readied, and so on down
+    // the chain; the others it readied go to the pool
+    void runFrom(int i) {
+        while (i >= 0) {
+            System& s = _systems[i];
+            s._fn(_dt);
+            int next = -1;
+            for (int d : s._next) {
+                if (_waiting[d].fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+                if (next < 0) next = d;
+                else          _pool.submit([this, d] { runFrom(d); }, ThreadPool::Priority::Urgent);
+            }
+            if (_left.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard lk(_doneMu);
+                _doneCv.notify_one();
+            }
+            i = next;
+        }
+    }
+
+    ThreadPool&         _pool;
+    std::vector<System> _systems;
+    bool                _built = false;
+
+    float                               _dt = 0.f;
+    std::unique_ptr<std::atomic<int>[]> _waiting;
+    std::atomic<int>                    _left{0};
+    std::mutex                          _doneMu;
+    std::condition_variable             _doneCv;
+};
@@ -0,0 +1,179 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include "chunk.h"
+#include "config.h"
+#include "packets.h"
+
+// ── Terrain edits ─────────────────────────────────────────────────────────────
+// A spherical brush in whole blocks. Digging pushes density towards air,
+// filling towards solid, by strength at the centre falling off linearly to
+// nothing at the radius. The arithmetic is all integer, in the wire's
+// density units (see ChunkFieldPacket), so applying an edit and then
+// encoding the field gives the same bytes wherever it's done.
+//
+// A chunk's samples run from coord*SIZE to coord*SIZE + SIZE inclusive —
+// the last layer is the next chunk's first — so an edit on a chunk border
+// lands in both, and forEachEditedChunk visits both.
+struct TerrainEdit {
+    int     x = 0, y = 0, z = 0; // centre, world blocks
+    int     radius   = 1;        // blocks
+    int     strength = 0;        // wire density units at the centre, 0..127
+    bool    fill     = false;    // false digs
+    uint8_t material = 0;        // BlockMat for samples a fill turns solid
+};
+
+// Sample index bounds an edit changed within one chunk, inclusive; empty
+// until something is added
+struct EditBox {
+    int lo[3] = {ChunkData::PADDED, ChunkData::PADDED, ChunkData::PADDED};
+    int hi[3] = {-1, -1, -1};
+
+    bool empty() const { return hi[0] < lo[0]; }
+    void add(int x, int y, int z) {
+        const int v[3] = {x, y, z};
+        for (int a = 0; a < 3; a++) {
+            lo[a] = std::min(lo[a], v[a]);
+            hi[a] = std::max(hi[a], v[a]);
+        }
+    }
+    void add(const EditBox& o) {
+        if (o.empty()) return;
+        add(o.lo[0], o.lo[1], o.lo[2]);
+        add(o.hi[0], o.hi[1], o.hi[2]);
+    }
+};
+
+namespace TerrainEdits {
+
+inline int floorDiv(int a, int b) { return a / b - (a % b != 0 && (a < 0) != (b < 0)); }
+
+// f(coord) for every full-resolution chunk with a sample inside the brush's
+// bounding box
+template<class F>
+void forEachEditedChunk(const TerrainEdit& e, F&& f) {
+    constexpr int S = ChunkData::SIZE;
+    // Chunk c holds samples [c*S, c*S + S]
+    auto lo = [&](int v) { return floorDiv(v - e.radius + S - 1, S) - 1; };
+    auto hi = [&](int v) { return floorDiv(v + e.radius, S); };
+    for (int cx = lo(e.x); cx <= hi(e.x); cx++)
+        for (int cy = lo(e.y); cy <= hi(e.y); cy++)
+            for (int cz = lo(e.z); cz <= hi(e.z); cz++)
+                f(ChunkCoord{cx, cy, cz});
+}
+
+// What a uniform marker stands for, as samples to edit
+inline void expandUniform(ChunkData& d, ChunkCoord coord, ChunkData::Fill fill) {
+    d.coord = coord;
+    d.fill  = ChunkData::Fill::Mixed;
+    ChunkData::Voxel v{ChunkData::quantize(fill == ChunkData::Fill::Solid ? -ChunkData::DENSITY_MAX
+                                                                          : ChunkData::DENSITY_MAX),
+                       (uint8_t)BlockMat::Stone};
+    ChunkData::Voxel* p = &d.voxels[0][0][0];
+    std::fill(p, p + ChunkFieldPacket::VOXELS, v);
+}
+
+// Applies e to the chunk's samples; box grows by every sample that changed.
+// Returns whether any did.
+inline bool apply(ChunkData& d, const TerrainEdit& e, EditBox& box) {
+    constexpr int S = ChunkData::SIZE, P = ChunkData::PADDED;
+    const int ox = d.coord.x * S, oy = d.coord.y * S, oz = d.coord.z * S;
+    const int r  = std::max(1, e.radius), r2 = r * r;
+    auto range = [&](int c, int o, int& lo, int& hi) {
+        lo = std::max(0, c - r - o);
+        hi = std::min(P - 1, c + r - o);
+    };
+    int x0, x1, y0, y1, z0, z1;
+    range(e.x, ox, x0, x1);
+    range(e.y, oy, y0, y1);
+    range(e.z, oz, z0, z1);
+
+    bool changed = false;
+    for (int x = x0; x <= x1; x++)
+        for (int z = z0; z <= z1; z++)
+            for (int y = y0; y <= y1; y++) {
+                int dx = ox + x - e.x, dy = oy + y - e.y, dz = oz + z - e.z;
+                int dd = dx * dx + dy * dy + dz * dz;
+                if (dd > r2) continue;
+                int delta = e.strength * (r2 - dd) / r2;
+                if (delta == 0) continue;
+
+                ChunkData::Voxel& v = d.at(x, y, z);
+                int w  = ChunkFieldPacket::toWire(v.density);
+                int nw = e.fill ? std::max(-127, w - delta) : std::min(127, w + delta);
+                if (nw == w) continue;
+                if (e.fill && w >= 0 && nw < 0) v.material = e.material;
+                v.density = ChunkFieldPacket::fromWire((int8_t)nw);
+                box.add(x, y, z);
+                changed = true;
+            }
+    return changed;
+}
+
+// Air once nothing's left inside the surface, Mixed otherwise. A chunk
+// filled solid stays Mixed: its materials would be lost to a Solid marker.
+inline ChunkData::Fill classify(const ChunkData& d) {
+    const ChunkData::Voxel* p = &d.voxels[0][0][0];
+    for (size_t i = 0; i < ChunkFieldPacket::VOXELS; i++)
+        if (p[i].density < 0) return ChunkData::Fill::Mixed;
+    return ChunkData::Fill::Air;
+}
+
+} // namespace TerrainEdits
+
+// Client -> server: dig or fill around a point. The server checks reach
+// and size against the sender's position (EDIT_REACH, EDIT_RADIUS_MAX).
+//   u8 id | i32 x,y,z | u8 radius | u8 strength | u8 flags (bit 0: fill) | u8 material
+struct TerrainEditPacket {
+    TerrainEdit edit;
+
+    void write(PacketWriter& w) const {
+        w.begin((uint8_t)PacketID::TerrainEdit, 17)
+         .i32(edit.x).i32(edit.y).i32(edit.z)
+         .u8((uint8_t)edit.radius).u8((uint8_t)edit.strength)
+         .u8(edit.fill ? 1 : 0).u8(edit.material);
+    }
+
+    static bool deserialize(const uint8_t* d, size_t len, TerrainEditPacket& out) {
+        PacketReader r(d, len);
+        TerrainEdit e;
+        e.x = r.i32(); e.y = r.i32(); e.z = r.i32();
+        e.radius   = r.u8();
+        e.strength = r.u8();
+        e.fill     = r.u8() & 1;
+        e.material = r.u8();
+        if (!r.ok() || e.radius < 1 || e.radius > Config::EDIT_RADIUS_MAX || e.strength > 127 ||
+            e.material >= BLOCK_MAT_COUNT)
+            return false;
+        out.edit = e;
+        return true;
+    }
+};
+
+// Server -> client: a full-resolution chunk that has been edited, as a
+// ChunkField, ChunkData or ChunkUniform packet wrapped with the chunk's
+// edit version. Every send of an edited chunk goes out like this, first
+// delivery included, so a client can drop a decode that finishes after a
+// newer one for the same coord.
+//   u8 id | i32 cx,cy,cz | u32 version | chunk packet
+struct ChunkUpdatePacket {
+    static constexpr size_t HEADER_BYTES = 1 + 12 + 4;
+
+    static std::vector<uint8_t> wrap(ChunkCoord c, uint32_t version, const std::vector<uint8_t>& inner) {
+        PacketWriter w(HEADER_BYTES + inner.size());
+        w.begin((uint8_t)PacketID::ChunkUpdate).i32(c.x).i32(c.y).i32(c.z).u32(version)
+         .bytes(inner.data(), inner.size());
+        return w.toVector();
+    }
+
+    // The wrapped packet, or nullptr on malformed input
+    static const uint8_t* unwrap(const uint8_t* d, size_t len, ChunkCoord& c, uint32_t& version,
+                                 size_t& innerLen) {
+        PacketReader r(d, len);
+        c.x = r.i32(); c.y = r.i32(); c.z = r.i32();
+        version = r.u32();
+        if (!r.ok() || r.remaining() == 0) return nullptr;
+        innerLen = r.remaining();
+        return d + r.offset();
+    }
+};
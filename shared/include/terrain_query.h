@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunk.h"
+#include "config.h"
+#include "resident_chunk.h"
+
+// ── DensityField ──────────────────────────────────────────────────────────────
+// One chunk's density samples as the wire carries them — int8, in
+// ChunkFieldPacket::DENSITY_SCALE steps per unit — with no materials, and
+// only the near-surface ones stored (SparseColumns): a few KB against the
+// dense grid's 35 and a ChunkData's 140. A uniform chunk keeps only its
+// fill. What the server keeps resident for terrain queries, so a query
+// never needs a mesh.
+struct DensityField {
+    ChunkCoord            coord{0, 0, 0};
+    ChunkData::Fill       fill = ChunkData::Fill::Air;
+    SparseColumns<int8_t> density; // built when Mixed
+
+    int8_t at(int x, int y, int z) const { return density.at(x, y, z); }
+    size_t bytes() const { return sizeof(DensityField) + density.heapBytes(); }
+
+    static std::unique_ptr<DensityField> fromData(const ChunkData& data);
+    // A ChunkField or ChunkUniform payload; nullptr for anything else, or
+    // if it's malformed
+    static std::unique_ptr<DensityField> fromPayload(const uint8_t* d, size_t len);
+};
+
+struct TerrainHit {
+    bool      hit = false;
+    float     t   = 0.f;           // along the ray, in blocks
+    glm::vec3 pos{0.f};
+    glm::vec3 normal{0.f, 1.f, 0.f}; // out of the terrain
+};
+
+// ── TerrainQuery ──────────────────────────────────────────────────────────────
+// Collision against the density field itself, trilinear between samples —
+// the surface marching cubes meshes, to within a cell's interpolation — in
+// world blocks. Chunks come from a lookup; one the lookup doesn't have
+// reads as air, so a query near unloaded terrain errs towards letting
+// things through. Each call looks a chunk up once however many samples it
+// takes from it; uniform and missing chunks are skipped whole.
+//
+// Not thread-safe on its own: it's as safe as the lookup.
+class TerrainQuery {
+public:
+    // The chunk at coord, nullptr if there isn't one. The pointer only has
+    // to last until the query returns.
+    using Lookup = std::function<const DensityField*(ChunkCoord)>;
+
+    explicit TerrainQuery(Lookup lookup) : _lookup(std::move(lookup)) {}
+
+    // Density at p, in units; below 0 is inside the terrain
+    float sample(glm::vec3 p) const;
+    bool  solid(glm::vec3 p) const { return sample(p) < 0.f; }
+
+    // Unit gradient at p, pointing out of the terrain; up where it's flat
+    glm::vec3 normal(glm::vec3 p) const;
+
+    // First crossing into the terrain along dir (need not be unit length)
+    // within maxDist blocks, by sphere tracing: steps of the density over
+    // TERRAIN_RAY_LIPSCHITZ, then bisection once a step lands inside. A ray
+    // starting inside hits at t = 0.
+    TerrainHit raycast(glm::vec3 origin, glm::vec3 dir, float maxDist) const;
+
+    // Whether any point of the box is inside the terrain. Exact for the
+    // trilinear field: within a cell its minimum over a box is at the box's
+    // corners, so this samples the box's corners and every lattice plane
+    // that cuts it.
+    bool overlaps(glm::vec3 lo, glm::vec3 hi) const;
+
+private:
+    struct Walk;
+
+    Lookup _lookup;
+};
@@ -2,66 +2,566 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include <functional>
-#include <queue>
+#include <deque>
 #include <vector>
+#include <memory>
 #include <atomic>
+#include <new>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include <optional>
+#include <variant>
+#include <chrono>
+#include "mem_tags.h"
 
-// Lightweight thread pool — submit work, optionally drain on shutdown.
-// No futures, no exceptions, just fire-and-forget tasks.
+#if defined(__linux__)
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+// ── Task ──────────────────────────────────────────────────────────────────────
+// Move-only void() callable with inline storage, so the usual lambdas
+// (a this pointer plus a moved-in buffer or two) never touch the heap.
+// Larger or throwing-move callables fall back to one allocation.
+class Task {
+public:
+    static constexpr size_t INLINE_BYTES = 48;
+
+    Task() = default;
+
+    template<class F, class D = std::decay_t<F>,
+             class = std::enable_if_t<!std::is_same_v<D, Task>>>
+    Task(F&& fn) {
+        if constexpr (fitsInline<D>()) {
+            new (_buf) D(std::forward<F>(fn));
+            _ops = &inlineOps<D>;
+        } else {
+            *reinterpret_cast<D**>(_buf) = new D(std::forward<F>(fn));
+            _ops = &heapOps<D>;
+        }
+    }
+
+    Task(Task&& o) noexcept { moveFrom(o); }
+    Task& operator=(Task&& o) noexcept {
+        if (this != &o) { reset(); moveFrom(o); }
+        return *this;
+    }
+    Task(const Task&)            = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { reset(); }
+
+    explicit operator bool() const { return _ops != nullptr; }
+    void operator()() { _ops->invoke(_buf); }
+
+private:
+    struct Ops {
+        void (*invoke) (void*);
+        void (*relocate)(void* dst, void* src); // move-construct + destroy src
+        void (*destroy)(void*);
+    };
+
+    template<class D>
+    static constexpr bool fitsInline() {
+        return sizeof(D) <= INLINE_BYTES && alignof(D) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<D>;
+    }
+
+    template<class D>
+    static constexpr Ops inlineOps = {
+        [](void* p) { (*static_cast<D*>(p))(); },
+        [](void* dst, void* src) {
+            new (dst) D(std::move(*static_cast<D*>(src)));
+            static_cast<D*>(src)->~D();
+        },
+        [](void* p) { static_cast<D*>(p)->~D(); },
+    };
+
+    template<class D>
+    static constexpr Ops heapOps = {
+        [](void* p) { (**static_cast<D**>(p))(); },
+        [](void* dst, void* src) { *static_cast<D**>(dst) = *static_cast<D**>(src); },
+        [](void* p) { delete *static_cast<D**>(p); },
+    };
+
+    void moveFrom(Task& o) {
+        _ops = o._ops;
+        if (_ops) { _ops->relocate(_buf, o._buf); o._ops = nullptr; }
+    }
+    void reset() {
+        if (_ops) { _ops->destroy(_buf); _ops = nullptr; }
+    }
+
+    alignas(std::max_align_t) unsigned char _buf[INLINE_BYTES];
+    const Ops* _ops = nullptr;
+};
+
+enum class TaskPriority : int { Urgent = 0, Normal = 1, Background = 2 };
+
+// ── CancelToken ───────────────────────────────────────────────────────────────
+// Cooperative cancellation shared by everyone holding a copy. The pool checks
+// it before starting a task; long tasks may poll cancelled() themselves.
+// A default-constructed token can never be cancelled.
+class CancelToken {
+public:
+    static CancelToken make() {
+        CancelToken t;
+        t._flag = std::make_shared<std::atomic<bool>>(false);
+        return t;
+    }
+
+    void cancel()    const { if (_flag) _flag->store(true, std::memory_order_release); }
+    bool cancelled() const { return _flag && _flag->load(std::memory_order_acquire); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> _flag;
+};
+
+class ThreadPool;
+
+// ── TaskFuture ────────────────────────────────────────────────────────────────
+// Handle to a value some pool task will produce. Copies share one state.
+// A future ends either ready (get() is valid) or cancelled — there are no
+// exceptions to carry. Continuations attached with then() are submitted to a
+// pool when the value lands, so pipeline stages can run on different workers;
+// a cancelled future cancels everything chained after it.
+template<class T>
+class TaskFuture {
+public:
+    using Value = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+    TaskFuture() = default;
+
+    static TaskFuture make() {
+        TaskFuture f;
+        f._state = std::make_shared<State>();
+        return f;
+    }
+
+    // An already-resolved future, to start a chain from a known value
+    static TaskFuture fromValue(Value v) {
+        TaskFuture f = make();
+        f.set(std::move(v));
+        return f;
+    }
+
+    bool valid()     const { return (bool)_state; }
+    bool done()      const { return status() != Status::Pending; }
+    bool ready()     const { return status() == Status::Ready; }
+    bool cancelled() const { return status() == Status::Cancelled; }
+
+    // Blocks until done. Don't call from a worker of the pool that would
+    // resolve it unless that pool has other threads.
+    void wait() const {
+        std::unique_lock lk(_state->mu);
+        _state->cv.wait(lk, [&]{ return _state->status != Status::Pending; });
+    }
+
+    // Only after ready()
+    Value& get() const { return *_state->value; }
+
+    // ── Producer side ──
+    void set(Value v)     { complete(Status::Ready, std::move(v)); }
+    void setCancelled()   { complete(Status::Cancelled, std::nullopt); }
+
+    // fn(TaskFuture&) runs once this is done (ready or cancelled), inline on
+    // the completing thread — or right now if already done. Keep it short.
+    template<class F>
+    void onDone(F&& fn) {
+        std::unique_lock lk(_state->mu);
+        if (_state->status == Status::Pending) {
+            _state->continuations.push_back(
+                [self = *this, fn = std::forward<F>(fn)]() mutable { fn(self); });
+            return;
+        }
+        lk.unlock();
+        fn(*this);
+    }
+
+    // fn(T&) (or fn() for void) runs on pool once this is ready; its result
+    // resolves the returned future. Skipped, and the result cancelled, if
+    // this is cancelled or token is by the time the stage would start.
+    template<class F>
+    auto then(ThreadPool& pool, F&& fn, TaskPriority prio = TaskPriority::Normal,
+              CancelToken token = {});
+
+private:
+    enum class Status : uint8_t { Pending, Ready, Cancelled };
+
+    struct State {
+        std::mutex              mu;
+        std::condition_variable cv;
+        Status                  status = Status::Pending;
+        std::optional<Value>    value;
+        std::vector<Task>       continuations;
+    };
+
+    Status status() const {
+        std::lock_guard lk(_state->mu);
+        return _state->status;
+    }
+
+    void complete(Status st, std::optional<Value> v) {
+        std::vector<Task> conts;
+        {
+            std::lock_guard lk(_state->mu);
+            if (_state->status != Status::Pending) return;
+            _state->status = st;
+            _state->value  = std::move(v);
+            conts.swap(_state->continuations);
+        }
+        _state->cv.notify_all();
+        for (Task& c : conts) c();
+    }
+
+    std::shared_ptr<State> _state;
+};
+
+// Resolves once every input is done; cancelled if any input was.
+template<class T>
+TaskFuture<void> whenAll(std::vector<TaskFuture<T>> futures) {
+    TaskFuture<void> all = TaskFuture<void>::make();
+    if (futures.empty()) { all.set({}); return all; }
+
+    struct Join {
+        std::atomic<int>  left;
+        std::atomic<bool> anyCancelled{false};
+        explicit Join(int n) : left(n) {}
+    };
+    auto join = std::make_shared<Join>((int)futures.size());
+    for (auto& f : futures) {
+        f.onDone([join, all](TaskFuture<T>& done) mutable {
+            if (done.cancelled()) join->anyCancelled.store(true);
+            if (join->left.fetch_sub(1) != 1) return;
+            if (join->anyCancelled.load()) all.setCancelled();
+            else                           all.set({});
+        });
+    }
+    return all;
+}
+
+// ── ThreadPool ────────────────────────────────────────────────────────────────
+
+struct ThreadPoolOptions {
+    int minThreads = 1; // started up front, never retired
+    int maxThreads = 0; // grown on demand up to this; 0 → hardware_concurrency-1
+    // Workers are pinned off these cores (Linux only; ignored elsewhere or if
+    // it would leave no core at all) — e.g. the one the ENet thread runs on.
+    std::vector<int> avoidCpus;
+    // Workers' allocations are charged to this, Scopes aside
+    MemTags::Tag memTag = MemTags::Untagged;
+    // Each worker on one core of its own, round the allowed ones in order,
+    // so what it first touches stays on that core's node
+    bool pinEach = false;
+};
+
+// Work-stealing pool — submit work, drained on shutdown.
+// Tasks are fire-and-forget by default; async() returns a TaskFuture for
+// work that needs a result, a continuation or a cancel. No exceptions.
 // Used on server for chunk generation and on client for mesh building.
+//
+// Each worker owns a deque per priority lane behind its own small lock.
+// Tasks submitted from a worker go to that worker's deque; tasks from other
+// threads are dealt round-robin. A worker drains its own lane front-first and
+// steals from the back of other workers' deques, always trying every
+// worker's Urgent lane before anyone's Normal lane, and so on. Submitters and
+// workers only meet on the global lock when a worker has to sleep.
+//
+// The pool starts minThreads workers and adds one whenever a submit or a pop
+// finds every worker busy and more tasks queued than workers, up to maxThreads.
+// Idle workers park on the condition variable and cost nothing.
 class ThreadPool {
 public:
-    // nThreads=0 → use hardware_concurrency-1 (leave one core for main)
-    explicit ThreadPool(int nThreads = 0) {
-        int n = nThreads > 0 ? nThreads
-              : std::max(1, (int)std::thread::hardware_concurrency() - 1);
-        _workers.reserve(n);
-        for (int i = 0; i < n; i++)
-            _workers.emplace_back([this]{ workerLoop(); });
+    using Priority = TaskPriority;
+    static constexpr int LANES = 3;
+
+    // Fixed size. nThreads=0 → use hardware_concurrency-1 (leave one core for main)
+    explicit ThreadPool(int nThreads = 0, MemTags::Tag memTag = MemTags::Untagged)
+        : ThreadPool(ThreadPoolOptions{autoThreads(nThreads), autoThreads(nThreads), {}, memTag}) {}
+
+    explicit ThreadPool(const ThreadPoolOptions& opt)
+        : _avoidCpus(opt.avoidCpus), _pinEach(opt.pinEach), _memTag(opt.memTag)
+    {
+        _max = autoThreads(opt.maxThreads);
+        int start = std::clamp(opt.minThreads, 1, _max);
+        _queues.reserve(_max);
+        for (int i = 0; i < _max; i++)
+            _queues.push_back(std::make_unique<WorkerQueue>());
+        _workers.reserve(_max);
+        std::lock_guard lk(_spawnMu);
+        for (int i = 0; i < start; i++) spawnWorker();
     }
 
     ~ThreadPool() {
         {
-            std::lock_guard lk(_mu);
+            std::lock_guard lk(_sleepMu);
             _stop = true;
         }
         _cv.notify_all();
+        std::lock_guard lk(_spawnMu);
         for (auto& t : _workers) t.join();
     }
 
-    // Submit a task. Cheap — just a queue push.
-    void submit(std::function<void()> fn) {
-        {
-            std::lock_guard lk(_mu);
-            _queue.push(std::move(fn));
-        }
-        _cv.notify_one();
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Submit a task. Cheap — one uncontended per-worker lock in the common case.
+    void submit(Task fn, Priority prio = Priority::Normal) {
+        push(targetQueue(), std::move(fn), prio);
+        _pending.fetch_add(1);
+        wake(1);
+        maybeGrow();
     }
 
+    // Submit many tasks at once, spread over all workers.
+    void submitBatch(std::vector<Task>& tasks, Priority prio = Priority::Normal) {
+        if (tasks.empty()) return;
+        size_t n     = (size_t)_active.load();
+        size_t start = _next.fetch_add(tasks.size(), std::memory_order_relaxed);
+        for (size_t i = 0; i < tasks.size(); i++)
+            push((start + i) % n, std::move(tasks[i]), prio);
+        _pending.fetch_add((int)tasks.size());
+        wake((int)tasks.size());
+        maybeGrow();
+        tasks.clear();
+    }
+
+    // Run fn() on a worker and hand back its result. If token is cancelled
+    // before a worker starts it, fn never runs and the future is cancelled.
+    template<class F, class R = std::invoke_result_t<std::decay_t<F>&>>
+    TaskFuture<R> async(F&& fn, Priority prio = Priority::Normal, CancelToken token = {}) {
+        TaskFuture<R> out = TaskFuture<R>::make();
+        submit([fn = std::forward<F>(fn), token, out]() mutable {
+            if (token.cancelled()) { out.setCancelled(); return; }
+            if constexpr (std::is_void_v<R>) { fn(); out.set({}); }
+            else                             { out.set(fn()); }
+        }, prio);
+        return out;
+    }
+
+    // Queued, not yet started
     int pending() const {
-        std::lock_guard lk(_mu);
-        return (int)_queue.size();
+        return _pending.load(std::memory_order_relaxed);
+    }
+
+    int threadCount() const { return _active.load(); }
+    int maxThreads()  const { return _max; }
+
+    // Fraction of wall time each worker spent running tasks since the
+    // previous call (or since it started). One caller at a time.
+    std::vector<float> sampleUtilization() {
+        auto now = std::chrono::steady_clock::now();
+        int n = _active.load();
+        std::vector<float> out(n);
+        _lastBusyNs.resize(n, 0);
+        _lastSample.resize(n, {});
+        for (int i = 0; i < n; i++) {
+            uint64_t busy = _queues[i]->busyNs.load(std::memory_order_relaxed);
+            auto since = std::max(_lastSample[i], _queues[i]->started.load());
+            double wall = std::chrono::duration<double, std::nano>(now - since).count();
+            out[i] = wall > 0 ? (float)std::min(1.0, (busy - _lastBusyNs[i]) / wall) : 0.f;
+            _lastBusyNs[i] = busy;
+            _lastSample[i] = now;
+        }
+        return out;
+    }
+
+    // Pin the calling thread, or another, to one core (Linux only); false
+    // if unsupported
+    static bool pinCurrentThread(int cpu) {
+#if defined(__linux__)
+        return pin(pthread_self(), cpu);
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+    static bool pinThread(std::thread& t, int cpu) {
+#if defined(__linux__)
+        return t.joinable() && pin(t.native_handle(), cpu);
+#else
+        (void)t; (void)cpu;
+        return false;
+#endif
     }
 
 private:
-    void workerLoop() {
+#if defined(__linux__)
+    static bool pin(pthread_t t, int cpu) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(t, sizeof(set), &set) == 0;
+    }
+#endif
+
+    struct WorkerQueue {
+        std::mutex       mu;
+        std::deque<Task> lanes[LANES];
+
+        std::atomic<uint64_t> busyNs{0};
+        std::atomic<std::chrono::steady_clock::time_point> started{};
+    };
+
+    static int autoThreads(int n) {
+        return n > 0 ? n : std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    }
+
+    // Caller holds _spawnMu
+    void spawnWorker() {
+        int i = _active.load();
+        _queues[i]->started.store(std::chrono::steady_clock::now());
+        _workers.emplace_back([this, i]{ workerLoop(i); });
+        _active.store(i + 1);
+    }
+
+    // Every worker busy and the backlog still longer than the crew — add one.
+    void maybeGrow() {
+        int active = _active.load();
+        if (active >= _max || _sleepers.load() > 0 || _pending.load() <= active) return;
+        std::unique_lock lk(_spawnMu, std::try_to_lock);
+        if (!lk.owns_lock() || _stop || _active.load() != active) return;
+        spawnWorker();
+    }
+
+    size_t targetQueue() {
+        if (tl_pool == this) return (size_t)tl_index; // keep locality
+        return _next.fetch_add(1, std::memory_order_relaxed) % (size_t)_active.load();
+    }
+
+    void push(size_t q, Task&& fn, Priority prio) {
+        WorkerQueue& wq = *_queues[q];
+        std::lock_guard lk(wq.mu);
+        wq.lanes[(int)prio].push_back(std::move(fn));
+    }
+
+    // _pending/_sleepers are seq_cst: a submitter bumps _pending then reads
+    // _sleepers, a sleeper bumps _sleepers then reads _pending, so at least
+    // one of them sees the other.
+    void wake(int n) {
+        if (_sleepers.load() == 0) return;
+        // Taking the lock orders this notify after a sleeper's predicate check
+        { std::lock_guard lk(_sleepMu); }
+        if (n == 1) _cv.notify_one();
+        else        _cv.notify_all();
+    }
+
+    bool tryPop(int self, Task& out) {
+        int n = _active.load();
+        for (int lane = 0; lane < LANES; lane++) {
+            for (int k = 0; k < n; k++) {
+                int q = (self + k) % n;
+                WorkerQueue& wq = *_queues[q];
+                std::unique_lock lk(wq.mu, std::try_to_lock);
+                if (!lk.owns_lock()) {
+                    if (q != self) continue; // busy victim — try the next one
+                    lk.lock();
+                }
+                auto& dq = wq.lanes[lane];
+                if (dq.empty()) continue;
+                if (q == self) { out = std::move(dq.front()); dq.pop_front(); }
+                else           { out = std::move(dq.back());  dq.pop_back();  }
+                _pending.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void pinWorker(int self) {
+#if defined(__linux__)
+        if (_avoidCpus.empty() && !_pinEach) return;
+        int ncpu = std::min<int>((int)std::thread::hardware_concurrency(), CPU_SETSIZE);
+        std::vector<int> allowed;
+        for (int c = 0; c < ncpu; c++)
+            if (std::find(_avoidCpus.begin(), _avoidCpus.end(), c) == _avoidCpus.end()) allowed.push_back(c);
+        if (allowed.empty()) return;
+        if (_pinEach) {
+            pin(pthread_self(), allowed[(size_t)self % allowed.size()]);
+            return;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : allowed) CPU_SET(c, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)self;
+#endif
+    }
+
+    void workerLoop(int self) {
+        tl_pool  = this;
+        tl_index = self;
+        pinWorker(self);
+        MemTags::exchange(_memTag);
+        WorkerQueue& me = *_queues[self];
         while (true) {
-            std::function<void()> fn;
-            {
-                std::unique_lock lk(_mu);
-                _cv.wait(lk, [this]{ return _stop || !_queue.empty(); });
-                if (_stop && _queue.empty()) return;
-                fn = std::move(_queue.front());
-                _queue.pop();
+            Task fn;
+            if (tryPop(self, fn)) {
+                maybeGrow();
+                auto t0 = std::chrono::steady_clock::now();
+                fn();
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+                me.busyNs.fetch_add((uint64_t)ns, std::memory_order_relaxed);
+                continue;
             }
-            fn();
+
+            std::unique_lock lk(_sleepMu);
+            _sleepers.fetch_add(1);
+            _cv.wait(lk, [this]{ return _stop || _pending.load() > 0; });
+            _sleepers.fetch_sub(1);
+            if (_stop && _pending.load() == 0) return;
         }
     }
 
-    mutable std::mutex      _mu;
+    inline static thread_local ThreadPool* tl_pool  = nullptr;
+    inline static thread_local int         tl_index = 0;
+
+    // _queues is sized to _max up front so growing never moves a queue a
+    // worker is looking at; only the first _active are in use.
+    std::vector<std::unique_ptr<WorkerQueue>> _queues;
+    std::vector<std::thread>                  _workers;
+    std::vector<int>    _avoidCpus;
+    bool                _pinEach = false;
+    MemTags::Tag        _memTag;
+    int                 _max = 1;
+    std::atomic<int>    _active{0};
+    std::atomic<size_t> _next{0};
+    std::atomic<int>    _pending{0};
+    std::atomic<int>    _sleepers{0};
+
+    std::mutex              _spawnMu;
+    std::mutex              _sleepMu;
     std::condition_variable _cv;
-    std::queue<std::function<void()>> _queue;
-    std::vector<std::thread> _workers;
-    bool _stop = false;
+    std::atomic<bool> _stop{false};
+
+    // sampleUtilization() state
+    std::vector<uint64_t>                              _lastBusyNs;
+    std::vector<std::chrono::steady_clock::time_point> _lastSample;
 };
+
+template<class T>
+template<class F>
+auto TaskFuture<T>::then(ThreadPool& pool, F&& fn, TaskPriority prio, CancelToken token) {
+    using Fn = std::decay_t<F>;
+    using R  = typename std::conditional_t<std::is_void_v<T>,
+                   std::invoke_result<Fn&>, std::invoke_result<Fn&, Value&>>::type;
+
+    TaskFuture<R> next = TaskFuture<R>::make();
+    onDone([&pool, fn = std::forward<F>(fn), prio, token, next](TaskFuture& prev) mutable {
+        if (!prev.ready()) { next.setCancelled(); return; }
+        pool.submit([fn = std::move(fn), token, prev, next]() mutable {
+            if (token.cancelled()) { next.setCancelled(); return; }
+            if constexpr (std::is_void_v<T>) {
+                if constexpr (std::is_void_v<R>) { fn(); next.set({}); }
+                else                             { next.set(fn()); }
+            } else {
+                if constexpr (std::is_void_v<R>) { fn(prev.get()); next.set({}); }
+                else                             { next.set(fn(prev.get())); }
+            }
+        }, prio);
+    });
+    return next;
+}
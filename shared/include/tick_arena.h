@@ -0,0 +1,117 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// ── TickArena ─────────────────────────────────────────────────────────────────
+// Bump allocator for what lives only until the end of a loop iteration:
+// batches swapped out of a worker queue, lists built and walked in one go.
+// alloc() is a pointer bump; nothing is freed until reset(), which takes
+// everything back at once. The memory stays: a reset after an iteration
+// that spilled past the first block folds the blocks into one big enough
+// for all of it, so a steady load settles into one block and no heap use.
+//
+// One thread. Anything allocated here must be gone (or never touched
+// again) by the reset, destructors included — ArenaVector's run as usual,
+// and only give nothing back.
+class TickArena {
+public:
+    explicit TickArena(size_t blockBytes = 64 << 10) : _blockBytes(blockBytes) {}
+
+    TickArena(const TickArena&)            = delete;
+    TickArena& operator=(const TickArena&) = delete;
+    // Only while nothing points into it: allocators hold its address
+    TickArena(TickArena&&)            = default;
+    TickArena& operator=(TickArena&&) = default;
+
+    void* alloc(size_t n, size_t align = alignof(std::max_align_t)) {
+        for (;;) {
+            if (_block < _blocks.size()) {
+                Block&    b  = _blocks[_block];
+                uintptr_t at = ((uintptr_t)b.mem.get() + _used + (align - 1)) & ~(uintptr_t)(align - 1);
+                size_t    to = at - (uintptr_t)b.mem.get() + n;
+                if (to <= b.size) {
+                    _used = to;
+                    _peak = std::max(_peak, _spilled + _used);
+                    return (void*)at;
+                }
+                _spilled += b.size;
+                _block++;
+                _used = 0;
+                continue;
+            }
+            size_t size = std::max(_blockBytes, n + align);
+            _blocks.push_back({std::make_unique<std::byte[]>(size), size});
+        }
+    }
+
+    template<class T>
+    T* alloc(size_t count = 1) { return static_cast<T*>(alloc(count * sizeof(T), alignof(T))); }
+
+    void reset() {
+        if (_block > 0 || _blocks.size() > 1) {
+            size_t total = std::max(_peak, _blockBytes);
+            _blocks.clear();
+            _blocks.push_back({std::make_unique<std::byte[]>(total), total});
+        }
+        _block   = 0;
+        _used    = 0;
+        _spilled = 0;
+        _peak    = 0;
+    }
+
+    // Bytes held, used or not
+    size_t capacity() const {
+        size_t n = 0;
+        for (const Block& b : _blocks) n += b.size;
+        return n;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> mem;
+        size_t                       size;
+    };
+
+    size_t             _blockBytes;
+    std::vector<Block> _blocks;
+    size_t             _block   = 0; // the one being bumped
+    size_t             _used    = 0; // into it
+    size_t             _spilled = 0; // sizes of the blocks before it
+    size_t             _peak    = 0; // since the reset
+};
+
+// Standard allocator over a TickArena; with none, the heap, so a container
+// can take one optionally. Moving a container moves its arena with it, so
+// one can be started over on another arena by assigning it a fresh one.
+template<class T>
+struct ArenaAllocator {
+    using value_type                             = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    TickArena* arena = nullptr;
+
+    ArenaAllocator() = default;
+    explicit ArenaAllocator(TickArena* a) : arena(a) {}
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U>& o) : arena(o.arena) {}
+
+    T* allocate(size_t n) {
+        if (arena) return arena->alloc<T>(n);
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t) {
+        if (!arena) ::operator delete(p);
+    }
+
+    template<class U>
+    bool operator==(const ArenaAllocator<U>& o) const { return arena == o.arena; }
+};
+
+template<class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
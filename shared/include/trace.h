@@ -0,0 +1,156 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+#include "chunk.h"
+#include "log.h"
+
+// ── Chunk pipeline tracing ────────────────────────────────────────────────────
+// Spans for every stage a chunk goes through, from scheduleChunk on the
+// server to the first frame that draws it on the client, written as Chrome
+// trace-event JSON (chrome://tracing, ui.perfetto.dev). Off unless start()
+// is called; while off, every call is one relaxed load.
+//
+// A chunk's trace ID is its ChunkKey. Coord and level of detail are already
+// in every chunk packet's header, so both ends name the same trace without
+// stamping anything into payloads that are cached, shared between peers and
+// persisted. Re-sends of one key share an ID and are told apart by time.
+// Spans carry the ID as a flow (bind_id), so Perfetto links a chunk's stages
+// across threads — and across processes once both files are loaded as one:
+//   jq -s add aetheris_server_trace.json aetheris_client_trace.json > both.json
+// Timestamps are wall-clock microseconds so the two files line up.
+//
+// Events are buffered and appended to the file by flush() — call it every
+// second or so — in the JSON array form, which tolerates a missing closing
+// bracket, so a trace of a process that never exits cleanly still loads.
+namespace Trace {
+
+inline constexpr size_t EVENTS_MAX = 1 << 20; // buffered between flushes; past this they're dropped
+
+struct Event {
+    const char* name;   // string literal
+    uint64_t    id;     // idOf(key)
+    int64_t     ts;     // µs
+    int64_t     dur;    // µs
+    uint32_t    tid;
+};
+
+inline std::atomic<bool>  g_on{false};
+inline std::mutex         g_mu;
+inline std::vector<Event> g_events;
+inline FILE*              g_file    = nullptr;
+inline int                g_pid     = 0;
+inline uint64_t           g_dropped = 0;
+
+inline bool on() { return g_on.load(std::memory_order_relaxed); }
+
+inline int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// 20 bits per axis and 3 for the level: every coord the world can reach
+inline uint64_t idOf(const ChunkKey& k) {
+    auto axis = [](int v) { return (uint64_t)(uint32_t)v & 0xFFFFF; };
+    return axis(k.coord.x) << 43 | axis(k.coord.y) << 23 | axis(k.coord.z) << 3 | (uint64_t)(k.lod & 7);
+}
+
+inline ChunkKey keyOf(uint64_t id) {
+    auto axis = [](uint64_t v) { return (int)((int32_t)((uint32_t)(v & 0xFFFFF) << 12) >> 12); };
+    return {{axis(id >> 43), axis(id >> 23), axis(id >> 3)}, (int)(id & 7)};
+}
+
+// Small, stable per-thread numbers for the tid column
+inline uint32_t threadId() {
+    static std::atomic<uint32_t> next{1};
+    thread_local uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+inline void span(const char* name, const ChunkKey& key, int64_t t0, int64_t t1) {
+    if (!on()) return;
+    Event e{name, idOf(key), t0, t1 > t0 ? t1 - t0 : 0, threadId()};
+    std::lock_guard lk(g_mu);
+    if (g_events.size() < EVENTS_MAX) g_events.push_back(e);
+    else g_dropped++;
+}
+
+// A zero-length span: the moment a chunk passed a point
+inline void mark(const char* name, const ChunkKey& key) {
+    if (!on()) return;
+    int64_t t = nowUs();
+    span(name, key, t, t);
+}
+
+// Times its own scope. The key can be filled in before it ends, for stages
+// that only learn which chunk they handled as they go (decoding).
+class Span {
+public:
+    explicit Span(const char* name, const ChunkKey& key = {})
+        : key(key), _name(name), _t0(on() ? nowUs() : 0) {}
+    ~Span() { if (_t0) span(_name, key, _t0, nowUs()); }
+    Span(const Span&)            = delete;
+    Span& operator=(const Span&) = delete;
+
+    ChunkKey key;
+private:
+    const char* _name;
+    int64_t     _t0;
+};
+
+// Appends everything buffered since the last call. One thread only.
+inline void flush() {
+    std::vector<Event> events;
+    uint64_t dropped;
+    {
+        std::lock_guard lk(g_mu);
+        if (!g_file) return;
+        events.swap(g_events);
+        dropped   = g_dropped;
+        g_dropped = 0;
+    }
+    for (const Event& e : events) {
+        ChunkKey k = keyOf(e.id);
+        fprintf(g_file,
+                "%s{\"name\":\"%s\",\"cat\":\"chunk\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,"
+                "\"ts\":%" PRId64 ",\"dur\":%" PRId64 ",\"bind_id\":\"0x%" PRIx64 "\","
+                "\"flow_in\":true,\"flow_out\":true,\"args\":{\"chunk\":\"%d,%d,%d\",\"lod\":%d}}",
+                ",\n", e.name, g_pid, e.tid, e.ts, e.dur, e.id,
+                k.coord.x, k.coord.y, k.coord.z, k.lod);
+    }
+    fflush(g_file);
+    if (dropped) Log::warn("Trace: " + std::to_string(dropped) + " events dropped between flushes");
+}
+
+// pid tells the processes apart in a merged trace; process names its track
+inline bool start(const char* path, int pid, const char* process) {
+    std::lock_guard lk(g_mu);
+    if (g_file) return true;
+    g_file = fopen(path, "w");
+    if (!g_file) {
+        Log::err(std::string("Trace: cannot open ") + path);
+        return false;
+    }
+    g_pid = pid;
+    fprintf(g_file, "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s\"}}",
+            pid, process);
+    g_on = true;
+    Log::info(std::string("Tracing chunks to ") + path);
+    return true;
+}
+
+inline void stop() {
+    if (!on()) return;
+    g_on = false;
+    flush();
+    std::lock_guard lk(g_mu);
+    fprintf(g_file, "\n]\n");
+    fclose(g_file);
+    g_file = nullptr;
+}
+
+} // namespace Trace
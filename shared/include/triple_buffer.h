@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// ── TripleBuffer ──────────────────────────────────────────────────────────────
+// Hands the latest value from exactly one producer thread to exactly one
+// consumer thread; neither side ever takes a lock or waits for the other.
+// The producer fills back() and publish()es it; the consumer's fetch()
+// swaps in the newest published value, if there's one it hasn't seen, and
+// front() reads it. Values published faster than they're fetched are
+// skipped, not queued. back() is whatever slot comes free — two publishes
+// old, or never written — so the producer writes all of it each time.
+template<class T>
+class TripleBuffer {
+public:
+    // Producer side
+    T&   back() { return _slots[_back]; }
+    void publish() { _back = _middle.exchange(_back | FRESH, std::memory_order_acq_rel) & INDEX; }
+
+    // Consumer side
+    bool fetch() {
+        if (!(_middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        _front = _middle.exchange(_front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T& front() const { return _slots[_front]; }
+
+private:
+    static constexpr uint32_t INDEX = 3;
+    static constexpr uint32_t FRESH = 4; // published since the last fetch
+
+    T _slots[3]{};
+    // Apart, so the two threads don't bounce one cache line between them
+    alignas(64) uint32_t _back  = 0;
+    alignas(64) uint32_t _front = 1;
+    alignas(64) std::atomic<uint32_t> _middle{2};
+};
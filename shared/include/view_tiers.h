@@ -0,0 +1,91 @@
+#pragma once
+#include <algorithm>
+#include "chunk.h"
+#include "config.h"
+
+// Inclusive box of cells at one level of detail
+struct ViewBox {
+    ChunkCoord lo{0, 0, 0};
+    ChunkCoord hi{-1, -1, -1}; // empty
+
+    bool empty() const { return hi.x < lo.x; }
+    bool contains(ChunkCoord c) const {
+        return c.x >= lo.x && c.x <= hi.x && c.y >= lo.y && c.y <= hi.y &&
+               c.z >= lo.z && c.z <= hi.z;
+    }
+    bool operator==(const ViewBox&) const = default;
+
+    static ViewBox around(ChunkCoord c, int rxz, int ry) {
+        return {{c.x - rxz, c.y - ry, c.z - rxz}, {c.x + rxz, c.y + ry, c.z + rxz}};
+    }
+};
+
+// What a client is sent around the chunk it's in, agreed at login.
+//
+// With no LOD levels it's the box of r x ry chunks around the player, as it
+// always was. With LOD, Inner(l) is the box of h x hy cells around the
+// player's cell at level l (its chunk >> l). Level l is sent across the
+// children of Inner(l+1) — a box of 2(2h+1) x 2(2hy+1) cells, always
+// aligned to its parents — minus Inner(l), which the level below covers
+// instead. Since Inner(l) always lies inside the children of Inner(l+1),
+// the levels tile space without gaps or overlap, each ring twice as coarse
+// as the one inside it, and every level's region has a fixed size as the
+// player moves. Level 0 is the children of Inner(1), which contains the
+// plain r-box. The server and client run the same rules: the server to
+// decide what to send, the client to decide what to evict.
+struct ViewTiers {
+    int r      = Config::CHUNK_RADIUS_XZ;
+    int ry     = Config::CHUNK_RADIUS_Y;
+    int levels = 0; // LOD levels past full resolution
+
+    int h()  const { return (r + 1) / 2; }
+    int hy() const { return (ry + 1) / 2; }
+
+    // As far as the view is guaranteed to reach from the player's chunk, in
+    // chunks, with the given number of levels
+    int reach(int lv) const { return lv == 0 ? r : h() << (lv + 1); }
+
+    // radius: the view distance the client asked for, in chunks; lod:
+    // whether it takes LOD meshes at all
+    static ViewTiers negotiate(int radius, bool lod) {
+        ViewTiers t;
+        t.r = std::clamp(radius, 1, Config::CHUNK_RADIUS_XZ);
+        radius = std::min(radius, Config::VIEW_RADIUS_MAX);
+        if (lod)
+            while (t.levels < Config::LOD_LEVELS_MAX && t.reach(t.levels) < radius) t.levels++;
+        return t;
+    }
+
+    static ChunkCoord cellAt(ChunkCoord chunk, int lv) {
+        return {chunk.x >> lv, chunk.y >> lv, chunk.z >> lv};
+    }
+
+    // Cells at level lv sent around the player's chunk
+    ViewBox region(int lv, ChunkCoord center) const {
+        if (levels == 0) return ViewBox::around(center, r, ry);
+        ViewBox p = inner(lv + 1, center);
+        return {{p.lo.x * 2, p.lo.y * 2, p.lo.z * 2},
+                {p.hi.x * 2 + 1, p.hi.y * 2 + 1, p.hi.z * 2 + 1}};
+    }
+
+    // The part of region(lv) a finer level covers
+    ViewBox hole(int lv, ChunkCoord center) const {
+        return lv == 0 ? ViewBox{} : inner(lv, center);
+    }
+
+    bool wants(const ChunkKey& k, ChunkCoord center) const {
+        return k.lod <= levels && region(k.lod, center).contains(k.coord) &&
+               !hole(k.lod, center).contains(k.coord);
+    }
+
+    // Region size, for per-level bitsets
+    int width(int)  const { return levels == 0 ? 2 * r + 1  : 2 * (2 * h() + 1); }
+    int height(int) const { return levels == 0 ? 2 * ry + 1 : 2 * (2 * hy() + 1); }
+
+    bool operator==(const ViewTiers&) const = default;
+
+private:
+    ViewBox inner(int lv, ChunkCoord center) const {
+        return ViewBox::around(cellAt(center, lv), h(), hy());
+    }
+};
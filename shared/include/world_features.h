@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "chunk.h"
+
+// ── World features ────────────────────────────────────────────────────────────
+// What's placed into the terrain after the noise pass: ore veins and
+// (placeholder) structures. Every feature belongs to a cell of a fixed grid
+// and comes out of a random stream seeded by (WORLD_SEED, cell, layer)
+// alone, so any chunk can list the features that reach it — its own and its
+// neighbours' — without asking, or waiting for, any other chunk. A feature
+// crossing a chunk boundary is drawn by each side from the same origin.
+// Decoration is a function of position, like the noise: chunks (and slabs
+// of one) decorate in parallel, in any order, to the same bytes.
+namespace Features {
+
+// Folded into the generator's world id: bump when placement changes
+inline constexpr uint32_t VERSION = 1;
+
+struct Origin {
+    enum class Kind : uint8_t {
+        Coal,  // vein: a blob of ore in stone, at least its depth underground
+        Iron,
+        Spire, // stone column standing on the surface
+        Vault, // hollow room underground, flat-floored
+    };
+    Kind  kind;
+    float x, y, z; // centre; a spire's base
+    float radius;
+    float height;  // spires
+};
+
+// World-space box, in blocks
+struct Box {
+    float x0, y0, z0, x1, y1, z1;
+};
+
+// Every feature of the layers reaching into box, appended to out: the
+// neighbourhood query. Ores only when withOres.
+void near(const Box& box, bool withOres, std::vector<Origin>& out);
+
+// Whether a structure changes the density of anything in box — a chunk
+// that would otherwise be uniform isn't
+bool structureTouches(const Box& box);
+
+// The samples a chunk at coord and lod covers, edge to edge
+Box chunkBox(ChunkCoord coord, int lod);
+
+// Places every feature reaching padded rows x in [x0, x1) of a chunk whose
+// terrain those rows already hold. Writes only those rows.
+void decorateSlab(ChunkData& data, int lod, int x0, int x1);
+
+} // namespace Features
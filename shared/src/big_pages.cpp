@@ -0,0 +1,110 @@
+#include "big_pages.h"
+#include <atomic>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::atomic<uint8_t>  g_mode{(uint8_t)BigPages::Mode::Off};
+    std::atomic<bool>     g_local{false};
+    std::atomic<int64_t>  g_live{0};
+    std::atomic<uint64_t> g_hugetlb{0}, g_fallbacks{0};
+
+    constexpr size_t PAGE = 4096;
+
+    size_t roundUp(size_t n, size_t to) { return (n + to - 1) / to * to; }
+
+    bool wantsHuge(size_t bytes) {
+        return (BigPages::Mode)g_mode.load() != BigPages::Mode::Off && bytes >= BigPages::HUGE_BYTES;
+    }
+    // What map() takes for a request of bytes, so unmap() gives the same
+    // back without a header; the mode doesn't change once configured
+    size_t mappedSize(size_t bytes) { return roundUp(bytes, wantsHuge(bytes) ? BigPages::HUGE_BYTES : PAGE); }
+}
+
+BigPages::Mode BigPages::parse(const std::string& s) {
+    if (s == "thp")     return Mode::Advise;
+    if (s == "hugetlb") return Mode::Explicit;
+    return Mode::Off;
+}
+
+const char* BigPages::name(Mode m) {
+    switch (m) {
+    case Mode::Advise:   return "thp";
+    case Mode::Explicit: return "hugetlb";
+    default:             return "off";
+    }
+}
+
+void BigPages::configure(const Policy& p) {
+    g_mode.store((uint8_t)p.mode);
+    g_local.store(p.numaLocal);
+}
+
+BigPages::Policy BigPages::policy() { return {(Mode)g_mode.load(), g_local.load()}; }
+
+BigPages::Stats BigPages::stats() {
+    return {g_live.load(std::memory_order_relaxed), g_hugetlb.load(std::memory_order_relaxed),
+            g_fallbacks.load(std::memory_order_relaxed)};
+}
+
+#if defined(__linux__)
+void* BigPages::map(size_t bytes) {
+    size_t len = mappedSize(bytes);
+    void*  p   = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (wantsHuge(bytes) && (Mode)g_mode.load() == Mode::Explicit) {
+        p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        (p != MAP_FAILED ? g_hugetlb : g_fallbacks).fetch_add(1, std::memory_order_relaxed);
+    }
+#endif
+    if (p == MAP_FAILED) {
+        p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+        if (wantsHuge(bytes)) adviseHuge(p, len);
+    }
+#ifdef SYS_mbind
+    // Pages aren't placed until first touched, so this only says where
+    constexpr int MPOL_LOCAL_ = 4;
+    if (g_local.load()) syscall(SYS_mbind, p, len, MPOL_LOCAL_, nullptr, 0ul, 0u);
+#endif
+    g_live.fetch_add((int64_t)len, std::memory_order_relaxed);
+    return p;
+}
+
+void BigPages::unmap(void* p, size_t bytes) {
+    if (!p) return;
+    size_t len = mappedSize(bytes);
+    munmap(p, len);
+    g_live.fetch_sub((int64_t)len, std::memory_order_relaxed);
+}
+
+void BigPages::adviseHuge(void* p, size_t bytes) {
+#ifdef MADV_HUGEPAGE
+    if ((Mode)g_mode.load() != Mode::Off && bytes >= HUGE_BYTES) madvise(p, bytes, MADV_HUGEPAGE);
+#else
+    (void)p; (void)bytes;
+#endif
+}
+#else
+void* BigPages::map(size_t bytes) {
+    size_t len = roundUp(bytes, PAGE);
+    void*  p   = ::operator new(len, std::align_val_t{PAGE});
+    std::memset(p, 0, len);
+    g_live.fetch_add((int64_t)len, std::memory_order_relaxed);
+    return p;
+}
+
+void BigPages::unmap(void* p, size_t bytes) {
+    if (!p) return;
+    size_t len = roundUp(bytes, PAGE);
+    ::operator delete(p, len, std::align_val_t{PAGE});
+    g_live.fetch_sub((int64_t)len, std::memory_order_relaxed);
+}
+
+void BigPages::adviseHuge(void*, size_t) {}
+#endif
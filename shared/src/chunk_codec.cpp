@@ -0,0 +1,183 @@
+#include "chunk_codec.h"
+#include "config.h"
+#include "mp_packets.h"
+#include "packets.h"
+#include <algorithm>
+#include <cstring>
+#if defined(AETHERIS_ZSTD)
+#include <zdict.h>
+#include <zstd.h>
+#endif
+#if defined(AETHERIS_LZ4)
+#include <lz4.h>
+#endif
+
+static constexpr size_t LZ4_DICT_MAX = 64 << 10; // all the history LZ4 can reach
+
+bool ChunkCodecs::available(ChunkCodec c) {
+    switch (c) {
+#if defined(AETHERIS_ZSTD)
+        case ChunkCodec::Zstd: return true;
+#endif
+#if defined(AETHERIS_LZ4)
+        case ChunkCodec::Lz4: return true;
+#endif
+        default: return false;
+    }
+}
+
+uint32_t ChunkCodecs::cap(ChunkCodec c) {
+    switch (c) {
+        case ChunkCodec::Zstd: return CAP_CHUNK_ZSTD;
+        case ChunkCodec::Lz4:  return CAP_CHUNK_LZ4;
+        default:               return 0;
+    }
+}
+
+uint32_t ChunkCodecs::caps() {
+    return (available(ChunkCodec::Zstd) ? cap(ChunkCodec::Zstd) : 0) |
+           (available(ChunkCodec::Lz4) ? cap(ChunkCodec::Lz4) : 0);
+}
+
+ChunkCodec ChunkCodecs::parse(const std::string& name) {
+    if (name == "zstd") return ChunkCodec::Zstd;
+    if (name == "lz4")  return ChunkCodec::Lz4;
+    return ChunkCodec::None;
+}
+
+const char* ChunkCodecs::name(ChunkCodec c) {
+    switch (c) {
+        case ChunkCodec::Zstd: return "zstd";
+        case ChunkCodec::Lz4:  return "lz4";
+        default:               return "none";
+    }
+}
+
+// ── ChunkDict ─────────────────────────────────────────────────────────────────
+
+std::shared_ptr<const ChunkDict> ChunkDict::train(ChunkCodec codec,
+                                                  const std::vector<std::vector<uint8_t>>& samples,
+                                                  size_t maxBytes) {
+    if (!ChunkCodecs::available(codec) || samples.empty()) return nullptr;
+    if (codec == ChunkCodec::Lz4) maxBytes = std::min(maxBytes, LZ4_DICT_MAX);
+    std::vector<uint8_t> dict;
+#if defined(AETHERIS_ZSTD)
+    std::vector<uint8_t> all;
+    std::vector<size_t>  sizes;
+    for (const auto& s : samples) {
+        all.insert(all.end(), s.begin(), s.end());
+        sizes.push_back(s.size());
+    }
+    dict.resize(maxBytes);
+    size_t n = ZDICT_trainFromBuffer(dict.data(), dict.size(), all.data(), sizes.data(), (unsigned)sizes.size());
+    if (ZDICT_isError(n)) return nullptr;
+    dict.resize(n);
+#else
+    // Newest last, where LZ4 matches most cheaply: the tail of each sample
+    // in turn, up to maxBytes
+    size_t each = std::max<size_t>(maxBytes / samples.size(), 1);
+    for (const auto& s : samples) {
+        size_t take = std::min(each, s.size());
+        dict.insert(dict.end(), s.end() - (ptrdiff_t)take, s.end());
+    }
+    if (dict.size() > maxBytes) dict.erase(dict.begin(), dict.end() - (ptrdiff_t)maxBytes);
+#endif
+    return load(codec, std::move(dict));
+}
+
+std::shared_ptr<const ChunkDict> ChunkDict::load(ChunkCodec codec, std::vector<uint8_t> bytes) {
+    if (!ChunkCodecs::available(codec) || bytes.empty()) return nullptr;
+    std::shared_ptr<ChunkDict> d(new ChunkDict);
+    d->_codec = codec;
+    // Never 0, so "no dictionary" can't match one
+    d->_id    = (uint32_t)mixHash(payloadHash(bytes.data(), bytes.size())) | 1;
+    d->_bytes = std::move(bytes);
+    if (codec == ChunkCodec::Lz4 && d->_bytes.size() > LZ4_DICT_MAX)
+        d->_bytes.erase(d->_bytes.begin(), d->_bytes.end() - (ptrdiff_t)LZ4_DICT_MAX);
+#if defined(AETHERIS_ZSTD)
+    if (codec == ChunkCodec::Zstd) {
+        d->_cdict = ZSTD_createCDict(d->_bytes.data(), d->_bytes.size(), Config::CHUNK_ZSTD_LEVEL);
+        d->_ddict = ZSTD_createDDict(d->_bytes.data(), d->_bytes.size());
+        if (!d->_cdict || !d->_ddict) return nullptr;
+    }
+#endif
+    return d;
+}
+
+ChunkDict::~ChunkDict() {
+#if defined(AETHERIS_ZSTD)
+    ZSTD_freeCDict(static_cast<ZSTD_CDict*>(_cdict));
+    ZSTD_freeDDict(static_cast<ZSTD_DDict*>(_ddict));
+#endif
+}
+
+std::vector<uint8_t> ChunkDict::pack(const uint8_t* d, size_t len) const {
+    constexpr size_t H = ChunkPackedPacket::HEADER_BYTES;
+    std::vector<uint8_t> out;
+    if (len <= H || len > ChunkPackedPacket::RAW_MAX) return out;
+    size_t n = 0;
+    switch (_codec) {
+#if defined(AETHERIS_ZSTD)
+        case ChunkCodec::Zstd: {
+            // Contexts are per thread; the digested dictionary is shared
+            static thread_local std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx*)> cctx(ZSTD_createCCtx(),
+                                                                                      ZSTD_freeCCtx);
+            out.resize(H + ZSTD_compressBound(len));
+            n = ZSTD_compress_usingCDict(cctx.get(), out.data() + H, out.size() - H, d, len,
+                                         static_cast<const ZSTD_CDict*>(_cdict));
+            if (ZSTD_isError(n)) n = 0;
+            break;
+        }
+#endif
+#if defined(AETHERIS_LZ4)
+        case ChunkCodec::Lz4: {
+            static thread_local LZ4_stream_t stream;
+            LZ4_initStream(&stream, sizeof(stream));
+            LZ4_loadDict(&stream, (const char*)_bytes.data(), (int)_bytes.size());
+            out.resize(H + (size_t)LZ4_compressBound((int)len));
+            int r = LZ4_compress_fast_continue(&stream, (const char*)d, (char*)out.data() + H, (int)len,
+                                               (int)(out.size() - H), 1);
+            n = r > 0 ? (size_t)r : 0;
+            break;
+        }
+#endif
+        default: (void)d; break; // no codec built in
+    }
+    if (n == 0 || H + n >= len) return {};
+    out.resize(H + n);
+    uint8_t* p = out.data();
+    p = putU8(p, (uint8_t)PacketID::ChunkPacked);
+    p = putU8(p, (uint8_t)_codec);
+    p = putU32(p, _id);
+    putU32(p, (uint32_t)len);
+    return out;
+}
+
+bool ChunkDict::unpack(const uint8_t* d, size_t len, std::vector<uint8_t>& out) const {
+    constexpr size_t H = ChunkPackedPacket::HEADER_BYTES;
+    if (len <= H || d[0] != (uint8_t)PacketID::ChunkPacked || d[1] != (uint8_t)_codec) return false;
+    size_t   o      = 2;
+    uint32_t id     = readU32(d, o);
+    uint32_t rawLen = readU32(d, o);
+    if (id != _id || rawLen == 0 || rawLen > ChunkPackedPacket::RAW_MAX) return false;
+    out.resize(rawLen);
+    switch (_codec) {
+#if defined(AETHERIS_ZSTD)
+        case ChunkCodec::Zstd: {
+            static thread_local std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx*)> dctx(ZSTD_createDCtx(),
+                                                                                      ZSTD_freeDCtx);
+            size_t n = ZSTD_decompress_usingDDict(dctx.get(), out.data(), rawLen, d + H, len - H,
+                                                  static_cast<const ZSTD_DDict*>(_ddict));
+            return !ZSTD_isError(n) && n == rawLen;
+        }
+#endif
+#if defined(AETHERIS_LZ4)
+        case ChunkCodec::Lz4: {
+            int n = LZ4_decompress_safe_usingDict((const char*)d + H, (char*)out.data(), (int)(len - H),
+                                                  (int)rawLen, (const char*)_bytes.data(), (int)_bytes.size());
+            return n == (int)rawLen;
+        }
+#endif
+        default: return false;
+    }
+}
@@ -108,3 +108,13 @@ GltfModel loadGlb(const char* path) {
         Log::warn(std::string("GLB has no usable meshes: ") + path);
     return out;
 }
+
+GltfMesh mergeMeshes(const GltfModel& model) {
+    GltfMesh out;
+    for (auto& m : model.meshes) {
+        uint32_t base = (uint32_t)out.vertices.size();
+        out.vertices.insert(out.vertices.end(), m.vertices.begin(), m.vertices.end());
+        for (auto i : m.indices) out.indices.push_back(base + i);
+    }
+    return out;
+}
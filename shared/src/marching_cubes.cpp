@@ -1,9 +1,15 @@
 #include "marching_cubes.h"
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <memory>
+#include <vector>
+#include <cstdint>
 #include <glm/geometric.hpp>
 #include <glm/vec3.hpp>
+#include "big_pages.h"
 
-static const int edgeTable[256] = {
+static constexpr uint16_t edgeTable[256] = {
     0x000, 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c, 0x80c, 0x905, 0xa0f,
     0xb06, 0xc0a, 0xd03, 0xe09, 0xf00, 0x190, 0x099, 0x393, 0x29a, 0x596, 0x49f,
     0x795, 0x69c, 0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90, 0x230,
@@ -29,7 +35,7 @@ static const int edgeTable[256] = {
     0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c, 0x70c, 0x605, 0x50f, 0x406, 0x30a,
     0x203, 0x109, 0x000};
 
-static const int triTable[256][16] = {
+static constexpr int8_t triTable[256][16] = {
     {-1},
     {0, 8, 3, -1},
     {0, 1, 9, -1},
@@ -287,126 +293,785 @@ static const int triTable[256][16] = {
     {0, 3, 8, -1},
     {-1}};
 
+const MarchTriTable& marchTriTable() { return triTable; }
+
+static Mesher g_mesher = Mesher::Cubes;
+
+Mesher defaultMesher()       { return g_mesher; }
+void   useMesher(Mesher m)   { g_mesher = m; }
+
+Mesher Meshers::parse(const std::string& name) {
+    return name == "nets" ? Mesher::Nets : Mesher::Cubes;
+}
+
+const char* Meshers::name(Mesher m) {
+    return m == Mesher::Nets ? "nets" : "cubes";
+}
+
 static const glm::ivec3 corners[8] = {
     {0,0,0},{1,0,0},{1,1,0},{0,1,0},
     {0,0,1},{1,0,1},{1,1,1},{0,1,1}
 };
-static const int edgePairs[12][2] = {
+static constexpr uint8_t edgePairs[12][2] = {
     {0,1},{1,2},{2,3},{3,0},
     {4,5},{5,6},{6,7},{7,4},
     {0,4},{1,5},{2,6},{3,7}
 };
 
-static glm::vec3 interp(float iso, glm::vec3 p0, float v0, glm::vec3 p1, float v1) {
-    return (std::abs(v0 - iso) < std::abs(v1 - iso)) ? p0 : p1;
+// ── Case tables ───────────────────────────────────────────────────────────────
+// triTable squeezed at compile time: per case, the edges the surface cuts and
+// the triangle count, with the triangles' edges back to back as bytes.
+// edgeTable is only kept to check the derived masks against.
+struct MarchCase {
+    uint16_t edges = 0;
+    uint8_t  triCount = 0;
+    uint8_t  tris[15] = {}; // triCount * 3 edge indices
+};
+
+static constexpr std::array<MarchCase, 256> buildCases() {
+    std::array<MarchCase, 256> cases{};
+    for (int i = 0; i < 256; i++) {
+        MarchCase& mc = cases[i];
+        int t = 0;
+        for (; triTable[i][t] != -1; t++) {
+            mc.tris[t] = (uint8_t)triTable[i][t];
+            mc.edges  |= (uint16_t)(1u << triTable[i][t]);
+        }
+        mc.triCount = (uint8_t)(t / 3);
+    }
+    return cases;
+}
+static constexpr std::array<MarchCase, 256> marchCases = buildCases();
+
+static constexpr bool casesMatchEdgeTable() {
+    for (int i = 0; i < 256; i++)
+        if (marchCases[i].edges != edgeTable[i]) return false;
+    return true;
+}
+static_assert(casesMatchEdgeTable(), "triTable and edgeTable disagree");
+
+// A cell's corners lie on four voxel columns, walked in y: 0 (x,z),
+// 1 (x+1,z), 2 (x+1,z+1), 3 (x,z+1). cornerColumn/cornerUp place each corner
+// on them; lowerBits/upperBits map a 4-bit "inside" mask of one column layer
+// to the cube-index bits it supplies as the cell's bottom or top face, so
+// each layer is classified once and reused by the cell above.
+static constexpr uint8_t cornerColumn[8] = {0, 1, 1, 0, 3, 2, 2, 3};
+static constexpr uint8_t cornerUp[8]     = {0, 0, 1, 1, 0, 0, 1, 1};
+
+static constexpr std::array<uint8_t, 16> layerBits(int up) {
+    std::array<uint8_t, 16> bits{};
+    for (int m = 0; m < 16; m++)
+        for (int c = 0; c < 8; c++)
+            if (cornerUp[c] == up && (m >> cornerColumn[c] & 1)) bits[m] |= (uint8_t)(1u << c);
+    return bits;
+}
+static constexpr std::array<uint8_t, 16> lowerBits = layerBits(0);
+static constexpr std::array<uint8_t, 16> upperBits = layerBits(1);
+
+// The surface vertex on an edge snaps to whichever end is nearer the iso
+// level, so every vertex sits on a grid corner — that's what lets the corner
+// cache below weld across cells.
+static int nearerCorner(float iso, int a, float va, int b, float vb) {
+    return (std::abs(va - iso) < std::abs(vb - iso)) ? a : b;
 }
 
 // Pick material from the "inside" corner (the one with lowest density value)
-static uint8_t pickMat(float iso,
-                        const float vals[8], const uint8_t mats[8],
-                        int a, int b)
-{
+static uint8_t pickMat(const float vals[8], const uint8_t mats[8], int a, int b) {
     // Prefer the corner that is more solidly inside (most negative = most solid)
     return (vals[a] < vals[b]) ? mats[a] : mats[b];
 }
 
-ChunkMesh marchChunk(const ChunkData& chunk) {
-    ChunkMesh mesh;
-    mesh.coord = chunk.coord;
+// Field gradient at a grid corner — central differences, one-sided at the
+// padded border. Points from solid (negative) toward air, i.e. the opposite
+// way to the triTable winding's face normals.
+static glm::vec3 cornerGradient(const ChunkData& c, int x, int y, int z) {
+    constexpr int N = ChunkData::SIZE;
+    int x0 = x > 0 ? x - 1 : x, x1 = x < N ? x + 1 : x;
+    int y0 = y > 0 ? y - 1 : y, y1 = y < N ? y + 1 : y;
+    int z0 = z > 0 ? z - 1 : z, z1 = z < N ? z + 1 : z;
+    auto d = [&](int i, int j, int k) { return (float)c.at(i, j, k).density; };
+    return { (d(x1, y, z) - d(x0, y, z)) / (float)(x1 - x0),
+             (d(x, y1, z) - d(x, y0, z)) / (float)(y1 - y0),
+             (d(x, y, z1) - d(x, y, z0)) / (float)(z1 - z0) };
+}
+
+// ── Corner cache ──────────────────────────────────────────────────────────────
+// Vertices already emitted at each grid corner, for the two z layers the
+// current row of cells touches (the classic 2-slice table, keyed by corner
+// rather than edge because of the snapping above). Each slot heads a short
+// chain of variants that differ by normal/material; in smooth mode there's at
+// most one per material.
+namespace {
+struct CornerCache {
+    static constexpr int P    = ChunkData::PADDED;
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Link { uint32_t vertex, next; };
 
-    constexpr int   N   = ChunkData::SIZE;
+    uint32_t          heads[2][P][P];
+    std::vector<Link> links;
+
+    void clearLayer(int z) {
+        auto& layer = heads[z & 1];
+        for (auto& row : layer) for (auto& h : row) h = NONE;
+    }
+
+    uint32_t find(const ChunkMesh& mesh, glm::ivec3 c, glm::vec3 n, uint32_t m) const {
+        for (uint32_t l = heads[c.z & 1][c.y][c.x]; l != NONE; l = links[l].next) {
+            const Vertex& v = mesh.vertices[links[l].vertex];
+            if (v.material == m && v.normal == n) return links[l].vertex;
+        }
+        return NONE;
+    }
+
+    void add(glm::ivec3 c, uint32_t vertex) {
+        uint32_t& h = heads[c.z & 1][c.y][c.x];
+        links.push_back({vertex, h});
+        h = (uint32_t)links.size() - 1;
+    }
+};
+} // namespace
+
+// ── Skirts ────────────────────────────────────────────────────────────────────
+// Edges with both ends on the same x or z face of the chunk that only one
+// triangle uses (two triangles meeting in the face share theirs) each get a
+// quad hanging `depth` cells below them, wound to face out of the chunk.
+// Vertices sit on grid corners, so edges are matched by corner, not index —
+// faceted welding gives one corner several vertices.
+
+// byVertex: match edges by vertex instead, for meshes (nets) whose
+// vertices aren't on corners but are one per position anyway
+static void addSkirts(ChunkMesh& mesh, float depth, bool byVertex = false) {
+    constexpr float N = (float)ChunkData::SIZE;
+    struct Edge { uint32_t lo, hi, a, b; int face; };
+    std::vector<Edge> edges;
+
+    auto faceOf = [&](const glm::vec3& p, const glm::vec3& q) -> int {
+        if (p.x == 0.f && q.x == 0.f) return 0;
+        if (p.x == N   && q.x == N)   return 1;
+        if (p.z == 0.f && q.z == 0.f) return 2;
+        if (p.z == N   && q.z == N)   return 3;
+        return -1;
+    };
+    auto cornerId = [](const glm::vec3& p) {
+        return (uint32_t)p.x << 12 | (uint32_t)p.y << 6 | (uint32_t)p.z;
+    };
+    size_t indexCount = mesh.indices.size();
+    for (size_t t = 0; t < indexCount; t += 3)
+        for (int e = 0; e < 3; e++) {
+            uint32_t a = mesh.indices[t + e], b = mesh.indices[t + (e + 1) % 3];
+            const glm::vec3& pa = mesh.vertices[a].pos;
+            const glm::vec3& pb = mesh.vertices[b].pos;
+            int face = faceOf(pa, pb);
+            if (face < 0) continue;
+            uint32_t ca = byVertex ? a : cornerId(pa), cb = byVertex ? b : cornerId(pb);
+            edges.push_back({std::min(ca, cb), std::max(ca, cb), a, b, face});
+        }
+    std::sort(edges.begin(), edges.end(), [](const Edge& x, const Edge& y) {
+        return x.lo != y.lo ? x.lo < y.lo : x.hi < y.hi;
+    });
+
+    static const glm::vec3 outward[4] = {{-1, 0, 0}, {1, 0, 0}, {0, 0, -1}, {0, 0, 1}};
+    for (size_t i = 0; i < edges.size(); ) {
+        size_t j = i + 1;
+        while (j < edges.size() && edges[j].lo == edges[i].lo && edges[j].hi == edges[i].hi) j++;
+        if (j - i == 1) {
+            uint32_t a = edges[i].a, b = edges[i].b;
+            Vertex va = mesh.vertices[a], vb = mesh.vertices[b];
+            va.pos.y = std::max(0.f, va.pos.y - depth);
+            vb.pos.y = std::max(0.f, vb.pos.y - depth);
+            glm::vec3 pa = mesh.vertices[a].pos, pb = mesh.vertices[b].pos;
+            if (glm::dot(glm::cross(pb - pa, vb.pos - pa), outward[edges[i].face]) < 0.f) {
+                std::swap(a, b);
+                std::swap(va, vb);
+            }
+            va.uv = terrainUV(va.pos, va.normal);
+            vb.uv = terrainUV(vb.pos, vb.normal);
+            uint32_t ia = (uint32_t)mesh.vertices.size(), ib = ia + 1;
+            mesh.vertices.push_back(va);
+            mesh.vertices.push_back(vb);
+            mesh.indices.insert(mesh.indices.end(), {a, b, ib, a, ib, ia});
+        }
+        i = j;
+    }
+}
+
+// Cells z in [z0, z1), appended to mesh. Corners welded through the cache
+// only within the range; stitchSlabs welds across ranges.
+static void marchRange(const ChunkData& chunk, ChunkMesh& mesh, const MarchOptions& opts,
+                       int z0, int z1) {
     constexpr float iso = 0.0f;
 
-    for (int z = 0; z < N; z++)
-    for (int y = 0; y < N; y++)
-    for (int x = 0; x < N; x++) {
-        float    vals[8];
-        uint8_t  mats[8];
-        glm::vec3 pos[8];
-
-        for (int c = 0; c < 8; c++) {
-            int cx = x + corners[c].x;
-            int cy = y + corners[c].y;
-            int cz = z + corners[c].z;
-            vals[c] = chunk.values   [cx][cy][cz];
-            mats[c] = chunk.materials[cx][cy][cz];
-            pos[c]  = glm::vec3(cx, cy, cz);
+    // One per thread, reused — it's the biggest allocation in here
+    static thread_local std::unique_ptr<CornerCache> tlCache;
+    if (!tlCache) tlCache = std::make_unique<CornerCache>();
+    CornerCache* cache = tlCache.get();
+    cache->links.clear();
+    cache->clearLayer(z0);
+
+    auto emit = [&](glm::ivec3 c, glm::vec3 faceNormal, uint8_t m) -> uint32_t {
+        glm::vec3 normal = faceNormal;
+        if (opts.smoothNormals) {
+            glm::vec3 g = cornerGradient(chunk, c.x, c.y, c.z);
+            if (glm::dot(g, g) > 1e-12f) normal = -glm::normalize(g);
         }
 
-        int cubeIndex = 0;
-        for (int c = 0; c < 8; c++)
-            if (vals[c] < iso) cubeIndex |= (1 << c);
+        // For grass: top faces (normal.y > 0.7) → grass, sides → dirt
+        if (m == (uint8_t)BlockMat::Grass && normal.y < 0.5f)
+            m = (uint8_t)BlockMat::Dirt; // side face of grass surface
+
+        uint32_t idx = cache->find(mesh, c, normal, m);
+        if (idx != CornerCache::NONE) return idx;
+
+        glm::vec3 p((float)c.x, (float)c.y, (float)c.z);
+        idx = (uint32_t)mesh.vertices.size();
+        mesh.vertices.push_back({p, normal, terrainUV(p, normal), (uint32_t)m});
+        cache->add(c, idx);
+        return idx;
+    };
+
+    constexpr int N = ChunkData::SIZE;
+    for (int z = z0; z < z1; z++) {
+        cache->clearLayer(z + 1); // recycles the slice two layers back
+
+        // y innermost, matching the voxel layout
+        for (int x = 0; x < N; x++) {
+            const ChunkData::Voxel* col[4] = {chunk.voxels[x][z], chunk.voxels[x + 1][z],
+                                              chunk.voxels[x + 1][z + 1], chunk.voxels[x][z + 1]};
+            auto inside = [&](int y) {
+                return (unsigned)(col[0][y].density < 0)      | (unsigned)(col[1][y].density < 0) << 1 |
+                       (unsigned)(col[2][y].density < 0) << 2 | (unsigned)(col[3][y].density < 0) << 3;
+            };
 
-        if (edgeTable[cubeIndex] == 0) continue;
+            unsigned below = inside(0);
+            for (int y = 0; y < N; y++) {
+                unsigned above = inside(y + 1);
+                const MarchCase& mc = marchCases[lowerBits[below] | upperBits[above]];
+                below = above;
+                if (mc.triCount == 0) continue;
 
-        glm::vec3 edgeVerts[12];
-        uint8_t   edgeMats[12];
+                // Raw fixed-point densities: every test below is a sign or a
+                // ratio, so the scale doesn't matter
+                float    vals[8];
+                uint8_t  mats[8];
 
-        for (int e = 0; e < 12; e++) {
-            if (edgeTable[cubeIndex] & (1 << e)) {
-                int a = edgePairs[e][0], b = edgePairs[e][1];
-                edgeVerts[e] = interp(iso, pos[a], vals[a], pos[b], vals[b]);
-                edgeMats[e]  = pickMat(iso, vals, mats, a, b);
+                for (int c = 0; c < 8; c++) {
+                    const ChunkData::Voxel& v = col[cornerColumn[c]][y + cornerUp[c]];
+                    vals[c] = (float)v.density;
+                    mats[c] = v.material;
+                }
+
+                glm::ivec3 edgeCorner[12];
+                uint8_t    edgeMats[12];
+
+                for (unsigned m = mc.edges; m; m &= m - 1) {
+                    int e = std::countr_zero(m);
+                    int a = edgePairs[e][0], b = edgePairs[e][1];
+                    int c = nearerCorner(iso, a, vals[a], b, vals[b]);
+                    edgeCorner[e] = {x + corners[c].x, y + corners[c].y, z + corners[c].z};
+                    edgeMats[e]   = pickMat(vals, mats, a, b);
+                }
+
+                for (int t = 0; t < mc.triCount * 3; t += 3) {
+                    int e0 = mc.tris[t];
+                    int e1 = mc.tris[t+1];
+                    int e2 = mc.tris[t+2];
+
+                    auto toVec = [](glm::ivec3 c) { return glm::vec3((float)c.x, (float)c.y, (float)c.z); };
+                    glm::vec3 v0 = toVec(edgeCorner[e0]);
+                    glm::vec3 v1 = toVec(edgeCorner[e1]);
+                    glm::vec3 v2 = toVec(edgeCorner[e2]);
+
+                    glm::vec3 cr = glm::cross(v1 - v0, v2 - v0);
+                    if (glm::dot(cr, cr) < 1e-10f) continue;
+                    glm::vec3 normal = glm::normalize(cr);
+
+                    // Faceted: the dominant "inside" material for the whole
+                    // triangle, from its first edge. Smooth: each vertex keeps its
+                    // own edge's material, so a welded corner doesn't depend on
+                    // which triangle reached it first.
+                    uint8_t m0 = edgeMats[e0];
+                    uint8_t m1 = opts.smoothNormals ? edgeMats[e1] : m0;
+                    uint8_t m2 = opts.smoothNormals ? edgeMats[e2] : m0;
+
+                    mesh.indices.push_back(emit(edgeCorner[e0], normal, m0));
+                    mesh.indices.push_back(emit(edgeCorner[e1], normal, m1));
+                    mesh.indices.push_back(emit(edgeCorner[e2], normal, m2));
+                }
             }
         }
+    }
 
-        for (int t = 0; triTable[cubeIndex][t] != -1; t += 3) {
-            int e0 = triTable[cubeIndex][t];
-            int e1 = triTable[cubeIndex][t+1];
-            int e2 = triTable[cubeIndex][t+2];
-
-            glm::vec3 v0 = edgeVerts[e0];
-            glm::vec3 v1 = edgeVerts[e1];
-            glm::vec3 v2 = edgeVerts[e2];
-
-            glm::vec3 cr = glm::cross(v1 - v0, v2 - v0);
-            if (glm::dot(cr, cr) < 1e-10f) continue;
-            glm::vec3 normal = glm::normalize(cr);
-
-            // Use the dominant "inside" material for this triangle
-            // Prefer material from the most-inside corner of the tri's edges
-            uint8_t mat = edgeMats[e0];
-
-            // Triplanar UV — tile at 1 unit, then remap into atlas column
-      auto makeVertex = [&](glm::vec3 p, uint8_t m) -> Vertex {
-    constexpr float TW = 64.f / 256.f;
-    constexpr float TH = 64.f / 256.f;
-    constexpr float COL_OFFSETS[] = { 0.0f, 0.25f, 0.5f, 0.75f };
-    constexpr float SCALE = 0.25f; // lower = more tiles = "zoomed out"
-
-    glm::vec3 an = glm::abs(normal);
-    glm::vec2 localUV;
-    if (an.x > an.y && an.x > an.z)
-        localUV = {p.z, p.y};
-    else if (an.y > an.z)
-        localUV = {p.x, p.z};
-    else
-        localUV = {p.x, p.y};
-
-    float u = std::fmod(std::abs(localUV.x) * SCALE, 1.0f);
-    float v = std::fmod(std::abs(localUV.y) * SCALE, 1.0f);
-
-    float uOff = (m < 4) ? COL_OFFSETS[m] : 0.f;
-    glm::vec2 uv{ uOff + u * TW, v * TH };
-    return {p, normal, uv, (uint32_t)m};
+}
+
+// ── Surface nets ──────────────────────────────────────────────────────────────
+// One vertex per cell the surface passes through, at the mean of where it
+// cuts the cell's edges (interpolated, not snapped), and one quad per
+// sign-changing sample edge joining the four cells around it, already
+// indexed. Every vertex is shared by the quads around it.
+//
+// A chunk has no samples past its own, so the cells around an edge on its
+// boundary are partly outside it. Those stand in collapsed onto the
+// boundary: a cell index of -1 or SIZE along an axis is the face (or edge)
+// of sample 0 or SIZE there, its vertex the mean of the cuts on it alone.
+// The neighbour finds the same cuts from the same shared samples, so the
+// two halves of every seam quad meet exactly.
+//
+// That alone is about two triangles per cell the surface crosses, more
+// than marching cubes' snapped ones, which collapse wherever a corner takes
+// several. So flat stretches are then coarsened, as adaptive dual
+// contouring does: a block of 2, 4 or NET_BLOCK_MAX cells a side whose
+// vertices all lie within NET_FLAT_DIST of one plane, face within
+// NET_FLAT_COS of its normal and share a material is drawn as one vertex,
+// and the quads inside it fall away. A block is only tried once each of its
+// eight halves has come out whole. Quads are kept, merely reindexed, so the
+// mesh stays closed; collapsed cells are never in a block, so the seams
+// don't move.
+
+namespace {
+struct NetCell {
+    static constexpr int      SPAN = ChunkData::SIZE + 2; // cell indices -1..SIZE
+    static constexpr uint32_t NONE = UINT32_MAX;
+    uint32_t vertex[SPAN][SPAN][SPAN];
 };
+} // namespace
+
+static constexpr int   NET_BLOCK_MAX = 8;
+static constexpr float NET_FLAT_DIST = 0.1f;  // cells
+static constexpr float NET_FLAT_COS  = 0.95f;
 
-            // For grass: top faces (normal.y > 0.7) → grass, sides → dirt
-            uint8_t matV0 = mat, matV1 = mat, matV2 = mat;
-            if (mat == (uint8_t)BlockMat::Grass && normal.y < 0.5f) {
-                // Side face of grass surface — use dirt
-                matV0 = matV1 = matV2 = (uint8_t)BlockMat::Dirt;
+// Counting sort of the positions in keys by their key, those keyed NONE
+// left out: bucket k is out[at[k], at[k + 1])
+static void bucketBy(const std::vector<uint32_t>& keys, size_t buckets, std::vector<uint32_t>& at,
+                     std::vector<uint32_t>& out) {
+    at.assign(buckets + 1, 0);
+    for (uint32_t k : keys)
+        if (k != UINT32_MAX) at[k + 1]++;
+    for (size_t k = 0; k < buckets; k++) at[k + 1] += at[k];
+    out.resize(at[buckets]);
+    for (size_t i = 0; i < keys.size(); i++)
+        if (keys[i] != UINT32_MAX) out[at[keys[i]]++] = (uint32_t)i;
+    for (size_t k = buckets; k > 0; k--) at[k] = at[k - 1];
+    at[0] = 0;
+}
+
+// Quad q's corners as drawn, repeats squashed: 4 a quad, 3 a triangle, and
+// 0 when fewer than three are left or it's folded over its diagonal
+template<class Drawn>
+static int netPolygon(const uint32_t* q, Drawn&& drawn, uint32_t v[4]) {
+    int n = 0;
+    for (int j = 0; j < 4; j++) {
+        uint32_t d = drawn(q[j]);
+        if (n == 0 || v[n - 1] != d) v[n++] = d;
+    }
+    if (n > 1 && v[n - 1] == v[0]) n--;
+    if (n < 3 || (n == 4 && (v[0] == v[2] || v[1] == v[3]))) return 0;
+    return n;
+}
+
+static void netsRange(const ChunkData& chunk, ChunkMesh& mesh) {
+    constexpr int N = ChunkData::SIZE;
+    static thread_local BigPages::Ptr<NetCell> tlCells; // on the worker's node, under numaLocal
+    if (!tlCells) tlCells = BigPages::make<NetCell>();
+    NetCell& cells = *tlCells;
+    std::fill(&cells.vertex[0][0][0], &cells.vertex[0][0][0] + NetCell::SPAN * NetCell::SPAN * NetCell::SPAN,
+              NetCell::NONE);
+    static thread_local std::vector<uint32_t> quads; // four cell vertices each
+    static thread_local std::vector<uint32_t> rep;   // the vertex each is drawn as
+    static thread_local std::vector<uint32_t> members;
+    static thread_local std::vector<uint32_t> cellOf;  // x << 16 | y << 8 | z; NONE if collapsed
+    static thread_local std::vector<uint32_t> mark;    // the block a cell vertex is tried in
+    static thread_local std::vector<uint32_t> around, aroundAt; // quad corners, by vertex
+    static thread_local std::vector<uint32_t> keys, byBlock, blockAt;
+    cellOf.clear();
+    quads.clear();
+
+    auto density = [&](int x, int y, int z) { return (float)chunk.at(x, y, z).density; };
+
+    // The cell's vertex, made the first time a quad asks for it
+    auto vertexOf = [&](glm::ivec3 c) -> uint32_t {
+        uint32_t& slot = cells.vertex[c.x + 1][c.y + 1][c.z + 1];
+        if (slot != NetCell::NONE) return slot;
+
+        glm::ivec3 lo, hi;
+        for (int a = 0; a < 3; a++) {
+            lo[a] = std::clamp(c[a], 0, N);
+            hi[a] = (c[a] < 0 || c[a] >= N) ? lo[a] : c[a] + 1;
+        }
+        const bool full = hi.x != lo.x && hi.y != lo.y && hi.z != lo.z;
+        glm::vec3 sum(0.f);
+        int       cuts = 0;
+        float     most = INFINITY; // material as marching cubes picks it: the most solid corner's
+        uint8_t   mat  = 0;
+        glm::vec3 grad(0.f);
+        for (int x = lo.x; x <= hi.x; x++)
+            for (int y = lo.y; y <= hi.y; y++)
+                for (int z = lo.z; z <= hi.z; z++) {
+                    float d = density(x, y, z);
+                    if (d < most) {
+                        most = d;
+                        mat  = chunk.at(x, y, z).material;
+                    }
+                    // Differences across the cell; a collapsed one has
+                    // no width to take them over
+                    if (full) grad += glm::vec3(x == hi.x ? d : -d, y == hi.y ? d : -d, z == hi.z ? d : -d);
+                    else      grad += cornerGradient(chunk, x, y, z);
+                    const glm::ivec3 up[3] = {{x + 1, y, z}, {x, y + 1, z}, {x, y, z + 1}};
+                    for (int a = 0; a < 3; a++) {
+                        if (up[a][a] > hi[a]) continue;
+                        float e = density(up[a].x, up[a].y, up[a].z);
+                        if ((d < 0) == (e < 0)) continue;
+                        glm::vec3 p((float)x, (float)y, (float)z);
+                        p[a] += d / (d - e);
+                        sum += p;
+                        cuts++;
+                    }
+                }
+        glm::vec3 pos = sum / (float)std::max(cuts, 1);
+        glm::vec3 normal(0.f, 1.f, 0.f);
+        if (glm::dot(grad, grad) > 1e-12f) normal = -glm::normalize(grad);
+        if (mat == (uint8_t)BlockMat::Grass && normal.y < 0.5f) mat = (uint8_t)BlockMat::Dirt;
+
+        slot = (uint32_t)mesh.vertices.size();
+        mesh.vertices.push_back({pos, normal, terrainUV(pos, normal), (uint32_t)mat});
+        const bool inside = c.x >= 0 && c.y >= 0 && c.z >= 0 && c.x < N && c.y < N && c.z < N;
+        cellOf.push_back(inside ? (uint32_t)c.x << 16 | (uint32_t)c.y << 8 | (uint32_t)c.z : NetCell::NONE);
+        return slot;
+    };
+
+    // Edges along each axis a from sample p; b and c the other two, so the
+    // quad c00 c10 c11 c01 winds about +a. Wound against the air, as
+    // marching cubes' triangles are. Each sample is read once, against its
+    // three upper neighbours, straight off the voxel array.
+    constexpr int P       = ChunkData::PADDED;
+    constexpr int STEP[3] = {P * P, 1, P}; // voxels[x][z][y]
+    const ChunkData::Voxel* voxel = &chunk.voxels[0][0][0];
+    glm::ivec3 p;
+    for (p.x = 0; p.x <= N; p.x++)
+    for (p.z = 0; p.z <= N; p.z++)
+    for (p.y = 0; p.y <= N; p.y++) {
+        const ChunkData::Voxel* v0 = voxel + (p.x * P + p.z) * P + p.y;
+        const bool in0 = v0->density < 0;
+        const bool cut[3] = {p.x < N && in0 != (v0[STEP[0]].density < 0),
+                             p.y < N && in0 != (v0[STEP[1]].density < 0),
+                             p.z < N && in0 != (v0[STEP[2]].density < 0)};
+        if (!(cut[0] | cut[1] | cut[2])) continue;
+        for (int a = 0; a < 3; a++) {
+            if (!cut[a]) continue;
+
+            const int  b = (a + 1) % 3, c = (a + 2) % 3;
+            glm::ivec3 k[4] = {p, p, p, p};
+            k[0][b]--; k[0][c]--;
+            k[1][c]--;
+            k[3][b]--;
+            uint32_t v[4];
+            for (int i = 0; i < 4; i++) v[i] = vertexOf(k[i]);
+            if (in0) std::swap(v[1], v[3]);
+            quads.insert(quads.end(), {v[0], v[1], v[2], v[3]});
+        }
+    }
+
+    // Coarsening, smallest blocks first. A vertex drawn as itself is one
+    // cell's; the members' own vertices stay put until the end, as a
+    // bigger block tests those rather than its halves' merged ones.
+    const size_t cellVertices = mesh.vertices.size();
+    rep.resize(cellVertices);
+    for (uint32_t v = 0; v < (uint32_t)cellVertices; v++) rep[v] = v;
+    mark.assign(cellVertices, NetCell::NONE);
+    bucketBy(quads, cellVertices, aroundAt, around); // corners of quads, by vertex
+
+    uint32_t block = 0;
+    for (int size = 2; size <= NET_BLOCK_MAX; size *= 2) {
+        const int B = N / size, half = size / 2;
+        keys.resize(cellVertices);
+        for (size_t v = 0; v < cellVertices; v++) {
+            const uint32_t c = cellOf[v];
+            keys[v] = c == NetCell::NONE ? c
+                                         : ((c >> 16) / size * B + (c >> 8 & 0xff) / size) * B + (c & 0xff) / size;
+        }
+        bucketBy(keys, (size_t)B * B * B, blockAt, byBlock);
+        for (int k = 0; k < B * B * B; k++) {
+            if (blockAt[k + 1] - blockAt[k] < 2) continue;
+            members.assign(byBlock.begin() + blockAt[k], byBlock.begin() + blockAt[k + 1]);
+
+            // Whole halves: every vertex in one is already drawn as one
+            uint32_t drawnIn[8];
+            std::fill(drawnIn, drawnIn + 8, NetCell::NONE);
+            bool whole = true;
+            for (uint32_t v : members) {
+                const uint32_t c = cellOf[v];
+                const int h = ((c >> 16) / half & 1) | ((c >> 8 & 0xff) / half & 1) << 1 | ((c & 0xff) / half & 1) << 2;
+                if (drawnIn[h] == NetCell::NONE) drawnIn[h] = rep[v];
+                whole = whole && rep[v] == drawnIn[h];
+            }
+            if (!whole) continue;
+
+            const Vertex& first = mesh.vertices[members[0]];
+            glm::vec3 centre(0.f), normal(0.f);
+            bool flat = true;
+            for (uint32_t v : members) {
+                centre += mesh.vertices[v].pos;
+                normal += mesh.vertices[v].normal;
+                flat = flat && mesh.vertices[v].material == first.material;
+            }
+            if (!flat || glm::dot(normal, normal) < 1e-12f) continue;
+            centre /= (float)members.size();
+            normal  = glm::normalize(normal);
+            for (uint32_t v : members) {
+                const Vertex& m = mesh.vertices[v];
+                flat = flat && glm::dot(m.normal, normal) >= NET_FLAT_COS &&
+                       std::fabs(glm::dot(m.pos - centre, normal)) <= NET_FLAT_DIST;
+            }
+            if (!flat) continue;
+
+            // Nor may any triangle around it turn over
+            const uint32_t drawn = (uint32_t)mesh.vertices.size();
+            block++;
+            for (uint32_t v : members) mark[v] = block;
+            auto drawnAs = [&](uint32_t v) { return mark[v] == block ? drawn : rep[v]; };
+            auto posOf   = [&](uint32_t d) { return d == drawn ? centre : mesh.vertices[d].pos; };
+            auto normOf  = [&](uint32_t d) { return d == drawn ? normal : mesh.vertices[d].normal; };
+            for (size_t m = 0; m < members.size() && flat; m++)
+                for (uint32_t i = aroundAt[members[m]]; i < aroundAt[members[m] + 1] && flat; i++) {
+                    const uint32_t* q = &quads[around[i] / 4 * 4];
+                    if (mark[q[0]] == block && mark[q[1]] == block && mark[q[2]] == block && mark[q[3]] == block)
+                        continue; // inside it: gone
+                    uint32_t v[4];
+                    int      n = netPolygon(q, drawnAs, v);
+                    for (int t = 1; t + 1 < n && flat; t++) {
+                        glm::vec3 face = glm::cross(posOf(v[t]) - posOf(v[0]), posOf(v[t + 1]) - posOf(v[0]));
+                        flat = glm::dot(face, normOf(v[0]) + normOf(v[t]) + normOf(v[t + 1])) > 0.f;
+                    }
+                }
+            if (!flat) continue;
+
+            uint32_t mat = first.material;
+            if (mat == (uint8_t)BlockMat::Grass && normal.y < 0.5f) mat = (uint8_t)BlockMat::Dirt;
+            mesh.vertices.push_back({centre, normal, terrainUV(centre, normal), mat});
+            for (uint32_t v : members) rep[v] = drawn;
+        }
+    }
+
+    // The quads as drawn, vertices renumbered in the order they're first used
+    static thread_local std::vector<uint32_t> kept; // final index of each vertex drawn
+    static thread_local std::vector<Vertex>   out;
+    kept.assign(mesh.vertices.size(), NetCell::NONE);
+    out.clear();
+    auto keep = [&](uint32_t drawn) {
+        if (kept[drawn] == NetCell::NONE) {
+            kept[drawn] = (uint32_t)out.size();
+            out.push_back(mesh.vertices[drawn]);
+        }
+        return kept[drawn];
+    };
+    for (size_t i = 0; i < quads.size(); i += 4) {
+        uint32_t v[4];
+        int      n = netPolygon(&quads[i], [&](uint32_t c) { return rep[c]; }, v);
+        if (n == 0) continue;
+        uint32_t k[4];
+        for (int j = 0; j < n; j++) k[j] = keep(v[j]);
+        mesh.indices.insert(mesh.indices.end(), {k[0], k[1], k[2]});
+        if (n == 4) mesh.indices.insert(mesh.indices.end(), {k[0], k[2], k[3]});
+    }
+    mesh.vertices.swap(out);
+}
+
+// ── Occlusion ─────────────────────────────────────────────────────────────────
+// The density is near enough the distance to the surface, in cells, out to
+// the generator's DENSITY_MAX clamp, so a tap t cells out along the normal
+// that finds the field reading less than t is that much nearer something
+// solid than open ground would leave it. Nearer taps weigh more. Taps past
+// the padded field are skipped, shortening what a vertex on the chunk's
+// border can see.
+static constexpr float OCCLUSION_TAPS[3]   = {0.5f, 1.f, 2.f}; // within DENSITY_MAX
+static constexpr float OCCLUSION_WEIGHT[3] = {1.f, 0.5f, 0.25f};
+
+// Trilinear and dequantized; p within [0, SIZE] on every axis
+static float fieldAt(const ChunkData& c, glm::vec3 p) {
+    constexpr int N = ChunkData::SIZE;
+    int x = std::min((int)p.x, N - 1), y = std::min((int)p.y, N - 1), z = std::min((int)p.z, N - 1);
+    float fx = p.x - (float)x, fy = p.y - (float)y, fz = p.z - (float)z;
+    auto d = [&](int i, int j, int k) { return (float)c.at(x + i, y + j, z + k).density; };
+    float x00 = d(0, 0, 0) + (d(1, 0, 0) - d(0, 0, 0)) * fx;
+    float x10 = d(0, 1, 0) + (d(1, 1, 0) - d(0, 1, 0)) * fx;
+    float x01 = d(0, 0, 1) + (d(1, 0, 1) - d(0, 0, 1)) * fx;
+    float x11 = d(0, 1, 1) + (d(1, 1, 1) - d(0, 1, 1)) * fx;
+    float y0  = x00 + (x10 - x00) * fy, y1 = x01 + (x11 - x01) * fy;
+    return (y0 + (y1 - y0) * fz) / ChunkData::DENSITY_SCALE;
+}
+
+static void bakeOcclusion(const ChunkData& chunk, ChunkMesh& mesh) {
+    constexpr float N = (float)ChunkData::SIZE;
+    for (Vertex& v : mesh.vertices) {
+        float sum = 0.f, weight = 0.f;
+        for (int t = 0; t < 3; t++) {
+            glm::vec3 q = v.pos + v.normal * OCCLUSION_TAPS[t];
+            if (q.x < 0.f || q.y < 0.f || q.z < 0.f || q.x > N || q.y > N || q.z > N) continue;
+            float shut = (OCCLUSION_TAPS[t] - fieldAt(chunk, q)) / OCCLUSION_TAPS[t];
+            sum    += OCCLUSION_WEIGHT[t] * std::clamp(shut, 0.f, 1.f);
+            weight += OCCLUSION_WEIGHT[t];
+        }
+        v.occlusion = weight > 0.f ? (uint8_t)(sum / weight * 255.f + 0.5f) : 0;
+    }
+}
+
+// ── Face links ────────────────────────────────────────────────────────────────
+
+uint16_t chunkFaceLinks(const ChunkData& chunk) {
+    if (chunk.fill == ChunkData::Fill::Air)   return FACE_LINKS_ALL;
+    if (chunk.fill == ChunkData::Fill::Solid) return 0;
+
+    constexpr int S = ChunkData::SIZE;
+    // Corner bit dx | dy << 1 | dz << 2, so these are the corners on each
+    // face, in face order (-x +x -y +y -z +z)
+    static constexpr uint8_t FACE_CORNERS[6] = {0x55, 0xAA, 0x33, 0xCC, 0x0F, 0xF0};
+    static thread_local std::vector<uint8_t>  air;   // per cell, its air corners
+    static thread_local std::vector<uint8_t>  seen;
+    static thread_local std::vector<uint32_t> stack;
+    air.assign((size_t)S * S * S, 0);
+    seen.assign((size_t)S * S * S, 0);
+    auto cell = [](int x, int y, int z) { return ((size_t)x * S + z) * S + y; };
+
+    for (int x = 0; x < S; x++)
+        for (int z = 0; z < S; z++)
+            for (int y = 0; y < S; y++) {
+                uint8_t m = 0;
+                for (int c = 0; c < 8; c++)
+                    if (chunk.at(x + (c & 1), y + (c >> 1 & 1), z + (c >> 2 & 1)).density >= 0)
+                        m |= (uint8_t)(1 << c);
+                air[cell(x, y, z)] = m;
             }
 
-            uint32_t base = (uint32_t)mesh.vertices.size();
-            mesh.vertices.push_back(makeVertex(v0, matV0));
-            mesh.vertices.push_back(makeVertex(v1, matV1));
-            mesh.vertices.push_back(makeVertex(v2, matV2));
-            mesh.indices.push_back(base);
-            mesh.indices.push_back(base + 1);
-            mesh.indices.push_back(base + 2);
+    uint16_t links = 0;
+    for (size_t start = 0; start < air.size(); start++) {
+        if (!air[start] || seen[start]) continue;
+        // One open region: every pair of faces it reaches is linked
+        uint8_t faces = 0;
+        seen[start] = 1;
+        stack.assign(1, (uint32_t)start);
+        while (!stack.empty()) {
+            uint32_t i = stack.back();
+            stack.pop_back();
+            int x = (int)(i / (S * S)), z = (int)(i / S % S), y = (int)(i % S);
+            int at[6] = {x == 0, x == S - 1, y == 0, y == S - 1, z == 0, z == S - 1};
+            int step[6] = {-S * S, S * S, -1, 1, -S, S};
+            for (int f = 0; f < 6; f++) {
+                if (!(air[i] & FACE_CORNERS[f])) continue;
+                if (at[f]) { faces |= (uint8_t)(1 << f); continue; }
+                uint32_t n = (uint32_t)((int)i + step[f]);
+                if (!seen[n] && air[n]) {
+                    seen[n] = 1;
+                    stack.push_back(n);
+                }
+            }
         }
+        for (int a = 0; a < 6; a++)
+            for (int b = a + 1; b < 6; b++)
+                if ((faces >> a & 1) && (faces >> b & 1)) links |= (uint16_t)(1 << faceLinkBit(a, b));
+        if (links == FACE_LINKS_ALL) break;
     }
+    return links;
+}
+
+void marchChunk(const ChunkData& chunk, ChunkMesh& mesh, const MarchOptions& opts) {
+    mesh.coord = chunk.coord;
+    mesh.lod   = 0;
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    mesh.faceLinks = chunkFaceLinks(chunk);
+    if (chunk.fill != ChunkData::Fill::Mixed) return;
+
+    // Before the skirts, which take their top edge's
+    if (opts.mesher == Mesher::Nets) {
+        netsRange(chunk, mesh);
+        if (opts.occlusion) bakeOcclusion(chunk, mesh);
+        if (opts.skirt > 0.f) addSkirts(mesh, opts.skirt, true);
+        return;
+    }
+    marchRange(chunk, mesh, opts, 0, ChunkData::SIZE);
+    if (opts.occlusion) bakeOcclusion(chunk, mesh);
+    if (opts.skirt > 0.f) addSkirts(mesh, opts.skirt);
+}
 
+// ── Slabs ─────────────────────────────────────────────────────────────────────
+
+void marchSlab(const ChunkData& chunk, ChunkMesh& mesh, int i, int n, const MarchOptions& opts) {
+    mesh.coord = chunk.coord;
+    mesh.lod   = 0;
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    if (chunk.fill != ChunkData::Fill::Mixed) return;
+    if (opts.mesher == Mesher::Nets) {
+        if (i == 0) netsRange(chunk, mesh);
+    } else
+        marchRange(chunk, mesh, opts, marchSlabStart(i, n), marchSlabStart(i + 1, n));
+    // The same per vertex whichever slab has it, so stitching still welds
+    if (opts.occlusion) bakeOcclusion(chunk, mesh);
+}
+
+// Slab i's cells only touch layers z0..z1, and slab i-1 emitted every vertex
+// it has on z0. A one-pass march would have found those in its cache instead
+// of emitting new ones, so each vertex slab i has on z0 is mapped onto slab
+// i-1's vertex with the same corner, normal and material, and the rest are
+// appended in order. That reproduces the one-pass vertex order exactly.
+void stitchSlabs(std::vector<ChunkMesh>& slabs, ChunkMesh& out, const MarchOptions& opts) {
+    constexpr int      P    = ChunkData::PADDED;
+    constexpr uint32_t NONE = UINT32_MAX;
+    out.vertices.clear();
+    out.indices.clear();
+    out.lod = 0;
+    if (slabs.empty()) return;
+    out.coord = slabs[0].coord;
+
+    // out's vertices on the boundary layer below the current slab, chained
+    // by corner
+    std::vector<uint32_t> heads((size_t)P * P, NONE);
+    std::vector<std::pair<uint32_t, uint32_t>> links; // vertex, next
+    std::vector<uint32_t> boundary, remap;
+
+    int n = (int)slabs.size();
+    for (int i = 0; i < n; i++) {
+        ChunkMesh& m = slabs[i];
+        float z0 = (float)marchSlabStart(i, n), z1 = (float)marchSlabStart(i + 1, n);
+
+        std::fill(heads.begin(), heads.end(), NONE);
+        links.clear();
+        for (uint32_t v : boundary) {
+            const glm::vec3& p = out.vertices[v].pos;
+            uint32_t& h = heads[(size_t)p.y * P + (size_t)p.x];
+            links.push_back({v, h});
+            h = (uint32_t)links.size() - 1;
+        }
+        boundary.clear();
+
+        remap.resize(m.vertices.size());
+        for (size_t k = 0; k < m.vertices.size(); k++) {
+            const Vertex& v = m.vertices[k];
+            uint32_t found = NONE;
+            if (i > 0 && v.pos.z == z0) {
+                for (uint32_t l = heads[(size_t)v.pos.y * P + (size_t)v.pos.x]; l != NONE; l = links[l].second) {
+                    const Vertex& w = out.vertices[links[l].first];
+                    if (w.pos == v.pos && w.normal == v.normal && w.material == v.material) {
+                        found = links[l].first;
+                        break;
+                    }
+                }
+            }
+            if (found == NONE) {
+                found = (uint32_t)out.vertices.size();
+                out.vertices.push_back(v);
+                if (v.pos.z == z1) boundary.push_back(found);
+            }
+            remap[k] = found;
+        }
+        for (uint32_t idx : m.indices) out.indices.push_back(remap[idx]);
+    }
+
+    if (opts.skirt > 0.f) addSkirts(out, opts.skirt, opts.mesher == Mesher::Nets);
+}
+
+ChunkMesh marchChunk(const ChunkData& chunk, const MarchOptions& opts) {
+    ChunkMesh mesh;
+    marchChunk(chunk, mesh, opts);
     return mesh;
 }
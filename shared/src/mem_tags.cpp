@@ -0,0 +1,75 @@
+#include "mem_tags.h"
+
+const char* MemTags::name(Tag t) {
+    static const char* const names[COUNT] = {
+        "other", "chunk_cache", "gen_scratch", "meshing", "packets", "inventory",
+    };
+    return t < COUNT ? names[t] : "?";
+}
+
+#ifdef AETHERIS_MEM_TAGS
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    // Ahead of every block; 16 bytes so what follows keeps malloc's alignment
+    struct alignas(16) Header {
+        size_t   size;
+        uint32_t tag;
+        uint32_t pad;
+    };
+    static_assert(sizeof(Header) == 16);
+
+    // A line each, so tags busy on different threads don't share one
+    struct alignas(64) Counters {
+        std::atomic<int64_t>  bytes{0}, blocks{0};
+        std::atomic<uint64_t> allocs{0};
+    };
+    // Constant-initialised: operator new may run before any constructor
+    Counters g_tags[MemTags::COUNT];
+
+    thread_local MemTags::Tag t_tag    = MemTags::Untagged;
+    thread_local uint64_t     t_allocs = 0;
+}
+
+MemTags::Stats MemTags::stats(Tag t) {
+    const Counters& c = g_tags[t < COUNT ? t : Untagged];
+    return {c.bytes.load(std::memory_order_relaxed), c.blocks.load(std::memory_order_relaxed),
+            c.allocs.load(std::memory_order_relaxed)};
+}
+
+MemTags::Tag MemTags::exchange(Tag t) {
+    Tag prev = t_tag;
+    t_tag    = t;
+    return prev;
+}
+
+uint64_t MemTags::threadAllocs() { return t_allocs; }
+
+// The array and nothrow forms forward here; aligned ones are left alone
+// and not counted
+void* operator new(std::size_t n) {
+    auto* h = static_cast<Header*>(std::malloc(sizeof(Header) + n));
+    if (!h) throw std::bad_alloc();
+    h->size = n;
+    h->tag  = t_tag;
+    Counters& c = g_tags[h->tag];
+    c.bytes.fetch_add((int64_t)n, std::memory_order_relaxed);
+    c.blocks.fetch_add(1, std::memory_order_relaxed);
+    c.allocs.fetch_add(1, std::memory_order_relaxed);
+    t_allocs++;
+    return h + 1;
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    Header* h   = static_cast<Header*>(p) - 1;
+    Counters& c = g_tags[h->tag];
+    c.bytes.fetch_sub((int64_t)h->size, std::memory_order_relaxed);
+    c.blocks.fetch_sub(1, std::memory_order_relaxed);
+    std::free(h);
+}
+
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+#endif
@@ -0,0 +1,96 @@
+#include "mesh_optimize.h"
+#include <cstdint>
+#include <vector>
+
+void optimizeMesh(ChunkMesh& mesh) {
+    constexpr uint32_t NONE = UINT32_MAX;
+    const uint32_t vc   = (uint32_t)mesh.vertices.size();
+    const uint32_t tris = (uint32_t)(mesh.indices.size() / 3);
+    if (tris == 0) return;
+
+    // Scratch kept per thread: chunk meshing runs on pool workers
+    static thread_local std::vector<uint32_t> start, adj, live, stamp, deadEnd, out, remap;
+    static thread_local std::vector<uint8_t>  emitted;
+    static thread_local std::vector<Vertex>   verts;
+
+    // Each vertex's triangles, back to back: start[v] .. start[v + 1]
+    start.assign(vc + 1, 0);
+    for (uint32_t i : mesh.indices) start[i + 1]++;
+    for (uint32_t v = 0; v < vc; v++) start[v + 1] += start[v];
+    adj.resize(mesh.indices.size());
+    live.assign(vc, 0);
+    for (size_t k = 0; k < mesh.indices.size(); k++) {
+        uint32_t v = mesh.indices[k];
+        adj[start[v] + live[v]++] = (uint32_t)(k / 3);
+    }
+
+    // ── Tipsify ───────────────────────────────────────────────────────────
+    // live: triangles still to emit per vertex; stamp: when each vertex last
+    // entered the cache, so it's still in there while time - stamp <= size
+    constexpr uint32_t K = MESH_CACHE_SIZE;
+    stamp.assign(vc, 0);
+    emitted.assign(tris, 0);
+    deadEnd.clear();
+    out.clear();
+    out.reserve(mesh.indices.size());
+    uint32_t time   = K + 1;
+    uint32_t cursor = 0; // next vertex in input order to fall back on
+
+    auto skipDeadEnd = [&]() -> uint32_t {
+        while (!deadEnd.empty()) {
+            uint32_t d = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[d] > 0) return d;
+        }
+        for (; cursor < vc; cursor++)
+            if (live[cursor] > 0) return cursor++;
+        return NONE;
+    };
+
+    uint32_t fan = skipDeadEnd();
+    while (fan != NONE) {
+        size_t candidates = out.size();
+        for (uint32_t a = start[fan]; a < start[fan + 1]; a++) {
+            uint32_t t = adj[a];
+            if (emitted[t]) continue;
+            emitted[t] = 1;
+            for (int c = 0; c < 3; c++) {
+                uint32_t v = mesh.indices[t * 3 + c];
+                out.push_back(v);
+                deadEnd.push_back(v);
+                live[v]--;
+                if (time - stamp[v] > K) stamp[v] = time++;
+            }
+        }
+
+        // Next fan: of the vertices just used, the one that has been in the
+        // cache longest and will still be there once its own fan is out
+        uint32_t best = NONE;
+        int      bestPriority = -1;
+        for (size_t k = candidates; k < out.size(); k++) {
+            uint32_t v = out[k];
+            if (live[v] == 0) continue;
+            int priority = 0;
+            if (time - stamp[v] + 2 * live[v] <= K) priority = (int)(time - stamp[v]);
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+        fan = best != NONE ? best : skipDeadEnd();
+    }
+
+    // ── Vertices in first-use order ───────────────────────────────────────
+    remap.assign(vc, NONE);
+    verts.clear();
+    verts.reserve(vc);
+    for (uint32_t& i : out) {
+        if (remap[i] == NONE) {
+            remap[i] = (uint32_t)verts.size();
+            verts.push_back(mesh.vertices[i]);
+        }
+        i = remap[i];
+    }
+    mesh.vertices.swap(verts);
+    mesh.indices.swap(out);
+}
@@ -0,0 +1,203 @@
+#include "net_alloc.h"
+#include "log.h"
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+
+namespace {
+    constexpr int    CLASSES     = 8;
+    constexpr size_t MIN_BLOCK   = 32;             // class 0; class i is MIN_BLOCK << i
+    constexpr int    LARGE       = CLASSES;        // header value past the classes
+    constexpr int    BATCH       = 32;             // blocks moved between a thread and a depot at once
+    constexpr int    THREAD_MAX  = BATCH * 2;      // per class per thread
+    constexpr size_t DEPOT_BYTES = 1 << 20;        // per class
+    constexpr int    FOLD_EVERY  = 64;
+
+    // Ahead of every block; 16 bytes so what follows keeps malloc's alignment
+    struct alignas(16) Header {
+        uint32_t cls;
+        uint32_t pad;
+        Header*  next; // while on a free list
+    };
+    static_assert(sizeof(Header) == 16);
+
+    size_t classSize(int c) { return MIN_BLOCK << c; }
+
+    int classOf(size_t size) {
+        int c = 0;
+        while (c < CLASSES && classSize(c) < size) c++;
+        return c;
+    }
+
+    struct Depot {
+        std::mutex mu;
+        Header*    head  = nullptr;
+        size_t     count = 0;
+    };
+    Depot g_depots[CLASSES];
+
+    std::atomic<uint64_t> g_allocs{0}, g_fromPool{0}, g_large{0};
+    std::atomic<int64_t>  g_live{0}, g_held{0};
+
+    struct ThreadCache {
+        Header* head[CLASSES]  = {};
+        int     count[CLASSES] = {};
+
+        // Not yet folded into the totals
+        uint64_t allocs = 0, fromPool = 0, large = 0;
+        int64_t  live   = 0;
+        int      ops    = 0;
+
+        void fold() {
+            g_allocs.fetch_add(allocs, std::memory_order_relaxed);
+            g_fromPool.fetch_add(fromPool, std::memory_order_relaxed);
+            g_large.fetch_add(large, std::memory_order_relaxed);
+            g_live.fetch_add(live, std::memory_order_relaxed);
+            allocs = fromPool = large = 0;
+            live = 0;
+            ops  = 0;
+        }
+        void tick() { if (++ops >= FOLD_EVERY) fold(); }
+
+        // Up to n blocks off c's list onto the depot, the rest to malloc's
+        void spill(int c, int n) {
+            Depot& d = g_depots[c];
+            std::lock_guard lk(d.mu);
+            for (; n > 0 && head[c]; n--) {
+                Header* h = head[c];
+                head[c]   = h->next;
+                count[c]--;
+                if ((d.count + 1) * classSize(c) > DEPOT_BYTES) {
+                    std::free(h);
+                    continue;
+                }
+                h->next = d.head;
+                d.head  = h;
+                d.count++;
+                g_held.fetch_add((int64_t)classSize(c), std::memory_order_relaxed);
+            }
+        }
+
+        void refill(int c) {
+            Depot& d = g_depots[c];
+            std::lock_guard lk(d.mu);
+            for (int n = 0; n < BATCH && d.head; n++) {
+                Header* h = d.head;
+                d.head    = h->next;
+                d.count--;
+                g_held.fetch_sub((int64_t)classSize(c), std::memory_order_relaxed);
+                h->next = head[c];
+                head[c] = h;
+                count[c]++;
+            }
+        }
+
+        ~ThreadCache() {
+            for (int c = 0; c < CLASSES; c++) spill(c, count[c]);
+            fold();
+            dead = true;
+        }
+
+        inline static thread_local bool dead = false;
+    };
+    thread_local ThreadCache t_cache;
+
+    // Past the thread's exit (a packet freed by a late destructor) the
+    // depot is used directly
+    void* allocDirect(int c) {
+        Depot& d = g_depots[c];
+        {
+            std::lock_guard lk(d.mu);
+            if (Header* h = d.head) {
+                d.head = h->next;
+                d.count--;
+                g_held.fetch_sub((int64_t)classSize(c), std::memory_order_relaxed);
+                return h;
+            }
+        }
+        return std::malloc(sizeof(Header) + classSize(c));
+    }
+
+    void noMemory() {
+        Log::err("ENet: out of memory");
+        std::abort();
+    }
+}
+
+void* NetAlloc::alloc(size_t size) {
+    int     c = classOf(size);
+    Header* h = nullptr;
+    if (c == LARGE) {
+        h = static_cast<Header*>(std::malloc(sizeof(Header) + size));
+        if (!h) return nullptr;
+    } else if (ThreadCache::dead) {
+        h = static_cast<Header*>(allocDirect(c));
+        if (!h) return nullptr;
+        g_allocs.fetch_add(1, std::memory_order_relaxed);
+        g_live.fetch_add((int64_t)classSize(c), std::memory_order_relaxed);
+    } else {
+        ThreadCache& tc = t_cache;
+        if (!tc.head[c]) tc.refill(c);
+        if ((h = tc.head[c])) {
+            tc.head[c] = h->next;
+            tc.count[c]--;
+            tc.fromPool++;
+        } else if (!(h = static_cast<Header*>(std::malloc(sizeof(Header) + classSize(c))))) {
+            return nullptr;
+        }
+        tc.allocs++;
+        tc.live += (int64_t)classSize(c);
+        tc.tick();
+    }
+    h->cls = (uint32_t)c;
+    if (c == LARGE) {
+        g_allocs.fetch_add(1, std::memory_order_relaxed);
+        g_large.fetch_add(1, std::memory_order_relaxed);
+    }
+    return h + 1;
+}
+
+void NetAlloc::free(void* p) {
+    if (!p) return;
+    Header* h = static_cast<Header*>(p) - 1;
+    int     c = (int)h->cls;
+    if (c == LARGE) {
+        std::free(h);
+        return;
+    }
+    if (ThreadCache::dead) {
+        g_live.fetch_sub((int64_t)classSize(c), std::memory_order_relaxed);
+        Depot& d = g_depots[c];
+        std::lock_guard lk(d.mu);
+        h->next = d.head;
+        d.head  = h;
+        d.count++;
+        g_held.fetch_add((int64_t)classSize(c), std::memory_order_relaxed);
+        return;
+    }
+    ThreadCache& tc = t_cache;
+    h->next    = tc.head[c];
+    tc.head[c] = h;
+    tc.count[c]++;
+    tc.live -= (int64_t)classSize(c);
+    if (tc.count[c] > THREAD_MAX) tc.spill(c, BATCH);
+    tc.tick();
+}
+
+NetAlloc::Stats NetAlloc::stats() {
+    Stats s;
+    s.allocs    = g_allocs.load(std::memory_order_relaxed);
+    s.fromPool  = g_fromPool.load(std::memory_order_relaxed);
+    s.large     = g_large.load(std::memory_order_relaxed);
+    s.liveBytes = g_live.load(std::memory_order_relaxed);
+    s.heldBytes = g_held.load(std::memory_order_relaxed);
+    return s;
+}
+
+ENetCallbacks NetAlloc::callbacks() {
+    ENetCallbacks cb{};
+    cb.malloc    = &NetAlloc::alloc;
+    cb.free      = &NetAlloc::free;
+    cb.no_memory = &noMemory;
+    return cb;
+}
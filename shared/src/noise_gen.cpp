@@ -1,117 +1,352 @@
 #include "noise_gen.h"
 #include "config.h"
+#include "noise_graph.h"
+#include "world_features.h"
 #include <cmath>
 #include <cstdint>
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 
-static float hashNoise(int64_t seed, int x, int y, int z) {
-    uint64_t h = (uint64_t)seed;
-    h ^= (uint64_t)(x * 1619 + y * 31337 + z * 6971);
-    h ^= h >> 16;
-    h *= 0x45d9f3b37197344dULL;
-    h ^= h >> 16;
-    return (float)(h & 0xffffff) / (float)0xffffff;
-}
-
-static float smoothstep(float t) { return t * t * (3.f - 2.f * t); }
-
-static float valueNoise(int64_t seed, float x, float y, float z) {
-    int ix = (int)std::floor(x), iy = (int)std::floor(y), iz = (int)std::floor(z);
-    float fx = x - ix, fy = y - iy, fz = z - iz;
-    float ux = smoothstep(fx), uy = smoothstep(fy), uz = smoothstep(fz);
-
-    float v000 = hashNoise(seed, ix,   iy,   iz  );
-    float v100 = hashNoise(seed, ix+1, iy,   iz  );
-    float v010 = hashNoise(seed, ix,   iy+1, iz  );
-    float v110 = hashNoise(seed, ix+1, iy+1, iz  );
-    float v001 = hashNoise(seed, ix,   iy,   iz+1);
-    float v101 = hashNoise(seed, ix+1, iy,   iz+1);
-    float v011 = hashNoise(seed, ix,   iy+1, iz+1);
-    float v111 = hashNoise(seed, ix+1, iy+1, iz+1);
-
-    return v000 + ux*(v100-v000)
-         + uy*(v010-v000 + ux*(v110-v010-v100+v000))
-         + uz*(v001-v000 + ux*(v101-v001-v100+v000)
-             + uy*(v011-v001-v010+v000 + ux*(v111-v011-v101+v001-v110+v010+v100-v000)));
-}
-
-static float fbm(int64_t seed, float x, float y, float z, int octaves) {
-    float n = 0.f, amp = 0.5f, freq = 1.f;
-    for (int o = 0; o < octaves; o++) {
-        n   += valueNoise(seed + o * 1000, x*freq, y*freq, z*freq) * amp;
-        amp  *= 0.5f;
-        freq *= 2.f;
+namespace {
+
+const Noise::Graph* g_graph = nullptr; // null: the built-in one
+
+// Each x row of columns is one run of the graph's surface
+std::shared_ptr<const SurfaceColumn> buildColumn(int cx, int cz, int lod) {
+    constexpr int   N    = ChunkData::SIZE;
+    constexpr int   P    = ChunkData::PADDED;
+    const float     step = (float)(1 << lod);
+
+    auto col = std::make_shared<SurfaceColumn>();
+    col->minY = 1e30f;
+    col->maxY = -1e30f;
+    float wx[P], wz[P];
+    for (int x = 0; x < P; x++) {
+        for (int z = 0; z < P; z++) {
+            wx[z] = (float)(cx * N + x) * step;
+            wz[z] = (float)(cz * N + z) * step;
+        }
+        surfaceHeights(wx, wz, col->surface[x], P);
+        for (int z = 0; z < P; z++) {
+            col->minY = std::min(col->minY, col->surface[x][z]);
+            col->maxY = std::max(col->maxY, col->surface[x][z]);
+        }
+    }
+    return col;
+}
+
+// Oldest out first. Chunks in a column are generated close together, so
+// recency buys little over insertion order here.
+struct ColumnCache {
+    std::mutex mu;
+    std::unordered_map<ChunkKey, std::shared_ptr<const SurfaceColumn>, ChunkKeyHash> columns;
+    std::deque<ChunkKey> order;
+};
+
+ColumnCache& columnCache() {
+    static ColumnCache cache;
+    return cache;
+}
+
+// ── Shared faces ──────────────────────────────────────────────────────────────
+// Neighbouring chunks both sample the plane between them (PADDED = SIZE + 1),
+// and a sample depends on nothing but its position. Whichever side is
+// generated first leaves the plane here; the other copies it instead of
+// running the graph over it, and takes it out again — by then nobody else
+// needs it. Faces are those of ChunkMesh's order: -x +x -y +y -z +z.
+constexpr int P = ChunkData::PADDED;
+
+// The two other axes, y innermost as in a chunk: [z][y], [x][z], [x][y]
+struct Face {
+    ChunkData::Voxel v[P][P];
+};
+
+// The plane on the low side of high along axis
+struct FaceKey {
+    ChunkKey high;
+    int      axis;
+    bool operator==(const FaceKey&) const = default;
+};
+struct FaceKeyHash {
+    size_t operator()(const FaceKey& k) const { return ChunkKeyHash()(k.high) ^ (size_t)k.axis; }
+};
+
+FaceKey faceKey(ChunkCoord coord, int lod, int face) {
+    const int axis = face >> 1;
+    if (face & 1) (axis == 0 ? coord.x : axis == 1 ? coord.y : coord.z)++;
+    return {{coord, lod}, axis};
+}
+
+struct FaceCache {
+    std::mutex mu;
+    std::unordered_map<FaceKey, std::shared_ptr<const Face>, FaceKeyHash> faces;
+    std::deque<FaceKey> order; // may name faces already taken out
+};
+
+FaceCache& faceCache() {
+    static FaceCache cache;
+    return cache;
+}
+
+using ChunkFaces = std::array<std::shared_ptr<const Face>, 6>;
+
+ChunkFaces findFaces(ChunkCoord coord, int lod) {
+    ChunkFaces   found;
+    FaceCache&   c = faceCache();
+    std::lock_guard lk(c.mu);
+    for (int f = 0; f < 6; f++) {
+        auto it = c.faces.find(faceKey(coord, lod, f));
+        if (it != c.faces.end()) found[f] = it->second;
+    }
+    return found;
+}
+
+// The sample at (a, b) of face f is the chunk's voxel at...
+template<class Data>
+auto& faceVoxel(Data& d, int f, int a, int b) {
+    const int at = (f & 1) ? P - 1 : 0;
+    switch (f >> 1) {
+        case 0:  return d.at(at, b, a);
+        case 1:  return d.at(a, at, b);
+        default: return d.at(a, b, at);
+    }
+}
+
+// Over the slab's rows: an x face is one row, the others a strip of each
+void copyFaces(ChunkData& data, const ChunkFaces& faces, int x0, int x1) {
+    for (int f = 0; f < 6; f++) {
+        if (!faces[f]) continue;
+        const Face& face = *faces[f];
+        if (f < 2) {
+            const int x = f ? P - 1 : 0;
+            if (x < x0 || x >= x1) continue;
+            for (int z = 0; z < P; z++)
+                for (int y = 0; y < P; y++) faceVoxel(data, f, z, y) = face.v[z][y];
+        } else {
+            for (int x = x0; x < x1; x++)
+                for (int b = 0; b < P; b++) faceVoxel(data, f, x, b) = face.v[x][b];
+        }
+    }
+}
+
+} // namespace
+
+std::shared_ptr<const SurfaceColumn> surfaceColumn(int cx, int cz, int lod) {
+    ChunkKey key{{cx, 0, cz}, lod};
+    ColumnCache& c = columnCache();
+    {
+        std::lock_guard lk(c.mu);
+        auto it = c.columns.find(key);
+        if (it != c.columns.end()) return it->second;
+    }
+
+    // Outside the lock: two workers racing on one column both build it, and
+    // the first insert wins
+    auto col = buildColumn(cx, cz, lod);
+    std::lock_guard lk(c.mu);
+    auto [it, inserted] = c.columns.try_emplace(key, std::move(col));
+    if (inserted) {
+        c.order.push_back(key);
+        while (c.order.size() > Config::SURFACE_COLUMN_CACHE) {
+            c.columns.erase(c.order.front());
+            c.order.pop_front();
+        }
     }
-    return n * 2.f - 1.f;
+    return it->second;
+}
+
+const Noise::Graph& terrainGraph() {
+    return g_graph ? *g_graph : Noise::Graph::builtin();
+}
+
+void useTerrainGraph(Noise::Graph graph) {
+    static std::optional<Noise::Graph> custom;
+    custom  = std::move(graph);
+    g_graph = &*custom;
+}
+
+uint64_t terrainGraphId() {
+    uint64_t h = terrainGraph().hash();
+    return h == Noise::Graph::builtin().hash() ? 0 : h;
 }
 
+void surfaceHeights(const float* wx, const float* wz, float* out, int n) {
+    terrainGraph().surface(wx, wz, out, n);
+}
+
+BlockMat surfaceMaterial(float surfaceY, float normalY) {
+    if (surfaceY <= terrainGraph().params().sandTop) return BlockMat::Sand;
+    return normalY < 0.5f ? BlockMat::Dirt : BlockMat::Grass;
+}
+
+// Bilinear between the column grid's block corners — the heightmap is far
+// smoother than a block
 float sampleSurfaceY(float wx, float wz) {
-    constexpr float hscale   = 0.008f;
-    constexpr float hHeight  = 80.f;
-    constexpr float seaLevel = 64.f;
-    const int64_t   seed     = (int64_t)Config::WORLD_SEED;
+    constexpr int N = ChunkData::SIZE;
+    float fx = std::floor(wx), fz = std::floor(wz);
+    int   bx = (int)fx, bz = (int)fz;
+    int   cx = (int)std::floor((float)bx / N), cz = (int)std::floor((float)bz / N);
+    int   x  = bx - cx * N, z = bz - cz * N;   // < N, so x + 1 is still on the grid
+    float tx = wx - fx, tz = wz - fz;
 
-    float base   = fbm(seed,         wx * hscale,        0.f, wz * hscale,        4);
-    float detail = fbm(seed + 111111, wx * hscale * 3.f, 0.f, wz * hscale * 3.f, 3) * 0.25f;
-    return seaLevel + (base + detail) * hHeight + 2.f;
+    auto col = surfaceColumn(cx, cz);
+    const auto& s = col->surface;
+    float y0 = s[x][z]     + (s[x + 1][z]     - s[x][z])     * tx;
+    float y1 = s[x][z + 1] + (s[x + 1][z + 1] - s[x][z + 1]) * tx;
+    return y0 + (y1 - y0) * tz + 2.f;
 }
 
-ChunkData generateChunk(ChunkCoord coord) {
-    ChunkData data;
+void beginChunk(ChunkData& data, ChunkCoord coord, int lod) {
+    constexpr int N = ChunkData::SIZE;
     data.coord = coord;
+    data.fill  = ChunkData::Fill::Mixed;
+
+    const float step = (float)(1 << lod);
+    auto column = surfaceColumn(coord.x, coord.z, lod);
+    const float minSurface = column->minY, maxSurface = column->maxY;
+
+    // Conservative uniform test. Density is surfaceY - wy + carve, and carve
+    // (only applied carve_depth+ below the surface) is >= -CAVE_MAX, so:
+    //   entirely above every column's surface            → all air
+    //   entirely CAVE_MAX+ below every column's surface  → all solid
+    // The bound is the graph's: 1.8 for the built-in caves, (1 - 4) * 0.6
+    const float CAVE_MAX = std::max(0.f, -terrainGraph().carveMin());
+    const float wyMin = (float)(coord.y * N) * step;
+    const float wyMax = (float)(coord.y * N + N) * step;
+    if (wyMin >= maxSurface)
+        data.fill = ChunkData::Fill::Air;
+    else if (wyMax + CAVE_MAX + 0.01f < minSurface)
+        data.fill = ChunkData::Fill::Solid;
+    // A spire over open ground or a vault in solid rock is a surface too
+    if (data.fill != ChunkData::Fill::Mixed && Features::structureTouches(Features::chunkBox(coord, lod)))
+        data.fill = ChunkData::Fill::Mixed;
+}
+
+void generateSlab(ChunkData& data, int lod, int x0, int x1) {
+    constexpr int               N      = ChunkData::SIZE;
+    constexpr int               P      = ChunkData::PADDED;
+    const Noise::Graph&         graph  = terrainGraph();
+    const Noise::Graph::Params& params = graph.params();
+    const ChunkCoord            coord  = data.coord;
 
-    constexpr int     N        = ChunkData::SIZE;
-    constexpr int     P        = ChunkData::PADDED;
-    const     int64_t seed     = (int64_t)Config::WORLD_SEED;
-    constexpr float   hscale   = 0.008f;
-    constexpr float   hHeight  = 80.f;
-    constexpr float   seaLevel = 64.f;
-    constexpr float   sandLevel = seaLevel + 4.f;
-    constexpr float   dirtDepth = 4.f;   // voxels below surface = dirt
-    constexpr float   stoneDepth = 10.f; // deeper than this = stone
-
-    for (int x = 0; x < P; x++)
-    for (int z = 0; z < P; z++) {
-        float wx = (float)(coord.x * N + x);
-        float wz = (float)(coord.z * N + z);
-
-        float base    = fbm(seed,         wx * hscale,        0.f, wz * hscale,        4);
-        float detail  = fbm(seed + 111111, wx * hscale * 3.f, 0.f, wz * hscale * 3.f, 3) * 0.25f;
-        float surfaceY = seaLevel + (base + detail) * hHeight;
-
-        for (int y = 0; y < P; y++) {
-            float wy = (float)(coord.y * N + y);
-
-            float cave = 0.f;
-            if (wy < surfaceY - 4.f) {
-                float c1 = fbm(seed + 222222, wx * 0.018f,       wy * 0.018f,       wz * 0.018f,       2);
-                float c2 = fbm(seed + 333333, wx * 0.018f + 5.f, wy * 0.018f + 5.f, wz * 0.018f + 5.f, 2);
-                cave = (1.f - std::abs(c1 * c2) * 4.f) * 0.6f;
+    // LOD cells sample every step blocks. Densities are divided by the step
+    // so they stay in cells per unit: the ±2 clamp then still leaves the
+    // surface's neighbours unclamped and the edge interpolation meaningful.
+    const float step    = (float)(1 << lod);
+    const float invStep = 1.f / step;
+
+    // Column heights — 2D noise only, shared with the rest of the column
+    auto column = surfaceColumn(coord.x, coord.z, lod);
+    const auto& surface = column->surface;
+
+    // Faces a neighbour already sampled: not carved here, copied at the end
+    ChunkFaces faces;
+    if (data.fill == ChunkData::Fill::Mixed) faces = findFaces(coord, lod);
+    auto shared = [&](int f, int i) { return faces[f] && i == ((f & 1) ? P - 1 : 0); };
+
+    for (int x = x0; x < x1; x++) {
+        const float wx = (float)(coord.x * N + x) * step;
+
+        // The carve for the whole x row in one run of the graph, over just
+        // the voxels deep enough to be carved
+        float cave[P][P] = {};
+        if (data.fill == ChunkData::Fill::Mixed && !shared(0, x) && !shared(1, x)) {
+            float cx[P * P], cy[P * P], cz[P * P], carve[P * P];
+            int   idx[P * P];
+            int   n = 0;
+            for (int z = 0; z < P; z++) {
+                if (shared(4, z) || shared(5, z)) continue;
+                float wz = (float)(coord.z * N + z) * step;
+                for (int y = 0; y < P; y++) {
+                    if (shared(2, y) || shared(3, y)) continue;
+                    float wy = (float)(coord.y * N + y) * step;
+                    if (!(wy < surface[x][z] - params.carveDepth)) continue;
+                    cx[n] = wx; cy[n] = wy; cz[n] = wz;
+                    idx[n++] = z * P + y;
+                }
             }
+            graph.carve(cx, cy, cz, carve, n);
+            for (int i = 0; i < n; i++) cave[idx[i] / P][idx[i] % P] = carve[i];
+        }
+
+        for (int z = 0; z < P; z++) {
+            float surfaceY = surface[x][z];
+            for (int y = 0; y < P; y++) {
+                float wy = (float)(coord.y * N + y) * step;
 
-            float density = surfaceY - wy + cave;
-            if (density >  2.f) density =  2.f;
-            if (density < -2.f) density = -2.f;
-            data.values[x][y][z] = -density;
-
-            // Material assignment
-            float depthBelow = surfaceY - wy;
-            uint8_t mat;
-            if (surfaceY <= sandLevel + 2.f) {
-                // Near sea level — sand
-                mat = (uint8_t)BlockMat::Sand;
-            } else if (depthBelow <= 1.f) {
-                // Top layer — grass
-                mat = (uint8_t)BlockMat::Grass;
-            } else if (depthBelow <= dirtDepth) {
-                // Shallow subsurface — dirt
-                mat = (uint8_t)BlockMat::Dirt;
-            } else {
-                // Deep — stone
-                mat = (uint8_t)BlockMat::Stone;
+                ChunkData::Voxel& v = data.at(x, y, z);
+                if (data.fill == ChunkData::Fill::Mixed) {
+                    float density = (surfaceY - wy + cave[z][y]) * invStep;
+                    if (density >  ChunkData::DENSITY_MAX) density =  ChunkData::DENSITY_MAX;
+                    if (density < -ChunkData::DENSITY_MAX) density = -ChunkData::DENSITY_MAX;
+                    v.density = ChunkData::quantize(-density);
+                } else {
+                    v.density = ChunkData::quantize(data.fill == ChunkData::Fill::Air ? ChunkData::DENSITY_MAX
+                                                                                      : -ChunkData::DENSITY_MAX);
+                }
+
+                // Material assignment
+                float depthBelow = surfaceY - wy;
+                uint8_t mat;
+                if (surfaceY <= params.sandTop) {
+                    // Near sea level — sand
+                    mat = (uint8_t)BlockMat::Sand;
+                } else if (depthBelow <= params.grassDepth) {
+                    // Top layer — grass
+                    mat = (uint8_t)BlockMat::Grass;
+                } else if (depthBelow <= params.dirtDepth) {
+                    // Shallow subsurface — dirt
+                    mat = (uint8_t)BlockMat::Dirt;
+                } else {
+                    // Deep — stone
+                    mat = (uint8_t)BlockMat::Stone;
+                }
+                v.material = mat;
             }
-            data.materials[x][y][z] = mat;
         }
     }
 
-    return data;
+    // Then what's placed on it, over the same rows; then the shared faces
+    // over both, as the neighbour made them
+    Features::decorateSlab(data, lod, x0, x1);
+    copyFaces(data, faces, x0, x1);
+}
+
+void publishFaces(const ChunkData& data, int lod) {
+    if (data.fill != ChunkData::Fill::Mixed) return;
+    FaceCache& c = faceCache();
+    std::array<std::shared_ptr<Face>, 6> made;
+    {
+        std::lock_guard lk(c.mu);
+        for (int f = 0; f < 6; f++) {
+            FaceKey key = faceKey(data.coord, lod, f);
+            if (!c.faces.erase(key)) made[f] = std::make_shared<Face>(); // else: both sides are done
+        }
+    }
+    // Copied outside the lock
+    for (int f = 0; f < 6; f++)
+        if (made[f])
+            for (int a = 0; a < P; a++)
+                for (int b = 0; b < P; b++) made[f]->v[a][b] = faceVoxel(data, f, a, b);
+
+    std::lock_guard lk(c.mu);
+    for (int f = 0; f < 6; f++) {
+        if (!made[f]) continue;
+        FaceKey key = faceKey(data.coord, lod, f);
+        if (c.faces.try_emplace(key, std::move(made[f])).second) c.order.push_back(key);
+    }
+    while (c.faces.size() > Config::FACE_CACHE && !c.order.empty()) {
+        c.faces.erase(c.order.front());
+        c.order.pop_front();
+    }
+}
+
+void generateChunk(ChunkData& out, ChunkCoord coord, int lod) {
+    beginChunk(out, coord, lod);
+    generateSlab(out, lod, 0, ChunkData::PADDED);
+    publishFaces(out, lod);
 }
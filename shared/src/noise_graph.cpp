@@ -0,0 +1,355 @@
+#include "noise_graph.h"
+#include "config.h"
+#include "log.h"
+#include "noise_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+
+namespace Noise {
+
+namespace {
+
+// The recipe generateChunk hard-coded before graphs, step for step
+constexpr const char* BUILTIN = R"(
+# Heightmap: a broad fbm and a finer one on top, about sea level
+bx      = mul x 0.008
+bz      = mul z 0.008
+dx      = mul bx 3
+dz      = mul bz 3
+base    = fbm bx 0 bz octaves=4
+detail  = fbm dx 0 dz octaves=3 seed=111111
+fine    = mul detail 0.25
+height  = add base fine
+scaled  = mul height 80
+surface = add scaled 64
+
+# Caves: where two 3D fbms are both near zero
+c1x     = mul x 0.018
+c1y     = mul y 0.018
+c1z     = mul z 0.018
+c2x     = add c1x 5
+c2y     = add c1y 5
+c2z     = add c1z 5
+c1      = fbm c1x c1y c1z octaves=2 seed=222222
+c2      = fbm c2x c2y c2z octaves=2 seed=333333
+both    = mul c1 c2
+near    = abs both
+tunnel  = mul near 4
+open    = sub 1 tunnel
+carve   = mul open 0.6
+
+param sand_top    70
+param grass_depth 1
+param dirt_depth  4
+param carve_depth 4
+)";
+
+constexpr uint16_t X = 0, Y = 1, Z = 2, INPUTS = 3;
+constexpr float    INF = std::numeric_limits<float>::infinity();
+
+struct Operand {
+    bool  number = false;
+    float value  = 0.f;
+    int   node   = -1; // or -1 - input
+};
+
+template<class OpT>
+struct Node {
+    std::string          name;
+    OpT                  op;
+    std::vector<Operand> args;
+    int                  octaves = 4;
+    int64_t              seed    = 0;
+    int                  line    = 0;
+    uint8_t              deps    = 0; // x, y, z bits
+};
+
+struct Range {
+    float lo, hi;
+};
+
+Range add(Range a, Range b) { return {a.lo + b.lo, a.hi + b.hi}; }
+Range sub(Range a, Range b) { return {a.lo - b.hi, a.hi - b.lo}; }
+Range mul(Range a, Range b) {
+    float p[4] = {a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi};
+    for (float v : p)
+        if (std::isnan(v)) return {-INF, INF}; // 0 * inf: anything
+    return {*std::min_element(p, p + 4), *std::max_element(p, p + 4)};
+}
+Range absr(Range a) {
+    if (a.lo >= 0.f) return a;
+    if (a.hi <= 0.f) return {-a.hi, -a.lo};
+    return {0.f, std::max(-a.lo, a.hi)};
+}
+
+void fnv(uint64_t& h, const void* p, size_t n) {
+    const uint8_t* b = static_cast<const uint8_t*>(p);
+    for (size_t i = 0; i < n; i++) h = (h ^ b[i]) * 0x100000001b3ULL;
+}
+
+} // namespace
+
+// ── Parsing ───────────────────────────────────────────────────────────────────
+
+std::optional<Graph> Graph::parse(std::string_view text, std::string& err) {
+    struct OpInfo { const char* name; Op op; int arity; };
+    static const OpInfo OPS[] = {
+        {"fbm", Op::Fbm, 3},     {"ridged", Op::Ridged, 3}, {"add", Op::Add, 2},
+        {"sub", Op::Sub, 2},     {"mul", Op::Mul, 2},       {"abs", Op::Abs, 1},
+        {"warp", Op::Warp, 3},   {"blend", Op::Blend, 3},   {"clamp", Op::Clamp, 3},
+        {"select", Op::Select, 4},
+    };
+
+    std::vector<Node<Op>>                nodes;
+    std::unordered_map<std::string, int> byName;
+    Graph                                g;
+    auto fail = [&](int line, const std::string& why) {
+        err = line ? "line " + std::to_string(line) + ": " + why : why;
+        return std::nullopt;
+    };
+
+    std::istringstream in{std::string(text)};
+    std::string        raw;
+    for (int line = 1; std::getline(in, raw); line++) {
+        if (size_t hash = raw.find('#'); hash != std::string::npos) raw.resize(hash);
+        std::istringstream       ls(raw);
+        std::vector<std::string> tok;
+        for (std::string t; ls >> t;) tok.push_back(t);
+        if (tok.empty()) continue;
+
+        if (tok[0] == "param") {
+            if (tok.size() != 3) return fail(line, "param wants a name and a value");
+            char* end = nullptr;
+            float v   = std::strtof(tok[2].c_str(), &end);
+            if (*end) return fail(line, "not a number: " + tok[2]);
+            if      (tok[1] == "sand_top")    g._params.sandTop    = v;
+            else if (tok[1] == "grass_depth") g._params.grassDepth = v;
+            else if (tok[1] == "dirt_depth")  g._params.dirtDepth  = v;
+            else if (tok[1] == "carve_depth") {
+                if (v < 0.f) return fail(line, "carve_depth can't be negative: carving above the surface");
+                g._params.carveDepth = v;
+            } else return fail(line, "unknown param " + tok[1]);
+            continue;
+        }
+
+        if (tok.size() < 3 || tok[1] != "=") return fail(line, "expected: name = op operands...");
+        if (tok[0] == "x" || tok[0] == "y" || tok[0] == "z" || byName.count(tok[0]))
+            return fail(line, tok[0] + " is already defined");
+        const OpInfo* info = nullptr;
+        for (const OpInfo& o : OPS)
+            if (tok[2] == o.name) info = &o;
+        if (!info) return fail(line, "unknown op " + tok[2]);
+
+        Node<Op> n;
+        n.name = tok[0];
+        n.op   = info->op;
+        n.line = line;
+        for (size_t i = 3; i < tok.size(); i++) {
+            const std::string& t = tok[i];
+            if (size_t eq = t.find('='); eq != std::string::npos) {
+                bool noise = info->op == Op::Fbm || info->op == Op::Ridged;
+                std::string key = t.substr(0, eq), val = t.substr(eq + 1);
+                char* end = nullptr;
+                long long v = std::strtoll(val.c_str(), &end, 10);
+                if (!noise || *end || val.empty()) return fail(line, "unexpected " + t);
+                if (key == "octaves" && v >= 1 && v <= 16) n.octaves = (int)v;
+                else if (key == "seed") n.seed = v;
+                else return fail(line, "unexpected " + t);
+                continue;
+            }
+            Operand a;
+            char* end = nullptr;
+            float v   = std::strtof(t.c_str(), &end);
+            if (end != t.c_str() && !*end) {
+                a.number = true;
+                a.value  = v;
+            } else if (t == "x" || t == "y" || t == "z") {
+                a.node = -1 - (t[0] - 'x');
+                n.deps |= (uint8_t)(1 << (t[0] - 'x'));
+            } else if (auto it = byName.find(t); it != byName.end()) {
+                a.node = it->second;
+                n.deps |= nodes[it->second].deps;
+            } else {
+                return fail(line, t + " isn't defined above");
+            }
+            n.args.push_back(a);
+        }
+        if ((int)n.args.size() != info->arity)
+            return fail(line, std::string(info->name) + " takes " + std::to_string(info->arity) + " operands");
+        byName[n.name] = (int)nodes.size();
+        nodes.push_back(std::move(n));
+    }
+
+    auto surface = byName.find("surface"), carve = byName.find("carve");
+    if (surface == byName.end()) return fail(0, "no surface node");
+    if (carve == byName.end()) return fail(0, "no carve node");
+    if (nodes[surface->second].deps & 2) return fail(nodes[surface->second].line, "surface can't depend on y");
+
+    // One output's tape: the nodes it reaches, in file order
+    auto compile = [&](int outNode, Tape& t) {
+        std::vector<bool> live(nodes.size(), false);
+        live[outNode] = true;
+        for (int i = outNode; i >= 0; i--)
+            if (live[i])
+                for (const Operand& a : nodes[i].args)
+                    if (!a.number && a.node >= 0) live[a.node] = true;
+
+        std::unordered_map<uint32_t, uint16_t> constReg;
+        for (size_t i = 0; i < nodes.size(); i++)
+            if (live[i])
+                for (const Operand& a : nodes[i].args) {
+                    if (!a.number) continue;
+                    uint32_t bits;
+                    std::memcpy(&bits, &a.value, 4);
+                    if (constReg.try_emplace(bits, (uint16_t)(INPUTS + t.consts.size())).second)
+                        t.consts.push_back(a.value);
+                }
+
+        std::vector<Range>    range(INPUTS + t.consts.size(), {-INF, INF});
+        std::vector<uint16_t> regOf(nodes.size(), 0);
+        for (size_t k = 0; k < t.consts.size(); k++) range[INPUTS + k] = {t.consts[k], t.consts[k]};
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (!live[i]) continue;
+            const Node<Op>& n = nodes[i];
+            Step s{};
+            s.op      = n.op;
+            s.octaves = n.octaves;
+            s.seed    = n.seed;
+            Range r[4];
+            for (size_t k = 0; k < n.args.size(); k++) {
+                const Operand& a = n.args[k];
+                if (a.number) {
+                    uint32_t bits;
+                    std::memcpy(&bits, &a.value, 4);
+                    s.src[k] = constReg[bits];
+                } else {
+                    s.src[k] = a.node >= 0 ? regOf[a.node] : (uint16_t)(-1 - a.node);
+                }
+                r[k] = range[s.src[k]];
+            }
+            s.dst    = (uint16_t)range.size();
+            regOf[i] = s.dst;
+            Range out{};
+            switch (n.op) {
+                case Op::Fbm:    out = {-1.f, 1.f}; break;
+                case Op::Ridged: out = {0.f, 1.f}; break;
+                case Op::Add:    out = add(r[0], r[1]); break;
+                case Op::Sub:    out = sub(r[0], r[1]); break;
+                case Op::Mul:    out = mul(r[0], r[1]); break;
+                case Op::Abs:    out = absr(r[0]); break;
+                case Op::Warp:   out = add(r[0], mul(r[1], r[2])); break;
+                case Op::Blend:  out = add(r[0], mul(sub(r[1], r[0]), r[2])); break;
+                case Op::Clamp:
+                    out = {std::min(std::max(r[0].lo, r[1].lo), r[2].hi),
+                           std::max(std::min(r[0].hi, r[2].hi), r[1].lo)};
+                    break;
+                case Op::Select: out = {std::min(r[0].lo, r[1].lo), std::max(r[0].hi, r[1].hi)}; break;
+            }
+            range.push_back(out);
+            t.steps.push_back(s);
+        }
+        t.out  = regOf[outNode];
+        t.regs = (uint16_t)range.size();
+        t.lo   = range[t.out].lo;
+        t.hi   = range[t.out].hi;
+    };
+    compile(surface->second, g._surface);
+    compile(carve->second, g._carve);
+
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const Tape* t : {&g._surface, &g._carve}) {
+        for (const Step& s : t->steps) {
+            fnv(h, &s.op, sizeof(s.op));
+            fnv(h, &s.dst, sizeof(s.dst));
+            fnv(h, s.src, sizeof(s.src));
+            fnv(h, &s.octaves, sizeof(s.octaves));
+            fnv(h, &s.seed, sizeof(s.seed));
+        }
+        fnv(h, t->consts.data(), t->consts.size() * sizeof(float));
+        fnv(h, &t->out, sizeof(t->out));
+    }
+    fnv(h, &g._params, sizeof(g._params));
+    g._hash = h;
+    return g;
+}
+
+const Graph& Graph::builtin() {
+    static const Graph g = [] {
+        std::string err;
+        std::optional<Graph> parsed = parse(BUILTIN, err);
+        if (!parsed) {
+            Log::err("Built-in terrain graph: " + err);
+            std::abort();
+        }
+        return std::move(*parsed);
+    }();
+    return g;
+}
+
+// ── Evaluation ────────────────────────────────────────────────────────────────
+// A batch at a time; every step writes its own register, so each loop is
+// independent of the others and flat enough for the compiler to vectorize
+
+void Graph::run(const Tape& t, const float* x, const float* y, const float* z, float* out, int n) const {
+    thread_local std::vector<float>        scratch;
+    thread_local std::vector<const float*> reg;
+    scratch.resize((size_t)t.regs * BATCH);
+    reg.resize(t.regs);
+    for (size_t k = 0; k < t.consts.size(); k++) {
+        float* c = &scratch[(INPUTS + k) * BATCH];
+        std::fill(c, c + BATCH, t.consts[k]);
+        reg[INPUTS + k] = c;
+    }
+    const int64_t world = (int64_t)Config::WORLD_SEED;
+
+    for (int i0 = 0; i0 < n; i0 += BATCH) {
+        const int m = std::min(BATCH, n - i0);
+        reg[X] = x ? x + i0 : nullptr;
+        reg[Y] = y ? y + i0 : nullptr;
+        reg[Z] = z ? z + i0 : nullptr;
+        for (const Step& s : t.steps) {
+            float*       d = &scratch[(size_t)s.dst * BATCH];
+            const float* a = reg[s.src[0]];
+            const float* b = reg[s.src[1]];
+            const float* c = reg[s.src[2]];
+            switch (s.op) {
+                case Op::Fbm:
+                    fbmSpan(world + s.seed, a, b, c, d, m, s.octaves);
+                    break;
+                case Op::Ridged:
+                    fbmSpan(world + s.seed, a, b, c, d, m, s.octaves);
+                    for (int i = 0; i < m; i++) d[i] = 1.f - std::abs(d[i]);
+                    break;
+                case Op::Add:   for (int i = 0; i < m; i++) d[i] = a[i] + b[i]; break;
+                case Op::Sub:   for (int i = 0; i < m; i++) d[i] = a[i] - b[i]; break;
+                case Op::Mul:   for (int i = 0; i < m; i++) d[i] = a[i] * b[i]; break;
+                case Op::Abs:   for (int i = 0; i < m; i++) d[i] = std::abs(a[i]); break;
+                case Op::Warp:  for (int i = 0; i < m; i++) d[i] = a[i] + b[i] * c[i]; break;
+                case Op::Blend: for (int i = 0; i < m; i++) d[i] = a[i] + (b[i] - a[i]) * c[i]; break;
+                case Op::Clamp: for (int i = 0; i < m; i++) d[i] = std::min(std::max(a[i], b[i]), c[i]); break;
+                case Op::Select: {
+                    const float* th = reg[s.src[3]];
+                    for (int i = 0; i < m; i++) d[i] = c[i] < th[i] ? a[i] : b[i];
+                    break;
+                }
+            }
+            reg[s.dst] = d;
+        }
+        std::memcpy(out + i0, reg[t.out], (size_t)m * sizeof(float));
+    }
+}
+
+void Graph::surface(const float* x, const float* z, float* out, int n) const {
+    run(_surface, x, nullptr, z, out, n);
+}
+
+void Graph::carve(const float* x, const float* y, const float* z, float* out, int n) const {
+    run(_carve, x, y, z, out, n);
+}
+
+} // namespace Noise
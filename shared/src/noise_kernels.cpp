@@ -0,0 +1,195 @@
+#include "noise_kernels.h"
+#include <cmath>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  #include <immintrin.h>
+  #define HAS_AVX2_KERNEL 1
+#endif
+
+namespace Noise {
+
+// ── Scalar reference ──────────────────────────────────────────────────────────
+// The SIMD kernels below mirror these line for line; change both together.
+
+static float hashNoise(int64_t seed, int x, int y, int z) {
+    uint64_t h = (uint64_t)seed;
+    h ^= (uint64_t)(x * 1619 + y * 31337 + z * 6971);
+    h ^= h >> 16;
+    h *= 0x45d9f3b37197344dULL;
+    h ^= h >> 16;
+    return (float)(h & 0xffffff) / (float)0xffffff;
+}
+
+static float smoothstep(float t) { return t * t * (3.f - 2.f * t); }
+
+static float valueNoise(int64_t seed, float x, float y, float z) {
+    int ix = (int)std::floor(x), iy = (int)std::floor(y), iz = (int)std::floor(z);
+    float fx = x - ix, fy = y - iy, fz = z - iz;
+    float ux = smoothstep(fx), uy = smoothstep(fy), uz = smoothstep(fz);
+
+    float v000 = hashNoise(seed, ix,   iy,   iz  );
+    float v100 = hashNoise(seed, ix+1, iy,   iz  );
+    float v010 = hashNoise(seed, ix,   iy+1, iz  );
+    float v110 = hashNoise(seed, ix+1, iy+1, iz  );
+    float v001 = hashNoise(seed, ix,   iy,   iz+1);
+    float v101 = hashNoise(seed, ix+1, iy,   iz+1);
+    float v011 = hashNoise(seed, ix,   iy+1, iz+1);
+    float v111 = hashNoise(seed, ix+1, iy+1, iz+1);
+
+    return v000 + ux*(v100-v000)
+         + uy*(v010-v000 + ux*(v110-v010-v100+v000))
+         + uz*(v001-v000 + ux*(v101-v001-v100+v000)
+             + uy*(v011-v001-v010+v000 + ux*(v111-v011-v101+v001-v110+v010+v100-v000)));
+}
+
+float fbm(int64_t seed, float x, float y, float z, int octaves) {
+    float n = 0.f, amp = 0.5f, freq = 1.f;
+    for (int o = 0; o < octaves; o++) {
+        n   += valueNoise(seed + o * 1000, x*freq, y*freq, z*freq) * amp;
+        amp  *= 0.5f;
+        freq *= 2.f;
+    }
+    return n * 2.f - 1.f;
+}
+
+static void fbmSpanScalar(int64_t seed, const float* xs, const float* ys, const float* zs,
+                          float* out, int n, int octaves) {
+    for (int i = 0; i < n; i++)
+        out[i] = fbm(seed, xs[i], ys[i], zs[i], octaves);
+}
+
+// ── AVX2, 8 samples per iteration ─────────────────────────────────────────────
+
+#if defined(HAS_AVX2_KERNEL)
+
+#define AVX2_FN __attribute__((target("avx2")))
+
+// Low 64 bits of a 64×64 multiply per lane (AVX2 only has 32×32→64)
+AVX2_FN static inline __m256i mullo64(__m256i a, __m256i b) {
+    __m256i lo  = _mm256_mul_epu32(a, b);
+    __m256i t1  = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b);
+    __m256i t2  = _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(_mm256_add_epi64(t1, t2), 32));
+}
+
+// Four 64-bit hashes of sign-extended lattice keys
+AVX2_FN static inline __m256i hash4(__m256i seed, __m128i key) {
+    const __m256i K = _mm256_set1_epi64x((long long)0x45d9f3b37197344dULL);
+    __m256i h = _mm256_xor_si256(seed, _mm256_cvtepi32_epi64(key));
+    h = _mm256_xor_si256(h, _mm256_srli_epi64(h, 16));
+    h = mullo64(h, K);
+    h = _mm256_xor_si256(h, _mm256_srli_epi64(h, 16));
+    return h;
+}
+
+AVX2_FN static inline __m256 hashNoise8(__m256i seed, __m256i key) {
+    __m256i lo = hash4(seed, _mm256_castsi256_si128(key));
+    __m256i hi = hash4(seed, _mm256_extracti128_si256(key, 1));
+    // Gather the low dword of each 64-bit lane back into 8×32
+    const __m256i pick = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    __m256i l32 = _mm256_permutevar8x32_epi32(lo, pick);
+    __m256i h32 = _mm256_permutevar8x32_epi32(hi, pick);
+    __m256i h   = _mm256_permute2x128_si256(l32, h32, 0x20);
+    h = _mm256_and_si256(h, _mm256_set1_epi32(0xffffff));
+    return _mm256_div_ps(_mm256_cvtepi32_ps(h), _mm256_set1_ps((float)0xffffff));
+}
+
+AVX2_FN static inline __m256 corner8(__m256i seed, __m256i key, int dx, int dy, int dz) {
+    return hashNoise8(seed, _mm256_add_epi32(key,
+        _mm256_set1_epi32(dx * 1619 + dy * 31337 + dz * 6971)));
+}
+
+AVX2_FN static inline __m256 add8(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+AVX2_FN static inline __m256 sub8(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+AVX2_FN static inline __m256 mul8(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+
+AVX2_FN static inline __m256 smoothstep8(__m256 t) {
+    __m256 three = _mm256_set1_ps(3.f), two = _mm256_set1_ps(2.f);
+    return _mm256_mul_ps(_mm256_mul_ps(t, t), _mm256_sub_ps(three, _mm256_mul_ps(two, t)));
+}
+
+AVX2_FN static inline __m256 valueNoise8(__m256i seed, __m256 x, __m256 y, __m256 z) {
+    __m256 flx = _mm256_floor_ps(x), fly = _mm256_floor_ps(y), flz = _mm256_floor_ps(z);
+    __m256i ix = _mm256_cvttps_epi32(flx), iy = _mm256_cvttps_epi32(fly), iz = _mm256_cvttps_epi32(flz);
+    __m256 fx = _mm256_sub_ps(x, _mm256_cvtepi32_ps(ix));
+    __m256 fy = _mm256_sub_ps(y, _mm256_cvtepi32_ps(iy));
+    __m256 fz = _mm256_sub_ps(z, _mm256_cvtepi32_ps(iz));
+    __m256 ux = smoothstep8(fx), uy = smoothstep8(fy), uz = smoothstep8(fz);
+
+    // x*1619 + y*31337 + z*6971 wraps the same as the scalar int math, so the
+    // +1 neighbours are just constant offsets from the base key
+    __m256i key = _mm256_add_epi32(
+        _mm256_add_epi32(_mm256_mullo_epi32(ix, _mm256_set1_epi32(1619)),
+                         _mm256_mullo_epi32(iy, _mm256_set1_epi32(31337))),
+        _mm256_mullo_epi32(iz, _mm256_set1_epi32(6971)));
+    __m256 v000 = corner8(seed, key, 0,0,0), v100 = corner8(seed, key, 1,0,0);
+    __m256 v010 = corner8(seed, key, 0,1,0), v110 = corner8(seed, key, 1,1,0);
+    __m256 v001 = corner8(seed, key, 0,0,1), v101 = corner8(seed, key, 1,0,1);
+    __m256 v011 = corner8(seed, key, 0,1,1), v111 = corner8(seed, key, 1,1,1);
+
+    // Same association as the scalar expression, innermost term first
+    __m256 d = add8(sub8(add8(sub8(sub8(v111, v011), v101), v001), v110), v010);
+    d        = sub8(add8(d, v100), v000);
+    __m256 c = add8(add8(sub8(sub8(v011, v001), v010), v000), mul8(ux, d));
+    __m256 b = add8(add8(sub8(v001, v000), mul8(ux, add8(sub8(sub8(v101, v001), v100), v000))),
+                    mul8(uy, c));
+    __m256 a = add8(sub8(v010, v000), mul8(ux, add8(sub8(sub8(v110, v010), v100), v000)));
+
+    __m256 r = add8(v000, mul8(ux, sub8(v100, v000)));
+    r = add8(r, mul8(uy, a));
+    r = add8(r, mul8(uz, b));
+    return r;
+}
+
+AVX2_FN static void fbmSpanAVX2(int64_t seed, const float* xs, const float* ys, const float* zs,
+                                float* out, int n, int octaves) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(xs + i);
+        __m256 y = _mm256_loadu_ps(ys + i);
+        __m256 z = _mm256_loadu_ps(zs + i);
+        __m256 acc = _mm256_setzero_ps();
+        float amp = 0.5f, freq = 1.f;
+        for (int o = 0; o < octaves; o++) {
+            __m256 f = _mm256_set1_ps(freq);
+            __m256i s = _mm256_set1_epi64x((long long)(seed + o * 1000));
+            __m256 v = valueNoise8(s, _mm256_mul_ps(x, f), _mm256_mul_ps(y, f), _mm256_mul_ps(z, f));
+            acc  = _mm256_add_ps(acc, _mm256_mul_ps(v, _mm256_set1_ps(amp)));
+            amp  *= 0.5f;
+            freq *= 2.f;
+        }
+        acc = _mm256_sub_ps(_mm256_mul_ps(acc, _mm256_set1_ps(2.f)), _mm256_set1_ps(1.f));
+        _mm256_storeu_ps(out + i, acc);
+    }
+    // Tail
+    fbmSpanScalar(seed, xs + i, ys + i, zs + i, out + i, n - i, octaves);
+}
+
+#endif // HAS_AVX2_KERNEL
+
+// ── Dispatch ──────────────────────────────────────────────────────────────────
+
+using SpanFn = void(*)(int64_t, const float*, const float*, const float*, float*, int, int);
+
+struct Kernel { SpanFn fn; const char* name; };
+
+static Kernel pickKernel() {
+#if defined(HAS_AVX2_KERNEL)
+    if (__builtin_cpu_supports("avx2")) return {fbmSpanAVX2, "avx2"};
+#endif
+    return {fbmSpanScalar, "scalar"};
+}
+
+static const Kernel& kernel() {
+    static const Kernel k = pickKernel();
+    return k;
+}
+
+void fbmSpan(int64_t seed, const float* xs, const float* ys, const float* zs,
+             float* out, int n, int octaves) {
+    kernel().fn(seed, xs, ys, zs, out, n, octaves);
+}
+
+const char* kernelName() { return kernel().name; }
+
+} // namespace Noise
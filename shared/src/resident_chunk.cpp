@@ -0,0 +1,20 @@
+#include "resident_chunk.h"
+#include <limits>
+
+std::unique_ptr<ResidentChunk> ResidentChunk::fromData(const ChunkData& data) {
+    auto r   = std::make_unique<ResidentChunk>();
+    r->coord = data.coord;
+    r->fill  = data.fill;
+    r->density.build([&](int x, int y, int z) { return data.at(x, y, z).density; },
+                     std::numeric_limits<ChunkData::Density>::max());
+    r->materials.build([&](int x, int y, int z) { return data.at(x, y, z).material; });
+    return r;
+}
+
+void ResidentChunk::decode(ChunkData& out) const {
+    out.coord = coord;
+    out.fill  = fill;
+    density.expand([&](int x, int y, int z, ChunkData::Density v) {
+        out.at(x, y, z) = {v, materials.at(x, y, z)};
+    });
+}
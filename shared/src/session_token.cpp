@@ -0,0 +1,243 @@
+#include "session_token.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+// ── SHA-256 ───────────────────────────────────────────────────────────────────
+// FIPS 180-4, byte input only
+
+namespace {
+    constexpr uint32_t K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+
+    uint32_t rotr(uint32_t x, int n) { return x >> n | x << (32 - n); }
+
+    struct Sha {
+        uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        uint8_t  block[64];
+        size_t   fill  = 0;
+        uint64_t total = 0;
+
+        void compress(const uint8_t* p) {
+            uint32_t w[64];
+            for (int i = 0; i < 16; i++)
+                w[i] = (uint32_t)p[i * 4] << 24 | (uint32_t)p[i * 4 + 1] << 16 | (uint32_t)p[i * 4 + 2] << 8 | p[i * 4 + 3];
+            for (int i = 16; i < 64; i++) {
+                uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ w[i - 15] >> 3;
+                uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ w[i - 2] >> 10;
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+            uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+            for (int i = 0; i < 64; i++) {
+                uint32_t t1 = hh + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+                uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                hh = g; g = f; f = e; e = d + t1;
+                d = c; c = b; b = a; a = t1 + t2;
+            }
+            h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+            h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+        }
+
+        void update(const void* d, size_t len) {
+            const uint8_t* p = static_cast<const uint8_t*>(d);
+            total += len;
+            while (len > 0) {
+                size_t n = std::min(len, sizeof(block) - fill);
+                std::memcpy(block + fill, p, n);
+                fill += n;
+                p += n;
+                len -= n;
+                if (fill == sizeof(block)) {
+                    compress(block);
+                    fill = 0;
+                }
+            }
+        }
+
+        Sha256::Digest finish() {
+            uint64_t bits = total * 8;
+            uint8_t  pad  = 0x80;
+            update(&pad, 1);
+            pad = 0;
+            while (fill != 56) update(&pad, 1);
+            uint8_t len[8];
+            for (int i = 0; i < 8; i++) len[i] = (uint8_t)(bits >> (56 - i * 8));
+            update(len, 8);
+            Sha256::Digest out;
+            for (int i = 0; i < 8; i++)
+                for (int k = 0; k < 4; k++) out[i * 4 + k] = (uint8_t)(h[i] >> (24 - k * 8));
+            return out;
+        }
+    };
+}
+
+Sha256::Digest Sha256::hash(const void* d, size_t len) {
+    Sha s;
+    s.update(d, len);
+    return s.finish();
+}
+
+Sha256::Digest Sha256::hmac(const uint8_t* key, size_t keyLen, const void* d, size_t len) {
+    uint8_t k[64] = {};
+    if (keyLen > sizeof(k)) {
+        Digest kh = hash(key, keyLen);
+        std::memcpy(k, kh.data(), kh.size());
+    } else if (keyLen > 0) {
+        std::memcpy(k, key, keyLen);
+    }
+    uint8_t ipad[64], opad[64];
+    for (int i = 0; i < 64; i++) {
+        ipad[i] = k[i] ^ 0x36;
+        opad[i] = k[i] ^ 0x5c;
+    }
+    Sha inner;
+    inner.update(ipad, sizeof(ipad));
+    inner.update(d, len);
+    Digest ih = inner.finish();
+    Sha outer;
+    outer.update(opad, sizeof(opad));
+    outer.update(ih.data(), ih.size());
+    return outer.finish();
+}
+
+// ── Encodings ─────────────────────────────────────────────────────────────────
+
+static const char B64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+static std::string b64url(const uint8_t* d, size_t len) {
+    std::string out;
+    out.reserve((len * 4 + 2) / 3);
+    uint32_t acc  = 0;
+    int      bits = 0;
+    for (size_t i = 0; i < len; i++) {
+        acc = acc << 8 | d[i];
+        for (bits += 8; bits >= 6; bits -= 6) out += B64[acc >> (bits - 6) & 63];
+    }
+    if (bits > 0) out += B64[acc << (6 - bits) & 63];
+    return out;
+}
+
+// Unpadded; false on any other character
+static bool unb64url(const std::string& s, size_t begin, size_t end, std::string& out) {
+    out.clear();
+    uint32_t acc  = 0;
+    int      bits = 0;
+    for (size_t i = begin; i < end; i++) {
+        char c = s[i];
+        int  v = c >= 'A' && c <= 'Z' ? c - 'A'
+               : c >= 'a' && c <= 'z' ? c - 'a' + 26
+               : c >= '0' && c <= '9' ? c - '0' + 52
+               : c == '-' ? 62 : c == '_' ? 63 : -1;
+        if (v < 0) return false;
+        acc = acc << 6 | (uint32_t)v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out += (char)(acc >> bits & 0xFF);
+        }
+    }
+    return true;
+}
+
+static bool unhex(const std::string& s, std::vector<uint8_t>& out) {
+    if (s.empty() || s.size() % 2) return false;
+    out.clear();
+    auto nib = [](char c) {
+        return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+    };
+    for (size_t i = 0; i < s.size(); i += 2) {
+        int hi = nib(s[i]), lo = nib(s[i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out.push_back((uint8_t)(hi << 4 | lo));
+    }
+    return true;
+}
+
+// ── SessionTokens ─────────────────────────────────────────────────────────────
+
+const char* SessionTokens::name(Result r) {
+    switch (r) {
+        case Result::Valid:        return "valid";
+        case Result::Unsigned:     return "unsigned";
+        case Result::Malformed:    return "malformed";
+        case Result::UnknownKey:   return "unknown key";
+        case Result::BadSignature: return "bad signature";
+        case Result::Expired:      return "expired";
+        case Result::Revoked:      return "revoked";
+    }
+    return "?";
+}
+
+SessionTokens::Result SessionTokens::verify(const std::string& token, int64_t now, Claims& out) const {
+    if (!isSigned(token)) return Result::Unsigned;
+    size_t a = token.find('.', 3);
+    size_t b = a == std::string::npos ? a : token.find('.', a + 1);
+    if (b == std::string::npos || token.find('.', b + 1) != std::string::npos) return Result::Malformed;
+
+    auto key = _keys.find(token.substr(3, a - 3));
+    if (key == _keys.end()) return Result::UnknownKey;
+
+    std::string sig;
+    if (!unb64url(token, b + 1, token.size(), sig) || sig.size() != 32) return Result::Malformed;
+    Sha256::Digest want = Sha256::hmac(key->second.data(), key->second.size(), token.data(), b);
+    uint8_t diff = 0; // every byte, so the time taken says nothing about the signature
+    for (size_t i = 0; i < want.size(); i++) diff |= want[i] ^ (uint8_t)sig[i];
+    if (diff) return Result::BadSignature;
+
+    std::string claims;
+    if (!unb64url(token, a + 1, b, claims)) return Result::Malformed;
+    std::string f[4];
+    size_t      at = 0;
+    for (int i = 0; i < 4; i++) {
+        size_t nl = i < 3 ? claims.find('\n', at) : claims.size();
+        if (nl == std::string::npos) return Result::Malformed;
+        f[i] = claims.substr(at, nl - at);
+        at   = nl + 1;
+    }
+    char* end = nullptr;
+    out.uid      = std::move(f[0]);
+    out.username = std::move(f[1]);
+    out.expires  = std::strtoll(f[2].c_str(), &end, 10);
+    out.session  = std::move(f[3]);
+    if (out.uid.empty() || end == f[2].c_str() || *end) return Result::Malformed;
+    if (now >= out.expires) return Result::Expired;
+    if (_revoked.count(out.session)) return Result::Revoked;
+    return Result::Valid;
+}
+
+bool SessionTokens::setKeys(const std::string& text) {
+    std::unordered_map<std::string, std::vector<uint8_t>> keys;
+    std::istringstream in(text);
+    std::string kid, hex;
+    std::vector<uint8_t> key;
+    for (std::string line; std::getline(in, line);) {
+        std::istringstream l(line);
+        if (l >> kid >> hex && kid[0] != '#' && unhex(hex, key)) keys[kid] = key;
+    }
+    if (keys.empty()) return false;
+    _keys = std::move(keys);
+    return true;
+}
+
+void SessionTokens::setRevoked(const std::string& text) {
+    _revoked.clear();
+    std::istringstream in(text);
+    for (std::string s; in >> s;) _revoked.insert(s);
+}
+
+std::string SessionTokens::sign(const std::string& kid, const std::vector<uint8_t>& key, const Claims& c) {
+    std::string claims = c.uid + "\n" + c.username + "\n" + std::to_string(c.expires) + "\n" + c.session;
+    std::string head   = "v1." + kid + "." + b64url((const uint8_t*)claims.data(), claims.size());
+    Sha256::Digest sig = Sha256::hmac(key.data(), key.size(), head.data(), head.size());
+    return head + "." + b64url(sig.data(), sig.size());
+}
@@ -0,0 +1,190 @@
+#include "terrain_query.h"
+#include "packets.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static constexpr int    S         = ChunkData::SIZE;
+static constexpr int    P         = ChunkData::PADDED;
+static constexpr float  INV_SCALE = 1.f / ChunkFieldPacket::DENSITY_SCALE;
+static constexpr int8_t SAT       = 127; // quantizeDensity's clamp, where the generator saturates
+
+static int floorDiv(int v, int d) { return v >= 0 ? v / d : -((-v + d - 1) / d); }
+
+static glm::ivec3 cellOf(glm::vec3 p) {
+    return {(int)std::floor(p.x), (int)std::floor(p.y), (int)std::floor(p.z)};
+}
+static ChunkCoord chunkOf(glm::ivec3 cell) {
+    return {floorDiv(cell.x, S), floorDiv(cell.y, S), floorDiv(cell.z, S)};
+}
+
+std::unique_ptr<DensityField> DensityField::fromData(const ChunkData& data) {
+    auto f   = std::make_unique<DensityField>();
+    f->coord = data.coord;
+    f->fill  = data.fill;
+    if (data.fill != ChunkData::Fill::Mixed) return f;
+    f->density.build([&](int x, int y, int z) { return ChunkFieldPacket::toWire(data.at(x, y, z).density); }, SAT);
+    return f;
+}
+
+std::unique_ptr<DensityField> DensityField::fromPayload(const uint8_t* d, size_t len) {
+    if (len == 0) return nullptr;
+    auto f = std::make_unique<DensityField>();
+    if (d[0] == (uint8_t)PacketID::ChunkUniform) {
+        if (len < 14) return nullptr;
+        ChunkUniformPacket u = ChunkUniformPacket::deserialize(d, len);
+        if (u.fill == ChunkData::Fill::Mixed) return nullptr;
+        f->coord = u.coord;
+        f->fill  = u.fill;
+        return f;
+    }
+    if (d[0] != (uint8_t)PacketID::ChunkField || len < ChunkFieldPacket::HEADER_BYTES) return nullptr;
+    size_t o = 2;
+    f->coord.x = readI32(d, o); f->coord.y = readI32(d, o); f->coord.z = readI32(d, o);
+    f->fill = ChunkData::Fill::Mixed;
+    // Decoded dense, then kept sparse
+    static thread_local std::vector<int8_t> dense(ChunkFieldPacket::VOXELS);
+    if (!ChunkFieldPacket::deserializeDensities(d, len, dense.data())) return nullptr;
+    f->density.build([&](int x, int y, int z) { return dense[((size_t)x * P + z) * P + y]; }, SAT);
+    return f;
+}
+
+// One query's chunks. A box straddling a corner touches up to eight, and a
+// sample picks between them at random, so the last few are kept.
+struct TerrainQuery::Walk {
+    const TerrainQuery& q;
+    struct Seen {
+        ChunkCoord          coord;
+        const DensityField* field;
+    };
+    Seen seen[4];
+    int  count = 0, next = 0;
+
+    explicit Walk(const TerrainQuery& query) : q(query) {}
+
+    const DensityField* chunk(ChunkCoord c) {
+        for (int i = 0; i < count; i++)
+            if (seen[i].coord == c) return seen[i].field;
+        Seen& s = seen[next];
+        next    = (next + 1) % 4;
+        count   = std::min(count + 1, 4);
+        s       = {c, q._lookup(c)};
+        return s.field;
+    }
+
+    float sample(glm::vec3 p) {
+        glm::ivec3 cell = cellOf(p);
+        ChunkCoord c    = chunkOf(cell);
+        const DensityField* f = chunk(c);
+        if (!f || f->fill == ChunkData::Fill::Air) return ChunkData::DENSITY_MAX;
+        if (f->fill == ChunkData::Fill::Solid) return -ChunkData::DENSITY_MAX;
+
+        // The cell's eight samples: y innermost, then z, then x
+        const int   x = cell.x - c.x * S, y = cell.y - c.y * S, z = cell.z - c.z * S;
+        const float tx = p.x - (float)cell.x, ty = p.y - (float)cell.y, tz = p.z - (float)cell.z;
+        auto lerp = [](float a, float b, float t) { return a + (b - a) * t; };
+        auto edge = [&](int dx, int dz) { return lerp(f->at(x + dx, y, z + dz), f->at(x + dx, y + 1, z + dz), ty); };
+        float v00 = edge(0, 0), v01 = edge(0, 1), v10 = edge(1, 0), v11 = edge(1, 1);
+        return lerp(lerp(v00, v01, tz), lerp(v10, v11, tz), tx) * INV_SCALE;
+    }
+};
+
+float TerrainQuery::sample(glm::vec3 p) const {
+    Walk w(*this);
+    return w.sample(p);
+}
+
+glm::vec3 TerrainQuery::normal(glm::vec3 p) const {
+    constexpr float h = 0.5f;
+    Walk w(*this);
+    glm::vec3 g{w.sample(p + glm::vec3(h, 0.f, 0.f)) - w.sample(p - glm::vec3(h, 0.f, 0.f)),
+                w.sample(p + glm::vec3(0.f, h, 0.f)) - w.sample(p - glm::vec3(0.f, h, 0.f)),
+                w.sample(p + glm::vec3(0.f, 0.f, h)) - w.sample(p - glm::vec3(0.f, 0.f, h))};
+    float len = glm::length(g);
+    return len > 1e-6f ? g / len : glm::vec3(0.f, 1.f, 0.f);
+}
+
+TerrainHit TerrainQuery::raycast(glm::vec3 origin, glm::vec3 dir, float maxDist) const {
+    TerrainHit hit;
+    float len = glm::length(dir);
+    if (len <= 0.f || maxDist < 0.f) return hit;
+    dir /= len;
+
+    Walk  w(*this);
+    float t = 0.f, d = w.sample(origin);
+    if (d >= 0.f) {
+        float out = 0.f; // last t known outside
+        while (true) {
+            glm::vec3  p = origin + dir * t;
+            ChunkCoord c = chunkOf(cellOf(p));
+            const DensityField* f = w.chunk(c);
+
+            // A uniform or missing chunk has no surface in it: straight to
+            // its far side. (Not a solid one — p would be inside it.)
+            float step;
+            if (!f || f->fill != ChunkData::Fill::Mixed) {
+                step = std::numeric_limits<float>::max();
+                const int cc[3] = {c.x, c.y, c.z};
+                for (int a = 0; a < 3; a++) {
+                    if (dir[a] > 0.f)      step = std::min(step, ((float)((cc[a] + 1) * S) - p[a]) / dir[a]);
+                    else if (dir[a] < 0.f) step = std::min(step, ((float)(cc[a] * S) - p[a]) / dir[a]);
+                }
+                step = std::max(step, 0.f) + 1e-3f;
+            } else {
+                step = std::max(d / Config::TERRAIN_RAY_LIPSCHITZ, Config::TERRAIN_RAY_MIN_STEP);
+            }
+
+            float tn = std::min(t + step, maxDist);
+            float dn = w.sample(origin + dir * tn);
+            if (dn < 0.f) {
+                out = t;
+                t   = tn;
+                break;
+            }
+            if (tn >= maxDist) return hit;
+            t = tn;
+            d = dn;
+        }
+        // The crossing is between out and t
+        for (int i = 0; i < 10; i++) {
+            float mid = 0.5f * (out + t);
+            (w.sample(origin + dir * mid) < 0.f ? t : out) = mid;
+        }
+    }
+    hit.hit    = true;
+    hit.t      = t;
+    hit.pos    = origin + dir * t;
+    hit.normal = normal(hit.pos);
+    return hit;
+}
+
+bool TerrainQuery::overlaps(glm::vec3 lo, glm::vec3 hi) const {
+    Walk w(*this);
+
+    // All air or unloaded: nothing to sample. Any solid chunk: inside.
+    ChunkCoord c0 = chunkOf(cellOf(lo)), c1 = chunkOf(cellOf(hi));
+    bool       mixed = false;
+    for (int cx = c0.x; cx <= c1.x; cx++)
+        for (int cy = c0.y; cy <= c1.y; cy++)
+            for (int cz = c0.z; cz <= c1.z; cz++) {
+                const DensityField* f = w.chunk({cx, cy, cz});
+                if (!f) continue;
+                if (f->fill == ChunkData::Fill::Solid) return true;
+                mixed |= f->fill == ChunkData::Fill::Mixed;
+            }
+    if (!mixed) return false;
+
+    // Per axis: lo, each lattice plane strictly inside, hi
+    auto next = [](float v, float end) { return std::min(std::floor(v) + 1.f, end); };
+    for (float x = lo.x;; x = next(x, hi.x)) {
+        for (float y = lo.y;; y = next(y, hi.y)) {
+            for (float z = lo.z;; z = next(z, hi.z)) {
+                if (w.sample({x, y, z}) < 0.f) return true;
+                if (z >= hi.z) break;
+            }
+            if (y >= hi.y) break;
+        }
+        if (x >= hi.x) break;
+    }
+    return false;
+}
@@ -0,0 +1,249 @@
+#include "world_features.h"
+#include "config.h"
+#include "noise_gen.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Features {
+
+namespace {
+
+// Ores: which, how many per cell, how big, and how deep they have to be
+// (below the ground right above them)
+constexpr int   ORE_CELL    = 32;
+constexpr float ORE_REACH   = 2.5f; // largest vein radius
+constexpr int   ORE_MAX_LOD = 1;    // past it a vein is smaller than a sample
+struct OreRule {
+    Origin::Kind kind;
+    int          perCell;
+    float        rMin, rMax;
+    float        minDepth;
+};
+constexpr OreRule ORES[] = {
+    {Origin::Kind::Coal, 5, 1.2f, 2.5f, 4.f},
+    {Origin::Kind::Iron, 2, 1.0f, 2.0f, 24.f},
+};
+
+// Structures: at most one of each per STRUCTURE_CELL² column of the world
+constexpr int   STRUCTURE_CELL  = 128;
+constexpr float STRUCTURE_REACH = 9.f; // widest, from its origin
+constexpr float SPIRE_CHANCE    = 0.35f;
+constexpr float VAULT_CHANCE    = 0.5f;
+
+// Layers of the random streams, so a cell's ores and structures never
+// share one
+constexpr uint32_t LAYER_ORE       = 1;
+constexpr uint32_t LAYER_STRUCTURE = 2;
+
+// splitmix64 over the cell: the same draws for the same cell, whoever asks
+struct Stream {
+    uint64_t s;
+    Stream(ChunkCoord cell, uint32_t layer)
+        : s(mixHash(packCoord(cell) ^ mixHash((uint64_t)(uint32_t)Config::WORLD_SEED << 8 | layer))) {}
+    uint64_t next() { return mixHash(s += 0x9e3779b97f4a7c15ull); }
+    float    unit() { return (float)(next() >> 40) * (1.f / (float)(1 << 24)); }
+    float    range(float lo, float hi) { return lo + (hi - lo) * unit(); }
+};
+
+float groundAt(float x, float z) {
+    float y;
+    surfaceHeights(&x, &z, &y, 1);
+    return y;
+}
+
+Box bounds(const Origin& o) {
+    switch (o.kind) {
+        case Origin::Kind::Spire:
+            return {o.x - o.radius, o.y, o.z - o.radius, o.x + o.radius, o.y + o.height, o.z + o.radius};
+        case Origin::Kind::Vault:
+            return {o.x - o.radius, o.y - o.radius * 0.5f, o.z - o.radius,
+                    o.x + o.radius, o.y + o.radius,        o.z + o.radius};
+        default:
+            return {o.x - o.radius, o.y - o.radius, o.z - o.radius, o.x + o.radius, o.y + o.radius, o.z + o.radius};
+    }
+}
+
+bool overlaps(const Box& a, const Box& b) {
+    return a.x0 <= b.x1 && b.x0 <= a.x1 && a.y0 <= b.y1 && b.y0 <= a.y1 && a.z0 <= b.z1 && b.z0 <= a.z1;
+}
+
+void oreCell(ChunkCoord c, std::vector<Origin>& out) {
+    Stream rng(c, LAYER_ORE);
+    for (const OreRule& r : ORES)
+        for (int i = 0; i < r.perCell; i++) {
+            Origin o{};
+            o.kind   = r.kind;
+            o.x      = (float)(c.x * ORE_CELL) + rng.range(0.f, (float)ORE_CELL);
+            o.y      = (float)(c.y * ORE_CELL) + rng.range(0.f, (float)ORE_CELL);
+            o.z      = (float)(c.z * ORE_CELL) + rng.range(0.f, (float)ORE_CELL);
+            o.radius = rng.range(r.rMin, r.rMax);
+            out.push_back(o);
+        }
+}
+
+// Every draw is made whether or not the structure is placed, so a change
+// to one chance doesn't move the other structure
+void structureCell(int cx, int cz, std::vector<Origin>& out) {
+    Stream rng({cx, 0, cz}, LAYER_STRUCTURE);
+    const float cell = (float)STRUCTURE_CELL;
+    const float edge = STRUCTURE_REACH; // kept inside the cell
+
+    float spireRoll = rng.unit();
+    Origin spire{Origin::Kind::Spire, (float)cx * cell + rng.range(edge, cell - edge), 0.f,
+                 (float)cz * cell + rng.range(edge, cell - edge), rng.range(1.5f, 3.f), rng.range(10.f, 22.f)};
+    float vaultRoll = rng.unit();
+    Origin vault{Origin::Kind::Vault, (float)cx * cell + rng.range(edge, cell - edge), 0.f,
+                 (float)cz * cell + rng.range(edge, cell - edge), rng.range(5.f, STRUCTURE_REACH), 0.f};
+    float vaultDepth = rng.range(18.f, 58.f);
+
+    if (spireRoll < SPIRE_CHANCE) {
+        spire.y = groundAt(spire.x, spire.z) - 3.f; // sunk, so it stands on a slope too
+        out.push_back(spire);
+    }
+    if (vaultRoll < VAULT_CHANCE) {
+        vault.y = groundAt(vault.x, vault.z) - vaultDepth;
+        out.push_back(vault);
+    }
+}
+
+int cellOf(float v, int cell) { return (int)std::floor(v / (float)cell); }
+
+void structuresNear(const Box& box, std::vector<Origin>& out) {
+    const float reach = STRUCTURE_REACH;
+    for (int cx = cellOf(box.x0 - reach, STRUCTURE_CELL); cx <= cellOf(box.x1 + reach, STRUCTURE_CELL); cx++)
+        for (int cz = cellOf(box.z0 - reach, STRUCTURE_CELL); cz <= cellOf(box.z1 + reach, STRUCTURE_CELL); cz++) {
+            size_t first = out.size();
+            structureCell(cx, cz, out);
+            out.erase(std::remove_if(out.begin() + (ptrdiff_t)first, out.end(),
+                                     [&](const Origin& o) { return !overlaps(bounds(o), box); }),
+                      out.end());
+        }
+}
+
+// Sample indices along one axis of the chunk whose positions fall in
+// [lo, hi], clipped to [first, last]
+void span(float lo, float hi, float origin, float step, int first, int last, int& i0, int& i1) {
+    i0 = std::max(first, (int)std::ceil((lo - origin) / step));
+    i1 = std::min(last, (int)std::floor((hi - origin) / step));
+}
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────────────────────────
+
+void near(const Box& box, bool withOres, std::vector<Origin>& out) {
+    structuresNear(box, out);
+    if (!withOres) return;
+    const float reach = ORE_REACH;
+    for (int cx = cellOf(box.x0 - reach, ORE_CELL); cx <= cellOf(box.x1 + reach, ORE_CELL); cx++)
+        for (int cy = cellOf(box.y0 - reach, ORE_CELL); cy <= cellOf(box.y1 + reach, ORE_CELL); cy++)
+            for (int cz = cellOf(box.z0 - reach, ORE_CELL); cz <= cellOf(box.z1 + reach, ORE_CELL); cz++) {
+                size_t first = out.size();
+                oreCell({cx, cy, cz}, out);
+                out.erase(std::remove_if(out.begin() + (ptrdiff_t)first, out.end(),
+                                         [&](const Origin& o) { return !overlaps(bounds(o), box); }),
+                          out.end());
+            }
+}
+
+bool structureTouches(const Box& box) {
+    thread_local std::vector<Origin> found; // per worker, reused
+    found.clear();
+    structuresNear(box, found);
+    return !found.empty();
+}
+
+Box chunkBox(ChunkCoord coord, int lod) {
+    constexpr int N    = ChunkData::SIZE;
+    const float   step = (float)(1 << lod);
+    return {(float)(coord.x * N) * step, (float)(coord.y * N) * step, (float)(coord.z * N) * step,
+            (float)(coord.x * N + N) * step, (float)(coord.y * N + N) * step, (float)(coord.z * N + N) * step};
+}
+
+void decorateSlab(ChunkData& data, int lod, int x0, int x1) {
+    constexpr int P = ChunkData::PADDED;
+    if (data.fill != ChunkData::Fill::Mixed || x0 >= x1) return;
+    const ChunkCoord coord   = data.coord;
+    const float      step    = (float)(1 << lod);
+    const float      invStep = 1.f / step;
+    const Box        whole   = chunkBox(coord, lod);
+    const float      ox = whole.x0, oy = whole.y0, oz = whole.z0;
+
+    // A structure's density saturates DENSITY_MAX cells out; anything it
+    // changes is within that of its shape
+    const float pad = ChunkData::DENSITY_MAX * step;
+    Box slab = whole;
+    slab.x0  = ox + (float)x0 * step;
+    slab.x1  = ox + (float)(x1 - 1) * step;
+    Box reach{slab.x0 - pad, slab.y0 - pad, slab.z0 - pad, slab.x1 + pad, slab.y1 + pad, slab.z1 + pad};
+
+    thread_local std::vector<Origin> found; // per worker, reused
+    found.clear();
+    near(reach, lod <= ORE_MAX_LOD, found);
+    if (found.empty()) return;
+    auto column = surfaceColumn(coord.x, coord.z, lod);
+    const auto& surface = column->surface;
+
+    // Veins first, then what's cut out, then what's built up; within a kind
+    // by position, so a sample on a shared face comes out the same from
+    // either chunk whatever order their queries listed the features in
+    auto rank = [](Origin::Kind k) { return k == Origin::Kind::Vault ? 1 : k == Origin::Kind::Spire ? 2 : 0; };
+    std::sort(found.begin(), found.end(), [&](const Origin& a, const Origin& b) {
+        if (rank(a.kind) != rank(b.kind)) return rank(a.kind) < rank(b.kind);
+        if (a.x != b.x) return a.x < b.x;
+        if (a.y != b.y) return a.y < b.y;
+        return a.z < b.z;
+    });
+
+    for (const Origin& o : found) {
+        const bool vein = o.kind == Origin::Kind::Coal || o.kind == Origin::Kind::Iron;
+        Box b = bounds(o);
+        if (!vein) b = {b.x0 - pad, b.y0 - pad, b.z0 - pad, b.x1 + pad, b.y1 + pad, b.z1 + pad};
+        int ix0, ix1, iy0, iy1, iz0, iz1;
+        span(b.x0, b.x1, ox, step, x0, x1 - 1, ix0, ix1);
+        span(b.y0, b.y1, oy, step, 0, P - 1, iy0, iy1);
+        span(b.z0, b.z1, oz, step, 0, P - 1, iz0, iz1);
+
+        float minDepth = 0.f;
+        for (const OreRule& r : ORES)
+            if (r.kind == o.kind) minDepth = r.minDepth;
+
+        for (int x = ix0; x <= ix1; x++)
+        for (int z = iz0; z <= iz1; z++) {
+            const float dx = ox + (float)x * step - o.x;
+            const float dz = oz + (float)z * step - o.z;
+            for (int y = iy0; y <= iy1; y++) {
+                const float wy = oy + (float)y * step;
+                const float dy = wy - o.y;
+                ChunkData::Voxel& v = data.at(x, y, z);
+                switch (o.kind) {
+                    case Origin::Kind::Coal:
+                    case Origin::Kind::Iron:
+                        if (dx * dx + dy * dy + dz * dz < o.radius * o.radius && v.density < 0 &&
+                            v.material == (uint8_t)BlockMat::Stone && surface[x][z] - wy >= minDepth)
+                            v.material = (uint8_t)(o.kind == Origin::Kind::Coal ? BlockMat::Coal : BlockMat::Iron);
+                        break;
+                    case Origin::Kind::Vault: {
+                        // A dome over a flat floor halfway down the sphere
+                        float sdf = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - o.radius,
+                                             (o.y - o.radius * 0.5f) - wy);
+                        v.density = std::max(v.density, ChunkData::quantize(-sdf * invStep));
+                        break;
+                    }
+                    case Origin::Kind::Spire: {
+                        // Tapering to 40% at the top
+                        float t   = std::clamp((wy - o.y) / o.height, 0.f, 1.f);
+                        float sdf = std::max(std::sqrt(dx * dx + dz * dz) - o.radius * (1.f - 0.6f * t),
+                                             std::max(o.y - wy, wy - (o.y + o.height)));
+                        ChunkData::Density q = ChunkData::quantize(sdf * invStep);
+                        if (q < v.density) v.density = q;
+                        if (sdf < step) v.material = (uint8_t)BlockMat::Stone;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace Features
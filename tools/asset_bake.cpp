@@ -0,0 +1,81 @@
+// tools/asset_bake.cpp
+// Offline GLB -> .aeb baker. Does the glTF parse, mesh merge and (for the
+// player) material atlas the client would otherwise do at startup, and writes
+// the result as an AssetBlob the client mmaps and uploads as-is.
+//
+// Build:
+//   meson target 'asset_bake', or
+//   g++ -std=c++20 -Ishared/include -Ithirdparty -Ithirdparty/tinygltf
+//       -o asset_bake tools/asset_bake.cpp shared/src/gltf_loader.cpp
+//
+// Usage:
+//   ./asset_bake --viewmodel arm.glb            # writes arm.aeb
+//   ./asset_bake --player player.glb out.aeb    # custom output path
+//
+// Re-run after changing the .glb — the client ignores a blob whose source
+// size or mtime no longer match.
+
+#define TINYGLTF_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "asset_blob.h"
+#include "gltf_loader.h"
+#include "player_model.h"
+
+static int usage() {
+    fprintf(stderr, "usage: asset_bake --viewmodel|--player <in.glb> [out.aeb]\n");
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) return usage();
+    const char* mode = argv[1];
+    std::string src  = argv[2];
+    std::string out  = argc > 3 ? argv[3] : AssetBlob::pathFor(src);
+
+    AssetBlob::Contents c;
+    GltfMesh   vm;
+    PlayerMesh pm;
+
+    if (strcmp(mode, "--viewmodel") == 0) {
+        GltfModel model = loadGlb(src.c_str());
+        if (!model.valid) { fprintf(stderr, "failed to load %s\n", src.c_str()); return 1; }
+        vm = mergeMeshes(model);
+        if (vm.vertices.empty()) { fprintf(stderr, "%s has no geometry\n", src.c_str()); return 1; }
+        glm::vec3 mn(1e9f), mx(-1e9f);
+        for (auto& v : vm.vertices) { mn = glm::min(mn, v.pos); mx = glm::max(mx, v.pos); }
+        c.vertices     = vm.vertices.data();
+        c.vertexStride = sizeof(GltfVertex);
+        c.vertexCount  = vm.vertices.size();
+        c.indices      = vm.indices.data();
+        c.indexCount   = vm.indices.size();
+        c.boundsMin    = mn;
+        c.boundsMax    = mx;
+    } else if (strcmp(mode, "--player") == 0) {
+        if (!buildPlayerMesh(src.c_str(), pm)) { fprintf(stderr, "failed to build %s\n", src.c_str()); return 1; }
+        c.vertices     = pm.verts.data();
+        c.vertexStride = sizeof(PlayerVertex);
+        c.vertexCount  = pm.verts.size();
+        c.indices      = pm.inds.data();
+        c.indexCount   = pm.inds.size();
+        c.texture      = pm.atlas.data();
+        c.textureW     = (uint32_t)pm.atlasW;
+        c.textureH     = (uint32_t)pm.atlasH;
+        c.boundsMin    = pm.boundsMin;
+        c.boundsMax    = pm.boundsMax;
+        c.jointCount   = pm.jointCount;
+    } else {
+        return usage();
+    }
+
+    if (!AssetBlob::write(out.c_str(), src.c_str(), c)) {
+        fprintf(stderr, "failed to write %s\n", out.c_str());
+        return 1;
+    }
+    printf("%s -> %s: %zu verts, %zu indices%s\n", src.c_str(), out.c_str(),
+           c.vertexCount, c.indexCount, c.texture ? ", atlas" : "");
+    return 0;
+}
@@ -0,0 +1,555 @@
+// tools/bench.cpp
+// Micro-benchmarks for the shared hot paths: chunk generation, meshing, the
+// chunk wire formats, the thread pool, the chunk tables, the collision
+// queries the PlayerController runs, the server's density-field versions
+// of them, and random reads under each BigPages mode. No window, no
+// Vulkan, no network.
+//
+// Each benchmark repeats its op until --min-time has passed and reports the
+// mean wall time per op. Results go to stdout as JSON in Google Benchmark's
+// layout ("context" + "benchmarks" with real_time/cpu_time/time_unit), so
+// existing compare scripts can diff two runs; a readable table goes to
+// stderr.
+//
+// Build:
+//   meson target 'bench', or
+//   g++ -std=c++20 -O2 -Ishared/include -Iclient/include -o bench
+//       tools/bench.cpp client/src/collide_kernels.cpp shared/src/chunk.cpp
+//       shared/src/marching_cubes.cpp shared/src/noise_gen.cpp
+//       shared/src/noise_kernels.cpp shared/src/terrain_query.cpp
+//       shared/src/big_pages.cpp -lpthread
+//
+// Usage:
+//   ./bench                        # everything, 0.25 s per benchmark
+//   ./bench --filter march         # names containing "march"
+//   ./bench --min-time 1 --out base.json
+//
+// Chunk sizes are a build option (meson -Dchunk_size=16|32|64); the spans
+// below are in blocks, so runs of differently built benches cover the same
+// world and compare op for op.
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "big_pages.h"
+#include "chunk_collider.h"
+#include "collide_kernels.h"
+#include "config.h"
+#include "flat_map.h"
+#include "marching_cubes.h"
+#include "noise_gen.h"
+#include "noise_kernels.h"
+#include "packets.h"
+#include "terrain_query.h"
+#include "thread_pool.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps results alive so the optimiser can't drop the work
+volatile uint64_t g_sink = 0;
+void keep(uint64_t v) { g_sink = g_sink + v; }
+
+struct Result {
+    std::string name;
+    uint64_t    iterations;
+    double      realNs;  // per op
+    double      cpuNs;   // per op, process CPU time (all threads)
+    double      itemsPerSec;
+    // Sizes of what an op makes, as Google Benchmark's user counters
+    std::vector<std::pair<std::string, double>> counters;
+};
+
+class Runner {
+public:
+    double      minTime = 0.25;
+    std::string filter;
+
+    // op() is one iteration; items is how many units of work it does, for
+    // the throughput column (chunks, tasks, queries). The result, for
+    // counters, or null when the filter skips it.
+    template<class F>
+    Result* run(const std::string& name, uint64_t items, F&& op) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) return nullptr;
+        op(); // warm caches and lazily built tables
+
+        uint64_t iters = 0;
+        auto     t0 = Clock::now();
+        std::clock_t c0 = std::clock();
+        double   elapsed;
+        do {
+            op();
+            iters++;
+            elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+        } while (elapsed < minTime);
+        double cpu = (double)(std::clock() - c0) / CLOCKS_PER_SEC;
+
+        Result r{name, iters, elapsed * 1e9 / iters, cpu * 1e9 / iters,
+                 (double)items * iters / elapsed};
+        fprintf(stderr, "%-28s %10llu  %12.0f ns  %12.0f items/s\n", r.name.c_str(),
+                (unsigned long long)r.iterations, r.realNs, r.itemsPerSec);
+        _results.push_back(std::move(r));
+        return &_results.back();
+    }
+
+    static void counter(Result* r, const char* name, double value) {
+        if (!r) return;
+        r->counters.push_back({name, value});
+        fprintf(stderr, "%-28s %10s  %12.0f %s\n", "", "", value, name);
+    }
+
+    void writeJson(FILE* f) const {
+        char date[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+        fprintf(f, "{\n  \"context\": {\n");
+        fprintf(f, "    \"date\": \"%s\",\n", date);
+        fprintf(f, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+        fprintf(f, "    \"noise_kernel\": \"%s\",\n", Noise::kernelName());
+        fprintf(f, "    \"collide_kernel\": \"%s\",\n", Collide::kernelName());
+        fprintf(f, "    \"density_bits\": %d,\n", Config::CHUNK_DENSITY_BITS);
+        fprintf(f, "    \"chunk_size\": %d,\n", Config::CHUNK_SIZE);
+        fprintf(f, "    \"min_time\": %g\n  },\n  \"benchmarks\": [\n", minTime);
+        for (size_t i = 0; i < _results.size(); i++) {
+            const Result& r = _results[i];
+            fprintf(f, "    {\"name\": \"%s\", \"run_type\": \"iteration\", \"iterations\": %llu, "
+                       "\"real_time\": %.1f, \"cpu_time\": %.1f, \"time_unit\": \"ns\", "
+                       "\"items_per_second\": %.1f",
+                    r.name.c_str(), (unsigned long long)r.iterations, r.realNs, r.cpuNs, r.itemsPerSec);
+            for (const auto& [key, value] : r.counters) fprintf(f, ", \"%s\": %.0f", key.c_str(), value);
+            fprintf(f, "}%s\n", i + 1 < _results.size() ? "," : "");
+        }
+        fprintf(f, "  ]\n}\n");
+    }
+
+private:
+    std::vector<Result> _results;
+};
+
+// Chunk coords by what the generator makes of them around spawn: the
+// surface band (y 0-128) is mixed, y 192-256 is open sky, y -128 to -64 is
+// solid rock — the generator only carves caves near the surface, so deep
+// chunks take the uniform early-out. Spans are in blocks, 128 square, so a
+// run covers the same world whatever the chunk size the build has.
+std::vector<ChunkCoord> coordsIn(int y0, int y1) {
+    constexpr int S = ChunkData::SIZE;
+    std::vector<ChunkCoord> v;
+    for (int y = y0 / S; y < y1 / S; y++)
+    for (int x = -64 / S; x < 64 / S; x++)
+    for (int z = -64 / S; z < 64 / S; z++) v.push_back({x, y, z});
+    return v;
+}
+
+std::vector<ChunkCoord> surfaceCoords() { return coordsIn(0, 128); }
+
+// ── Generation and meshing ────────────────────────────────────────────────────
+void benchGenerate(Runner& run) {
+    auto data = std::make_unique<ChunkData>();
+    auto gen = [&](const char* name, const std::vector<ChunkCoord>& coords) {
+        run.run(name, coords.size(), [&] {
+            for (ChunkCoord c : coords) {
+                generateChunk(*data, c);
+                keep((uint64_t)data->fill);
+            }
+        });
+    };
+    gen("generate/surface",     surfaceCoords());
+    gen("generate/underground", coordsIn(-128, -64));
+    gen("generate/air",         coordsIn(192, 256));
+}
+
+std::vector<std::unique_ptr<ChunkData>> mixedChunks() {
+    std::vector<std::unique_ptr<ChunkData>> out;
+    for (ChunkCoord c : surfaceCoords()) {
+        auto d = std::make_unique<ChunkData>();
+        generateChunk(*d, c);
+        if (d->fill == ChunkData::Fill::Mixed) out.push_back(std::move(d));
+    }
+    return out;
+}
+
+// With the triangles and vertices each makes of the chunks, all told, to
+// set the meshers side by side
+void benchMarch(Runner& run, const std::vector<std::unique_ptr<ChunkData>>& chunks) {
+    ChunkMesh mesh;
+    auto march = [&](const char* name, MarchOptions opts) {
+        uint64_t triangles = 0, vertices = 0;
+        Result*  r = run.run(name, chunks.size(), [&] {
+            triangles = vertices = 0;
+            for (auto& c : chunks) {
+                marchChunk(*c, mesh, opts);
+                triangles += mesh.indices.size() / 3;
+                vertices  += mesh.vertices.size();
+                keep(mesh.indices.size());
+            }
+        });
+        Runner::counter(r, "triangles", (double)triangles);
+        Runner::counter(r, "vertices", (double)vertices);
+    };
+    march("march/faceted", {});
+    MarchOptions smooth;
+    smooth.smoothNormals = true;
+    march("march/smooth", smooth);
+    MarchOptions skirt;
+    skirt.skirt = Config::LOD_SKIRT_CELLS;
+    march("march/skirted", skirt);
+    MarchOptions nets;
+    nets.mesher = Mesher::Nets;
+    march("march/nets", nets);
+    // What the client's decode worker runs: faceted, occlusion baked
+    MarchOptions occluded;
+    occluded.occlusion = true;
+    march("march/occlusion", occluded);
+}
+
+// ── Wire formats ──────────────────────────────────────────────────────────────
+void benchPackets(Runner& run, const std::vector<std::unique_ptr<ChunkData>>& chunks) {
+    std::vector<std::vector<uint8_t>> meshes, fields;
+    for (auto& c : chunks) {
+        fields.push_back(ChunkFieldPacket::serialize(*c));
+        meshes.push_back(ChunkDataPacket::serialize(marchChunk(*c)));
+    }
+    size_t n = chunks.size();
+
+    std::vector<ChunkMesh> marched;
+    for (auto& c : chunks) marched.push_back(marchChunk(*c));
+    run.run("packet/mesh_serialize", n, [&] {
+        for (auto& m : marched) keep(ChunkDataPacket::serialize(m).size());
+    });
+
+    ChunkMesh mesh;
+    run.run("packet/mesh_deserialize", n, [&] {
+        for (auto& b : meshes) {
+            ChunkDataPacket::deserialize(b.data(), b.size(), mesh);
+            keep(mesh.vertices.size());
+        }
+    });
+
+    run.run("packet/field_serialize", n, [&] {
+        for (auto& c : chunks) keep(ChunkFieldPacket::serialize(*c).size());
+    });
+
+    auto data = std::make_unique<ChunkData>();
+    run.run("packet/field_deserialize", n, [&] {
+        for (auto& b : fields) keep(ChunkFieldPacket::deserialize(b.data(), b.size(), *data));
+    });
+
+    // What the MeshBuilder does with a field packet
+    run.run("packet/field_to_mesh", n, [&] {
+        for (auto& b : fields) {
+            if (ChunkFieldPacket::deserialize(b.data(), b.size(), *data)) marchChunk(*data, mesh);
+            keep(mesh.indices.size());
+        }
+    });
+}
+
+// ── Thread pool ───────────────────────────────────────────────────────────────
+void benchPool(Runner& run) {
+    constexpr int TASKS = 4096;
+    ThreadPool pool;
+    std::atomic<int> done{0};
+    auto drain = [&] {
+        while (done.load(std::memory_order_acquire) < TASKS) std::this_thread::yield();
+    };
+
+    run.run("pool/submit_drain", TASKS, [&] {
+        done.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < TASKS; i++)
+            pool.submit([&done] { done.fetch_add(1, std::memory_order_release); });
+        drain();
+    });
+
+    std::vector<Task> batch;
+    run.run("pool/batch_drain", TASKS, [&] {
+        done.store(0, std::memory_order_relaxed);
+        batch.clear();
+        for (int i = 0; i < TASKS; i++)
+            batch.emplace_back([&done] { done.fetch_add(1, std::memory_order_release); });
+        pool.submitBatch(batch);
+        drain();
+    });
+}
+
+// ── Chunk tables ──────────────────────────────────────────────────────────────
+// The resident tables (VkContext::chunks, the ChunkCache, the player's
+// colliders) as a view walks: each step inserts the face of chunks the cube
+// moves into and erases the face it leaves, then every resident key is looked
+// up once and as many absent ones missed. std::unordered_map runs with the
+// hash the tables had before (boost-style combine over std::hash<int>, which
+// is the identity), FlatMap with the mixed one they use now.
+struct LegacyKeyHash {
+    size_t operator()(const ChunkKey& k) const {
+        size_t h = 0;
+        for (int v : {k.coord.x, k.coord.y, k.coord.z})
+            h ^= std::hash<int>{}(v) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return h ^ (size_t)(k.lod * 0x9e3779b97f4a7c15ull);
+    }
+};
+
+template<class Map>
+void streamView(Map& map, int steps, uint64_t& found) {
+    constexpr int R = 12;
+    map.clear();
+    for (int x = -R; x <= R; x++)
+    for (int y = -4; y <= 4; y++)
+    for (int z = -R; z <= R; z++) map[ChunkKey{{x, y, z}, 0}] = (uint32_t)x;
+
+    for (int s = 1; s <= steps; s++) {
+        for (int y = -4; y <= 4; y++)
+        for (int z = -R; z <= R; z++) {
+            map.erase(ChunkKey{{s - 1 - R, y, z}, 0});
+            map[ChunkKey{{s + R, y, z}, 0}] = (uint32_t)s;
+        }
+        for (int x = s - R; x <= s + R; x++)
+        for (int y = -4; y <= 4; y++)
+        for (int z = -R; z <= R; z++) {
+            found += map.count(ChunkKey{{x, y, z}, 0});
+            found += map.count(ChunkKey{{x, y, z}, 1});
+        }
+    }
+}
+
+void benchMaps(Runner& run) {
+    constexpr int STEPS = 32;
+    const uint64_t lookups = (uint64_t)STEPS * 25 * 9 * 25 * 2;
+
+    std::unordered_map<ChunkKey, uint32_t, LegacyKeyHash> legacy;
+    run.run("map/stream_unordered", lookups, [&] {
+        uint64_t found = 0;
+        streamView(legacy, STEPS, found);
+        keep(found);
+    });
+
+    FlatMap<ChunkKey, uint32_t, ChunkKeyHash> flat;
+    run.run("map/stream_flat", lookups, [&] {
+        uint64_t found = 0;
+        streamView(flat, STEPS, found);
+        keep(found);
+    });
+
+    // Eviction as the client does it: erase in the walk, every entry seen once
+    auto evict = [](auto& map) {
+        uint64_t left = 0;
+        for (auto it = map.begin(); it != map.end();) {
+            if (it->first.coord.x & 1) it = map.erase(it);
+            else { ++it; left++; }
+        }
+        return left;
+    };
+    run.run("map/evict_unordered", 25 * 9 * 25, [&] {
+        uint64_t found = 0;
+        streamView(legacy, 0, found);
+        keep(evict(legacy));
+    });
+    run.run("map/evict_flat", 25 * 9 * 25, [&] {
+        uint64_t found = 0;
+        streamView(flat, 0, found);
+        keep(evict(flat));
+    });
+}
+
+// ── Collision ─────────────────────────────────────────────────────────────────
+// The PlayerController's per-substep queries, replayed over colliders built
+// from the terrain around spawn: a player-sized box gathered and swept
+// against its candidates, and the five ground rays. Positions follow a loop
+// over the surface, so the soups are the ones a walking player sees.
+void benchCollide(Runner& run) {
+    FlatMap<ChunkCoord, ChunkCollider, ChunkCoordHash> colliders;
+    constexpr int S = ChunkData::SIZE; // 192 x 128 x 192 blocks around spawn
+    for (int x = -96 / S; x < 96 / S; x++)
+    for (int y = 0; y < 128 / S; y++)
+    for (int z = -96 / S; z < 96 / S; z++) {
+        auto d = std::make_unique<ChunkData>();
+        generateChunk(*d, {x, y, z});
+        ChunkMesh mesh = marchChunk(*d);
+        if (mesh.indices.empty()) continue;
+        colliders[{x, y, z}].build(mesh);
+    }
+
+    const glm::vec3 half{Config::PLAYER_WIDTH * 0.5f, Config::PLAYER_HEIGHT * 0.5f,
+                         Config::PLAYER_WIDTH * 0.5f};
+    std::vector<glm::vec3> path;
+    for (int i = 0; i < 256; i++) {
+        float a = (float)i / 256.f * 6.2831853f;
+        float x = std::cos(a) * 60.f, z = std::sin(a) * 60.f;
+        path.push_back({x, sampleSurfaceY(x, z) + half.y, z});
+    }
+
+    Collide::TriSoA       near;
+    std::vector<uint8_t>  hit;
+    std::vector<glm::vec3> mtv;
+    auto gather = [&](glm::vec3 mn, glm::vec3 mx) {
+        near.clear();
+        float sz = (float)ChunkData::SIZE;
+        for (int cx = (int)std::floor(mn.x / sz); cx <= (int)std::floor(mx.x / sz); cx++)
+        for (int cy = (int)std::floor(mn.y / sz); cy <= (int)std::floor(mx.y / sz); cy++)
+        for (int cz = (int)std::floor(mn.z / sz); cz <= (int)std::floor(mx.z / sz); cz++) {
+            auto it = colliders.find({cx, cy, cz});
+            if (it == colliders.end()) continue;
+            const ChunkCollider& col = it->second;
+            col.query(mn, mx, [&](glm::vec3 a, glm::vec3 b, glm::vec3 c) { near.push(a, b, c); });
+        }
+    };
+
+    run.run("collide/box_sweep", path.size(), [&] {
+        for (glm::vec3 p : path) {
+            glm::vec3 reach = half + glm::vec3(1.f);
+            gather(p - reach, p + reach);
+            hit.resize(near.count);
+            mtv.resize(near.count);
+            keep((uint64_t)Collide::boxTris(p - half, p + half, near, hit.data(), mtv.data()));
+        }
+    });
+
+    run.run("collide/ground_rays", path.size(), [&] {
+        for (glm::vec3 p : path) {
+            float inset = half.x - 0.08f, origY = p.y - half.y + 0.02f, len = 0.25f;
+            gather({p.x - inset, origY - len, p.z - inset}, {p.x + inset, origY, p.z + inset});
+            glm::vec3 origins[5] = {{p.x, origY, p.z},
+                                    {p.x + inset, origY, p.z + inset}, {p.x - inset, origY, p.z + inset},
+                                    {p.x + inset, origY, p.z - inset}, {p.x - inset, origY, p.z - inset}};
+            for (glm::vec3 o : origins) {
+                float t;
+                keep((uint64_t)(Collide::rayTris(o, {0.f, -1.f, 0.f}, len, 0.1f, near, t) + 1));
+            }
+        }
+    });
+}
+
+// ── Terrain queries ───────────────────────────────────────────────────────────
+// The same box and ground rays against the density field of the same
+// chunks, the way the server answers them (TerrainQuery), plus a ray from
+// head height to the ground ahead. Chunks are looked up in a FlatMap, as
+// the server's DensityCache does.
+void benchTerrain(Runner& run) {
+    FlatMap<ChunkCoord, std::unique_ptr<DensityField>, ChunkCoordHash> fields;
+    constexpr int S = ChunkData::SIZE; // 192 x 128 x 192 blocks around spawn
+    for (int x = -96 / S; x < 96 / S; x++)
+    for (int y = 0; y < 128 / S; y++)
+    for (int z = -96 / S; z < 96 / S; z++) {
+        auto d = std::make_unique<ChunkData>();
+        generateChunk(*d, {x, y, z});
+        fields[{x, y, z}] = DensityField::fromData(*d);
+    }
+    TerrainQuery terrain([&fields](ChunkCoord c) -> const DensityField* {
+        auto it = fields.find(c);
+        return it == fields.end() ? nullptr : it->second.get();
+    });
+
+    const glm::vec3 half{Config::PLAYER_WIDTH * 0.5f, Config::PLAYER_HEIGHT * 0.5f,
+                         Config::PLAYER_WIDTH * 0.5f};
+    std::vector<glm::vec3> path;
+    for (int i = 0; i < 256; i++) {
+        float a = (float)i / 256.f * 6.2831853f;
+        float x = std::cos(a) * 60.f, z = std::sin(a) * 60.f;
+        path.push_back({x, sampleSurfaceY(x, z) + half.y, z});
+    }
+
+    run.run("terrain/sample", path.size(), [&] {
+        for (glm::vec3 p : path) keep((uint64_t)(terrain.sample(p) * 1000.f));
+    });
+
+    run.run("terrain/box_overlap", path.size(), [&] {
+        for (glm::vec3 p : path) keep((uint64_t)terrain.overlaps(p - half, p + half));
+    });
+
+    run.run("terrain/ground_rays", path.size(), [&] {
+        for (glm::vec3 p : path) {
+            float inset = half.x - 0.08f, origY = p.y - half.y + 0.02f, len = 0.25f;
+            glm::vec3 origins[5] = {{p.x, origY, p.z},
+                                    {p.x + inset, origY, p.z + inset}, {p.x - inset, origY, p.z + inset},
+                                    {p.x + inset, origY, p.z - inset}, {p.x - inset, origY, p.z - inset}};
+            for (glm::vec3 o : origins)
+                keep((uint64_t)terrain.raycast(o, {0.f, -1.f, 0.f}, len).hit);
+        }
+    });
+
+    run.run("terrain/look_ray", path.size(), [&] {
+        for (size_t i = 0; i < path.size(); i++) {
+            glm::vec3 p = path[i], ahead = path[(i + 8) % path.size()];
+            glm::vec3 eye = p + glm::vec3(0.f, half.y, 0.f);
+            keep((uint64_t)terrain.raycast(eye, ahead - eye, 64.f).t);
+        }
+    });
+}
+
+// ── Pages ─────────────────────────────────────────────────────────────────────
+// Dependent loads, one cache line apiece, round a buffer far past what the
+// TLB covers, the way probes of the big caches land, with the buffer from
+// each BigPages mode. hugetlb with no pool reserved falls back to thp and
+// says so.
+void benchPages(Runner& run) {
+    constexpr size_t BYTES = 256u << 20, STRIDE = 64 / sizeof(uint32_t);
+    constexpr uint64_t HOPS = 1u << 16;
+    const size_t lines = BYTES / 64;
+
+    // Sattolo's shuffle: one cycle through every line
+    std::vector<uint32_t> next(lines);
+    std::iota(next.begin(), next.end(), 0u);
+    std::mt19937 rng(42);
+    for (size_t i = lines - 1; i > 0; i--) std::swap(next[i], next[rng() % i]);
+
+    const BigPages::Policy prev = BigPages::policy();
+    for (BigPages::Mode mode : {BigPages::Mode::Off, BigPages::Mode::Advise, BigPages::Mode::Explicit}) {
+        std::string name = std::string("pages/chase_") + BigPages::name(mode);
+        if (!run.filter.empty() && name.find(run.filter) == std::string::npos) continue;
+        BigPages::configure({mode, false});
+        uint64_t fallbacks = BigPages::stats().fallbacks;
+        auto* buf = static_cast<uint32_t*>(BigPages::map(BYTES));
+        for (size_t i = 0; i < lines; i++) buf[i * STRIDE] = next[i];
+        if (BigPages::stats().fallbacks != fallbacks) fprintf(stderr, "(no hugetlb pool; %s runs as thp)\n", name.c_str());
+
+        uint32_t at = 0;
+        run.run(name, HOPS, [&] {
+            for (uint64_t h = 0; h < HOPS; h++) at = buf[(size_t)at * STRIDE];
+            keep(at);
+        });
+        BigPages::unmap(buf, BYTES);
+    }
+    BigPages::configure(prev);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Runner run;
+    const char* outPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--filter") && i + 1 < argc)        run.filter  = argv[++i];
+        else if (!strcmp(argv[i], "--min-time") && i + 1 < argc) run.minTime = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc)      outPath     = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--filter substr] [--min-time seconds] [--out file.json]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    benchGenerate(run);
+    auto chunks = mixedChunks();
+    benchMarch(run, chunks);
+    benchPackets(run, chunks);
+    benchPool(run);
+    benchMaps(run);
+    benchCollide(run);
+    benchTerrain(run);
+    benchPages(run);
+
+    FILE* f = outPath ? fopen(outPath, "w") : stdout;
+    if (!f) { fprintf(stderr, "can't write %s\n", outPath); return 1; }
+    run.writeJson(f);
+    if (outPath) fclose(f);
+    return 0;
+}
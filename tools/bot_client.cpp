@@ -1,225 +1,584 @@
 // tools/bot_client.cpp
 // Headless multiplayer test bot. No Vulkan, no window — just ENet + packets.
-// Connects, authenticates (guest), walks in a circle, prints other players.
+// Connects, authenticates, walks around and prints other players.
+//
+// With --swarm N it becomes a load generator: N simulated clients in one
+// process, sharded over --threads ENet hosts (one thread each), joining at
+// --ramp per second. Every bot speaks the real client protocol (the same
+// caps, PlayerMoveQ at 20 Hz, acking PlayerPosDelta), and the run ends with
+// latency and throughput distributions:
+//
+//   join       connect started -> AuthResponse accepted
+//   spawn      SpawnPosition -> its chunk and the one below both arrived
+//              (the client's spawn gate)
+//   pos        a bot sent a position -> another bot saw it in a sync
+//   chunk B    chunk bytes received per bot
+//
+// Movement patterns (--pattern):
+//   circle   8-block circle around spawn (the default)
+//   walk     random walk at walking speed, new heading every few seconds
+//   sprint   straight line at sprint speed, one heading per bot — exercises
+//            chunk streaming
+//   cluster  jitter around spawn — everyone in everyone's interest range
 //
 // Build:
-//   g++ -std=c++17 -Ishared/include -o bot_client tools/bot_client.cpp \
+//   meson target 'bot_client', or
+//   g++ -std=c++20 -O2 -Ishared/include -o bot_client tools/bot_client.cpp
+//       shared/src/noise_gen.cpp shared/src/noise_kernels.cpp shared/src/chunk.cpp
 //       -lenet -lm -pthread
-//   (or add to meson as a separate target)
 //
 // Usage:
 //   ./bot_client                          # connect to 127.0.0.1:7777 as "Bot1"
 //   ./bot_client 127.0.0.1 7777 Bot2     # custom ip/port/name
 //   ./bot_client 127.0.0.1 7777 Bot3 mytoken  # with auth token
+//   ./bot_client 127.0.0.1 7777 --swarm 200 --threads 4 --pattern sprint
+//       --duration 120 --json run.json
+//   ./bot_client --swarm 50 --tokens tokens.txt   # "token" or "name token" per line
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <cmath>
-#include <chrono>
-#include <thread>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <enet/enet.h>
+#include "config.h"
+#include "net_common.h"
+#include "noise_gen.h"
+#include "packet_dispatch.h"
 
-// ── Inline the minimal packet serialization we need ───────────────────────────
-#include <vector>
-#include <cstdint>
+using Clock = std::chrono::steady_clock;
 
-static void writeU8 (std::vector<uint8_t>& b, uint8_t  v) { b.push_back(v); }
-static void writeU32(std::vector<uint8_t>& b, uint32_t v) {
-    b.push_back((v>>24)&0xFF); b.push_back((v>>16)&0xFF);
-    b.push_back((v>> 8)&0xFF); b.push_back( v     &0xFF);
-}
-static void writeF32(std::vector<uint8_t>& b, float v) {
-    uint32_t tmp; memcpy(&tmp, &v, 4); writeU32(b, tmp);
-}
-static uint8_t  readU8 (const uint8_t* d, size_t& o) { return d[o++]; }
-static uint32_t readU32(const uint8_t* d, size_t& o) {
-    uint32_t v = ((uint32_t)d[o]<<24)|((uint32_t)d[o+1]<<16)|
-                 ((uint32_t)d[o+2]<< 8)|((uint32_t)d[o+3]);
-    o+=4; return v;
-}
-static float readF32(const uint8_t* d, size_t& o) {
-    uint32_t tmp = readU32(d,o); float v; memcpy(&v,&tmp,4); return v;
+static std::atomic<bool> g_stop{false};
+static void onSignal(int) { g_stop = true; }
+
+static double msSince(Clock::time_point t, Clock::time_point now = Clock::now()) {
+    return std::chrono::duration<double, std::milli>(now - t).count();
 }
 
-// Packet IDs we care about
-enum : uint8_t {
-    PID_ChunkData     = 0x01,
-    PID_PlayerMove     = 0x02,
-    PID_SpawnPosition  = 0x05,
-    PID_AuthRequest    = 0x30,
-    PID_AuthResponse   = 0x31,
-    PID_PlayerSpawn    = 0x32,
-    PID_PlayerDespawn  = 0x33,
-    PID_PlayerPosSync  = 0x34,
+enum class Pattern { Circle, Walk, Sprint, Cluster };
+
+struct Options {
+    std::string ip      = "127.0.0.1";
+    int         port    = 7777;
+    std::string name    = "Bot1";
+    std::string token;
+    int         swarm    = 0;     // 0: one verbose bot
+    int         threads  = 1;
+    double      ramp     = 20.0;  // joins per second
+    double      duration = 0.0;   // seconds, 0 = until Ctrl+C
+    Pattern     pattern  = Pattern::Circle;
+    std::string tokensFile, jsonFile;
+    uint32_t    caps       = CAP_CHUNK_FIELDS | CAP_MOVE_DELTA | CAP_LOD_CHUNKS;
+    int         viewRadius = Config::CHUNK_RADIUS_XZ;
 };
 
-static void sendReliable(ENetPeer* peer, const std::vector<uint8_t>& data) {
-    ENetPacket* pkt = enet_packet_create(data.data(), data.size(),
-                                         ENET_PACKET_FLAG_RELIABLE);
-    enet_peer_send(peer, 0, pkt);
-}
+// ── Bot ───────────────────────────────────────────────────────────────────────
+struct Bot {
+    static constexpr int SENT_RING = 64; // ~3 s of moves at 20 Hz
 
-int main(int argc, char** argv) {
-    const char* ip   = argc > 1 ? argv[1] : "127.0.0.1";
-    int         port = argc > 2 ? atoi(argv[2]) : 7777;
-    const char* name = argc > 3 ? argv[3] : "Bot1";
-    const char* token = argc > 4 ? argv[4] : "";
+    int         index = 0;
+    std::string name, token;
+    ENetPeer*   peer = nullptr;
 
-    printf("[Bot] %s connecting to %s:%d\n", name, ip, port);
+    Clock::time_point connectAt, authedAt, spawnAt;
+    bool     authed = false, spawned = false, spawnReady = false, gone = false;
+    uint32_t id = 0;
 
-    if (enet_initialize() != 0) { fprintf(stderr, "enet init failed\n"); return 1; }
+    glm::vec3  spawn{0.f}, pos{0.f};
+    float      yaw = 0.f, heading = 0.f, turnIn = 0.f, angle = 0.f;
+    float      sendAccum = 0.f;
+    ChunkCoord spawnChunk{};
+    bool       haveAt = false, haveBelow = false;
+    std::mt19937 rng;
 
-    ENetHost* host = enet_host_create(nullptr, 1, 2, 0, 0);
-    if (!host) { fprintf(stderr, "host create failed\n"); return 1; }
-
-    ENetAddress addr{};
-    enet_address_set_host(&addr, ip);
-    addr.port = (uint16_t)port;
-
-    ENetPeer* server = enet_host_connect(host, &addr, 2, 0);
-    if (!server) { fprintf(stderr, "connect failed\n"); return 1; }
-
-    // Wait for connection
-    ENetEvent ev;
-    if (enet_host_service(host, &ev, 5000) <= 0 || ev.type != ENET_EVENT_TYPE_CONNECT) {
-        fprintf(stderr, "[Bot] Connection failed\n");
-        enet_peer_reset(server);
-        enet_host_destroy(host);
-        enet_deinitialize();
-        return 1;
-    }
-
-    printf("[Bot] Connected! Sending auth...\n");
-
-    // Send auth request
-    {
-        std::vector<uint8_t> b;
-        writeU8(b, PID_AuthRequest);
-        std::string sName(name), sToken(token);
-        writeU32(b, (uint32_t)sName.size());
-        b.insert(b.end(), sName.begin(), sName.end());
-        writeU32(b, (uint32_t)sToken.size());
-        b.insert(b.end(), sToken.begin(), sToken.end());
-        sendReliable(server, b);
-        enet_host_flush(host);
-    }
-
-    // State
-    float posX = 0.f, posY = 80.f, posZ = 0.f;
-    float yaw = 0.f;
-    float circleAngle = 0.f;
-    float circleRadius = 8.f;
-    float circleSpeed = 0.5f; // radians/sec
-    bool spawned = false;
-    bool authed = false;
-    uint32_t myId = 0;
-
-    using Clock = std::chrono::steady_clock;
-    auto lastTime = Clock::now();
-    float sendAccum = 0.f;
-
-    printf("[Bot] Running. Ctrl+C to stop.\n");
-
-    while (true) {
-        auto now = Clock::now();
-        float dt = std::chrono::duration<float>(now - lastTime).count();
-        lastTime = now;
-        if (dt > 0.1f) dt = 0.1f;
-
-        // Poll network
-        while (enet_host_service(host, &ev, 0) > 0) {
-            if (ev.type == ENET_EVENT_TYPE_RECEIVE) {
-                const uint8_t* d = ev.packet->data;
-                size_t len = ev.packet->dataLength;
-                if (len > 0) {
-                    uint8_t pid = d[0];
-
-                    if (pid == PID_AuthResponse) {
-                        size_t o = 1;
-                        uint8_t accepted = readU8(d, o);
-                        uint32_t playerId = readU32(d, o);
-                        uint32_t msgLen = readU32(d, o);
-                        std::string msg((const char*)d + o, msgLen);
-                        if (accepted) {
-                            authed = true;
-                            myId = playerId;
-                            printf("[Bot] Auth accepted: %s (id=%u)\n", msg.c_str(), playerId);
-                        } else {
-                            printf("[Bot] Auth rejected: %s\n", msg.c_str());
-                            goto done;
-                        }
-                    }
-                    else if (pid == PID_SpawnPosition) {
-                        size_t o = 1;
-                        posX = readF32(d, o);
-                        posY = readF32(d, o);
-                        posZ = readF32(d, o);
-                        spawned = true;
-                        printf("[Bot] Spawn at (%.1f, %.1f, %.1f)\n", posX, posY, posZ);
-                    }
-                    else if (pid == PID_PlayerSpawn) {
-                        size_t o = 1;
-                        uint32_t pid2 = readU32(d, o);
-                        uint32_t nLen = readU32(d, o);
-                        std::string pname((const char*)d + o, nLen); o += nLen;
-                        float px = readF32(d, o), py = readF32(d, o), pz = readF32(d, o);
-                        printf("[Bot] Player spawned: %s (id=%u) at (%.1f,%.1f,%.1f)\n",
-                               pname.c_str(), pid2, px, py, pz);
-                    }
-                    else if (pid == PID_PlayerDespawn) {
-                        size_t o = 1;
-                        uint32_t pid2 = readU32(d, o);
-                        printf("[Bot] Player left (id=%u)\n", pid2);
-                    }
-                    else if (pid == PID_PlayerPosSync) {
-                        // Silent — too spammy to print
-                    }
-                    else if (pid == PID_ChunkData) {
-                        // Ignore chunk data — we're headless
-                    }
-                    // Ignore all other packets (inventory, stats, etc.)
+    uint64_t        chunkBytes = 0, chunks = 0;
+    PosDeltaDecoder decoder;
+    // Last position seen per other player, so only changes are timed
+    std::unordered_map<uint32_t, std::array<int32_t, 3>> seen;
+
+    // Positions sent, for matching against other bots' syncs. Read from
+    // other shards, hence the lock.
+    struct Sent { Clock::time_point at; int32_t q[3]; };
+    std::mutex sentLock;
+    Sent       sent[SENT_RING];
+    int        sentCount = 0;
+
+    void recordSent(Clock::time_point at) {
+        std::lock_guard lk(sentLock);
+        Sent& s = sent[sentCount++ % SENT_RING];
+        s.at = at;
+        s.q[0] = MoveQuant::pos(pos.x); s.q[1] = MoveQuant::pos(pos.y); s.q[2] = MoveQuant::pos(pos.z);
+    }
+
+    // When this bot sent q, newest match first; false if it's aged out
+    bool sentAt(const int32_t q[3], Clock::time_point& at) {
+        std::lock_guard lk(sentLock);
+        for (int i = 1; i <= std::min(sentCount, SENT_RING); i++) {
+            const Sent& s = sent[(sentCount - i) % SENT_RING];
+            if (s.q[0] == q[0] && s.q[1] == q[1] && s.q[2] == q[2]) { at = s.at; return true; }
+        }
+        return false;
+    }
+};
+
+// Every bot by server-assigned id, filled in as auth responses arrive
+struct Registry {
+    std::mutex                         lock;
+    std::unordered_map<uint32_t, Bot*> byId;
+
+    void add(uint32_t id, Bot* b) { std::lock_guard lk(lock); byId[id] = b; }
+    Bot* find(uint32_t id) {
+        std::lock_guard lk(lock);
+        auto it = byId.find(id);
+        return it != byId.end() ? it->second : nullptr;
+    }
+};
+
+struct Samples {
+    std::vector<double> joinMs, spawnMs, posMs;
+};
+
+// ── Shard ─────────────────────────────────────────────────────────────────────
+// One ENet host and the bots on it, on its own thread
+class Shard {
+public:
+    std::atomic<int>      joined{0}, spawned{0}, dropped{0};
+    std::atomic<uint64_t> chunkBytes{0};
+    Samples               samples; // read after the thread has finished
+
+    Shard(const Options& opt, Registry& reg, std::vector<Bot*> bots, double rampPerShard)
+        : _opt(opt), _reg(reg), _bots(std::move(bots)), _ramp(rampPerShard) {
+        _host = enet_host_create(nullptr, std::max<size_t>(_bots.size(), 1), Net::CHANNEL_COUNT, 0, 0);
+        enet_address_set_host(&_addr, opt.ip.c_str());
+        _addr.port = (uint16_t)opt.port;
+        registerHandlers();
+    }
+    ~Shard() { if (_host) enet_host_destroy(_host); }
+
+    bool ok() const { return _host != nullptr; }
+
+    void run() {
+        auto start = Clock::now(), last = start;
+        size_t next = 0;
+        ENetEvent ev;
+        while (!g_stop) {
+            auto now = Clock::now();
+            float dt = std::min(std::chrono::duration<float>(now - last).count(), 0.1f);
+            last = now;
+
+            // Ramp joins
+            size_t due = std::min(_bots.size(), (size_t)(msSince(start, now) / 1000.0 * _ramp) + 1);
+            for (; next < due; next++) connect(*_bots[next], now);
+
+            while (enet_host_service(_host, &ev, 0) > 0) {
+                Bot* b = ev.peer ? static_cast<Bot*>(ev.peer->data) : nullptr;
+                if (ev.type == ENET_EVENT_TYPE_CONNECT && b) {
+                    sendAuth(*b);
+                } else if (ev.type == ENET_EVENT_TYPE_RECEIVE) {
+                    if (b) _dispatch.dispatch(ev.peer, ev.packet->data, ev.packet->dataLength);
+                    enet_packet_destroy(ev.packet);
+                } else if (ev.type == ENET_EVENT_TYPE_DISCONNECT && b && !b->gone) {
+                    b->gone = true;
+                    dropped++;
+                    if (verbose()) printf("[Bot] Disconnected from server\n");
                 }
-                enet_packet_destroy(ev.packet);
             }
-            else if (ev.type == ENET_EVENT_TYPE_DISCONNECT) {
-                printf("[Bot] Disconnected from server\n");
-                goto done;
+
+            for (size_t i = 0; i < next; i++) step(*_bots[i], dt, now);
+            enet_host_flush(_host);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        for (Bot* b : _bots)
+            if (b->peer && !b->gone) enet_peer_disconnect(b->peer, 0);
+        enet_host_flush(_host);
+    }
+
+private:
+    const Options&    _opt;
+    Registry&         _reg;
+    std::vector<Bot*> _bots;
+    double            _ramp;
+    ENetHost*         _host = nullptr;
+    ENetAddress       _addr{};
+    PacketDispatcher  _dispatch;
+    PacketWriter      _writer;
+    PlayerPosSyncPacket _sync;
+
+    bool verbose() const { return _opt.swarm == 0; }
+    static Bot& bot(ENetPeer* p) { return *static_cast<Bot*>(p->data); }
+
+    void connect(Bot& b, Clock::time_point now) {
+        b.connectAt = now;
+        b.peer = enet_host_connect(_host, &_addr, Net::CHANNEL_COUNT, 0);
+        if (!b.peer) { b.gone = true; dropped++; return; }
+        b.peer->data = &b;
+    }
+
+    void sendAuth(Bot& b) {
+        AuthRequestPacket req;
+        req.username   = b.name;
+        req.token      = b.token;
+        req.caps       = _opt.caps;
+        req.viewRadius = (uint8_t)std::clamp(_opt.viewRadius, 1, Config::VIEW_RADIUS_MAX);
+        Net::sendReliable(b.peer, req.serialize());
+    }
+
+    void registerHandlers() {
+        _dispatch.on(MPPacketID::AuthResponse, [this](ENetPeer* p, const uint8_t* d, size_t len) {
+            Bot& b = bot(p);
+            auto resp = AuthResponsePacket::deserialize(d, len);
+            if (!resp.accepted) {
+                printf("[Bot] %s: auth rejected: %s\n", b.name.c_str(), resp.message.c_str());
+                enet_peer_disconnect(p, 0);
+                return;
+            }
+            b.authed   = true;
+            b.id       = resp.playerId;
+            b.authedAt = Clock::now();
+            samples.joinMs.push_back(msSince(b.connectAt, b.authedAt));
+            _reg.add(b.id, &b);
+            joined++;
+            if (verbose()) printf("[Bot] Auth accepted: %s (id=%u)\n", resp.message.c_str(), b.id);
+        });
+
+        _dispatch.on(PacketID::SpawnPosition, [this](ENetPeer* p, const uint8_t* d, size_t len) {
+            if (len < 13) return;
+            Bot& b = bot(p);
+            auto sp = SpawnPositionPacket::deserialize(d, len);
+            b.spawn = b.pos = {sp.x, sp.y, sp.z};
+            b.spawned = true;
+            b.spawnAt = Clock::now();
+            int N = ChunkData::SIZE;
+            b.spawnChunk = {(int)std::floor(sp.x / N), (int)std::floor(sp.y / N), (int)std::floor(sp.z / N)};
+            b.haveAt = b.haveBelow = false;
+            b.heading = std::uniform_real_distribution<float>(0.f, 6.2831853f)(b.rng);
+            if (verbose()) printf("[Bot] Spawn at (%.1f, %.1f, %.1f)\n", sp.x, sp.y, sp.z);
+        });
+
+        // u8 id | u8 format | i32 coord — field and mesh packets alike
+        auto chunk = [this](ENetPeer* p, const uint8_t* d, size_t len, size_t coordAt) {
+            Bot& b = bot(p);
+            b.chunkBytes += len;
+            b.chunks++;
+            chunkBytes += len;
+            if (len < coordAt + 12 || !b.spawned || b.spawnReady) return;
+            if (d[0] == (uint8_t)PacketID::ChunkData &&
+                ((d[14] >> ChunkDataPacket::LOD_SHIFT) & ChunkDataPacket::LOD_MASK) != 0) return;
+            size_t o = coordAt;
+            ChunkCoord c{readI32(d, o), readI32(d, o), readI32(d, o)};
+            ChunkCoord below{b.spawnChunk.x, b.spawnChunk.y - 1, b.spawnChunk.z};
+            b.haveAt    |= c == b.spawnChunk;
+            b.haveBelow |= c == below;
+            if (b.haveAt && b.haveBelow) {
+                b.spawnReady = true;
+                samples.spawnMs.push_back(msSince(b.spawnAt));
+                spawned++;
             }
+        };
+        _dispatch.on(PacketID::ChunkData,    [chunk](ENetPeer* p, const uint8_t* d, size_t len) { chunk(p, d, len, 2); });
+        _dispatch.on(PacketID::ChunkField,   [chunk](ENetPeer* p, const uint8_t* d, size_t len) { chunk(p, d, len, 2); });
+        _dispatch.on(PacketID::ChunkUniform, [chunk](ENetPeer* p, const uint8_t* d, size_t len) { chunk(p, d, len, 1); });
+
+        _dispatch.on(MPPacketID::PlayerPosSync, [this](ENetPeer* p, const uint8_t* d, size_t len) {
+            _sync = PlayerPosSyncPacket::deserialize(d, len);
+            onPositions(bot(p));
+        });
+        _dispatch.on(MPPacketID::PlayerPosDelta, [this](ENetPeer* p, const uint8_t* d, size_t len) {
+            if (bot(p).decoder.decode(d, len, _sync)) onPositions(bot(p));
+        });
+
+        _dispatch.on(MPPacketID::PlayerSpawn, [this](ENetPeer*, const uint8_t* d, size_t len) {
+            if (!verbose()) return;
+            auto sp = PlayerSpawnPacket::deserialize(d, len);
+            printf("[Bot] Player spawned: %s (id=%u) at (%.1f,%.1f,%.1f)\n",
+                   sp.username.c_str(), sp.playerId, sp.x, sp.y, sp.z);
+        });
+        _dispatch.on(MPPacketID::PlayerDespawn, [this](ENetPeer*, const uint8_t* d, size_t len) {
+            if (verbose()) printf("[Bot] Player left (id=%u)\n", PlayerDespawnPacket::deserialize(d, len).playerId);
+        });
+        // Everything else (inventory, stats, enemies) is counted and dropped
+    }
+
+    // A position another bot sent, seen for the first time here: time it
+    void onPositions(Bot& rx) {
+        auto now = Clock::now();
+        for (const PlayerPosEntry& e : _sync.players) {
+            if (e.playerId == rx.id) continue;
+            std::array<int32_t, 3> q{MoveQuant::pos(e.x), MoveQuant::pos(e.y), MoveQuant::pos(e.z)};
+            auto [it, fresh] = rx.seen.try_emplace(e.playerId, q);
+            if (!fresh && it->second == q) continue;
+            it->second = q;
+            Bot* tx = _reg.find(e.playerId);
+            Clock::time_point at;
+            if (tx && tx->sentAt(q.data(), at)) samples.posMs.push_back(msSince(at, now));
+        }
+    }
+
+    void step(Bot& b, float dt, Clock::time_point now) {
+        if (!b.spawned || b.gone) return;
+        move(b, dt);
+
+        b.sendAccum += dt;
+        if (b.sendAccum < 0.05f) return; // 20 Hz
+        b.sendAccum = 0.f;
+        if (_opt.caps & CAP_MOVE_DELTA) {
+            PlayerMoveQPacket mv;
+            mv.x = b.pos.x; mv.y = b.pos.y; mv.z = b.pos.z;
+            mv.yaw = b.yaw;
+            mv.ack = b.decoder.ack();
+            mv.write(_writer);
+            Net::sendMovement(b.peer, _writer.data(), _writer.size());
+        } else {
+            Net::sendReliable(b.peer, PlayerMovePacket{b.pos.x, b.pos.y, b.pos.z, b.yaw, 0.f}.serialize());
         }
+        b.recordSent(now);
+    }
 
-        // Walk in circle around spawn point
-        if (spawned && authed) {
-            circleAngle += circleSpeed * dt;
-            float cx = posX + cosf(circleAngle) * circleRadius;
-            float cz = posZ + sinf(circleAngle) * circleRadius;
-            yaw = -circleAngle * (180.f / 3.14159f) + 90.f;
-
-            // Send position at 20Hz
-            sendAccum += dt;
-            if (sendAccum >= 0.05f) {
-                sendAccum = 0.f;
-                std::vector<uint8_t> b;
-                writeU8(b, PID_PlayerMove);
-                writeF32(b, cx);
-                writeF32(b, posY);
-                writeF32(b, cz);
-                writeF32(b, yaw);
-                writeF32(b, 0.f); // pitch
-                sendReliable(server, b);
-                enet_host_flush(host);
+    void move(Bot& b, float dt) {
+        constexpr float RAD2DEG = 180.f / 3.14159265f;
+        float x = b.pos.x, z = b.pos.z;
+        switch (_opt.pattern) {
+        case Pattern::Circle:
+            b.angle += 0.5f * dt; // radians/sec
+            x = b.spawn.x + std::cos(b.angle) * 8.f;
+            z = b.spawn.z + std::sin(b.angle) * 8.f;
+            b.yaw = -b.angle * RAD2DEG + 90.f;
+            break;
+        case Pattern::Walk:
+            b.turnIn -= dt;
+            if (b.turnIn <= 0.f) {
+                b.heading = std::uniform_real_distribution<float>(0.f, 6.2831853f)(b.rng);
+                b.turnIn  = std::uniform_real_distribution<float>(2.f, 6.f)(b.rng);
             }
+            [[fallthrough]];
+        case Pattern::Sprint: {
+            float speed = Config::WALK_SPEED * (_opt.pattern == Pattern::Sprint ? Config::SPRINT_MULT : 1.f);
+            x += std::cos(b.heading) * speed * dt;
+            z += std::sin(b.heading) * speed * dt;
+            b.yaw = -b.heading * RAD2DEG + 90.f;
+            break;
         }
+        case Pattern::Cluster:
+            b.angle += 1.3f * dt;
+            x = b.spawn.x + std::cos(b.angle + b.index) * 2.f;
+            z = b.spawn.z + std::sin(b.angle * 0.7f + b.index) * 2.f;
+            b.yaw = b.angle * RAD2DEG;
+            break;
+        }
+        b.pos = {x, sampleSurfaceY(x, z) + Config::PLAYER_HEIGHT, z};
+    }
+};
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+// ── Report ────────────────────────────────────────────────────────────────────
+struct Dist {
+    size_t n = 0;
+    double p50 = 0, p90 = 0, p99 = 0, max = 0, mean = 0;
+
+    static Dist of(std::vector<double> v) {
+        Dist d;
+        d.n = v.size();
+        if (v.empty()) return d;
+        std::sort(v.begin(), v.end());
+        auto at = [&](double q) { return v[std::min(v.size() - 1, (size_t)(q * (v.size() - 1) + 0.5))]; };
+        d.p50 = at(0.5); d.p90 = at(0.9); d.p99 = at(0.99); d.max = v.back();
+        for (double x : v) d.mean += x;
+        d.mean /= (double)v.size();
+        return d;
+    }
+
+    void print(const char* what, const char* unit) const {
+        printf("  %-10s n=%-7zu p50 %9.1f  p90 %9.1f  p99 %9.1f  max %9.1f  mean %9.1f %s\n",
+               what, n, p50, p90, p99, max, mean, unit);
+    }
+    void json(FILE* f, const char* what, bool last) const {
+        fprintf(f, "    \"%s\": {\"n\": %zu, \"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, "
+                   "\"max\": %.2f, \"mean\": %.2f}%s\n", what, n, p50, p90, p99, max, mean, last ? "" : ",");
+    }
+};
+
+static const char* patternName(Pattern p) {
+    switch (p) {
+    case Pattern::Circle:  return "circle";
+    case Pattern::Walk:    return "walk";
+    case Pattern::Sprint:  return "sprint";
+    case Pattern::Cluster: return "cluster";
     }
+    return "?";
+}
+
+static bool parsePattern(const char* s, Pattern& out) {
+    for (Pattern p : {Pattern::Circle, Pattern::Walk, Pattern::Sprint, Pattern::Cluster})
+        if (!strcmp(s, patternName(p))) { out = p; return true; }
+    return false;
+}
+
+static bool parseArgs(int argc, char** argv, Options& o) {
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        bool more = i + 1 < argc;
+        if      (!strcmp(a, "--swarm")    && more) o.swarm      = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(a, "--threads")  && more) o.threads    = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(a, "--ramp")     && more) o.ramp       = std::max(0.1, atof(argv[++i]));
+        else if (!strcmp(a, "--duration") && more) o.duration   = atof(argv[++i]);
+        else if (!strcmp(a, "--tokens")   && more) o.tokensFile = argv[++i];
+        else if (!strcmp(a, "--json")     && more) o.jsonFile   = argv[++i];
+        else if (!strcmp(a, "--view")     && more) o.viewRadius = atoi(argv[++i]);
+        else if (!strcmp(a, "--caps")     && more) o.caps       = (uint32_t)strtoul(argv[++i], nullptr, 0);
+        else if (!strcmp(a, "--pattern")  && more) { if (!parsePattern(argv[++i], o.pattern)) return false; }
+        else if (a[0] == '-' && a[1] == '-') return false;
+        else if (positional == 0) { o.ip = a; positional++; }
+        else if (positional == 1) { o.port = atoi(a); positional++; }
+        else if (positional == 2) { o.name = a; positional++; }
+        else if (positional == 3) { o.token = a; positional++; }
+        else return false;
+    }
+    return true;
+}
 
-done:
-    enet_peer_disconnect(server, 0);
-    enet_host_flush(host);
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        fprintf(stderr, "usage: %s [ip] [port] [name] [token] [--swarm N] [--threads T] [--ramp per_s]\n"
+                        "       [--pattern circle|walk|sprint|cluster] [--duration s] [--tokens file]\n"
+                        "       [--view radius] [--caps mask] [--json file]\n", argv[0]);
+        return 2;
+    }
+    int count = std::max(opt.swarm, 1);
+    opt.threads = std::min(opt.threads, count);
+
+    // "token" or "name token" per line, handed out in order; the rest are guests
+    std::vector<std::pair<std::string, std::string>> creds;
+    if (!opt.tokensFile.empty()) {
+        std::ifstream in(opt.tokensFile);
+        if (!in) { fprintf(stderr, "can't read %s\n", opt.tokensFile.c_str()); return 1; }
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream ls(line);
+            std::string a, b;
+            if (!(ls >> a)) continue;
+            creds.push_back(ls >> b ? std::make_pair(a, b) : std::make_pair(std::string(), a));
+        }
+    }
+
+    if (enet_initialize() != 0) { fprintf(stderr, "enet init failed\n"); return 1; }
+    std::signal(SIGINT, onSignal);
+
+    std::vector<std::unique_ptr<Bot>> bots;
+    for (int i = 0; i < count; i++) {
+        auto b = std::make_unique<Bot>();
+        b->index = i;
+        b->name  = opt.swarm ? opt.name + "_" + std::to_string(i) : opt.name;
+        b->token = opt.token;
+        b->rng.seed(0x9E3779B9u * (uint32_t)(i + 1));
+        if (i < (int)creds.size()) {
+            if (!creds[i].first.empty()) b->name = creds[i].first;
+            b->token = creds[i].second;
+        }
+        bots.push_back(std::move(b));
+    }
+
+    printf("[Bot] %d bot%s -> %s:%d, %d thread%s, pattern %s\n", count, count == 1 ? "" : "s",
+           opt.ip.c_str(), opt.port, opt.threads, opt.threads == 1 ? "" : "s", patternName(opt.pattern));
+
+    Registry reg;
+    std::vector<std::unique_ptr<Shard>> shards;
+    for (int t = 0; t < opt.threads; t++) {
+        std::vector<Bot*> mine;
+        for (int i = t; i < count; i += opt.threads) mine.push_back(bots[i].get());
+        shards.push_back(std::make_unique<Shard>(opt, reg, std::move(mine), opt.ramp / opt.threads));
+        if (!shards.back()->ok()) { fprintf(stderr, "host create failed\n"); return 1; }
+    }
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (auto& s : shards) threads.emplace_back([&s] { s->run(); });
+
+    // Progress every 5 s; the single bot is already chatty
+    auto lastReport = start;
+    uint64_t lastBytes = 0;
+    while (!g_stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto now = Clock::now();
+        if (opt.duration > 0 && msSince(start, now) >= opt.duration * 1000.0) g_stop = true;
+        if (!opt.swarm || msSince(lastReport, now) < 5000.0) continue;
+        int joined = 0, ready = 0, dropped = 0;
+        uint64_t bytes = 0;
+        for (auto& s : shards) {
+            joined += s->joined; ready += s->spawned; dropped += s->dropped;
+            bytes += s->chunkBytes;
+        }
+        printf("[Swarm] %5.0fs  joined %d/%d  spawn-ready %d  dropped %d  chunks %.1f MB (%.2f MB/s)\n",
+               msSince(start, now) / 1000.0, joined, count, ready, dropped, bytes / 1048576.0,
+               (bytes - lastBytes) / 1048576.0 / (msSince(lastReport, now) / 1000.0));
+        lastReport = now;
+        lastBytes  = bytes;
+    }
+    for (auto& t : threads) t.join();
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    enet_host_destroy(host);
+
+    // ── Summary ───────────────────────────────────────────────────────────────
+    Samples all;
+    int joined = 0, ready = 0, dropped = 0;
+    for (auto& s : shards) {
+        joined += s->joined; ready += s->spawned; dropped += s->dropped;
+        auto add = [](std::vector<double>& to, const std::vector<double>& from) {
+            to.insert(to.end(), from.begin(), from.end());
+        };
+        add(all.joinMs, s->samples.joinMs);
+        add(all.spawnMs, s->samples.spawnMs);
+        add(all.posMs, s->samples.posMs);
+    }
+    std::vector<double> perBotBytes;
+    uint64_t totalBytes = 0;
+    for (auto& b : bots) {
+        if (b->authed) perBotBytes.push_back((double)b->chunkBytes);
+        totalBytes += b->chunkBytes;
+    }
+    double secs = msSince(start) / 1000.0;
+    Dist join = Dist::of(all.joinMs), spawn = Dist::of(all.spawnMs), pos = Dist::of(all.posMs),
+         bytes = Dist::of(perBotBytes);
+
+    printf("[Bot] %.0fs: %d/%d joined, %d spawn-ready, %d dropped, %.1f MB of chunks (%.2f MB/s)\n",
+           secs, joined, count, ready, dropped, totalBytes / 1048576.0, totalBytes / 1048576.0 / secs);
+    join.print("join", "ms");
+    spawn.print("spawn", "ms");
+    pos.print("pos", "ms");
+    bytes.print("chunk B", "bytes/bot");
+
+    if (!opt.jsonFile.empty()) {
+        FILE* f = fopen(opt.jsonFile.c_str(), "w");
+        if (!f) { fprintf(stderr, "can't write %s\n", opt.jsonFile.c_str()); }
+        else {
+            fprintf(f, "{\n  \"bots\": %d, \"threads\": %d, \"pattern\": \"%s\", \"seconds\": %.1f,\n",
+                    count, opt.threads, patternName(opt.pattern), secs);
+            fprintf(f, "  \"joined\": %d, \"spawn_ready\": %d, \"dropped\": %d, \"chunk_bytes\": %llu,\n",
+                    joined, ready, dropped, (unsigned long long)totalBytes);
+            fprintf(f, "  \"distributions\": {\n");
+            join.json(f, "join_ms", false);
+            spawn.json(f, "spawn_chunks_ms", false);
+            pos.json(f, "position_latency_ms", false);
+            bytes.json(f, "chunk_bytes_per_bot", true);
+            fprintf(f, "  }\n}\n");
+            fclose(f);
+        }
+    }
+
+    shards.clear();
     enet_deinitialize();
     printf("[Bot] Bye.\n");
     return 0;
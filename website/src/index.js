@@ -2,6 +2,7 @@
 
 const express       = require('express');
 const bcrypt        = require('bcrypt');
+const crypto        = require('crypto');
 const jwt           = require('jsonwebtoken');
 const cors          = require('cors');
 const helmet        = require('helmet');
@@ -16,7 +17,6 @@ const { JSONFile }  = require('lowdb/node');
 const PORT       = process.env.PORT       || 8080;
 const JWT_SECRET = process.env.JWT_SECRET || 'ImVerySecure!';
 const BCRYPT_ROUNDS = 12;
-const TOKEN_TTL     = '7d';
 const SESSION_TTL_MS = 7 * 86400000;
 
 // ── Database ──────────────────────────────────────────────────────────────────
@@ -28,14 +28,60 @@ const db = new Low(adapter, {
     users:    {},
     sessions: {},
     usernames: {},
+    revoked:  {},
 });
 
 async function initDB() {
     await db.read();
     db.data ||= { users: {}, sessions: {}, usernames: {} };
+    db.data.revoked ||= {};
     await db.write();
 }
 
+// ── Session signing ───────────────────────────────────────────────────────────
+// Session tokens are signed (v1.<kid>.<claims>.<sig>, see the game's
+// shared/include/session_token.h) so game servers can check them without
+// asking /api/verify. The key lives in data/session-keys.txt, "<kid> <hex>"
+// per line — the same file a game server takes with --auth-keys, and
+// rereads to pick up rotations; it's never served, as whoever holds it can
+// sign sessions. The first line signs; the rest still verify.
+const KEYS_FILE = path.join(DATA_DIR, 'session-keys.txt');
+
+function loadSessionKeys() {
+    if (!fs.existsSync(KEYS_FILE)) {
+        const kid = 'k' + Date.now().toString(36);
+        fs.writeFileSync(KEYS_FILE, `${kid} ${crypto.randomBytes(32).toString('hex')}\n`, { mode: 0o600 });
+    }
+    return fs.readFileSync(KEYS_FILE, 'utf8').split('\n')
+        .map(l => l.trim().split(/\s+/))
+        .filter(([kid, hex]) => kid && hex && !kid.startsWith('#'))
+        .map(([kid, hex]) => ({ kid, key: Buffer.from(hex, 'hex') }));
+}
+const SESSION_KEYS = loadSessionKeys();
+
+function signSession(uid, username, expiresAt, sid) {
+    const { kid, key } = SESSION_KEYS[0];
+    const claims = Buffer.from(`${uid}\n${username}\n${Math.floor(expiresAt / 1000)}\n${sid}`).toString('base64url');
+    const head   = `v1.${kid}.${claims}`;
+    return head + '.' + crypto.createHmac('sha256', key).update(head).digest('base64url');
+}
+
+function issueSession(uid, username) {
+    const sid       = uuid();
+    const expiresAt = Date.now() + SESSION_TTL_MS;
+    const token     = signSession(uid, username, expiresAt, sid);
+    db.data.sessions[token] = { uid, username, sid, issuedAt: Date.now(), expiresAt };
+    return token;
+}
+
+// Game servers refuse a revoked session until it would have expired anyway
+function revokeSession(token) {
+    const sess = db.data.sessions[token];
+    if (!sess) return;
+    if (sess.sid) db.data.revoked[sess.sid] = sess.expiresAt;
+    delete db.data.sessions[token];
+}
+
 // ── Helpers ───────────────────────────────────────────────────────────────────
 function isValidUsername(name) {
     return typeof name === 'string' &&
@@ -53,6 +99,9 @@ function purgeExpiredSessions() {
     for (const [tok, sess] of Object.entries(db.data.sessions)) {
         if (sess.expiresAt < now) delete db.data.sessions[tok];
     }
+    for (const [sid, expiresAt] of Object.entries(db.data.revoked)) {
+        if (expiresAt < now) delete db.data.revoked[sid];
+    }
 }
 
 function verifySessionToken(token) {
@@ -107,9 +156,7 @@ app.post('/api/register', authLimiter, async (req, res) => {
     db.data.usernames[key] = uid;
     await db.write();
 
-    const token     = jwt.sign({ uid, username }, JWT_SECRET, { expiresIn: TOKEN_TTL });
-    const expiresAt = Date.now() + SESSION_TTL_MS;
-    db.data.sessions[token] = { uid, username, issuedAt: Date.now(), expiresAt };
+    const token = issueSession(uid, username);
     await db.write();
 
     return res.status(201).json({ token, username, uid });
@@ -131,11 +178,9 @@ app.post('/api/login', authLimiter, async (req, res) => {
     if (!ok) return res.status(401).json({ error: 'Invalid username or password.' });
 
     for (const [tok, sess] of Object.entries(db.data.sessions))
-        if (sess.uid === uid) delete db.data.sessions[tok];
+        if (sess.uid === uid) revokeSession(tok);
 
-    const token     = jwt.sign({ uid, username: user.username }, JWT_SECRET, { expiresIn: TOKEN_TTL });
-    const expiresAt = Date.now() + SESSION_TTL_MS;
-    db.data.sessions[token] = { uid, username: user.username, issuedAt: Date.now(), expiresAt };
+    const token = issueSession(uid, user.username);
     await db.write();
 
     return res.json({ token, username: user.username, uid });
@@ -145,7 +190,7 @@ app.post('/api/login', authLimiter, async (req, res) => {
 app.post('/api/logout', (req, res) => {
     const token = (req.headers.authorization || '').replace('Bearer ', '').trim();
     if (token && db.data.sessions[token]) {
-        delete db.data.sessions[token];
+        revokeSession(token);
         db.write().catch(() => {});
     }
     return res.json({ ok: true });
@@ -157,16 +202,25 @@ app.get('/api/verify', verifyLimiter, (req, res) => {
     const sess  = verifySessionToken(token);
     if (!sess) return res.json({ valid: false });
 
-    try { jwt.verify(token, JWT_SECRET); }
-    catch {
-        delete db.data.sessions[token];
-        db.write().catch(() => {});
-        return res.json({ valid: false });
+    // Signed tokens are only ever issued here, and the session entry is
+    // what says they're still live; older ones are JWTs
+    if (!token.startsWith('v1.')) {
+        try { jwt.verify(token, JWT_SECRET); }
+        catch {
+            delete db.data.sessions[token];
+            db.write().catch(() => {});
+            return res.json({ valid: false });
+        }
     }
 
     return res.json({ valid: true, uid: sess.uid, username: sess.username });
 });
 
+// GET /api/session-revoked  — sessions ended before they expire, one per line
+app.get('/api/session-revoked', verifyLimiter, (req, res) => {
+    return res.type('text/plain').send(Object.keys(db.data.revoked).join('\n') + '\n');
+});
+
 // GET /api/me
 app.get('/api/me', (req, res) => {
     const token = (req.headers.authorization || '').replace('Bearer ', '').trim();